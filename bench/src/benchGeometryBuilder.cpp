@@ -57,4 +57,91 @@ static void BM_Tangram_BuildRoundRoundLine(benchmark::State& state) {
 }
 BENCHMARK(BM_Tangram_BuildRoundRoundLine);
 
+// Longer lines, built with the std::function callback and with an inlined vertex function
+
+static std::vector<glm::vec2> zigzag(size_t _points) {
+    std::vector<glm::vec2> points;
+    for (size_t i = 0; i < _points; i++) {
+        points.emplace_back(i / float(_points), (i % 2) * 0.01f);
+    }
+    return points;
+}
+
+static void BM_Tangram_BuildLineCallback(benchmark::State& state) {
+    auto points = zigzag(state.range(0));
+    std::vector<PosNormEnormColVertex> vertices;
+    PolyLineBuilder builder {
+        [&](const glm::vec2& coord, const glm::vec2& normal, const glm::vec2& uv) {
+            vertices.push_back({ coord, uv, normal, 0.5f, 0xffffff, 0.f });
+        },
+        CapTypes::butt,
+        JoinTypes::miter
+    };
+    while(state.KeepRunning()) {
+        vertices.clear();
+        builder.clear();
+        Builders::buildPolyLine(points, builder);
+        benchmark::DoNotOptimize(vertices.data());
+    }
+}
+BENCHMARK(BM_Tangram_BuildLineCallback)->Arg(16)->Arg(256);
+
+static void BM_Tangram_BuildLineInlined(benchmark::State& state) {
+    auto points = zigzag(state.range(0));
+    std::vector<PosNormEnormColVertex> vertices;
+    PolyLineBuilder builder({}, CapTypes::butt, JoinTypes::miter);
+    while(state.KeepRunning()) {
+        vertices.clear();
+        builder.clear();
+        Builders::buildPolyLine(points, builder, [&](const glm::vec2& coord, const glm::vec2& normal, const glm::vec2& uv) {
+            vertices.push_back({ coord, uv, normal, 0.5f, 0xffffff, 0.f });
+        });
+        benchmark::DoNotOptimize(vertices.data());
+    }
+}
+BENCHMARK(BM_Tangram_BuildLineInlined)->Arg(16)->Arg(256);
+
+struct PolygonBenchVertex {
+    glm::vec3 pos;
+    glm::vec3 normal;
+    glm::vec2 uv;
+};
+
+static void BM_Tangram_BuildPolygonCallback(benchmark::State& state) {
+    Feature feature;
+    feature.addPolygon({{ {0, 0}, {1, 0}, {1, 1}, {0, 1}, {0, 0} }});
+    auto polygon = feature.polygons()[0];
+    std::vector<PolygonBenchVertex> vertices;
+    PolygonBuilder builder([&](const glm::vec3& coord, const glm::vec3& normal, const glm::vec2& uv) {
+        vertices.push_back({ coord, normal, uv });
+    });
+    while(state.KeepRunning()) {
+        vertices.clear();
+        builder.clear();
+        Builders::buildPolygonExtrusion(polygon, 0.f, 1.f, builder);
+        Builders::buildPolygon(polygon, 1.f, builder);
+        benchmark::DoNotOptimize(vertices.data());
+    }
+}
+BENCHMARK(BM_Tangram_BuildPolygonCallback);
+
+static void BM_Tangram_BuildPolygonInlined(benchmark::State& state) {
+    Feature feature;
+    feature.addPolygon({{ {0, 0}, {1, 0}, {1, 1}, {0, 1}, {0, 0} }});
+    auto polygon = feature.polygons()[0];
+    std::vector<PolygonBenchVertex> vertices;
+    PolygonBuilder builder;
+    auto addVertex = [&](const glm::vec3& coord, const glm::vec3& normal, const glm::vec2& uv) {
+        vertices.push_back({ coord, normal, uv });
+    };
+    while(state.KeepRunning()) {
+        vertices.clear();
+        builder.clear();
+        Builders::buildPolygonExtrusion(polygon, 0.f, 1.f, builder, addVertex);
+        Builders::buildPolygon(polygon, 1.f, builder, addVertex);
+        benchmark::DoNotOptimize(vertices.data());
+    }
+}
+BENCHMARK(BM_Tangram_BuildPolygonInlined);
+
 BENCHMARK_MAIN();
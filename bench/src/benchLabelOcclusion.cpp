@@ -0,0 +1,165 @@
+#include "benchmark/benchmark.h"
+
+#include "labels/labelManager.h"
+#include "labels/textLabel.h"
+#include "labels/textLabels.h"
+#include "style/textStyle.h"
+#include "tile/tile.h"
+#include "view/view.h"
+
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#define RUN(FIXTURE, NAME)                                              \
+    BENCHMARK_DEFINE_F(FIXTURE, NAME)(benchmark::State& st) { while (st.KeepRunning()) { run(); } } \
+    BENCHMARK_REGISTER_F(FIXTURE, NAME);  //->Iterations(1)
+
+using namespace Tangram;
+
+const size_t label_count = 20000;
+
+TextStyle textStyle("textStyle");
+TextLabels textLabels(textStyle);
+
+class OcclusionLabels : public LabelManager {
+public:
+    void add(Label* _label, const Tile* _tile, const ViewState& _viewState, const glm::mat4& _mvp) {
+        m_labels.push_back({_label, nullptr, _tile, nullptr, false, {}});
+        ScreenTransform transform(m_transforms, m_labels.back().transformRange);
+        _label->update(_mvp, _viewState, nullptr, transform);
+    }
+    void occlude(const ViewState& _viewState) { handleOcclusions(_viewState); }
+    // Drop the last result, as a frame in which the view moved would
+    void invalidate() { m_lastOcclusions.clear(); }
+    void clear() {
+        m_labels.clear();
+        m_transforms.clear();
+    }
+};
+
+class LabelOcclusionFixture : public benchmark::Fixture {
+public:
+    std::unique_ptr<View> view;
+    std::unique_ptr<Tile> tile;
+    std::vector<std::unique_ptr<TextLabel>> labels;
+    OcclusionLabels manager;
+
+    void SetUp(const ::benchmark::State& state) override {
+        view = std::make_unique<View>(1024, 1024);
+        view->setConstrainToWorldBounds(false);
+        view->setPosition(0, 0);
+        view->setZoom(0);
+        view->update();
+
+        tile = std::make_unique<Tile>(TileID{0,0,0});
+        tile->update(0, *view);
+
+        srand(0);
+        for (size_t i = 0; i < label_count; i++) {
+            Label::Options options;
+            options.anchors.anchor[0] = LabelProperty::Anchor::right;
+            options.anchors.anchor[1] = LabelProperty::Anchor::left;
+            options.anchors.count = 2;
+            // A few repeat groups of road-name-like labels
+            if (i % 4 == 0) {
+                options.repeatGroup = i % 16;
+                options.repeatDistance = 64;
+            }
+            glm::vec2 position(rand() / float(RAND_MAX), rand() / float(RAND_MAX));
+            glm::vec2 size(8 + rand() % 64, 8 + rand() % 16);
+
+            labels.emplace_back(new TextLabel({{glm::vec3(position, 0)}}, Label::Type::point, options,
+                                              {}, size, textLabels, {},
+                                              TextLabelProperty::Align::none));
+        }
+        for (auto& label : labels) {
+            manager.add(label.get(), tile.get(), view->state(), tile->mvp());
+        }
+    }
+    void TearDown(const ::benchmark::State& state) override {
+        manager.clear();
+        labels.clear();
+    }
+};
+
+class MovingLabelsFixture : public LabelOcclusionFixture {
+public:
+    __attribute__ ((noinline)) void run() {
+        manager.invalidate();
+        manager.occlude(view->state());
+    }
+};
+RUN(MovingLabelsFixture, LabelOcclusionMoving);
+
+class StaticLabelsFixture : public LabelOcclusionFixture {
+public:
+    __attribute__ ((noinline)) void run() {
+        manager.occlude(view->state());
+    }
+};
+RUN(StaticLabelsFixture, LabelOcclusionStatic);
+
+// Road names of one repeat group on a dense grid of streets, which is the
+// worst case for the repeat distance checks
+class RepeatGroupFixture : public benchmark::Fixture {
+public:
+    std::unique_ptr<View> view;
+    std::unique_ptr<Tile> tile;
+    std::vector<std::unique_ptr<TextLabel>> labels;
+    OcclusionLabels manager;
+
+    void SetUp(const ::benchmark::State& state) override {
+        view = std::make_unique<View>(1024, 1024);
+        view->setConstrainToWorldBounds(false);
+        view->setPosition(0, 0);
+        view->setZoom(0);
+        view->update();
+
+        tile = std::make_unique<Tile>(TileID{0,0,0});
+        tile->update(0, *view);
+
+        size_t count = state.range(0);
+        float repeatDistance = state.range(1);
+
+        srand(0);
+        for (size_t i = 0; i < count; i++) {
+            Label::Options options;
+            options.anchors.anchor[0] = LabelProperty::Anchor::center;
+            options.anchors.count = 1;
+            options.repeatGroup = 1;
+            options.repeatDistance = repeatDistance;
+            glm::vec2 position(rand() / float(RAND_MAX), rand() / float(RAND_MAX));
+
+            labels.emplace_back(new TextLabel({{glm::vec3(position, 0)}}, Label::Type::point, options,
+                                              {}, {1, 1}, textLabels, {},
+                                              TextLabelProperty::Align::none));
+        }
+        for (auto& label : labels) {
+            manager.add(label.get(), tile.get(), view->state(), tile->mvp());
+        }
+    }
+    void TearDown(const ::benchmark::State& state) override {
+        manager.clear();
+        labels.clear();
+    }
+};
+
+// The time per label stays flat with the label count and the repeat distance
+BENCHMARK_DEFINE_F(RepeatGroupFixture, LabelRepeatGroup)(benchmark::State& st) {
+    while (st.KeepRunning()) {
+        manager.invalidate();
+        manager.occlude(view->state());
+    }
+    st.SetItemsProcessed(st.iterations() * st.range(0));
+}
+static void repeatGroupArgs(benchmark::internal::Benchmark* _bench) {
+    for (int count : { 1000, 4000, 16000 }) {
+        for (int distance : { 32, 128, 512 }) {
+            _bench->Args({ count, distance });
+        }
+    }
+}
+BENCHMARK_REGISTER_F(RepeatGroupFixture, LabelRepeatGroup)->Apply(repeatGroupArgs);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,238 @@
+#include "benchmark/benchmark.h"
+
+#include "benchTileData.h"
+#include "data/tileSource.h"
+#include "labels/labelManager.h"
+#include "labels/labelSet.h"
+#include "log.h"
+#include "marker/marker.h"
+#include "mockPlatform.h"
+#include "scene/scene.h"
+#include "scene/styleContext.h"
+#include "style/style.h"
+#include "tile/tile.h"
+#include "tile/tileBuilder.h"
+#include "tile/tileManager.h"
+#include "tile/tileTask.h"
+#include "util/mapProjection.h"
+#include "view/view.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace Tangram;
+
+const char scene_file[] = "res/scene.yaml";
+const char tile_file[] = "res/tile.mvt";
+
+const TileID test_tile{301, 384, 10};
+
+// Tiles around the test tile in each direction, all built from its data
+const int grid_radius = 1;
+
+// Feature densities of the tiles, which control the number of labels
+const float densities[] = { 0.25f, 1.f, 4.f };
+
+enum Motion { static_view, pan, zoom, rotate };
+
+std::shared_ptr<Scene> scene;
+std::shared_ptr<TileSource> source;
+std::shared_ptr<TileData> tileData;
+std::vector<std::vector<std::shared_ptr<Tile>>> tileSets;
+MockPlatform platform;
+
+static void loadScene() {
+    SceneOptions sceneOptions{platform.resolveUrl(Url(scene_file))};
+    sceneOptions.numTileWorkers = 0;
+    sceneOptions.prefetchTiles = false;
+
+    scene = std::make_shared<Scene>(platform, std::move(sceneOptions));
+    if (!scene->load()) { exit(-1); }
+
+    for (auto& s : scene->tileSources()) {
+        source = s;
+        if (source->generateGeometry()) { break; }
+    }
+
+    auto task = source->createTask(test_tile);
+    auto& binaryTask = dynamic_cast<BinaryTileTask&>(*task);
+    binaryTask.rawTileData = std::make_shared<std::vector<char>>(MockPlatform::getBytesFromFile(tile_file));
+    tileData = source->parse(*task);
+    if (!tileData) {
+        LOGE("Invalid tile file '%s'", tile_file);
+        exit(-1);
+    }
+
+    TileBuilder builder(*scene, new StyleContext());
+    builder.init();
+
+    for (float density : densities) {
+        auto data = withDensity(*tileData, density);
+        std::vector<std::shared_ptr<Tile>> tiles;
+        for (int x = -grid_radius; x <= grid_radius; x++) {
+            for (int y = -grid_radius; y <= grid_radius; y++) {
+                TileID id(test_tile.x + x, test_tile.y + y, test_tile.z);
+                tiles.push_back(builder.build(id, *data, *source));
+            }
+        }
+        tileSets.push_back(std::move(tiles));
+    }
+}
+
+static void globalSetup() {
+    static bool loaded = (loadScene(), true);
+    (void)loaded;
+}
+
+// Exposes the steps of updateLabelSet()
+class PlacementLabels : public LabelManager {
+public:
+    void collect(const ViewState& _viewState, const std::vector<std::shared_ptr<Tile>>& _tiles) {
+        m_transforms.clear();
+        m_obbs.clear();
+        updateLabels(_viewState, 0, scene->styles(), _tiles, m_markers, false);
+    }
+    void sort() {
+        std::sort(m_labels.begin(), m_labels.end(), LabelManager::priorityComparator);
+    }
+    void occlude(const ViewState& _viewState) { handleOcclusions(_viewState); }
+    void fade(float _dt) {
+        for (auto& entry : m_labels) { entry.label->evalState(_dt); }
+    }
+    size_t labelCount() const { return m_labels.size(); }
+
+    std::vector<std::unique_ptr<Marker>> m_markers;
+};
+
+class LabelPlacementFixture : public benchmark::Fixture {
+public:
+    std::unique_ptr<View> view;
+    PlacementLabels manager;
+    const std::vector<std::shared_ptr<Tile>>* tiles = nullptr;
+    Motion motion = static_view;
+    glm::dvec2 center;
+    int frame = 0;
+
+    void SetUp(const ::benchmark::State& _state) override {
+        globalSetup();
+        tiles = &tileSets[_state.range(0)];
+        motion = Motion(_state.range(1));
+
+        view = std::make_unique<View>(1024, 768);
+        center = MapProjection::tileCenter(test_tile);
+        view->setPosition(center);
+        view->setZoom(test_tile.z + 0.5f);
+        frame = 0;
+        step();
+
+        // Start from a settled placement
+        manager.updateLabelSet(view->state(), 1, *scene, *tiles, manager.m_markers,
+                               *scene->tileManager());
+    }
+
+    void TearDown(const ::benchmark::State& _state) override {
+        view.reset();
+    }
+
+    // Move the view by one frame of the motion
+    void step() {
+        frame++;
+        double t = frame / 60.0;
+        switch (motion) {
+        case static_view:
+            break;
+        case pan: {
+            // Circle with a diameter of half a tile, once in about six seconds
+            double radius = 0.25 * MapProjection::metersPerTileAtZoom(test_tile.z);
+            view->setPosition(center.x + radius * std::cos(t), center.y + radius * std::sin(t));
+            break;
+        }
+        case zoom:
+            view->setZoom(test_tile.z + 0.5f + 0.4f * std::sin(t));
+            break;
+        case rotate:
+            view->setRoll(t);
+            break;
+        }
+        view->update();
+        for (auto& tile : *tiles) { tile->update(1.f / 60.f, *view); }
+    }
+
+    void setCounters(benchmark::State& _state) {
+        _state.counters["labels"] = manager.labelCount();
+    }
+};
+
+static void placementArgs(benchmark::internal::Benchmark* _bench) {
+    for (int density = 0; density < int(sizeof(densities) / sizeof(densities[0])); density++) {
+        for (int motion : { static_view, pan, zoom, rotate }) {
+            _bench->Args({ density, motion });
+        }
+    }
+}
+
+// The whole per-frame label update
+BENCHMARK_DEFINE_F(LabelPlacementFixture, UpdateLabelSet)(benchmark::State& st) {
+    while (st.KeepRunning()) {
+        step();
+        manager.updateLabelSet(view->state(), 1.f / 60.f, *scene, *tiles, manager.m_markers,
+                               *scene->tileManager());
+    }
+    setCounters(st);
+}
+BENCHMARK_REGISTER_F(LabelPlacementFixture, UpdateLabelSet)->Apply(placementArgs);
+
+// Collecting labels of the tiles and updating their screen transforms
+BENCHMARK_DEFINE_F(LabelPlacementFixture, Collect)(benchmark::State& st) {
+    while (st.KeepRunning()) {
+        step();
+        manager.collect(view->state(), *tiles);
+    }
+    setCounters(st);
+}
+BENCHMARK_REGISTER_F(LabelPlacementFixture, Collect)->Apply(placementArgs);
+
+// Priority sort of the collected labels
+BENCHMARK_DEFINE_F(LabelPlacementFixture, Sort)(benchmark::State& st) {
+    while (st.KeepRunning()) {
+        st.PauseTiming();
+        step();
+        manager.collect(view->state(), *tiles);
+        st.ResumeTiming();
+        manager.sort();
+    }
+    setCounters(st);
+}
+BENCHMARK_REGISTER_F(LabelPlacementFixture, Sort)->Apply(placementArgs);
+
+// Collision and anchor fallback of the sorted labels
+BENCHMARK_DEFINE_F(LabelPlacementFixture, Collision)(benchmark::State& st) {
+    while (st.KeepRunning()) {
+        st.PauseTiming();
+        step();
+        manager.collect(view->state(), *tiles);
+        manager.sort();
+        st.ResumeTiming();
+        manager.occlude(view->state());
+    }
+    setCounters(st);
+}
+BENCHMARK_REGISTER_F(LabelPlacementFixture, Collision)->Apply(placementArgs);
+
+// Fade transitions of the placed labels
+BENCHMARK_DEFINE_F(LabelPlacementFixture, Fade)(benchmark::State& st) {
+    while (st.KeepRunning()) {
+        st.PauseTiming();
+        step();
+        manager.collect(view->state(), *tiles);
+        manager.sort();
+        manager.occlude(view->state());
+        st.ResumeTiming();
+        manager.fade(1.f / 60.f);
+    }
+    setCounters(st);
+}
+BENCHMARK_REGISTER_F(LabelPlacementFixture, Fade)->Apply(placementArgs);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,77 @@
+#include "benchmark/benchmark.h"
+
+#include "mockPlatform.h"
+#include "scene/importer.h"
+
+#include <string>
+
+#define RUN(FIXTURE, NAME)                                              \
+    BENCHMARK_DEFINE_F(FIXTURE, NAME)(benchmark::State& st) { while (st.KeepRunning()) { run(); } } \
+    BENCHMARK_REGISTER_F(FIXTURE, NAME);
+
+using namespace Tangram;
+
+const int import_count = 24;
+const int layer_count = 40;
+
+// Each import overrides globals and styles of the shared base
+// and adds its own layers, like the parts of a basemap do.
+static std::string importYaml(int _import) {
+    std::string n = std::to_string(_import);
+    std::string yaml = "import: base.yaml\n"
+        "global:\n"
+        "    color_" + n + ": '#" + std::to_string(100000 + _import) + "'\n"
+        "    sort_order: " + n + "\n"
+        "styles:\n"
+        "    lines:\n"
+        "        base: lines\n"
+        "        blend_order: " + n + "\n"
+        "    style_" + n + ":\n"
+        "        base: polygons\n"
+        "        shaders:\n"
+        "            uniforms: { u_value: " + n + " }\n"
+        "layers:\n";
+    for (int i = 0; i < layer_count; i++) {
+        std::string l = std::to_string(i);
+        yaml += "    layer_" + n + "_" + l + ":\n"
+            "        data: { source: mapzen, layer: roads }\n"
+            "        filter: { kind: kind_" + l + " }\n"
+            "        draw:\n"
+            "            lines: { order: " + l + ", color: global.color_" + n + ", width: 2px }\n"
+            "        minor:\n"
+            "            filter: { kind_detail: [minor, service] }\n"
+            "            draw: { lines: { width: 1px } }\n";
+    }
+    return yaml;
+}
+
+class SceneImportFixture : public benchmark::Fixture {
+public:
+    MockPlatform platform;
+    Url sceneUrl{"/root/scene.yaml"};
+
+    void SetUp(const ::benchmark::State& state) override {
+        std::string scene = "import:\n";
+        for (int i = 0; i < import_count; i++) {
+            std::string name = "import_" + std::to_string(i) + ".yaml";
+            scene += "    - " + name + "\n";
+            platform.putMockUrlContents(Url("/root/" + name), importYaml(i));
+        }
+        scene += "scene: { background: { color: white } }\n";
+        platform.putMockUrlContents(sceneUrl, scene);
+
+        platform.putMockUrlContents(Url("/root/base.yaml"),
+            "global: { sort_order: 0 }\n"
+            "sources: { mapzen: { type: MVT, url: 'https://tile.example.com/{z}/{x}/{y}.mvt' } }\n"
+            "styles: { lines: { base: lines, blend: overlay } }\n");
+    }
+
+    __attribute__ ((noinline)) void run() {
+        Importer importer;
+        auto config = importer.loadSceneData(platform, sceneUrl);
+        benchmark::DoNotOptimize(config);
+    }
+};
+RUN(SceneImportFixture, SceneImportMerge);
+
+BENCHMARK_MAIN();
@@ -152,6 +152,58 @@ struct JSTileStyleFnFixture : public benchmark::Fixture {
 
 RUN(JSTileStyleFnFixture, TileStyleFnBench);
 
+// Match all features of the tile against the layer filters of the scene
+template<bool useProgram>
+struct FilterEvalFixture : public benchmark::Fixture {
+    StyleContext ctx;
+    uint32_t numMatches = 0;
+
+    void SetUp(const ::benchmark::State& state) override {
+        globalSetup();
+        ctx.initFunctions(*scene);
+        ctx.setZoom(10);
+    }
+    void TearDown(const ::benchmark::State& state) override {
+        LOG(">>> %d", numMatches);
+        numMatches = 0;
+    }
+    bool eval(const SceneLayer& layer, const Feature& feat) {
+        return useProgram
+            ? layer.filterProgram().eval(feat, ctx)
+            : layer.filter().eval(feat, ctx);
+    }
+    void match(const SceneLayer& layer, const Feature& feat) {
+        if (!eval(layer, feat)) { return; }
+        numMatches++;
+        for (const auto& sublayer : layer.sublayers()) {
+            match(sublayer, feat);
+        }
+    }
+    __attribute__ ((noinline)) void run() {
+        for (const auto& datalayer : scene->layers()) {
+            for (const auto& collection : tileData->layers) {
+                if (!collection.name.empty()) {
+                    const auto& dlc = datalayer.collections();
+                    bool layerContainsCollection =
+                        std::find(dlc.begin(), dlc.end(), collection.name) != dlc.end();
+
+                    if (!layerContainsCollection) { continue; }
+                }
+                for (const auto& feat : collection.features) {
+                    ctx.setFeature(feat);
+                    match(datalayer, feat);
+                }
+            }
+        }
+    }
+};
+
+using FilterTreeFixture = FilterEvalFixture<false>;
+RUN(FilterTreeFixture, FilterTreeBench);
+
+using FilterProgramFixture = FilterEvalFixture<true>;
+RUN(FilterProgramFixture, FilterProgramBench);
+
 class DirectGetPropertyFixture : public benchmark::Fixture {
 public:
     Feature feature;
@@ -7,8 +7,11 @@
 #include "mockPlatform.h"
 #include "scene/importer.h"
 #include "scene/scene.h"
+#include "scene/drawRule.h"
 #include "scene/sceneLoader.h"
 #include "style/style.h"
+#include "style/textStyle.h"
+#include "style/textStyleBuilder.h"
 #include "text/fontContext.h"
 #include "tile/tile.h"
 #include "tile/tileBuilder.h"
@@ -31,6 +34,7 @@ const char tile_file[] = "res/tile.mvt";
 
 std::shared_ptr<Scene> scene;
 std::shared_ptr<TileSource> source;
+std::shared_ptr<TileTask> task;
 std::shared_ptr<TileData> tileData;
 MockPlatform platform;
 
@@ -51,7 +55,7 @@ void globalSetup() {
     }
 
     Tile tile({0,0,10,10});
-    auto task = source->createTask(tile.getID());
+    task = source->createTask(tile.getID());
     auto& t = dynamic_cast<BinaryTileTask&>(*task);
 
     auto rawTileData = MockPlatform::getBytesFromFile(tile_file);
@@ -83,6 +87,103 @@ public:
 
 RUN(TileBuilderFixture, TileBuilderBench);
 
+size_t countFeatures(const TileData& _data) {
+    size_t count = 0;
+    for (auto& layer : _data.layers) { count += layer.features.size(); }
+    return count;
+}
 
+class TileParseFixture : public benchmark::Fixture {
+public:
+    std::unique_ptr<TileBuilder> tileBuilder;
+    std::shared_ptr<TileData> result;
+    void SetUp(const ::benchmark::State& state) override {
+        globalSetup();
+        tileBuilder = std::make_unique<TileBuilder>(*scene, new StyleContext());
+        tileBuilder->init();
+    }
+    void TearDown(const ::benchmark::State& state) override {
+        task->setFeatureFilter(nullptr);
+        result.reset();
+    }
+
+    __attribute__ ((noinline)) void run() {
+        result = source->parse(*task);
+    }
+};
+
+// Decodes all features of the tile
+BENCHMARK_DEFINE_F(TileParseFixture, ParseAll)(benchmark::State& st) {
+    while (st.KeepRunning()) { run(); }
+    st.counters["features"] = countFeatures(*result);
+}
+BENCHMARK_REGISTER_F(TileParseFixture, ParseAll);
+
+// Skips the geometry of features which the data layers of the scene reject.
+// 'skipped' counts the features that would otherwise be decoded and dropped
+// by TileBuilder.
+BENCHMARK_DEFINE_F(TileParseFixture, ParseFiltered)(benchmark::State& st) {
+    TileID tileId = task->tileId();
+    while (st.KeepRunning()) {
+        task->setFeatureFilter(&tileBuilder->featureFilter(tileId, *source));
+        run();
+    }
+    st.counters["features"] = countFeatures(*result);
+    st.counters["skipped"] = countFeatures(*tileData) - countFeatures(*result);
+}
+BENCHMARK_REGISTER_F(TileParseFixture, ParseFiltered);
+
+class CurvedTextLabelFixture : public benchmark::Fixture {
+public:
+    std::unique_ptr<StyleBuilder> builder;
+    std::vector<LineView> lines;
+    TextStyle::Parameters params;
+    TextStyleBuilder::LabelAttributes attributes;
+    DrawRule rule{{"", 0, {}}, "", 0};
+    Tile tile{{0,0,10,10}};
+
+    void SetUp(const ::benchmark::State& state) override {
+        globalSetup();
+        for (auto& style : scene->styles()) {
+            if (dynamic_cast<TextStyle*>(style.get())) {
+                builder = style->createBuilder();
+                break;
+            }
+        }
+        if (!builder) { exit(-1); }
+
+        // All lines of the tile with enough points for curved labels
+        for (auto& layer : tileData->layers) {
+            for (auto& feature : layer.features) {
+                for (auto line : feature.lines()) {
+                    if (line.size() > 2) { lines.push_back(line); }
+                }
+            }
+        }
+        // Width of a typical road name in pixels
+        attributes.width = 80;
+        attributes.height = 12;
+    }
+    void TearDown(const ::benchmark::State& state) override {
+        lines.clear();
+        builder.reset();
+    }
+
+    __attribute__ ((noinline)) void run() {
+        auto& textBuilder = static_cast<TextStyleBuilder&>(*builder);
+        textBuilder.setup(tile);
+        for (auto& line : lines) {
+            textBuilder.addCurvedTextLabels(line, params, attributes, rule);
+        }
+        textBuilder.labels()->clear();
+    }
+};
+
+// Finds the ranges of all tile lines which are straight enough for curved labels
+BENCHMARK_DEFINE_F(CurvedTextLabelFixture, AddCurvedTextLabels)(benchmark::State& st) {
+    while (st.KeepRunning()) { run(); }
+    st.counters["lines"] = lines.size();
+}
+BENCHMARK_REGISTER_F(CurvedTextLabelFixture, AddCurvedTextLabels);
 
 BENCHMARK_MAIN();
@@ -0,0 +1,173 @@
+#include "benchmark/benchmark.h"
+
+#include "benchTileData.h"
+#include "data/tileSource.h"
+#include "debug/metrics.h"
+#include "log.h"
+#include "map.h"
+#include "mockPlatform.h"
+#include "scene/scene.h"
+#include "scene/styleContext.h"
+#include "tile/tile.h"
+#include "tile/tileBuilder.h"
+#include "tile/tileTask.h"
+
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+using namespace Tangram;
+
+const char scene_file[] = "res/scene.yaml";
+const char tile_file[] = "res/tile.mvt";
+
+// Zoom levels and feature densities of the synthesized corpus
+const int min_zoom = 3;
+const int max_zoom = 17;
+const float densities[] = { 0.25f, 1.f, 4.f };
+
+struct CorpusTile {
+    TileID id;
+    std::shared_ptr<TileData> data;
+    size_t features;
+};
+
+std::shared_ptr<Scene> scene;
+std::shared_ptr<TileSource> source;
+std::vector<CorpusTile> corpus;
+MockPlatform platform;
+
+static std::shared_ptr<TileData> parseTile(const TileID& _id, const std::string& _file) {
+    auto task = source->createTask(_id);
+    auto& binaryTask = dynamic_cast<BinaryTileTask&>(*task);
+    binaryTask.rawTileData = std::make_shared<std::vector<char>>(MockPlatform::getBytesFromFile(_file.c_str()));
+    return source->parse(*task);
+}
+
+// The corpus is read from the list in TANGRAM_BENCH_TILES when set, with
+// lines of '<z> <x> <y> <file>'. Otherwise it is synthesized from the test
+// tile at each zoom level in [min_zoom, max_zoom] and with each density, so
+// that the zoom-dependent filters and draw rules of the scene apply.
+static void loadCorpus() {
+    if (const char* list = getenv("TANGRAM_BENCH_TILES")) {
+        std::ifstream file(list);
+        std::string line;
+        while (std::getline(file, line)) {
+            std::istringstream in(line);
+            int x, y, z;
+            std::string path;
+            if (!(in >> z >> x >> y >> path)) { continue; }
+            TileID id(x, y, z);
+            if (auto data = parseTile(id, path)) {
+                corpus.push_back({ id, data, countFeatures(*data) });
+            }
+        }
+        if (corpus.empty()) {
+            LOGE("No tiles in '%s'", list);
+            exit(-1);
+        }
+        return;
+    }
+
+    auto data = parseTile({301, 384, 10}, tile_file);
+    if (!data) {
+        LOGE("Invalid tile file '%s'", tile_file);
+        exit(-1);
+    }
+    for (int z = min_zoom; z <= max_zoom; z++) {
+        // The tile around the position of the test tile at zoom z
+        TileID id(301 >> std::max(0, 10 - z) << std::max(0, z - 10),
+                  384 >> std::max(0, 10 - z) << std::max(0, z - 10), z);
+        for (float density : densities) {
+            auto tileData = withDensity(*data, density);
+            corpus.push_back({ id, tileData, countFeatures(*tileData) });
+        }
+    }
+}
+
+static void loadScene() {
+    SceneOptions sceneOptions{platform.resolveUrl(Url(scene_file))};
+    sceneOptions.numTileWorkers = 0;
+    sceneOptions.prefetchTiles = false;
+
+    scene = std::make_shared<Scene>(platform, std::move(sceneOptions));
+    if (!scene->load()) { exit(-1); }
+
+    for (auto& s : scene->tileSources()) {
+        source = s;
+        if (source->generateGeometry()) { break; }
+    }
+
+    loadCorpus();
+    Metrics::setEnabled(true);
+}
+
+// Benchmark threads wait until the first one loaded the scene
+static void globalSetup() {
+    static bool loaded = (loadScene(), true);
+    (void)loaded;
+}
+
+// Sets per-tile means of the build stages, once for all threads
+static void setStageCounters(benchmark::State& _state) {
+    if (_state.thread_index != 0) { return; }
+
+    auto metrics = Metrics::collect(true);
+    const auto& styling = metrics.stages[PipelineMetrics::styling];
+    const auto& geometry = metrics.stages[PipelineMetrics::geometry_build];
+    if (styling.count == 0) { return; }
+
+    _state.counters["styling_ms"] = styling.totalMs / styling.count;
+    _state.counters["geometry_ms"] = geometry.totalMs / geometry.count;
+}
+
+// Builds all tiles of one zoom level
+static void BM_TileBuilderZoom(benchmark::State& _state) {
+    globalSetup();
+
+    int zoom = _state.range(0);
+    TileBuilder builder(*scene, new StyleContext());
+    builder.init();
+
+    size_t tiles = 0, features = 0;
+    Metrics::collect(true);
+    while (_state.KeepRunning()) {
+        for (auto& tile : corpus) {
+            if (tile.id.z != zoom) { continue; }
+            auto result = builder.build(tile.id, *tile.data, *source);
+            benchmark::DoNotOptimize(result);
+            tiles++;
+            features += tile.features;
+        }
+    }
+    _state.SetItemsProcessed(tiles);
+    _state.counters["features"] = benchmark::Counter(features, benchmark::Counter::kIsRate);
+    setStageCounters(_state);
+}
+BENCHMARK(BM_TileBuilderZoom)->DenseRange(min_zoom, max_zoom, 2)->Unit(benchmark::kMillisecond);
+
+// Builds the whole corpus with one TileBuilder per thread and the shared
+// Scene, like the tile workers do. Tiles per second should scale with the
+// number of threads unless they contend on shared state.
+static void BM_TileBuilderThreads(benchmark::State& _state) {
+    globalSetup();
+
+    TileBuilder builder(*scene, new StyleContext());
+    builder.init();
+
+    if (_state.thread_index == 0) { Metrics::collect(true); }
+
+    size_t tiles = 0;
+    size_t next = _state.thread_index * corpus.size() / _state.threads;
+    while (_state.KeepRunning()) {
+        auto& tile = corpus[next++ % corpus.size()];
+        auto result = builder.build(tile.id, *tile.data, *source);
+        benchmark::DoNotOptimize(result);
+        tiles++;
+    }
+    _state.SetItemsProcessed(tiles);
+    setStageCounters(_state);
+}
+BENCHMARK(BM_TileBuilderThreads)->ThreadRange(1, 8)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
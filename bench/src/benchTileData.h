@@ -0,0 +1,36 @@
+#pragma once
+
+#include "data/tileData.h"
+
+#include <memory>
+
+namespace Tangram {
+
+inline size_t countFeatures(const TileData& _data) {
+    size_t count = 0;
+    for (auto& layer : _data.layers) { count += layer.features.size(); }
+    return count;
+}
+
+// Keeps every n-th feature for densities below 1 and repeats each
+// feature for densities above 1. Features share their geometry.
+inline std::shared_ptr<TileData> withDensity(const TileData& _data, float _density) {
+    auto result = std::make_shared<TileData>();
+    for (auto& layer : _data.layers) {
+        result->layers.emplace_back(layer.name);
+        auto& features = result->layers.back().features;
+        if (_density < 1.f) {
+            size_t step = size_t(1.f / _density);
+            for (size_t i = 0; i < layer.features.size(); i += step) {
+                features.push_back(layer.features[i]);
+            }
+        } else {
+            for (auto& feature : layer.features) {
+                features.insert(features.end(), size_t(_density), feature);
+            }
+        }
+    }
+    return result;
+}
+
+}
@@ -0,0 +1,101 @@
+#include "benchmark/benchmark.h"
+
+#include "data/tileSource.h"
+#include "mockPlatform.h"
+#include "tile/tile.h"
+#include "tile/tileManager.h"
+#include "tile/tileTask.h"
+#include "util/mapProjection.h"
+#include "view/view.h"
+
+#include <cmath>
+
+using namespace Tangram;
+
+// Builds each tile as soon as it is enqueued, so that the benchmark measures
+// the bookkeeping of the TileManager alone
+struct InstantTileWorker : TileTaskQueue {
+    void enqueue(std::shared_ptr<TileTask> _task) override {
+        _task->setTile(std::make_unique<Tile>(_task->tileId(), _task->sourceId(),
+                                              _task->sourceGeneration()));
+    }
+};
+
+struct BenchTileSource : TileSource {
+    BenchTileSource() : TileSource("bench", nullptr) {
+        m_generateGeometry = true;
+    }
+
+    void loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) override {
+        _task->startedLoading();
+        _cb.func(std::move(_task));
+    }
+
+    void cancelLoadingTile(TileTask& _task) override {}
+
+    void clearData() override {}
+
+    std::shared_ptr<TileTask> createTask(TileID _tileId) override {
+        return std::make_shared<TileTask>(_tileId, shared_from_this());
+    }
+};
+
+enum Motion { static_view, pan, tilted_pan };
+
+class TileManagerFixture : public benchmark::Fixture {
+public:
+    MockPlatform platform;
+    InstantTileWorker worker;
+    std::unique_ptr<TileManager> tileManager;
+    std::unique_ptr<View> view;
+    Motion motion = static_view;
+    glm::dvec2 center;
+    int frame = 0;
+
+    void SetUp(const ::benchmark::State& _state) override {
+        motion = Motion(_state.range(0));
+
+        tileManager = std::make_unique<TileManager>(platform, worker);
+        tileManager->setTileSources({ std::make_shared<BenchTileSource>(),
+                                      std::make_shared<BenchTileSource>() });
+
+        view = std::make_unique<View>(1024, 768);
+        center = MapProjection::tileCenter({9650, 12320, 15});
+        view->setPosition(center);
+        view->setZoom(15.5f);
+        view->setMaxPitch(90);
+        if (motion == tilted_pan) { view->setPitch(1.f); }
+        frame = 0;
+
+        // Start from loaded tiles
+        for (int i = 0; i < 2; i++) { step(); }
+    }
+
+    void TearDown(const ::benchmark::State& _state) override {
+        tileManager.reset();
+        view.reset();
+    }
+
+    void step() {
+        frame++;
+        if (motion != static_view) {
+            // Pan along a circle with a radius of two tiles
+            double t = frame / 60.0;
+            double radius = 2.0 * MapProjection::metersPerTileAtZoom(15);
+            view->setPosition(center.x + radius * std::cos(t), center.y + radius * std::sin(t));
+        }
+        view->update();
+        tileManager->updateTileSets(*view);
+    }
+};
+
+// Per-frame update of the visible tiles, proxies and prefetching
+BENCHMARK_DEFINE_F(TileManagerFixture, UpdateTileSets)(benchmark::State& st) {
+    while (st.KeepRunning()) {
+        step();
+    }
+    st.counters["tiles"] = tileManager->getVisibleTiles().size();
+}
+BENCHMARK_REGISTER_F(TileManagerFixture, UpdateTileSets)->Arg(static_view)->Arg(pan)->Arg(tilted_pan);
+
+BENCHMARK_MAIN();
@@ -1,15 +1,35 @@
 #include "benchmark/benchmark.h"
 
+#include "data/mbtilesDataSource.h"
+#include "data/memoryCacheDataSource.h"
+#include "data/networkDataSource.h"
 #include "data/tileSource.h"
 #include "log.h"
 #include "map.h"
 #include "mockPlatform.h"
 #include "tile/tile.h"
+#include "tile/tileHash.h"
 #include "tile/tileTask.h"
+#include "util/mapProjection.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
 
 using namespace Tangram;
 
 const char tile_file[] = "res/tile.mvt";
+// Recorded tile requests: one frame per line, with the visible tiles as z/x/y
+// separated by spaces. A pan and zoom around one place is replayed without it.
+const char trace_file[] = "res/tile_trace.txt";
+const char cache_file[] = "bench_cache.mbtiles";
 
 struct TileSourceFixture : public benchmark::Fixture {
     std::shared_ptr<TileSource> source;
@@ -44,5 +64,352 @@ BENCHMARK_DEFINE_F(TileSourceFixture, TileSourceBench)(benchmark::State& st) {
 }
 BENCHMARK_REGISTER_F(TileSourceFixture, TileSourceBench);
 
+// Answers URL requests with the same content after a latency and the transfer
+// time at a bandwidth per connection, with a limited number of connections.
+// Queued requests start by their priority hint.
+class EmulatedNetworkPlatform : public MockPlatform {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    EmulatedNetworkPlatform(std::vector<char> _content, std::chrono::milliseconds _latency,
+                            double _bytesPerSecond, size_t _connections)
+        : m_content(std::move(_content)), m_latency(_latency),
+          m_transfer(std::chrono::duration_cast<Clock::duration>(
+                         std::chrono::duration<double>(m_content.size() / _bytesPerSecond))),
+          m_connections(_connections),
+          m_thread(&EmulatedNetworkPlatform::run, this) {}
+
+    ~EmulatedNetworkPlatform() override {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_running = false;
+        }
+        m_condition.notify_all();
+        m_thread.join();
+    }
+
+    bool startUrlRequestImpl(const Url& _url, const UrlRequestHandle _handle, UrlRequestId& _id) override {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            _id = ++m_lastId;
+            m_queued.push_back({ _id, _handle, 0.5f, {} });
+            m_requests++;
+        }
+        m_condition.notify_all();
+        return true;
+    }
+
+    void cancelUrlRequestImpl(const UrlRequestId _id) override {
+        UrlRequestHandle handle = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (auto* requests : { &m_queued, &m_active }) {
+                auto it = std::find_if(requests->begin(), requests->end(),
+                                       [&](auto& request) { return request.id == _id; });
+                if (it != requests->end()) {
+                    handle = it->handle;
+                    requests->erase(it);
+                    break;
+                }
+            }
+        }
+        m_condition.notify_all();
+        if (handle) {
+            UrlResponse response;
+            response.error = "Request canceled";
+            onUrlResponse(handle, std::move(response));
+        }
+    }
+
+    void setUrlRequestPriorityImpl(const UrlRequestId _id, float _priority) override {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& request : m_queued) {
+            if (request.id == _id) { request.priority = _priority; }
+        }
+    }
+
+    size_t requests() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_requests;
+    }
+
+private:
+    struct Request {
+        UrlRequestId id;
+        UrlRequestHandle handle;
+        float priority;
+        Clock::time_point done;
+    };
+
+    void run() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (m_running) {
+            // Start the most urgent requests, the oldest first among equals
+            while (m_active.size() < m_connections && !m_queued.empty()) {
+                auto next = std::max_element(m_queued.begin(), m_queued.end(), [](auto& a, auto& b) {
+                    return a.priority < b.priority || (a.priority == b.priority && a.id > b.id);
+                });
+                next->done = Clock::now() + m_latency + m_transfer;
+                m_active.push_back(*next);
+                m_queued.erase(next);
+            }
+            if (m_active.empty()) {
+                m_condition.wait(lock);
+                continue;
+            }
+            auto first = std::min_element(m_active.begin(), m_active.end(),
+                                          [](auto& a, auto& b) { return a.done < b.done; });
+            if (Clock::now() < first->done) {
+                m_condition.wait_until(lock, first->done);
+                continue;
+            }
+            UrlRequestHandle handle = first->handle;
+            m_active.erase(first);
+
+            lock.unlock();
+            UrlResponse response;
+            response.content = m_content;
+            onUrlResponse(handle, std::move(response));
+            lock.lock();
+        }
+    }
+
+    std::vector<char> m_content;
+    Clock::duration m_latency;
+    Clock::duration m_transfer;
+    size_t m_connections;
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::vector<Request> m_queued;
+    std::vector<Request> m_active;
+    UrlRequestId m_lastId = 0;
+    size_t m_requests = 0;
+    bool m_running = true;
+
+    std::thread m_thread;
+};
+
+using TileTrace = std::vector<std::vector<TileID>>;
+
+// Tiles of a viewport of 4x3 tiles, panning 8 tiles east and back at zoom 15,
+// then zooming in to 16 and out again
+static TileTrace syntheticTrace() {
+    TileTrace trace;
+    auto viewport = [&](double _x, double _y, int _z) {
+        std::vector<TileID> tiles;
+        for (int y = int(std::floor(_y - 1.5)); y <= int(std::floor(_y + 1.5)); y++) {
+            for (int x = int(std::floor(_x - 2.0)); x <= int(std::floor(_x + 2.0)); x++) {
+                tiles.emplace_back(x, y, _z);
+            }
+        }
+        trace.push_back(std::move(tiles));
+    };
+    double x = 9650.5, y = 12320.5;
+    for (int frame = 0; frame <= 32; frame++) { viewport(x + frame * 0.25, y, 15); }
+    for (int frame = 32; frame >= 0; frame--) { viewport(x + frame * 0.25, y, 15); }
+    for (int frame = 0; frame < 8; frame++) { viewport(x * 2, y * 2, 16); }
+    for (int frame = 0; frame < 8; frame++) { viewport(x, y, 15); }
+    return trace;
+}
+
+static TileTrace loadTrace(const char* _path) {
+    std::ifstream file(_path);
+    if (!file) { return syntheticTrace(); }
+
+    TileTrace trace;
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream frame(line);
+        std::vector<TileID> tiles;
+        int x, y, z;
+        char slash;
+        while (frame >> z >> slash >> x >> slash >> y) { tiles.emplace_back(x, y, z); }
+        trace.push_back(std::move(tiles));
+    }
+    return trace;
+}
+
+// Replays the tile requests of a trace through a MemoryCacheDataSource, a
+// caching MBTilesDataSource and a NetworkDataSource on an emulated network.
+// Each frame requests the tiles that entered the view and cancels those that
+// left it while loading. Reports the time from request to data and the part
+// of the tiles that each source provided.
+class DataPathFixture : public benchmark::Fixture {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    TileTrace trace;
+    std::vector<char> content;
+    std::chrono::milliseconds frameInterval{33};
+
+    std::unique_ptr<EmulatedNetworkPlatform> platform;
+    std::shared_ptr<TileSource> source;
+    int networkLevel = 0;
+
+    std::mutex mutex;
+    std::condition_variable loaded;
+    std::unordered_map<TileID, std::shared_ptr<TileTask>> loading;
+    size_t pending = 0;
+    std::vector<double> timesToData;
+    std::vector<size_t> sourceTiles;
+    size_t canceled = 0;
+
+    void SetUp(const ::benchmark::State& _state) override {
+        trace = loadTrace(trace_file);
+        content = MockPlatform::getBytesFromFile(tile_file);
+    }
+
+    void TearDown(const ::benchmark::State& _state) override {
+        source.reset();
+        platform.reset();
+        std::remove(cache_file);
+    }
+
+    void createSources(const ::benchmark::State& _state) {
+        source.reset();
+        platform.reset();
+        std::remove(cache_file);
+
+        platform = std::make_unique<EmulatedNetworkPlatform>(content,
+                                                             std::chrono::milliseconds(_state.range(0)),
+                                                             _state.range(1) * 1024.0, _state.range(2));
+
+        auto memory = std::make_unique<MemoryCacheDataSource>();
+        memory->setCacheSize(4 * 1024 * 1024);
+        auto network = std::make_unique<NetworkDataSource>(*platform, "https://tiles.test/{z}/{x}/{y}.mvt",
+                                                           NetworkDataSource::UrlOptions());
+#ifdef TANGRAM_MBTILES_DATASOURCE
+        MBTilesOptions options;
+        options.connections = _state.range(3);
+        auto mbtiles = std::make_unique<MBTilesDataSource>(*platform, "bench", cache_file, "", true, false,
+                                                           options);
+        mbtiles->setNext(std::move(network));
+        memory->setNext(std::move(mbtiles));
+        networkLevel = 2;
+#else
+        memory->setNext(std::move(network));
+        networkLevel = 1;
+#endif
+        source = std::make_shared<TileSource>("bench", std::move(memory));
+        source->setFormat(TileSource::Format::Mvt);
+
+        loading.clear();
+        pending = 0;
+        timesToData.clear();
+        sourceTiles.assign(networkLevel + 1, 0);
+        canceled = 0;
+    }
+
+    void load(TileID _tileId, glm::dvec2 _center) {
+        auto task = source->createTask(_tileId);
+        glm::dvec2 offset = MapProjection::tileCenter(_tileId) - _center;
+        task->setPriority(offset.x * offset.x + offset.y * offset.y);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            loading[_tileId] = task;
+            pending++;
+        }
+        auto start = Clock::now();
+        source->loadTileData(task, {[this, start](std::shared_ptr<TileTask> _task) {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = loading.find(_task->tileId());
+            if (it == loading.end() || it->second != _task) { return; }
+            loading.erase(it);
+            pending--;
+            timesToData.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+            sourceTiles[std::min(_task->rawSource, networkLevel)]++;
+            loaded.notify_all();
+        }});
+    }
+
+    void cancel(TileID _tileId) {
+        std::shared_ptr<TileTask> task;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = loading.find(_tileId);
+            if (it == loading.end()) { return; }
+            task = it->second;
+            loading.erase(it);
+            pending--;
+            canceled++;
+        }
+        task->cancel();
+        source->cancelLoadingTile(*task);
+    }
+
+    void replay() {
+        std::vector<TileID> visible;
+        auto next = Clock::now();
+        for (auto& frame : trace) {
+            glm::dvec2 center(0.0);
+            for (auto& tileId : frame) { center += MapProjection::tileCenter(tileId) / double(frame.size()); }
+
+            for (auto& tileId : visible) {
+                if (std::find(frame.begin(), frame.end(), tileId) == frame.end()) { cancel(tileId); }
+            }
+            for (auto& tileId : frame) {
+                if (std::find(visible.begin(), visible.end(), tileId) == visible.end()) { load(tileId, center); }
+            }
+            visible = frame;
+
+            next += frameInterval;
+            std::this_thread::sleep_until(next);
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        loaded.wait(lock, [this]() { return pending == 0; });
+    }
+};
+
+static double percentile(std::vector<double>& _values, double _p) {
+    if (_values.empty()) { return 0; }
+    std::sort(_values.begin(), _values.end());
+    return _values[size_t(_p * (_values.size() - 1))];
+}
+
+BENCHMARK_DEFINE_F(DataPathFixture, DataPathReplay)(benchmark::State& st) {
+    std::vector<double> times;
+    std::vector<size_t> tiles;
+    size_t requests = 0, cancels = 0;
+
+    while (st.KeepRunning()) {
+        st.PauseTiming();
+        createSources(st);
+        st.ResumeTiming();
+
+        replay();
+
+        st.PauseTiming();
+        times.insert(times.end(), timesToData.begin(), timesToData.end());
+        tiles.resize(sourceTiles.size());
+        for (size_t i = 0; i < tiles.size(); i++) { tiles[i] += sourceTiles[i]; }
+        requests += platform->requests();
+        cancels += canceled;
+        st.ResumeTiming();
+    }
+
+    double total = std::max<double>(times.size(), 1);
+    st.counters["p50_ms"] = percentile(times, 0.5);
+    st.counters["p90_ms"] = percentile(times, 0.9);
+    st.counters["p99_ms"] = percentile(times, 0.99);
+    st.counters["memory_hits"] = tiles[0] / total;
+#ifdef TANGRAM_MBTILES_DATASOURCE
+    st.counters["mbtiles_hits"] = tiles[1] / total;
+#endif
+    st.counters["network"] = tiles[networkLevel] / total;
+    st.counters["requests"] = requests / double(st.iterations());
+    st.counters["canceled"] = cancels / double(st.iterations());
+}
+
+// Latency in ms, bandwidth per connection in KiB/s, connections, MBTiles connections
+static void dataPathArgs(benchmark::internal::Benchmark* _bench) {
+    _bench->Args({ 50, 2048, 6, 4 });
+    _bench->Args({ 200, 512, 6, 4 });
+    _bench->Args({ 200, 512, 2, 4 });
+    _bench->Args({ 50, 2048, 6, 1 });
+}
+BENCHMARK_REGISTER_F(DataPathFixture, DataPathReplay)->Apply(dataPathArgs)->Iterations(2)
+    ->UseRealTime()->Unit(benchmark::kMillisecond);
+
 
 BENCHMARK_MAIN();
@@ -0,0 +1,99 @@
+#include "benchmark/benchmark.h"
+
+#include "marker/marker.h"
+#include "util/mapProjection.h"
+#include "view/view.h"
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+using namespace Tangram;
+
+enum Pitch { flat, tilted };
+
+class ViewFixture : public benchmark::Fixture {
+public:
+    std::unique_ptr<View> view;
+    glm::dvec2 center;
+    int frame = 0;
+
+    void SetUp(const ::benchmark::State& _state) override {
+        view = std::make_unique<View>(1024, 768);
+        center = MapProjection::tileCenter({9650, 12320, 15});
+        view->setPosition(center);
+        view->setZoom(17.5f);
+        view->setMaxPitch(90);
+        if (Pitch(_state.range(0)) == tilted) { view->setPitch(1.f); }
+        frame = 0;
+    }
+
+    void TearDown(const ::benchmark::State& _state) override {
+        view.reset();
+    }
+
+    // Pan along a circle with a radius of two tiles
+    void step() {
+        frame++;
+        double t = frame / 60.0;
+        double radius = 2.0 * MapProjection::metersPerTileAtZoom(17);
+        view->setPosition(center.x + radius * std::cos(t), center.y + radius * std::sin(t));
+        view->update();
+    }
+};
+
+// Visible tiles of the view at a high zoom, where tile coordinates are large
+BENCHMARK_DEFINE_F(ViewFixture, VisibleTiles)(benchmark::State& st) {
+    int tiles = 0;
+    while (st.KeepRunning()) {
+        step();
+        tiles = 0;
+        view->getVisibleTiles([&](TileID) { tiles++; });
+    }
+    st.counters["tiles"] = tiles;
+}
+BENCHMARK_REGISTER_F(ViewFixture, VisibleTiles)->Arg(flat)->Arg(tilted);
+
+// Per-frame projection of markers spread over the view
+BENCHMARK_DEFINE_F(ViewFixture, MarkerProjection)(benchmark::State& st) {
+    std::vector<std::unique_ptr<Marker>> markers;
+    double span = 4.0 * MapProjection::metersPerTileAtZoom(17);
+    for (int i = 0; i < 1000; i++) {
+        auto marker = std::make_unique<Marker>(i + 1);
+        BoundingBox bounds;
+        bounds.min = { center.x + span * (i % 32) / 32.0, center.y + span * (i / 32) / 32.0 };
+        bounds.max = bounds.min + glm::dvec2(10.0);
+        marker->setBounds(bounds);
+        markers.push_back(std::move(marker));
+    }
+
+    while (st.KeepRunning()) {
+        step();
+        for (auto& marker : markers) { marker->update(frame / 60.0, *view); }
+        benchmark::DoNotOptimize(markers.back()->modelViewProjectionMatrix());
+    }
+}
+BENCHMARK_REGISTER_F(ViewFixture, MarkerProjection)->Arg(flat)->Arg(tilted);
+
+// Screen positions of points given in degrees, as for the screen positions of
+// markers and labels that platforms request
+BENCHMARK_DEFINE_F(ViewFixture, LngLatToScreenPosition)(benchmark::State& st) {
+    std::vector<LngLat> points;
+    LngLat origin = MapProjection::projectedMetersToLngLat(center);
+    for (int i = 0; i < 1000; i++) {
+        points.push_back({ origin.longitude + 0.01 * (i % 32) / 32.0,
+                           origin.latitude + 0.01 * (i / 32) / 32.0 });
+    }
+
+    while (st.KeepRunning()) {
+        step();
+        bool outside = false;
+        for (auto& point : points) {
+            auto position = view->lngLatToScreenPosition(point.longitude, point.latitude, outside);
+            benchmark::DoNotOptimize(position);
+        }
+    }
+}
+BENCHMARK_REGISTER_F(ViewFixture, LngLatToScreenPosition)->Arg(flat)->Arg(tilted);
+
+BENCHMARK_MAIN();
@@ -3,7 +3,9 @@
 #include "data/tileSource.h"
 #include "util/types.h"
 
+#include <map>
 #include <mutex>
+#include <vector>
 
 namespace Tangram {
 
@@ -15,9 +17,36 @@ class ClientDataSource : public TileSource {
 
 public:
 
+    // Point features are drawn as clusters up to maxZoom when enabled. Clusters
+    // have the properties 'cluster' and 'point_count'.
+    struct ClusterOptions {
+        ClusterOptions() {}
+
+        bool enabled = false;
+        // Radius in pixels within which points are clustered
+        float radius = 40;
+        int maxZoom = 16;
+    };
+
+    // Features are tiled with geojson-vt. The tiles up to indexMaxZoom with more
+    // than indexMaxPoints points are split when the features are tiled, the others
+    // when they are first loaded, and all of them are kept for later loads.
+    struct TilingOptions {
+        TilingOptions() {}
+
+        int indexMaxZoom = 5;
+        int indexMaxPoints = 100000;
+        // Drop the added features once they are tiled, so that only the tiled
+        // copy is kept in memory. The features can then no longer be updated
+        // or removed by their ID, only all at once with clearFeatures.
+        bool releaseFeatures = false;
+    };
+
     ClientDataSource(Platform& _platform, const std::string& _name,
                         const std::string& _url, bool generateCentroids = false,
-                        TileSource::ZoomOptions _zoomOptions = {});
+                        TileSource::ZoomOptions _zoomOptions = {},
+                        ClusterOptions _clusterOptions = {},
+                        TilingOptions _tilingOptions = {});
 
     ~ClientDataSource() override;
 
@@ -45,22 +74,77 @@ public:
     // http://www.iana.org/assignments/media-types/application/geo+json
     const char* mimeType() const override { return "application/geo+json"; };
 
+    using FeatureId = uint64_t;
+
     // Add geometry from a GeoJSON string
     void addData(const std::string& _data);
 
-    void addPointFeature(Properties&& properties, LngLat coordinates);
+    // Add geometry from a GeoJSON document that arrives in chunks. The features
+    // of a FeatureCollection are added as soon as each one is complete, so the
+    // whole document is not held in memory.
+    void beginData();
+    void appendData(const char* _data, size_t _length);
+    // Returns false when the document was incomplete or invalid
+    bool endData();
+
+    // Add a feature. The returned ID updates or removes the feature later.
+    FeatureId addPointFeature(Properties&& properties, LngLat coordinates);
 
-    void addPolylineFeature(Properties&& properties, PolylineBuilder&& polyline);
+    FeatureId addPolylineFeature(Properties&& properties, PolylineBuilder&& polyline);
 
-    void addPolygonFeature(Properties&& properties, PolygonBuilder
+    FeatureId addPolygonFeature(Properties&& properties, PolygonBuilder
         && polygon);
 
+    // Property values of many features, given once for each key. A column has
+    // one value for each feature of the call that it is passed to.
+    struct NumberColumn {
+        std::string key;
+        const double* values;
+    };
+
+    struct StringColumn {
+        std::string key;
+        const std::string* values;
+    };
+
+    // Add _count points in one call. _coordinates holds the longitude and
+    // latitude of each point. The features get consecutive IDs, starting at
+    // the returned ID.
+    FeatureId addPointFeatures(size_t _count, const double* _coordinates,
+                               const std::vector<NumberColumn>& _numbers = {},
+                               const std::vector<StringColumn>& _strings = {});
+
+    // Add _count polylines in one call. The points of polyline i are the
+    // coordinate pairs from _offsets[i] to _offsets[i + 1] in _coordinates.
+    FeatureId addPolylineFeatures(size_t _count, const double* _coordinates, const uint32_t* _offsets,
+                                  const std::vector<NumberColumn>& _numbers = {},
+                                  const std::vector<StringColumn>& _strings = {});
+
+    // Replace the properties and geometry of a feature. Returns false when
+    // there is no feature with the ID, or it was released, see TilingOptions.
+    bool updatePointFeature(FeatureId _id, Properties&& properties, LngLat coordinates);
+
+    bool updatePolylineFeature(FeatureId _id, Properties&& properties, PolylineBuilder&& polyline);
+
+    bool updatePolygonFeature(FeatureId _id, Properties&& properties, PolygonBuilder&& polygon);
+
+    bool removeFeature(FeatureId _id);
+
     // Remove all feature data.
     void clearFeatures();
 
-    // Transform added feature data into tiles.
+    // Transform added feature data into tiles. Only the parts of the tile
+    // pyramid with changed features are tiled again, and only the tiles that
+    // overlap them are rebuilt.
     void generateTiles();
 
+    int64_t tileGeneration(const TileID& _tileId) const override;
+
+    void clearData() override;
+
+    /* Adds the estimated size of the features and their geojson-vt indices */
+    void getMemoryUsage(MemoryUsage& _usage) const override;
+
     void loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) override;
     std::shared_ptr<TileTask> createTask(TileID _tileId) override;
 
@@ -73,10 +157,34 @@ protected:
     struct Storage;
     std::unique_ptr<Storage> m_store;
 
+    // Splits a GeoJSON document into features while it is read
+    class GeoJsonStream;
+    std::unique_ptr<GeoJsonStream> m_stream;
+
+    void addFeatures(const char* _json, size_t _length);
+
+    // Tiled features, published atomically by generateTiles. parse reads the
+    // current snapshot without locking the store.
+    struct Snapshot;
+    std::shared_ptr<const Snapshot> m_snapshot;
+    std::mutex m_mutexBuild;
+
+    // Generations of the branches of the tile pyramid, see Storage
+    std::map<TileID, int64_t> m_branchGenerations;
+    int64_t m_globalGeneration = 0;
+    // Generation of the clusters, for the tiles up to the cluster max zoom
+    int64_t m_clusterGeneration = 0;
+    int64_t m_baseGeneration = 0;
+    mutable std::mutex m_mutexGenerations;
+
+    // Guards m_store while features are edited
     mutable std::mutex m_mutexStore;
     bool m_hasPendingData = false;
     bool m_generateCentroids = false;
 
+    ClusterOptions m_clusterOptions;
+    TilingOptions m_tilingOptions;
+
     Platform& m_platform;
 
 };
@@ -1,12 +1,16 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace Tangram {
 
 class Value;
 struct PropertyItem;
+struct PropertyTable;
 
 // Helper to cleanup double string values from trailing 0s
 std::string doubleToString(double _doubleValue);
@@ -14,32 +18,63 @@ std::string doubleToString(double _doubleValue);
 struct Properties {
     using Item = PropertyItem;
 
+    // Indices of a key and a value in a PropertyTable
+    using Tag = std::pair<uint32_t, uint32_t>;
+
+    // Property keys used by filters and styles are interned in a process-wide
+    // table. Lookups by KeyId compare integers instead of strings.
+    using KeyId = uint32_t;
+
+    // Returns the KeyId of _key, adding it to the table if needed. Called where
+    // filters and styles are compiled. This is thread-safe.
+    static KeyId internKey(const std::string& _key);
+
+    // Returns the KeyId of _key for the items of parsed features without adding
+    // it to the table. Keys that are not interned get an id matching no interned
+    // key. Only the first lookup of a key by a thread after a key was interned
+    // takes the lock. This is thread-safe.
+    static KeyId findKey(const std::string& _key);
+
+    // Whether an item key with the id _itemKeyId from findKey() is the key _key
+    static bool matchesKey(KeyId _itemKeyId, const std::string& _itemKey, KeyId _key) {
+        if (_itemKeyId == _key) { return true; }
+        // Keys that were interned after the item key was looked up
+        return (_itemKeyId & not_interned) && _key >= (_itemKeyId & ~not_interned) &&
+            findKey(_itemKey) == _key;
+    }
+
     Properties();
     ~Properties();
 
-    Properties(const Properties& _other) = default;
+    // Copies always hold their own items
+    Properties(const Properties& _other);
     Properties(Properties&& _other) = default;
     Properties(std::vector<Item>&& _items);
-    Properties& operator=(const Properties& _other) = default;
+    Properties& operator=(const Properties& _other);
     Properties& operator=(Properties&& _other);
 
     const Value& get(const std::string& key) const;
+    const Value& get(KeyId key) const;
 
     void sort();
 
     void clear();
 
     bool contains(const std::string& key) const;
+    bool contains(KeyId key) const;
 
     bool getNumber(const std::string& key, double& value) const;
+    bool getNumber(KeyId key, double& value) const;
 
     double getNumber(const std::string& key) const;
 
     bool getString(const std::string& key, std::string& value) const;
 
     const std::string& getString(const std::string& key) const;
+    const std::string& getString(KeyId key) const;
 
     std::string getAsString(const std::string& key) const;
+    std::string getAsString(KeyId key) const;
 
     bool getAsString(const std::string& key, std::string& value) const;
 
@@ -50,12 +85,22 @@ struct Properties {
 
     void setSorted(std::vector<Item>&& _items);
 
+    // Set the properties as tags referencing the shared keys and values of
+    // _table. get() looks values up in the table, all modifying functions
+    // first convert the tags into items.
+    void setTags(std::shared_ptr<const PropertyTable> _table, std::vector<Tag>&& _tags);
+
+    // Convert tags into items. Parsers call this before the Properties are
+    // shared between threads, as items() only returns items.
+    void resolve();
+
     // template <typename... Args> void set(std::string key, Args&&... args) {
     //     props.emplace_back(std::move(key), Value{std::forward<Args>(args)...});
     //     sort();
     // }
 
-    const std::vector<Item>& items() const { return props; }
+    // Items of resolved Properties
+    const std::vector<Item>& items() const;
 
     int32_t sourceId;
 
@@ -69,7 +114,17 @@ struct Properties {
         }
     }
 private:
+    // Flag of the ids of keys that were not interned. The other bits hold the
+    // number of interned keys at the time.
+    static constexpr KeyId not_interned = 0x80000000;
+
+    // Items of the tags, in key order. Does not change the tags.
+    std::vector<Item> resolvedItems() const;
+
     std::vector<Item> props;
+
+    std::shared_ptr<const PropertyTable> m_table;
+    std::vector<Tag> m_tags;
 };
 
 }
@@ -1,15 +1,25 @@
 #pragma once
 
+#include "data/properties.h"
 #include "util/variant.h"
 
+#include <vector>
+
 namespace Tangram {
 
 struct PropertyItem {
     PropertyItem(std::string _key, Value _value) :
-        key(std::move(_key)), value(std::move(_value)) {}
+        key(std::move(_key)), value(std::move(_value)) {
+        keyId = Properties::findKey(key);
+    }
+
+    PropertyItem(std::string _key, Properties::KeyId _keyId, Value _value) :
+        key(std::move(_key)), value(std::move(_value)), keyId(_keyId) {}
 
     std::string key;
     Value value;
+    // Id of the key from Properties::findKey()
+    Properties::KeyId keyId;
     bool operator<(const PropertyItem& _rhs) const {
         return key.size() == _rhs.key.size()
             ? key < _rhs.key
@@ -17,4 +27,17 @@ struct PropertyItem {
     }
 };
 
+// Keys and values shared by the Properties of the features in a layer of a tile
+struct PropertyTable {
+    std::vector<std::string> keys;
+    std::vector<Value> values;
+    // Rank of each key in the key ordering of Properties
+    std::vector<uint32_t> keyOrder;
+    // Ids of the keys from Properties::findKey()
+    std::vector<Properties::KeyId> keyIds;
+
+    // Set keyOrder and keyIds once all keys are added
+    void orderKeys();
+};
+
 }
@@ -13,8 +13,10 @@ struct TileData;
 struct TileID;
 struct Raster;
 class RasterSource;
+class NetworkDataSource;
 class Tile;
 class TileManager;
+struct MemoryUsage;
 struct RawCache;
 class Texture;
 
@@ -61,8 +63,30 @@ public:
             if (next) { next->cancelLoadingTile(_task); }
         }
 
+        /* Pass on a new priority of a task that is loading */
+        virtual void updateTilePriority(TileTask& _task) {
+            if (next) { next->updateTilePriority(_task); }
+        }
+
         virtual void clear() { if (next) next->clear(); }
 
+        /* Bytes of tile data held in memory by this and the next sources */
+        virtual size_t memoryUsage() const { return next ? next->memoryUsage() : 0; }
+
+        /* Releases tile data held in memory that can be loaded again */
+        virtual void releaseMemory() { if (next) next->releaseMemory(); }
+
+        /* Copies the tile data cached by _previous, the same chain of sources
+         * of a previous scene, into this and the next sources */
+        virtual void copyCache(const DataSource& _previous) {
+            if (next && _previous.next) { next->copyCache(*_previous.next); }
+        }
+
+        /* The source at the end of the chain when it loads tiles from the network */
+        virtual const NetworkDataSource* networkSource() const {
+            return next ? next->networkSource() : nullptr;
+        }
+
         void setNext(std::unique_ptr<DataSource> _next) {
             next = std::move(_next);
             next->level = level + 1;
@@ -103,12 +127,47 @@ public:
     /* Stops any running I/O tasks pertaining to @_task */
     virtual void cancelLoadingTile(TileTask& _task);
 
+    /* Pass on a new priority of a task that is loading to the requests for its data */
+    void updateTilePriority(TileTask& _task);
+
     /* Parse a <TileTask> with data into a <TileData>, returning an empty TileData on failure */
     virtual std::shared_ptr<TileData> parse(const TileTask& _task) const;
 
+    /* Parse the data of an overzoomed tile, beyond maxZoom. The overzoomed tiles
+     * of the same data tile share the parsed TileData, so it is parsed only once
+     * while zooming in. The task must have no feature filter, as the filters of
+     * the styling zoom would not apply to the other tiles. */
+    std::shared_ptr<TileData> parseOverzoomed(const TileTask& _task) const;
+
+    /* Number of data tiles of which the overzoomed tiles share the TileData */
+    static constexpr size_t overzoom_cache_tiles = 8;
+
+    /* Share the parsed TileData of overzoomed tiles with the sources of the same
+     * format and _key, usually the URL template, in this and other Map instances.
+     * The data is shared while any source or tile task holds it. */
+    void setSharedData(const std::string& _key);
+
+    /* Number of TileData shared between sources that are still held */
+    static size_t sharedDataCount();
+
     /* Clears all data associated with this TileSource */
     virtual void clearData();
 
+    /* Adds the memory used by this TileSource to _usage */
+    virtual void getMemoryUsage(MemoryUsage& _usage) const;
+
+    /* Releases cached data that can be loaded again, without changing the generation */
+    virtual void releaseMemory();
+
+    /* Copies the cached tile data of _previous, a source with the same
+     * configuration in a previous scene */
+    void copyCache(const TileSource& _previous);
+
+    /* The data source loading the tiles of this TileSource from the network, or null */
+    const NetworkDataSource* networkSource() const {
+        return m_sources ? m_sources->networkSource() : nullptr;
+    }
+
     const std::string& name() const { return m_name; }
 
     virtual std::shared_ptr<TileTask> createTask(TileID _tile);
@@ -119,6 +178,11 @@ public:
     /* Generation ID of TileSource state (incremented for each update, e.g. on clearData()) */
     int64_t generation() const { return m_generation; }
 
+    /* Generation of the data of a tile. Tiles built before this generation are
+     * rebuilt; sources that update only parts of their data return less than
+     * generation() for unchanged tiles. */
+    virtual int64_t tileGeneration(const TileID& _tileId) const { return m_generation; }
+
     const ZoomOptions& zoomOptions() { return m_zoomOptions; }
     int32_t minDisplayZoom() const { return m_zoomOptions.minDisplayZoom; }
     int32_t maxDisplayZoom() const { return m_zoomOptions.maxDisplayZoom; }
@@ -176,6 +240,18 @@ protected:
     std::vector<RasterSource*> m_rasterSources;
 
     std::unique_ptr<DataSource> m_sources;
+
+    struct OverzoomEntry {
+        TileID id;
+        int64_t generation;
+        std::shared_ptr<TileData> data;
+    };
+    // Parsed TileData of overzoomed tiles, most recently used first
+    mutable std::vector<OverzoomEntry> m_overzoomData;
+    mutable std::mutex m_overzoomMutex;
+
+    // Key of the TileData shared with other sources, empty when not shared
+    std::string m_sharedDataKey;
 };
 
 }
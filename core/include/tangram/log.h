@@ -3,6 +3,7 @@
 #include "platform.h"
 
 #include <atomic>
+#include <cstdint>
 #include <cstring>
 
 /*
@@ -12,9 +13,39 @@
  * LOGE: Error log, LOG_LEVEL >= 1
  * LOGN: Notification log (displayed once), LOG_LEVEL >= 0
  * LOG: Default log, LOG_LEVEL >= 0
+ * LOGC: Trace log of a LogCategory enabled by setLogCategories(), LOG_LEVEL >= 0
  * LOGS: Screen log, no LOG_LEVEL
+ *
+ * Levels above LOG_LEVEL are compiled out. Debug and trace logs are written
+ * by a logging thread, see logAsync().
  */
 
+namespace Tangram {
+
+enum class LogCategory : uint32_t {
+    tile = 1 << 0,
+    render = 1 << 1,
+    network = 1 << 2,
+};
+
+// Enable the trace logs of the LogCategory bits in _mask, none by default
+void setLogCategories(uint32_t _mask);
+
+extern std::atomic<uint32_t> logCategories;
+
+inline bool logCategoryEnabled(LogCategory _category) {
+    return (logCategories.load(std::memory_order_relaxed) & uint32_t(_category)) != 0;
+}
+
+// Format a message and queue it for logMsg() on the logging thread. Messages
+// are truncated to 255 characters and dropped while the queue is full.
+void logAsync(const char* fmt, ...);
+
+// Wait until the queued messages are written
+void flushLog();
+
+}
+
 //#define __FILENAME__ (strrchr(__FILE__, '/') ? strrchr(__FILE__, '/') + 1 : __FILE__)
 // From: https://blog.galowicz.de/2016/02/20/short_file_macro/
 static constexpr const char * past_last_slash(const char * const str, const char * const last_slash) {
@@ -37,7 +68,7 @@ static constexpr const char * past_last_slash(const char * const str) {
 
 #if LOG_LEVEL >= 3
 #define LOGD(fmt, ...) \
-do { Tangram::logMsg("DEBUG %s:%d: " fmt "\n", __FILENAME__, __LINE__, ## __VA_ARGS__); } while(0)
+do { Tangram::logAsync("DEBUG %s:%d: " fmt "\n", __FILENAME__, __LINE__, ## __VA_ARGS__); } while(0)
 #else
 #define LOGD(fmt, ...)
 #endif
@@ -66,9 +97,17 @@ do { Tangram::logMsg("ERROR %s:%d: " fmt "\n", __FILENAME__, __LINE__, ## __VA_A
 
 #define LOG(fmt, ...)                                                   \
     do { Tangram::logMsg("TANGRAM %s:%d: " fmt "\n", __FILENAME__, __LINE__, ##__VA_ARGS__); } while (0)
+
+#define LOGC(category, fmt, ...)                                                                  \
+    do {                                                                                          \
+        if (Tangram::logCategoryEnabled(Tangram::LogCategory::category)) {                        \
+            Tangram::logAsync("TRACE %s:%d: " fmt "\n", __FILENAME__, __LINE__, ##__VA_ARGS__);   \
+        }                                                                                         \
+    } while (0)
 #else
 #define LOG(fmt, ...)
 #define LOGN(fmt, ...)
+#define LOGC(category, fmt, ...)
 #endif
 
 #if 0
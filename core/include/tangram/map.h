@@ -6,6 +6,7 @@
 
 #include <array>
 #include <functional>
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
@@ -80,6 +81,41 @@ using SceneReadyCallback = std::function<void(SceneID id, const SceneError*)>;
 
 using CameraAnimationCallback = std::function<void(bool finished)>;
 
+// Receives the PNG encoded image of a queued snapshot, or an empty buffer when it could not be rendered
+using SnapshotCallback = std::function<void(std::vector<uint8_t> png)>;
+
+struct OfflineRegion {
+    // Bounds of the region
+    LngLat min;
+    LngLat max;
+    // Range of map zoom levels, converted to the tile zoom levels of each source
+    int minZoom = 0;
+    int maxZoom = 16;
+    // Names of the network sources of the current scene to download
+    std::vector<std::string> sources;
+    // Path of the MBTiles file of each source, with '{source}' replaced by the
+    // source name. The files can be used as 'url' of the sources.
+    std::string path;
+    // Maximum number of tile requests in flight
+    size_t concurrency = 8;
+    // Maximum number of tiles written in one transaction
+    size_t writeBatchSize = 64;
+};
+
+struct OfflineRegionProgress {
+    // Tiles of the region of all sources
+    size_t total = 0;
+    // Tiles that were already stored
+    size_t skipped = 0;
+    size_t downloaded = 0;
+    size_t failed = 0;
+    // Set in the last call, once the downloaded tiles are written
+    bool finished = false;
+};
+
+// Receives the progress of an offline region download, called from worker threads
+using OfflineRegionCallback = std::function<void(const OfflineRegionProgress& progress)>;
+
 enum class EaseType : char {
     linear = 0,
     cubic,
@@ -160,6 +196,99 @@ struct MapState {
     bool isAnimating() { return flags & is_animating; }
 };
 
+struct TileCacheStats {
+    // Tiles that were requested from the cache and found or not found
+    size_t hits = 0;
+    size_t misses = 0;
+    // Tiles that were removed to stay within the cache limits
+    size_t evictions = 0;
+    // Tiles currently in the cache
+    size_t tiles = 0;
+    // Bytes used by the tiles in the cache and the limit
+    size_t memoryUsage = 0;
+    size_t memoryLimit = 0;
+};
+
+struct MetricsHistogram {
+    // Bucket i counts durations below 2^i microseconds that are not counted
+    // by a lower bucket, the last bucket counts all longer durations
+    static constexpr size_t bucketCount = 20;
+    std::array<uint64_t, bucketCount> buckets{};
+
+    uint64_t count = 0;
+    double totalMs = 0;
+    double maxMs = 0;
+};
+
+struct PipelineMetrics {
+    enum Stage {
+        fetch = 0,          // Network request of tile data
+        cache_lookup,       // Lookup of the tile cache and disk cache
+        parse,              // Decoding of MVT, GeoJSON and other tile data
+        styling,            // Matching and merging draw rules of features
+        geometry_build,     // Evaluating draw rules and building meshes and labels
+        label_collision,    // Label occlusion and placement
+        mesh_upload,        // Upload of the meshes of a tile
+        render,             // Drawing of all styles in a frame
+        stage_count,
+    };
+    enum Counter {
+        tiles_built = 0,
+        tiles_canceled,     // Tile tasks canceled before their tile was built
+        cache_hits,         // Tiles taken from the tile cache or the disk cache
+        counter_count,
+    };
+    // Draw calls, vertices (indices of indexed draws) and GL state changes
+    struct DrawCounts {
+        uint64_t drawCalls = 0;
+        uint64_t vertices = 0;
+        uint64_t stateChanges = 0;
+    };
+    std::array<MetricsHistogram, stage_count> stages;
+    // Drawing time per style
+    std::map<std::string, MetricsHistogram> renderStyles;
+    // GPU time per style and of the feature selection pass, measured with
+    // timer queries when the GPU supports them
+    std::map<std::string, MetricsHistogram> renderStylesGpu;
+    MetricsHistogram selectionGpu;
+    // Draw counts per style
+    std::map<std::string, DrawCounts> renderStyleDraws;
+    std::array<uint64_t, counter_count> counters{};
+};
+
+struct MemoryUsage {
+    enum Category {
+        tile_meshes = 0,    // Meshes of the tiles in view and their proxies
+        raster_textures,    // Raster textures of the tiles in view
+        tile_cache,         // Meshes and rasters of the tiles in the tile cache
+        data_cache,         // Tile data in the in-memory caches of the sources
+        client_data,        // Features and geojson-vt indices of ClientDataSources
+        glyph_atlases,      // Glyph textures of the font atlas
+        font_cache,         // Text layouts and glyph distance fields
+        scene_textures,     // Textures of the scene, e.g. sprites and style textures
+        javascript,         // Heaps of the JavaScript contexts of all scenes
+        category_count,
+    };
+    // Bytes in CPU memory and in GPU buffers and textures per category
+    std::array<size_t, category_count> cpuBytes{};
+    std::array<size_t, category_count> gpuBytes{};
+
+    size_t total() const {
+        size_t sum = 0;
+        for (size_t i = 0; i < category_count; i++) { sum += cpuBytes[i] + gpuBytes[i]; }
+        return sum;
+    }
+};
+
+struct QueueDepths {
+    // Tile tasks waiting for a worker
+    size_t tileTasks = 0;
+    // URL requests that were started and did not finish yet
+    size_t urlRequests = 0;
+    // Jobs waiting to run on the GL thread
+    size_t jobs = 0;
+};
+
 class Map {
 
 public:
@@ -200,6 +329,13 @@ public:
         return loadScene(SceneOptions{_yaml, Url(_resourceRoot), _useScenePosition, _sceneUpdates}, true);
     }
 
+    // Apply SceneUpdates to the current scene. Values of style uniforms, material colors
+    // and dynamic lights are applied in place for the next frame. Style draw parameters,
+    // layers and source parameters are applied in place and only the tiles of affected
+    // sources are rebuilt. Other changes load the scene again asynchronously with the
+    // updates. The scene ready listener is called in all cases.
+    SceneID updateScene(const std::vector<SceneUpdate>& _sceneUpdates);
+
     // Set listener for scene load events. The callback receives the SceneID
     // of the loaded scene and SceneError in case loading was not successful.
     // The callback may be be called from the main or worker thread.
@@ -240,6 +376,31 @@ public:
     // Each unsigned int corresponds to an RGBA pixel value
     void captureSnapshot(unsigned int* _data);
 
+    // Queue a snapshot of the map at _camera of _width x _height physical pixels. Snapshots are
+    // taken in order: update() moves the view to the next one and render() draws it into an
+    // offscreen buffer once its view is complete. The pixels are read back while the tiles of the
+    // following snapshot load, and _callback is called with the encoded image on a worker thread.
+    // The view keeps the camera and size of the last snapshot.
+    void queueSnapshot(const CameraPosition& _camera, int _width, int _height, SnapshotCallback _callback);
+
+    // Add a view of _width x _height physical pixels that is drawn from the scene and tiles of this
+    // map, e.g. an overview. Its tiles are loaded by update() along with those of the map, so that
+    // it costs only the drawing. Labels and markers are placed for the map view only and are not
+    // drawn in added views. Returns the id of the view.
+    int32_t addView(int _width, int _height);
+
+    // Remove the view _id of addView(), returns false when there is no such view
+    bool removeView(int32_t _id);
+
+    // Set the size of the view _id in physical pixels
+    void resizeView(int32_t _id, int _width, int _height);
+
+    // Set the camera of the view _id
+    void setViewCameraPosition(int32_t _id, const CameraPosition& _camera);
+
+    // Render the view _id into the framebuffer bound on the GL thread of the map, after render()
+    void renderView(int32_t _id);
+
     // Set the position of the map view in degrees longitude and latitude
     void setPosition(double _lon, double _lat);
 
@@ -269,6 +430,12 @@ public:
     // Get the maximum zoom level for the view.
     float getMaxZoom() const;
 
+    // Set how tiles far from the camera in tilted views are loaded at lower zoom
+    // levels: _pixelError is the size in pixels up to which one pixel of a tile may
+    // appear on screen (1.5 by default, 0 disables it), and above _maxTiles visible
+    // tiles the error is raised until they fit (0, the default, means no limit).
+    void setTileDetail(float _pixelError, int _maxTiles);
+
     // Set the counter-clockwise rotation of the view in radians; 0 corresponds to
     // North pointing up
     void setRotation(float _radians);
@@ -339,6 +506,16 @@ public:
     // Returns true if the source was found and cleared, otherwise returns false.
     bool clearTileSource(TileSource& _source, bool _data, bool _tiles);
 
+    // Download the tiles of _region into MBTiles files and report the progress to _callback;
+    // tiles that are already stored are skipped, so an interrupted download resumes when it
+    // is started again. Returns an ID for cancelOfflineRegion(), or 0 when no source of the
+    // region can be downloaded.
+    int32_t downloadOfflineRegion(const OfflineRegion& _region, OfflineRegionCallback _callback);
+
+    // Stop requesting the tiles of an offline region download; tiles already downloaded are
+    // still written. Returns true if the download was found, otherwise returns false.
+    bool cancelOfflineRegion(int32_t _id);
+
     // Add a marker object to the map and return an ID for it; an ID of 0 indicates an invalid marker;
     // the marker will not be drawn until both styling and geometry are set using the functions below.
     MarkerID markerAdd();
@@ -347,6 +524,14 @@ public:
     // removed, otherwise returns false.
     bool markerRemove(MarkerID _marker);
 
+    // Add _count marker objects to the map and write their IDs to _markers, which must have room
+    // for _count IDs; the markers are like those of 'markerAdd'.
+    void markerAdd(MarkerID* _markers, int _count);
+
+    // Remove the marker objects with the _count IDs in _markers; returns the number of markers that
+    // were found and removed.
+    int markerRemove(const MarkerID* _markers, int _count);
+
     // Set the styling for a marker object; _styling is a string of YAML that specifies a 'draw rule'
     // according to the scene file syntax; returns true if the marker ID was found and successfully
     // updated, otherwise returns false.
@@ -357,6 +542,27 @@ public:
     // returns true if the marker ID was found and successfully updated, otherwise returns false.
     bool markerSetStylingFromPath(MarkerID _marker, const char* _path);
 
+    // Create a styling that can be shared by many markers; _styling is a string of YAML like for
+    // 'markerSetStylingFromString'. It is parsed once for all of its markers and its draw rule is
+    // evaluated once per zoom level; returns an ID for it, or 0 if _styling is null.
+    MarkerStylingID markerCreateStylingFromString(const char* _styling);
+
+    // Create a styling that can be shared by many markers from a draw rule path like for
+    // 'markerSetStylingFromPath'; returns an ID for it, or 0 if _path is null.
+    MarkerStylingID markerCreateStylingFromPath(const char* _path);
+
+    // Remove a shared styling; markers that use it keep their styling; returns true if the
+    // styling ID was found and removed, otherwise returns false.
+    bool markerRemoveStyling(MarkerStylingID _styling);
+
+    // Set the shared styling of a marker object; returns true if the marker ID and the styling ID
+    // were found and the marker was successfully updated, otherwise returns false.
+    bool markerSetStyling(MarkerID _marker, MarkerStylingID _styling);
+
+    // Set the shared styling of the marker objects with the _count IDs in _markers; returns the
+    // number of markers that were found and updated.
+    int markerSetStyling(const MarkerID* _markers, int _count, MarkerStylingID _styling);
+
     // Set a bitmap to use as the image for a point marker; _data is a buffer of RGBA pixel data with
     // length of _width * _height; pixels are in row-major order beginning from the bottom-left of the
     // image; returns true if the marker ID was found and successfully updated, otherwise returns false.
@@ -367,6 +573,11 @@ public:
     // marker ID was found and successfully updated, otherwise returns false.
     bool markerSetPoint(MarkerID _marker, LngLat _lngLat);
 
+    // Set the geometry of each of the marker objects with the _count IDs in _markers to a point at
+    // the coordinates with the same index in _lngLats; returns the number of markers that were found
+    // and updated.
+    int markerSetPoint(const MarkerID* _markers, const LngLat* _lngLats, int _count);
+
     // Set the geometry of a marker to a point at the given coordinates; if the marker was previously
     // set to a point, this eases the position over the given duration in seconds with the given EaseType;
     // returns true if the marker ID was found and successfully updated, otherwise returns false.
@@ -378,6 +589,13 @@ public:
     // successfully updated, otherwise returns false.
     bool markerSetPolyline(MarkerID _marker, LngLat* _coordinates, int _count);
 
+    // Append the given coordinates to the polyline of a marker, or set the marker to a polyline along
+    // them if it is not one; _coordinates is a pointer to a sequence of _count LngLats. The mesh of the
+    // polyline is extended instead of being built again, so that a line that grows by a few points at
+    // a time, like a GPS trail, is updated at the cost of the new points; returns true if the marker
+    // ID was found and successfully updated, otherwise returns false.
+    bool markerAppendPolyline(MarkerID _marker, LngLat* _coordinates, int _count);
+
     // Set the geometry of a marker to a polygon with the given coordinates; _counts is a pointer
     // to a sequence of _rings integers and _coordinates is a pointer to a sequence of LngLats with
     // a total length equal to the sum of _counts; for each integer n in _counts, a polygon is created
@@ -425,6 +643,11 @@ public:
     // efficiency, but can cause errors if your application code makes OpenGL calls (false by default)
     void useCachedGlState(bool _use);
 
+    // Set whether the map is rendered into an offscreen frame that is drawn again while the view,
+    // tiles, labels and markers do not change; this saves the scene draw calls for static views at
+    // the cost of a screen-sized buffer (false by default)
+    void useFrameCache(bool _use);
+
     // Set the radius in logical pixels to use when picking features on the map (default is 0.5).
     void setPickRadius(float _radius);
 
@@ -444,12 +667,70 @@ public:
     // with its associated properties or null if no marker was found.
     void pickMarkerAt(float _x, float _y, MarkerPickCallback _onMarkerPickCallback);
 
+    // Set the state of the feature with _featureId of the TileSource with _sourceId in the
+    // current scene, e.g. to highlight it, without rebuilding its tiles. Shader blocks read
+    // the bytes of _state, from the lowest, as a vec4 in [0, 1] with featureState(). Only
+    // 'interactive' polygons and lines of features with an ID have a state.
+    void setFeatureState(int32_t _sourceId, uint64_t _featureId, uint32_t _state);
+
+    // Reset the states of all features of the current scene to 0
+    void clearFeatureStates();
+
     // Run this task asynchronously to Tangram's main update loop.
     void runAsyncTask(std::function<void()> _task);
 
     // Send a signal to Tangram that the platform received a memory warning
     void onMemoryWarning();
 
+    // Get statistics of the in-memory tile cache of the current scene
+    TileCacheStats getTileCacheStats();
+
+    // Get the bytes of CPU and GPU memory used by the current scene per category
+    MemoryUsage getMemoryUsage();
+
+    // Get the number of tile tasks, URL requests and GL jobs that are pending
+    QueueDepths getQueueDepths();
+
+    // Limit the memory used by the current and later scenes to about _bytes; 0 removes
+    // the limit. Above the limit cached data is released in the order of the cost to
+    // recreate it: tiles of the tile cache, cached tile data, then text layouts and font
+    // resources. onMemoryWarning() releases all of them and the tiles in view.
+    void setMemoryBudget(size_t _bytes);
+
+    // Keep update() and render() of a frame within about _milliseconds, e.g. 16 for
+    // 60 fps; 0 removes the target (default). While frames take longer, fewer tiles
+    // are uploaded and shown per frame and labels are placed every few frames.
+    void setTargetFrameTime(float _milliseconds);
+
+    // Get the quality tier of the current scene. For a scene loaded with
+    // QualityTier::automatic this is the tier it was lowered to while frames
+    // were slower than the target frame time, or 20 ms without a target.
+    QualityTier getQualityTier() const;
+
+    // Turn collection of PipelineMetrics on or off (off by default). Metrics are
+    // collected by each thread and shared by all Map instances.
+    static void setMetricsEnabled(bool _enabled);
+
+    // Get the PipelineMetrics collected since metrics were enabled or last reset,
+    // and reset them when _reset is true, e.g. to export them periodically
+    static PipelineMetrics getPipelineMetrics(bool _reset = false);
+
+    // Turn recording of trace events of tile building, scene updates and
+    // rendering on or off (off by default). Shared by all Map instances.
+    static void setTraceEnabled(bool _enabled);
+
+    // Get the recorded trace events in the Chrome trace JSON format, which can
+    // be opened in chrome://tracing or Perfetto. Removes them when _clear is true.
+    static std::string getTraceJson(bool _clear = true);
+
+    // Get the glyph distance fields of the current scene, in the format loaded from
+    // the 'fields' url of a font. Requires SceneOptions::recordGlyphFields.
+    std::vector<char> getGlyphFields();
+
+    // Limit the memory of the tile cache used by tiles of the TileSource with _sourceId
+    // in the current scene to _bytes; 0 removes the limit (the total cache size still applies)
+    void setTileCacheBudget(int32_t _sourceId, size_t _bytes);
+
     // Sets an opaque default background color used as default color when a scene is being loaded
     // r, g, b must be between 0.0 and 1.0
     void setDefaultBackgroundColor(float r, float g, float b);
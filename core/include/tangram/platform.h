@@ -1,8 +1,10 @@
 #pragma once
 
+#include "sceneOptions.h"
 #include "util/url.h"
 
 #include <atomic>
+#include <cstdint>
 #include <functional>
 #include <mutex>
 #include <string>
@@ -15,6 +17,15 @@ namespace Tangram {
 // This is the handle which Platform uses to identify an UrlRequest.
 using UrlRequestHandle = uint64_t;
 
+// Validators of a previous response, to make a conditional request for the
+// same URL. Empty strings are not sent.
+struct UrlValidators {
+    std::string etag;
+    std::string lastModified;
+
+    bool empty() const { return etag.empty() && lastModified.empty(); }
+};
+
 // Result of a URL request. If the request could not be completed or if the
 // host returned an HTTP status code >= 400, a non-null error string will be
 // present. This error string is only valid in the scope of the UrlCallback
@@ -23,6 +34,14 @@ using UrlRequestHandle = uint64_t;
 struct UrlResponse {
     std::vector<char> content;
     const char* error = nullptr;
+    // HTTP status code, 0 when the platform does not report it. A conditional
+    // request returns 304 without content when the cached copy is still valid.
+    int statusCode = 0;
+    // Validators of the returned content, empty when the host sent none.
+    UrlValidators validators;
+    // Seconds for which the content may be used without revalidation, from
+    // Cache-Control max-age; -1 when the host did not specify it.
+    int64_t maxAge = -1;
 };
 
 // Function type for receiving data from a URL request.
@@ -30,6 +49,9 @@ using UrlCallback = std::function<void(UrlResponse&&)>;
 
 using FontSourceLoader = std::function<std::vector<char>()>;
 
+// Source of a font for the text renderer. Fonts given by path are opened by
+// FreeType, which maps or streams the file, while a loader returns the whole file.
+// Prefer paths for large font files.
 struct FontSourceHandle {
 
     FontSourceHandle() {}
@@ -56,6 +78,18 @@ void initGLExtensions();
 // Set the priority of the current thread. Priority is equivalent to pthread niceness
 void setCurrentThreadPriority(int priority);
 
+// Threads that are placed by setCurrentThreadPlacement
+enum class ThreadRole : uint8_t {
+    worker, // ThreadPool threads building tiles
+    io,     // Threads loading scenes and files
+    gl,     // The thread rendering the map
+};
+
+// Restrict the current thread to the cores suited for _role under _placement. Only
+// has an effect on CPUs with cores of different capacity; ThreadPlacement::none
+// lets the thread run on all cores again.
+void setCurrentThreadPlacement(ThreadRole _role, ThreadPlacement _placement);
+
 class Platform {
 
 public:
@@ -81,15 +115,38 @@ public:
     // thread than the original call to startUrlRequest.
     UrlRequestHandle startUrlRequest(Url _url, UrlCallback&& _callback);
 
+    // Start a conditional request with the validators of a cached copy of the
+    // content of _url. The response has status 304 and no content when the
+    // cached copy is still valid. Platforms which do not support conditional
+    // requests make a normal request.
+    UrlRequestHandle startUrlRequest(Url _url, const UrlValidators& _validators, UrlCallback&& _callback);
+
     // Stop retrieving data from a URL that was previously requested. When a
     // request is canceled its callback will still be run, but the response
     // will have an error string and the data may not be complete.
     void cancelUrlRequest(UrlRequestHandle _request);
 
+    // Hint how urgent a request is, from 0 to 1 for the most urgent. Requests
+    // start with a priority of 0.5 and it can be changed while they run.
+    // Platforms which can not reorder requests ignore it.
+    void setUrlRequestPriority(UrlRequestHandle _request, float _priority);
+
+    // Number of URL requests that were started and whose callback did not run yet
+    size_t activeUrlRequests();
+
     virtual FontSourceHandle systemFont(const std::string& _name, const std::string& _weight, const std::string& _face) const;
 
     virtual std::vector<FontSourceHandle> systemFontFallbacksHandle() const;
 
+    // Decode PNG or JPEG image data with a decoder of the platform. Pixels of
+    // _channels bytes are written row by row from the bottom-left corner of the
+    // image into the buffer of _width * _height * _channels bytes returned by
+    // _allocator. Return false when the platform has no decoder for the data,
+    // which is then decoded with stb_image. Called from worker threads.
+    virtual bool decodeImage(const uint8_t* _data, size_t _length, int _channels,
+                             int& _width, int& _height,
+                             std::function<uint8_t*(size_t)> _allocator) const { return false; }
+
 protected:
     // Platform implementation specific id for URL requests. This id is
     // interpreted differently for each platform type, so do not perform any
@@ -102,9 +159,18 @@ protected:
 
     virtual void cancelUrlRequestImpl(UrlRequestId _id) = 0;
 
+    // Called for requests whose UrlRequestId has been set
+    virtual void setUrlRequestPriorityImpl(UrlRequestId _id, float _priority) {}
+
     // Return true when UrlRequestId has been set (i.e. when request is async and can be canceled)
     virtual bool startUrlRequestImpl(const Url& _url, UrlRequestHandle _request, UrlRequestId& _id) = 0;
 
+    // Start a conditional request. Defaults to a request without the validators.
+    virtual bool startConditionalUrlRequestImpl(const Url& _url, const UrlValidators& _validators,
+                                                UrlRequestHandle _request, UrlRequestId& _id) {
+        return startUrlRequestImpl(_url, _request, _id);
+    }
+
     static bool bytesFromFileSystem(const char* _path, std::function<char*(size_t)> _allocator);
 
     std::atomic<bool> m_shutdown{false};
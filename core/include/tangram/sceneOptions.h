@@ -2,6 +2,7 @@
 
 #include "util/url.h"
 
+#include <cstdint>
 #include <functional>
 #include <string>
 #include <vector>
@@ -19,6 +20,22 @@ struct SceneUpdate {
 };
 
 
+// Placement of threads on CPUs with cores of different capacity, e.g. big.LITTLE
+enum class ThreadPlacement : uint8_t {
+    none,       // Leave the placement to the scheduler
+    throughput, // Tile workers and the GL thread on the faster cores, I/O on the slower ones
+    battery,    // Tile workers and I/O on the slower cores
+};
+
+// Rendering quality for the capabilities of the device. The lower tiers are
+// applied to the scene as it is loaded, see QualityProfile for their settings.
+enum class QualityTier : uint8_t {
+    automatic, // Select the tier by the GL limits and lower it while frames are slow
+    high,      // The scene as it is written
+    medium,    // Vertex lighting, capped label density and a smaller tile cache
+    low,       // Also no extrusion and rasters at half resolution
+};
+
 class SceneOptions {
 public:
     explicit SceneOptions(const Url& _url, bool _useScenePosition = false,
@@ -43,6 +60,11 @@ public:
     /// SceneUpdates to apply to the scene
     std::vector<SceneUpdate> updates;
 
+    /// Scene precompiled by tangram-compile-scene for this URL and these
+    /// updates. When it matches, the scene config is restored from it instead
+    /// of loading and merging the YAML imports. Not used for zip archives.
+    Url precompiledScene;
+
     /// Set the view to the position provided by the scene
     bool useScenePosition = true;
 
@@ -52,12 +74,97 @@ public:
     /// Start loading tiles as soon as possible
     bool prefetchTiles = true;
 
-    /// Start loading tiles as soon as possible
+    /// Number of tiles built concurrently. The shared ThreadPool
+    /// is grown to at least this number of threads.
     uint32_t numTileWorkers = 2;
 
+    /// Pin tile workers, I/O and GL threads to cores by their capacity on
+    /// CPUs with cores of different capacity. The placement of the last
+    /// loaded scene applies to all Map instances in this process.
+    ThreadPlacement threadPlacement = ThreadPlacement::none;
+
+    /// Quality tier of the scene. With QualityTier::automatic the scene is
+    /// loaded at the tier of the GL limits and Map loads it again at the next
+    /// lower tier while frames are slow; Scene::qualityTier() is the tier in use.
+    QualityTier qualityTier = QualityTier::high;
+
+    /// Number of additional threads that build the data layers of
+    /// a single tile in parallel. 0 builds each tile on one thread.
+    uint32_t numLayerWorkers = 0;
+
     /// 16MB default in-memory DataSource cache
     size_t memoryTileCacheSize = CACHE_SIZE;
 
+    /// Store tiles compressed in the in-memory cache, so that
+    /// memoryTileCacheSize holds about three times more vector tiles
+    bool compressMemoryTileCache = false;
+
+    /// Share the in-memory caches of tile data with the scenes of other Map
+    /// instances that load the same source URLs. The raw tiles are kept when
+    /// a Map is destroyed, and overzoomed tiles are parsed once for all Maps.
+    bool sharedTileCache = false;
+
+    /// Fit the scene into devices with 256-512MB of RAM, like the Raspberry Pi
+    /// and Tizen devices. The scene is loaded at QualityTier::low with one tile
+    /// worker and a smaller, compressed in-memory tile cache. Text layouts do not
+    /// keep glyph atlas pages alive and MBTiles sources read with one connection.
+    /// With a Map::setMemoryBudget() the budget is checked after each change of
+    /// the tiles in view rather than once per second.
+    bool lowMemory = false;
+
+    /// Existing directory for a persistent cache of built tile geometry.
+    /// Tiles are stored and restored when this is not empty.
+    std::string tileDiskCachePath;
+
+    /// Existing directory for a persistent cache of linked shader programs.
+    /// Programs are stored and restored when this is not empty and the
+    /// driver supports program binaries.
+    std::string shaderCachePath;
+
+    /// File for the last frame rendered for a settled view of this scene. When
+    /// the same scene is loaded at the same view in the next session, the
+    /// stored frame is drawn while it loads and then faded out to the map.
+    /// The file is written when this is not empty.
+    std::string startupFramePath;
+
+    /// Resolve label occlusions on a worker thread. Each frame applies the
+    /// last completed placement, which trades one placement of latency for
+    /// less work on the GL thread while the view moves.
+    bool asyncLabelPlacement = false;
+
+    /// Find the label OBBs that may collide with a compute shader pass on
+    /// GLES 3.1 and desktop GL 4.3 drivers, so that frames with many labels
+    /// test fewer pairs on the CPU. Not used with asyncLabelPlacement.
+    bool gpuLabelCollision = false;
+
+    /// Show tiles once the styles other than labels are built, and add the
+    /// labels in a second pass. The tiles in view replace their proxy tiles
+    /// sooner on slow devices. Not used with a tileDiskCachePath.
+    bool progressiveTiles = false;
+
+    /// Keep the distance fields of all glyphs built for this scene, so that
+    /// they can be baked with Map::getGlyphFields() and referenced as 'fields'
+    /// of a font in the scene 'fonts' block.
+    bool recordGlyphFields = false;
+
+    /// Build the polyline and polygon markers of a style, draw order and tile
+    /// into shared meshes. Many markers are drawn with few draw calls, while
+    /// a change to one marker rebuilds the mesh of its batch.
+    bool batchMarkers = false;
+
+    /// Build a spatial index over the geometry of the interactive features
+    /// of each tile, so that Map::pickFeatureAt() is answered from it
+    /// without drawing the selection pass. Picks that hit a tile restored
+    /// from the tileDiskCachePath still use the selection pass.
+    bool indexInteractiveFeatures = false;
+
+    /// Read the view and light uniforms of the points, lines, polygons and
+    /// text styles from uniform buffers on GLES 3 and GL 3.1 drivers, which
+    /// are set once per frame rather than for each style. Their shaders are
+    /// then compiled as GLSL ES 3.00 or GLSL 1.40, so scene shader blocks must
+    /// not use keywords like in, out or texture as identifiers.
+    bool uniformBlocks = false;
+
 private:
     static constexpr size_t CACHE_SIZE = 16 * (1024 * 1024);
 
@@ -15,6 +15,7 @@ class TileBuilder;
 class TileSource;
 class Tile;
 class MapProjection;
+class FeatureFilter;
 struct TileData;
 
 
@@ -32,6 +33,9 @@ public:
 
     virtual bool hasData() const { return true; }
 
+    // Hash of the data of the task, 0 when it can not be hashed
+    virtual uint64_t dataHash() const { return 0; }
+
     virtual bool isReady() const {
         if (needsLoading()) { return false; }
 
@@ -40,24 +44,40 @@ public:
 
     Tile* tile() { return m_tile.get(); }
 
+    // Returns the built tile. A partial tile that was not taken gets the
+    // meshes of the second pass.
     std::unique_ptr<Tile> getTile();
     void setTile(std::unique_ptr<Tile>&& _tile);
 
+    // The tile of the first pass of a progressive build, until it is taken.
+    // It has the meshes of all styles but labels, which the second pass builds
+    // into tile().
+    Tile* partialTile() { return m_partialReady ? m_partialTile.get() : nullptr; }
+    std::unique_ptr<Tile> getPartialTile();
+
+    // Whether the first pass of a progressive build is done and the task
+    // waits to be processed again for the second one
+    bool needsSecondPass() const { return m_partialReady && !m_ready; }
+
     std::shared_ptr<TileSource> source() { return m_source.lock(); }
     int64_t sourceId() { return m_sourceId; }
     int64_t sourceGeneration() const { return m_sourceGeneration; }
 
     TileID tileId() const { return m_tileId; }
 
-    void cancel() { m_canceled = true; }
+    void cancel();
     bool isCanceled() const { return m_canceled; }
 
     double getPriority() const {
         return m_priority.load();
     }
 
+    // Raster sub-tasks are scheduled with the main task
     void setPriority(double _priority) {
         m_priority.store(_priority);
+        for (auto& subTask : m_subTasks) {
+            subTask->setPriority(_priority);
+        }
     }
 
     void setProxyState(bool isProxy) { m_proxyState = isProxy; }
@@ -68,14 +88,47 @@ public:
     // running on worker thread
     virtual void process(TileBuilder& _tileBuilder);
 
+    // running on worker thread while the Scene is not complete: decode the data
+    // of the task, which needs only its TileSource, so that process() only styles it
+    virtual void parseData();
+
+    // Whether parseData() did not run yet
+    bool needsParse() const { return !m_parseDone && !m_canceled && !m_partialReady; }
+
     // running on main thread when the tile is added to
     virtual void complete();
 
     // onDone for sub-tasks
     virtual void complete(TileTask& _mainTask) {}
 
+    // Whether the sub-task has a stand-in for its result while it is not ready,
+    // e.g. a raster cropped from the texture of a parent tile
+    virtual bool hasProxy() const { return false; }
+
+    // onDone for sub-tasks that are not ready yet: add the stand-in to the tile
+    virtual void completeProxy(TileTask& _mainTask) {}
+
+    // Replace the stand-in in _tile by the result once the sub-task is ready
+    virtual void replaceProxy(Tile& _tile) {}
+
     int rawSource = 0;
 
+    // Filter for the TileSource parser, set while the task is processed
+    FeatureFilter* featureFilter() const { return m_featureFilter; }
+    void setFeatureFilter(FeatureFilter* _filter) { m_featureFilter = _filter; }
+
+    // A previous build of the tile, which is kept instead of building the tile
+    // again when the data of the task has the same content hash
+    void setPreviousTile(std::shared_ptr<Tile> _tile);
+    std::shared_ptr<Tile> previousTile() const { return m_previousTile; }
+
+    // Whether the task is ready without a tile since the previous one is kept
+    bool keepsPreviousTile() const { return m_keepPreviousTile; }
+
+    // Build only the labels, for a tile whose other meshes were taken from
+    // the tile of a previous scene
+    void setLabelsOnly() { m_labelsOnly = true; }
+
     bool needsLoading() const { return m_needsLoading; }
 
     // Set whether DataSource should (re)try loading data
@@ -87,6 +140,10 @@ public:
 
 protected:
 
+    // Parse the data of the task, with the feature filter of _tileBuilder,
+    // unless it was parsed by parseData()
+    std::shared_ptr<TileData> parse(TileBuilder& _tileBuilder, TileSource& _source);
+
     const TileID m_tileId;
 
     // Save shared reference to Datasource while building tile
@@ -101,12 +158,30 @@ protected:
     // Tile result, set when tile was  sucessfully created
     std::unique_ptr<Tile> m_tile;
 
+    // Result of the first pass of a progressive build and the data for the second
+    std::unique_ptr<Tile> m_partialTile;
+    std::shared_ptr<TileData> m_partialData;
+    float m_partialBuildTime = 0;
+    std::atomic<bool> m_partialReady{false};
+
+    // Unfiltered data parsed before the Scene was complete
+    std::shared_ptr<TileData> m_parsedData;
+    bool m_parseDone = false;
+
+    std::shared_ptr<Tile> m_previousTile;
+    uint64_t m_previousContentHash = 0;
+    bool m_keepPreviousTile = false;
+
+    bool m_labelsOnly = false;
+
     std::atomic<bool> m_ready;
     std::atomic<bool> m_canceled;
     std::atomic<bool> m_needsLoading;
 
     std::atomic<float> m_priority;
     std::atomic<bool> m_proxyState;
+
+    FeatureFilter* m_featureFilter = nullptr;
 };
 
 class BinaryTileTask : public TileTask {
@@ -115,8 +190,30 @@ public:
         : TileTask(_tileId, _source) {}
 
     virtual bool hasData() const override {
-        return rawTileData && !rawTileData->empty();
+        return tileDataSize() > 0;
+    }
+
+    virtual uint64_t dataHash() const override;
+
+    // Tile data that will be processed by TileSource: the view when one is
+    // set, otherwise rawTileData.
+    const char* tileData() const {
+        if (m_dataViewOwner) { return m_dataView; }
+        return rawTileData ? rawTileData->data() : nullptr;
     }
+    size_t tileDataSize() const {
+        if (m_dataViewOwner) { return m_dataViewSize; }
+        return rawTileData ? rawTileData->size() : 0;
+    }
+
+    // Refer to _size bytes of tile data at _data instead of copying them into
+    // rawTileData. _owner keeps the data valid while the task holds it.
+    void setTileDataView(const char* _data, size_t _size, std::shared_ptr<const void> _owner) {
+        m_dataView = _data;
+        m_dataViewSize = _size;
+        m_dataViewOwner = std::move(_owner);
+    }
+
     // Raw tile data that will be processed by TileSource.
     std::shared_ptr<std::vector<char>> rawTileData;
 
@@ -124,10 +221,28 @@ public:
     bool urlRequestStarted = false;
 
     UrlRequestHandle urlRequestHandle = 0;
+
+    // Validators of a stale cached copy of the tile, sent by the network
+    // source to revalidate it. Set to the validators of the network response.
+    UrlValidators validators;
+    // Seconds for which the network response may be used, -1 when unknown
+    int64_t maxAge = -1;
+    // Set when the network source confirmed that the cached copy is still
+    // valid. The task then has no data; the cache that sent the validators
+    // provides it.
+    bool notModified = false;
+
+private:
+    const char* m_dataView = nullptr;
+    size_t m_dataViewSize = 0;
+    std::shared_ptr<const void> m_dataViewOwner;
 };
 
 struct TileTaskQueue {
     virtual void enqueue(std::shared_ptr<TileTask> task) = 0;
+
+    // Called after the priorities of queued tasks have been updated
+    virtual void updatePriorities() {}
 };
 
 struct TileTaskCb {
@@ -52,4 +52,6 @@ typedef std::vector<LngLat> Coordinates;
 
 typedef uint32_t MarkerID;
 
+typedef uint32_t MarkerStylingID;
+
 } // namespace Tangram
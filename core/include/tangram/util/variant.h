@@ -15,6 +15,7 @@
 #endif
 
 #include <string>
+#include <utility>
 
 namespace Tangram {
 // Primarily used when duk evaluated jsFunction results in a a null or undefined value
@@ -63,7 +64,7 @@ public:
     Value(const T& val): Base(val) {}
 
     template<typename T>
-    Value(T&& val): Base(val) {}
+    Value(T&& val): Base(std::forward<T>(val)) {}
 };
 
 const static Value NOT_A_VALUE(none_type{});
@@ -3,9 +3,10 @@ precision mediump float;
 #endif
 
 uniform sampler2D u_tex;
+uniform float u_alpha;
 varying vec2 uv;
 
 void main() {
-    gl_FragColor = texture2D(u_tex, uv);
+    gl_FragColor = texture2D(u_tex, uv) * u_alpha;
 }
 
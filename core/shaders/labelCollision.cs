@@ -0,0 +1,81 @@
+// Prepended: #version, CELL_CAPACITY and MAX_PAIRS
+
+precision highp float;
+precision highp int;
+
+layout(local_size_x = 64) in;
+
+// Extents of the label OBBs: min x, min y, max x, max y
+layout(std430, binding = 0) readonly buffer Boxes {
+    vec4 boxes[];
+};
+
+// Number of boxes of each cell, followed by CELL_CAPACITY box indices per cell
+layout(std430, binding = 1) buffer Cells {
+    uint cells[];
+};
+
+// Pairs of a box and an earlier box that it overlaps
+layout(std430, binding = 2) buffer Pairs {
+    uint pairCount;
+    uint overflow;
+    uint pairs[];
+};
+
+uniform int u_count;
+uniform ivec2 u_grid;
+uniform float u_cell_size;
+// 0: insert the boxes into the cells, 1: collect the pairs of each cell
+uniform int u_pass;
+
+ivec2 cellOf(vec2 p) {
+    return clamp(ivec2(floor(p / u_cell_size)), ivec2(0), u_grid - 1);
+}
+
+void main() {
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= uint(u_count)) { return; }
+
+    vec4 box = boxes[i];
+    ivec2 first = cellOf(box.xy);
+    ivec2 last = cellOf(box.zw);
+    uint cellCount = uint(u_grid.x * u_grid.y);
+
+    for (int y = first.y; y <= last.y; y++) {
+        for (int x = first.x; x <= last.x; x++) {
+            uint cell = uint(y * u_grid.x + x);
+            uint items = cellCount + cell * uint(CELL_CAPACITY);
+
+            if (u_pass == 0) {
+                uint slot = atomicAdd(cells[cell], 1u);
+                if (slot < uint(CELL_CAPACITY)) {
+                    cells[items + slot] = i;
+                } else {
+                    atomicOr(overflow, 1u);
+                }
+                continue;
+            }
+
+            uint count = min(cells[cell], uint(CELL_CAPACITY));
+            for (uint k = 0u; k < count; k++) {
+                uint j = cells[items + k];
+                if (j >= i) { continue; }
+
+                vec4 other = boxes[j];
+                if (any(greaterThan(other.xy, box.zw)) || any(greaterThan(box.xy, other.zw))) {
+                    continue;
+                }
+                // Report a pair only from the cell of the corner of the overlap
+                if (cellOf(max(box.xy, other.xy)) != ivec2(x, y)) { continue; }
+
+                uint pair = atomicAdd(pairCount, 1u);
+                if (pair < uint(MAX_PAIRS)) {
+                    pairs[2u * pair] = i;
+                    pairs[2u * pair + 1u] = j;
+                } else {
+                    atomicOr(overflow, 1u);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,32 @@
+/*
+
+Lights with an outer radius are skipped by the fragments of screen tiles that
+they do not reach. Each texel of u_light_tiles holds the bits of 32 lights of a
+tile, TANGRAM_LIGHT_TILE_TEXELS texels per tile.
+
+*/
+
+#if defined(TANGRAM_FRAGMENT_SHADER) && defined(TANGRAM_LIGHTING_FRAGMENT)
+
+uniform sampler2D u_light_tiles;
+// Size of a screen tile in pixels, and of u_light_tiles in texels
+uniform vec3 u_light_tiles_size;
+
+// Bytes of the bits of the lights _texel * 32 to _texel * 32 + 31 in the tile of the fragment
+vec4 lightTileMask(float _texel) {
+    vec2 tile = floor(gl_FragCoord.xy / u_light_tiles_size.x);
+    vec2 texel = vec2(tile.x * TANGRAM_LIGHT_TILE_TEXELS + _texel, tile.y) + 0.5;
+    return floor(texture2D(u_light_tiles, texel / u_light_tiles_size.yz) * 255.0 + 0.5);
+}
+
+// Whether the bit with the value _bit of the byte of _mask selected by _channel is set
+bool lightInTile(vec4 _mask, vec4 _channel, float _bit) {
+    return mod(floor(dot(_mask, _channel) / _bit), 2.0) > 0.5;
+}
+
+#else
+
+#define lightTileMask(texel) vec4(255.0)
+#define lightInTile(mask, channel, bit) true
+
+#endif
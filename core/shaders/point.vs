@@ -13,7 +13,15 @@ uniform LOWP int u_sprite_mode;
 
 #pragma tangram: uniforms
 
+#ifdef TANGRAM_INSTANCED
+// Corner of the quad in [-1, 1], its offset from the position along the two
+// axes and the texture coordinates of the bottom-left and top-right corners
+attribute vec2 a_corner;
+attribute vec4 a_axes;
+attribute vec4 a_uv_rect;
+#else
 attribute vec2 a_uv;
+#endif
 attribute LOWP float a_alpha;
 attribute LOWP vec4 a_color;
 attribute vec4 a_position;
@@ -48,14 +56,23 @@ void main() {
     }
 #endif
 
+#ifdef TANGRAM_INSTANCED
+    vec2 uv = mix(a_uv_rect.xy, a_uv_rect.zw, a_corner * 0.5 + 0.5);
+    vec4 position = a_position;
+    position.xy += a_corner.x * a_axes.xy + a_corner.y * a_axes.zw;
+#else
+    vec2 uv = a_uv;
+    vec4 position = a_position;
+#endif
+
     if (u_sprite_mode == 0) {
-        v_texcoords = sign(a_uv);
-        v_edge = abs(a_uv);
+        v_texcoords = sign(uv);
+        v_edge = abs(uv);
     } else {
-        v_texcoords = a_uv;
+        v_texcoords = uv;
     }
     v_outline_color = a_outline_color;
     v_aa_factor = a_aa_factor;
 
-    gl_Position = a_position;
+    gl_Position = position;
 }
@@ -7,16 +7,21 @@ precision highp float;
 #pragma tangram: defines
 
 uniform mat4 u_model;
-uniform mat4 u_view;
-uniform mat4 u_proj;
-uniform mat3 u_normal_matrix;
 uniform vec4 u_tile_origin;
-uniform vec3 u_map_position;
-uniform vec2 u_resolution;
-uniform float u_time;
-uniform float u_meters_per_pixel;
-uniform float u_device_pixel_ratio;
-uniform mat3 u_inverse_normal_matrix;
+
+#ifdef TANGRAM_UNIFORM_BLOCKS
+    #pragma tangram: uniform_blocks
+#else
+    uniform mat4 u_view;
+    uniform mat4 u_proj;
+    uniform mat3 u_normal_matrix;
+    uniform vec3 u_map_position;
+    uniform vec2 u_resolution;
+    uniform float u_time;
+    uniform float u_meters_per_pixel;
+    uniform float u_device_pixel_ratio;
+    uniform mat3 u_inverse_normal_matrix;
+#endif
 
 #pragma tangram: uniforms
 
@@ -41,6 +46,15 @@ vec3 worldNormal() {
     return normalize(u_inverse_normal_matrix * v_normal);
 }
 
+#ifdef TANGRAM_FEATURE_STATE
+    varying vec4 v_feature_state;
+
+    // State of the feature set with Map::setFeatureState, zero when it has none
+    vec4 featureState() {
+        return v_feature_state;
+    }
+#endif
+
 #pragma tangram: material
 #pragma tangram: lighting
 #pragma tangram: global
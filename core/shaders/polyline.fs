@@ -7,18 +7,26 @@ precision highp float;
 #pragma tangram: defines
 
 uniform mat4 u_model;
-uniform mat4 u_view;
-uniform mat4 u_proj;
-uniform mat3 u_normal_matrix;
-uniform mat3 u_inverse_normal_matrix;
 uniform vec4 u_tile_origin;
-uniform vec3 u_map_position;
-uniform vec2 u_resolution;
-uniform float u_time;
-uniform float u_meters_per_pixel;
-uniform float u_device_pixel_ratio;
 uniform float u_texture_ratio;
 uniform sampler2D u_texture;
+#ifdef TANGRAM_LINE_DASH
+    uniform vec2 u_dash_region;
+#endif
+
+#ifdef TANGRAM_UNIFORM_BLOCKS
+    #pragma tangram: uniform_blocks
+#else
+    uniform mat4 u_view;
+    uniform mat4 u_proj;
+    uniform mat3 u_normal_matrix;
+    uniform mat3 u_inverse_normal_matrix;
+    uniform vec3 u_map_position;
+    uniform vec2 u_resolution;
+    uniform float u_time;
+    uniform float u_meters_per_pixel;
+    uniform float u_device_pixel_ratio;
+#endif
 
 #pragma tangram: uniforms
 
@@ -43,6 +51,15 @@ vec3 worldNormal() {
     return normalize(u_inverse_normal_matrix * v_normal);
 }
 
+#ifdef TANGRAM_FEATURE_STATE
+    varying vec4 v_feature_state;
+
+    // State of the feature set with Map::setFeatureState, zero when it has none
+    vec4 featureState() {
+        return v_feature_state;
+    }
+#endif
+
 #pragma tangram: material
 #pragma tangram: lighting
 #pragma tangram: global
@@ -65,7 +82,12 @@ void main(void) {
     #endif
 
     #ifdef TANGRAM_LINE_TEXTURE
-        vec2 line_st = vec2(v_texcoord.x, fract(v_texcoord.y * TANGRAM_DASH_TEX_SCALE / u_texture_ratio));
+        #if defined(TANGRAM_LINE_DASH)
+            // Column of the pattern in the dash atlas
+            vec2 line_st = vec2(u_dash_region.x, fract(v_texcoord.y * TANGRAM_DASH_TEX_SCALE / u_texture_ratio) * u_dash_region.y);
+        #else
+            vec2 line_st = vec2(v_texcoord.x, fract(v_texcoord.y * TANGRAM_DASH_TEX_SCALE / u_texture_ratio));
+        #endif
         vec4 line_color = texture2D(u_texture, line_st);
 
         #if defined(TANGRAM_LINE_DASH)
@@ -6,17 +6,42 @@ precision highp float;
 
 #pragma tangram: defines
 
-uniform mat4 u_model;
-uniform mat4 u_view;
-uniform mat4 u_proj;
-uniform mat3 u_normal_matrix;
-uniform vec4 u_tile_origin;
-uniform vec3 u_map_position;
-uniform vec2 u_resolution;
-uniform float u_time;
-uniform float u_meters_per_pixel;
-uniform float u_device_pixel_ratio;
-uniform float u_proxy_depth;
+#ifdef TANGRAM_UNIFORM_BLOCKS
+    #pragma tangram: uniform_blocks
+#else
+    uniform mat4 u_view;
+    uniform mat4 u_proj;
+    uniform mat3 u_normal_matrix;
+    uniform vec3 u_map_position;
+    uniform vec2 u_resolution;
+    uniform float u_time;
+    uniform float u_meters_per_pixel;
+    uniform float u_device_pixel_ratio;
+#endif
+
+#ifdef TANGRAM_TILE_BATCH
+    // Transforms of the tiles drawn in a batch, selected by u_tile_index:
+    // translation and scale of the model matrix, proxy depth and tile origin
+    uniform vec4 u_tile_transforms[TANGRAM_TILE_BATCH];
+    uniform vec4 u_tile_origins[TANGRAM_TILE_BATCH];
+    uniform int u_tile_index;
+
+    mat4 tangramTileModel() {
+        vec4 t = u_tile_transforms[u_tile_index];
+        return mat4(t.z, 0.0, 0.0, 0.0,
+                    0.0, t.z, 0.0, 0.0,
+                    0.0, 0.0, t.z, 0.0,
+                    t.x, t.y, 0.0, 1.0);
+    }
+
+    #define u_model tangramTileModel()
+    #define u_tile_origin u_tile_origins[u_tile_index]
+    #define u_proxy_depth u_tile_transforms[u_tile_index].w
+#else
+    uniform mat4 u_model;
+    uniform vec4 u_tile_origin;
+    uniform float u_proxy_depth;
+#endif
 
 #pragma tangram: uniforms
 
@@ -29,14 +54,33 @@ attribute vec4 a_extrude;
     varying vec2 v_texcoord;
 #endif
 
+#ifdef TANGRAM_LINE_OUTLINE
+    // Width, width change, and order of the outline, which is drawn
+    // instead of the line when u_outline_pass is set
+    attribute vec4 a_outline;
+    attribute vec4 a_outline_color;
+    uniform bool u_outline_pass;
+#endif
+
+#if defined(TANGRAM_FEATURE_SELECTION) || defined(TANGRAM_FEATURE_STATE)
+    attribute vec4 a_selection_color;
+#endif
+
 #ifdef TANGRAM_FEATURE_SELECTION
     // Make sure lighting is a no-op for feature selection pass
     #undef TANGRAM_LIGHTING_VERTEX
 
-    attribute vec4 a_selection_color;
     varying vec4 v_selection_color;
 #endif
 
+#ifdef TANGRAM_FEATURE_STATE
+    varying vec4 v_feature_state;
+
+    #ifdef TANGRAM_FEATURE_STATE_TEXTURE
+        uniform sampler2D u_feature_state;
+    #endif
+#endif
+
 varying vec4 v_world_position;
 varying vec4 v_position;
 varying vec4 v_color;
@@ -67,6 +111,13 @@ vec4 modelPositionBaseZoom() {
     return vec4(UNPACK_POSITION(a_position.xyz), 1.0);
 }
 
+#ifdef TANGRAM_FEATURE_STATE
+    // State of the feature set with Map::setFeatureState, zero when it has none
+    vec4 featureState() {
+        return v_feature_state;
+    }
+#endif
+
 #pragma tangram: material
 #pragma tangram: lighting
 #pragma tangram: global
@@ -80,6 +131,18 @@ void main() {
 
     vec4 position = vec4(UNPACK_POSITION(a_position.xyz), 1.0);
 
+    #ifdef TANGRAM_FEATURE_STATE
+        v_feature_state = vec4(0.0);
+        #ifdef TANGRAM_FEATURE_STATE_TEXTURE
+            // Selection colors with the high bit set hold the index of the state
+            vec4 state_index = floor(a_selection_color * 255.0 + 0.5);
+            if (state_index.a >= 128.0) {
+                v_feature_state = texture2D(u_feature_state,
+                                            (state_index.rg + 0.5) / TANGRAM_FEATURE_STATE_SIZE);
+            }
+        #endif
+    #endif
+
     #ifdef TANGRAM_FEATURE_SELECTION
         v_selection_color = a_selection_color;
         // Skip non-selectable meshes
@@ -94,6 +157,18 @@ void main() {
 
     v_color = a_color;
 
+    vec4 extrude = UNPACK_EXTRUSION(a_extrude);
+    float order = a_position.w;
+
+    #ifdef TANGRAM_LINE_OUTLINE
+        if (u_outline_pass) {
+            // Lines without outline have zero width in this pass
+            v_color = a_outline_color;
+            extrude.zw = UNPACK_EXTRUSION(a_outline.xy);
+            order = a_outline.z;
+        }
+    #endif
+
     #ifdef TANGRAM_USE_TEX_COORDS
         v_texcoord = UNPACK_TEXCOORD(a_texcoord);
     #endif
@@ -105,7 +180,6 @@ void main() {
     v_normal = u_normal_matrix * vec3(0.,0.,1.);
 
     {
-        vec4 extrude = UNPACK_EXTRUSION(a_extrude);
         float width = extrude.z;
         float dwdz = extrude.w;
         float dz = u_map_position.z - u_tile_origin.z;
@@ -156,7 +230,7 @@ void main() {
     gl_Position.z += TANGRAM_DEPTH_DELTA * gl_Position.w * u_proxy_depth;
 
     #ifdef TANGRAM_DEPTH_DELTA
-        float layer = UNPACK_ORDER(a_position.w);
+        float layer = UNPACK_ORDER(order);
         gl_Position.z -= layer * TANGRAM_DEPTH_DELTA * gl_Position.w;
     #endif
 }
@@ -3,8 +3,10 @@
 #ifdef GL_ES
 precision mediump float;
 #define LOWP lowp
+#define HIGHP highp
 #else
 #define LOWP
+#define HIGHP
 #endif
 
 #pragma tangram: defines
@@ -13,15 +15,18 @@ uniform mat4 u_ortho;
 uniform vec2 u_uv_scale_factor;
 uniform float u_max_stroke_width;
 uniform LOWP int u_pass;
+uniform HIGHP float u_label_time;
 
 #pragma tangram: uniforms
 
 attribute vec2 a_uv;
-attribute LOWP float a_alpha;
 attribute LOWP vec4 a_color;
 attribute vec2 a_position;
 attribute LOWP vec4 a_stroke;
-attribute float a_scale;
+// Font scale and the easing of the fade
+attribute vec2 a_scale;
+// Alpha and 0, or the start and duration of the fade, negative when fading out
+attribute HIGHP vec2 a_fade;
 
 #ifdef TANGRAM_FEATURE_SELECTION
 attribute vec4 a_selection_color;
@@ -40,9 +45,25 @@ varying float v_alpha;
 #define UNPACK_EXTRUDE(x) (x / 256.0)
 #define UNPACK_TEXTURE(x) (x * u_uv_scale_factor)
 
+// Same as FadeEffect::update()
+float fadeAlpha() {
+    if (a_fade.y == 0.0) { return a_fade.x; }
+
+    bool fade_in = a_fade.y > 0.0;
+    float t = clamp((u_label_time - a_fade.x) / abs(a_fade.y), 0.0, 1.0);
+
+    if (a_scale.y == 2.0) {
+        // sine
+        return sin((fade_in ? t : 1.0 - t) * 1.57079632679);
+    }
+    // linear or pow
+    float alpha = a_scale.y == 1.0 ? t * t : t;
+    return fade_in ? alpha : 1.0 - alpha;
+}
+
 void main() {
 
-    v_alpha = a_alpha;
+    v_alpha = fadeAlpha();
     v_color = a_color;
 
 #ifdef TANGRAM_FEATURE_SELECTION
@@ -56,7 +77,7 @@ void main() {
 
     vec2 vertex_pos = UNPACK_POSITION(a_position);
     v_texcoords = UNPACK_TEXTURE(a_uv);
-    float sdf_scale = a_scale / 64.0;
+    float sdf_scale = a_scale.x / 64.0;
     v_sdf_pixel = 0.5 / (u_max_stroke_width * sdf_scale);
 
     if (u_pass == 0) {
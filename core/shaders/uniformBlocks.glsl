@@ -0,0 +1,17 @@
+// View uniforms of all styles, set once per frame in a uniform buffer.
+// The members must be the same in all shaders so that their offsets are too.
+layout(std140) uniform TangramView {
+    highp mat4 u_view;
+    highp mat4 u_proj;
+    highp mat3 u_normal_matrix;
+    highp mat3 u_inverse_normal_matrix;
+    highp vec3 u_map_position;
+    highp vec2 u_resolution;
+    highp float u_time;
+    highp float u_meters_per_pixel;
+    highp float u_device_pixel_ratio;
+};
+
+#ifdef TANGRAM_FRAGMENT_SHADER
+    out highp vec4 tangram_FragColor;
+#endif
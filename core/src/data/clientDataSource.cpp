@@ -1,12 +1,15 @@
 #include "data/clientDataSource.h"
 
 #include "log.h"
+#include "map.h"
 #include "platform.h"
 #include "tile/tileTask.h"
 #include "util/geom.h"
+#include "data/pointClusters.h"
 #include "data/propertyItem.h"
 #include "data/tileData.h"
 #include "tile/tile.h"
+#include "util/mapProjection.h"
 #include "view/view.h"
 
 #include "mapbox/geojsonvt.hpp"
@@ -17,16 +20,18 @@
 
 
 #include <regex>
+#include <set>
+#include <unordered_set>
 
 namespace Tangram {
 
 using namespace mapbox;
 
-geojsonvt::Options options() {
+geojsonvt::Options options(const ClientDataSource::TilingOptions& _tilingOptions) {
     geojsonvt::Options opt;
     opt.maxZoom = 18;
-    opt.indexMaxZoom = 5;
-    opt.indexMaxPoints = 100000;
+    opt.indexMaxZoom = glm::clamp(_tilingOptions.indexMaxZoom, 0, int(opt.maxZoom));
+    opt.indexMaxPoints = std::max(_tilingOptions.indexMaxPoints, 0);
     opt.solidChildren = true;
     opt.tolerance = 3;
     opt.extent = 4096;
@@ -34,10 +39,157 @@ geojsonvt::Options options() {
     return opt;
 }
 
+// Features are tiled in branches of the tile pyramid below the tiles of this
+// zoom, so that a changed feature is only tiled again with its neighbors.
+static constexpr int branch_zoom = 10;
+
+// Features that overlap more branches are tiled in the global branch
+static constexpr int max_feature_branches = 4;
+
 struct ClientDataSource::Storage {
-    std::unique_ptr<geojsonvt::GeoJSONVT> tiles;
-    geometry::feature_collection<double> features;
-    std::vector<Properties> properties;
+
+    struct StoredFeature {
+        geometry::geometry<double> geometry;
+        std::shared_ptr<const Properties> properties;
+
+        // Point with label_placement when generating centroids
+        bool hasCentroid = false;
+        geometry::point<double> centroid;
+        std::shared_ptr<const Properties> centroidProperties;
+
+        // Range of branch tiles that the feature overlaps
+        int minX = 0, minY = 0, maxX = -1, maxY = -1;
+        bool global = false;
+
+        // Number of points of the geometry and centroid
+        size_t points = 0;
+
+        // Point that is tiled with the clusters instead of its branches
+        bool clustered = false;
+    };
+
+    struct Branch {
+        std::set<FeatureId> features;
+        bool dirty = false;
+    };
+
+    // Tiled features of a branch
+    struct Index {
+        geojsonvt::GeoJSONVT tiles;
+        // Properties by ID of the geojsonvt features
+        std::vector<std::shared_ptr<const Properties>> properties;
+        // geojson-vt creates tiles when they are first requested
+        std::mutex mutex;
+        // Estimated size of the projected features, without the tiles
+        size_t bytes = 0;
+
+        Index(const geometry::feature_collection<double>& _features,
+              std::vector<std::shared_ptr<const Properties>>&& _properties,
+              const geojsonvt::Options& _options)
+            : tiles(_features, _options), properties(std::move(_properties)) {}
+    };
+
+    // Features of all branches to be tiled
+    struct Build {
+        geometry::feature_collection<double> features;
+        std::vector<std::shared_ptr<const Properties>> properties;
+        size_t points = 0;
+    };
+
+    // Points to be clustered
+    struct ClusterBuild {
+        std::vector<double> lngLats;
+        std::vector<std::shared_ptr<const Properties>> properties;
+    };
+
+    // Clustered points, with properties by index of the points
+    struct Clusters {
+        PointClusters clusters;
+        std::vector<std::shared_ptr<const Properties>> properties;
+
+        Clusters(const std::vector<double>& _lngLats, PointClusters::Options _options,
+                 std::vector<std::shared_ptr<const Properties>>&& _properties)
+            : clusters(_lngLats, _options), properties(std::move(_properties)) {}
+    };
+
+    std::map<FeatureId, StoredFeature> features;
+    // Number of points of all features
+    size_t points = 0;
+
+    // Branches by their tile at branch_zoom
+    std::map<TileID, Branch> branches;
+    Branch global;
+
+    FeatureId nextId = 0;
+
+    // Point features are clustered, see ClusterOptions
+    bool clustering = false;
+    bool clustersDirty = false;
+
+    // Some features were released once tiled, see TilingOptions
+    bool hasReleased = false;
+    // The next build drops the indices of the released features
+    bool dropReleased = false;
+
+    template<class F>
+    void forEachBranch(const StoredFeature& _feature, F _f) {
+        if (_feature.global) {
+            _f(global);
+            return;
+        }
+        for (int x = _feature.minX; x <= _feature.maxX; x++) {
+            for (int y = _feature.minY; y <= _feature.maxY; y++) {
+                _f(branches[TileID(x, y, branch_zoom)]);
+            }
+        }
+    }
+
+    void insert(FeatureId _id, StoredFeature&& _feature);
+
+    bool erase(FeatureId _id);
+
+    void clear() {
+        features.clear();
+        points = 0;
+        for (auto& branch : branches) {
+            branch.second.features.clear();
+            branch.second.dirty = true;
+        }
+        global.features.clear();
+        global.dirty = true;
+        clustersDirty = clustering;
+        if (hasReleased) {
+            dropReleased = true;
+            hasReleased = false;
+        }
+    }
+
+    // Drop the tiled features, except for the clustered points that are
+    // clustered again with the others
+    void release();
+
+    static StoredFeature make(geometry::geometry<double>&& _geometry, Properties&& _properties,
+                              bool _generateCentroid);
+
+    // Collect the features of a dirty branch to be tiled
+    Build collect(Branch& _branch);
+
+    // Tile the collected features; null when there are none
+    static std::shared_ptr<Index> index(Build&& _build, const geojsonvt::Options& _options);
+
+    // Collect all clustered points
+    void collectClusters(ClusterBuild& _build);
+
+    // Cluster the collected points; null when there are none
+    static std::shared_ptr<Clusters> cluster(ClusterBuild&& _build, PointClusters::Options _options);
+};
+
+// Indices of all branches, replaced as a whole by generateTiles. A branch has
+// an index for each build of its new features when features are released.
+struct ClientDataSource::Snapshot {
+    std::multimap<TileID, std::shared_ptr<Storage::Index>> branches;
+    std::vector<std::shared_ptr<Storage::Index>> global;
+    std::shared_ptr<Storage::Clusters> clusters;
 };
 
 struct ClientDataSource::PolylineBuilderData : mapbox::geometry::line_string<double> {
@@ -86,23 +238,151 @@ std::shared_ptr<TileTask> ClientDataSource::createTask(TileID _tileId) {
 }
 
 // TODO: pass scene's resourcePath to constructor to be used with `stringFromFile`
+class ClientDataSource::GeoJsonStream {
+public:
+
+    explicit GeoJsonStream(ClientDataSource& _source) : m_source(_source) {}
+
+    // Scan _data for complete features of the 'features' array of a
+    // FeatureCollection and add them. Other documents are kept until finish.
+    void append(const char* _data, size_t _length);
+
+    bool finish();
+
+private:
+
+    ClientDataSource& m_source;
+
+    std::string m_buffer;
+    // Position of the next character to scan in m_buffer
+    size_t m_pos = 0;
+    // Depth of nested objects and arrays
+    int m_depth = 0;
+    bool m_inString = false;
+    bool m_escape = false;
+    size_t m_stringStart = 0;
+    // Last string and whether a ':' followed it, at the top level object
+    std::string m_key;
+    bool m_keyDone = false;
+
+    bool m_inFeatures = false;
+    bool m_isCollection = false;
+    // Start of the feature being read, or npos
+    size_t m_featureStart = std::string::npos;
+    bool m_valid = true;
+};
+
+void ClientDataSource::GeoJsonStream::append(const char* _data, size_t _length) {
+
+    m_buffer.append(_data, _length);
+
+    for (; m_pos < m_buffer.size(); m_pos++) {
+        char c = m_buffer[m_pos];
+
+        if (m_inString) {
+            if (m_escape) {
+                m_escape = false;
+            } else if (c == '\\') {
+                m_escape = true;
+            } else if (c == '"') {
+                m_inString = false;
+                if (m_depth == 1) {
+                    m_key.assign(m_buffer, m_stringStart, m_pos - m_stringStart);
+                    m_keyDone = false;
+                }
+            }
+            continue;
+        }
+
+        switch (c) {
+        case '"':
+            m_inString = true;
+            m_stringStart = m_pos + 1;
+            break;
+        case ':':
+            if (m_depth == 1) { m_keyDone = true; }
+            break;
+        case '{':
+        case '[':
+            if (c == '[' && m_depth == 1 && m_keyDone && m_key == "features") {
+                m_inFeatures = true;
+                m_isCollection = true;
+            } else if (c == '{' && m_depth == 2 && m_inFeatures) {
+                m_featureStart = m_pos;
+            }
+            m_depth++;
+            m_keyDone = false;
+            break;
+        case '}':
+        case ']':
+            m_depth--;
+            if (m_depth == 2 && m_featureStart != std::string::npos) {
+                try {
+                    m_source.addFeatures(&m_buffer[m_featureStart], m_pos + 1 - m_featureStart);
+                } catch (const std::exception& e) {
+                    LOGW("Invalid GeoJSON feature: %s", e.what());
+                    m_valid = false;
+                }
+                m_featureStart = std::string::npos;
+            } else if (m_depth == 1) {
+                m_inFeatures = false;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    // Drop what was read, except for the current feature
+    if (m_isCollection) {
+        size_t keep = (m_featureStart != std::string::npos) ? m_featureStart : m_pos;
+        if (m_inString) { keep = std::min(keep, m_stringStart); }
+        m_buffer.erase(0, keep);
+        m_pos -= keep;
+        m_stringStart -= std::min(m_stringStart, keep);
+        if (m_featureStart != std::string::npos) { m_featureStart = 0; }
+    }
+}
+
+bool ClientDataSource::GeoJsonStream::finish() {
+
+    if (m_isCollection) {
+        return m_valid && m_depth == 0 && !m_inString;
+    }
+    // A single Feature or geometry
+    try {
+        m_source.addFeatures(m_buffer.data(), m_buffer.size());
+    } catch (const std::exception& e) {
+        LOGW("Invalid GeoJSON: %s", e.what());
+        return false;
+    }
+    return true;
+}
+
 ClientDataSource::ClientDataSource(Platform& _platform, const std::string& _name,
                                    const std::string& _url, bool _generateCentroids,
-                                   TileSource::ZoomOptions _zoomOptions)
+                                   TileSource::ZoomOptions _zoomOptions,
+                                   ClusterOptions _clusterOptions,
+                                   TilingOptions _tilingOptions)
 
     : TileSource(_name, nullptr, _zoomOptions),
       m_generateCentroids(_generateCentroids),
+      m_clusterOptions(_clusterOptions),
+      m_tilingOptions(_tilingOptions),
       m_platform(_platform) {
 
     m_generateGeometry = true;
     m_store = std::make_unique<Storage>();
+    m_store->clustering = m_clusterOptions.enabled;
 
     if (!_url.empty()) {
         UrlCallback onUrlFinished = [&, this](UrlResponse&& response) {
             if (response.error) {
                 LOGE("Unable to retrieve data from '%s': %s", _url.c_str(), response.error);
             } else {
-                addData(std::string(response.content.begin(), response.content.end()));
+                GeoJsonStream stream(*this);
+                stream.append(response.content.data(), response.content.size());
+                stream.finish();
                 generateTiles();
             }
             m_hasPendingData = false;
@@ -174,26 +454,321 @@ struct prop_visitor {
     }
 };
 
+// Bounds in degrees of all points of a geometry
+struct feature_bounds {
+    double minLng = std::numeric_limits<double>::max();
+    double minLat = std::numeric_limits<double>::max();
+    double maxLng = std::numeric_limits<double>::lowest();
+    double maxLat = std::numeric_limits<double>::lowest();
+
+    void operator()(const geometry::point<double>& p) {
+        minLng = std::min(minLng, p.x);
+        minLat = std::min(minLat, p.y);
+        maxLng = std::max(maxLng, p.x);
+        maxLat = std::max(maxLat, p.y);
+    }
+
+    void operator()(const geometry::geometry<double>& geom) {
+        geometry::geometry<double>::visit(geom, *this);
+    }
+
+    template <typename T>
+    void operator()(const std::vector<T>& geom) {
+        for (const auto& g : geom) { (*this)(g); }
+    }
+};
+
+struct point_count {
+    size_t count = 0;
+
+    void operator()(const geometry::point<double>& p) { count++; }
+
+    void operator()(const geometry::geometry<double>& geom) {
+        geometry::geometry<double>::visit(geom, *this);
+    }
+
+    template <typename T>
+    void operator()(const std::vector<T>& geom) {
+        for (const auto& g : geom) { (*this)(g); }
+    }
+};
+
+static glm::ivec2 branchCoordinates(double _lng, double _lat) {
+    double lat = glm::clamp(_lat, -MapProjection::MAX_LATITUDE_DEGREES, MapProjection::MAX_LATITUDE_DEGREES);
+    auto meters = MapProjection::lngLatToProjectedMeters(LngLat(_lng, lat));
+    double metersPerTile = MapProjection::metersPerTileAtZoom(branch_zoom);
+    int max = (1 << branch_zoom) - 1;
+    return {
+        glm::clamp(int((meters.x + MapProjection::EARTH_HALF_CIRCUMFERENCE_METERS) / metersPerTile), 0, max),
+        glm::clamp(int((MapProjection::EARTH_HALF_CIRCUMFERENCE_METERS - meters.y) / metersPerTile), 0, max)
+    };
+}
+
+ClientDataSource::Storage::StoredFeature ClientDataSource::Storage::make(geometry::geometry<double>&& _geometry,
+                                                                         Properties&& _properties,
+                                                                         bool _generateCentroid) {
+    StoredFeature feature;
+    feature.geometry = std::move(_geometry);
+    feature.properties = std::make_shared<const Properties>(std::move(_properties));
+
+    if (_generateCentroid &&
+        geometry::geometry<double>::visit(feature.geometry, add_centroid{ feature.centroid })) {
+        auto props = std::make_shared<Properties>(*feature.properties);
+        props->set("label_placement", 1.0);
+        feature.hasCentroid = true;
+        feature.centroidProperties = std::move(props);
+    }
+
+    point_count points;
+    points(feature.geometry);
+    feature.points = points.count + (feature.hasCentroid ? 1 : 0);
+
+    feature_bounds bounds;
+    bounds(feature.geometry);
+    if (bounds.minLng <= bounds.maxLng) {
+        // Tile rows grow from north to south
+        auto min = branchCoordinates(bounds.minLng, bounds.maxLat);
+        auto max = branchCoordinates(bounds.maxLng, bounds.minLat);
+        feature.minX = min.x;
+        feature.minY = min.y;
+        feature.maxX = max.x;
+        feature.maxY = max.y;
+        feature.global = (max.x - min.x + 1) * (max.y - min.y + 1) > max_feature_branches;
+    }
+    return feature;
+}
+
+void ClientDataSource::Storage::insert(FeatureId _id, StoredFeature&& _feature) {
+    auto& feature = features[_id];
+    feature = std::move(_feature);
+    points += feature.points;
+
+    if (clustering && feature.geometry.is<geometry::point<double>>()) {
+        feature.clustered = true;
+        clustersDirty = true;
+    }
+
+    forEachBranch(feature, [&](Branch& _branch) {
+        _branch.features.insert(_id);
+        _branch.dirty = true;
+    });
+}
+
+bool ClientDataSource::Storage::erase(FeatureId _id) {
+    auto it = features.find(_id);
+    if (it == features.end()) { return false; }
+
+    forEachBranch(it->second, [&](Branch& _branch) {
+        _branch.features.erase(_id);
+        _branch.dirty = true;
+    });
+    points -= it->second.points;
+    if (it->second.clustered) { clustersDirty = true; }
+    features.erase(it);
+    return true;
+}
+
+ClientDataSource::Storage::Build ClientDataSource::Storage::collect(Branch& _branch) {
+    Build build;
+
+    for (auto id : _branch.features) {
+        const auto& feature = features[id];
+        if (feature.clustered) { continue; }
+
+        build.features.emplace_back(feature.geometry, uint64_t(build.properties.size()));
+        build.properties.push_back(feature.properties);
+        build.points += feature.points;
+
+        if (feature.hasCentroid) {
+            build.features.emplace_back(feature.centroid, uint64_t(build.properties.size()));
+            build.properties.push_back(feature.centroidProperties);
+        }
+    }
+    _branch.dirty = false;
+    return build;
+}
+
+void ClientDataSource::Storage::release() {
+    for (auto it = features.begin(); it != features.end();) {
+        if (it->second.clustered) {
+            ++it;
+            continue;
+        }
+        FeatureId id = it->first;
+        forEachBranch(it->second, [&](Branch& _branch) {
+            _branch.features.erase(id);
+        });
+        points -= it->second.points;
+        it = features.erase(it);
+        hasReleased = true;
+    }
+}
+
+std::shared_ptr<ClientDataSource::Storage::Index> ClientDataSource::Storage::index(Build&& _build,
+                                                                                   const geojsonvt::Options& _options) {
+    if (_build.features.empty()) { return nullptr; }
+    auto index = std::make_shared<Index>(_build.features, std::move(_build.properties), _options);
+    // geojson-vt keeps the features as points of three doubles
+    index->bytes = _build.points * 3 * sizeof(double);
+    return index;
+}
+
+void ClientDataSource::Storage::collectClusters(ClusterBuild& _build) {
+    for (const auto& it : features) {
+        if (!it.second.clustered) { continue; }
+        const auto& point = it.second.geometry.get<geometry::point<double>>();
+        _build.lngLats.push_back(point.x);
+        _build.lngLats.push_back(point.y);
+        _build.properties.push_back(it.second.properties);
+    }
+    clustersDirty = false;
+}
+
+std::shared_ptr<ClientDataSource::Storage::Clusters> ClientDataSource::Storage::cluster(ClusterBuild&& _build,
+                                                                                      PointClusters::Options _options) {
+    if (_build.properties.empty()) { return nullptr; }
+    return std::make_shared<Clusters>(_build.lngLats, _options, std::move(_build.properties));
+}
+
 void ClientDataSource::generateTiles() {
 
-    std::lock_guard<std::mutex> lock(m_mutexStore);
+    // Builds run one at a time, so that snapshots are published in order
+    std::lock_guard<std::mutex> buildLock(m_mutexBuild);
+
+    std::vector<std::pair<TileID, Storage::Build>> builds;
+    Storage::Build globalBuild;
+    bool buildGlobal = false;
+    Storage::ClusterBuild clusterBuild;
+    bool buildClusters = false;
+    bool release = m_tilingOptions.releaseFeatures;
+    bool dropReleased = false;
+    {
+        // Only copy the changed features while edits are locked out
+        std::lock_guard<std::mutex> lock(m_mutexStore);
+
+        for (auto it = m_store->branches.begin(); it != m_store->branches.end();) {
+            auto& branch = it->second;
+            if (branch.dirty) {
+                builds.emplace_back(it->first, m_store->collect(branch));
+            }
+            if (branch.features.empty()) {
+                it = m_store->branches.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        if (m_store->global.dirty) {
+            globalBuild = m_store->collect(m_store->global);
+            buildGlobal = true;
+        }
+        if (m_store->clustersDirty) {
+            m_store->collectClusters(clusterBuild);
+            buildClusters = true;
+        }
+        if (release) { m_store->release(); }
+        dropReleased = m_store->dropReleased;
+        m_store->dropReleased = false;
+    }
+
+    if (builds.empty() && !buildGlobal && !buildClusters && !dropReleased) { return; }
+
+    // Tiles keep being parsed from the previous snapshot while the indices are built
+    auto previous = dropReleased ? nullptr : std::atomic_load(&m_snapshot);
+    auto snapshot = previous ? std::make_shared<Snapshot>(*previous) : std::make_shared<Snapshot>();
+
+    auto tilingOptions = options(m_tilingOptions);
+
+    // The indices of released features are kept, as their features can't be tiled again
+    for (auto& build : builds) {
+        auto index = Storage::index(std::move(build.second), tilingOptions);
+        if (!release) { snapshot->branches.erase(build.first); }
+        if (index) { snapshot->branches.emplace(build.first, std::move(index)); }
+    }
+    if (buildGlobal) {
+        auto index = Storage::index(std::move(globalBuild), tilingOptions);
+        if (!release) { snapshot->global.clear(); }
+        if (index) { snapshot->global.push_back(std::move(index)); }
+    }
+    if (buildClusters) {
+        PointClusters::Options options;
+        options.radius = m_clusterOptions.radius;
+        options.minZoom = std::max(m_zoomOptions.minDisplayZoom, 0);
+        options.maxZoom = m_clusterOptions.maxZoom;
+        snapshot->clusters = Storage::cluster(std::move(clusterBuild), options);
+    }
+
+    std::atomic_store(&m_snapshot, std::shared_ptr<const Snapshot>(std::move(snapshot)));
+    int64_t generation = ++m_generation;
+
+    // Only the tiles of the rebuilt branches are loaded again
+    std::lock_guard<std::mutex> lock(m_mutexGenerations);
+    for (auto& build : builds) {
+        m_branchGenerations[build.first] = generation;
+    }
+    if (buildGlobal || dropReleased) {
+        m_globalGeneration = generation;
+    }
+    if (buildClusters) {
+        m_clusterGeneration = generation;
+    }
+}
+
+int64_t ClientDataSource::tileGeneration(const TileID& _tileId) const {
+
+    std::lock_guard<std::mutex> lock(m_mutexGenerations);
+
+    int64_t generation = std::max(m_baseGeneration, m_globalGeneration);
 
-    if (m_generateCentroids) {
-        for (const auto &feat : m_store->features) {
-            geometry::point<double> centroid;
-            const auto& properties = m_store->properties[feat.id.get<uint64_t>()];
-            if (geometry::geometry<double>::visit(feat.geometry, add_centroid{ centroid })) {
-                uint64_t id = m_store->features.size();
-                m_store->features.emplace_back(centroid, id);
-                m_store->properties.push_back(properties);
-                auto& props = m_store->properties.back();
-                props.set("label_placement", 1.0);
+    // Clusters of all zooms change with any clustered point. Above the max
+    // zoom the points are drawn alone, so the generations of their branches
+    // apply.
+    if (m_clusterOptions.enabled && _tileId.z <= m_clusterOptions.maxZoom) {
+        generation = std::max(generation, m_clusterGeneration);
+    }
+
+    if (_tileId.z >= branch_zoom) {
+        int shift = _tileId.z - branch_zoom;
+        auto it = m_branchGenerations.find(TileID(_tileId.x >> shift, _tileId.y >> shift, branch_zoom));
+        if (it != m_branchGenerations.end()) {
+            generation = std::max(generation, it->second);
+        }
+    } else {
+        // All branches below the tile
+        int shift = branch_zoom - _tileId.z;
+        int minX = _tileId.x << shift, maxX = ((_tileId.x + 1) << shift) - 1;
+        int minY = _tileId.y << shift, maxY = ((_tileId.y + 1) << shift) - 1;
+
+        for (auto it = m_branchGenerations.lower_bound(TileID(minX, minY, branch_zoom));
+             it != m_branchGenerations.end() && it->first.x <= maxX; ++it) {
+            if (it->first.y >= minY && it->first.y <= maxY) {
+                generation = std::max(generation, it->second);
             }
         }
     }
+    return generation;
+}
 
-    m_store->tiles = std::make_unique<geojsonvt::GeoJSONVT>(m_store->features, options());
-    m_generation++;
+void ClientDataSource::clearData() {
+    TileSource::clearData();
+
+    std::lock_guard<std::mutex> lock(m_mutexGenerations);
+    m_baseGeneration = m_generation;
+}
+
+void ClientDataSource::getMemoryUsage(MemoryUsage& _usage) const {
+    TileSource::getMemoryUsage(_usage);
+
+    size_t bytes = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutexStore);
+        bytes += m_store->points * sizeof(geometry::point<double>);
+    }
+    if (auto snapshot = std::atomic_load(&m_snapshot)) {
+        for (const auto& branch : snapshot->branches) { bytes += branch.second->bytes; }
+        for (const auto& global : snapshot->global) { bytes += global->bytes; }
+        if (snapshot->clusters) { bytes += snapshot->clusters->clusters.bytes(); }
+    }
+    _usage.cpuBytes[MemoryUsage::client_data] += bytes;
 }
 
 void ClientDataSource::loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) {
@@ -216,65 +791,217 @@ void ClientDataSource::clearFeatures() {
 
     std::lock_guard<std::mutex> lock(m_mutexStore);
 
-    m_store->features.clear();
-    m_store->properties.clear();
+    m_store->clear();
 }
 
 void ClientDataSource::addData(const std::string& _data) {
 
-    std::lock_guard<std::mutex> lock(m_mutexStore);
+    GeoJsonStream stream(*this);
+    stream.append(_data.data(), _data.size());
+    stream.finish();
+}
 
-    const auto json = geojson::parse(_data);
+void ClientDataSource::beginData() {
+    m_stream = std::make_unique<GeoJsonStream>(*this);
+}
+
+void ClientDataSource::appendData(const char* _data, size_t _length) {
+    if (!m_stream) { beginData(); }
+    m_stream->append(_data, _length);
+}
+
+bool ClientDataSource::endData() {
+    if (!m_stream) { return false; }
+    bool complete = m_stream->finish();
+    m_stream.reset();
+    return complete;
+}
+
+void ClientDataSource::addFeatures(const char* _json, size_t _length) {
+
+    const auto json = geojson::parse(std::string(_json, _length));
     auto features = geojsonvt::geojson::visit(json, geojsonvt::ToFeatureCollection{});
 
+    std::lock_guard<std::mutex> lock(m_mutexStore);
+
     for (auto& feature : features) {
 
-        feature.id = uint64_t(m_store->properties.size());
-        m_store->properties.emplace_back();
-        Properties& props = m_store->properties.back();
+        Properties props;
 
         for (const auto& prop : feature.properties) {
             auto key = prop.first;
             prop_visitor visitor = {props, key};
             mapbox::util::apply_visitor(visitor, prop.second);
         }
-        feature.properties.clear();
-    }
 
-    m_store->features.insert(m_store->features.end(),
-                             std::make_move_iterator(features.begin()),
-                             std::make_move_iterator(features.end()));
+        m_store->insert(m_store->nextId++, Storage::make(std::move(feature.geometry), std::move(props),
+                                                         m_generateCentroids));
+    }
 }
 
-void ClientDataSource::addPointFeature(Properties&& properties, LngLat coordinates) {
+ClientDataSource::FeatureId ClientDataSource::addPointFeature(Properties&& properties, LngLat coordinates) {
 
     std::lock_guard<std::mutex> lock(m_mutexStore);
 
     geometry::point<double> geom {coordinates.longitude, coordinates.latitude};
 
-    uint64_t id = m_store->features.size();
-    m_store->features.emplace_back(geom, id);
-    m_store->properties.emplace_back(properties);
+    FeatureId id = m_store->nextId++;
+    m_store->insert(id, Storage::make(geom, std::move(properties), m_generateCentroids));
+    return id;
 }
 
-void ClientDataSource::addPolylineFeature(Properties&& properties, PolylineBuilder&& polyline) {
+ClientDataSource::FeatureId ClientDataSource::addPolylineFeature(Properties&& properties, PolylineBuilder&& polyline) {
 
     std::lock_guard<std::mutex> lock(m_mutexStore);
 
-    uint64_t id = m_store->features.size();
     auto geom = std::move(polyline.data);
-    m_store->features.emplace_back(*geom, id);
-    m_store->properties.emplace_back(properties);
+    FeatureId id = m_store->nextId++;
+    m_store->insert(id, Storage::make(geometry::line_string<double>(std::move(*geom)), std::move(properties),
+                                      m_generateCentroids));
+    return id;
 }
 
-void ClientDataSource::addPolygonFeature(Properties&& properties, PolygonBuilder&& polygon) {
+ClientDataSource::FeatureId ClientDataSource::addPolygonFeature(Properties&& properties, PolygonBuilder&& polygon) {
 
     std::lock_guard<std::mutex> lock(m_mutexStore);
 
-    uint64_t id = m_store->features.size();
     auto geom = std::move(polygon.data);
-    m_store->features.emplace_back(*geom, id);
-    m_store->properties.emplace_back(properties);
+    FeatureId id = m_store->nextId++;
+    m_store->insert(id, Storage::make(geometry::polygon<double>(std::move(*geom)), std::move(properties),
+                                      m_generateCentroids));
+    return id;
+}
+
+// Makes the Properties of each row of property columns. Keys are sorted and
+// looked up once for all rows.
+struct ColumnRows {
+
+    struct Column {
+        std::string key;
+        Properties::KeyId keyId;
+        const double* numbers;
+        const std::string* strings;
+    };
+    std::vector<Column> columns;
+
+    ColumnRows(const std::vector<ClientDataSource::NumberColumn>& _numbers,
+               const std::vector<ClientDataSource::StringColumn>& _strings) {
+
+        for (auto& column : _numbers) {
+            columns.push_back({column.key, 0, column.values, nullptr});
+        }
+        for (auto& column : _strings) {
+            columns.push_back({column.key, 0, nullptr, column.values});
+        }
+        // When a key is repeated the last column is used
+        std::stable_sort(columns.begin(), columns.end(), [](const Column& a, const Column& b) {
+            return Properties::keyComparator(a.key, b.key);
+        });
+        for (size_t i = 0; i + 1 < columns.size();) {
+            if (columns[i].key == columns[i + 1].key) {
+                columns.erase(columns.begin() + i);
+            } else {
+                i++;
+            }
+        }
+        for (auto& column : columns) {
+            column.keyId = Properties::findKey(column.key);
+        }
+    }
+
+    Properties row(size_t _row) const {
+        std::vector<Properties::Item> items;
+        items.reserve(columns.size());
+        for (auto& column : columns) {
+            if (column.numbers) {
+                items.emplace_back(column.key, column.keyId, Value(column.numbers[_row]));
+            } else {
+                items.emplace_back(column.key, column.keyId, Value(column.strings[_row]));
+            }
+        }
+        Properties props;
+        props.setSorted(std::move(items));
+        return props;
+    }
+};
+
+ClientDataSource::FeatureId ClientDataSource::addPointFeatures(size_t _count, const double* _coordinates,
+                                                               const std::vector<NumberColumn>& _numbers,
+                                                               const std::vector<StringColumn>& _strings) {
+
+    ColumnRows rows(_numbers, _strings);
+
+    std::lock_guard<std::mutex> lock(m_mutexStore);
+
+    FeatureId first = m_store->nextId;
+    for (size_t i = 0; i < _count; i++) {
+        geometry::point<double> geom {_coordinates[2 * i], _coordinates[2 * i + 1]};
+        m_store->insert(m_store->nextId++, Storage::make(geom, rows.row(i), m_generateCentroids));
+    }
+    return first;
+}
+
+ClientDataSource::FeatureId ClientDataSource::addPolylineFeatures(size_t _count, const double* _coordinates,
+                                                                  const uint32_t* _offsets,
+                                                                  const std::vector<NumberColumn>& _numbers,
+                                                                  const std::vector<StringColumn>& _strings) {
+
+    ColumnRows rows(_numbers, _strings);
+
+    std::lock_guard<std::mutex> lock(m_mutexStore);
+
+    FeatureId first = m_store->nextId;
+    for (size_t i = 0; i < _count; i++) {
+        geometry::line_string<double> geom;
+        geom.reserve(_offsets[i + 1] - _offsets[i]);
+        for (uint32_t j = _offsets[i]; j < _offsets[i + 1]; j++) {
+            geom.emplace_back(_coordinates[2 * j], _coordinates[2 * j + 1]);
+        }
+        m_store->insert(m_store->nextId++, Storage::make(std::move(geom), rows.row(i), m_generateCentroids));
+    }
+    return first;
+}
+
+bool ClientDataSource::updatePointFeature(FeatureId _id, Properties&& properties, LngLat coordinates) {
+
+    std::lock_guard<std::mutex> lock(m_mutexStore);
+
+    if (!m_store->erase(_id)) { return false; }
+
+    geometry::point<double> geom {coordinates.longitude, coordinates.latitude};
+    m_store->insert(_id, Storage::make(geom, std::move(properties), m_generateCentroids));
+    return true;
+}
+
+bool ClientDataSource::updatePolylineFeature(FeatureId _id, Properties&& properties, PolylineBuilder&& polyline) {
+
+    std::lock_guard<std::mutex> lock(m_mutexStore);
+
+    if (!m_store->erase(_id)) { return false; }
+
+    auto geom = std::move(polyline.data);
+    m_store->insert(_id, Storage::make(geometry::line_string<double>(std::move(*geom)), std::move(properties),
+                                       m_generateCentroids));
+    return true;
+}
+
+bool ClientDataSource::updatePolygonFeature(FeatureId _id, Properties&& properties, PolygonBuilder&& polygon) {
+
+    std::lock_guard<std::mutex> lock(m_mutexStore);
+
+    if (!m_store->erase(_id)) { return false; }
+
+    auto geom = std::move(polygon.data);
+    m_store->insert(_id, Storage::make(geometry::polygon<double>(std::move(*geom)), std::move(properties),
+                                       m_generateCentroids));
+    return true;
+}
+
+bool ClientDataSource::removeFeature(FeatureId _id) {
+
+    std::lock_guard<std::mutex> lock(m_mutexStore);
+
+    return m_store->erase(_id);
 }
 
 struct add_geometry {
@@ -286,35 +1013,37 @@ struct add_geometry {
         return { pt.x / extent, 1. - pt.y / extent };
     }
 
+    // Collect the points of a line without repeated points
+    template <typename T>
+    void setLine(const T& _points) {
+        line.clear();
+        for (const auto& p : _points) {
+            auto tp = transformPoint(p);
+            if (line.size() > 0 && tp == line.back()) { continue; }
+            line.push_back(tp);
+        }
+    }
+
     Feature& feature;
+    Line& line;
 
     bool operator()(const geometry::point<int16_t>& p) {
         feature.geometryType = GeometryType::points;
-        feature.points.push_back(transformPoint(p));
+        feature.addPoint(transformPoint(p));
         return true;
     }
     bool operator()(const geometry::line_string<int16_t>& geom) {
         feature.geometryType = GeometryType::lines;
-        feature.lines.emplace_back();
-        Line& line = feature.lines.back();
-        for (const auto& p : geom) {
-            auto tp = transformPoint(p);
-            if (line.size() > 0 && tp == line.back()) { continue; }
-            line.push_back(tp);
-        }
+        setLine(geom);
+        feature.addLine(line);
         return true;
     }
     bool operator()(const geometry::polygon<int16_t>& geom) {
         feature.geometryType = GeometryType::polygons;
-        feature.polygons.emplace_back();
+        feature.beginPolygon();
         for (const auto& ring : geom) {
-            feature.polygons.back().emplace_back();
-            Line& line = feature.polygons.back().back();
-            for (const auto& p : ring) {
-                auto tp = transformPoint(p);
-                if (line.size() > 0 && tp == line.back()) { continue; }
-                line.push_back(tp);
-            }
+            setLine(ring);
+            feature.addRing(line);
         }
         return true;
     }
@@ -343,21 +1072,80 @@ struct add_geometry {
 
 std::shared_ptr<TileData> ClientDataSource::parse(const TileTask& _task) const {
 
-    std::lock_guard<std::mutex> lock(m_mutexStore);
+    auto snapshot = std::atomic_load(&m_snapshot);
+    if (!snapshot) { return nullptr; }
 
-    auto data = std::make_shared<TileData>();
+    const auto& tileId = _task.tileId();
+
+    // Branches with features in the tile
+    std::vector<Storage::Index*> indices;
+    for (const auto& global : snapshot->global) {
+        indices.push_back(global.get());
+    }
+    if (tileId.z >= branch_zoom) {
+        int shift = tileId.z - branch_zoom;
+        auto range = snapshot->branches.equal_range(TileID(tileId.x >> shift, tileId.y >> shift, branch_zoom));
+        for (auto it = range.first; it != range.second; ++it) {
+            indices.push_back(it->second.get());
+        }
+    } else {
+        int shift = branch_zoom - tileId.z;
+        int minX = tileId.x << shift, maxX = ((tileId.x + 1) << shift) - 1;
+        int minY = tileId.y << shift, maxY = ((tileId.y + 1) << shift) - 1;
+
+        for (auto it = snapshot->branches.lower_bound(TileID(minX, minY, branch_zoom));
+             it != snapshot->branches.end() && it->first.x <= maxX; ++it) {
+            if (it->first.y >= minY && it->first.y <= maxY) {
+                indices.push_back(it->second.get());
+            }
+        }
+    }
 
-    if (!m_store->tiles) { return nullptr; }
-    auto tile = m_store->tiles->getTile(_task.tileId().z, _task.tileId().x, _task.tileId().y);
+    auto data = std::make_shared<TileData>();
 
     data->layers.emplace_back("");  // empty name will skip filtering by 'collection'
     Layer& layer = data->layers.back();
 
-    for (auto& it : tile.features) {
-        Feature feature(m_id);
+    // Reused for each line and ring before it is copied into the GeometryBuffer
+    Line line;
+
+    // A feature in several branches is in the tiles of each of them above branch_zoom
+    std::unordered_set<const Properties*> added;
+    bool unique = tileId.z >= branch_zoom;
+
+    for (auto* index : indices) {
+        std::lock_guard<std::mutex> lock(index->mutex);
+
+        auto& tile = index->tiles.getTile(tileId.z, tileId.x, tileId.y);
+
+        for (auto& it : tile.features) {
+            const auto& props = index->properties[it.id.get<uint64_t>()];
+            if (!unique && !added.insert(props.get()).second) { continue; }
+
+            Feature feature(m_id, layer.geometry);
+
+            if (geometry::geometry<int16_t>::visit(it.geometry, add_geometry{ feature, line })) {
+                feature.props = *props;
+                layer.features.emplace_back(std::move(feature));
+            }
+        }
+    }
+
+    if (snapshot->clusters) {
+        std::vector<PointClusters::Cluster> clusters;
+        snapshot->clusters->clusters.getTile(tileId, clusters);
 
-        if (geometry::geometry<int16_t>::visit(it.geometry, add_geometry{ feature })) {
-            feature.props = m_store->properties[it.id.get<uint64_t>()];
+        for (const auto& cluster : clusters) {
+            Feature feature(m_id, layer.geometry);
+            feature.geometryType = GeometryType::points;
+            feature.addPoint(Point(cluster.x, cluster.y));
+
+            if (cluster.count == 1) {
+                feature.props = *snapshot->clusters->properties[cluster.point];
+            } else {
+                feature.props.set("cluster", 1.0);
+                feature.props.set("point_count", double(cluster.count));
+            }
             layer.features.emplace_back(std::move(feature));
         }
     }
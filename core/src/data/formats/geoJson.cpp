@@ -8,6 +8,8 @@
 
 #include "glm/glm.hpp"
 
+#include <cstring>
+
 namespace Tangram {
 
 bool GeoJson::isFeatureCollection(const JsonValue& _in) {
@@ -38,10 +40,17 @@ Point GeoJson::getPoint(const JsonValue& _in, const Transform& _proj) {
 Line GeoJson::getLine(const JsonValue& _in, const Transform& _proj) {
 
     Line line;
+    getLine(_in, _proj, line);
+    return line;
+
+}
+
+void GeoJson::getLine(const JsonValue& _in, const Transform& _proj, Line& _line) {
+
+    _line.clear();
     for (auto itr = _in.Begin(); itr != _in.End(); ++itr) {
-        line.push_back(getPoint(*itr, _proj));
+        _line.push_back(getPoint(*itr, _proj));
     }
-    return line;
 
 }
 
@@ -55,82 +64,126 @@ Polygon GeoJson::getPolygon(const JsonValue& _in, const Transform& _proj) {
 
 }
 
-Properties GeoJson::getProperties(const JsonValue& _in, int32_t _sourceId) {
+GeoJson::PropertyPool::PropertyPool() : table(std::make_shared<PropertyTable>()) {}
+
+uint32_t GeoJson::PropertyPool::key(const char* _key, size_t _length) {
+    auto it = keys.emplace(std::string(_key, _length), uint32_t(table->keys.size()));
+    if (it.second) { table->keys.push_back(it.first->first); }
+    return it.first->second;
+}
+
+uint32_t GeoJson::PropertyPool::value(const char* _string, size_t _length) {
+    auto it = strings.emplace(std::string(_string, _length), uint32_t(table->values.size()));
+    if (it.second) { table->values.emplace_back(it.first->first); }
+    return it.first->second;
+}
 
-    std::vector<PropertyItem> items;
-    items.reserve(_in.MemberCount());
+uint32_t GeoJson::PropertyPool::value(double _number) {
+    auto it = numbers.emplace(_number, uint32_t(table->values.size()));
+    if (it.second) { table->values.emplace_back(_number); }
+    return it.first->second;
+}
+
+void GeoJson::PropertyPool::finish() {
+    table->orderKeys();
+}
+
+Properties GeoJson::getProperties(const JsonValue& _in, int32_t _sourceId, PropertyPool& _pool) {
+
+    std::vector<Properties::Tag> tags;
+    tags.reserve(_in.MemberCount());
 
     for (auto it = _in.MemberBegin(); it != _in.MemberEnd(); ++it) {
 
-        const auto& name = it->name.GetString();
         const auto& value = it->value;
+        uint32_t valueId;
         if (value.IsNumber()) {
-            items.emplace_back(name, value.GetDouble());
-        } else if (it->value.IsString()) {
-            items.emplace_back(name, value.GetString());
-        } else if (it->value.IsBool()) {
-            items.emplace_back(name, double(value.GetBool()));
+            valueId = _pool.value(value.GetDouble());
+        } else if (value.IsString()) {
+            valueId = _pool.value(value.GetString(), value.GetStringLength());
+        } else if (value.IsBool()) {
+            valueId = _pool.value(double(value.GetBool()));
+        } else {
+            continue;
         }
+        tags.emplace_back(_pool.key(it->name.GetString(), it->name.GetStringLength()), valueId);
     }
 
+    // Keys are ordered by the pool once the layer is read
     Properties properties;
     properties.sourceId = _sourceId;
-    properties.setSorted(std::move(items));
-    properties.sort();
+    properties.setTags(_pool.table, std::move(tags));
 
     return properties;
 
 }
 
-Feature GeoJson::getFeature(const JsonValue& _in, const Transform& _proj, int32_t _sourceId) {
+Feature GeoJson::getFeature(const JsonValue& _in, const Transform& _proj, int32_t _sourceId,
+                            std::shared_ptr<GeometryBuffer> _geometry, Line& _line,
+                            PropertyPool& _pool) {
+
+    Feature feature(_sourceId, std::move(_geometry));
 
-    Feature feature;
+    auto id = _in.FindMember("id");
+    if (id != _in.MemberEnd() && id->value.IsUint64()) {
+        feature.id = id->value.GetUint64();
+    }
 
     // Copy properties into tile data
     auto properties = _in.FindMember("properties");
     if (properties != _in.MemberEnd()) {
-        feature.props = getProperties(properties->value, _sourceId);
+        feature.props = getProperties(properties->value, _sourceId, _pool);
     }
 
     // Copy geometry into tile data
     const JsonValue& geometry = _in["geometry"];
     const JsonValue& coords = geometry["coordinates"];
-    const std::string& geometryType = geometry["type"].GetString();
+    const char* geometryType = geometry["type"].GetString();
 
-    if (geometryType.compare("Point") == 0) {
+    if (std::strcmp(geometryType, "Point") == 0) {
 
         feature.geometryType = GeometryType::points;
-        feature.points.push_back(getPoint(coords, _proj));
+        feature.addPoint(getPoint(coords, _proj));
 
-    } else if (geometryType.compare("MultiPoint") == 0) {
+    } else if (std::strcmp(geometryType, "MultiPoint") == 0) {
 
         feature.geometryType = GeometryType::points;
         for (auto pointCoords = coords.Begin(); pointCoords != coords.End(); ++pointCoords) {
-            feature.points.push_back(getPoint(*pointCoords, _proj));
+            feature.addPoint(getPoint(*pointCoords, _proj));
         }
 
-    } else if (geometryType.compare("LineString") == 0) {
+    } else if (std::strcmp(geometryType, "LineString") == 0) {
 
         feature.geometryType = GeometryType::lines;
-        feature.lines.push_back(getLine(coords, _proj));
+        getLine(coords, _proj, _line);
+        feature.addLine(_line);
 
-    } else if (geometryType.compare("MultiLineString") == 0) {
+    } else if (std::strcmp(geometryType, "MultiLineString") == 0) {
 
         feature.geometryType = GeometryType::lines;
         for (auto lineCoords = coords.Begin(); lineCoords != coords.End(); ++lineCoords) {
-            feature.lines.push_back(getLine(*lineCoords, _proj));
+            getLine(*lineCoords, _proj, _line);
+            feature.addLine(_line);
         }
 
-    } else if (geometryType.compare("Polygon") == 0) {
+    } else if (std::strcmp(geometryType, "Polygon") == 0) {
 
         feature.geometryType = GeometryType::polygons;
-        feature.polygons.push_back(getPolygon(coords, _proj));
+        feature.beginPolygon();
+        for (auto ringCoords = coords.Begin(); ringCoords != coords.End(); ++ringCoords) {
+            getLine(*ringCoords, _proj, _line);
+            feature.addRing(_line);
+        }
 
-    } else if (geometryType.compare("MultiPolygon") == 0) {
+    } else if (std::strcmp(geometryType, "MultiPolygon") == 0) {
 
         feature.geometryType = GeometryType::polygons;
         for (auto polyCoords = coords.Begin(); polyCoords != coords.End(); ++polyCoords) {
-            feature.polygons.push_back(getPolygon(*polyCoords, _proj));
+            feature.beginPolygon();
+            for (auto ringCoords = polyCoords->Begin(); ringCoords != polyCoords->End(); ++ringCoords) {
+                getLine(*ringCoords, _proj, _line);
+                feature.addRing(_line);
+            }
         }
 
     }
@@ -150,9 +203,15 @@ Layer GeoJson::getLayer(const JsonValue& _in, const Transform& _proj, int32_t _s
         return layer;
     }
 
+    // Reused for each line and ring of the features
+    Line line;
+    PropertyPool pool;
+
+    layer.features.reserve(features->value.Size());
     for (auto featureIt = features->value.Begin(); featureIt != features->value.End(); ++featureIt) {
-        layer.features.push_back(getFeature(*featureIt, _proj, _sourceId));
+        layer.features.push_back(getFeature(*featureIt, _proj, _sourceId, layer.geometry, line, pool));
     }
+    pool.finish();
 
     return layer;
 
@@ -167,7 +226,8 @@ std::shared_ptr<TileData> GeoJson::parseTile(const TileTask& _task, int32_t _sou
     // Parse data into a JSON document
     const char* error;
     size_t offset;
-    auto document = JsonParseBytes(task.rawTileData->data(), task.rawTileData->size(), &error, &offset);
+    std::vector<char> buffer;
+    auto document = JsonParseInsitu(task.tileData(), task.tileDataSize(), buffer, &error, &offset);
 
     if (error) {
         LOGE("Json parsing failed on tile [%s]: %s (%u)", task.tileId().toString().c_str(), error, offset);
@@ -197,7 +257,7 @@ std::shared_ptr<TileData> GeoJson::parseTile(const TileTask& _task, int32_t _sou
             }
         }
     }
-
+    tileData->resolveProperties();
 
     // Discard original JSON object and return TileData
 
@@ -5,6 +5,8 @@
 #include "util/types.h"
 #include <functional>
 #include <memory>
+#include <string>
+#include <unordered_map>
 
 namespace Tangram {
 
@@ -20,11 +22,35 @@ Point getPoint(const JsonValue& _in, const Transform& _proj);
 
 Line getLine(const JsonValue& _in, const Transform& _proj);
 
+// Read the points of a line into _line
+void getLine(const JsonValue& _in, const Transform& _proj, Line& _line);
+
 Polygon getPolygon(const JsonValue& _in, const Transform& _proj);
 
-Properties getProperties(const JsonValue& _in, int32_t _sourceId);
+// Keys and values of the features of a layer. Each distinct key and value is
+// stored once in the table, which the Properties of the features reference.
+struct PropertyPool {
+    PropertyPool();
+
+    uint32_t key(const char* _key, size_t _length);
+    uint32_t value(const char* _string, size_t _length);
+    uint32_t value(double _number);
+
+    // Order the keys of the table once all features are read
+    void finish();
+
+    std::shared_ptr<PropertyTable> table;
+    std::unordered_map<std::string, uint32_t> keys;
+    std::unordered_map<std::string, uint32_t> strings;
+    std::unordered_map<double, uint32_t> numbers;
+};
+
+Properties getProperties(const JsonValue& _in, int32_t _sourceId, PropertyPool& _pool);
 
-Feature getFeature(const JsonValue& _in, const Transform& _proj, int32_t _sourceId);
+// Add the geometry of the feature to _geometry, the buffer of the Layer. Each line
+// and ring is read into _line before it is copied there.
+Feature getFeature(const JsonValue& _in, const Transform& _proj, int32_t _sourceId,
+                   std::shared_ptr<GeometryBuffer> _geometry, Line& _line, PropertyPool& _pool);
 
 Layer getLayer(const JsonValue& _in, const Transform& _proj, int32_t _sourceId);
 
@@ -22,11 +22,16 @@
 #define LAYER_VALUE 4
 #define LAYER_TILE_EXTENT 5
 
+// Number of features parsed between checks for the cancellation of the task
+#define CANCEL_CHECK_FEATURES 64
+
 namespace Tangram {
 
-Mvt::Geometry Mvt::getGeometry(ParserContext& _ctx, protobuf::message _geomIn) {
+void Mvt::getGeometry(ParserContext& _ctx, protobuf::message _geomIn) {
 
-    Geometry geometry;
+    Geometry& geometry = _ctx.geometry;
+    geometry.coordinates.clear();
+    geometry.sizes.clear();
 
     GeomCmd cmd = GeomCmd::moveTo;
     uint32_t cmdRepeat = 0;
@@ -46,14 +51,36 @@ Mvt::Geometry Mvt::getGeometry(ParserContext& _ctx, protobuf::message _geomIn) {
             cmdRepeat = cmdData >> 3; //last 5 bits
         }
 
-        if(cmd == GeomCmd::moveTo || cmd == GeomCmd::lineTo) { // get parameters/points
-            // if cmd is move then move to a new line/set of points and save this line
-            if(cmd == GeomCmd::moveTo) {
-                if (geometry.coordinates.size() > 0) {
-                    geometry.sizes.push_back(numCoordinates);
+        if (cmd == GeomCmd::lineTo) {
+            // Decode the whole run into the coordinates sized for it. Each point
+            // takes at least two bytes, which bounds the size for invalid data.
+            size_t end = geometry.coordinates.size();
+            size_t remaining = (_geomIn.getEnd() - _geomIn.getData()) / 2;
+            geometry.coordinates.resize(end + std::min(size_t(cmdRepeat), remaining));
+
+            for (size_t i = end, n = geometry.coordinates.size(); i < n; i++) {
+                x += _geomIn.svarint();
+                y += _geomIn.svarint();
+
+                // bring the points in 0 to 1 space
+                Point p(invTileExtent * (double)x, invTileExtent * (double)(_ctx.tileExtent - y));
+
+                if (numCoordinates == 0 || geometry.coordinates[end - 1] != p) {
+                    geometry.coordinates[end++] = p;
+                    numCoordinates++;
                 }
-                numCoordinates = 0;
             }
+            geometry.coordinates.resize(end);
+            cmdRepeat = 0;
+            continue;
+        }
+
+        if(cmd == GeomCmd::moveTo) { // get parameters/points
+            // move to a new line/set of points and save this line
+            if (geometry.coordinates.size() > 0) {
+                geometry.sizes.push_back(numCoordinates);
+            }
+            numCoordinates = 0;
 
             x += _geomIn.svarint();
             y += _geomIn.svarint();
@@ -81,23 +108,23 @@ Mvt::Geometry Mvt::getGeometry(ParserContext& _ctx, protobuf::message _geomIn) {
     if (numCoordinates > 0) {
         geometry.sizes.push_back(numCoordinates);
     }
-
-    return geometry;
 }
 
-Feature Mvt::getFeature(ParserContext& _ctx, protobuf::message _featureIn) {
+bool Mvt::getFeature(ParserContext& _ctx, protobuf::message _featureIn, Feature& _feature) {
 
-    Feature feature(_ctx.sourceId);
+    auto& keys = _ctx.properties->keys;
+    auto& values = _ctx.properties->values;
 
     _ctx.featureTags.clear();
-    _ctx.featureTags.assign(_ctx.keys.size(), -1);
+    _ctx.geometry.coordinates.clear();
+    _ctx.geometry.sizes.clear();
 
+    protobuf::message geometryMsg;
 
     while(_featureIn.next()) {
         switch(_featureIn.tag) {
             case FEATURE_ID:
-                // ignored for now, also not used in json parsing
-                _featureIn.skip();
+                _feature.id = _featureIn.varint();
                 break;
 
             case FEATURE_TAGS: {
@@ -106,33 +133,33 @@ Feature Mvt::getFeature(ParserContext& _ctx, protobuf::message _featureIn) {
                 while(tagsMsg) {
                     auto tagKey = tagsMsg.varint();
 
-                    if(_ctx.keys.size() <= tagKey) {
+                    if(keys.size() <= tagKey) {
                         LOGE("accessing out of bound key");
-                        return feature;
+                        return true;
                     }
 
                     if(!tagsMsg) {
                         LOGE("uneven number of feature tag ids");
-                        return feature;
+                        return true;
                     }
 
                     auto valueKey = tagsMsg.varint();
 
-                    if( _ctx.values.size() <= valueKey ) {
+                    if( values.size() <= valueKey ) {
                         LOGE("accessing out of bound values");
-                        return feature;
+                        return true;
                     }
 
-                    _ctx.featureTags[tagKey] = valueKey;
+                    _ctx.featureTags.emplace_back(tagKey, valueKey);
                 }
                 break;
             }
             case FEATURE_TYPE:
-                feature.geometryType = (GeometryType)_featureIn.varint();
+                _feature.geometryType = (GeometryType)_featureIn.varint();
                 break;
             // Actual geometry data
             case FEATURE_GEOM:
-                _ctx.geometry = getGeometry(_ctx, _featureIn.getMessage());
+                geometryMsg = _featureIn.getMessage();
                 break;
 
             default:
@@ -141,34 +168,28 @@ Feature Mvt::getFeature(ParserContext& _ctx, protobuf::message _featureIn) {
         }
     }
 
-    std::vector<Properties::Item> properties;
-    properties.reserve(_ctx.featureTags.size());
+    // Values are looked up in the layer's PropertyTable only when they are accessed
+    _feature.props.setTags(_ctx.properties, { _ctx.featureTags.begin(), _ctx.featureTags.end() });
 
-    for (int tagKey : _ctx.orderedKeys) {
-        int tagValue = _ctx.featureTags[tagKey];
-        if (tagValue >= 0) {
-            properties.emplace_back(_ctx.keys[tagKey], _ctx.values[tagValue]);
-        }
-    }
-    feature.props.setSorted(std::move(properties));
+    // Only decode the geometry when the feature is used
+    if (_ctx.filter && !_ctx.filter->accept(_feature)) { return false; }
+
+    getGeometry(_ctx, geometryMsg);
 
-    switch(feature.geometryType) {
+    switch(_feature.geometryType) {
         case GeometryType::points:
-            feature.points.insert(feature.points.begin(),
-                                  _ctx.geometry.coordinates.begin(),
-                                  _ctx.geometry.coordinates.end());
+            for (auto& point : _ctx.geometry.coordinates) {
+                _feature.addPoint(point);
+            }
             break;
 
         case GeometryType::lines:
         {
-            auto pos = _ctx.geometry.coordinates.begin();
+            const Point* pos = _ctx.geometry.coordinates.data();
             for (int length : _ctx.geometry.sizes) {
                 if (length == 0) { continue; }
-                Line line;
-                line.reserve(length);
-                line.insert(line.begin(), pos, pos + length);
+                _feature.addLine(pos, length);
                 pos += length;
-                feature.lines.emplace_back(std::move(line));
             }
             break;
         }
@@ -189,20 +210,18 @@ Feature Mvt::getFeature(ParserContext& _ctx, protobuf::message _featureIn) {
                 if (_ctx.winding == 0) {
                     _ctx.winding = winding;
                 }
-                Line line;
-                line.reserve(length);
+                if (winding == _ctx.winding || _feature.polygons().empty()) {
+                    // This is an exterior polygon.
+                    _feature.beginPolygon();
+                }
                 if (_ctx.winding > 0) {
-                    line.insert(line.end(), pos, pos + length);
+                    _feature.addRing(&*pos, length);
                 } else {
-                    line.insert(line.end(), rpos - length, rpos);
+                    _ctx.ring.assign(rpos - length, rpos);
+                    _feature.addRing(_ctx.ring);
                 }
                 pos += length;
                 rpos -= length;
-                if (winding == _ctx.winding || feature.polygons.empty()) {
-                    // This is an exterior polygon.
-                    feature.polygons.emplace_back();
-                }
-                feature.polygons.back().push_back(std::move(line));
             }
             break;
         }
@@ -212,17 +231,20 @@ Feature Mvt::getFeature(ParserContext& _ctx, protobuf::message _featureIn) {
             break;
     }
 
-    return feature;
+    return true;
 }
 
 Layer Mvt::getLayer(ParserContext& _ctx, protobuf::message _layerIn) {
 
     Layer layer("");
+    _ctx.layerGeometry = layer.geometry;
 
-    _ctx.keys.clear();
-    _ctx.values.clear();
+    _ctx.properties = std::make_shared<PropertyTable>();
     _ctx.featureMsgs.clear();
 
+    auto& keys = _ctx.properties->keys;
+    auto& values = _ctx.properties->values;
+
     bool lastWasFeature = false;
     size_t numFeatures = 0;
     protobuf::message featureItr;
@@ -245,7 +267,7 @@ Layer Mvt::getLayer(ParserContext& _ctx, protobuf::message _layerIn) {
                 continue;
             }
             case LAYER_KEY: {
-                _ctx.keys.push_back(_layerIn.string());
+                keys.push_back(_layerIn.string());
                 break;
             }
             case LAYER_VALUE: {
@@ -254,28 +276,28 @@ Layer Mvt::getLayer(ParserContext& _ctx, protobuf::message _layerIn) {
                 while (valueItr.next()) {
                     switch (valueItr.tag) {
                         case 1: // string value
-                            _ctx.values.push_back(valueItr.string());
+                            values.emplace_back(valueItr.string());
                             break;
                         case 2: // float value
-                            _ctx.values.push_back(valueItr.float32());
+                            values.emplace_back(valueItr.float32());
                             break;
                         case 3: // double value
-                            _ctx.values.push_back(valueItr.float64());
+                            values.emplace_back(valueItr.float64());
                             break;
                         case 4: // int value
-                            _ctx.values.push_back(valueItr.int64());
+                            values.emplace_back(valueItr.int64());
                             break;
                         case 5: // uint value
-                            _ctx.values.push_back(valueItr.varint());
+                            values.emplace_back(valueItr.varint());
                             break;
                         case 6: // sint value
-                            _ctx.values.push_back(valueItr.int64());
+                            values.emplace_back(valueItr.int64());
                             break;
                         case 7: // bool value
-                            _ctx.values.push_back(valueItr.boolean());
+                            values.emplace_back(valueItr.boolean());
                             break;
                         default:
-                            _ctx.values.push_back(none_type{});
+                            values.emplace_back(none_type{});
                             valueItr.skip();
                             break;
                     }
@@ -295,25 +317,24 @@ Layer Mvt::getLayer(ParserContext& _ctx, protobuf::message _layerIn) {
 
     if (_ctx.featureMsgs.empty()) { return layer; }
 
-    //// Assign ordering to keys for faster sorting
-    _ctx.orderedKeys.clear();
-    _ctx.orderedKeys.reserve(_ctx.keys.size());
-    // assign key ids
-    for (int i = 0, n = _ctx.keys.size(); i < n; i++) {
-        _ctx.orderedKeys.push_back(i);
-    }
-    // sort by Property key ordering
-    std::sort(_ctx.orderedKeys.begin(), _ctx.orderedKeys.end(),
-              [&](int a, int b) {
-                  return Properties::keyComparator(_ctx.keys[a], _ctx.keys[b]);
-              });
+    // Skip layers which are not used by the scene
+    if (_ctx.filter && !_ctx.filter->beginLayer(layer.name)) { return layer; }
+
+    _ctx.properties->orderKeys();
 
     layer.features.reserve(numFeatures);
+    size_t count = 0;
     for (auto& featureItr : _ctx.featureMsgs) {
         do {
+            if (++count % CANCEL_CHECK_FEATURES == 0 && _ctx.task && _ctx.task->isCanceled()) {
+                return layer;
+            }
             auto featureMsg = featureItr.getMessage();
 
-            layer.features.push_back(getFeature(_ctx, featureMsg));
+            Feature feature(_ctx.sourceId, _ctx.layerGeometry);
+            if (getFeature(_ctx, featureMsg, feature)) {
+                layer.features.push_back(std::move(feature));
+            }
 
         } while (featureItr.next() && featureItr.tag == LAYER_FEATURE);
     }
@@ -327,11 +348,16 @@ std::shared_ptr<TileData> Mvt::parseTile(const TileTask& _task, int32_t _sourceI
 
     auto& task = static_cast<const BinaryTileTask&>(_task);
 
-    protobuf::message item(task.rawTileData->data(), task.rawTileData->size());
+    protobuf::message item(task.tileData(), task.tileDataSize());
     ParserContext ctx(_sourceId);
+    ctx.filter = _task.featureFilter();
+    ctx.task = &_task;
 
     try {
         while(item.next()) {
+            // The tile left the view, return to more useful work
+            if (_task.isCanceled()) { return {}; }
+
             if(item.tag == LAYER) {
                 tileData->layers.push_back(getLayer(ctx, item.getMessage()));
             } else {
@@ -347,6 +373,11 @@ std::shared_ptr<TileData> Mvt::parseTile(const TileTask& _task, int32_t _sourceI
     } catch(...) {
         return {};
     }
+    // A layer may be incomplete
+    if (_task.isCanceled()) { return {}; }
+
+    tileData->resolveProperties();
+
     return tileData;
 }
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "data/propertyItem.h"
 #include "data/tileData.h"
 #include "pbf/pbf.hpp"
 #include "util/variant.h"
@@ -25,14 +26,21 @@ namespace Mvt {
         ParserContext(int32_t _sourceId) : sourceId(_sourceId){}
 
         int32_t sourceId;
-        std::vector<std::string> keys;
-        std::vector<Value> values;
+        // Optional filter for skipping unused layers and features
+        FeatureFilter* filter = nullptr;
+        // Optional task whose cancellation stops parsing
+        const TileTask* task = nullptr;
+        // Keys and values of the current layer, shared by the Properties of its features
+        std::shared_ptr<PropertyTable> properties;
         std::vector<protobuf::message> featureMsgs;
+        // Geometry of the current feature, reused between features
         Geometry geometry;
-        // Map Key ID -> Tag values
-        std::vector<int> featureTags;
-        // Key IDs sorted by Property key ordering
-        std::vector<int> orderedKeys;
+        // Reversed polygon ring
+        Line ring;
+        // Geometry buffer of the current layer
+        std::shared_ptr<GeometryBuffer> layerGeometry;
+        // Key and value IDs of the current feature
+        std::vector<Properties::Tag> featureTags;
 
         int tileExtent = 0;
         int winding = 0;
@@ -44,9 +52,12 @@ namespace Mvt {
         closePath = 7
     };
 
-    Geometry getGeometry(ParserContext& _ctx, protobuf::message _geomIn);
+    // Decode _geomIn into _ctx.geometry
+    void getGeometry(ParserContext& _ctx, protobuf::message _geomIn);
 
-    Feature getFeature(ParserContext& _ctx, protobuf::message _featureIn);
+    // Returns false when the feature is rejected by _ctx.filter. Its geometry is
+    // not decoded in this case.
+    bool getFeature(ParserContext& _ctx, protobuf::message _featureIn, Feature& _feature);
 
     Layer getLayer(ParserContext& _ctx, protobuf::message _layerIn);
 
@@ -6,6 +6,8 @@
 #include "util/mapProjection.h"
 #include "log.h"
 
+#include <cstring>
+
 namespace Tangram {
 
 TopoJson::Topology TopoJson::getTopology(const JsonDocument& _document, const Transform& _proj) {
@@ -39,31 +41,29 @@ TopoJson::Topology TopoJson::getTopology(const JsonDocument& _document, const Tr
         return topo;
     }
 
-    topo.arcs.reserve(jsonArcs.Size());
+    topo.arcs.reserve(jsonArcs.Size() + 1);
 
     // Decode and transform the points that make up 'arcs'
     for (auto jsonArcsIt = jsonArcs.Begin(); jsonArcsIt != jsonArcs.End(); ++jsonArcsIt) {
 
         const auto& jsonArc = *jsonArcsIt;
 
-        if (!jsonArc.IsArray()) { // According to spec, jsonArc.Size() >= 2 should also hold
-            continue;
-        }
-
-        Line arc;
-        arc.reserve(jsonArc.Size());
+        // According to spec, jsonArc.Size() >= 2 should also hold. An invalid
+        // arc is kept empty so that the indices of the following ones match.
+        if (jsonArc.IsArray()) {
 
-        // Quantized position
-        glm::ivec2 q;
+            // Quantized position
+            glm::ivec2 q(0);
 
-        for (auto jsonCoordsIt = jsonArc.Begin(); jsonCoordsIt != jsonArc.End(); ++jsonCoordsIt) {
+            for (auto jsonCoordsIt = jsonArc.Begin(); jsonCoordsIt != jsonArc.End(); ++jsonCoordsIt) {
 
-            const auto& jsonCoords = *jsonCoordsIt;
+                const auto& jsonCoords = *jsonCoordsIt;
 
-            arc.push_back(getPoint(jsonCoords, topo, q));
+                topo.arcCoordinates.push_back(getPoint(jsonCoords, topo, q));
+            }
         }
 
-        topo.arcs.push_back(arc);
+        topo.arcs.push_back(topo.arcCoordinates.size());
     }
 
     return topo;
@@ -86,9 +86,17 @@ Point TopoJson::getPoint(const JsonValue& _coordinates, const Topology& _topolog
 Line TopoJson::getLine(const JsonValue& _arcs, const Topology& _topology) {
 
     Line line;
+    getLine(_arcs, _topology, line);
+    return line;
+
+}
+
+void TopoJson::getLine(const JsonValue& _arcs, const Topology& _topology, Line& _line) {
+
+    _line.clear();
 
     if (!_arcs.IsArray()) {
-        return line;
+        return;
     }
 
     for (auto arcIt = _arcs.Begin(); arcIt != _arcs.End(); ++arcIt) {
@@ -100,36 +108,24 @@ Line TopoJson::getLine(const JsonValue& _arcs, const Topology& _topology) {
             index = -1 - index;
         }
 
-        if (index < 0 || (std::vector<Line>::size_type)index >= _topology.arcs.size()) {
+        if (index < 0 || size_t(index) >= _topology.numArcs()) {
             continue;
         }
 
-        const auto& arc = _topology.arcs[index];
-
-        auto begin = arc.begin();
-        auto end = arc.end();
-        size_t inc = 1;
-        if (reverse) {
-            begin = arc.end() - 1;
-            end = arc.begin() - 1;
-            inc = -inc;
-        }
+        const Point* arc = _topology.arcCoordinates.data() + _topology.arcs[index];
+        size_t count = _topology.arcs[index + 1] - _topology.arcs[index];
 
         // If a line is made from multiple arcs, the first position of an arc must
         // be equal to the last position of the previous arc. So when reconstructing
         // the geometry, the first position of each arc except the first may be dropped
-        if (arcIt != _arcs.Begin()) {
-            begin = begin + inc;
-        }
+        size_t first = arcIt != _arcs.Begin() ? 1 : 0;
 
-        for (auto pointIt = begin; pointIt != end; pointIt += inc) {
-            line.push_back(*pointIt);
+        for (size_t i = first; i < count; i++) {
+            _line.push_back(reverse ? arc[count - 1 - i] : arc[i]);
         }
 
     }
 
-    return line;
-
 }
 
 Polygon TopoJson::getPolygon(const JsonValue& _arcSets, const Topology& _topology) {
@@ -151,74 +147,96 @@ Polygon TopoJson::getPolygon(const JsonValue& _arcSets, const Topology& _topolog
 
 }
 
-Feature TopoJson::getFeature(const JsonValue& _geometry, const Topology& _topology, int32_t _source) {
+static void addPolygon(const JsonValue& _arcSets, const TopoJson::Topology& _topology,
+                       Line& _ring, Feature& _feature) {
+
+    _feature.beginPolygon();
+
+    if (!_arcSets.IsArray()) {
+        return;
+    }
+
+    for (auto arcSetIt = _arcSets.Begin(); arcSetIt != _arcSets.End(); ++arcSetIt) {
+
+        TopoJson::getLine(*arcSetIt, _topology, _ring);
+        _feature.addRing(_ring);
+
+    }
+
+}
+
+Feature TopoJson::getFeature(const JsonValue& _geometry, const Topology& _topology, int32_t _source,
+                             std::shared_ptr<GeometryBuffer> _buffer, Line& _line,
+                             GeoJson::PropertyPool& _pool) {
 
     static const JsonValue keyProperties("properties");
     static const JsonValue keyType("type");
     static const JsonValue keyCoordinates("coordinates");
     static const JsonValue keyArcs("arcs");
 
-    Feature feature;
+    Feature feature(_source, std::move(_buffer));
 
     auto propertiesIt = _geometry.FindMember(keyProperties);
     if (propertiesIt != _geometry.MemberEnd() && propertiesIt->value.IsObject()) {
-        feature.props = GeoJson::getProperties(propertiesIt->value, _source);
+        feature.props = GeoJson::getProperties(propertiesIt->value, _source, _pool);
     }
 
-    std::string type;
+    const char* type = "";
     auto typeIt = _geometry.FindMember(keyType);
     if (typeIt != _geometry.MemberEnd() && typeIt->value.IsString()) {
         type = typeIt->value.GetString();
     }
 
-    if (type == "Point") {
+    if (std::strcmp(type, "Point") == 0) {
         feature.geometryType = GeometryType::points;
         auto coordinatesIt = _geometry.FindMember(keyCoordinates);
         if (coordinatesIt != _geometry.MemberEnd()) {
-            glm::ivec2 cursor;
-            feature.points.push_back(getPoint(coordinatesIt->value, _topology, cursor));
+            glm::ivec2 cursor(0);
+            feature.addPoint(getPoint(coordinatesIt->value, _topology, cursor));
         }
-    } else if (type == "MultiPoint") {
+    } else if (std::strcmp(type, "MultiPoint") == 0) {
         feature.geometryType = GeometryType::points;
         auto coordinatesIt = _geometry.FindMember(keyCoordinates);
         if (coordinatesIt != _geometry.MemberEnd() && coordinatesIt->value.IsArray()) {
             auto& coordinates = coordinatesIt->value;
             for (auto point = coordinates.Begin(); point != coordinates.End(); ++point) {
-                glm::ivec2 cursor;
-                feature.points.push_back(getPoint(*point, _topology, cursor));
+                glm::ivec2 cursor(0);
+                feature.addPoint(getPoint(*point, _topology, cursor));
             }
         }
-    } else if (type == "LineString") {
+    } else if (std::strcmp(type, "LineString") == 0) {
         feature.geometryType = GeometryType::lines;
         auto arcsIt = _geometry.FindMember(keyArcs);
         if (arcsIt != _geometry.MemberEnd()) {
-            feature.lines.push_back(getLine(arcsIt->value, _topology));
+            getLine(arcsIt->value, _topology, _line);
+            feature.addLine(_line);
         }
-    } else if (type == "MultiLineString") {
+    } else if (std::strcmp(type, "MultiLineString") == 0) {
         feature.geometryType = GeometryType::lines;
         auto arcsIt = _geometry.FindMember(keyArcs);
         if (arcsIt != _geometry.MemberEnd() && arcsIt->value.IsArray()) {
             auto& arcs = arcsIt->value;
             for (auto arcList = arcs.Begin(); arcList != arcs.End(); ++arcList) {
-                feature.lines.push_back(getLine(*arcList, _topology));
+                getLine(*arcList, _topology, _line);
+                feature.addLine(_line);
             }
         }
-    } else if (type == "Polygon") {
+    } else if (std::strcmp(type, "Polygon") == 0) {
         feature.geometryType = GeometryType::polygons;
         auto arcsIt = _geometry.FindMember(keyArcs);
         if (arcsIt != _geometry.MemberEnd()) {
-            feature.polygons.push_back(getPolygon(arcsIt->value, _topology));
+            addPolygon(arcsIt->value, _topology, _line, feature);
         }
-    } else if (type == "MultiPolygon") {
+    } else if (std::strcmp(type, "MultiPolygon") == 0) {
         feature.geometryType = GeometryType::polygons;
         auto arcsIt = _geometry.FindMember(keyArcs);
         if (arcsIt != _geometry.MemberEnd() && arcsIt->value.IsArray()) {
             auto& arcs = arcsIt->value;
             for (auto arcList = arcs.Begin(); arcList != arcs.End(); ++arcList) {
-                feature.polygons.push_back(getPolygon(*arcList, _topology));
+                addPolygon(*arcList, _topology, _line, feature);
             }
         }
-    } else if (type == "GeometryCollection") {
+    } else if (std::strcmp(type, "GeometryCollection") == 0) {
         // Not handled
     }
 
@@ -235,9 +253,15 @@ Layer TopoJson::getLayer(JsonValue::MemberIterator& _objectIt, const Topology& _
     if (type != object.MemberEnd() && strcmp("GeometryCollection", type->value.GetString()) == 0) {
         auto geometries = object.FindMember("geometries");
         if (geometries != object.MemberEnd() && geometries->value.IsArray()) {
+            // Reused for each line and ring of the features
+            Line line;
+            GeoJson::PropertyPool pool;
+
+            layer.features.reserve(geometries->value.Size());
             for (auto it = geometries->value.Begin(); it != geometries->value.End(); ++it) {
-                layer.features.push_back(getFeature(*it, _topology, _source));
+                layer.features.push_back(getFeature(*it, _topology, _source, layer.geometry, line, pool));
             }
+            pool.finish();
         }
     }
 
@@ -254,7 +278,8 @@ std::shared_ptr<TileData> TopoJson::parseTile(const TileTask& _task, int32_t _so
     // Parse data into a JSON document
     const char* error;
     size_t offset;
-    auto document = JsonParseBytes(task.rawTileData->data(), task.rawTileData->size(), &error, &offset);
+    std::vector<char> buffer;
+    auto document = JsonParseInsitu(task.tileData(), task.tileDataSize(), buffer, &error, &offset);
 
     if (error) {
         LOGE("Json parsing failed on tile [%s]: %s (%u)", task.tileId().toString().c_str(), error, offset);
@@ -284,6 +309,7 @@ std::shared_ptr<TileData> TopoJson::parseTile(const TileTask& _task, int32_t _so
     for (auto layer = objects.MemberBegin(); layer != objects.MemberEnd(); ++layer) {
         tileData->layers.push_back(TopoJson::getLayer(layer, topology, _source));
     }
+    tileData->resolveProperties();
 
     // Discard JSON object and return TileData
     return tileData;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "data/formats/geoJson.h"
 #include "data/tileData.h"
 #include "util/json.h"
 #include "util/types.h"
@@ -19,8 +20,13 @@ using Transform = std::function<Point(LngLat _lngLat)>;
 struct Topology {
     glm::dvec2 scale = { 1., 1. };
     glm::dvec2 translate = { 0., 0. };
-    std::vector<Line> arcs;
+    // Arcs decoded once for all features that reference them,
+    // arc i is [arcs[i], arcs[i+1]) of arcCoordinates
+    std::vector<Point> arcCoordinates;
+    std::vector<uint32_t> arcs = { 0 };
     Transform proj;
+
+    size_t numArcs() const { return arcs.size() - 1; }
 };
 
 Topology getTopology(const JsonDocument& _document, const Transform& _proj);
@@ -29,9 +35,16 @@ Point getPoint(const JsonValue& _coordinates, const Topology& _topology, glm::iv
 
 Line getLine(const JsonValue& _arcs, const Topology& _topology);
 
+// Read the points of a line into _line
+void getLine(const JsonValue& _arcs, const Topology& _topology, Line& _line);
+
 Polygon getPolygon(const JsonValue& _arcs, const Topology& _topology);
 
-Feature getFeature(const JsonValue& _geometry, const Topology& _topology, int32_t _sourceId);
+// Add the geometry of the feature to _buffer, the GeometryBuffer of the Layer. Each
+// line and ring is read into _line before it is copied there.
+Feature getFeature(const JsonValue& _geometry, const Topology& _topology, int32_t _sourceId,
+                   std::shared_ptr<GeometryBuffer> _buffer, Line& _line,
+                   GeoJson::PropertyPool& _pool);
 
 Layer getLayer(JsonValue::MemberIterator& _object, const Topology& _topology, int32_t _sourceId);
 
@@ -6,7 +6,11 @@
 #include "platform.h"
 #include "util/url.h"
 
+#include <algorithm>
+#include <chrono>
+
 #include <SQLiteCpp/Database.h>
+#include <SQLiteCpp/Transaction.h>
 #include "hash-library/md5.cpp"
 
 
@@ -98,38 +102,106 @@ CREATE VIEW IF NOT EXISTS grid_data AS
     JOIN keymap ON grid_key.key_name = keymap.key_name;
 COMMIT;)SQL_ESC";
 
-struct MBTilesQueries {
-    // SELECT statement from tiles view
-    SQLite::Statement getTileData;
+/**
+ * Validators of the network responses of cached tiles. Not part of the
+ * MBTiles spec; created in cache mode, also for existing caches.
+ */
+static const char* VALIDATORS_SCHEMA = R"SQL_ESC(BEGIN;
+CREATE TABLE IF NOT EXISTS tile_validators (
+    zoom_level INTEGER,
+    tile_column INTEGER,
+    tile_row INTEGER,
+    etag TEXT,
+    last_modified TEXT,
+    expires INTEGER
+);
+CREATE UNIQUE INDEX IF NOT EXISTS tile_validators_index ON tile_validators (zoom_level, tile_column, tile_row);
+COMMIT;)SQL_ESC";
 
+static int64_t unixTime() {
+    using namespace std::chrono;
+    return duration_cast<seconds>(system_clock::now().time_since_epoch()).count();
+}
+
+struct MBTilesQueries {
     // REPLACE INTO statement in map table
     SQLite::Statement putMap;
 
-    // REPLACE INTO statement in images table
+    // INSERT statement in images table. Images are keyed by the hash of their
+    // data, so an image that is already stored is not written again.
     SQLite::Statement putImage;
 
-    MBTilesQueries(SQLite::Database& _db, bool _cache)
-        : getTileData(_db, "SELECT tile_data FROM tiles WHERE zoom_level = ? AND tile_column = ? AND tile_row = ?;"),
-          putMap(_db, _cache ? "REPLACE INTO map (zoom_level, tile_column, tile_row, tile_id) VALUES (?, ?, ?, ?);" : ";" ),
-          putImage(_db, _cache ? "REPLACE INTO images (tile_id, tile_data) VALUES (?, ?);" : ";") {}
+    // REPLACE INTO statement in tile_validators table
+    SQLite::Statement putValidators;
+
+    // SELECT statement from map and images tables
+    SQLite::Statement hasTile;
+
+    MBTilesQueries(SQLite::Database& _db)
+        : putMap(_db, "REPLACE INTO map (zoom_level, tile_column, tile_row, tile_id) VALUES (?, ?, ?, ?);"),
+          putImage(_db, "INSERT OR IGNORE INTO images (tile_id, tile_data) VALUES (?, ?);"),
+          putValidators(_db, "REPLACE INTO tile_validators (zoom_level, tile_column, tile_row, etag, last_modified, expires)"
+                        " VALUES (?, ?, ?, ?, ?, ?);"),
+          hasTile(_db, "SELECT 1 FROM map JOIN images ON images.tile_id = map.tile_id"
+                  " WHERE zoom_level = ? AND tile_column = ? AND tile_row = ?;") {}
+
+};
+
+struct MBTilesReader {
+    SQLite::Database db;
+
+    // SELECT statement from tiles view
+    SQLite::Statement getTileData;
+
+    // SELECT statement from tile_validators table, only in cache mode
+    std::unique_ptr<SQLite::Statement> getValidators;
 
+    MBTilesReader(const std::string& _path, const char* _vfs, bool _cacheMode)
+        : db(_path, SQLite::OPEN_READONLY, 0, _vfs),
+          getTileData(db, "SELECT tile_data FROM tiles WHERE zoom_level = ? AND tile_column = ? AND tile_row = ?;") {
+        if (_cacheMode) {
+            getValidators = std::make_unique<SQLite::Statement>(db, "SELECT etag, last_modified, expires FROM tile_validators"
+                                                                " WHERE zoom_level = ? AND tile_column = ? AND tile_row = ?;");
+        }
+    }
 };
 
 MBTilesDataSource::MBTilesDataSource(Platform& _platform, std::string _name, std::string _path,
-                                     std::string _mime, bool _cache, bool _offlineFallback)
+                                     std::string _mime, bool _cache, bool _offlineFallback,
+                                     MBTilesOptions _options)
     : m_name(_name),
       m_path(_path),
       m_mime(_mime),
       m_cacheMode(_cache),
       m_offlineMode(_offlineFallback),
+      m_options(_options),
       m_platform(_platform) {
 
-    m_worker = std::make_unique<AsyncWorker>();
+    m_options.connections = std::max<size_t>(m_options.connections, 1);
+    m_options.writeBatchSize = std::max<size_t>(m_options.writeBatchSize, 1);
+
+    m_writer = std::make_unique<AsyncWorker>(ThreadPool::shared(), ThreadPool::Priority::io);
+    // Cached tiles that are still queued are written before the database is closed
+    m_writer->waitForCompletion();
 
     openMBTiles();
 }
 
 MBTilesDataSource::~MBTilesDataSource() {
+    {
+        // Wait until no pool job uses a reader connection
+        std::unique_lock<std::mutex> lock(m_readMutex);
+        m_reading = false;
+        m_readQueue.clear();
+        m_readCondition.wait(lock, [&]{ return m_idleReaders.size() == m_readers.size(); });
+    }
+    {
+        // Write the tiles of the last, incomplete batch
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        scheduleFlush();
+    }
+    // Waits for the writes, while the write queue is still alive
+    m_writer.reset();
 }
 
 bool MBTilesDataSource::loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) {
@@ -147,13 +219,31 @@ bool MBTilesDataSource::loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb
 
     if (_task->rawSource == this->level) {
 
-        m_worker->enqueue([this, _task, _cb](){
+        enqueueRead([this, _task, _cb](MBTilesReader& _reader){
             TileID tileId = _task->tileId();
 
             auto& task = static_cast<BinaryTileTask&>(*_task);
             task.rawTileData = std::make_shared<std::vector<char>>();
 
-            getTileData(tileId, *task.rawTileData);
+            getTileData(_reader, tileId, *task.rawTileData);
+
+            int64_t expires = -1;
+            if (task.hasData() && getTileValidators(_reader, tileId, task.validators, expires) && expires >= 0) {
+                int64_t maxAge = expires - unixTime();
+                if (maxAge < 0 && next) {
+                    // Revalidate the expired tile with the next source
+                    LOGD("expired tile: %s", tileId.toString().c_str());
+                    auto staleData = std::move(task.rawTileData);
+                    _task->rawSource = next->level;
+                    if (!loadNextSource(_task, _cb, staleData)) {
+                        task.rawTileData = staleData;
+                        _cb.func(_task);
+                    }
+                    return;
+                }
+                // Memory caches keep the tile until it expires here
+                task.maxAge = std::max<int64_t>(maxAge, 0);
+            }
 
             if (task.hasData()) {
                 LOGW("loaded tile: %s, %d", tileId.toString().c_str(), task.rawTileData->size());
@@ -181,7 +271,90 @@ bool MBTilesDataSource::loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb
     return loadNextSource(_task, _cb);
 }
 
-bool MBTilesDataSource::loadNextSource(std::shared_ptr<TileTask> _task, TileTaskCb _cb) {
+void MBTilesDataSource::enqueueRead(ReadJob _job) {
+    std::lock_guard<std::mutex> lock(m_readMutex);
+    if (!m_reading) { return; }
+
+    m_readQueue.push_back(std::move(_job));
+
+    // Start another drain job while there are free connections
+    if (!m_idleReaders.empty()) {
+        MBTilesReader* reader = m_idleReaders.back();
+        m_idleReaders.pop_back();
+        ThreadPool::shared().enqueue(ThreadPool::Priority::io, [this, reader]{ drainReads(*reader); });
+    }
+}
+
+void MBTilesDataSource::drainReads(MBTilesReader& _reader) {
+    while (true) {
+        ReadJob job;
+        {
+            std::lock_guard<std::mutex> lock(m_readMutex);
+            if (m_readQueue.empty() || !m_reading) {
+                m_idleReaders.push_back(&_reader);
+                // NB: 'this' may be destroyed right after the lock is released
+                m_readCondition.notify_all();
+                return;
+            }
+            job = std::move(m_readQueue.front());
+            m_readQueue.pop_front();
+        }
+        job(_reader);
+    }
+}
+
+void MBTilesDataSource::enqueueWrite(const BinaryTileTask& _task, std::shared_ptr<std::vector<char>> _data) {
+    int64_t expires = _task.maxAge < 0 ? -1 : unixTime() + _task.maxAge;
+
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+
+    auto now = std::chrono::steady_clock::now();
+    if (m_pendingWrites.empty()) { m_pendingSince = now; }
+
+    m_pendingWrites.push_back({ _task.tileId(), std::move(_data), _task.validators, expires });
+
+    if (m_pendingWrites.size() >= m_options.writeBatchSize ||
+        now - m_pendingSince >= m_options.writeInterval) {
+        scheduleFlush();
+    }
+}
+
+void MBTilesDataSource::scheduleFlush() {
+    // Tiles arriving before the flush runs are written with this batch
+    if (!m_flushScheduled && !m_pendingWrites.empty()) {
+        m_flushScheduled = true;
+        m_writer->enqueue([this](){ flushWrites(); });
+    }
+}
+
+void MBTilesDataSource::flushWrites() {
+    std::vector<PendingWrite> writes;
+    {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        writes.swap(m_pendingWrites);
+        m_flushScheduled = false;
+    }
+
+    std::unordered_set<std::string> storedImages;
+
+    for (size_t start = 0; start < writes.size(); start += m_options.writeBatchSize) {
+        size_t end = std::min(start + m_options.writeBatchSize, writes.size());
+        storedImages.clear();
+        try {
+            SQLite::Transaction transaction(*m_db);
+            for (size_t i = start; i < end; i++) {
+                storeTileData(writes[i], storedImages);
+            }
+            transaction.commit();
+            LOG("MBTiles stored %d tiles, %d images", int(end - start), int(storedImages.size()));
+        } catch (std::exception& e) {
+            LOGE("MBTiles SQLite transaction failed: %s", e.what());
+        }
+    }
+}
+
+bool MBTilesDataSource::loadNextSource(std::shared_ptr<TileTask> _task, TileTaskCb _cb,
+                                       std::shared_ptr<std::vector<char>> _staleData) {
     if (!next) { return false; }
 
     if (!m_db) {
@@ -189,19 +362,25 @@ bool MBTilesDataSource::loadNextSource(std::shared_ptr<TileTask> _task, TileTask
     }
 
     // Intercept TileTaskCb to store result from next source.
-    TileTaskCb cb{[this, _cb](std::shared_ptr<TileTask> _task) {
+    TileTaskCb cb{[this, _cb, _staleData](std::shared_ptr<TileTask> _task) {
 
-        if (_task->hasData()) {
+        auto& task = static_cast<BinaryTileTask&>(*_task);
 
-            if (m_cacheMode) {
-                m_worker->enqueue([this, _task](){
+        if (!_task->hasData() && _staleData) {
+            // Keep the stored tile until it expires again when it was
+            // revalidated, otherwise use it while the next source fails
+            task.rawTileData = _staleData;
+            if (task.notModified && m_cacheMode) {
+                enqueueWrite(task, nullptr);
+            }
 
-                        auto& task = static_cast<BinaryTileTask&>(*_task);
+            _cb.func(_task);
 
-                        LOGW("store tile: %s, %d", _task->tileId().toString().c_str(), task.hasData());
+        } else if (_task->hasData()) {
 
-                        storeTileData(_task->tileId(), *task.rawTileData);
-                    });
+            // Tiles held as views of the next source are not copied into the database
+            if (m_cacheMode && task.rawTileData) {
+                enqueueWrite(task, task.rawTileData);
             }
 
             _cb.func(_task);
@@ -209,12 +388,12 @@ bool MBTilesDataSource::loadNextSource(std::shared_ptr<TileTask> _task, TileTask
         } else if (m_offlineMode) {
             LOGW("try fallback tile: %s, %d", _task->tileId().toString().c_str());
 
-            m_worker->enqueue([this, _task, _cb](){
+            enqueueRead([this, _task, _cb](MBTilesReader& _reader){
 
                 auto& task = static_cast<BinaryTileTask&>(*_task);
                 task.rawTileData = std::make_shared<std::vector<char>>();
 
-                getTileData(_task->tileId(), *task.rawTileData);
+                getTileData(_reader, _task->tileId(), *task.rawTileData);
 
                 LOGW("loaded tile: %s, %d", _task->tileId().toString().c_str(), task.rawTileData->size());
 
@@ -232,6 +411,9 @@ bool MBTilesDataSource::loadNextSource(std::shared_ptr<TileTask> _task, TileTask
 
 void MBTilesDataSource::openMBTiles() {
 
+    std::string path;
+    const char* vfs = "";
+
     try {
         auto mode = SQLite::OPEN_READONLY | SQLite::OPEN_FULLMUTEX;
         if (m_cacheMode) {
@@ -241,8 +423,7 @@ void MBTilesDataSource::openMBTiles() {
         }
 
         auto url = Url(m_path);
-        auto path = url.path();
-        const char* vfs = "";
+        path = url.path();
         if (url.scheme() == "asset") {
             vfs = "ndk-asset";
             path.erase(path.begin()); // Remove leading '/'.
@@ -263,7 +444,6 @@ void MBTilesDataSource::openMBTiles() {
             LOGE("Cannot cache to 'externally created' MBTiles database");
             // Run in non-caching mode
             m_cacheMode = false;
-            return;
         }
     } else if (m_cacheMode) {
 
@@ -287,10 +467,31 @@ void MBTilesDataSource::openMBTiles() {
         return;
     }
 
+    if (m_cacheMode) {
+        try {
+            // Let reader connections see committed tiles while the next batch is written.
+            // In WAL mode a commit does not need to wait for a sync of the database.
+            m_db->exec("PRAGMA journal_mode=WAL;");
+            m_db->exec("PRAGMA synchronous=NORMAL;");
+            m_db->exec(VALIDATORS_SCHEMA);
+            m_queries = std::make_unique<MBTilesQueries>(*m_db);
+        } catch (std::exception& e) {
+            LOGE("Unable to initialize queries: %s", e.what());
+            m_db.reset();
+            return;
+        }
+    }
+
     try {
-        m_queries = std::make_unique<MBTilesQueries>(*m_db, m_cacheMode);
+        for (size_t i = 0; i < m_options.connections; i++) {
+            m_readers.push_back(std::make_unique<MBTilesReader>(path, vfs, m_cacheMode));
+            m_idleReaders.push_back(m_readers.back().get());
+        }
     } catch (std::exception& e) {
-        LOGE("Unable to initialize queries: %s", e.what());
+        LOGE("Unable to open SQLite database for reading: %s - %s", m_path.c_str(), e.what());
+        m_idleReaders.clear();
+        m_readers.clear();
+        m_queries.reset();
         m_db.reset();
         return;
     }
@@ -422,9 +623,9 @@ void MBTilesDataSource::initSchema(SQLite::Database& db, std::string _name, std:
     }
 }
 
-bool MBTilesDataSource::getTileData(const TileID& _tileId, std::vector<char>& _data) {
+bool MBTilesDataSource::getTileData(MBTilesReader& _reader, const TileID& _tileId, std::vector<char>& _data) {
 
-    auto& stmt = m_queries->getTileData;
+    auto& stmt = _reader.getTileData;
     try {
         // Google TMS to WMTS
         // https://github.com/mapbox/node-mbtiles/blob/
@@ -471,12 +672,92 @@ bool MBTilesDataSource::getTileData(const TileID& _tileId, std::vector<char>& _d
     return false;
 }
 
-void MBTilesDataSource::storeTileData(const TileID& _tileId, const std::vector<char>& _data) {
-    int z = _tileId.z;
-    int y = (1 << z) - 1 - _tileId.y;
+bool MBTilesDataSource::hasTileData(const TileID& _tileId) {
+    if (!m_queries) { return false; }
+
+    auto& stmt = m_queries->hasTile;
+    bool found = false;
+    try {
+        int z = _tileId.z;
+        int y = (1 << z) - 1 - _tileId.y;
+
+        stmt.bind(1, z);
+        stmt.bind(2, _tileId.x);
+        stmt.bind(3, y);
+
+        found = stmt.executeStep();
+    } catch (std::exception& e) {
+        LOGE("MBTiles SQLite has tile statement failed: %s", e.what());
+    }
+    try {
+        stmt.reset();
+    } catch(...) {}
+
+    return found;
+}
+
+bool MBTilesDataSource::getTileValidators(MBTilesReader& _reader, const TileID& _tileId,
+                                          UrlValidators& _validators, int64_t& _expires) {
+    if (!_reader.getValidators) { return false; }
+
+    auto& stmt = *_reader.getValidators;
+    bool found = false;
+    try {
+        int z = _tileId.z;
+        int y = (1 << z) - 1 - _tileId.y;
+
+        stmt.bind(1, z);
+        stmt.bind(2, _tileId.x);
+        stmt.bind(3, y);
+
+        if (stmt.executeStep()) {
+            std::string etag = stmt.getColumn(0);
+            std::string lastModified = stmt.getColumn(1);
+            _validators.etag = etag;
+            _validators.lastModified = lastModified;
+            _expires = stmt.getColumn(2).isNull() ? -1 : stmt.getColumn(2).getInt64();
+            found = true;
+        }
+    } catch (std::exception& e) {
+        LOGE("MBTiles SQLite get validators statement failed: %s", e.what());
+    }
+    try {
+        stmt.reset();
+    } catch(...) {}
+
+    return found;
+}
+
+void MBTilesDataSource::storeTileData(const PendingWrite& _write, std::unordered_set<std::string>& _storedImages) {
+    const TileID& tileId = _write.tileId;
+    int z = tileId.z;
+    int y = (1 << z) - 1 - tileId.y;
 
-    const char* data = _data.data();
-    size_t size = _data.size();
+    try {
+        auto& stmt = m_queries->putValidators;
+        stmt.bind(1, z);
+        stmt.bind(2, tileId.x);
+        stmt.bind(3, y);
+        stmt.bind(4, _write.validators.etag);
+        stmt.bind(5, _write.validators.lastModified);
+        if (_write.expires < 0) {
+            stmt.bind(6);
+        } else {
+            stmt.bind(6, static_cast<long long>(_write.expires));
+        }
+        stmt.exec();
+
+        stmt.reset();
+
+    } catch (std::exception& e) {
+        LOGE("MBTiles SQLite put validators statement failed: %s", e.what());
+    }
+
+    // Only the validators of a revalidated tile changed
+    if (!_write.data) { return; }
+
+    const char* data = _write.data->data();
+    size_t size = _write.data->size();
 
     /**
      * We create an MD5 of the raw tile data. The MD5 functions as a hash
@@ -489,7 +770,7 @@ void MBTilesDataSource::storeTileData(const TileID& _tileId, const std::vector<c
     try {
         auto& stmt = m_queries->putMap;
         stmt.bind(1, z);
-        stmt.bind(2, _tileId.x);
+        stmt.bind(2, tileId.x);
         stmt.bind(3, y);
         stmt.bind(4, md5id);
         stmt.exec();
@@ -500,6 +781,9 @@ void MBTilesDataSource::storeTileData(const TileID& _tileId, const std::vector<c
         LOGE("MBTiles SQLite put map statement failed: %s", e.what());
     }
 
+    // Tiles with the same data often come in runs, e.g. water or empty tiles
+    if (!_storedImages.insert(md5id).second) { return; }
+
     try {
         auto& stmt = m_queries->putImage;
         stmt.bind(1, md5id);
@@ -2,6 +2,13 @@
 
 #include "data/tileSource.h"
 
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <unordered_set>
+
 namespace SQLite {
 class Database;
 }
@@ -12,13 +19,24 @@ namespace Tangram {
 class Platform;
 
 struct MBTilesQueries;
+struct MBTilesReader;
 class AsyncWorker;
 
+struct MBTilesOptions {
+    // Number of read-only connections used to read tiles concurrently
+    size_t connections = 4;
+    // Maximum number of cached tiles written in one transaction
+    size_t writeBatchSize = 32;
+    // Cached tiles are written once writeBatchSize tiles are queued or the
+    // oldest queued tile has waited this long (checked when a tile is queued)
+    std::chrono::milliseconds writeInterval{2000};
+};
+
 class MBTilesDataSource : public TileSource::DataSource {
 public:
 
     MBTilesDataSource(Platform& _platform, std::string _name, std::string _path, std::string _mime,
-                      bool _cache = false, bool _offlineFallback = false);
+                      bool _cache = false, bool _offlineFallback = false, MBTilesOptions _options = MBTilesOptions());
 
     ~MBTilesDataSource();
 
@@ -26,10 +44,45 @@ public:
 
     void clear() override {}
 
+    /* Whether tiles from the next source are stored, i.e. the database is open in cache mode */
+    bool canStoreTiles() const { return bool(m_queries); }
+
+    /* Whether the data of a tile is stored in the map and images tables. Uses
+     * the connection of the writes, so it is called from one thread at a time. */
+    bool hasTileData(const TileID& _tileId);
+
 private:
-    bool getTileData(const TileID& _tileId, std::vector<char>& _data);
-    void storeTileData(const TileID& _tileId, const std::vector<char>& _data);
-    bool loadNextSource(std::shared_ptr<TileTask> _task, TileTaskCb _cb);
+    using ReadJob = std::function<void(MBTilesReader&)>;
+
+    // A cached tile and the validators of its network response. Without
+    // data only the validators and the expiry of a stored tile are updated.
+    struct PendingWrite {
+        TileID tileId;
+        std::shared_ptr<std::vector<char>> data;
+        UrlValidators validators;
+        // Unix time in seconds after which the tile is revalidated, -1 for never
+        int64_t expires;
+    };
+
+    bool getTileData(MBTilesReader& _reader, const TileID& _tileId, std::vector<char>& _data);
+    // Returns false when no validators are stored for the tile
+    bool getTileValidators(MBTilesReader& _reader, const TileID& _tileId,
+                           UrlValidators& _validators, int64_t& _expires);
+    // _storedImages holds the hashes of images written in the current transaction
+    void storeTileData(const PendingWrite& _write, std::unordered_set<std::string>& _storedImages);
+    // _staleData is an expired cached tile, used when the next source
+    // confirms that it is still valid or fails to load the tile
+    bool loadNextSource(std::shared_ptr<TileTask> _task, TileTaskCb _cb,
+                        std::shared_ptr<std::vector<char>> _staleData = nullptr);
+
+    // Run _job on the ThreadPool with the next free reader connection
+    void enqueueRead(ReadJob _job);
+    void drainReads(MBTilesReader& _reader);
+
+    // Queue the data and validators of _task to be written with the next batch of cached tiles
+    void enqueueWrite(const BinaryTileTask& _task, std::shared_ptr<std::vector<char>> _data);
+    void scheduleFlush();
+    void flushWrites();
 
     void openMBTiles();
     bool testSchema(SQLite::Database& db);
@@ -47,10 +100,30 @@ private:
     // Offline fallback: Try next source (download) first, then fall back to mbtiles
     bool m_offlineMode;
 
-    // Pointer to SQLite DB of MBTiles store
+    MBTilesOptions m_options;
+
+    // Pointer to SQLite DB of MBTiles store, used to set up the schema and
+    // to write cached tiles
     std::unique_ptr<SQLite::Database> m_db;
     std::unique_ptr<MBTilesQueries> m_queries;
-    std::unique_ptr<AsyncWorker> m_worker;
+
+    // Runs the batched writes one at a time
+    std::unique_ptr<AsyncWorker> m_writer;
+
+    std::mutex m_writeMutex;
+    std::vector<PendingWrite> m_pendingWrites;
+    std::chrono::steady_clock::time_point m_pendingSince;
+    bool m_flushScheduled = false;
+
+    // Read-only connections. Each one is used by at most one pool job at a
+    // time, so reads run concurrently without locking.
+    std::vector<std::unique_ptr<MBTilesReader>> m_readers;
+
+    std::mutex m_readMutex;
+    std::condition_variable m_readCondition;
+    std::deque<ReadJob> m_readQueue;
+    std::vector<MBTilesReader*> m_idleReaders;
+    bool m_reading = true;
 
     // Platform reference
     Platform& m_platform;
@@ -2,8 +2,13 @@
 
 #include "tile/tileHash.h"
 #include "tile/tileID.h"
+#include "util/threadPool.h"
+#include "util/zlibHelper.h"
 #include "log.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <list>
 #include <mutex>
 #include <unordered_map>
@@ -15,17 +20,30 @@ struct RawCache {
     // Used to ensure safe access from async loading threads
     std::mutex m_mutex;
 
+    using Clock = std::chrono::steady_clock;
+
     // LRU in-memory cache for raw tile data
-    using CacheEntry = std::pair<TileID, std::shared_ptr<std::vector<char>>>;
+    struct CacheEntry {
+        TileID id;
+        std::shared_ptr<std::vector<char>> data;
+        bool compressed;
+        // Validators to revalidate the data once it expired
+        UrlValidators validators;
+        Clock::time_point expires;
+    };
     using CacheList = std::list<CacheEntry>;
     using CacheMap = std::unordered_map<TileID, typename CacheList::iterator>;
 
     CacheMap m_cacheMap;
     CacheList m_cacheList;
     int m_usage = 0;
-    int m_maxUsage = 0;
+    // Set by the sources of all Maps that share the cache
+    std::atomic<int> m_maxUsage{0};
 
-    bool get(BinaryTileTask& _task) {
+    /* Sets _data to the cached data of the task. Returns false when there is
+     * no data or when it has expired; the task then has the validators of the
+     * expired data. */
+    bool get(BinaryTileTask& _task, std::shared_ptr<std::vector<char>>& _data, bool& _compressed) {
 
         if (m_maxUsage <= 0) { return false; }
 
@@ -37,21 +55,54 @@ struct RawCache {
         if (it != m_cacheMap.end()) {
             // Move cached entry to start of list
             m_cacheList.splice(m_cacheList.begin(), m_cacheList, it->second);
-            _task.rawTileData = m_cacheList.front().second;
+            auto& entry = m_cacheList.front();
+            _data = entry.data;
+            _compressed = entry.compressed;
 
+            if (entry.expires <= Clock::now()) {
+                _task.validators = entry.validators;
+                return false;
+            }
             return true;
         }
 
         return false;
     }
-    void put(const TileID& tileID, std::shared_ptr<std::vector<char>> rawDataRef) {
+    static Clock::time_point expires(int64_t _maxAge) {
+        // Data without max-age does not expire
+        return _maxAge < 0 ? Clock::time_point::max() : Clock::now() + std::chrono::seconds(_maxAge);
+    }
+
+    // Set new validators and expiry of revalidated data. Returns false when
+    // the entry has been evicted.
+    bool refresh(const TileID& tileID, const UrlValidators& _validators, int64_t _maxAge) {
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        TileID id(tileID.x, tileID.y, tileID.z);
+
+        auto it = m_cacheMap.find(id);
+        if (it == m_cacheMap.end()) { return false; }
+
+        it->second->validators = _validators;
+        it->second->expires = expires(_maxAge);
+        return true;
+    }
+
+    void put(const TileID& tileID, std::shared_ptr<std::vector<char>> rawDataRef, bool _compressed,
+             const UrlValidators& _validators, int64_t _maxAge) {
 
         if (m_maxUsage <= 0) { return; }
 
         std::lock_guard<std::mutex> lock(m_mutex);
         TileID id(tileID.x, tileID.y, tileID.z);
 
-        m_cacheList.push_front({id, rawDataRef});
+        auto it = m_cacheMap.find(id);
+        if (it != m_cacheMap.end()) {
+            m_usage -= it->second->data->size();
+            m_cacheList.erase(it->second);
+        }
+
+        m_cacheList.push_front({id, rawDataRef, _compressed, _validators, expires(_maxAge)});
         m_cacheMap[id] = m_cacheList.begin();
 
         m_usage += rawDataRef->size();
@@ -67,9 +118,9 @@ struct RawCache {
             //        double(m_cacheUsage) / (1024*1024));
 
             auto& entry = m_cacheList.back();
-            m_usage -= entry.second->size();
+            m_usage -= entry.data->size();
 
-            m_cacheMap.erase(entry.first);
+            m_cacheMap.erase(entry.id);
             m_cacheList.pop_back();
         }
     }
@@ -80,11 +131,49 @@ struct RawCache {
         m_cacheList.clear();
         m_usage = 0;
     }
+
+    size_t usage() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_usage;
+    }
+
+    // Append the entries of _other that fit, most recently used first. The
+    // data is shared with _other.
+    void copy(RawCache& _other) {
+        CacheList entries;
+        {
+            std::lock_guard<std::mutex> lock(_other.m_mutex);
+            entries = _other.m_cacheList;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& entry : entries) {
+            if (m_usage + int(entry.data->size()) > m_maxUsage) { break; }
+            if (m_cacheMap.find(entry.id) != m_cacheMap.end()) { continue; }
+
+            m_usage += entry.data->size();
+            m_cacheList.push_back(std::move(entry));
+            m_cacheMap[m_cacheList.back().id] = std::prev(m_cacheList.end());
+        }
+    }
+};
+
+
+constexpr size_t MemoryCacheDataSource::max_shared_caches;
+
+// Caches shared by the sources of all Maps, most recently requested first
+struct SharedRawCaches {
+    std::mutex mutex;
+    std::vector<std::pair<std::string, std::shared_ptr<RawCache>>> caches;
 };
 
+static SharedRawCaches& sharedRawCaches() {
+    static SharedRawCaches s_caches;
+    return s_caches;
+}
 
 MemoryCacheDataSource::MemoryCacheDataSource() :
-    m_cache(std::make_unique<RawCache>()) {
+    m_cache(std::make_shared<RawCache>()) {
 }
 
 MemoryCacheDataSource::~MemoryCacheDataSource() {}
@@ -93,24 +182,107 @@ void MemoryCacheDataSource::setCacheSize(size_t _cacheSize) {
     m_cache->m_maxUsage = _cacheSize;
 }
 
-bool MemoryCacheDataSource::cacheGet(BinaryTileTask& _task) {
-    return m_cache->get(_task);
+void MemoryCacheDataSource::setCompression(bool _compress) {
+    m_compress = _compress;
+}
+
+void MemoryCacheDataSource::setSharedCache(const std::string& _key) {
+    int maxUsage = m_cache->m_maxUsage;
+    auto& shared = sharedRawCaches();
+
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    auto it = std::find_if(shared.caches.begin(), shared.caches.end(),
+                           [&](auto& _entry) { return _entry.first == _key; });
+    if (it != shared.caches.end()) {
+        std::rotate(shared.caches.begin(), it, it + 1);
+    } else {
+        shared.caches.emplace(shared.caches.begin(), _key, std::make_shared<RawCache>());
+    }
+    m_cache = shared.caches.front().second;
+
+    // The cache is as large as the largest request of its sources
+    if (m_cache->m_maxUsage < maxUsage) { m_cache->m_maxUsage = maxUsage; }
+
+    // Drop the least recently requested caches that no source uses
+    for (size_t i = shared.caches.size(); i > max_shared_caches; i--) {
+        auto unused = std::find_if(shared.caches.rbegin(), shared.caches.rend(),
+                                   [](auto& _entry) { return _entry.second.use_count() == 1; });
+        if (unused == shared.caches.rend()) { break; }
+        shared.caches.erase(std::next(unused).base());
+    }
+}
+
+size_t MemoryCacheDataSource::sharedCacheCount() {
+    auto& shared = sharedRawCaches();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    return shared.caches.size();
+}
+
+void MemoryCacheDataSource::releaseSharedCaches() {
+    auto& shared = sharedRawCaches();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    for (auto& entry : shared.caches) { entry.second->clear(); }
+    shared.caches.erase(std::remove_if(shared.caches.begin(), shared.caches.end(),
+                                       [](auto& _entry) { return _entry.second.use_count() == 1; }),
+                        shared.caches.end());
+}
+
+bool MemoryCacheDataSource::cacheGet(BinaryTileTask& _task, std::shared_ptr<std::vector<char>>& _data,
+                                     bool& _compressed) {
+    return m_cache->get(_task, _data, _compressed);
+}
+
+void MemoryCacheDataSource::cachePut(const BinaryTileTask& _task) {
+    if (m_cache->m_maxUsage <= 0) { return; }
+
+    if (m_compress) {
+        auto compressed = std::make_shared<std::vector<char>>();
+        if (zlib::deflate(_task.rawTileData->data(), _task.rawTileData->size(), *compressed) == 0 &&
+            compressed->size() < _task.rawTileData->size()) {
+            compressed->shrink_to_fit();
+            m_cache->put(_task.tileId(), compressed, true, _task.validators, _task.maxAge);
+            return;
+        }
+    }
+    m_cache->put(_task.tileId(), _task.rawTileData, false, _task.validators, _task.maxAge);
 }
 
-void MemoryCacheDataSource::cachePut(const TileID& _tileID, std::shared_ptr<std::vector<char>> _rawDataRef) {
-    m_cache->put(_tileID, _rawDataRef);
+std::shared_ptr<std::vector<char>> MemoryCacheDataSource::uncompress(std::shared_ptr<std::vector<char>> _data,
+                                                                     bool _compressed) {
+    if (!_compressed) { return _data; }
+
+    auto data = std::make_shared<std::vector<char>>();
+    if (zlib::inflate(_data->data(), _data->size(), *data) != 0) {
+        LOGE("Invalid compressed cache entry");
+        return nullptr;
+    }
+    return data;
 }
 
 bool MemoryCacheDataSource::loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) {
 
     auto& task = static_cast<BinaryTileTask&>(*_task);
 
+    // Cached data. When it has expired it is used when the next sources
+    // confirm it or fail.
+    std::shared_ptr<std::vector<char>> cachedData;
+    bool compressed = false;
+
     if (_task->rawSource == this->level) {
 
-        cacheGet(task);
+        if (cacheGet(task, cachedData, compressed)) {
+            if (!compressed) {
+                task.rawTileData = std::move(cachedData);
+                _cb.func(_task);
+                return true;
+            }
+            // Keep decompression off the thread that loads the tiles
+            ThreadPool::shared().enqueue(ThreadPool::Priority::tile, [_task, _cb, cachedData]() {
+                if (_task->isCanceled()) { return; }
 
-        if (task.hasData()) {
-            _cb.func(_task);
+                static_cast<BinaryTileTask&>(*_task).rawTileData = uncompress(cachedData, true);
+                _cb.func(_task);
+            });
             return true;
         }
 
@@ -120,11 +292,25 @@ bool MemoryCacheDataSource::loadTileData(std::shared_ptr<TileTask> _task, TileTa
 
     if (next) {
 
-        return next->loadTileData(_task, {[this, _cb](std::shared_ptr<TileTask> _task) {
+        return next->loadTileData(_task, {[this, _cb, cachedData, compressed](std::shared_ptr<TileTask> _task) {
 
             auto& task = static_cast<BinaryTileTask&>(*_task);
 
-            if (task.hasData()) { cachePut(task.tileId(), task.rawTileData); }
+            if (!task.hasData() && cachedData) {
+                task.rawTileData = uncompress(cachedData, compressed);
+                // Keep the data for max-age when it was revalidated,
+                // otherwise revalidate it again on the next request
+                if (task.notModified) {
+                    if (!m_cache->refresh(task.tileId(), task.validators, task.maxAge) && task.rawTileData) {
+                        cachePut(task);
+                    }
+                } else {
+                    LOGD("Use expired data for tile %s", task.tileId().toString().c_str());
+                }
+            } else if (task.hasData() && task.rawTileData) {
+                // Tiles held as views of their DataSource need no copy in the cache
+                cachePut(task);
+            }
 
             _cb.func(_task);
         }});
@@ -139,4 +325,23 @@ void MemoryCacheDataSource::clear() {
     if (next) { next->clear(); }
 }
 
+size_t MemoryCacheDataSource::memoryUsage() const {
+    return m_cache->usage() + (next ? next->memoryUsage() : 0);
+}
+
+void MemoryCacheDataSource::releaseMemory() {
+    m_cache->clear();
+
+    if (next) { next->releaseMemory(); }
+}
+
+void MemoryCacheDataSource::copyCache(const DataSource& _previous) {
+    auto previous = dynamic_cast<const MemoryCacheDataSource*>(&_previous);
+    if (previous && previous->m_cache != m_cache) {
+        m_cache->copy(*previous->m_cache);
+    }
+
+    DataSource::copyCache(_previous);
+}
+
 }
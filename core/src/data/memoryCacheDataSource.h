@@ -2,6 +2,8 @@
 
 #include "data/tileSource.h"
 
+#include <string>
+
 namespace Tangram {
 
 class MemoryCacheDataSource : public TileSource::DataSource {
@@ -14,17 +16,53 @@ public:
 
     void clear() override;
 
+    size_t memoryUsage() const override;
+
+    void releaseMemory() override;
+
+    void copyCache(const DataSource& _previous) override;
+
     /* @_cacheSize: Set size of in-memory cache for tile data in bytes.
      * This cache holds unprocessed tile data for fast recreation of recently used tiles.
      */
     void setCacheSize(size_t _cacheSize);
 
+    /* @_compress: Store tile data compressed, so that the cache size holds
+     * more tiles. Tiles are decompressed on the ThreadPool when loaded.
+     */
+    void setCompression(bool _compress);
+
+    /* @_key: Use the cache shared by all sources with the same key, usually
+     * the URL template, in this and other Map instances. Shared caches outlive
+     * the sources that use them, so that Maps created one after another do not
+     * load the same tiles again. The size of a shared cache is the largest
+     * cache size of its sources.
+     */
+    void setSharedCache(const std::string& _key);
+
+    /* Shared caches that are kept when no source uses them */
+    static constexpr size_t max_shared_caches = 8;
+
+    /* Number of shared caches, including those no source uses */
+    static size_t sharedCacheCount();
+
+    /* Clear all shared caches and drop those no source uses */
+    static void releaseSharedCaches();
+
 private:
-    bool cacheGet(BinaryTileTask& _task);
+    /* Entries expire after the max-age of their network response. Expired
+     * entries are revalidated with their validators by the next sources and
+     * used while the network is unavailable. */
+    bool cacheGet(BinaryTileTask& _task, std::shared_ptr<std::vector<char>>& _data, bool& _compressed);
+
+    void cachePut(const BinaryTileTask& _task);
+
+    static std::shared_ptr<std::vector<char>> uncompress(std::shared_ptr<std::vector<char>> _data,
+                                                         bool _compressed);
 
-    void cachePut(const TileID& _tileID, std::shared_ptr<std::vector<char>> _rawDataRef);
+    std::shared_ptr<RawCache> m_cache;
 
-    std::unique_ptr<RawCache> m_cache;
+    bool m_compress = false;
 
 };
 
@@ -1,13 +1,25 @@
 #include "data/networkDataSource.h"
 
+#include "debug/metrics.h"
+#include "gl/hardware.h"
 #include "log.h"
 #include "platform.h"
+#include "util/mapProjection.h"
+#include "util/responseBufferPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <tuple>
 
 namespace Tangram {
 
 NetworkDataSource::NetworkDataSource(Platform& _platform, std::string url, UrlOptions options) :
     m_platform(_platform),
     m_urlTemplate(std::move(url)),
+    m_compiledTemplate(m_urlTemplate),
     m_options(std::move(options)) {}
 
 std::string NetworkDataSource::tileCoordinatesToQuadKey(const TileID &tile) {
@@ -34,45 +46,140 @@ bool NetworkDataSource::urlHasTilePattern(const std::string &url) {
            (url.find("{q}") != std::string::npos);
 }
 
-std::string NetworkDataSource::buildUrlForTile(const TileID& tile, const std::string& urlTemplate, const UrlOptions& options, int subdomainIndex) {
+NetworkDataSource::UrlTemplate::UrlTemplate(const std::string& url) {
 
-    std::string url = urlTemplate;
+    static const std::pair<const char*, Field> placeholders[] = {
+        { "{x}", Field::x }, { "{y}", Field::y }, { "{z}", Field::z }, { "{s}", Field::s },
+        { "{q}", Field::q }, { "{texture_format}", Field::texture_format },
+    };
 
-    size_t xPos = url.find("{x}");
-    if (xPos != std::string::npos) {
-        url.replace(xPos, 3, std::to_string(tile.x));
+    size_t start = 0;
+    size_t pos = url.find('{');
+    while (pos != std::string::npos) {
+        Field field = Field::none;
+        size_t end = pos + 1;
+        for (auto& placeholder : placeholders) {
+            if (url.compare(pos, std::strlen(placeholder.first), placeholder.first) == 0) {
+                field = placeholder.second;
+                end = pos + std::strlen(placeholder.first);
+                break;
+            }
+        }
+        if (field != Field::none) {
+            segments.push_back({ url.substr(start, pos - start), field });
+            length += pos - start;
+            start = end;
+        }
+        pos = url.find('{', end);
     }
-    size_t yPos = url.find("{y}");
-    if (yPos != std::string::npos) {
-        int y = tile.y;
-        int z = tile.z;
-        if (options.isTms) {
+    segments.push_back({ url.substr(start), Field::none });
+    length += url.size() - start;
+}
+
+void NetworkDataSource::UrlTemplate::build(std::string& out, const TileID& tile, const UrlOptions& options,
+                                           int subdomainIndex) const {
+
+    // Room for the numbers and a quadkey
+    out.reserve(out.size() + length + 16 + tile.z);
+
+    for (auto& segment : segments) {
+        out += segment.text;
+        switch (segment.field) {
+        case Field::none:
+            break;
+        case Field::x:
+            out += std::to_string(tile.x);
+            break;
+        case Field::y:
             // Convert XYZ to TMS
-            y = (1 << z) - 1 - tile.y;
+            out += std::to_string(options.isTms ? (1 << tile.z) - 1 - tile.y : tile.y);
+            break;
+        case Field::z:
+            out += std::to_string(tile.z);
+            break;
+        case Field::s:
+            if (subdomainIndex < options.subdomains.size()) {
+                out += options.subdomains[subdomainIndex];
+            } else {
+                out += "{s}";
+            }
+            break;
+        case Field::q:
+            out += tileCoordinatesToQuadKey(tile);
+            break;
+        case Field::texture_format: {
+            // Raster tiles in the compressed texture format of the GPU, or PNG
+            const char* format = Hardware::compressedTextureFormat();
+            out += format ? format : "png";
+            break;
         }
-        url.replace(yPos, 3, std::to_string(y));
-    }
-    size_t zPos = url.find("{z}");
-    if (zPos != std::string::npos) {
-        url.replace(zPos, 3, std::to_string(tile.z));
-    }
-    if (subdomainIndex < options.subdomains.size()) {
-        size_t sPos = url.find("{s}");
-        if (sPos != std::string::npos) {
-            url.replace(sPos, 3, options.subdomains[subdomainIndex]);
         }
     }
-    size_t qPos = url.find("{q}");
-    if (qPos != std::string::npos) {
-        auto quadkey = tileCoordinatesToQuadKey(tile);
-        url.replace(qPos, 3, quadkey);
-    }
+}
 
+std::string NetworkDataSource::buildUrlForTile(const TileID& tile, const std::string& urlTemplate, const UrlOptions& options, int subdomainIndex) {
+    std::string url;
+    UrlTemplate(urlTemplate).build(url, tile, options, subdomainIndex);
     return url;
 }
 
+int NetworkDataSource::subdomainIndexForTile(const TileID& tile, const UrlOptions& options) {
+    if (options.subdomains.empty()) { return 0; }
+    return (tile.x + tile.y) % options.subdomains.size();
+}
+
+namespace {
+
+// Tile requests in flight, shared by all NetworkDataSources. Tasks that need
+// the same URL wait for one request and share its response. Conditional
+// requests are only shared by tasks with the same validators, since a 304
+// response has no content for the others.
+struct InFlightRequest {
+    struct Waiter {
+        std::shared_ptr<TileTask> task;
+        TileTaskCb callback;
+    };
+    // Distinguishes a new request for the URL from a canceled earlier one
+    uint64_t id = 0;
+    UrlRequestHandle handle = 0;
+    bool started = false;
+    // Priority hint last given to the request
+    float priority = 0.5f;
+    std::vector<Waiter> waiters;
+};
+
+// Platform, URL and validators
+using InFlightKey = std::tuple<const Platform*, std::string, std::string>;
+
+InFlightKey inFlightKey(const Platform& _platform, const Url& _url, const UrlValidators& _validators) {
+    return InFlightKey{ &_platform, _url.string(), _validators.etag + '\n' + _validators.lastModified };
+}
+
+struct InFlightRequests {
+    std::mutex mutex;
+    std::map<InFlightKey, InFlightRequest> requests;
+    uint64_t nextId = 0;
+};
+
+InFlightRequests& inFlightRequests() {
+    static InFlightRequests s_requests;
+    return s_requests;
+}
+
+// Smallest change of the priority hint of a request that is passed on
+constexpr float url_priority_step = 0.05f;
+
+// Priority hint of the request of a task, 1 at the view center and 0.5 one
+// tile away. Task priorities are squared distances in meters.
+float urlPriority(const TileTask& _task) {
+    double distance = std::sqrt(_task.getPriority()) / MapProjection::metersPerTileAtZoom(_task.tileId().z);
+    return float(1.0 / (1.0 + distance));
+}
+
+}
+
 bool NetworkDataSource::loadTileData(std::shared_ptr<TileTask> task, TileTaskCb callback) {
-    LOGD("skyway loadTileData");
+    LOGC(network, "skyway loadTileData");
     if (task->rawSource != this->level) {
         LOGE("NetworkDataSource must be last!");
         return false;
@@ -80,49 +187,192 @@ bool NetworkDataSource::loadTileData(std::shared_ptr<TileTask> task, TileTaskCb
 
     auto tileId = task->tileId();
 
-    Url url(buildUrlForTile(tileId, m_urlTemplate, m_options, m_urlSubdomainIndex));
+    std::string urlString;
+    m_compiledTemplate.build(urlString, tileId, m_options, subdomainIndexForTile(tileId, m_options));
+    Url url(std::move(urlString));
 
-    if (!m_options.subdomains.empty()) {
-        m_urlSubdomainIndex = (m_urlSubdomainIndex + 1) % m_options.subdomains.size();
-    }
+    auto& dlTask = static_cast<BinaryTileTask&>(*task);
+    dlTask.urlRequestStarted = true;
 
-    LOGTInit(">>> %s", task->tileId().toString().c_str());
-    UrlCallback onRequestFinish = [=](UrlResponse&& response) mutable {
-        auto source = task->source();
-        if (!source) {
-            LOGW("URL Callback for deleted TileSource '%s'", url.string().c_str());
-            return;
+    auto& inFlight = inFlightRequests();
+    InFlightKey key = inFlightKey(m_platform, url, dlTask.validators);
+    UrlValidators validators = dlTask.validators;
+    uint64_t requestId = 0;
+    {
+        std::lock_guard<std::mutex> lock(inFlight.mutex);
+        auto& request = inFlight.requests[key];
+        request.waiters.push_back({ task, callback });
+
+        if (request.id != 0) {
+            LOGD("Join request for %s", url.string().c_str());
+            dlTask.urlRequestHandle = request.handle;
+            return true;
         }
-        LOGT("<<< %s -- canceled:%d", task->tileId().toString().c_str(), task->isCanceled());
+        request.id = requestId = ++inFlight.nextId;
+    }
 
-        if (task->isCanceled()) {
-            return;
+    LOGTInit(">>> %s", task->tileId().toString().c_str());
+    auto fetchStart = Metrics::start();
+    UrlCallback onRequestFinish = [key, requestId, fetchStart](UrlResponse&& response) {
+        Metrics::record(Metrics::Stage::fetch, fetchStart);
+        const auto& url = std::get<1>(key);
+        std::vector<InFlightRequest::Waiter> waiters;
+        {
+            auto& inFlight = inFlightRequests();
+            std::lock_guard<std::mutex> lock(inFlight.mutex);
+            auto it = inFlight.requests.find(key);
+            if (it == inFlight.requests.end() || it->second.id != requestId) {
+                // All tasks waiting for this request were canceled
+                return;
+            }
+            waiters = std::move(it->second.waiters);
+            inFlight.requests.erase(it);
         }
 
+        std::shared_ptr<std::vector<char>> content;
+        bool notModified = false;
         if (response.error) {
-            LOGD("URL request '%s': %s", url.string().c_str(), response.error);
+            LOGD("URL request '%s': %s", url.c_str(), response.error);
+
+        } else if (response.statusCode == 304) {
+            LOGD("URL request '%s': not modified", url.c_str());
+            notModified = true;
 
         } else if (!response.content.empty()) {
+            // The buffer is reused for another response once the tasks release it
+            content = ResponseBufferPool::shared().share(std::move(response.content));
+        }
+
+        for (auto& waiter : waiters) {
+            auto& task = waiter.task;
+            auto source = task->source();
+            if (!source) {
+                LOGW("URL Callback for deleted TileSource '%s'", url.c_str());
+                continue;
+            }
+            LOGT("<<< %s -- canceled:%d", task->tileId().toString().c_str(), task->isCanceled());
+
+            if (task->isCanceled()) {
+                continue;
+            }
+
+            // Tasks of sources that share the URL share the data, which is only read
             auto& dlTask = static_cast<BinaryTileTask&>(*task);
-            dlTask.rawTileData = std::make_shared<std::vector<char>>(std::move(response.content));
+            dlTask.rawTileData = content;
+            dlTask.notModified = notModified;
+            dlTask.maxAge = response.maxAge;
+            // A 304 response need not repeat the validators
+            if (!notModified || !response.validators.empty()) {
+                dlTask.validators = response.validators;
+            }
+
+            waiter.callback.func(std::move(task));
         }
-        callback.func(std::move(task));
     };
 
-    auto& dlTask = static_cast<BinaryTileTask&>(*task);
-    dlTask.urlRequestHandle = m_platform.startUrlRequest(url, std::move(onRequestFinish));
-    dlTask.urlRequestStarted = true;
+    // The request may complete right away, so the table must not be locked here
+    UrlRequestHandle handle = m_platform.startUrlRequest(url, validators, std::move(onRequestFinish));
+    dlTask.urlRequestHandle = handle;
+    float priority = urlPriority(*task);
+    m_platform.setUrlRequestPriority(handle, priority);
+
+    bool canceled = false;
+    {
+        std::lock_guard<std::mutex> lock(inFlight.mutex);
+        auto it = inFlight.requests.find(key);
+        if (it != inFlight.requests.end() && it->second.id == requestId) {
+            if (it->second.waiters.empty()) {
+                // All tasks were canceled while the request was started
+                inFlight.requests.erase(it);
+                canceled = true;
+            } else {
+                it->second.handle = handle;
+                it->second.started = true;
+                it->second.priority = priority;
+                for (auto& waiter : it->second.waiters) {
+                    static_cast<BinaryTileTask&>(*waiter.task).urlRequestHandle = handle;
+                }
+            }
+        }
+    }
+    if (canceled) {
+        m_platform.cancelUrlRequest(handle);
+    }
 
     return true;
 }
 
+void NetworkDataSource::updateTilePriority(TileTask& task) {
+    // Runs on the main thread while the fields of the task may be written on
+    // other threads, so the request is found by its waiters in the table
+    auto tileId = task.tileId();
+    std::string urlString;
+    m_compiledTemplate.build(urlString, tileId, m_options, subdomainIndexForTile(tileId, m_options));
+    Url url(std::move(urlString));
+
+    float priority = urlPriority(task);
+    UrlRequestHandle handle = 0;
+    {
+        auto& inFlight = inFlightRequests();
+        std::lock_guard<std::mutex> lock(inFlight.mutex);
+
+        // Requests for the URL with any validators
+        auto it = inFlight.requests.lower_bound(InFlightKey{ &m_platform, url.string(), std::string() });
+        for (; it != inFlight.requests.end(); ++it) {
+            if (std::get<0>(it->first) != &m_platform || std::get<1>(it->first) != url.string()) { return; }
+
+            auto& waiters = it->second.waiters;
+            bool waiting = std::any_of(waiters.begin(), waiters.end(),
+                                       [&](auto& waiter) { return waiter.task.get() == &task; });
+            if (waiting) { break; }
+        }
+        if (it == inFlight.requests.end() || !it->second.started) { return; }
+
+        // Only pass on changes that reorder the requests
+        if (std::abs(priority - it->second.priority) < url_priority_step) { return; }
+
+        it->second.priority = priority;
+        handle = it->second.handle;
+    }
+
+    m_platform.setUrlRequestPriority(handle, priority);
+}
+
 void NetworkDataSource::cancelLoadingTile(TileTask& task) {
     auto& dlTask = static_cast<BinaryTileTask&>(task);
-    if (dlTask.urlRequestStarted) {
-        dlTask.urlRequestStarted = false;
+    if (!dlTask.urlRequestStarted) { return; }
 
-        m_platform.cancelUrlRequest(dlTask.urlRequestHandle);
+    dlTask.urlRequestStarted = false;
+
+    auto tileId = task.tileId();
+    std::string urlString;
+    m_compiledTemplate.build(urlString, tileId, m_options, subdomainIndexForTile(tileId, m_options));
+    Url url(std::move(urlString));
+
+    UrlRequestHandle handle = 0;
+    {
+        auto& inFlight = inFlightRequests();
+        std::lock_guard<std::mutex> lock(inFlight.mutex);
+        auto it = inFlight.requests.find(inFlightKey(m_platform, url, dlTask.validators));
+        if (it == inFlight.requests.end()) { return; }
+
+        auto& waiters = it->second.waiters;
+        waiters.erase(std::remove_if(waiters.begin(), waiters.end(),
+                                     [&](auto& waiter) { return waiter.task.get() == &task; }),
+                      waiters.end());
+
+        // Cancel the request when no other task waits for it
+        if (!waiters.empty()) { return; }
+
+        if (!it->second.started) {
+            // loadTileData cancels the request once it has a handle
+            return;
+        }
+        handle = it->second.handle;
+        inFlight.requests.erase(it);
     }
+
+    m_platform.cancelUrlRequest(handle);
 }
 
 }
@@ -22,6 +22,13 @@ public:
 
     void cancelLoadingTile(TileTask& _task) override;
 
+    void updateTilePriority(TileTask& _task) override;
+
+    const NetworkDataSource* networkSource() const override { return this; }
+
+    const std::string& urlTemplate() const { return m_urlTemplate; }
+    const UrlOptions& urlOptions() const { return m_options; }
+
     static std::string tileCoordinatesToQuadKey(const TileID& tile);
 
     /// Returns true if the URL either contains 'x', 'y', and 'z' placeholders or contains a 'q' placeholder.
@@ -29,15 +36,35 @@ public:
 
     static std::string buildUrlForTile(const TileID& tile, const std::string& urlTemplate, const UrlOptions& options, int subdomainIndex);
 
+    /// Subdomain used for a tile. It only depends on the tile, so that requests for the
+    /// same tile from sources with the same URL template can be shared.
+    static int subdomainIndexForTile(const TileID& tile, const UrlOptions& options);
+
 private:
 
+    // URL template split at its placeholders, so that tile URLs are built by
+    // appending the parts rather than by searching the template each time
+    struct UrlTemplate {
+        enum class Field : uint8_t { none, x, y, z, s, q, texture_format };
+        struct Segment {
+            // Text up to the placeholder field, if any
+            std::string text;
+            Field field;
+        };
+        std::vector<Segment> segments;
+        size_t length = 0;
+
+        explicit UrlTemplate(const std::string& url);
+
+        void build(std::string& out, const TileID& tile, const UrlOptions& options, int subdomainIndex) const;
+    };
+
     Platform& m_platform;
 
     std::string m_urlTemplate;
+    UrlTemplate m_compiledTemplate;
 
     UrlOptions m_options;
-
-    int m_urlSubdomainIndex = 0;
 };
 
 }
@@ -0,0 +1,255 @@
+#include "data/offlineRegionDownload.h"
+
+#include "data/mbtilesDataSource.h"
+#include "data/networkDataSource.h"
+#include "data/tileSource.h"
+#include "log.h"
+#include "tile/tileTask.h"
+#include "util/mapProjection.h"
+#include "util/threadPool.h"
+
+#include "glm/common.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace Tangram {
+
+OfflineRegionDownload::OfflineRegionDownload(Platform& _platform, const OfflineRegion& _region,
+                                             OfflineRegionCallback _callback)
+    : m_platform(_platform),
+      m_region(_region),
+      m_callback(std::move(_callback)) {
+
+    m_region.concurrency = std::max<size_t>(m_region.concurrency, 1);
+}
+
+OfflineRegionDownload::~OfflineRegionDownload() {}
+
+bool OfflineRegionDownload::addSource(std::shared_ptr<TileSource> _source, const std::string& _path) {
+
+    auto network = _source->networkSource();
+    if (!network) {
+        LOGE("Offline region source '%s' does not load tiles from the network", _source->name().c_str());
+        return false;
+    }
+
+    // Map zoom levels to the tile zoom levels of the source; tiles beyond
+    // maxZoom are overzoomed from those of maxZoom
+    int bias = _source->zoomBias();
+    int maxZoom = _source->maxZoom();
+    int minTileZoom = glm::clamp(m_region.minZoom - bias, 0, maxZoom);
+    int maxTileZoom = glm::clamp(m_region.maxZoom - bias, 0, maxZoom);
+    if (minTileZoom > maxTileZoom) {
+        LOGW("Offline region has no zoom levels of source '%s'", _source->name().c_str());
+        return false;
+    }
+
+    MBTilesOptions options;
+    options.connections = 1;
+    options.writeBatchSize = m_region.writeBatchSize;
+
+    auto store = std::make_unique<MBTilesDataSource>(m_platform, _source->name(), _path, "",
+                                                     true, false, options);
+    if (!store->canStoreTiles()) {
+        LOGE("Cannot store offline region tiles of source '%s' in %s", _source->name().c_str(), _path.c_str());
+        return false;
+    }
+    store->setNext(std::make_unique<NetworkDataSource>(m_platform, network->urlTemplate(), network->urlOptions()));
+
+    m_sources.push_back({ std::move(_source), std::move(store), minTileZoom, maxTileZoom });
+    return true;
+}
+
+void OfflineRegionDownload::tileRange(LngLat _min, LngLat _max, int _z, glm::ivec2& _tileMin, glm::ivec2& _tileMax) {
+    double maxLatitude = MapProjection::MAX_LATITUDE_DEGREES;
+    _min.latitude = glm::clamp(_min.latitude, -maxLatitude, maxLatitude);
+    _max.latitude = glm::clamp(_max.latitude, -maxLatitude, maxLatitude);
+
+    ProjectedMeters a = MapProjection::lngLatToProjectedMeters(_min);
+    ProjectedMeters b = MapProjection::lngLatToProjectedMeters(_max);
+
+    // Tile coordinates have y pointing down
+    double metersPerTile = MapProjection::metersPerTileAtZoom(_z);
+    double halfCircumference = MapProjection::EARTH_HALF_CIRCUMFERENCE_METERS;
+    glm::dvec2 ta{ (a.x + halfCircumference) / metersPerTile, (halfCircumference - a.y) / metersPerTile };
+    glm::dvec2 tb{ (b.x + halfCircumference) / metersPerTile, (halfCircumference - b.y) / metersPerTile };
+
+    int maxTile = (1 << _z) - 1;
+    _tileMin = glm::clamp(glm::ivec2(glm::floor(glm::min(ta, tb))), 0, maxTile);
+    _tileMax = glm::clamp(glm::ivec2(glm::floor(glm::max(ta, tb))), 0, maxTile);
+}
+
+void OfflineRegionDownload::start() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& source : m_sources) {
+            for (int z = source.minZoom; z <= source.maxZoom; z++) {
+                glm::ivec2 tileMin, tileMax;
+                tileRange(m_region.min, m_region.max, z, tileMin, tileMax);
+                m_progress.total += size_t(tileMax.x - tileMin.x + 1) * size_t(tileMax.y - tileMin.y + 1);
+            }
+        }
+        LOG("Offline region: %d tiles of %d sources", int(m_progress.total), int(m_sources.size()));
+
+        scheduleRequests();
+    }
+}
+
+void OfflineRegionDownload::cancel() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_canceled = true;
+}
+
+bool OfflineRegionDownload::isFinished() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_done;
+}
+
+bool OfflineRegionDownload::nextTile(size_t& _source, TileID& _tile) {
+    while (m_source < m_sources.size()) {
+        auto& source = m_sources[m_source];
+        if (m_z < 0) {
+            m_z = source.minZoom;
+            tileRange(m_region.min, m_region.max, m_z, m_tileMin, m_tileMax);
+            m_x = m_tileMin.x;
+            m_y = m_tileMin.y;
+        } else if (++m_y > m_tileMax.y) {
+            m_y = m_tileMin.y;
+            if (++m_x > m_tileMax.x) {
+                if (++m_z > source.maxZoom) {
+                    m_source++;
+                    m_z = -1;
+                    continue;
+                }
+                tileRange(m_region.min, m_region.max, m_z, m_tileMin, m_tileMax);
+                m_x = m_tileMin.x;
+                m_y = m_tileMin.y;
+            }
+        }
+        _source = m_source;
+        _tile = TileID(m_x, m_y, m_z);
+        return true;
+    }
+    return false;
+}
+
+void OfflineRegionDownload::scheduleRequests() {
+    // Called with m_mutex locked
+    if (m_requesting || m_done) { return; }
+
+    m_requesting = true;
+    auto self = shared_from_this();
+    ThreadPool::shared().enqueue(ThreadPool::Priority::io, [self]{ self->requestTiles(); });
+}
+
+void OfflineRegionDownload::requestTiles() {
+    OfflineRegionProgress progress;
+    bool finished = false;
+
+    while (true) {
+        size_t sourceIndex = 0;
+        TileID tileId(0, 0, 0);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_canceled && m_inFlight >= m_region.concurrency) {
+                // Continued when a tile in flight is loaded
+                m_requesting = false;
+                progress = m_progress;
+                break;
+            }
+            if (m_canceled || !nextTile(sourceIndex, tileId)) {
+                m_requesting = false;
+                finished = m_inFlight == 0 && !m_done;
+                m_done |= finished;
+                progress = m_progress;
+                break;
+            }
+        }
+
+        auto& source = m_sources[sourceIndex];
+
+        // Resume an interrupted download
+        if (source.store->hasTileData(tileId)) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_progress.skipped++;
+            continue;
+        }
+
+        auto task = std::make_shared<BinaryTileTask>(tileId, source.tileSource);
+        task->rawSource = source.store->next->level;
+        // Below the requests of the tiles in view
+        task->setPriority(std::numeric_limits<double>::max());
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_inFlight++;
+        }
+
+        auto self = shared_from_this();
+        TileTaskCb cb{[self](std::shared_ptr<TileTask> _task) {
+            // The MBTilesDataSource queued the tile data to be written
+            self->onTileLoaded(_task->hasData());
+        }};
+
+        if (!source.store->loadTileData(task, cb)) {
+            onTileLoaded(false);
+        }
+    }
+
+    if (finished) {
+        finish();
+    } else {
+        report(progress);
+    }
+}
+
+void OfflineRegionDownload::onTileLoaded(bool _loaded) {
+    OfflineRegionProgress progress;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_inFlight--;
+        if (_loaded) {
+            m_progress.downloaded++;
+        } else {
+            m_progress.failed++;
+        }
+        progress = m_progress;
+
+        // NB: Also schedules the requests when the last tile was requested,
+        // to finish once no tiles are in flight
+        scheduleRequests();
+    }
+    report(progress);
+}
+
+void OfflineRegionDownload::finish() {
+    // MBTilesDataSource writes its queued tiles before the database is closed
+    for (auto& source : m_sources) {
+        source.store.reset();
+    }
+
+    OfflineRegionProgress progress;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        progress = m_progress;
+    }
+    progress.finished = true;
+
+    LOG("Offline region finished: %d downloaded, %d skipped, %d failed",
+        int(progress.downloaded), int(progress.skipped), int(progress.failed));
+
+    report(progress);
+}
+
+void OfflineRegionDownload::report(const OfflineRegionProgress& _progress) {
+    if (!m_callback) { return; }
+
+    std::lock_guard<std::mutex> lock(m_reportMutex);
+    if (m_reportedFinished) { return; }
+    m_reportedFinished = _progress.finished;
+
+    m_callback(_progress);
+}
+
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "map.h"
+#include "tile/tileID.h"
+
+#include "glm/vec2.hpp"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Tangram {
+
+class MBTilesDataSource;
+class Platform;
+class TileSource;
+class TileTask;
+
+// Downloads the tiles of an OfflineRegion from the network sources of a scene into
+// MBTiles files. At most OfflineRegion::concurrency tiles are requested at a time,
+// and the MBTilesDataSource of each source writes them in batched transactions.
+class OfflineRegionDownload : public std::enable_shared_from_this<OfflineRegionDownload> {
+public:
+
+    OfflineRegionDownload(Platform& _platform, const OfflineRegion& _region, OfflineRegionCallback _callback);
+
+    ~OfflineRegionDownload();
+
+    // Add a source of the region; returns false when it does not load tiles from the
+    // network or its MBTiles file can not be written
+    bool addSource(std::shared_ptr<TileSource> _source, const std::string& _path);
+
+    bool hasSources() const { return !m_sources.empty(); }
+
+    // Start requesting the tiles of the added sources
+    void start();
+
+    // Stop requesting tiles, the finished progress is reported once the tiles in flight are written
+    void cancel();
+
+    bool isFinished() const;
+
+    // The range of tiles at zoom _z covering the bounds _min, _max
+    static void tileRange(LngLat _min, LngLat _max, int _z, glm::ivec2& _tileMin, glm::ivec2& _tileMax);
+
+private:
+
+    struct Source {
+        std::shared_ptr<TileSource> tileSource;
+        // Cache mode MBTilesDataSource followed by a NetworkDataSource
+        std::unique_ptr<MBTilesDataSource> store;
+        // Range of tile zoom levels
+        int minZoom;
+        int maxZoom;
+    };
+
+    // Get the next tile of the region, returns false after the last one
+    bool nextTile(size_t& _source, TileID& _tile);
+    // Request tiles until enough are in flight, skipping stored tiles. Runs
+    // on the ThreadPool, one call at a time.
+    void requestTiles();
+    void scheduleRequests();
+    void onTileLoaded(bool _loaded);
+    // Write the last batch of tiles and report the finished progress
+    void finish();
+    void report(const OfflineRegionProgress& _progress);
+
+    Platform& m_platform;
+    OfflineRegion m_region;
+    OfflineRegionCallback m_callback;
+
+    std::vector<Source> m_sources;
+
+    mutable std::mutex m_mutex;
+    OfflineRegionProgress m_progress;
+    size_t m_inFlight = 0;
+    bool m_requesting = false;
+    bool m_canceled = false;
+    bool m_done = false;
+
+    // Position of the last tile, in the tile range m_tileMin, m_tileMax of zoom m_z.
+    // m_z is -1 before the first tile of a source.
+    size_t m_source = 0;
+    int m_z = -1;
+    int m_x = 0;
+    int m_y = 0;
+    glm::ivec2 m_tileMin;
+    glm::ivec2 m_tileMax;
+
+    // Reports one progress at a time and none after the finished one
+    std::mutex m_reportMutex;
+    bool m_reportedFinished = false;
+};
+
+}
@@ -0,0 +1,355 @@
+#include "data/pmtilesDataSource.h"
+
+#include "log.h"
+#include "platform.h"
+#include "util/threadPool.h"
+#include "util/url.h"
+#include "util/zlibHelper.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Tangram {
+
+// https://github.com/protomaps/PMTiles/blob/main/spec/v3/spec.md
+static constexpr size_t header_size = 127;
+static constexpr uint8_t spec_version = 3;
+
+// Depth of leaf directories is limited by the spec
+static constexpr int max_directory_depth = 4;
+
+namespace {
+
+enum class Compression : uint8_t { unknown, none, gzip, brotli, zstd };
+
+struct Entry {
+    uint64_t tileId;
+    uint64_t offset;
+    uint32_t length;
+    // Number of consecutive tiles with the same data; 0 for a leaf directory
+    uint32_t runLength;
+};
+
+using Directory = std::vector<Entry>;
+
+uint64_t readUint64(const uint8_t* _data) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; i--) { value = (value << 8) | _data[i]; }
+    return value;
+}
+
+bool readVarint(const uint8_t*& _data, const uint8_t* _end, uint64_t& _value) {
+    _value = 0;
+    for (int shift = 0; _data < _end && shift < 64; shift += 7) {
+        uint8_t byte = *_data++;
+        _value |= uint64_t(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) { return true; }
+    }
+    return false;
+}
+
+// Entries are stored column-wise: tile ID deltas, run lengths, lengths, offsets
+bool decodeDirectory(const uint8_t* _data, const uint8_t* _end, Directory& _entries) {
+    uint64_t numEntries = 0;
+    if (!readVarint(_data, _end, numEntries) || numEntries > size_t(_end - _data)) {
+        return false;
+    }
+    _entries.resize(numEntries);
+
+    uint64_t value = 0, tileId = 0;
+    for (auto& entry : _entries) {
+        if (!readVarint(_data, _end, value)) { return false; }
+        tileId += value;
+        entry.tileId = tileId;
+    }
+    for (auto& entry : _entries) {
+        if (!readVarint(_data, _end, value)) { return false; }
+        entry.runLength = uint32_t(value);
+    }
+    for (auto& entry : _entries) {
+        if (!readVarint(_data, _end, value)) { return false; }
+        entry.length = uint32_t(value);
+    }
+    for (size_t i = 0; i < _entries.size(); i++) {
+        if (!readVarint(_data, _end, value)) { return false; }
+        // 0 continues after the data of the previous entry
+        if (value == 0 && i > 0) {
+            _entries[i].offset = _entries[i-1].offset + _entries[i-1].length;
+        } else {
+            _entries[i].offset = value - 1;
+        }
+    }
+    return true;
+}
+
+}
+
+class PMTilesDataSource::Archive {
+public:
+
+    static std::shared_ptr<Archive> open(const std::string& _path);
+
+    ~Archive();
+
+    /* Set _data and _size to the stored data of the tile with _tileIndex.
+     * Returns false when the archive does not contain the tile. */
+    bool findTile(uint64_t _tileIndex, const char*& _data, size_t& _size);
+
+    Compression tileCompression = Compression::unknown;
+
+private:
+
+    struct Leaf {
+        uint64_t offset;
+        Directory entries;
+    };
+
+    bool readHeader();
+
+    bool readDirectory(uint64_t _offset, uint64_t _length, Directory& _entries) const;
+
+    std::shared_ptr<const Leaf> getLeaf(uint64_t _offset, uint64_t _length);
+
+    const uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+
+#ifdef _WIN32
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+    HANDLE m_mapping = nullptr;
+#endif
+
+    uint64_t m_leafDirectoryOffset = 0;
+    uint64_t m_tileDataOffset = 0;
+    Compression m_internalCompression = Compression::unknown;
+
+    Directory m_rootDirectory;
+
+    // Recently used leaf directories, by slot of their offset. Slots are
+    // replaced atomically so that readers do not need a lock.
+    std::array<std::shared_ptr<const Leaf>, 64> m_leaves;
+};
+
+std::shared_ptr<PMTilesDataSource::Archive> PMTilesDataSource::Archive::open(const std::string& _path) {
+    auto archive = std::make_shared<Archive>();
+
+#ifdef _WIN32
+    archive->m_file = CreateFileA(_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (archive->m_file == INVALID_HANDLE_VALUE) {
+        LOGE("Unable to open PMTiles archive: %s", _path.c_str());
+        return nullptr;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(archive->m_file, &size)) { return nullptr; }
+    archive->m_size = size_t(size.QuadPart);
+
+    archive->m_mapping = CreateFileMappingA(archive->m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (archive->m_mapping) {
+        archive->m_data = static_cast<const uint8_t*>(MapViewOfFile(archive->m_mapping, FILE_MAP_READ, 0, 0, 0));
+    }
+#else
+    int fd = ::open(_path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        LOGE("Unable to open PMTiles archive: %s", _path.c_str());
+        return nullptr;
+    }
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        archive->m_size = size_t(info.st_size);
+        void* data = mmap(nullptr, archive->m_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (data != MAP_FAILED) {
+            archive->m_data = static_cast<const uint8_t*>(data);
+        }
+    }
+    // The mapping stays valid after the file is closed
+    close(fd);
+#endif
+
+    if (!archive->m_data) {
+        LOGE("Unable to map PMTiles archive: %s", _path.c_str());
+        return nullptr;
+    }
+    if (!archive->readHeader()) {
+        LOGE("Invalid PMTiles archive: %s", _path.c_str());
+        return nullptr;
+    }
+    return archive;
+}
+
+PMTilesDataSource::Archive::~Archive() {
+#ifdef _WIN32
+    if (m_data) { UnmapViewOfFile(m_data); }
+    if (m_mapping) { CloseHandle(m_mapping); }
+    if (m_file != INVALID_HANDLE_VALUE) { CloseHandle(m_file); }
+#else
+    if (m_data) { munmap(const_cast<uint8_t*>(m_data), m_size); }
+#endif
+}
+
+bool PMTilesDataSource::Archive::readHeader() {
+    if (m_size < header_size || std::memcmp(m_data, "PMTiles", 7) != 0 ||
+        m_data[7] != spec_version) {
+        return false;
+    }
+
+    uint64_t rootOffset = readUint64(m_data + 8);
+    uint64_t rootLength = readUint64(m_data + 16);
+    m_leafDirectoryOffset = readUint64(m_data + 40);
+    m_tileDataOffset = readUint64(m_data + 56);
+    m_internalCompression = Compression(m_data[97]);
+    tileCompression = Compression(m_data[98]);
+
+    if (m_internalCompression != Compression::none && m_internalCompression != Compression::gzip) {
+        LOGE("Unsupported PMTiles directory compression: %d", int(m_internalCompression));
+        return false;
+    }
+    if (tileCompression != Compression::none && tileCompression != Compression::gzip &&
+        tileCompression != Compression::unknown) {
+        LOGE("Unsupported PMTiles tile compression: %d", int(tileCompression));
+        return false;
+    }
+
+    return readDirectory(rootOffset, rootLength, m_rootDirectory);
+}
+
+bool PMTilesDataSource::Archive::readDirectory(uint64_t _offset, uint64_t _length, Directory& _entries) const {
+    if (_offset > m_size || _length > m_size - _offset) { return false; }
+
+    auto data = m_data + _offset;
+
+    if (m_internalCompression == Compression::gzip) {
+        std::vector<char> inflated;
+        if (zlib::inflate(reinterpret_cast<const char*>(data), _length, inflated) != 0) {
+            return false;
+        }
+        auto begin = reinterpret_cast<const uint8_t*>(inflated.data());
+        return decodeDirectory(begin, begin + inflated.size(), _entries);
+    }
+    return decodeDirectory(data, data + _length, _entries);
+}
+
+std::shared_ptr<const PMTilesDataSource::Archive::Leaf>
+PMTilesDataSource::Archive::getLeaf(uint64_t _offset, uint64_t _length) {
+
+    auto& slot = m_leaves[(_offset * 0x9E3779B97F4A7C15ull) >> 58];
+
+    auto leaf = std::atomic_load(&slot);
+    if (leaf && leaf->offset == _offset) { return leaf; }
+
+    auto decoded = std::make_shared<Leaf>();
+    decoded->offset = _offset;
+    if (!readDirectory(_offset, _length, decoded->entries)) { return nullptr; }
+
+    leaf = std::move(decoded);
+    std::atomic_store(&slot, leaf);
+    return leaf;
+}
+
+bool PMTilesDataSource::Archive::findTile(uint64_t _tileIndex, const char*& _data, size_t& _size) {
+
+    const Directory* directory = &m_rootDirectory;
+    std::shared_ptr<const Leaf> leaf;
+
+    for (int depth = 0; depth < max_directory_depth; depth++) {
+        // Last entry starting at or before _tileIndex
+        auto it = std::upper_bound(directory->begin(), directory->end(), _tileIndex,
+                                   [](uint64_t _id, const Entry& _entry) { return _id < _entry.tileId; });
+        if (it == directory->begin()) { return false; }
+        --it;
+
+        if (it->runLength > 0) {
+            if (_tileIndex >= it->tileId + it->runLength) { return false; }
+
+            uint64_t offset = m_tileDataOffset + it->offset;
+            if (offset > m_size || it->length > m_size - offset) { return false; }
+
+            _data = reinterpret_cast<const char*>(m_data + offset);
+            _size = it->length;
+            return true;
+        }
+
+        leaf = getLeaf(m_leafDirectoryOffset + it->offset, it->length);
+        if (!leaf) { return false; }
+        directory = &leaf->entries;
+    }
+    return false;
+}
+
+uint64_t PMTilesDataSource::tileIndex(const TileID& _tileId) {
+    // Tiles of lower zoom levels come first
+    uint64_t index = ((uint64_t(1) << (2 * _tileId.z)) - 1) / 3;
+
+    int64_t x = _tileId.x, y = _tileId.y;
+    int64_t n = int64_t(1) << _tileId.z;
+
+    for (int64_t s = n / 2; s > 0; s /= 2) {
+        int64_t rx = (x & s) > 0;
+        int64_t ry = (y & s) > 0;
+        index += s * s * ((3 * rx) ^ ry);
+        // Rotate the quadrant
+        if (ry == 0) {
+            if (rx == 1) {
+                x = n - 1 - x;
+                y = n - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return index;
+}
+
+PMTilesDataSource::PMTilesDataSource(Platform& _platform, const std::string& _path)
+    : m_platform(_platform) {
+
+    m_archive = Archive::open(Url(_path).path());
+
+    if (m_archive) { LOG("PMTiles archive opened: %s", _path.c_str()); }
+}
+
+PMTilesDataSource::~PMTilesDataSource() {}
+
+bool PMTilesDataSource::loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) {
+
+    if (!m_archive || _task->rawSource != this->level) {
+        if (next) { return next->loadTileData(_task, _cb); }
+        return false;
+    }
+
+    // Reading may fault in pages of the file, so it runs on the pool
+    ThreadPool::shared().enqueue(ThreadPool::Priority::io, [archive = m_archive, _task, _cb]() {
+        if (_task->isCanceled()) { return; }
+
+        auto& task = static_cast<BinaryTileTask&>(*_task);
+
+        const char* data = nullptr;
+        size_t size = 0;
+        if (archive->findTile(tileIndex(task.tileId()), data, size) && size > 0) {
+            if (archive->tileCompression == Compression::gzip) {
+                task.rawTileData = std::make_shared<std::vector<char>>();
+                if (zlib::inflate(data, size, *task.rawTileData) != 0) {
+                    LOGW("Invalid gzip compression of tile: %s", task.tileId().toString().c_str());
+                    task.rawTileData.reset();
+                }
+            } else {
+                // The archive stays mapped while the task refers to the tile
+                task.setTileDataView(data, size, archive);
+            }
+        }
+
+        _cb.func(_task);
+    });
+    return true;
+}
+
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "data/tileSource.h"
+
+#include <memory>
+#include <string>
+
+namespace Tangram {
+
+class Platform;
+
+/* Reads tiles from a PMTiles (version 3) archive
+ *
+ * The archive is a single read-only file: a header, a directory of tile
+ * offsets indexed by Hilbert tile ID, and the tile data. The file is memory
+ * mapped, so that a tile read is a directory lookup in mapped memory.
+ * Uncompressed tiles are handed to the task as a view of the mapping without
+ * being copied. Tiles are read on the shared ThreadPool; reads do not lock,
+ * so many can run concurrently.
+ */
+class PMTilesDataSource : public TileSource::DataSource {
+public:
+
+    PMTilesDataSource(Platform& _platform, const std::string& _path);
+
+    ~PMTilesDataSource();
+
+    bool loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) override;
+
+    void clear() override {}
+
+    // The mapped archive and its decoded directories
+    class Archive;
+
+    // Hilbert curve index of a tile in an archive
+    static uint64_t tileIndex(const TileID& _tileId);
+
+private:
+
+    Platform& m_platform;
+
+    std::shared_ptr<Archive> m_archive;
+};
+
+}
@@ -0,0 +1,150 @@
+#include "data/pointClusters.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+namespace Tangram {
+
+// Nodes in a leaf of the KD-tree
+static constexpr size_t kd_leaf_size = 64;
+
+static double lngX(double _lng) {
+    return _lng / 360.0 + 0.5;
+}
+
+static double latY(double _lat) {
+    double s = std::sin(_lat * M_PI / 180.0);
+    double y = 0.5 - 0.25 * std::log((1 + s) / (1 - s)) / M_PI;
+    return std::min(std::max(y, 0.0), 1.0);
+}
+
+// Sort the nodes from _left to _right into a KD-tree, splitting by x first
+template<class N>
+static void sortKD(std::vector<N>& _nodes, size_t _left, size_t _right, int _axis) {
+    if (_right - _left <= kd_leaf_size) { return; }
+
+    size_t mid = (_left + _right) / 2;
+    std::nth_element(_nodes.begin() + _left, _nodes.begin() + mid, _nodes.begin() + _right + 1,
+                     [&](const N& a, const N& b) { return _axis ? a.y < b.y : a.x < b.x; });
+
+    sortKD(_nodes, _left, mid - 1, 1 - _axis);
+    sortKD(_nodes, mid + 1, _right, 1 - _axis);
+}
+
+// Call _f with the index of each node in the box
+template<class N, class F>
+static void range(const std::vector<N>& _nodes, double _minX, double _minY,
+                  double _maxX, double _maxY, F _f) {
+    if (_nodes.empty()) { return; }
+
+    struct Range { size_t left, right; int axis; };
+    std::vector<Range> stack{{ 0, _nodes.size() - 1, 0 }};
+
+    auto inside = [&](const N& n) {
+        return n.x >= _minX && n.x <= _maxX && n.y >= _minY && n.y <= _maxY;
+    };
+
+    while (!stack.empty()) {
+        Range r = stack.back();
+        stack.pop_back();
+
+        if (r.right - r.left <= kd_leaf_size) {
+            for (size_t i = r.left; i <= r.right; i++) {
+                if (inside(_nodes[i])) { _f(i); }
+            }
+            continue;
+        }
+
+        size_t mid = (r.left + r.right) / 2;
+        const N& n = _nodes[mid];
+        if (inside(n)) { _f(mid); }
+
+        double coord = r.axis ? n.y : n.x;
+        if ((r.axis ? _minY : _minX) <= coord) { stack.push_back({ r.left, mid - 1, 1 - r.axis }); }
+        if ((r.axis ? _maxY : _maxX) >= coord) { stack.push_back({ mid + 1, r.right, 1 - r.axis }); }
+    }
+}
+
+PointClusters::PointClusters(const std::vector<double>& _lngLats, Options _options)
+    : m_options(_options) {
+
+    m_options.maxZoom = std::max(m_options.maxZoom, m_options.minZoom);
+    m_levels.resize(m_options.maxZoom - m_options.minZoom + 2);
+
+    auto& points = m_levels.back();
+    points.reserve(_lngLats.size() / 2);
+    for (size_t i = 0; i < _lngLats.size() / 2; i++) {
+        points.push_back({ lngX(_lngLats[2 * i]), latY(_lngLats[2 * i + 1]), 1, uint32_t(i), INT_MAX });
+    }
+    if (!points.empty()) { sortKD(points, 0, points.size() - 1, 0); }
+
+    std::vector<size_t> neighbors;
+
+    for (int z = m_options.maxZoom; z >= m_options.minZoom; z--) {
+        auto& nodes = m_levels[z - m_options.minZoom + 1];
+        auto& clusters = m_levels[z - m_options.minZoom];
+        double r = m_options.radius / (256.0 * std::pow(2.0, z));
+
+        for (auto& node : nodes) {
+            if (node.zoom <= z) { continue; }
+            node.zoom = z;
+
+            neighbors.clear();
+            range(nodes, node.x - r, node.y - r, node.x + r, node.y + r, [&](size_t i) {
+                const auto& n = nodes[i];
+                if (n.zoom > z && (n.x - node.x) * (n.x - node.x) + (n.y - node.y) * (n.y - node.y) <= r * r) {
+                    neighbors.push_back(i);
+                }
+            });
+
+            if (neighbors.empty()) {
+                clusters.push_back({ node.x, node.y, node.count, node.point, INT_MAX });
+                continue;
+            }
+
+            // The cluster is at the center of its points
+            uint32_t count = node.count;
+            double wx = node.x * node.count;
+            double wy = node.y * node.count;
+            for (size_t i : neighbors) {
+                auto& n = nodes[i];
+                n.zoom = z;
+                count += n.count;
+                wx += n.x * n.count;
+                wy += n.y * n.count;
+            }
+            clusters.push_back({ wx / count, wy / count, count, node.point, INT_MAX });
+        }
+
+        if (!clusters.empty()) { sortKD(clusters, 0, clusters.size() - 1, 0); }
+    }
+}
+
+void PointClusters::getTile(const TileID& _tileId, std::vector<Cluster>& _clusters) const {
+    int z = std::min(std::max(int(_tileId.z), m_options.minZoom), m_options.maxZoom + 1);
+    const auto& nodes = m_levels[z - m_options.minZoom];
+
+    double n = std::pow(2.0, _tileId.z);
+    double minX = _tileId.x / n, maxX = (_tileId.x + 1) / n;
+    double minY = _tileId.y / n, maxY = (_tileId.y + 1) / n;
+
+    // Nodes on the edge between two tiles belong to the tile on the right or below
+    bool lastX = _tileId.x == int(n) - 1;
+    bool lastY = _tileId.y == int(n) - 1;
+
+    range(nodes, minX, minY, maxX, maxY, [&](size_t i) {
+        const auto& node = nodes[i];
+        if ((node.x == maxX && !lastX) || (node.y == maxY && !lastY)) { return; }
+        _clusters.push_back({ node.x * n - _tileId.x, 1.0 - (node.y * n - _tileId.y),
+                              node.count, node.point });
+    });
+}
+
+size_t PointClusters::bytes() const {
+    size_t bytes = 0;
+    for (const auto& level : m_levels) { bytes += level.capacity() * sizeof(Node); }
+    return bytes;
+}
+
+}
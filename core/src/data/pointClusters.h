@@ -0,0 +1,63 @@
+#pragma once
+
+#include "tile/tileID.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Tangram {
+
+/* Hierarchical greedy clustering of points, like supercluster
+ *
+ * Points are clustered for each zoom from maxZoom down to minZoom. Each point
+ * or cluster of the next zoom that is not yet taken takes all others within
+ * the cluster radius. The nodes of each zoom are sorted into a KD-tree, which
+ * finds the neighbors while clustering and the nodes of a tile afterwards.
+ */
+class PointClusters {
+
+public:
+
+    struct Options {
+        // Radius in pixels of a 256 pixel tile
+        float radius = 40;
+        int minZoom = 0;
+        // Points are not clustered above this zoom
+        int maxZoom = 16;
+    };
+
+    struct Cluster {
+        // Position in the tile, from 0 to 1 with y up
+        double x, y;
+        // Number of points in the cluster
+        uint32_t count;
+        // Index of the point when count is 1
+        uint32_t point;
+    };
+
+    // _lngLats holds the longitude and latitude of each point
+    PointClusters(const std::vector<double>& _lngLats, Options _options);
+
+    // Append the clusters and single points in the tile
+    void getTile(const TileID& _tileId, std::vector<Cluster>& _clusters) const;
+
+    size_t bytes() const;
+
+private:
+
+    struct Node {
+        // Mercator position from 0 to 1, with y down
+        double x, y;
+        uint32_t count;
+        uint32_t point;
+        // Lowest zoom that the node was clustered at
+        int zoom;
+    };
+
+    // Nodes of each zoom from minZoom to maxZoom + 1, in KD-tree order
+    std::vector<std::vector<Node>> m_levels;
+
+    Options m_options;
+};
+
+}
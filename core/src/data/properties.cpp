@@ -1,6 +1,10 @@
 #include "data/propertyItem.h"
 #include "data/properties.h"
 #include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <mutex>
+#include <unordered_map>
 
 namespace Tangram {
 
@@ -15,22 +19,175 @@ std::string doubleToString(double _doubleValue) {
     return value;
 }
 
+constexpr Properties::KeyId Properties::not_interned;
+
+namespace {
+
+struct KeyTable {
+    std::mutex mutex;
+    std::unordered_map<std::string, Properties::KeyId> ids;
+    // Number of interned keys, read without the lock by findKey()
+    std::atomic<uint32_t> count{0};
+};
+
+KeyTable& keyTable() {
+    static KeyTable s_table;
+    return s_table;
+}
+
+// Keys looked up by a thread since the last key was interned
+struct KeyCache {
+    uint32_t count = 0;
+    std::unordered_map<std::string, Properties::KeyId> ids;
+};
+
+// Feature keys are not bounded, the cache is cleared when it gets larger
+constexpr size_t max_cached_keys = 1024;
+
+}
+
+Properties::KeyId Properties::internKey(const std::string& _key) {
+    auto& table = keyTable();
+
+    std::lock_guard<std::mutex> lock(table.mutex);
+    auto it = table.ids.emplace(_key, KeyId(table.ids.size()));
+    if (it.second) {
+        table.count.store(uint32_t(table.ids.size()), std::memory_order_release);
+    }
+    return it.first->second;
+}
+
+Properties::KeyId Properties::findKey(const std::string& _key) {
+    thread_local KeyCache t_cache;
+    auto& table = keyTable();
+
+    uint32_t count = table.count.load(std::memory_order_acquire);
+    if (t_cache.count != count || t_cache.ids.size() >= max_cached_keys) {
+        t_cache.ids.clear();
+        t_cache.count = count;
+    }
+
+    auto cached = t_cache.ids.find(_key);
+    if (cached != t_cache.ids.end()) { return cached->second; }
+
+    KeyId id;
+    {
+        std::lock_guard<std::mutex> lock(table.mutex);
+        auto it = table.ids.find(_key);
+        id = (it != table.ids.end()) ? it->second : (not_interned | KeyId(table.ids.size()));
+    }
+    t_cache.ids.emplace(_key, id);
+    return id;
+}
+
+void PropertyTable::orderKeys() {
+
+    // Assign ordering to keys for faster sorting
+    std::vector<uint32_t> orderedKeys(keys.size());
+    for (uint32_t i = 0, n = keys.size(); i < n; i++) {
+        orderedKeys[i] = i;
+    }
+    // sort by Property key ordering
+    std::sort(orderedKeys.begin(), orderedKeys.end(),
+              [&](uint32_t a, uint32_t b) {
+                  return Properties::keyComparator(keys[a], keys[b]);
+              });
+    // map key id -> rank
+    keyOrder.resize(keys.size());
+    for (uint32_t i = 0, n = orderedKeys.size(); i < n; i++) {
+        keyOrder[orderedKeys[i]] = i;
+    }
+    // map key id -> KeyId
+    keyIds.clear();
+    keyIds.reserve(keys.size());
+    for (auto& key : keys) {
+        keyIds.push_back(Properties::findKey(key));
+    }
+}
+
 Properties::Properties() : sourceId(0) {}
 
 Properties::~Properties() {}
 
+Properties::Properties(const Properties& _other)
+    : sourceId(_other.sourceId),
+      props(_other.m_table ? _other.resolvedItems() : _other.props) {}
+
+Properties& Properties::operator=(const Properties& _other) {
+    props = _other.m_table ? _other.resolvedItems() : _other.props;
+    sourceId = _other.sourceId;
+    m_table.reset();
+    m_tags.clear();
+    return *this;
+}
+
 Properties& Properties::operator=(Properties&& _other) {
     props = std::move(_other.props);
     sourceId = _other.sourceId;
+    m_table = std::move(_other.m_table);
+    m_tags = std::move(_other.m_tags);
     return *this;
 }
 
 void Properties::setSorted(std::vector<Item>&& _items) {
     props = std::move(_items);
+    m_table.reset();
+    m_tags.clear();
+}
+
+void Properties::setTags(std::shared_ptr<const PropertyTable> _table, std::vector<Tag>&& _tags) {
+    props.clear();
+    m_table = std::move(_table);
+    m_tags = std::move(_tags);
+}
+
+std::vector<Properties::Item> Properties::resolvedItems() const {
+    auto& table = *m_table;
+
+    std::vector<Tag> tags = m_tags;
+    std::stable_sort(tags.begin(), tags.end(), [&](const Tag& a, const Tag& b) {
+        return table.keyOrder[a.first] < table.keyOrder[b.first];
+    });
+
+    std::vector<Item> items;
+    items.reserve(tags.size());
+    for (size_t i = 0; i < tags.size(); i++) {
+        // When a key is repeated the last value is used
+        if (i + 1 < tags.size() && tags[i + 1].first == tags[i].first) { continue; }
+
+        uint32_t key = tags[i].first;
+        items.emplace_back(table.keys[key], table.keyIds[key], table.values[tags[i].second]);
+    }
+    return items;
+}
+
+const std::vector<Properties::Item>& Properties::items() const {
+    assert(!m_table);
+    return props;
+}
+
+void Properties::resolve() {
+    if (!m_table) { return; }
+
+    props = resolvedItems();
+
+    m_table.reset();
+    m_tags.clear();
+    m_tags.shrink_to_fit();
 }
 
 const Value& Properties::get(const std::string& key) const {
 
+    if (m_table) {
+        // Use the last value when a key is repeated
+        for (auto it = m_tags.rbegin(); it != m_tags.rend(); ++it) {
+            if (m_table->keys[it->first] == key) {
+                return m_table->values[it->second];
+            }
+        }
+        return NOT_A_VALUE;
+    }
+
     const auto it = std::find_if(props.begin(), props.end(),
                                  [&](const auto& item) {
                                      return item.key == key;
@@ -50,12 +207,37 @@ const Value& Properties::get(const std::string& key) const {
     return it->value;
 }
 
-void Properties::clear() { props.clear(); }
+const Value& Properties::get(KeyId key) const {
+
+    if (m_table) {
+        for (auto it = m_tags.rbegin(); it != m_tags.rend(); ++it) {
+            if (matchesKey(m_table->keyIds[it->first], m_table->keys[it->first], key)) {
+                return m_table->values[it->second];
+            }
+        }
+        return NOT_A_VALUE;
+    }
+
+    for (const auto& item : props) {
+        if (matchesKey(item.keyId, item.key, key)) { return item.value; }
+    }
+    return NOT_A_VALUE;
+}
+
+void Properties::clear() {
+    props.clear();
+    m_table.reset();
+    m_tags.clear();
+}
 
 bool Properties::contains(const std::string& key) const {
     return !get(key).is<none_type>();
 }
 
+bool Properties::contains(KeyId key) const {
+    return !get(key).is<none_type>();
+}
+
 bool Properties::getNumber(const std::string& key, double& value) const {
     auto& it = get(key);
     if (it.is<double>()) {
@@ -65,6 +247,15 @@ bool Properties::getNumber(const std::string& key, double& value) const {
     return false;
 }
 
+bool Properties::getNumber(KeyId key, double& value) const {
+    auto& it = get(key);
+    if (it.is<double>()) {
+        value = it.get<double>();
+        return true;
+    }
+    return false;
+}
+
 double Properties::getNumber(const std::string& key) const {
     auto& it = get(key);
     if (it.is<double>()) {
@@ -92,6 +283,16 @@ const std::string& Properties::getString(const std::string& key) const {
     return EMPTY_STRING;
 }
 
+const std::string& Properties::getString(KeyId key) const {
+    const static std::string EMPTY_STRING = "";
+
+    auto& it = get(key);
+    if (it.is<std::string>()) {
+        return it.get<std::string>();
+    }
+    return EMPTY_STRING;
+}
+
 bool Properties::getAsString(const std::string& key, std::string& value) const {
     auto& it = get(key);
 
@@ -121,12 +322,21 @@ std::string Properties::getAsString(const std::string& key) const {
 
 }
 
+std::string Properties::getAsString(KeyId key) const {
+
+    return asString(get(key));
+
+}
+
 void Properties::sort() {
+    resolve();
     std::sort(props.begin(), props.end());
 }
 
 void Properties::set(std::string key, std::string value) {
 
+    resolve();
+
     auto it = std::lower_bound(props.begin(), props.end(), key,
                                [](auto& item, auto& key) {
                                    return keyComparator(item.key, key);
@@ -141,6 +351,8 @@ void Properties::set(std::string key, std::string value) {
 
 void Properties::set(std::string key, double value) {
 
+    resolve();
+
     auto it = std::lower_bound(props.begin(), props.end(), key,
                                [](auto& item, auto& key) {
                                    return keyComparator(item.key, key);
@@ -157,8 +369,10 @@ std::string Properties::toJson() const {
 
     std::string json = "{ ";
 
-    for (const auto& item : props) {
-        bool last = (&item == &props.back());
+    const auto& items = m_table ? resolvedItems() : props;
+
+    for (const auto& item : items) {
+        bool last = (&item == &items.back());
         json += "\"" + item.key + "\": \"" + asString(item.value) + (last ? "\"" : "\",");
     }
 
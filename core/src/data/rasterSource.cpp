@@ -1,6 +1,7 @@
 #include "data/rasterSource.h"
 #include "data/propertyItem.h"
 #include "data/tileData.h"
+#include "gl/rasterAtlas.h"
 #include "tile/tile.h"
 #include "tile/tileBuilder.h"
 #include "tile/tileTask.h"
@@ -9,6 +10,8 @@
 
 namespace Tangram {
 
+constexpr int RasterSource::max_proxy_levels;
+
 class RasterTileTask : public BinaryTileTask {
 public:
 
@@ -17,6 +20,12 @@ public:
     std::unique_ptr<Texture> texture;
     std::unique_ptr<Raster> raster;
 
+    // Cached texture of a parent tile, of which the tile shows the part that
+    // covers it until the texture of this task is loaded
+    std::unique_ptr<Raster> proxy;
+    // Index of the proxy in the rasters of the tile, -1 when it is not shown
+    int proxyIndex = -1;
+
     RasterTileTask(TileID& _tileId, std::shared_ptr<TileSource> _source, bool _subTask)
         : BinaryTileTask(_tileId, _source),
           subTask(_subTask) {}
@@ -27,7 +36,7 @@ public:
     }
 
     bool hasData() const override {
-        return bool(rawTileData) || bool(texture) || bool(raster);
+        return bool(rawTileData) || bool(tileData()) || bool(texture) || bool(raster);
     }
 
     bool isReady() const override {
@@ -38,17 +47,20 @@ public:
         }
     }
 
+    void parseData() override {
+        m_parseDone = true;
+
+        auto source = rasterSource();
+        if (!source) { return; }
+
+        decodeTexture(*source);
+    }
+
     void process(TileBuilder& _tileBuilder) override {
         auto source = rasterSource();
         if (!source) { return; }
 
-        if (!texture && !raster) {
-            // Decode texture data
-            texture = source->createTexture(m_tileId, *rawTileData);
-            if (!texture) {
-                raster = std::make_unique<Raster>(m_tileId, source->emptyTexture());
-            }
-        }
+        decodeTexture(*source);
 
         // Create tile geometries
         if (!subTask) {
@@ -57,17 +69,37 @@ public:
         }
     }
 
+    void decodeTexture(RasterSource& _source) {
+        if (texture || raster) { return; }
+
+        texture = _source.createTexture(m_tileId, tileData(), tileDataSize());
+        if (!texture) {
+            raster = std::make_unique<Raster>(m_tileId, _source.emptyTexture());
+        }
+    }
+
     void addRaster(Tile& _tile) {
         auto source = rasterSource();
         if (!source) { return; }
 
         auto& rasters = _tile.rasters();
 
+        std::shared_ptr<Texture> tex;
+        TileID rasterId = m_tileId;
         if (raster) {
-            rasters.emplace_back(raster->tileID, raster->texture);
+            rasterId = raster->tileID;
+            tex = raster->texture;
+        } else {
+            tex = source->cacheTexture(m_tileId, std::move(texture));
+        }
+
+        // Replace the raster of the parent texture that was shown meanwhile
+        if (proxyIndex >= 0 && size_t(proxyIndex) < rasters.size()) {
+            rasters[proxyIndex].tileID = rasterId;
+            rasters[proxyIndex].texture = std::move(tex);
+            proxyIndex = -1;
         } else {
-            auto tex = source->cacheTexture(m_tileId, std::move(texture));
-            rasters.emplace_back(m_tileId, tex);
+            rasters.emplace_back(rasterId, std::move(tex));
         }
     }
 
@@ -75,15 +107,24 @@ public:
 
         addRaster(*m_tile);
 
-        for (auto& subTask : m_subTasks) {
-            assert(subTask->isReady());
-            subTask->complete(*this);
-        }
+        TileTask::complete();
     }
 
     void complete(TileTask& _mainTask) override {
         addRaster(*_mainTask.tile());
     }
+
+    bool hasProxy() const override { return bool(proxy); }
+
+    void completeProxy(TileTask& _mainTask) override {
+        auto& rasters = _mainTask.tile()->rasters();
+        proxyIndex = int(rasters.size());
+        rasters.emplace_back(proxy->tileID, proxy->texture);
+    }
+
+    void replaceProxy(Tile& _tile) override {
+        if (proxyIndex >= 0) { addRaster(_tile); }
+    }
 };
 
 
@@ -98,6 +139,7 @@ RasterSource::RasterSource(const std::string& _name, std::unique_ptr<DataSource>
     GLubyte pixel[4] = { 0, 0, 0, 0 };
     auto bpp = _options.bytesPerPixel();
     m_emptyTexture->setPixelData(1, 1, bpp, pixel, bpp);
+    m_emptyTexture->retainCompressedCopy();
 }
 
 void RasterSource::generateGeometry(bool _generateGeometry) {
@@ -106,13 +148,13 @@ void RasterSource::generateGeometry(bool _generateGeometry) {
     if (m_generateGeometry) {
         Feature rasterFeature;
         rasterFeature.geometryType = GeometryType::polygons;
-        rasterFeature.polygons = { { {
+        rasterFeature.addPolygon({ {
                     {0.0f, 0.0f},
                     {1.0f, 0.0f},
                     {1.0f, 1.0f},
                     {0.0f, 1.0f},
                     {0.0f, 0.0f}
-                } } };
+                } });
         rasterFeature.props = Properties();
 
         m_tileData = std::make_shared<TileData>();
@@ -121,13 +163,40 @@ void RasterSource::generateGeometry(bool _generateGeometry) {
     }
 }
 
-std::unique_ptr<Texture> RasterSource::createTexture(TileID _tile, const std::vector<char>& _rawTileData) {
-    if (_rawTileData.empty()) { return nullptr; }
+std::unique_ptr<Texture> RasterSource::createTexture(TileID _tile, const char* _data, size_t _length) {
+    if (_length == 0) { return nullptr; }
+
+    auto data = reinterpret_cast<const uint8_t*>(_data);
 
-    auto data = reinterpret_cast<const uint8_t*>(_rawTileData.data());
-    auto length = _rawTileData.size();
+    // Invalid data and compressed formats that the GPU does not support
+    // get the empty texture
+    auto texture = std::make_unique<RasterAtlasTexture>(m_texOptions);
+    if (!texture->loadImageFromMemory(data, _length, m_imageDecoder)) { return nullptr; }
 
-    return std::make_unique<Texture>(data, length, m_texOptions);
+    if (m_textureAtlas && texture->canAddToAtlas()) {
+        addToAtlas(*texture);
+    }
+    return std::move(texture);
+}
+
+void RasterSource::addToAtlas(RasterAtlasTexture& _texture) {
+    std::lock_guard<std::mutex> lock(m_atlasMutex);
+
+    int slotSize = _texture.width();
+    for (auto it = m_atlases.begin(); it != m_atlases.end();) {
+        auto atlas = it->lock();
+        if (!atlas) {
+            it = m_atlases.erase(it);
+            continue;
+        }
+        if (atlas->slotSize() == slotSize && _texture.addToAtlas(atlas)) { return; }
+        ++it;
+    }
+
+    auto atlas = std::make_shared<RasterAtlas>(m_texOptions, slotSize);
+    if (_texture.addToAtlas(atlas)) {
+        m_atlases.push_back(atlas);
+    }
 }
 
 void RasterSource::loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) {
@@ -185,9 +254,29 @@ std::shared_ptr<RasterTileTask> RasterSource::createRasterTask(TileID _tileId, b
             task->startedLoading();
         }
     }
+
+    if (subTask && !task->raster) {
+        task->proxy = parentRaster(id);
+    }
     return task;
 }
 
+std::unique_ptr<Raster> RasterSource::parentRaster(TileID _tileId) const {
+    TileID id(_tileId.x, _tileId.y, _tileId.z);
+
+    for (int i = 0; i < max_proxy_levels && id.z > 0; i++) {
+        id = TileID(id.x >> 1, id.y >> 1, id.z - 1);
+
+        auto texIt = m_textures->find(id);
+        if (texIt == m_textures->end()) { continue; }
+
+        if (auto texture = texIt->second.lock()) {
+            return std::make_unique<Raster>(id, texture);
+        }
+    }
+    return nullptr;
+}
+
 std::shared_ptr<TileTask> RasterSource::createTask(TileID _tileId) {
     auto task = createRasterTask(_tileId, false);
 
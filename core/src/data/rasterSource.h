@@ -8,10 +8,14 @@
 #include <functional>
 #include <map>
 #include <mutex>
+#include <vector>
 
 namespace Tangram {
 
+class RasterAtlas;
+class RasterAtlasTexture;
 class RasterTileTask;
+struct Raster;
 
 class RasterSource : public TileSource {
 
@@ -22,6 +26,14 @@ class RasterSource : public TileSource {
 
     std::shared_ptr<Texture> m_emptyTexture;
 
+    // Atlases of the decoded textures, by slot size. They are released with
+    // the last texture in one of their slots.
+    std::vector<std::weak_ptr<RasterAtlas>> m_atlases;
+    std::mutex m_atlasMutex;
+    bool m_textureAtlas = true;
+
+    const Platform* m_imageDecoder = nullptr;
+
     friend class RasterTileTask;
     friend class TileSource;
 protected:
@@ -33,14 +45,23 @@ protected:
 
     void addRasterTask(TileTask& _tileTask);
 
-    std::unique_ptr<Texture> createTexture(TileID _tile, const std::vector<char>& _rawTileData);
+    std::unique_ptr<Texture> createTexture(TileID _tile, const char* _data, size_t _length);
 
     std::shared_ptr<Texture> cacheTexture(const TileID& _tileId, std::unique_ptr<Texture> _texture);
 
+    // Raster of the closest parent of _tileId whose texture is cached, or null
+    std::unique_ptr<Raster> parentRaster(TileID _tileId) const;
+
+    void addToAtlas(RasterAtlasTexture& _texture);
+
     std::shared_ptr<Texture> emptyTexture() { return m_emptyTexture; }
 
 public:
 
+    // Parent levels searched for a cached texture that a raster sub-task shows
+    // while its own texture is loaded, see TileTask::hasProxy()
+    static constexpr int max_proxy_levels = 4;
+
     RasterSource(const std::string& _name, std::unique_ptr<DataSource> _sources,
                  TextureOptions _options, TileSource::ZoomOptions _zoomOptions = {});
 
@@ -55,6 +76,12 @@ public:
 
     void generateGeometry(bool _generateGeometry) override;
 
+    // Whether textures are placed in shared atlases, see RasterAtlas
+    void setTextureAtlas(bool _enabled) { m_textureAtlas = _enabled; }
+
+    // Platform that decodes raster images when it has a decoder for them
+    void setImageDecoder(const Platform* _platform) { m_imageDecoder = _platform; }
+
 };
 
 }
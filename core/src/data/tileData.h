@@ -3,8 +3,11 @@
 #include "glm/vec2.hpp"
 #include "data/properties.h"
 
-#include <vector>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 /*
 
@@ -34,10 +37,17 @@ Data heirarchy:
 
   A <Layer> contains a name and a collection of <Feature>s
 
+  A <Layer> also owns a <GeometryBuffer> holding the coordinates of all its
+  features in one contiguous buffer, with offset arrays for lines, polygon
+  rings and polygons.
+
   A <Feature> contains a <GeometryType> denoting what variety of geometry is
   contained in the feature, a <Properties> struct describing the feature, and
-  one collection each of <Point>s, <Line>s, and <Polygon>s. Only the geometry
-  collection corresponding to the feature's geometryType should contain data.
+  the ranges of its <Point>s, <Line>s, and <Polygon>s in a <GeometryBuffer>.
+  Only the geometry collection corresponding to the feature's geometryType
+  should contain data. The geometry is accessed through views: points() is a
+  span of <Point>s, lines() a view of <LineView>s and polygons() a view of
+  <PolygonView>s.
 
   A <Properties> contains a sorted vector of key-value pairs storing the
   properties of a <Feature>
@@ -50,6 +60,9 @@ Data heirarchy:
 
   A <Point> is 2 32-bit floating point coordinates representing x and y.
 
+  <Line> and <Polygon> are the owning containers used to build geometry,
+  <LineView> and <PolygonView> reference geometry in a <GeometryBuffer>.
+
 */
 namespace Tangram {
 
@@ -66,33 +79,276 @@ using Line = std::vector<Point>;
 
 using Polygon = std::vector<Line>;
 
+// Read-only view of a contiguous sequence of T
+template<typename T>
+struct Span {
+    using value_type = T;
+
+    Span() {}
+    Span(const T* _data, size_t _size) : m_data(_data), m_size(_size) {}
+    Span(const std::vector<T>& _vector) : m_data(_vector.data()), m_size(_vector.size()) {}
+
+    const T* begin() const { return m_data; }
+    const T* end() const { return m_data + m_size; }
+    const T* data() const { return m_data; }
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    const T& operator[](size_t _index) const { return m_data[_index]; }
+    const T& front() const { return m_data[0]; }
+    const T& back() const { return m_data[m_size - 1]; }
+
+private:
+    const T* m_data = nullptr;
+    size_t m_size = 0;
+};
+
+using LineView = Span<Point>;
+
+// Iterator for views whose elements are views created on access
+template<typename View>
+struct ViewIterator {
+    const View* view;
+    size_t index;
+
+    auto operator*() const { return (*view)[index]; }
+    ViewIterator& operator++() { index++; return *this; }
+    bool operator==(const ViewIterator& _other) const { return index == _other.index; }
+    bool operator!=(const ViewIterator& _other) const { return index != _other.index; }
+};
+
+struct GeometryBuffer {
+    // Coordinates of point features
+    std::vector<Point> points;
+    // Coordinates of all lines and polygon rings
+    std::vector<Point> coordinates;
+    // Offsets of line i in 'coordinates' are [lines[i], lines[i+1])
+    std::vector<uint32_t> lines = { 0 };
+    // Range of rings in 'lines' for each polygon
+    std::vector<std::pair<uint32_t, uint32_t>> polygons;
+
+    LineView line(size_t _index) const {
+        return { coordinates.data() + lines[_index], lines[_index + 1] - lines[_index] };
+    }
+
+    size_t numLines() const { return lines.size() - 1; }
+
+    void clear() {
+        points.clear();
+        coordinates.clear();
+        lines.assign(1, 0);
+        polygons.clear();
+    }
+};
+
+// View of a range of lines in a GeometryBuffer. Used for the lines
+// of a Feature and for the rings of a polygon.
+struct LinesView {
+    using value_type = LineView;
+    using iterator = ViewIterator<LinesView>;
+
+    LinesView() {}
+    LinesView(const GeometryBuffer* _buffer, size_t _begin, size_t _end)
+        : m_buffer(_buffer), m_begin(_begin), m_end(_end) {}
+
+    LineView operator[](size_t _index) const { return m_buffer->line(m_begin + _index); }
+    LineView front() const { return (*this)[0]; }
+    LineView back() const { return (*this)[size() - 1]; }
+
+    size_t size() const { return m_end - m_begin; }
+    bool empty() const { return m_end == m_begin; }
+
+    iterator begin() const { return { this, 0 }; }
+    iterator end() const { return { this, size() }; }
+
+private:
+    const GeometryBuffer* m_buffer = nullptr;
+    size_t m_begin = 0;
+    size_t m_end = 0;
+};
+
+using PolygonView = LinesView;
+
+// View of a range of polygons in a GeometryBuffer
+struct PolygonsView {
+    using value_type = PolygonView;
+    using iterator = ViewIterator<PolygonsView>;
+
+    PolygonsView() {}
+    PolygonsView(const GeometryBuffer* _buffer, size_t _begin, size_t _end)
+        : m_buffer(_buffer), m_begin(_begin), m_end(_end) {}
+
+    PolygonView operator[](size_t _index) const {
+        auto& rings = m_buffer->polygons[m_begin + _index];
+        return { m_buffer, rings.first, rings.second };
+    }
+    PolygonView front() const { return (*this)[0]; }
+    PolygonView back() const { return (*this)[size() - 1]; }
+
+    size_t size() const { return m_end - m_begin; }
+    bool empty() const { return m_end == m_begin; }
+
+    iterator begin() const { return { this, 0 }; }
+    iterator end() const { return { this, size() }; }
+
+private:
+    const GeometryBuffer* m_buffer = nullptr;
+    size_t m_begin = 0;
+    size_t m_end = 0;
+};
+
 struct Feature {
     Feature() {}
     Feature(int32_t _sourceId) { props.sourceId = _sourceId; }
 
+    // Feature that adds its geometry to the shared _geometry buffer
+    Feature(int32_t _sourceId, std::shared_ptr<GeometryBuffer> _geometry)
+        : m_geometry(std::move(_geometry)) {
+        props.sourceId = _sourceId;
+    }
+
     GeometryType geometryType = GeometryType::polygons;
 
-    std::vector<Point> points;
-    std::vector<Line> lines;
-    std::vector<Polygon> polygons;
+    // ID of the feature in the source data, e.g. of an MVT v2 feature,
+    // which identifies it across tiles. 0 when it has none.
+    uint64_t id = 0;
+
+    Span<Point> points() const {
+        if (!m_geometry) { return {}; }
+        return { m_geometry->points.data() + m_points.begin, m_points.size() };
+    }
+
+    LinesView lines() const {
+        return { m_geometry.get(), m_lines.begin, m_lines.end };
+    }
+
+    PolygonsView polygons() const {
+        return { m_geometry.get(), m_polygons.begin, m_polygons.end };
+    }
+
+    // Add geometry to this Feature. The geometry of a Feature must be added
+    // before geometry of the next Feature that shares its GeometryBuffer.
+    void addPoint(const Point& _point);
+
+    void addLine(const Point* _points, size_t _count);
+    void addLine(const Line& _line) { addLine(_line.data(), _line.size()); }
+
+    // Append points to the last line of this Feature, which must be the last
+    // geometry in its GeometryBuffer
+    void extendLine(const Point* _points, size_t _count);
+
+    // Start a new polygon. The following addRing() calls add rings to it.
+    void beginPolygon();
+    void addRing(const Point* _points, size_t _count);
+    void addRing(const Line& _ring) { addRing(_ring.data(), _ring.size()); }
+
+    void addPolygon(const Polygon& _polygon);
 
     Properties props;
+
+private:
+    struct Range {
+        uint32_t begin = 0;
+        uint32_t end = 0;
+        size_t size() const { return end - begin; }
+        // Extend the range by the element at _index
+        void add(uint32_t _index) {
+            if (begin == end) { begin = _index; }
+            end = _index + 1;
+        }
+    };
+
+    GeometryBuffer& geometry() {
+        if (!m_geometry) { m_geometry = std::make_shared<GeometryBuffer>(); }
+        return *m_geometry;
+    }
+
+    std::shared_ptr<GeometryBuffer> m_geometry;
+    Range m_points;
+    Range m_lines;
+    Range m_polygons;
 };
 
 struct Layer {
 
-    Layer(const std::string& _name) : name(_name) {}
+    Layer(const std::string& _name)
+        : name(_name), geometry(std::make_shared<GeometryBuffer>()) {}
 
     std::string name;
 
     std::vector<Feature> features;
 
+    // Geometry of the features
+    std::shared_ptr<GeometryBuffer> geometry;
+
 };
 
 struct TileData {
 
     std::vector<Layer> layers;
 
+    // Convert the property tags of the features into items. Parsers call this
+    // before the TileData is shared with the threads that build tiles.
+    void resolveProperties() {
+        for (auto& layer : layers) {
+            for (auto& feature : layer.features) { feature.props.resolve(); }
+        }
+    }
+
 };
 
+// Lets tile parsers skip the geometry of features which would not be used
+class FeatureFilter {
+public:
+    virtual ~FeatureFilter() {}
+
+    // Called before the features of the collection _name are parsed.
+    // Returns false when none of them can be used.
+    virtual bool beginLayer(const std::string& _name) = 0;
+
+    // Returns false when _feature of the current collection is not used.
+    // Properties and geometryType of _feature are set, its geometry is not.
+    virtual bool accept(const Feature& _feature) = 0;
+};
+
+inline void Feature::addPoint(const Point& _point) {
+    auto& buffer = geometry();
+    m_points.add(buffer.points.size());
+    buffer.points.push_back(_point);
+}
+
+inline void Feature::addLine(const Point* _points, size_t _count) {
+    auto& buffer = geometry();
+    buffer.coordinates.insert(buffer.coordinates.end(), _points, _points + _count);
+    m_lines.add(buffer.numLines());
+    buffer.lines.push_back(buffer.coordinates.size());
+}
+
+inline void Feature::extendLine(const Point* _points, size_t _count) {
+    auto& buffer = geometry();
+    buffer.coordinates.insert(buffer.coordinates.end(), _points, _points + _count);
+    buffer.lines.back() = buffer.coordinates.size();
+}
+
+inline void Feature::beginPolygon() {
+    auto& buffer = geometry();
+    m_polygons.add(buffer.polygons.size());
+    uint32_t ring = buffer.numLines();
+    buffer.polygons.emplace_back(ring, ring);
+}
+
+inline void Feature::addRing(const Point* _points, size_t _count) {
+    auto& buffer = geometry();
+    if (m_polygons.size() == 0) { beginPolygon(); }
+
+    buffer.coordinates.insert(buffer.coordinates.end(), _points, _points + _count);
+    buffer.lines.push_back(buffer.coordinates.size());
+    buffer.polygons.back().second = buffer.numLines();
+}
+
+inline void Feature::addPolygon(const Polygon& _polygon) {
+    beginPolygon();
+    for (const auto& ring : _polygon) { addRing(ring); }
+}
+
 }
@@ -10,13 +10,42 @@
 #include "tile/tile.h"
 #include "tile/tileTask.h"
 #include "log.h"
+#include "map.h"
 #include "util/geom.h"
 
+#include <algorithm>
 #include <atomic>
+#include <cassert>
 #include <functional>
 
 namespace Tangram {
 
+constexpr size_t TileSource::overzoom_cache_tiles;
+
+// Parsed TileData shared between sources, most recently used first. The
+// entries do not own the data, it is released with the last source or task
+// that holds it.
+struct SharedTileData {
+    struct Entry {
+        std::string key;
+        TileSource::Format format;
+        TileID id;
+        uint64_t dataHash;
+        std::weak_ptr<TileData> data;
+    };
+    static constexpr size_t max_entries = 64;
+
+    std::mutex mutex;
+    std::vector<Entry> entries;
+};
+
+constexpr size_t SharedTileData::max_entries;
+
+static SharedTileData& sharedTileData() {
+    static SharedTileData s_data;
+    return s_data;
+}
+
 TileSource::TileSource(const std::string& _name, std::unique_ptr<DataSource> _sources,
                        ZoomOptions _zoomOptions) :
     m_name(_name),
@@ -28,9 +57,8 @@ TileSource::TileSource(const std::string& _name, std::unique_ptr<DataSource> _so
     m_id = s_serial++;
 }
 
-TileSource::~TileSource() {
-    clearData();
-}
+// Caches shared with sources of other scenes are kept
+TileSource::~TileSource() {}
 
 int32_t TileSource::zoomBiasFromTileSize(int32_t tileSize) {
     const auto BaseTileSize = 256;
@@ -75,9 +103,32 @@ void TileSource::clearData() {
 
     if (m_sources) { m_sources->clear(); }
 
+    {
+        std::lock_guard<std::mutex> lock(m_overzoomMutex);
+        m_overzoomData.clear();
+    }
+
     m_generation++;
 }
 
+void TileSource::getMemoryUsage(MemoryUsage& _usage) const {
+
+    if (m_sources) { _usage.cpuBytes[MemoryUsage::data_cache] += m_sources->memoryUsage(); }
+}
+
+void TileSource::releaseMemory() {
+
+    if (m_sources) { m_sources->releaseMemory(); }
+
+    std::lock_guard<std::mutex> lock(m_overzoomMutex);
+    m_overzoomData.clear();
+}
+
+void TileSource::copyCache(const TileSource& _previous) {
+
+    if (m_sources && _previous.m_sources) { m_sources->copyCache(*_previous.m_sources); }
+}
+
 void TileSource::loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) {
 
     if (m_sources) {
@@ -105,6 +156,86 @@ std::shared_ptr<TileData> TileSource::parse(const TileTask& _task) const {
     return nullptr;
 }
 
+std::shared_ptr<TileData> TileSource::parseOverzoomed(const TileTask& _task) const {
+    assert(_task.featureFilter() == nullptr);
+
+    const auto& tileId = _task.tileId();
+    TileID dataId(tileId.x, tileId.y, tileId.z);
+    int64_t generation = _task.sourceGeneration();
+
+    {
+        std::lock_guard<std::mutex> lock(m_overzoomMutex);
+        auto it = std::find_if(m_overzoomData.begin(), m_overzoomData.end(), [&](auto& _entry) {
+            return _entry.id == dataId && _entry.generation == generation;
+        });
+        if (it != m_overzoomData.end()) {
+            std::rotate(m_overzoomData.begin(), it, it + 1);
+            return m_overzoomData.front().data;
+        }
+    }
+
+    std::shared_ptr<TileData> data;
+
+    // Sources of other Maps may have parsed the same data
+    uint64_t dataHash = m_sharedDataKey.empty() ? 0 : _task.dataHash();
+    if (dataHash != 0) {
+        auto& shared = sharedTileData();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        auto it = std::find_if(shared.entries.begin(), shared.entries.end(), [&](auto& _entry) {
+            return _entry.id == dataId && _entry.dataHash == dataHash &&
+                _entry.format == m_format && _entry.key == m_sharedDataKey;
+        });
+        if (it != shared.entries.end()) {
+            data = it->data.lock();
+            if (data) {
+                std::rotate(shared.entries.begin(), it, it + 1);
+            } else {
+                shared.entries.erase(it);
+            }
+        }
+    }
+
+    if (!data) {
+        // Tiles of other zoom levels may parse the same data meanwhile
+        data = parse(_task);
+        if (!data) { return nullptr; }
+
+        // The tasks of all overzoomed tiles only read the shared data
+        data->resolveProperties();
+
+        if (dataHash != 0) {
+            auto& shared = sharedTileData();
+            std::lock_guard<std::mutex> lock(shared.mutex);
+            shared.entries.erase(std::remove_if(shared.entries.begin(), shared.entries.end(),
+                                                [](auto& _entry) { return _entry.data.expired(); }),
+                                 shared.entries.end());
+            shared.entries.insert(shared.entries.begin(),
+                                  SharedTileData::Entry{ m_sharedDataKey, m_format, dataId, dataHash, data });
+            if (shared.entries.size() > SharedTileData::max_entries) {
+                shared.entries.pop_back();
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_overzoomMutex);
+    m_overzoomData.insert(m_overzoomData.begin(), OverzoomEntry{ dataId, generation, data });
+    if (m_overzoomData.size() > overzoom_cache_tiles) {
+        m_overzoomData.pop_back();
+    }
+    return data;
+}
+
+void TileSource::setSharedData(const std::string& _key) {
+    m_sharedDataKey = _key;
+}
+
+size_t TileSource::sharedDataCount() {
+    auto& shared = sharedTileData();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    return std::count_if(shared.entries.begin(), shared.entries.end(),
+                         [](auto& _entry) { return !_entry.data.expired(); });
+}
+
 void TileSource::cancelLoadingTile(TileTask& _task) {
 
     if (m_sources) { m_sources->cancelLoadingTile(_task); }
@@ -114,6 +245,15 @@ void TileSource::cancelLoadingTile(TileTask& _task) {
     }
 }
 
+void TileSource::updateTilePriority(TileTask& _task) {
+
+    if (m_sources) { m_sources->updateTilePriority(_task); }
+
+    for (auto& subTask : _task.subTasks()) {
+        if (auto source = subTask->source()) { source->updateTilePriority(*subTask); }
+    }
+}
+
 void TileSource::addRasterSource(std::shared_ptr<TileSource> _rasterSource) {
     if (!_rasterSource) {
         LOGE("No raster source");
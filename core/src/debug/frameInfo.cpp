@@ -5,9 +5,12 @@
 #include "gl/glError.h"
 #include "gl/primitives.h"
 #include "map.h"
+#include "text/fontContext.h"
+#include "tile/tileBuilder.h"
 #include "tile/tileManager.h"
 #include "tile/tile.h"
 #include "tile/tileCache.h"
+#include "util/builders.h"
 #include "view/view.h"
 
 #include <deque>
@@ -49,6 +52,8 @@ void FrameInfo::beginFrame() {
         s_startFrameTime = clock();
     }
 
+    Builders::collectTessellationStats(getDebugFlag(DebugFlags::tangram_infos));
+
 }
 
 
@@ -117,6 +122,20 @@ void FrameInfo::draw(RenderState& rs, const View& _view, const TileManager& _til
             debuginfos.push_back("tile cache size:"
                                  + std::to_string(_tileManager.getTileCache()->getMemoryUsage() / 1024) + "kb");
             debuginfos.push_back("tile size:" + std::to_string(memused / 1024) + "kb");
+            auto scratch = TileBuilder::scratchStats();
+            debuginfos.push_back("builder buffers reused/allocated:"
+                                 + std::to_string(scratch.reusedBytes / 1024) + "kb/"
+                                 + std::to_string(scratch.allocatedBytes / 1024) + "kb");
+            auto tessellation = Builders::tessellationStats();
+            debuginfos.push_back("polygons tessellated/convex/cached:"
+                                 + std::to_string(tessellation.polygons) + "/"
+                                 + std::to_string(tessellation.convex) + "/"
+                                 + std::to_string(tessellation.cached) + " in "
+                                 + to_string_with_precision(tessellation.nanoseconds / 1e6, 2) + "ms");
+            auto layouts = FontContext::layoutCacheStats();
+            debuginfos.push_back("text layouts cached/shaped:"
+                                 + std::to_string(layouts.hits) + "/"
+                                 + std::to_string(layouts.misses));
             debuginfos.push_back("avg frame cpu time:" + to_string_with_precision(avgTimeCpu, 2) + "ms");
             debuginfos.push_back("avg frame render time:" + to_string_with_precision(avgTimeRender, 2) + "ms");
             debuginfos.push_back("avg frame update time:" + to_string_with_precision(avgTimeUpdate, 2) + "ms");
@@ -0,0 +1,168 @@
+#include "debug/metrics.h"
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+namespace Tangram {
+
+constexpr size_t MetricsHistogram::bucketCount;
+
+std::atomic<bool> Metrics::s_enabled{false};
+
+namespace {
+
+struct ThreadMetrics;
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<ThreadMetrics*> threads;
+    // Metrics of threads that have exited
+    PipelineMetrics retired;
+};
+
+// Never destroyed, threads may exit after static destructors ran
+Registry& registry() {
+    static auto* s_registry = new Registry();
+    return *s_registry;
+}
+
+void add(MetricsHistogram& _histogram, Metrics::Clock::duration _duration) {
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(_duration).count();
+    double ms = std::chrono::duration<double, std::milli>(_duration).count();
+
+    size_t bucket = 0;
+    while (us > 0 && bucket < MetricsHistogram::bucketCount - 1) {
+        us >>= 1;
+        bucket++;
+    }
+    _histogram.buckets[bucket]++;
+    _histogram.count++;
+    _histogram.totalMs += ms;
+    _histogram.maxMs = std::max(_histogram.maxMs, ms);
+}
+
+void merge(MetricsHistogram& _dst, const MetricsHistogram& _src) {
+    for (size_t i = 0; i < MetricsHistogram::bucketCount; i++) {
+        _dst.buckets[i] += _src.buckets[i];
+    }
+    _dst.count += _src.count;
+    _dst.totalMs += _src.totalMs;
+    _dst.maxMs = std::max(_dst.maxMs, _src.maxMs);
+}
+
+void merge(PipelineMetrics& _dst, const PipelineMetrics& _src) {
+    for (size_t i = 0; i < PipelineMetrics::stage_count; i++) {
+        merge(_dst.stages[i], _src.stages[i]);
+    }
+    for (const auto& style : _src.renderStyles) {
+        merge(_dst.renderStyles[style.first], style.second);
+    }
+    for (const auto& style : _src.renderStylesGpu) {
+        merge(_dst.renderStylesGpu[style.first], style.second);
+    }
+    merge(_dst.selectionGpu, _src.selectionGpu);
+    for (const auto& style : _src.renderStyleDraws) {
+        auto& counts = _dst.renderStyleDraws[style.first];
+        counts.drawCalls += style.second.drawCalls;
+        counts.vertices += style.second.vertices;
+        counts.stateChanges += style.second.stateChanges;
+    }
+    for (size_t i = 0; i < PipelineMetrics::counter_count; i++) {
+        _dst.counters[i] += _src.counters[i];
+    }
+}
+
+struct ThreadMetrics {
+    // Only contended while the metrics are collected
+    std::mutex mutex;
+    PipelineMetrics metrics;
+
+    ThreadMetrics() {
+        auto& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.threads.push_back(this);
+    }
+
+    ~ThreadMetrics() {
+        auto& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.threads.erase(std::find(r.threads.begin(), r.threads.end(), this));
+        merge(r.retired, metrics);
+    }
+};
+
+ThreadMetrics& threadMetrics() {
+    static thread_local ThreadMetrics t_metrics;
+    return t_metrics;
+}
+
+}
+
+void Metrics::setEnabled(bool _enabled) {
+    s_enabled = _enabled;
+}
+
+void Metrics::record(Stage _stage, Clock::duration _duration) {
+    auto& thread = threadMetrics();
+    std::lock_guard<std::mutex> lock(thread.mutex);
+    Tangram::add(thread.metrics.stages[_stage], _duration);
+}
+
+void Metrics::recordStyle(const std::string& _style, Clock::duration _duration) {
+    if (!enabled()) { return; }
+
+    auto& thread = threadMetrics();
+    std::lock_guard<std::mutex> lock(thread.mutex);
+    Tangram::add(thread.metrics.renderStyles[_style], _duration);
+}
+
+void Metrics::recordStyleGpu(const std::string& _style, Clock::duration _duration) {
+    if (!enabled()) { return; }
+
+    auto& thread = threadMetrics();
+    std::lock_guard<std::mutex> lock(thread.mutex);
+    Tangram::add(thread.metrics.renderStylesGpu[_style], _duration);
+}
+
+void Metrics::recordSelectionGpu(Clock::duration _duration) {
+    if (!enabled()) { return; }
+
+    auto& thread = threadMetrics();
+    std::lock_guard<std::mutex> lock(thread.mutex);
+    Tangram::add(thread.metrics.selectionGpu, _duration);
+}
+
+void Metrics::countStyleDraws(const std::string& _style, const PipelineMetrics::DrawCounts& _counts) {
+    if (!enabled()) { return; }
+
+    auto& thread = threadMetrics();
+    std::lock_guard<std::mutex> lock(thread.mutex);
+    auto& counts = thread.metrics.renderStyleDraws[_style];
+    counts.drawCalls += _counts.drawCalls;
+    counts.vertices += _counts.vertices;
+    counts.stateChanges += _counts.stateChanges;
+}
+
+void Metrics::add(Counter _counter, uint64_t _value) {
+    auto& thread = threadMetrics();
+    std::lock_guard<std::mutex> lock(thread.mutex);
+    thread.metrics.counters[_counter] += _value;
+}
+
+PipelineMetrics Metrics::collect(bool _reset) {
+    auto& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+
+    PipelineMetrics result = r.retired;
+    if (_reset) { r.retired = PipelineMetrics(); }
+
+    for (auto* thread : r.threads) {
+        std::lock_guard<std::mutex> threadLock(thread->mutex);
+        merge(result, thread->metrics);
+        if (_reset) { thread->metrics = PipelineMetrics(); }
+    }
+    return result;
+}
+
+}
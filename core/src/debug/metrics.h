@@ -0,0 +1,68 @@
+#pragma once
+
+#include "map.h"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+namespace Tangram {
+
+/* Collection of PipelineMetrics
+ *
+ * Each thread records into its own PipelineMetrics, so that recording only
+ * takes an uncontended lock. collect() merges the metrics of all threads.
+ * Nothing is recorded while metrics are disabled.
+ */
+class Metrics {
+
+public:
+
+    using Stage = PipelineMetrics::Stage;
+    using Counter = PipelineMetrics::Counter;
+    using Clock = std::chrono::steady_clock;
+
+    static bool enabled() { return s_enabled.load(std::memory_order_relaxed); }
+    static void setEnabled(bool _enabled);
+
+    // Start time of a stage, or a zero time_point when disabled
+    static Clock::time_point start() {
+        return enabled() ? Clock::now() : Clock::time_point();
+    }
+
+    // Record the time since _start, unless _start is zero
+    static void record(Stage _stage, Clock::time_point _start) {
+        if (_start != Clock::time_point()) { record(_stage, Clock::now() - _start); }
+    }
+    static void record(Stage _stage, Clock::duration _duration);
+
+    static void recordStyle(const std::string& _style, Clock::duration _duration);
+
+    static void recordStyleGpu(const std::string& _style, Clock::duration _duration);
+
+    static void recordSelectionGpu(Clock::duration _duration);
+
+    static void countStyleDraws(const std::string& _style, const PipelineMetrics::DrawCounts& _counts);
+
+    static void count(Counter _counter, uint64_t _value = 1) {
+        if (enabled()) { add(_counter, _value); }
+    }
+
+    static PipelineMetrics collect(bool _reset);
+
+    // Records the lifetime of the scope
+    struct Timer {
+        explicit Timer(Stage _stage) : stage(_stage), begin(start()) {}
+        ~Timer() { record(stage, begin); }
+        Stage stage;
+        Clock::time_point begin;
+    };
+
+private:
+
+    static void add(Counter _counter, uint64_t _value);
+
+    static std::atomic<bool> s_enabled;
+};
+
+}
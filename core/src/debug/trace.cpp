@@ -0,0 +1,120 @@
+#include "debug/trace.h"
+
+#include <vector>
+
+namespace Tangram {
+
+constexpr size_t Trace::capacity;
+
+std::atomic<bool> Trace::s_enabled{false};
+
+namespace {
+
+// A slot is written like a seqlock: its state is odd while an event is
+// written and 2 * (sequence + 1) once the event with sequence is complete.
+struct Slot {
+    std::atomic<uint64_t> state{0};
+    std::atomic<const char*> name{nullptr};
+    std::atomic<int64_t> begin{0};
+    std::atomic<int64_t> duration{0};
+    std::atomic<uint32_t> thread{0};
+};
+
+Slot s_slots[Trace::capacity];
+
+// Sequence of the next event
+std::atomic<uint64_t> s_next{0};
+
+// Events before this sequence were cleared
+std::atomic<uint64_t> s_cleared{0};
+
+std::atomic<uint32_t> s_nextThread{1};
+
+struct Event {
+    const char* name;
+    int64_t begin;
+    int64_t duration;
+    uint32_t thread;
+};
+
+Trace::Clock::time_point epoch() {
+    static const auto s_epoch = Trace::Clock::now();
+    return s_epoch;
+}
+
+int64_t micros(Trace::Clock::duration _duration) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(_duration).count();
+}
+
+uint32_t threadId() {
+    static thread_local uint32_t t_thread = s_nextThread++;
+    return t_thread;
+}
+
+}
+
+void Trace::setEnabled(bool _enabled) {
+    epoch();
+    s_enabled = _enabled;
+}
+
+void Trace::record(const char* _name, Clock::time_point _begin) {
+    auto end = Clock::now();
+
+    uint64_t sequence = s_next.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = s_slots[sequence % capacity];
+
+    slot.state.store(2 * sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.name.store(_name, std::memory_order_relaxed);
+    slot.begin.store(micros(_begin - epoch()), std::memory_order_relaxed);
+    slot.duration.store(micros(end - _begin), std::memory_order_relaxed);
+    slot.thread.store(threadId(), std::memory_order_relaxed);
+
+    slot.state.store(2 * sequence + 2, std::memory_order_release);
+}
+
+std::string Trace::toJson(bool _clear) {
+
+    uint64_t end = s_next.load();
+    uint64_t begin = s_cleared.load();
+    if (end - begin > capacity) { begin = end - capacity; }
+
+    std::vector<Event> events;
+    events.reserve(end - begin);
+
+    for (uint64_t sequence = begin; sequence < end; sequence++) {
+        const Slot& slot = s_slots[sequence % capacity];
+
+        uint64_t state = slot.state.load(std::memory_order_acquire);
+        Event event{ slot.name.load(std::memory_order_relaxed),
+                     slot.begin.load(std::memory_order_relaxed),
+                     slot.duration.load(std::memory_order_relaxed),
+                     slot.thread.load(std::memory_order_relaxed) };
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        // Skip events that are still written or were overwritten meanwhile
+        if (state != 2 * sequence + 2 || slot.state.load(std::memory_order_relaxed) != state) {
+            continue;
+        }
+        events.push_back(event);
+    }
+
+    if (_clear) { s_cleared = end; }
+
+    std::string json = "{\"traceEvents\":[";
+    for (size_t i = 0; i < events.size(); i++) {
+        const auto& event = events[i];
+        if (i > 0) { json += ','; }
+        json += "{\"name\":\"";
+        json += event.name;
+        json += "\",\"ph\":\"X\",\"pid\":1,\"tid\":" + std::to_string(event.thread) +
+            ",\"ts\":" + std::to_string(event.begin) +
+            ",\"dur\":" + std::to_string(event.duration) + "}";
+    }
+    json += "],\"displayTimeUnit\":\"ms\"}";
+    return json;
+}
+
+}
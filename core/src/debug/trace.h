@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace Tangram {
+
+/* Recording of timed events in the Chrome trace format
+ *
+ * Events are written into a fixed size ring buffer without locks; when it is
+ * full the oldest events are overwritten. Event names must be string literals,
+ * only their pointers are stored. Nothing is recorded while tracing is
+ * disabled.
+ *
+ * The output of toJson() can be opened in chrome://tracing or Perfetto.
+ */
+class Trace {
+
+public:
+
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr size_t capacity = 1 << 16;
+
+    static bool enabled() { return s_enabled.load(std::memory_order_relaxed); }
+    static void setEnabled(bool _enabled);
+
+    // Record an event of the current thread from _begin to now
+    static void record(const char* _name, Clock::time_point _begin);
+
+    // JSON of the recorded events, oldest first. Removes them when _clear is true.
+    static std::string toJson(bool _clear);
+
+    // Records the lifetime of the scope
+    struct Scope {
+        explicit Scope(const char* _name) : name(_name) {
+            if (enabled()) { begin = Clock::now(); }
+        }
+        ~Scope() {
+            if (begin != Clock::time_point()) { record(name, begin); }
+        }
+        const char* name;
+        Clock::time_point begin;
+    };
+
+private:
+
+    static std::atomic<bool> s_enabled;
+};
+
+}
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) Tangram::Trace::Scope TRACE_CONCAT(traceScope_, __LINE__)(name)
@@ -12,6 +12,8 @@ typedef ptrdiff_t GLsizeiptr;
 typedef ptrdiff_t GLintptr;
 #endif
 
+#include <stdint.h>
+
 /*
  * Mesa 3-D graphics library
  *
@@ -196,6 +198,10 @@ typedef char            GLchar;
 #define GL_DEPTH_WRITEMASK              0x0B72
 #define GL_DEPTH_COMPONENT              0x1902
 #define GL_DEPTH_COMPONENT16            0x81A5
+#define GL_DEPTH24_STENCIL8             0x88F0
+
+/* Scissor */
+#define GL_SCISSOR_TEST                 0x0C11
 
 /* Stencil */
 #define GL_STENCIL_BITS                 0x0D57
@@ -268,6 +274,45 @@ typedef char            GLchar;
 #define GL_LINK_STATUS                  0x8B82
 #define GL_INFO_LOG_LENGTH              0x8B84
 
+// Uniform buffers
+#define GL_UNIFORM_BUFFER               0x8A11
+#define GL_UNIFORM_OFFSET               0x8A3B
+#define GL_UNIFORM_BLOCK_DATA_SIZE      0x8A40
+#define GL_INVALID_INDEX                0xFFFFFFFFu
+
+// Program binaries
+#define GL_PROGRAM_BINARY_LENGTH        0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS   0x87FE
+
+// Compressed texture formats
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#define GL_COMPRESSED_RGBA_BPTC_UNORM   0x8E8C
+#define GL_COMPRESSED_RGB8_ETC2         0x9274
+#define GL_COMPRESSED_RGBA8_ETC2_EAC    0x9278
+#define GL_COMPRESSED_RGBA_ASTC_4x4_KHR 0x93B0
+
+// KHR_parallel_shader_compile
+#define GL_COMPLETION_STATUS_KHR        0x91B1
+
+// Pixel buffer objects
+#define GL_PIXEL_PACK_BUFFER            0x88EB
+#define GL_STREAM_READ                  0x88E1
+#define GL_MAP_READ_BIT                 0x0001
+
+// Compute shaders
+#define GL_COMPUTE_SHADER               0x91B9
+#define GL_SHADER_STORAGE_BUFFER        0x90D2
+#define GL_SHADER_STORAGE_BARRIER_BIT   0x00002000
+#define GL_BUFFER_UPDATE_BARRIER_BIT    0x00000200
+
+// Timer queries
+#define GL_TIME_ELAPSED                 0x88BF
+#define GL_QUERY_RESULT                 0x8866
+#define GL_QUERY_RESULT_AVAILABLE       0x8867
+#define GL_GPU_DISJOINT_EXT             0x8FBB
+
 // mapbuffer
 #define GL_READ_ONLY                    0x88B8
 #define GL_WRITE_ONLY                   0x88B9
@@ -275,6 +320,9 @@ typedef char            GLchar;
 
 #define GL_MAX_TEXTURE_SIZE             0x0D33
 #define GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS 0x8B4D
+#define GL_MAX_VERTEX_TEXTURE_IMAGE_UNITS 0x8B4C
+#define GL_MAX_VERTEX_UNIFORM_COMPONENTS 0x8B4A
+#define GL_MAX_VERTEX_UNIFORM_VECTORS   0x8DFB
 
 namespace Tangram {
 struct GL {
@@ -284,6 +332,7 @@ struct GL {
     static void clear(GLbitfield mask);
     static void lineWidth(GLfloat width);
     static void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+    static void scissor(GLint x, GLint y, GLsizei width, GLsizei height);
 
     static void enable(GLenum);
     static void disable(GLenum);
@@ -326,6 +375,21 @@ struct GL {
     static void bufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usage);
     static void bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void *data);
 
+    // Uniform buffers
+    static void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+    static GLuint getUniformBlockIndex(GLuint program, const GLchar *uniformBlockName);
+    static void uniformBlockBinding(GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding);
+    static void getActiveUniformBlockiv(GLuint program, GLuint uniformBlockIndex, GLenum pname, GLint *params);
+    static void getUniformIndices(GLuint program, GLsizei uniformCount, const GLchar *const*uniformNames,
+                                  GLuint *uniformIndices);
+    static void getActiveUniformsiv(GLuint program, GLsizei uniformCount, const GLuint *uniformIndices,
+                                    GLenum pname, GLint *params);
+
+    // Program binaries
+    static void getProgramBinary(GLuint program, GLsizei bufSize, GLsizei *length,
+                                 GLenum *binaryFormat, void *binary);
+    static void programBinary(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
+
     // Framebuffers
     static void bindFramebuffer(GLenum target, GLuint framebuffer);
     static void genFramebuffers(GLsizei n, GLuint *framebuffers);
@@ -363,6 +427,12 @@ struct GL {
                            GLint border, GLenum format, GLenum type,
                            const GLvoid *pixels);
 
+    static void compressedTexImage2D(GLenum target, GLint level,
+                                     GLenum internalFormat,
+                                     GLsizei width, GLsizei height,
+                                     GLint border, GLsizei imageSize,
+                                     const GLvoid *data);
+
     static void texSubImage2D(GLenum target, GLint level,
                               GLint xoffset, GLint yoffset,
                               GLsizei width, GLsizei height,
@@ -380,6 +450,13 @@ struct GL {
     static void drawArrays(GLenum mode, GLint first, GLsizei count );
     static void drawElements(GLenum mode, GLsizei count,
                              GLenum type, const GLvoid *indices );
+    static void drawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type,
+                                       const GLvoid *indices, GLint basevertex);
+
+    // instancing
+    static void vertexAttribDivisor(GLuint index, GLuint divisor);
+    static void drawElementsInstanced(GLenum mode, GLsizei count, GLenum type,
+                                      const GLvoid *indices, GLsizei instancecount);
 
     static void uniform1f(GLint location, GLfloat v0);
     static void uniform2f(GLint location, GLfloat v0, GLfloat v1);
@@ -407,6 +484,7 @@ struct GL {
     // mapbuffer
     static void *mapBuffer(GLenum target, GLenum access);
     static GLboolean unmapBuffer(GLenum target);
+    static void *mapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
 
     static void finish(void);
 
@@ -417,5 +495,17 @@ struct GL {
     static void deleteVertexArrays(GLsizei n, const GLuint *arrays);
     static void genVertexArrays(GLsizei n, GLuint *arrays);
 
+    // Compute shaders
+    static void dispatchCompute(GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z);
+    static void memoryBarrier(GLbitfield barriers);
+
+    // Timer queries
+    static void genQueries(GLsizei n, GLuint *ids);
+    static void deleteQueries(GLsizei n, const GLuint *ids);
+    static void beginQuery(GLenum target, GLuint id);
+    static void endQuery(GLenum target);
+    static void getQueryObjectuiv(GLuint id, GLenum pname, GLuint *params);
+    static void getQueryObjectui64v(GLuint id, GLenum pname, uint64_t *params);
+
 };
 }
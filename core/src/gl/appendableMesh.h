@@ -0,0 +1,245 @@
+#pragma once
+
+#include "gl/mesh.h"
+#include "gl/glError.h"
+#include "gl/hardware.h"
+#include "gl/renderState.h"
+#include "gl/shaderProgram.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace Tangram {
+
+/*
+ * AppendableMesh - Mesh of geometry that grows at its end, like the line of a
+ * GPS trail. Each part keeps its vertices and indices in buffers of their own,
+ * whose storage doubles when it is full, so that appending to a part uploads
+ * only the geometry that changed since the last draw.
+ */
+template<class T>
+class AppendableMesh : public StyledMesh, protected MeshBase {
+
+public:
+
+    AppendableMesh(std::shared_ptr<VertexLayout> _vertexLayout, GLenum _drawMode, size_t _parts)
+        : MeshBase(_vertexLayout, _drawMode, GL_DYNAMIC_DRAW),
+          m_parts(_parts) {
+        m_isCompiled = true;
+        m_indexType = Hardware::supportsElementIndexUint ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
+    }
+
+    ~AppendableMesh() override;
+
+    /*
+     * Replace the end of _part, the geometry that the last append marked as
+     * its end, by _data. The indices of _data refer to the _sharedVertices
+     * vertices before the first vertex of _data, and its last _endVertices
+     * vertices and _endIndices indices are the end that the next append
+     * replaces. Returns false when the part would exceed the index range.
+     */
+    bool append(size_t _part, const MeshData<T>& _data, size_t _sharedVertices,
+                size_t _endVertices, size_t _endIndices);
+
+    bool draw(RenderState& rs, ShaderProgram& _shader, bool _useVao = true) override;
+
+    void uploadGeometry(RenderState& rs) override { upload(rs); }
+
+    size_t bufferSize() const override;
+
+    // The geometry is kept in memory for the next append
+    size_t cpuBufferSize() const override { return bufferSize(); }
+
+    void upload(RenderState& rs) override;
+
+private:
+
+    struct Part {
+        std::vector<T> vertices;
+        std::vector<GLuint> indices;
+
+        size_t endVertices = 0;
+        size_t endIndices = 0;
+
+        GLuint vertexBuffer = 0;
+        GLuint indexBuffer = 0;
+        // Elements the buffers have storage for
+        size_t vertexCapacity = 0;
+        size_t indexCapacity = 0;
+        // Elements in the buffers that did not change since the last upload
+        size_t uploadedVertices = 0;
+        size_t uploadedIndices = 0;
+    };
+
+    void uploadPart(RenderState& rs, Part& _part);
+
+    std::vector<Part> m_parts;
+};
+
+template<class T>
+AppendableMesh<T>::~AppendableMesh() {
+    // Buffers of a lost context were already deleted with it
+    if (m_rs && m_rsGeneration == m_rs->handleGeneration()) {
+        for (auto& part : m_parts) {
+            if (part.vertexBuffer) { m_rs->queueBufferDeletion(1, &part.vertexBuffer); }
+            if (part.indexBuffer) { m_rs->queueBufferDeletion(1, &part.indexBuffer); }
+        }
+    }
+}
+
+template<class T>
+bool AppendableMesh<T>::append(size_t _part, const MeshData<T>& _data, size_t _sharedVertices,
+                               size_t _endVertices, size_t _endIndices) {
+
+    auto& part = m_parts[_part];
+
+    size_t vertices = part.vertices.size() - part.endVertices;
+    size_t indices = part.indices.size() - part.endIndices;
+    size_t maxVertices = (m_indexType == GL_UNSIGNED_INT) ? 0xffffffff : MAX_INDEX_VALUE;
+
+    if (_sharedVertices > vertices || vertices + _data.vertices.size() > maxVertices) {
+        return false;
+    }
+
+    part.vertices.erase(part.vertices.begin() + vertices, part.vertices.end());
+    part.indices.erase(part.indices.begin() + indices, part.indices.end());
+    part.vertices.insert(part.vertices.end(), _data.vertices.begin(), _data.vertices.end());
+
+    // The indices of each line of _data start at its first vertex
+    size_t base = vertices - _sharedVertices;
+    size_t src = 0;
+    for (auto& offset : _data.offsets) {
+        for (size_t i = 0; i < offset.first; i++) {
+            part.indices.push_back(base + _data.indices[src++]);
+        }
+        base += offset.second;
+    }
+
+    part.endVertices = _endVertices;
+    part.endIndices = _endIndices;
+
+    part.uploadedVertices = std::min(part.uploadedVertices, vertices);
+    part.uploadedIndices = std::min(part.uploadedIndices, indices);
+
+    m_nVertices = 0;
+    m_nIndices = 0;
+    for (auto& p : m_parts) {
+        m_nVertices += p.vertices.size();
+        m_nIndices += p.indices.size();
+    }
+    m_isUploaded = false;
+
+    return true;
+}
+
+template<class T>
+void AppendableMesh<T>::uploadPart(RenderState& rs, Part& _part) {
+
+    size_t stride = m_vertexLayout->getStride();
+
+    if (_part.vertexBuffer == 0) { GL::genBuffers(1, &_part.vertexBuffer); }
+    if (_part.indexBuffer == 0) { GL::genBuffers(1, &_part.indexBuffer); }
+
+    rs.vertexBuffer(_part.vertexBuffer);
+
+    size_t count = _part.vertices.size();
+    auto* vertexData = reinterpret_cast<const GLbyte*>(_part.vertices.data());
+
+    if (count > _part.vertexCapacity) {
+        _part.vertexCapacity = std::max(count, 2 * _part.vertexCapacity);
+        GL::bufferData(GL_ARRAY_BUFFER, _part.vertexCapacity * stride, nullptr, m_hint);
+        _part.uploadedVertices = 0;
+    }
+    if (_part.uploadedVertices < count) {
+        size_t first = _part.uploadedVertices;
+        GL::bufferSubData(GL_ARRAY_BUFFER, first * stride, (count - first) * stride,
+                          vertexData + first * stride);
+        rs.addUploadedBytes((count - first) * stride);
+    }
+    _part.uploadedVertices = count;
+
+    rs.indexBuffer(_part.indexBuffer);
+
+    count = _part.indices.size();
+    size_t size = indexSize();
+
+    if (count > _part.indexCapacity) {
+        _part.indexCapacity = std::max(count, 2 * _part.indexCapacity);
+        GL::bufferData(GL_ELEMENT_ARRAY_BUFFER, _part.indexCapacity * size, nullptr, m_hint);
+        _part.uploadedIndices = 0;
+    }
+    if (_part.uploadedIndices < count) {
+        size_t first = _part.uploadedIndices;
+        if (m_indexType == GL_UNSIGNED_INT) {
+            GL::bufferSubData(GL_ELEMENT_ARRAY_BUFFER, first * size, (count - first) * size,
+                              reinterpret_cast<const GLbyte*>(_part.indices.data() + first));
+        } else {
+            std::vector<GLushort> indices(_part.indices.begin() + first, _part.indices.end());
+            GL::bufferSubData(GL_ELEMENT_ARRAY_BUFFER, first * size, (count - first) * size,
+                              reinterpret_cast<const GLbyte*>(indices.data()));
+        }
+        rs.addUploadedBytes((count - first) * size);
+    }
+    _part.uploadedIndices = count;
+}
+
+template<class T>
+void AppendableMesh<T>::upload(RenderState& rs) {
+
+    if (m_rs && m_rsGeneration != rs.handleGeneration()) {
+        // The buffers were deleted with a lost context
+        for (auto& part : m_parts) {
+            part.vertexBuffer = part.indexBuffer = 0;
+            part.vertexCapacity = part.indexCapacity = 0;
+            part.uploadedVertices = part.uploadedIndices = 0;
+        }
+        m_isUploaded = false;
+    }
+
+    if (m_isUploaded) { return; }
+
+    m_rs = &rs;
+    m_rsGeneration = rs.handleGeneration();
+
+    for (auto& part : m_parts) {
+        if (part.indices.empty()) { continue; }
+        uploadPart(rs, part);
+    }
+
+    m_isUploaded = true;
+}
+
+template<class T>
+bool AppendableMesh<T>::draw(RenderState& rs, ShaderProgram& _shader, bool _useVao) {
+
+    if (m_nIndices == 0) { return false; }
+
+    if (!_shader.use(rs)) { return false; }
+
+    upload(rs);
+
+    for (auto& part : m_parts) {
+        if (part.indices.empty()) { continue; }
+
+        rs.vertexBuffer(part.vertexBuffer);
+        rs.indexBuffer(part.indexBuffer);
+        m_vertexLayout->enable(rs, _shader, 0);
+
+        rs.countDraw(part.indices.size());
+        GL::drawElements(m_drawMode, part.indices.size(), m_indexType, 0);
+    }
+
+    return true;
+}
+
+template<class T>
+size_t AppendableMesh<T>::bufferSize() const {
+    size_t size = 0;
+    for (auto& part : m_parts) {
+        size += part.vertices.size() * sizeof(T) + part.indices.size() * indexSize();
+    }
+    return size;
+}
+
+}
@@ -0,0 +1,165 @@
+#include "gl/bufferPool.h"
+
+#include "gl/glError.h"
+#include "gl/renderState.h"
+
+#include <algorithm>
+
+namespace Tangram {
+
+constexpr size_t BufferPool::PAGE_SIZE;
+constexpr size_t BufferPool::ALIGNMENT;
+
+struct BufferPool::Page {
+
+    Page(RenderState& _rs) : rs(&_rs) {
+        freeRanges.emplace_back(0, PAGE_SIZE);
+    }
+
+    ~Page() {
+        if (buffer) { rs->queueBufferDeletion(1, &buffer); }
+    }
+
+    // Take _size bytes at a multiple of _alignment from the first free range
+    // that has room for them. Returns PAGE_SIZE when there is none.
+    size_t take(size_t _size, size_t _alignment) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto it = freeRanges.begin(); it != freeRanges.end(); ++it) {
+            size_t offset = (it->first + _alignment - 1) / _alignment * _alignment;
+            size_t end = it->first + it->second;
+            if (offset + _size > end) { continue; }
+
+            // The space before the aligned offset stays free
+            if (offset > it->first) {
+                it->second = offset - it->first;
+                if (offset + _size < end) {
+                    freeRanges.emplace(std::next(it), offset + _size, end - offset - _size);
+                }
+            } else if (offset + _size == end) {
+                freeRanges.erase(it);
+            } else {
+                it->first += _size;
+                it->second -= _size;
+            }
+            return offset;
+        }
+        return PAGE_SIZE;
+    }
+
+    // Return a range, merging it with adjacent free ranges
+    void release(size_t _offset, size_t _size) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto next = std::lower_bound(freeRanges.begin(), freeRanges.end(),
+                                     std::make_pair(_offset, size_t(0)));
+
+        if (next != freeRanges.begin() &&
+            std::prev(next)->first + std::prev(next)->second == _offset) {
+            auto prev = std::prev(next);
+            prev->second += _size;
+            if (next != freeRanges.end() && _offset + _size == next->first) {
+                prev->second += next->second;
+                freeRanges.erase(next);
+            }
+        } else if (next != freeRanges.end() && _offset + _size == next->first) {
+            next->first = _offset;
+            next->second += _size;
+        } else {
+            freeRanges.emplace(next, _offset, _size);
+        }
+    }
+
+    bool isEmpty() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return freeRanges.size() == 1 && freeRanges[0].second == PAGE_SIZE;
+    }
+
+    RenderState* rs;
+    GLuint buffer = 0;
+
+    std::mutex mutex;
+    // Offsets and sizes of the unused ranges, sorted by offset
+    std::vector<std::pair<size_t, size_t>> freeRanges;
+};
+
+BufferPool::Allocation::Allocation(std::shared_ptr<Page> _page, size_t _offset, size_t _size)
+    : m_page(std::move(_page)), m_offset(_offset), m_size(_size) {}
+
+BufferPool::Allocation::~Allocation() {
+    m_page->release(m_offset, m_size);
+}
+
+GLuint BufferPool::Allocation::buffer() const {
+    return m_page->buffer;
+}
+
+BufferPool::BufferPool(GLenum _target) : m_target(_target) {}
+
+BufferPool::~BufferPool() {}
+
+std::unique_ptr<BufferPool::Allocation> BufferPool::allocate(RenderState& _rs, size_t _size,
+                                                             const void* _data, size_t _alignment) {
+
+    size_t size = (_size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    if (size == 0 || size > PAGE_SIZE || _alignment == 0) { return nullptr; }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Delete pages that no mesh uses anymore, but keep one for new meshes
+    bool keepEmpty = true;
+    m_pages.erase(std::remove_if(m_pages.begin(), m_pages.end(), [&](auto& _page) {
+        if (!_page->isEmpty()) { return false; }
+        if (keepEmpty) {
+            keepEmpty = false;
+            return false;
+        }
+        return true;
+    }), m_pages.end());
+
+    std::shared_ptr<Page> page;
+    size_t offset = PAGE_SIZE;
+
+    for (auto& p : m_pages) {
+        offset = p->take(size, _alignment);
+        if (offset != PAGE_SIZE) {
+            page = p;
+            break;
+        }
+    }
+
+    auto bind = [&](GLuint _buffer) {
+        if (m_target == GL_ELEMENT_ARRAY_BUFFER) {
+            _rs.indexBuffer(_buffer);
+        } else {
+            _rs.vertexBuffer(_buffer);
+        }
+    };
+
+    if (page) {
+        bind(page->buffer);
+    } else {
+        page = std::make_shared<Page>(_rs);
+        GL::genBuffers(1, &page->buffer);
+        bind(page->buffer);
+        GL::bufferData(m_target, PAGE_SIZE, nullptr, GL_STATIC_DRAW);
+
+        offset = page->take(size, _alignment);
+        m_pages.push_back(page);
+    }
+
+    GL::bufferSubData(m_target, offset, _size, _data);
+
+    return std::make_unique<Allocation>(page, offset, size);
+}
+
+void BufferPool::invalidate() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& page : m_pages) { page->buffer = 0; }
+    m_pages.clear();
+}
+
+size_t BufferPool::pageCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pages.size();
+}
+
+}
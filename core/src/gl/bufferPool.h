@@ -0,0 +1,73 @@
+#pragma once
+
+#include "gl.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Tangram {
+
+class RenderState;
+
+/* Suballocator of large GL buffers
+ *
+ * Static meshes store their vertices and indices in ranges of shared buffer
+ * pages instead of owning buffers of their own, so that the meshes of a frame
+ * are drawn from a few buffers and RenderState can skip most buffer binds.
+ * Each page keeps a free list of its unused ranges. Ranges are uploaded on the
+ * GL thread and may be released from any thread; pages without allocations are
+ * deleted through the RenderState.
+ */
+class BufferPool {
+
+    struct Page;
+
+public:
+
+    static constexpr size_t PAGE_SIZE = 4*1024*1024; // 4 MB
+
+    // Ranges start at multiples of the alignment, which suits the vertex
+    // attribute offsets and the index types
+    static constexpr size_t ALIGNMENT = 16;
+
+    /* Range of a page that holds the data of one mesh */
+    class Allocation {
+    public:
+        Allocation(std::shared_ptr<Page> _page, size_t _offset, size_t _size);
+        ~Allocation();
+
+        GLuint buffer() const;
+        size_t offset() const { return m_offset; }
+
+    private:
+        std::shared_ptr<Page> m_page;
+        size_t m_offset;
+        size_t m_size;
+    };
+
+    /* @_target: GL_ARRAY_BUFFER or GL_ELEMENT_ARRAY_BUFFER */
+    explicit BufferPool(GLenum _target);
+
+    ~BufferPool();
+
+    /* Copy _size bytes of _data into a free range of a page at a multiple of
+     * _alignment, adding a page when none has enough space. Returns nullptr
+     * when _size exceeds PAGE_SIZE. */
+    std::unique_ptr<Allocation> allocate(RenderState& _rs, size_t _size, const void* _data,
+                                         size_t _alignment = ALIGNMENT);
+
+    /* Drop the pages without deleting their buffers, after GL context loss */
+    void invalidate();
+
+    size_t pageCount() const;
+
+private:
+
+    GLenum m_target;
+
+    mutable std::mutex m_mutex;
+    std::vector<std::shared_ptr<Page>> m_pages;
+};
+
+}
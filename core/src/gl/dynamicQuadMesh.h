@@ -8,6 +8,7 @@
 #include "gl/hardware.h"
 #include "gl/vao.h"
 
+#include <limits>
 #include <memory>
 #include <vector>
 #include <atomic>
@@ -23,6 +24,8 @@ public:
         : MeshBase(_vertexLayout, _drawMode, GL_DYNAMIC_DRAW) {
     }
 
+    ~DynamicQuadMesh() override;
+
     bool draw(RenderState& rs, ShaderProgram& _shader, bool _useVao = true) override;
 
     bool drawRange(RenderState& rs, ShaderProgram& shader, size_t vertexPos, size_t vertexCount);
@@ -37,10 +40,27 @@ public:
         m_isUploaded = false;
         m_vertices.clear();
         //m_batches.clear();
+
+        for (auto& buffer : m_buffers) {
+            buffer.vertices = 0;
+            buffer.dirtyBegin = std::numeric_limits<size_t>::max();
+            buffer.dirtyEnd = 0;
+        }
     }
 
     size_t numberOfVertices() const { return m_vertices.size(); }
 
+    T& vertex(size_t _index) { return m_vertices[_index]; }
+
+    // Upload the vertices of this range again after they were modified in place
+    void markModified(size_t _first, size_t _count) {
+        for (auto& buffer : m_buffers) {
+            buffer.dirtyBegin = std::min(buffer.dirtyBegin, _first);
+            buffer.dirtyEnd = std::max(buffer.dirtyEnd, _first + _count);
+        }
+        m_isUploaded = false;
+    }
+
     void upload(RenderState& rs) override;
 
     bool isReady() { return m_isUploaded; }
@@ -55,21 +75,71 @@ public:
 
 private:
 
+    // The vertices are uploaded to two buffers in turn, so that the buffer
+    // drawn in the last frame is not written while the GPU may still read it.
+    // Each buffer keeps the range that changed since it was last written.
+    struct Buffer {
+        GLuint id = 0;
+        // Vertices the buffer has storage for
+        size_t capacity = 0;
+        // Vertices written to the buffer
+        size_t vertices = 0;
+        size_t dirtyBegin = std::numeric_limits<size_t>::max();
+        size_t dirtyEnd = 0;
+    };
+
     std::vector<T> m_vertices;
-    Vao m_vaos;
+    Buffer m_buffers[2];
+    size_t m_current = 0;
+    Vao m_vaos[2];
 };
 
+template<class T>
+DynamicQuadMesh<T>::~DynamicQuadMesh() {
+    // MeshBase deletes the current buffer
+    if (m_rs && m_rsGeneration == m_rs->handleGeneration()) {
+        auto& other = m_buffers[m_current ^ 1];
+        if (other.id) { m_rs->queueBufferDeletion(1, &other.id); }
+        for (auto& vao : m_vaos) { vao.dispose(*m_rs); }
+    }
+}
+
 template<class T>
 void DynamicQuadMesh<T>::upload(RenderState& rs) {
 
     if (m_nVertices == 0 || m_isUploaded) { return; }
 
+    m_current ^= 1;
+    auto& buffer = m_buffers[m_current];
+
     // Generate vertex buffer, if needed
-    if (m_glVertexBuffer == 0) {
-        GL::genBuffers(1, &m_glVertexBuffer);
+    if (buffer.id == 0) {
+        GL::genBuffers(1, &buffer.id);
+        m_rs = &rs;
+        m_rsGeneration = rs.handleGeneration();
+    }
+    m_glVertexBuffer = buffer.id;
+
+    rs.vertexBuffer(buffer.id);
+
+    size_t stride = m_vertexLayout->getStride();
+    // Write the modified vertices and those pushed since the last upload
+    size_t begin = std::min(buffer.dirtyBegin, buffer.vertices);
+    size_t end = buffer.vertices < m_nVertices ? m_nVertices : std::min(buffer.dirtyEnd, m_nVertices);
+    auto* data = reinterpret_cast<GLbyte*>(m_vertices.data());
+
+    if (begin == 0 || m_nVertices > buffer.capacity) {
+        // Orphan the data store when all of it is written
+        GL::bufferData(GL_ARRAY_BUFFER, m_nVertices * stride, data, m_hint);
+        buffer.capacity = m_nVertices;
+    } else if (begin < end) {
+        GL::bufferSubData(GL_ARRAY_BUFFER, begin * stride,
+                          (end - begin) * stride, data + begin * stride);
     }
 
-    MeshBase::subDataUpload(rs, reinterpret_cast<GLbyte*>(m_vertices.data()));
+    buffer.vertices = m_nVertices;
+    buffer.dirtyBegin = std::numeric_limits<size_t>::max();
+    buffer.dirtyEnd = 0;
 
     m_isUploaded = true;
 }
@@ -87,11 +157,11 @@ bool DynamicQuadMesh<T>::draw(RenderState& rs, ShaderProgram& shader, bool useVa
 
     if (useVao) {
         // Capture vao state for a default vertex offset of 0/0
-        if (!m_vaos.isInitialized()) {
+        if (!m_vaos[m_current].isInitialized()) {
             VertexOffsets vertexOffsets;
             vertexOffsets.emplace_back(0, 0);
-            m_vaos.initialize(rs, shader, vertexOffsets, *m_vertexLayout,
-                              m_glVertexBuffer, rs.getQuadIndexBuffer());
+            m_vaos[m_current].initialize(rs, shader, vertexOffsets, *m_vertexLayout,
+                                         m_glVertexBuffer, rs.getQuadIndexBuffer());
         }
     }
 #endif
@@ -115,7 +185,7 @@ bool DynamicQuadMesh<T>::draw(RenderState& rs, ShaderProgram& shader, bool useVa
             // Use vao only for first batch of offsets, other vertices can use a
             // different stride so just reuse the vertex layout with a different
             // byte offset instead
-            m_vaos.bind(0);
+            m_vaos[m_current].bind(0);
         } else
 #endif
         {
@@ -128,10 +198,11 @@ bool DynamicQuadMesh<T>::draw(RenderState& rs, ShaderProgram& shader, bool useVa
 
         size_t elementsInBatch = verticesInBatch * 6 / 4;
         GL::drawElements(m_drawMode, elementsInBatch, GL_UNSIGNED_SHORT, 0);
+        rs.countDraw(elementsInBatch);
 
 #ifdef DYNAMIC_MESH_VAOS
         if (useVao && vertexPos == 0) {
-            m_vaos.unbind();
+            m_vaos[m_current].unbind();
         }
 #endif
 
@@ -170,6 +241,7 @@ bool DynamicQuadMesh<T>::drawRange(RenderState& rs, ShaderProgram& shader,
 
         size_t elementsInBatch = verticesInBatch * 6 / 4;
         GL::drawElements(m_drawMode, elementsInBatch, GL_UNSIGNED_SHORT, 0);
+        rs.countDraw(elementsInBatch);
 
         // Update counters.
         vertexPos += verticesInBatch;
@@ -9,6 +9,7 @@
 #include "glm/vec2.hpp"
 
 #include <cmath>
+#include <cstring>
 
 namespace Tangram {
 
@@ -27,19 +28,21 @@ public:
     GLuint glHandle() const { return m_glHandle; }
 };
 
-FrameBuffer::FrameBuffer(int _width, int _height, bool _colorRenderBuffer) :
+FrameBuffer::FrameBuffer(int _width, int _height, bool _colorRenderBuffer, bool _stencil) :
     m_glFrameBufferHandle(0),
     m_glDepthRenderBufferHandle(0),
     m_glColorRenderBufferHandle(0),
     m_valid(false),
     m_colorRenderBuffer(_colorRenderBuffer),
+    m_stencil(_stencil),
     m_width(_width), m_height(_height) {
 
 }
 
-bool FrameBuffer::applyAsRenderTarget(RenderState& _rs, ColorF _clearColor) {
+bool FrameBuffer::applyAsRenderTarget(RenderState& _rs, ColorF _clearColor,
+                                      const PixelRect* _scissor) {
 
-    if (!m_glFrameBufferHandle) {
+    if (!m_rs) {
         init(_rs);
     }
 
@@ -47,16 +50,24 @@ bool FrameBuffer::applyAsRenderTarget(RenderState& _rs, ColorF _clearColor) {
         return false;
     }
 
-    FrameBuffer::apply(_rs, m_glFrameBufferHandle, {m_width, m_height}, _clearColor);
+    FrameBuffer::apply(_rs, m_glFrameBufferHandle, {m_width, m_height}, _clearColor, _scissor);
 
     return true;
 }
 
-void FrameBuffer::apply(RenderState& _rs, GLuint _handle, glm::vec2 _viewport, ColorF _clearColor) {
+void FrameBuffer::apply(RenderState& _rs, GLuint _handle, glm::vec2 _viewport, ColorF _clearColor,
+                        const PixelRect* _scissor) {
 
     _rs.framebuffer(_handle);
     _rs.viewport(0, 0, _viewport.x, _viewport.y);
 
+    if (_scissor) {
+        _rs.scissorTest(GL_TRUE);
+        GL::scissor(_scissor->left, _scissor->bottom, _scissor->width, _scissor->height);
+    } else {
+        _rs.scissorTest(GL_FALSE);
+    }
+
     if (_clearColor == ColorF() && _rs.defaultOpaqueClearColor()) {
         _rs.clearDefaultOpaqueColor();
     } else {
@@ -91,7 +102,7 @@ GLuint FrameBuffer::readAt(float _normalizedX, float _normalizedY) const {
     return pixel;
 }
 
-FrameBuffer::PixelRect FrameBuffer::readRect(float _normalizedX, float _normalizedY, float _normalizedW, float _normalizedH) const {
+FrameBuffer::PixelRect FrameBuffer::rect(float _normalizedX, float _normalizedY, float _normalizedW, float _normalizedH) const {
 
     PixelRect rect;
     rect.left = fminf(fmaxf(floorf(_normalizedX * m_width), 0.f), m_width);
@@ -99,9 +110,66 @@ FrameBuffer::PixelRect FrameBuffer::readRect(float _normalizedX, float _normaliz
     rect.width = fminf(fmaxf(ceilf(_normalizedW * m_width), 0.f), m_width - rect.left);
     rect.height = fminf(fmaxf(ceilf(_normalizedH * m_height), 0.f), m_height - rect.bottom);
 
-    rect.pixels.resize(rect.width * rect.height);
+    return rect;
+}
+
+FrameBuffer::PixelRect FrameBuffer::readRect(float _normalizedX, float _normalizedY, float _normalizedW, float _normalizedH) const {
+
+    PixelRect rect = this->rect(_normalizedX, _normalizedY, _normalizedW, _normalizedH);
+    readPixels(rect);
+
+    return rect;
+}
+
+void FrameBuffer::readPixels(PixelRect& _rect) const {
+
+    _rect.pixels.resize(_rect.width * _rect.height);
+
+    GL::readPixels(_rect.left, _rect.bottom, _rect.width, _rect.height, GL_RGBA, GL_UNSIGNED_BYTE, _rect.pixels.data());
+}
+
+bool FrameBuffer::readPixelsAsync(const PixelRect& _rect) {
 
-    GL::readPixels(rect.left, rect.bottom, rect.width, rect.height, GL_RGBA, GL_UNSIGNED_BYTE, rect.pixels.data());
+    if (!Hardware::supportsPixelBufferObjects || !m_valid) { return false; }
+
+    size_t size = _rect.width * _rect.height * sizeof(GLuint);
+
+    if (!m_glPixelBufferHandle) {
+        GL::genBuffers(1, &m_glPixelBufferHandle);
+    }
+    GL::bindBuffer(GL_PIXEL_PACK_BUFFER, m_glPixelBufferHandle);
+    if (size > m_pixelBufferSize) {
+        GL::bufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+        m_pixelBufferSize = size;
+    }
+
+    // With a bound pack buffer the pixels are copied to it at offset 0 on the GPU
+    GL::readPixels(_rect.left, _rect.bottom, _rect.width, _rect.height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    GL::bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    m_pendingPixels = { {}, _rect.left, _rect.bottom, _rect.width, _rect.height };
+    m_pixelsPending = true;
+
+    return true;
+}
+
+FrameBuffer::PixelRect FrameBuffer::mapPixels() {
+
+    PixelRect rect;
+    if (!m_pixelsPending) { return rect; }
+    m_pixelsPending = false;
+
+    size_t count = m_pendingPixels.width * m_pendingPixels.height;
+
+    GL::bindBuffer(GL_PIXEL_PACK_BUFFER, m_glPixelBufferHandle);
+    auto* data = GL::mapBufferRange(GL_PIXEL_PACK_BUFFER, 0, count * sizeof(GLuint), GL_MAP_READ_BIT);
+    if (data) {
+        rect = m_pendingPixels;
+        rect.pixels.resize(count);
+        std::memcpy(rect.pixels.data(), data, count * sizeof(GLuint));
+        GL::unmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    GL::bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
 
     return rect;
 }
@@ -114,6 +182,12 @@ void FrameBuffer::init(RenderState& _rs) {
         m_colorRenderBuffer = false;
     }
 
+    if (m_stencil && !Hardware::supportsPackedDepthStencil) {
+        LOGW("Driver doesn't support packed depth stencil buffers");
+        m_rs = &_rs;
+        return;
+    }
+
     GL::genFramebuffers(1, &m_glFrameBufferHandle);
 
     _rs.framebuffer(m_glFrameBufferHandle);
@@ -136,14 +210,18 @@ void FrameBuffer::init(RenderState& _rs) {
     }
 
     {
-        // Create depth render buffer
+        // Create depth render buffer, with stencil when requested
         GL::genRenderbuffers(1, &m_glDepthRenderBufferHandle);
         GL::bindRenderbuffer(GL_RENDERBUFFER, m_glDepthRenderBufferHandle);
-        GL::renderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16,
+        GL::renderbufferStorage(GL_RENDERBUFFER, m_stencil ? GL_DEPTH24_STENCIL8 : GL_DEPTH_COMPONENT16,
                                 m_width, m_height);
 
         GL::framebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
                                     GL_RENDERBUFFER, m_glDepthRenderBufferHandle);
+        if (m_stencil) {
+            GL::framebufferRenderbuffer(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT,
+                                        GL_RENDERBUFFER, m_glDepthRenderBufferHandle);
+        }
     }
 
     GLenum status = GL::checkFramebufferStatus(GL_FRAMEBUFFER);
@@ -179,10 +257,13 @@ void FrameBuffer::init(RenderState& _rs) {
 FrameBuffer::~FrameBuffer() {
     if (m_rs) {
         m_rs->queueFramebufferDeletion(m_glFrameBufferHandle);
+        if (m_glPixelBufferHandle) {
+            m_rs->queueBufferDeletion(1, &m_glPixelBufferHandle);
+        }
     }
 }
 
-void FrameBuffer::drawDebug(RenderState& _rs, glm::vec2 _dim) {
+void FrameBuffer::draw(RenderState& _rs, glm::vec2 _dim) {
 
     if (m_texture) {
         Primitives::drawTexture(_rs, *m_texture, glm::vec2{}, _dim);
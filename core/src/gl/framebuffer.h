@@ -16,13 +16,23 @@ class FrameBuffer {
 
 public:
 
-    FrameBuffer(int _width, int _height, bool _colorRenderBuffer = true);
+    struct PixelRect {
+        std::vector<GLuint> pixels;
+        int32_t left = 0, bottom = 0, width = 0, height = 0;
+    };
+
+    // With _stencil the buffer has a stencil attachment, or is not valid when
+    // the driver does not support packed depth stencil buffers
+    FrameBuffer(int _width, int _height, bool _colorRenderBuffer = true, bool _stencil = false);
 
     ~FrameBuffer();
 
-    bool applyAsRenderTarget(RenderState& _rs, ColorF _clearColor = ColorF());
+    // Clears and draws only within _scissor, when it is given
+    bool applyAsRenderTarget(RenderState& _rs, ColorF _clearColor = ColorF(),
+                             const PixelRect* _scissor = nullptr);
 
-    static void apply(RenderState& _rs, GLuint _handle, glm::vec2 _viewport, ColorF _clearColor);
+    static void apply(RenderState& _rs, GLuint _handle, glm::vec2 _viewport, ColorF _clearColor,
+                      const PixelRect* _scissor = nullptr);
 
     bool valid() const { return m_valid; }
 
@@ -34,14 +44,24 @@ public:
 
     GLuint readAt(float _normalizedX, float _normalizedY) const;
 
-    struct PixelRect {
-        std::vector<GLuint> pixels;
-        int32_t left = 0, bottom = 0, width = 0, height = 0;
-    };
+    // Pixel region of the normalized rect, clamped to the buffer
+    PixelRect rect(float _normalizedX, float _normalizedY, float _normalizedW, float _normalizedH) const;
 
     PixelRect readRect(float _normalizedX, float _normalizedY, float _normalizedW, float _normalizedH) const;
 
-    void drawDebug(RenderState& _rs, glm::vec2 _dim);
+    // Reads the pixels of _rect
+    void readPixels(PixelRect& _rect) const;
+
+    // Starts reading the pixels of _rect into a pixel buffer object, without waiting for
+    // the GPU. Returns false when pixel buffer objects are not supported.
+    bool readPixelsAsync(const PixelRect& _rect);
+
+    // Returns the pixels of the last readPixelsAsync(), or an empty rect. Call it
+    // on a later frame, once the GPU has written them.
+    PixelRect mapPixels();
+
+    // Draws the color texture over _dim of the current render target
+    void draw(RenderState& _rs, glm::vec2 _dim);
 
 private:
 
@@ -57,10 +77,21 @@ private:
 
     GLuint m_glColorRenderBufferHandle;
 
+    GLuint m_glPixelBufferHandle = 0;
+
+    size_t m_pixelBufferSize = 0;
+
+    // Region of the pixels in the pixel buffer, until they are mapped
+    PixelRect m_pendingPixels;
+
+    bool m_pixelsPending = false;
+
     bool m_valid;
 
     bool m_colorRenderBuffer;
 
+    bool m_stencil;
+
     int m_width;
 
     int m_height;
@@ -3,6 +3,9 @@
 #include "gl/renderState.h"
 #include "log.h"
 
+#include <algorithm>
+#include <cstring>
+
 namespace Tangram {
 
 GlyphTexture::GlyphTexture() : Texture(textureOptions()) {
@@ -14,6 +17,9 @@ GlyphTexture::GlyphTexture() : Texture(textureOptions()) {
 
 bool GlyphTexture::bind(RenderState& _rs, GLuint _textureUnit) {
 
+    // Glyphs are kept in m_buffer and uploaded whole to a new context
+    recoverLostContext(_rs);
+
     if (!m_shouldResize && m_dirtyRows.empty()) {
         if (m_glHandle == 0) { return false; }
 
@@ -38,20 +44,43 @@ bool GlyphTexture::bind(RenderState& _rs, GLuint _textureUnit) {
     for (auto& range : m_dirtyRows) {
         auto rows = range.max - range.min;
         auto offset = m_buffer.get() + (range.min * m_width * bpp());
-        GL::texSubImage2D(GL_TEXTURE_2D, 0, 0, range.min, m_width, rows, format,
-                          GL_UNSIGNED_BYTE, offset);
+
+        if (range.left == 0 && range.right == m_width) {
+            GL::texSubImage2D(GL_TEXTURE_2D, 0, 0, range.min, m_width, rows, format,
+                              GL_UNSIGNED_BYTE, offset);
+            continue;
+        }
+
+        // Pack the rows of the region, its width is a multiple of 4 bytes
+        // to match the default GL_UNPACK_ALIGNMENT
+        size_t rowBytes = (range.right - range.left) * bpp();
+        m_uploadBuffer.resize(rowBytes * rows);
+        for (int y = 0; y < rows; y++) {
+            std::memcpy(&m_uploadBuffer[y * rowBytes],
+                        offset + (y * m_width + range.left) * bpp(), rowBytes);
+        }
+        GL::texSubImage2D(GL_TEXTURE_2D, 0, range.left, range.min, range.right - range.left, rows,
+                          format, GL_UNSIGNED_BYTE, m_uploadBuffer.data());
     }
     m_dirtyRows.clear();
     return true;
 }
 
 void GlyphTexture::setRowsDirty(int start, int count) {
+    setRegionDirty(0, start, m_width, count);
+}
+
+void GlyphTexture::setRegionDirty(int x, int y, int width, int height) {
     // FIXME: check that dirty range is valid for texture size!
-    int max = start + count;
-    int min = start;
+    int max = y + height;
+    int min = y;
+
+    // Align columns to 4 bytes
+    int left = x & ~3;
+    int right = std::min((x + width + 3) & ~3, m_width);
 
     if (m_dirtyRows.empty()) {
-        m_dirtyRows.push_back({min, max});
+        m_dirtyRows.push_back({min, max, left, right});
         return;
     }
 
@@ -66,16 +95,18 @@ void GlyphTexture::setRowsDirty(int start, int count) {
         }
         if (max < n->min) {
             // this range is before current
-            m_dirtyRows.insert(n, {min, max});
+            m_dirtyRows.insert(n, {min, max, left, right});
             return;
         }
         // Combine with overlapping range
         n->min = std::min(n->min, min);
         n->max = std::max(n->max, max);
+        n->left = std::min(n->left, left);
+        n->right = std::max(n->right, right);
         break;
     }
     if (n == m_dirtyRows.end()) {
-        m_dirtyRows.push_back({min, max});
+        m_dirtyRows.push_back({min, max, left, right});
         return;
     }
 
@@ -83,6 +114,8 @@ void GlyphTexture::setRowsDirty(int start, int count) {
     auto it = n+1;
     while (it != m_dirtyRows.end() && max >= it->min) {
         n->max = std::max(it->max, max);
+        n->left = std::min(n->left, it->left);
+        n->right = std::max(n->right, it->right);
         it = m_dirtyRows.erase(it);
     }
 }
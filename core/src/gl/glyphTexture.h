@@ -19,15 +19,25 @@ public:
 
     void setRowsDirty(int start, int count);
 
+    // Mark a region for upload on the next bind. Regions are merged per row
+    // range and only their horizontal extent is uploaded.
+    void setRegionDirty(int x, int y, int width, int height);
+
     GLubyte* buffer() { return m_buffer.get(); }
 
 protected:
     struct DirtyRowRange {
         int min;
         int max;
+        // Columns [left, right) of the rows
+        int left;
+        int right;
     };
 
     std::vector<DirtyRowRange> m_dirtyRows;
+
+    // Dirty regions narrower than the texture packed into contiguous rows
+    std::vector<GLubyte> m_uploadBuffer;
 };
 
 }
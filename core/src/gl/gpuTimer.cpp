@@ -0,0 +1,90 @@
+#include "gl/gpuTimer.h"
+
+#include "debug/metrics.h"
+#include "gl/hardware.h"
+
+namespace Tangram {
+
+constexpr size_t GpuTimer::MAX_PENDING;
+
+bool GpuTimer::begin(Pass _pass, const std::string& _name) {
+    if (!Hardware::supportsTimerQuery || !Metrics::enabled() ||
+        m_active || m_pending.size() >= MAX_PENDING) {
+        return false;
+    }
+
+    GLuint handle = 0;
+    if (m_free.empty()) {
+        GL::genQueries(1, &handle);
+    } else {
+        handle = m_free.back();
+        m_free.pop_back();
+    }
+
+    GL::beginQuery(GL_TIME_ELAPSED, handle);
+    m_pending.push_back({ handle, _pass, _name });
+    m_active = true;
+    return true;
+}
+
+void GpuTimer::end() {
+    if (!m_active) { return; }
+
+    GL::endQuery(GL_TIME_ELAPSED);
+    m_active = false;
+}
+
+void GpuTimer::collect() {
+    if (m_pending.empty() || m_active) { return; }
+
+    // Results of the queries in flight are invalid after a disjoint operation,
+    // like a change of the GPU clock
+    if (Hardware::supportsDisjointTimerQuery) {
+        GLint disjoint = 0;
+        GL::getIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+        if (disjoint) {
+            for (auto& query : m_pending) { m_free.push_back(query.handle); }
+            m_pending.clear();
+            return;
+        }
+    }
+
+    while (!m_pending.empty()) {
+        auto& query = m_pending.front();
+
+        GLuint available = 0;
+        GL::getQueryObjectuiv(query.handle, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) { break; }
+
+        uint64_t ns = 0;
+        GL::getQueryObjectui64v(query.handle, GL_QUERY_RESULT, &ns);
+        auto duration = std::chrono::duration_cast<Metrics::Clock::duration>(std::chrono::nanoseconds(ns));
+
+        if (query.pass == Pass::selection) {
+            Metrics::recordSelectionGpu(duration);
+        } else {
+            Metrics::recordStyleGpu(query.name, duration);
+        }
+
+        m_free.push_back(query.handle);
+        m_pending.pop_front();
+    }
+}
+
+void GpuTimer::invalidate() {
+    m_pending.clear();
+    m_free.clear();
+    m_active = false;
+}
+
+void GpuTimer::clear() {
+    end();
+    for (auto& query : m_pending) { m_free.push_back(query.handle); }
+    if (!m_free.empty()) {
+        GL::deleteQueries(m_free.size(), m_free.data());
+    }
+    m_pending.clear();
+    m_free.clear();
+}
+
+}
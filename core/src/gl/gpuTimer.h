@@ -0,0 +1,61 @@
+#pragma once
+
+#include "gl.h"
+
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace Tangram {
+
+/* GPU time of draw passes, measured with timer queries
+ *
+ * The results of queries are read in later frames once they are available,
+ * so that timing never waits for the GPU, and are recorded in Metrics.
+ * Nothing is measured without Hardware::supportsTimerQuery or while metrics
+ * are disabled. Only one query can be active at a time.
+ */
+class GpuTimer {
+
+public:
+
+    // Queries that may wait for their results, no new ones are started beyond
+    static constexpr size_t MAX_PENDING = 256;
+
+    enum class Pass { style, selection };
+
+    /* Start timing the GPU commands until end() for the style _name or the
+     * selection pass. Returns whether a query was started. */
+    bool begin(Pass _pass, const std::string& _name = "");
+
+    void end();
+
+    /* Record the results of the finished queries in Metrics */
+    void collect();
+
+    /* Drop all queries without deleting them, after GL context loss */
+    void invalidate();
+
+    /* Delete all queries */
+    void clear();
+
+    size_t pendingQueries() const { return m_pending.size(); }
+
+private:
+
+    struct Query {
+        GLuint handle;
+        Pass pass;
+        std::string name;
+    };
+
+    // Queries waiting for their results, the oldest first
+    std::deque<Query> m_pending;
+
+    // Queries whose results were read
+    std::vector<GLuint> m_free;
+
+    bool m_active = false;
+};
+
+}
@@ -4,6 +4,7 @@
 #include "log.h"
 #include "platform.h"
 
+#include <cstdio>
 #include <cstring>
 #include <sstream>
 #include <algorithm>
@@ -16,9 +17,27 @@ bool supportsMapBuffer = false;
 bool supportsVAOs = false;
 bool supportsTextureNPOT = false;
 bool supportsGLRGBA8OES = false;
+bool supportsElementIndexUint = false;
+bool supportsInstancing = false;
+bool supportsUniformBuffers = false;
+bool isGLES = false;
+bool supportsProgramBinary = false;
+bool supportsParallelShaderCompile = false;
+bool supportsPixelBufferObjects = false;
+bool supportsPackedDepthStencil = false;
+bool supportsETC2 = false;
+bool supportsASTC = false;
+bool supportsS3TC = false;
+bool supportsBPTC = false;
+bool supportsComputeShaders = false;
+bool supportsBaseVertex = false;
+bool supportsTimerQuery = false;
+bool supportsDisjointTimerQuery = false;
 
 uint32_t maxTextureSize = 0;
 uint32_t maxCombinedTextureUnits = 0;
+uint32_t maxVertexTextureUnits = 0;
+uint32_t maxVertexUniformVectors = 0;
 static char* s_glExtensions;
 
 bool isAvailable(std::string _extension) {
@@ -27,6 +46,14 @@ bool isAvailable(std::string _extension) {
       : false;
 }
 
+const char* compressedTextureFormat() {
+    if (supportsASTC) { return "astc"; }
+    if (supportsETC2) { return "etc2"; }
+    if (supportsBPTC) { return "bc7"; }
+    if (supportsS3TC) { return "s3tc"; }
+    return nullptr;
+}
+
 void printAvailableExtensions() {
     if (s_glExtensions == NULL) {
         LOGW("Extensions string is NULL");
@@ -45,6 +72,34 @@ void printAvailableExtensions() {
 }
 
 void loadExtensions() {
+    // 32-bit indices are core in desktop GL and GLES 3, and an extension of GLES 2
+    auto version = (const char*) GL::getString(GL_VERSION);
+    supportsElementIndexUint = version && strstr(version, "OpenGL ES 2") == nullptr;
+
+    // Instanced arrays are core in GLES 3 and desktop GL 3.3,
+    // uniform buffers in GLES 3 and desktop GL 3.1, program binaries in
+    // GLES 3 and desktop GL 4.1, ETC2 textures in GLES 3 and desktop GL 4.3,
+    // BPTC textures in desktop GL 4.2, pixel buffer objects with buffer mapping
+    // and packed depth stencil buffers in GLES 3 and desktop GL 3.0, compute
+    // shaders with storage buffers in GLES 3.1 and desktop GL 4.3, base vertex
+    // draws in GLES 3.2 and desktop GL 3.2, timer queries in desktop GL 3.3
+    int major = 0, minor = 0;
+    if (version) {
+        const char* es = strstr(version, "OpenGL ES ");
+        sscanf(es ? es + 10 : version, "%d.%d", &major, &minor);
+        isGLES = es != nullptr;
+        supportsInstancing = es ? major >= 3 : major * 10 + minor >= 33;
+        supportsUniformBuffers = es ? major >= 3 : major * 10 + minor >= 31;
+        supportsProgramBinary = es ? major >= 3 : major * 10 + minor >= 41;
+        supportsETC2 = es ? major >= 3 : major * 10 + minor >= 43;
+        supportsBPTC = !es && major * 10 + minor >= 42;
+        supportsPixelBufferObjects = major >= 3;
+        supportsPackedDepthStencil = major >= 3;
+        supportsComputeShaders = major * 10 + minor >= (es ? 31 : 43);
+        supportsBaseVertex = major * 10 + minor >= 32;
+        supportsTimerQuery = !es && major * 10 + minor >= 33;
+    }
+
     s_glExtensions = (char*) GL::getString(GL_EXTENSIONS);
 
     if (s_glExtensions == NULL) {
@@ -56,11 +111,35 @@ void loadExtensions() {
     supportsVAOs = isAvailable("vertex_array_object");
     supportsTextureNPOT = isAvailable("texture_non_power_of_two");
     supportsGLRGBA8OES = isAvailable("rgb8_rgba8");
+    supportsElementIndexUint = supportsElementIndexUint || isAvailable("element_index_uint");
+    supportsInstancing = supportsInstancing || isAvailable("instanced_arrays");
+    // KHR_ and ARB_parallel_shader_compile
+    supportsParallelShaderCompile = isAvailable("parallel_shader_compile");
+    supportsETC2 = supportsETC2 || isAvailable("ES3_compatibility");
+    supportsASTC = isAvailable("texture_compression_astc_ldr");
+    supportsS3TC = isAvailable("texture_compression_s3tc");
+    supportsBPTC = supportsBPTC || isAvailable("texture_compression_bptc");
+    supportsPackedDepthStencil = supportsPackedDepthStencil || isAvailable("packed_depth_stencil");
+    // OES_ and EXT_draw_elements_base_vertex
+    supportsBaseVertex = supportsBaseVertex || isAvailable("draw_elements_base_vertex");
+    // EXT_disjoint_timer_query in GLES, ARB_timer_query in desktop GL
+    supportsDisjointTimerQuery = isAvailable("disjoint_timer_query");
+    supportsTimerQuery = supportsTimerQuery || isAvailable("timer_query");
 
     LOG("Driver supports map buffer: %d", supportsMapBuffer);
     LOG("Driver supports vaos: %d", supportsVAOs);
     LOG("Driver supports rgb8_rgba8: %d", supportsGLRGBA8OES);
     LOG("Driver supports NPOT texture: %d", supportsTextureNPOT);
+    LOG("Driver supports 32-bit indices: %d", supportsElementIndexUint);
+    LOG("Driver supports instancing: %d", supportsInstancing);
+    LOG("Driver supports uniform buffers: %d", supportsUniformBuffers);
+    LOG("Driver supports parallel shader compile: %d", supportsParallelShaderCompile);
+    LOG("Driver supports pixel buffer objects: %d", supportsPixelBufferObjects);
+    LOG("Driver supports compute shaders: %d", supportsComputeShaders);
+    LOG("Driver supports base vertex draws: %d", supportsBaseVertex);
+    LOG("Driver supports timer queries: %d", supportsTimerQuery);
+    LOG("Driver supports compressed textures: etc2 %d astc %d s3tc %d bptc %d",
+        supportsETC2, supportsASTC, supportsS3TC, supportsBPTC);
 
     // find extension symbols if needed
     initGLExtensions();
@@ -74,8 +153,30 @@ void loadCapabilities() {
     GL::getIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &val);
     maxCombinedTextureUnits = val;
 
+    GL::getIntegerv(GL_MAX_VERTEX_TEXTURE_IMAGE_UNITS, &val);
+    maxVertexTextureUnits = val;
+
+    // Desktop GL before 4.1 only reports the number of components
+    auto version = (const char*) GL::getString(GL_VERSION);
+    if (version && strstr(version, "OpenGL ES")) {
+        GL::getIntegerv(GL_MAX_VERTEX_UNIFORM_VECTORS, &val);
+        maxVertexUniformVectors = val;
+    } else {
+        GL::getIntegerv(GL_MAX_VERTEX_UNIFORM_COMPONENTS, &val);
+        maxVertexUniformVectors = val / 4;
+    }
+
+    // Drivers may support the API without any binary format
+    if (supportsProgramBinary) {
+        GL::getIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &val);
+        supportsProgramBinary = val > 0;
+    }
+
     LOG("Hardware max texture size %d", maxTextureSize);
     LOG("Hardware max combined texture units %d", maxCombinedTextureUnits);
+    LOG("Hardware max vertex texture units %d", maxVertexTextureUnits);
+    LOG("Hardware max vertex uniform vectors %d", maxVertexUniformVectors);
+    LOG("Driver supports program binaries: %d", supportsProgramBinary);
 }
 
 }
@@ -9,12 +9,33 @@ extern bool supportsMapBuffer;
 extern bool supportsVAOs;
 extern bool supportsTextureNPOT;
 extern bool supportsGLRGBA8OES;
+extern bool supportsElementIndexUint;
+extern bool supportsInstancing;
+extern bool supportsUniformBuffers;
+extern bool isGLES;
+extern bool supportsProgramBinary;
+extern bool supportsParallelShaderCompile;
+extern bool supportsPixelBufferObjects;
+extern bool supportsPackedDepthStencil;
+extern bool supportsETC2;
+extern bool supportsASTC;
+extern bool supportsS3TC;
+extern bool supportsBPTC;
+extern bool supportsComputeShaders;
+extern bool supportsBaseVertex;
+extern bool supportsTimerQuery;
+extern bool supportsDisjointTimerQuery;
 extern uint32_t maxTextureSize;
 extern uint32_t maxCombinedTextureUnits;
+extern uint32_t maxVertexTextureUnits;
+extern uint32_t maxVertexUniformVectors;
 
 void loadCapabilities();
 void loadExtensions();
 bool isAvailable(std::string _extension);
+// Name of the preferred compressed texture format: "astc", "etc2", "bc7" or "s3tc",
+// or nullptr when none is supported
+const char* compressedTextureFormat();
 void printAvailableExtensions();
 
 }
@@ -0,0 +1,225 @@
+#include "gl/iconAtlas.h"
+
+#include "gl/hardware.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace Tangram {
+
+constexpr int IconAtlas::max_texture_size;
+constexpr int IconAtlas::max_icon_size;
+
+// Cells hold RGBA images with a border of one pixel
+static const int atlas_bpp = 4;
+static const int cell_border = 1;
+
+IconAtlas::IconAtlas() : m_texture(TextureOptions()) {
+    int size = textureSize();
+
+    // Storage is allocated on the first bind, without a copy in memory
+    m_texture.resize(size, size);
+}
+
+int IconAtlas::textureSize() {
+    if (Hardware::maxTextureSize == 0) { return max_texture_size; }
+    return std::min<int>(max_texture_size, Hardware::maxTextureSize);
+}
+
+int IconAtlas::allocate(int _width, int _height) {
+    glm::ivec2 size = { _width + 2 * cell_border, _height + 2 * cell_border };
+    int area = size.x * size.y;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Reuse the smallest released cell that is not much larger
+    int best = -1;
+    for (int i = 0; i < int(m_cells.size()); i++) {
+        auto& cell = m_cells[i];
+        int cellArea = cell.size.x * cell.size.y;
+        if (cell.used || cell.size.x < size.x || cell.size.y < size.y || cellArea > 2 * area) {
+            continue;
+        }
+        if (best < 0 || cellArea < m_cells[best].size.x * m_cells[best].size.y) { best = i; }
+    }
+    if (best >= 0) {
+        m_cells[best].used = true;
+        return best;
+    }
+
+    int textureSize = m_texture.width();
+
+    // Place the cell in the lowest shelf it fits, or start a new one
+    Shelf* shelf = nullptr;
+    for (auto& s : m_shelves) {
+        if (s.height >= size.y && s.width + size.x <= textureSize &&
+            (!shelf || s.height < shelf->height)) {
+            shelf = &s;
+        }
+    }
+    if (!shelf) {
+        int y = m_shelves.empty() ? 0 : m_shelves.back().y + m_shelves.back().height;
+        if (y + size.y > textureSize || size.x > textureSize) { return -1; }
+        m_shelves.push_back({ y, size.y, 0 });
+        shelf = &m_shelves.back();
+    }
+
+    m_cells.push_back({ { shelf->width, shelf->y }, size, true });
+    shelf->width += size.x;
+
+    return m_cells.size() - 1;
+}
+
+void IconAtlas::release(int _cell) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_cells[_cell].used = false;
+
+    // Start over once all cells are free
+    if (std::none_of(m_cells.begin(), m_cells.end(), [](auto& cell) { return cell.used; })) {
+        m_cells.clear();
+        m_shelves.clear();
+    }
+}
+
+glm::ivec2 IconAtlas::cellOrigin(int _cell) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_cells[_cell].origin;
+}
+
+void IconAtlas::addIcon(IconAtlasTexture* _icon) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_icons.push_back(_icon);
+    m_pending.push_back(_icon);
+}
+
+void IconAtlas::removeIcon(IconAtlasTexture* _icon) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_icons.erase(std::remove(m_icons.begin(), m_icons.end(), _icon), m_icons.end());
+    m_pending.erase(std::remove(m_pending.begin(), m_pending.end(), _icon), m_pending.end());
+}
+
+bool IconAtlas::bind(RenderState& _rs, GLuint _unit) {
+    bool contextLost = m_texture.recoverLostContext(_rs);
+
+    if (!m_texture.bind(_rs, _unit)) { return false; }
+
+    // Images that are drawn in one batch with another image of the atlas
+    // are uploaded here, since only the first image of a batch is bound
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (contextLost) {
+        // Images that have been uploaded are restored from their copies
+        m_pending.clear();
+        for (auto* icon : m_icons) {
+            if (icon->m_buffer || icon->restoreCompressedCopy()) { m_pending.push_back(icon); }
+        }
+    }
+    for (auto* icon : m_pending) { icon->uploadToAtlas(_rs); }
+    m_pending.clear();
+
+    return true;
+}
+
+IconAtlasTexture::~IconAtlasTexture() {
+    if (m_atlas) {
+        m_atlas->removeIcon(this);
+        m_atlas->release(m_cell);
+    }
+}
+
+bool IconAtlasTexture::canAddToAtlas() const {
+    return m_buffer && m_compressedFormat == 0 && !spriteAtlas() &&
+        m_options.pixelFormat == PixelFormat::RGBA &&
+        m_options.minFilter == TextureMinFilter::LINEAR &&
+        m_options.magFilter == TextureMagFilter::LINEAR &&
+        !m_options.generateMipmaps &&
+        m_options.wrapS == TextureWrap::CLAMP_TO_EDGE &&
+        m_options.wrapT == TextureWrap::CLAMP_TO_EDGE &&
+        m_width > 0 && m_height > 0 &&
+        m_width <= IconAtlas::max_icon_size && m_height <= IconAtlas::max_icon_size;
+}
+
+bool IconAtlasTexture::addToAtlas(std::shared_ptr<IconAtlas> _atlas) {
+    assert(canAddToAtlas() && !m_atlas);
+
+    int cell = _atlas->allocate(m_width, m_height);
+    if (cell < 0) { return false; }
+
+    // Copy the image with a border that repeats its edge pixels
+    int width = m_width + 2 * cell_border;
+    int height = m_height + 2 * cell_border;
+    size_t length = size_t(width) * height * atlas_bpp;
+    TextureData buffer(reinterpret_cast<GLubyte*>(std::malloc(length)));
+    if (!buffer) {
+        _atlas->release(cell);
+        return false;
+    }
+    for (int y = 0; y < height; y++) {
+        int row = std::min(std::max(y - cell_border, 0), m_height - 1);
+        const GLubyte* src = m_buffer.get() + size_t(row) * m_width * atlas_bpp;
+        GLubyte* dst = buffer.get() + size_t(y) * width * atlas_bpp;
+        std::memcpy(dst, src, atlas_bpp);
+        std::memcpy(dst + atlas_bpp, src, m_width * atlas_bpp);
+        std::memcpy(dst + (m_width + 1) * atlas_bpp, src + (m_width - 1) * atlas_bpp, atlas_bpp);
+    }
+
+    m_buffer = std::move(buffer);
+    m_bufferSize = length;
+    m_shouldResize = false;
+    m_atlas = std::move(_atlas);
+    m_cell = cell;
+    m_origin = m_atlas->cellOrigin(cell);
+
+    // Keep the copy of the image with its border
+    if (!m_compressedCopy.empty()) { retainCompressedCopy(); }
+
+    m_atlas->addIcon(this);
+
+    return true;
+}
+
+void IconAtlasTexture::uploadToAtlas(RenderState& _rs) {
+    if (!m_buffer) { return; }
+
+    int width = m_width + 2 * cell_border;
+    int height = m_height + 2 * cell_border;
+    while (!uploadRows(_rs, m_origin.x, m_origin.y, width, height, m_buffer.get())) {}
+    m_buffer.reset();
+}
+
+bool IconAtlasTexture::bind(RenderState& _rs, GLuint _unit) {
+    if (!m_atlas) { return Texture::bind(_rs, _unit); }
+
+    return m_atlas->bind(_rs, _unit);
+}
+
+bool IconAtlasTexture::uploadSlice(RenderState& _rs, GLuint _unit) {
+    if (!m_atlas) { return Texture::uploadSlice(_rs, _unit); }
+
+    return m_atlas->bind(_rs, _unit);
+}
+
+glm::vec4 IconAtlasTexture::uvRect() const {
+    if (!m_atlas) { return Texture::uvRect(); }
+
+    float size = m_atlas->texture().width();
+    return { (m_origin.x + cell_border) / size,
+             (m_origin.y + cell_border) / size,
+             m_width / size,
+             m_height / size };
+}
+
+const Texture* IconAtlasTexture::sharedTexture() const {
+    if (!m_atlas) { return this; }
+
+    return &m_atlas->texture();
+}
+
+size_t IconAtlasTexture::gpuBytes() const {
+    if (!m_atlas) { return Texture::gpuBytes(); }
+
+    return m_buffer ? 0 : m_bufferSize;
+}
+
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "gl/texture.h"
+
+#include "glm/vec2.hpp"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Tangram {
+
+class IconAtlasTexture;
+
+// Texture that packs small point icons into rows of cells, so that point
+// sprites of different images are drawn in one batch with one GL texture.
+// Cells have a border of one pixel that repeats the edges of their image.
+class IconAtlas {
+public:
+
+    IconAtlas();
+
+    // Returns a cell for an image of _width by _height pixels, or -1 when the
+    // atlas is full
+    int allocate(int _width, int _height);
+
+    void release(int _cell);
+
+    // Lower-left corner of a cell and its border, in pixels
+    glm::ivec2 cellOrigin(int _cell);
+
+    // Binds the atlas texture and uploads the images added since the last bind,
+    // or all images when the GL context was lost
+    bool bind(RenderState& _rs, GLuint _unit);
+
+    Texture& texture() { return m_texture; }
+
+    // Width and height of the atlas texture
+    static int textureSize();
+
+    static constexpr int max_texture_size = 1024;
+    static constexpr int max_icon_size = 128;
+
+private:
+
+    friend class IconAtlasTexture;
+
+    void addIcon(IconAtlasTexture* _icon);
+    void removeIcon(IconAtlasTexture* _icon);
+
+    struct Cell {
+        glm::ivec2 origin;
+        glm::ivec2 size;
+        bool used;
+    };
+
+    struct Shelf {
+        int y;
+        int height;
+        // Width of the cells in the shelf
+        int width;
+    };
+
+    Texture m_texture;
+
+    std::mutex m_mutex;
+    std::vector<Cell> m_cells;
+    std::vector<Shelf> m_shelves;
+    std::vector<IconAtlasTexture*> m_icons;
+    std::vector<IconAtlasTexture*> m_pending;
+};
+
+// Point icon texture that is drawn from a cell of an IconAtlas once it has
+// been added to one, and otherwise from its own GL texture. Width and height
+// remain those of the image.
+class IconAtlasTexture : public Texture {
+public:
+
+    using Texture::Texture;
+
+    ~IconAtlasTexture() override;
+
+    // Whether the decoded image fits an atlas: Small, uncompressed RGBA with
+    // linear filtering, without mipmaps, repeat wrapping or sprites
+    bool canAddToAtlas() const;
+
+    // Moves the image into a cell of _atlas, which is uploaded on the next
+    // bind of any image of the atlas. Returns false when the atlas is full.
+    bool addToAtlas(std::shared_ptr<IconAtlas> _atlas);
+
+    bool inAtlas() const { return bool(m_atlas); }
+
+    bool bind(RenderState& _rs, GLuint _unit) override;
+
+    bool uploadSlice(RenderState& _rs, GLuint _unit) override;
+
+    glm::vec4 uvRect() const override;
+
+    const Texture* sharedTexture() const override;
+
+    size_t gpuBytes() const override;
+
+private:
+
+    friend class IconAtlas;
+
+    // Uploads the image with its border to the bound atlas texture
+    void uploadToAtlas(RenderState& _rs);
+
+    std::shared_ptr<IconAtlas> m_atlas;
+    int m_cell = -1;
+    glm::ivec2 m_origin;
+};
+
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "gl/mesh.h"
+#include "gl/glError.h"
+#include "gl/renderState.h"
+#include "gl/shaderProgram.h"
+#include "gl/vertexLayout.h"
+
+#include <memory>
+#include <vector>
+
+namespace Tangram {
+
+/* Mesh of quads drawn with instancing
+ *
+ * Holds one element of T per quad, drawn over the corners of the shared quad
+ * corner buffer of the RenderState. The shader gets the corner in the
+ * 'a_corner' attribute and the attributes of _instanceLayout once per quad.
+ * Only use this when Hardware::supportsInstancing is set.
+ */
+template<class T>
+class InstancedQuadMesh : public StyledMesh, protected MeshBase {
+
+public:
+
+    InstancedQuadMesh(std::shared_ptr<VertexLayout> _instanceLayout, GLenum _drawMode)
+        : MeshBase(_instanceLayout, _drawMode, GL_DYNAMIC_DRAW),
+          m_cornerLayout(std::make_shared<VertexLayout>(std::vector<VertexLayout::VertexAttrib>{
+                  {"a_corner", 2, GL_FLOAT, false, 0}})) {
+    }
+
+    bool draw(RenderState& rs, ShaderProgram& _shader, bool _useVao = true) override {
+        return drawRange(rs, _shader, 0, m_nVertices);
+    }
+
+    bool drawRange(RenderState& rs, ShaderProgram& shader, size_t instancePos, size_t instanceCount);
+
+    size_t bufferSize() const override {
+        return MeshBase::bufferSize();
+    }
+
+    void clear() {
+        // Clear instances for next frame
+        m_nVertices = 0;
+        m_isUploaded = false;
+        m_instances.clear();
+    }
+
+    size_t numberOfInstances() const { return m_instances.size(); }
+
+    void upload(RenderState& rs) override;
+
+    // Reserves space for one quad and returns a pointer into m_instances
+    T* pushInstance() {
+        m_nVertices += 1;
+        m_instances.emplace_back();
+        return &m_instances.back();
+    }
+
+private:
+
+    std::vector<T> m_instances;
+    std::shared_ptr<VertexLayout> m_cornerLayout;
+};
+
+template<class T>
+void InstancedQuadMesh<T>::upload(RenderState& rs) {
+
+    if (m_nVertices == 0 || m_isUploaded) { return; }
+
+    if (m_glVertexBuffer == 0) {
+        GL::genBuffers(1, &m_glVertexBuffer);
+    }
+
+    MeshBase::subDataUpload(rs, reinterpret_cast<GLbyte*>(m_instances.data()));
+
+    m_isUploaded = true;
+}
+
+template<class T>
+bool InstancedQuadMesh<T>::drawRange(RenderState& rs, ShaderProgram& shader,
+                                     size_t instancePos, size_t instanceCount) {
+
+    if (m_nVertices == 0 || instanceCount == 0) { return false; }
+
+    // Enable shader program
+    if (!shader.use(rs)) { return false; }
+
+    rs.indexBuffer(rs.getQuadIndexBuffer());
+
+    rs.vertexBuffer(rs.getQuadCornerBuffer());
+    m_cornerLayout->enable(rs, shader, 0);
+
+    rs.vertexBuffer(m_glVertexBuffer);
+    m_vertexLayout->enable(rs, shader, instancePos * m_vertexLayout->getStride());
+
+    // The divisors are reset after the draw since the attribute locations are
+    // shared with the layouts of other meshes
+    m_vertexLayout->setDivisor(shader, 1);
+
+    GL::drawElementsInstanced(m_drawMode, 6, GL_UNSIGNED_SHORT, 0, instanceCount);
+    rs.countDraw(6 * instanceCount);
+
+    m_vertexLayout->setDivisor(shader, 0);
+
+    return true;
+}
+
+}
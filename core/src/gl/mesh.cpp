@@ -1,11 +1,15 @@
 #include "gl/mesh.h"
+#include "gl/bufferPool.h"
 #include "gl/shaderProgram.h"
 #include "gl/renderState.h"
 #include "gl/hardware.h"
+#include "gl/recyclePool.h"
 #include "gl/glError.h"
 #include "platform.h"
 #include "log.h"
 
+#include <limits>
+
 namespace Tangram {
 
 
@@ -34,10 +38,14 @@ MeshBase::MeshBase(std::shared_ptr<VertexLayout> _vertexLayout, GLenum _drawMode
 }
 
 MeshBase::~MeshBase() {
-    if (m_rs) {
-        if (m_glVertexBuffer || m_glIndexBuffer) {
-            GLuint buffers[] = { m_glVertexBuffer, m_glIndexBuffer };
-            m_rs->queueBufferDeletion(2, buffers);
+    // Buffers of a lost context were already deleted with it
+    if (m_rs && m_rsGeneration == m_rs->handleGeneration()) {
+        auto& pool = m_rs->recyclePool();
+        if (m_glVertexBuffer) {
+            pool.recycleBuffer(m_glVertexBuffer, GL_ARRAY_BUFFER, m_hint, m_vertexCapacity);
+        }
+        if (m_glIndexBuffer) {
+            pool.recycleBuffer(m_glIndexBuffer, GL_ELEMENT_ARRAY_BUFFER, m_hint, m_indexCapacity);
         }
         m_vaos.dispose(*m_rs);
     }
@@ -89,6 +97,7 @@ void MeshBase::subDataUpload(RenderState& rs, GLbyte* _data) {
 
     // invalidate/orphane the data store on the driver
     GL::bufferData(GL_ARRAY_BUFFER, vertexBytes, NULL, m_hint);
+    m_vertexCapacity = vertexBytes;
 
     if (Hardware::supportsMapBuffer) {
         GLvoid* dataStore = GL::mapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
@@ -109,40 +118,92 @@ void MeshBase::subDataUpload(RenderState& rs, GLbyte* _data) {
 
 void MeshBase::upload(RenderState& rs) {
 
-    // Generate vertex buffer, if needed
-    if (m_glVertexBuffer == 0) {
-        GL::genBuffers(1, &m_glVertexBuffer);
-    }
-
     // Buffer vertex data
     int vertexBytes = m_nVertices * m_vertexLayout->getStride();
 
-    rs.vertexBuffer(m_glVertexBuffer);
-    GL::bufferData(GL_ARRAY_BUFFER, vertexBytes, m_glVertexData, m_hint);
+    // Static geometry is stored in the shared buffers when it fits a page
+    if (m_hint == GL_STATIC_DRAW) {
+        // Vertices start at a multiple of the stride for base vertex draws
+        m_vertexRange = rs.vertexPool().allocate(rs, vertexBytes, m_glVertexData,
+                                                 m_vertexLayout->getStride());
+    }
+
+    if (!m_vertexRange) {
+        // Reuse the vertex buffer of a deleted mesh or generate one, if needed
+        if (m_glVertexBuffer == 0) {
+            m_glVertexBuffer = rs.recyclePool().acquireBuffer(GL_ARRAY_BUFFER, m_hint,
+                                                              vertexBytes, m_vertexCapacity);
+            if (m_glVertexBuffer == 0) {
+                GL::genBuffers(1, &m_glVertexBuffer);
+                m_vertexCapacity = 0;
+            }
+        }
+
+        rs.vertexBuffer(m_glVertexBuffer);
+        uploadBuffer(GL_ARRAY_BUFFER, vertexBytes, m_glVertexData, m_vertexCapacity);
+    }
 
     delete[] m_glVertexData;
     m_glVertexData = nullptr;
 
     if (m_glIndexData) {
 
-        if (m_glIndexBuffer == 0) {
-            GL::genBuffers(1, &m_glIndexBuffer);
+        if (m_hint == GL_STATIC_DRAW) {
+            m_indexRange = rs.indexPool().allocate(rs, m_nIndices * indexSize(), m_glIndexData);
         }
 
-        // Buffer element index data
-        rs.indexBuffer(m_glIndexBuffer);
+        if (!m_indexRange) {
+            size_t indexBytes = m_nIndices * indexSize();
 
-        GL::bufferData(GL_ELEMENT_ARRAY_BUFFER, m_nIndices * sizeof(GLushort), m_glIndexData, m_hint);
+            if (m_glIndexBuffer == 0) {
+                m_glIndexBuffer = rs.recyclePool().acquireBuffer(GL_ELEMENT_ARRAY_BUFFER, m_hint,
+                                                                 indexBytes, m_indexCapacity);
+                if (m_glIndexBuffer == 0) {
+                    GL::genBuffers(1, &m_glIndexBuffer);
+                    m_indexCapacity = 0;
+                }
+            }
+
+            // Buffer element index data
+            rs.indexBuffer(m_glIndexBuffer);
+
+            uploadBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBytes, m_glIndexData, m_indexCapacity);
+        }
 
         delete[] m_glIndexData;
         m_glIndexData = nullptr;
     }
 
+    rs.addUploadedBytes(bufferSize());
+
     m_rs = &rs;
+    m_rsGeneration = rs.handleGeneration();
 
     m_isUploaded = true;
 }
 
+void MeshBase::uploadBuffer(GLenum _target, size_t _size, const GLbyte* _data, size_t& _capacity) {
+    // A recycled buffer keeps its storage when the data fits
+    if (_capacity >= _size && _size > 0) {
+        GL::bufferSubData(_target, 0, _size, _data);
+    } else {
+        GL::bufferData(_target, _size, _data, m_hint);
+        _capacity = _size;
+    }
+}
+
+void MeshBase::uploadGeometry(RenderState& rs) {
+    if (!m_isCompiled || m_isUploaded || m_nVertices == 0) { return; }
+
+    upload(rs);
+}
+
+void MeshBase::releaseVaos() {
+    if (m_rs && m_rsGeneration == m_rs->handleGeneration()) {
+        m_vaos.dispose(*m_rs);
+    }
+}
+
 bool MeshBase::draw(RenderState& rs, ShaderProgram& _shader, bool _useVao) {
     bool useVao = _useVao && Hardware::supportsVAOs;
 
@@ -161,17 +222,31 @@ bool MeshBase::draw(RenderState& rs, ShaderProgram& _shader, bool _useVao) {
         subDataUpload(rs);
     }
 
-    if (useVao) {
+    GLuint vertexBuffer = m_vertexRange ? m_vertexRange->buffer() : m_glVertexBuffer;
+    GLuint indexBuffer = m_indexRange ? m_indexRange->buffer() : m_glIndexBuffer;
+    size_t vertexByteOffset = m_vertexRange ? m_vertexRange->offset() : 0;
+    size_t indexByteOffset = m_indexRange ? m_indexRange->offset() : 0;
+
+    // Geometry in the pages of the buffer pools is drawn with a VAO shared by
+    // the meshes of the same pages and program
+    bool sharedVao = useVao && m_vertexRange &&
+        (m_nIndices == 0 || (m_indexRange && Hardware::supportsBaseVertex));
+    GLint baseVertex = sharedVao ? GLint(vertexByteOffset / m_vertexLayout->getStride()) : 0;
+
+    if (sharedVao) {
+        rs.vaoCache().get(rs, _shader, *m_vertexLayout, vertexBuffer, indexBuffer).bind(0);
+    } else if (useVao) {
         if (!m_vaos.isInitialized()) {
             // Capture vao state
-            m_vaos.initialize(rs, _shader, m_vertexOffsets, *m_vertexLayout, m_glVertexBuffer, m_glIndexBuffer);
+            m_vaos.initialize(rs, _shader, m_vertexOffsets, *m_vertexLayout, vertexBuffer, indexBuffer,
+                              vertexByteOffset);
         }
     } else {
         // Bind buffers for drawing
-        rs.vertexBuffer(m_glVertexBuffer);
+        rs.vertexBuffer(vertexBuffer);
 
         if (m_nIndices > 0) {
-            rs.indexBuffer(m_glIndexBuffer);
+            rs.indexBuffer(indexBuffer);
         }
     }
 
@@ -185,19 +260,29 @@ bool MeshBase::draw(RenderState& rs, ShaderProgram& _shader, bool _useVao) {
 
         if (!useVao) {
             // Enable vertex attribs via vertex layout object
-            size_t byteOffset = vertexOffset * m_vertexLayout->getStride();
+            size_t byteOffset = vertexByteOffset + vertexOffset * m_vertexLayout->getStride();
             m_vertexLayout->enable(rs,  _shader, byteOffset);
-        } else {
+        } else if (!sharedVao) {
             // Bind the corresponding vao relative to the current offset
             m_vaos.bind(i);
         }
 
         // Draw as elements or arrays
         if (nIndices > 0) {
-            GL::drawElements(m_drawMode, nIndices, GL_UNSIGNED_SHORT,
-                             (void*)(indiceOffset * sizeof(GLushort)));
+            rs.countDraw(nIndices);
+        } else if (nVertices > 0) {
+            rs.countDraw(nVertices);
+        }
+
+        if (nIndices > 0 && sharedVao) {
+            GL::drawElementsBaseVertex(m_drawMode, nIndices, m_indexType,
+                                       (void*)(indexByteOffset + indiceOffset * indexSize()),
+                                       baseVertex + vertexOffset);
+        } else if (nIndices > 0) {
+            GL::drawElements(m_drawMode, nIndices, m_indexType,
+                             (void*)(indexByteOffset + indiceOffset * indexSize()));
         } else if (nVertices > 0) {
-            GL::drawArrays(m_drawMode, 0, nVertices);
+            GL::drawArrays(m_drawMode, sharedVao ? baseVertex + vertexOffset : 0, nVertices);
         }
 
         vertexOffset += nVertices;
@@ -212,46 +297,133 @@ bool MeshBase::draw(RenderState& rs, ShaderProgram& _shader, bool _useVao) {
 }
 
 size_t MeshBase::bufferSize() const {
-    return m_nVertices * m_vertexLayout->getStride() + m_nIndices * sizeof(GLushort);
+    return m_nVertices * m_vertexLayout->getStride() + m_nIndices * indexSize();
+}
+
+template<class T>
+static void appendBytes(std::vector<uint8_t>& _out, const T* _data, size_t _count) {
+    auto bytes = reinterpret_cast<const uint8_t*>(_data);
+    _out.insert(_out.end(), bytes, bytes + _count * sizeof(T));
+}
+
+template<class T>
+static bool readBytes(const uint8_t*& _data, const uint8_t* _end, T* _dst, size_t _count) {
+    size_t size = _count * sizeof(T);
+    if (size == 0) { return true; }
+    if (size_t(_end - _data) < size) { return false; }
+    std::memcpy(_dst, _data, size);
+    _data += size;
+    return true;
+}
+
+bool MeshBase::serialize(std::vector<uint8_t>& _out) const {
+    if (!m_isCompiled || m_isUploaded) { return false; }
+
+    uint32_t sizes[] = { uint32_t(m_vertexLayout->getStride()), uint32_t(indexSize()) };
+    uint64_t counts[] = { m_nVertices, m_nIndices, m_vertexOffsets.size() };
+
+    appendBytes(_out, sizes, 2);
+    appendBytes(_out, counts, 3);
+    appendBytes(_out, m_vertexOffsets.data(), m_vertexOffsets.size());
+    appendBytes(_out, m_glVertexData, m_nVertices * sizes[0]);
+    appendBytes(_out, m_glIndexData, m_nIndices * sizes[1]);
+    return true;
+}
+
+bool MeshBase::deserialize(const uint8_t*& _data, const uint8_t* _end) {
+    if (m_isCompiled) { return false; }
+
+    uint32_t sizes[2];
+    uint64_t counts[3];
+    if (!readBytes(_data, _end, sizes, 2) || !readBytes(_data, _end, counts, 3)) {
+        return false;
+    }
+    uint32_t stride = sizes[0];
+    if (sizes[1] == sizeof(GLuint) && Hardware::supportsElementIndexUint) {
+        m_indexType = GL_UNSIGNED_INT;
+    } else if (sizes[1] != sizeof(GLushort)) {
+        return false;
+    }
+    // The geometry must fit the remaining data and this mesh's vertex layout
+    if (stride != uint32_t(m_vertexLayout->getStride()) ||
+        counts[0] > size_t(_end - _data) / stride ||
+        counts[1] > size_t(_end - _data) / sizes[1] ||
+        counts[2] > size_t(_end - _data) / sizeof(m_vertexOffsets[0])) {
+        return false;
+    }
+
+    m_nVertices = counts[0];
+    m_nIndices = counts[1];
+    m_vertexOffsets.resize(counts[2]);
+    m_glVertexData = new GLbyte[m_nVertices * stride];
+    if (m_nIndices > 0) { m_glIndexData = new GLbyte[m_nIndices * sizes[1]]; }
+
+    if (!readBytes(_data, _end, m_vertexOffsets.data(), m_vertexOffsets.size()) ||
+        !readBytes(_data, _end, m_glVertexData, m_nVertices * stride) ||
+        !readBytes(_data, _end, m_glIndexData, m_nIndices * sizes[1])) {
+        return false;
+    }
+
+    m_isCompiled = true;
+    return true;
+}
+
+void MeshBase::allocateIndices() {
+    m_indexType = (m_nVertices > MAX_INDEX_VALUE && Hardware::supportsElementIndexUint)
+        ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
+    m_glIndexData = new GLbyte[m_nIndices * indexSize()];
 }
 
 // Add indices by collecting them into batches to draw as much as
 // possible in one draw call.  The indices must be shifted by the
 // number of vertices that are present in the current batch.
-size_t MeshBase::compileIndices(const std::vector<std::pair<uint32_t, uint32_t>>& _offsets,
-                                const std::vector<uint16_t>& _indices, size_t _offset) {
-
+template<class I>
+static size_t compileBatches(std::vector<std::pair<uint32_t, uint32_t>>& _vertexOffsets,
+                             const std::vector<std::pair<uint32_t, uint32_t>>& _offsets,
+                             const std::vector<uint16_t>& _indices, I* _dst) {
 
-    GLushort* dst = m_glIndexData + _offset;
+    constexpr size_t maxVertices = std::numeric_limits<I>::max();
     size_t curVertices = 0;
     size_t src = 0;
 
-    if (m_vertexOffsets.empty()) {
-        m_vertexOffsets.emplace_back(0, 0);
+    if (_vertexOffsets.empty()) {
+        _vertexOffsets.emplace_back(0, 0);
     } else {
-        curVertices = m_vertexOffsets.back().second;
+        curVertices = _vertexOffsets.back().second;
     }
 
     for (auto& p : _offsets) {
         size_t nIndices = p.first;
         size_t nVertices = p.second;
 
-        if (curVertices + nVertices > MAX_INDEX_VALUE) {
-            m_vertexOffsets.emplace_back(0, 0);
+        if (curVertices + nVertices > maxVertices) {
+            _vertexOffsets.emplace_back(0, 0);
             curVertices = 0;
         }
-        for (size_t i = 0; i < nIndices; i++, dst++) {
-            *dst = _indices[src++] + curVertices;
+        for (size_t i = 0; i < nIndices; i++, _dst++) {
+            *_dst = _indices[src++] + curVertices;
         }
 
-        auto& offset = m_vertexOffsets.back();
+        auto& offset = _vertexOffsets.back();
         offset.first += nIndices;
         offset.second += nVertices;
 
         curVertices += nVertices;
     }
 
-    return _offset + src;
+    return src;
+}
+
+size_t MeshBase::compileIndices(const std::vector<std::pair<uint32_t, uint32_t>>& _offsets,
+                                const std::vector<uint16_t>& _indices, size_t _offset) {
+
+    size_t count = (m_indexType == GL_UNSIGNED_INT)
+        ? compileBatches(m_vertexOffsets, _offsets, _indices,
+                         reinterpret_cast<GLuint*>(m_glIndexData) + _offset)
+        : compileBatches(m_vertexOffsets, _offsets, _indices,
+                         reinterpret_cast<GLushort*>(m_glIndexData) + _offset);
+
+    return _offset + count;
 }
 
 void MeshBase::setDirty(GLintptr _byteOffset, GLsizei _byteSize) {
@@ -1,12 +1,14 @@
 #pragma once
 
 #include "gl.h"
+#include "gl/bufferPool.h"
 #include "gl/vertexLayout.h"
 #include "gl/vao.h"
 #include "style/style.h"
 #include "util/types.h"
 #include "platform.h"
 
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <memory>
@@ -60,6 +62,17 @@ public:
      */
     virtual void upload(RenderState& rs);
 
+    /*
+     * Upload the compiled geometry unless it is already uploaded
+     */
+    void uploadGeometry(RenderState& rs);
+
+    /*
+     * Release the VAOs of this mesh, which are set up again for the program
+     * of the next draw
+     */
+    void releaseVaos();
+
     /*
      * Sub data upload of the mesh, returns true if this results in a buffer binding
      */
@@ -73,8 +86,29 @@ public:
 
     size_t bufferSize() const;
 
+    /*
+     * Bytes of the compiled geometry in memory. The copy is freed by upload(),
+     * a lost GL context is recovered by building the tiles again.
+     */
+    size_t cpuBufferSize() const { return m_isUploaded ? 0 : bufferSize(); }
+
+    /*
+     * Append the compiled vertices, indices and draw batches to _out. Returns
+     * false when the mesh is not compiled or was already uploaded.
+     */
+    bool serialize(std::vector<uint8_t>& _out) const;
+
+    /*
+     * Read geometry written by serialize() into a mesh with the same vertex
+     * layout, advancing _data. Returns false when the data is invalid.
+     */
+    bool deserialize(const uint8_t*& _data, const uint8_t* _end);
+
 protected:
 
+    // Fill the buffer bound to _target, in its storage of _capacity bytes when _size fits
+    void uploadBuffer(GLenum _target, size_t _size, const GLbyte* _data, size_t& _capacity);
+
     // Used in draw for legth and offsets: sumIndices, sumVertices
     // needs to be set by compile()
     std::vector<std::pair<uint32_t, uint32_t>> m_vertexOffsets;
@@ -83,6 +117,8 @@ protected:
 
     size_t m_nVertices;
     GLuint m_glVertexBuffer;
+    // Size of the storage of m_glVertexBuffer, which may be a recycled buffer
+    size_t m_vertexCapacity = 0;
 
     Vao m_vaos;
 
@@ -91,8 +127,15 @@ protected:
 
     size_t m_nIndices;
     GLuint m_glIndexBuffer;
-    // Compiled  indices for upload
-    GLushort* m_glIndexData = nullptr;
+    size_t m_indexCapacity = 0;
+    // Compiled  indices for upload, of m_indexType
+    GLbyte* m_glIndexData = nullptr;
+    GLenum m_indexType = GL_UNSIGNED_SHORT;
+
+    // Ranges of the shared buffers that hold the uploaded geometry of static
+    // meshes, instead of m_glVertexBuffer and m_glIndexBuffer
+    std::unique_ptr<BufferPool::Allocation> m_vertexRange;
+    std::unique_ptr<BufferPool::Allocation> m_indexRange;
 
     GLenum m_drawMode;
     GLenum m_hint;
@@ -102,10 +145,21 @@ protected:
     bool m_dirty;
 
     RenderState* m_rs = nullptr;
+    // Handle generation of m_rs when the buffers were created
+    uint32_t m_rsGeneration = 0;
 
     GLsizei m_dirtySize;
     GLintptr m_dirtyOffset;
 
+    size_t indexSize() const {
+        return m_indexType == GL_UNSIGNED_INT ? sizeof(GLuint) : sizeof(GLushort);
+    }
+
+    // Allocate m_glIndexData for m_nIndices. Meshes with more vertices than
+    // a 16-bit index can address use 32-bit indices when the driver supports
+    // them, so that they are drawn in one call instead of several batches.
+    void allocateIndices();
+
     size_t compileIndices(const std::vector<std::pair<uint32_t, uint32_t>>& _offsets,
                           const std::vector<uint16_t>& _indices, size_t _offset);
 
@@ -131,6 +185,57 @@ struct MeshData {
         indices.clear();
         vertices.clear();
     }
+
+    // Bytes allocated by the vectors of this MeshData
+    size_t capacityBytes() const {
+        return indices.capacity() * sizeof(uint16_t) +
+            vertices.capacity() * sizeof(T) +
+            offsets.capacity() * sizeof(offsets[0]);
+    }
+
+    // Append the geometry of _other after the geometry of this MeshData
+    void append(const MeshData<T>& _other) {
+        indices.insert(indices.end(), _other.indices.begin(), _other.indices.end());
+        vertices.insert(vertices.end(), _other.vertices.begin(), _other.vertices.end());
+        offsets.insert(offsets.end(), _other.offsets.begin(), _other.offsets.end());
+    }
+
+    // Reorder the chunks of geometry of each offset by ascending _key, which is
+    // called with the vertices of a chunk. Chunks with equal keys keep their order.
+    template<class K>
+    void sortChunks(K _key) {
+        if (offsets.size() < 2) { return; }
+
+        struct Chunk { size_t index, vertex, id; float key; };
+        std::vector<Chunk> chunks;
+        chunks.reserve(offsets.size());
+
+        size_t index = 0, vertex = 0;
+        for (size_t i = 0; i < offsets.size(); i++) {
+            float key = _key(vertices.data() + vertex, offsets[i].second);
+            chunks.push_back({ index, vertex, i, key });
+            index += offsets[i].first;
+            vertex += offsets[i].second;
+        }
+
+        std::stable_sort(chunks.begin(), chunks.end(),
+                         [](const Chunk& a, const Chunk& b) { return a.key < b.key; });
+
+        MeshData<T> sorted;
+        sorted.indices.reserve(indices.size());
+        sorted.vertices.reserve(vertices.size());
+        sorted.offsets.reserve(offsets.size());
+
+        for (const auto& chunk : chunks) {
+            const auto& offset = offsets[chunk.id];
+            sorted.indices.insert(sorted.indices.end(), indices.begin() + chunk.index,
+                                  indices.begin() + chunk.index + offset.first);
+            sorted.vertices.insert(sorted.vertices.end(), vertices.begin() + chunk.vertex,
+                                   vertices.begin() + chunk.vertex + offset.second);
+            sorted.offsets.push_back(offset);
+        }
+        *this = std::move(sorted);
+    }
 };
 
 template<class T>
@@ -147,10 +252,26 @@ public:
         return MeshBase::bufferSize();
     }
 
+    size_t cpuBufferSize() const override {
+        return MeshBase::cpuBufferSize();
+    }
+
     bool draw(RenderState& rs, ShaderProgram& shader, bool useVao = true) override {
         return MeshBase::draw(rs, shader, useVao);
     }
 
+    bool serialize(std::vector<uint8_t>& _out) const override {
+        return MeshBase::serialize(_out);
+    }
+
+    void uploadGeometry(RenderState& rs) override {
+        MeshBase::uploadGeometry(rs);
+    }
+
+    void releaseVaos() override {
+        MeshBase::releaseVaos();
+    }
+
     void compile(const std::vector<MeshData<T>>& _meshes);
 
     void compile(const MeshData<T>& _mesh);
@@ -171,6 +292,68 @@ public:
                          size_t _attribOffset = 0);
 };
 
+/*
+ * CompiledMesh - Mesh restored from the serialized geometry of a Mesh<T>
+ */
+class CompiledMesh : public StyledMesh, protected MeshBase {
+public:
+
+    CompiledMesh(std::shared_ptr<VertexLayout> _vertexLayout, GLenum _drawMode)
+        : MeshBase(_vertexLayout, _drawMode) {}
+
+    size_t bufferSize() const override {
+        return MeshBase::bufferSize();
+    }
+
+    size_t cpuBufferSize() const override {
+        return MeshBase::cpuBufferSize();
+    }
+
+    bool draw(RenderState& rs, ShaderProgram& shader, bool useVao = true) override {
+        return MeshBase::draw(rs, shader, useVao);
+    }
+
+    bool serialize(std::vector<uint8_t>& _out) const override {
+        return MeshBase::serialize(_out);
+    }
+
+    void uploadGeometry(RenderState& rs) override {
+        MeshBase::uploadGeometry(rs);
+    }
+
+    void releaseVaos() override {
+        MeshBase::releaseVaos();
+    }
+
+    bool deserialize(const uint8_t*& _data, const uint8_t* _end) {
+        return MeshBase::deserialize(_data, _end);
+    }
+
+    /*
+     * Replace the value of the 4-byte attribute _attribName of each vertex by
+     * _map(value). Does nothing when the vertex layout has no such attribute.
+     */
+    template<class F>
+    void mapAttribute(const std::string& _attribName, F _map);
+};
+
+template<class F>
+void CompiledMesh::mapAttribute(const std::string& _attribName, F _map) {
+    if (m_glVertexData == nullptr) { return; }
+
+    for (auto& attrib : m_vertexLayout->getAttribs()) {
+        if (attrib.name != _attribName) { continue; }
+
+        size_t stride = m_vertexLayout->getStride();
+        for (size_t offset = attrib.offset; offset < m_nVertices * stride; offset += stride) {
+            uint32_t value;
+            std::memcpy(&value, m_glVertexData + offset, sizeof(value));
+            value = _map(value);
+            std::memcpy(m_glVertexData + offset, &value, sizeof(value));
+        }
+        return;
+    }
+}
 
 template<class T>
 void Mesh<T>::compile(const std::vector<MeshData<T>>& _meshes) {
@@ -199,7 +382,7 @@ void Mesh<T>::compile(const std::vector<MeshData<T>>& _meshes) {
     assert(offset == m_nVertices * stride);
 
     if (m_nIndices > 0) {
-        m_glIndexData = new GLushort[m_nIndices];
+        allocateIndices();
 
         size_t offset = 0;
         for (auto& m : _meshes) {
@@ -225,7 +408,7 @@ void Mesh<T>::compile(const MeshData<T>& _mesh) {
                 m_nVertices * stride);
 
     if (m_nIndices > 0) {
-        m_glIndexData = new GLushort[m_nIndices];
+        allocateIndices();
         compileIndices(_mesh.offsets, _mesh.indices, 0);
     }
 
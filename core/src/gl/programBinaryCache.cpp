@@ -0,0 +1,131 @@
+#include "gl/programBinaryCache.h"
+
+#include "log.h"
+#include "util/hash.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace Tangram {
+
+constexpr uint32_t ProgramBinaryCache::format_version;
+
+static constexpr uint32_t file_magic = 0x42505454; // "TTPB"
+
+struct BinaryHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t format;
+    uint32_t length;
+};
+
+ProgramBinaryCache::ProgramBinaryCache(std::string _directory) :
+    m_directory(std::move(_directory)) {
+
+    if (!m_directory.empty() && m_directory.back() != '/') {
+        m_directory += '/';
+    }
+}
+
+uint64_t ProgramBinaryCache::key(const std::string& _vertSrc, const std::string& _fragSrc) {
+
+    if (m_driverHash == 0) {
+        for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+            auto value = (const char*) GL::getString(name);
+            hash_combine(m_driverHash, std::string(value ? value : ""));
+        }
+    }
+
+    size_t seed = m_driverHash;
+    hash_combine(seed, _vertSrc);
+    hash_combine(seed, _fragSrc);
+    return seed;
+}
+
+std::string ProgramBinaryCache::path(uint64_t _key) const {
+    char name[32];
+    snprintf(name, sizeof(name), "%016" PRIx64 ".bin", _key);
+    return m_directory + name;
+}
+
+GLuint ProgramBinaryCache::load(const std::string& _vertSrc, const std::string& _fragSrc) {
+
+    uint64_t programKey = key(_vertSrc, _fragSrc);
+    std::string file = path(programKey);
+
+    std::ifstream stream(file, std::ifstream::binary);
+    if (!stream.is_open()) { return 0; }
+
+    BinaryHeader header;
+    stream.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!stream.good() || header.magic != file_magic || header.version != format_version ||
+        header.key != programKey) {
+        return 0;
+    }
+
+    std::vector<char> binary(header.length);
+    stream.read(binary.data(), binary.size());
+    if (!stream.good()) { return 0; }
+    stream.close();
+
+    GLuint program = GL::createProgram();
+    GL::programBinary(program, header.format, binary.data(), binary.size());
+
+    GLint isLinked = GL_FALSE;
+    GL::getProgramiv(program, GL_LINK_STATUS, &isLinked);
+
+    if (isLinked == GL_FALSE) {
+        // The driver does not accept the format anymore
+        LOGD("Discarding program binary %s", file.c_str());
+        GL::deleteProgram(program);
+        std::remove(file.c_str());
+        return 0;
+    }
+
+    return program;
+}
+
+bool ProgramBinaryCache::store(GLuint _program, const std::string& _vertSrc, const std::string& _fragSrc) {
+
+    GLint length = 0;
+    GL::getProgramiv(_program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) { return false; }
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    GLsizei written = 0;
+    GL::getProgramBinary(_program, length, &written, &format, binary.data());
+    if (written <= 0) { return false; }
+
+    BinaryHeader header{ file_magic, format_version, key(_vertSrc, _fragSrc),
+                         uint32_t(format), uint32_t(written) };
+
+    // Write to a temporary file first so that a partial entry is never loaded
+    std::string file = path(header.key);
+    std::string tmpFile = file + ".tmp";
+    {
+        std::ofstream stream(tmpFile, std::ofstream::binary | std::ofstream::trunc);
+        if (!stream.is_open()) {
+            LOGW("Cannot write program binary file: %s", tmpFile.c_str());
+            return false;
+        }
+        stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        stream.write(binary.data(), written);
+        if (!stream.good()) {
+            stream.close();
+            std::remove(tmpFile.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tmpFile.c_str(), file.c_str()) != 0) {
+        std::remove(tmpFile.c_str());
+        return false;
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "gl.h"
+
+#include <cstdint>
+#include <string>
+
+namespace Tangram {
+
+/* Persistent cache of linked shader programs
+ *
+ * Stores the binaries returned by the driver for linked programs in a
+ * directory, one file per program. Entries are keyed by a hash of the
+ * preprocessed vertex and fragment sources and of the GL vendor, renderer and
+ * version strings, so that a driver update does not load stale binaries.
+ * Binaries the driver rejects are removed, and the program is compiled
+ * from source instead.
+ */
+class ProgramBinaryCache {
+
+public:
+
+    // Version of the file format
+    static constexpr uint32_t format_version = 1;
+
+    // _directory must exist and be writable
+    explicit ProgramBinaryCache(std::string _directory);
+
+    /* Return a program linked from the stored binary of _vertSrc and
+     * _fragSrc, or 0 when there is none or the driver rejects it.
+     * Must be called on the GL thread. */
+    GLuint load(const std::string& _vertSrc, const std::string& _fragSrc);
+
+    /* Write the binary of the linked _program built from _vertSrc and
+     * _fragSrc. Returns false on failure. */
+    bool store(GLuint _program, const std::string& _vertSrc, const std::string& _fragSrc);
+
+    const std::string& directory() const { return m_directory; }
+
+private:
+
+    uint64_t key(const std::string& _vertSrc, const std::string& _fragSrc);
+
+    std::string path(uint64_t _key) const;
+
+    std::string m_directory;
+
+    // Hash of the driver strings, read on the first use on the GL thread
+    size_t m_driverHash = 0;
+};
+
+}
@@ -0,0 +1,160 @@
+#include "gl/rasterAtlas.h"
+
+#include "gl/hardware.h"
+#include "gl/renderState.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace Tangram {
+
+constexpr int RasterAtlas::max_texture_size;
+
+// Slots hold RGBA images with a border of one pixel
+static const int atlas_bpp = 4;
+static const int slot_border = 1;
+
+RasterAtlas::RasterAtlas(TextureOptions _options, int _slotSize)
+    : m_texture(_options),
+      m_slotSize(_slotSize) {
+
+    int size = textureSize();
+    m_slotsPerRow = size / (m_slotSize + 2 * slot_border);
+
+    // Storage is allocated on the first bind, without a copy in memory
+    m_texture.resize(size, size);
+
+    // Hand out the first slots first
+    for (int slot = m_slotsPerRow * m_slotsPerRow - 1; slot >= 0; slot--) {
+        m_freeSlots.push_back(slot);
+    }
+}
+
+int RasterAtlas::textureSize() {
+    if (Hardware::maxTextureSize == 0) { return max_texture_size; }
+    return std::min<int>(max_texture_size, Hardware::maxTextureSize);
+}
+
+int RasterAtlas::allocate() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_freeSlots.empty()) { return -1; }
+
+    int slot = m_freeSlots.back();
+    m_freeSlots.pop_back();
+    return slot;
+}
+
+void RasterAtlas::release(int _slot) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_freeSlots.push_back(_slot);
+}
+
+glm::ivec2 RasterAtlas::slotOrigin(int _slot) const {
+    int cell = m_slotSize + 2 * slot_border;
+    return { (_slot % m_slotsPerRow) * cell, (_slot / m_slotsPerRow) * cell };
+}
+
+RasterAtlasTexture::~RasterAtlasTexture() {
+    if (m_atlas) { m_atlas->release(m_slot); }
+}
+
+bool RasterAtlasTexture::canAddToAtlas() const {
+    return m_buffer && m_compressedFormat == 0 &&
+        m_options.pixelFormat == PixelFormat::RGBA &&
+        !m_options.generateMipmaps &&
+        m_options.wrapS == TextureWrap::CLAMP_TO_EDGE &&
+        m_options.wrapT == TextureWrap::CLAMP_TO_EDGE &&
+        m_width == m_height && m_width > 0 &&
+        m_width + 2 * slot_border <= RasterAtlas::textureSize();
+}
+
+bool RasterAtlasTexture::addToAtlas(std::shared_ptr<RasterAtlas> _atlas) {
+    assert(canAddToAtlas() && _atlas->slotSize() == m_width);
+
+    int slot = _atlas->allocate();
+    if (slot < 0) { return false; }
+
+    // Copy the image with a border that repeats its edge pixels
+    int size = m_width;
+    int cell = size + 2 * slot_border;
+    size_t length = size_t(cell) * cell * atlas_bpp;
+    TextureData buffer(reinterpret_cast<GLubyte*>(std::malloc(length)));
+    if (!buffer) {
+        _atlas->release(slot);
+        return false;
+    }
+    for (int y = 0; y < cell; y++) {
+        int row = std::min(std::max(y - slot_border, 0), size - 1);
+        const GLubyte* src = m_buffer.get() + size_t(row) * size * atlas_bpp;
+        GLubyte* dst = buffer.get() + size_t(y) * cell * atlas_bpp;
+        std::memcpy(dst, src, atlas_bpp);
+        std::memcpy(dst + atlas_bpp, src, size * atlas_bpp);
+        std::memcpy(dst + (size + 1) * atlas_bpp, src + (size - 1) * atlas_bpp, atlas_bpp);
+    }
+
+    m_buffer = std::move(buffer);
+    m_bufferSize = length;
+    m_atlas = std::move(_atlas);
+    m_slot = slot;
+
+    // Rasters are sampled in the coordinates of the atlas texture
+    m_width = m_height = m_atlas->texture().width();
+    m_shouldResize = false;
+
+    return true;
+}
+
+bool RasterAtlasTexture::bind(RenderState& _rs, GLuint _unit) {
+    if (!m_atlas) { return Texture::bind(_rs, _unit); }
+
+    if (!m_atlas->texture().bind(_rs, _unit)) { return false; }
+
+    // Upload the rest of the slot when it is drawn before uploadSlice() is done
+    if (m_buffer) {
+        int cell = m_atlas->slotSize() + 2 * slot_border;
+        auto origin = m_atlas->slotOrigin(m_slot);
+        while (!uploadRows(_rs, origin.x, origin.y, cell, cell, m_buffer.get())) {}
+        m_buffer.reset();
+    }
+    return true;
+}
+
+bool RasterAtlasTexture::uploadSlice(RenderState& _rs, GLuint _unit) {
+    if (!m_atlas) { return Texture::uploadSlice(_rs, _unit); }
+
+    if (!m_buffer) { return true; }
+
+    if (!m_atlas->texture().bind(_rs, _unit)) { return false; }
+
+    int cell = m_atlas->slotSize() + 2 * slot_border;
+    auto origin = m_atlas->slotOrigin(m_slot);
+    if (!uploadRows(_rs, origin.x, origin.y, cell, cell, m_buffer.get())) { return false; }
+
+    m_buffer.reset();
+    return true;
+}
+
+glm::vec3 RasterAtlasTexture::region() const {
+    if (!m_atlas) { return Texture::region(); }
+
+    float size = m_atlas->texture().width();
+    auto origin = m_atlas->slotOrigin(m_slot);
+    return { (origin.x + slot_border) / size,
+             (origin.y + slot_border) / size,
+             m_atlas->slotSize() / size };
+}
+
+const Texture* RasterAtlasTexture::sharedTexture() const {
+    if (!m_atlas) { return this; }
+
+    return &m_atlas->texture();
+}
+
+size_t RasterAtlasTexture::gpuBytes() const {
+    if (!m_atlas) { return Texture::gpuBytes(); }
+
+    return m_buffer ? 0 : m_bufferSize;
+}
+
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "gl/texture.h"
+
+#include "glm/vec2.hpp"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Tangram {
+
+// Texture with equally sized slots for the raster tiles of a RasterSource,
+// so that drawing their tiles binds one GL texture. Slots have a border of
+// one pixel that repeats the edges of their image, so that linear filtering
+// does not blend neighboring slots.
+class RasterAtlas {
+public:
+
+    RasterAtlas(TextureOptions _options, int _slotSize);
+
+    // Returns a free slot, or -1 when the atlas is full
+    int allocate();
+
+    void release(int _slot);
+
+    int slotSize() const { return m_slotSize; }
+
+    // Lower-left corner of a slot and its border, in pixels
+    glm::ivec2 slotOrigin(int _slot) const;
+
+    Texture& texture() { return m_texture; }
+
+    // Width and height of the atlas texture
+    static int textureSize();
+
+    static constexpr int max_texture_size = 2048;
+
+private:
+
+    Texture m_texture;
+    int m_slotSize;
+    int m_slotsPerRow;
+
+    std::mutex m_mutex;
+    std::vector<int> m_freeSlots;
+};
+
+// Raster tile texture that is drawn from a slot of a RasterAtlas once it
+// has been added to one, and otherwise from its own GL texture.
+class RasterAtlasTexture : public Texture {
+public:
+
+    using Texture::Texture;
+
+    ~RasterAtlasTexture() override;
+
+    // Whether the decoded image fits an atlas: Square, uncompressed RGBA
+    // without mipmaps or repeat wrapping
+    bool canAddToAtlas() const;
+
+    // Moves the image into a slot of _atlas, which is uploaded on the next
+    // bind. Returns false when the atlas is full.
+    bool addToAtlas(std::shared_ptr<RasterAtlas> _atlas);
+
+    bool inAtlas() const { return bool(m_atlas); }
+
+    bool bind(RenderState& _rs, GLuint _unit) override;
+
+    bool uploadSlice(RenderState& _rs, GLuint _unit) override;
+
+    glm::vec3 region() const override;
+
+    const Texture* sharedTexture() const override;
+
+    size_t gpuBytes() const override;
+
+private:
+
+    std::shared_ptr<RasterAtlas> m_atlas;
+    int m_slot = -1;
+};
+
+}
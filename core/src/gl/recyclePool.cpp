@@ -0,0 +1,153 @@
+#include "gl/recyclePool.h"
+
+#include "gl/glError.h"
+
+namespace Tangram {
+
+constexpr size_t RecyclePool::MAX_TEXTURE_BYTES;
+constexpr size_t RecyclePool::MAX_BUFFER_BYTES;
+constexpr size_t RecyclePool::MAX_VAOS;
+
+void RecyclePool::recycleTexture(GLuint _texture, const TextureKey& _key, size_t _bytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_recycledTextures.push_back({ _texture, _key, _bytes });
+}
+
+void RecyclePool::recycleBuffer(GLuint _buffer, GLenum _target, GLenum _usage, size_t _capacity) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_recycledBuffers.push_back({ _buffer, _target, _usage, _capacity });
+}
+
+void RecyclePool::recycleVAOs(size_t _count, const GLuint* _vaos, uint32_t _attribMask) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (size_t i = 0; i < _count; i++) {
+        m_recycledVAOs.push_back({ _vaos[i], _attribMask });
+    }
+}
+
+void RecyclePool::flush() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto& texture : m_recycledTextures) {
+        m_textures.push_back(texture);
+        m_textureBytes += texture.bytes;
+    }
+    m_recycledTextures.clear();
+
+    while (m_textureBytes > MAX_TEXTURE_BYTES) {
+        auto& texture = m_textures.front();
+        GL::deleteTextures(1, &texture.handle);
+        m_textureBytes -= texture.bytes;
+        m_textures.pop_front();
+    }
+
+    for (auto& buffer : m_recycledBuffers) {
+        m_buffers.push_back(buffer);
+        m_bufferBytes += buffer.capacity;
+    }
+    m_recycledBuffers.clear();
+
+    while (m_bufferBytes > MAX_BUFFER_BYTES) {
+        auto& buffer = m_buffers.front();
+        GL::deleteBuffers(1, &buffer.handle);
+        m_bufferBytes -= buffer.capacity;
+        m_buffers.pop_front();
+    }
+
+    m_vaos.insert(m_vaos.end(), m_recycledVAOs.begin(), m_recycledVAOs.end());
+    m_recycledVAOs.clear();
+
+    while (m_vaos.size() > MAX_VAOS) {
+        GL::deleteVertexArrays(1, &m_vaos.front().handle);
+        m_vaos.pop_front();
+    }
+}
+
+GLuint RecyclePool::acquireTexture(const TextureKey& _key) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto it = m_textures.begin(); it != m_textures.end(); ++it) {
+        if (it->key == _key) {
+            GLuint handle = it->handle;
+            m_textureBytes -= it->bytes;
+            m_textures.erase(it);
+            return handle;
+        }
+    }
+    return 0;
+}
+
+GLuint RecyclePool::acquireBuffer(GLenum _target, GLenum _usage, size_t _size, size_t& _capacity) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // The smallest buffer that fits
+    auto best = m_buffers.end();
+    for (auto it = m_buffers.begin(); it != m_buffers.end(); ++it) {
+        if (it->target != _target || it->usage != _usage ||
+            it->capacity < _size || it->capacity > 2 * _size) {
+            continue;
+        }
+        if (best == m_buffers.end() || it->capacity < best->capacity) { best = it; }
+    }
+    if (best == m_buffers.end()) { return 0; }
+
+    GLuint handle = best->handle;
+    _capacity = best->capacity;
+    m_bufferBytes -= best->capacity;
+    m_buffers.erase(best);
+    return handle;
+}
+
+GLuint RecyclePool::acquireVAO(uint32_t _attribMask) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto it = m_vaos.begin(); it != m_vaos.end(); ++it) {
+        if (it->attribMask == _attribMask) {
+            GLuint handle = it->handle;
+            m_vaos.erase(it);
+            return handle;
+        }
+    }
+    return 0;
+}
+
+void RecyclePool::invalidate() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_recycledTextures.clear();
+    m_recycledBuffers.clear();
+    m_recycledVAOs.clear();
+    m_textures.clear();
+    m_buffers.clear();
+    m_vaos.clear();
+    m_textureBytes = 0;
+    m_bufferBytes = 0;
+}
+
+void RecyclePool::clear() {
+    flush();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto& texture : m_textures) { GL::deleteTextures(1, &texture.handle); }
+    for (auto& buffer : m_buffers) { GL::deleteBuffers(1, &buffer.handle); }
+    for (auto& vao : m_vaos) { GL::deleteVertexArrays(1, &vao.handle); }
+
+    m_textures.clear();
+    m_buffers.clear();
+    m_vaos.clear();
+    m_textureBytes = 0;
+    m_bufferBytes = 0;
+}
+
+size_t RecyclePool::textureBytes() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_textureBytes;
+}
+
+size_t RecyclePool::bufferBytes() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_bufferBytes;
+}
+
+}
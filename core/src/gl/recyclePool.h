@@ -0,0 +1,113 @@
+#pragma once
+
+#include "gl.h"
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace Tangram {
+
+/* Pools of the GL objects of deleted meshes and textures
+ *
+ * Buffers, textures and vertex array objects that would be deleted are kept
+ * for new meshes and textures of the same kind, so that incoming tiles reuse
+ * their names and storage instead of allocating new ones. Textures are reused
+ * for the same size and format and buffers for up to twice the size they
+ * need. Objects are recycled from any thread and become available with the
+ * next flush(), after the frame that may still draw them. The oldest objects
+ * beyond the limits of the pools are deleted.
+ */
+class RecyclePool {
+
+public:
+
+    static constexpr size_t MAX_TEXTURE_BYTES = 16*1024*1024; // 16 MB
+    static constexpr size_t MAX_BUFFER_BYTES = 8*1024*1024; // 8 MB
+    static constexpr size_t MAX_VAOS = 256;
+
+    struct TextureKey {
+        int width;
+        int height;
+        GLenum format;
+        bool mipmaps;
+
+        bool operator==(const TextureKey& _other) const {
+            return width == _other.width && height == _other.height &&
+                format == _other.format && mipmaps == _other.mipmaps;
+        }
+    };
+
+    /* Recycle a texture with storage for _key of _bytes. This is thread-safe. */
+    void recycleTexture(GLuint _texture, const TextureKey& _key, size_t _bytes);
+
+    /* Recycle a buffer with _capacity bytes of storage, created for _target
+     * with the _usage hint. This is thread-safe. */
+    void recycleBuffer(GLuint _buffer, GLenum _target, GLenum _usage, size_t _capacity);
+
+    /* Recycle VAOs whose enabled attribute locations are the bits of _attribMask.
+     * This is thread-safe. */
+    void recycleVAOs(size_t _count, const GLuint* _vaos, uint32_t _attribMask);
+
+    /* Make the objects recycled since the last flush available and delete the
+     * oldest objects beyond the limits */
+    void flush();
+
+    /* Returns a texture with storage for _key, or 0 */
+    GLuint acquireTexture(const TextureKey& _key);
+
+    /* Returns a buffer for _target and _usage with storage for _size to twice
+     * _size bytes and sets _capacity to its size, or returns 0 */
+    GLuint acquireBuffer(GLenum _target, GLenum _usage, size_t _size, size_t& _capacity);
+
+    /* Returns a VAO that enables the attribute locations of _attribMask, or 0.
+     * The VAO keeps its last attribute pointers and element array buffer. */
+    GLuint acquireVAO(uint32_t _attribMask);
+
+    /* Drop all objects without deleting them, after GL context loss */
+    void invalidate();
+
+    /* Delete all objects */
+    void clear();
+
+    size_t textureBytes() const;
+    size_t bufferBytes() const;
+
+private:
+
+    struct Texture {
+        GLuint handle;
+        TextureKey key;
+        size_t bytes;
+    };
+
+    struct Buffer {
+        GLuint handle;
+        GLenum target;
+        GLenum usage;
+        size_t capacity;
+    };
+
+    struct VAO {
+        GLuint handle;
+        uint32_t attribMask;
+    };
+
+    mutable std::mutex m_mutex;
+
+    // Recycled since the last flush
+    std::vector<Texture> m_recycledTextures;
+    std::vector<Buffer> m_recycledBuffers;
+    std::vector<VAO> m_recycledVAOs;
+
+    // Available objects, the oldest first
+    std::deque<Texture> m_textures;
+    std::deque<Buffer> m_buffers;
+    std::deque<VAO> m_vaos;
+
+    size_t m_textureBytes = 0;
+    size_t m_bufferBytes = 0;
+};
+
+}
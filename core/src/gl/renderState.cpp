@@ -1,9 +1,13 @@
 #include "gl/renderState.h"
 
+#include "gl/bufferPool.h"
 #include "gl/vertexLayout.h"
 #include "gl/glError.h"
+#include "gl/gpuTimer.h"
 #include "gl/hardware.h"
+#include "gl/recyclePool.h"
 #include "gl/texture.h"
+#include "gl/vao.h"
 #include "log.h"
 #include "platform.h"
 
@@ -11,13 +15,19 @@
 
 namespace Tangram {
 
-RenderState::RenderState() {
+RenderState::RenderState()
+    : m_vertexPool(std::make_unique<BufferPool>(GL_ARRAY_BUFFER)),
+      m_indexPool(std::make_unique<BufferPool>(GL_ELEMENT_ARRAY_BUFFER)),
+      m_recyclePool(std::make_unique<RecyclePool>()),
+      m_vaoCache(std::make_unique<VaoCache>()),
+      m_gpuTimer(std::make_unique<GpuTimer>()) {
 
     m_blending = { 0, false };
     m_culling = { 0, false };
     m_depthMask = { 0, false };
     m_depthTest = { 0, false };
     m_stencilTest = { 0, false };
+    m_scissorTest = { 0, false };
     m_blendingFunc = { 0, 0, false };
     m_stencilMask = { 0, false };
     m_stencilFunc = { 0, 0, 0, false };
@@ -27,6 +37,7 @@ RenderState::RenderState() {
     m_cullFace = { 0, false };
     m_vertexBuffer = { 0, false };
     m_indexBuffer = { 0, false };
+    for (auto& binding : m_uniformBuffers) { binding = { 0, false }; }
     m_program = { 0, false };
     m_clearColor = { 0., 0., 0., 0., false };
     m_defaultOpaqueClearColor = { 0., 0., 0., false };
@@ -49,8 +60,11 @@ void RenderState::flushResourceDeletion() {
         m_textureDeletionList.clear();
     }
     if (m_bufferDeletionList.size()) {
+        for (GLuint buffer : m_bufferDeletionList) { m_vaoCache->evictBuffer(*this, buffer); }
         GL::deleteBuffers(m_bufferDeletionList.size(), m_bufferDeletionList.data());
         m_bufferDeletionList.clear();
+        // Deleted buffers are unbound from the uniform buffer binding points
+        for (auto& binding : m_uniformBuffers) { binding.set = false; }
     }
     if (m_framebufferDeletionList.size()) {
         GL::deleteFramebuffers(m_framebufferDeletionList.size(), m_framebufferDeletionList.data());
@@ -58,10 +72,14 @@ void RenderState::flushResourceDeletion() {
     }
     if (m_programDeletionList.size()) {
         for (GLuint program : m_programDeletionList) {
+            m_vaoCache->evictProgram(*this, program);
             GL::deleteProgram(program);
         }
         m_programDeletionList.clear();
     }
+
+    // Objects recycled in the last frame can be reused from now on
+    m_recyclePool->flush();
 }
 
 void RenderState::queueFramebufferDeletion(GLuint framebuffer) {
@@ -96,7 +114,16 @@ GLuint RenderState::getTextureUnit(GLuint _unit) {
 RenderState::~RenderState() {
 
     deleteQuadIndexBuffer();
+    deleteQuadCornerBuffer();
+
+    m_vaoCache->clear(*this);
+
+    // Queue the deletion of the pool pages
+    m_vertexPool.reset();
+    m_indexPool.reset();
     flushResourceDeletion();
+    m_recyclePool->clear();
+    m_gpuTimer->clear();
 
     for (auto& s : vertexShaders) {
         GL::deleteShader(s.second);
@@ -125,10 +152,12 @@ void RenderState::invalidateStates() {
     m_depthMask.set = false;
     m_frontFace.set = false;
     m_stencilTest.set = false;
+    m_scissorTest.set = false;
     m_stencilMask.set = false;
     m_program.set = false;
     m_indexBuffer.set = false;
     m_vertexBuffer.set = false;
+    for (auto& binding : m_uniformBuffers) { binding.set = false; }
     m_texture.set = false;
     m_textureUnit.set = false;
     m_viewport.set = false;
@@ -147,6 +176,14 @@ void RenderState::invalidateHandles() {
     vertexShaders.clear();
     fragmentShaders.clear();
 
+    m_vertexPool->invalidate();
+    m_indexPool->invalidate();
+    m_recyclePool->invalidate();
+    m_vaoCache->invalidate();
+    m_gpuTimer->invalidate();
+
+    m_handleGeneration++;
+
     // The handles queued for deletion are no longer valid,
     // so clear them without deleting.
     {
@@ -196,6 +233,7 @@ inline void setGlFlag(GLenum flag, GLboolean enable) {
 bool RenderState::blending(GLboolean enable) {
     if (!m_blending.set || m_blending.enabled != enable) {
         m_blending = { enable, true };
+        m_drawStats.stateChanges++;
         setGlFlag(GL_BLEND, enable);
         return false;
     }
@@ -205,6 +243,7 @@ bool RenderState::blending(GLboolean enable) {
 bool RenderState::blendingFunc(GLenum sfactor, GLenum dfactor) {
     if (!m_blendingFunc.set || m_blendingFunc.sfactor != sfactor || m_blendingFunc.dfactor != dfactor) {
         m_blendingFunc = { sfactor, dfactor, true };
+        m_drawStats.stateChanges++;
         GL::blendFunc(sfactor, dfactor);
         return false;
     }
@@ -228,6 +267,7 @@ void RenderState::defaultOpaqueClearColor(GLclampf r, GLclampf g, GLclampf b) {
 bool RenderState::clearColor(GLclampf r, GLclampf g, GLclampf b, GLclampf a) {
     if (!m_clearColor.set || m_clearColor.r != r || m_clearColor.g != g || m_clearColor.b != b || m_clearColor.a != a) {
         m_clearColor = { r, g, b, a, true };
+        m_drawStats.stateChanges++;
         GL::clearColor(r, g, b, a);
         return false;
     }
@@ -237,6 +277,7 @@ bool RenderState::clearColor(GLclampf r, GLclampf g, GLclampf b, GLclampf a) {
 bool RenderState::colorMask(GLboolean r, GLboolean g, GLboolean b, GLboolean a) {
     if (!m_colorMask.set || m_colorMask.r != r || m_colorMask.g != g || m_colorMask.b != b || m_colorMask.a != a) {
         m_colorMask = { r, g, b, a, true };
+        m_drawStats.stateChanges++;
         GL::colorMask(r, g, b, a);
         return false;
     }
@@ -246,6 +287,7 @@ bool RenderState::colorMask(GLboolean r, GLboolean g, GLboolean b, GLboolean a)
 bool RenderState::cullFace(GLenum face) {
     if (!m_cullFace.set || m_cullFace.face != face) {
         m_cullFace = { face, true };
+        m_drawStats.stateChanges++;
         GL::cullFace(face);
         return false;
     }
@@ -255,6 +297,7 @@ bool RenderState::cullFace(GLenum face) {
 bool RenderState::culling(GLboolean enable) {
     if (!m_culling.set || m_culling.enabled != enable) {
         m_culling = { enable, true };
+        m_drawStats.stateChanges++;
         setGlFlag(GL_CULL_FACE, enable);
         return false;
     }
@@ -264,6 +307,7 @@ bool RenderState::culling(GLboolean enable) {
 bool RenderState::depthTest(GLboolean enable) {
     if (!m_depthTest.set || m_depthTest.enabled != enable) {
         m_depthTest = { enable, true };
+        m_drawStats.stateChanges++;
         setGlFlag(GL_DEPTH_TEST, enable);
         return false;
     }
@@ -273,6 +317,7 @@ bool RenderState::depthTest(GLboolean enable) {
 bool RenderState::depthMask(GLboolean enable) {
     if (!m_depthMask.set || m_depthMask.enabled != enable) {
         m_depthMask = { enable, true };
+        m_drawStats.stateChanges++;
         GL::depthMask(enable);
         return false;
     }
@@ -282,6 +327,7 @@ bool RenderState::depthMask(GLboolean enable) {
 bool RenderState::frontFace(GLenum face) {
     if (!m_frontFace.set || m_frontFace.face != face) {
         m_frontFace = { face, true };
+        m_drawStats.stateChanges++;
         GL::frontFace(face);
         return false;
     }
@@ -291,6 +337,7 @@ bool RenderState::frontFace(GLenum face) {
 bool RenderState::stencilMask(GLuint mask) {
     if (!m_stencilMask.set || m_stencilMask.mask != mask) {
         m_stencilMask = { mask, true };
+        m_drawStats.stateChanges++;
         GL::stencilMask(mask);
         return false;
     }
@@ -300,6 +347,7 @@ bool RenderState::stencilMask(GLuint mask) {
 bool RenderState::stencilFunc(GLenum func, GLint ref, GLuint mask) {
     if (!m_stencilFunc.set || m_stencilFunc.func != func || m_stencilFunc.ref != ref || m_stencilFunc.mask != mask) {
         m_stencilFunc = { func, ref, mask, true };
+        m_drawStats.stateChanges++;
         GL::stencilFunc(func, ref, mask);
         return false;
     }
@@ -309,6 +357,7 @@ bool RenderState::stencilFunc(GLenum func, GLint ref, GLuint mask) {
 bool RenderState::stencilOp(GLenum sfail, GLenum spassdfail, GLenum spassdpass) {
     if (!m_stencilOp.set || m_stencilOp.sfail != sfail || m_stencilOp.spassdfail != spassdfail || m_stencilOp.spassdpass != spassdpass) {
         m_stencilOp = { sfail, spassdfail, spassdpass, true };
+        m_drawStats.stateChanges++;
         GL::stencilOp(sfail, spassdfail, spassdpass);
         return false;
     }
@@ -318,15 +367,27 @@ bool RenderState::stencilOp(GLenum sfail, GLenum spassdfail, GLenum spassdpass)
 bool RenderState::stencilTest(GLboolean enable) {
     if (!m_stencilTest.set || m_stencilTest.enabled != enable) {
         m_stencilTest = { enable, true };
+        m_drawStats.stateChanges++;
         setGlFlag(GL_STENCIL_TEST, enable);
         return false;
     }
     return true;
 }
 
+bool RenderState::scissorTest(GLboolean enable) {
+    if (!m_scissorTest.set || m_scissorTest.enabled != enable) {
+        m_scissorTest = { enable, true };
+        m_drawStats.stateChanges++;
+        setGlFlag(GL_SCISSOR_TEST, enable);
+        return false;
+    }
+    return true;
+}
+
 bool RenderState::shaderProgram(GLuint program) {
     if (!m_program.set || m_program.program != program) {
         m_program = { program, true };
+        m_drawStats.stateChanges++;
         GL::useProgram(program);
         return false;
     }
@@ -336,12 +397,14 @@ bool RenderState::shaderProgram(GLuint program) {
 void RenderState::texture(GLuint handle, GLuint unit, GLenum target) {
     if (!m_textureUnit.set || m_textureUnit.unit != unit) {
         m_textureUnit = { unit, true };
+        m_drawStats.stateChanges++;
         // Our cached texture handle is irrelevant on the new unit, so unset it.
         m_texture.set = false;
         GL::activeTexture(getTextureUnit(unit));
     }
     if (!m_texture.set || m_texture.target != target || m_texture.handle != handle) {
         m_texture = { target, handle, true };
+        m_drawStats.stateChanges++;
         GL::bindTexture(target, handle);
     }
 }
@@ -349,15 +412,28 @@ void RenderState::texture(GLuint handle, GLuint unit, GLenum target) {
 bool RenderState::vertexBuffer(GLuint handle) {
     if (!m_vertexBuffer.set || m_vertexBuffer.handle != handle) {
         m_vertexBuffer = { handle, true };
+        m_drawStats.stateChanges++;
         GL::bindBuffer(GL_ARRAY_BUFFER, handle);
         return false;
     }
     return true;
 }
 
+bool RenderState::uniformBuffer(GLuint index, GLuint handle) {
+    auto& binding = m_uniformBuffers[index];
+    if (!binding.set || binding.handle != handle) {
+        binding = { handle, true };
+        m_drawStats.stateChanges++;
+        GL::bindBufferBase(GL_UNIFORM_BUFFER, index, handle);
+        return false;
+    }
+    return true;
+}
+
 bool RenderState::indexBuffer(GLuint handle) {
     if (!m_indexBuffer.set || m_indexBuffer.handle != handle) {
         m_indexBuffer = { handle, true };
+        m_drawStats.stateChanges++;
         GL::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, handle);
         return false;
     }
@@ -404,9 +480,41 @@ void RenderState::generateQuadIndexBuffer() {
 
 }
 
+GLuint RenderState::getQuadCornerBuffer() {
+    if (m_quadCornerBuffer == 0) {
+        generateQuadCornerBuffer();
+    }
+    return m_quadCornerBuffer;
+}
+
+void RenderState::deleteQuadCornerBuffer() {
+    if (m_vertexBuffer.handle == m_quadCornerBuffer) {
+        m_vertexBuffer.set = false;
+    }
+    GL::deleteBuffers(1, &m_quadCornerBuffer);
+    m_quadCornerBuffer = 0;
+}
+
+void RenderState::generateQuadCornerBuffer() {
+
+    // Corners of a quad in [-1, 1], in the order of the four vertices of
+    // each quad in the quad index buffer
+    const GLfloat corners[] = {
+        -1.f,  1.f,
+         1.f,  1.f,
+        -1.f, -1.f,
+         1.f, -1.f,
+    };
+
+    GL::genBuffers(1, &m_quadCornerBuffer);
+    vertexBuffer(m_quadCornerBuffer);
+    GL::bufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+}
+
 bool RenderState::framebuffer(GLuint handle) {
     if (!m_framebuffer.set || m_framebuffer.handle != handle) {
         m_framebuffer = { handle, true };
+        m_drawStats.stateChanges++;
         GL::bindFramebuffer(GL_FRAMEBUFFER, handle);
         return false;
     }
@@ -417,6 +525,7 @@ bool RenderState::viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
     if (!m_viewport.set || m_viewport.x != x || m_viewport.y != y
       || m_viewport.width != width || m_viewport.height != height) {
         m_viewport = { x, y, width, height, true };
+        m_drawStats.stateChanges++;
         GL::viewport(x, y, width, height);
         return false;
     }
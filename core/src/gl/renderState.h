@@ -2,6 +2,7 @@
 
 #include "gl.h"
 #include <array>
+#include <memory>
 #include <string>
 #include <mutex>
 #include <vector>
@@ -9,9 +10,13 @@
 
 namespace Tangram {
 
+class BufferPool;
 class Disposer;
+class GpuTimer;
+class RecyclePool;
 class Scene;
 class Texture;
+class VaoCache;
 
 class RenderState {
 
@@ -21,6 +26,10 @@ public:
 
     static constexpr size_t MAX_QUAD_VERTICES = 16384;
 
+    static constexpr size_t MAX_UNIFORM_BUFFER_BINDINGS = 2;
+
+    static constexpr size_t DEFAULT_UPLOAD_BUDGET = 2*1024*1024; // 2 MB
+
     RenderState();
     ~RenderState();
 
@@ -40,6 +49,10 @@ public:
     // Reset the resource handle cache.
     void invalidateHandles();
 
+    // Incremented by invalidateHandles(); handles created in an earlier
+    // generation belong to a lost context and must not be deleted.
+    uint32_t handleGeneration() const { return m_handleGeneration; }
+
     // Get the texture slot from a texture unit from 0 to TANGRAM_MAX_TEXTURE_UNIT-1.
     static GLuint getTextureUnit(GLuint _unit);
 
@@ -87,6 +100,8 @@ public:
 
     bool stencilTest(GLboolean enable);
 
+    bool scissorTest(GLboolean enable);
+
     bool shaderProgram(GLuint program);
 
     void texture(GLuint handle, GLuint unit, GLenum target);
@@ -95,6 +110,9 @@ public:
 
     bool indexBuffer(GLuint handle);
 
+    // Bind a buffer to the uniform buffer binding point _index
+    bool uniformBuffer(GLuint index, GLuint handle);
+
     bool framebuffer(GLuint handle);
 
     bool viewport(GLint x, GLint y, GLsizei width, GLsizei height);
@@ -107,6 +125,10 @@ public:
 
     GLuint getQuadIndexBuffer();
 
+    // Vertex buffer with the corners of one quad, in the order of the quad
+    // index buffer, for instanced quads
+    GLuint getQuadCornerBuffer();
+
     void flushResourceDeletion();
 
     void queueTextureDeletion(GLuint texture);
@@ -119,6 +141,35 @@ public:
 
     void queueProgramDeletion(GLuint program);
 
+    // Shared buffers for the vertices and indices of static meshes
+    BufferPool& vertexPool() { return *m_vertexPool; }
+    BufferPool& indexPool() { return *m_indexPool; }
+
+    // Buffers, textures and VAOs of deleted objects for reuse
+    RecyclePool& recyclePool() { return *m_recyclePool; }
+
+    // VAOs shared by the meshes in the pages of the buffer pools
+    VaoCache& vaoCache() { return *m_vaoCache; }
+
+    // Timer queries for the GPU time of styles
+    GpuTimer& gpuTimer() { return *m_gpuTimer; }
+
+    // Draw calls, vertices (indices of indexed draws) and GL state changes
+    // since the RenderState was created
+    struct DrawStats {
+        uint64_t drawCalls = 0;
+        uint64_t vertices = 0;
+        uint64_t stateChanges = 0;
+    };
+
+    const DrawStats& drawStats() const { return m_drawStats; }
+
+    // Count a draw call of _vertices vertices or indices
+    void countDraw(size_t _vertices) {
+        m_drawStats.drawCalls++;
+        m_drawStats.vertices += _vertices;
+    }
+
     std::array<GLuint, MAX_ATTRIBUTES> attributeBindings = { { 0 } };
 
     std::unordered_map<std::string, GLuint> fragmentShaders;
@@ -126,15 +177,41 @@ public:
 
     float frameTime() { return m_frameTime; }
 
+    // Bytes of mesh geometry and texture data that new tiles may upload per
+    // frame. Meshes are uploaded whole and textures in slices of rows, so the
+    // budget can be exceeded by the last tile.
+    size_t uploadBudget = DEFAULT_UPLOAD_BUDGET;
+
+    // Count _bytes of geometry uploaded in the current frame
+    void addUploadedBytes(size_t _bytes) { m_uploadedBytes += _bytes; }
+
+    size_t uploadedBytes() const { return m_uploadedBytes; }
+
+    bool hasUploadBudget() const { return m_uploadedBytes < uploadBudget; }
+
+    // Texture work that waits for the upload budget of a later frame
+    void deferUpload() { m_uploadDeferred = true; }
+
+    bool hasDeferredUploads() const { return m_uploadDeferred; }
+
     friend class Scene;
 
 protected:
     void setFrameTime(float _time) { m_frameTime = _time; }
 
+    void resetUploadedBytes() {
+        m_uploadedBytes = 0;
+        m_uploadDeferred = false;
+    }
+
 private:
 
     float m_frameTime = 0.f;
 
+    size_t m_uploadedBytes = 0;
+
+    bool m_uploadDeferred = false;
+
     std::mutex m_deletionListMutex;
     std::vector<GLuint> m_VAODeletionList;
     std::vector<GLuint> m_bufferDeletionList;
@@ -145,14 +222,31 @@ private:
 
     uint32_t m_nextTextureUnit = 0;
 
+    uint32_t m_handleGeneration = 0;
+
+    std::unique_ptr<BufferPool> m_vertexPool;
+    std::unique_ptr<BufferPool> m_indexPool;
+
+    std::unique_ptr<RecyclePool> m_recyclePool;
+
+    std::unique_ptr<VaoCache> m_vaoCache;
+
+    std::unique_ptr<GpuTimer> m_gpuTimer;
+
+    DrawStats m_drawStats;
+
     GLuint m_quadIndexBuffer = 0;
     void deleteQuadIndexBuffer();
     void generateQuadIndexBuffer();
 
+    GLuint m_quadCornerBuffer = 0;
+    void deleteQuadCornerBuffer();
+    void generateQuadCornerBuffer();
+
     struct {
         GLboolean enabled;
         bool set;
-    } m_blending, m_culling, m_depthMask, m_depthTest, m_stencilTest;
+    } m_blending, m_culling, m_depthMask, m_depthTest, m_stencilTest, m_scissorTest;
 
     struct {
         GLenum sfactor, dfactor;
@@ -191,6 +285,11 @@ private:
         bool set;
     } m_vertexBuffer, m_indexBuffer;
 
+    struct {
+        GLuint handle;
+        bool set;
+    } m_uniformBuffers[MAX_UNIFORM_BUFFER_BINDINGS];
+
     struct {
         GLuint program;
         bool set;
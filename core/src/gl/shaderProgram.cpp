@@ -1,7 +1,11 @@
 #include "gl/shaderProgram.h"
 
 #include "gl/glError.h"
+#include "gl/hardware.h"
+#include "gl/programBinaryCache.h"
 #include "gl/renderState.h"
+#include "gl/uniformBuffer.h"
+#include "gl/vao.h"
 #include "glm/gtc/type_ptr.hpp"
 #include "scene/light.h"
 #include "log.h"
@@ -16,7 +20,8 @@ ShaderProgram::ShaderProgram() {
 }
 
 ShaderProgram::~ShaderProgram() {
-    if (m_rs) {
+    // Programs of a lost context were deleted with it
+    if (m_rs && m_rsGeneration == m_rs->handleGeneration()) {
         if (m_glProgram) {
             // Delete only the program, separate shaders are cached and eventually deleted by RenderState.
             // TODO: This approach leaves shaders in memory even if they aren't used by any programs until
@@ -24,6 +29,9 @@ ShaderProgram::~ShaderProgram() {
             // cache to keep shaders in memory only while at least one program uses them. (MEB 2018/5/17)
             m_rs->queueProgramDeletion(m_glProgram);
         }
+        if (m_linkingProgram) {
+            m_rs->queueProgramDeletion(m_linkingProgram);
+        }
     }
 }
 
@@ -52,7 +60,9 @@ GLint ShaderProgram::getUniformLocation(const UniformLocation& _uniform) {
 
 bool ShaderProgram::use(RenderState& rs) {
 
-    if (m_needsBuild) {
+    dropLostHandles(rs);
+
+    if (m_needsBuild || m_linking) {
         build(rs);
     }
 
@@ -64,13 +74,73 @@ bool ShaderProgram::use(RenderState& rs) {
     return false;
 }
 
+bool ShaderProgram::isReady(RenderState& rs) {
+
+    dropLostHandles(rs);
+
+    if (m_needsBuild) {
+        compile(rs);
+    }
+
+    if (m_linking) {
+        if (Hardware::supportsParallelShaderCompile) {
+            GLint completed = GL_FALSE;
+            GL::getProgramiv(m_linkingProgram, GL_COMPLETION_STATUS_KHR, &completed);
+            if (completed == GL_FALSE) { return false; }
+        }
+        finishBuild(rs);
+    }
+
+    return isValid();
+}
+
 bool ShaderProgram::build(RenderState& rs) {
 
+    if (!m_needsBuild && !m_linking) { return false; }
+
+    if (m_needsBuild && !compile(rs)) {
+        return false;
+    }
+
+    if (m_linking) {
+        return finishBuild(rs);
+    }
+
+    return isValid();
+}
+
+void ShaderProgram::dropLostHandles(RenderState& rs) {
+    if (!m_rs || m_rsGeneration == rs.handleGeneration()) { return; }
+
+    m_glProgram = 0;
+    m_glFragmentShader = 0;
+    m_glVertexShader = 0;
+    m_linkingProgram = 0;
+    m_linking = false;
+
+    // Attribute locations and uniform values belong to the lost program
+    m_attribMap.clear();
+    m_uniformCache.clear();
+
+    m_needsBuild = true;
+}
+
+bool ShaderProgram::compile(RenderState& rs) {
+
     if (!m_needsBuild) { return false; }
     m_needsBuild = false;
+    m_rs = &rs;
+    m_rsGeneration = rs.handleGeneration();
 
     // Delete handle for old program and shaders.
+    if (m_linkingProgram) {
+        GL::deleteProgram(m_linkingProgram);
+        m_linkingProgram = 0;
+        m_linking = false;
+    }
     if (m_glProgram) {
+        // A new program may get the same name
+        rs.vaoCache().evictProgram(rs, m_glProgram);
         GL::deleteProgram(m_glProgram);
         m_glProgram = 0;
     }
@@ -86,67 +156,126 @@ bool ShaderProgram::build(RenderState& rs) {
     auto& vertSrc = m_vertexShaderSource;
     auto& fragSrc = m_fragmentShaderSource;
 
-    // Compile vertex and fragment shaders
-    GLint vertexShader = makeCompiledShader(rs, vertSrc, GL_VERTEX_SHADER);
-    if (vertexShader == 0) {
-        LOGE("Shader compilation failed for %s", m_description.c_str());
-        return false;
+    if (m_binaryCache && Hardware::supportsProgramBinary) {
+        GLuint program = m_binaryCache->load(vertSrc, fragSrc);
+        if (program != 0) {
+            if (Hardware::supportsUniformBuffers) {
+                UniformBuffer::bindBlocks(program);
+            }
+            m_glProgram = program;
+            m_attribMap.clear();
+            return true;
+        }
     }
 
-    GLint fragmentShader = makeCompiledShader(rs, fragSrc, GL_FRAGMENT_SHADER);
-    if (fragmentShader == 0) {
+    // Issue compilation and linking, their status is checked in finishBuild()
+    GLuint vertexShader = compileShader(rs, vertSrc, GL_VERTEX_SHADER);
+    GLuint fragmentShader = compileShader(rs, fragSrc, GL_FRAGMENT_SHADER);
+    if (vertexShader == 0 || fragmentShader == 0) {
         LOGE("Shader compilation failed for %s", m_description.c_str());
         return false;
     }
 
-    // Link shaders into a program
-    GLint program = makeLinkedShaderProgram(fragmentShader, vertexShader);
-    if (program == 0) {
+    m_linkingProgram = linkShaderProgram(fragmentShader, vertexShader);
+    m_glFragmentShader = fragmentShader;
+    m_glVertexShader = vertexShader;
+    m_linking = true;
+
+    return true;
+}
+
+bool ShaderProgram::finishBuild(RenderState& rs) {
+
+    GLuint program = m_linkingProgram;
+    m_linkingProgram = 0;
+    m_linking = false;
+
+    auto& vertSrc = m_vertexShaderSource;
+    auto& fragSrc = m_fragmentShaderSource;
+
+    if (!checkCompiledShader(rs, vertSrc, GL_VERTEX_SHADER) ||
+        !checkCompiledShader(rs, fragSrc, GL_FRAGMENT_SHADER) ||
+        !checkLinkedProgram(program)) {
         LOGE("Shader compilation failed for %s", m_description.c_str());
+        GL::deleteProgram(program);
+        m_glFragmentShader = 0;
+        m_glVertexShader = 0;
         return false;
     }
 
+    if (m_binaryCache && Hardware::supportsProgramBinary) {
+        m_binaryCache->store(program, vertSrc, fragSrc);
+    }
+
+    if (Hardware::supportsUniformBuffers) {
+        UniformBuffer::bindBlocks(program);
+    }
+
     m_glProgram = program;
-    m_glFragmentShader = fragmentShader;
-    m_glVertexShader = vertexShader;
 
     // Clear any cached shader locations
     m_attribMap.clear();
-    m_rs = &rs;
 
     return true;
 }
 
 GLuint ShaderProgram::makeLinkedShaderProgram(GLint _fragShader, GLint _vertShader) {
 
+    GLuint program = linkShaderProgram(_fragShader, _vertShader);
+
+    if (!checkLinkedProgram(program)) {
+        GL::deleteProgram(program);
+        return 0;
+    }
+
+    return program;
+}
+
+GLuint ShaderProgram::linkShaderProgram(GLint _fragShader, GLint _vertShader) {
+
     GLuint program = GL::createProgram();
 
     GL::attachShader(program, _fragShader);
     GL::attachShader(program, _vertShader);
     GL::linkProgram(program);
 
+    return program;
+}
+
+bool ShaderProgram::checkLinkedProgram(GLuint _program) {
+
     GLint isLinked;
-    GL::getProgramiv(program, GL_LINK_STATUS, &isLinked);
+    GL::getProgramiv(_program, GL_LINK_STATUS, &isLinked);
 
     if (isLinked == GL_FALSE) {
         GLint infoLength = 0;
-        GL::getProgramiv(program, GL_INFO_LOG_LENGTH, &infoLength);
+        GL::getProgramiv(_program, GL_INFO_LOG_LENGTH, &infoLength);
 
         if (infoLength > 1) {
             std::vector<GLchar> infoLog(infoLength);
-            GL::getProgramInfoLog(program, infoLength, NULL, &infoLog[0]);
+            GL::getProgramInfoLog(_program, infoLength, NULL, &infoLog[0]);
             LOGE("linking program:\n%s", &infoLog[0]);
         }
 
-        GL::deleteProgram(program);
-        return 0;
+        return false;
     }
 
-    return program;
+    return true;
 }
 
 GLuint ShaderProgram::makeCompiledShader(RenderState& rs, const std::string& _src, GLenum _type) {
 
+    GLuint shader = compileShader(rs, _src, _type);
+
+    if (shader == 0 || !checkCompiledShader(rs, _src, _type)) {
+        return 0;
+    }
+
+    return shader;
+}
+
+GLuint ShaderProgram::compileShader(RenderState& rs, const std::string& _src, GLenum _type) {
+
     auto& cache = (_type == GL_VERTEX_SHADER) ? rs.vertexShaders : rs.fragmentShaders;
 
     auto entry = cache.emplace(_src, 0);
@@ -160,6 +289,22 @@ GLuint ShaderProgram::makeCompiledShader(RenderState& rs, const std::string& _sr
     GL::shaderSource(shader, 1, &source, NULL);
     GL::compileShader(shader);
 
+    entry.first->second = shader;
+
+    return shader;
+}
+
+bool ShaderProgram::checkCompiledShader(RenderState& rs, const std::string& _src, GLenum _type) {
+
+    auto& cache = (_type == GL_VERTEX_SHADER) ? rs.vertexShaders : rs.fragmentShaders;
+
+    auto entry = cache.find(_src);
+    if (entry == cache.end() || entry->second == 0) {
+        return false;
+    }
+
+    GLuint shader = entry->second;
+
     GLint isCompiled;
     GL::getShaderiv(shader, GL_COMPILE_STATUS, &isCompiled);
 
@@ -174,7 +319,7 @@ GLuint ShaderProgram::makeCompiledShader(RenderState& rs, const std::string& _sr
             GL::getShaderInfoLog(shader, infoLength, NULL, static_cast<GLchar*>(&infoLog[0]));
             LOGE("Shader compilation failed\n%s", infoLog.c_str());
 
-            std::stringstream sourceStream(source);
+            std::stringstream sourceStream(_src);
             std::string item;
             std::vector<std::string> sourceLines;
             while (std::getline(sourceStream, item)) { sourceLines.push_back(item); }
@@ -203,13 +348,13 @@ GLuint ShaderProgram::makeCompiledShader(RenderState& rs, const std::string& _sr
             }
         }
 
+        // Keep the failure in the cache, other programs may share the shader
         GL::deleteShader(shader);
-        return 0;
+        entry->second = 0;
+        return false;
     }
 
-    entry.first->second = shader;
-
-    return shader;
+    return true;
 }
 
 void ShaderProgram::setUniformi(RenderState& rs, const UniformLocation& _loc, int _value) {
@@ -350,6 +495,15 @@ void ShaderProgram::setUniformf(RenderState& rs, const UniformLocation& _loc, co
     }
 }
 
+void ShaderProgram::setUniformf(RenderState& rs, const UniformLocation& _loc, const UniformArray4f& _value) {
+    if (!use(rs)) { return; }
+    GLint location = getUniformLocation(_loc);
+    if (location >= 0) {
+        bool cached = getFromCache(location, _value);
+        if (!cached) { GL::uniform4fv(location, _value.size(), (float*)_value.data()); }
+    }
+}
+
 void ShaderProgram::setUniformi(RenderState& rs, const UniformLocation& _loc, const UniformTextureArray& _value) {
     if (!use(rs)) { return; }
     GLint location = getUniformLocation(_loc);
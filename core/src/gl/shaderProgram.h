@@ -13,6 +13,7 @@
 
 namespace Tangram {
 
+class ProgramBinaryCache;
 class RenderState;
 
 //
@@ -37,6 +38,15 @@ public:
     // successful it returns true.
     bool build(RenderState& rs);
 
+    // Issue compilation and linking of the shaders without waiting for the result, which
+    // is checked when the program is used; returns false when it is known to fail.
+    bool compile(RenderState& rs);
+
+    // Returns true if the program can be used without waiting for the driver to finish
+    // compiling it, and calls compile() when the sources have been modified. Without
+    // KHR_parallel_shader_compile this finishes the build and only returns false on failure.
+    bool isReady(RenderState& rs);
+
     // Getters
     GLuint getGlProgram() const { return m_glProgram; };
 
@@ -74,6 +84,7 @@ public:
     void setUniformf(RenderState& rs, const UniformLocation& _loc, const UniformArray1f& _value);
     void setUniformf(RenderState& rs, const UniformLocation& _loc, const UniformArray2f& _value);
     void setUniformf(RenderState& rs, const UniformLocation& _loc, const UniformArray3f& _value);
+    void setUniformf(RenderState& rs, const UniformLocation& _loc, const UniformArray4f& _value);
     void setUniformi(RenderState& rs, const UniformLocation& _loc, const UniformTextureArray& _value);
 
     // Ensure the program is bound and then set the named uniform to the values
@@ -84,14 +95,32 @@ public:
 
     void setDescription(std::string _description) { m_description = _description; }
 
+    // Load the linked program from _cache when possible and store it there after linking
+    void setBinaryCache(ProgramBinaryCache* _cache) { m_binaryCache = _cache; }
+
     static GLuint makeLinkedShaderProgram(GLint _fragShader, GLint _vertShader);
     static GLuint makeCompiledShader(RenderState& rs, const std::string& _src, GLenum _type);
 
+    // Variants of the functions above that do not wait for the driver
+    static GLuint linkShaderProgram(GLint _fragShader, GLint _vertShader);
+    static GLuint compileShader(RenderState& rs, const std::string& _src, GLenum _type);
+
+    // Check the result of linkShaderProgram() and compileShader(), printing the logs on failure
+    static bool checkLinkedProgram(GLuint _program);
+    static bool checkCompiledShader(RenderState& rs, const std::string& _src, GLenum _type);
+
     const std::string& vertexShaderSource() { return m_vertexShaderSource; }
     const std::string& fragmentShaderSource() { return m_fragmentShaderSource; }
 
 private:
 
+    // Check the result of compile() and set up the linked program
+    bool finishBuild(RenderState& rs);
+
+    // Drops the handles of a lost context, so that the program is built again
+    // and restored from the binary cache when there is one
+    void dropLostHandles(RenderState& rs);
+
     // Get a uniform value from the cache, and returns false when it's a cache miss
     template <class T>
     inline bool getFromCache(GLint _location, T _value) {
@@ -121,7 +150,15 @@ private:
 
     bool m_needsBuild = true;
 
+    // Set while the program issued by compile() is being linked
+    bool m_linking = false;
+    GLuint m_linkingProgram = 0;
+
     RenderState* m_rs = nullptr;
+    // Handle generation of m_rs when the program was compiled
+    uint32_t m_rsGeneration = 0;
+
+    ProgramBinaryCache* m_binaryCache = nullptr;
 
 };
 
@@ -0,0 +1,37 @@
+#include "gl/shaderProgramCache.h"
+
+#include "gl/shaderProgram.h"
+#include "util/hash.h"
+
+namespace Tangram {
+
+ShaderProgramCache::ShaderProgramCache(ProgramBinaryCache* _binaryCache) :
+    m_binaryCache(_binaryCache) {}
+
+std::shared_ptr<ShaderProgram> ShaderProgramCache::get(const std::string& _vertSrc,
+                                                       const std::string& _fragSrc,
+                                                       const std::string& _description) {
+    size_t key = 0;
+    hash_combine(key, _vertSrc);
+    hash_combine(key, _fragSrc);
+
+    auto& programs = m_programs[key];
+    for (auto& program : programs) {
+        if (program->vertexShaderSource() == _vertSrc &&
+            program->fragmentShaderSource() == _fragSrc) {
+            return program;
+        }
+    }
+
+    auto program = std::make_shared<ShaderProgram>();
+    program->setDescription(_description);
+    program->setShaderSource(_vertSrc, _fragSrc);
+    program->setBinaryCache(m_binaryCache);
+
+    programs.push_back(program);
+    m_size++;
+
+    return program;
+}
+
+}
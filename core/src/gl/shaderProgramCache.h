@@ -0,0 +1,44 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Tangram {
+
+class ProgramBinaryCache;
+class ShaderProgram;
+
+/* Programs of the styles of a scene, keyed by their final sources
+ *
+ * Styles whose sources are identical after all shader blocks and defines are
+ * applied share one program, so that it is compiled once and not switched
+ * between them. Their uniform values are set on the shared program, where
+ * values that did not change are skipped by the uniform cache of ShaderProgram.
+ */
+class ShaderProgramCache {
+
+public:
+
+    // Programs created by the cache load and store their binaries in _binaryCache
+    explicit ShaderProgramCache(ProgramBinaryCache* _binaryCache = nullptr);
+
+    // Return the program built from _vertSrc and _fragSrc, creating it with
+    // _description when there is none yet
+    std::shared_ptr<ShaderProgram> get(const std::string& _vertSrc, const std::string& _fragSrc,
+                                       const std::string& _description);
+
+    size_t size() const { return m_size; }
+
+private:
+
+    // Programs by hash of their sources
+    std::unordered_map<size_t, std::vector<std::shared_ptr<ShaderProgram>>> m_programs;
+
+    ProgramBinaryCache* m_binaryCache;
+
+    size_t m_size = 0;
+};
+
+}
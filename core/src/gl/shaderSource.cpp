@@ -1,14 +1,35 @@
 #include "gl/shaderSource.h"
+#include "gl/hardware.h"
 #include "util/floatFormatter.h"
+#include "util/hash.h"
 
-#include <set>
+#include <algorithm>
+#include <mutex>
 #include <sstream>
-#include <tuple>
+#include <unordered_map>
 
 #include "selection_fs.h"
 
 namespace Tangram {
 
+namespace {
+
+struct CachedSource {
+    uint8_t options;
+    std::string source;
+    std::map<std::string, std::vector<std::string>> blocks;
+    std::string output;
+};
+
+// The cache is cleared when it holds this many sources
+constexpr size_t max_cached_sources = 256;
+
+std::mutex s_cacheMutex;
+std::unordered_map<size_t, std::vector<CachedSource>> s_cache;
+size_t s_cacheSize = 0;
+
+}
+
 void ShaderSource::setSourceStrings(const std::string& _fragSrc, const std::string& _vertSrc){
     m_fragmentShaderSource = std::string(_fragSrc);
     m_vertexShaderSource = std::string(_vertSrc);
@@ -41,10 +62,72 @@ void ShaderSource::addSourceBlock(const std::string& _tagName, const std::string
     m_sourceBlocks[_tagName].push_back(sourceBlock);
 }
 
+bool ShaderSource::contains(const std::string& _token) const {
+
+    if (m_vertexShaderSource.find(_token) != std::string::npos ||
+        m_fragmentShaderSource.find(_token) != std::string::npos) {
+        return true;
+    }
+    for (auto& block : m_sourceBlocks) {
+        for (auto& source : block.second) {
+            if (source.find(_token) != std::string::npos) { return true; }
+        }
+    }
+    return false;
+}
+
 std::string ShaderSource::applySourceBlocks(const std::string& _source, bool _fragShader, bool _selection) const {
 
+    uint8_t options = (_fragShader ? 1 : 0) | (_selection ? 2 : 0) |
+        (m_uniformBlocks ? 4 : 0) | (m_uniformBlocks && Hardware::isGLES ? 8 : 0);
+
+    size_t key = 0;
+    hash_combine(key, options);
+    hash_combine(key, _source);
+    for (auto& block : m_sourceBlocks) {
+        hash_combine(key, block.first);
+        for (auto& s : block.second) { hash_combine(key, s); }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(s_cacheMutex);
+        auto it = s_cache.find(key);
+        if (it != s_cache.end()) {
+            for (auto& entry : it->second) {
+                if (entry.options == options && entry.source == _source &&
+                    entry.blocks == m_sourceBlocks) {
+                    return entry.output;
+                }
+            }
+        }
+    }
+
+    std::string out = assembleSource(_source, _fragShader, _selection);
+
+    std::lock_guard<std::mutex> lock(s_cacheMutex);
+    if (s_cacheSize >= max_cached_sources) {
+        s_cache.clear();
+        s_cacheSize = 0;
+    }
+    s_cache[key].push_back({ options, _source, m_sourceBlocks, out });
+    s_cacheSize++;
+
+    return out;
+}
+
+std::string ShaderSource::assembleSource(const std::string& _source, bool _fragShader, bool _selection) const {
+
     std::string out;
-    std::set<std::string> pragmas;
+
+    size_t shaderLength = 512 + _source.length();
+    for (auto& block : m_sourceBlocks) {
+        for (auto& s : block.second) {
+            shaderLength += s.length() + 1;
+        }
+    }
+    out.reserve(shaderLength);
+
+    appendVersionHeader(out, _fragShader);
 
     out.append("#define TANGRAM_EPSILON 0.00001\n");
     out.append("#define TANGRAM_WORLD_POSITION_WRAP 100000.\n");
@@ -60,14 +143,8 @@ std::string ShaderSource::applySourceBlocks(const std::string& _source, bool _fr
         out.append("#define TANGRAM_FEATURE_SELECTION\n");
     }
 
-    size_t shaderLength = out.length() + _source.length();
-    for (auto& block : m_sourceBlocks) {
-        for (auto& s : block.second) {
-            shaderLength += s.length() + 1;
-        }
-        shaderLength += 1;
-    }
-    out.reserve(shaderLength);
+    // Blocks that were inserted already
+    std::vector<const std::vector<std::string>*> applied;
 
     size_t end = 0;
     const char* str = _source.c_str();
@@ -92,21 +169,27 @@ std::string ShaderSource::applySourceBlocks(const std::string& _source, bool _fr
         out.append(str + start, end - start);
         if (out.back() != '\n') { out.append("\n"); }
 
-        char pragmaName[128];
-        if (sscanf(str + pragma + 8, " tangram:%127s", pragmaName) == 0) {
+        // Read the block name of "#pragma tangram: <name>"
+        size_t name = _source.find_first_not_of(" \t", pragma + 8);
+        if (name >= end || _source.compare(name, 8, "tangram:") != 0) {
+            continue;
+        }
+        name = _source.find_first_not_of(" \t", name + 8);
+        if (name >= end) {
             continue;
         }
+        size_t nameEnd = _source.find_first_of(" \t\r\n", name);
+        if (nameEnd > end) { nameEnd = end; }
 
-        auto block = m_sourceBlocks.find(pragmaName);
+        auto block = m_sourceBlocks.find(_source.substr(name, nameEnd - name));
         if (block == m_sourceBlocks.end()) {
             continue;
         }
 
-        bool unique;
-        std::tie(std::ignore, unique) = pragmas.emplace(pragmaName);
-        if (!unique) {
+        if (std::find(applied.begin(), applied.end(), &block->second) != applied.end()) {
             continue;
         }
+        applied.push_back(&block->second);
 
         // insert blocks
         for (auto& s : block->second) {
@@ -118,13 +201,6 @@ std::string ShaderSource::applySourceBlocks(const std::string& _source, bool _fr
         }
     }
 
-    // printf("overalloc'd: %d\n",  shaderLength - int(out.length()));
-    // for (auto& block : m_sourceBlocks) {
-    //     if (pragmas.find(block.first) == pragmas.end()) {
-    //         logMsg("Warning: expected pragma '%s' in shader source\n",
-    //                block.first.c_str());
-    //     }
-    // }
     return out;
 }
 
@@ -138,8 +214,46 @@ void ShaderSource::addExtensionDeclaration(const std::string& _extension) {
     addSourceBlock("extensions", oss.str());
 }
 
+void ShaderSource::appendVersionHeader(std::string& _out, bool _fragShader) const {
+
+    if (!m_uniformBlocks) { return; }
+
+    // Uniform blocks need GLSL ES 3.00 or GLSL 1.40, which replace the
+    // attribute, varying and texture2D keywords used by the shaders and
+    // scene shader blocks
+    _out.append(Hardware::isGLES ? "#version 300 es\n" : "#version 140\n");
+    _out.append("#define TANGRAM_UNIFORM_BLOCKS\n");
+    _out.append("#define texture2D texture\n");
+
+    if (_fragShader) {
+        _out.append("#define varying in\n");
+        _out.append("#define gl_FragColor tangram_FragColor\n");
+    } else {
+        _out.append("#define attribute in\n");
+        _out.append("#define varying out\n");
+    }
+}
+
 std::string ShaderSource::buildSelectionFragmentSource() const {
+    if (m_uniformBlocks) {
+        std::string out;
+        appendVersionHeader(out, true);
+        out.append("out highp vec4 tangram_FragColor;\n");
+        out.append(selection_fs);
+        return out;
+    }
     return selection_fs;
 }
 
+void ShaderSource::clearCache() {
+    std::lock_guard<std::mutex> lock(s_cacheMutex);
+    s_cache.clear();
+    s_cacheSize = 0;
+}
+
+size_t ShaderSource::cacheSize() {
+    std::lock_guard<std::mutex> lock(s_cacheMutex);
+    return s_cacheSize;
+}
+
 }
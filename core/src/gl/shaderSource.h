@@ -19,8 +19,17 @@ public:
 
     void addExtensionDeclaration(const std::string& _extension);
 
+    // Build the sources as GLSL ES 3.00 or GLSL 1.40 with TANGRAM_UNIFORM_BLOCKS
+    // defined, so that they read the view and light uniforms from uniform blocks
+    void setUniformBlocks(bool _uniformBlocks) { m_uniformBlocks = _uniformBlocks; }
+
+    bool uniformBlocks() const { return m_uniformBlocks; }
+
     const auto& getSourceBlocks() const { return m_sourceBlocks; }
 
+    // Whether _token occurs in the shader sources or in any source block
+    bool contains(const std::string& _token) const;
+
     // Build vertex shader source
     std::string buildVertexSource() const {
         return applySourceBlocks(m_vertexShaderSource, false);
@@ -39,15 +48,30 @@ public:
     // Build selection fragment shader source
     std::string buildSelectionFragmentSource() const;
 
+    // Built sources are cached by their shader source, source blocks and options,
+    // so that styles and scenes with the same inputs do not assemble them again
+    static void clearCache();
+
+    static size_t cacheSize();
+
 private:
 
+    // Return the cached source for these inputs or assemble it
     std::string applySourceBlocks(const std::string& _source, bool _fragShader,
                                   bool _selection = false) const;
 
+    std::string assembleSource(const std::string& _source, bool _fragShader,
+                               bool _selection) const;
+
+    // Version directive and GLSL ES 1.00 compatibility defines for uniform blocks
+    void appendVersionHeader(std::string& _out, bool _fragShader) const;
+
     std::map<std::string, std::vector<std::string>> m_sourceBlocks;
 
     std::string m_vertexShaderSource = "";
     std::string m_fragmentShaderSource = "";
+
+    bool m_uniformBlocks = false;
 };
 
 }
@@ -0,0 +1,158 @@
+#include "gl/startupFrame.h"
+
+#include "gl/primitives.h"
+#include "gl/renderState.h"
+#include "gl/texture.h"
+#include "log.h"
+#include "util/mapProjection.h"
+#include "util/threadPool.h"
+#include "util/zlibHelper.h"
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+namespace Tangram {
+
+constexpr uint32_t StartupFrame::format_version;
+constexpr float StartupFrame::fade_duration;
+constexpr float StartupFrame::max_hold;
+
+static constexpr uint32_t file_magic = 0x46535454; // "TTSF"
+
+struct FrameHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t sceneHash;
+    double x;
+    double y;
+    float zoom;
+    float roll;
+    float pitch;
+    int32_t width;
+    int32_t height;
+    uint32_t length;
+};
+
+bool StartupFrame::ViewPosition::matches(const ViewPosition& _other) const {
+    if (width != _other.width || height != _other.height) { return false; }
+
+    // Angles and zoom within a thousandth, the center within a tenth of a pixel
+    double tolerance = 0.1 * MapProjection::metersPerPixelAtZoom(zoom);
+    return std::abs(zoom - _other.zoom) < 1e-3f &&
+        std::abs(roll - _other.roll) < 1e-3f &&
+        std::abs(pitch - _other.pitch) < 1e-3f &&
+        std::abs(position.x - _other.position.x) < tolerance &&
+        std::abs(position.y - _other.position.y) < tolerance;
+}
+
+std::shared_ptr<StartupFrame> StartupFrame::load(const std::string& _path, uint64_t _sceneHash) {
+
+    auto frame = std::make_shared<StartupFrame>();
+
+    ThreadPool::shared().enqueue(ThreadPool::Priority::io, [frame, _path, _sceneHash]() {
+        std::ifstream stream(_path, std::ifstream::binary);
+        if (!stream.is_open()) {
+            frame->m_state = State::failed;
+            return;
+        }
+
+        FrameHeader header;
+        stream.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!stream.good() || header.magic != file_magic || header.version != format_version ||
+            header.sceneHash != _sceneHash || header.width <= 0 || header.height <= 0) {
+            frame->m_state = State::failed;
+            return;
+        }
+
+        std::vector<char> deflated(header.length);
+        stream.read(deflated.data(), deflated.size());
+
+        std::vector<char> pixels;
+        size_t length = size_t(header.width) * header.height * 4;
+        if (!stream.good() || zlib::inflate(deflated.data(), deflated.size(), pixels) != 0 ||
+            pixels.size() != length) {
+            LOGW("Invalid startup frame: %s", _path.c_str());
+            frame->m_state = State::failed;
+            return;
+        }
+
+        frame->m_texture = std::make_unique<Texture>(TextureOptions());
+        frame->m_texture->setPixelData(header.width, header.height, 4,
+                                       reinterpret_cast<const GLubyte*>(pixels.data()), length);
+
+        frame->m_view.position = { header.x, header.y };
+        frame->m_view.zoom = header.zoom;
+        frame->m_view.roll = header.roll;
+        frame->m_view.pitch = header.pitch;
+        frame->m_view.width = header.width;
+        frame->m_view.height = header.height;
+
+        frame->m_state = State::loaded;
+    });
+
+    return frame;
+}
+
+bool StartupFrame::store(const std::string& _path, uint64_t _sceneHash, const ViewPosition& _view,
+                         const std::vector<GLuint>& _pixels) {
+
+    std::vector<char> deflated;
+    if (zlib::deflate(reinterpret_cast<const char*>(_pixels.data()),
+                      _pixels.size() * sizeof(GLuint), deflated) != 0) {
+        return false;
+    }
+
+    FrameHeader header{ file_magic, format_version, _sceneHash, _view.position.x, _view.position.y,
+                        _view.zoom, _view.roll, _view.pitch, _view.width, _view.height,
+                        uint32_t(deflated.size()) };
+
+    // Write to a temporary file first so that a partial frame is never loaded
+    std::string tmpFile = _path + ".tmp";
+    {
+        std::ofstream stream(tmpFile, std::ofstream::binary | std::ofstream::trunc);
+        if (!stream.is_open()) {
+            LOGW("Cannot write startup frame: %s", tmpFile.c_str());
+            return false;
+        }
+        stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        stream.write(deflated.data(), deflated.size());
+        if (!stream.good()) {
+            stream.close();
+            std::remove(tmpFile.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tmpFile.c_str(), _path.c_str()) != 0) {
+        std::remove(tmpFile.c_str());
+        return false;
+    }
+    return true;
+}
+
+StartupFrame::~StartupFrame() {}
+
+bool StartupFrame::canDraw(const ViewPosition& _view) const {
+    return m_state == State::loaded && m_view.matches(_view);
+}
+
+bool StartupFrame::update(float _dt, bool _viewComplete) {
+    m_holdTime += _dt;
+    if (_viewComplete || m_holdTime >= max_hold) {
+        m_fading = true;
+    }
+    if (m_fading) {
+        m_alpha -= _dt / fade_duration;
+    }
+    return m_alpha > 0.f;
+}
+
+void StartupFrame::draw(RenderState& _rs, glm::vec2 _viewport) {
+    Primitives::setResolution(_rs, _viewport.x, _viewport.y);
+
+    _rs.blending(GL_TRUE);
+    _rs.blendingFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    Primitives::drawTexture(_rs, *m_texture, glm::vec2{}, _viewport, m_alpha);
+}
+
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "gl.h"
+
+#include "glm/vec2.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Tangram {
+
+class RenderState;
+class Texture;
+
+/* Frame of the last session, drawn while the scene loads
+ *
+ * The last frame rendered for a settled view is stored with the hash of the
+ * scene options and the position of the view as deflated RGBA rows. On the
+ * next start the frame is read on a worker thread and drawn while the same
+ * scene loads at the same position, then faded out to the live map.
+ */
+class StartupFrame {
+
+public:
+
+    // Version of the file format
+    static constexpr uint32_t format_version = 1;
+
+    // Seconds the frame fades out over
+    static constexpr float fade_duration = 0.3f;
+
+    // Seconds the frame is drawn over the ready scene while its tiles load
+    static constexpr float max_hold = 2.f;
+
+    struct ViewPosition {
+        glm::dvec2 position;
+        float zoom = 0;
+        float roll = 0;
+        float pitch = 0;
+        int width = 0;
+        int height = 0;
+
+        // Whether the views show the same area, up to a fraction of a pixel
+        bool matches(const ViewPosition& _other) const;
+    };
+
+    /* Starts reading the frame stored at _path for the scene of _sceneHash on
+     * the shared ThreadPool */
+    static std::shared_ptr<StartupFrame> load(const std::string& _path, uint64_t _sceneHash);
+
+    /* Writes _pixels, the rows of a frame of _view from the bottom up, to _path.
+     * Returns false on failure. */
+    static bool store(const std::string& _path, uint64_t _sceneHash, const ViewPosition& _view,
+                      const std::vector<GLuint>& _pixels);
+
+    ~StartupFrame();
+
+    // Whether the frame is still being read
+    bool isLoading() const { return m_state == State::loading; }
+
+    // Whether the frame was read and can be drawn for _view
+    bool canDraw(const ViewPosition& _view) const;
+
+    /* Advances the fade out of the frame over the ready scene, which starts
+     * once _viewComplete or after max_hold. Returns false once the frame is
+     * transparent. */
+    bool update(float _dt, bool _viewComplete);
+
+    void draw(RenderState& _rs, glm::vec2 _viewport);
+
+private:
+
+    enum class State : uint8_t {
+        loading,
+        loaded,
+        failed,
+    };
+
+    std::atomic<State> m_state{State::loading};
+
+    // Set by the loading job before m_state is loaded
+    std::unique_ptr<Texture> m_texture;
+    ViewPosition m_view;
+
+    float m_alpha = 1.f;
+    float m_holdTime = 0;
+    bool m_fading = false;
+};
+
+}
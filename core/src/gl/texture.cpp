@@ -7,14 +7,76 @@
 #include "map.h"
 #include "platform.h"
 #include "util/geom.h"
+#include "util/zlibHelper.h"
 
 #include "stb_image.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstring> // for memset
 
 namespace Tangram {
 
+// KTX 2.0 container: Identifier, header, index and the level index that
+// follows with one entry per mipmap level.
+// See https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html
+static const uint8_t ktx2_identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+static const size_t ktx2_header_size = 80;
+static const size_t ktx2_level_size = 24;
+
+// Rows that uploadSlice() uploads at least
+static const int texture_slice_rows = 32;
+
+template<typename T>
+static T readLE(const uint8_t* _data) {
+    T value;
+    std::memcpy(&value, _data, sizeof(T));
+    return value;
+}
+
+struct CompressedFormat {
+    GLenum glFormat;
+    uint32_t blockWidth, blockHeight, blockBytes;
+    bool supported;
+};
+
+// Maps the VkFormat of a KTX2 texture to a GL format. sRGB variants are not
+// supported since styles blend colors in gamma space.
+static bool ktx2Format(uint32_t _vkFormat, CompressedFormat& _format) {
+    switch (_vkFormat) {
+    case 131: // VK_FORMAT_BC1_RGB_UNORM_BLOCK
+        _format = { GL_COMPRESSED_RGB_S3TC_DXT1_EXT, 4, 4, 8, Hardware::supportsS3TC };
+        return true;
+    case 133: // VK_FORMAT_BC1_RGBA_UNORM_BLOCK
+        _format = { GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, 4, 4, 8, Hardware::supportsS3TC };
+        return true;
+    case 137: // VK_FORMAT_BC3_UNORM_BLOCK
+        _format = { GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, 4, 4, 16, Hardware::supportsS3TC };
+        return true;
+    case 145: // VK_FORMAT_BC7_UNORM_BLOCK
+        _format = { GL_COMPRESSED_RGBA_BPTC_UNORM, 4, 4, 16, Hardware::supportsBPTC };
+        return true;
+    case 147: // VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK
+        _format = { GL_COMPRESSED_RGB8_ETC2, 4, 4, 8, Hardware::supportsETC2 };
+        return true;
+    case 151: // VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK
+        _format = { GL_COMPRESSED_RGBA8_ETC2_EAC, 4, 4, 16, Hardware::supportsETC2 };
+        return true;
+    default:
+        break;
+    }
+    // VK_FORMAT_ASTC_4x4_UNORM_BLOCK to VK_FORMAT_ASTC_8x8_UNORM_BLOCK, which
+    // alternate with their sRGB variants. The GL formats are consecutive.
+    static const uint32_t astcBlocks[8][2] = { {4, 4}, {5, 4}, {5, 5}, {6, 5}, {6, 6}, {8, 5}, {8, 6}, {8, 8} };
+    if (_vkFormat >= 157 && _vkFormat <= 171 && (_vkFormat - 157) % 2 == 0) {
+        uint32_t i = (_vkFormat - 157) / 2;
+        _format = { GLenum(GL_COMPRESSED_RGBA_ASTC_4x4_KHR + i), astcBlocks[i][0], astcBlocks[i][1], 16,
+                    Hardware::supportsASTC };
+        return true;
+    }
+    return false;
+}
+
 Texture::Texture(TextureOptions _options) : m_options(_options) {}
 
 Texture::Texture(const uint8_t* data, size_t length, TextureOptions options)
@@ -23,17 +85,39 @@ Texture::Texture(const uint8_t* data, size_t length, TextureOptions options)
 }
 
 Texture::~Texture() {
-    if (m_rs) {
-        m_rs->queueTextureDeletion(m_glHandle);
+    // Handles of a lost context are gone with it
+    if (m_rs && m_rsGeneration == m_rs->handleGeneration()) {
+        // Textures with storage are reused for new textures of the same size
+        if (m_storageWidth > 0) {
+            size_t bytes = size_t(m_storageWidth) * m_storageHeight * bpp();
+            if (m_options.generateMipmaps) { bytes += bytes / 3; }
+            m_rs->recyclePool().recycleTexture(m_glHandle, storageKey(m_storageWidth, m_storageHeight),
+                                               bytes);
+        } else {
+            m_rs->queueTextureDeletion(m_glHandle);
+        }
     }
 }
 
-bool Texture::loadImageFromMemory(const uint8_t* data, size_t length) {
-    // stbi_load_from_memory loads the image as a series of scanlines starting
-    // from the top-left corner of the image. This flips the output such that
-    // the data begins at the bottom-left corner, as required for our OpenGL
-    // texture coordinates.
-    stbi_set_flip_vertically_on_load(true);
+RecyclePool::TextureKey Texture::storageKey(int _width, int _height) const {
+    return { _width, _height, static_cast<GLenum>(m_options.pixelFormat),
+             m_options.generateMipmaps };
+}
+
+bool Texture::isKTX2(const uint8_t* data, size_t length) {
+    return length >= ktx2_header_size &&
+        std::memcmp(data, ktx2_identifier, sizeof(ktx2_identifier)) == 0;
+}
+
+bool Texture::loadImageFromMemory(const uint8_t* data, size_t length, const Platform* _platform) {
+    if (isKTX2(data, length)) {
+        if (loadKTX2(data, length)) { return true; }
+
+        GLubyte pixel[4] = { 0, 0, 0, 255 };
+        setPixelData(1, 1, bpp(), pixel, bpp());
+        return false;
+    }
+    m_compressedFormat = 0;
 
     int width = 0, height = 0;
     int channelsInFile = 0;
@@ -41,6 +125,28 @@ bool Texture::loadImageFromMemory(const uint8_t* data, size_t length) {
 
     LOGTInit();
 
+    if (_platform) {
+        auto allocator = [&](size_t _size) {
+            m_buffer.reset(reinterpret_cast<GLubyte*>(std::malloc(_size)));
+            return m_buffer.get();
+        };
+        if (_platform->decodeImage(data, length, channelsRequested, width, height, allocator) &&
+            m_buffer && width > 0 && height > 0) {
+            m_bufferSize = width * height * bpp();
+            resize(width, height);
+
+            LOGT("Decoded image data with platform decoder: %dx%d bpp:%d",
+                 width, height, channelsRequested);
+            return true;
+        }
+    }
+
+    // stbi_load_from_memory loads the image as a series of scanlines starting
+    // from the top-left corner of the image. This flips the output such that
+    // the data begins at the bottom-left corner, as required for our OpenGL
+    // texture coordinates.
+    stbi_set_flip_vertically_on_load(true);
+
     m_buffer.reset(stbi_load_from_memory(data, static_cast<int>(length),
                                          &width, &height, &channelsInFile,
                                          channelsRequested));
@@ -76,6 +182,7 @@ bool Texture::setPixelData(int _width, int _height, int _bytesPerPixel,
     if (m_bufferSize != _length) {
         m_buffer.reset();
     }
+    m_compressedFormat = 0;
 
     if (!m_buffer) {
         m_buffer.reset(reinterpret_cast<GLubyte*>(std::malloc(_length)));
@@ -95,17 +202,123 @@ bool Texture::setPixelData(int _width, int _height, int _bytesPerPixel,
     return true;
 }
 
+// Compressed data is uploaded as is, so that it is not decoded on the worker
+// and takes a fraction of the memory of RGBA data on the GPU. Data that is not
+// supercompressed is supported, since Basis and zstd need a transcoder.
+// Textures are expected to have their origin at the lower-left corner like
+// decoded images, e.g. from 'toktx --lower_left_maps_to_s0t0'.
+bool Texture::loadKTX2(const uint8_t* _data, size_t _length) {
+    uint32_t vkFormat = readLE<uint32_t>(_data + 12);
+    uint32_t width = readLE<uint32_t>(_data + 20);
+    uint32_t height = readLE<uint32_t>(_data + 24);
+    uint32_t depth = readLE<uint32_t>(_data + 28);
+    uint32_t layers = readLE<uint32_t>(_data + 32);
+    uint32_t faces = readLE<uint32_t>(_data + 36);
+    uint32_t levels = std::max(readLE<uint32_t>(_data + 40), 1u);
+    uint32_t supercompression = readLE<uint32_t>(_data + 44);
+
+    if (supercompression != 0) {
+        LOGE("Unsupported KTX2 supercompression scheme: %d", supercompression);
+        return false;
+    }
+    if (width == 0 || height == 0 || depth != 0 || layers != 0 || faces != 1) {
+        LOGE("Unsupported KTX2 texture: %dx%dx%d layers:%d faces:%d", width, height, depth, layers, faces);
+        return false;
+    }
+    CompressedFormat format;
+    if (!ktx2Format(vkFormat, format)) {
+        LOGE("Unsupported KTX2 format: %d", vkFormat);
+        return false;
+    }
+    if (!format.supported) {
+        LOGW("KTX2 format %d is not supported by the GPU", vkFormat);
+        return false;
+    }
+    if (_length < ktx2_header_size + levels * ktx2_level_size) {
+        LOGE("Invalid KTX2 level index: %d levels", levels);
+        return false;
+    }
+
+    std::vector<size_t> levelSizes;
+    size_t total = 0;
+    for (uint32_t i = 0; i < levels; i++) {
+        const uint8_t* entry = _data + ktx2_header_size + i * ktx2_level_size;
+        uint64_t offset = readLE<uint64_t>(entry);
+        uint64_t size = readLE<uint64_t>(entry + 8);
+
+        uint32_t w = std::max(width >> i, 1u);
+        uint32_t h = std::max(height >> i, 1u);
+        size_t expected = size_t((w + format.blockWidth - 1) / format.blockWidth) *
+            ((h + format.blockHeight - 1) / format.blockHeight) * format.blockBytes;
+
+        if (size != expected || offset > _length || size > _length - offset) {
+            LOGE("Invalid KTX2 level %d: %d bytes", i, int(size));
+            return false;
+        }
+        levelSizes.push_back(expected);
+        total += expected;
+    }
+
+    m_buffer.reset(reinterpret_cast<GLubyte*>(std::malloc(total)));
+    if (!m_buffer) {
+        LOGE("Could not allocate texture: Out of memory!");
+        return false;
+    }
+    GLubyte* level = m_buffer.get();
+    for (uint32_t i = 0; i < levels; i++) {
+        uint64_t offset = readLE<uint64_t>(_data + ktx2_header_size + i * ktx2_level_size);
+        std::memcpy(level, _data + offset, levelSizes[i]);
+        level += levelSizes[i];
+    }
+
+    m_bufferSize = total;
+    m_compressedFormat = format.glFormat;
+    m_levelSizes = std::move(levelSizes);
+
+    // Mipmaps can only come from the container
+    m_options.generateMipmaps = false;
+    uint32_t mipmapLevels = 1;
+    while ((std::max(width, height) >> mipmapLevels) > 0) { mipmapLevels++; }
+    if (levels < mipmapLevels &&
+        m_options.minFilter != TextureMinFilter::NEAREST &&
+        m_options.minFilter != TextureMinFilter::LINEAR) {
+        m_options.minFilter = TextureMinFilter::LINEAR;
+    }
+
+    resize(width, height);
+
+    return true;
+}
+
 void Texture::setSpriteAtlas(std::unique_ptr<Tangram::SpriteAtlas> sprites) {
     m_spriteAtlas = std::move(sprites);
 }
 
 void Texture::generate(RenderState& _rs, GLuint _textureUnit) {
-    GL::genTextures(1, &m_glHandle);
+    m_storageWidth = 0;
+    m_storageHeight = 0;
+
+    // Reuse the texture of a deleted texture with the same storage
+    if (m_compressedFormat == 0 && m_width > 0 && m_height > 0) {
+        m_glHandle = _rs.recyclePool().acquireTexture(storageKey(m_width, m_height));
+    }
+    if (m_glHandle != 0) {
+        m_storageWidth = m_width;
+        m_storageHeight = m_height;
+    } else {
+        GL::genTextures(1, &m_glHandle);
+    }
 
     _rs.texture(m_glHandle, _textureUnit, GL_TEXTURE_2D);
 
-    GL::texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
-                      static_cast<GLint>(m_options.minFilter));
+    // Textures are drawn without mipmaps until they are generated
+    auto minFilter = m_options.minFilter;
+    if (m_options.generateMipmaps) {
+        minFilter = (minFilter == TextureMinFilter::NEAREST_MIPMAP_NEAREST ||
+                     minFilter == TextureMinFilter::NEAREST_MIPMAP_LINEAR)
+            ? TextureMinFilter::NEAREST : TextureMinFilter::LINEAR;
+    }
+    GL::texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, static_cast<GLint>(minFilter));
     GL::texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER,
                       static_cast<GLint>(m_options.magFilter));
 
@@ -115,10 +328,13 @@ void Texture::generate(RenderState& _rs, GLuint _textureUnit) {
                       static_cast<GLint>(m_options.wrapT));
 
     m_rs = &_rs;
+    m_rsGeneration = _rs.handleGeneration();
 }
 
 bool Texture::upload(RenderState& _rs, GLuint _textureUnit) {
     m_shouldResize = false;
+    m_uploadedRows = 0;
+    m_mipmapsPending = false;
 
     if (Hardware::maxTextureSize < m_width ||
         Hardware::maxTextureSize < m_height) {
@@ -126,28 +342,138 @@ bool Texture::upload(RenderState& _rs, GLuint _textureUnit) {
         if (m_disposeBuffer) { m_buffer.reset(); }
         return false;
     }
+    if (m_compressedFormat != 0 && !m_buffer) {
+        LOGW("Compressed texture data has been disposed");
+        return false;
+    }
     if (m_glHandle == 0) {
         generate(_rs, _textureUnit);
     } else {
         _rs.texture(m_glHandle, _textureUnit, GL_TEXTURE_2D);
     }
 
+    if (m_compressedFormat != 0) {
+        const GLubyte* level = m_buffer.get();
+        for (size_t i = 0; i < m_levelSizes.size(); i++) {
+            GL::compressedTexImage2D(GL_TEXTURE_2D, i, m_compressedFormat,
+                                     std::max(m_width >> i, 1), std::max(m_height >> i, 1), 0,
+                                     m_levelSizes[i], level);
+            level += m_levelSizes[i];
+        }
+        m_storageWidth = 0;
+        m_storageHeight = 0;
+        return true;
+    }
+
     auto format = static_cast<GLenum>(m_options.pixelFormat);
-    GL::texImage2D(GL_TEXTURE_2D, 0, format, m_width, m_height, 0, format,
-                   GL_UNSIGNED_BYTE, m_buffer.get());
+    if (m_buffer && hasStorage()) {
+        GL::texSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_width, m_height, format,
+                          GL_UNSIGNED_BYTE, m_buffer.get());
+    } else {
+        GL::texImage2D(GL_TEXTURE_2D, 0, format, m_width, m_height, 0, format,
+                       GL_UNSIGNED_BYTE, m_buffer.get());
+        m_storageWidth = m_width;
+        m_storageHeight = m_height;
+    }
+
+    if (m_buffer) {
+        _rs.addUploadedBytes(m_bufferSize);
 
-    if (m_buffer && m_options.generateMipmaps) {
-        GL::generateMipmap(GL_TEXTURE_2D);
+        if (m_options.generateMipmaps) {
+            m_mipmapsPending = true;
+            _rs.deferUpload();
+        }
     }
     return true;
 }
 
+bool Texture::uploadRows(RenderState& _rs, int _x, int _y, int _width, int _height,
+                         const GLubyte* _data) {
+    size_t rowBytes = _width * bpp();
+    size_t budget = _rs.uploadBudget - std::min(_rs.uploadedBytes(), _rs.uploadBudget);
+    int rows = std::max(texture_slice_rows, int(budget / rowBytes));
+    rows = std::min(rows, _height - m_uploadedRows);
+
+    auto format = static_cast<GLenum>(m_options.pixelFormat);
+    GL::texSubImage2D(GL_TEXTURE_2D, 0, _x, _y + m_uploadedRows, _width, rows, format,
+                      GL_UNSIGNED_BYTE, _data + m_uploadedRows * rowBytes);
+
+    _rs.addUploadedBytes(rows * rowBytes);
+    m_uploadedRows += rows;
+
+    if (m_uploadedRows < _height) { return false; }
+
+    m_uploadedRows = 0;
+    return true;
+}
+
+bool Texture::uploadSlice(RenderState& _rs, GLuint _textureUnit) {
+    recoverLostContext(_rs);
+
+    if (!m_shouldResize) { return true; }
+
+    // Rows are uploaded in slices when they need no padding for
+    // GL_UNPACK_ALIGNMENT. Other data is uploaded whole.
+    if (!m_buffer || m_compressedFormat != 0 || (m_width * bpp()) % 4 != 0 ||
+        Hardware::maxTextureSize < m_width || Hardware::maxTextureSize < m_height) {
+        bind(_rs, _textureUnit);
+        return true;
+    }
+
+    if (m_uploadedRows == 0) {
+        // Allocate the storage for the slices
+        if (m_glHandle == 0) {
+            generate(_rs, _textureUnit);
+        } else {
+            _rs.texture(m_glHandle, _textureUnit, GL_TEXTURE_2D);
+        }
+        if (!hasStorage()) {
+            auto format = static_cast<GLenum>(m_options.pixelFormat);
+            GL::texImage2D(GL_TEXTURE_2D, 0, format, m_width, m_height, 0, format,
+                           GL_UNSIGNED_BYTE, nullptr);
+            m_storageWidth = m_width;
+            m_storageHeight = m_height;
+        }
+    } else {
+        _rs.texture(m_glHandle, _textureUnit, GL_TEXTURE_2D);
+    }
+
+    if (!uploadRows(_rs, 0, 0, m_width, m_height, m_buffer.get())) { return false; }
+
+    m_shouldResize = false;
+    if (m_options.generateMipmaps) {
+        m_mipmapsPending = true;
+        _rs.deferUpload();
+    }
+    if (m_disposeBuffer) { m_buffer.reset(); }
+
+    return true;
+}
+
+void Texture::generateMipmaps(RenderState& _rs) {
+    if (!_rs.hasUploadBudget()) {
+        _rs.deferUpload();
+        return;
+    }
+    GL::generateMipmap(GL_TEXTURE_2D);
+    GL::texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                      static_cast<GLint>(m_options.minFilter));
+
+    // The levels below the first take a third of its size
+    _rs.addUploadedBytes(m_bufferSize / 3);
+    m_mipmapsPending = false;
+}
+
 bool Texture::bind(RenderState& _rs, GLuint _textureUnit) {
 
+    recoverLostContext(_rs);
+
     if (!m_shouldResize) {
         if (m_glHandle == 0) { return false; }
 
         _rs.texture(m_glHandle, _textureUnit, GL_TEXTURE_2D);
+
+        if (m_mipmapsPending) { generateMipmaps(_rs); }
         return true;
     }
 
@@ -179,6 +505,50 @@ void Texture::resize(int width, int height) {
     m_shouldResize = true;
 }
 
+void Texture::retainCompressedCopy() {
+    m_compressedCopy.clear();
+    if (!m_buffer) { return; }
+
+    if (zlib::deflate(reinterpret_cast<const char*>(m_buffer.get()), m_bufferSize,
+                      m_compressedCopy) != 0) {
+        LOGW("Could not retain a copy of texture data");
+        m_compressedCopy.clear();
+    }
+    m_compressedCopy.shrink_to_fit();
+}
+
+bool Texture::restoreCompressedCopy() {
+    if (m_compressedCopy.empty()) { return false; }
+
+    std::vector<char> data;
+    if (zlib::inflate(m_compressedCopy.data(), m_compressedCopy.size(), data) != 0 ||
+        data.size() != m_bufferSize) {
+        LOGW("Invalid copy of texture data");
+        return false;
+    }
+    m_buffer.reset(reinterpret_cast<GLubyte*>(std::malloc(m_bufferSize)));
+    if (!m_buffer) { return false; }
+
+    std::memcpy(m_buffer.get(), data.data(), m_bufferSize);
+    return true;
+}
+
+bool Texture::recoverLostContext(RenderState& _rs) {
+    if (m_glHandle == 0 || m_rsGeneration == _rs.handleGeneration()) { return false; }
+
+    // The GL texture went with the context, it is uploaded again on the next bind
+    m_glHandle = 0;
+    m_storageWidth = 0;
+    m_storageHeight = 0;
+    m_uploadedRows = 0;
+    m_mipmapsPending = false;
+    m_shouldResize = true;
+
+    if (!m_buffer) { restoreCompressedCopy(); }
+
+    return true;
+}
+
 size_t Texture::bpp() const {
     return m_options.bytesPerPixel();
 }
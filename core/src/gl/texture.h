@@ -1,8 +1,12 @@
 #pragma once
 
 #include "gl.h"
+#include "gl/recyclePool.h"
 #include "scene/spriteAtlas.h"
 
+#include "glm/vec3.hpp"
+#include "glm/vec4.hpp"
+
 #include <cstdlib>
 #include <vector>
 #include <memory>
@@ -10,6 +14,7 @@
 
 namespace Tangram {
 
+class Platform;
 class RenderState;
 
 enum class TextureMinFilter : GLenum {
@@ -74,7 +79,12 @@ public:
 
     virtual ~Texture();
 
-    bool loadImageFromMemory(const uint8_t* data, size_t length);
+    // Decodes PNG or JPEG data, or loads the compressed levels of a KTX2 container.
+    // Returns false when the data is invalid or its format is not supported by the GPU.
+    // Images are decoded by _platform when it has a decoder for them.
+    bool loadImageFromMemory(const uint8_t* data, size_t length, const Platform* _platform = nullptr);
+
+    static bool isKTX2(const uint8_t* data, size_t length);
 
     // Sets texture pixel data
     bool setPixelData(int _width, int _height, int _bytesPerPixel, const GLubyte* _data, size_t _length);
@@ -84,6 +94,12 @@ public:
     // supported by the driver.
     virtual bool bind(RenderState& rs, GLuint _unit);
 
+    // Uploads the next rows of new texture data within the upload budget of
+    // rs, and at least one slice of them. Returns true once the texture can be
+    // drawn. Mipmaps are generated by a later bind within the budget, until
+    // then the texture is drawn without them.
+    virtual bool uploadSlice(RenderState& rs, GLuint _unit);
+
     // Width and Height texture getters
     int width() const { return m_width; }
     int height() const { return m_height; }
@@ -91,25 +107,71 @@ public:
     // Size of texture data in bytes
     size_t bufferSize() const { return m_bufferSize; }
 
+    // Bytes of texture data in memory, until it is disposed after upload, and on the GPU
+    size_t cpuBytes() const { return (m_buffer ? m_bufferSize : 0) + m_compressedCopy.size(); }
+    virtual size_t gpuBytes() const { return m_glHandle != 0 ? m_bufferSize : 0; }
+
+    // Origin and scale of the texture coordinates of the image, for textures
+    // that hold it in a part of a shared GL texture
+    virtual glm::vec3 region() const { return { 0.f, 0.f, 1.f }; }
+
+    // Origin, width and height of the texture coordinates of the image, as
+    // region() for images that are not square
+    virtual glm::vec4 uvRect() const { return { 0.f, 0.f, 1.f, 1.f }; }
+
+    // Texture whose GL texture bind() binds; the same for all images of an atlas
+    virtual const Texture* sharedTexture() const { return this; }
+
     float displayScale() const { return m_options.displayScale; }
 
+    // GL format of compressed texture data, or 0
+    GLenum compressedFormat() const { return m_compressedFormat; }
+
     const auto& spriteAtlas() const { return m_spriteAtlas; }
     void setSpriteAtlas(std::unique_ptr<SpriteAtlas> sprites);
 
     // Resize the texture
     void resize(int width, int height);
 
+    // Keeps a deflated copy of the texture data, from which it is uploaded
+    // again after a loss of the GL context once the data has been disposed
+    void retainCompressedCopy();
+
+    // Drops the GL texture of a lost context and restores the texture data
+    // for the next upload. Returns true when the texture had a GL texture of
+    // a lost context.
+    bool recoverLostContext(RenderState& rs);
+
 protected:
 
     // Bytes per pixel for current PixelFormat options
     size_t bpp() const;
 
+    // Generates the GL texture, or reuses a deleted texture with storage for this size
     void generate(RenderState& rs, GLuint _textureUnit);
 
+    RecyclePool::TextureKey storageKey(int _width, int _height) const;
+
+    // Whether the GL texture has storage for the current size
+    bool hasStorage() const {
+        return m_storageWidth > 0 && m_storageWidth == m_width && m_storageHeight == m_height;
+    }
+
     bool upload(RenderState& rs, GLuint _textureUnit);
 
+    // Uploads rows of _data from m_uploadedRows on to the region of the bound
+    // texture at _x, _y. Returns true when all rows are uploaded.
+    bool uploadRows(RenderState& rs, int _x, int _y, int _width, int _height, const GLubyte* _data);
+
+    void generateMipmaps(RenderState& rs);
+
+    // Restores the texture data from the retained copy
+    bool restoreCompressedCopy();
+
     bool sanityCheck(size_t _width, size_t _height, size_t _bytesPerPixel, size_t _length) const;
 
+    bool loadKTX2(const uint8_t* data, size_t length);
+
     void setBufferData(GLubyte* buffer, size_t size) {
         if (m_buffer.get() == buffer) { return; }
         m_buffer.reset(buffer);
@@ -123,9 +185,24 @@ protected:
 
     size_t m_bufferSize = 0;
 
+    // Compressed data holds the mipmap levels one after another, from the largest
+    GLenum m_compressedFormat = 0;
+    std::vector<size_t> m_levelSizes;
+
     GLuint m_glHandle = 0;
+    // Handle generation of the RenderState when m_glHandle was generated
+    uint32_t m_rsGeneration = 0;
+    // Size of the level 0 storage of m_glHandle, or 0 when it has none to reuse
+    int m_storageWidth = 0;
+    int m_storageHeight = 0;
+
+    // Deflated copy of the texture data, see retainCompressedCopy()
+    std::vector<char> m_compressedCopy;
 
     bool m_shouldResize = false;
+    // Rows of the new data that uploadSlice() has uploaded
+    int m_uploadedRows = 0;
+    bool m_mipmapsPending = false;
     // Dipose buffer after texture upload
     bool m_disposeBuffer = true;
 
@@ -0,0 +1,171 @@
+#include "gl/uniformBuffer.h"
+
+#include "gl/glError.h"
+#include "gl/renderState.h"
+#include "gl/shaderProgram.h"
+#include "log.h"
+
+#include "glm/gtc/type_ptr.hpp"
+
+#include <cstring>
+
+namespace Tangram {
+
+constexpr GLuint UniformBuffer::VIEW_BINDING;
+constexpr GLuint UniformBuffer::LIGHTS_BINDING;
+constexpr const char* UniformBuffer::VIEW_BLOCK;
+constexpr const char* UniformBuffer::LIGHTS_BLOCK;
+
+UniformBuffer::UniformBuffer(std::string _blockName, GLuint _binding) :
+    m_blockName(std::move(_blockName)),
+    m_binding(_binding) {}
+
+UniformBuffer::~UniformBuffer() {
+    if (m_rs && m_glBuffer) {
+        m_rs->queueBufferDeletion(1, &m_glBuffer);
+    }
+}
+
+void UniformBuffer::bindBlocks(GLuint _program) {
+    GLuint index = GL::getUniformBlockIndex(_program, VIEW_BLOCK);
+    if (index != GL_INVALID_INDEX) {
+        GL::uniformBlockBinding(_program, index, VIEW_BINDING);
+    }
+    index = GL::getUniformBlockIndex(_program, LIGHTS_BLOCK);
+    if (index != GL_INVALID_INDEX) {
+        GL::uniformBlockBinding(_program, index, LIGHTS_BINDING);
+    }
+}
+
+template <class T>
+void UniformBuffer::set(const UniformLocation& _loc, const T& _value) {
+    for (auto& member : m_members) {
+        if (member.name != _loc.name) { continue; }
+
+        if (member.value.is<T>() && member.value.get<T>() == _value) {
+            return;
+        }
+        member.value = _value;
+        m_dirty = true;
+        return;
+    }
+    // Members added after the layout was read are looked up in the next program
+    m_members.push_back({ _loc.name, _value, -1 });
+    m_layoutLoaded = false;
+    m_dirty = true;
+}
+
+void UniformBuffer::setUniformf(const UniformLocation& _loc, float _value) {
+    set(_loc, _value);
+}
+
+void UniformBuffer::setUniformf(const UniformLocation& _loc, const glm::vec2& _value) {
+    set(_loc, _value);
+}
+
+void UniformBuffer::setUniformf(const UniformLocation& _loc, const glm::vec3& _value) {
+    set(_loc, _value);
+}
+
+void UniformBuffer::setUniformf(const UniformLocation& _loc, const glm::vec4& _value) {
+    set(_loc, _value);
+}
+
+void UniformBuffer::setUniformMatrix3f(const UniformLocation& _loc, const glm::mat3& _value) {
+    set(_loc, _value);
+}
+
+void UniformBuffer::setUniformMatrix4f(const UniformLocation& _loc, const glm::mat4& _value) {
+    set(_loc, _value);
+}
+
+bool UniformBuffer::loadLayout(GLuint _program) {
+
+    GLuint block = GL::getUniformBlockIndex(_program, m_blockName.c_str());
+    if (block == GL_INVALID_INDEX) { return false; }
+
+    GLint size = 0;
+    GL::getActiveUniformBlockiv(_program, block, GL_UNIFORM_BLOCK_DATA_SIZE, &size);
+
+    std::vector<const GLchar*> names;
+    for (auto& member : m_members) { names.push_back(member.name.c_str()); }
+
+    std::vector<GLuint> indices(names.size(), GL_INVALID_INDEX);
+    GL::getUniformIndices(_program, names.size(), names.data(), indices.data());
+
+    for (size_t i = 0; i < m_members.size(); i++) {
+        // Uniforms that are not members of the block are not written
+        m_members[i].offset = -1;
+        if (indices[i] != GL_INVALID_INDEX) {
+            GL::getActiveUniformsiv(_program, 1, &indices[i], GL_UNIFORM_OFFSET, &m_members[i].offset);
+        }
+    }
+
+    m_data.assign(size, 0);
+    m_layoutLoaded = true;
+    m_dirty = true;
+
+    return true;
+}
+
+void UniformBuffer::pack() {
+
+    auto write = [&](GLint _offset, const float* _values, size_t _count) {
+        if (_offset + _count * sizeof(float) > m_data.size()) {
+            LOGW("Uniform exceeds the size of block %s", m_blockName.c_str());
+            return;
+        }
+        std::memcpy(&m_data[_offset], _values, _count * sizeof(float));
+    };
+
+    for (auto& member : m_members) {
+        if (member.offset < 0) { continue; }
+
+        auto& value = member.value;
+        if (value.is<float>()) {
+            write(member.offset, &value.get<float>(), 1);
+        } else if (value.is<glm::vec2>()) {
+            write(member.offset, glm::value_ptr(value.get<glm::vec2>()), 2);
+        } else if (value.is<glm::vec3>()) {
+            write(member.offset, glm::value_ptr(value.get<glm::vec3>()), 3);
+        } else if (value.is<glm::vec4>()) {
+            write(member.offset, glm::value_ptr(value.get<glm::vec4>()), 4);
+        } else if (value.is<glm::mat3>()) {
+            // std140 aligns each matrix column to a vec4
+            auto& m = value.get<glm::mat3>();
+            for (int i = 0; i < 3; i++) {
+                write(member.offset + i * 4 * sizeof(float), glm::value_ptr(m[i]), 3);
+            }
+        } else if (value.is<glm::mat4>()) {
+            write(member.offset, glm::value_ptr(value.get<glm::mat4>()), 16);
+        }
+    }
+}
+
+bool UniformBuffer::update(RenderState& rs, ShaderProgram& _program) {
+
+    if (!_program.use(rs)) { return false; }
+
+    if (!m_layoutLoaded && !loadLayout(_program.getGlProgram())) {
+        return false;
+    }
+
+    if (m_dirty) {
+        pack();
+
+        if (!m_glBuffer) {
+            GL::genBuffers(1, &m_glBuffer);
+            m_rs = &rs;
+        }
+        GL::bindBuffer(GL_UNIFORM_BUFFER, m_glBuffer);
+        GL::bufferData(GL_UNIFORM_BUFFER, m_data.size(), m_data.data(), GL_DYNAMIC_DRAW);
+
+        m_dirty = false;
+    }
+
+    rs.uniformBuffer(m_binding, m_glBuffer);
+
+    return true;
+}
+
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "gl.h"
+#include "gl/uniform.h"
+
+#include "glm/glm.hpp"
+
+#include <string>
+#include <vector>
+
+namespace Tangram {
+
+class RenderState;
+class ShaderProgram;
+
+/* Uniform buffer object backing a std140 uniform block of the style shaders
+ *
+ * Uniforms that are the same for all styles are set once per frame into the
+ * buffer instead of into each program. The member offsets are read from the
+ * first program that declares the block; std140 makes them the same in all
+ * programs. Values are kept until the layout is known, so that they can be
+ * set before any program is built.
+ */
+class UniformBuffer {
+
+public:
+
+    // Binding points of the uniform blocks, assigned when a program is linked
+    static constexpr GLuint VIEW_BINDING = 0;
+    static constexpr GLuint LIGHTS_BINDING = 1;
+
+    static constexpr const char* VIEW_BLOCK = "TangramView";
+    static constexpr const char* LIGHTS_BLOCK = "TangramLights";
+
+    UniformBuffer(std::string _blockName, GLuint _binding);
+    ~UniformBuffer();
+
+    UniformBuffer(const UniformBuffer&) = delete;
+    UniformBuffer& operator=(const UniformBuffer&) = delete;
+
+    // Assign the binding points of the blocks declared by _program
+    static void bindBlocks(GLuint _program);
+
+    void setUniformf(const UniformLocation& _loc, float _value);
+    void setUniformf(const UniformLocation& _loc, const glm::vec2& _value);
+    void setUniformf(const UniformLocation& _loc, const glm::vec3& _value);
+    void setUniformf(const UniformLocation& _loc, const glm::vec4& _value);
+    void setUniformMatrix3f(const UniformLocation& _loc, const glm::mat3& _value);
+    void setUniformMatrix4f(const UniformLocation& _loc, const glm::mat4& _value);
+
+    // Upload values that changed since the last update and bind the buffer to
+    // its binding point. Returns false when _program does not declare the block.
+    bool update(RenderState& rs, ShaderProgram& _program);
+
+private:
+
+    struct Member {
+        std::string name;
+        UniformValue value;
+        GLint offset;
+    };
+
+    template <class T>
+    void set(const UniformLocation& _loc, const T& _value);
+
+    bool loadLayout(GLuint _program);
+
+    void pack();
+
+    std::string m_blockName;
+    GLuint m_binding;
+
+    std::vector<Member> m_members;
+    std::vector<GLubyte> m_data;
+
+    GLuint m_glBuffer = 0;
+
+    bool m_layoutLoaded = false;
+    bool m_dirty = true;
+
+    RenderState* m_rs = nullptr;
+
+};
+
+}
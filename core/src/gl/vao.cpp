@@ -1,25 +1,34 @@
 #include "gl/vao.h"
 #include "gl/glError.h"
+#include "gl/recyclePool.h"
 #include "gl/renderState.h"
 #include "gl/shaderProgram.h"
 #include "gl/vertexLayout.h"
+#include <algorithm>
 #include <unordered_map>
 
 namespace Tangram {
 
 void Vao::initialize(RenderState& rs, ShaderProgram& _program, const VertexOffsets& _vertexOffsets,
-                     VertexLayout& _layout, GLuint _vertexBuffer, GLuint _indexBuffer) {
-
-    m_glVAOs.resize(_vertexOffsets.size());
-
-    GL::genVertexArrays(m_glVAOs.size(), m_glVAOs.data());
+                     VertexLayout& _layout, GLuint _vertexBuffer, GLuint _indexBuffer,
+                     size_t _byteOffset) {
 
     fastmap<std::string, GLuint> locations;
 
     // FIXME (use a bindAttrib instead of getLocation) to make those locations shader independent
+    m_attribMask = 0;
     for (auto& attrib : _layout.getAttribs()) {
         GLint location = _program.getAttribLocation(attrib.name);
         locations[attrib.name] = location;
+        if (location >= 0 && location < 32) { m_attribMask |= 1u << location; }
+    }
+
+    // Reuse VAOs of deleted meshes that enable the same attributes, since
+    // attributes are never disabled here
+    m_glVAOs.resize(_vertexOffsets.size());
+    for (auto& vao : m_glVAOs) {
+        vao = rs.recyclePool().acquireVAO(m_attribMask);
+        if (vao == 0) { GL::genVertexArrays(1, &vao); }
     }
 
     rs.vertexBuffer(_vertexBuffer);
@@ -37,7 +46,7 @@ void Vao::initialize(RenderState& rs, ShaderProgram& _program, const VertexOffse
         }
 
         // Enable vertex layout on the specified locations
-        _layout.enable(locations, vertexOffset * _layout.getStride());
+        _layout.enable(locations, _byteOffset + vertexOffset * _layout.getStride());
 
         vertexOffset += nVerts;
     }
@@ -62,9 +71,51 @@ void Vao::unbind() {
     GL::bindVertexArray(0);
 }
 
+Vao& VaoCache::get(RenderState& rs, ShaderProgram& _program, VertexLayout& _layout,
+                   GLuint _vertexBuffer, GLuint _indexBuffer) {
+
+    GLuint program = _program.getGlProgram();
+    for (auto& entry : m_entries) {
+        if (entry.program == program && entry.layout == &_layout &&
+            entry.vertexBuffer == _vertexBuffer && entry.indexBuffer == _indexBuffer) {
+            return entry.vao;
+        }
+    }
+
+    m_entries.push_back({ program, &_layout, _vertexBuffer, _indexBuffer, Vao() });
+    auto& vao = m_entries.back().vao;
+    vao.initialize(rs, _program, {{ 0, 0 }}, _layout, _vertexBuffer, _indexBuffer);
+    return vao;
+}
+
+void VaoCache::evictBuffer(RenderState& rs, GLuint _buffer) {
+    m_entries.erase(std::remove_if(m_entries.begin(), m_entries.end(), [&](Entry& _entry) {
+        if (_entry.vertexBuffer != _buffer && _entry.indexBuffer != _buffer) { return false; }
+        _entry.vao.dispose(rs);
+        return true;
+    }), m_entries.end());
+}
+
+void VaoCache::evictProgram(RenderState& rs, GLuint _program) {
+    m_entries.erase(std::remove_if(m_entries.begin(), m_entries.end(), [&](Entry& _entry) {
+        if (_entry.program != _program) { return false; }
+        _entry.vao.dispose(rs);
+        return true;
+    }), m_entries.end());
+}
+
+void VaoCache::invalidate() {
+    m_entries.clear();
+}
+
+void VaoCache::clear(RenderState& rs) {
+    for (auto& entry : m_entries) { entry.vao.dispose(rs); }
+    m_entries.clear();
+}
+
 void Vao::dispose(RenderState& rs) {
     if (!m_glVAOs.empty()) {
-        rs.queueVAODeletion(m_glVAOs.size(), m_glVAOs.data());
+        rs.recyclePool().recycleVAOs(m_glVAOs.size(), m_glVAOs.data(), m_attribMask);
         m_glVAOs.clear();
     }
 }
@@ -16,8 +16,10 @@ class Vao {
 
 public:
 
+    // _byteOffset is the start of the vertices in _vertexBuffer
     void initialize(RenderState& rs, ShaderProgram& _program, const VertexOffsets& _vertexOffsets,
-                    VertexLayout& _layout, GLuint _vertexBuffer, GLuint _indexBuffer);
+                    VertexLayout& _layout, GLuint _vertexBuffer, GLuint _indexBuffer,
+                    size_t _byteOffset = 0);
     bool isInitialized();
     void bind(unsigned int _index);
     void unbind();
@@ -25,8 +27,50 @@ public:
 
 private:
     std::vector<GLuint> m_glVAOs;
+    // Attribute locations that the VAOs enable
+    uint32_t m_attribMask = 0;
 
 };
 
+/* VAOs shared by the meshes in the pages of the buffer pools
+ *
+ * Meshes with geometry in the same vertex and index pages that are drawn with
+ * the same program and vertex layout use one VAO, whose attributes point to
+ * the start of the vertex page, and draw with a base vertex. Entries are
+ * disposed before their buffers or programs are deleted. Only used on the GL
+ * thread.
+ */
+class VaoCache {
+
+public:
+
+    // Returns the VAO for these buffers, created on first use
+    Vao& get(RenderState& rs, ShaderProgram& _program, VertexLayout& _layout,
+             GLuint _vertexBuffer, GLuint _indexBuffer);
+
+    // Dispose the VAOs that use _buffer or _program
+    void evictBuffer(RenderState& rs, GLuint _buffer);
+    void evictProgram(RenderState& rs, GLuint _program);
+
+    // Drop the VAOs without deleting them, after GL context loss
+    void invalidate();
+
+    void clear(RenderState& rs);
+
+    size_t size() const { return m_entries.size(); }
+
+private:
+
+    struct Entry {
+        GLuint program;
+        const VertexLayout* layout;
+        GLuint vertexBuffer;
+        GLuint indexBuffer;
+        Vao vao;
+    };
+
+    std::vector<Entry> m_entries;
+};
+
 }
 
@@ -104,4 +104,15 @@ void VertexLayout::enable(RenderState& rs, ShaderProgram& _program, size_t _byte
     }
 }
 
+void VertexLayout::setDivisor(ShaderProgram& _program, GLuint _divisor) {
+
+    for (auto& attrib : m_attribs) {
+        GLint location = _program.getAttribLocation(attrib.name);
+
+        if (location != -1) {
+            GL::vertexAttribDivisor(location, _divisor);
+        }
+    }
+}
+
 }
@@ -31,6 +31,10 @@ public:
 
     void enable(const fastmap<std::string, GLuint>& _locations, size_t _bytOffset);
 
+    // Set how often the attributes advance in instanced draws: 0 for each
+    // vertex, 1 for each instance. Only call this when instancing is supported.
+    void setDivisor(ShaderProgram& _program, GLuint _divisor);
+
     GLint getStride() const { return m_stride; };
 
     const std::vector<VertexAttrib> getAttribs() const { return m_attribs; }
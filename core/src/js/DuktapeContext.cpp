@@ -10,14 +10,77 @@
 #include "duktape/duktape.h"
 #include "glm/vec2.hpp"
 
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+
 namespace Tangram {
 
-const static char INSTANCE_ID[] = "\xff""\xff""obj";
 const static char FUNC_ID[] = "\xff""\xff""fns";
+const static char BATCH_ID[] = "\xff""\xff""batch";
+const static char TARGET_ID[] = "\xff""\xff""target";
+
+// Slots of the feature proxy target
+const static duk_uarridx_t BATCH_INDEX_SLOT = 0;
+const static duk_uarridx_t INSTANCE_SLOT = 1;
+
+// Calls 'fn' for each feature of a batch. 'result' is a buffer of one byte per feature.
+// The index of the current feature is stored in BATCH_INDEX_SLOT of the feature proxy
+// target, which avoids a call into C per feature. The proxy hides it from scene functions.
+const static char BATCH_FUNCTION[] = R"(function(fn, target, result) {
+    for (var i = 0; i < result.length; i++) {
+        target[0] = i;
+        result[i] = fn() ? 1 : 0;
+    }
+})";
+
+// Bytes allocated by the heaps of all contexts
+static std::atomic<size_t> s_heapBytes(0);
+
+// Allocations are prefixed with their size, keeping the alignment of malloc
+static const size_t ALLOC_HEADER = alignof(std::max_align_t);
+
+static void* heapAlloc(void* udata, duk_size_t size) {
+    if (size == 0) { return nullptr; }
+    auto block = static_cast<char*>(std::malloc(size + ALLOC_HEADER));
+    if (!block) { return nullptr; }
+    *reinterpret_cast<size_t*>(block) = size;
+    s_heapBytes += size;
+    return block + ALLOC_HEADER;
+}
+
+static void heapFree(void* udata, void* ptr) {
+    if (!ptr) { return; }
+    auto block = static_cast<char*>(ptr) - ALLOC_HEADER;
+    s_heapBytes -= *reinterpret_cast<size_t*>(block);
+    std::free(block);
+}
+
+static void* heapRealloc(void* udata, void* ptr, duk_size_t size) {
+    if (!ptr) { return heapAlloc(udata, size); }
+    if (size == 0) {
+        heapFree(udata, ptr);
+        return nullptr;
+    }
+    auto block = static_cast<char*>(ptr) - ALLOC_HEADER;
+    size_t oldSize = *reinterpret_cast<size_t*>(block);
+    block = static_cast<char*>(std::realloc(block, size + ALLOC_HEADER));
+    if (!block) { return nullptr; }
+    *reinterpret_cast<size_t*>(block) = size;
+    s_heapBytes += size;
+    s_heapBytes -= oldSize;
+    return block + ALLOC_HEADER;
+}
+
+size_t DuktapeContext::heapBytes() {
+    return s_heapBytes;
+}
 
 DuktapeContext::DuktapeContext() {
-    // Create duktape heap with default allocation functions and custom fatal error handler.
-    _ctx = duk_create_heap(nullptr, nullptr, nullptr, nullptr, fatalErrorHandler);
+    // Create duktape heap with allocation functions that count the heap size and custom
+    // fatal error handler.
+    _ctx = duk_create_heap(heapAlloc, heapRealloc, heapFree, nullptr, fatalErrorHandler);
 
     //// Create global geometry constants
     // TODO make immutable
@@ -35,11 +98,17 @@ DuktapeContext::DuktapeContext() {
     // -> [cons]
     duk_eval_string(_ctx, "Proxy");
 
-    // Add feature object
-    // -> [cons, { __obj: this }]
-    duk_idx_t featureObj = duk_push_object(_ctx);
+    // Add feature object, an array to keep slot access fast
+    // -> [cons, [ 0, this ]]
+    duk_idx_t featureObj = duk_push_array(_ctx);
+    duk_push_uint(_ctx, 0);
+    duk_put_prop_index(_ctx, featureObj, BATCH_INDEX_SLOT);
     duk_push_pointer(_ctx, this);
-    duk_put_prop_string(_ctx, featureObj, INSTANCE_ID);
+    duk_put_prop_index(_ctx, featureObj, INSTANCE_SLOT);
+
+    // Keep the target for batch evaluation
+    duk_dup(_ctx, featureObj);
+    duk_put_global_string(_ctx, TARGET_ID);
 
     // Add handler object
     // -> [cons, {...}, { get: func, has: func }]
@@ -68,6 +137,14 @@ DuktapeContext::DuktapeContext() {
     if (!duk_put_global_string(_ctx, FUNC_ID)) {
         LOGE("'fns' object not set");
     }
+
+    // Set up batch evaluation
+    if (duk_pcompile_string(_ctx, DUK_COMPILE_FUNCTION, BATCH_FUNCTION) == 0) {
+        duk_put_global_string(_ctx, BATCH_ID);
+    } else {
+        LOGE("Failure: %s", duk_safe_to_string(_ctx, -1));
+        duk_pop(_ctx);
+    }
 }
 
 DuktapeContext::~DuktapeContext() {
@@ -110,6 +187,54 @@ bool DuktapeContext::setFunction(JSFunctionIndex index, const std::string& sourc
     return true;
 }
 
+bool DuktapeContext::setFunction(JSFunctionIndex index, const JSFunctionBytecode& bytecode) {
+    if (bytecode.empty()) {
+        return false;
+    }
+
+    if (!duk_get_global_string(_ctx, FUNC_ID)) {
+        LOGE("AddFunction - functions array not initialized");
+        duk_pop(_ctx); // pop [undefined] sitting at stack top
+        return false;
+    }
+
+    // NB: duk_load_function() does not validate the bytecode, it must come
+    // from compileFunction() of the same Duktape build.
+    void* buffer = duk_push_fixed_buffer(_ctx, bytecode.size());
+    std::memcpy(buffer, bytecode.data(), bytecode.size());
+    duk_load_function(_ctx);
+
+    duk_put_prop_index(_ctx, -2, index);
+
+    // Pop the functions array off the stack
+    duk_pop(_ctx);
+
+    return true;
+}
+
+bool DuktapeContext::compileFunction(const std::string& source, JSFunctionBytecode& bytecode) {
+    bytecode.clear();
+
+    if (duk_pcompile_lstring(_ctx, DUK_COMPILE_FUNCTION, source.data(), source.length()) != 0) {
+        LOGW("Compile failed: %s\n%s\n---",
+             duk_safe_to_string(_ctx, -1),
+             source.c_str());
+        duk_pop(_ctx);
+        return false;
+    }
+
+    // [function] -> [buffer]
+    duk_dump_function(_ctx);
+
+    duk_size_t size = 0;
+    auto data = static_cast<const uint8_t*>(duk_get_buffer_data(_ctx, -1, &size));
+    bytecode.assign(data, data + size);
+
+    duk_pop(_ctx);
+
+    return true;
+}
+
 bool DuktapeContext::evaluateBooleanFunction(uint32_t index) {
     if (!evaluateFunction(index)) {
         return false;
@@ -124,6 +249,53 @@ bool DuktapeContext::evaluateBooleanFunction(uint32_t index) {
     return result;
 }
 
+bool DuktapeContext::evaluateBooleanFunctions(JSFunctionIndex index, const Feature* features,
+                                              size_t count, uint8_t* results) {
+    if (count == 0) {
+        return true;
+    }
+
+    // -> [buffer]
+    duk_idx_t resultIdx = duk_get_top(_ctx);
+    duk_push_fixed_buffer(_ctx, count);
+
+    // -> [buffer, batch, fns]
+    duk_get_global_string(_ctx, BATCH_ID);
+    duk_get_global_string(_ctx, FUNC_ID);
+
+    // -> [buffer, batch, fn]
+    if (!duk_get_prop_index(_ctx, -1, index)) {
+        LOGE("EvalFilterFn - function %d not set", index);
+        duk_set_top(_ctx, resultIdx);
+        return false;
+    }
+    duk_remove(_ctx, -2);
+
+    // -> [buffer, batch, fn, target, buffer]
+    duk_get_global_string(_ctx, TARGET_ID);
+    duk_dup(_ctx, resultIdx);
+
+    _batchFeatures = features;
+    _batchCount = count;
+
+    // The whole batch is evaluated by a single call into JS
+    bool success = duk_pcall(_ctx, 3) == 0;
+    if (success) {
+        duk_size_t size = 0;
+        auto data = static_cast<const uint8_t*>(duk_get_buffer_data(_ctx, resultIdx, &size));
+        std::memcpy(results, data, size);
+    } else {
+        LOGE("EvalFilterFn: %s", duk_safe_to_string(_ctx, -1));
+    }
+
+    _batchFeatures = nullptr;
+    _batchCount = 0;
+
+    duk_set_top(_ctx, resultIdx);
+
+    return success;
+}
+
 DuktapeValue DuktapeContext::getFunctionResult(uint32_t index) {
     if (!evaluateFunction(index)) {
         return DuktapeValue();
@@ -179,19 +351,40 @@ void DuktapeContext::resetToScopeMarker(JSScopeMarker marker) {
     duk_set_top(_ctx, marker);
 }
 
+const Feature* DuktapeContext::getFeature(duk_context *_ctx, const DuktapeContext* context) {
+    if (!context->_batchFeatures) {
+        return context->_feature;
+    }
+    // Index of the current feature of the batch, from the target object (first parameter).
+    duk_get_prop_index(_ctx, 0, BATCH_INDEX_SLOT);
+    auto index = static_cast<size_t>(duk_get_uint(_ctx, -1));
+    duk_pop(_ctx);
+    return index < context->_batchCount ? &context->_batchFeatures[index] : nullptr;
+}
+
+void DuktapeContext::trackProperty(const char* key) const {
+    if (!_trackedProperties) { return; }
+    for (const auto& tracked : *_trackedProperties) {
+        if (tracked == key) { return; }
+    }
+    _trackedProperties->emplace_back(key);
+}
+
 // Implements Proxy handler.has(target_object, key)
 int DuktapeContext::jsHasProperty(duk_context *_ctx) {
 
-    duk_get_prop_string(_ctx, 0, INSTANCE_ID);
+    duk_get_prop_index(_ctx, 0, INSTANCE_SLOT);
     auto context = static_cast<const DuktapeContext*>(duk_to_pointer(_ctx, -1));
-    if (!context || !context->_feature) {
-        LOGE("Error: no context set %p %p", context, context ? context->_feature : nullptr);
+    auto feature = context ? getFeature(_ctx, context) : nullptr;
+    if (!feature) {
+        LOGE("Error: no context set %p %p", context, feature);
         duk_pop(_ctx);
         return 0;
     }
 
     const char* key = duk_require_string(_ctx, 1);
-    auto result = static_cast<duk_bool_t>(context->_feature->props.contains(key));
+    context->trackProperty(key);
+    auto result = static_cast<duk_bool_t>(feature->props.contains(key));
     duk_push_boolean(_ctx, result);
 
     return 1;
@@ -201,18 +394,20 @@ int DuktapeContext::jsHasProperty(duk_context *_ctx) {
 int DuktapeContext::jsGetProperty(duk_context *_ctx) {
 
     // Get the JavaScriptContext instance from JS Feature object (first parameter).
-    duk_get_prop_string(_ctx, 0, INSTANCE_ID);
+    duk_get_prop_index(_ctx, 0, INSTANCE_SLOT);
     auto context = static_cast<const DuktapeContext*>(duk_to_pointer(_ctx, -1));
-    if (!context || !context->_feature) {
-        LOGE("Error: no context set %p %p",  context, context ? context->_feature : nullptr);
+    auto feature = context ? getFeature(_ctx, context) : nullptr;
+    if (!feature) {
+        LOGE("Error: no context set %p %p",  context, feature);
         duk_pop(_ctx);
         return 0;
     }
 
     // Get the property name (second parameter)
     const char* key = duk_require_string(_ctx, 1);
+    context->trackProperty(key);
 
-    auto it = context->_feature->props.get(key);
+    auto it = feature->props.get(key);
     if (it.is<std::string>()) {
         duk_push_string(_ctx, it.get<std::string>().c_str());
     } else if (it.is<double>()) {
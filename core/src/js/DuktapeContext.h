@@ -8,6 +8,7 @@
 #include "duktape/duktape.h"
 
 #include <string>
+#include <vector>
 
 namespace Tangram {
 
@@ -139,8 +140,26 @@ public:
 
     bool setFunction(JSFunctionIndex index, const std::string& source);
 
+    // Set function 'index' from the result of compileFunction()
+    bool setFunction(JSFunctionIndex index, const JSFunctionBytecode& bytecode);
+
+    // Compile 'source' without adding it to the functions of this context
+    bool compileFunction(const std::string& source, JSFunctionBytecode& bytecode);
+
     bool evaluateBooleanFunction(JSFunctionIndex index);
 
+    // Evaluate the "truthiness" of function 'index' for each of 'count' features,
+    // writing 1 or 0 to 'results'. Returns false when the function failed.
+    bool evaluateBooleanFunctions(JSFunctionIndex index, const Feature* features,
+                                  size_t count, uint8_t* results);
+
+    // Add the keys of the feature properties that functions read or test to
+    // 'keys', each once, until it is set to null.
+    void setPropertyTracking(std::vector<std::string>* keys) { _trackedProperties = keys; }
+
+    // Bytes allocated by the heaps of all contexts
+    static size_t heapBytes();
+
 protected:
     DuktapeValue newNull();
 
@@ -161,6 +180,11 @@ private:
     static int jsGetProperty(duk_context *_ctx);
     static int jsHasProperty(duk_context *_ctx);
 
+    // Returns the current feature, or the current one of a batch
+    static const Feature* getFeature(duk_context *_ctx, const DuktapeContext* context);
+
+    void trackProperty(const char* key) const;
+
     static void fatalErrorHandler(void* userData, const char* message);
 
     bool evaluateFunction(uint32_t index);
@@ -173,6 +197,12 @@ private:
 
     const Feature* _feature = nullptr;
 
+    // Features of evaluateBooleanFunctions()
+    const Feature* _batchFeatures = nullptr;
+    size_t _batchCount = 0;
+
+    std::vector<std::string>* _trackedProperties = nullptr;
+
     friend JavaScriptScope<DuktapeContext>;
 };
 
@@ -74,6 +74,24 @@ bool JSCoreContext::setFunction(JSFunctionIndex index, const std::string& source
     return true;
 }
 
+bool JSCoreContext::setFunction(JSFunctionIndex index, const JSFunctionBytecode& bytecode) {
+    if (bytecode.empty()) {
+        return false;
+    }
+    return setFunction(index, std::string(bytecode.begin(), bytecode.end()));
+}
+
+bool JSCoreContext::compileFunction(const std::string& source, JSFunctionBytecode& bytecode) {
+    // JavaScriptCore has no public API for bytecode, so only check that the
+    // function compiles and keep its source.
+    bytecode.clear();
+    if (!compileFunction(source)) {
+        return false;
+    }
+    bytecode.assign(source.begin(), source.end());
+    return true;
+}
+
 bool JSCoreContext::evaluateBooleanFunction(JSFunctionIndex index) {
     auto resultValue = getFunctionResult(index);
     if (resultValue) {
@@ -82,6 +100,21 @@ bool JSCoreContext::evaluateBooleanFunction(JSFunctionIndex index) {
     return false;
 }
 
+bool JSCoreContext::evaluateBooleanFunctions(JSFunctionIndex index, const Feature* features,
+                                             size_t count, uint8_t* results) {
+    // Calls into JavaScriptCore are cheap compared to Duktape, so this
+    // evaluates the features one at a time.
+    for (size_t i = 0; i < count; i++) {
+        _feature = &features[i];
+        auto resultValue = getFunctionResult(index);
+        if (!resultValue) {
+            return false;
+        }
+        results[i] = resultValue.toBool() ? 1 : 0;
+    }
+    return true;
+}
+
 JSCoreValue JSCoreContext::newNull() {
     JSValueRef jsValue = JSValueMakeNull(_context);
     return JSCoreValue(_context, jsValue);
@@ -164,6 +197,14 @@ JSObjectRef JSCoreContext::compileFunction(const std::string& source) {
     return JSValueToObject(_context, jsFunction, nullptr);
 }
 
+void JSCoreContext::trackProperty(const char* key) {
+    if (!_trackedProperties) { return; }
+    for (const auto& tracked : *_trackedProperties) {
+        if (tracked == key) { return; }
+    }
+    _trackedProperties->emplace_back(key);
+}
+
 bool JSCoreContext::jsHasPropertyCallback(JSContextRef, JSObjectRef object, JSStringRef property) {
     auto jsCoreContext = reinterpret_cast<JSCoreContext*>(JSObjectGetPrivate(object));
     if (!jsCoreContext) {
@@ -175,6 +216,7 @@ bool JSCoreContext::jsHasPropertyCallback(JSContextRef, JSObjectRef object, JSSt
     }
     char nameBuffer[128]; // This should be enough for all the names we use - could make it dynamically-sized if needed.
     JSStringGetUTF8CString(property, nameBuffer, sizeof(nameBuffer));
+    jsCoreContext->trackProperty(nameBuffer);
     return feature->props.contains(nameBuffer);
 }
 
@@ -190,6 +232,7 @@ JSValueRef JSCoreContext::jsGetPropertyCallback(JSContextRef context, JSObjectRe
     JSValueRef jsValue = nullptr;
     char nameBuffer[128]; // This should be enough for all the names we use - could make it dynamically-sized if needed.
     JSStringGetUTF8CString(property, nameBuffer, sizeof(nameBuffer));
+    jsCoreContext->trackProperty(nameBuffer);
     auto it = feature->props.get(nameBuffer);
     if (it.is<std::string>()) {
         jsValue = jsCoreContext->_strings.get(context, it.get<std::string>());
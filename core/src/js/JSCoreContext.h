@@ -203,8 +203,26 @@ public:
 
     bool setFunction(JSFunctionIndex index, const std::string& source);
 
+    // Set function 'index' from the result of compileFunction()
+    bool setFunction(JSFunctionIndex index, const JSFunctionBytecode& bytecode);
+
+    // Compile 'source' without adding it to the functions of this context
+    bool compileFunction(const std::string& source, JSFunctionBytecode& bytecode);
+
     bool evaluateBooleanFunction(JSFunctionIndex index);
 
+    // Evaluate the "truthiness" of function 'index' for each of 'count' features,
+    // writing 1 or 0 to 'results'. Returns false when the function failed.
+    bool evaluateBooleanFunctions(JSFunctionIndex index, const Feature* features,
+                                  size_t count, uint8_t* results);
+
+    // Add the keys of the feature properties that functions read to 'keys',
+    // each once, until it is set to null.
+    void setPropertyTracking(std::vector<std::string>* keys) { _trackedProperties = keys; }
+
+    // JavaScriptCore does not report the size of its heaps
+    static size_t heapBytes() { return 0; }
+
 protected:
 
     JSCoreValue newNull();
@@ -226,6 +244,8 @@ private:
 
     JSObjectRef compileFunction(const std::string& source);
 
+    void trackProperty(const char* key);
+
     std::vector<JSObjectRef> _functions;
 
     JSContextGroupRef _group;
@@ -235,6 +255,8 @@ private:
 
     const Feature* _feature;
 
+    std::vector<std::string>* _trackedProperties = nullptr;
+
     friend JavaScriptScope<JSCoreContext>;
 };
 
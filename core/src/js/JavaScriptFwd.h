@@ -4,6 +4,7 @@
 #pragma once
 
 #include <cstdint>
+#include <vector>
 
 namespace Tangram {
 
@@ -24,6 +25,10 @@ struct Feature;
 using JSScopeMarker = int32_t;
 using JSFunctionIndex = uint32_t;
 
+// Compiled form of a JS function which can be loaded into any JSContext.
+// Duktape stores its bytecode here, JavaScriptCore the function source.
+using JSFunctionBytecode = std::vector<uint8_t>;
+
 template<class Context> class JavaScriptScope;
 
 using JSScope = JavaScriptScope<JSContext>;
@@ -197,22 +197,15 @@ void CurvedLabel::obbs(ScreenTransform& _transform, OBBBuffer& _obbs) {
 }
 
 void CurvedLabel::addVerticesToMesh(ScreenTransform& _transform, const glm::vec2& _screenSize) {
-    if (!visibleState()) { return; }
 
-    TextVertex::State state {
-        m_fontAttrib.selectionColor,
-        m_fontAttrib.fill,
-        m_fontAttrib.stroke,
-        uint16_t(m_alpha * TextVertex::alpha_scale),
-        uint16_t(m_fontAttrib.fontScale),
-    };
+    TextVertex::State state = vertexState();
 
-    auto it = m_textLabels.quads.begin() + m_textRanges[m_textRangeIndex].start;
-    auto end = it + m_textRanges[m_textRangeIndex].length;
-    auto& style = m_textLabels.style;
+    if (patchMeshes(state)) { return; }
 
-    auto& meshes = style.getMeshes();
+    if (!visibleState()) { return; }
 
+    auto it = m_textLabels.quads.begin() + m_textRanges[m_textRangeIndex].start;
+    auto end = it + m_textRanges[m_textRangeIndex].length;
     glm::vec2 rotation;
     LineSampler<ScreenTransform> sampler { _transform };
 
@@ -274,7 +267,7 @@ void CurvedLabel::addVerticesToMesh(ScreenTransform& _transform, const glm::vec2
 
         if (!visible) { continue; }
 
-        auto* quadVertices = meshes[it->atlas]->pushQuad();
+        auto* quadVertices = pushQuad(it->atlas);
 
         for (int i = 0; i < 4; i++) {
             TextVertex& v = quadVertices[i];
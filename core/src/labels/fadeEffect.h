@@ -40,8 +40,23 @@ public:
         m_interpolation = _interpolation;
         m_duration = _duration;
         m_step = 0.f;
+        m_started = false;
     }
 
+    // Scene time when the fade started, derived from the _time at which it is
+    // first asked for, so that it stays the same for the whole fade
+    float startTime(float _time) {
+        if (!m_started) {
+            m_start = _time - m_step;
+            m_started = true;
+        }
+        return m_start;
+    }
+
+    float duration() const { return m_duration; }
+
+    Interpolation interpolation() const { return m_interpolation; }
+
     bool isFinished() {
         return m_step > m_duration;
     }
@@ -52,6 +67,8 @@ private:
     float m_duration = 0.0f;
     float m_step = 0.0f;
     bool m_in = false;
+    float m_start = 0.0f;
+    bool m_started = false;
 };
 
 }
@@ -10,6 +10,7 @@
 namespace Tangram {
 
 const float Label::activation_distance_threshold = 2;
+constexpr int Label::tile_zoom_steps;
 
 Label::Label(glm::vec2 _size, Type _type, Options _options)
     : m_type(_type),
@@ -78,6 +79,14 @@ void Label::setAlpha(float _alpha) {
     m_alpha = clamp01(_alpha);
 }
 
+glm::vec2 Label::fade(float _time) {
+    if (m_state != State::fading_in && m_state != State::fading_out) {
+        return { m_alpha, 0.f };
+    }
+    float duration = m_fade.duration();
+    return { m_fade.startTime(_time), m_state == State::fading_in ? duration : -duration };
+}
+
 void Label::resetState() {
 
     if (m_state == State::dead) { return; }
@@ -69,10 +69,15 @@ public:
         bool flat = false;
         float angle = 0.f;
         uint32_t featureId = 0;
+        // ID of the tile data feature, identifies its labels in buffered and adjacent tiles
+        uint64_t sourceId = 0;
     };
 
     static const float activation_distance_threshold;
 
+    // Number of fractional zoom steps at which LabelCollider resolves the collisions within a tile
+    static constexpr int tile_zoom_steps = 4;
+
     Label(glm::vec2 _size, Type _type, Options _options);
 
     virtual ~Label();
@@ -127,6 +132,18 @@ public:
 
     bool occludedLastFrame() const { return m_occludedLastFrame; }
 
+    // Whether labels of the same tile occlude this label when the tile is drawn
+    // at its zoom + _step / tile_zoom_steps. Set by LabelCollider.
+    bool occludedInTile(int _step) const { return m_tileOcclusion & (1 << _step); }
+
+    void setOccludedInTile(int _step, bool _occluded) {
+        if (_occluded) {
+            m_tileOcclusion |= (1 << _step);
+        } else {
+            m_tileOcclusion &= ~(1 << _step);
+        }
+    }
+
     Label* relative() const { return m_relative; }
     bool isChild() const { return bool(m_relative); }
     bool isSibling() const { return bool(m_relative) && bool(m_relative->relative()); }
@@ -156,6 +173,13 @@ public:
 
     void setAlpha(float _alpha);
 
+    // Fade of the label for its vertices, where the shader evaluates it:
+    // the alpha and 0 when the label is not fading, otherwise the scene
+    // time when the fade started and its duration, negative when fading out
+    glm::vec2 fade(float _time);
+
+    FadeEffect::Interpolation fadeInterpolation() const { return m_fade.interpolation(); }
+
 protected:
 
     virtual void applyAnchor(LabelProperty::Anchor _anchor) = 0;
@@ -176,6 +200,9 @@ protected:
     bool m_occludedLastFrame;
     bool m_occluded;
 
+    // Bit per tile_zoom_steps
+    uint8_t m_tileOcclusion = 0;
+
     glm::vec2 m_screenCenter;
     float m_alpha;
 };
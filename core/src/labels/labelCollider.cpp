@@ -80,12 +80,37 @@ void LabelCollider::process(TileID _tileID, float _tileInverseScale, float _tile
                   return l1->hash() < l2->hash();
               });
 
+    m_candidates = m_labels;
+
+    // Collisions within the tile at fractional zoom steps, applied by LabelManager
+    // to labels of this tile while the view is within the zoom of the tile
+    for (int step = 0; step < Label::tile_zoom_steps; step++) {
+        m_labels = m_candidates;
+        for (auto& entry : m_labels) { entry.label->occlude(false); }
+
+        collide(_tileID, float(step) / Label::tile_zoom_steps, _tileSize, false);
+
+        for (auto& entry : m_candidates) {
+            entry.label->setOccludedInTile(step, entry.label->isOccluded());
+        }
+    }
+
     // Set view parameters so that the tile is rendererd at
     // style-zoom-level + 2. (scaled up by factor 4). This
     // filters out labels that are unlikely to become visible
     // within the tiles zoom-range.
-    int overzoom = 2;
-    float tileScale = pow(2, _tileID.s - _tileID.z + overzoom);
+    m_labels = m_candidates;
+    for (auto& entry : m_labels) { entry.label->occlude(false); }
+
+    collide(_tileID, 2.f, _tileSize, true);
+
+    m_candidates.clear();
+    m_labels.clear();
+}
+
+void LabelCollider::collide(TileID _tileID, float _overzoom, float _tileSize, bool _final) {
+
+    float tileScale = pow(2, _tileID.s - _tileID.z + _overzoom);
     glm::vec2 screenSize{ _tileSize * tileScale };
 
     // Project tile to NDC (-1 to 1, y-up)
@@ -100,7 +125,7 @@ void LabelCollider::process(TileID _tileID, float _tileInverseScale, float _tile
         false, // changedOnLastUpdate (unused)
         glm::dvec2{}, // center (unused)
         0.f, // zoom (unused)
-        powf(2.f, _tileID.s + overzoom), // zoomScale
+        powf(2.f, _tileID.s + _overzoom), // zoomScale
         0.f, // fractZoom
         screenSize, // viewPortSize
         _tileSize, // screenTileSize
@@ -108,6 +133,7 @@ void LabelCollider::process(TileID _tileID, float _tileInverseScale, float _tile
 
     m_obbs.clear();
     m_transforms.clear();
+    m_aabbs.clear();
 
     for (auto it = m_labels.begin(); it != m_labels.end(); ) {
         auto& entry = *it;
@@ -127,12 +153,19 @@ void LabelCollider::process(TileID _tileID, float _tileInverseScale, float _tile
             m_aabbs.push_back(aabb);
             it++;
         } else {
+            // Not placeable at this zoom step
+            if (!_final) { label->occlude(); }
             it = m_labels.erase(it);
         }
     }
 
     if (m_labels.empty()) { return; }
 
+    m_obbBatch.clear();
+    for (size_t i = 0; i < m_obbs.size(); i++) {
+        m_obbBatch.set(i, m_obbs[i]);
+    }
+
     // Limit isect2d splits to a maximum of 64 in each dimension to keep allocations reasonable.
     glm::vec2 split{ min(screenSize.x / 128.f, 64.f), min(screenSize.y / 128.f, 64.f) };
 
@@ -152,9 +185,9 @@ void LabelCollider::process(TileID _tileID, float _tileInverseScale, float _tile
             std::swap(pair.first, pair.second);
 
             // Note: Mark the label to be potentially occluded
-            l2->enterState(Label::State::sleep, 0.0f);
+            if (_final) { l2->enterState(Label::State::sleep, 0.0f); }
         } else {
-            l1->enterState(Label::State::sleep, 0.0f);
+            if (_final) { l1->enterState(Label::State::sleep, 0.0f); }
         }
     }
 
@@ -237,17 +270,9 @@ void LabelCollider::process(TileID _tileID, float _tileInverseScale, float _tile
         }
 
         bool intersection = false;
-        for (int i = e1.obbs.start; i < e1.obbs.end(); i++) {
-            for (int j = e2.obbs.start; j < e2.obbs.end(); j++) {
-
-                if (intersect(m_obbs[i], m_obbs[j])) {
-                    intersection = true;
-
-                    // break out of outer loop
-                    i = e1.obbs.end();
-                    break;
-                }
-            }
+        for (int i = e1.obbs.start; i < e1.obbs.end() && !intersection; i++) {
+            intersection = m_obbBatch.intersectsAny(OBBBatch::query(m_obbs[i]),
+                                                    e2.obbs.start, e2.obbs.end());
         }
         if (!intersection) { continue; }
 
@@ -288,19 +313,18 @@ void LabelCollider::process(TileID _tileID, float _tileInverseScale, float _tile
                 label->occlude();
             } else if (!label->options().optional && label->isOccluded()) {
                 label->relative()->occlude();
-                label->relative()->enterState(Label::State::dead, 0.0f);
+                if (_final) { label->relative()->enterState(Label::State::dead, 0.0f); }
             }
         }
 
+        if (!_final) { continue; }
+
         if (label->isOccluded()) {
             label->enterState(Label::State::dead, 0.0f);
         } else {
             label->enterState(Label::State::none, 0.0f);
         }
     }
-
-    m_labels.clear();
-    m_aabbs.clear();
 }
 
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "labels/label.h"
+#include "labels/obbBatch.h"
 #include "labels/screenTransform.h"
 #include "util/mapProjection.h"
 #include "util/types.h"
@@ -28,6 +29,10 @@ private:
 
     size_t filterRepeatGroups(size_t startPos, size_t curPos);
 
+    // Resolve collisions of m_labels with the tile drawn at its zoom + _overzoom.
+    // Only the final pass sets the label states.
+    void collide(TileID _tileID, float _overzoom, float _tileSize, bool _final);
+
     using AABB = isect2d::AABB<glm::vec2>;
     using OBB = isect2d::OBB<glm::vec2>;
     using CollisionPairs = std::vector<isect2d::ISect2D<glm::vec2>::Pair>;
@@ -49,8 +54,12 @@ private:
     // Parallel vectors
 
     std::vector<LabelEntry> m_labels;
+
+    // All labels in priority order, m_labels is reset to these for each pass
+    std::vector<LabelEntry> m_candidates;
     std::vector<AABB> m_aabbs;
     std::vector<OBB> m_obbs;
+    OBBBatch m_obbBatch;
 
     isect2d::ISect2D<glm::vec2> m_isect2d;
 
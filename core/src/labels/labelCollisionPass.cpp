@@ -0,0 +1,200 @@
+#include "labels/labelCollisionPass.h"
+
+#include "gl/hardware.h"
+#include "gl/renderState.h"
+#include "gl/shaderProgram.h"
+#include "log.h"
+
+#include "labelCollision_cs.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+namespace Tangram {
+
+constexpr float LabelCollisionPass::cell_size;
+constexpr uint32_t LabelCollisionPass::cell_capacity;
+constexpr uint32_t LabelCollisionPass::max_pairs;
+
+// Invocations per work group, see labelCollision.cs
+static const uint32_t group_size = 64;
+
+// Pair count and overflow flag before the pairs
+static const size_t pairs_header = 2;
+
+void CollisionCandidates::clear() {
+    offsets.clear();
+    indices.clear();
+}
+
+void CollisionCandidates::set(size_t _boxCount, const uint32_t* _pairs, size_t _pairCount) {
+    // Counting sort of the pairs by their first box
+    offsets.assign(_boxCount + 1, 0);
+    for (size_t p = 0; p < _pairCount; p++) {
+        offsets[_pairs[2 * p] + 1]++;
+    }
+    for (size_t i = 0; i < _boxCount; i++) {
+        offsets[i + 1] += offsets[i];
+    }
+
+    indices.resize(_pairCount);
+    std::vector<uint32_t> next(offsets.begin(), offsets.end() - 1);
+    for (size_t p = 0; p < _pairCount; p++) {
+        indices[next[_pairs[2 * p]]++] = _pairs[2 * p + 1];
+    }
+}
+
+LabelCollisionPass::LabelCollisionPass(RenderState& _rs) : m_rs(_rs) {}
+
+LabelCollisionPass::~LabelCollisionPass() {
+    // Handles of a lost context are gone with it
+    if (m_rsGeneration != m_rs.handleGeneration()) { return; }
+
+    if (m_program) {
+        m_rs.queueProgramDeletion(m_program);
+    }
+    if (m_buffers[0]) {
+        m_rs.queueBufferDeletion(3, m_buffers);
+    }
+}
+
+bool LabelCollisionPass::isSupported() {
+    return Hardware::supportsComputeShaders;
+}
+
+bool LabelCollisionPass::build() {
+
+    std::string source = Hardware::isGLES ? "#version 310 es\n" : "#version 430\n";
+    source += "#define CELL_CAPACITY " + std::to_string(cell_capacity) + "\n";
+    source += "#define MAX_PAIRS " + std::to_string(max_pairs) + "\n";
+    source += labelCollision_cs;
+
+    GLuint shader = GL::createShader(GL_COMPUTE_SHADER);
+    const GLchar* src = source.c_str();
+    GL::shaderSource(shader, 1, &src, nullptr);
+    GL::compileShader(shader);
+
+    GLint isCompiled = GL_FALSE;
+    GL::getShaderiv(shader, GL_COMPILE_STATUS, &isCompiled);
+    if (isCompiled == GL_FALSE) {
+        GLint infoLength = 0;
+        GL::getShaderiv(shader, GL_INFO_LOG_LENGTH, &infoLength);
+        if (infoLength > 1) {
+            std::vector<GLchar> infoLog(infoLength);
+            GL::getShaderInfoLog(shader, infoLength, nullptr, &infoLog[0]);
+            LOGE("Label collision shader compilation failed\n%s", &infoLog[0]);
+        }
+        GL::deleteShader(shader);
+        return false;
+    }
+
+    GLuint program = GL::createProgram();
+    GL::attachShader(program, shader);
+    GL::linkProgram(program);
+    GL::deleteShader(shader);
+
+    if (!ShaderProgram::checkLinkedProgram(program)) {
+        GL::deleteProgram(program);
+        return false;
+    }
+
+    m_program = program;
+    m_uCount = GL::getUniformLocation(program, "u_count");
+    m_uGrid = GL::getUniformLocation(program, "u_grid");
+    m_uCellSize = GL::getUniformLocation(program, "u_cell_size");
+    m_uPass = GL::getUniformLocation(program, "u_pass");
+
+    GL::genBuffers(3, m_buffers);
+    m_rsGeneration = m_rs.handleGeneration();
+
+    return true;
+}
+
+void LabelCollisionPass::bindStorage(GLuint _index, GLsizeiptr _size, const void* _data) {
+    GL::bindBuffer(GL_SHADER_STORAGE_BUFFER, m_buffers[_index]);
+    GL::bufferData(GL_SHADER_STORAGE_BUFFER, _size, _data, GL_DYNAMIC_DRAW);
+    GL::bindBufferBase(GL_SHADER_STORAGE_BUFFER, _index, m_buffers[_index]);
+}
+
+bool LabelCollisionPass::findCandidates(const std::vector<glm::vec4>& _boxes, glm::vec2 _viewportSize,
+                                        CollisionCandidates& _candidates) {
+
+    _candidates.clear();
+
+    if (_boxes.empty()) { return false; }
+
+    if (m_program && m_rsGeneration != m_rs.handleGeneration()) {
+        m_program = 0;
+        std::fill(std::begin(m_buffers), std::end(m_buffers), 0);
+    }
+
+    if (!m_program) {
+        if (m_buildFailed) { return false; }
+        if (!build()) {
+            LOGW("Label collisions are resolved on the CPU");
+            m_buildFailed = true;
+            return false;
+        }
+    }
+
+    glm::ivec2 grid = { std::max(1.f, std::ceil(_viewportSize.x / cell_size)),
+                        std::max(1.f, std::ceil(_viewportSize.y / cell_size)) };
+    size_t cellCount = size_t(grid.x) * grid.y;
+
+    // Only the cell counts and the pair header have to start at zero
+    m_zeros.assign(std::max(cellCount, pairs_header), 0);
+
+    bindStorage(0, _boxes.size() * sizeof(glm::vec4), _boxes.data());
+    bindStorage(1, cellCount * (1 + cell_capacity) * sizeof(uint32_t), nullptr);
+    GL::bufferSubData(GL_SHADER_STORAGE_BUFFER, 0, cellCount * sizeof(uint32_t), m_zeros.data());
+    bindStorage(2, (pairs_header + 2 * max_pairs) * sizeof(uint32_t), nullptr);
+    GL::bufferSubData(GL_SHADER_STORAGE_BUFFER, 0, pairs_header * sizeof(uint32_t), m_zeros.data());
+
+    m_rs.shaderProgram(m_program);
+    GL::uniform1i(m_uCount, _boxes.size());
+    GL::uniform2i(m_uGrid, grid.x, grid.y);
+    GL::uniform1f(m_uCellSize, cell_size);
+
+    GLuint groups = (_boxes.size() + group_size - 1) / group_size;
+
+    GL::uniform1i(m_uPass, 0);
+    GL::dispatchCompute(groups, 1, 1);
+    GL::memoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    GL::uniform1i(m_uPass, 1);
+    GL::dispatchCompute(groups, 1, 1);
+    GL::memoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    // Waits for the pass: The pairs are needed for the placement of this frame
+    GL::bindBuffer(GL_SHADER_STORAGE_BUFFER, m_buffers[2]);
+    auto* header = static_cast<const uint32_t*>(
+        GL::mapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, pairs_header * sizeof(uint32_t), GL_MAP_READ_BIT));
+    if (!header) { return false; }
+
+    uint32_t pairCount = header[0];
+    bool overflow = header[1] != 0;
+    GL::unmapBuffer(GL_SHADER_STORAGE_BUFFER);
+
+    if (overflow) {
+        LOGD("Label collision pass overflowed with %d boxes", int(_boxes.size()));
+        return false;
+    }
+
+    if (pairCount == 0) {
+        _candidates.set(_boxes.size(), nullptr, 0);
+        return true;
+    }
+
+    auto* pairs = static_cast<const uint32_t*>(
+        GL::mapBufferRange(GL_SHADER_STORAGE_BUFFER, pairs_header * sizeof(uint32_t),
+                           2 * pairCount * sizeof(uint32_t), GL_MAP_READ_BIT));
+    if (!pairs) { return false; }
+
+    _candidates.set(_boxes.size(), pairs, pairCount);
+    GL::unmapBuffer(GL_SHADER_STORAGE_BUFFER);
+
+    return true;
+}
+
+}
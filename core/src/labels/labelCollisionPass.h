@@ -0,0 +1,88 @@
+#pragma once
+
+#include "gl.h"
+
+#include "glm/vec2.hpp"
+#include "glm/vec4.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace Tangram {
+
+class RenderState;
+
+// Boxes whose extents overlap each box, among the boxes before it. The
+// candidates of box i are indices[offsets[i]] to indices[offsets[i + 1] - 1].
+struct CollisionCandidates {
+
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> indices;
+
+    // Number of boxes that have candidates
+    size_t size() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+
+    const uint32_t* begin(size_t _box) const { return indices.data() + offsets[_box]; }
+    const uint32_t* end(size_t _box) const { return indices.data() + offsets[_box + 1]; }
+
+    void clear();
+
+    // Group the _pairCount pairs of a box and an earlier box at _pairs by box
+    void set(size_t _boxCount, const uint32_t* _pairs, size_t _pairCount);
+};
+
+// Compute shader prepass of label occlusion: The extents of the label OBBs are
+// binned into a coarse screen grid on the GPU and the pairs of overlapping
+// extents are read back, so that each OBB is only tested against its own
+// candidates instead of querying the isect2d grid.
+class LabelCollisionPass {
+
+public:
+
+    explicit LabelCollisionPass(RenderState& _rs);
+
+    ~LabelCollisionPass();
+
+    // Whether the driver has compute shaders and shader storage buffers
+    static bool isSupported();
+
+    // Find the candidates of _boxes (min x, min y, max x, max y) in a viewport
+    // of _viewportSize. Returns false when the program could not be built or a
+    // cell or the pair buffer overflowed, these boxes are then resolved on the CPU.
+    bool findCandidates(const std::vector<glm::vec4>& _boxes, glm::vec2 _viewportSize,
+                        CollisionCandidates& _candidates);
+
+    // Size in pixels of the cells of the grid
+    static constexpr float cell_size = 64.f;
+
+    // Boxes per cell and pairs per pass that fit the buffers
+    static constexpr uint32_t cell_capacity = 256;
+    static constexpr uint32_t max_pairs = 1 << 16;
+
+private:
+
+    bool build();
+
+    // Allocate _size bytes of the buffer at storage binding _index, initialized
+    // from _data when it is not null, and bind it
+    void bindStorage(GLuint _index, GLsizeiptr _size, const void* _data);
+
+    RenderState& m_rs;
+
+    GLuint m_program = 0;
+    bool m_buildFailed = false;
+    // Handle generation of m_rs when the program was built
+    uint32_t m_rsGeneration = 0;
+
+    GLint m_uCount = -1;
+    GLint m_uGrid = -1;
+    GLint m_uCellSize = -1;
+    GLint m_uPass = -1;
+
+    // Boxes, cells and pairs
+    GLuint m_buffers[3] = { 0, 0, 0 };
+
+    std::vector<uint32_t> m_zeros;
+};
+
+}
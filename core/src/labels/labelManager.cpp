@@ -1,6 +1,8 @@
 #include "labels/labelManager.h"
 
 #include "data/tileSource.h"
+#include "debug/metrics.h"
+#include "debug/trace.h"
 #include "gl/primitives.h"
 #include "gl/shaderProgram.h"
 #include "labels/curvedLabel.h"
@@ -17,6 +19,8 @@
 #include "tile/tile.h"
 #include "tile/tileCache.h"
 #include "tile/tileManager.h"
+#include "util/asyncWorker.h"
+#include "util/hash.h"
 #include "view/view.h"
 
 #include "glm/glm.hpp"
@@ -24,10 +28,19 @@
 #include "glm/gtx/rotate_vector.hpp"
 #include "glm/gtx/norm.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <unordered_set>
 
 namespace Tangram {
 
+constexpr float LabelManager::occlusion_cell_size;
+constexpr float LabelManager::min_repeat_cell_size;
+constexpr float LabelManager::duplicate_cell_size;
+constexpr size_t LabelManager::collision_pass_min_labels;
+constexpr size_t LabelManager::max_uncovered_obbs;
+
 LabelManager::LabelManager()
     : m_needUpdate(false),
       m_lastZoom(0.0f) {}
@@ -74,6 +87,16 @@ void LabelManager::processLabelUpdate(const ViewState& _viewState, const LabelSe
                 label->addVerticesToMesh(transform, _viewState.viewportSize);
             }
         } else if (label->canOcclude()) {
+            if (_tile && !_isProxy && !m_labelKeys.insert(labelKey(*label)).second) {
+                // The same label from a buffered or adjacent tile: keep it out of the
+                // collision pass and fade it out when it was visible
+                label->occlude();
+                m_needUpdate |= label->evalState(_dt);
+                if (label->visibleState()) {
+                    label->addVerticesToMesh(transform, _viewState.viewportSize);
+                }
+                continue;
+            }
             m_labels.emplace_back(label.get(), _style, _tile, _marker, _isProxy, transformRange);
         } else {
             m_needUpdate |= label->evalState(_dt);
@@ -85,6 +108,19 @@ void LabelManager::processLabelUpdate(const ViewState& _viewState, const LabelSe
     }
 }
 
+uint64_t LabelManager::labelKey(const Label& _label) {
+    // Labels of one feature share its ID, labels of features without one are
+    // told apart by their styling, which includes the text, and their position
+    glm::ivec2 cell = glm::round(_label.screenCenter() / duplicate_cell_size);
+
+    size_t seed = 0;
+    hash_combine(seed, _label.hash());
+    hash_combine(seed, _label.options().sourceId);
+    hash_combine(seed, cell.x);
+    hash_combine(seed, cell.y);
+    return seed;
+}
+
 std::pair<Label*, const Tile*> LabelManager::getLabel(uint32_t _selectionColor) const {
 
     for (auto& entry : m_selectionLabels) {
@@ -104,7 +140,10 @@ void LabelManager::updateLabels(const ViewState& _viewState, float _dt,
                           const std::vector<std::unique_ptr<Marker>>& _markers,
                           bool _onlyRender) {
 
-    if (!_onlyRender) { m_labels.clear(); }
+    if (!_onlyRender) {
+        m_labels.clear();
+        m_labelKeys.clear();
+    }
 
     m_selectionLabels.clear();
 
@@ -318,135 +357,690 @@ bool LabelManager::zOrderComparator(const LabelEntry& _a, const LabelEntry& _b)
     return bool(_a.tile);
 }
 
+// Sort [_begin, _end) by insertion, unless more than _maxMoves moves are needed.
+// The range is then left partially sorted and false is returned.
+template<class It, class Compare>
+static bool insertionSort(It _begin, It _end, Compare _compare, size_t _maxMoves) {
+    size_t moves = 0;
+    for (auto it = _begin + 1; it < _end; ++it) {
+        if (!_compare(*it, *(it - 1))) { continue; }
+
+        auto value = std::move(*it);
+        auto hole = it;
+        do {
+            *hole = std::move(*(hole - 1));
+            --hole;
+            if (++moves > _maxMoves) {
+                *hole = std::move(value);
+                return false;
+            }
+        } while (hole != _begin && _compare(value, *(hole - 1)));
+        *hole = std::move(value);
+    }
+    return true;
+}
+
+void LabelManager::sortLabels(std::unordered_map<const Label*, uint32_t>& _ranks, LabelComparator _compare) {
+
+    // Labels of the last frame in their last order, followed by the new ones
+    m_rankSlots.assign(_ranks.size(), -1);
+    m_newLabels.clear();
+
+    for (size_t i = 0; i < m_labels.size(); i++) {
+        auto it = _ranks.find(m_labels[i].label);
+        if (it != _ranks.end() && m_rankSlots[it->second] < 0) {
+            m_rankSlots[it->second] = int(i);
+        } else {
+            m_newLabels.push_back(i);
+        }
+    }
+
+    m_sortedLabels.clear();
+    for (int slot : m_rankSlots) {
+        if (slot >= 0) { m_sortedLabels.push_back(m_labels[slot]); }
+    }
+    auto kept = m_sortedLabels.size();
+    for (size_t i : m_newLabels) {
+        m_sortedLabels.push_back(m_labels[i]);
+    }
+
+    auto begin = m_sortedLabels.begin();
+    auto middle = begin + kept;
+    auto end = m_sortedLabels.end();
+
+    std::sort(middle, end, _compare);
+
+    // Occlusion and visibility of the last frame are part of the priority order
+    if (!insertionSort(begin, middle, _compare, kept)) {
+        std::sort(begin, middle, _compare);
+    }
+
+    std::inplace_merge(begin, middle, end, _compare);
+
+    m_labels.swap(m_sortedLabels);
+
+    _ranks.clear();
+    for (size_t i = 0; i < m_labels.size(); i++) {
+        _ranks.emplace(m_labels[i].label, uint32_t(i));
+    }
+}
+
 void LabelManager::handleOcclusions(const ViewState& _viewState) {
 
+    Metrics::Timer timer(Metrics::Stage::label_collision);
+    TRACE_SCOPE("LabelManager::handleOcclusions");
+
+    // The occlusion of each label only depends on the screen transforms of the
+    // labels and their order: when neither changed, restore the last result
+    if (!placementInputChanged()) {
+
+        for (auto& last : m_lastOcclusions) {
+            last.label->occlude(last.occluded);
+        }
+        // The OBBs are still needed to draw the labels
+        for (auto& entry : m_labels) {
+            ScreenTransform transform { m_transforms, entry.transformRange };
+            OBBBuffer obbs { m_obbs, entry.obbsRange };
+            entry.label->obbs(transform, obbs);
+        }
+        return;
+    }
+
+    // Keep the grid cells allocated from frame to frame
+    if (m_occlusionGridSize != _viewState.viewportSize) {
+        m_occlusionGridSize = _viewState.viewportSize;
+        m_isect2d.resize({std::max(1.f, std::ceil(m_occlusionGridSize.x / occlusion_cell_size)),
+                          std::max(1.f, std::ceil(m_occlusionGridSize.y / occlusion_cell_size))},
+                         {m_occlusionGridSize.x, m_occlusionGridSize.y});
+    }
+
     m_isect2d.clear();
+    m_obbBatch.clear();
     m_repeatGroups.clear();
+    m_collisionCandidates.clear();
+    m_uncoveredObbs.clear();
 
-    using iterator = decltype(m_labels)::const_iterator;
+    // When the view was only translated since the last placement, labels that
+    // stayed visible and within the viewport keep their placement
+    bool incremental = !m_lastOcclusions.empty() &&
+        (_viewState.translatedOnLastUpdate || !_viewState.changedOnLastUpdate);
 
-    // Find the label to which the obb belongs
-    auto findLabel = [](iterator begin, iterator end, int obb) {
-        for (auto it = begin; it != end; it++) {
-            if (obb >= it->obbsRange.start && obb < it->obbsRange.end()) {
-                return it->label;
-            }
+    // Whether the OBBs of all labels are computed before placing them
+    bool obbsComputed = incremental;
+
+    if (!incremental && m_collisionPass && m_labels.size() >= collision_pass_min_labels) {
+        findCollisionCandidates(_viewState);
+        obbsComputed = true;
+    }
+
+    if (incremental) {
+        for (auto& entry : m_labels) {
+            ScreenTransform transform { m_transforms, entry.transformRange };
+            OBBBuffer obbs { m_obbs, entry.obbsRange };
+            entry.label->obbs(transform, obbs);
         }
-        assert(false);
-        return static_cast<Label*>(nullptr);
-    };
 
-    for (auto it = m_labels.begin(); it != m_labels.end(); ++it) {
-        auto& entry = *it;
-        auto* l = entry.label;
+        markKeptLabels(_viewState);
+
+        for (size_t i = 0; i < m_labels.size(); i++) {
+            if (!m_keptLabels[i]) { continue; }
 
+            m_labels[i].label->occlude(false);
+            insertLabel(m_labels[i]);
+        }
+    }
+
+    for (size_t i = 0; i < m_labels.size(); i++) {
+        auto& entry = m_labels[i];
+
+        if (incremental && m_keptLabels[i]) { continue; }
+
+        if (!obbsComputed) {
+            ScreenTransform transform { m_transforms, entry.transformRange };
+            OBBBuffer obbs { m_obbs, entry.obbsRange };
+            entry.label->obbs(transform, obbs);
+        }
+
+        placeLabel(entry, _viewState);
+    }
+
+    // Relatives may have been occluded after their own entry was processed
+    savePlacementInput();
+}
+
+void LabelManager::findCollisionCandidates(const ViewState& _viewState) {
+
+    for (auto& entry : m_labels) {
         ScreenTransform transform { m_transforms, entry.transformRange };
         OBBBuffer obbs { m_obbs, entry.obbsRange };
+        entry.label->obbs(transform, obbs);
+    }
 
-        l->obbs(transform, obbs);
+    m_obbExtents.clear();
+    for (auto& obb : m_obbs) {
+        auto aabb = obb.getExtent();
+        m_obbExtents.push_back({ aabb.min.x, aabb.min.y, aabb.max.x, aabb.max.y });
+    }
 
-        // Parent must have been processed earlier so at this point its
-        // occlusion and anchor position is determined for the current frame.
-        if (l->isChild()) {
-            if (l->relative()->isOccluded()) {
-                l->occlude();
-                continue;
+    if (!m_collisionPass->findCandidates(m_obbExtents, _viewState.viewportSize, m_collisionCandidates)) {
+        m_collisionCandidates.clear();
+        return;
+    }
+
+    // Candidates are only tested once their label is inserted
+    m_obbLabels.assign(m_obbs.size(), nullptr);
+}
+
+void LabelManager::markKeptLabels(const ViewState& _viewState) {
+
+    std::unordered_set<const Label*> lastLabels;
+    for (auto& last : m_lastOcclusions) { lastLabels.insert(last.label); }
+
+    // Labels that were visible and are entirely within the viewport. Labels crossing
+    // the viewport edge, new ones and proxy labels are placed again.
+    std::unordered_set<const Label*> visible;
+
+    for (auto& entry : m_labels) {
+        auto* l = entry.label;
+        if (entry.proxy || l->occludedLastFrame() || !lastLabels.count(l)) { continue; }
+
+        bool inside = true;
+        for (auto& obb : OBBBuffer{ m_obbs, entry.obbsRange }) {
+            auto aabb = obb.getExtent();
+            if (aabb.min.x < 0 || aabb.min.y < 0 ||
+                aabb.max.x > _viewState.viewportSize.x ||
+                aabb.max.y > _viewState.viewportSize.y) {
+                inside = false;
+                break;
             }
         }
+        if (inside) { visible.insert(l); }
+    }
 
-        // Skip label if another label of this repeatGroup is
-        // within repeatDistance.
-        if (l->options().repeatDistance > 0.f) {
-            if (withinRepeatDistance(l)) {
-                l->occlude();
-                // If this label is not marked optional, then mark the relative label as occluded
-                if (l->relative() && !l->options().optional) {
-                    l->relative()->occlude();
-                }
-                continue;
+    // The placement of a label depends on its relative
+    m_keptLabels.assign(m_labels.size(), false);
+    for (size_t i = 0; i < m_labels.size(); i++) {
+        auto* l = m_labels[i].label;
+        m_keptLabels[i] = visible.count(l) && (!l->relative() || visible.count(l->relative()));
+    }
+}
+
+bool LabelManager::occludedInTile(const LabelEntry& _entry, const ViewState& _viewState) {
+
+    // LabelCollider resolved the collisions of the tile unrotated, untilted and
+    // with the first anchor
+    if (!_entry.tile || _entry.proxy || _viewState.rotation != 0.f || _viewState.pitch != 0.f ||
+        _entry.label->options().anchors.count > 1) {
+        return false;
+    }
+
+    float fract = _viewState.zoom - _entry.tile->getID().s;
+    if (fract < 0.f) { return false; }
+
+    // Use the next step up: labels that collide at a zoom also collide at lower zooms
+    int step = int(std::ceil(fract * Label::tile_zoom_steps));
+    if (step >= Label::tile_zoom_steps) { return false; }
+
+    return _entry.label->occludedInTile(step);
+}
+
+void LabelManager::placeLabel(LabelEntry& _entry, const ViewState& _viewState) {
+    auto* l = _entry.label;
+
+    // Parent must have been processed earlier so at this point its
+    // occlusion and anchor position is determined for the current frame.
+    if (l->isChild()) {
+        if (l->relative()->isOccluded()) {
+            l->occlude();
+            return;
+        }
+    }
+
+    // Collisions with labels of the same tile are known from the tile build
+    if (occludedInTile(_entry, _viewState)) {
+        l->occlude();
+        if (l->relative() && !l->options().optional) {
+            l->relative()->occlude();
+        }
+        return;
+    }
+
+    // Skip label if another label of this repeatGroup is
+    // within repeatDistance.
+    if (l->options().repeatDistance > 0.f) {
+        if (withinRepeatDistance(l)) {
+            l->occlude();
+            // If this label is not marked optional, then mark the relative label as occluded
+            if (l->relative() && !l->options().optional) {
+                l->relative()->occlude();
             }
+            return;
         }
+    }
 
-        int anchorIndex = l->anchorIndex();
+    ScreenTransform transform { m_transforms, _entry.transformRange };
 
-        // For each anchor
-        do {
-            if (l->isOccluded()) {
-                // Update OBB for anchor fallback
-                obbs.clear();
+    int anchorIndex = l->anchorIndex();
+
+    // For each anchor
+    do {
+        if (l->isOccluded()) {
+            // Update OBB for anchor fallback. Append them, as the OBBs
+            // of following labels may already be in m_obbs.
+            _entry.obbsRange = Range(m_obbs.size(), 0);
+            OBBBuffer obbs { m_obbs, _entry.obbsRange };
 
-                l->obbs(transform, obbs);
+            l->obbs(transform, obbs);
 
-                if (anchorIndex == l->anchorIndex()) {
-                    // Reached first anchor again
-                    break;
-                }
+            if (anchorIndex == l->anchorIndex()) {
+                // Reached first anchor again
+                break;
             }
+        }
 
-            l->occlude(false);
+        l->occlude(false);
 
-            // Occlude label when its obbs intersect with a previous label.
-            for (auto& obb : obbs) {
+        // Occlude label when its obbs intersect with a previous label.
+        for (auto& obb : OBBBuffer{ m_obbs, _entry.obbsRange }) {
+            size_t obbIndex = &obb - m_obbs.data();
+
+            // Ignore intersection with relative label
+            auto addCandidate = [&](size_t other) {
+                if (!l->relative() || l->relative() != m_obbLabels[other]) {
+                    m_obbCandidates.push_back(other);
+                }
+            };
+
+            m_obbCandidates.clear();
+            if (obbIndex < m_collisionCandidates.size() &&
+                m_uncoveredObbs.size() <= max_uncovered_obbs) {
+                for (auto* it = m_collisionCandidates.begin(obbIndex);
+                     it != m_collisionCandidates.end(obbIndex); ++it) {
+                    if (m_obbLabels[*it]) { addCandidate(*it); }
+                }
+                for (uint32_t other : m_uncoveredObbs) { addCandidate(other); }
+            } else {
                 m_isect2d.intersect(obb.getExtent(), [&](auto& a, auto& b) {
+                        addCandidate(reinterpret_cast<size_t>(b.m_userData));
+                        return true;
+                    }, false);
+            }
+
+            if (m_obbBatch.intersectsAny(OBBBatch::query(obb), m_obbCandidates.data(),
+                                         m_obbCandidates.size())) {
+                l->occlude();
+                break;
+            }
+        }
+    } while (l->isOccluded() && l->nextAnchor());
+
+    // At this point, the label has a relative that is visible,
+    // if it is not an optional label, turn the relative to occluded
+    if (l->isOccluded()) {
+        if (l->relative() && !l->options().optional) {
+            l->relative()->occlude();
+        }
+    } else {
+        insertLabel(_entry);
+    }
+}
+
+void LabelManager::insertLabel(LabelEntry& _entry) {
+    auto* l = _entry.label;
+
+    // Insert into ISect2D grid
+    if (m_obbLabels.size() < m_obbs.size()) {
+        m_obbLabels.resize(m_obbs.size());
+    }
+    int obbPos = _entry.obbsRange.start;
+    for (auto& obb : OBBBuffer{ m_obbs, _entry.obbsRange }) {
+        m_obbLabels[obbPos] = l;
+        m_obbBatch.set(obbPos, obb);
+        if (m_collisionCandidates.size() > 0 && size_t(obbPos) >= m_collisionCandidates.size()) {
+            m_uncoveredObbs.push_back(obbPos);
+        }
+        auto aabb = obb.getExtent();
+        aabb.m_userData = reinterpret_cast<void*>(obbPos++);
+        m_isect2d.insert(aabb);
+    }
+
+    if (l->options().repeatDistance > 0.f) {
+        m_repeatGroups[l->options().repeatGroup].insert(l->screenCenter(), l->options().repeatDistance, l);
+    }
+}
+
+bool LabelManager::placementInputChanged() const {
+    return !(m_lastTransforms.points == m_transforms.points &&
+             m_lastTransforms.path == m_transforms.path &&
+             m_lastOcclusions.size() == m_labels.size() &&
+             std::equal(m_labels.begin(), m_labels.end(), m_lastOcclusions.begin(),
+                        [](auto& entry, auto& last) {
+                            return entry.label == last.label &&
+                                entry.transformRange.start == last.transformStart;
+                        }));
+}
+
+void LabelManager::savePlacementInput() {
+    m_lastTransforms = m_transforms;
+    m_lastOcclusions.clear();
+    for (auto& entry : m_labels) {
+        m_lastOcclusions.push_back({ entry.label, entry.transformRange.start,
+                                     entry.label->isOccluded() });
+    }
+}
+
+void LabelManager::setCollisionPass(std::unique_ptr<LabelCollisionPass> _pass) {
+    m_collisionPass = std::move(_pass);
+}
+
+void LabelManager::setAsyncPlacement(bool _async) {
+    if (_async == bool(m_placementWorker)) { return; }
+
+    if (_async) {
+        m_placementWorker = std::make_unique<AsyncWorker>(ThreadPool::shared(),
+                                                          ThreadPool::Priority::gl);
+    } else {
+        // Waits for a running placement
+        m_placementWorker.reset();
+    }
+
+    std::lock_guard<std::mutex> lock(m_placementMutex);
+    m_placementResult.reset();
+    m_placementRunning = false;
+    m_placementOutdated = false;
+    m_placedLabels.clear();
+    m_lastOcclusions.clear();
+}
+
+bool LabelManager::placementPending() const {
+    if (!m_placementWorker) { return false; }
+
+    std::lock_guard<std::mutex> lock(m_placementMutex);
+    return m_placementRunning || m_placementOutdated || m_placementResult;
+}
+
+void LabelManager::applyPlacement() {
+    {
+        std::lock_guard<std::mutex> lock(m_placementMutex);
+        if (m_placementResult) {
+            m_placedLabels.clear();
+            for (auto& placed : *m_placementResult) {
+                m_placedLabels.emplace(placed.label, placed);
+            }
+            m_placementResult.reset();
+        }
+    }
+
+    for (auto& entry : m_labels) {
+        auto* l = entry.label;
+
+        // Labels that were not part of the last placement wait for the next one.
+        // The pointers of the result are only compared, labels may be gone by now.
+        auto it = m_placedLabels.find(l);
+        if (it == m_placedLabels.end() || it->second.hash != l->hash()) {
+            l->occlude();
+        } else {
+            if (it->second.anchorIndex != l->anchorIndex()) {
+                l->setAnchorIndex(it->second.anchorIndex);
+            }
+            l->occlude(it->second.occluded);
+        }
+
+        ScreenTransform transform { m_transforms, entry.transformRange };
+        OBBBuffer obbs { m_obbs, entry.obbsRange };
+        l->obbs(transform, obbs);
+    }
+}
+
+void LabelManager::schedulePlacement(const ViewState& _viewState) {
+
+    bool changed = placementInputChanged();
+    {
+        std::lock_guard<std::mutex> lock(m_placementMutex);
+        if (!changed && !m_placementOutdated) { return; }
+
+        if (m_placementRunning) {
+            // Placed when the running one is done
+            m_placementOutdated = true;
+            return;
+        }
+        m_placementRunning = true;
+        m_placementOutdated = false;
+    }
+    savePlacementInput();
+
+    // Labels are only touched on the GL thread: capture the OBBs of every anchor
+    auto input = std::make_shared<PlacementInput>();
+    input->viewportSize = _viewState.viewportSize;
+
+    std::unordered_map<const Label*, int> indices;
+    for (size_t i = 0; i < m_labels.size(); i++) {
+        indices.emplace(m_labels[i].label, int(i));
+    }
+
+    for (auto& entry : m_labels) {
+        auto* l = entry.label;
+
+        PlacementLabel p;
+        p.label = l;
+        p.hash = l->hash();
+        p.screenCenter = l->screenCenter();
+        p.repeatGroup = l->options().repeatGroup;
+        p.repeatDistance = l->options().repeatDistance;
+        p.relative = -1;
+        p.hasRelative = l->isChild();
+        p.relativeOccluded = false;
+        p.optional = l->options().optional;
+        p.tileOccluded = occludedInTile(entry, _viewState);
+        p.anchorIndex = l->anchorIndex();
+
+        if (p.hasRelative) {
+            auto it = indices.find(l->relative());
+            if (it != indices.end()) {
+                p.relative = it->second;
+            } else {
+                p.relativeOccluded = l->relative()->isOccluded();
+            }
+        }
+
+        ScreenTransform transform { m_transforms, entry.transformRange };
+
+        int anchorCount = std::max(1, int(l->options().anchors.count));
+        p.anchors = Range(input->anchorObbs.size(), anchorCount);
+
+        for (int i = 0; i < anchorCount; i++) {
+            if (i > 0) { l->nextAnchor(); }
+
+            Range range;
+            OBBBuffer obbs { input->obbs, range };
+            l->obbs(transform, obbs);
+            input->anchorObbs.push_back(range);
+        }
+        if (anchorCount > 1) { l->setAnchorIndex(p.anchorIndex); }
+
+        input->labels.push_back(p);
+    }
+
+    m_placementWorker->enqueue([this, input]() {
+        auto result = placeLabels(*input);
+
+        std::lock_guard<std::mutex> lock(m_placementMutex);
+        m_placementResult = std::make_unique<std::vector<PlacedLabel>>(std::move(result));
+        m_placementRunning = false;
+    });
+}
+
+std::vector<LabelManager::PlacedLabel> LabelManager::placeLabels(const PlacementInput& _input) {
+
+    auto& labels = _input.labels;
+    auto& obbs = _input.obbs;
+
+    std::vector<PlacedLabel> result;
+    result.reserve(labels.size());
+    for (auto& p : labels) {
+        result.push_back({ p.label, p.hash, p.anchorIndex, false });
+    }
+
+    if (m_placementGridSize != _input.viewportSize) {
+        m_placementGridSize = _input.viewportSize;
+        m_placementGrid.resize({std::max(1.f, std::ceil(m_placementGridSize.x / occlusion_cell_size)),
+                                std::max(1.f, std::ceil(m_placementGridSize.y / occlusion_cell_size))},
+                               {m_placementGridSize.x, m_placementGridSize.y});
+    }
+    m_placementGrid.clear();
+    m_placementBatch.clear();
+
+    // Label index of each OBB inserted into the grid
+    std::vector<int> obbLabels(obbs.size(), -1);
+
+    // Visible labels of each repeat group
+    std::unordered_map<size_t, RepeatGrid<int>> repeatGroups;
+
+    auto withinRepeatDistance = [&](const PlacementLabel& _label) {
+        auto group = repeatGroups.find(_label.repeatGroup);
+        if (group == repeatGroups.end()) { return false; }
+
+        float threshold2 = _label.repeatDistance * _label.repeatDistance;
+
+        return group->second.any(_label.screenCenter, _label.repeatDistance, [&](int _other) {
+            return glm::distance2(_label.screenCenter, labels[_other].screenCenter) < threshold2;
+        });
+    };
+
+    for (size_t i = 0; i < labels.size(); i++) {
+        auto& p = labels[i];
+        auto& placed = result[i];
+
+        // Relatives come first in priority order
+        if (p.hasRelative) {
+            bool relativeOccluded = (p.relative >= 0)
+                ? result[p.relative].occluded
+                : p.relativeOccluded;
+
+            if (relativeOccluded) {
+                placed.occluded = true;
+                continue;
+            }
+        }
+
+        if (p.tileOccluded) {
+            placed.occluded = true;
+            if (p.relative >= 0 && !p.optional) {
+                result[p.relative].occluded = true;
+            }
+            continue;
+        }
+
+        if (p.repeatDistance > 0.f && withinRepeatDistance(p)) {
+            placed.occluded = true;
+            if (p.relative >= 0 && !p.optional) {
+                result[p.relative].occluded = true;
+            }
+            continue;
+        }
+
+        // Try the anchors in order, starting with the current one
+        int anchor = -1;
+        for (int n = 0; n < p.anchors.length && anchor < 0; n++) {
+            auto& range = _input.anchorObbs[p.anchors.start + n];
+            bool occluded = false;
+
+            for (int k = range.start; k < range.end() && !occluded; k++) {
+                m_placementCandidates.clear();
+                m_placementGrid.intersect(obbs[k].getExtent(), [&](auto& a, auto& b) {
                         size_t other = reinterpret_cast<size_t>(b.m_userData);
 
-                        if (!intersect(obb, m_obbs[other])) {
-                            return true;
-                        }
                         // Ignore intersection with relative label
-                        if (l->relative() && l->relative() == findLabel(std::begin(m_labels), it, other)) {
-                            return true;
+                        if (p.relative < 0 || obbLabels[other] != p.relative) {
+                            m_placementCandidates.push_back(other);
                         }
-                        l->occlude();
-                        return false;
+                        return true;
 
                     }, false);
 
-                if (l->isOccluded()) { break; }
+                occluded = m_placementBatch.intersectsAny(OBBBatch::query(obbs[k]),
+                                                          m_placementCandidates.data(),
+                                                          m_placementCandidates.size());
             }
-        } while (l->isOccluded() && l->nextAnchor());
+            if (!occluded) { anchor = n; }
+        }
 
-        // At this point, the label has a relative that is visible,
-        // if it is not an optional label, turn the relative to occluded
-        if (l->isOccluded()) {
-            if (l->relative() && !l->options().optional) {
-                l->relative()->occlude();
-            }
-        } else {
-            // Insert into ISect2D grid
-            int obbPos = entry.obbsRange.start;
-            for (auto& obb : obbs) {
-                auto aabb = obb.getExtent();
-                aabb.m_userData = reinterpret_cast<void*>(obbPos++);
-                m_isect2d.insert(aabb);
+        if (anchor < 0) {
+            placed.occluded = true;
+            if (p.relative >= 0 && !p.optional) {
+                result[p.relative].occluded = true;
             }
+            continue;
+        }
 
-            if (l->options().repeatDistance > 0.f) {
-                m_repeatGroups[l->options().repeatGroup].push_back(l);
-            }
+        placed.anchorIndex = (p.anchorIndex + anchor) % p.anchors.length;
+
+        auto& range = _input.anchorObbs[p.anchors.start + anchor];
+        for (int k = range.start; k < range.end(); k++) {
+            obbLabels[k] = i;
+            m_placementBatch.set(k, obbs[k]);
+            auto aabb = obbs[k].getExtent();
+            aabb.m_userData = reinterpret_cast<void*>(k);
+            m_placementGrid.insert(aabb);
+        }
+
+        if (p.repeatDistance > 0.f) {
+            repeatGroups[p.repeatGroup].insert(p.screenCenter, p.repeatDistance, int(i));
         }
     }
+
+    return result;
+}
+
+uint64_t LabelManager::repeatCellKey(glm::ivec2 _cell) {
+    return (uint64_t(uint32_t(_cell.x)) << 32) | uint32_t(_cell.y);
 }
 
 bool LabelManager::withinRepeatDistance(Label *_label) {
-    float threshold2 = pow(_label->options().repeatDistance, 2);
+    float distance = _label->options().repeatDistance;
+    float threshold2 = distance * distance;
 
     auto it = m_repeatGroups.find(_label->options().repeatGroup);
-    if (it != m_repeatGroups.end()) {
-        for (auto* ll : it->second) {
-            float d2 = glm::distance2(_label->screenCenter(), ll->screenCenter());
-            if (d2 < threshold2) {
-                return true;
-            }
+    if (it == m_repeatGroups.end()) { return false; }
+
+    glm::vec2 center = _label->screenCenter();
+
+    return it->second.any(center, distance, [&](const Label* _other) {
+        return glm::distance2(center, _other->screenCenter()) < threshold2;
+    });
+}
+
+void LabelManager::limitLabelDensity(const ViewState& _viewState) {
+
+    size_t maxLabels = size_t(m_maxLabelDensity * _viewState.viewportSize.x *
+                              _viewState.viewportSize.y * 1e-6f);
+    size_t visible = 0;
+
+    // m_labels are in priority order, with relatives before their children
+    for (auto& entry : m_labels) {
+        auto* l = entry.label;
+        if (l->isOccluded()) { continue; }
+
+        if (l->isChild() && l->relative()->isOccluded()) {
+            l->occlude();
+            continue;
+        }
+        if (visible < maxLabels) {
+            visible++;
+            continue;
+        }
+        l->occlude();
+        if (l->relative() && !l->options().optional) {
+            l->relative()->occlude();
         }
     }
-    return false;
 }
 
 void LabelManager::updateLabelSet(const ViewState& _viewState, float _dt, const Scene& _scene,
                             const std::vector<std::shared_ptr<Tile>>& _tiles,
                             const std::vector<std::unique_ptr<Marker>>& _markers,
                             TileManager& _tileManager) {
+    TRACE_SCOPE("LabelManager::updateLabelSet");
 
     m_transforms.clear();
     m_obbs.clear();
@@ -454,7 +1048,7 @@ void LabelManager::updateLabelSet(const ViewState& _viewState, float _dt, const
     /// Collect and update labels from visible tiles
     updateLabels(_viewState, _dt, _scene.styles(), _tiles, _markers, false);
 
-    std::sort(m_labels.begin(), m_labels.end(), LabelManager::priorityComparator);
+    sortLabels(m_priorityRanks, LabelManager::priorityComparator);
 
     /// Mark labels to skip transitions
 
@@ -463,17 +1057,25 @@ void LabelManager::updateLabelSet(const ViewState& _viewState, float _dt, const
         m_lastZoom = _viewState.zoom;
     }
 
-    m_isect2d.resize({_viewState.viewportSize.x / 256, _viewState.viewportSize.y / 256},
-                     {_viewState.viewportSize.x, _viewState.viewportSize.y});
+    if (m_placementWorker) {
+        applyPlacement();
+        schedulePlacement(_viewState);
+        // Keep updating until the placement of the current view is applied
+        m_needUpdate |= placementPending();
+    } else {
+        handleOcclusions(_viewState);
+    }
 
-    handleOcclusions(_viewState);
+    if (m_maxLabelDensity > 0) {
+        limitLabelDensity(_viewState);
+    }
 
     // Update label state
     for (auto& entry : m_labels) {
         m_needUpdate |= entry.label->evalState(_dt);
     }
 
-    std::sort(m_labels.begin(), m_labels.end(), LabelManager::zOrderComparator);
+    sortLabels(m_zOrderRanks, LabelManager::zOrderComparator);
 
     Label::AABB screenBounds{0, 0, _viewState.viewportSize.x, _viewState.viewportSize.y};
 
@@ -2,22 +2,28 @@
 
 #include "data/properties.h"
 #include "labels/label.h"
+#include "labels/labelCollisionPass.h"
+#include "labels/obbBatch.h"
 #include "labels/screenTransform.h"
 #include "labels/spriteLabel.h"
 #include "tile/tileID.h"
 
 #include "glm_vec.h" // for isect2d.h
 #include "isect2d.h"
+#include "glm/common.hpp"
 
+#include <algorithm>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <set>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace Tangram {
 
+class AsyncWorker;
 class FontContext;
 class LabelSet;
 class Marker;
@@ -51,6 +57,28 @@ public:
 
     bool needUpdate() const { return m_needUpdate; }
 
+    /* Place labels on a worker thread. updateLabelSet() then applies the last
+     * completed placement and schedules the next one from a snapshot of the
+     * current frame, so that occlusions lag one placement behind the view.
+     */
+    void setAsyncPlacement(bool _async);
+
+    // True while a placement is running, or its result or newer input was not applied
+    bool placementPending() const;
+
+    /* Test the OBBs of a placement against the candidates found by _pass,
+     * which runs on the GL thread, instead of querying the isect2d grid.
+     * Placements on the worker and incremental placements use the grid.
+     */
+    void setCollisionPass(std::unique_ptr<LabelCollisionPass> _pass);
+
+    bool hasCollisionPass() const { return bool(m_collisionPass); }
+
+    /* Show at most _density labels per million viewport pixels, in priority
+     * order, after their occlusions are resolved. 0 does not limit the labels.
+     */
+    void setMaxLabelDensity(float _density) { m_maxLabelDensity = _density; }
+
     std::pair<Label*, const Tile*> getLabel(uint32_t _selectionColor) const;
 
 protected:
@@ -69,6 +97,123 @@ protected:
 
     bool withinRepeatDistance(Label *_label);
 
+    void limitLabelDensity(const ViewState& _viewState);
+
+    static uint64_t repeatCellKey(glm::ivec2 _cell);
+
+    /* Visible labels of a repeat group by cell of their screen center. The
+     * cells are as large as the repeat distance of the first label of the
+     * group, so a label of the group only visits the 3x3 cells around it */
+    template <class T>
+    struct RepeatGrid {
+        float cellSize = 0;
+        std::unordered_map<uint64_t, std::vector<T>> cells;
+
+        glm::ivec2 cell(glm::vec2 _position) const {
+            return glm::ivec2(glm::floor(_position / cellSize));
+        }
+
+        void insert(glm::vec2 _position, float _distance, T _label) {
+            if (cellSize == 0) { cellSize = std::max(_distance, min_repeat_cell_size); }
+            cells[repeatCellKey(cell(_position))].push_back(_label);
+        }
+
+        // Whether _within returns true for a label in the cells within _distance of _position
+        template <class F>
+        bool any(glm::vec2 _position, float _distance, F _within) const {
+            auto withinAny = [&](const std::vector<T>& _labels) {
+                for (const auto& label : _labels) {
+                    if (_within(label)) { return true; }
+                }
+                return false;
+            };
+
+            glm::ivec2 min = cell(_position - _distance);
+            glm::ivec2 max = cell(_position + _distance);
+
+            // Visit the occupied cells directly when a label of the group has
+            // a larger distance than the cells and covers more of them
+            if (size_t(max.x - min.x + 1) * size_t(max.y - min.y + 1) > cells.size()) {
+                for (auto& cell : cells) {
+                    if (withinAny(cell.second)) { return true; }
+                }
+                return false;
+            }
+
+            for (int y = min.y; y <= max.y; y++) {
+                for (int x = min.x; x <= max.x; x++) {
+                    auto it = cells.find(repeatCellKey({x, y}));
+                    if (it != cells.end() && withinAny(it->second)) { return true; }
+                }
+            }
+            return false;
+        }
+    };
+
+    // Size in pixels of the cells of the occlusion grid
+    static constexpr float occlusion_cell_size = 128.f;
+
+    // Labels from which a placement uses the collision pass
+    static constexpr size_t collision_pass_min_labels = 256;
+
+    // Inserted OBBs without candidates, from which OBBs with candidates query the grid again
+    static constexpr size_t max_uncovered_obbs = 32;
+
+    // Smallest size in pixels of the cells of a RepeatGrid
+    static constexpr float min_repeat_cell_size = 16.f;
+
+    // Size in pixels of the cells in which the screen centers of duplicate labels fall
+    static constexpr float duplicate_cell_size = 2.f;
+
+    // Identity of a tile label, shared by its duplicates in buffered and adjacent tiles
+    static uint64_t labelKey(const Label& _label);
+
+    // Label OBBs and options captured on the GL thread for a placement on the worker
+    struct PlacementLabel {
+        // Only compared, the label may be gone when the placement runs
+        const Label* label;
+        size_t hash;
+        glm::vec2 screenCenter;
+        size_t repeatGroup;
+        float repeatDistance;
+        // Index of the relative label, -1 when it is not placed in this frame
+        int relative;
+        bool hasRelative;
+        bool relativeOccluded;
+        bool optional;
+        bool tileOccluded;
+        int anchorIndex;
+        // Ranges in PlacementInput::anchorObbs, starting with the current anchor
+        Range anchors;
+    };
+
+    struct PlacementInput {
+        glm::vec2 viewportSize;
+        std::vector<PlacementLabel> labels;
+        std::vector<Range> anchorObbs;
+        std::vector<OBB> obbs;
+    };
+
+    struct PlacedLabel {
+        const Label* label;
+        size_t hash;
+        int anchorIndex;
+        bool occluded;
+    };
+
+    // Occlusion and anchor fallback of handleOcclusions() on a snapshot. Runs on the worker.
+    std::vector<PlacedLabel> placeLabels(const PlacementInput& _input);
+
+    // Apply the last completed placement to m_labels
+    void applyPlacement();
+
+    // Start a placement of m_labels when the worker is idle and the input changed
+    void schedulePlacement(const ViewState& _viewState);
+
+    // Whether m_transforms and m_labels differ from the last savePlacementInput()
+    bool placementInputChanged() const;
+    void savePlacementInput();
+
     void processLabelUpdate(const ViewState& _viewState, const LabelSet* _labelSet, Style* _style,
                             const Tile* _tile, const Marker *_marker, const glm::mat4& _mvp,
                             float _dt, bool _drawAll, bool _onlyRender, bool _isProxy);
@@ -77,6 +222,25 @@ protected:
 
     isect2d::ISect2D<glm::vec2> m_isect2d;
 
+    // Viewport size m_isect2d was last resized for
+    glm::vec2 m_occlusionGridSize { 0.f };
+
+    // Label of each OBB index inserted into m_isect2d
+    std::vector<Label*> m_obbLabels;
+
+    // OBBs inserted into m_isect2d, for testing the candidates of a grid query at once
+    OBBBatch m_obbBatch;
+    std::vector<uint32_t> m_obbCandidates;
+
+    std::unique_ptr<LabelCollisionPass> m_collisionPass;
+    std::vector<glm::vec4> m_obbExtents;
+
+    // Candidates of the OBBs before m_collisionCandidates.size() in this placement
+    CollisionCandidates m_collisionCandidates;
+
+    // Inserted OBBs after those, from anchor fallbacks
+    std::vector<uint32_t> m_uncoveredObbs;
+
     struct LabelEntry {
 
         LabelEntry(Label* _label, Style* _style, const Tile* _tile, const Marker* _marker,
@@ -104,15 +268,83 @@ protected:
 
     static bool zOrderComparator(const LabelEntry& _a, const LabelEntry& _b);
 
+    using LabelComparator = bool (*)(const LabelEntry&, const LabelEntry&);
+
+    /* Sort m_labels by _compare, starting from the order of the labels in the
+     * last frame, which _ranks holds and which is updated. Most labels keep
+     * their order from frame to frame, so that only the labels of new tiles
+     * and those whose occlusion or visibility changed need to be sorted */
+    void sortLabels(std::unordered_map<const Label*, uint32_t>& _ranks, LabelComparator _compare);
+
+    // Occlusion, repeat distance and anchor fallback of one label against the labels placed before
+    void placeLabel(LabelEntry& _entry, const ViewState& _viewState);
+
+    // Whether LabelCollider found the label occluded within its tile at the current zoom
+    static bool occludedInTile(const LabelEntry& _entry, const ViewState& _viewState);
+
+    // Add the OBBs of a visible label to the grid and its repeat group
+    void insertLabel(LabelEntry& _entry);
+
+    // Compute the OBBs of all labels and their candidates with m_collisionPass
+    void findCollisionCandidates(const ViewState& _viewState);
+
+    // Set m_keptLabels for labels that keep their placement after a translation
+    void markKeptLabels(const ViewState& _viewState);
+
     std::vector<OBB> m_obbs;
     ScreenTransform::Buffer m_transforms;
 
     std::vector<LabelEntry> m_labels;
     std::vector<LabelEntry> m_selectionLabels;
 
-    std::unordered_map<size_t, std::vector<Label*>> m_repeatGroups;
+    // Index of each label of the last frame in the priority order and in the z-order
+    std::unordered_map<const Label*, uint32_t> m_priorityRanks;
+    std::unordered_map<const Label*, uint32_t> m_zOrderRanks;
+
+    // Used by sortLabels()
+    std::vector<LabelEntry> m_sortedLabels;
+    std::vector<int> m_rankSlots;
+    std::vector<size_t> m_newLabels;
+
+    // labelKey() of the tile labels in m_labels
+    std::unordered_set<uint64_t> m_labelKeys;
+
+    // Visible labels of each repeat group
+    std::unordered_map<size_t, RepeatGrid<Label*>> m_repeatGroups;
+
+    // Input and result of the last handleOcclusions()
+    struct LastOcclusion {
+        Label* label;
+        int transformStart;
+        bool occluded;
+    };
+    ScreenTransform::Buffer m_lastTransforms;
+    std::vector<LastOcclusion> m_lastOcclusions;
+
+    // Whether each entry of m_labels keeps its last placement in an incremental handleOcclusions()
+    std::vector<bool> m_keptLabels;
+
+    // Last placement result applied on the GL thread
+    std::unordered_map<const Label*, PlacedLabel> m_placedLabels;
+
+    // Guards the m_placement* state shared with the worker
+    mutable std::mutex m_placementMutex;
+    std::unique_ptr<std::vector<PlacedLabel>> m_placementResult;
+    bool m_placementRunning = false;
+    bool m_placementOutdated = false;
+
+    // Only used by the worker
+    isect2d::ISect2D<glm::vec2> m_placementGrid;
+    OBBBatch m_placementBatch;
+    std::vector<uint32_t> m_placementCandidates;
+    glm::vec2 m_placementGridSize { 0.f };
 
     float m_lastZoom;
+
+    float m_maxLabelDensity = 0;
+
+    // Declared last so that a running placement finishes before the members it uses are destroyed
+    std::unique_ptr<AsyncWorker> m_placementWorker;
 };
 
 }
@@ -0,0 +1,263 @@
+#include "labels/obbBatch.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TANGRAM_OBB_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define TANGRAM_OBB_NEON
+#endif
+
+namespace Tangram {
+
+OBBBatch::Query OBBBatch::query(const OBB& _obb) {
+    Query q;
+
+    const auto& quad = _obb.getQuad();
+    for (int j = 0; j < 4; j++) {
+        q.x[j] = quad[j].x;
+        q.y[j] = quad[j].y;
+    }
+
+    // Two adjacent edges of the rectangle
+    for (int k = 0; k < 2; k++) {
+        q.axisX[k] = quad[k+1].x - quad[k].x;
+        q.axisY[k] = quad[k+1].y - quad[k].y;
+
+        float p = q.x[0] * q.axisX[k] + q.y[0] * q.axisY[k];
+        q.min[k] = q.max[k] = p;
+        for (int j = 1; j < 4; j++) {
+            p = q.x[j] * q.axisX[k] + q.y[j] * q.axisY[k];
+            q.min[k] = std::min(q.min[k], p);
+            q.max[k] = std::max(q.max[k], p);
+        }
+    }
+    return q;
+}
+
+void OBBBatch::set(size_t _index, const OBB& _obb) {
+
+    if (_index >= m_size) {
+        m_size = _index + 1;
+        for (int j = 0; j < 4; j++) {
+            m_x[j].resize(m_size);
+            m_y[j].resize(m_size);
+        }
+        for (int k = 0; k < 2; k++) {
+            m_axisX[k].resize(m_size);
+            m_axisY[k].resize(m_size);
+            m_min[k].resize(m_size);
+            m_max[k].resize(m_size);
+        }
+    }
+
+    Query q = query(_obb);
+    for (int j = 0; j < 4; j++) {
+        m_x[j][_index] = q.x[j];
+        m_y[j][_index] = q.y[j];
+    }
+    for (int k = 0; k < 2; k++) {
+        m_axisX[k][_index] = q.axisX[k];
+        m_axisY[k][_index] = q.axisY[k];
+        m_min[k][_index] = q.min[k];
+        m_max[k][_index] = q.max[k];
+    }
+}
+
+void OBBBatch::clear() {
+    // Keep the capacity, entries are overwritten by set()
+    m_size = 0;
+}
+
+bool OBBBatch::intersects(const Query& _q, size_t _i) const {
+
+    for (int k = 0; k < 2; k++) {
+        // Candidate projected onto the axis of the query
+        float p = m_x[0][_i] * _q.axisX[k] + m_y[0][_i] * _q.axisY[k];
+        float min = p, max = p;
+        for (int j = 1; j < 4; j++) {
+            p = m_x[j][_i] * _q.axisX[k] + m_y[j][_i] * _q.axisY[k];
+            min = std::min(min, p);
+            max = std::max(max, p);
+        }
+        if (max < _q.min[k] || min > _q.max[k]) { return false; }
+
+        // Query projected onto the axis of the candidate
+        p = _q.x[0] * m_axisX[k][_i] + _q.y[0] * m_axisY[k][_i];
+        min = max = p;
+        for (int j = 1; j < 4; j++) {
+            p = _q.x[j] * m_axisX[k][_i] + _q.y[j] * m_axisY[k][_i];
+            min = std::min(min, p);
+            max = std::max(max, p);
+        }
+        if (max < m_min[k][_i] || min > m_max[k][_i]) { return false; }
+    }
+    return true;
+}
+
+#if defined(TANGRAM_OBB_SSE2)
+
+template<class Load>
+bool OBBBatch::intersects4(const Query& _q, Load _load) const {
+
+    __m128 x[4], y[4];
+    for (int j = 0; j < 4; j++) {
+        x[j] = _load(m_x[j]);
+        y[j] = _load(m_y[j]);
+    }
+
+    __m128 separated = _mm_setzero_ps();
+
+    for (int k = 0; k < 2; k++) {
+        // Candidates projected onto the axis of the query
+        __m128 ax = _mm_set1_ps(_q.axisX[k]);
+        __m128 ay = _mm_set1_ps(_q.axisY[k]);
+        __m128 p = _mm_add_ps(_mm_mul_ps(x[0], ax), _mm_mul_ps(y[0], ay));
+        __m128 min = p, max = p;
+        for (int j = 1; j < 4; j++) {
+            p = _mm_add_ps(_mm_mul_ps(x[j], ax), _mm_mul_ps(y[j], ay));
+            min = _mm_min_ps(min, p);
+            max = _mm_max_ps(max, p);
+        }
+        separated = _mm_or_ps(separated, _mm_cmplt_ps(max, _mm_set1_ps(_q.min[k])));
+        separated = _mm_or_ps(separated, _mm_cmpgt_ps(min, _mm_set1_ps(_q.max[k])));
+
+        // Query projected onto the axes of the candidates
+        __m128 bx = _load(m_axisX[k]);
+        __m128 by = _load(m_axisY[k]);
+        p = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(_q.x[0]), bx), _mm_mul_ps(_mm_set1_ps(_q.y[0]), by));
+        min = max = p;
+        for (int j = 1; j < 4; j++) {
+            p = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(_q.x[j]), bx), _mm_mul_ps(_mm_set1_ps(_q.y[j]), by));
+            min = _mm_min_ps(min, p);
+            max = _mm_max_ps(max, p);
+        }
+        separated = _mm_or_ps(separated, _mm_cmplt_ps(max, _load(m_min[k])));
+        separated = _mm_or_ps(separated, _mm_cmpgt_ps(min, _load(m_max[k])));
+    }
+
+    // Any candidate without a separating axis
+    return _mm_movemask_ps(separated) != 0xf;
+}
+
+bool OBBBatch::intersectsAny(const Query& _q, const uint32_t* _indices, size_t _count) const {
+    size_t i = 0;
+    for (; i + 4 <= _count; i += 4) {
+        const uint32_t* c = _indices + i;
+        auto load = [c](const std::vector<float>& v) {
+            return _mm_setr_ps(v[c[0]], v[c[1]], v[c[2]], v[c[3]]);
+        };
+        if (intersects4(_q, load)) { return true; }
+    }
+    for (; i < _count; i++) {
+        if (intersects(_q, _indices[i])) { return true; }
+    }
+    return false;
+}
+
+bool OBBBatch::intersectsAny(const Query& _q, size_t _begin, size_t _end) const {
+    size_t i = _begin;
+    for (; i + 4 <= _end; i += 4) {
+        auto load = [i](const std::vector<float>& v) { return _mm_loadu_ps(&v[i]); };
+        if (intersects4(_q, load)) { return true; }
+    }
+    for (; i < _end; i++) {
+        if (intersects(_q, i)) { return true; }
+    }
+    return false;
+}
+
+#elif defined(TANGRAM_OBB_NEON)
+
+template<class Load>
+bool OBBBatch::intersects4(const Query& _q, Load _load) const {
+
+    float32x4_t x[4], y[4];
+    for (int j = 0; j < 4; j++) {
+        x[j] = _load(m_x[j]);
+        y[j] = _load(m_y[j]);
+    }
+
+    uint32x4_t separated = vdupq_n_u32(0);
+
+    for (int k = 0; k < 2; k++) {
+        // Candidates projected onto the axis of the query
+        float32x4_t ax = vdupq_n_f32(_q.axisX[k]);
+        float32x4_t ay = vdupq_n_f32(_q.axisY[k]);
+        float32x4_t p = vaddq_f32(vmulq_f32(x[0], ax), vmulq_f32(y[0], ay));
+        float32x4_t min = p, max = p;
+        for (int j = 1; j < 4; j++) {
+            p = vaddq_f32(vmulq_f32(x[j], ax), vmulq_f32(y[j], ay));
+            min = vminq_f32(min, p);
+            max = vmaxq_f32(max, p);
+        }
+        separated = vorrq_u32(separated, vcltq_f32(max, vdupq_n_f32(_q.min[k])));
+        separated = vorrq_u32(separated, vcgtq_f32(min, vdupq_n_f32(_q.max[k])));
+
+        // Query projected onto the axes of the candidates
+        float32x4_t bx = _load(m_axisX[k]);
+        float32x4_t by = _load(m_axisY[k]);
+        p = vaddq_f32(vmulq_n_f32(bx, _q.x[0]), vmulq_n_f32(by, _q.y[0]));
+        min = max = p;
+        for (int j = 1; j < 4; j++) {
+            p = vaddq_f32(vmulq_n_f32(bx, _q.x[j]), vmulq_n_f32(by, _q.y[j]));
+            min = vminq_f32(min, p);
+            max = vmaxq_f32(max, p);
+        }
+        separated = vorrq_u32(separated, vcltq_f32(max, _load(m_min[k])));
+        separated = vorrq_u32(separated, vcgtq_f32(min, _load(m_max[k])));
+    }
+
+    // Any candidate without a separating axis
+    return vminvq_u32(separated) == 0;
+}
+
+bool OBBBatch::intersectsAny(const Query& _q, const uint32_t* _indices, size_t _count) const {
+    size_t i = 0;
+    for (; i + 4 <= _count; i += 4) {
+        const uint32_t* c = _indices + i;
+        auto load = [c](const std::vector<float>& v) {
+            float lanes[4] = { v[c[0]], v[c[1]], v[c[2]], v[c[3]] };
+            return vld1q_f32(lanes);
+        };
+        if (intersects4(_q, load)) { return true; }
+    }
+    for (; i < _count; i++) {
+        if (intersects(_q, _indices[i])) { return true; }
+    }
+    return false;
+}
+
+bool OBBBatch::intersectsAny(const Query& _q, size_t _begin, size_t _end) const {
+    size_t i = _begin;
+    for (; i + 4 <= _end; i += 4) {
+        auto load = [i](const std::vector<float>& v) { return vld1q_f32(&v[i]); };
+        if (intersects4(_q, load)) { return true; }
+    }
+    for (; i < _end; i++) {
+        if (intersects(_q, i)) { return true; }
+    }
+    return false;
+}
+
+#else
+
+bool OBBBatch::intersectsAny(const Query& _q, const uint32_t* _indices, size_t _count) const {
+    for (size_t i = 0; i < _count; i++) {
+        if (intersects(_q, _indices[i])) { return true; }
+    }
+    return false;
+}
+
+bool OBBBatch::intersectsAny(const Query& _q, size_t _begin, size_t _end) const {
+    for (size_t i = _begin; i < _end; i++) {
+        if (intersects(_q, i)) { return true; }
+    }
+    return false;
+}
+
+#endif
+
+}
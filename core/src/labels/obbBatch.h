@@ -0,0 +1,64 @@
+#pragma once
+
+#include "glm_vec.h" // for isect2d.h
+#include "obb.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Tangram {
+
+/* Structure-of-arrays copy of OBBs for separating axis tests
+ *
+ * Corners, edge axes and the projections of each OBB onto its own axes are
+ * kept in one array per component, so that one OBB is tested against four
+ * others at a time with SSE2 or NEON. Other targets use the scalar test.
+ */
+class OBBBatch {
+
+public:
+
+    using OBB = isect2d::OBB<glm::vec2>;
+
+    // Separating axis data of the OBB tested against the batch
+    struct Query {
+        float x[4], y[4];
+        float axisX[2], axisY[2];
+        float min[2], max[2];
+    };
+
+    static Query query(const OBB& _obb);
+
+    // Set the OBB at _index, growing the batch when needed
+    void set(size_t _index, const OBB& _obb);
+
+    void clear();
+
+    size_t size() const { return m_size; }
+
+    // Whether _query intersects any OBB at _indices
+    bool intersectsAny(const Query& _query, const uint32_t* _indices, size_t _count) const;
+
+    // Whether _query intersects any OBB in [_begin, _end)
+    bool intersectsAny(const Query& _query, size_t _begin, size_t _end) const;
+
+    bool intersects(const Query& _query, size_t _index) const;
+
+private:
+
+    template<class Load>
+    bool intersects4(const Query& _query, Load _load) const;
+
+    std::vector<float> m_x[4];
+    std::vector<float> m_y[4];
+
+    // Edge directions and the interval of the OBB projected onto them
+    std::vector<float> m_axisX[2];
+    std::vector<float> m_axisY[2];
+    std::vector<float> m_min[2];
+    std::vector<float> m_max[2];
+
+    size_t m_size = 0;
+};
+
+}
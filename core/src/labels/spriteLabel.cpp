@@ -233,11 +233,11 @@ void SpriteLabel::addVerticesToMesh(ScreenTransform& _transform, const glm::vec2
         uint16_t(m_alpha * SpriteVertex::alpha_scale),
     };
 
-    auto* quadVertices = m_labels.m_style.pushQuad(m_texture);
-
     if (m_options.flat) {
         FlatTransform transform(_transform);
 
+        auto* quadVertices = m_labels.m_style.pushQuad(m_texture);
+
         for (int i = 0; i < 4; i++) {
             SpriteVertex& vertex = quadVertices[i];
 
@@ -256,6 +256,20 @@ void SpriteLabel::addVerticesToMesh(ScreenTransform& _transform, const glm::vec2
         pos += m_options.offset * scale;
         pos += m_anchor * scale;
 
+        if (m_labels.m_style.useInstancing()) {
+            // The quad corners are placed by the vertex shader
+            SpriteInstance& instance = *m_labels.m_style.pushInstance(m_texture);
+
+            instance.pos = glm::vec4(pos, 0.f, 1.f);
+            instance.axes = glm::vec4((quad.quad[1].pos - quad.quad[0].pos) * 0.5f * scale,
+                                      (quad.quad[0].pos - quad.quad[2].pos) * 0.5f * scale);
+            instance.uvRect = glm::i16vec4(quad.quad[2].uv, quad.quad[1].uv);
+            instance.state = state;
+            return;
+        }
+
+        auto* quadVertices = m_labels.m_style.pushQuad(m_texture);
+
         for (int i = 0; i < 4; i++) {
             SpriteVertex& vertex = quadVertices[i];
             glm::vec2 coord = pos + quad.quad[i].pos * scale;
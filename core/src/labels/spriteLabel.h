@@ -26,6 +26,16 @@ struct SpriteVertex {
     static const float texture_scale;
 };
 
+// Attributes of one billboard sprite for instanced drawing
+struct SpriteInstance {
+    glm::vec4 pos;
+    // Offsets from pos to the middle of two adjacent edges, in clip space
+    glm::vec4 axes;
+    // Texture coordinates of the bottom-left and top-right corners
+    glm::i16vec4 uvRect;
+    SpriteVertex::State state;
+};
+
 class SpriteLabel : public Label {
 public:
 
@@ -19,7 +19,6 @@ using namespace TextLabelProperty;
 
 const float TextVertex::position_scale = 4.0f;
 const float TextVertex::position_inv_scale = 0.25f;
-const float TextVertex::alpha_scale = 65535.0f;
 
 struct PointTransform {
     ScreenTransform& m_transform;
@@ -192,23 +191,69 @@ void TextLabel::obbs(ScreenTransform& _transform, OBBBuffer& _obbs) {
 
 }
 
-void TextLabel::addVerticesToMesh(ScreenTransform& _transform, const glm::vec2& _screenSize) {
-    if (!visibleState()) { return; }
-
-    TextVertex::State state {
+TextVertex::State TextLabel::vertexState() {
+    return {
         m_fontAttrib.selectionColor,
         m_fontAttrib.fill,
         m_fontAttrib.stroke,
-        uint16_t(m_alpha * TextVertex::alpha_scale),
         uint16_t(m_fontAttrib.fontScale),
+        uint16_t(fadeInterpolation()),
+        visibleState() ? fade(m_textLabels.style.labelTime()) : glm::vec2(0.f),
     };
+}
+
+bool TextLabel::patchMeshes(const TextVertex::State& _state) {
 
-    auto it = m_textLabels.quads.begin() + m_textRanges[m_textRangeIndex].start;
-    auto end = it + m_textRanges[m_textRangeIndex].length;
     auto& style = m_textLabels.style;
 
+    if (m_meshGeneration != style.meshGeneration()) {
+        m_meshGeneration = style.meshGeneration();
+        m_meshRuns.clear();
+        return false;
+    }
+    if (!style.patchMeshes()) { return false; }
+
     auto& meshes = style.getMeshes();
+    for (auto& run : m_meshRuns) {
+        auto& mesh = *meshes[run.mesh];
+        // All glyphs of a label share its fade
+        auto& state = mesh.vertex(run.first).state;
+        if (state.fade == _state.fade && state.ease == _state.ease) { continue; }
+
+        for (uint32_t i = run.first; i < run.first + run.count; i++) {
+            mesh.vertex(i).state.fade = _state.fade;
+            mesh.vertex(i).state.ease = _state.ease;
+        }
+        mesh.markModified(run.first, run.count);
+    }
+    return true;
+}
+
+TextVertex* TextLabel::pushQuad(size_t _atlas) {
+
+    auto& mesh = *m_textLabels.style.getMeshes()[_atlas];
+    uint32_t first = mesh.numberOfVertices();
 
+    size_t n = m_meshRuns.size();
+    if (n > 0 && m_meshRuns[n - 1].mesh == _atlas &&
+        m_meshRuns[n - 1].first + m_meshRuns[n - 1].count == first) {
+        m_meshRuns[n - 1].count += 4;
+    } else {
+        m_meshRuns.push_back({ uint32_t(_atlas), first, 4 });
+    }
+    return mesh.pushQuad();
+}
+
+void TextLabel::addVerticesToMesh(ScreenTransform& _transform, const glm::vec2& _screenSize) {
+
+    TextVertex::State state = vertexState();
+
+    if (patchMeshes(state)) { return; }
+
+    if (!visibleState()) { return; }
+
+    auto it = m_textLabels.quads.begin() + m_textRanges[m_textRangeIndex].start;
+    auto end = it + m_textRanges[m_textRangeIndex].length;
     PointTransform transform(_transform);
 
     glm::vec2 rotation = transform.rotation();
@@ -250,7 +295,7 @@ void TextLabel::addVerticesToMesh(ScreenTransform& _transform, const glm::vec2&
         }
         if (!visible) { continue; }
 
-        auto* quadVertices = meshes[it->atlas]->pushQuad();
+        auto* quadVertices = pushQuad(it->atlas);
 
         for (int i = 0; i < 4; i++) {
             TextVertex& v = quadVertices[i];
@@ -266,6 +311,9 @@ TextLabels::~TextLabels() {
 }
 
 void TextLabels::setQuads(std::vector<GlyphQuad>&& _quads, std::bitset<FontContext::max_textures> _atlasRefs) {
+    // Glyphs of the quads may still be queued for rasterization
+    style.context()->waitForGlyphs(_atlasRefs);
+
     quads = std::move(_quads);
     m_atlasRefs = _atlasRefs;
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "labels/label.h"
+#include "util/smallVector.h"
 
 #include <glm/glm.hpp>
 
@@ -26,13 +27,15 @@ struct TextVertex {
         uint32_t selection;
         uint32_t color;
         uint32_t stroke;
-        uint16_t alpha;
         uint16_t scale;
+        // FadeEffect::Interpolation of the fade
+        uint16_t ease;
+        // Label::fade(), the text shader computes the alpha from it
+        glm::vec2 fade;
     } state;
 
     const static float position_scale;
     const static float position_inv_scale;
-    const static float alpha_scale;
 };
 
 class TextLabel : public Label {
@@ -84,6 +87,18 @@ public:
 
 protected:
 
+    // Returns true when the glyphs of this label are still in the meshes of
+    // the text style and only their fade was rewritten, which only happens
+    // when the state of the label changes. Labels that are no longer visible
+    // hide their glyphs this way.
+    bool patchMeshes(const TextVertex::State& _state);
+
+    // State of the glyph vertices, with the fade of the label at the style time
+    TextVertex::State vertexState();
+
+    // Pushes a glyph quad into the mesh of _atlas
+    TextVertex* pushQuad(size_t _atlas);
+
     const Coordinates m_coordinates;
 
     // Back-pointer to owning container
@@ -99,6 +114,15 @@ protected:
 
     // The text LAbel prefered alignment
     TextLabelProperty::Align m_preferedAlignment;
+
+    // Vertices of the glyph quads in the text style meshes of m_meshGeneration
+    struct MeshRun {
+        uint32_t mesh;
+        uint32_t first;
+        uint32_t count;
+    };
+    SmallVector<MeshRun, 2> m_meshRuns;
+    uint32_t m_meshGeneration = 0;
 };
 
 }
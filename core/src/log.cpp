@@ -0,0 +1,130 @@
+#include "log.h"
+
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Tangram {
+
+std::atomic<uint32_t> logCategories{0};
+
+void setLogCategories(uint32_t _mask) {
+    logCategories = _mask;
+}
+
+namespace {
+
+/* Ring buffer of formatted messages, written by a logging thread */
+class AsyncLog {
+
+public:
+
+    static constexpr size_t MAX_MESSAGES = 256;
+    static constexpr size_t MAX_MESSAGE_SIZE = 256;
+
+    AsyncLog() : m_messages(MAX_MESSAGES * MAX_MESSAGE_SIZE) {
+        m_thread = std::thread([this]{ run(); });
+    }
+
+    ~AsyncLog() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_running = false;
+        }
+        m_condition.notify_all();
+        m_thread.join();
+    }
+
+    void push(const char* _message, size_t _length) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_count == MAX_MESSAGES) {
+            m_dropped++;
+            return;
+        }
+        char* slot = &m_messages[((m_first + m_count) % MAX_MESSAGES) * MAX_MESSAGE_SIZE];
+        memcpy(slot, _message, _length + 1);
+        m_count++;
+        m_condition.notify_all();
+    }
+
+    void flush() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condition.wait(lock, [&]{ return m_count == 0 && !m_writing; });
+    }
+
+private:
+
+    void run() {
+        char message[MAX_MESSAGE_SIZE];
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        while (true) {
+            m_condition.wait(lock, [&]{ return m_count > 0 || !m_running; });
+            if (m_count == 0) { break; }
+
+            memcpy(message, &m_messages[m_first * MAX_MESSAGE_SIZE], MAX_MESSAGE_SIZE);
+            m_first = (m_first + 1) % MAX_MESSAGES;
+            m_count--;
+            size_t dropped = m_dropped;
+            m_dropped = 0;
+            m_writing = true;
+
+            lock.unlock();
+            if (dropped > 0) { logMsg("TANGRAM dropped %d log messages\n", int(dropped)); }
+            logMsg("%s", message);
+            lock.lock();
+
+            m_writing = false;
+            m_condition.notify_all();
+        }
+    }
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::thread m_thread;
+
+    // MAX_MESSAGES slots of MAX_MESSAGE_SIZE chars, the oldest at m_first
+    std::vector<char> m_messages;
+    size_t m_first = 0;
+    size_t m_count = 0;
+    size_t m_dropped = 0;
+
+    bool m_writing = false;
+    bool m_running = true;
+};
+
+constexpr size_t AsyncLog::MAX_MESSAGES;
+constexpr size_t AsyncLog::MAX_MESSAGE_SIZE;
+
+AsyncLog& asyncLog() {
+    static AsyncLog s_log;
+    return s_log;
+}
+
+}
+
+void logAsync(const char* fmt, ...) {
+    char message[AsyncLog::MAX_MESSAGE_SIZE];
+
+    va_list args;
+    va_start(args, fmt);
+    int length = vsnprintf(message, sizeof(message), fmt, args);
+    va_end(args);
+
+    if (length < 0) { return; }
+    if (size_t(length) >= sizeof(message)) {
+        // Keep the line break of truncated messages
+        length = sizeof(message) - 1;
+        message[length - 1] = '\n';
+    }
+    asyncLog().push(message, length);
+}
+
+void flushLog() {
+    asyncLog().flush();
+}
+
+}
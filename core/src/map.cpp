@@ -1,20 +1,30 @@
 #include "map.h"
 
+#include "data/memoryCacheDataSource.h"
+#include "data/offlineRegionDownload.h"
 #include "debug/textDisplay.h"
 #include "debug/frameInfo.h"
+#include "debug/metrics.h"
+#include "debug/trace.h"
 #include "gl.h"
 #include "gl/glError.h"
 #include "gl/framebuffer.h"
+#include "gl/gpuTimer.h"
 #include "gl/hardware.h"
 #include "gl/primitives.h"
 #include "gl/renderState.h"
 #include "gl/shaderProgram.h"
+#include "gl/shaderSource.h"
+#include "gl/startupFrame.h"
+#include "js/JavaScript.h"
 #include "labels/labelManager.h"
 #include "marker/marker.h"
 #include "marker/markerManager.h"
 #include "platform.h"
 #include "scene/scene.h"
+#include "scene/sceneBinary.h"
 #include "scene/sceneLoader.h"
+#include "selection/featureState.h"
 #include "selection/selectionQuery.h"
 #include "style/material.h"
 #include "style/style.h"
@@ -23,14 +33,19 @@
 #include "tile/tileCache.h"
 #include "util/asyncWorker.h"
 #include "util/fastmap.h"
+#include "util/frameBudget.h"
 #include "util/inputHandler.h"
 #include "util/ease.h"
 #include "util/jobQueue.h"
 #include "view/flyTo.h"
 #include "view/view.h"
 
+#include <algorithm>
 #include <bitset>
 #include <cmath>
+#include <deque>
+
+#include <miniz.h>
 
 namespace Tangram {
 
@@ -45,6 +60,12 @@ struct CameraEase {
 
 using CameraAnimator = std::function<uint32_t(float dt)>;
 
+struct SnapshotJob {
+    CameraPosition camera;
+    int width, height;
+    SnapshotCallback callback;
+};
+
 struct ClientTileSource {
     std::shared_ptr<TileSource> tileSource;
     bool added = false;
@@ -63,28 +84,54 @@ public:
     void setPixelScale(float _pixelsPerPoint);
     SceneID loadScene(SceneOptions&& _sceneOptions);
     SceneID loadSceneAsync(SceneOptions&& _sceneOptions);
+    void disposeScene(std::unique_ptr<Scene> _scene);
+    // Returns true when the pending scene replaced the current one
+    bool updatePendingScene(float _dt, const std::vector<const View*>& _views);
     void syncClientTileSources(bool _firstUpdate);
     bool updateCameraEase(float _dt);
+    MemoryUsage getMemoryUsage();
+    void limitMemory(size_t _budget);
+    void updateQualityTier();
+    void renderSnapshot();
+    void resolveSnapshot();
+    void encodeSnapshot(FrameBuffer::PixelRect _pixels, SnapshotCallback _callback);
+    void loadStartupFrame(const SceneOptions& _options);
+    void drawStartupFrame(glm::vec2 _viewport);
+    void storeStartupFrame();
+    StartupFrame::ViewPosition startupFrameView() const;
 
     Platform& platform;
     RenderState renderState;
     JobQueue jobQueue;
     View view;
-    
+
+    // Scene loading blocks while waiting for resources and disposes Scenes, which
+    // waits for their TileWorker jobs. Keep it off the shared ThreadPool.
     std::unique_ptr<AsyncWorker> asyncWorker = std::make_unique<AsyncWorker>();
     InputHandler inputHandler;
 
     std::unique_ptr<Ease> ease;
 
     std::unique_ptr<Scene> scene;
+    // Scene of loadSceneAsync() that replaces the drawn scene once the tiles
+    // in view are loaded, or after maxPendingSceneTime seconds
+    std::unique_ptr<Scene> pendingScene;
+    float pendingSceneTime = 0;
+    static constexpr float maxPendingSceneTime = 3.f;
     
     std::unique_ptr<FrameBuffer> selectionBuffer = std::make_unique<FrameBuffer>(0, 0);
 
     bool cacheGlState = false;
+    // Placement last applied to the GL thread
+    uint32_t glPlacementGeneration = 0;
+    // Whether setupGL() was called before, for a context that may be lost
+    bool glContextCreated = false;
     float pickRadius = .5f;
     bool isAnimating = false;
 
     std::vector<SelectionQuery> selectionQueries;
+    // Queries whose selection pixels are read back asynchronously
+    std::vector<SelectionQuery> pendingSelectionQueries;
 
     SceneReadyCallback onSceneReady = nullptr;
     CameraAnimationCallback cameraAnimationListener = nullptr;
@@ -92,6 +139,51 @@ public:
     std::mutex tileSourceMutex;
 
     std::map<int32_t, ClientTileSource> clientTileSources;
+    // Set when clientTileSources has changes for syncClientTileSources()
+    bool clientTileSourcesChanged = false;
+
+    // Offline region downloads by ID, removed once finished
+    std::map<int32_t, std::shared_ptr<OfflineRegionDownload>> offlineRegions;
+    int32_t lastOfflineRegionId = 0;
+
+    // Limit of setMemoryBudget(), 0 when unlimited
+    size_t memoryBudget = 0;
+    // Seconds since the memory usage was compared to the budget
+    float memoryCheckTime = 0;
+
+    FrameBudget frameBudget;
+
+    // Lowers the quality tier of a scene loaded with QualityTier::automatic
+    QualityMonitor qualityMonitor;
+    bool automaticQuality = false;
+
+    // Last rendered frame, drawn again while nothing changed
+    bool useFrameCache = false;
+    bool frameChanged = true;
+    std::unique_ptr<FrameBuffer> frameCache;
+    // Debug flags of the cached frame
+    unsigned long frameFlags = 0;
+
+    // Queued snapshots, the first is rendered once its view is complete
+    std::deque<SnapshotJob> snapshotJobs;
+    bool snapshotViewSet = false;
+    bool snapshotViewComplete = false;
+    // The pixels of the last snapshot are read back while the next one loads
+    std::unique_ptr<FrameBuffer> snapshotBuffer;
+    SnapshotCallback snapshotCallback;
+
+    // Frame of the last session, drawn while the scene loads
+    std::shared_ptr<StartupFrame> startupFrame;
+    // Whether a frame of a scene was rendered
+    bool sceneRendered = false;
+    // Whether nothing was loading or moving on the last update
+    bool viewComplete = false;
+    // Whether the frame of the settled view was stored
+    bool startupFrameStored = false;
+
+    // Views of addView(), in the order of their tiles in the TileManager
+    std::map<int32_t, View> views;
+    int32_t lastViewId = 0;
 
     // TODO MapOption
     Color background{0xffffffff};
@@ -111,11 +203,13 @@ Map::~Map() {
     // and discard incoming UrlRequest directly.
     //
     // In any case after shutdown Platform may not call back into Map!
+    for (auto& entry : impl->offlineRegions) { entry.second->cancel(); }
     platform->shutdown();
 
     // Impl will be automatically destroyed by unique_ptr, but threads owned by AsyncWorker and
     // Scene need to be destroyed before JobQueue stops.
     impl->asyncWorker.reset();
+    impl->pendingScene.reset();
     impl->scene.reset();
 
     // Make sure other threads are stopped before calling stop()!
@@ -130,6 +224,10 @@ Map::~Map() {
 SceneID Map::loadScene(SceneOptions&& _sceneOptions, bool _async) {
 
     LOGD("skyway sence url = %s",_sceneOptions.url.path().c_str());
+
+    impl->automaticQuality = _sceneOptions.qualityTier == QualityTier::automatic;
+    impl->qualityMonitor.reset();
+
     if (_async) {
         return impl->loadSceneAsync(std::move(_sceneOptions));
     } else {
@@ -139,6 +237,13 @@ SceneID Map::loadScene(SceneOptions&& _sceneOptions, bool _async) {
 
 SceneID Map::Impl::loadScene(SceneOptions&& _sceneOptions) {
 
+    loadStartupFrame(_sceneOptions);
+
+    // The pending scene is disposed after its loading task
+    disposeScene(std::move(pendingScene));
+
+    ThreadPool::setThreadPlacement(_sceneOptions.threadPlacement);
+
     // NB: This also disposes old scene which might be blocking
     scene = std::make_unique<Scene>(platform, std::move(_sceneOptions));
 
@@ -153,28 +258,47 @@ SceneID Map::Impl::loadScene(SceneOptions&& _sceneOptions) {
 
 SceneID Map::Impl::loadSceneAsync(SceneOptions&& _sceneOptions) {
 
-    // Move the previous scene into a shared_ptr so that it can be captured in a std::function
-    // (unique_ptr can't be captured because std::function is copyable).
-    std::shared_ptr<Scene> oldScene = std::move(scene);
+    loadStartupFrame(_sceneOptions);
+
+    // The current scene is drawn until the tiles in view of the next one are loaded,
+    // unless the view moves to the position of the next one
+    bool keepScene = scene->isReady() && !_sceneOptions.useScenePosition;
 
-    oldScene->cancelTasks();
-    
     // Add callback for tile prefetching
     auto prefetchCallback = [&](Scene* _scene) {
         jobQueue.add([&, _scene]() {
             if (_scene == scene.get()) {
                 scene->prefetchTiles(view);
                 background = scene->backgroundColor(view.getIntegerZoom());
+            } else if (_scene == pendingScene.get()) {
+                pendingScene->prefetchTiles(view);
             }});
         platform.requestRender();
     };
-    
-    scene = std::make_unique<Scene>(platform, std::move(_sceneOptions), prefetchCallback);
+
+    ThreadPool::setThreadPlacement(_sceneOptions.threadPlacement);
+
+    auto newScene = std::make_unique<Scene>(platform, std::move(_sceneOptions), prefetchCallback);
+    if (scene->isReady()) {
+        newScene->setPreviousScene(*scene, keepScene);
+    }
+
+    // A scene that did not replace the current one yet is replaced by the new one
+    std::unique_ptr<Scene> oldScene = std::move(pendingScene);
+    std::unique_ptr<Scene> replacedScene;
+    if (keepScene) {
+        pendingScene = std::move(newScene);
+        pendingSceneTime = 0;
+    } else {
+        replacedScene = std::move(scene);
+        scene = std::move(newScene);
+    }
 
     // This async task gets a raw pointer to the new scene and the following task takes ownership of the shared_ptr to
     // the old scene. Tasks in the async queue are executed one at a time in FIFO order, so even if another scene starts
     // to load before this loading task finishes, the current scene won't be freed until after this task finishes.
-    asyncWorker->enqueue([this, newScene = scene.get()]() {
+    Scene* loadingScene = keepScene ? pendingScene.get() : scene.get();
+    asyncWorker->enqueue([this, newScene = loadingScene]() {
         newScene->load();
 
         if (onSceneReady) {
@@ -184,14 +308,73 @@ SceneID Map::Impl::loadSceneAsync(SceneOptions&& _sceneOptions) {
         platform.requestRender();
     });
 
+    disposeScene(std::move(oldScene));
+    disposeScene(std::move(replacedScene));
+
+    return loadingScene->id;
+}
+
+void Map::Impl::disposeScene(std::unique_ptr<Scene> _scene) {
+    if (!_scene) { return; }
+
+    _scene->cancelTasks();
+
+    // Move the scene into a shared_ptr so that it can be captured in a std::function
+    // (unique_ptr can't be captured because std::function is copyable).
+    std::shared_ptr<Scene> oldScene = std::move(_scene);
+
     asyncWorker->enqueue([disposingScene = std::move(oldScene)]() mutable {
         if (disposingScene.use_count() != 1) {
             LOGE("Incorrect use count for old scene pointer: %d. Scene may be leaked!", disposingScene.use_count());
         }
         disposingScene.reset();
     });
+}
 
-    return scene->id;
+bool Map::Impl::updatePendingScene(float _dt, const std::vector<const View*>& _views) {
+
+    if (!pendingScene->completeScene(view)) { return false; }
+
+    for (auto& entry : clientTileSources) {
+        if (!entry.second.remove) {
+            pendingScene->tileManager()->addClientTileSource(entry.second.tileSource);
+        }
+    }
+
+    pendingSceneTime += _dt;
+    auto sceneState = pendingScene->update(view, _dt, false, _views);
+
+    if (sceneState.tilesLoading && pendingSceneTime < maxPendingSceneTime) { return false; }
+
+    // The tiles of the current scene that the new one can draw are moved to it
+    pendingScene->adoptTiles(*scene);
+
+    disposeScene(std::move(scene));
+    scene = std::move(pendingScene);
+    frameChanged = true;
+    platform.requestRender();
+
+    return true;
+}
+
+SceneID Map::updateScene(const std::vector<SceneUpdate>& _sceneUpdates) {
+
+    // The updates also apply to a scene that is loading, which is loaded again
+    if (!impl->pendingScene && impl->scene->applyUpdates(_sceneUpdates)) {
+        if (impl->onSceneReady) {
+            impl->onSceneReady(impl->scene->id, impl->scene->errors());
+        }
+        impl->platform.requestRender();
+        return impl->scene->id;
+    }
+
+    auto& scene = impl->pendingScene ? impl->pendingScene : impl->scene;
+    SceneOptions options = scene->options();
+    // Keep the current view
+    options.useScenePosition = false;
+    options.updates.insert(options.updates.end(), _sceneUpdates.begin(), _sceneUpdates.end());
+
+    return impl->loadSceneAsync(std::move(options));
 }
 
 void Map::setSceneReadyListener(SceneReadyCallback _onSceneReady) {
@@ -219,8 +402,13 @@ void Map::resize(int _newWidth, int _newHeight) {
 MapState Map::update(float _dt) {
 
     FrameInfo::beginUpdate();
+    impl->frameBudget.beginUpdate();
 
-    impl->jobQueue.runJobs();
+    // Jobs beyond the budget of this frame run in the next ones
+    impl->jobQueue.runJobs(impl->frameBudget.jobTime());
+    if (impl->jobQueue.hasPendingJobs()) {
+        platform->requestRender();
+    }
     
     bool isEasing = impl->updateCameraEase(_dt);
     bool isFlinging = impl->inputHandler.update(_dt);
@@ -236,15 +424,41 @@ MapState Map::update(float _dt) {
 
     if (!scene.completeScene(impl->view)) {
         state |= MapState::scene_loading;
+        impl->frameChanged = true;
 
     } else {
+        // Move the view to the next queued snapshot
+        if (!impl->snapshotJobs.empty() && !impl->snapshotViewSet) {
+            auto& job = impl->snapshotJobs.front();
+            impl->view.setSize(job.width, job.height);
+            setCameraPosition(job.camera);
+            impl->snapshotViewSet = true;
+        }
+
         impl->view.update();
 
         // Sync ClientTileSource changes with TileManager
         bool firstUpdate = !wasReady;
         impl->syncClientTileSources(firstUpdate);
 
-        auto sceneState = scene.update(impl->view, _dt);
+        auto& frameBudget = impl->frameBudget;
+        scene.tileManager()->setCompletionLimit(frameBudget.tileCompletions());
+
+        std::vector<const View*> views;
+        for (auto& entry : impl->views) {
+            entry.second.setPixelScale(impl->view.pixelScale());
+            entry.second.update();
+            views.push_back(&entry.second);
+        }
+
+        auto sceneState = scene.update(impl->view, _dt, frameBudget.placeLabels(), views);
+
+        if (firstUpdate || impl->view.changedOnLastUpdate() ||
+            scene.tileManager()->hasTileSetChanged() ||
+            sceneState.animateLabels || sceneState.animateMarkers) {
+            impl->frameChanged = true;
+            impl->startupFrameStored = false;
+        }
 
         if (sceneState.animateLabels || sceneState.animateMarkers) {
             state |= MapState::labels_changing;
@@ -253,24 +467,72 @@ MapState Map::update(float _dt) {
         if (sceneState.tilesLoading) {
             state |= MapState::tiles_loading;
         }
+        if (scene.tileManager()->hasDeferredTiles()) {
+            state |= MapState::tiles_loading;
+            platform->requestRender();
+        }
+
+        // The next scene loads the tiles in view while this one is drawn, until
+        // it replaces this one
+        if (impl->pendingScene && !impl->updatePendingScene(_dt, views)) {
+            state |= MapState::scene_loading;
+        }
+        if (impl->pendingScene && impl->pendingScene->isReady()) {
+            platform->requestRender();
+        }
+
+        // Accounting walks all tiles and sources, so check the budget once per second,
+        // or whenever the tiles in view changed for a lowMemory scene
+        if (impl->memoryBudget > 0) {
+            impl->memoryCheckTime += _dt;
+            if (impl->memoryCheckTime >= 1.f ||
+                (scene.options().lowMemory && scene.tileManager()->hasTileSetChanged())) {
+                impl->memoryCheckTime = 0;
+                impl->limitMemory(impl->memoryBudget);
+            }
+        }
+    }
+
+    impl->snapshotViewComplete = impl->snapshotViewSet && state == 0;
+    impl->viewComplete = state == 0;
+
+    // Fade the frame of the last session out once the tiles in view are loaded,
+    // it is not shown when it was read after the scene
+    if (impl->startupFrame && impl->scene->isReady()) {
+        if (!impl->startupFrame->isLoading() &&
+            impl->startupFrame->update(_dt, impl->viewComplete)) {
+            platform->requestRender();
+        } else {
+            impl->startupFrame.reset();
+        }
+    }
+    if (!impl->snapshotJobs.empty()) {
+        platform->requestRender();
     }
 
+    impl->frameBudget.endUpdate();
     FrameInfo::endUpdate();
 
     return { state };
 }
 
 void Map::render() {
-    LOGD("skyway map render");
+    LOGC(render, "skyway map render");
+    TRACE_SCOPE("Map::render");
     auto& scene = *impl->scene;
     auto& view = impl->view;
     auto& renderState = impl->renderState;
 
     glm::vec2 viewport(view.getWidth(), view.getHeight());
 
+    ThreadPool::applyThreadPlacement(ThreadRole::gl, impl->glPlacementGeneration);
+
     // Delete batch of gl resources
     renderState.flushResourceDeletion();
 
+    // Record the GPU time of styles in earlier frames
+    renderState.gpuTimer().collect();
+
     // Invalidate render states for new frame
     if (!impl->cacheGlState) {
         renderState.invalidateStates();
@@ -283,24 +545,62 @@ void Map::render() {
     if (!scene.isReady()) {
         FrameBuffer::apply(renderState, renderState.defaultFrameBuffer(),
                            viewport, impl->background.toColorF());
+        impl->drawStartupFrame(viewport);
         return;
     }
 
     Primitives::setResolution(renderState, view.getWidth(), view.getHeight());
     FrameInfo::beginFrame();
+    impl->frameBudget.beginRender();
+
+    // Compile the programs of the next scene before it is drawn
+    auto* pendingScene = impl->pendingScene.get();
+    if (pendingScene && pendingScene->isReady()) {
+        pendingScene->renderBeginFrame(renderState);
+    } else {
+        pendingScene = nullptr;
+    }
 
     scene.renderBeginFrame(renderState);
+    impl->resolveSnapshot();
+    renderState.uploadBudget = impl->frameBudget.uploadBudget(RenderState::DEFAULT_UPLOAD_BUDGET);
+
+    // Upload new tiles within the per-frame budget; their proxies are drawn
+    // until they are shown after the next update
+    if (scene.tileManager()->uploadTiles(renderState)) {
+        platform->requestRender();
+        impl->frameChanged = true;
+    }
+    if (pendingScene && pendingScene->tileManager()->uploadTiles(renderState)) {
+        platform->requestRender();
+    }
+
+    // Answer feature picks from the FeatureIndex of the tiles when possible
+    if (scene.options().indexInteractiveFeatures) {
+        auto& queries = impl->selectionQueries;
+        queries.erase(std::remove_if(queries.begin(), queries.end(), [&](const SelectionQuery& query) {
+            return query.processFromIndex(view, *scene.tileManager());
+        }), queries.end());
+    }
 
     // Render feature selection pass to offscreen framebuffer
     bool drawSelectionDebug = getDebugFlag(DebugFlags::selection_buffer);
     bool drawSelectionBuffer = !impl->selectionQueries.empty();
 
-    if (drawSelectionBuffer || drawSelectionDebug) {
-        impl->selectionBuffer->applyAsRenderTarget(impl->renderState);
+    // Resolve the queries whose pixels were read on the last frame
+    if (!impl->pendingSelectionQueries.empty()) {
+        scene.resolveSelection(view, *impl->selectionBuffer, impl->pendingSelectionQueries);
+        impl->pendingSelectionQueries.clear();
+    }
 
-        scene.renderSelection(renderState, view,
-                              *impl->selectionBuffer,
-                              impl->selectionQueries);
+    if (drawSelectionBuffer || drawSelectionDebug) {
+        if (scene.renderSelection(renderState, view,
+                                  *impl->selectionBuffer,
+                                  impl->selectionQueries,
+                                  drawSelectionDebug)) {
+            impl->pendingSelectionQueries.swap(impl->selectionQueries);
+            platform->requestRender();
+        }
         impl->selectionQueries.clear();
     }
 
@@ -312,20 +612,81 @@ void Map::render() {
                        viewport, impl->background.toColorF());
 
     if (drawSelectionDebug) {
-        impl->selectionBuffer->drawDebug(renderState, viewport);
+        impl->selectionBuffer->draw(renderState, viewport);
         FrameInfo::draw(renderState, view, *scene.tileManager());
         return;
     }
 
-    // Render scene
-    bool drawnAnimatedStyle = scene.render(renderState, view);
+    // The debug overlays are drawn over the scene and change every frame
+    unsigned long flags = g_flags.to_ulong();
+    if (flags != impl->frameFlags || g_flags.test(DebugFlags::tangram_infos) ||
+        g_flags.test(DebugFlags::tangram_stats)) {
+        impl->frameFlags = flags;
+        impl->frameChanged = true;
+    }
 
-    if (scene.animated() != Scene::animate::no &&
-        drawnAnimatedStyle != platform->isContinuousRendering()) {
-        platform->setContinuousRendering(drawnAnimatedStyle);
+    // Render the scene into the frame cache, or draw the cached frame again
+    auto& frameCache = impl->frameCache;
+    if (!impl->useFrameCache) {
+        frameCache.reset();
+    } else if (!frameCache || frameCache->getWidth() != view.getWidth() ||
+               frameCache->getHeight() != view.getHeight()) {
+        frameCache = std::make_unique<FrameBuffer>(view.getWidth(), view.getHeight(), false, true);
+        impl->frameChanged = true;
     }
 
+    if (frameCache && impl->frameChanged &&
+        !frameCache->applyAsRenderTarget(renderState, impl->background.toColorF())) {
+        // Packed depth stencil is not supported, render directly
+        frameCache.reset();
+        impl->useFrameCache = false;
+        FrameBuffer::apply(renderState, renderState.defaultFrameBuffer(),
+                           viewport, impl->background.toColorF());
+    }
+
+    if (!frameCache || impl->frameChanged) {
+        // Render scene
+        auto renderStart = Metrics::start();
+        bool drawnAnimatedStyle = scene.render(renderState, view);
+        Metrics::record(Metrics::Stage::render, renderStart);
+
+        // Draw the skipped styles once their shaders are compiled, and generate
+        // the mipmaps that did not fit in the upload budget
+        bool pending = scene.shadersPending() || renderState.hasDeferredUploads();
+        if (pending) {
+            platform->requestRender();
+        }
+
+        if (scene.animated() != Scene::animate::no &&
+            drawnAnimatedStyle != platform->isContinuousRendering()) {
+            platform->setContinuousRendering(drawnAnimatedStyle);
+        }
+
+        impl->frameChanged = drawnAnimatedStyle || pending;
+        impl->sceneRendered = true;
+
+        if (impl->viewComplete && !pending && !impl->startupFrameStored) {
+            impl->storeStartupFrame();
+        }
+    }
+
+    if (frameCache) {
+        FrameBuffer::apply(renderState, renderState.defaultFrameBuffer(),
+                           viewport, impl->background.toColorF());
+        renderState.blending(GL_FALSE);
+        frameCache->draw(renderState, viewport);
+    }
+
+    impl->drawStartupFrame(viewport);
+
+    impl->frameBudget.endRender();
+    impl->updateQualityTier();
+
     FrameInfo::draw(renderState, view, *scene.tileManager());
+
+    if (impl->snapshotViewComplete) {
+        impl->renderSnapshot();
+    }
 }
 
 int Map::getViewportHeight() {
@@ -360,6 +721,9 @@ CameraPosition Map::getCameraPosition() {
 void Map::cancelCameraAnimation() {
     impl->inputHandler.cancelFling();
 
+    if (impl->ease && impl->scene->isReady()) {
+        impl->scene->tileManager()->cancelPathPrefetch();
+    }
     impl->ease.reset();
 
     if (impl->cameraAnimationListener) {
@@ -437,6 +801,9 @@ bool Map::Impl::updateCameraEase(float _dt) {
         if (cameraAnimationListener) {
             cameraAnimationListener(true);
         }
+        if (scene->isReady()) {
+            scene->tileManager()->endPathPrefetch();
+        }
         ease.reset();
         return false;
     }
@@ -530,6 +897,12 @@ float Map::getMaxZoom() const {
     return impl->view.getMaxZoom();
 }
 
+void Map::setTileDetail(float _pixelError, int _maxTiles) {
+    impl->view.setTileLodPixelError(_pixelError);
+    impl->view.setMaxVisibleTiles(_maxTiles);
+    platform->requestRender();
+}
+
 void Map::setRotation(float _radians) {
     cancelCameraAnimation();
 
@@ -629,13 +1002,17 @@ void Map::flyTo(const CameraPosition& _camera, float _duration, float _speed) {
                                distance);
 
     EaseType e = EaseType::cubic;
+    auto setView =
+        [=](View& _view, float t) {
+            glm::dvec3 pos = fn(t);
+            _view.setPosition(pos.x, pos.y);
+            _view.setZoom(pos.z);
+            _view.setRoll(ease(rStart, rEnd, t, e));
+            _view.setPitch(ease(tStart, _camera.tilt, t, e));
+        };
     auto cb =
         [=](float t) {
-            glm::dvec3 pos = fn(t);
-            impl->view.setPosition(pos.x, pos.y);
-            impl->view.setZoom(pos.z);
-            impl->view.setRoll(ease(rStart, rEnd, t, e));
-            impl->view.setPitch(ease(tStart, _camera.tilt, t, e));
+            setView(impl->view, t);
             impl->platform.requestRender();
         };
 
@@ -647,6 +1024,17 @@ void Map::flyTo(const CameraPosition& _camera, float _duration, float _speed) {
 
     impl->ease = std::make_unique<Ease>(duration, cb);
 
+    // Start loading the tiles at the destination, then those along the way
+    if (duration > 0.f && impl->scene->isReady()) {
+        std::vector<View> views;
+        for (float t : { 1.f, 0.25f, 0.5f, 0.75f }) {
+            views.push_back(impl->view);
+            setView(views.back(), t);
+            views.back().update();
+        }
+        impl->scene->tileManager()->prefetchPath(views);
+    }
+
     platform->requestRender();
 }
 
@@ -684,6 +1072,7 @@ void Map::Impl::setPixelScale(float _pixelsPerPoint) {
     }
     view.setPixelScale(_pixelsPerPoint);
     scene->setPixelScale(_pixelsPerPoint);
+    if (pendingScene) { pendingScene->setPixelScale(_pixelsPerPoint); }
 }
 
 void Map::setCameraType(int _type) {
@@ -703,6 +1092,7 @@ void Map::addTileSource(std::shared_ptr<TileSource> _source) {
 
     entry.tileSource = _source;
     entry.added = true;
+    impl->clientTileSourcesChanged = true;
 }
 
 bool Map::removeTileSource(TileSource& _source) {
@@ -712,6 +1102,7 @@ bool Map::removeTileSource(TileSource& _source) {
     auto it = tileSources.find(_source.id());
     if (it != tileSources.end()) {
         it->second.remove = true;
+        impl->clientTileSourcesChanged = true;
         return true;
     }
     return false;
@@ -727,20 +1118,87 @@ bool Map::clearTileSource(TileSource& _source, bool _data, bool _tiles) {
     auto it = tileSources.find(_source.id());
     if (it != tileSources.end()) {
         it->second.clear = true;
+        impl->clientTileSourcesChanged = true;
         return true;
     }
     return false;
 }
 
+int32_t Map::downloadOfflineRegion(const OfflineRegion& _region, OfflineRegionCallback _callback) {
+#ifdef TANGRAM_MBTILES_DATASOURCE
+    auto& offlineRegions = impl->offlineRegions;
+    for (auto it = offlineRegions.begin(); it != offlineRegions.end(); ) {
+        if (it->second->isFinished()) {
+            it = offlineRegions.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    const std::string placeholder = "{source}";
+    size_t placeholderPos = _region.path.find(placeholder);
+    if (placeholderPos == std::string::npos && _region.sources.size() > 1) {
+        LOGE("Offline region path must contain '%s' for more than one source", placeholder.c_str());
+        return 0;
+    }
+
+    auto download = std::make_shared<OfflineRegionDownload>(*platform, _region, std::move(_callback));
+
+    for (auto& name : _region.sources) {
+        std::shared_ptr<TileSource> source;
+        for (auto& tileSource : impl->scene->tileSources()) {
+            if (tileSource->name() == name) {
+                source = tileSource;
+                break;
+            }
+        }
+        if (!source) {
+            LOGE("Offline region source '%s' is not in the current scene", name.c_str());
+            continue;
+        }
+        std::string path = _region.path;
+        if (placeholderPos != std::string::npos) {
+            path.replace(placeholderPos, placeholder.size(), name);
+        }
+        download->addSource(source, path);
+    }
+
+    if (!download->hasSources()) { return 0; }
+
+    download->start();
+
+    int32_t id = ++impl->lastOfflineRegionId;
+    offlineRegions.emplace(id, std::move(download));
+    return id;
+#else
+    LOGE("MBTiles support is disabled. Offline regions can not be downloaded");
+    return 0;
+#endif
+}
+
+bool Map::cancelOfflineRegion(int32_t _id) {
+    auto& offlineRegions = impl->offlineRegions;
+    auto it = offlineRegions.find(_id);
+    if (it == offlineRegions.end()) { return false; }
+
+    it->second->cancel();
+    offlineRegions.erase(it);
+    return true;
+}
+
 void Map::Impl::syncClientTileSources(bool _firstUpdate) {
     std::lock_guard<std::mutex> lock(tileSourceMutex);
 
+    if (!clientTileSourcesChanged && !_firstUpdate) { return; }
+    clientTileSourcesChanged = false;
+
     auto& tileManager = *scene->tileManager();
     for (auto it = clientTileSources.begin();
          it != clientTileSources.end(); ) {
         auto& ts = it->second;
         if (ts.remove) {
             tileManager.removeClientTileSource(it->first);
+            if (pendingScene) { pendingScene->tileManager()->removeClientTileSource(it->first); }
             it = clientTileSources.erase(it);
             continue;
         }
@@ -751,6 +1209,7 @@ void Map::Impl::syncClientTileSources(bool _firstUpdate) {
         if (ts.clear) {
             ts.clear = false;
             tileManager.clearTileSet(it->first);
+            if (pendingScene) { pendingScene->tileManager()->clearTileSet(it->first); }
         }
         ++it;
     }
@@ -766,12 +1225,28 @@ bool Map::markerRemove(MarkerID _marker) {
     return success;
 }
 
+void Map::markerAdd(MarkerID* _markers, int _count) {
+    impl->scene->markerManager()->add(_markers, _count);
+}
+
+int Map::markerRemove(const MarkerID* _markers, int _count) {
+    int removed = impl->scene->markerManager()->remove(_markers, _count);
+    platform->requestRender();
+    return removed;
+}
+
 bool Map::markerSetPoint(MarkerID _marker, LngLat _lngLat) {
     bool success = impl->scene->markerManager()->setPoint(_marker, _lngLat);
     platform->requestRender();
     return success;
 }
 
+int Map::markerSetPoint(const MarkerID* _markers, const LngLat* _lngLats, int _count) {
+    int updated = impl->scene->markerManager()->setPoint(_markers, _lngLats, _count);
+    platform->requestRender();
+    return updated;
+}
+
 bool Map::markerSetPointEased(MarkerID _marker, LngLat _lngLat, float _duration, EaseType ease) {
     bool success = impl->scene->markerManager()->setPointEased(_marker, _lngLat, _duration, ease);
     platform->requestRender();
@@ -784,6 +1259,12 @@ bool Map::markerSetPolyline(MarkerID _marker, LngLat* _coordinates, int _count)
     return success;
 }
 
+bool Map::markerAppendPolyline(MarkerID _marker, LngLat* _coordinates, int _count) {
+    bool success = impl->scene->markerManager()->appendPolyline(_marker, _coordinates, _count);
+    platform->requestRender();
+    return success;
+}
+
 bool Map::markerSetPolygon(MarkerID _marker, LngLat* _coordinates, int* _counts, int _rings) {
     bool success = impl->scene->markerManager()->setPolygon(_marker, _coordinates, _counts, _rings);
     platform->requestRender();
@@ -802,6 +1283,28 @@ bool Map::markerSetStylingFromPath(MarkerID _marker, const char* _path) {
     return success;
 }
 
+MarkerStylingID Map::markerCreateStylingFromString(const char* _styling) {
+    return impl->scene->markerManager()->addStyling(_styling, false);
+}
+
+MarkerStylingID Map::markerCreateStylingFromPath(const char* _path) {
+    return impl->scene->markerManager()->addStyling(_path, true);
+}
+
+bool Map::markerRemoveStyling(MarkerStylingID _styling) {
+    return impl->scene->markerManager()->removeStyling(_styling);
+}
+
+bool Map::markerSetStyling(MarkerID _marker, MarkerStylingID _styling) {
+    return markerSetStyling(&_marker, 1, _styling) > 0;
+}
+
+int Map::markerSetStyling(const MarkerID* _markers, int _count, MarkerStylingID _styling) {
+    int updated = impl->scene->markerManager()->setStyling(_markers, _count, _styling);
+    platform->requestRender();
+    return updated;
+}
+
 bool Map::markerSetBitmap(MarkerID _marker, int _width, int _height, const unsigned int* _data, float _density) {
     bool success = impl->scene->markerManager()->setBitmap(_marker, _width, _height, _density, _data);
     platform->requestRender();
@@ -844,6 +1347,17 @@ void Map::pickMarkerAt(float _x, float _y, MarkerPickCallback _onMarkerPickCallb
     platform->requestRender();
 }
 
+void Map::setFeatureState(int32_t _sourceId, uint64_t _featureId, uint32_t _state) {
+    if (impl->scene->featureState()->set(_sourceId, _featureId, _state)) {
+        platform->requestRender();
+    }
+}
+
+void Map::clearFeatureStates() {
+    impl->scene->featureState()->clear();
+    platform->requestRender();
+}
+
 void Map::handleTapGesture(float _posX, float _posY) {
     cancelCameraAnimation();
     impl->inputHandler.handleTapGesture(_posX, _posY);
@@ -890,15 +1404,25 @@ void Map::setupGL() {
 
     LOG("setup GL");
 
+    // Meshes are not kept in memory after upload, so tiles of a lost context
+    // are built again from the tile data in the caches of the sources, those
+    // in view first. Shader programs and textures restore themselves on their
+    // next use, from the program binary cache and their retained copies.
+    if (impl->glContextCreated) {
+        impl->scene->tileManager()->rebuildLostTiles();
+    }
+    impl->glContextCreated = true;
+
     impl->renderState.invalidate();
 
-    //impl->scene->tileManager()->clearTileSets();
     impl->scene->markerManager()->rebuildAll();
 
     if (impl->selectionBuffer->valid()) {
         impl->selectionBuffer = std::make_unique<FrameBuffer>(impl->selectionBuffer->getWidth(),
                                                               impl->selectionBuffer->getHeight());
     }
+    impl->frameCache.reset();
+    impl->frameChanged = true;
 
     // Set default primitive render color
     Primitives::setColor(impl->renderState, 0xffffff);
@@ -914,6 +1438,64 @@ void Map::useCachedGlState(bool _useCache) {
     impl->cacheGlState = _useCache;
 }
 
+void Map::queueSnapshot(const CameraPosition& _camera, int _width, int _height,
+                        SnapshotCallback _callback) {
+    impl->snapshotJobs.push_back({ _camera, _width, _height, std::move(_callback) });
+    impl->platform.requestRender();
+}
+
+int32_t Map::addView(int _width, int _height) {
+    int32_t id = ++impl->lastViewId;
+    impl->views.emplace(id, View(_width, _height));
+    impl->platform.requestRender();
+    return id;
+}
+
+bool Map::removeView(int32_t _id) {
+    impl->platform.requestRender();
+    return impl->views.erase(_id) > 0;
+}
+
+void Map::resizeView(int32_t _id, int _width, int _height) {
+    auto it = impl->views.find(_id);
+    if (it == impl->views.end()) { return; }
+
+    it->second.setSize(_width, _height);
+    impl->platform.requestRender();
+}
+
+void Map::setViewCameraPosition(int32_t _id, const CameraPosition& _camera) {
+    auto it = impl->views.find(_id);
+    if (it == impl->views.end()) { return; }
+
+    auto& view = it->second;
+    view.setZoom(_camera.zoom);
+    view.setRoll(_camera.rotation);
+    view.setPitch(_camera.tilt);
+    view.setCenterCoordinates(LngLat(_camera.longitude, _camera.latitude));
+    impl->platform.requestRender();
+}
+
+void Map::renderView(int32_t _id) {
+    auto it = impl->views.find(_id);
+    if (it == impl->views.end() || !impl->scene->isReady()) { return; }
+
+    auto& view = it->second;
+    auto& renderState = impl->renderState;
+
+    renderState.cacheDefaultFramebuffer();
+    FrameBuffer::apply(renderState, renderState.defaultFrameBuffer(),
+                       glm::vec2(view.getWidth(), view.getHeight()), impl->background.toColorF());
+
+    size_t index = std::distance(impl->views.begin(), it);
+    impl->scene->renderView(renderState, view, index, impl->view);
+}
+
+void Map::useFrameCache(bool _use) {
+    impl->useFrameCache = _use;
+    impl->frameChanged = true;
+}
+
 void Map::runAsyncTask(std::function<void()> _task) {
     if (impl->asyncWorker) {
         impl->asyncWorker->enqueue(std::move(_task));
@@ -922,11 +1504,215 @@ void Map::runAsyncTask(std::function<void()> _task) {
 
 void Map::onMemoryWarning() {
 
+    // Release all cached data, then the tiles in view
+    impl->limitMemory(0);
+
     impl->scene->tileManager()->clearTileSets(true);
 
     if (impl->scene && impl->scene->fontContext()) {
         impl->scene->fontContext()->releaseFonts();
     }
+
+    ShaderSource::clearCache();
+    MemoryCacheDataSource::releaseSharedCaches();
+}
+
+TileCacheStats Map::getTileCacheStats() {
+    return impl->scene->tileManager()->getTileCache()->stats();
+}
+
+MemoryUsage Map::getMemoryUsage() {
+    return impl->getMemoryUsage();
+}
+
+QueueDepths Map::getQueueDepths() {
+    QueueDepths depths;
+    depths.tileTasks = impl->scene->tileWorker()->queuedTasks();
+    depths.urlRequests = impl->platform.activeUrlRequests();
+    depths.jobs = impl->jobQueue.pendingJobs();
+    return depths;
+}
+
+void Map::setTargetFrameTime(float _milliseconds) {
+    impl->frameBudget.setTargetFrameTime(_milliseconds);
+}
+
+void Map::setMemoryBudget(size_t _bytes) {
+    impl->memoryBudget = _bytes;
+    impl->memoryCheckTime = 0;
+    if (_bytes > 0) { impl->limitMemory(_bytes); }
+}
+
+MemoryUsage Map::Impl::getMemoryUsage() {
+    MemoryUsage usage;
+    scene->getMemoryUsage(usage);
+    usage.cpuBytes[MemoryUsage::javascript] = JSContext::heapBytes();
+    return usage;
+}
+
+void Map::Impl::renderSnapshot() {
+    auto job = std::move(snapshotJobs.front());
+    snapshotJobs.pop_front();
+    snapshotViewSet = false;
+    snapshotViewComplete = false;
+
+    if (!snapshotBuffer || snapshotBuffer->getWidth() != job.width ||
+        snapshotBuffer->getHeight() != job.height) {
+        snapshotBuffer = std::make_unique<FrameBuffer>(job.width, job.height, true, true);
+    }
+    if (!snapshotBuffer->applyAsRenderTarget(renderState, background.toColorF())) {
+        LOGE("Unable to render a snapshot of %d x %d", job.width, job.height);
+        encodeSnapshot({}, std::move(job.callback));
+        return;
+    }
+
+    scene->render(renderState, view);
+
+    auto pixels = snapshotBuffer->rect(0, 0, 1, 1);
+    if (snapshotBuffer->readPixelsAsync(pixels)) {
+        snapshotCallback = std::move(job.callback);
+        return;
+    }
+    snapshotBuffer->readPixels(pixels);
+    encodeSnapshot(std::move(pixels), std::move(job.callback));
+}
+
+void Map::Impl::resolveSnapshot() {
+    if (!snapshotCallback) { return; }
+
+    encodeSnapshot(snapshotBuffer->mapPixels(), std::move(snapshotCallback));
+    snapshotCallback = nullptr;
+}
+
+void Map::Impl::encodeSnapshot(FrameBuffer::PixelRect _pixels, SnapshotCallback _callback) {
+    // Encoding takes longer than rendering, keep it off the GL thread
+    asyncWorker->enqueue([pixels = std::move(_pixels), callback = std::move(_callback)]() {
+        std::vector<uint8_t> png;
+        if (!pixels.pixels.empty()) {
+            size_t size = 0;
+            // Rows are read from the bottom up
+            void* data = tdefl_write_image_to_png_file_in_memory_ex(pixels.pixels.data(), pixels.width,
+                                                                    pixels.height, 4, &size,
+                                                                    MZ_DEFAULT_LEVEL, MZ_TRUE);
+            if (data) {
+                png.assign(static_cast<uint8_t*>(data), static_cast<uint8_t*>(data) + size);
+                mz_free(data);
+            }
+        }
+        callback(std::move(png));
+    });
+}
+
+void Map::Impl::loadStartupFrame(const SceneOptions& _options) {
+    startupFrame.reset();
+
+    // Only the first scene of the map is drawn from the last session
+    if (_options.startupFramePath.empty() || sceneRendered) { return; }
+
+    startupFrame = StartupFrame::load(_options.startupFramePath, SceneBinary::sourceHash(_options));
+}
+
+StartupFrame::ViewPosition Map::Impl::startupFrameView() const {
+    StartupFrame::ViewPosition position;
+    position.position = { view.getPosition().x, view.getPosition().y };
+    position.zoom = view.getZoom();
+    position.roll = view.getRoll();
+    position.pitch = view.getPitch();
+    position.width = view.getWidth();
+    position.height = view.getHeight();
+    return position;
+}
+
+void Map::Impl::drawStartupFrame(glm::vec2 _viewport) {
+    if (!startupFrame) { return; }
+
+    if (startupFrame->isLoading()) {
+        // Draw the frame as soon as it is read
+        platform.requestRender();
+        return;
+    }
+    // The frame of another view is not drawn
+    if (!startupFrame->canDraw(startupFrameView())) {
+        startupFrame.reset();
+        return;
+    }
+    startupFrame->draw(renderState, _viewport);
+}
+
+void Map::Impl::storeStartupFrame() {
+    startupFrameStored = true;
+
+    auto& path = scene->options().startupFramePath;
+    if (path.empty()) { return; }
+
+    // Read back the frame of the scene from the bound framebuffer. This waits
+    // for the frame, once for each view that settles.
+    auto position = startupFrameView();
+    std::vector<GLuint> pixels(size_t(position.width) * position.height);
+    GL::readPixels(0, 0, position.width, position.height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+    asyncWorker->enqueue([path, hash = SceneBinary::sourceHash(scene->options()), position,
+                          pixels = std::move(pixels)]() {
+        if (!StartupFrame::store(path, hash, position, pixels)) {
+            LOGW("Could not store the startup frame");
+        }
+    });
+}
+
+void Map::Impl::limitMemory(size_t _budget) {
+    size_t usage = getMemoryUsage().total();
+    if (usage <= _budget) { return; }
+
+    size_t released = scene->releaseMemory(usage - _budget);
+    if (_budget > 0 && usage > released + _budget) {
+        LOGD("Memory usage of %dkb exceeds the budget of %dkb", int((usage - released) / 1024),
+             int(_budget / 1024));
+    }
+}
+
+void Map::Impl::updateQualityTier() {
+    if (!automaticQuality || pendingScene || !scene->isReady() ||
+        scene->qualityTier() == QualityTier::low) { return; }
+
+    if (!qualityMonitor.addFrameTime(frameBudget.frameTime(), frameBudget.targetFrameTime())) {
+        return;
+    }
+
+    // Load the scene again at the next lower tier and keep the view
+    SceneOptions options = scene->options();
+    options.qualityTier = QualityProfile::lowerTier(scene->qualityTier());
+    options.useScenePosition = false;
+
+    LOGW("Frames are slow, loading the scene at quality tier %d", int(options.qualityTier));
+    loadSceneAsync(std::move(options));
+}
+
+QualityTier Map::getQualityTier() const {
+    return impl->scene->qualityTier();
+}
+
+void Map::setMetricsEnabled(bool _enabled) {
+    Metrics::setEnabled(_enabled);
+}
+
+PipelineMetrics Map::getPipelineMetrics(bool _reset) {
+    return Metrics::collect(_reset);
+}
+
+void Map::setTraceEnabled(bool _enabled) {
+    Trace::setEnabled(_enabled);
+}
+
+std::string Map::getTraceJson(bool _clear) {
+    return Trace::toJson(_clear);
+}
+
+std::vector<char> Map::getGlyphFields() {
+    return impl->scene->fontContext()->glyphFieldsData();
+}
+
+void Map::setTileCacheBudget(int32_t _sourceId, size_t _bytes) {
+    impl->scene->tileManager()->getTileCache()->setSourceBudget(_sourceId, _bytes);
 }
 
 void Map::setDefaultBackgroundColor(float r, float g, float b) {
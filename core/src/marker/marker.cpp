@@ -11,6 +11,8 @@
 #include "glm/gtc/matrix_transform.hpp"
 #include "glm/gtx/transform.hpp"
 
+#include <algorithm>
+
 namespace Tangram {
 
 Marker::Marker(MarkerID id) : m_id(id) {
@@ -18,19 +20,41 @@ Marker::Marker(MarkerID id) : m_id(id) {
 }
 
 Marker::~Marker() {
+    clearMesh();
+    // Markers of a removed batch are built again
+    for (auto* marker : m_batchedMarkers) { marker->m_batch = nullptr; }
 }
 
 void Marker::setBounds(BoundingBox bounds) {
     m_bounds = bounds;
     m_origin = bounds.min; // South-West corner
+    m_extent = glm::max(bounds.width(), bounds.height());
+    m_ease.active = false;
+}
+
+void Marker::extendBounds(const BoundingBox& bounds) {
+    m_bounds.expand(bounds.min.x, bounds.min.y);
+    m_bounds.expand(bounds.max.x, bounds.max.y);
 }
 
 void Marker::setStyling(std::string styling, bool isPath) {
     m_styling.string = styling;
     m_styling.isPath = isPath;
+    m_sharedStyling.reset();
     m_builtZoomLevel = -1;
 }
 
+void Marker::setSharedStyling(std::shared_ptr<MarkerStyling> styling) {
+    m_styling = {};
+    m_sharedStyling = std::move(styling);
+    m_builtZoomLevel = -1;
+}
+
+void Marker::setDrawRule(const DrawRule& rule) {
+    m_drawRuleData.reset();
+    m_drawRule = std::make_unique<DrawRule>(rule);
+}
+
 void Marker::setFeature(std::unique_ptr<Feature> feature) {
     m_feature = std::move(feature);
 }
@@ -85,17 +109,47 @@ void Marker::setMesh(uint32_t styleId, uint32_t zoom, std::unique_ptr<StyledMesh
 
 void Marker::clearMesh() {
     m_mesh.reset();
+    if (m_batch) {
+        // The batch is built again without this marker
+        auto& markers = m_batch->m_batchedMarkers;
+        markers.erase(std::find(markers.begin(), markers.end(), this));
+        m_batch->m_mesh.reset();
+        m_batch = nullptr;
+    }
 }
 
-void Marker::setEase(const glm::dvec2& dest, float duration, EaseType e) {
-    auto origin = m_origin;
-    auto cb = [=](float t) { m_origin = { ease(origin.x, dest.x, t, e), ease(origin.y, dest.y, t, e) }; };
-    m_ease = { duration, cb };
+void Marker::setBatch(Marker* batch) {
+    clearMesh();
+    m_batch = batch;
+    m_batch->m_batchedMarkers.push_back(this);
+    m_batch->m_mesh.reset();
 }
 
-void Marker::update(float dt, const View& view) {
-    // Update easing
-    if (!m_ease.finished()) { m_ease.update(dt); }
+void Marker::setEase(const glm::dvec2& dest, float duration, EaseType e, double time) {
+    // Start from the current origin of an ease in progress
+    updateEase(time);
+    m_ease.start = m_origin;
+    m_ease.end = dest;
+    m_ease.startTime = time;
+    m_ease.duration = duration;
+    m_ease.type = e;
+    m_ease.active = true;
+}
+
+void Marker::updateEase(double time) {
+    if (!m_ease.active) { return; }
+
+    float t = 1.f;
+    if (m_ease.duration > 0.f) {
+        t = glm::clamp(float((time - m_ease.startTime) / m_ease.duration), 0.f, 1.f);
+    }
+    m_origin = { ease(m_ease.start.x, m_ease.end.x, t, m_ease.type),
+                 ease(m_ease.start.y, m_ease.end.y, t, m_ease.type) };
+    if (t >= 1.f) { m_ease.active = false; }
+}
+
+void Marker::update(double time, const View& view) {
+    updateEase(time);
     // Apply marker-view translation to the model matrix
     const auto& viewOrigin = view.getPosition();
     m_modelMatrix[3][0] = m_origin.x - viewOrigin.x;
@@ -105,6 +159,8 @@ void Marker::update(float dt, const View& view) {
 }
 
 void Marker::setVisible(bool visible) {
+    // A batch only holds the geometry of visible markers
+    if (m_batch && m_visible != visible) { m_batch->m_mesh.reset(); }
     m_visible = visible;
 }
 
@@ -133,7 +189,7 @@ uint32_t Marker::styleId() const {
 }
 
 float Marker::extent() const {
-    return glm::max(m_bounds.width(), m_bounds.height());
+    return m_extent;
 }
 
 Feature* Marker::feature() const {
@@ -148,6 +204,10 @@ StyledMesh* Marker::mesh() const {
     return m_mesh.get();
 }
 
+Marker* Marker::batch() const {
+    return m_batch;
+}
+
 Texture* Marker::texture() const {
     return m_texture.get();
 }
@@ -169,7 +229,7 @@ const glm::mat4& Marker::modelViewProjectionMatrix() const {
 }
 
 bool Marker::isEasing() const {
-    return !m_ease.finished();
+    return m_ease.active;
 }
 
 bool Marker::isVisible() const {
@@ -8,6 +8,7 @@
 #include "glm/vec2.hpp"
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace Tangram {
 
@@ -21,6 +22,7 @@ class View;
 struct DrawRule;
 struct DrawRuleData;
 struct Feature;
+struct MarkerStyling;
 struct StyledMesh;
 
 class Marker {
@@ -43,12 +45,22 @@ public:
     // maximum dimension (extent) of the bounds.
     void setBounds(BoundingBox bounds);
 
+    // Extend the bounds to include bounds, keeping the origin and extent of the
+    // coordinate system of the feature geometry.
+    void extendBounds(const BoundingBox& bounds);
+
     // Set the feature whose geometry will be used to build the marker.
     void setFeature(std::unique_ptr<Feature> feature);
 
     // Sets the styling struct for the marker
     void setStyling(std::string styling, bool isPath);
 
+    // Set a styling that is parsed once and shared with other markers.
+    void setSharedStyling(std::shared_ptr<MarkerStyling> styling);
+
+    // Set the draw rule of this marker to a copy of rule.
+    void setDrawRule(const DrawRule& rule);
+
     // Set the new draw rule data that will be used to build the marker.
     void setDrawRuleData(std::unique_ptr<DrawRuleData> drawRuleData);
 
@@ -63,17 +75,30 @@ public:
     // Set the styled mesh for this marker with the associated style id and zoom level.
     void setMesh(uint32_t styleId, uint32_t zoom, std::unique_ptr<StyledMesh> mesh);
 
+    // Clear the mesh of this marker, or take it out of its batch
     void clearMesh();
 
+    // Set the batch whose mesh holds the geometry of this marker.
+    void setBatch(Marker* batch);
+
+    // Set whether points are appended to the polyline of this marker, which is
+    // then built into a mesh of its own that is extended with the points.
+    void setAppendable(bool appendable) { m_appendable = appendable; }
+
+    bool isAppendable() const { return m_appendable; }
+
     void setTexture(std::unique_ptr<Texture> texture);
 
     // Set an ease for the origin of this marker in Mercator meters.
-    void setEase(const glm::dvec2& destination, float duration, EaseType ease);
+    // Set an ease for the origin of this marker in Mercator meters, starting at time in
+    // seconds. The origin at a time of update() is evaluated from the start and end points.
+    void setEase(const glm::dvec2& destination, float duration, EaseType ease, double time);
 
     void setSelectionColor(uint32_t selectionColor);
 
-    // Set the model matrix for the marker using the current view and update any eases.
-    void update(float dt, const View& view);
+    // Set the model matrix for the marker using the current view and the origin of
+    // any ease at time in seconds.
+    void update(double time, const View& view);
 
     // Set whether this marker should be visible.
     void setVisible(bool visible);
@@ -94,12 +119,21 @@ public:
     // Get the ordering of this marker relative to other markers.
     int drawOrder() const;
 
-    // Get the length of the maximum dimension of the bounds of this marker. This is used as
-    // the scale in the model matrix.
+    // Get the length of the maximum dimension of the bounds of this marker when they were set.
+    // This is used as the scale in the model matrix.
     float extent() const;
 
     StyledMesh* mesh() const;
 
+    // Get the batch whose mesh holds the geometry of this marker, or null.
+    Marker* batch() const;
+
+    // A batch is a marker with an ID of 0 and no feature of its own, whose mesh
+    // holds the geometry of the markers in it. Its bounds are those of a tile.
+    bool isBatch() const { return m_id == 0; }
+
+    const std::vector<Marker*>& batchedMarkers() const { return m_batchedMarkers; }
+
     DrawRule* drawRule() const;
 
     Feature* feature() const;
@@ -118,6 +152,8 @@ public:
 
     const Styling& styling() const { return m_styling; }
 
+    const std::shared_ptr<MarkerStyling>& sharedStyling() const { return m_sharedStyling; }
+
     bool evaluateRuleForContext(StyleContext& ctx);
 
     bool isEasing() const;
@@ -138,6 +174,7 @@ protected:
     std::unique_ptr<DrawRule> m_drawRule;
 
     Styling m_styling;
+    std::shared_ptr<MarkerStyling> m_sharedStyling;
 
     MarkerID m_id = 0;
 
@@ -155,6 +192,8 @@ protected:
     // Bounding box in global projection space which describes the origin and extent of the coordinates in the Feature
     BoundingBox m_bounds;
 
+    float m_extent = 0;
+
     // Matrix relating marker-local coordinates to global projection space coordinates;
     // Note that this matrix does not contain the relative translation from the global origin to the marker origin.
     // Distances from the global origin are too large to represent precisely in 32-bit floats, so we only apply the
@@ -163,10 +202,43 @@ protected:
 
     glm::mat4 m_modelViewProjectionMatrix;
 
-    Ease m_ease;
+    struct PointEase {
+        glm::dvec2 start;
+        glm::dvec2 end;
+        double startTime = 0;
+        float duration = 0;
+        EaseType type = EaseType::linear;
+        bool active = false;
+    } m_ease;
+
+    void updateEase(double time);
+
+    Marker* m_batch = nullptr;
+    std::vector<Marker*> m_batchedMarkers;
 
     bool m_visible = true;
 
+    bool m_appendable = false;
+
+};
+
+// A styling that is parsed once and shared by many markers. Its draw rule is
+// evaluated once per zoom level and copied to the rules of the markers.
+struct MarkerStyling {
+    MarkerStyling(std::string styling, bool isPath) : rule(0) {
+        rule.setStyling(std::move(styling), isPath);
+    }
+
+    // Marker without geometry that holds the parsed draw rule
+    Marker rule;
+
+    // Whether the styling was parsed, and successfully
+    bool parsed = false;
+    bool valid = false;
+
+    // Zoom at which the rule was last evaluated, and whether it applies there
+    int evaluatedZoom = -1;
+    bool evaluated = false;
 };
 
 } // namespace Tangram
@@ -1,7 +1,7 @@
 #include "marker/markerManager.h"
 
 #include "data/tileData.h"
-#include "gl/texture.h"
+#include "gl/iconAtlas.h"
 #include "marker/marker.h"
 #include "scene/sceneLoader.h"
 #include "scene/dataLayer.h"
@@ -19,35 +19,99 @@ namespace Tangram {
 // ':' Delimiter for style params and layer-sublayer naming
 static const char DELIMITER = ':';
 
-MarkerManager::MarkerManager(const Scene& _scene) : m_scene(_scene) {}
+// Polyline vertices store marker coordinates as 16-bit fixed point in [-4, 4)
+static const float MAX_LINE_COORDINATE = 3.99f;
+
+MarkerManager::MarkerManager(const Scene& _scene)
+    : m_scene(_scene), m_batchMarkers(_scene.options().batchMarkers) {}
 
 MarkerManager::~MarkerManager() {}
 
 
 MarkerID MarkerManager::add() {
+    MarkerID id = 0;
+    add(&id, 1);
+    return id;
+}
+
+void MarkerManager::add(MarkerID* markerIDs, int count) {
+    if (count <= 0) { return; }
+
     m_dirty = true;
 
-    // Add a new empty marker object to the list of markers.
-    auto id = ++m_idCounter;
-    m_markers.push_back(std::make_unique<Marker>(id));
+    // Add new empty marker objects to the list of markers.
+    for (int i = 0; i < count; i++) {
+        auto id = ++m_idCounter;
+        m_markers.push_back(std::make_unique<Marker>(id));
+        m_markerIndex[id] = m_markers.back().get();
+
+        // Return a handle for the marker.
+        markerIDs[i] = id;
+    }
 
     // Sort the marker list by draw order.
     std::stable_sort(m_markers.begin(), m_markers.end(), Marker::compareByDrawOrder);
-
-    // Return a handle for the marker.
-    return id;
 }
 
 bool MarkerManager::remove(MarkerID markerID) {
     m_dirty = true;
 
-    for (auto it = m_markers.begin(), end = m_markers.end(); it != end; ++it) {
-        if (it->get()->id() == markerID) {
-            m_markers.erase(it);
-            return true;
-        }
+    return remove(&markerID, 1) > 0;
+}
+
+int MarkerManager::remove(const MarkerID* markerIDs, int count) {
+    std::vector<const Marker*> removed;
+    for (int i = 0; i < count; i++) {
+        auto it = m_markerIndex.find(markerIDs[i]);
+        if (it == m_markerIndex.end()) { continue; }
+        removed.push_back(it->second);
+        m_markerIndex.erase(it);
     }
-    return false;
+    if (removed.empty()) { return 0; }
+
+    m_dirty = true;
+
+    // Erase all of them in one pass over the list of markers
+    std::sort(removed.begin(), removed.end());
+    m_markers.erase(std::remove_if(m_markers.begin(), m_markers.end(), [&](auto& marker) {
+                return std::binary_search(removed.begin(), removed.end(), marker.get());
+            }), m_markers.end());
+
+    return int(removed.size());
+}
+
+MarkerStylingID MarkerManager::addStyling(const char* styling, bool isPath) {
+    if (!styling) { return 0; }
+
+    auto id = ++m_stylingIdCounter;
+    m_stylings[id] = std::make_shared<MarkerStyling>(std::string(styling), isPath);
+
+    return id;
+}
+
+bool MarkerManager::removeStyling(MarkerStylingID stylingID) {
+    auto it = m_stylings.find(stylingID);
+    if (it == m_stylings.end()) { return false; }
+
+    m_stylings.erase(it);
+    return true;
+}
+
+int MarkerManager::setStyling(const MarkerID* markerIDs, int count, MarkerStylingID stylingID) {
+    auto it = m_stylings.find(stylingID);
+    if (it == m_stylings.end()) { return 0; }
+
+    int updated = 0;
+    for (int i = 0; i < count; i++) {
+        Marker* marker = getMarkerOrNull(markerIDs[i]);
+        if (!marker) { continue; }
+
+        marker->setSharedStyling(it->second);
+        updated++;
+    }
+    if (updated > 0) { m_dirty = true; }
+
+    return updated;
 }
 
 bool MarkerManager::setStyling(MarkerID markerID, const char* styling, bool isPath) {
@@ -68,10 +132,15 @@ bool MarkerManager::setBitmap(MarkerID markerID, int width, int height, float de
 
     TextureOptions options;
     options.displayScale = 1.f / density;
-    auto texture = std::make_unique<Texture>(options);
+    auto texture = std::make_unique<IconAtlasTexture>(options);
     texture->setPixelData(width, height, sizeof(GLuint),
                           reinterpret_cast<const GLubyte*>(bitmapData),
                           width * height * sizeof(GLuint));
+    texture->retainCompressedCopy();
+    // Small bitmaps are drawn from the icon atlas of the scene
+    if (texture->canAddToAtlas()) {
+        texture->addToAtlas(m_scene.iconAtlas());
+    }
     marker->setTexture(std::move(texture));
     m_dirty = true;
 
@@ -93,6 +162,8 @@ bool MarkerManager::setDrawOrder(MarkerID markerID, int drawOrder) {
     if (!marker) { return false; }
 
     marker->setDrawOrder(drawOrder);
+    // Move the marker to the batch of its draw order
+    if (marker->batch()) { marker->clearMesh(); }
     // Sort the marker list by draw order.
     std::stable_sort(m_markers.begin(), m_markers.end(), Marker::compareByDrawOrder);
 
@@ -105,13 +176,14 @@ bool MarkerManager::setPoint(MarkerID markerID, LngLat lngLat) {
     Marker* marker = getMarkerOrNull(markerID);
     if (!marker) { return false; }
 
-    marker->clearMesh();
-
     // If the marker does not have a 'point' feature mesh built, build it.
+    // Otherwise the point moves with the origin of the model matrix, like
+    // for eased points, and its mesh is kept.
     if (!marker->feature() || marker->feature()->geometryType != GeometryType::points) {
+        marker->clearMesh();
         auto feature = std::make_unique<Feature>();
         feature->geometryType = GeometryType::points;
-        feature->points.emplace_back();
+        feature->addPoint({});
         marker->setFeature(std::move(feature));
     }
 
@@ -124,6 +196,14 @@ bool MarkerManager::setPoint(MarkerID markerID, LngLat lngLat) {
     return true;
 }
 
+int MarkerManager::setPoint(const MarkerID* markerIDs, const LngLat* lngLats, int count) {
+    int updated = 0;
+    for (int i = 0; i < count; i++) {
+        if (setPoint(markerIDs[i], lngLats[i])) { updated++; }
+    }
+    return updated;
+}
+
 bool MarkerManager::setPointEased(MarkerID markerID, LngLat lngLat, float duration, EaseType ease) {
     Marker* marker = getMarkerOrNull(markerID);
     if (!marker) { return false; }
@@ -136,7 +216,7 @@ bool MarkerManager::setPointEased(MarkerID markerID, LngLat lngLat, float durati
     }
 
     auto dest = MapProjection::lngLatToProjectedMeters({lngLat.longitude, lngLat.latitude});
-    marker->setEase(dest, duration, ease);
+    marker->setEase(dest, duration, ease, m_time);
 
     return true;
 }
@@ -147,14 +227,15 @@ bool MarkerManager::setPolyline(MarkerID markerID, LngLat* coordinates, int coun
 
     m_dirty = true;
     marker->clearMesh();
+    marker->setAppendable(false);
 
     if (!coordinates || count < 2) { return false; }
 
     // Build a feature for the new set of polyline points.
     auto feature = std::make_unique<Feature>();
     feature->geometryType = GeometryType::lines;
-    feature->lines.emplace_back();
-    auto& line = feature->lines.back();
+    Line line;
+    line.reserve(count);
 
     // Determine the bounds of the polyline.
     BoundingBox bounds;
@@ -178,6 +259,7 @@ bool MarkerManager::setPolyline(MarkerID markerID, LngLat* coordinates, int coun
         auto meters = MapProjection::lngLatToProjectedMeters(degrees);
         line.emplace_back((meters.x - origin.x) * scale, (meters.y - origin.y) * scale);
     }
+    feature->addLine(line);
 
     // Update the feature data for the marker.
     marker->setFeature(std::move(feature));
@@ -185,6 +267,95 @@ bool MarkerManager::setPolyline(MarkerID markerID, LngLat* coordinates, int coun
     return true;
 }
 
+bool MarkerManager::appendPolyline(MarkerID markerID, LngLat* coordinates, int count) {
+    Marker* marker = getMarkerOrNull(markerID);
+    if (!marker) { return false; }
+
+    auto feature = marker->feature();
+    if (!feature || feature->geometryType != GeometryType::lines || feature->lines().size() != 1) {
+        if (!setPolyline(markerID, coordinates, count)) { return false; }
+        marker->setAppendable(true);
+        return true;
+    }
+
+    if (!coordinates || count < 1) { return false; }
+
+    m_dirty = true;
+
+    auto line = feature->lines()[0];
+    size_t first = line.size();
+
+    const auto origin = marker->origin();
+    double extent = marker->extent();
+    BoundingBox bounds = marker->bounds();
+
+    std::vector<glm::dvec2> meters;
+    meters.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        meters.push_back(MapProjection::lngLatToProjectedMeters({coordinates[i].longitude, coordinates[i].latitude}));
+        bounds.expand(meters.back().x, meters.back().y);
+    }
+
+    if (extent > 0) {
+        // Project the points into the coordinate system of the marker
+        Line points;
+        points.reserve(count);
+        bool inRange = true;
+        for (const auto& m : meters) {
+            glm::vec2 point((m - origin) / extent);
+            if (point == (points.empty() ? line.back() : points.back())) { continue; }
+
+            inRange &= std::abs(point.x) < MAX_LINE_COORDINATE && std::abs(point.y) < MAX_LINE_COORDINATE;
+            points.push_back(point);
+        }
+        if (points.empty()) { return true; }
+
+        if (inRange) {
+            feature->extendLine(points.data(), points.size());
+            marker->extendBounds(bounds);
+            marker->setAppendable(true);
+
+            // Extend the mesh when it is built for the current zoom
+            auto mesh = marker->mesh();
+            auto rule = marker->drawRule();
+            if (mesh && rule && m_styleContext && marker->builtZoomLevel() == m_zoom) {
+                StyleBuilder* styler = getStyleBuilder(*rule);
+                if (styler) {
+                    styler->setup(*marker, m_zoom);
+                    if (styler->appendLine(*mesh, *feature, first, *rule)) { return true; }
+                }
+            }
+            marker->clearMesh();
+            return true;
+        }
+    }
+
+    // Set the line again in the coordinate system of the bounds of all points,
+    // whose extent grows by a factor of 4 or more until this is needed again
+    marker->clearMesh();
+    marker->setBounds(bounds);
+    const auto& newOrigin = marker->origin();
+    double scale = marker->extent() > 0 ? 1. / marker->extent() : 0.;
+
+    Line all;
+    all.reserve(first + meters.size());
+    for (const auto& point : line) {
+        glm::dvec2 m = extent > 0 ? origin + glm::dvec2(point) * extent : origin;
+        all.emplace_back((m - newOrigin) * scale);
+    }
+    for (const auto& m : meters) {
+        all.emplace_back((m - newOrigin) * scale);
+    }
+
+    auto rebased = std::make_unique<Feature>();
+    rebased->geometryType = GeometryType::lines;
+    rebased->addLine(all);
+    marker->setFeature(std::move(rebased));
+    marker->setAppendable(true);
+
+    return true;
+}
+
 bool MarkerManager::setPolygon(MarkerID markerID, LngLat* coordinates, int* counts, int rings) {
     if (!m_scene.isReady()) { return false; }
 
@@ -199,8 +370,8 @@ bool MarkerManager::setPolygon(MarkerID markerID, LngLat* coordinates, int* coun
     // Build a feature for the new set of polygon points.
     auto feature = std::make_unique<Feature>();
     feature->geometryType = GeometryType::polygons;
-    feature->polygons.emplace_back();
-    auto& polygon = feature->polygons.back();
+    feature->beginPolygon();
+    Line line;
 
     // Determine the bounds of the polygon.
     BoundingBox bounds;
@@ -229,13 +400,13 @@ bool MarkerManager::setPolygon(MarkerID markerID, LngLat* coordinates, int* coun
     ring = coordinates;
     for (int i = 0; i < rings; ++i) {
         int count = counts[i];
-        polygon.emplace_back();
-        auto& line = polygon.back();
+        line.clear();
         for (int j = 0; j < count; ++j) {
             auto degrees = LngLat(ring[j].longitude, ring[j].latitude);
             auto meters = MapProjection::lngLatToProjectedMeters(degrees);
             line.emplace_back((meters.x - origin.x) * scale, (meters.y - origin.y) * scale);
         }
+        feature->addRing(line);
         ring += count;
     }
 
@@ -261,32 +432,75 @@ bool MarkerManager::update(const View& _view, float _dt) {
     }
 
     m_zoom = _view.getZoom();
+    m_time += _dt;
+
+    if (m_idle && !m_dirty && !_view.changedOnLastUpdate()) { return false; }
 
     bool rebuilt = false;
     bool easing = false;
     bool dirty = m_dirty;
     m_dirty = false;
 
-    for (auto& marker : m_markers) {
+    size_t markerCount = m_markers.size();
+    for (size_t i = 0; i < markerCount; i++) {
+        Marker* marker = m_markers[i].get();
+        if (marker->isBatch()) { continue; }
+
         int builtZoom = marker->builtZoomLevel();
 
-        if (m_zoom != builtZoom || !marker->mesh()) {
+        if (m_zoom != builtZoom || (!marker->mesh() && !marker->batch())) {
             if (builtZoom < 0) { buildStyling(*marker); }
 
-            buildMesh(*marker, m_zoom);
+            if (!addToBatch(*marker, m_zoom)) {
+                buildMesh(*marker, m_zoom);
+            }
             rebuilt = true;
         }
 
-        marker->update(_dt, _view);
+        // Hidden markers are not drawn, and the origin of their
+        // eases is evaluated from the time once they are shown
+        if (!marker->isVisible()) { continue; }
+
+        marker->update(m_time, _view);
         easing |= marker->isEasing();
     }
 
+    if (!m_batches.empty()) {
+        if (m_markers.size() > markerCount) {
+            // Sort new batches by draw order
+            std::stable_sort(m_markers.begin(), m_markers.end(), Marker::compareByDrawOrder);
+        }
+
+        for (auto it = m_batches.begin(); it != m_batches.end();) {
+            if (it->second->batchedMarkers().empty()) {
+                it = m_batches.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        m_markers.erase(std::remove_if(m_markers.begin(), m_markers.end(), [](auto& marker) {
+                    return marker->isBatch() && marker->batchedMarkers().empty();
+                }), m_markers.end());
+
+        for (auto& marker : m_markers) {
+            if (!marker->isBatch()) { continue; }
+            if (!marker->mesh()) {
+                rebuilt |= buildBatch(*marker, m_zoom);
+            }
+            marker->update(m_time, _view);
+        }
+    }
+
+    m_idle = !rebuilt && !easing;
+
     return rebuilt || easing || dirty;
 }
 
 void MarkerManager::removeAll() {
     m_dirty = true;
     m_markers.clear();
+    m_markerIndex.clear();
+    m_batches.clear();
 }
 
 void MarkerManager::rebuildAll() {
@@ -295,8 +509,40 @@ void MarkerManager::rebuildAll() {
     m_dirty = true;
 
     for (auto& entry : m_markers) {
+        if (entry->isBatch()) { continue; }
         buildStyling(*entry);
-        buildMesh(*entry, m_zoom);
+        if (entry->batch()) {
+            // Added to a batch again on next update
+            entry->clearMesh();
+        } else {
+            buildMesh(*entry, m_zoom);
+        }
+    }
+}
+
+void MarkerManager::resetStyling() {
+    m_dirty = true;
+
+    // Marker function indices are offset by the number of scene functions
+    m_styleContext.reset();
+    m_styleBuilders.clear();
+    m_functions.clear();
+    m_stops.clear();
+
+    for (auto& entry : m_stylings) {
+        entry.second->parsed = false;
+    }
+
+    for (auto& marker : m_markers) {
+        if (marker->isBatch()) { continue; }
+        if (auto shared = marker->sharedStyling()) {
+            // Parsed again for the first of its markers
+            shared->parsed = false;
+            marker->setSharedStyling(shared);
+            continue;
+        }
+        const auto& styling = marker->styling();
+        marker->setStyling(styling.string, styling.isPath);
     }
 }
 
@@ -306,6 +552,19 @@ const std::vector<std::unique_ptr<Marker>>& MarkerManager::markers() const {
 
 bool MarkerManager::buildStyling(Marker& marker) {
 
+    // Copy the rule of a shared styling, which is parsed only once
+    if (const auto& shared = marker.sharedStyling()) {
+        if (!shared->parsed) {
+            shared->parsed = true;
+            shared->valid = buildStyling(shared->rule);
+            shared->evaluatedZoom = -1;
+        }
+        if (!shared->valid) { return false; }
+
+        marker.setDrawRule(*shared->rule.drawRule());
+        return true;
+    }
+
     const auto& markerStyling = marker.styling();
 
     // If the Marker styling is a path, find the layers it specifies.
@@ -390,36 +649,39 @@ bool MarkerManager::buildStyling(Marker& marker) {
     return true;
 }
 
-bool MarkerManager::buildMesh(Marker& marker, int zoom) {
-
-    marker.clearMesh();
+StyleBuilder* MarkerManager::getStyleBuilder(const DrawRule& rule) {
+    auto name = rule.getStyleName();
+    auto it = m_styleBuilders.find(name);
+    if (it == m_styleBuilders.end()) {
+        LOGN("Invalid style %s", name.c_str());
+        return nullptr;
+    }
+    return it->second.get();
+}
 
-    auto feature = marker.feature();
+bool MarkerManager::evaluateRule(Marker& marker, StyleBuilder& styler, int zoom) {
     auto rule = marker.drawRule();
-    if (!feature || !rule) { return false; }
 
-    StyleBuilder* styler = nullptr;
-    {
-        auto name = rule->getStyleName();
-        auto it = m_styleBuilders.find(name);
-        if (it != m_styleBuilders.end()) {
-            styler = it->second.get();
-        } else {
-            LOGN("Invalid style %s", name.c_str());
-            return false;
+    if (const auto& shared = marker.sharedStyling()) {
+        // Evaluate the shared rule once per zoom for all of its markers
+        if (shared->evaluatedZoom != zoom) {
+            styler.style().applyDefaultDrawRules(*shared->rule.drawRule());
+            m_styleContext->setZoom(zoom);
+            shared->evaluated = shared->rule.evaluateRuleForContext(*m_styleContext);
+            shared->evaluatedZoom = zoom;
         }
-    }
-
-    // Apply default draw rules defined for this style
-    styler->style().applyDefaultDrawRules(*rule);
+        if (!shared->evaluated) { return false; }
 
-    m_styleContext->setZoom(zoom);
+        *rule = *shared->rule.drawRule();
 
-    bool valid = marker.evaluateRuleForContext(*m_styleContext);
+    } else {
+        // Apply default draw rules defined for this style
+        styler.style().applyDefaultDrawRules(*rule);
 
-    if (!valid) { return false; }
+        m_styleContext->setZoom(zoom);
 
-    styler->setup(marker, zoom);
+        if (!marker.evaluateRuleForContext(*m_styleContext)) { return false; }
+    }
 
     uint32_t selectionColor = 0;
     bool interactive = false;
@@ -431,15 +693,129 @@ bool MarkerManager::buildMesh(Marker& marker, int zoom) {
     } else {
         rule->selectionColor = 0;
     }
+    marker.setSelectionColor(selectionColor);
 
-    if (!styler->addFeature(*feature, *rule)) { return false; }
+    return true;
+}
 
-    marker.setSelectionColor(selectionColor);
-    marker.setMesh(styler->style().getID(), zoom, styler->build());
+bool MarkerManager::buildMesh(Marker& marker, int zoom) {
+
+    marker.clearMesh();
+
+    auto feature = marker.feature();
+    auto rule = marker.drawRule();
+    if (!feature || !rule) { return false; }
+
+    StyleBuilder* styler = getStyleBuilder(*rule);
+    if (!styler) { return false; }
+
+    if (!evaluateRule(marker, *styler, zoom)) { return false; }
+
+    styler->setup(marker, zoom);
+
+    std::unique_ptr<StyledMesh> mesh;
+    if (marker.isAppendable()) {
+        mesh = styler->buildAppendable(*feature, *rule);
+    }
+    if (!mesh) {
+        if (!styler->addFeature(*feature, *rule)) { return false; }
+        mesh = styler->build();
+    }
+
+    marker.setMesh(styler->style().getID(), zoom, std::move(mesh));
+
+    return true;
+}
+
+bool MarkerManager::addToBatch(Marker& marker, int zoom) {
+    // Appendable markers keep a mesh of their own that is extended in place
+    if (!m_batchMarkers || marker.isAppendable()) { return false; }
+
+    auto feature = marker.feature();
+    auto rule = marker.drawRule();
+    if (!feature || !rule || feature->geometryType == GeometryType::points) { return false; }
+
+    StyleBuilder* styler = getStyleBuilder(*rule);
+    if (!styler) { return false; }
+
+    auto& style = styler->style();
+    if (style.type() != StyleType::polygon && style.type() != StyleType::polyline) {
+        return false;
+    }
+
+    // The batch has the coordinates of the tile at zoom that contains the
+    // origin of the marker. Markers larger than the tile keep their own mesh,
+    // since their vertices would be out of the range of the tile.
+    double metersPerTile = MapProjection::metersPerTileAtZoom(zoom);
+    if (marker.extent() > metersPerTile) { return false; }
+
+    int tiles = 1 << zoom;
+    TileID tile(glm::clamp(int((marker.origin().x + MapProjection::EARTH_HALF_CIRCUMFERENCE_METERS) / metersPerTile), 0, tiles - 1),
+                glm::clamp(int((MapProjection::EARTH_HALF_CIRCUMFERENCE_METERS - marker.origin().y) / metersPerTile), 0, tiles - 1),
+                zoom);
+
+    auto& batch = m_batches[std::make_tuple(marker.drawOrder(), style.getID(), tile)];
+    if (!batch) {
+        m_markers.push_back(std::make_unique<Marker>(0));
+        batch = m_markers.back().get();
+        batch->setBounds(MapProjection::tileBounds(tile));
+        batch->setDrawOrder(marker.drawOrder());
+        batch->setMesh(style.getID(), zoom, nullptr);
+    }
+
+    marker.setBatch(batch);
+    marker.setMesh(style.getID(), zoom, nullptr);
 
     return true;
 }
 
+bool MarkerManager::buildBatch(Marker& batch, int zoom) {
+    if (batch.batchedMarkers().empty()) { return false; }
+
+    auto rule = batch.batchedMarkers().front()->drawRule();
+    StyleBuilder* styler = getStyleBuilder(*rule);
+    if (!styler) { return false; }
+
+    styler->setup(batch, zoom);
+
+    const auto& origin = batch.origin();
+    double extent = batch.extent();
+
+    for (auto* marker : batch.batchedMarkers()) {
+        if (!marker->isVisible()) { continue; }
+        if (!evaluateRule(*marker, *styler, zoom)) { continue; }
+
+        // Move the geometry from the coordinates of the marker to those of the batch
+        glm::vec2 offset((marker->origin() - origin) / extent);
+        float scale = marker->extent() / extent;
+        auto toBatch = [&](const LineView& _line) {
+            Line line;
+            line.reserve(_line.size());
+            for (const auto& point : _line) { line.push_back(offset + point * scale); }
+            return line;
+        };
+
+        auto feature = marker->feature();
+        Feature batchFeature;
+        batchFeature.geometryType = feature->geometryType;
+        batchFeature.props = feature->props;
+        if (feature->geometryType == GeometryType::lines) {
+            for (const auto& line : feature->lines()) { batchFeature.addLine(toBatch(line)); }
+        } else {
+            for (const auto& polygon : feature->polygons()) {
+                batchFeature.beginPolygon();
+                for (const auto& ring : polygon) { batchFeature.addRing(toBatch(ring)); }
+            }
+        }
+
+        styler->addFeature(batchFeature, *marker->drawRule());
+    }
+
+    batch.setMesh(styler->style().getID(), zoom, styler->build());
+
+    return bool(batch.mesh());
+}
+
 const Marker* MarkerManager::getMarkerOrNullBySelectionColor(uint32_t selectionColor) const {
     for (const auto& marker : m_markers) {
         if (marker->isVisible() && marker->selectionColor() == selectionColor) {
@@ -452,10 +828,9 @@ const Marker* MarkerManager::getMarkerOrNullBySelectionColor(uint32_t selectionC
 
 Marker* MarkerManager::getMarkerOrNull(MarkerID markerID) {
     if (!markerID) { return nullptr; }
-    for (const auto& entry : m_markers) {
-        if (entry->id() == markerID) { return entry.get(); }
-    }
-    return nullptr;
+    auto it = m_markerIndex.find(markerID);
+    if (it == m_markerIndex.end()) { return nullptr; }
+    return it->second;
 }
 
 } // namespace Tangram
@@ -6,13 +6,17 @@
 #include "util/fastmap.h"
 #include "util/types.h"
 
+#include <map>
 #include <memory>
+#include <tuple>
+#include <unordered_map>
 #include <vector>
 
 namespace Tangram {
 
 class MapProjection;
 class Marker;
+struct MarkerStyling;
 class StyleBuilder;
 class StyleContext;
 class View;
@@ -27,9 +31,25 @@ public:
     // Create a new, empty marker and return its ID. An ID of 0 indicates an invalid marker.
     MarkerID add();
 
+    // Create count new, empty markers and write their IDs to markerIDs.
+    void add(MarkerID* markerIDs, int count);
+
     // Try to remove the marker with the given ID; returns true if the marker was found and removed.
     bool remove(MarkerID markerID);
 
+    // Remove the markers with the given IDs; returns the number of markers found and removed.
+    int remove(const MarkerID* markerIDs, int count);
+
+    // Create a styling from a YAML string or a scene path that is parsed once and can be shared by
+    // many markers; returns its ID, or 0 if styling is null.
+    MarkerStylingID addStyling(const char* styling, bool isPath);
+
+    // Remove a shared styling; markers that use it keep their styling. Returns true if it was found.
+    bool removeStyling(MarkerStylingID stylingID);
+
+    // Set the shared styling of the markers with the given IDs; returns the number of markers updated.
+    int setStyling(const MarkerID* markerIDs, int count, MarkerStylingID stylingID);
+
     // Set the styling for a marker using a YAML string; returns true if the marker was found and updated.
     bool setStylingFromString(MarkerID markerID, const char* styling) {
         return setStyling(markerID, styling, false);
@@ -51,6 +71,9 @@ public:
     // Set a marker to a point feature at the given position; returns true if the marker was found and updated.
     bool setPoint(MarkerID markerID, LngLat lngLat);
 
+    // Set the markers with the given IDs to point features at lngLats; returns the number of markers updated.
+    int setPoint(const MarkerID* markerIDs, const LngLat* lngLats, int count);
+
     // Set a marker to a point feature at the given position; if the marker was previously set to a point, this
     // eases from the old position to the new one over the given duration with the given ease type; returns true if
     // the marker was found and updated.
@@ -59,12 +82,18 @@ public:
     // Set a marker to a polyline feature at the given position; returns true if the marker was found and updated.
     bool setPolyline(MarkerID markerID, LngLat* coordinates, int count);
 
+    // Append points to the polyline of a marker, or set it to a polyline when it has none. The mesh of
+    // the polyline is extended in place while the zoom does not change. Returns true if the marker was
+    // found and updated.
+    bool appendPolyline(MarkerID markerID, LngLat* coordinates, int count);
+
     // Set a marker to a polygon feature at the given position; returns true if the marker was found and updated.
     bool setPolygon(MarkerID markerID, LngLat* coordinates, int* counts, int rings);
 
     // Update the zoom level for all markers; markers are built for one zoom
     // level at a time so when the current zoom changes, all marker meshes are
     // rebuilt. Returns true when any Markers changed since last call to update.
+    // Markers are not visited while they and the view do not change.
     bool update(const View& _view, float _dt);
 
     // Remove and destroy all markers.
@@ -73,6 +102,10 @@ public:
     // Rebuild all markers.
     void rebuildAll();
 
+    // Drop the styling of all markers after the scene layers, functions or stops
+    // changed; markers are styled and built again on next update.
+    void resetStyling();
+
     const std::vector<std::unique_ptr<Marker>>& markers() const;
 
     const Marker* getMarkerOrNullBySelectionColor(uint32_t selectionColor) const;
@@ -85,6 +118,15 @@ private:
     bool buildStyling(Marker& marker);
     bool buildMesh(Marker& marker, int zoom);
 
+    StyleBuilder* getStyleBuilder(const DrawRule& rule);
+    bool evaluateRule(Marker& marker, StyleBuilder& styler, int zoom);
+
+    // Add a polyline or polygon marker to the batch of its draw order, style and
+    // tile at zoom; returns false when the marker needs a mesh of its own.
+    bool addToBatch(Marker& marker, int zoom);
+    // Returns true when the batch has geometry to draw
+    bool buildBatch(Marker& batch, int zoom);
+
     const Scene& m_scene;
     // Custom functions and stops from styling strings
     SceneStops m_stops;
@@ -92,11 +134,22 @@ private:
 
     std::unique_ptr<StyleContext> m_styleContext;
     std::vector<std::unique_ptr<Marker>> m_markers;
+    std::unordered_map<MarkerID, Marker*> m_markerIndex;
+    fastmap<MarkerStylingID, std::shared_ptr<MarkerStyling>> m_stylings;
     fastmap<std::string, std::unique_ptr<StyleBuilder>> m_styleBuilders;
 
+    // Batch markers in m_markers by draw order, style ID and tile
+    std::map<std::tuple<int, uint32_t, TileID>, Marker*> m_batches;
+    bool m_batchMarkers = false;
+
     uint32_t m_idCounter = 0;
+    uint32_t m_stylingIdCounter = 0;
     int m_zoom = 0;
+    // Time of the last update in seconds, the clock of marker eases
+    double m_time = 0;
     bool m_dirty = false;
+    // No marker was rebuilt or easing in the last update
+    bool m_idle = false;
 
 };
 
@@ -1,6 +1,7 @@
 #include "platform.h"
 #include "log.h"
 
+#include <algorithm>
 #include <fstream>
 #include <string>
 #include <cassert>
@@ -78,6 +79,10 @@ void Platform::shutdown() {
 }
 
 UrlRequestHandle Platform::startUrlRequest(Url _url, UrlCallback&& _callback) {
+    return startUrlRequest(std::move(_url), UrlValidators(), std::move(_callback));
+}
+
+UrlRequestHandle Platform::startUrlRequest(Url _url, const UrlValidators& _validators, UrlCallback&& _callback) {
 
     assert(_callback);
 
@@ -99,7 +104,11 @@ UrlRequestHandle Platform::startUrlRequest(Url _url, UrlCallback&& _callback) {
     }
 
     // Start Platform specific url request
-    if (startUrlRequestImpl(_url, handle, entry->id)) {
+    bool cancelable = _validators.empty() ?
+        startUrlRequestImpl(_url, handle, entry->id) :
+        startConditionalUrlRequestImpl(_url, _validators, handle, entry->id);
+
+    if (cancelable) {
         entry->cancelable = true;
     }
 
@@ -140,6 +149,25 @@ void Platform::cancelUrlRequest(const UrlRequestHandle _request) {
     }
 }
 
+void Platform::setUrlRequestPriority(const UrlRequestHandle _request, float _priority) {
+    if (_request == 0) { return; }
+
+    UrlRequestId id = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_callbackMutex);
+        auto it = m_urlCallbacks.find(_request);
+        if (it == m_urlCallbacks.end() || !it->second.cancelable) { return; }
+        id = it->second.id;
+    }
+
+    setUrlRequestPriorityImpl(id, std::max(0.f, std::min(_priority, 1.f)));
+}
+
+size_t Platform::activeUrlRequests() {
+    std::lock_guard<std::mutex> lock(m_callbackMutex);
+    return m_urlCallbacks.size();
+}
+
 void Platform::onUrlResponse(const UrlRequestHandle _request, UrlResponse&& _response) {
     if (m_shutdown) {
         LOGW("onUrlResponse after shutdown");
@@ -1,6 +1,7 @@
 #include "scene/directionalLight.h"
 
 #include "gl/shaderProgram.h"
+#include "gl/uniformBuffer.h"
 #include "directionalLight_glsl.h"
 #include "platform.h"
 #include "util/floatFormatter.h"
@@ -30,18 +31,30 @@ std::unique_ptr<LightUniforms> DirectionalLight::getUniforms() {
     return std::make_unique<Uniforms>(getUniformName());
 }
 
-void DirectionalLight::setupProgram(RenderState& rs, const View& _view, ShaderProgram& _shader,
-                                    LightUniforms& _uniforms) {
+glm::vec3 DirectionalLight::getViewDirection(const View& _view) const {
 
-    glm::vec3 direction = m_direction;
     if (m_origin == LightOrigin::world) {
-        direction = _view.getNormalMatrix() * direction;
+        return _view.getNormalMatrix() * m_direction;
     }
+    return m_direction;
+}
+
+void DirectionalLight::setupProgram(RenderState& rs, const View& _view, ShaderProgram& _shader,
+                                    LightUniforms& _uniforms) {
 
     Light::setupProgram(rs, _view, _shader, _uniforms);
 
     auto& u = static_cast<DirectionalLight::Uniforms&>(_uniforms);
-    _shader.setUniformf(rs, u.direction, direction);
+    _shader.setUniformf(rs, u.direction, getViewDirection(_view));
+}
+
+void DirectionalLight::setupUniformBuffer(const View& _view, UniformBuffer& _buffer,
+                                          LightUniforms& _uniforms) {
+
+    Light::setupUniformBuffer(_view, _buffer, _uniforms);
+
+    auto& u = static_cast<DirectionalLight::Uniforms&>(_uniforms);
+    _buffer.setUniformf(u.direction, getViewDirection(_view));
 }
 
 std::string DirectionalLight::getClassBlock() {
@@ -19,6 +19,9 @@ public:
     virtual void setupProgram(RenderState& rs, const View& _view, ShaderProgram& _shader,
                               LightUniforms& _uniforms) override;
 
+    virtual void setupUniformBuffer(const View& _view, UniformBuffer& _buffer,
+                                    LightUniforms& _uniforms) override;
+
     struct Uniforms : public LightUniforms {
 
         Uniforms(const std::string& _name)
@@ -33,6 +36,9 @@ public:
 
 protected:
 
+    /*  Direction of the light in camera space */
+    glm::vec3 getViewDirection(const View& _view) const;
+
     /*  GLSL block code with structs and need functions for this light type */
     virtual std::string getClassBlock() override;
     virtual std::string getInstanceDefinesBlock() override;
@@ -1,5 +1,6 @@
 #include "scene/drawRule.h"
 
+#include "data/tileData.h"
 #include "log.h"
 #include "platform.h"
 #include "scene/scene.h"
@@ -11,6 +12,7 @@
 #include "util/hash.h"
 
 #include <algorithm>
+#include <cstring>
 
 namespace Tangram {
 
@@ -34,17 +36,29 @@ std::string DrawRuleData::toString() const {
     return str;
 }
 
+constexpr uint8_t DrawRule::no_param;
+
 DrawRule::DrawRule(const DrawRuleData& ruleData, const std::string& layerName, int layerDepth) :
     name(&ruleData.name),
     id(ruleData.id) {
 
+    std::memset(m_paramIndex, no_param, sizeof(m_paramIndex));
+
     for (const auto& param : ruleData.parameters) {
-        auto key = static_cast<uint8_t>(param.key);
-        active[key] = true;
-        params[key] = { &param, layerName.c_str(), layerDepth };
+        setParam(static_cast<uint8_t>(param.key), { &param, layerName.c_str(), layerDepth });
     }
 }
 
+void DrawRule::setParam(size_t _key, const Param& _param) {
+    if (m_paramIndex[_key] == no_param) {
+        m_paramIndex[_key] = m_params.size();
+        m_params.push_back(_param);
+    } else {
+        m_params[m_paramIndex[_key]] = _param;
+    }
+    active[_key] = true;
+}
+
 bool DrawRule::hasParameterSet(StyleParamKey _key) const {
     if (auto& param = findParameter(_key)) {
         auto key = static_cast<uint8_t>(param.key);
@@ -58,13 +72,12 @@ void DrawRule::merge(const DrawRuleData& ruleData, const std::string& layerName,
     for (const auto& paramNew : ruleData.parameters) {
 
         auto key = static_cast<uint8_t>(paramNew.key);
-        auto& param = params[key];
 
-        if (!active[key] || layerDepth > param.layerDepth) {
-            param = { &paramNew, layerName.c_str(), layerDepth };
-            active[key] = true;
+        if (!active[key] || layerDepth > param(key).layerDepth) {
+            setParam(key, { &paramNew, layerName.c_str(), layerDepth });
         }
     }
+    m_paramSetHashActive.reset();
 }
 
 bool DrawRule::contains(StyleParamKey _key) const {
@@ -76,7 +89,7 @@ const StyleParam& DrawRule::findParameter(StyleParamKey _key) const {
 
     auto key = static_cast<uint8_t>(_key);
     if (!active[key]) { return NONE; }
-    return *params[key].param;
+    return *param(key).param;
 }
 
 const std::string& DrawRule::getStyleName() const {
@@ -90,11 +103,27 @@ const std::string& DrawRule::getStyleName() const {
     }
 }
 
+int DrawRule::getStyleNameId() const {
+
+    const auto& style = findParameter(StyleParamKey::style);
+
+    if (style) {
+        return style.nameId;
+    } else {
+        return id;
+    }
+}
+
 size_t DrawRule::getParamSetHash() const {
+    // Evaluation may deactivate parameters of the merged rule
+    if (m_paramSetHashActive == active && active.any()) { return m_paramSetHash; }
+
     size_t seed = 0;
     for (size_t i = 0; i < StyleParamKeySize; i++) {
-        if (active[i]) { hash_combine(seed, params[i].layerName); }
+        if (active[i]) { hash_combine(seed, param(i).layerName); }
     }
+    m_paramSetHash = seed;
+    m_paramSetHashActive = active;
     return seed;
 }
 
@@ -102,6 +131,14 @@ void DrawRule::logGetError(StyleParamKey _expectedKey, const StyleParam& _param)
     LOGE("wrong type '%d'for StyleParam '%d'", _param.value.which(), _expectedKey);
 }
 
+// Limit for the number of cached matches per tile
+static constexpr size_t MAX_CACHE_ENTRIES = 512;
+
+void DrawRuleMergeSet::clearCache() {
+    m_cache.clear();
+    m_mergeCache.clear();
+}
+
 bool DrawRuleMergeSet::match(const Feature& _feature, const SceneLayer& _layer, StyleContext& _ctx) {
 
     _ctx.setFeature(_feature);
@@ -113,10 +150,58 @@ bool DrawRuleMergeSet::match(const Feature& _feature, const SceneLayer& _layer,
         return false;
     }
 
+    if (!_layer.matchIsCacheable()) {
+        return matchLayers(_feature, _layer, _ctx);
+    }
+
+    int geometryType = static_cast<int>(_feature.geometryType);
+
+    size_t hash = 0;
+    hash_combine(hash, &_layer);
+    hash_combine(hash, geometryType);
+
+    m_cacheValues.clear();
+    for (auto key : _layer.filterKeys()) {
+        const auto& value = _feature.props.get(key);
+        m_cacheValues.push_back(value);
+
+        hash_combine(hash, value.which());
+        if (value.is<double>()) {
+            hash_combine(hash, value.get<double>());
+        } else if (value.is<std::string>()) {
+            hash_combine(hash, value.get<std::string>());
+        }
+    }
+
+    auto it = m_cache.find(hash);
+    if (it != m_cache.end()) {
+        auto& entry = it->second;
+        if (entry.layer == &_layer && entry.geometryType == geometryType &&
+            entry.values == m_cacheValues) {
+            m_cacheHits++;
+            m_matchedRules = entry.rules;
+            return entry.matched;
+        }
+        // Hash collision: match without caching
+        return matchLayers(_feature, _layer, _ctx);
+    }
+
+    bool matched = matchLayers(_feature, _layer, _ctx);
+
+    if (m_cache.size() < MAX_CACHE_ENTRIES) {
+        m_cache.emplace(hash, CacheEntry{ &_layer, geometryType, m_cacheValues,
+                                          matched, m_matchedRules });
+    }
+    return matched;
+}
+
+bool DrawRuleMergeSet::matchLayers(const Feature& _feature, const SceneLayer& _layer, StyleContext& _ctx) {
+
     // If the first filter doesn't match, return immediately
-    if (!_layer.filter().eval(_feature, _ctx)) { return false; }
+    if (!_layer.filterProgram().eval(_feature, _ctx)) { return false; }
 
     m_queuedLayers.push_back({ &_layer, 1 });
+    m_layerChain.clear();
 
     // Iterate depth-first over the layer hierarchy
     while (!m_queuedLayers.empty()) {
@@ -126,8 +211,8 @@ bool DrawRuleMergeSet::match(const Feature& _feature, const SceneLayer& _layer,
         const auto depth = m_queuedLayers.back().depth;
         m_queuedLayers.pop_back();
 
-        // Merge rules from layer into accumulated set
-        mergeRules(layer, depth);
+        // Rules of the layer are merged in this order
+        m_layerChain.push_back({ &layer, depth });
 
         // Push each of the layer's matching sublayers onto the stack
         for (const auto& sublayer : layer.sublayers()) {
@@ -136,7 +221,7 @@ bool DrawRuleMergeSet::match(const Feature& _feature, const SceneLayer& _layer,
                 continue;
             }
 
-            if (sublayer.filter().eval(_feature, _ctx)) {
+            if (sublayer.filterProgram().eval(_feature, _ctx)) {
                 m_queuedLayers.push_back({ &sublayer, depth + 1 });
                 if (sublayer.exclusive()) {
                     break;
@@ -145,6 +230,29 @@ bool DrawRuleMergeSet::match(const Feature& _feature, const SceneLayer& _layer,
         }
     }
 
+    size_t hash = 0;
+    for (const auto& match : m_layerChain) {
+        hash_combine(hash, match.layer);
+        hash_combine(hash, match.depth);
+    }
+
+    auto it = m_mergeCache.find(hash);
+    if (it != m_mergeCache.end() && it->second.chain == m_layerChain) {
+        m_matchedRules = it->second.rules;
+        m_mergeCacheHits++;
+        return true;
+    }
+
+    // Merge rules from the matched layers into accumulated set
+    for (const auto& match : m_layerChain) {
+        mergeRules(*match.layer, match.depth);
+    }
+
+    if (it == m_mergeCache.end() && m_mergeCache.size() < MAX_CACHE_ENTRIES) {
+        for (const auto& rule : m_matchedRules) { rule.getParamSetHash(); }
+        m_mergeCache.emplace(hash, MergeEntry{ m_layerChain, m_matchedRules });
+    }
+
     return true;
 }
 
@@ -158,12 +266,9 @@ bool DrawRuleMergeSet::evaluateRuleForContext(DrawRule& rule, StyleContext& cont
     bool valid = true;
     for (size_t i = 0; i < StyleParamKeySize; ++i) {
 
-        if (!rule.active[i]) {
-            rule.params[i].param = nullptr;
-            continue;
-        }
+        if (!rule.active[i]) { continue; }
 
-        auto*& param = rule.params[i].param;
+        auto*& param = rule.param(i).param;
 
         // Evaluate JS functions and Stops
         if (param->function >= 0) {
@@ -1,8 +1,11 @@
 #pragma once
 
 #include "scene/styleParam.h"
+#include "util/smallVector.h"
 
 #include <bitset>
+#include <iterator>
+#include <unordered_map>
 #include <vector>
 #include <set>
 
@@ -54,22 +57,26 @@ struct DrawRuleData {
 
 struct DrawRule {
 
-    // Map of StypeParamKey => StyleParam pointer
-    // of the matched SceneLayer or the evaluated
-    // Function/Stops in DrawRuleMergeset.
-    struct {
+    // StyleParam pointer of the matched SceneLayer or the
+    // evaluated Function/Stops in DrawRuleMergeset.
+    struct Param {
         const StyleParam* param;
         // SceneLayer name and depth
         const char* layerName;
         int layerDepth;
-    } params[StyleParamKeySize];
+    };
 
     // A mask to indicate which parameters are set.
-    // 'active' MUST be checked before accessing 'params'
-    // This is cheaper to zero out 4 byte than
-    // 480 (on 32bit arch) or 980 byte for params array.
+    // 'active' MUST be checked before accessing 'param()'
     std::bitset<StyleParamKeySize> active = { 0 };
 
+    // Param of an active key, or of a key that was active before evaluation
+    Param& param(size_t _key) { return m_params[m_paramIndex[_key]]; }
+    const Param& param(size_t _key) const { return m_params[m_paramIndex[_key]]; }
+
+    // Set the param of _key and make it active
+    void setParam(size_t _key, const Param& _param);
+
 
     // draw-style name and id
     const std::string* name = nullptr;
@@ -86,24 +93,35 @@ struct DrawRule {
 
     const std::string& getStyleName() const;
 
+    // Draw rule name ID of getStyleName(), or -1 when the style name was not
+    // known when the scene was loaded
+    int getStyleNameId() const;
+
+    // Hash of the layers that provide the parameters, computed once per
+    // merged rule and set of active parameters
     size_t getParamSetHash() const;
 
     bool hasParameterSet(StyleParamKey _key) const;
 
     const StyleParam& findParameter(StyleParamKey _key) const;
 
+    // The value of each key has one type, so the value is read by checking
+    // the type index of the variant rather than by visiting it
     template<typename T>
     bool get(StyleParamKey _key, T& _value) const {
-        if (auto& param = findParameter(_key)) {
-            return StyleParam::Value::visit(param.value, StyleParam::visitor<T>{ _value });
+        auto& param = findParameter(_key);
+        if (param.value.is<T>()) {
+            _value = param.value.get<T>();
+            return true;
         }
         return false;
     }
 
     template<typename T>
     const T* get(StyleParamKey _key) const {
-        if (auto& param = findParameter(_key)) {
-            return StyleParam::Value::visit(param.value, StyleParam::visitor_ptr<T>{});
+        auto& param = findParameter(_key);
+        if (param.value.is<T>()) {
+            return &param.value.get<T>();
         }
         return nullptr;
     }
@@ -111,6 +129,17 @@ struct DrawRule {
 private:
     void logGetError(StyleParamKey _expectedKey, const StyleParam& _param) const;
 
+    static constexpr uint8_t no_param = 0xff;
+
+    // Rules are copied for each matched feature, so only the params of the
+    // keys that have been set are stored, in the order they were set, with
+    // the index of each key's param in m_paramIndex.
+    SmallVector<Param, 16> m_params;
+    uint8_t m_paramIndex[StyleParamKeySize];
+
+    mutable size_t m_paramSetHash = 0;
+    mutable std::bitset<StyleParamKeySize> m_paramSetHashActive = { 0 };
+
 };
 
 class DrawRuleMergeSet {
@@ -126,15 +155,60 @@ public:
 
     auto& matchedRules() { return m_matchedRules; }
 
+    // Matches are cached per SceneLayer by the values of the properties that its
+    // filters reference and the geometry type. The cache must be cleared when
+    // the zoom changes, i.e. for each tile.
+    void clearCache();
+
+    // Number of match() calls that were answered from the cache
+    size_t cacheHits() const { return m_cacheHits; }
+
+    // Number of matches that reused the merged rules of an earlier match of the same layers
+    size_t mergeCacheHits() const { return m_mergeCacheHits; }
+
+    // Whether _param is a dynamically evaluated parameter owned by this DrawRuleMergeSet.
+    // It is only valid until the next rule is evaluated.
+    bool isEvaluated(const StyleParam* _param) const {
+        return _param >= std::begin(m_evaluated) && _param < std::end(m_evaluated);
+    }
+
 private:
     struct LayerMatch {
         const SceneLayer* layer;
         int depth;
+        bool operator==(const LayerMatch& _other) const {
+            return layer == _other.layer && depth == _other.depth;
+        }
+    };
+
+    struct CacheEntry {
+        const SceneLayer* layer;
+        int geometryType;
+        std::vector<Value> values;
+        bool matched;
+        std::vector<DrawRule> rules;
     };
 
-    // Reusable containers 'matchedRules' and 'queuedLayers'
+    bool matchLayers(const Feature& feature, const SceneLayer& layer, StyleContext& context);
+
+    // Reusable containers 'matchedRules', 'queuedLayers' and 'layerChain'
     std::vector<DrawRule> m_matchedRules;
     std::vector<LayerMatch> m_queuedLayers;
+    std::vector<LayerMatch> m_layerChain;
+
+    // Merged rules by the chain of matched layers. Features of different
+    // layers or with function filters often match the same sublayers.
+    struct MergeEntry {
+        std::vector<LayerMatch> chain;
+        std::vector<DrawRule> rules;
+    };
+    std::unordered_map<size_t, MergeEntry> m_mergeCache;
+    size_t m_mergeCacheHits = 0;
+
+    // Cached matches by hash of CacheEntry layer, geometryType and values
+    std::unordered_map<size_t, CacheEntry> m_cache;
+    std::vector<Value> m_cacheValues;
+    size_t m_cacheHits = 0;
 
     // Container for dynamically-evaluated parameters
     StyleParam m_evaluated[StyleParamKeySize];
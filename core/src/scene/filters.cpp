@@ -4,6 +4,7 @@
 #include "platform.h"
 #include "scene/styleContext.h"
 
+#include <algorithm>
 #include <cmath>
 
 namespace Tangram {
@@ -284,15 +285,16 @@ struct number_matcher {
 
 struct match_equal_set {
     using result_type = bool;
-    const std::vector<Value>& values;
+    const Value* begin;
+    const Value* end;
 
     template <typename T>
     bool operator()(T) const { return false; }
 
     bool operator()(const double& num) const {
         number_matcher m{num};
-        for (const auto& v : values) {
-            if (Value::visit(v, m)) {
+        for (auto v = begin; v != end; ++v) {
+            if (Value::visit(*v, m)) {
                 return true;
             }
         }
@@ -301,8 +303,8 @@ struct match_equal_set {
     bool operator()(const std::string& str) const {
         string_matcher m{str};
 
-        for (const auto& v : values) {
-            if (Value::visit(v, m)) {
+        for (auto v = begin; v != end; ++v) {
+            if (Value::visit(*v, m)) {
                 return true;
             }
         }
@@ -375,7 +377,8 @@ struct matcher {
             ? props.get(f.key)
             : ctx.getKeyword(f.keyword);
 
-        return Value::visit(value, match_equal_set{f.values});
+        return Value::visit(value, match_equal_set{f.values.data(),
+                                                   f.values.data() + f.values.size()});
     }
     bool operator() (const Filter::Equality& f) const {
         auto& value = (f.keyword == FilterKeyword::undefined)
@@ -403,4 +406,160 @@ bool Filter::eval(const Feature& feat, StyleContext& ctx) const {
     return Data::visit(data, matcher(feat, ctx));
 }
 
+constexpr int32_t FilterProgram::accept;
+constexpr int32_t FilterProgram::reject;
+
+FilterProgram::FilterProgram(const Filter& _filter) {
+    m_entry = compile(_filter, accept, reject);
+}
+
+Properties::KeyId FilterProgram::addKey(const std::string& _key) {
+    auto keyId = Properties::internKey(_key);
+    if (std::find(m_keyIds.begin(), m_keyIds.end(), keyId) == m_keyIds.end()) {
+        m_keys.push_back(_key);
+        m_keyIds.push_back(keyId);
+    }
+    return keyId;
+}
+
+int32_t FilterProgram::compile(const Filter& _filter, int32_t _onTrue, int32_t _onFalse) {
+
+    const auto& data = _filter.data;
+    const auto& operands = _filter.operands();
+
+    // Compile operands back to front, so that each one can jump to the
+    // entry point of the following operand.
+    switch (data.which()) {
+    case Filter::Data::type<Filter::OperatorAll>::value: {
+        int32_t entry = _onTrue;
+        for (auto it = operands.rbegin(); it != operands.rend(); ++it) {
+            entry = compile(*it, entry, _onFalse);
+        }
+        return entry;
+    }
+    case Filter::Data::type<Filter::OperatorAny>::value: {
+        int32_t entry = _onFalse;
+        for (auto it = operands.rbegin(); it != operands.rend(); ++it) {
+            entry = compile(*it, _onTrue, entry);
+        }
+        return entry;
+    }
+    case Filter::Data::type<Filter::OperatorNone>::value: {
+        int32_t entry = _onTrue;
+        for (auto it = operands.rbegin(); it != operands.rend(); ++it) {
+            entry = compile(*it, _onFalse, entry);
+        }
+        return entry;
+    }
+    case Filter::Data::type<none_type>::value:
+        return _onTrue;
+
+    default:
+        break;
+    }
+
+    Instruction ins{};
+    ins.keyword = FilterKeyword::undefined;
+    ins.onTrue = _onTrue;
+    ins.onFalse = _onFalse;
+
+    switch (data.which()) {
+    case Filter::Data::type<Filter::Existence>::value: {
+        auto& f = data.get<Filter::Existence>();
+        ins.op = Op::existence;
+        ins.key = addKey(f.key);
+        if (!f.exists) { std::swap(ins.onTrue, ins.onFalse); }
+        break;
+    }
+    case Filter::Data::type<Filter::EqualitySet>::value: {
+        auto& f = data.get<Filter::EqualitySet>();
+        ins.op = Op::equality_set;
+        ins.keyword = f.keyword;
+        ins.key = addKey(f.key);
+        ins.value = m_values.size();
+        ins.numValues = f.values.size();
+        m_values.insert(m_values.end(), f.values.begin(), f.values.end());
+        break;
+    }
+    case Filter::Data::type<Filter::Equality>::value: {
+        auto& f = data.get<Filter::Equality>();
+        ins.op = Op::equality;
+        ins.keyword = f.keyword;
+        ins.key = addKey(f.key);
+        ins.value = m_values.size();
+        ins.numValues = 1;
+        m_values.push_back(f.value);
+        break;
+    }
+    case Filter::Data::type<Filter::Range>::value: {
+        auto& f = data.get<Filter::Range>();
+        ins.op = Op::range;
+        ins.keyword = f.keyword;
+        ins.key = addKey(f.key);
+        ins.min = f.min;
+        ins.max = f.max;
+        ins.hasPixelArea = f.hasPixelArea;
+        break;
+    }
+    case Filter::Data::type<Filter::Function>::value:
+        ins.op = Op::function;
+        ins.value = data.get<Filter::Function>().id;
+        m_functions.push_back(ins.value);
+        break;
+    default:
+        return _onTrue;
+    }
+
+    m_instructions.push_back(ins);
+    return m_instructions.size() - 1;
+}
+
+bool FilterProgram::eval(const Feature& _feature, StyleContext& _ctx) const {
+
+    const auto& props = _feature.props;
+    int32_t pc = m_entry;
+
+    while (pc >= 0) {
+        const auto& ins = m_instructions[pc];
+        bool result = false;
+
+        switch (ins.op) {
+        case Op::existence:
+            result = props.contains(ins.key);
+            break;
+        case Op::equality: {
+            auto& value = (ins.keyword == FilterKeyword::undefined)
+                ? props.get(ins.key)
+                : _ctx.getKeyword(ins.keyword);
+            result = Value::visit(value, match_equal{m_values[ins.value]});
+            break;
+        }
+        case Op::equality_set: {
+            auto& value = (ins.keyword == FilterKeyword::undefined)
+                ? props.get(ins.key)
+                : _ctx.getKeyword(ins.keyword);
+            const Value* values = m_values.data() + ins.value;
+            result = Value::visit(value, match_equal_set{values, values + ins.numValues});
+            break;
+        }
+        case Op::range: {
+            auto scale = (ins.hasPixelArea) ? _ctx.getPixelAreaScale() : 1.f;
+            auto& value = (ins.keyword == FilterKeyword::undefined)
+                ? props.get(ins.key)
+                : _ctx.getKeyword(ins.keyword);
+            result = value.is<double>() &&
+                value.get<double>() >= ins.min * scale &&
+                value.get<double>() < ins.max * scale;
+            break;
+        }
+        case Op::function:
+            result = _ctx.evalFilter(ins.value);
+            break;
+        }
+
+        pc = result ? ins.onTrue : ins.onFalse;
+    }
+    return pc == accept;
+}
+
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "data/properties.h"
 #include "util/variant.h"
 
 #include <memory>
@@ -117,4 +118,75 @@ struct Filter {
     bool isValid() const { return !data.is<none_type>(); }
     operator bool() const { return isValid(); }
 };
+
+// FilterProgram is a Filter lowered into a flat array of tests.
+//
+// Each test jumps to the next test depending on its result, or ends the
+// evaluation by accepting or rejecting the feature. Operators become jumps, so
+// evaluation needs no recursion and stops as soon as the result is known.
+// Tests keep the filterCost ordering of the operands of the Filter. Property
+// keys are interned when the program is compiled.
+class FilterProgram {
+public:
+    FilterProgram() = default;
+    explicit FilterProgram(const Filter& _filter);
+
+    // Gives the same result as Filter::eval for the compiled Filter
+    bool eval(const Feature& _feature, StyleContext& _ctx) const;
+
+    size_t numInstructions() const { return m_instructions.size(); }
+
+    // Property keys used by the program
+    const std::vector<std::string>& keys() const { return m_keys; }
+    const std::vector<Properties::KeyId>& keyIds() const { return m_keyIds; }
+
+    // Whether the program calls scene functions
+    bool hasFunctions() const { return !m_functions.empty(); }
+
+    // IDs of the scene functions called by the program
+    const std::vector<uint32_t>& functions() const { return m_functions; }
+
+private:
+
+    enum class Op : uint8_t {
+        equality,
+        equality_set,
+        range,
+        existence,
+        function,
+    };
+
+    // Jump targets which end the evaluation
+    static constexpr int32_t accept = -1;
+    static constexpr int32_t reject = -2;
+
+    struct Instruction {
+        Op op;
+        FilterKeyword keyword;
+        bool hasPixelArea;
+        Properties::KeyId key;
+        // Index of the first value in m_values, or the function id
+        uint32_t value;
+        uint32_t numValues;
+        float min;
+        float max;
+        // Next instruction for either result of the test
+        int32_t onTrue;
+        int32_t onFalse;
+    };
+
+    // Emit instructions for _filter and return its entry point
+    int32_t compile(const Filter& _filter, int32_t _onTrue, int32_t _onFalse);
+
+    // Returns the interned _key and adds it to m_keys
+    Properties::KeyId addKey(const std::string& _key);
+
+    std::vector<Instruction> m_instructions;
+    std::vector<std::string> m_keys;
+    std::vector<Properties::KeyId> m_keyIds;
+    std::vector<Value> m_values;
+    int32_t m_entry = accept;
+    std::vector<uint32_t> m_functions;
+};
+
 }
@@ -2,7 +2,8 @@
 
 #include "log.h"
 #include "platform.h"
-#include "util/asyncWorker.h"
+#include "scene/sceneBinary.h"
+#include "util/threadPool.h"
 #include "util/yamlUtil.h"
 #include "util/zipArchive.h"
 
@@ -16,6 +17,27 @@ using YAML::NodeType;
 
 namespace Tangram {
 
+namespace {
+
+// Resolves URLs against one base, once for each distinct URL string. Scenes
+// tend to refer to the same textures and fonts many times.
+struct UrlResolver {
+    const Url& base;
+    std::unordered_map<std::string, std::string> resolved;
+
+    explicit UrlResolver(const Url& _base) : base(_base) {}
+
+    const std::string& operator()(const std::string& _url) {
+        auto it = resolved.find(_url);
+        if (it == resolved.end()) {
+            it = resolved.emplace(_url, base.resolve(Url(_url)).string()).first;
+        }
+        return it->second;
+    }
+};
+
+}
+
 Importer::Importer() {}
 Importer::~Importer() {}
 
@@ -25,7 +47,7 @@ Node Importer::loadSceneData(Platform& _platform, const Url& _sceneUrl, const st
 
     if (!_sceneYaml.empty()) {
         // Load scene from yaml string.
-        addSceneYaml(_sceneUrl, _sceneYaml.data(), _sceneYaml.length());
+        addSceneNode(_sceneUrl, parseSceneYaml(_sceneUrl, _sceneYaml.data(), _sceneYaml.length()));
     } else {
         // Load scene from yaml file.
         m_sceneQueue.push_back(_sceneUrl);
@@ -34,6 +56,8 @@ Node Importer::loadSceneData(Platform& _platform, const Url& _sceneUrl, const st
     std::atomic_uint activeDownloads(0);
     std::condition_variable condition;
 
+    std::vector<Url> urlsToImport;
+
     while (true) {
         {
             std::unique_lock<std::mutex> lock(m_sceneMutex);
@@ -44,40 +68,57 @@ Node Importer::loadSceneData(Platform& _platform, const Url& _sceneUrl, const st
                 }
                 condition.wait(lock);
             }
-            
+
             if (m_sceneQueue.empty() || m_canceled) {
                 continue;
             }
 
-            nextUrlToImport = m_sceneQueue.back();
-            m_sceneQueue.pop_back();
+            // Start requests for all imports found so far at once.
+            urlsToImport.swap(m_sceneQueue);
 
-            // Mark Url as going-to-be-imported to prevent duplicate work.
-            m_sceneNodes.emplace(nextUrlToImport, SceneNode{});
+            for (auto& url : urlsToImport) {
+                // Mark Url as going-to-be-imported to prevent duplicate work.
+                m_sceneNodes.emplace(url, SceneNode{});
+            }
         }
 
-        auto cb = [&, nextUrlToImport](UrlResponse&& response) {
-            std::unique_lock<std::mutex> lock(m_sceneMutex);
-            if (response.error) {
-                LOGE("Unable to retrieve '%s': %s", nextUrlToImport.string().c_str(),
-                     response.error);
+        for (auto& nextUrlToImport : urlsToImport) {
+
+            auto cb = [&, nextUrlToImport](UrlResponse&& response) {
+                if (response.error) {
+                    LOGE("Unable to retrieve '%s': %s", nextUrlToImport.string().c_str(),
+                         response.error);
+                    std::unique_lock<std::mutex> lock(m_sceneMutex);
+                    activeDownloads--;
+                    condition.notify_one();
+                    return;
+                }
+                // Parse while other imports are still downloading, only
+                // adding the results needs the lock.
+                std::shared_ptr<ZipArchive> zipArchive;
+                SceneNode sceneNode = parseSceneData(nextUrlToImport, std::move(response.content),
+                                                     zipArchive);
+
+                std::unique_lock<std::mutex> lock(m_sceneMutex);
+                if (zipArchive) {
+                    m_zipArchives.emplace(nextUrlToImport, zipArchive);
+                }
+                addSceneNode(nextUrlToImport, std::move(sceneNode));
+                activeDownloads--;
+                condition.notify_one();
+            };
+
+            activeDownloads++;
+
+            if (nextUrlToImport.scheme() == "zip") {
+                readFromZip(nextUrlToImport, cb);
             } else {
-                LOGD("skyway nextUrlToImport = %s",nextUrlToImport.data().c_str());
-                addSceneData(nextUrlToImport, std::move(response.content));
+                auto handle = _platform.startUrlRequest(nextUrlToImport, cb);
+                std::unique_lock<std::mutex> lock(m_sceneMutex);
+                m_urlRequests.push_back(handle);
             }
-            activeDownloads--;
-            condition.notify_one();
-        };
-        
-        activeDownloads++;
-
-        if (nextUrlToImport.scheme() == "zip") {
-            readFromZip(nextUrlToImport, cb);
-        } else {
-            auto handle = _platform.startUrlRequest(nextUrlToImport, cb);
-            std::unique_lock<std::mutex> lock(m_sceneMutex);
-            m_urlRequests.push_back(handle);
         }
+        urlsToImport.clear();
     }
 
     if (m_canceled) { return Node(); }
@@ -94,11 +135,12 @@ Node Importer::loadSceneData(Platform& _platform, const Url& _sceneUrl, const st
         if (isZipArchiveUrl(sceneUrl)) {
             sceneUrl = getBaseUrlForZipArchive(sceneUrl);
         }
+        UrlResolver resolve(sceneUrl);
         for (auto& node : sceneNode.second.pendingUrlNodes) {
             // If the node does not contain a named texture in the final scene, treat it as a URL relative to the scene
             // file where it was originally encountered.
             if (!textures[node.Scalar()]) {
-                node = sceneUrl.resolve(Url(node.Scalar())).string();
+                node = resolve(node.Scalar());
             }
         }
     }
@@ -108,6 +150,36 @@ Node Importer::loadSceneData(Platform& _platform, const Url& _sceneUrl, const st
     return root;
 }
 
+Node Importer::loadSceneBinary(Platform& _platform, const Url& _binaryUrl, const Url& _sceneUrl,
+                               uint64_t _sceneHash) {
+
+    std::vector<char> data;
+    bool done = false;
+    std::condition_variable condition;
+
+    auto cb = [&](UrlResponse&& response) {
+        std::unique_lock<std::mutex> lock(m_sceneMutex);
+        if (response.error) {
+            LOGW("Unable to retrieve precompiled scene '%s': %s", _binaryUrl.string().c_str(),
+                 response.error);
+        } else {
+            data = std::move(response.content);
+        }
+        done = true;
+        condition.notify_one();
+    };
+
+    auto handle = _platform.startUrlRequest(_binaryUrl, cb);
+
+    std::unique_lock<std::mutex> lock(m_sceneMutex);
+    m_urlRequests.push_back(handle);
+    condition.wait(lock, [&]{ return done; });
+
+    if (m_canceled || data.empty()) { return Node(NodeType::Undefined); }
+
+    return SceneBinary::read(data, _sceneHash, _sceneUrl);
+}
+
 void Importer::cancelLoading(Platform& _platform) {
     std::unique_lock<std::mutex> lock(m_sceneMutex);
     m_canceled = true;
@@ -116,17 +188,17 @@ void Importer::cancelLoading(Platform& _platform) {
     }
 }
 
-void Importer::addSceneData(const Url& sceneUrl, std::vector<char>&& sceneData) {
+Importer::SceneNode Importer::parseSceneData(const Url& sceneUrl, std::vector<char>&& sceneData,
+                                             std::shared_ptr<ZipArchive>& zipArchive) {
     LOGD("Process: '%s'", sceneUrl.string().c_str());
 
     if (!isZipArchiveUrl(sceneUrl)) {
-        addSceneYaml(sceneUrl, sceneData.data(), sceneData.size());
-        return;
+        return parseSceneYaml(sceneUrl, sceneData.data(), sceneData.size());
     }
 
     // We're loading a scene from a zip archive
     // First, create an archive from the data.
-    auto zipArchive = std::make_shared<ZipArchive>();
+    zipArchive = std::make_shared<ZipArchive>();
     zipArchive->loadFromMemory(std::move(sceneData));
 
     // Find the "base" scene file in the archive entries.
@@ -135,35 +207,43 @@ void Importer::addSceneData(const Url& sceneUrl, std::vector<char>&& sceneData)
         // The "base" scene file must have extension "yaml" or "yml" and be
         // at the root directory of the archive (i.e. no '/' in path).
         if ((ext == "yaml" || ext == "yml") && entry.path.find('/') == std::string::npos) {
-            // Found the base, now extract the contents to the scene string.
+            // Found the base, a stored scene file is parsed in place.
+            if (auto data = zipArchive->entryData(&entry)) {
+                return parseSceneYaml(sceneUrl, data, entry.uncompressedSize);
+            }
+            // Otherwise extract the contents to the scene string.
             std::vector<char> yaml;
             yaml.resize(entry.uncompressedSize);
 
-            zipArchive->decompressEntry(&entry, &yaml[0]);
+            if (!zipArchive->decompressEntry(&entry, yaml.data())) {
+                LOGE("Unable to decompress scene file '%s'", entry.path.c_str());
+                return SceneNode{};
+            }
 
-            addSceneYaml(sceneUrl, yaml.data(), yaml.size());
-            break;
+            return parseSceneYaml(sceneUrl, yaml.data(), yaml.size());
         }
     }
-
-    m_zipArchives.emplace(sceneUrl, zipArchive);
+    return SceneNode{};
 }
 
 UrlRequestHandle Importer::readFromZip(const Url& url, UrlCallback callback) {
 
-    if (!m_zipWorker) {
-        m_zipWorker = std::make_unique<AsyncWorker>();
-        m_zipWorker->waitForCompletion();
+    // URL for a file in a zip archive, get the encoded source URL.
+    auto source = Importer::getArchiveUrlForZipEntry(url);
+    // Search for the source URL in our archive map.
+    std::shared_ptr<ZipArchive> archive;
+    {
+        // Archives are added from download callbacks while scene imports load
+        std::lock_guard<std::mutex> lock(m_sceneMutex);
+        auto it = m_zipArchives.find(source);
+        if (it != m_zipArchives.end()) { archive = it->second; }
     }
 
-    m_zipWorker->enqueue([=](){
+    // Entries are decompressed in parallel, the job holds on to the archive
+    // and does not access the Importer.
+    ThreadPool::shared().enqueue(ThreadPool::Priority::io, [=](){
         UrlResponse response;
-        // URL for a file in a zip archive, get the encoded source URL.
-        auto source = Importer::getArchiveUrlForZipEntry(url);
-        // Search for the source URL in our archive map.
-        auto it = m_zipArchives.find(source);
-        if (it != m_zipArchives.end()) {
-            auto& archive = it->second;
+        if (archive) {
             // Found the archive! Now create a response for the request.
             auto zipEntryPath = url.path().substr(1);
             auto entry = archive->findEntry(zipEntryPath);
@@ -184,20 +264,20 @@ UrlRequestHandle Importer::readFromZip(const Url& url, UrlCallback callback) {
     return 0;
 }
 
-void Importer::addSceneYaml(const Url& sceneUrl, const char* sceneYaml, size_t length) {
+Importer::SceneNode Importer::parseSceneYaml(const Url& sceneUrl, const char* sceneYaml, size_t length) {
 
-    auto& sceneNode = m_sceneNodes[sceneUrl];
+    SceneNode sceneNode;
 
     try {
         sceneNode.yaml = YamlUtil::loadNoCopy(sceneYaml, length);
     } catch (const YAML::ParserException& e) {
         LOGE("Parsing scene config '%s'", e.what());
-        return;
+        return sceneNode;
     }
 
     if (!sceneNode.yaml.IsDefined() || !sceneNode.yaml.IsMap()) {
         LOGE("Scene is not a valid YAML map: %s", sceneUrl.string().c_str());
-        return;
+        return sceneNode;
     }
 
     sceneNode.imports = getResolvedImportUrls(sceneNode.yaml, sceneUrl);
@@ -207,12 +287,20 @@ void Importer::addSceneYaml(const Url& sceneUrl, const char* sceneYaml, size_t l
     // Remove 'import' values so they don't get merged.
     sceneNode.yaml.remove("import");
 
+    return sceneNode;
+}
+
+void Importer::addSceneNode(const Url& sceneUrl, SceneNode&& sceneNode) {
+
     for (const auto& url : sceneNode.imports) {
         // Check if this scene URL has been (or is going to be) imported already
-        if (m_sceneNodes.find(url) == m_sceneNodes.end()) {
+        if (m_sceneNodes.find(url) == m_sceneNodes.end() &&
+            std::find(m_sceneQueue.begin(), m_sceneQueue.end(), url) == m_sceneQueue.end()) {
             m_sceneQueue.push_back(url);
         }
     }
+
+    m_sceneNodes[sceneUrl] = std::move(sceneNode);
 }
 
 std::vector<Url> Importer::getResolvedImportUrls(const Node& sceneNode, const Url& baseUrl) {
@@ -286,11 +374,27 @@ void Importer::mergeMapFields(Node& target, const Node& import) {
         target = import;
 
     } else {
+        // Index the entries of target once: operator[] searches the map
+        // linearly and converts every key it compares.
+        std::unordered_map<std::string, Node> entries;
+        entries.reserve(target.size());
+        for (const auto& entry : target) {
+            entries.emplace(entry.first.Scalar(), entry.second);
+        }
+
         for (const auto& entry : import) {
             const auto& key = entry.first.Scalar();
             const auto& source = entry.second;
-            auto dest = target[key];
-            mergeMapFields(dest, source);
+            auto it = entries.find(key);
+            if (it != entries.end()) {
+                mergeMapFields(it->second, source);
+            } else {
+                // New field, referencing the imported node like assignment does
+                Node dest;
+                dest = source;
+                target.force_insert(key, dest);
+                entries.emplace(key, dest);
+            }
         }
     }
 }
@@ -397,6 +501,7 @@ void Importer::resolveSceneUrls(Node& root, const Url& baseUrl) {
     if (isZipArchiveUrl(baseUrl)) {
         base = getBaseUrlForZipArchive(baseUrl);
     }
+    UrlResolver resolve(base);
 
     // Resolve global texture URLs.
 
@@ -406,7 +511,7 @@ void Importer::resolveSceneUrls(Node& root, const Url& baseUrl) {
         for (auto texture : textures) {
             if (Node textureUrlNode = texture.second["url"]) {
                 if (nodeIsPotentialUrl(textureUrlNode)) {
-                    textureUrlNode = base.resolve(Url(textureUrlNode.Scalar())).string();
+                    textureUrlNode = resolve(textureUrlNode.Scalar());
                 }
             }
         }
@@ -419,28 +524,31 @@ void Importer::resolveSceneUrls(Node& root, const Url& baseUrl) {
             if (!source.second.IsMap()) { continue; }
             if (Node sourceUrl = source.second["url"]) {
                 if (nodeIsPotentialUrl(sourceUrl)) {
-                    sourceUrl = base.resolve(Url(sourceUrl.Scalar())).string();
+                    sourceUrl = resolve(sourceUrl.Scalar());
                 }
             }
         }
     }
 
-    // Resolve font URLs.
+    // Resolve font URLs and URLs of pre-baked glyph fields.
+
+    auto resolveFontUrls = [&](Node fontNode) {
+        for (const char* key : { "url", "fields" }) {
+            auto urlNode = fontNode[key];
+            if (nodeIsPotentialUrl(urlNode)) {
+                urlNode = resolve(urlNode.Scalar());
+            }
+        }
+    };
 
     if (Node fonts = root["fonts"]) {
         if (fonts.IsMap()) {
             for (const auto& font : fonts) {
                 if (font.second.IsMap()) {
-                    auto urlNode = font.second["url"];
-                    if (nodeIsPotentialUrl(urlNode)) {
-                        urlNode = base.resolve(Url(urlNode.Scalar())).string();
-                    }
+                    resolveFontUrls(font.second);
                 } else if (font.second.IsSequence()) {
                     for (auto& fontNode : font.second) {
-                        auto urlNode = fontNode["url"];
-                        if (nodeIsPotentialUrl(urlNode)) {
-                            urlNode = base.resolve(Url(urlNode.Scalar())).string();
-                        }
+                        resolveFontUrls(fontNode);
                     }
                 }
             }
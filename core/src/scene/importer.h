@@ -14,7 +14,6 @@
 
 namespace Tangram {
 
-class AsyncWorker;
 class SceneOptions;
 class ZipArchive;
 class Url;
@@ -30,6 +29,11 @@ public:
     // Loads the main scene with deep merging dependent imported scenes.
     Node loadSceneData(Platform& platform, const Url& sceneUrl, const std::string& sceneYaml = "");
 
+    // Loads a scene precompiled with SceneBinary. Returns an undefined node
+    // when it is missing or was not compiled for _sceneHash.
+    Node loadSceneBinary(Platform& platform, const Url& binaryUrl, const Url& sceneUrl,
+                         uint64_t sceneHash);
+
     void cancelLoading(Platform& _platform);
 
     static bool isZipArchiveUrl(const Url& url);
@@ -59,11 +63,27 @@ public:
 
 protected:
 
-    // Process and store data for an imported scene from a vector of bytes.
-    void addSceneData(const Url& sceneUrl, std::vector<char>&& sceneContent);
+    // Scene files must be parsed into YAML nodes to find further imports.
+    // The parsed scenes are stored in a map with their URLs to be merged once
+    // all imports are found and parsed.
+    struct SceneNode {
+        Node yaml{};
+        std::vector<Url> imports;
+        std::vector<Node> pendingUrlNodes;
+    };
+
+    // Parse an imported scene from a vector of bytes. Sets _zipArchive when
+    // the data is a zip archive. This does not access Importer state, so
+    // downloaded scenes are parsed in parallel.
+    SceneNode parseSceneData(const Url& sceneUrl, std::vector<char>&& sceneContent,
+                             std::shared_ptr<ZipArchive>& zipArchive);
 
-    // Process and store data for an imported scene from a string of YAML.
-    void addSceneYaml(const Url& sceneUrl, const char* sceneYaml, size_t length);
+    // Parse an imported scene from a string of YAML.
+    SceneNode parseSceneYaml(const Url& sceneUrl, const char* sceneYaml, size_t length);
+
+    // Store a parsed scene and queue its imports that were not requested yet.
+    // Called with m_sceneMutex locked.
+    void addSceneNode(const Url& sceneUrl, SceneNode&& sceneNode);
 
     // Get the sequence of scene names that are designated to be imported into the
     // input scene node by its 'import' fields.
@@ -75,14 +95,6 @@ protected:
     void mergeMapFields(Node& target, const Node& import);
 
 
-    // Scene files must be parsed into YAML nodes to find further imports.
-    // The parsed scenes are stored in a map with their URLs to be merged once
-    // all imports are found and parsed.
-    struct SceneNode {
-        Node yaml{};
-        std::vector<Url> imports;
-        std::vector<Node> pendingUrlNodes;
-    };
     std::unordered_map<Url, SceneNode> m_sceneNodes = {};
 
     std::vector<Url> m_sceneQueue = {};
@@ -90,7 +102,6 @@ protected:
     // Container for any zip archives needed for the scene. For each entry, the
     // key is the original URL from which the zip archive was retrieved and the
     // value is a ZipArchive initialized with the compressed archive data.
-    std::unique_ptr<AsyncWorker> m_zipWorker;
     std::unordered_map<Url, std::shared_ptr<ZipArchive>> m_zipArchives;
 
     // Keep track of UrlRequests for cancellation. NB we don't care to remove
@@ -1,10 +1,15 @@
 #include "scene/light.h"
 
 #include "gl/shaderProgram.h"
+#include "gl/uniformBuffer.h"
+#include "lightCulling_glsl.h"
 #include "lights_glsl.h"
 #include "platform.h"
+#include "scene/lightCulling.h"
+#include "scene/pointLight.h"
 #include "util/floatFormatter.h"
 
+#include <algorithm>
 #include <set>
 #include <sstream>
 
@@ -53,6 +58,12 @@ void Light::setupProgram(RenderState& rs, const View& _view, ShaderProgram& _sha
     _shader.setUniformf(rs, _uniforms.specular, m_specular);
 }
 
+void Light::setupUniformBuffer(const View& _view, UniformBuffer& _buffer, LightUniforms& _uniforms) {
+    _buffer.setUniformf(_uniforms.ambient, m_ambient);
+    _buffer.setUniformf(_uniforms.diffuse, m_diffuse);
+    _buffer.setUniformf(_uniforms.specular, m_specular);
+}
+
 auto Light::assembleLights(const std::vector<std::unique_ptr<Light>>& _lights) ->
     std::map<std::string, std::string> {
 
@@ -77,6 +88,36 @@ auto Light::assembleLights(const std::vector<std::unique_ptr<Light>>& _lights) -
         lighting << '\n' << string;
     }
 
+    // Uniforms of the dynamic lights, which styles with uniform blocks read from a buffer
+    std::stringstream lightUniforms;
+    for (auto& light : _lights) {
+        if (light->isDynamic()) {
+            lightUniforms << "    " << light->getTypeName() << " " << light->getUniformName() << ";\n";
+        }
+    }
+    if (lightUniforms.tellp() > 0) {
+        lighting << "\n#ifdef TANGRAM_UNIFORM_BLOCKS\n"
+                 << "layout(std140) uniform " << UniformBuffer::LIGHTS_BLOCK << " {\n"
+                 << lightUniforms.str()
+                 << "};\n"
+                 << "#else\n";
+        for (auto& light : _lights) {
+            if (light->isDynamic()) {
+                lighting << "uniform " << light->getTypeName() << " " << light->getUniformName() << ";\n";
+            }
+        }
+        lighting << "#endif\n";
+    }
+
+    // Lights with an outer radius are only computed in the screen tiles they reach
+    auto culledLights = LightCulling::cullableLights(_lights);
+    if (!culledLights.empty()) {
+        size_t texels = (culledLights.size() + 31) / 32;
+        lightDefines.insert("#define TANGRAM_LIGHT_CULLING\n#define TANGRAM_LIGHT_TILE_TEXELS " +
+                            ff::to_string(float(texels)) + "\n");
+        lighting << '\n' << lightCulling_glsl;
+    }
+
     std::stringstream definesBlock;
     for (auto& string: lightDefines) {
         definesBlock << '\n' << string;
@@ -97,8 +138,17 @@ auto Light::assembleLights(const std::vector<std::unique_ptr<Light>>& _lights) -
 
     // The main lighting functions each contain a tag where all light instances should be computed;
     std::stringstream lights;
+    if (!culledLights.empty()) {
+        lights << '\n' << LightCulling::maskBlock(culledLights.size());
+    }
     for (auto& light : _lights) {
-        lights << '\n' << light->getInstanceComputeBlock();
+        auto culled = std::find(culledLights.begin(), culledLights.end(), light.get());
+        if (culled != culledLights.end()) {
+            size_t index = culled - culledLights.begin();
+            lights << '\n' << LightCulling::computeBlock(index, light->getInstanceComputeBlock());
+        } else {
+            lights << '\n' << light->getInstanceComputeBlock();
+        }
     }
 
     const std::string tag = "#pragma tangram: lights_to_compute";
@@ -129,8 +179,8 @@ std::string Light::getInstanceBlock() {
     std::string block = "";
     const std::string& typeName = getTypeName();
     if (m_dynamic) {
-        //  If is dynamic, define the uniform and copy it to the global instance of the light struct
-        block += "uniform " + typeName + " " + getUniformName() + ";\n";
+        //  If is dynamic, define the global instance of the light struct; the uniform
+        //  declared by assembleLights() is copied to it in the setup block
         block += typeName + " " + getInstanceName() + ";\n";
     } else {
         //  If is not dynamic define the global instance of the light struct and fill the variables
@@ -12,6 +12,7 @@ namespace Tangram {
 
 class RenderState;
 class ShaderProgram;
+class UniformBuffer;
 class View;
 
 enum class LightType {
@@ -98,6 +99,9 @@ public:
     virtual void setupProgram(RenderState& rs, const View& _view, ShaderProgram& _shader,
                               LightUniforms& _uniforms);
 
+    /*  Pass the uniforms for this particular DYNAMICAL light into the buffer of the lights uniform block */
+    virtual void setupUniformBuffer(const View& _view, UniformBuffer& _buffer, LightUniforms& _uniforms);
+
     /*  STATIC Function that compose sourceBlocks with Lights on a ProgramShader */
     static std::map<std::string, std::string>  assembleLights(const std::vector<std::unique_ptr<Light>>& _lights);
 
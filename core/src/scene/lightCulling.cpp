@@ -0,0 +1,163 @@
+#include "scene/lightCulling.h"
+
+#include "gl/texture.h"
+#include "scene/pointLight.h"
+#include "util/floatFormatter.h"
+#include "view/view.h"
+
+#include "glm/mat4x4.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace Tangram {
+
+constexpr int LightCulling::tile_size;
+constexpr size_t LightCulling::min_lights;
+
+static TextureOptions maskTextureOptions() {
+    TextureOptions options;
+    options.minFilter = TextureMinFilter::NEAREST;
+    options.magFilter = TextureMagFilter::NEAREST;
+    return options;
+}
+
+std::vector<PointLight*> LightCulling::cullableLights(const std::vector<std::unique_ptr<Light>>& _lights) {
+
+    std::vector<PointLight*> lights;
+    for (auto& light : _lights) {
+        auto type = light->getType();
+        if (type != LightType::point && type != LightType::spot) { continue; }
+
+        auto* pointLight = static_cast<PointLight*>(light.get());
+        if (pointLight->getOuterRadius() > 0.f) { lights.push_back(pointLight); }
+    }
+    if (lights.size() < min_lights) { lights.clear(); }
+
+    return lights;
+}
+
+std::string LightCulling::maskBlock(size_t _lights) {
+    std::string block;
+    for (size_t texel = 0; texel * 32 < _lights; texel++) {
+        block += "vec4 light_tile_mask" + std::to_string(texel) +
+            " = lightTileMask(" + ff::to_string(float(texel)) + ");\n";
+    }
+    return block;
+}
+
+std::string LightCulling::computeBlock(size_t _index, const std::string& _computeBlock) {
+    size_t byte = (_index % 32) / 8;
+    glm::vec4 channel(0.f);
+    channel[byte] = 1.f;
+
+    return "if (lightInTile(light_tile_mask" + std::to_string(_index / 32) + ", " +
+        ff::to_string(channel) + ", " + ff::to_string(float(1 << (_index % 8))) + ")) {\n" +
+        _computeBlock + "}\n";
+}
+
+LightCulling::LightCulling(std::vector<PointLight*> _lights)
+    : m_lights(std::move(_lights)),
+      m_texels((m_lights.size() + 31) / 32) {}
+
+LightCulling::~LightCulling() {}
+
+void LightCulling::update(const View& _view) {
+
+    int columns = std::max(1, int(std::ceil(_view.getWidth() / tile_size)));
+    int rows = std::max(1, int(std::ceil(_view.getHeight() / tile_size)));
+
+    size_t size = columns * rows * m_texels * 4;
+
+    std::vector<uint8_t> masks(size, 0);
+
+    const glm::mat4& proj = _view.getProjectionMatrix();
+
+    for (size_t i = 0; i < m_lights.size(); i++) {
+        auto* light = m_lights[i];
+        float radius = light->getOuterRadius();
+        glm::vec3 center = glm::vec3(light->getViewPosition(_view));
+
+        // Tiles of the bounds on screen of the cube around the sphere of the light,
+        // all of them for lights without an outer radius or around the eye
+        int col0 = 0, row0 = 0, col1 = columns - 1, row1 = rows - 1;
+
+        if (radius > 0.f) {
+            glm::vec2 min(1.f), max(-1.f);
+            int cornersBehind = 0;
+
+            for (int corner = 0; corner < 8; corner++) {
+                glm::vec3 p = center + radius * glm::vec3((corner & 1) ? 1.f : -1.f,
+                                                          (corner & 2) ? 1.f : -1.f,
+                                                          (corner & 4) ? 1.f : -1.f);
+                glm::vec4 clip = proj * glm::vec4(p, 1.f);
+                if (clip.w <= 0.f) {
+                    cornersBehind++;
+                    continue;
+                }
+                glm::vec2 ndc = glm::vec2(clip) / clip.w;
+                if (corner == cornersBehind) {
+                    min = max = ndc;
+                } else {
+                    min = glm::min(min, ndc);
+                    max = glm::max(max, ndc);
+                }
+            }
+
+            // A sphere behind the eye lights no visible fragment
+            if (cornersBehind == 8) { continue; }
+
+            if (cornersBehind == 0) {
+                if (min.x > 1.f || min.y > 1.f || max.x < -1.f || max.y < -1.f) { continue; }
+
+                col0 = std::max(0, int((min.x * 0.5f + 0.5f) * _view.getWidth()) / tile_size);
+                row0 = std::max(0, int((min.y * 0.5f + 0.5f) * _view.getHeight()) / tile_size);
+                col1 = std::min(columns - 1, int((max.x * 0.5f + 0.5f) * _view.getWidth()) / tile_size);
+                row1 = std::min(rows - 1, int((max.y * 0.5f + 0.5f) * _view.getHeight()) / tile_size);
+            }
+        }
+
+        uint8_t bit = 1 << (i % 8);
+        size_t offset = (i / 32) * 4 + (i % 32) / 8;
+
+        for (int row = row0; row <= row1; row++) {
+            for (int col = col0; col <= col1; col++) {
+                masks[(row * columns + col) * m_texels * 4 + offset] |= bit;
+            }
+        }
+    }
+
+    if (columns != m_columns || rows != m_rows || masks != m_masks) {
+        m_masks.swap(masks);
+        m_columns = columns;
+        m_rows = rows;
+        m_changed = true;
+    }
+}
+
+bool LightCulling::bind(RenderState& _rs, GLuint _unit) {
+
+    if (m_masks.empty()) { return false; }
+
+    if (!m_texture) { m_texture = std::make_unique<Texture>(maskTextureOptions()); }
+
+    if (m_changed) {
+        m_texture->setPixelData(m_columns * m_texels, m_rows, 4, m_masks.data(), m_masks.size());
+        m_changed = false;
+    }
+    return m_texture->bind(_rs, _unit);
+}
+
+glm::vec3 LightCulling::gridSize() const {
+    return glm::vec3(tile_size, m_columns * m_texels, m_rows);
+}
+
+bool LightCulling::lightInTile(size_t _index, int _column, int _row) const {
+    if (_index >= m_lights.size() || _column < 0 || _column >= m_columns ||
+        _row < 0 || _row >= m_rows) {
+        return false;
+    }
+    size_t offset = (_row * m_columns + _column) * m_texels * 4 + (_index / 32) * 4 + (_index % 32) / 8;
+    return (m_masks[offset] & (1 << (_index % 8))) != 0;
+}
+
+}
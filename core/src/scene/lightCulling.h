@@ -0,0 +1,82 @@
+#pragma once
+
+#include "gl.h"
+
+#include "glm/vec3.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Tangram {
+
+class Light;
+class PointLight;
+class RenderState;
+class Texture;
+class View;
+
+/* Assigns the point and spot lights of a scene to the screen tiles they reach
+ *
+ * A light with an outer radius does not light fragments farther away from it.
+ * Each frame the bounds of these spheres on screen are binned into tiles of
+ * tile_size pixels, and a texture with a bit per light and tile is uploaded,
+ * so that the lighting block of the shaders skips the lights of other tiles.
+ */
+class LightCulling {
+
+public:
+
+    /// Size of a screen tile in pixels
+    static constexpr int tile_size = 64;
+
+    /// Lights that can be culled below which all lights are computed for each fragment
+    static constexpr size_t min_lights = 4;
+
+    /// Lights of _lights that can be culled, in the order of their bits, or
+    /// none when they are fewer than min_lights
+    static std::vector<PointLight*> cullableLights(const std::vector<std::unique_ptr<Light>>& _lights);
+
+    /// GLSL that fetches the bits of _lights culled lights for a fragment
+    static std::string maskBlock(size_t _lights);
+
+    /// GLSL that runs _computeBlock only for fragments reached by the culled light _index
+    static std::string computeBlock(size_t _index, const std::string& _computeBlock);
+
+    explicit LightCulling(std::vector<PointLight*> _lights);
+
+    ~LightCulling();
+
+    /// Bin the lights into the screen tiles of _view
+    void update(const View& _view);
+
+    /// Bind the texture of the tiles, uploading the bits that changed
+    bool bind(RenderState& _rs, GLuint _unit);
+
+    /// Size of a screen tile in pixels, and of the texture in texels
+    glm::vec3 gridSize() const;
+
+    /// Whether the light _index reaches the screen tile at _column and _row
+    bool lightInTile(size_t _index, int _column, int _row) const;
+
+    int columns() const { return m_columns; }
+    int rows() const { return m_rows; }
+
+private:
+
+    std::vector<PointLight*> m_lights;
+
+    // RGBA texels of the bits of the lights, m_texels per tile
+    std::vector<uint8_t> m_masks;
+    size_t m_texels = 0;
+
+    int m_columns = 0;
+    int m_rows = 0;
+
+    bool m_changed = false;
+
+    std::unique_ptr<Texture> m_texture;
+
+};
+
+}
@@ -1,6 +1,7 @@
 #include "scene/pointLight.h"
 
 #include "gl/shaderProgram.h"
+#include "gl/uniformBuffer.h"
 #include "platform.h"
 #include "pointLight_glsl.h"
 #include "util/floatFormatter.h"
@@ -46,9 +47,7 @@ std::unique_ptr<LightUniforms> PointLight::getUniforms() {
     return std::make_unique<Uniforms>(getUniformName());
 }
 
-void PointLight::setupProgram(RenderState& rs, const View& _view, ShaderProgram& _shader,
-                              LightUniforms& _uniforms) {
-    Light::setupProgram(rs, _view, _shader, _uniforms);
+glm::vec4 PointLight::getViewPosition(const View& _view) const {
 
     glm::vec4 position = glm::vec4(m_position.value, 0.0);
 
@@ -79,9 +78,16 @@ void PointLight::setupProgram(RenderState& rs, const View& _view, ShaderProgram&
         position = _view.getViewMatrix() * position;
     }
 
+    return position;
+}
+
+void PointLight::setupProgram(RenderState& rs, const View& _view, ShaderProgram& _shader,
+                              LightUniforms& _uniforms) {
+    Light::setupProgram(rs, _view, _shader, _uniforms);
+
     auto& u = static_cast<Uniforms&>(_uniforms);
 
-    _shader.setUniformf(rs, u.position, position);
+    _shader.setUniformf(rs, u.position, getViewPosition(_view));
 
     if (m_attenuation != 0.0) {
         _shader.setUniformf(rs, u.attenuation, m_attenuation);
@@ -96,6 +102,27 @@ void PointLight::setupProgram(RenderState& rs, const View& _view, ShaderProgram&
     }
 }
 
+void PointLight::setupUniformBuffer(const View& _view, UniformBuffer& _buffer,
+                                    LightUniforms& _uniforms) {
+    Light::setupUniformBuffer(_view, _buffer, _uniforms);
+
+    auto& u = static_cast<Uniforms&>(_uniforms);
+
+    _buffer.setUniformf(u.position, getViewPosition(_view));
+
+    if (m_attenuation != 0.0) {
+        _buffer.setUniformf(u.attenuation, m_attenuation);
+    }
+
+    if (m_innerRadius != 0.0) {
+        _buffer.setUniformf(u.innerRadius, m_innerRadius);
+    }
+
+    if (m_outerRadius != 0.0) {
+        _buffer.setUniformf(u.outerRadius, m_outerRadius);
+    }
+}
+
 std::string PointLight::getClassBlock() {
     return pointLight_glsl;
 }
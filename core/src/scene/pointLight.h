@@ -24,6 +24,9 @@ public:
     virtual void setupProgram(RenderState& rs, const View& _view, ShaderProgram& _shader,
                               LightUniforms& _uniforms) override;
 
+    virtual void setupUniformBuffer(const View& _view, UniformBuffer& _buffer,
+                                    LightUniforms& _uniforms) override;
+
     struct Uniforms : public LightUniforms {
         Uniforms(const std::string& _name)
             : LightUniforms(_name),
@@ -40,6 +43,12 @@ public:
 
     auto getPosition() const -> UnitVec<glm::vec3> { return m_position; }
 
+    /*  Distance beyond which the light has no effect, or 0 when it reaches everything */
+    float getOuterRadius() const { return m_outerRadius; }
+
+    /*  Position of the light in camera space */
+    glm::vec4 getViewPosition(const View& _view) const;
+
     std::unique_ptr<LightUniforms> getUniforms() override;
 
 protected:
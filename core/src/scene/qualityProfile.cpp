@@ -0,0 +1,175 @@
+#include "scene/qualityProfile.h"
+
+#include "gl/hardware.h"
+#include "util/yamlUtil.h"
+
+#include <algorithm>
+
+namespace Tangram {
+
+constexpr uint32_t QualityMonitor::window_frames;
+constexpr float QualityMonitor::slow_frame_time;
+constexpr size_t QualityProfile::low_memory_cache_size;
+constexpr size_t QualityProfile::low_memory_layout_cache;
+
+QualityProfile QualityProfile::forTier(QualityTier _tier) {
+
+    if (_tier == QualityTier::automatic) { _tier = hardwareTier(); }
+
+    QualityProfile profile;
+    profile.tier = _tier;
+
+    switch (_tier) {
+    case QualityTier::low:
+        profile.vertexLighting = true;
+        profile.extrusion = false;
+        profile.labelDensity = 150;
+        profile.tileCacheSize = 8 * 1024 * 1024;
+        profile.rasterZoomOffset = 1;
+        break;
+    case QualityTier::medium:
+        profile.vertexLighting = true;
+        profile.labelDensity = 300;
+        profile.tileCacheSize = 16 * 1024 * 1024;
+        break;
+    default:
+        break;
+    }
+    return profile;
+}
+
+QualityTier QualityProfile::hardwareTier() {
+
+    if (Hardware::maxTextureSize == 0) { return QualityTier::high; }
+
+    if (Hardware::maxTextureSize < 4096 || Hardware::maxVertexUniformVectors < 128) {
+        return QualityTier::low;
+    }
+    // Drivers with GLES 2.0 only
+    if (Hardware::isGLES && !Hardware::supportsUniformBuffers) {
+        return QualityTier::medium;
+    }
+    return QualityTier::high;
+}
+
+QualityTier QualityProfile::lowerTier(QualityTier _tier) {
+    switch (_tier) {
+    case QualityTier::automatic:
+    case QualityTier::high:
+        return QualityTier::medium;
+    default:
+        return QualityTier::low;
+    }
+}
+
+void QualityProfile::applyLowMemory(SceneOptions& _options) {
+    if (!_options.lowMemory) { return; }
+
+    _options.qualityTier = QualityTier::low;
+    _options.numTileWorkers = std::min<uint32_t>(_options.numTileWorkers, 1);
+    _options.numLayerWorkers = 0;
+    _options.memoryTileCacheSize = std::min(_options.memoryTileCacheSize, low_memory_cache_size);
+    _options.compressMemoryTileCache = true;
+}
+
+// Keys that can be used as a SceneUpdate path segment
+static bool isPathKey(const std::string& _key) {
+    return !_key.empty() && _key.find_first_of(".#") == std::string::npos;
+}
+
+static void disableExtrusion(const YAML::Node& _draw, const std::string& _path,
+                             std::vector<SceneUpdate>& _updates) {
+    if (!_draw || !_draw.IsMap()) { return; }
+
+    for (const auto& entry : _draw) {
+        const auto& style = entry.first.Scalar();
+        if (!isPathKey(style) || !entry.second.IsMap()) { continue; }
+
+        if (entry.second["extrude"]) {
+            _updates.emplace_back(_path + "." + style + ".extrude", "false");
+        }
+    }
+}
+
+static void disableLayerExtrusion(const YAML::Node& _layer, const std::string& _path,
+                                  std::vector<SceneUpdate>& _updates) {
+    if (!_layer || !_layer.IsMap()) { return; }
+
+    for (const auto& entry : _layer) {
+        const auto& key = entry.first.Scalar();
+        if (key == "draw") {
+            disableExtrusion(entry.second, _path + ".draw", _updates);
+        } else if (key != "data" && key != "filter" && isPathKey(key) && entry.second.IsMap()) {
+            // Sublayer
+            disableLayerExtrusion(entry.second, _path + "." + key, _updates);
+        }
+    }
+}
+
+std::vector<SceneUpdate> QualityProfile::sceneUpdates(const YAML::Node& _config) const {
+
+    std::vector<SceneUpdate> updates;
+
+    if (!extrusion) {
+        const YAML::Node& layers = _config["layers"];
+        if (layers && layers.IsMap()) {
+            for (const auto& entry : layers) {
+                const auto& name = entry.first.Scalar();
+                if (!isPathKey(name)) { continue; }
+                disableLayerExtrusion(entry.second, "layers." + name, updates);
+            }
+        }
+        const YAML::Node& styles = _config["styles"];
+        if (styles && styles.IsMap()) {
+            for (const auto& entry : styles) {
+                const auto& name = entry.first.Scalar();
+                if (!isPathKey(name) || !entry.second.IsMap()) { continue; }
+                const YAML::Node& draw = entry.second["draw"];
+                if (draw && draw.IsMap() && draw["extrude"]) {
+                    updates.emplace_back("styles." + name + ".draw.extrude", "false");
+                }
+            }
+        }
+    }
+
+    if (rasterZoomOffset != 0) {
+        const YAML::Node& sources = _config["sources"];
+        if (sources && sources.IsMap()) {
+            for (const auto& entry : sources) {
+                const auto& name = entry.first.Scalar();
+                const YAML::Node& source = entry.second;
+                if (!isPathKey(name) || !source.IsMap()) { continue; }
+
+                const YAML::Node& type = source["type"];
+                if (!type || !type.IsScalar() || type.Scalar() != "Raster") { continue; }
+
+                int zoomOffset = 0;
+                if (const YAML::Node& offset = source["zoom_offset"]) {
+                    YamlUtil::getInt(offset, zoomOffset);
+                }
+                updates.emplace_back("sources." + name + ".zoom_offset",
+                                     std::to_string(zoomOffset + rasterZoomOffset));
+            }
+        }
+    }
+
+    return updates;
+}
+
+bool QualityMonitor::addFrameTime(float _ms, float _targetFrameTime) {
+
+    m_frameTimes += _ms;
+    if (++m_frames < window_frames) { return false; }
+
+    float average = m_frameTimes / m_frames;
+    reset();
+
+    return average > (_targetFrameTime > 0 ? _targetFrameTime : slow_frame_time);
+}
+
+void QualityMonitor::reset() {
+    m_frameTimes = 0;
+    m_frames = 0;
+}
+
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "sceneOptions.h"
+#include "yaml-cpp/yaml.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Tangram {
+
+/* Settings of a QualityTier
+ *
+ * Extrusion and raster resolution are applied as SceneUpdates to the scene
+ * config, so that scene authors do not write variants of a scene per device.
+ * The lighting of all styles, including the built-in ones, is set on the
+ * styles after they are loaded, as their lighting may come from mixins.
+ * Label density and the tile cache size are set on the LabelManager and
+ * the TileManager of the scene.
+ */
+struct QualityProfile {
+
+    QualityTier tier = QualityTier::high;
+
+    /// Light styles per vertex instead of per fragment
+    bool vertexLighting = false;
+
+    /// Draw polygons with their 'extrude' parameter
+    bool extrusion = true;
+
+    /// Maximum labels per million viewport pixels, 0 when unlimited
+    float labelDensity = 0;
+
+    /// Bytes of built tiles kept in the TileCache, 0 for the default
+    size_t tileCacheSize = 0;
+
+    /// Added to the 'zoom_offset' of raster sources, which load tiles of
+    /// lower zoom levels and so lower resolution
+    int32_t rasterZoomOffset = 0;
+
+    /// Settings of _tier, where QualityTier::automatic is the tier of the GL limits
+    static QualityProfile forTier(QualityTier _tier);
+
+    /// Tier of the GL limits in Hardware, or QualityTier::high when the
+    /// capabilities were not loaded yet
+    static QualityTier hardwareTier();
+
+    /// Next lower tier, or _tier when it is the lowest one
+    static QualityTier lowerTier(QualityTier _tier);
+
+    /// Bytes of the in-memory tile data cache of a SceneOptions::lowMemory scene
+    static constexpr size_t low_memory_cache_size = 4 * 1024 * 1024;
+
+    /// Bytes of text layouts cached by the FontContext of a lowMemory scene
+    static constexpr size_t low_memory_layout_cache = 64 * 1024;
+
+    /// Apply the settings of SceneOptions::lowMemory to _options
+    static void applyLowMemory(SceneOptions& _options);
+
+    /// SceneUpdates that apply extrusion and raster resolution to _config
+    std::vector<SceneUpdate> sceneUpdates(const YAML::Node& _config) const;
+
+};
+
+/* Lowers the tier of a scene with QualityTier::automatic while frames are slow
+ *
+ * The CPU time of update and render is averaged over a window of frames. The
+ * tier is never raised again, so that a scene is not reloaded back and forth.
+ */
+class QualityMonitor {
+
+public:
+
+    /// Frames averaged for a decision
+    static constexpr uint32_t window_frames = 120;
+
+    /// Average frame time in milliseconds above which the tier is lowered,
+    /// when there is no target frame time
+    static constexpr float slow_frame_time = 20.f;
+
+    /// Add the time of a frame, returns true when the last window of frames was slow.
+    /// _targetFrameTime replaces slow_frame_time when it is larger than 0.
+    bool addFrameTime(float _ms, float _targetFrameTime = 0);
+
+    void reset();
+
+private:
+
+    float m_frameTimes = 0;
+    uint32_t m_frames = 0;
+
+};
+
+}
@@ -1,17 +1,33 @@
 #include "scene/scene.h"
 
+#include "data/rasterSource.h"
 #include "data/tileSource.h"
+#include "debug/metrics.h"
+#include "debug/trace.h"
 #include "gl/framebuffer.h"
+#include "gl/gpuTimer.h"
+#include "gl/iconAtlas.h"
+#include "gl/programBinaryCache.h"
 #include "gl/shaderProgram.h"
+#include "gl/shaderProgramCache.h"
+#include "gl/texture.h"
+#include "gl/uniformBuffer.h"
 #include "labels/labelManager.h"
+#include "marker/marker.h"
 #include "marker/markerManager.h"
 #include "scene/dataLayer.h"
+#include "scene/drawRule.h"
 #include "scene/importer.h"
 #include "scene/light.h"
+#include "scene/lightCulling.h"
+#include "scene/sceneBinary.h"
 #include "scene/sceneLoader.h"
 #include "scene/spriteAtlas.h"
 #include "scene/stops.h"
+#include "scene/styleContext.h"
+#include "scene/styleMixer.h"
 #include "selection/featureSelection.h"
+#include "selection/featureState.h"
 #include "selection/selectionQuery.h"
 #include "style/material.h"
 #include "style/debugStyle.h"
@@ -21,27 +37,58 @@
 #include "style/rasterStyle.h"
 #include "style/style.h"
 #include "text/fontContext.h"
+#include "tile/tileCache.h"
+#include "tile/tileDiskCache.h"
 #include "util/base64.h"
+#include "util/hash.h"
 #include "util/util.h"
+#include "util/yamlUtil.h"
 #include "log.h"
 #include "scene.h"
 
 #include <algorithm>
+#include <chrono>
+#include <fstream>
 
 namespace Tangram {
 
 static std::atomic<int32_t> s_serial;
 
+static SceneOptions applyLowMemory(SceneOptions&& _options) {
+    QualityProfile::applyLowMemory(_options);
+    return std::move(_options);
+}
 
 Scene::Scene(Platform& _platform, SceneOptions&& _options, std::function<void(Scene*)> _prefetchCallback) :
     id(s_serial++),
     m_platform(_platform),
-    m_options(std::move(_options)),
+    m_options(applyLowMemory(std::move(_options))),
+    m_qualityProfile(QualityProfile::forTier(m_options.qualityTier)),
     m_tilePrefetchCallback(_prefetchCallback) {
     
     m_tileWorker = std::make_unique<TileWorker>(_platform, m_options.numTileWorkers);
     m_tileManager = std::make_unique<TileManager>(_platform, *m_tileWorker);
+    if (m_qualityProfile.tileCacheSize > 0) {
+        m_tileManager->setCacheSize(m_qualityProfile.tileCacheSize);
+    }
     m_markerManager = std::make_unique<MarkerManager>(*this);
+    m_featureState = std::make_unique<FeatureState>();
+
+    if (m_options.uniformBlocks) {
+        m_viewUniforms = std::make_unique<UniformBuffer>(UniformBuffer::VIEW_BLOCK,
+                                                         UniformBuffer::VIEW_BINDING);
+        m_lightUniforms = std::make_unique<UniformBuffer>(UniformBuffer::LIGHTS_BLOCK,
+                                                          UniformBuffer::LIGHTS_BINDING);
+    }
+
+    if (!m_options.tileDiskCachePath.empty()) {
+        m_tileDiskCache = std::make_unique<TileDiskCache>(m_options.tileDiskCachePath);
+    }
+
+    if (!m_options.shaderCachePath.empty()) {
+        m_programBinaryCache = std::make_unique<ProgramBinaryCache>(m_options.shaderCachePath);
+    }
+    m_programCache = std::make_unique<ShaderProgramCache>(m_programBinaryCache.get());
 }
 
 Scene::~Scene() {
@@ -96,13 +143,32 @@ bool Scene::load() {
     
     m_state = State::loading;
 
+    auto loadStart = std::chrono::steady_clock::now();
+    auto phaseStart = loadStart;
+    auto endPhase = [&](float& _time) {
+        auto now = std::chrono::steady_clock::now();
+        _time = std::chrono::duration<float, std::milli>(now - phaseStart).count();
+        phaseStart = now;
+    };
+
     /// Wait until all scene-yamls are available and merged.
     /// NB: Importer holds reference to zip archives for resource loading
     ///
     /// Importer is blocking until all imports are loaded
     m_importer = std::make_unique<Importer>();
-    m_config = m_importer->loadSceneData(m_platform, m_options.url, m_options.yaml);
+
+    /// Zip archives are still needed for resources, so these are always imported
+    bool precompiled = false;
+    if (!m_options.precompiledScene.isEmpty() && !Importer::isZipArchiveUrl(m_options.url)) {
+        m_config = m_importer->loadSceneBinary(m_platform, m_options.precompiledScene, m_options.url,
+                                               SceneBinary::sourceHash(m_options));
+        precompiled = bool(m_config);
+    }
+    if (!precompiled) {
+        m_config = m_importer->loadSceneData(m_platform, m_options.url, m_options.yaml);
+    }
     LOGTO("<<< applyImports");
+    endPhase(m_loadTimes.imports);
 
     if (isCanceled(State::loading)) { return false; }
 
@@ -112,21 +178,41 @@ bool Scene::load() {
         return false;
     }
 
-    auto result = SceneLoader::applyUpdates(m_config, m_options.updates);
-    if (result.error != Error::none) {
-        m_errors.push_back(result);
-        LOGE("Applying SceneUpdates failed!");
-        return false;
+    /// The precompiled config has updates applied and URLs resolved
+    if (!precompiled) {
+        auto result = SceneLoader::applyUpdates(m_config, m_options.updates);
+        if (result.error != Error::none) {
+            m_errors.push_back(result);
+            LOGE("Applying SceneUpdates failed!");
+            return false;
+        }
+        LOGTO("<<< applyUpdates");
+
+        Importer::resolveSceneUrls(m_config, m_options.url);
     }
-    LOGTO("<<< applyUpdates");
 
-    Importer::resolveSceneUrls(m_config, m_options.url);
+    /// Quality tier settings are not part of a precompiled config
+    auto tierUpdates = m_qualityProfile.sceneUpdates(m_config);
+    if (!tierUpdates.empty()) {
+        SceneLoader::applyUpdates(m_config, tierUpdates);
+    }
+    m_baseConfig = YAML::Clone(m_config);
 
     SceneLoader::applyGlobals(m_config, m_config);
+    setGlobals();
     LOGTO("<<< applyGlobals");
 
+    if (m_tileDiskCache) {
+        YAML::Emitter emitter;
+        emitter << m_config;
+        m_configHash = std::hash<std::string>()(emitter.c_str());
+        LOGTO("<<< configHash");
+    }
+    endPhase(m_loadTimes.config);
+
     m_tileSources = SceneLoader::applySources(m_config, m_options, m_platform);
     LOGTO("<<< applySources");
+    endPhase(m_loadTimes.sources);
 
     SceneLoader::applyCameras(m_config, m_camera);
     LOGTO("<<< applyCameras");
@@ -134,7 +220,10 @@ bool Scene::load() {
     SceneLoader::applyScene(m_config["scene"], m_background, m_backgroundStops, m_animated);
     LOGTO("<<< applyScene");
 
+    setSourceHashes();
+
     m_tileManager->setTileSources(m_tileSources);
+    copyPreviousSources();
 
     /// Scene is ready to load tiles for initial view
     if (m_options.prefetchTiles && m_tilePrefetchCallback) {
@@ -142,6 +231,10 @@ bool Scene::load() {
     }
 
     m_fontContext = std::make_unique<FontContext>(m_platform);
+    m_fontContext->recordGlyphFields(m_options.recordGlyphFields);
+    if (m_options.lowMemory) {
+        m_fontContext->setLayoutCacheSize(QualityProfile::low_memory_layout_cache);
+    }
     m_fontContext->loadFonts();
     LOGTO("<<< initFonts");
 
@@ -167,6 +260,10 @@ bool Scene::load() {
     /// These indices are used for style geometry lookup in tiles
     for(uint32_t i = 0; i < m_styles.size(); i++) {
         m_styles[i]->setID(i);
+        if (m_qualityProfile.vertexLighting &&
+            m_styles[i]->lightingType() == LightingType::fragment) {
+            m_styles[i]->setLightingType(LightingType::vertex);
+        }
         if (auto pointStyle = dynamic_cast<PointStyle*>(m_styles[i].get())) {
             pointStyle->setTextures(m_textures.textures);
             pointStyle->setFontContext(*m_fontContext);
@@ -177,16 +274,30 @@ bool Scene::load() {
     }
     runTextureTasks();
     LOGTO("<<< applyStyles");
+    endPhase(m_loadTimes.styles);
 
     m_lights = SceneLoader::applyLights(m_config["lights"]);
     m_lightShaderBlocks = Light::assembleLights(m_lights);
+    auto culledLights = LightCulling::cullableLights(m_lights);
+    if (!culledLights.empty()) {
+        m_lightCulling = std::make_unique<LightCulling>(std::move(culledLights));
+    }
+    for (auto& light : m_lights) {
+        m_lightUniformNames.push_back(light->getUniforms());
+    }
     LOGTO("<<< applyLights");
 
     m_layers = SceneLoader::applyLayers(m_config["layers"], m_jsFunctions, m_stops, m_names);
     LOGTO("<<< applyLayers");
+    endPhase(m_loadTimes.layers);
+
+    StyleContext().compileFunctions(m_jsFunctions, m_jsBytecode);
+    LOGTO("<<< compileFunctions");
 
     for (auto& style : m_styles) { style->build(*this); }
+    m_drawOrder = Style::drawOrder(m_styles);
     LOGTO("<<< buildStyles");
+    endPhase(m_loadTimes.functions);
 
     if (isCanceled(State::loading)) { return false; }
 
@@ -197,10 +308,13 @@ bool Scene::load() {
 
     m_featureSelection = std::make_unique<FeatureSelection>();
     m_labelManager = std::make_unique<LabelManager>();
+    m_labelManager->setAsyncPlacement(m_options.asyncLabelPlacement);
+    m_labelManager->setMaxLabelDensity(m_qualityProfile.labelDensity);
 
     m_state = State::pending_resources;
 
     bool startTileWorker = m_options.prefetchTiles;
+    bool iconsPacked = false;
     while (true) {
         // NB: Capture completion of tasks until wait(lock)
         // Otherwise we can loose the notify. We cannot lock m_tasksMutex
@@ -227,21 +341,19 @@ bool Scene::load() {
         });
 
         m_fonts.tasks.remove_if([&](auto& task) {
-            if (!task.done) { f++; }
             if (!task.done) {
+                f++;
                 canBuildTiles = false;
-                return false;
             }
-            if (task.response.error) {
-                LOGE("Error retrieving font '%s' at %s: ",
-                     task.ft.uri.c_str(), task.response.error);
-                return true;
-            }
-            auto&& data = task.response.content;
-            m_fontContext->addFont(task.ft, alfons::InputSource(std::move(data)));
-            return true;
+            return task.done;
         });
 
+        /// Icons are packed before tiles refer to their texture coordinates
+        if (canBuildTiles && !iconsPacked) {
+            m_textures.packIcons();
+            iconsPacked = true;
+        }
+
         /// Ready to build tiles?
         if (startTileWorker && canBuildTiles && m_tilePrefetchCallback) {
             m_readyToBuildTiles = true;
@@ -291,10 +403,329 @@ bool Scene::load() {
         m_state = State::pending_completion;
     }
 
+    endPhase(m_loadTimes.resources);
+    m_loadTimes.total = std::chrono::duration<float, std::milli>(phaseStart - loadStart).count();
+    LOG("Scene loaded in %.1fms: imports %.1f, config %.1f, sources %.1f, styles %.1f, "
+        "layers %.1f, functions %.1f, resources %.1f", m_loadTimes.total, m_loadTimes.imports,
+        m_loadTimes.config, m_loadTimes.sources, m_loadTimes.styles, m_loadTimes.layers,
+        m_loadTimes.functions, m_loadTimes.resources);
+
     LOGTO("<<<<<< loadScene <<<<<<");
     return true;
 }
 
+bool Scene::applyUpdates(const std::vector<SceneUpdate>& _updates) {
+    if (m_state != State::ready) { return false; }
+
+    LOGTOInit();
+
+    YAML::Node baseConfig = YAML::Clone(m_baseConfig);
+    if (SceneLoader::applyUpdates(baseConfig, _updates).error != Error::none) {
+        // Reported by loading the scene
+        return false;
+    }
+    Importer::resolveSceneUrls(baseConfig, m_options.url);
+
+    YAML::Node config = YAML::Clone(baseConfig);
+    SceneLoader::applyGlobals(config, config);
+    const YAML::Node& styles = static_cast<const YAML::Node&>(config)["styles"];
+    if (styles && styles.IsMap()) {
+        try {
+            StyleMixer().mixStyleNodes(styles);
+        } catch (const YAML::RepresentationException& e) {
+            return false;
+        }
+    }
+
+    auto changes = SceneLoader::diffConfig(m_config, config);
+    if (changes.reload) { return false; }
+    LOGTO("<<< diffConfig");
+
+    auto findStyle = [&](const std::string& _name) -> Style* {
+        for (auto& style : m_styles) {
+            if (style->getName() == _name) { return style.get(); }
+        }
+        return nullptr;
+    };
+    auto findSource = [&](const std::string& _name) {
+        return std::find_if(m_tileSources.begin(), m_tileSources.end(),
+                            [&](auto& s) { return s->name() == _name; });
+    };
+
+    /// Uniform values: new textures would need to be loaded
+    auto isTexture = [](const YAML::Node& _value) {
+        const YAML::Node& value = (_value.IsSequence() && _value.size() > 0) ? _value[0] : _value;
+        double d;
+        bool b;
+        return value.IsScalar() && !YamlUtil::getDouble(value, d, false) && !YamlUtil::getBool(value, b);
+    };
+    std::vector<std::tuple<Style*, std::string, UniformValue>> uniforms;
+    for (const auto& name : changes.uniforms) {
+        // Abstract styles are only mixed into others
+        Style* style = findStyle(name);
+        if (!style) { continue; }
+
+        for (const auto& uniform : config["styles"][name]["shaders"]["uniforms"]) {
+            StyleUniform styleUniform;
+            if (isTexture(uniform.second) ||
+                !SceneLoader::parseStyleUniforms(uniform.second, styleUniform, m_textures)) {
+                return false;
+            }
+            uniforms.emplace_back(style, uniform.first.Scalar(), std::move(styleUniform.value));
+        }
+    }
+
+    /// Source parameters: raster sources are shared by other sources
+    std::vector<std::shared_ptr<TileSource>> sources;
+    for (const auto& name : changes.sources) {
+        auto it = findSource(name);
+        if (it == m_tileSources.end()) { return false; }
+        auto& current = *it;
+
+        const YAML::Node& sourceNode = config["sources"][name];
+        if (!current->generateGeometry() || !current->rasterSources().empty() ||
+            sourceNode["rasters"]) {
+            return false;
+        }
+        for (auto& source : m_tileSources) {
+            for (auto* raster : source->rasterSources()) {
+                if (raster == current.get()) { return false; }
+            }
+        }
+
+        std::shared_ptr<TileSource> source;
+        try {
+            source = SceneLoader::loadSource(sourceNode, name, m_options, m_platform);
+        } catch (const YAML::RepresentationException& e) {
+            return false;
+        }
+        if (!source) { return false; }
+        source->generateGeometry(true);
+        sources.push_back(std::move(source));
+    }
+
+    /// Lights: values of static lights are part of the shaders
+    std::vector<Light*> lights;
+    for (const auto& name : changes.lights) {
+        auto it = std::find_if(m_lights.begin(), m_lights.end(),
+                               [&](auto& l) { return l->getInstanceName() == name; });
+        // Not visible
+        if (it == m_lights.end()) { continue; }
+        if (!(*it)->isDynamic()) { return false; }
+        lights.push_back(it->get());
+    }
+
+    /// Values are read by the styles when drawing the next frame
+    for (auto& uniform : uniforms) {
+        if (!std::get<0>(uniform)->setStyleUniform(std::get<1>(uniform), std::get<2>(uniform))) {
+            // Type of the uniform changed, the shader needs to be rebuilt
+            return false;
+        }
+    }
+    for (const auto& name : changes.materials) {
+        if (Style* style = findStyle(name)) {
+            SceneLoader::loadMaterial(config["styles"][name]["material"], style->getMaterial(),
+                                      *style, m_textures);
+        }
+    }
+    for (auto* light : lights) {
+        SceneLoader::loadLightProps(config["lights"][light->getInstanceName()], *light);
+    }
+    LOGTO("<<< uniforms");
+
+    bool rebuildRules = !changes.layers.empty() || !changes.styleParams.empty();
+    bool rebuildTiles = rebuildRules || !sources.empty() || changes.globals;
+
+    m_baseConfig = baseConfig;
+    m_options.updates.insert(m_options.updates.end(), _updates.begin(), _updates.end());
+
+    /// Hashed again for the next Scene that takes over its tiles
+    m_sourceHashes.clear();
+
+    if (!rebuildTiles) {
+        /// TileBuilders only read the globals, which did not change
+        m_config = config;
+        LOGTO("<<< applyUpdates");
+        return true;
+    }
+
+    /// TileBuilders read the scene globals, layers, functions and stops
+    m_tileWorker->pause();
+
+    m_config = config;
+    setGlobals();
+
+    if (rebuildRules) {
+        /// Parse draw rules of styles and layers into new functions, stops
+        /// and names, so that these do not grow with each update
+        m_jsFunctions.clear();
+        m_jsBytecode.clear();
+        m_stops.clear();
+        m_names.clear();
+
+        for (const auto& entry : m_config["styles"]) {
+            Style* style = findStyle(entry.first.Scalar());
+            if (!style) { continue; }
+            try {
+                const YAML::Node& drawNode = entry.second["draw"];
+                if (!drawNode) {
+                    style->setDefaultDrawRule(nullptr);
+                    continue;
+                }
+                auto params = SceneLoader::parseStyleParams(drawNode, m_stops, m_jsFunctions);
+                int ruleID = SceneLoader::addDrawRuleName(m_names, style->getName());
+                SceneLoader::addStyleNames(m_names, params);
+                style->setDefaultDrawRule(std::make_unique<DrawRuleData>(style->getName(), ruleID,
+                                                                         std::move(params)));
+            } catch (const YAML::RepresentationException& e) {
+                LOGE("Parsing style: '%s'", e.what());
+            }
+        }
+        m_layers = SceneLoader::applyLayers(m_config["layers"], m_jsFunctions, m_stops, m_names);
+
+        StyleContext().compileFunctions(m_jsFunctions, m_jsBytecode);
+        LOGTO("<<< applyLayers");
+    }
+
+    if (m_tileDiskCache) {
+        YAML::Emitter emitter;
+        emitter << m_config;
+        m_configHash = std::hash<std::string>()(emitter.c_str());
+    }
+
+    for (auto& source : sources) {
+        auto name = source->name();
+        *findSource(name) = source;
+        m_tileManager->replaceTileSource(std::move(source));
+        changes.layerSources.erase(name);
+    }
+
+    if (!changes.styleParams.empty() || changes.globals) {
+        /// Any layer may use the style or the globals
+        m_tileManager->clearTileSets();
+    } else {
+        for (const auto& name : changes.layerSources) {
+            auto it = findSource(name);
+            if (it != m_tileSources.end()) {
+                m_tileManager->clearTileSet((*it)->id());
+            }
+        }
+    }
+
+    /// New TileBuilders and StyleContexts for the new scene data
+    m_tileWorker->setScene(*this);
+
+    m_markerManager->resetStyling();
+
+    m_tileWorker->startJobs();
+
+    LOGTO("<<< applyUpdates");
+    return true;
+}
+
+void Scene::setSourceHashes() {
+    auto hash = [](const YAML::Node& _node) {
+        YAML::Emitter emitter;
+        emitter << _node;
+        return std::hash<std::string>()(emitter.c_str());
+    };
+    const YAML::Node& config = m_config;
+
+    /// Styles, globals and the rest apply to the tiles of all sources
+    size_t common = 0;
+    for (const auto& entry : config) {
+        const auto& key = entry.first.Scalar();
+        if (key == "sources" || key == "layers") { continue; }
+        hash_combine(common, key);
+        hash_combine(common, hash(entry.second));
+    }
+
+    m_sourceHashes.clear();
+    for (const auto& entry : config["sources"]) {
+        SourceHash sourceHash;
+        sourceHash.data = hash(entry.second);
+        sourceHash.tiles = common;
+        hash_combine(sourceHash.tiles, sourceHash.data);
+        m_sourceHashes[entry.first.Scalar()] = sourceHash;
+    }
+
+    for (const auto& entry : config["layers"]) {
+        const YAML::Node& data = entry.second["data"];
+        if (!data) { continue; }
+        const YAML::Node& source = data["source"];
+        if (!source || !source.IsScalar()) { continue; }
+
+        auto it = m_sourceHashes.find(source.Scalar());
+        if (it == m_sourceHashes.end()) { continue; }
+        hash_combine(it->second.tiles, entry.first.Scalar());
+        hash_combine(it->second.tiles, hash(entry.second));
+    }
+}
+
+void Scene::setPreviousScene(Scene& _previous, bool _adoptTiles) {
+    if (_previous.m_sourceHashes.empty()) { _previous.setSourceHashes(); }
+
+    m_previousSources = _previous.m_tileSources;
+    m_previousSourceHashes = _previous.m_sourceHashes;
+    m_adoptTiles = _adoptTiles;
+}
+
+void Scene::copyPreviousSources() {
+    std::vector<std::string> heldSources;
+
+    for (auto& source : m_tileSources) {
+        auto hash = m_sourceHashes.find(source->name());
+        auto previousHash = m_previousSourceHashes.find(source->name());
+        if (hash == m_sourceHashes.end() || previousHash == m_previousSourceHashes.end() ||
+            hash->second.data != previousHash->second.data) {
+            continue;
+        }
+
+        auto previous = std::find_if(m_previousSources.begin(), m_previousSources.end(),
+                                     [&](auto& s) { return s->name() == source->name(); });
+        if (previous == m_previousSources.end()) { continue; }
+
+        source->copyCache(**previous);
+
+        if (m_adoptTiles && hash->second.tiles == previousHash->second.tiles) {
+            heldSources.push_back(source->name());
+        }
+    }
+    if (!heldSources.empty()) {
+        LOGD("Take %d tile sets from the previous scene", int(heldSources.size()));
+        m_tileManager->holdTileSets(heldSources);
+    }
+
+    m_previousSources.clear();
+    m_previousSourceHashes.clear();
+}
+
+void Scene::adoptTiles(Scene& _previous) {
+    // Meshes are stored by style ID and built for the pixel scale
+    if (_previous.m_pixelScale == m_pixelScale && _previous.m_styles.size() == m_styles.size()) {
+        m_tileManager->adoptTiles(*_previous.m_tileManager, labelStyles());
+    }
+    m_tileManager->holdTileSets({});
+}
+
+std::vector<bool> Scene::labelStyles() const {
+    std::vector<bool> styles(m_styles.size(), false);
+    bool hasLabels = false;
+    for (auto& style : m_styles) {
+        if (style->type() == StyleType::text || style->type() == StyleType::point) {
+            styles[style->getID()] = true;
+            hasLabels = true;
+        }
+    }
+    if (!hasLabels) { styles.clear(); }
+    return styles;
+}
+
+void Scene::setGlobals() {
+    const YAML::Node& globals = static_cast<const YAML::Node&>(m_config)["global"];
+    m_globals.reset(globals ? globals : YAML::Node());
+}
+
 void Scene::prefetchTiles(const View& _view) {
     View view = _view;
 
@@ -379,10 +810,12 @@ void Scene::setPixelScale(float _scale) {
     m_markerManager->rebuildAll();
 }
 
+SceneTextures::SceneTextures() : iconAtlas(std::make_shared<IconAtlas>()) {}
+
 std::shared_ptr<Texture> SceneTextures::add(const std::string& _name, const Url& _url,
                                             const TextureOptions& _options) {
 
-    std::shared_ptr<Texture> texture = std::make_shared<Texture>(_options);
+    std::shared_ptr<Texture> texture = std::make_shared<IconAtlasTexture>(_options);
     textures.emplace(_name, texture);
 
     if (_url.hasBase64Data() && _url.mediaType() == "image/png") {
@@ -399,6 +832,8 @@ std::shared_ptr<Texture> SceneTextures::add(const std::string& _name, const Url&
 
         } else if (!texture->loadImageFromMemory(blob.data(), blob.size())) {
             LOGE("Invalid Base64 texture");
+        } else {
+            texture->retainCompressedCopy();
         }
         return texture;
     }
@@ -408,14 +843,35 @@ std::shared_ptr<Texture> SceneTextures::add(const std::string& _name, const Url&
     return texture;
 }
 
-std::shared_ptr<Texture> SceneTextures::get(const std::string& _name) {
+std::shared_ptr<Texture> SceneTextures::get(const std::string& _name, bool _sampledByShader) {
+    std::shared_ptr<Texture> texture;
     auto entry = textures.find(_name);
     if (entry != textures.end()) {
-        return entry->second;
+        texture = entry->second;
+    } else {
+        /// If texture could not be found by name then interpret name as URL
+        TextureOptions options;
+        texture = add(_name, Url(_name), options);
+    }
+    if (_sampledByShader) { shaderTextures.insert(texture.get()); }
+    return texture;
+}
+
+void SceneTextures::packIcons() {
+    for (auto& entry : textures) {
+        auto icon = dynamic_cast<IconAtlasTexture*>(entry.second.get());
+        if (!icon || shaderTextures.count(icon)) { continue; }
+
+        // Textures with a size from the scene may still be decoding
+        bool pending = std::any_of(tasks.begin(), tasks.end(), [&](auto& task) {
+            return !task.done && task.texture == entry.second;
+        });
+        if (pending || !icon->canAddToAtlas()) { continue; }
+
+        if (!icon->addToAtlas(iconAtlas)) {
+            LOG("Icon atlas is full, texture '%s' is not packed", entry.first.c_str());
+        }
     }
-    /// If texture could not be found by name then interpret name as URL
-    TextureOptions options;
-    return add(_name, Url(_name), options);
 }
 
 void Scene::runTextureTasks() {
@@ -436,8 +892,11 @@ void Scene::runTextureTasks() {
                 /// Decode texture on download thread.
                 auto data = reinterpret_cast<const uint8_t*>(response.content.data());
                 auto& texture = task.texture;
-                if (!texture->loadImageFromMemory(data, response.content.size())) {
+                if (!texture->loadImageFromMemory(data, response.content.size(), &m_platform)) {
                     LOGE("Invalid texture data from URL '%s'", task.url.string().c_str());
+                } else {
+                    // Restores the texture after a loss of the GL context
+                    texture->retainCompressedCopy();
                 }
                 if (auto& sprites = texture->spriteAtlas()) {
                     sprites->updateSpriteNodes({texture->width(), texture->height()});
@@ -459,7 +918,8 @@ void Scene::runTextureTasks() {
 }
 
 void SceneFonts::add(const std::string& _uri, const std::string& _family,
-                     const std::string& _style, const std::string& _weight) {
+                     const std::string& _style, const std::string& _weight,
+                     bool _glyphFields) {
 
     std::string familyNormalized, styleNormalized;
     familyNormalized.resize(_family.size());
@@ -469,7 +929,7 @@ void SceneFonts::add(const std::string& _uri, const std::string& _family,
     std::transform(_style.begin(), _style.end(), styleNormalized.begin(), ::tolower);
     auto desc = FontDescription{ familyNormalized, styleNormalized, _weight, _uri};
 
-    tasks.emplace_front(Url(_uri), desc);
+    tasks.emplace_front(Url(_uri), desc, _glyphFields);
 }
 
 void Scene::runFontTasks() {
@@ -478,12 +938,30 @@ void Scene::runFontTasks() {
         if (task.started) { continue; }
         task.started = true;
 
+        if (!task.glyphFields && task.url.scheme() == "file" &&
+            std::ifstream(task.url.path()).good()) {
+            // Local font files are opened by FreeType, which maps them instead
+            // of reading the whole file into memory
+            LOG("Open font %s", task.ft.uri.c_str());
+            m_fontContext->addFont(task.ft, alfons::InputSource(task.url.path()));
+            task.done = true;
+            continue;
+        }
+
         LOG("Fetch font %s", task.ft.uri.c_str());
         // TODO remove weak_ptr - it should not be possible to get a callback
         // after task was deleted.
         auto cb = [this, &task](UrlResponse&& response) {
              LOG("Received font: %s", task.ft.uri.c_str());
-             task.response = std::move(response);
+             if (response.error) {
+                 LOGE("Error retrieving font '%s' at %s: ",
+                      task.ft.uri.c_str(), response.error);
+             } else if (task.glyphFields) {
+                 m_fontContext->addGlyphFields(response.content);
+             } else {
+                 /// Load font on download thread, FontContext is synchronized.
+                 m_fontContext->addFont(task.ft, alfons::InputSource(std::move(response.content)));
+             }
              task.done = true;
 
              m_tasksActive--;
@@ -499,63 +977,195 @@ void Scene::runFontTasks() {
     }
 }
 
-Scene::UpdateState Scene::update(const View& _view, float _dt) {
+Scene::UpdateState Scene::update(const View& _view, float _dt, bool _placeLabels,
+                                 const std::vector<const View*>& _views) {
+    TRACE_SCOPE("Scene::update");
 
     m_time += _dt;
 
     bool markersChanged = m_markerManager->update(_view, _dt);
 
-    for (const auto& style : m_styles) {
-        style->onBeginUpdate();
-    }
-
-    m_tileManager->updateTileSets(_view);
+    m_tileManager->updateTileSets(_view, _views);
 
     auto& tiles = m_tileManager->getVisibleTiles();
     auto& markers = m_markerManager->markers();
 
-    if (_view.changedOnLastUpdate() ||
+    bool updateLabelSet = _view.changedOnLastUpdate() ||
         m_tileManager->hasTileSetChanged() ||
-        markersChanged) {
+        markersChanged ||
+        m_labelManager->placementPending() ||
+        m_labelPlacementDeferred;
 
+    // The label meshes of the last update stay valid while no label fades
+    if (!updateLabelSet && !m_labelManager->needUpdate()) {
+        return { m_tileManager->hasLoadingTiles(), false, markersChanged };
+    }
+
+    for (const auto& style : m_styles) {
+        style->onBeginUpdate(updateLabelSet, m_time);
+    }
+
+    if (updateLabelSet) {
         for (const auto& tile : tiles) {
             tile->update(_dt, _view);
         }
+    }
+
+    if (updateLabelSet && _placeLabels) {
         m_labelManager->updateLabelSet(_view.state(), _dt, *this, tiles, markers,
                                        *m_tileManager);
     } else {
         m_labelManager->updateLabels(_view.state(), _dt, m_styles, tiles, markers);
     }
 
-    return { m_tileManager->hasLoadingTiles(), m_labelManager->needUpdate(), markersChanged };
+    m_labelPlacementDeferred = updateLabelSet && !_placeLabels;
+
+    return { m_tileManager->hasLoadingTiles(),
+             m_labelManager->needUpdate() || m_labelPlacementDeferred, markersChanged };
 }
 
 void Scene::renderBeginFrame(RenderState& _rs) {
     _rs.setFrameTime(m_time);
+    _rs.resetUploadedBytes();
+
+    // The pass runs in the label placement of the next update on this thread
+    if (m_options.gpuLabelCollision && !m_options.asyncLabelPlacement &&
+        !m_labelManager->hasCollisionPass() && LabelCollisionPass::isSupported()) {
+        m_labelManager->setCollisionPass(std::make_unique<LabelCollisionPass>(_rs));
+    }
+
+    // Issue compilation of all programs before the first is waited for
+    for (const auto& style : m_styles) {
+        style->compileShaders(_rs);
+    }
     // point style & text style
     for (const auto& style : m_styles) {
         style->onBeginFrame(_rs);
     }
 }
 
+void Scene::setupUniformBuffers(RenderState& _rs, const View& _view) {
+
+    if (m_lightCulling) { m_lightCulling->update(_view); }
+
+    if (!m_viewUniforms) { return; }
+
+    static struct {
+        UniformLocation uTime{"u_time"};
+        UniformLocation uDevicePixelRatio{"u_device_pixel_ratio"};
+        UniformLocation uResolution{"u_resolution"};
+        UniformLocation uMapPosition{"u_map_position"};
+        UniformLocation uNormalMatrix{"u_normal_matrix"};
+        UniformLocation uInverseNormalMatrix{"u_inverse_normal_matrix"};
+        UniformLocation uMetersPerPixel{"u_meters_per_pixel"};
+        UniformLocation uView{"u_view"};
+        UniformLocation uProj{"u_proj"};
+    } u;
+
+    auto& view = *m_viewUniforms;
+    view.setUniformf(u.uTime, _rs.frameTime());
+    view.setUniformf(u.uDevicePixelRatio, m_pixelScale);
+    view.setUniformf(u.uResolution, glm::vec2(_view.getWidth(), _view.getHeight()));
+
+    const auto& mapPos = _view.getPosition();
+    view.setUniformf(u.uMapPosition, glm::vec3(mapPos.x, mapPos.y, _view.getZoom()));
+    view.setUniformMatrix3f(u.uNormalMatrix, _view.getNormalMatrix());
+    view.setUniformMatrix3f(u.uInverseNormalMatrix, _view.getInverseNormalMatrix());
+    view.setUniformf(u.uMetersPerPixel, float(1.0 / _view.pixelsPerMeter()));
+    view.setUniformMatrix4f(u.uView, _view.getViewMatrix());
+    view.setUniformMatrix4f(u.uProj, _view.getProjectionMatrix());
+
+    for (size_t i = 0; i < m_lights.size(); i++) {
+        if (m_lightUniformNames[i]) {
+            m_lights[i]->setupUniformBuffer(_view, *m_lightUniforms, *m_lightUniformNames[i]);
+        }
+    }
+}
+
 bool Scene::render(RenderState& _rs, View& _view) {
 
+    setupUniformBuffers(_rs, _view);
+
     bool drawnAnimatedStyle = false;
-    LOGD("skyway render style begin");
-    for (const auto& style : m_styles) {
-        LOGD("skyway render style - name = %s type = %s", style->getName().c_str(), style->getTypeName().c_str());
+    m_shadersPending = false;
+    LOGC(render, "skyway render style begin");
+    for (auto* style : m_drawOrder) {
+        LOGC(render, "skyway render style - name = %s type = %s", style->getName().c_str(), style->getTypeName().c_str());
+        auto styleStart = Metrics::start();
+        auto drawStats = _rs.drawStats();
+        _rs.gpuTimer().begin(GpuTimer::Pass::style, style->getName());
+
         bool styleDrawn = style->draw(_rs, _view,
                                       m_tileManager->getVisibleTiles(),
                                       m_markerManager->markers());
 
+        _rs.gpuTimer().end();
+        if (styleStart != Metrics::Clock::time_point()) {
+            Metrics::recordStyle(style->getName(), Metrics::Clock::now() - styleStart);
+
+            const auto& stats = _rs.drawStats();
+            PipelineMetrics::DrawCounts counts;
+            counts.drawCalls = stats.drawCalls - drawStats.drawCalls;
+            counts.vertices = stats.vertices - drawStats.vertices;
+            counts.stateChanges = stats.stateChanges - drawStats.stateChanges;
+            Metrics::countStyleDraws(style->getName(), counts);
+        }
+
         drawnAnimatedStyle |= (styleDrawn && style->isAnimated());
+        m_shadersPending |= style->shadersPending();
     }
-    LOGD("skyway render style finish");
+    LOGC(render, "skyway render style finish");
     return drawnAnimatedStyle;
 }
 
-void Scene::renderSelection(RenderState& _rs, View& _view, FrameBuffer& _selectionBuffer,
-                            std::vector<SelectionQuery>& _selectionQueries) {
+void Scene::renderView(RenderState& _rs, View& _view, size_t _index, const View& _mainView) {
+
+    // Tiles in both views keep the transforms of the main view, updated in
+    // update(), for the next frame
+    auto& tiles = m_tileManager->getViewTiles(_index);
+    m_tileTransforms.clear();
+    for (const auto& tile : tiles) {
+        m_tileTransforms.push_back(tile->getTransform());
+        tile->update(0, _view);
+    }
+
+    setupUniformBuffers(_rs, _view);
+
+    static const std::vector<std::unique_ptr<Marker>> noMarkers;
+    for (auto* style : m_drawOrder) {
+        if (style->type() == StyleType::point || style->type() == StyleType::text) { continue; }
+        style->draw(_rs, _view, tiles, noMarkers);
+    }
+
+    for (size_t i = 0; i < tiles.size(); i++) {
+        tiles[i]->setTransform(m_tileTransforms[i]);
+    }
+}
+
+bool Scene::renderSelection(RenderState& _rs, View& _view, FrameBuffer& _selectionBuffer,
+                            std::vector<SelectionQuery>& _selectionQueries, bool _fullFrame) {
+
+    // Region of the selection buffer around all query points
+    FrameBuffer::PixelRect region;
+    for (const auto& selectionQuery : _selectionQueries) {
+        auto rect = selectionQuery.rect(_view, _selectionBuffer);
+        if (region.width == 0 || region.height == 0) {
+            region = rect;
+        } else if (rect.width > 0 && rect.height > 0) {
+            int right = std::max(region.left + region.width, rect.left + rect.width);
+            int top = std::max(region.bottom + region.height, rect.bottom + rect.height);
+            region.left = std::min(region.left, rect.left);
+            region.bottom = std::min(region.bottom, rect.bottom);
+            region.width = right - region.left;
+            region.height = top - region.bottom;
+        }
+    }
+
+    _selectionBuffer.applyAsRenderTarget(_rs, ColorF(), _fullFrame ? nullptr : &region);
+
+    setupUniformBuffers(_rs, _view);
+
+    _rs.gpuTimer().begin(GpuTimer::Pass::selection);
 
     for (const auto& style : m_styles) {
 
@@ -564,12 +1174,30 @@ void Scene::renderSelection(RenderState& _rs, View& _view, FrameBuffer& _selecti
                                   m_markerManager->markers());
     }
 
-    std::vector<SelectionColorRead> colorCache;
-    /// Resolve feature selection queries
+    _rs.gpuTimer().end();
+
+    if (_selectionQueries.empty()) { return false; }
+
+    // Read back on the next frame without waiting for the GPU, when supported
+    if (_selectionBuffer.readPixelsAsync(region)) { return true; }
+
+    _selectionBuffer.readPixels(region);
+
+    for (const auto& selectionQuery : _selectionQueries) {
+        selectionQuery.process(_view, _selectionBuffer, region,
+                               *m_markerManager, *m_tileManager, *m_labelManager);
+    }
+    return false;
+}
+
+void Scene::resolveSelection(const View& _view, FrameBuffer& _selectionBuffer,
+                             const std::vector<SelectionQuery>& _selectionQueries) {
+
+    auto pixels = _selectionBuffer.mapPixels();
+
     for (const auto& selectionQuery : _selectionQueries) {
-        selectionQuery.process(_view, _selectionBuffer,
-                               *m_markerManager, *m_tileManager,
-                               *m_labelManager, colorCache);
+        selectionQuery.process(_view, _selectionBuffer, pixels,
+                               *m_markerManager, *m_tileManager, *m_labelManager);
     }
 }
 
@@ -581,6 +1209,53 @@ std::shared_ptr<Texture> Scene::getTexture(const std::string& textureName) const
     return texIt->second;
 }
 
+uint64_t Scene::tileCacheHash() const {
+    size_t seed = m_configHash;
+    hash_combine(seed, m_pixelScale);
+    return seed;
+}
+
+void Scene::getMemoryUsage(MemoryUsage& _usage) const {
+
+    m_tileManager->getMemoryUsage(_usage);
+
+    // Fonts and textures are added while the scene is loading
+    if (!isReady()) { return; }
+
+    m_fontContext->getMemoryUsage(_usage);
+
+    for (const auto& entry : m_textures.textures) {
+        if (!entry.second) { continue; }
+        _usage.cpuBytes[MemoryUsage::scene_textures] += entry.second->cpuBytes();
+        _usage.gpuBytes[MemoryUsage::scene_textures] += entry.second->gpuBytes();
+    }
+}
+
+size_t Scene::releaseMemory(size_t _bytes) {
+
+    // Tiles of the tile cache are built again from the tile data
+    auto& tileCache = m_tileManager->getTileCache();
+    size_t cached = tileCache->getMemoryUsage();
+    tileCache->trim(cached > _bytes ? cached - _bytes : 0);
+    size_t released = cached - tileCache->getMemoryUsage();
+    if (released >= _bytes) { return released; }
+
+    // Tile data is loaded again from the disk cache or the network
+    MemoryUsage usage;
+    m_tileManager->getMemoryUsage(usage);
+    m_tileManager->releaseSourceMemory();
+    released += usage.cpuBytes[MemoryUsage::data_cache];
+    if (released >= _bytes || !isReady()) { return released; }
+
+    // Text layouts are shaped again
+    MemoryUsage before, after;
+    m_fontContext->getMemoryUsage(before);
+    m_fontContext->releaseMemory();
+    m_fontContext->getMemoryUsage(after);
+    released += before.cpuBytes[MemoryUsage::font_cache] - after.cpuBytes[MemoryUsage::font_cache];
+    return released;
+}
+
 std::shared_ptr<TileSource> Scene::getTileSource(int32_t id) const {
     auto it = std::find_if(m_tileSources.begin(), m_tileSources.end(),
                            [&](auto& s){ return s->id() == id; });
@@ -1,9 +1,11 @@
 #pragma once
 
+#include "js/JavaScriptFwd.h"
 #include "map.h"
 #include "platform.h"
 #include "stops.h"
 #include "sceneOptions.h"
+#include "scene/qualityProfile.h"
 #include "text/fontContext.h" // For FontDescription
 #include "tile/tileManager.h"
 #include "util/color.h"
@@ -21,19 +23,27 @@
 #include <vector>
 #include <tuple>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "glm/vec2.hpp"
 #include "yaml-cpp/yaml.h"
 
 namespace Tangram {
 
+class DashAtlas;
 class DataLayer;
 class FeatureSelection;
+class FeatureState;
 class FontContext;
 class FrameBuffer;
+class IconAtlas;
 class Importer;
 class LabelManager;
 class Light;
+class LightCulling;
+class ProgramBinaryCache;
+class ShaderProgramCache;
+struct LightUniforms;
 class MapProjection;
 class MarkerManager;
 class Platform;
@@ -41,7 +51,9 @@ class SceneLayer;
 class SelectionQuery;
 class Style;
 class Texture;
+class TileDiskCache;
 class TileSource;
+class UniformBuffer;
 struct SceneLoader;
 
 struct SceneCamera : public Camera {
@@ -66,28 +78,48 @@ struct SceneTextures {
 
     std::unordered_map<std::string, std::shared_ptr<Texture>> textures;
 
+    // Dash patterns of all line styles, created by the first dashed style
+    std::shared_ptr<DashAtlas> dashAtlas;
+
+    // Small point icons of the scene and of markers
+    std::shared_ptr<IconAtlas> iconAtlas;
+
+    // Textures that shaders sample, which keep their own GL texture
+    std::unordered_set<const Texture*> shaderTextures;
+
     std::forward_list<Task> tasks;
 
+    SceneTextures();
+
     std::shared_ptr<Texture> add(const std::string& name, const Url& url,
                                  const TextureOptions& options);
 
-    std::shared_ptr<Texture> get(const std::string& name);
+    // Returns the texture called name, or adds one that is loaded from the
+    // URL name. Textures that are not only point icons are sampledByShader.
+    std::shared_ptr<Texture> get(const std::string& name, bool sampledByShader = true);
+
+    // Moves the decoded images of textures that are only drawn as point
+    // icons into the icon atlas
+    void packIcons();
 };
 
 struct SceneFonts {
     struct Task {
-        Task(Url url, FontDescription ft) : url(url), ft(ft) {}
+        Task(Url url, FontDescription ft, bool glyphFields = false)
+            : url(url), ft(ft), glyphFields(glyphFields) {}
         bool started = false;
         bool done = false;
         Url url;
         FontDescription ft;
+        // Pre-baked glyph distance fields instead of a font file
+        bool glyphFields;
         UrlRequestHandle requestHandle = 0;
-        UrlResponse response;
     };
     std::forward_list<Task> tasks;
 
     void add(const std::string& _uri, const std::string& _family,
-             const std::string& _style, const std::string& _weight);
+             const std::string& _style, const std::string& _weight,
+             bool _glyphFields = false);
 };
 
 class Scene {
@@ -105,18 +137,42 @@ public:
     /// Load the whole Scene
     bool load();
 
+    /// Apply SceneUpdates to the loaded Scene without loading it again: values
+    /// of uniforms, materials and dynamic lights are set without rebuilding
+    /// shaders or tiles; default draw parameters of styles, layers and source
+    /// parameters are updated in place and only the tiles of affected sources
+    /// are rebuilt. Returns false when the updates require to load the Scene again.
+    bool applyUpdates(const std::vector<SceneUpdate>& _updates);
+
     auto& tileSources() const { return m_tileSources; }
     auto& featureSelection() const { return m_featureSelection; }
+    auto& featureState() const { return m_featureState; }
     auto& fontContext() const { return m_fontContext; }
     
     const auto& config() const { return m_config; }
+    /// The 'global' node of the config, for TileBuilders while the config is updated
+    const auto& globals() const { return m_globals; }
+    const auto& loadTimes() const { return m_loadTimes; }
     const auto& functions() const { return m_jsFunctions; }
+    const auto& functionBytecode() const { return m_jsBytecode; }
     const auto& layers() const { return m_layers; }
+    const auto& drawRuleNames() const { return m_names; }
     const auto& lightBlocks() const { return m_lightShaderBlocks; }
     const auto& lights() const { return m_lights; }
+    /// Screen tiles of the lights with an outer radius, or null when the
+    /// scene has too few of them to be culled
+    LightCulling* lightCulling() const { return m_lightCulling.get(); }
+
+    /// Uniform buffers shared by the styles that read view and light
+    /// uniforms from uniform blocks, or null without SceneOptions::uniformBlocks
+    UniformBuffer* viewUniforms() const { return m_viewUniforms.get(); }
+    UniformBuffer* lightUniforms() const { return m_lightUniforms.get(); }
     const auto& options() const { return m_options; }
+    /// Tier in use, which is resolved for QualityTier::automatic
+    QualityTier qualityTier() const { return m_qualityProfile.tier; }
     const auto& styles() const { return m_styles; }
     const auto& textures() const { return m_textures.textures; }
+    const auto& iconAtlas() const { return m_textures.iconAtlas; }
 
     std::shared_ptr<TileSource> getTileSource(int32_t id) const;
     std::shared_ptr<Texture> getTexture(const std::string& name) const;
@@ -130,21 +186,59 @@ public:
     struct UpdateState {
         bool tilesLoading, animateLabels, animateMarkers;
     };
-    UpdateState update(const View& _view, float _dt);
+    /// Without _placeLabels, labels are moved with the view but keep their
+    /// last placement; animateLabels is then set to run a later update.
+    /// The tiles of _views are loaded along with those of _view for renderView().
+    UpdateState update(const View& _view, float _dt, bool _placeLabels = true,
+                       const std::vector<const View*>& _views = {});
 
     void renderBeginFrame(RenderState& _rs);
     bool render(RenderState& _rs, View& _view);
-    void renderSelection(RenderState& _rs, View& _view,
+    /// Draw the tiles of the additional view _index of update() for _view. Labels and
+    /// markers are placed for _mainView only and are not drawn.
+    void renderView(RenderState& _rs, View& _view, size_t _index, const View& _mainView);
+    /// Draw the selection pass around the query points, or the whole of it for _fullFrame,
+    /// and resolve the queries. Returns true when the pixels are read asynchronously and
+    /// the queries are to be resolved by resolveSelection() on the next frame.
+    bool renderSelection(RenderState& _rs, View& _view,
                          FrameBuffer& _selectionBuffer,
-                         std::vector<SelectionQuery>& _selectionQueries);
+                         std::vector<SelectionQuery>& _selectionQueries,
+                         bool _fullFrame);
+    void resolveSelection(const View& _view, FrameBuffer& _selectionBuffer,
+                          const std::vector<SelectionQuery>& _selectionQueries);
 
     Color backgroundColor(int _zoom) const;
+
+    /// Whether the last render() skipped styles whose shaders are still compiling
+    bool shadersPending() const { return m_shadersPending; }
     
     /// Used for FrameInfo debug
     TileManager* tileManager() const { return m_tileManager.get(); }
 
     MarkerManager* markerManager() const { return m_markerManager.get(); }
 
+    TileWorker* tileWorker() const { return m_tileWorker.get(); }
+
+    /// Persistent cache of tile geometry, null unless SceneOptions::tileDiskCachePath is set
+    TileDiskCache* tileDiskCache() const { return m_tileDiskCache.get(); }
+
+    /// Persistent cache of shader programs, null unless SceneOptions::shaderCachePath is set
+    ProgramBinaryCache* programBinaryCache() const { return m_programBinaryCache.get(); }
+
+    /// Shader programs shared by the styles of this scene
+    ShaderProgramCache& programCache() const { return *m_programCache; }
+
+    /// Hash of the scene configuration and pixel scale which tiles are built with
+    uint64_t tileCacheHash() const;
+
+    /// Adds the memory used by tiles, sources, fonts and textures of this scene to _usage
+    void getMemoryUsage(MemoryUsage& _usage) const;
+
+    /// Releases cached data until about _bytes were released or nothing is left to
+    /// release, in the order of the cost to recreate it: tiles of the tile cache,
+    /// tile data of the sources, then text layouts. Returns the released bytes.
+    size_t releaseMemory(size_t _bytes);
+
     const SceneError* errors() const {
         return (m_errors.empty() ? nullptr : &m_errors.front());
     }
@@ -168,6 +262,20 @@ public:
     /// Cancel scene loading and all TileManager tasks
     void cancelTasks();
 
+    /// Call before load(): the sources of this Scene copy the cached tile data
+    /// of the sources of _previous with the same configuration. With _adoptTiles,
+    /// sources whose layers and styles did not change either do not load tiles
+    /// until adoptTiles() takes them from _previous.
+    void setPreviousScene(Scene& _previous, bool _adoptTiles);
+
+    /// Take the tiles of the sources held by setPreviousScene() from _previous,
+    /// which is no longer drawn. Their labels are built again.
+    void adoptTiles(Scene& _previous);
+
+    /// Styles that are built into labels, which refer to the fonts and textures
+    /// of the Scene. Empty when the Scene has no label styles.
+    std::vector<bool> labelStyles() const;
+
     /// Returns true when scene finished loading and completeScene() suceeded.
     bool isReady() const { return m_state == State::ready; };
 
@@ -185,6 +293,7 @@ protected:
     Platform& m_platform;
 
     SceneOptions m_options;
+    QualityProfile m_qualityProfile;
     std::function<void(Scene*)> m_tilePrefetchCallback;
 
     std::unique_ptr<Importer> m_importer;
@@ -203,19 +312,56 @@ protected:
 
     State m_state = State::initial;
 
+    /// Milliseconds spent in the phases of load(). 'resources' is the time
+    /// spent waiting for fonts and textures after the scene was built.
+    struct LoadTimes {
+        float imports = 0;
+        float config = 0;
+        float sources = 0;
+        float styles = 0;
+        float layers = 0;
+        float functions = 0;
+        float resources = 0;
+        float total = 0;
+    };
+    LoadTimes m_loadTimes;
+
     /// ---------------------------------------------------------------///
     /// Loaded Scene Data
     /// The root node of the YAML scene configuration
     YAML::Node m_config;
 
+    /// m_config before globals were applied, base for applyUpdates()
+    YAML::Node m_baseConfig;
+
+    /// Set m_globals from m_config
+    void setGlobals();
+    YAML::Node m_globals;
+
     SceneCamera m_camera;
 
     Layers m_layers;
     TileSources m_tileSources;
     Styles m_styles;
+    /// Styles in the order they are drawn, see Style::drawOrder()
+    std::vector<Style*> m_drawOrder;
+
+    /// Whether the last update() did not place labels that needed placement
+    bool m_labelPlacementDeferred = false;
+
+    /// Transforms of the tiles drawn by renderView() for the main view
+    std::vector<Tile::Transform> m_tileTransforms;
 
     Lights m_lights;
     LightShaderBlocks m_lightShaderBlocks;
+    std::unique_ptr<LightCulling> m_lightCulling;
+
+    /// Set per frame in setupUniformBuffers(), before any style is drawn
+    void setupUniformBuffers(RenderState& _rs, const View& _view);
+    std::unique_ptr<UniformBuffer> m_viewUniforms;
+    std::unique_ptr<UniformBuffer> m_lightUniforms;
+    /// Uniform names of the dynamic lights, null for the others
+    std::vector<std::unique_ptr<LightUniforms>> m_lightUniformNames;
 
     void runTextureTasks();
     SceneTextures m_textures;
@@ -229,6 +375,8 @@ protected:
     DrawRuleNames m_names;
 
     SceneFunctions m_jsFunctions;
+    /// m_jsFunctions compiled once for the StyleContexts of all TileBuilders
+    std::vector<JSFunctionBytecode> m_jsBytecode;
     SceneStops m_stops;
 
     Color m_background;
@@ -239,16 +387,41 @@ protected:
     /// Runtime Data
     float m_pixelScale = 1.0f;
     float m_time = 0.0;
+    bool m_shadersPending = false;
 
     /// Set true when all resources for TileBuilder are available
     bool m_readyToBuildTiles = false;
 
     std::unique_ptr<FontContext> m_fontContext;
     std::unique_ptr<FeatureSelection> m_featureSelection;
+    std::unique_ptr<FeatureState> m_featureState;
     std::unique_ptr<TileWorker> m_tileWorker;
     std::unique_ptr<TileManager> m_tileManager;
     std::unique_ptr<MarkerManager> m_markerManager;
     std::unique_ptr<LabelManager> m_labelManager;
+    std::unique_ptr<TileDiskCache> m_tileDiskCache;
+    std::unique_ptr<ProgramBinaryCache> m_programBinaryCache;
+    std::unique_ptr<ShaderProgramCache> m_programCache;
+
+    /// Hash of m_config after SceneUpdates and globals were applied
+    uint64_t m_configHash = 0;
+
+    /// Hashes of the configuration of each source, and of what its tiles are
+    /// built with: the source, its layers and the configuration of the rest
+    /// but other sources and layers
+    struct SourceHash {
+        size_t data = 0;
+        size_t tiles = 0;
+    };
+    using SourceHashes = std::map<std::string, SourceHash>;
+    SourceHashes m_sourceHashes;
+    void setSourceHashes();
+
+    /// State of the Scene of setPreviousScene(), until load() copied its data
+    TileSources m_previousSources;
+    SourceHashes m_previousSourceHashes;
+    bool m_adoptTiles = false;
+    void copyPreviousSources();
 
     std::mutex m_sceneLoadMutex;
     std::mutex m_taskMutex;
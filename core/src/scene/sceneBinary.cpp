@@ -0,0 +1,270 @@
+#include "scene/sceneBinary.h"
+
+#include "log.h"
+#include "sceneOptions.h"
+#include "util/url.h"
+
+#include <cstring>
+#include <unordered_map>
+
+namespace Tangram {
+
+// Format, in native byte order:
+//   magic, uint32 version, uint64 hash,
+//   uint32 length and bytes of the scene directory URL,
+//   uint32 string count, then uint32 length and bytes per string,
+//   the root node.
+// Nodes are a uint8 NodeKind followed by
+//   scalar: uint8 ScalarTag, uint32 tag string (for ScalarTag::other), uint32 string
+//   sequence: uint32 count, the nodes
+//   map: uint32 count, the key and value nodes
+static const char SCENE_BINARY_MAGIC[4] = { 'T', 'G', 'S', 'B' };
+static const uint32_t SCENE_BINARY_VERSION = 1;
+
+// Deeper nodes are rejected as corrupt data
+static const int MAX_DEPTH = 256;
+
+enum class NodeKind : uint8_t { null, scalar, sequence, map };
+
+// Plain scalars are tagged "?" and quoted scalars "!" by the YAML parser
+enum class ScalarTag : uint8_t { plain, quoted, other };
+
+static uint64_t fnv1a(uint64_t _hash, const std::string& _str) {
+    for (unsigned char c : _str) {
+        _hash ^= c;
+        _hash *= 0x100000001b3;
+    }
+    // Separate consecutive strings
+    _hash ^= 0xff;
+    _hash *= 0x100000001b3;
+    return _hash;
+}
+
+// Directory of the scene, for rebasing URLs
+static std::string sceneDirectory(const Url& _sceneUrl) {
+    const auto& url = _sceneUrl.string();
+    return url.substr(0, url.rfind('/') + 1);
+}
+
+uint64_t SceneBinary::sourceHash(const SceneOptions& _options) {
+    uint64_t hash = 0xcbf29ce484222325;
+    hash = fnv1a(hash, _options.url.string());
+    hash = fnv1a(hash, _options.yaml);
+    for (const auto& update : _options.updates) {
+        hash = fnv1a(hash, update.path);
+        hash = fnv1a(hash, update.value);
+    }
+    return hash;
+}
+
+namespace {
+
+struct Writer {
+    std::vector<char> data;
+    std::unordered_map<std::string, uint32_t> stringIds;
+    std::vector<const std::string*> strings;
+    std::vector<char> nodes;
+
+    template<typename T>
+    static void put(std::vector<char>& _out, T _value) {
+        auto bytes = reinterpret_cast<const char*>(&_value);
+        _out.insert(_out.end(), bytes, bytes + sizeof(T));
+    }
+
+    static void putString(std::vector<char>& _out, const std::string& _str) {
+        put(_out, uint32_t(_str.size()));
+        _out.insert(_out.end(), _str.begin(), _str.end());
+    }
+
+    uint32_t stringId(const std::string& _str) {
+        auto it = stringIds.emplace(_str, uint32_t(strings.size()));
+        if (it.second) { strings.push_back(&it.first->first); }
+        return it.first->second;
+    }
+
+    void node(const YAML::Node& _node) {
+        switch (_node.Type()) {
+        case YAML::NodeType::Scalar: {
+            put(nodes, NodeKind::scalar);
+            const auto& tag = _node.Tag();
+            if (tag == "?") {
+                put(nodes, ScalarTag::plain);
+            } else if (tag == "!") {
+                put(nodes, ScalarTag::quoted);
+            } else {
+                put(nodes, ScalarTag::other);
+                put(nodes, stringId(tag));
+            }
+            put(nodes, stringId(_node.Scalar()));
+            break;
+        }
+        case YAML::NodeType::Sequence:
+            put(nodes, NodeKind::sequence);
+            put(nodes, uint32_t(_node.size()));
+            for (const auto& item : _node) { node(item); }
+            break;
+        case YAML::NodeType::Map:
+            put(nodes, NodeKind::map);
+            put(nodes, uint32_t(_node.size()));
+            for (const auto& entry : _node) {
+                node(entry.first);
+                node(entry.second);
+            }
+            break;
+        default:
+            put(nodes, NodeKind::null);
+            break;
+        }
+    }
+};
+
+struct Reader {
+    const std::vector<char>& data;
+    size_t pos = 0;
+    std::vector<std::string> strings;
+
+    template<typename T>
+    bool get(T& _value) {
+        if (pos + sizeof(T) > data.size()) { return false; }
+        std::memcpy(&_value, data.data() + pos, sizeof(T));
+        pos += sizeof(T);
+        return true;
+    }
+
+    bool getString(std::string& _str) {
+        uint32_t length = 0;
+        if (!get(length) || pos + length > data.size()) { return false; }
+        _str.assign(data.data() + pos, length);
+        pos += length;
+        return true;
+    }
+
+    bool getStringId(const std::string*& _str) {
+        uint32_t id = 0;
+        if (!get(id) || id >= strings.size()) { return false; }
+        _str = &strings[id];
+        return true;
+    }
+
+    bool node(YAML::Node& _node, int _depth) {
+        NodeKind kind;
+        if (_depth > MAX_DEPTH || !get(kind)) { return false; }
+
+        switch (kind) {
+        case NodeKind::null:
+            _node.reset(YAML::Node(YAML::NodeType::Null));
+            return true;
+        case NodeKind::scalar: {
+            ScalarTag tagKind;
+            const std::string* tag = nullptr;
+            const std::string* scalar = nullptr;
+            if (!get(tagKind)) { return false; }
+            if (tagKind == ScalarTag::other && !getStringId(tag)) { return false; }
+            if (!getStringId(scalar)) { return false; }
+            _node.reset(YAML::Node(*scalar));
+            if (tagKind == ScalarTag::plain) {
+                _node.SetTag("?");
+            } else if (tagKind == ScalarTag::quoted) {
+                _node.SetTag("!");
+            } else {
+                _node.SetTag(*tag);
+            }
+            return true;
+        }
+        case NodeKind::sequence: {
+            uint32_t count = 0;
+            if (!get(count)) { return false; }
+            _node.reset(YAML::Node(YAML::NodeType::Sequence));
+            for (uint32_t i = 0; i < count; i++) {
+                YAML::Node item;
+                if (!node(item, _depth + 1)) { return false; }
+                _node.push_back(item);
+            }
+            return true;
+        }
+        case NodeKind::map: {
+            uint32_t count = 0;
+            if (!get(count)) { return false; }
+            _node.reset(YAML::Node(YAML::NodeType::Map));
+            for (uint32_t i = 0; i < count; i++) {
+                YAML::Node key, value;
+                if (!node(key, _depth + 1) || !node(value, _depth + 1)) { return false; }
+                // Keys are unique in the written config, skip the lookup of operator[]
+                _node.force_insert(key, value);
+            }
+            return true;
+        }
+        }
+        return false;
+    }
+};
+
+}
+
+std::vector<char> SceneBinary::write(const YAML::Node& _config, uint64_t _hash,
+                                     const Url& _sceneUrl) {
+    Writer writer;
+    writer.node(_config);
+
+    auto& out = writer.data;
+    out.insert(out.end(), SCENE_BINARY_MAGIC, SCENE_BINARY_MAGIC + sizeof(SCENE_BINARY_MAGIC));
+    Writer::put(out, SCENE_BINARY_VERSION);
+    Writer::put(out, _hash);
+    Writer::putString(out, sceneDirectory(_sceneUrl));
+    Writer::put(out, uint32_t(writer.strings.size()));
+    for (const auto* str : writer.strings) {
+        Writer::putString(out, *str);
+    }
+    out.insert(out.end(), writer.nodes.begin(), writer.nodes.end());
+
+    return std::move(out);
+}
+
+YAML::Node SceneBinary::read(const std::vector<char>& _data, uint64_t _hash,
+                             const Url& _sceneUrl) {
+    Reader reader{_data};
+
+    char magic[4];
+    uint32_t version = 0;
+    uint64_t hash = 0;
+    std::string compiledDirectory;
+    uint32_t count = 0;
+
+    if (!reader.get(magic) || std::memcmp(magic, SCENE_BINARY_MAGIC, sizeof(magic)) != 0 ||
+        !reader.get(version) || version != SCENE_BINARY_VERSION) {
+        LOGE("Invalid precompiled scene");
+        return YAML::Node(YAML::NodeType::Undefined);
+    }
+    if (!reader.get(hash) || hash != _hash) {
+        LOGW("Precompiled scene was compiled for a different scene or updates");
+        return YAML::Node(YAML::NodeType::Undefined);
+    }
+    if (!reader.getString(compiledDirectory) || !reader.get(count)) {
+        LOGE("Invalid precompiled scene");
+        return YAML::Node(YAML::NodeType::Undefined);
+    }
+
+    // Rebase URLs that were resolved against the directory of the scene at compile time
+    std::string directory = sceneDirectory(_sceneUrl);
+    bool rebase = !compiledDirectory.empty() && compiledDirectory != directory;
+
+    reader.strings.resize(count);
+    for (auto& str : reader.strings) {
+        if (!reader.getString(str)) {
+            LOGE("Invalid precompiled scene");
+            return YAML::Node(YAML::NodeType::Undefined);
+        }
+        if (rebase && str.compare(0, compiledDirectory.size(), compiledDirectory) == 0) {
+            str.replace(0, compiledDirectory.size(), directory);
+        }
+    }
+
+    YAML::Node root;
+    if (!reader.node(root, 0) || !root.IsMap()) {
+        LOGE("Invalid precompiled scene");
+        return YAML::Node(YAML::NodeType::Undefined);
+    }
+    return root;
+}
+
+}
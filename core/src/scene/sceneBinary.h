@@ -0,0 +1,43 @@
+#pragma once
+
+#include "yaml-cpp/yaml.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Tangram {
+
+class SceneOptions;
+class Url;
+
+/* Precompiled scene config
+ *
+ * Stores the scene config with all imports merged and SceneUpdates applied
+ * as a compact binary node tree with a shared string table, so that it is
+ * restored without YAML parsing or import requests. The data is tagged with
+ * sourceHash() of the options it was compiled for and rejected for others.
+ *
+ * URLs below the directory of the scene are rebased to the directory of the
+ * scene URL at load time.
+ */
+class SceneBinary {
+
+public:
+
+    /// Hash of the scene URL or YAML string and the SceneUpdates. This is
+    /// stable across platforms, unlike std::hash.
+    static uint64_t sourceHash(const SceneOptions& _options);
+
+    /// Serialize _config, which was loaded from _sceneUrl
+    static std::vector<char> write(const YAML::Node& _config, uint64_t _hash,
+                                   const Url& _sceneUrl);
+
+    /// Returns an undefined node when _data is invalid or was
+    /// written for a different hash.
+    static YAML::Node read(const std::vector<char>& _data, uint64_t _hash,
+                           const Url& _sceneUrl);
+
+};
+
+}
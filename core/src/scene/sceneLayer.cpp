@@ -1,5 +1,6 @@
 #include "scene/sceneLayer.h"
 
+#include <algorithm>
 #include <type_traits>
 
 namespace Tangram {
@@ -11,6 +12,7 @@ SceneLayer::SceneLayer(std::string name, Filter filter,
                        std::vector<SceneLayer> sublayers,
                        Options options) :
     m_filter(std::move(filter)),
+    m_filterProgram(m_filter),
     m_name(std::move(name)),
     m_rules(std::move(rules)),
     m_sublayers(std::move(sublayers)),
@@ -33,6 +35,21 @@ SceneLayer::SceneLayer(std::string name, Filter filter,
                   // first.
                   return a.name() > b.name();
               });
+
+    m_filterKeys = m_filterProgram.keyIds();
+    m_matchIsCacheable = !m_filterProgram.hasFunctions();
+    m_batchFunctions = m_filterProgram.functions();
+
+    for (const auto& sublayer : m_sublayers) {
+        m_filterKeys.insert(m_filterKeys.end(), sublayer.filterKeys().begin(), sublayer.filterKeys().end());
+        m_matchIsCacheable &= sublayer.matchIsCacheable();
+        auto& functions = sublayer.filterProgram().functions();
+        m_batchFunctions.insert(m_batchFunctions.end(), functions.begin(), functions.end());
+    }
+    std::sort(m_filterKeys.begin(), m_filterKeys.end());
+    m_filterKeys.erase(std::unique(m_filterKeys.begin(), m_filterKeys.end()), m_filterKeys.end());
+    std::sort(m_batchFunctions.begin(), m_batchFunctions.end());
+    m_batchFunctions.erase(std::unique(m_batchFunctions.begin(), m_batchFunctions.end()), m_batchFunctions.end());
 }
 
 }
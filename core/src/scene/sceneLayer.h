@@ -26,6 +26,18 @@ public:
 
     const auto& name() const { return m_name; }
     const auto& filter() const { return m_filter; }
+    // m_filter compiled for faster evaluation
+    const auto& filterProgram() const { return m_filterProgram; }
+
+    // Property keys referenced by the filters of this layer and its sublayers
+    const auto& filterKeys() const { return m_filterKeys; }
+
+    // Whether matching this layer only depends on the values of filterKeys(),
+    // the geometry type and the zoom, i.e. no filter calls a scene function
+    bool matchIsCacheable() const { return m_matchIsCacheable; }
+    // Filter functions of this layer and its direct sublayers, which are
+    // evaluated for most features that the layer is applied to
+    const auto& batchFunctions() const { return m_batchFunctions; }
     const auto& rules() const { return m_rules; }
     const auto& sublayers() const { return m_sublayers; }
     auto priority() const { return m_options.priority; }
@@ -35,6 +47,10 @@ public:
 private:
 
     Filter m_filter;
+    FilterProgram m_filterProgram;
+    std::vector<Properties::KeyId> m_filterKeys;
+    bool m_matchIsCacheable = true;
+    std::vector<uint32_t> m_batchFunctions;
     std::string m_name;
     std::vector<DrawRuleData> m_rules;
     std::vector<SceneLayer> m_sublayers;
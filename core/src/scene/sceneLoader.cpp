@@ -4,6 +4,7 @@
 #include "data/memoryCacheDataSource.h"
 #include "data/mbtilesDataSource.h"
 #include "data/networkDataSource.h"
+#include "data/pmtilesDataSource.h"
 #include "data/rasterSource.h"
 #include "data/tileSource.h"
 #include "gl/shaderSource.h"
@@ -25,6 +26,7 @@
 #include "scene/stops.h"
 #include "scene/styleMixer.h"
 #include "scene/styleParam.h"
+#include "util/dashArray.h"
 #include "util/floatFormatter.h"
 #include "util/yamlPath.h"
 #include "util/yamlUtil.h"
@@ -38,6 +40,7 @@
 #include <cassert>
 #include <iterator>
 #include <regex>
+#include <set>
 #include <vector>
 
 using YAML::Node;
@@ -80,6 +83,246 @@ SceneError SceneLoader::applyUpdates(Node& _config, const std::vector<SceneUpdat
     return {};
 }
 
+static bool nodesEqual(const Node& _a, const Node& _b) {
+    if (!_a || !_b) { return !_a && !_b; }
+    if (_a.Type() != _b.Type()) { return false; }
+
+    switch (_a.Type()) {
+    case NodeType::Scalar:
+        return _a.Scalar() == _b.Scalar();
+    case NodeType::Sequence:
+        if (_a.size() != _b.size()) { return false; }
+        for (size_t i = 0; i < _a.size(); i++) {
+            if (!nodesEqual(_a[i], _b[i])) { return false; }
+        }
+        return true;
+    case NodeType::Map:
+        if (_a.size() != _b.size()) { return false; }
+        for (const auto& entry : _a) {
+            const Node& other = _b[entry.first.Scalar()];
+            if (!other || !nodesEqual(entry.second, other)) { return false; }
+        }
+        return true;
+    default:
+        return true;
+    }
+}
+
+// Whether only colors or shininess differ between the materials, which
+// does not change the shader of the style
+static bool materialValuesChanged(const Node& _a, const Node& _b) {
+    if (!_a || !_b || !_a.IsMap() || !_b.IsMap() || _a.size() != _b.size()) { return false; }
+
+    for (const auto& entry : _a) {
+        const auto& key = entry.first.Scalar();
+        const Node& other = _b[key];
+        if (!other) { return false; }
+        if (nodesEqual(entry.second, other)) { continue; }
+
+        if (key != "emission" && key != "ambient" && key != "diffuse" &&
+            key != "specular" && key != "shininess") {
+            return false;
+        }
+        // Material textures
+        if (entry.second.IsMap() || other.IsMap()) { return false; }
+    }
+    return true;
+}
+
+// Source of the layer when it is enabled, as in applySources()
+static bool enabledLayerSource(const Node& _layer, std::string& _source) {
+    if (!_layer.IsMap()) { return false; }
+
+    bool enabled = true;
+    if (const Node& n = _layer["enabled"]) {
+        YAML::convert<bool>::decode(n, enabled);
+    } else if (const Node& n = _layer["visible"]) {
+        YAML::convert<bool>::decode(n, enabled);
+    }
+    if (!enabled) { return false; }
+
+    const Node& data = _layer["data"];
+    if (!data || !data.IsMap()) { return false; }
+    const Node& source = data["source"];
+    if (!source || !source.IsScalar()) { return false; }
+
+    _source = source.Scalar();
+    return true;
+}
+
+SceneChanges SceneLoader::diffConfig(const Node& _current, const Node& _updated) {
+
+    SceneChanges changes;
+
+    auto isMap = [](const Node& _node) { return _node && _node.IsMap(); };
+
+    // Call _fn with the entries of each key of the maps _a and _b, entries
+    // missing in one of the maps are undefined nodes
+    auto forEachEntry = [](const Node& _a, const Node& _b, auto _fn) {
+        for (const auto& entry : _a) {
+            const auto& key = entry.first.Scalar();
+            _fn(key, entry.second, _b[key]);
+        }
+        for (const auto& entry : _b) {
+            const auto& key = entry.first.Scalar();
+            if (!_a[key]) { _fn(key, _a[key], entry.second); }
+        }
+    };
+
+    forEachEntry(_current, _updated, [&](const std::string& _key, const Node& _a, const Node& _b) {
+        if (nodesEqual(_a, _b)) { return; }
+
+        if (_key == "global") {
+            // Globals are substituted into the other sections, but JS functions
+            // may also read them at runtime
+            changes.globals = true;
+
+        } else if (_key == "styles") {
+            if (!isMap(_a) || !isMap(_b)) {
+                changes.reload = true;
+                return;
+            }
+            forEachEntry(_a, _b, [&](const std::string& _name, const Node& _sa, const Node& _sb) {
+                if (nodesEqual(_sa, _sb)) { return; }
+                if (!isMap(_sa) || !isMap(_sb)) {
+                    changes.reload = true;
+                    return;
+                }
+                // Anything but values of uniforms and materials and default draw
+                // rules changes the shaders or the meshes of the style
+                auto uniformsOf = [&](const Node& _style) {
+                    const Node& shaders = _style["shaders"];
+                    return (isMap(shaders) && shaders["uniforms"]) ? Node(shaders["uniforms"]) : Node();
+                };
+                const Node ua = uniformsOf(_sa);
+                const Node ub = uniformsOf(_sb);
+
+                Node a = YAML::Clone(_sa);
+                Node b = YAML::Clone(_sb);
+                for (Node* style : { &a, &b }) {
+                    style->remove("draw");
+                    style->remove("material");
+                }
+                if (!ua.IsNull()) { a["shaders"].remove("uniforms"); }
+                if (!ub.IsNull()) { b["shaders"].remove("uniforms"); }
+                if (!nodesEqual(a, b)) {
+                    changes.reload = true;
+                    return;
+                }
+
+                const Node& ma = _sa["material"];
+                const Node& mb = _sb["material"];
+                if (!nodesEqual(ma, mb)) {
+                    if (!materialValuesChanged(ma, mb)) {
+                        changes.reload = true;
+                        return;
+                    }
+                    changes.materials.push_back(_name);
+                }
+                if (!nodesEqual(_sa["draw"], _sb["draw"])) {
+                    changes.styleParams.push_back(_name);
+                }
+                if (!nodesEqual(ua, ub)) {
+                    // Uniform declarations must stay the same
+                    bool sameNames = isMap(ua) && isMap(ub) && ua.size() == ub.size();
+                    if (sameNames) {
+                        for (const auto& uniform : ua) {
+                            if (!ub[uniform.first.Scalar()]) { sameNames = false; }
+                        }
+                    }
+                    if (!sameNames) {
+                        changes.reload = true;
+                        return;
+                    }
+                    changes.uniforms.push_back(_name);
+                }
+            });
+
+        } else if (_key == "layers") {
+            if (!isMap(_a) || !isMap(_b)) {
+                changes.reload = true;
+                return;
+            }
+            // Layers that enable or disable a source change the tile sets
+            std::set<std::string> sourcesA, sourcesB;
+            std::string source;
+            for (const auto& layer : _a) {
+                if (enabledLayerSource(layer.second, source)) { sourcesA.insert(source); }
+            }
+            for (const auto& layer : _b) {
+                if (enabledLayerSource(layer.second, source)) { sourcesB.insert(source); }
+            }
+            if (sourcesA != sourcesB) {
+                changes.reload = true;
+                return;
+            }
+
+            forEachEntry(_a, _b, [&](const std::string& _name, const Node& _la, const Node& _lb) {
+                if (nodesEqual(_la, _lb)) { return; }
+                changes.layers.push_back(_name);
+
+                // Disabled layers still may have had geometry in the tiles
+                for (const Node& layer : { _la, _lb }) {
+                    if (!isMap(layer)) { continue; }
+                    const Node& data = layer["data"];
+                    if (!data) { continue; }
+                    const Node& source = isMap(data) ? data["source"] : Node();
+                    if (source && source.IsScalar()) {
+                        changes.layerSources.insert(source.Scalar());
+                    } else {
+                        changes.reload = true;
+                    }
+                }
+            });
+
+        } else if (_key == "lights") {
+            if (!isMap(_a) || !isMap(_b)) {
+                changes.reload = true;
+                return;
+            }
+            forEachEntry(_a, _b, [&](const std::string& _name, const Node& _la, const Node& _lb) {
+                if (nodesEqual(_la, _lb)) { return; }
+                // Added or removed lights and parameters change the shaders
+                if (!isMap(_la) || !isMap(_lb) || _la.size() != _lb.size()) {
+                    changes.reload = true;
+                    return;
+                }
+                for (const auto& entry : _la) {
+                    const auto& key = entry.first.Scalar();
+                    const Node& other = _lb[key];
+                    if (!other || ((key == "type" || key == "origin" || key == "visible") &&
+                                   !nodesEqual(entry.second, other))) {
+                        changes.reload = true;
+                        return;
+                    }
+                }
+                changes.lights.push_back(_name);
+            });
+
+        } else if (_key == "sources") {
+            if (!isMap(_a) || !isMap(_b)) {
+                changes.reload = true;
+                return;
+            }
+            forEachEntry(_a, _b, [&](const std::string& _name, const Node& _sa, const Node& _sb) {
+                if (nodesEqual(_sa, _sb)) { return; }
+                // Added or removed sources change the tile sets
+                if (!_sa || !_sb) {
+                    changes.reload = true;
+                    return;
+                }
+                changes.sources.push_back(_name);
+            });
+
+        } else {
+            // Scene, cameras, fonts and textures
+            changes.reload = true;
+        }
+    });
+
+    return changes;
+}
+
 void createGlobalRefs(std::vector<std::pair<YamlPath, YamlPath>>& _globalRefs,
                       const Node& _node, YamlPathBuffer& _path) {
 
@@ -327,103 +570,105 @@ std::unique_ptr<Light> SceneLoader::loadLight(const std::pair<Node, Node>& _node
     std::unique_ptr<Light> sceneLight;
     if (type == "ambient") {
         sceneLight = std::make_unique<AmbientLight>(name);
-
     } else if (type == "directional") {
-        auto dLight(std::make_unique<DirectionalLight>(name));
+        sceneLight = std::make_unique<DirectionalLight>(name);
+    } else if (type == "point") {
+        sceneLight = std::make_unique<PointLight>(name);
+    } else if (type == "spotlight") {
+        sceneLight = std::make_unique<SpotLight>(name);
+    } else {
+        LOGNode("Invalid light type", light, "");
+        return nullptr;
+    }
 
-        if (const Node& directionNode = light["direction"]) {
+    loadLightProps(light, *sceneLight);
+
+    // Verify that light position parameters are consistent with the origin type
+    if (sceneLight->getType() == LightType::point || sceneLight->getType() == LightType::spot) {
+        auto pLight = static_cast<PointLight&>(*sceneLight);
+        auto lightPosition = pLight.getPosition();
+        LightOrigin origin = pLight.getOrigin();
+
+        if (origin == LightOrigin::world) {
+            if (lightPosition.units[0] == Unit::pixel || lightPosition.units[1] == Unit::pixel) {
+                LOGW("Light position with attachment %s may not be used with unit of type %s",
+                    lightOriginString(origin).c_str(), unitToString(Unit::pixel).c_str());
+                LOGW("Long/Lat expected in meters");
+            }
+        }
+    }
+    return sceneLight;
+}
+
+void SceneLoader::loadLightProps(const Node& _light, Light& _sceneLight) {
+
+    if (_sceneLight.getType() == LightType::directional) {
+        auto& dLight = static_cast<DirectionalLight&>(_sceneLight);
+
+        if (const Node& directionNode = _light["direction"]) {
             glm::vec3 direction;
             if (YamlUtil::parseVec<glm::vec3>(directionNode, direction)) {
-                dLight->setDirection(direction);
+                dLight.setDirection(direction);
             }
         }
-        sceneLight = std::move(dLight);
-
-    } else if (type == "point") {
-        auto pLight(std::make_unique<PointLight>(name));
+    } else if (_sceneLight.getType() == LightType::point || _sceneLight.getType() == LightType::spot) {
+        auto& pLight = static_cast<PointLight&>(_sceneLight);
 
-        if (const Node& position = light["position"]) {
-            parseLightPosition(position, *pLight);
+        if (const Node& position = _light["position"]) {
+            parseLightPosition(position, pLight);
         }
-        if (const Node& radius = light["radius"]) {
+        if (const Node& radius = _light["radius"]) {
             if (radius.size() > 1) {
-                pLight->setRadius(YamlUtil::getFloatOrDefault(radius[0], 0.f),
-                                  YamlUtil::getFloatOrDefault(radius[1], 0.f));
+                pLight.setRadius(YamlUtil::getFloatOrDefault(radius[0], 0.f),
+                                 YamlUtil::getFloatOrDefault(radius[1], 0.f));
             } else {
-                pLight->setRadius(YamlUtil::getFloatOrDefault(radius, 0.f));
+                pLight.setRadius(YamlUtil::getFloatOrDefault(radius, 0.f));
             }
         }
-        if (const Node& att = light["attenuation"]) {
-            float attenuation;
-            if (YamlUtil::getFloat(att, attenuation)) {
-                pLight->setAttenuation(attenuation);
+        if (_sceneLight.getType() == LightType::point) {
+            if (const Node& att = _light["attenuation"]) {
+                float attenuation;
+                if (YamlUtil::getFloat(att, attenuation)) {
+                    pLight.setAttenuation(attenuation);
+                }
             }
         }
-        sceneLight = std::move(pLight);
-
-    } else if (type == "spotlight") {
-        auto sLight(std::make_unique<SpotLight>(name));
+    }
+    if (_sceneLight.getType() == LightType::spot) {
+        auto& sLight = static_cast<SpotLight&>(_sceneLight);
 
-        if (const Node& position = light["position"]) {
-            parseLightPosition(position, *sLight);
-        }
-        if (const Node& directionNode = light["direction"]) {
+        if (const Node& directionNode = _light["direction"]) {
             glm::vec3 direction;
             if (YamlUtil::parseVec<glm::vec3>(directionNode, direction)) {
-                sLight->setDirection(direction);
+                sLight.setDirection(direction);
             }
         }
-        if (const Node& radius = light["radius"]) {
-            if (radius.size() > 1) {
-                sLight->setRadius(YamlUtil::getFloatOrDefault(radius[0], 0.f),
-                                  YamlUtil::getFloatOrDefault(radius[1], 0.f));
-            } else {
-                sLight->setRadius(YamlUtil::getFloatOrDefault(radius, 0.f));
-            }
-        }
-        if (const Node& angle = light["angle"]) {
-            sLight->setCutoffAngle(YamlUtil::getFloatOrDefault(angle, 0.f));
+        if (const Node& angle = _light["angle"]) {
+            sLight.setCutoffAngle(YamlUtil::getFloatOrDefault(angle, 0.f));
         }
-        if (const Node& exponent = light["exponent"]) {
-            sLight->setCutoffExponent(YamlUtil::getFloatOrDefault(exponent, 0.f));
+        if (const Node& exponent = _light["exponent"]) {
+            sLight.setCutoffExponent(YamlUtil::getFloatOrDefault(exponent, 0.f));
         }
-        sceneLight = std::move(sLight);
     }
-    if (const Node& origin = light["origin"]) {
+    if (const Node& origin = _light["origin"]) {
         const std::string& originStr = origin.Scalar();
         if (originStr == "world") {
-            sceneLight->setOrigin(LightOrigin::world);
+            _sceneLight.setOrigin(LightOrigin::world);
         } else if (originStr == "camera") {
-            sceneLight->setOrigin(LightOrigin::camera);
+            _sceneLight.setOrigin(LightOrigin::camera);
         } else if (originStr == "ground") {
-            sceneLight->setOrigin(LightOrigin::ground);
+            _sceneLight.setOrigin(LightOrigin::ground);
         }
     }
-    if (const Node& ambient = light["ambient"]) {
-        sceneLight->setAmbientColor(YamlUtil::getColorAsVec4(ambient));
-    }
-    if (const Node& diffuse = light["diffuse"]) {
-        sceneLight->setDiffuseColor(YamlUtil::getColorAsVec4(diffuse));
+    if (const Node& ambient = _light["ambient"]) {
+        _sceneLight.setAmbientColor(YamlUtil::getColorAsVec4(ambient));
     }
-    if (const Node& specular = light["specular"]) {
-        sceneLight->setSpecularColor(YamlUtil::getColorAsVec4(specular));
+    if (const Node& diffuse = _light["diffuse"]) {
+        _sceneLight.setDiffuseColor(YamlUtil::getColorAsVec4(diffuse));
     }
-
-    // Verify that light position parameters are consistent with the origin type
-    if (sceneLight->getType() == LightType::point || sceneLight->getType() == LightType::spot) {
-        auto pLight = static_cast<PointLight&>(*sceneLight);
-        auto lightPosition = pLight.getPosition();
-        LightOrigin origin = pLight.getOrigin();
-
-        if (origin == LightOrigin::world) {
-            if (lightPosition.units[0] == Unit::pixel || lightPosition.units[1] == Unit::pixel) {
-                LOGW("Light position with attachment %s may not be used with unit of type %s",
-                    lightOriginString(origin).c_str(), unitToString(Unit::pixel).c_str());
-                LOGW("Long/Lat expected in meters");
-            }
-        }
+    if (const Node& specular = _light["specular"]) {
+        _sceneLight.setSpecularColor(YamlUtil::getColorAsVec4(specular));
     }
-    return sceneLight;
 }
 
 void SceneLoader::parseLightPosition(const Node& _positionNode, PointLight& _light) {
@@ -574,7 +819,7 @@ void SceneLoader::loadFontDescription(const Node& _node, const std::string& _fam
         return;
     }
 
-    std::string style = "regular", weight = "400", uri;
+    std::string style = "regular", weight = "400", uri, fieldsUri;
     for (const auto& fontDesc : _node) {
         const std::string& key = fontDesc.first.Scalar();
         if (key == "weight") {
@@ -583,6 +828,8 @@ void SceneLoader::loadFontDescription(const Node& _node, const std::string& _fam
             style = fontDesc.second.Scalar();
         } else if (key == "url") {
             uri = fontDesc.second.Scalar();
+        } else if (key == "fields") {
+            fieldsUri = fontDesc.second.Scalar();
         } else if (key == "external") {
             LOGW("external: within fonts: is a no-op in native" \
                  " version of tangram (%s)", _family.c_str());
@@ -595,6 +842,10 @@ void SceneLoader::loadFontDescription(const Node& _node, const std::string& _fam
     }
 
     _fonts.add(uri, _family, style, weight);
+
+    if (!fieldsUri.empty()) {
+        _fonts.add(fieldsUri, _family, style, weight, true);
+    }
 }
 
 Scene::TileSources SceneLoader::applySources(const Node& _config, const SceneOptions& _options,
@@ -786,13 +1037,13 @@ std::shared_ptr<TileSource> SceneLoader::loadSource(const Node& _source, const s
 
     bool isTiled = NetworkDataSource::urlHasTilePattern(url);
 
-    bool isMBTilesFile = false;
-    {
-        const char* extStr = ".mbtiles";
-        const size_t extLength = strlen(extStr);
+    auto hasExtension = [&](const char* _ext) {
+        const size_t extLength = strlen(_ext);
         const size_t urlLength = url.length();
-        isMBTilesFile = urlLength > extLength && (url.compare(urlLength - extLength, extLength, extStr) == 0);
-    }
+        return urlLength > extLength && (url.compare(urlLength - extLength, extLength, _ext) == 0);
+    };
+    bool isMBTilesFile = hasExtension(".mbtiles");
+    bool isPMTilesFile = hasExtension(".pmtiles");
 
     if (const Node& tmsNode = _source["tms"]) {
         YamlUtil::getBool(tmsNode, urlOptions.isTms);
@@ -804,17 +1055,37 @@ std::shared_ptr<TileSource> SceneLoader::loadSource(const Node& _source, const s
 #ifdef TANGRAM_MBTILES_DATASOURCE
         // If we have MBTiles, we know the source is tiled.
         isTiled = true;
+        MBTilesOptions mbtilesOptions;
+        // Each connection has its own SQLite page cache
+        if (_options.lowMemory) { mbtilesOptions.connections = 1; }
+        int value = 0;
+        if (YamlUtil::getInt(_source["mbtiles_connections"], value) && value > 0) {
+            mbtilesOptions.connections = value;
+        }
+        if (YamlUtil::getInt(_source["mbtiles_batch_size"], value) && value > 0) {
+            mbtilesOptions.writeBatchSize = value;
+        }
+        if (YamlUtil::getInt(_source["mbtiles_write_interval"], value) && value >= 0) {
+            mbtilesOptions.writeInterval = std::chrono::milliseconds(value);
+        }
         // Create an MBTiles data source from the file at the url and add it to the source chain.
-        rawSources = std::make_unique<MBTilesDataSource>(_platform, _name, url, "");
+        rawSources = std::make_unique<MBTilesDataSource>(_platform, _name, url, "", false, false,
+                                                         mbtilesOptions);
 #else
         LOGE("MBTiles support is disabled. This source will be ignored: %s", _name.c_str());
         return nullptr;
 #endif
+    } else if (isPMTilesFile) {
+        // The archive is memory mapped, so its tiles need no in-memory cache
+        isTiled = true;
+        rawSources = std::make_unique<PMTilesDataSource>(_platform, url);
     } else if (isTiled) {
         auto cacheSize = _options.memoryTileCacheSize;
         if (cacheSize > 0) {
             auto cache = std::make_unique<MemoryCacheDataSource>();
             cache->setCacheSize(cacheSize);
+            cache->setCompression(_options.compressMemoryTileCache);
+            if (_options.sharedTileCache) { cache->setSharedCache(url); }
             rawSources = std::move(cache);
         }
 
@@ -833,7 +1104,16 @@ std::shared_ptr<TileSource> SceneLoader::loadSource(const Node& _source, const s
         if (auto genLabelCentroidsNode = _source["generate_label_centroids"]) {
             generateCentroids = true;
         }
-        sourcePtr = std::make_shared<ClientDataSource>(_platform, _name, url, generateCentroids, zoomOptions);
+        ClientDataSource::ClusterOptions clusterOptions;
+        YamlUtil::getBool(_source["cluster"], clusterOptions.enabled);
+        YamlUtil::getFloat(_source["cluster_radius"], clusterOptions.radius);
+        YamlUtil::getInt(_source["cluster_max_zoom"], clusterOptions.maxZoom);
+        ClientDataSource::TilingOptions tilingOptions;
+        YamlUtil::getInt(_source["index_max_zoom"], tilingOptions.indexMaxZoom);
+        YamlUtil::getInt(_source["index_max_points"], tilingOptions.indexMaxPoints);
+        YamlUtil::getBool(_source["release_features"], tilingOptions.releaseFeatures);
+        sourcePtr = std::make_shared<ClientDataSource>(_platform, _name, url, generateCentroids, zoomOptions,
+                                                       clusterOptions, tilingOptions);
     } else if (type == "Raster") {
         TextureOptions options;
         if (const Node& filtering = _source["filtering"]) {
@@ -841,7 +1121,10 @@ std::shared_ptr<TileSource> SceneLoader::loadSource(const Node& _source, const s
                 LOGW("Invalid texture filtering: %s", Dump(filtering).c_str());
             }
         }
-        sourcePtr = std::make_shared<RasterSource>(_name, std::move(rawSources), options, zoomOptions);
+        auto rasterSource = std::make_shared<RasterSource>(_name, std::move(rawSources), options, zoomOptions);
+        rasterSource->setTextureAtlas(YamlUtil::getBoolOrDefault(_source["texture_atlas"], true));
+        rasterSource->setImageDecoder(&_platform);
+        sourcePtr = rasterSource;
     } else {
         sourcePtr = std::make_shared<TileSource>(_name, std::move(rawSources), zoomOptions);
 
@@ -857,6 +1140,7 @@ std::shared_ptr<TileSource> SceneLoader::loadSource(const Node& _source, const s
                  "This source will be ignored.", _name.c_str());
             return nullptr;
         }
+        if (_options.sharedTileCache && isTiled) { sourcePtr->setSharedData(url); }
     }
 
     return sourcePtr;
@@ -881,7 +1165,7 @@ Scene::Styles SceneLoader::applyStyles(const Node& _node, SceneTextures& _textur
 
     StyleMixer mixer;
     try {
-        mixer.mixStyleNodes(_node);
+        mixer.mixStyleNodesCached(_node);
     } catch (const YAML::RepresentationException& e) {
         LOGNode("Mixing styles: '%s'", _node, e.what());
     }
@@ -906,6 +1190,7 @@ Scene::Styles SceneLoader::applyStyles(const Node& _node, SceneTextures& _textur
                 // post rule merging for any style parameter which was not assigned
                 // during merging step.
                 int ruleID = addDrawRuleName(_ruleNames, name);
+                addStyleNames(_ruleNames, params);
                 style->setDefaultDrawRule(std::make_unique<DrawRuleData>(name, ruleID,
                                                                          std::move(params)));
             }
@@ -992,6 +1277,19 @@ void SceneLoader::loadStyleProps(const Node& _styleNode, Style& _style, SceneTex
         else { LOGW("Invalid blend mode '%s'", blendMode.c_str()); }
     }
 
+    if (const Node& renderModeNode = _styleNode["render_mode"]) {
+        const std::string& renderMode = renderModeNode.Scalar();
+        if      (renderMode == "standard")      { _style.setRenderMode(RenderMode::standard); }
+        else if (renderMode == "front_to_back") { _style.setRenderMode(RenderMode::front_to_back); }
+        else if (renderMode == "depth_prepass") { _style.setRenderMode(RenderMode::depth_prepass); }
+        else { LOGW("Invalid render mode '%s'", renderMode.c_str()); }
+
+        if (_style.renderMode() != RenderMode::standard && _style.blendMode() != Blending::opaque) {
+            LOGW("Render mode '%s' of style '%s' is only used with opaque blending",
+                 renderMode.c_str(), _style.getName().c_str());
+        }
+    }
+
     if (const Node& blendOrderNode = _styleNode["blend_order"]) {
         int blendOrderValue;
         if (YamlUtil::getInt(blendOrderNode, blendOrderValue)) {
@@ -1008,6 +1306,15 @@ void SceneLoader::loadStyleProps(const Node& _styleNode, Style& _style, SceneTex
         }
     }
 
+    if (const Node& simplifyNode = _styleNode["simplify"]) {
+        float tolerance;
+        if (YamlUtil::getFloat(simplifyNode, tolerance) && tolerance >= 0) {
+            _style.setSimplifyTolerance(tolerance);
+        } else {
+            LOGW("Invalid simplify tolerance: %s", Dump(simplifyNode).c_str());
+        }
+    }
+
     if (const Node& dashNode = _styleNode["dash"]) {
         if (auto polylineStyle = dynamic_cast<PolylineStyle*>(&_style)) {
             if (dashNode.IsSequence()) {
@@ -1019,7 +1326,10 @@ void SceneLoader::loadStyleProps(const Node& _styleNode, Style& _style, SceneTex
                         dashValues.push_back(floatValue);
                     }
                 }
-                polylineStyle->setDashArray(dashValues);
+                if (!_textures.dashAtlas) {
+                    _textures.dashAtlas = std::make_shared<DashAtlas>();
+                }
+                polylineStyle->setDashArray(dashValues, _textures.dashAtlas);
                 polylineStyle->setTexCoordsGeneration(true);
             }
         }
@@ -1048,7 +1358,7 @@ void SceneLoader::loadStyleProps(const Node& _styleNode, Style& _style, SceneTex
     if (const Node& textureNode = _styleNode["texture"]) {
         if (auto pointStyle = dynamic_cast<PointStyle*>(&_style)) {
             const std::string& textureName = textureNode.Scalar();
-            auto styleTexture = _textures.get(textureName);
+            auto styleTexture = _textures.get(textureName, false);
             if (styleTexture) {
                 pointStyle->setDefaultTexture(styleTexture);
             } else {
@@ -1121,24 +1431,24 @@ void SceneLoader::parseStyleParams(const Node& _params, const std::string& _pref
                 auto styleKey = StyleParam::getKey(key);
                 if (styleKey != StyleParamKey::none) {
 
-                    if (StyleParam::isColor(styleKey)) {
-                        _stops.push_back(Stops::Colors(value));
+                    auto addStops = [&](Stops&& stops) {
+                        stops.buildTable(styleKey);
+                        _stops.push_back(std::move(stops));
                         _out.push_back(StyleParam{ styleKey, &_stops.back() });
+                    };
+
+                    if (StyleParam::isColor(styleKey)) {
+                        addStops(Stops::Colors(value));
                     } else if (StyleParam::isSize(styleKey)) {
-                        _stops.push_back(Stops::Sizes(value, StyleParam::unitSetForStyleParam(styleKey)));
-                        _out.push_back(StyleParam{ styleKey, &_stops.back() });
+                        addStops(Stops::Sizes(value, StyleParam::unitSetForStyleParam(styleKey)));
                     } else if (StyleParam::isWidth(styleKey)) {
-                        _stops.push_back(Stops::Widths(value, StyleParam::unitSetForStyleParam(styleKey)));
-                        _out.push_back(StyleParam{ styleKey, &_stops.back() });
+                        addStops(Stops::Widths(value, StyleParam::unitSetForStyleParam(styleKey)));
                     } else if (StyleParam::isOffsets(styleKey)) {
-                        _stops.push_back(Stops::Offsets(value, StyleParam::unitSetForStyleParam(styleKey)));
-                        _out.push_back(StyleParam{ styleKey, &_stops.back() });
+                        addStops(Stops::Offsets(value, StyleParam::unitSetForStyleParam(styleKey)));
                     } else if (StyleParam::isFontSize(styleKey)) {
-                        _stops.push_back(Stops::FontSize(value));
-                        _out.push_back(StyleParam{ styleKey, &_stops.back() });
+                        addStops(Stops::FontSize(value));
                     } else if (StyleParam::isNumberType(styleKey)) {
-                        _stops.push_back(Stops::Numbers(value));
-                        _out.push_back(StyleParam{ styleKey, &_stops.back() });
+                        addStops(Stops::Numbers(value));
                     }
                 } else {
                     LOGW("Unknown style parameter %s", key.c_str());
@@ -1568,6 +1878,7 @@ SceneLayer SceneLoader::loadSublayer(const Node& _layer, const std::string& _lay
 
                 auto const& ruleName = ruleNode.first.Scalar();
                 int ruleId = addDrawRuleName(_ruleNames, ruleName);
+                addStyleNames(_ruleNames, params);
 
                 rules.emplace_back(ruleName, ruleId, std::move(params));
             }
@@ -1785,6 +2096,15 @@ int SceneLoader::addDrawRuleName(DrawRuleNames& _names, const std::string& _name
     return _names.size()-1;
 }
 
+void SceneLoader::addStyleNames(DrawRuleNames& _names, std::vector<StyleParam>& _params) {
+    for (auto& param : _params) {
+        if ((param.key == StyleParamKey::style || param.key == StyleParamKey::outline_style) &&
+            param.value.is<std::string>()) {
+            param.nameId = addDrawRuleName(_names, param.value.get<std::string>());
+        }
+    }
+}
+
 int SceneLoader::addSceneFunction(SceneFunctions& _functions, const std::string& _function) {
     for (size_t i = 0; i <_functions.size(); i++) {
         if (_functions.at(i) == _function) { return i; }
@@ -4,6 +4,7 @@
 #include "map.h"
 #include "scene/scene.h"
 
+#include <set>
 #include <string>
 #include <vector>
 
@@ -28,11 +29,37 @@ struct StyleUniform {
     UniformValue value;
 };
 
+// Changes between two scene configurations, by the parts of the scene they affect
+struct SceneChanges {
+    // Styles with new values of their shader uniforms
+    std::vector<std::string> uniforms;
+    // Styles with new material colors
+    std::vector<std::string> materials;
+    // Styles with new default draw parameters
+    std::vector<std::string> styleParams;
+    // Top-level layers with new filters or draw rules
+    std::vector<std::string> layers;
+    // Sources of the changed layers
+    std::set<std::string> layerSources;
+    // Lights with new colors, positions or directions
+    std::vector<std::string> lights;
+    // Sources with new parameters
+    std::vector<std::string> sources;
+    // New globals for JS functions
+    bool globals = false;
+    // Set for any change that requires to load the scene again
+    bool reload = false;
+};
+
 struct SceneLoader {
     using Node = YAML::Node;
 
     static SceneError applyUpdates(Node& config, const std::vector<SceneUpdate>& updates);
 
+    /// Classify the differences of the updated config, both with globals applied
+    /// and styles mixed
+    static SceneChanges diffConfig(const Node& current, const Node& updated);
+
     /// Global
     static void applyGlobals(const Node& source, Node& destination);
 
@@ -48,6 +75,7 @@ struct SceneLoader {
     /// Lights
     static Scene::Lights applyLights(const Node& lightsNode);
     static std::unique_ptr<Light> loadLight(const std::pair<Node, Node>& light);
+    static void loadLightProps(const Node& light, Light& sceneLight);
     static void parseLightPosition(const Node& positionNode, PointLight& light);
 
     /// Textures
@@ -102,6 +130,8 @@ struct SceneLoader {
     static bool getFilterRangeValue(const Node& node, double& val, bool& hasPixelArea);
 
     static int addDrawRuleName(DrawRuleNames& _names, const std::string& _name);
+    /// Add the style names of 'style' and 'outline_style' params to _names
+    static void addStyleNames(DrawRuleNames& _names, std::vector<StyleParam>& _params);
     static int addSceneFunction(SceneFunctions& _functions, const std::string& _function);
 
     SceneLoader() = delete;
@@ -1,6 +1,7 @@
 #include "scene/spotLight.h"
 
 #include "gl/shaderProgram.h"
+#include "gl/uniformBuffer.h"
 #include "platform.h"
 #include "spotLight_glsl.h"
 #include "util/floatFormatter.h"
@@ -46,17 +47,30 @@ void SpotLight::setupProgram(RenderState& rs, const View& _view, ShaderProgram&
                              LightUniforms& _uniforms) {
     PointLight::setupProgram(rs, _view, _shader, _uniforms);
 
-    glm::vec3 direction = m_direction;
-    if (m_origin == LightOrigin::world) {
-        direction = glm::normalize(_view.getNormalMatrix() * direction);
-    }
-
     auto& u = static_cast<Uniforms&>(_uniforms);
-    _shader.setUniformf(rs, u.direction, direction);
+    _shader.setUniformf(rs, u.direction, getViewDirection(_view));
     _shader.setUniformf(rs, u.spotCosCutoff, m_spotCosCutoff);
     _shader.setUniformf(rs, u.spotExponent, m_spotExponent);
 }
 
+void SpotLight::setupUniformBuffer(const View& _view, UniformBuffer& _buffer,
+                                   LightUniforms& _uniforms) {
+    PointLight::setupUniformBuffer(_view, _buffer, _uniforms);
+
+    auto& u = static_cast<Uniforms&>(_uniforms);
+    _buffer.setUniformf(u.direction, getViewDirection(_view));
+    _buffer.setUniformf(u.spotCosCutoff, m_spotCosCutoff);
+    _buffer.setUniformf(u.spotExponent, m_spotExponent);
+}
+
+glm::vec3 SpotLight::getViewDirection(const View& _view) const {
+
+    if (m_origin == LightOrigin::world) {
+        return glm::normalize(_view.getNormalMatrix() * m_direction);
+    }
+    return m_direction;
+}
+
 std::string SpotLight::getClassBlock() {
     return spotLight_glsl;
 }
@@ -23,6 +23,9 @@ public:
     virtual void setupProgram(RenderState& rs, const View& _view, ShaderProgram& _shader,
                               LightUniforms& _uniforms) override;
 
+    virtual void setupUniformBuffer(const View& _view, UniformBuffer& _buffer,
+                                    LightUniforms& _uniforms) override;
+
     struct Uniforms : public PointLight::Uniforms {
 
         Uniforms(const std::string& _name)
@@ -39,6 +42,9 @@ public:
     std::unique_ptr<LightUniforms> getUniforms() override;
 
 protected:
+    /*  Direction of the light in camera space */
+    glm::vec3 getViewDirection(const View& _view) const;
+
     /*  GLSL block code with structs and need functions for this light type */
     virtual std::string getClassBlock() override;
     virtual std::string getInstanceAssignBlock() override;
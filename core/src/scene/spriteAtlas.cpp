@@ -4,17 +4,34 @@ namespace Tangram {
 
 SpriteAtlas::SpriteAtlas() {}
 
-void SpriteAtlas::addSpriteNode(const std::string& _name, glm::vec2 _origin, glm::vec2 _size) {
-    m_spritesNodes[_name] = SpriteNode { {}, {}, _size, _origin};
+int SpriteAtlas::addSpriteNode(const std::string& _name, glm::vec2 _origin, glm::vec2 _size) {
+    auto it = m_spriteIds.find(_name);
+    if (it != m_spriteIds.end()) {
+        m_spriteNodes[it->second] = SpriteNode { {}, {}, _size, _origin};
+        return it->second;
+    }
+
+    int id = m_spriteNodes.size();
+    m_spriteNodes.push_back(SpriteNode { {}, {}, _size, _origin});
+    m_spriteIds[_name] = id;
+    return id;
+}
+
+int SpriteAtlas::getSpriteId(const std::string& _name) const {
+    auto it = m_spriteIds.find(_name);
+    if (it == m_spriteIds.end()) {
+        return -1;
+    }
+    return it->second;
 }
 
 bool SpriteAtlas::getSpriteNode(const std::string& _name, SpriteNode& _node) const {
-    auto it = m_spritesNodes.find(_name);
-    if (it == m_spritesNodes.end()) {
+    int id = getSpriteId(_name);
+    if (id < 0) {
         return false;
     }
 
-    _node = it->second;
+    _node = m_spriteNodes[id];
     return true;
 }
 
@@ -22,18 +39,18 @@ void SpriteAtlas::updateSpriteNodes(const glm::vec2& _textureSize) {
     float atlasWidth = _textureSize.x;
     float atlasHeight = _textureSize.y;
 
-    for (auto& spriteNode : m_spritesNodes) {
+    for (auto& spriteNode : m_spriteNodes) {
 
-        const auto& origin = spriteNode.second.m_origin;
-        const auto& size = spriteNode.second.m_size;
+        const auto& origin = spriteNode.m_origin;
+        const auto& size = spriteNode.m_size;
 
         float uvL = origin.x / atlasWidth;
         float uvR = uvL + size.x / atlasWidth;
         float uvB = 1.f - origin.y / atlasHeight;
         float uvT = uvB - size.y / atlasHeight;
 
-        spriteNode.second.m_uvBL = { uvL, uvB };
-        spriteNode.second.m_uvTR = { uvR, uvT };
+        spriteNode.m_uvBL = { uvL, uvB };
+        spriteNode.m_uvTR = { uvR, uvT };
 
     }
 }
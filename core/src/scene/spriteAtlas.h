@@ -5,6 +5,7 @@
 #include "glm/glm.hpp"
 #include <map>
 #include <memory>
+#include <vector>
 
 namespace Tangram {
 
@@ -20,13 +21,19 @@ class SpriteAtlas {
 public:
     SpriteAtlas();
 
-    /* Creates a sprite node in the atlas located at _origin in the texture by a size in pixels _size */
-    void addSpriteNode(const std::string& _name, glm::vec2 _origin, glm::vec2 _size);
+    /* Creates a sprite node in the atlas located at _origin in the texture by a size in pixels _size,
+     * returns its id */
+    int addSpriteNode(const std::string& _name, glm::vec2 _origin, glm::vec2 _size);
     bool getSpriteNode(const std::string& _name, SpriteNode& _node) const;
     void updateSpriteNodes(const glm::vec2&  _textureSize);
 
+    /* Returns the id of the sprite node _name, or -1 */
+    int getSpriteId(const std::string& _name) const;
+    const SpriteNode& getSpriteNode(int _id) const { return m_spriteNodes[_id]; }
+
 private:
-    fastmap<std::string, SpriteNode> m_spritesNodes;
+    std::vector<SpriteNode> m_spriteNodes;
+    fastmap<std::string, int> m_spriteIds;
 };
 
 }
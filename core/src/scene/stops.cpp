@@ -7,6 +7,7 @@
 #include "util/mapProjection.h"
 
 #include <algorithm>
+#include <cmath>
 #include "csscolorparser.hpp"
 #include "yaml-cpp/yaml.h"
 
@@ -413,6 +414,66 @@ auto Stops::nearestHigherFrame(float _key) const -> std::vector<Frame>::const_it
                             [](const Frame& f, float z) { return f.key < z; });
 }
 
+void Stops::buildTable(StyleParamKey _key) {
+
+    table = Table{};
+
+    if (frames.empty() || StyleParam::isSize(_key)) { return; }
+
+    float start = frames.front().key;
+    float span = frames.back().key - start;
+    size_t count = size_t(std::ceil(span * table_resolution)) + 1;
+    if (count > max_table_samples) { return; }
+
+    Table result;
+    result.start = start;
+    result.components = StyleParam::isColor(_key) ? 4 : StyleParam::isOffsets(_key) ? 2 : 1;
+    result.samples.reserve(count * result.components);
+
+    for (size_t i = 0; i < count; i++) {
+        StyleParam::Value value;
+        eval(*this, _key, start + i / table_resolution, value);
+
+        if (value.is<uint32_t>()) {
+            Color color(value.get<uint32_t>());
+            result.samples.insert(result.samples.end(), { float(color.r), float(color.g),
+                                                          float(color.b), float(color.a) });
+        } else if (value.is<glm::vec2>()) {
+            auto v = value.get<glm::vec2>();
+            result.samples.insert(result.samples.end(), { v.x, v.y });
+        } else {
+            result.samples.push_back(value.get<float>());
+        }
+    }
+    table = std::move(result);
+}
+
+auto Stops::evalTable(float _key) const -> StyleParam::Value {
+
+    size_t count = table.samples.size() / table.components;
+    float pos = std::min(std::max((_key - table.start) * table_resolution, 0.f), float(count - 1));
+
+    size_t i = size_t(pos);
+    size_t j = std::min(i + 1, count - 1);
+    float lerp = pos - i;
+
+    const float* a = &table.samples[i * table.components];
+    const float* b = &table.samples[j * table.components];
+
+    switch (table.components) {
+    case 4:
+        return Color(a[0] * (1 - lerp) + b[0] * lerp,
+                     a[1] * (1 - lerp) + b[1] * lerp,
+                     a[2] * (1 - lerp) + b[2] * lerp,
+                     a[3] * (1 - lerp) + b[3] * lerp).abgr;
+    case 2:
+        return glm::vec2(a[0] * (1 - lerp) + b[0] * lerp,
+                         a[1] * (1 - lerp) + b[1] * lerp);
+    default:
+        return a[0] * (1 - lerp) + b[0] * lerp;
+    }
+}
+
 void Stops::eval(const Stops& _stops, StyleParamKey _key, float _zoom, StyleParam::Value& _result) {
 
     /* StyleParam::size stops can not have a generic evaluation, and
@@ -420,6 +481,11 @@ void Stops::eval(const Stops& _stops, StyleParamKey _key, float _zoom, StylePara
      */
     if (StyleParam::isSize(_key)) { return; }
 
+    if (!_stops.table.samples.empty()) {
+        _result = _stops.evalTable(_zoom);
+        return;
+    }
+
     if (StyleParam::isColor(_key)) {
         _result = _stops.evalColor(_zoom);
     } else if (StyleParam::isWidth(_key)) {
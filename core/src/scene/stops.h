@@ -29,6 +29,23 @@ struct Stops {
     };
 
     std::vector<Frame> frames;
+
+    /* Samples of eval() every 1/table_resolution zoom from the first to the
+     * last frame. eval() interpolates the two samples around the zoom instead
+     * of searching the frames. Empty when buildTable() was not called or the
+     * frames span more than max_table_samples.
+     */
+    struct Table {
+        float start = 0;
+        // 1 for float, 2 for vec2 and 4 for color values
+        int components = 0;
+        std::vector<float> samples;
+    };
+    Table table;
+
+    static constexpr float table_resolution = 16;
+    static constexpr size_t max_table_samples = 512;
+
     static Stops Colors(const YAML::Node& _node);
     static Stops Widths(const YAML::Node& _node, UnitSet _units);
     static Stops FontSize(const YAML::Node& _node);
@@ -48,6 +65,11 @@ struct Stops {
     auto evalSize(float _key, const glm::vec2& cssSize) const -> glm::vec2;
     auto nearestHigherFrame(float _key) const -> std::vector<Frame>::const_iterator;
 
+    /// Build the table for the evaluation of _key by eval()
+    void buildTable(StyleParamKey _key);
+
+    auto evalTable(float _key) const -> StyleParam::Value;
+
     static void eval(const Stops& _stops, StyleParamKey _key, float _zoom, StyleParam::Value& _result);
 };
 
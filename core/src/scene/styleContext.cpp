@@ -11,8 +11,16 @@
 #include "util/builders.h"
 #include "util/yamlUtil.h"
 
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
 namespace Tangram {
 
+constexpr size_t StyleContext::max_cached_results;
+
 static const std::vector<std::string> s_geometryStrings = {
     "", // unknown
     "point",
@@ -20,6 +28,599 @@ static const std::vector<std::string> s_geometryStrings = {
     "polygon",
 };
 
+// Result of a natively evaluated expression, with the value types of JS
+struct NativeValue {
+    enum class Type : uint8_t { undefined, null, boolean, number, string };
+
+    Type type = Type::undefined;
+    bool boolean = false;
+    double number = 0;
+    // Points to a literal or a feature property; 'buffer' holds computed strings
+    const std::string* string = nullptr;
+    std::string buffer;
+
+    const std::string& str() const { return string ? *string : buffer; }
+
+    bool isTruthy() const {
+        switch (type) {
+        case Type::boolean: return boolean;
+        case Type::number: return number != 0 && !std::isnan(number);
+        case Type::string: return !str().empty();
+        default: return false;
+        }
+    }
+};
+
+// A scene function of the form 'function() { return <expression>; }' compiled
+// to an expression tree which is evaluated without the JS engine.
+//
+// Supported are number, string, boolean, null and undefined literals, feature
+// properties, $zoom, $geometry and $meters_per_pixel, combined with ! - + * /,
+// comparisons, equality, && || and ?:. eval() returns false for the few cases
+// it does not implement like JS, e.g. converting numbers to strings; the caller
+// then runs the JS function instead.
+class NativeFunction {
+public:
+
+    // Returns null when _source is not a supported function
+    static std::unique_ptr<NativeFunction> compile(const std::string& _source);
+
+    bool eval(const Feature* _feature, const StyleContext& _ctx, NativeValue& _result) const {
+        if (!_feature) { return false; }
+        return eval(m_root, *_feature, _ctx, _result);
+    }
+
+private:
+
+    enum class Op : uint8_t {
+        literal, property, keyword,
+        logical_not, negate,
+        logical_and, logical_or, conditional,
+        equal, not_equal, strict_equal, strict_not_equal,
+        less, less_equal, greater, greater_equal,
+        add, subtract, multiply, divide,
+    };
+
+    struct Node {
+        Op op;
+        int32_t a = -1, b = -1, c = -1;
+        NativeValue::Type type = NativeValue::Type::undefined;
+        bool boolean = false;
+        double number = 0;
+        uint32_t string = 0;
+        Properties::KeyId key = 0;
+        FilterKeyword keyword = FilterKeyword::undefined;
+    };
+
+    struct Parser;
+
+    bool eval(int32_t _node, const Feature& _feature, const StyleContext& _ctx, NativeValue& _out) const;
+
+    static bool toNumber(const NativeValue& _value, double& _number);
+    static bool looseEqual(const NativeValue& _a, const NativeValue& _b, bool& _result);
+    static bool strictEqual(const NativeValue& _a, const NativeValue& _b);
+
+    std::vector<Node> m_nodes;
+    // String literals, referenced by Node::string. Never resized after compile().
+    std::vector<std::string> m_strings;
+    int32_t m_root = -1;
+};
+
+// Recursive descent parser for the supported subset of JS
+struct NativeFunction::Parser {
+    const char* pos;
+    const char* end;
+    NativeFunction& fn;
+
+    static bool isIdentChar(char c) {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$';
+    }
+
+    void skipSpace() {
+        while (pos < end && std::isspace(static_cast<unsigned char>(*pos))) { pos++; }
+    }
+
+    // Consume punctuator _token
+    bool accept(const char* _token) {
+        skipSpace();
+        size_t length = std::strlen(_token);
+        if (size_t(end - pos) < length || std::strncmp(pos, _token, length) != 0) { return false; }
+        pos += length;
+        return true;
+    }
+
+    // Consume the word _word when it is not the start of a longer identifier
+    bool acceptWord(const char* _word) {
+        skipSpace();
+        size_t length = std::strlen(_word);
+        if (size_t(end - pos) < length || std::strncmp(pos, _word, length) != 0) { return false; }
+        if (pos + length < end && isIdentChar(pos[length])) { return false; }
+        pos += length;
+        return true;
+    }
+
+    int32_t add(Node _node) {
+        fn.m_nodes.push_back(_node);
+        return int32_t(fn.m_nodes.size() - 1);
+    }
+
+    int32_t binary(Op _op, int32_t _a, int32_t _b) {
+        if (_a < 0 || _b < 0) { return -1; }
+        Node node;
+        node.op = _op;
+        node.a = _a;
+        node.b = _b;
+        return add(node);
+    }
+
+    int32_t stringLiteral(std::string _string) {
+        Node node;
+        node.op = Op::literal;
+        node.type = NativeValue::Type::string;
+        node.string = fn.m_strings.size();
+        fn.m_strings.push_back(std::move(_string));
+        return add(node);
+    }
+
+    bool parseString(std::string& _string) {
+        char quote = *pos++;
+        while (pos < end && *pos != quote) {
+            if (*pos == '\\') {
+                if (++pos == end) { return false; }
+                switch (*pos) {
+                case '\\': case '\'': case '"': _string += *pos; break;
+                case 'n': _string += '\n'; break;
+                case 't': _string += '\t'; break;
+                default: return false;
+                }
+                pos++;
+            } else if (*pos == '\n') {
+                return false;
+            } else {
+                _string += *pos++;
+            }
+        }
+        if (pos == end) { return false; }
+        pos++;
+        return true;
+    }
+
+    int32_t parsePrimary() {
+        skipSpace();
+        if (pos == end) { return -1; }
+
+        if (accept("(")) {
+            int32_t expr = parseConditional();
+            if (!accept(")")) { return -1; }
+            return expr;
+        }
+
+        if (*pos == '\'' || *pos == '"') {
+            std::string string;
+            if (!parseString(string)) { return -1; }
+            return stringLiteral(std::move(string));
+        }
+
+        if (std::isdigit(static_cast<unsigned char>(*pos)) || *pos == '.') {
+            // No hex, octal or binary literals
+            if (*pos == '0' && pos + 1 < end && std::isalpha(static_cast<unsigned char>(pos[1]))) {
+                return -1;
+            }
+            std::string literal;
+            while (pos < end && (std::isalnum(static_cast<unsigned char>(*pos)) || *pos == '.' ||
+                                 ((*pos == '+' || *pos == '-') && (pos[-1] == 'e' || pos[-1] == 'E')))) {
+                literal += *pos++;
+            }
+            char* endptr = nullptr;
+            double number = std::strtod(literal.c_str(), &endptr);
+            if (*endptr != '\0') { return -1; }
+            Node node;
+            node.op = Op::literal;
+            node.type = NativeValue::Type::number;
+            node.number = number;
+            return add(node);
+        }
+
+        Node node;
+        node.op = Op::literal;
+        if (acceptWord("true")) {
+            node.type = NativeValue::Type::boolean;
+            node.boolean = true;
+            return add(node);
+        }
+        if (acceptWord("false")) {
+            node.type = NativeValue::Type::boolean;
+            return add(node);
+        }
+        if (acceptWord("null")) {
+            node.type = NativeValue::Type::null;
+            return add(node);
+        }
+        if (acceptWord("undefined")) {
+            return add(node);
+        }
+
+        for (auto keyword : { FilterKeyword::zoom, FilterKeyword::geometry, FilterKeyword::meters_per_pixel }) {
+            if (acceptWord(filterKeywordToString(keyword).c_str())) {
+                node.op = Op::keyword;
+                node.keyword = keyword;
+                return add(node);
+            }
+        }
+
+        if (acceptWord("feature")) {
+            std::string key;
+            if (accept(".")) {
+                skipSpace();
+                while (pos < end && isIdentChar(*pos)) { key += *pos++; }
+                if (key.empty()) { return -1; }
+            } else if (accept("[")) {
+                skipSpace();
+                if (pos == end || (*pos != '\'' && *pos != '"')) { return -1; }
+                if (!parseString(key) || !accept("]")) { return -1; }
+            } else {
+                return -1;
+            }
+            // Method calls like feature.name.toUpperCase() are not supported
+            skipSpace();
+            if (pos < end && (*pos == '.' || *pos == '[' || *pos == '(')) { return -1; }
+
+            node.op = Op::property;
+            node.key = Properties::internKey(key);
+            return add(node);
+        }
+
+        // Other identifiers, function calls, objects, arrays, ...
+        return -1;
+    }
+
+    int32_t parseUnary() {
+        if (accept("!")) {
+            Node node;
+            node.op = Op::logical_not;
+            node.a = parseUnary();
+            return node.a < 0 ? -1 : add(node);
+        }
+        skipSpace();
+        if (pos < end && *pos == '-' && !(pos + 1 < end && pos[1] == '-')) {
+            pos++;
+            Node node;
+            node.op = Op::negate;
+            node.a = parseUnary();
+            return node.a < 0 ? -1 : add(node);
+        }
+        return parsePrimary();
+    }
+
+    int32_t parseMultiplicative() {
+        int32_t left = parseUnary();
+        while (left >= 0) {
+            if (accept("*=") || accept("/=")) { return -1; }
+            if (accept("*")) { left = binary(Op::multiply, left, parseUnary()); }
+            else if (accept("/")) { left = binary(Op::divide, left, parseUnary()); }
+            else { break; }
+        }
+        return left;
+    }
+
+    int32_t parseAdditive() {
+        int32_t left = parseMultiplicative();
+        while (left >= 0) {
+            if (accept("++") || accept("--") || accept("+=") || accept("-=")) { return -1; }
+            if (accept("+")) { left = binary(Op::add, left, parseMultiplicative()); }
+            else if (accept("-")) { left = binary(Op::subtract, left, parseMultiplicative()); }
+            else { break; }
+        }
+        return left;
+    }
+
+    int32_t parseRelational() {
+        int32_t left = parseAdditive();
+        while (left >= 0) {
+            if (accept("<<") || accept(">>")) { return -1; }
+            if (accept("<=")) { left = binary(Op::less_equal, left, parseAdditive()); }
+            else if (accept(">=")) { left = binary(Op::greater_equal, left, parseAdditive()); }
+            else if (accept("<")) { left = binary(Op::less, left, parseAdditive()); }
+            else if (accept(">")) { left = binary(Op::greater, left, parseAdditive()); }
+            else { break; }
+        }
+        return left;
+    }
+
+    int32_t parseEquality() {
+        int32_t left = parseRelational();
+        while (left >= 0) {
+            if (accept("===")) { left = binary(Op::strict_equal, left, parseRelational()); }
+            else if (accept("!==")) { left = binary(Op::strict_not_equal, left, parseRelational()); }
+            else if (accept("==")) { left = binary(Op::equal, left, parseRelational()); }
+            else if (accept("!=")) { left = binary(Op::not_equal, left, parseRelational()); }
+            else { break; }
+        }
+        return left;
+    }
+
+    int32_t parseAnd() {
+        int32_t left = parseEquality();
+        while (left >= 0 && accept("&&")) {
+            left = binary(Op::logical_and, left, parseEquality());
+        }
+        return left;
+    }
+
+    int32_t parseOr() {
+        int32_t left = parseAnd();
+        while (left >= 0 && accept("||")) {
+            left = binary(Op::logical_or, left, parseAnd());
+        }
+        return left;
+    }
+
+    int32_t parseConditional() {
+        int32_t condition = parseOr();
+        if (condition < 0 || !accept("?")) { return condition; }
+
+        Node node;
+        node.op = Op::conditional;
+        node.a = condition;
+        node.b = parseConditional();
+        if (node.b < 0 || !accept(":")) { return -1; }
+        node.c = parseConditional();
+        return node.c < 0 ? -1 : add(node);
+    }
+
+    // function() { return <expression>; }
+    int32_t parseFunction() {
+        if (!acceptWord("function") || !accept("(") || !accept(")") || !accept("{")) { return -1; }
+        if (!acceptWord("return")) { return -1; }
+
+        int32_t expr = parseConditional();
+        if (expr < 0) { return -1; }
+
+        accept(";");
+        if (!accept("}")) { return -1; }
+
+        skipSpace();
+        return pos == end ? expr : -1;
+    }
+};
+
+std::unique_ptr<NativeFunction> NativeFunction::compile(const std::string& _source) {
+    auto fn = std::make_unique<NativeFunction>();
+
+    Parser parser{ _source.data(), _source.data() + _source.size(), *fn };
+    fn->m_root = parser.parseFunction();
+
+    if (fn->m_root < 0) { return nullptr; }
+    return fn;
+}
+
+bool NativeFunction::toNumber(const NativeValue& _value, double& _number) {
+    using Type = NativeValue::Type;
+
+    switch (_value.type) {
+    case Type::undefined: _number = NAN; return true;
+    case Type::null: _number = 0; return true;
+    case Type::boolean: _number = _value.boolean ? 1 : 0; return true;
+    case Type::number: _number = _value.number; return true;
+    case Type::string: break;
+    }
+
+    const std::string& str = _value.str();
+    size_t begin = str.find_first_not_of(" \t\n\r\f\v");
+    if (begin == std::string::npos) {
+        _number = 0;
+        return true;
+    }
+    size_t last = str.find_last_not_of(" \t\n\r\f\v");
+    std::string trimmed = str.substr(begin, last - begin + 1);
+
+    for (char c : trimmed) {
+        if (std::isdigit(static_cast<unsigned char>(c)) || c == '.' || c == 'e' || c == 'E' ||
+            c == '+' || c == '-') {
+            continue;
+        }
+        // 'Infinity' and hex, octal or binary strings would need JS conversion rules
+        if (c == 'I' || c == 'x' || c == 'X' || c == 'o' || c == 'O' || c == 'b' || c == 'B') {
+            return false;
+        }
+        _number = NAN;
+        return true;
+    }
+
+    char* endptr = nullptr;
+    _number = std::strtod(trimmed.c_str(), &endptr);
+    if (*endptr != '\0') { _number = NAN; }
+    return true;
+}
+
+bool NativeFunction::strictEqual(const NativeValue& _a, const NativeValue& _b) {
+    using Type = NativeValue::Type;
+
+    if (_a.type != _b.type) { return false; }
+
+    switch (_a.type) {
+    case Type::boolean: return _a.boolean == _b.boolean;
+    case Type::number: return _a.number == _b.number;
+    case Type::string: return _a.str() == _b.str();
+    default: return true;
+    }
+}
+
+bool NativeFunction::looseEqual(const NativeValue& _a, const NativeValue& _b, bool& _result) {
+    using Type = NativeValue::Type;
+
+    if (_a.type == _b.type) {
+        _result = strictEqual(_a, _b);
+        return true;
+    }
+
+    bool aNullish = _a.type == Type::undefined || _a.type == Type::null;
+    bool bNullish = _b.type == Type::undefined || _b.type == Type::null;
+    if (aNullish || bNullish) {
+        _result = aNullish && bNullish;
+        return true;
+    }
+
+    // Remaining types are boolean, number and string which compare as numbers
+    double a, b;
+    if (!toNumber(_a, a) || !toNumber(_b, b)) { return false; }
+    _result = a == b;
+    return true;
+}
+
+bool NativeFunction::eval(int32_t _node, const Feature& _feature, const StyleContext& _ctx,
+                          NativeValue& _out) const {
+    using Type = NativeValue::Type;
+
+    const Node& node = m_nodes[_node];
+
+    auto setBoolean = [&](bool _value) {
+        _out.type = Type::boolean;
+        _out.boolean = _value;
+        return true;
+    };
+    auto setNumber = [&](double _value) {
+        _out.type = Type::number;
+        _out.number = _value;
+        return true;
+    };
+    auto setValue = [&](const Value& _value) {
+        if (_value.is<std::string>()) {
+            _out.type = Type::string;
+            _out.string = &_value.get<std::string>();
+        } else if (_value.is<double>()) {
+            setNumber(_value.get<double>());
+        } else {
+            _out.type = Type::undefined;
+        }
+        return true;
+    };
+
+    switch (node.op) {
+    case Op::literal:
+        _out.type = node.type;
+        _out.boolean = node.boolean;
+        _out.number = node.number;
+        _out.string = node.type == Type::string ? &m_strings[node.string] : nullptr;
+        return true;
+
+    case Op::property:
+        return setValue(_feature.props.get(node.key));
+
+    case Op::keyword: {
+        auto& value = _ctx.getKeyword(node.keyword);
+        // The JS global is not defined yet
+        if (value.is<none_type>()) { return false; }
+        return setValue(value);
+    }
+    case Op::logical_not:
+        if (!eval(node.a, _feature, _ctx, _out)) { return false; }
+        return setBoolean(!_out.isTruthy());
+
+    case Op::negate: {
+        double number;
+        if (!eval(node.a, _feature, _ctx, _out) || !toNumber(_out, number)) { return false; }
+        return setNumber(-number);
+    }
+    case Op::logical_and:
+        if (!eval(node.a, _feature, _ctx, _out)) { return false; }
+        return !_out.isTruthy() || eval(node.b, _feature, _ctx, _out);
+
+    case Op::logical_or:
+        if (!eval(node.a, _feature, _ctx, _out)) { return false; }
+        return _out.isTruthy() || eval(node.b, _feature, _ctx, _out);
+
+    case Op::conditional:
+        if (!eval(node.a, _feature, _ctx, _out)) { return false; }
+        return eval(_out.isTruthy() ? node.b : node.c, _feature, _ctx, _out);
+
+    default:
+        break;
+    }
+
+    // Binary operators
+    NativeValue a, b;
+    if (!eval(node.a, _feature, _ctx, a) || !eval(node.b, _feature, _ctx, b)) { return false; }
+
+    switch (node.op) {
+    case Op::strict_equal:
+        return setBoolean(strictEqual(a, b));
+
+    case Op::strict_not_equal:
+        return setBoolean(!strictEqual(a, b));
+
+    case Op::equal:
+    case Op::not_equal: {
+        bool equal;
+        if (!looseEqual(a, b, equal)) { return false; }
+        return setBoolean(node.op == Op::equal ? equal : !equal);
+    }
+    case Op::less:
+    case Op::less_equal:
+    case Op::greater:
+    case Op::greater_equal: {
+        if (a.type == Type::string && b.type == Type::string) {
+            int cmp = a.str().compare(b.str());
+            switch (node.op) {
+            case Op::less: return setBoolean(cmp < 0);
+            case Op::less_equal: return setBoolean(cmp <= 0);
+            case Op::greater: return setBoolean(cmp > 0);
+            default: return setBoolean(cmp >= 0);
+            }
+        }
+        double x, y;
+        if (!toNumber(a, x) || !toNumber(b, y)) { return false; }
+        // Comparisons with NaN are false
+        switch (node.op) {
+        case Op::less: return setBoolean(x < y);
+        case Op::less_equal: return setBoolean(x <= y);
+        case Op::greater: return setBoolean(x > y);
+        default: return setBoolean(x >= y);
+        }
+    }
+    case Op::add:
+        if (a.type == Type::string || b.type == Type::string) {
+            // Only concatenation of strings, number formatting is left to JS
+            if (a.type != Type::string || b.type != Type::string) { return false; }
+            _out.type = Type::string;
+            _out.buffer = a.str() + b.str();
+            _out.string = nullptr;
+            return true;
+        }
+        // fall through
+    case Op::subtract:
+    case Op::multiply:
+    case Op::divide: {
+        double x, y;
+        if (!toNumber(a, x) || !toNumber(b, y)) { return false; }
+        switch (node.op) {
+        case Op::add: return setNumber(x + y);
+        case Op::subtract: return setNumber(x - y);
+        case Op::multiply: return setNumber(x * y);
+        default: return setNumber(x / y);
+        }
+    }
+    default:
+        return false;
+    }
+}
+
+// Gives NativeValue the interface of JSValue used by evalStyle
+struct NativeResult {
+    const NativeValue& value;
+
+    bool isString() const { return value.type == NativeValue::Type::string; }
+    bool isBoolean() const { return value.type == NativeValue::Type::boolean; }
+    bool isNumber() const { return value.type == NativeValue::Type::number; }
+    bool isUndefined() const { return value.type == NativeValue::Type::undefined; }
+    bool isArray() const { return false; }
+    std::string toString() const { return value.str(); }
+    bool toBool() const { return value.boolean; }
+    double toDouble() const { return value.number; }
+    size_t getLength() const { return 0; }
+    NativeResult getValueAtIndex(size_t) const { return *this; }
+};
+
 StyleContext::StyleContext() {
     m_jsContext = std::make_unique<JSContext>();
 }
@@ -81,13 +682,18 @@ JSValue parseSceneGlobals(JSScope& jsScope, const YAML::Node& node) {
 
 void StyleContext::setSceneGlobals(const YAML::Node& sceneGlobals) {
 
-    if (!sceneGlobals) { return; }
+    if (!sceneGlobals || sceneGlobals.IsNull()) { return; }
 
     JSScope jsScope(*m_jsContext);
 
     auto jsValue = parseSceneGlobals(jsScope, sceneGlobals);
 
     m_jsContext->setGlobalValue("global", std::move(jsValue));
+
+    // Results may depend on the globals
+    for (auto& cache : m_functionCaches) {
+        cache.results.clear();
+    }
 }
 
 void StyleContext::initFunctions(const Scene& _scene) {
@@ -97,27 +703,90 @@ void StyleContext::initFunctions(const Scene& _scene) {
     }
     m_sceneId = _scene.id;
 
-    setSceneGlobals(_scene.config()["global"]);
-    setFunctions(_scene.functions());
+    auto start = std::chrono::steady_clock::now();
+
+    setSceneGlobals(_scene.globals());
+    setFunctions(_scene.functions(), _scene.functionBytecode());
+
+    m_functionSetupTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    LOGD("Scene function setup took %.2fms", m_functionSetupTime);
+}
+
+bool StyleContext::compileFunctions(const std::vector<std::string>& _functions,
+                                    std::vector<JSFunctionBytecode>& _bytecode) {
+    bool success = true;
+    _bytecode.resize(_functions.size());
+    for (size_t i = 0; i < _functions.size(); i++) {
+        success &= m_jsContext->compileFunction(_functions[i], _bytecode[i]);
+    }
+    return success;
+}
+
+// Whether a function gives the same result for the same inputs, as far as
+// can be told from its source
+static bool isDeterministic(const std::string& _function) {
+    return _function.find("random") == std::string::npos &&
+        _function.find("Date") == std::string::npos;
 }
 
 bool StyleContext::setFunctions(const std::vector<std::string>& _functions) {
+    return setFunctions(_functions, {});
+}
+
+bool StyleContext::setFunctions(const std::vector<std::string>& _functions,
+                                const std::vector<JSFunctionBytecode>& _bytecode) {
+    // Only use bytecode that was compiled from _functions
+    bool useBytecode = _bytecode.size() == _functions.size();
+
     uint32_t id = 0;
     bool success = true;
+    m_nativeFunctions.clear();
     for (auto& function : _functions) {
-        success &= m_jsContext->setFunction(id++, function);
+        m_nativeFunctions.push_back(NativeFunction::compile(function));
+        // The JS function is still needed when native evaluation bails out
+        if (useBytecode) {
+            success &= m_jsContext->setFunction(id, _bytecode[id]);
+        } else {
+            success &= m_jsContext->setFunction(id, function);
+        }
+        id++;
     }
 
     m_functionCount = id;
+    resetFunctionCaches(_functions);
+
+    LOG("Compiled %d of %d scene functions natively", int(nativeFunctionCount()), int(m_functionCount));
 
     return success;
 }
 
 bool StyleContext::addFunction(const std::string& _function) {
+    m_nativeFunctions.resize(m_functionCount);
+    m_nativeFunctions.push_back(NativeFunction::compile(_function));
     bool success = m_jsContext->setFunction(m_functionCount++, _function);
+    m_functionCaches.resize(m_functionCount);
+    m_functionCaches.back() = FunctionCache();
+    m_functionCaches.back().enabled = isDeterministic(_function);
     return success;
 }
 
+void StyleContext::resetFunctionCaches(const std::vector<std::string>& _functions) {
+    m_functionCaches.clear();
+    m_functionCaches.resize(_functions.size());
+    for (size_t i = 0; i < _functions.size(); i++) {
+        m_functionCaches[i].enabled = isDeterministic(_functions[i]);
+    }
+}
+
+size_t StyleContext::nativeFunctionCount() const {
+    return std::count_if(m_nativeFunctions.begin(), m_nativeFunctions.end(),
+                         [](auto& fn) { return bool(fn); });
+}
+
+const NativeFunction* StyleContext::getNativeFunction(FunctionID _id) const {
+    return _id < m_nativeFunctions.size() ? m_nativeFunctions[_id].get() : nullptr;
+}
+
 void StyleContext::setFeature(const Feature& _feature) {
 
     m_feature = &_feature;
@@ -171,25 +840,74 @@ double StyleContext::getPixelAreaScale() {
 }
 
 void StyleContext::clear() {
+    m_feature = nullptr;
     m_jsContext->setCurrentFeature(nullptr);
 }
 
-bool StyleContext::evalFilter(FunctionID _id) {
-    bool result = m_jsContext->evaluateBooleanFunction(_id);
-    return result;
+void StyleContext::evalFilterBatch(FunctionID _id, const std::vector<Feature>& _features) {
+    if (getNativeFunction(_id) || _features.empty()) { return; }
+
+    if (m_batchFeatures != _features.data()) {
+        clearFilterBatch();
+        m_batchFeatures = _features.data();
+        m_batchSize = _features.size();
+    }
+
+    // Keep the result buffers of previous batches
+    if (m_numFilterBatches == m_filterBatches.size()) {
+        m_filterBatches.emplace_back();
+    }
+    auto& batch = m_filterBatches[m_numFilterBatches];
+    batch.id = _id;
+    batch.results.resize(m_batchSize);
+
+    // $geometry is a JS global, evaluate runs of features with the same geometry type
+    bool success = true;
+    for (size_t begin = 0, end = 0; begin < m_batchSize && success; begin = end) {
+        const auto geometryType = _features[begin].geometryType;
+        while (end < m_batchSize && _features[end].geometryType == geometryType) { end++; }
+
+        setFeature(_features[begin]);
+        success = m_jsContext->evaluateBooleanFunctions(_id, &_features[begin], end - begin,
+                                                        &batch.results[begin]);
+    }
+    clear();
+
+    // Leave features of failed batches to evalFilter()
+    if (success) { m_numFilterBatches++; }
 }
 
-bool StyleContext::evalStyle(FunctionID _id, StyleParamKey _key, StyleParam::Value& _val) {
-    _val = none_type{};
+void StyleContext::clearFilterBatch() {
+    m_numFilterBatches = 0;
+    m_batchFeatures = nullptr;
+    m_batchSize = 0;
+}
 
-    JSScope jsScope(*m_jsContext);
-    auto jsValue = jsScope.getFunctionResult(_id);
-    if (!jsValue) {
-        return false;
+bool StyleContext::evalFilter(FunctionID _id) {
+    if (m_numFilterBatches > 0 && m_feature >= m_batchFeatures &&
+        m_feature < m_batchFeatures + m_batchSize) {
+        for (size_t i = 0; i < m_numFilterBatches; i++) {
+            if (m_filterBatches[i].id == _id) {
+                return m_filterBatches[i].results[m_feature - m_batchFeatures] != 0;
+            }
+        }
+    }
+    if (auto* native = getNativeFunction(_id)) {
+        NativeValue result;
+        if (native->eval(m_feature, *this, result)) {
+            return result.isTruthy();
+        }
     }
+    bool result = m_jsContext->evaluateBooleanFunction(_id);
+    return result;
+}
 
-    if (jsValue.isString()) {
-        std::string value = jsValue.toString();
+// Convert the result of a style function, a JSValue or NativeResult, to the
+// type of StyleParam _key.
+template<typename Result>
+static void convertStyleResult(Result& _result, StyleParamKey _key, StyleParam::Value& _val) {
+    if (_result.isString()) {
+        std::string value = _result.toString();
 
         switch (_key) {
             case StyleParamKey::outline_style:
@@ -223,8 +941,8 @@ bool StyleContext::evalStyle(FunctionID _id, StyleParamKey _key, StyleParam::Val
                 break;
         }
 
-    } else if (jsValue.isBoolean()) {
-        bool value = jsValue.toBool();
+    } else if (_result.isBoolean()) {
+        bool value = _result.toBool();
 
         switch (_key) {
             case StyleParamKey::interactive:
@@ -239,8 +957,8 @@ bool StyleContext::evalStyle(FunctionID _id, StyleParamKey _key, StyleParam::Val
                 break;
         }
 
-    } else if (jsValue.isArray()) {
-        auto len = jsValue.getLength();
+    } else if (_result.isArray()) {
+        auto len = _result.getLength();
 
         switch (_key) {
             case StyleParamKey::extrude: {
@@ -249,8 +967,8 @@ bool StyleContext::evalStyle(FunctionID _id, StyleParamKey _key, StyleParam::Val
                     break;
                 }
 
-                double v1 = jsValue.getValueAtIndex(0).toDouble();
-                double v2 = jsValue.getValueAtIndex(1).toDouble();
+                double v1 = _result.getValueAtIndex(0).toDouble();
+                double v2 = _result.getValueAtIndex(1).toDouble();
 
                 _val = glm::vec2(v1, v2);
                 break;
@@ -263,12 +981,12 @@ bool StyleContext::evalStyle(FunctionID _id, StyleParamKey _key, StyleParam::Val
                     LOGW("Wrong array size for color: '%d'.", len);
                     break;
                 }
-                double r = jsValue.getValueAtIndex(0).toDouble();
-                double g = jsValue.getValueAtIndex(1).toDouble();
-                double b = jsValue.getValueAtIndex(2).toDouble();
+                double r = _result.getValueAtIndex(0).toDouble();
+                double g = _result.getValueAtIndex(1).toDouble();
+                double b = _result.getValueAtIndex(2).toDouble();
                 double a = 1.0;
                 if (len == 4) {
-                    a = jsValue.getValueAtIndex(3).toDouble();
+                    a = _result.getValueAtIndex(3).toDouble();
                 }
                 _val = ColorF(r, g, b, a).toColor().abgr;
                 break;
@@ -276,8 +994,8 @@ bool StyleContext::evalStyle(FunctionID _id, StyleParamKey _key, StyleParam::Val
             default:
                 break;
         }
-    } else if (jsValue.isNumber()) {
-        double number = jsValue.toDouble();
+    } else if (_result.isNumber()) {
+        double number = _result.toDouble();
         if (std::isnan(number)) {
             LOGD("duk evaluates JS method to NAN.\n");
         }
@@ -331,14 +1049,107 @@ bool StyleContext::evalStyle(FunctionID _id, StyleParamKey _key, StyleParam::Val
             default:
                 break;
         }
-    } else if (jsValue.isUndefined()) {
+    } else if (_result.isUndefined()) {
         // Explicitly set value as 'undefined'. This is important for some styling rules.
         _val = Undefined();
     } else {
         LOGW("Unhandled return type from Javascript style function for %d.", _key);
     }
 
+}
+
+bool StyleContext::evalStyle(FunctionID _id, StyleParamKey _key, StyleParam::Value& _val) {
+    _val = none_type{};
+
+    if (auto* native = getNativeFunction(_id)) {
+        NativeValue result;
+        // A null result is passed on to JS, which logs it as unhandled
+        if (native->eval(m_feature, *this, result) && result.type != NativeValue::Type::null) {
+            NativeResult nativeResult{result};
+            convertStyleResult(nativeResult, _key, _val);
+            return !_val.is<none_type>();
+        }
+    }
+
+    FunctionCache* cache = nullptr;
+    if (_id < m_functionCaches.size() && m_functionCaches[_id].enabled && m_feature) {
+        cache = &m_functionCaches[_id];
+
+        setCacheKey(*cache, _key);
+        auto it = cache->results.find(m_cacheKey);
+        if (it != cache->results.end()) {
+            m_cachedResults++;
+            _val = it->second;
+            return !_val.is<none_type>();
+        }
+        m_readProperties.clear();
+        m_jsContext->setPropertyTracking(&m_readProperties);
+    }
+
+    {
+        JSScope jsScope(*m_jsContext);
+        auto jsValue = jsScope.getFunctionResult(_id);
+        if (jsValue) {
+            convertStyleResult(jsValue, _key, _val);
+        }
+    }
+
+    if (cache) {
+        m_jsContext->setPropertyTracking(nullptr);
+        cacheResult(*cache, _key, _val);
+    }
+
     return !_val.is<none_type>();
 }
 
+void StyleContext::setCacheKey(const FunctionCache& _cache, StyleParamKey _key) {
+    auto append = [this](const void* _data, size_t _size) {
+        m_cacheKey.append(static_cast<const char*>(_data), _size);
+    };
+
+    m_cacheKey.clear();
+    append(&_key, sizeof(_key));
+    append(&m_feature->geometryType, sizeof(m_feature->geometryType));
+    append(&m_zoom, sizeof(m_zoom));
+
+    for (auto keyId : _cache.keyIds) {
+        const auto& value = m_feature->props.get(keyId);
+        if (value.is<double>()) {
+            m_cacheKey += 'n';
+            append(&value.get<double>(), sizeof(double));
+        } else if (value.is<std::string>()) {
+            const auto& string = value.get<std::string>();
+            uint32_t length = string.size();
+            m_cacheKey += 's';
+            append(&length, sizeof(length));
+            m_cacheKey += string;
+        } else {
+            m_cacheKey += 'u';
+        }
+    }
+}
+
+void StyleContext::cacheResult(FunctionCache& _cache, StyleParamKey _key, const StyleParam::Value& _val) {
+    // Earlier results stay valid, but they were keyed by fewer properties
+    bool newKeys = false;
+    for (auto& key : m_readProperties) {
+        if (std::find(_cache.keys.begin(), _cache.keys.end(), key) == _cache.keys.end()) {
+            _cache.keys.push_back(key);
+            _cache.keyIds.push_back(Properties::internKey(key));
+            newKeys = true;
+        }
+    }
+    if (newKeys) {
+        _cache.results.clear();
+        setCacheKey(_cache, _key);
+    }
+
+    if (_cache.results.size() >= max_cached_results) {
+        _cache.enabled = false;
+        _cache.results.clear();
+        return;
+    }
+    _cache.results.emplace(m_cacheKey, _val);
+}
+
 } // namespace Tangram
@@ -6,6 +6,8 @@
 #include <array>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace YAML {
     class Node;
@@ -13,6 +15,7 @@ namespace YAML {
 
 namespace Tangram {
 
+class NativeFunction;
 class Scene;
 struct Feature;
 struct StyleParam;
@@ -51,6 +54,12 @@ public:
     /// Called from Filter::eval
     bool evalFilter(FunctionID id);
 
+    /// Evaluate filter function id for all features at once. Until clearFilterBatch()
+    /// evalFilter(id) returns these results when the current feature is one of features.
+    /// Functions that are evaluated natively are not batched.
+    void evalFilterBatch(FunctionID id, const std::vector<Feature>& features);
+    void clearFilterBatch();
+
     /// Called from DrawRule::eval
     bool evalStyle(FunctionID id, StyleParamKey key, StyleParam::Value& value);
 
@@ -61,13 +70,49 @@ public:
     void clear();
 
     bool setFunctions(const std::vector<std::string>& functions);
+
+    /// Like setFunctions(functions) but loads the JS functions from bytecode
+    /// of compileFunctions(), when it matches the size of functions.
+    bool setFunctions(const std::vector<std::string>& functions,
+                      const std::vector<JSFunctionBytecode>& bytecode);
+
+    /// Compile functions once so that they can be loaded into other StyleContexts.
+    /// Entries of functions that fail to compile are left empty.
+    bool compileFunctions(const std::vector<std::string>& functions,
+                          std::vector<JSFunctionBytecode>& bytecode);
+
     bool addFunction(const std::string& function);
     void setSceneGlobals(const YAML::Node& sceneGlobals);
 
+    /// Number of functions that are evaluated natively instead of by the JS engine.
+    size_t nativeFunctionCount() const;
+
+    /// Milliseconds spent setting up globals and functions in the last initFunctions().
+    float functionSetupTime() const { return m_functionSetupTime; }
+
+    /// Number of evalStyle() calls answered from the results of earlier ones.
+    size_t cachedResultCount() const { return m_cachedResults; }
+
+    /// Results of a JS style function are cached by zoom level, geometry type
+    /// and the values of the feature properties that it reads, up to this
+    /// number of results. Functions with more distinct inputs are not cached.
+    static constexpr size_t max_cached_results = 256;
+
 private:
 
     void setKeyword(FilterKeyword keyword, Value value);
 
+    const NativeFunction* getNativeFunction(FunctionID id) const;
+
+    struct FunctionCache;
+
+    // Write the inputs of the function of _cache for the current feature to m_cacheKey
+    void setCacheKey(const FunctionCache& _cache, StyleParamKey _key);
+
+    void cacheResult(FunctionCache& _cache, StyleParamKey _key, const StyleParam::Value& _val);
+
+    void resetFunctionCaches(const std::vector<std::string>& _functions);
+
     std::array<Value, 4> m_keywordValues;
 
     // Cache zoom separately from keywords for easier access.
@@ -80,9 +125,40 @@ private:
 
     int32_t m_sceneId = -1;
 
+    float m_functionSetupTime = 0;
+
     const Feature* m_feature = nullptr;
 
     std::unique_ptr<JSContext> m_jsContext;
+
+    // Functions with a simple expression compiled to native code, by FunctionID.
+    // Null for functions that only run in m_jsContext.
+    std::vector<std::unique_ptr<NativeFunction>> m_nativeFunctions;
+
+    // Results of a JS style function by the values of the properties read by
+    // any of its evaluations. Two features with the same values take the same
+    // path through the function, unless it is not deterministic.
+    struct FunctionCache {
+        std::vector<std::string> keys;
+        std::vector<Properties::KeyId> keyIds;
+        std::unordered_map<std::string, StyleParam::Value> results;
+        bool enabled = true;
+    };
+    std::vector<FunctionCache> m_functionCaches;
+    std::string m_cacheKey;
+    // Properties read by the function being evaluated
+    std::vector<std::string> m_readProperties;
+    size_t m_cachedResults = 0;
+
+    // Results of evalFilterBatch() for the features starting at m_batchFeatures
+    struct FilterBatch {
+        FunctionID id;
+        std::vector<uint8_t> results;
+    };
+    std::vector<FilterBatch> m_filterBatches;
+    size_t m_numFilterBatches = 0;
+    const Feature* m_batchFeatures = nullptr;
+    size_t m_batchSize = 0;
 };
 
 }
@@ -4,11 +4,63 @@
 #include "util/topologicalSort.h"
 
 #include <algorithm>
+#include <cstdint>
+#include <mutex>
 #include <set>
 #include "yaml-cpp/yaml.h"
 
 namespace Tangram {
 
+// Number of mixed 'styles' sections kept by mixStyleNodesCached
+static const size_t MAX_CACHE_ENTRIES = 4;
+
+struct MixCacheEntry {
+    uint64_t hash;
+    YAML::Node styles;
+};
+
+// Most recently used entries first
+static std::vector<MixCacheEntry> s_mixCache;
+static std::mutex s_mixCacheMutex;
+
+// FNV-1a over the node structure, tags and scalars
+static uint64_t hashNode(uint64_t _hash, const YAML::Node& _node) {
+    auto add = [&](const std::string& _str) {
+        for (unsigned char c : _str) {
+            _hash ^= c;
+            _hash *= 0x100000001b3;
+        }
+        _hash ^= 0xff;
+        _hash *= 0x100000001b3;
+    };
+
+    _hash ^= uint64_t(_node.Type());
+    _hash *= 0x100000001b3;
+
+    switch (_node.Type()) {
+    case YAML::NodeType::Scalar:
+        add(_node.Tag());
+        add(_node.Scalar());
+        break;
+    case YAML::NodeType::Sequence:
+        _hash ^= _node.size();
+        _hash *= 0x100000001b3;
+        for (const auto& item : _node) { _hash = hashNode(_hash, item); }
+        break;
+    case YAML::NodeType::Map:
+        _hash ^= _node.size();
+        _hash *= 0x100000001b3;
+        for (const auto& entry : _node) {
+            _hash = hashNode(_hash, entry.first);
+            _hash = hashNode(_hash, entry.second);
+        }
+        break;
+    default:
+        break;
+    }
+    return _hash;
+}
+
 std::vector<std::string> StyleMixer::getStylesToMix(const Node& _style) {
 
     std::vector<std::string> names;
@@ -87,6 +139,39 @@ void StyleMixer::mixStyleNodes(Node _styles) {
     }
 }
 
+bool StyleMixer::mixStyleNodesCached(Node _styles) {
+
+    uint64_t hash = hashNode(0xcbf29ce484222325, _styles);
+
+    {
+        std::lock_guard<std::mutex> lock(s_mixCacheMutex);
+        for (auto it = s_mixCache.begin(); it != s_mixCache.end(); ++it) {
+            if (it->hash != hash) { continue; }
+            // The caller owns its copy, so that later changes to the
+            // scene config do not leak into the cache.
+            _styles = YAML::Clone(it->styles);
+            std::rotate(s_mixCache.begin(), it, it + 1);
+            return true;
+        }
+    }
+
+    mixStyleNodes(_styles);
+
+    MixCacheEntry entry{ hash, YAML::Clone(_styles) };
+
+    std::lock_guard<std::mutex> lock(s_mixCacheMutex);
+    s_mixCache.insert(s_mixCache.begin(), std::move(entry));
+    if (s_mixCache.size() > MAX_CACHE_ENTRIES) {
+        s_mixCache.pop_back();
+    }
+    return false;
+}
+
+void StyleMixer::clearCache() {
+    std::lock_guard<std::mutex> lock(s_mixCacheMutex);
+    s_mixCache.clear();
+}
+
 void StyleMixer::applyStyleMixins(Node _style, const std::vector<Node>& _mixins) {
 
     // Merge boolean flags as a disjunction.
@@ -28,6 +28,14 @@ public:
     // unless otherwise noted.
     void mixStyleNodes(Node _styles);
 
+    // Like mixStyleNodes, but reuses the output of an earlier call with equal
+    // input, e.g. when a scene is reloaded with updates to other sections.
+    // Returns whether the cached output was used.
+    bool mixStyleNodesCached(Node _styles);
+
+    // Drop all cached mixing output.
+    static void clearCache();
+
     // Apply the given list of 'mixin' styles to the first style.
     void applyStyleMixins(Node _style, const std::vector<Node>& _mixins);
 
@@ -107,6 +107,9 @@ const std::map<std::string, StyleParamKey> s_StyleParamMap = {
     {"transition:selected:time", StyleParamKey::transition_selected_time},
     {"transition:show:time", StyleParamKey::transition_show_time},
     {"visible", StyleParamKey::visible},
+    {"walls:merge", StyleParamKey::walls_merge},
+    {"walls:min_height", StyleParamKey::walls_min_height},
+    {"walls:skip_interior", StyleParamKey::walls_skip_interior},
     {"width", StyleParamKey::width},
 };
 
@@ -243,6 +246,9 @@ StyleParam::Value StyleParam::parseNode(StyleParamKey key, const YAML::Node& nod
         } else {
             LOGW("Invalid text source: %s", Dump(node).c_str());
         }
+        for (const auto& key : textSource.keys) {
+            textSource.keyIds.push_back(Properties::internKey(key));
+        }
         return std::move(textSource);
     }
     case StyleParamKey::text_align:
@@ -274,6 +280,8 @@ StyleParam::Value StyleParam::parseNode(StyleParamKey key, const YAML::Node& nod
     case StyleParamKey::visible:
     case StyleParamKey::text_visible:
     case StyleParamKey::outline_visible:
+    case StyleParamKey::walls_merge:
+    case StyleParamKey::walls_skip_interior:
     case StyleParamKey::collide:
     case StyleParamKey::text_optional:
     case StyleParamKey::text_collide: {
@@ -361,7 +369,8 @@ StyleParam::Value StyleParam::parseNode(StyleParamKey key, const YAML::Node& nod
     case StyleParamKey::miter_limit:
     case StyleParamKey::outline_miter_limit:
     case StyleParamKey::placement_min_length_ratio:
-    case StyleParamKey::text_font_stroke_width: {
+    case StyleParamKey::text_font_stroke_width:
+    case StyleParamKey::walls_min_height: {
         float floatValue;
         if (YamlUtil::getFloat(node, floatValue, true)) {
             return floatValue;
@@ -401,6 +410,34 @@ StyleParam::Value StyleParam::parseNode(StyleParamKey key, const YAML::Node& nod
 }
 
 StyleParam::Value StyleParam::parseString(StyleParamKey key, const std::string& value) {
+    // Values that are taken as they are, or only need the string, are parsed
+    // without building a YAML node
+    switch (key) {
+    case StyleParamKey::text_align:
+    case StyleParamKey::text_transform:
+    case StyleParamKey::sprite:
+    case StyleParamKey::sprite_default:
+    case StyleParamKey::style:
+    case StyleParamKey::outline_style:
+    case StyleParamKey::repeat_group:
+    case StyleParamKey::text_repeat_group:
+    case StyleParamKey::texture:
+        return value;
+    case StyleParamKey::color:
+    case StyleParamKey::outline_color:
+    case StyleParamKey::text_font_fill:
+    case StyleParamKey::text_font_stroke_color: {
+        Color result;
+        if (parseColor(value, result)) {
+            return result.abgr;
+        }
+        LOGW("Invalid color value: %s", value.c_str());
+        return none_type{};
+    }
+    default:
+        break;
+    }
+
     YAML::Node node(value);
     return parseNode(key, node);
 }
@@ -471,6 +508,8 @@ std::string StyleParam::toString() const {
     case StyleParamKey::visible:
     case StyleParamKey::text_visible:
     case StyleParamKey::outline_visible:
+    case StyleParamKey::walls_merge:
+    case StyleParamKey::walls_skip_interior:
     case StyleParamKey::collide:
     case StyleParamKey::text_optional:
     case StyleParamKey::text_collide:
@@ -508,6 +547,7 @@ std::string StyleParam::toString() const {
     case StyleParamKey::miter_limit:
     case StyleParamKey::angle:
     case StyleParamKey::outline_miter_limit:
+    case StyleParamKey::walls_min_height:
         if (!value.is<float>()) break;
         return k + std::to_string(value.get<float>());
     default:
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "data/properties.h"
 #include "labels/labelProperty.h"
 #include "util/variant.h"
 
@@ -91,6 +92,9 @@ enum class StyleParamKey : uint8_t {
     transition_selected_time,
     transition_show_time,
     visible,
+    walls_merge,
+    walls_min_height,
+    walls_skip_interior,
     width,
     NUM_ELEMENTS
 };
@@ -189,6 +193,8 @@ struct StyleParam {
 
     struct TextSource {
         std::vector<std::string> keys;
+        // Interned keys
+        std::vector<Properties::KeyId> keyIds;
         bool operator==(const TextSource& _other) const {
             return keys == _other.keys;
         }
@@ -268,6 +274,9 @@ struct StyleParam {
     Value value;
     const Stops* stops = nullptr;
     int32_t function = -1;
+    // Draw rule name ID of the style named by a 'style' or 'outline_style'
+    // value, set when the scene is loaded
+    int32_t nameId = -1;
 
     bool operator<(const StyleParam& _rhs) const { return key < _rhs.key; }
     bool valid() const { return !value.is<none_type>() || stops != nullptr || function >= 0; }
@@ -307,30 +316,6 @@ struct StyleParam {
 
     static const std::string& keyName(StyleParamKey _key);
 
-    template<typename T>
-    struct visitor {
-        using result_type = bool;
-        T& out;
-        bool operator()(const T& v) const {
-            out = v;
-            return true;
-        }
-        template<typename O>
-        bool operator()(const O v) const {
-            return false;
-        }
-    };
-    template<typename T>
-    struct visitor_ptr {
-        using result_type = const T*;
-        const T* operator()(const T& v) const {
-            return &v;
-        }
-        template<typename O>
-        const T* operator()(const O v) const {
-            return nullptr;
-        }
-    };
 };
 
 }
@@ -0,0 +1,241 @@
+#include "selection/featureIndex.h"
+
+#include "glm/geometric.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace Tangram {
+
+static constexpr uint32_t NODE_SIZE = 16;
+
+// Position of x, y in [0, 65535] along a Hilbert curve
+static uint32_t hilbertIndex(uint32_t x, uint32_t y) {
+    const uint32_t n = 1 << 16;
+    uint32_t d = 0;
+    for (uint32_t s = n / 2; s > 0; s /= 2) {
+        uint32_t rx = (x & s) > 0;
+        uint32_t ry = (y & s) > 0;
+        d += s * s * ((3 * rx) ^ ry);
+        // Rotate the quadrant
+        if (ry == 0) {
+            if (rx == 1) {
+                x = n - 1 - x;
+                y = n - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return d;
+}
+
+static float segmentDistance(glm::vec2 _p, glm::vec2 _a, glm::vec2 _b) {
+    glm::vec2 ab = _b - _a;
+    float length2 = glm::dot(ab, ab);
+    float t = length2 > 0.f ? glm::clamp(glm::dot(_p - _a, ab) / length2, 0.f, 1.f) : 0.f;
+    return glm::distance(_p, _a + t * ab);
+}
+
+static int typeRank(GeometryType _type) {
+    switch (_type) {
+    case GeometryType::points: return 3;
+    case GeometryType::lines: return 2;
+    case GeometryType::polygons: return 1;
+    default: return 0;
+    }
+}
+
+void FeatureIndex::addLine(const Point* _points, size_t _count, Box& _box) {
+    for (size_t i = 0; i < _count; i++) {
+        _box.min = glm::min(_box.min, _points[i]);
+        _box.max = glm::max(_box.max, _points[i]);
+    }
+    m_coordinates.insert(m_coordinates.end(), _points, _points + _count);
+    m_lines.push_back(m_coordinates.size());
+}
+
+void FeatureIndex::add(const Feature& _feature, uint32_t _id) {
+
+    Entry entry;
+    entry.id = _id;
+    entry.type = _feature.geometryType;
+    entry.order = m_entries.size();
+    entry.linesBegin = m_lines.size() - 1;
+    entry.box = { glm::vec2(std::numeric_limits<float>::max()),
+                  glm::vec2(std::numeric_limits<float>::lowest()) };
+
+    switch (_feature.geometryType) {
+    case GeometryType::points:
+        for (auto& point : _feature.points()) { addLine(&point, 1, entry.box); }
+        break;
+    case GeometryType::lines:
+        for (auto line : _feature.lines()) { addLine(line.data(), line.size(), entry.box); }
+        break;
+    case GeometryType::polygons:
+        for (auto polygon : _feature.polygons()) {
+            for (auto ring : polygon) { addLine(ring.data(), ring.size(), entry.box); }
+        }
+        break;
+    default:
+        break;
+    }
+
+    entry.linesEnd = m_lines.size() - 1;
+    if (entry.linesEnd == entry.linesBegin) { return; }
+
+    m_entries.push_back(entry);
+}
+
+void FeatureIndex::append(const FeatureIndex& _other) {
+
+    uint32_t lineOffset = m_lines.size() - 1;
+    uint32_t coordinateOffset = m_coordinates.size();
+    uint32_t order = m_entries.size();
+
+    m_coordinates.insert(m_coordinates.end(), _other.m_coordinates.begin(), _other.m_coordinates.end());
+    for (size_t i = 1; i < _other.m_lines.size(); i++) {
+        m_lines.push_back(_other.m_lines[i] + coordinateOffset);
+    }
+
+    for (auto entry : _other.m_entries) {
+        entry.order += order;
+        entry.linesBegin += lineOffset;
+        entry.linesEnd += lineOffset;
+        m_entries.push_back(entry);
+    }
+}
+
+void FeatureIndex::build() {
+
+    m_nodes.clear();
+    m_levels.clear();
+
+    if (m_entries.empty()) { return; }
+
+    Box extent = m_entries[0].box;
+    for (auto& entry : m_entries) {
+        extent.min = glm::min(extent.min, entry.box.min);
+        extent.max = glm::max(extent.max, entry.box.max);
+    }
+
+    glm::vec2 scale = 65535.f / glm::max(extent.max - extent.min, glm::vec2(1e-6f));
+
+    std::vector<std::pair<uint32_t, uint32_t>> order;
+    order.reserve(m_entries.size());
+    for (uint32_t i = 0; i < m_entries.size(); i++) {
+        glm::vec2 center = ((m_entries[i].box.min + m_entries[i].box.max) * 0.5f - extent.min) * scale;
+        order.emplace_back(hilbertIndex(center.x, center.y), i);
+    }
+    std::sort(order.begin(), order.end());
+
+    std::vector<Entry> entries;
+    entries.reserve(m_entries.size());
+    for (auto& item : order) { entries.push_back(m_entries[item.second]); }
+    m_entries = std::move(entries);
+
+    // Leaf level, then parents until one node holds all
+    for (auto& entry : m_entries) { m_nodes.push_back(entry.box); }
+    m_levels.push_back(0);
+    m_levels.push_back(m_nodes.size());
+
+    while (m_levels.back() - m_levels[m_levels.size() - 2] > 1) {
+        uint32_t begin = m_levels[m_levels.size() - 2];
+        uint32_t end = m_levels.back();
+        for (uint32_t i = begin; i < end; i += NODE_SIZE) {
+            Box box = m_nodes[i];
+            for (uint32_t j = i + 1; j < std::min(i + NODE_SIZE, end); j++) {
+                box.min = glm::min(box.min, m_nodes[j].min);
+                box.max = glm::max(box.max, m_nodes[j].max);
+            }
+            m_nodes.push_back(box);
+        }
+        m_levels.push_back(m_nodes.size());
+    }
+}
+
+bool FeatureIndex::hits(const Entry& _entry, glm::vec2 _point, float _radius) const {
+
+    if (_entry.type == GeometryType::polygons) {
+        // Even-odd rule over all rings of the polygons
+        bool inside = false;
+        for (uint32_t l = _entry.linesBegin; l < _entry.linesEnd; l++) {
+            const Point* ring = m_coordinates.data() + m_lines[l];
+            uint32_t count = m_lines[l + 1] - m_lines[l];
+            if (count == 0) { continue; }
+            for (uint32_t i = 0, j = count - 1; i < count; j = i++) {
+                if (((ring[i].y > _point.y) != (ring[j].y > _point.y)) &&
+                    (_point.x < (ring[j].x - ring[i].x) * (_point.y - ring[i].y) /
+                     (ring[j].y - ring[i].y) + ring[i].x)) {
+                    inside = !inside;
+                }
+            }
+        }
+        return inside;
+    }
+
+    for (uint32_t l = _entry.linesBegin; l < _entry.linesEnd; l++) {
+        const Point* line = m_coordinates.data() + m_lines[l];
+        uint32_t count = m_lines[l + 1] - m_lines[l];
+        if (count == 1 && glm::distance(_point, line[0]) <= _radius) { return true; }
+        for (uint32_t i = 1; i < count; i++) {
+            if (segmentDistance(_point, line[i - 1], line[i]) <= _radius) { return true; }
+        }
+    }
+    return false;
+}
+
+FeatureIndex::Hit FeatureIndex::pick(glm::vec2 _point, float _radius) const {
+
+    Hit hit;
+    if (m_levels.size() < 2) { return hit; }
+
+    Box query = { _point - _radius, _point + _radius };
+    uint32_t hitOrder = 0;
+
+    // Nodes to visit as level and index in m_nodes
+    std::vector<std::pair<uint32_t, uint32_t>> stack;
+    uint32_t root = m_levels.size() - 2;
+    for (uint32_t i = m_levels[root]; i < m_levels[root + 1]; i++) {
+        stack.emplace_back(root, i);
+    }
+
+    while (!stack.empty()) {
+        auto node = stack.back();
+        stack.pop_back();
+
+        if (!m_nodes[node.second].intersects(query)) { continue; }
+
+        uint32_t level = node.first;
+        if (level == 0) {
+            auto& entry = m_entries[node.second];
+            int rank = typeRank(entry.type);
+            if (rank < typeRank(hit.type) ||
+                (rank == typeRank(hit.type) && hit.id != 0 && entry.order < hitOrder)) {
+                continue;
+            }
+            if (hits(entry, _point, _radius)) {
+                hit = { entry.id, entry.type };
+                hitOrder = entry.order;
+            }
+            continue;
+        }
+
+        uint32_t first = m_levels[level - 1] + (node.second - m_levels[level]) * NODE_SIZE;
+        uint32_t last = std::min(first + NODE_SIZE, m_levels[level]);
+        for (uint32_t i = first; i < last; i++) {
+            stack.emplace_back(level - 1, i);
+        }
+    }
+
+    return hit;
+}
+
+size_t FeatureIndex::memoryUsage() const {
+    return m_entries.capacity() * sizeof(Entry) +
+        m_coordinates.capacity() * sizeof(Point) +
+        m_lines.capacity() * sizeof(uint32_t) +
+        m_nodes.capacity() * sizeof(Box) +
+        m_levels.capacity() * sizeof(uint32_t);
+}
+
+}
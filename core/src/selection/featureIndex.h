@@ -0,0 +1,87 @@
+#pragma once
+
+#include "data/tileData.h"
+
+#include "glm/vec2.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Tangram {
+
+// Packed Hilbert R-tree over the geometry of the interactive features of a
+// tile, in tile coordinates. Feature picks are answered from it without
+// drawing the selection pass. The index is immutable once it is built.
+class FeatureIndex {
+
+public:
+
+    struct Hit {
+        // Selection color of the feature, or 0
+        uint32_t id = 0;
+        // Points are picked over lines, and lines over polygons
+        GeometryType type = GeometryType::unknown;
+    };
+
+    // Add the geometry of _feature, picked with the selection color _id
+    void add(const Feature& _feature, uint32_t _id);
+
+    // Add the features of _other after those of this index
+    void append(const FeatureIndex& _other);
+
+    // Sort the features along a Hilbert curve and build the tree
+    void build();
+
+    // Returns the feature at _point, or within _radius of it for points and
+    // lines. The last added feature of the highest type wins.
+    Hit pick(glm::vec2 _point, float _radius) const;
+
+    size_t size() const { return m_entries.size(); }
+
+    size_t memoryUsage() const;
+
+private:
+
+    struct Box {
+        glm::vec2 min;
+        glm::vec2 max;
+
+        bool intersects(const Box& _other) const {
+            return min.x <= _other.max.x && max.x >= _other.min.x &&
+                min.y <= _other.max.y && max.y >= _other.min.y;
+        }
+    };
+
+    struct Entry {
+        Box box;
+        uint32_t id;
+        GeometryType type;
+        // Order in which the feature was added
+        uint32_t order;
+        // Range of the lines of the feature in m_lines; a polygon is the
+        // set of its rings, a point is a line of one point
+        uint32_t linesBegin;
+        uint32_t linesEnd;
+    };
+
+    void addLine(const Point* _points, size_t _count, Box& _box);
+
+    bool hits(const Entry& _entry, glm::vec2 _point, float _radius) const;
+
+    std::vector<Entry> m_entries;
+
+    // Coordinates of all lines, line i is [m_lines[i], m_lines[i+1])
+    std::vector<Point> m_coordinates;
+    std::vector<uint32_t> m_lines = { 0 };
+
+    // Boxes of the tree nodes, level by level from the boxes of the entries.
+    // Node i of a level holds nodes i * NODE_SIZE to (i + 1) * NODE_SIZE of
+    // the level below.
+    std::vector<Box> m_nodes;
+    // Index in m_nodes of the first node of each level, and the end
+    std::vector<uint32_t> m_levels;
+
+};
+
+}
@@ -1,5 +1,7 @@
 #include "selection/featureSelection.h"
 
+#include "selection/featureState.h"
+
 namespace Tangram {
 
 FeatureSelection::FeatureSelection() :
@@ -8,11 +10,12 @@ FeatureSelection::FeatureSelection() :
 
 uint32_t FeatureSelection::nextColorIdentifier() {
 
-    uint32_t entry = m_entry++;
+    // The colors with FeatureState::color_flag are those of feature states
+    uint32_t entry = m_entry++ & ~FeatureState::color_flag;
 
-    // skip zero every 2^32 features
+    // skip zero every 2^31 features
     while (entry == 0) {
-        entry = m_entry++;
+        entry = m_entry++ & ~FeatureState::color_flag;
     }
 
     return entry;
@@ -0,0 +1,156 @@
+#include "selection/featureState.h"
+
+#include "gl/glError.h"
+#include "gl/renderState.h"
+#include "gl/texture.h"
+#include "log.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Tangram {
+
+constexpr int FeatureState::size;
+constexpr uint32_t FeatureState::color_flag;
+
+namespace {
+
+/* RGBA texture of the feature states, with a texel per index */
+class StateTexture : public Texture {
+
+    static TextureOptions textureOptions() {
+        TextureOptions options;
+        options.minFilter = TextureMinFilter::NEAREST;
+        options.magFilter = TextureMagFilter::NEAREST;
+        return options;
+    }
+
+public:
+
+    StateTexture() : Texture(textureOptions()) {
+        m_bufferSize = FeatureState::size * FeatureState::size * 4;
+        m_buffer.reset(reinterpret_cast<GLubyte*>(std::calloc(m_bufferSize, 1)));
+        m_disposeBuffer = false;
+        resize(FeatureState::size, FeatureState::size);
+    }
+
+    void setTexel(uint32_t _index, uint32_t _state) {
+        std::memcpy(m_buffer.get() + _index * 4, &_state, 4);
+
+        int row = _index / FeatureState::size;
+        m_dirtyMin = std::min(m_dirtyMin, row);
+        m_dirtyMax = std::max(m_dirtyMax, row + 1);
+    }
+
+    void clear() {
+        std::memset(m_buffer.get(), 0, m_bufferSize);
+        m_dirtyMin = 0;
+        m_dirtyMax = FeatureState::size;
+    }
+
+    bool bind(RenderState& _rs, GLuint _textureUnit) override {
+
+        // States are kept in m_buffer and uploaded whole to a new context
+        recoverLostContext(_rs);
+
+        if (m_shouldResize) {
+            m_shouldResize = false;
+            m_dirtyMax = 0;
+            m_dirtyMin = FeatureState::size;
+            return upload(_rs, _textureUnit);
+        }
+        if (m_glHandle == 0) { return false; }
+
+        _rs.texture(m_glHandle, _textureUnit, GL_TEXTURE_2D);
+
+        // Upload the rows of the states that changed
+        if (m_dirtyMin < m_dirtyMax) {
+            GL::texSubImage2D(GL_TEXTURE_2D, 0, 0, m_dirtyMin, m_width, m_dirtyMax - m_dirtyMin,
+                              GL_RGBA, GL_UNSIGNED_BYTE, m_buffer.get() + m_dirtyMin * m_width * 4);
+            m_dirtyMax = 0;
+            m_dirtyMin = FeatureState::size;
+        }
+        return true;
+    }
+
+private:
+
+    // Rows [m_dirtyMin, m_dirtyMax) to upload on the next bind
+    int m_dirtyMin = FeatureState::size;
+    int m_dirtyMax = 0;
+};
+
+}
+
+FeatureState::FeatureState() : m_features(1) {}
+
+FeatureState::~FeatureState() {}
+
+uint32_t FeatureState::index(int32_t _sourceId, uint64_t _featureId) {
+    auto key = std::make_pair(_sourceId, _featureId);
+
+    auto it = m_indices.find(key);
+    if (it != m_indices.end()) { return it->second; }
+
+    if (m_features.size() == size_t(size * size)) { return 0; }
+
+    uint32_t index = m_features.size();
+    m_features.push_back(key);
+    m_indices[key] = index;
+    return index;
+}
+
+uint32_t FeatureState::color(int32_t _sourceId, uint64_t _featureId) {
+    if (_featureId == 0) { return 0; }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uint32_t index = this->index(_sourceId, _featureId);
+    return index == 0 ? 0 : color_flag | index;
+}
+
+std::pair<int32_t, uint64_t> FeatureState::feature(uint32_t _color) const {
+    uint32_t index = _color & ~color_flag;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if ((_color & color_flag) == 0 || index >= m_features.size()) { return { 0, 0 }; }
+    return m_features[index];
+}
+
+bool FeatureState::set(int32_t _sourceId, uint64_t _featureId, uint32_t _state) {
+    if (_featureId == 0) { return false; }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uint32_t index = this->index(_sourceId, _featureId);
+    if (index == 0) {
+        LOGW("Too many feature states, ignoring the state of feature %llu",
+             (unsigned long long)_featureId);
+        return false;
+    }
+    m_pending.emplace_back(index, _state);
+    return true;
+}
+
+void FeatureState::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pending.clear();
+    m_cleared = true;
+}
+
+bool FeatureState::bind(RenderState& _rs, GLuint _unit) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (!m_texture) { m_texture = std::make_unique<StateTexture>(); }
+        auto& texture = static_cast<StateTexture&>(*m_texture);
+
+        if (m_cleared) {
+            texture.clear();
+            m_cleared = false;
+        }
+        for (auto& state : m_pending) { texture.setTexel(state.first, state.second); }
+        m_pending.clear();
+    }
+    return m_texture->bind(_rs, _unit);
+}
+
+}
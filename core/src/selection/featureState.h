@@ -0,0 +1,74 @@
+#pragma once
+
+#include "gl.h"
+#include "util/fastmap.h"
+
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace Tangram {
+
+class RenderState;
+class Texture;
+
+/* RGBA states of features, set by source and feature ID
+ *
+ * Interactive features with an ID get a selection color that holds the index
+ * of their state, the same in all tiles. Styles that read featureState() in
+ * their shader blocks look the state up in a texture by this index, so that
+ * changing the state of a feature updates a texel instead of rebuilding its
+ * tiles.
+ */
+class FeatureState {
+
+public:
+
+    // Width and height of the state texture
+    static constexpr int size = 256;
+
+    // Selection colors of features with a state have this bit set and the
+    // index of the state in the lower bits
+    static constexpr uint32_t color_flag = 0x80000000;
+
+    FeatureState();
+    ~FeatureState();
+
+    // Selection color of the feature _featureId of _sourceId, or 0 when the
+    // feature has no ID or the state texture is full
+    uint32_t color(int32_t _sourceId, uint64_t _featureId);
+
+    // Source and feature ID of a selection color returned by color(), or
+    // { 0, 0 } for other colors
+    std::pair<int32_t, uint64_t> feature(uint32_t _color) const;
+
+    // Set the state of the feature, which is drawn once the state texture is
+    // bound. Returns false when no more feature states fit in the texture.
+    bool set(int32_t _sourceId, uint64_t _featureId, uint32_t _state);
+
+    // Reset the states of all features to 0
+    void clear();
+
+    // Bind the state texture to _unit and upload the states that changed
+    bool bind(RenderState& rs, GLuint _unit);
+
+private:
+
+    uint32_t index(int32_t _sourceId, uint64_t _featureId);
+
+    mutable std::mutex m_mutex;
+
+    fastmap<std::pair<int32_t, uint64_t>, uint32_t> m_indices;
+
+    // Features by index, index 0 is not used
+    std::vector<std::pair<int32_t, uint64_t>> m_features;
+
+    // States set since the last bind, by index
+    std::vector<std::pair<uint32_t, uint32_t>> m_pending;
+    bool m_cleared = false;
+
+    std::unique_ptr<Texture> m_texture;
+};
+
+}
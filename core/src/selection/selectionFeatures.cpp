@@ -0,0 +1,138 @@
+#include "selection/selectionFeatures.h"
+
+#include "data/propertyItem.h"
+
+namespace Tangram {
+
+uint32_t SelectionFeatures::keyIndex(const std::string& _key, Properties::KeyId _keyId) {
+
+    if (m_keyLookup.size() != m_keys.size()) {
+        for (uint32_t i = 0; i < m_keys.size(); i++) { m_keyLookup.emplace(m_keys[i], i); }
+    }
+
+    auto it = m_keyLookup.emplace(_key, uint32_t(m_keys.size()));
+    if (it.second) {
+        m_keys.push_back(_key);
+        m_keyIds.push_back(_keyId);
+    }
+    return it.first->second;
+}
+
+uint32_t SelectionFeatures::valueIndex(const Value& _value) {
+
+    for (; m_indexedValues < m_values.size(); m_indexedValues++) {
+        auto& value = m_values[m_indexedValues];
+        if (value.is<std::string>()) {
+            m_stringLookup.emplace(value.get<std::string>(), uint32_t(m_indexedValues));
+        } else if (value.is<double>()) {
+            m_numberLookup.emplace(value.get<double>(), uint32_t(m_indexedValues));
+        }
+    }
+
+    uint32_t index = m_values.size();
+    if (_value.is<std::string>()) {
+        index = m_stringLookup.emplace(_value.get<std::string>(), index).first->second;
+    } else if (_value.is<double>()) {
+        index = m_numberLookup.emplace(_value.get<double>(), index).first->second;
+    }
+
+    if (index == m_values.size()) {
+        m_values.push_back(_value);
+        m_indexedValues = m_values.size();
+    }
+    return index;
+}
+
+void SelectionFeatures::add(uint32_t _id, const Properties& _props, int32_t _sourceId) {
+
+    Feature feature;
+    feature.sourceId = _sourceId;
+    feature.begin = m_tags.size();
+
+    for (auto& item : _props.items()) {
+        m_tags.emplace_back(keyIndex(item.key, item.keyId), valueIndex(item.value));
+    }
+
+    feature.end = m_tags.size();
+    m_features[_id] = feature;
+}
+
+void SelectionFeatures::merge(const SelectionFeatures& _other) {
+
+    std::vector<uint32_t> keys(_other.m_keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        keys[i] = keyIndex(_other.m_keys[i], _other.m_keyIds[i]);
+    }
+
+    std::vector<uint32_t> values(_other.m_values.size());
+    for (size_t i = 0; i < values.size(); i++) {
+        values[i] = valueIndex(_other.m_values[i]);
+    }
+
+    for (auto& entry : _other.m_features) {
+        Feature feature = entry.second;
+        feature.begin = m_tags.size();
+        for (uint32_t i = entry.second.begin; i < entry.second.end; i++) {
+            auto& tag = _other.m_tags[i];
+            m_tags.emplace_back(keys[tag.first], values[tag.second]);
+        }
+        feature.end = m_tags.size();
+        m_features[entry.first] = feature;
+    }
+}
+
+std::shared_ptr<Properties> SelectionFeatures::get(uint32_t _id) const {
+
+    auto it = m_features.find(_id);
+    if (it == m_features.end()) { return nullptr; }
+
+    auto& feature = it->second;
+
+    // Tags were added in the order of the sorted items
+    std::vector<PropertyItem> items;
+    items.reserve(feature.end - feature.begin);
+    for (uint32_t i = feature.begin; i < feature.end; i++) {
+        auto& tag = m_tags[i];
+        items.emplace_back(m_keys[tag.first], m_keyIds[tag.first], m_values[tag.second]);
+    }
+
+    auto props = std::make_shared<Properties>();
+    props->setSorted(std::move(items));
+    props->sourceId = feature.sourceId;
+    return props;
+}
+
+std::vector<uint32_t> SelectionFeatures::ids() const {
+    std::vector<uint32_t> ids;
+    ids.reserve(m_features.size());
+    for (auto& entry : m_features) { ids.push_back(entry.first); }
+    return ids;
+}
+
+void SelectionFeatures::shrink() {
+    m_keyLookup = {};
+    m_stringLookup = {};
+    m_numberLookup = {};
+    m_indexedValues = 0;
+
+    m_features.map.shrink_to_fit();
+    m_tags.shrink_to_fit();
+    m_keys.shrink_to_fit();
+    m_keyIds.shrink_to_fit();
+    m_values.shrink_to_fit();
+}
+
+size_t SelectionFeatures::memoryUsage() const {
+    size_t bytes = m_features.map.capacity() * sizeof(m_features.map[0]) +
+        m_tags.capacity() * sizeof(m_tags[0]) +
+        m_keyIds.capacity() * sizeof(Properties::KeyId) +
+        m_values.capacity() * sizeof(Value);
+
+    for (auto& key : m_keys) { bytes += sizeof(key) + key.capacity(); }
+    for (auto& value : m_values) {
+        if (value.is<std::string>()) { bytes += value.get<std::string>().capacity(); }
+    }
+    return bytes;
+}
+
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "data/properties.h"
+#include "util/fastmap.h"
+#include "util/variant.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Tangram {
+
+// Properties of the interactive features of a tile by selection color. The
+// keys and values of all features are stored once per tile, each feature is a
+// range of key and value indices. Properties are only created for pick results.
+class SelectionFeatures {
+
+public:
+
+    // Add the properties of the feature with selection color _id
+    void add(uint32_t _id, const Properties& _props) { add(_id, _props, _props.sourceId); }
+
+    // Add the properties of a feature of the source _sourceId, for features
+    // of TileData that is shared with other sources
+    void add(uint32_t _id, const Properties& _props, int32_t _sourceId);
+
+    // Add the features of _other, replacing those with the same color
+    void merge(const SelectionFeatures& _other);
+
+    bool contains(uint32_t _id) const { return m_features.find(_id) != m_features.end(); }
+
+    // Returns new Properties of the feature with selection color _id, or null
+    std::shared_ptr<Properties> get(uint32_t _id) const;
+
+    // Selection colors of all features
+    std::vector<uint32_t> ids() const;
+
+    size_t size() const { return m_features.size(); }
+
+    // Release the lookup tables that are only needed to add features
+    void shrink();
+
+    size_t memoryUsage() const;
+
+private:
+
+    struct Feature {
+        int32_t sourceId = 0;
+        // Range of the feature in m_tags
+        uint32_t begin = 0;
+        uint32_t end = 0;
+    };
+
+    uint32_t keyIndex(const std::string& _key, Properties::KeyId _keyId);
+    uint32_t valueIndex(const Value& _value);
+
+    fastmap<uint32_t, Feature> m_features;
+
+    // Key and value indices of the properties of all features
+    std::vector<std::pair<uint32_t, uint32_t>> m_tags;
+
+    std::vector<std::string> m_keys;
+    std::vector<Properties::KeyId> m_keyIds;
+    std::vector<Value> m_values;
+
+    // Indices of keys and values, rebuilt when features are added after shrink()
+    std::unordered_map<std::string, uint32_t> m_keyLookup;
+    std::unordered_map<std::string, uint32_t> m_stringLookup;
+    std::unordered_map<double, uint32_t> m_numberLookup;
+    size_t m_indexedValues = 0;
+
+};
+
+}
@@ -5,6 +5,7 @@
 #include "labels/labelManager.h"
 #include "marker/marker.h"
 #include "marker/markerManager.h"
+#include "selection/featureIndex.h"
 #include "tile/tileManager.h"
 #include "view/view.h"
 
@@ -12,6 +13,10 @@
 
 namespace Tangram {
 
+// Minimum pick radius in pixels for indexed features, which are indexed
+// without their drawn width
+static constexpr float MIN_INDEX_PICK_RADIUS = 4.f;
+
 SelectionQuery::SelectionQuery(glm::vec2 _position, float _radius, QueryCallback _queryCallback)
     : m_position(_position), m_radius(_radius), m_queryCallback(_queryCallback) {}
 
@@ -20,38 +25,38 @@ QueryType SelectionQuery::type() const {
           (m_queryCallback.is<LabelPickCallback>() ? QueryType::label : QueryType::marker);
 }
 
-void SelectionQuery::process(const View& _view, const FrameBuffer& _framebuffer, const MarkerManager& _markerManager,
-                             const TileManager& _tileManager, const LabelManager& _labels, std::vector<SelectionColorRead>& _colorCache) const {
+FrameBuffer::PixelRect SelectionQuery::rect(const View& _view, const FrameBuffer& _framebuffer) const {
 
     float radius = m_radius * _view.pixelScale();
     glm::vec2 windowCoordinates = _view.normalizedWindowCoordinates(m_position.x - radius, m_position.y + radius);
     glm::vec2 windowSize = _view.normalizedWindowCoordinates(m_position.x + radius, m_position.y - radius) - windowCoordinates;
 
+    return _framebuffer.rect(windowCoordinates.x, windowCoordinates.y, windowSize.x, windowSize.y);
+}
+
+void SelectionQuery::process(const View& _view, const FrameBuffer& _framebuffer, const FrameBuffer::PixelRect& _pixels,
+                             const MarkerManager& _markerManager, const TileManager& _tileManager,
+                             const LabelManager& _labels) const {
+
     GLuint color = 0;
 
-    auto it = std::find_if(_colorCache.begin(), _colorCache.end(), [=](const auto& _colorRead) {
-        return (m_position == _colorRead.position) && (m_radius == _colorRead.radius);
-    });
-
-    if (it == _colorCache.end()) {
-        // Find the first non-zero color nearest to the position and within the selection radius.
-        auto rect = _framebuffer.readRect(windowCoordinates.x, windowCoordinates.y, windowSize.x, windowSize.y);
-        float minDistance = std::fmin(rect.width, rect.height);
-        float hw = static_cast<float>(rect.width) / 2.f, hh = static_cast<float>(rect.height) / 2.f;
-        for (int32_t row = 0; row < rect.height; row++) {
-            for (int32_t col = 0; col < rect.width; col++) {
-                uint32_t sample = rect.pixels[row * rect.width + col];
-                float distance = std::hypot(row - hw, col - hh);
-                if (sample != 0 && distance < minDistance) {
-                    color = sample;
-                    minDistance = distance;
-                }
+    // Find the first non-zero color nearest to the position and within the selection radius.
+    auto rect = this->rect(_view, _framebuffer);
+    float minDistance = std::fmin(rect.width, rect.height);
+    float hw = static_cast<float>(rect.width) / 2.f, hh = static_cast<float>(rect.height) / 2.f;
+    for (int32_t row = 0; row < rect.height; row++) {
+        int32_t y = rect.bottom + row - _pixels.bottom;
+        if (y < 0 || y >= _pixels.height) { continue; }
+        for (int32_t col = 0; col < rect.width; col++) {
+            int32_t x = rect.left + col - _pixels.left;
+            if (x < 0 || x >= _pixels.width) { continue; }
+            uint32_t sample = _pixels.pixels[y * _pixels.width + x];
+            float distance = std::hypot(row - hw, col - hh);
+            if (sample != 0 && distance < minDistance) {
+                color = sample;
+                minDistance = distance;
             }
         }
-        // Cache the resulting color for other queries.
-        _colorCache.push_back({color, m_radius, m_position});
-    } else {
-        color = it->color;
     }
 
     switch (type()) {
@@ -126,4 +131,52 @@ void SelectionQuery::process(const View& _view, const FrameBuffer& _framebuffer,
     default: break;
     }
 }
+bool SelectionQuery::processFromIndex(View& _view, const TileManager& _tileManager) const {
+
+    if (type() != QueryType::feature) { return false; }
+
+    float x = m_position.x, y = m_position.y;
+    _view.screenToGroundPlane(x, y);
+    glm::dvec2 ground(x, y);
+
+    double radius = std::fmax(m_radius, MIN_INDEX_PICK_RADIUS) / _view.pixelsPerMeter();
+
+    const Tile* hitTile = nullptr;
+    FeatureIndex::Hit hit;
+
+    // Proxy tiles are drawn below the others
+    for (bool proxies : { false, true }) {
+        for (const auto& tile : _tileManager.getVisibleTiles()) {
+            if (tile->isProxy() != proxies) { continue; }
+
+            glm::dvec2 origin = _view.getRelativeMeters(tile->getOrigin());
+            glm::dvec2 local = (ground - origin) * tile->getInverseScale();
+            if (local.x < 0 || local.x > 1 || local.y < 0 || local.y > 1) { continue; }
+
+            auto& index = tile->featureIndex();
+            if (!index) { return false; }
+
+            auto tileHit = index->pick(glm::vec2(local), radius * tile->getInverseScale());
+            if (tileHit.id != 0 && !hitTile) {
+                hitTile = tile.get();
+                hit = tileHit;
+            }
+        }
+        if (hitTile) { break; }
+    }
+
+    auto& cb = m_queryCallback.get<FeaturePickCallback>();
+
+    if (hitTile) {
+        if (auto props = hitTile->getSelectionFeature(hit.id)) {
+            FeaturePickResult queryResult(props, {{m_position.x, m_position.y}});
+            cb(&queryResult);
+            return true;
+        }
+    }
+
+    cb(nullptr);
+    return true;
+}
+
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "gl/framebuffer.h"
 #include "glm/vec2.hpp"
 #include "map.h"
 #include "util/variant.h"
@@ -7,7 +8,6 @@
 namespace Tangram {
 
 class MarkerManager;
-class FrameBuffer;
 class TileManager;
 class LabelManager;
 class View;
@@ -20,20 +20,22 @@ enum class QueryType {
 
 using QueryCallback = variant<FeaturePickCallback, LabelPickCallback, MarkerPickCallback>;
 
-struct SelectionColorRead {
-    uint32_t color;
-    float radius;
-    glm::vec2 position;
-};
-
 class SelectionQuery {
 
 public:
     SelectionQuery(glm::vec2 _position, float _radius, QueryCallback _queryCallback);
 
-    void process(const View& _view, const FrameBuffer& _framebuffer, const MarkerManager& _markerManager,
-                 const TileManager& _tileManager, const LabelManager& _labelManager,
-                 std::vector<SelectionColorRead>& _cache) const;
+    // Region of the framebuffer within the selection radius of the query position
+    FrameBuffer::PixelRect rect(const View& _view, const FrameBuffer& _framebuffer) const;
+
+    // Resolves the query with the selection pixels of a region that contains its rect
+    void process(const View& _view, const FrameBuffer& _framebuffer, const FrameBuffer::PixelRect& _pixels,
+                 const MarkerManager& _markerManager, const TileManager& _tileManager,
+                 const LabelManager& _labelManager) const;
+
+    // Resolves a feature query with the FeatureIndex of the tiles at its
+    // position. Returns false when the query needs the selection pass.
+    bool processFromIndex(View& _view, const TileManager& _tileManager) const;
 
     QueryType type() const;
 
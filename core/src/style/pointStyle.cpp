@@ -1,10 +1,13 @@
 #include "style/pointStyle.h"
 
 #include "gl/dynamicQuadMesh.h"
+#include "gl/hardware.h"
 #include "gl/shaderProgram.h"
+#include "gl/shaderProgramCache.h"
 #include "gl/texture.h"
 #include "gl/vertexLayout.h"
 #include "platform.h"
+#include "scene/scene.h"
 #include "scene/spriteAtlas.h"
 #include "style/pointStyleBuilder.h"
 #include "view/view.h"
@@ -21,6 +24,7 @@ PointStyle::PointStyle(std::string _name, Blending _blendMode, GLenum _drawMode,
 
     m_type = StyleType::point;
     m_lightingType = LightingType::none;
+    m_uniformBlocks = true;
 
     m_textStyle = std::make_unique<TextStyle>(_name, true, _blendMode, _drawMode);
 }
@@ -33,6 +37,35 @@ void PointStyle::build(const Scene& _scene) {
     m_textStyle->build(_scene);
 
     m_mesh = std::make_unique<DynamicQuadMesh<SpriteVertex>>(m_vertexLayout, m_drawMode);
+    m_instancedMesh = std::make_unique<InstancedQuadMesh<SpriteInstance>>(m_instanceLayout, m_drawMode);
+
+    // The programs are only compiled when the instanced mesh is drawn
+    auto instanced = [](const std::string& _source) {
+        const std::string define = "#define TANGRAM_INSTANCED\n";
+        // The #version directive must stay on the first line
+        if (_source.compare(0, 9, "#version ") == 0) {
+            size_t end = _source.find('\n') + 1;
+            return _source.substr(0, end) + define + _source.substr(end);
+        }
+        return define + _source;
+    };
+
+    auto& programs = _scene.programCache();
+
+    m_instancedProgram = programs.get(instanced(m_shaderProgram->vertexShaderSource()),
+                                      m_shaderProgram->fragmentShaderSource(),
+                                      "instanced {style:" + m_name + "}");
+
+    if (m_selection) {
+        m_instancedSelectionProgram = programs.get(instanced(m_selectionProgram->vertexShaderSource()),
+                                                   m_selectionProgram->fragmentShaderSource(),
+                                                   "instanced selection_program {style:" + m_name + "}");
+    }
+
+    // Copies of the style uniforms, which cache their location in the program
+    for (auto& uniform : Style::m_mainUniforms.styleUniforms) {
+        m_instancedStyleUniforms.styleUniforms.push_back(uniform);
+    }
 }
 
 void PointStyle::constructVertexLayout() {
@@ -46,27 +79,59 @@ void PointStyle::constructVertexLayout() {
         {"a_aa_factor", 1, GL_SHORT, true, 0},
         {"a_alpha", 1, GL_UNSIGNED_SHORT, true, 0},
     }));
+
+    m_instanceLayout = std::shared_ptr<VertexLayout>(new VertexLayout({
+        {"a_position", 4, GL_FLOAT, false, 0},
+        {"a_axes", 4, GL_FLOAT, false, 0},
+        {"a_uv_rect", 4, GL_SHORT, true, 0},
+        {"a_selection_color", 4, GL_UNSIGNED_BYTE, true, 0},
+        {"a_color", 4, GL_UNSIGNED_BYTE, true, 0},
+        {"a_outline_color", 4, GL_UNSIGNED_BYTE, true, 0},
+        {"a_aa_factor", 1, GL_SHORT, true, 0},
+        {"a_alpha", 1, GL_UNSIGNED_SHORT, true, 0},
+    }));
 }
 
 void PointStyle::constructShaderProgram() {
     m_shaderSource->setSourceStrings(point_fs, point_vs);
 }
 
-void PointStyle::onBeginUpdate() {
+void PointStyle::onBeginUpdate(bool _labelSetChanged, float _time) {
     m_mesh->clear();
+    m_instancedMesh->clear();
     m_batches.clear();
-    m_textStyle->onBeginUpdate();
+    m_textStyle->onBeginUpdate(_labelSetChanged, _time);
 }
 
 void PointStyle::onBeginFrame(RenderState& rs) {
     // Upload meshes for next frame
     m_mesh->upload(rs);
+    m_instancedMesh->upload(rs);
     m_textStyle->onBeginFrame(rs);
 }
 
+void PointStyle::compileShaders(RenderState& rs) {
+    // The instanced programs are only compiled when the instanced mesh is drawn
+    Style::compileShaders(rs);
+    m_textStyle->compileShaders(rs);
+}
+
+bool PointStyle::shadersReady(RenderState& rs) {
+    bool ready = Style::shadersReady(rs);
+    if (m_instancedMesh->numberOfInstances() > 0) {
+        ready &= m_instancedProgram->isReady(rs);
+    }
+    ready &= m_textStyle->shadersReady(rs);
+    return ready;
+}
+
 void PointStyle::onBeginDrawFrame(RenderState& rs, const View& _view) {
     Style::onBeginDrawFrame(rs, _view);
 
+    if (m_instancedMesh->numberOfInstances() > 0) {
+        setupShaderUniforms(rs, *m_instancedProgram, _view, m_instancedStyleUniforms);
+    }
+
     auto texUnit = rs.nextAvailableTextureUnit();
 
     m_shaderProgram->setUniformi(rs, m_mainUniforms.uTex, texUnit);
@@ -74,19 +139,33 @@ void PointStyle::onBeginDrawFrame(RenderState& rs, const View& _view) {
     m_shaderProgram->setUniformMatrix4f(rs, m_mainUniforms.uOrtho,
                                         _view.getOrthoViewportMatrix());
 
+    if (m_instancedMesh->numberOfInstances() > 0) {
+        m_instancedProgram->setUniformi(rs, m_instancedUniforms.uTex, texUnit);
+        m_instancedProgram->setUniformMatrix4f(rs, m_instancedUniforms.uOrtho,
+                                               _view.getOrthoViewportMatrix());
+    }
 
     size_t vertexPos = 0;
+    size_t instancePos = 0;
     for (auto& batch : m_batches) {
 
         auto tex = batch.texture;
 
-        m_shaderProgram->setUniformi(rs, m_mainUniforms.uSpriteMode, bool(tex) ? 1 : 0);
-
         if (tex) { tex->bind(rs, texUnit); }
 
-        m_mesh->drawRange(rs, *m_shaderProgram, vertexPos, batch.vertexCount);
+        if (batch.instanced) {
+            m_instancedProgram->setUniformi(rs, m_instancedUniforms.uSpriteMode, bool(tex) ? 1 : 0);
+
+            m_instancedMesh->drawRange(rs, *m_instancedProgram, instancePos, batch.count);
 
-        vertexPos += batch.vertexCount;
+            instancePos += batch.count;
+        } else {
+            m_shaderProgram->setUniformi(rs, m_mainUniforms.uSpriteMode, bool(tex) ? 1 : 0);
+
+            m_mesh->drawRange(rs, *m_shaderProgram, vertexPos, batch.count);
+
+            vertexPos += batch.count;
+        }
     }
 
     m_textStyle->onBeginDrawFrame(rs, _view);
@@ -104,6 +183,17 @@ void PointStyle::onBeginDrawSelectionFrame(RenderState& rs, const View& _view) {
 
     m_mesh->draw(rs, *m_selectionProgram, false);
 
+    if (m_instancedMesh->numberOfInstances() > 0) {
+        m_instancedMesh->upload(rs);
+
+        setupShaderUniforms(rs, *m_instancedSelectionProgram, _view, m_instancedSelectionStyleUniforms);
+
+        m_instancedSelectionProgram->setUniformMatrix4f(rs, m_instancedSelectionUniforms.uOrtho,
+                                                        _view.getOrthoViewportMatrix());
+
+        m_instancedMesh->draw(rs, *m_instancedSelectionProgram, false);
+    }
+
     m_textStyle->onBeginDrawSelectionFrame(rs, _view);
 }
 
@@ -116,15 +206,47 @@ void PointStyle::setPixelScale(float _pixelScale) {
     m_textStyle->setPixelScale(_pixelScale);
 }
 
+bool PointStyle::setStyleUniform(const std::string& _name, const UniformValue& _value) {
+    if (!Style::setStyleUniform(_name, _value)) { return false; }
+
+    for (auto& uniform : m_instancedStyleUniforms.styleUniforms) {
+        if (uniform.first.getName() == _name) { uniform.second = _value; }
+    }
+    return true;
+}
+
+// Images of one atlas are drawn in one batch
+static bool sameTexture(const Texture* _a, const Texture* _b) {
+    if (_a == _b) { return true; }
+    return _a && _b && _a->sharedTexture() == _b->sharedTexture();
+}
+
 SpriteVertex* PointStyle::pushQuad(Texture* texture) const {
 
-    if (m_batches.empty() || m_batches.back().texture != texture) {
-        m_batches.push_back({ texture });
+    if (m_batches.empty() || !sameTexture(m_batches.back().texture, texture) ||
+        m_batches.back().instanced) {
+        m_batches.push_back({ texture, false });
     }
 
-    m_batches.back().vertexCount += 4;
+    m_batches.back().count += 4;
 
     return m_mesh->pushQuad();
 }
 
+bool PointStyle::useInstancing() const {
+    return Hardware::supportsInstancing;
+}
+
+SpriteInstance* PointStyle::pushInstance(Texture* texture) const {
+
+    if (m_batches.empty() || !sameTexture(m_batches.back().texture, texture) ||
+        !m_batches.back().instanced) {
+        m_batches.push_back({ texture, true });
+    }
+
+    m_batches.back().count += 1;
+
+    return m_instancedMesh->pushInstance();
+}
+
 }
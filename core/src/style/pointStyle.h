@@ -1,6 +1,7 @@
 #pragma once
 
 #include "gl/dynamicQuadMesh.h"
+#include "gl/instancedQuadMesh.h"
 #include "labels/spriteLabel.h"
 #include "labels/labelProperty.h"
 #include "labels/textLabels.h"
@@ -26,9 +27,11 @@ public:
 
     virtual ~PointStyle();
 
-    virtual void onBeginUpdate() override;
+    virtual void onBeginUpdate(bool _labelSetChanged, float _time) override;
     virtual void onBeginDrawFrame(RenderState& rs, const View& _view) override;
     virtual void onBeginFrame(RenderState& rs) override;
+    virtual void compileShaders(RenderState& rs) override;
+    virtual bool shadersReady(RenderState& rs) override;
     virtual void onBeginDrawSelectionFrame(RenderState& rs, const View& _view) override;
     virtual bool draw(RenderState& rs, const Tile& _tile) override { return false; }
     virtual bool draw(RenderState& rs, const Marker& _marker) override { return false; }
@@ -48,7 +51,9 @@ public:
     const auto& defaultTexture() const { return m_defaultTexture; }
 
     auto& mesh() const { return m_mesh; }
-    virtual size_t dynamicMeshSize() const override { return m_mesh->bufferSize(); }
+    virtual size_t dynamicMeshSize() const override {
+        return m_mesh->bufferSize() + m_instancedMesh->bufferSize();
+    }
 
     virtual std::unique_ptr<StyleBuilder> createBuilder() const override;
 
@@ -60,8 +65,15 @@ public:
     TextStyle& textStyle() const { return *m_textStyle; }
     virtual void setPixelScale(float _pixelScale) override;
 
+    virtual bool setStyleUniform(const std::string& _name, const UniformValue& _value) override;
+
     SpriteVertex* pushQuad(Texture* texture) const;
 
+    // Whether billboard sprites are drawn as instances of one quad
+    bool useInstancing() const;
+
+    SpriteInstance* pushInstance(Texture* texture) const;
+
 protected:
 
     void drawMesh(RenderState& rs, ShaderProgram& shaderProgram, UniformLocation& uSpriteMode);
@@ -75,15 +87,28 @@ protected:
         UniformLocation uSpriteMode{"u_sprite_mode"};
     } m_mainUniforms, m_selectionUniforms;
 
+    // Uniforms of the instanced programs
+    Style::UniformBlock m_instancedStyleUniforms, m_instancedSelectionStyleUniforms;
+    UniformBlock m_instancedUniforms, m_instancedSelectionUniforms;
+
     struct TextureBatch {
-        TextureBatch(Texture* t) : texture(t) {}
+        TextureBatch(Texture* t, bool i) : texture(t), instanced(i) {}
         Texture* texture = nullptr;
-        size_t vertexCount = 0;
+        bool instanced = false;
+        // Vertices of m_mesh, or instances of m_instancedMesh
+        size_t count = 0;
     };
 
     mutable std::unique_ptr<DynamicQuadMesh<SpriteVertex>> m_mesh;
     mutable std::vector<TextureBatch> m_batches;
 
+    std::shared_ptr<VertexLayout> m_instanceLayout;
+    mutable std::unique_ptr<InstancedQuadMesh<SpriteInstance>> m_instancedMesh;
+
+    // Variants of the shader programs that read the quads from m_instancedMesh
+    std::shared_ptr<ShaderProgram> m_instancedProgram;
+    std::shared_ptr<ShaderProgram> m_instancedSelectionProgram;
+
     std::unique_ptr<TextStyle> m_textStyle;
 };
 
@@ -212,6 +212,7 @@ auto PointStyleBuilder::applyRule(const DrawRule& _rule) const -> Parameters {
 
     std::hash<Parameters> hash;
     p.labelOptions.paramHash = hash(p);
+    p.labelOptions.sourceId = m_sourceId;
 
     if (p.interactive) {
         p.labelOptions.featureId = _rule.selectionColor;
@@ -310,9 +311,25 @@ bool PointStyleBuilder::getTexture(const Parameters& _params, Texture **_texture
     return true;
 }
 
+int PointStyleBuilder::getSpriteId(const Parameters& _params, const SpriteAtlas& _atlas) const {
+    auto& cache = m_spriteCache;
+    if (cache.atlas == &_atlas && cache.sprite == _params.sprite &&
+        cache.spriteDefault == _params.spriteDefault) {
+        return cache.id;
+    }
+
+    int id = _atlas.getSpriteId(_params.sprite);
+    if (id < 0) { id = _atlas.getSpriteId(_params.spriteDefault); }
+
+    cache.atlas = &_atlas;
+    cache.sprite = _params.sprite;
+    cache.spriteDefault = _params.spriteDefault;
+    cache.id = id;
+    return id;
+}
+
 bool PointStyleBuilder::evalSizeParam(const DrawRule& _rule, Parameters& _params, const Texture* _texture) const {
     StyleParam::SizeValue size;
-    SpriteNode spriteNode;
     glm::vec2 spriteSize(NAN);
 
     if (_texture) {
@@ -320,11 +337,11 @@ bool PointStyleBuilder::evalSizeParam(const DrawRule& _rule, Parameters& _params
 
         const auto &atlas = _texture->spriteAtlas();
         if (atlas) {
-            if (!atlas->getSpriteNode(_params.sprite, spriteNode) &&
-                !atlas->getSpriteNode(_params.spriteDefault, spriteNode)) {
+            _params.spriteId = getSpriteId(_params, *atlas);
+            if (_params.spriteId < 0) {
                 return false;
             }
-            spriteSize = spriteNode.m_size * _texture->displayScale();
+            spriteSize = atlas->getSpriteNode(_params.spriteId).m_size * _texture->displayScale();
         } else if ( !_params.sprite.empty() || !_params.spriteDefault.empty()) {
             // missing sprite atlas for texture but sprite specified in draw rule
             return false;
@@ -366,16 +383,18 @@ bool PointStyleBuilder::getUVQuad(Parameters& _params, glm::vec4& _quad, const T
     if (_texture) {
         const auto& atlas = _texture->spriteAtlas();
         if (atlas) {
-            SpriteNode spriteNode;
-            if (!atlas->getSpriteNode(_params.sprite, spriteNode) &&
-                !atlas->getSpriteNode(_params.spriteDefault, spriteNode)) {
-                return false;
-            }
+            // Resolved by evalSizeParam()
+            const auto& spriteNode = atlas->getSpriteNode(_params.spriteId);
             _quad.x = spriteNode.m_uvBL.x;
             _quad.y = spriteNode.m_uvBL.y;
             _quad.z = spriteNode.m_uvTR.x;
             _quad.w = spriteNode.m_uvTR.y;
         }
+
+        // Map to the image in an icon atlas
+        glm::vec4 rect = _texture->uvRect();
+        _quad = glm::vec4(rect.x + _quad.x * rect.z, rect.y + _quad.y * rect.w,
+                          rect.x + _quad.z * rect.z, rect.y + _quad.w * rect.w);
     } else {
 
         float fillEdge = _params.size.x;
@@ -404,7 +423,7 @@ bool PointStyleBuilder::getUVQuad(Parameters& _params, glm::vec4& _quad, const T
     return true;
 }
 
-void PointStyleBuilder::labelPointsPlacing(const Line& _line, const glm::vec4& _uvsQuad, Texture* _texture,
+void PointStyleBuilder::labelPointsPlacing(const LineView& _line, const glm::vec4& _uvsQuad, Texture* _texture,
                                            Parameters& params, const DrawRule& _rule) {
 
     if (_line.size() < 2) { return; }
@@ -516,7 +535,7 @@ bool PointStyleBuilder::addPoint(const Point& _point, const Properties& _props,
     return true;
 }
 
-bool PointStyleBuilder::addLine(const Line& _line, const Properties& _props,
+bool PointStyleBuilder::addLine(const LineView& _line, const Properties& _props,
                                 const DrawRule& _rule) {
 
     Parameters p = applyRule(_rule);
@@ -538,7 +557,7 @@ bool PointStyleBuilder::addLine(const Line& _line, const Properties& _props,
     return true;
 }
 
-bool PointStyleBuilder::addPolygon(const Polygon& _polygon, const Properties& _props,
+bool PointStyleBuilder::addPolygon(const PolygonView& _polygon, const Properties& _props,
                                    const DrawRule& _rule) {
 
     Parameters p = applyRule(_rule);
@@ -573,6 +592,7 @@ bool PointStyleBuilder::addPolygon(const Polygon& _polygon, const Properties& _p
 bool PointStyleBuilder::addFeature(const Feature& _feat, const DrawRule& _rule) {
 
     size_t iconsStart = m_labels.size();
+    m_sourceId = _feat.id;
 
     if (!StyleBuilder::addFeature(_feat, _rule)) {
         return false;
@@ -590,6 +610,7 @@ bool PointStyleBuilder::addFeature(const Feature& _feat, const DrawRule& _rule)
         auto& textLabels = *textStyleBuilder.labels();
 
         TextStyle::Parameters params = textStyleBuilder.applyRule(_rule, _feat.props, true);
+        params.labelOptions.sourceId = _feat.id;
 
         TextStyleBuilder::LabelAttributes attrib;
         if (textStyleBuilder.prepareLabel(params, Label::Type::point, attrib)) {
@@ -26,6 +26,8 @@ struct PointStyleBuilder : public StyleBuilder {
         bool dynamicTexture = false;
         std::string sprite;
         std::string spriteDefault;
+        // Id of sprite or spriteDefault in the sprite atlas of the texture
+        int spriteId = -1;
         std::string texture;
         glm::vec2 size = { 16.f, 16.f };
         uint32_t color = 0xffffffff;
@@ -47,12 +49,18 @@ struct PointStyleBuilder : public StyleBuilder {
 
     bool checkRule(const DrawRule& _rule) const override;
 
-    bool addPolygon(const Polygon& _polygon, const Properties& _props, const DrawRule& _rule) override;
-    bool addLine(const Line& _line, const Properties& _props, const DrawRule& _rule) override;
+    bool addPolygon(const PolygonView& _polygon, const Properties& _props, const DrawRule& _rule) override;
+    bool addLine(const LineView& _line, const Properties& _props, const DrawRule& _rule) override;
     bool addPoint(const Point& _line, const Properties& _props, const DrawRule& _rule) override;
 
     std::unique_ptr<StyledMesh> build() override;
 
+    size_t scratchCapacity() const override {
+        return m_quads.capacity() * sizeof(SpriteQuad) +
+            m_labels.capacity() * sizeof(m_labels[0]) +
+            (m_textStyleBuilder ? m_textStyleBuilder->scratchCapacity() : 0);
+    }
+
     const Style& style() const override { return m_style; }
 
     PointStyleBuilder(const PointStyle& _style) : m_style(_style) {
@@ -62,7 +70,7 @@ struct PointStyleBuilder : public StyleBuilder {
     Parameters applyRule(const DrawRule& _rule) const;
 
     // Gets points for label placement and appropriate angle for each label (if `auto` angle is set)
-    void labelPointsPlacing(const Line& _line, const glm::vec4& _quad, Texture* _texture,
+    void labelPointsPlacing(const LineView& _line, const glm::vec4& _quad, Texture* _texture,
                             Parameters& _params, const DrawRule& _rule);
 
     void addLabel(const Point& _point, const glm::vec4& _quad, Texture* _texture,
@@ -95,6 +103,9 @@ private:
     bool evalSizeParam(const DrawRule& _rule, Parameters& _params, const Texture* _texture) const;
     bool getUVQuad(Parameters& _params, glm::vec4& _quad, const Texture* _texture) const;
 
+    // Id of the sprite of _params in _atlas, or -1
+    int getSpriteId(const Parameters& _params, const SpriteAtlas& _atlas) const;
+
     std::vector<std::unique_ptr<Label>> m_labels;
     std::vector<SpriteQuad> m_quads;
 
@@ -103,12 +114,23 @@ private:
     float m_zoom = 0;
     float m_styleZoom = 0;
     float m_tileScale = 1;
+    // ID of the feature whose labels are being added
+    uint64_t m_sourceId = 0;
     std::unique_ptr<SpriteLabels> m_spriteLabels;
     std::unique_ptr<StyleBuilder> m_textStyleBuilder;
 
     // Non-owning reference to a texture to use for the current feature.
     Texture* m_texture = nullptr;
 
+    // Sprite names resolved last, which most consecutive features share
+    struct SpriteCache {
+        const SpriteAtlas* atlas = nullptr;
+        std::string sprite;
+        std::string spriteDefault;
+        int id = -1;
+    };
+    mutable SpriteCache m_spriteCache;
+
 };
 
 }
@@ -11,11 +11,14 @@
 #include "util/builders.h"
 #include "util/color.h"
 #include "util/extrude.h"
+#include "util/mapProjection.h"
 
 #include "glm/vec2.hpp"
 #include "glm/vec3.hpp"
 #include "glm/gtc/type_precision.hpp"
+#include <algorithm>
 #include <cmath>
+#include <limits>
 
 #include "polygon_fs.h"
 #include "polygon_vs.h"
@@ -50,31 +53,56 @@ struct PolygonVertex : PolygonVertexNoUVs {
     glm::u16vec2 texcoord;
 };
 
+// Vertices of styles without a normal attribute
+struct PolygonVertexNoNormals {
+
+    PolygonVertexNoNormals(glm::vec3 position, uint32_t order, glm::vec3 normal, glm::vec2 uv, GLuint abgr, GLuint selection)
+        : pos(glm::i16vec4{ glm::round(position * position_scale), order }),
+          abgr(abgr),
+          selection(selection) {}
+
+    glm::i16vec4 pos; // pos.w contains layer (params.order)
+    GLuint abgr;
+    GLuint selection;
+};
+
+struct PolygonVertexNoNormalsUVs : PolygonVertexNoNormals {
+
+    PolygonVertexNoNormalsUVs(glm::vec3 position, uint32_t order, glm::vec3 normal, glm::vec2 uv, GLuint abgr, GLuint selection)
+        : PolygonVertexNoNormals(position, order, normal, uv, abgr, selection), texcoord(uv * texture_scale) {}
+
+    glm::u16vec2 texcoord;
+};
+
 PolygonStyle::PolygonStyle(std::string _name, Blending _blendMode, GLenum _drawMode, bool _selection)
     : Style(_name, _blendMode, _drawMode, _selection) {
     m_type = StyleType::polygon;
     m_material.material = std::make_shared<Material>();
+    m_tileBatching = true;
+    m_uniformBlocks = true;
 }
 
 void PolygonStyle::constructVertexLayout() {
-    
+
+    // Without lighting the normals are only used by shader blocks of the scene
+    m_normalAttribute = m_lightingType != LightingType::none;
+    m_boundedMeshes = true;
+    for (auto& block : m_shaderSource->getSourceBlocks()) {
+        if (block.first != "defines" && block.first != "uniforms") { m_normalAttribute = true; }
+        if (block.first == "position") { m_boundedMeshes = false; }
+    }
+
+    std::vector<VertexLayout::VertexAttrib> attribs = {{"a_position", 4, GL_SHORT, false, 0}};
+    if (m_normalAttribute) {
+        attribs.push_back({"a_normal", 4, GL_BYTE, true, 0}); // The 4th byte is for padding
+    }
+    attribs.push_back({"a_color", 4, GL_UNSIGNED_BYTE, true, 0});
+    attribs.push_back({"a_selection_color", 4, GL_UNSIGNED_BYTE, true, 0});
     if (m_texCoordsGeneration) {
-        m_vertexLayout = std::shared_ptr<VertexLayout>(new VertexLayout({
-            {"a_position", 4, GL_SHORT, false, 0},
-            {"a_normal", 4, GL_BYTE, true, 0}, // The 4th byte is for padding
-            {"a_color", 4, GL_UNSIGNED_BYTE, true, 0},
-            {"a_selection_color", 4, GL_UNSIGNED_BYTE, true, 0},
-            {"a_texcoord", 2, GL_UNSIGNED_SHORT, true, 0},
-        }));
-    } else {
-        m_vertexLayout = std::shared_ptr<VertexLayout>(new VertexLayout({
-            {"a_position", 4, GL_SHORT, false, 0},
-            {"a_normal", 4, GL_BYTE, true, 0},
-            {"a_color", 4, GL_UNSIGNED_BYTE, true, 0},
-            {"a_selection_color", 4, GL_UNSIGNED_BYTE, true, 0},
-        }));
+        attribs.push_back({"a_texcoord", 2, GL_UNSIGNED_SHORT, true, 0});
     }
 
+    m_vertexLayout = std::make_shared<VertexLayout>(attribs);
 }
 
 void PolygonStyle::constructShaderProgram() {
@@ -84,6 +112,9 @@ void PolygonStyle::constructShaderProgram() {
     if (m_texCoordsGeneration) {
         m_shaderSource->addSourceBlock("defines", "#define TANGRAM_USE_TEX_COORDS\n");
     }
+    if (!m_normalAttribute) {
+        m_shaderSource->addSourceBlock("defines", "#define TANGRAM_NO_NORMAL_ATTRIBUTE\n");
+    }
 }
 
 template <class V>
@@ -99,49 +130,136 @@ public:
         float minHeight;
         uint32_t selectionColor = 0;
         bool keepTileEdges = false;
+        // Walls lower than this on screen are not built, in pixels
+        float wallMinHeight = 0;
+        bool mergeWalls = false;
+        bool skipInteriorWalls = false;
     };
 
     void setup(const Tile& _tile) override {
+        const auto& id = _tile.getID();
         m_tileUnitsPerMeter = _tile.getInverseScale();
-        m_zoom = _tile.getID().z;
+        m_zoom = id.z;
+        // Size of the tile on screen at its style zoom
+        m_pixelsPerTileUnit = MapProjection::tileSize() * m_style.pixelScale() * exp2(id.s - id.z);
+        m_simplifyTolerance = m_style.simplifyTolerance() * m_style.pixelScale() / m_pixelsPerTileUnit;
+        m_clipToTile = true;
         m_meshData.clear();
+        m_walls.clear();
     }
 
     void setup(const Marker& _marker, int zoom) override {
         m_zoom = zoom;
         m_tileUnitsPerMeter = 1.f / _marker.extent();
+        m_pixelsPerTileUnit = MapProjection::tileSize() * m_style.pixelScale() *
+            _marker.extent() / MapProjection::metersPerTileAtZoom(zoom);
+        m_simplifyTolerance = m_style.simplifyTolerance() * m_style.pixelScale() / m_pixelsPerTileUnit;
+        m_clipToTile = false;
         m_meshData.clear();
+        m_walls.clear();
     }
 
-    bool addPolygon(const Polygon& _polygon, const Properties& _props, const DrawRule& _rule) override;
+    bool addPolygon(const PolygonView& _polygon, const Properties& _props, const DrawRule& _rule) override;
 
     const Style& style() const override { return m_style; }
 
     std::unique_ptr<StyledMesh> build() override;
 
+    MeshBounds meshBounds() const override { return m_bounds; }
+
+    bool canMerge() const override { return true; }
+
+    void merge(StyleBuilder& _other) override {
+        auto& other = static_cast<PolygonStyleBuilder<V>&>(_other);
+        m_meshData.append(other.m_meshData);
+        m_walls.insert(m_walls.end(), other.m_walls.begin(), other.m_walls.end());
+        other.m_meshData.clear();
+        other.m_walls.clear();
+    }
+
     PolygonStyleBuilder(const PolygonStyle& _style) : m_style(_style) {}
 
+    size_t scratchCapacity() const override {
+        return m_meshData.capacityBytes() + m_builder.indices.capacity() * sizeof(uint16_t) +
+            m_walls.capacity() * sizeof(Wall);
+    }
+
     Parameters parseRule(const DrawRule& _rule, const Properties& _props);
 
     PolygonBuilder& polygonBuilder() { return m_builder; }
 
+    bool boundedMeshes = true;
+
 private:
 
+    // Wall of a feature with skipInteriorWalls, built with the others in build()
+    struct Wall {
+        glm::vec2 a, b;
+        float minHeight;
+        float height;
+        uint32_t order;
+        uint32_t color;
+        uint32_t selectionColor;
+        bool merge;
+
+        bool sameParams(const Wall& _other) const {
+            return minHeight == _other.minHeight && height == _other.height &&
+                order == _other.order && color == _other.color &&
+                selectionColor == _other.selectionColor;
+        }
+    };
+
+    void buildWalls();
+
     const PolygonStyle& m_style;
 
     PolygonBuilder m_builder;
 
     MeshData<V> m_meshData;
 
+    // Consecutive walls of a ring are kept in order
+    std::vector<Wall> m_walls;
+
+    MeshBounds m_bounds;
+
     float m_tileUnitsPerMeter = 0;
+    float m_pixelsPerTileUnit = 0;
     int m_zoom = 0;
 
+    // Simplification tolerance in tile units, and the simplified rings
+    float m_simplifyTolerance = 0;
+    GeometryBuffer m_simplified;
+
+    // Polygons of tiles are clipped to the tile, unless tile edges are kept
+    bool m_clipToTile = false;
+    GeometryBuffer m_clipped;
+
 };
 
 template <class V>
 std::unique_ptr<StyledMesh> PolygonStyleBuilder<V>::build() {
+    if (!m_walls.empty()) { buildWalls(); }
+
+    m_bounds = {};
     if (m_meshData.vertices.empty()) { return nullptr; }
 
+    if (boundedMeshes) {
+        for (const auto& vertex : m_meshData.vertices) {
+            m_bounds.expand(glm::vec3(vertex.pos) / position_scale);
+        }
+    }
+
+    if (m_style.drawsFrontToBack()) {
+        // The tallest features first, so that they hide what is behind them
+        m_meshData.sortChunks([](const V* _vertices, size_t _count) {
+            int16_t height = 0;
+            for (size_t i = 0; i < _count; i++) {
+                height = std::max(height, _vertices[i].pos.z);
+            }
+            return -float(height);
+        });
+    }
+
     auto mesh = std::make_unique<Mesh<V>>(m_style.vertexLayout(),
                                                       m_style.drawMode());
     mesh->compile(m_meshData);
@@ -150,6 +268,84 @@ std::unique_ptr<StyledMesh> PolygonStyleBuilder<V>::build() {
     return std::move(mesh);
 }
 
+template <class V>
+void PolygonStyleBuilder<V>::buildWalls() {
+
+    auto edgeLess = [](const glm::vec2& a0, const glm::vec2& b0, const glm::vec2& a1, const glm::vec2& b1) {
+        if (a0.x != a1.x) { return a0.x < a1.x; }
+        if (a0.y != a1.y) { return a0.y < a1.y; }
+        if (b0.x != b1.x) { return b0.x < b1.x; }
+        return b0.y < b1.y;
+    };
+
+    std::vector<uint32_t> sorted(m_walls.size());
+    for (uint32_t i = 0; i < sorted.size(); i++) { sorted[i] = i; }
+    std::sort(sorted.begin(), sorted.end(), [&](uint32_t i, uint32_t j) {
+        return edgeLess(m_walls[i].a, m_walls[i].b, m_walls[j].a, m_walls[j].b);
+    });
+
+    // A wall is hidden by the opposite wall of an adjacent footprint that
+    // covers its height
+    std::vector<bool> hidden(m_walls.size(), false);
+    for (uint32_t i = 0; i < m_walls.size(); i++) {
+        const auto& wall = m_walls[i];
+        auto it = std::lower_bound(sorted.begin(), sorted.end(), i, [&](uint32_t j, uint32_t) {
+            return edgeLess(m_walls[j].a, m_walls[j].b, wall.b, wall.a);
+        });
+        for (; it != sorted.end(); ++it) {
+            const auto& other = m_walls[*it];
+            if (other.a != wall.b || other.b != wall.a) { break; }
+            if (other.minHeight <= wall.minHeight && other.height >= wall.height) {
+                hidden[i] = true;
+                break;
+            }
+        }
+    }
+
+    const Wall* params = nullptr;
+    auto addVertex = [&](const glm::vec3& coord, const glm::vec3& normal, const glm::vec2& uv) {
+        m_meshData.vertices.push_back({ coord, params->order, normal, uv,
+                                        params->color, params->selectionColor });
+    };
+
+    auto flush = [&]() {
+        m_meshData.indices.insert(m_meshData.indices.end(),
+                                  m_builder.indices.begin(),
+                                  m_builder.indices.end());
+        m_meshData.offsets.emplace_back(m_builder.indices.size(),
+                                        m_builder.numVertices);
+        m_builder.clear();
+    };
+
+    m_builder.clear();
+
+    for (size_t i = 0; i < m_walls.size(); i++) {
+        if (hidden[i]) { continue; }
+
+        params = &m_walls[i];
+        glm::vec2 b = params->b;
+
+        // Extend the wall over the following visible walls of its ring
+        while (params->merge && i + 1 < m_walls.size() && !hidden[i + 1]) {
+            const auto& next = m_walls[i + 1];
+            if (next.a != b || !next.sameParams(*params) ||
+                !Builders::isCollinear(params->a, b, next.b)) {
+                break;
+            }
+            b = next.b;
+            i++;
+        }
+
+        if (m_builder.numVertices + 4 > std::numeric_limits<uint16_t>::max()) { flush(); }
+
+        Builders::buildWall(params->a, b, params->minHeight, params->height, m_builder, addVertex);
+    }
+
+    if (m_builder.numVertices > 0) { flush(); }
+
+    m_walls.clear();
+}
+
 template <class V>
 auto PolygonStyleBuilder<V>::parseRule(const DrawRule& _rule, const Properties& _props) -> Parameters {
     Parameters p;
@@ -162,6 +358,9 @@ auto PolygonStyleBuilder<V>::parseRule(const DrawRule& _rule, const Properties&
     _rule.get(StyleParamKey::extrude, p.extrude);
     _rule.get(StyleParamKey::order, p.order);
     _rule.get(StyleParamKey::tile_edges, p.keepTileEdges);
+    _rule.get(StyleParamKey::walls_min_height, p.wallMinHeight);
+    _rule.get(StyleParamKey::walls_merge, p.mergeWalls);
+    _rule.get(StyleParamKey::walls_skip_interior, p.skipInteriorWalls);
 
     if (Tangram::getDebugFlag(Tangram::DebugFlags::proxy_colors)) {
         p.color <<= (m_zoom % 6);
@@ -176,24 +375,47 @@ auto PolygonStyleBuilder<V>::parseRule(const DrawRule& _rule, const Properties&
 }
 
 template <class V>
-bool PolygonStyleBuilder<V>::addPolygon(const Polygon& _polygon, const Properties& _props, const DrawRule& _rule) {
+bool PolygonStyleBuilder<V>::addPolygon(const PolygonView& _polygon, const Properties& _props, const DrawRule& _rule) {
+
+    const Parameters p = parseRule(_rule, _props);
 
-    auto p = parseRule(_rule, _props);
+    PolygonView polygon = _polygon;
+    if (m_clipToTile && !p.keepTileEdges) {
+        m_clipped.clear();
+        polygon = Builders::clipPolygon(polygon, m_clipped);
+        if (polygon.empty()) { return false; }
+    }
+    if (m_simplifyTolerance > 0) {
+        m_simplified.clear();
+        polygon = Builders::simplifyPolygon(polygon, m_simplifyTolerance, m_simplified);
+    }
 
     m_builder.keepTileEdges = p.keepTileEdges;
+    m_builder.mergeCollinearWalls = p.mergeWalls;
 
-    m_builder.addVertex = [this, p](const glm::vec3& coord,
-                                 const glm::vec3& normal,
-                                 const glm::vec2& uv) {
-        m_meshData.vertices.push_back({ coord, p.order, normal, uv, p.color, p.selectionColor });
+    auto& vertices = m_meshData.vertices;
+    auto addVertex = [&](const glm::vec3& coord, const glm::vec3& normal, const glm::vec2& uv) {
+        vertices.push_back({ coord, p.order, normal, uv, p.color, p.selectionColor });
     };
 
-    if (p.minHeight != p.height) {
-        Builders::buildPolygonExtrusion(_polygon, p.minHeight,
-                                        p.height, m_builder);
+    float wallHeight = std::abs(p.height - p.minHeight) * m_pixelsPerTileUnit;
+
+    if (p.minHeight != p.height && wallHeight >= p.wallMinHeight * m_style.pixelScale()) {
+        if (p.skipInteriorWalls) {
+            // Shared walls are only known once all features are added;
+            // collinear edges are merged after they are removed
+            m_builder.mergeCollinearWalls = false;
+            Builders::forEachWall(polygon, m_builder, [&](const glm::vec2& a, const glm::vec2& b) {
+                m_walls.push_back({ a, b, p.minHeight, p.height, p.order, p.color,
+                                    p.selectionColor, p.mergeWalls });
+            });
+        } else {
+            Builders::buildPolygonExtrusion(polygon, p.minHeight,
+                                            p.height, m_builder, addVertex);
+        }
     }
 
-    Builders::buildPolygon(_polygon, p.height, m_builder);
+    Builders::buildPolygon(polygon, p.height, m_builder, addVertex);
 
     m_meshData.indices.insert(m_meshData.indices.end(),
                               m_builder.indices.begin(),
@@ -206,16 +428,24 @@ bool PolygonStyleBuilder<V>::addPolygon(const Polygon& _polygon, const Propertie
     return true;
 }
 
+template <class V>
+static std::unique_ptr<StyleBuilder> createPolygonBuilder(const PolygonStyle& _style, bool _texCoords,
+                                                          bool _bounded) {
+    auto builder = std::make_unique<PolygonStyleBuilder<V>>(_style);
+    builder->polygonBuilder().useTexCoords = _texCoords;
+    builder->boundedMeshes = _bounded;
+    return std::move(builder);
+}
+
 std::unique_ptr<StyleBuilder> PolygonStyle::createBuilder() const {
-    if (m_texCoordsGeneration) {
-        auto builder = std::make_unique<PolygonStyleBuilder<PolygonVertex>>(*this);
-        builder->polygonBuilder().useTexCoords = true;
-        return std::move(builder);
-    } else {
-        auto builder = std::make_unique<PolygonStyleBuilder<PolygonVertexNoUVs>>(*this);
-        builder->polygonBuilder().useTexCoords = false;
-        return std::move(builder);
+    if (m_normalAttribute) {
+        return m_texCoordsGeneration
+            ? createPolygonBuilder<PolygonVertex>(*this, true, m_boundedMeshes)
+            : createPolygonBuilder<PolygonVertexNoUVs>(*this, false, m_boundedMeshes);
     }
+    return m_texCoordsGeneration
+        ? createPolygonBuilder<PolygonVertexNoNormalsUVs>(*this, true, m_boundedMeshes)
+        : createPolygonBuilder<PolygonVertexNoNormals>(*this, false, m_boundedMeshes);
 }
 
 }
@@ -18,6 +18,14 @@ public:
     virtual std::unique_ptr<StyleBuilder> createBuilder() const override;
     virtual ~PolygonStyle() {}
 
+protected:
+
+    // Normals are only stored when lighting or shader blocks may use them
+    bool m_normalAttribute = true;
+
+    // Whether vertices stay in their mesh bounds, which a position shader block may change
+    bool m_boundedMeshes = true;
+
 };
 
 }
@@ -1,6 +1,7 @@
 #include "style/polylineStyle.h"
 
 #include "gl/shaderProgram.h"
+#include "gl/appendableMesh.h"
 #include "gl/mesh.h"
 #include "gl/texture.h"
 #include "gl/renderState.h"
@@ -9,6 +10,8 @@
 #include "marker/marker.h"
 #include "material.h"
 #include "platform.h"
+#include "scene/dataLayer.h"
+#include "scene/scene.h"
 #include "scene/stops.h"
 #include "scene/drawRule.h"
 #include "tile/tile.h"
@@ -21,6 +24,8 @@
 #include "glm/vec3.hpp"
 #include "glm/gtc/type_precision.hpp"
 
+#include <set>
+
 #include "polyline_vs.h"
 #include "polyline_fs.h"
 
@@ -65,31 +70,142 @@ struct PolylineVertex : PolylineVertexNoUVs {
     glm::u16vec2 texcoord;
 };
 
+// Mesh of the line of a marker, which is extended when points are appended to the line
+template <class V>
+struct PolylineMesh : public AppendableMesh<V> {
+    using AppendableMesh<V>::AppendableMesh;
+
+    // Points of the line in the mesh, and the distance along it to its second to last point
+    size_t points = 0;
+    float distance = 0;
+};
+
+// Outline of the line of a vertex, drawn in the outline pass of the mesh
+struct PolylineOutline {
+    // Width, width change to the next zoom, order and padding
+    glm::i16vec4 outline = {};
+    GLuint outlineAbgr = 0;
+};
+
+template <class V>
+struct PolylineVertexWithOutline : V, PolylineOutline {
+    using V::V;
+};
+
+// Set the outline of _vertices from _start, or return false when they have none
+template <class V>
+static bool setOutline(std::vector<V>& _vertices, size_t _start, glm::i16vec4 _outline, GLuint _abgr) {
+    return false;
+}
+
+template <class V>
+static bool setOutline(std::vector<PolylineVertexWithOutline<V>>& _vertices, size_t _start,
+                       glm::i16vec4 _outline, GLuint _abgr) {
+    for (size_t i = _start; i < _vertices.size(); i++) {
+        _vertices[i].outline = _outline;
+        _vertices[i].outlineAbgr = _abgr;
+    }
+    return true;
+}
+
+// Whether _rule draws an outline with the line
+static bool hasOutline(const DrawRuleData& _rule) {
+    for (const auto& param : _rule.parameters) {
+        if (param.key == StyleParamKey::outline_width ||
+            param.key == StyleParamKey::outline_color) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Collect the names of the draw rules of _layer and its sublayers that may
+// use _style, and of those that draw outlines
+static void collectRules(const SceneLayer& _layer, const std::string& _style,
+                         std::set<std::string>& _styleRules, std::set<std::string>& _outlineRules) {
+
+    for (const auto& rule : _layer.rules()) {
+        if (rule.name == _style) { _styleRules.insert(rule.name); }
+
+        for (const auto& param : rule.parameters) {
+            if (param.key != StyleParamKey::style) { continue; }
+            // Style functions may return any style
+            if (param.function >= 0 ||
+                (param.value.is<std::string>() && param.value.get<std::string>() == _style)) {
+                _styleRules.insert(rule.name);
+            }
+        }
+        if (hasOutline(rule)) { _outlineRules.insert(rule.name); }
+    }
+
+    for (const auto& sublayer : _layer.sublayers()) {
+        collectRules(sublayer, _style, _styleRules, _outlineRules);
+    }
+}
+
 PolylineStyle::PolylineStyle(std::string _name, Blending _blendMode, GLenum _drawMode, bool _selection)
     : Style(_name, _blendMode, _drawMode, _selection) {
     m_type = StyleType::polyline;
     m_material.material = std::make_shared<Material>();
+    m_tileBatching = true;
+    m_uniformBlocks = true;
+}
+
+void PolylineStyle::build(const Scene& _scene) {
+
+    // Lines of this style carry their outlines when a draw rule that may use
+    // this style draws outlines, or when its default draw rule does
+    std::set<std::string> styleRules, outlineRules;
+    for (const auto& layer : _scene.layers()) {
+        collectRules(layer, m_name, styleRules, outlineRules);
+    }
+
+    m_outlineAttributes = false;
+    for (const auto& rule : styleRules) {
+        if (outlineRules.count(rule) || (m_defaultDrawRule && hasOutline(*m_defaultDrawRule))) {
+            m_outlineAttributes = true;
+            break;
+        }
+    }
+
+    Style::build(_scene);
 }
 
 void PolylineStyle::constructVertexLayout() {
 
     // TODO: Ideally this would be in the same location as the struct that it basically describes
+    std::vector<VertexLayout::VertexAttrib> attribs = {
+        {"a_position", 4, GL_SHORT, false, 0},
+        {"a_extrude", 4, GL_SHORT, false, 0},
+        {"a_color", 4, GL_UNSIGNED_BYTE, true, 0},
+        {"a_selection_color", 4, GL_UNSIGNED_BYTE, true, 0},
+    };
     if (m_texCoordsGeneration) {
-        m_vertexLayout = std::shared_ptr<VertexLayout>(new VertexLayout({
-            {"a_position", 4, GL_SHORT, false, 0},
-            {"a_extrude", 4, GL_SHORT, false, 0},
-            {"a_color", 4, GL_UNSIGNED_BYTE, true, 0},
-            {"a_selection_color", 4, GL_UNSIGNED_BYTE, true, 0},
-            {"a_texcoord", 2, GL_UNSIGNED_SHORT, false, 0},
-        }));
-    } else {
-        m_vertexLayout = std::shared_ptr<VertexLayout>(new VertexLayout({
-            {"a_position", 4, GL_SHORT, false, 0},
-            {"a_extrude", 4, GL_SHORT, false, 0},
-            {"a_color", 4, GL_UNSIGNED_BYTE, true, 0},
-            {"a_selection_color", 4, GL_UNSIGNED_BYTE, true, 0},
-        }));
+        attribs.push_back({"a_texcoord", 2, GL_UNSIGNED_SHORT, false, 0});
     }
+    if (m_outlineAttributes) {
+        attribs.push_back({"a_outline", 4, GL_SHORT, false, 0});
+        attribs.push_back({"a_outline_color", 4, GL_UNSIGNED_BYTE, true, 0});
+    }
+    m_vertexLayout = std::shared_ptr<VertexLayout>(new VertexLayout(attribs));
+}
+
+bool PolylineStyle::drawMesh(RenderState& rs, ShaderProgram& _program, StyledMesh& _mesh, bool _useVao) {
+
+    if (!m_outlineAttributes) { return Style::drawMesh(rs, _program, _mesh, _useVao); }
+
+    auto& outlinePass = (&_program == m_selectionProgram.get()) ? m_uSelectionOutlinePass : m_uOutlinePass;
+
+    // Without depth testing the outlines are drawn first, like the
+    // outline meshes that are compiled before the lines
+    bool painterMode = (m_blend == Blending::overlay || m_blend == Blending::inlay);
+
+    bool drawn = true;
+    for (int pass : { 0, 1 }) {
+        _program.setUniformi(rs, outlinePass, painterMode ? 1 - pass : pass);
+        drawn &= _mesh.draw(rs, _program, _useVao);
+    }
+    return drawn;
 }
 
 void PolylineStyle::onBeginDrawFrame(RenderState& rs, const View& _view) {
@@ -101,7 +217,16 @@ void PolylineStyle::onBeginDrawFrame(RenderState& rs, const View& _view) {
         m_texture->bind(rs, textureUnit);
 
         m_shaderProgram->setUniformi(rs, m_uTexture, textureUnit);
-        m_shaderProgram->setUniformf(rs, m_uTextureRatio, m_texture->height() / m_texture->width());
+
+        if (m_dashArray.size() > 0) {
+            // Column of the pattern and its part of the atlas height
+            m_shaderProgram->setUniformf(rs, m_uTextureRatio, float(m_dashPattern.length));
+            m_shaderProgram->setUniformf(rs, m_uDashRegion,
+                                         glm::vec2((m_dashPattern.column + 0.5f) / m_texture->width(),
+                                                   float(m_dashPattern.length) / m_texture->height()));
+        } else {
+            m_shaderProgram->setUniformf(rs, m_uTextureRatio, m_texture->height() / m_texture->width());
+        }
     }
 }
 
@@ -114,16 +239,10 @@ void PolylineStyle::constructShaderProgram() {
     m_shaderSource->setSourceStrings(polyline_fs, polyline_vs);
 
     if (m_dashArray.size() > 0) {
-        TextureOptions options;
-        options.minFilter = TextureMinFilter::NEAREST;
-        options.magFilter = TextureMagFilter::NEAREST;
+        if (!m_dashAtlas) { m_dashAtlas = std::make_shared<DashAtlas>(); }
         // provides precision for dash patterns that are a fraction of line width
-        auto pixels = DashArray::render(m_dashArray, dash_scale);
-
-        m_texture = std::make_shared<Texture>(options);
-        m_texture->setPixelData(1, pixels.size(), sizeof(GLuint),
-                                reinterpret_cast<GLubyte*>(pixels.data()),
-                                pixels.size() * sizeof(GLuint));
+        m_dashPattern = m_dashAtlas->add(m_dashArray, dash_scale);
+        m_texture = m_dashAtlas->texture();
 
         m_shaderSource->addSourceBlock("defines", "#define TANGRAM_LINE_BACKGROUND_COLOR vec4(" +
                                                   ff::to_string(m_dashBackgroundColor.r) + ", " +
@@ -147,6 +266,10 @@ void PolylineStyle::constructShaderProgram() {
     if (m_texCoordsGeneration) {
         m_shaderSource->addSourceBlock("defines", "#define TANGRAM_USE_TEX_COORDS\n");
     }
+
+    if (m_outlineAttributes) {
+        m_shaderSource->addSourceBlock("defines", "#define TANGRAM_LINE_OUTLINE\n", false);
+    }
 }
 
 template <class V>
@@ -187,13 +310,32 @@ public:
 
     std::unique_ptr<StyledMesh> build() override;
 
+    std::unique_ptr<StyledMesh> buildAppendable(const Feature& _feat, const DrawRule& _rule) override;
+
+    bool appendLine(StyledMesh& _mesh, const Feature& _feat, size_t _first, const DrawRule& _rule) override;
+
+    bool canMerge() const override { return true; }
+
+    void merge(StyleBuilder& _other) override {
+        auto& other = static_cast<PolylineStyleBuilder<V>&>(_other);
+        for (size_t i = 0; i < m_meshData.size(); i++) {
+            m_meshData[i].append(other.m_meshData[i]);
+            other.m_meshData[i].clear();
+        }
+    }
+
     PolylineStyleBuilder(const PolylineStyle& _style)
         : m_style(_style),
           m_meshData(2) {}
 
-    void addMesh(const Line& _line, const Parameters& _params);
+    size_t scratchCapacity() const override {
+        return m_meshData[0].capacityBytes() + m_meshData[1].capacityBytes() +
+            m_builder.indices.capacity() * sizeof(uint16_t);
+    }
+
+    void addMesh(const LineView& _line, const Parameters& _params);
 
-    void buildLine(const Line& _line, const typename Parameters::Attributes& _att,
+    void buildLine(const LineView& _line, const typename Parameters::Attributes& _att,
                    MeshData<V>& _mesh, GLuint _selection);
 
     Parameters parseRule(const DrawRule& _rule, const Properties& _props);
@@ -204,6 +346,9 @@ public:
 
 private:
 
+    // Move the built geometry to the end of the parts of _mesh
+    bool appendToMesh(PolylineMesh<V>& _mesh, size_t _sharedVertices);
+
     const PolylineStyle& m_style;
     PolyLineBuilder m_builder;
 
@@ -213,6 +358,20 @@ private:
     float m_tileUnitsPerPixel = 0;
     int m_zoom = 0;
     float m_overzoom2 = 1;
+
+    // Simplification tolerance in tile units, and the simplified line
+    float m_simplifyTolerance = 0;
+    Line m_simplified;
+
+    // Polygon outlines of tiles are clipped to the tile, unless tile edges are kept
+    bool m_clipToTile = false;
+    Line m_clipped;
+
+    // Distance along the line to the start of a continued line, and the
+    // vertices and indices at the end of the last line of each mesh data
+    float m_distance = 0;
+    size_t m_endVertices[2] = {};
+    size_t m_endIndices[2] = {};
 };
 
 template <class V>
@@ -225,6 +384,8 @@ void PolylineStyleBuilder<V>::setup(const Tile& tile) {
     m_overzoom2 = exp2(id.s - id.z);
     m_tileUnitsPerMeter = tile.getInverseScale();
     m_tileUnitsPerPixel = 1.f / MapProjection::tileSize();
+    m_simplifyTolerance = m_style.simplifyTolerance() * m_tileUnitsPerPixel / m_overzoom2;
+    m_clipToTile = true;
 
     // When a tile is overzoomed, we are actually styling the area of its
     // 'source' tile, which will have a larger effective pixel size at the
@@ -244,7 +405,8 @@ void PolylineStyleBuilder<V>::setup(const Marker& marker, int zoom) {
     // "tile size" for building a Marker is the size of a tile in pixels multiplied
     // by the ratio of the Marker's extent to the length of a tile side at this zoom.
     m_tileUnitsPerPixel = metersPerTile / (marker.extent() * 256.f);
-
+    m_simplifyTolerance = m_style.simplifyTolerance() * m_tileUnitsPerPixel;
+    m_clipToTile = false;
 }
 
 template <class V>
@@ -272,6 +434,96 @@ std::unique_ptr<StyledMesh> PolylineStyleBuilder<V>::build() {
     return std::move(mesh);
 }
 
+template <class V>
+std::unique_ptr<StyledMesh> PolylineStyleBuilder<V>::buildAppendable(const Feature& _feat, const DrawRule& _rule) {
+    if (_feat.geometryType != GeometryType::lines || _feat.lines().size() != 1) { return nullptr; }
+
+    // Appended points are not simplified together with the line, so neither is the line
+    float simplifyTolerance = m_simplifyTolerance;
+    m_simplifyTolerance = 0;
+    bool added = addFeature(_feat, _rule);
+    m_simplifyTolerance = simplifyTolerance;
+
+    if (!added || (m_meshData[0].vertices.empty() && m_meshData[1].vertices.empty())) {
+        m_meshData[0].clear();
+        m_meshData[1].clear();
+        return nullptr;
+    }
+
+    auto mesh = std::make_unique<PolylineMesh<V>>(m_style.vertexLayout(), m_style.drawMode(), 2);
+    if (!appendToMesh(*mesh, 0)) { return nullptr; }
+
+    auto line = _feat.lines()[0];
+    mesh->points = line.size();
+    for (size_t i = 0; i + 2 < line.size(); i++) {
+        mesh->distance += glm::distance(line[i], line[i + 1]);
+    }
+    return std::move(mesh);
+}
+
+template <class V>
+bool PolylineStyleBuilder<V>::appendLine(StyledMesh& _mesh, const Feature& _feat, size_t _first,
+                                         const DrawRule& _rule) {
+
+    auto* mesh = dynamic_cast<PolylineMesh<V>*>(&_mesh);
+    if (!mesh || _feat.geometryType != GeometryType::lines || _feat.lines().size() != 1) { return false; }
+
+    auto line = _feat.lines()[0];
+    if (_first < 2 || mesh->points != _first || line.size() <= _first) { return false; }
+
+    // The new points continue the line from the corners of the join at its
+    // second to last point, which replace the corners and cap of its end
+    LineView tail(line.data() + _first - 2, line.size() - _first + 2);
+    for (size_t i = 0; i + 1 < tail.size(); i++) {
+        // Repeated points have no join
+        if (tail[i] == tail[i + 1]) { return false; }
+    }
+
+    if (!checkRule(_rule)) { return false; }
+
+    Parameters params = parseRule(_rule, _feat.props);
+    if (params.fill.width[0] <= 0.0f && params.fill.width[1] <= 0.0f ) { return false; }
+    params.keepTileEdges = true;
+
+    float simplifyTolerance = m_simplifyTolerance;
+    m_simplifyTolerance = 0;
+    m_builder.continueLine = true;
+    m_distance = mesh->distance;
+
+    addMesh(tail, params);
+
+    m_builder.continueLine = false;
+    m_distance = 0;
+    m_simplifyTolerance = simplifyTolerance;
+
+    if (!appendToMesh(*mesh, 2)) { return false; }
+
+    mesh->points = line.size();
+    for (size_t i = 0; i + 2 < tail.size(); i++) {
+        mesh->distance += glm::distance(tail[i], tail[i + 1]);
+    }
+    return true;
+}
+
+template <class V>
+bool PolylineStyleBuilder<V>::appendToMesh(PolylineMesh<V>& _mesh, size_t _sharedVertices) {
+
+    // Draw the outline first when not using depth testing, like in build()
+    bool painterMode = (m_style.blendMode() == Blending::overlay ||
+                        m_style.blendMode() == Blending::inlay);
+
+    bool appended = true;
+    for (size_t i = 0; i < 2; i++) {
+        auto& data = m_meshData[i];
+        if (!data.vertices.empty()) {
+            appended &= _mesh.append(painterMode ? 1 - i : i, data, _sharedVertices,
+                                     m_endVertices[i], m_endIndices[i]);
+        }
+        data.clear();
+    }
+    return appended;
+}
+
 template <class V>
 auto PolylineStyleBuilder<V>::parseRule(const DrawRule& _rule, const Properties& _props) -> Parameters {
     Parameters p;
@@ -325,7 +577,10 @@ auto PolylineStyleBuilder<V>::parseRule(const DrawRule& _rule, const Properties&
     auto& strokeWidth = _rule.findParameter(StyleParamKey::outline_width);
     bool outlineVisible = true;
     _rule.get(StyleParamKey::outline_visible, outlineVisible);
-    if ( outlineVisible && (!p.lineOn || !_rule.findParameter(StyleParamKey::outline_style)) ) {
+    // Outlines in this style are built with the line
+    auto& outlineStyle = _rule.findParameter(StyleParamKey::outline_style);
+    bool outlineHere = !outlineStyle || outlineStyle.value.get<std::string>() == m_style.getName();
+    if ( outlineVisible && (!p.lineOn || outlineHere) ) {
         if (strokeWidth |
             _rule.get(StyleParamKey::outline_order, stroke.order) |
             _rule.get(StyleParamKey::outline_cap, cap) |
@@ -425,13 +680,13 @@ bool PolylineStyleBuilder<V>::addFeature(const Feature& _feat, const DrawRule& _
         // Line geometries are never clipped to tiles, so keep all segments
         params.keepTileEdges = true;
 
-        for (auto& line : _feat.lines) {
+        for (const auto& line : _feat.lines()) {
             addMesh(line, params);
         }
     } else {
         params.closedPolygon = true;
 
-        for (auto& polygon : _feat.polygons) {
+        for (const auto& polygon : _feat.polygons()) {
             for (const auto& line : polygon) {
                 addMesh(line, params);
             }
@@ -442,29 +697,47 @@ bool PolylineStyleBuilder<V>::addFeature(const Feature& _feat, const DrawRule& _
 }
 
 template <class V>
-void PolylineStyleBuilder<V>::buildLine(const Line& _line, const typename Parameters::Attributes& _att,
+void PolylineStyleBuilder<V>::buildLine(const LineView& _line, const typename Parameters::Attributes& _att,
                                         MeshData<V>& _mesh, GLuint selection) {
 
-    float zoom = m_overzoom2;
-    m_builder.addVertex = [&](const glm::vec2& coord, const glm::vec2& normal, const glm::vec2& uv) {
-        _mesh.vertices.push_back({{ coord.x,coord.y }, normal, { uv.x, uv.y * zoom },
-                                  _att.width, _att.height, _att.color, selection});
-    };
+    auto& vertices = _mesh.vertices;
+    float overzoom2 = m_overzoom2;
+    float distance = m_distance;
 
-    Builders::buildPolyLine(_line, m_builder);
+    Builders::buildPolyLine(_line, m_builder, [&](const glm::vec2& coord, const glm::vec2& normal, const glm::vec2& uv) {
+        vertices.push_back({{ coord.x, coord.y }, normal, { uv.x, (uv.y + distance) * overzoom2 },
+                            _att.width, _att.height, _att.color, selection});
+    });
 
     _mesh.indices.insert(_mesh.indices.end(),
                          m_builder.indices.begin(),
                          m_builder.indices.end());
 
+    // A continued line shares the corners of its first point with the line before it
     _mesh.offsets.emplace_back(m_builder.indices.size(),
-                               m_builder.numVertices);
+                               m_builder.numVertices - (m_builder.continueLine ? 2 : 0));
+
+    size_t part = &_mesh - m_meshData.data();
+    m_endVertices[part] = m_builder.endVertices;
+    m_endIndices[part] = m_builder.endIndices;
 
     m_builder.clear();
 }
 
 template <class V>
-void PolylineStyleBuilder<V>::addMesh(const Line& _line, const Parameters& _params) {
+void PolylineStyleBuilder<V>::addMesh(const LineView& _line, const Parameters& _params) {
+
+    LineView line = _line;
+    if (m_clipToTile && _params.closedPolygon && !_params.keepTileEdges && !Builders::isInsideTile(line)) {
+        m_clipped.clear();
+        if (!Builders::clipRing(line, m_clipped)) { return; }
+        line = m_clipped;
+    }
+    if (m_simplifyTolerance > 0) {
+        m_simplified.clear();
+        Builders::simplifyLine(line, m_simplifyTolerance, m_simplified);
+        line = m_simplified;
+    }
 
     m_builder.cap = _params.fill.cap;
     m_builder.join = _params.fill.join;
@@ -472,7 +745,7 @@ void PolylineStyleBuilder<V>::addMesh(const Line& _line, const Parameters& _para
     m_builder.keepTileEdges = _params.keepTileEdges;
     m_builder.closedPolygon = _params.closedPolygon;
 
-    if (_params.lineOn) { buildLine(_line, _params.fill, m_meshData[0], _params.selectionColor); }
+    if (_params.lineOn) { buildLine(line, _params.fill, m_meshData[0], _params.selectionColor); }
 
     if (!_params.outlineOn) { return; }
 
@@ -485,16 +758,25 @@ void PolylineStyleBuilder<V>::addMesh(const Line& _line, const Parameters& _para
         m_builder.join = _params.stroke.join;
         m_builder.miterLimit = _params.stroke.miterLimit;
 
-        buildLine(_line, _params.stroke, m_meshData[1], _params.selectionColor);
+        buildLine(line, _params.stroke, m_meshData[1], _params.selectionColor);
 
     } else {
         auto& fill = m_meshData[0];
         auto& stroke = m_meshData[1];
 
-        // reuse indices from original line, overriding color and width
         size_t nIndices = fill.offsets.back().first;
         size_t nVertices = fill.offsets.back().second;
+
+        // draw the outline from the vertices of the line when they carry it
+        glm::i16vec4 outline{ _params.stroke.width, _params.stroke.height[1], 0 };
+        if (setOutline(fill.vertices, fill.vertices.size() - nVertices, outline, _params.stroke.color)) {
+            return;
+        }
+
+        // reuse indices from original line, overriding color and width
         stroke.offsets.emplace_back(nIndices, nVertices);
+        m_endVertices[1] = m_endVertices[0];
+        m_endIndices[1] = m_endIndices[0];
 
         auto indicesIt = fill.indices.end() - nIndices;
         stroke.indices.insert(stroke.indices.end(),
@@ -514,10 +796,18 @@ void PolylineStyleBuilder<V>::addMesh(const Line& _line, const Parameters& _para
 }
 
 std::unique_ptr<StyleBuilder> PolylineStyle::createBuilder() const {
-    if (m_texCoordsGeneration) {
+    if (m_texCoordsGeneration && m_outlineAttributes) {
+        auto builder = std::make_unique<PolylineStyleBuilder<PolylineVertexWithOutline<PolylineVertex>>>(*this);
+        builder->polylineBuilder().useTexCoords = true;
+        return std::move(builder);
+    } else if (m_texCoordsGeneration) {
         auto builder = std::make_unique<PolylineStyleBuilder<PolylineVertex>>(*this);
         builder->polylineBuilder().useTexCoords = true;
         return std::move(builder);
+    } else if (m_outlineAttributes) {
+        auto builder = std::make_unique<PolylineStyleBuilder<PolylineVertexWithOutline<PolylineVertexNoUVs>>>(*this);
+        builder->polylineBuilder().useTexCoords = false;
+        return std::move(builder);
     } else {
         auto builder = std::make_unique<PolylineStyleBuilder<PolylineVertexNoUVs>>(*this);
         builder->polylineBuilder().useTexCoords = false;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "style/style.h"
+#include "util/dashArray.h"
 
 namespace Tangram {
 
@@ -12,25 +13,46 @@ public:
 
     PolylineStyle(std::string _name, Blending _blendMode = Blending::opaque, GLenum _drawMode = GL_TRIANGLES, bool _selection = true);
 
+    virtual void build(const Scene& _scene) override;
     virtual void constructVertexLayout() override;
     virtual void constructShaderProgram() override;
     virtual std::unique_ptr<StyleBuilder> createBuilder() const override;
     virtual void onBeginDrawFrame(RenderState& rs, const View& _view) override;
     virtual ~PolylineStyle() {}
 
-    void setDashArray(std::vector<float> _dashArray) { m_dashArray = _dashArray; }
+    /* Dash patterns are drawn from _atlas, shared with the other line styles
+     * of the scene, or from an atlas of this style */
+    void setDashArray(std::vector<float> _dashArray, std::shared_ptr<DashAtlas> _atlas = nullptr) {
+        m_dashArray = _dashArray;
+        m_dashAtlas = _atlas;
+    }
     void setTexture(std::shared_ptr<Texture>& _texture) { m_texture = _texture; }
 
     void setDashBackgroundColor(const glm::vec4 _dashBackgroundColor);
 
+    /* Whether the vertices carry the outline of the line, which is then drawn
+     * from the same mesh in a second pass */
+    bool outlineAttributes() const { return m_outlineAttributes; }
+
+protected:
+
+    virtual bool drawMesh(RenderState& rs, ShaderProgram& _program, StyledMesh& _mesh, bool _useVao) override;
+
 private:
 
     std::vector<float> m_dashArray;
+    std::shared_ptr<DashAtlas> m_dashAtlas;
+    DashAtlas::Pattern m_dashPattern;
     std::shared_ptr<Texture> m_texture;
     glm::vec4 m_dashBackgroundColor = {};
 
     UniformLocation m_uTexture{"u_texture"};
     UniformLocation m_uTextureRatio{"u_texture_ratio"};
+    UniformLocation m_uDashRegion{"u_dash_region"};
+
+    bool m_outlineAttributes = false;
+    UniformLocation m_uOutlinePass{"u_outline_pass"};
+    UniformLocation m_uSelectionOutlinePass{"u_outline_pass"};
 };
 
 }
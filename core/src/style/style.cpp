@@ -1,21 +1,28 @@
 #include "style/style.h"
 
 #include "data/tileSource.h"
+#include "gl/hardware.h"
 #include "gl/renderState.h"
 #include "gl/shaderProgram.h"
+#include "gl/shaderProgramCache.h"
+#include "gl/shaderSource.h"
+#include "gl/uniformBuffer.h"
 #include "gl/mesh.h"
 #include "log.h"
 #include "map.h"
 #include "marker/marker.h"
 #include "scene/light.h"
+#include "scene/lightCulling.h"
 #include "scene/scene.h"
 #include "scene/spriteAtlas.h"
 #include "scene/styleParam.h"
+#include "selection/featureState.h"
 #include "style/material.h"
 #include "tile/tile.h"
 #include "view/view.h"
 
 #include "rasters_glsl.h"
+#include "uniformBlocks_glsl.h"
 
 namespace Tangram {
 
@@ -41,22 +48,20 @@ void Style::build(const Scene& _scene) {
     constructVertexLayout();
     constructShaderProgram();
 
-    const char* blendingDefine = "";
-    switch (m_blend) {
-    case Blending::opaque: blendingDefine = "#define TANGRAM_BLEND_OPAQUE\n"; break;
-    case Blending::add: blendingDefine = "#define TANGRAM_BLEND_ADD\n"; break;
-    case Blending::multiply: blendingDefine = "#define TANGRAM_BLEND_MULTIPLY\n"; break;
-    case Blending::inlay: blendingDefine = "#define TANGRAM_BLEND_INLAY\n"; break;
-    case Blending::translucent: blendingDefine = "#define TANGRAM_BLEND_TRANSLUCENT\n"; break;
-    case Blending::overlay: blendingDefine = "#define TANGRAM_BLEND_OVERLAY\n"; break;
+    // Scenes opt into uniform blocks, which change the GLSL version of their shader blocks
+    if (m_uniformBlocks && _scene.viewUniforms() && Hardware::supportsUniformBuffers) {
+        m_shaderSource->setUniformBlocks(true);
+        m_shaderSource->addSourceBlock("uniform_blocks", uniformBlocks_glsl, false);
+        m_viewUniforms = _scene.viewUniforms();
+        m_lightUniforms = _scene.lightUniforms();
     }
 
-    m_shaderSource->addSourceBlock("defines", blendingDefine, false);
-
     if (m_material.material) {
         m_material.uniforms = m_material.material->injectOnProgram(*m_shaderSource);
     }
 
+    m_lightCulling = nullptr;
+
     if (m_lightingType != LightingType::none) {
 
         switch (m_lightingType) {
@@ -65,6 +70,7 @@ void Style::build(const Scene& _scene) {
             break;
         case LightingType::fragment:
             m_shaderSource->addSourceBlock("defines", "#define TANGRAM_LIGHTING_FRAGMENT\n", false);
+            m_lightCulling = _scene.lightCulling();
             break;
         default:
             break;
@@ -102,62 +108,108 @@ void Style::build(const Scene& _scene) {
         }
     }
 
-    const auto& blocks = m_shaderSource->getSourceBlocks();
-    if (blocks.find("color") != blocks.end() ||
-        blocks.find("filter") != blocks.end() ||
-        blocks.find("raster") != blocks.end()) {
-        m_hasColorShaderBlock = true;
+    // Styles that differ only in blend mode can share their program
+    // unless the shaders test the blend mode
+    if (m_shaderSource->contains("TANGRAM_BLEND_")) {
+        const char* blendingDefine = "";
+        switch (m_blend) {
+        case Blending::opaque: blendingDefine = "#define TANGRAM_BLEND_OPAQUE\n"; break;
+        case Blending::add: blendingDefine = "#define TANGRAM_BLEND_ADD\n"; break;
+        case Blending::multiply: blendingDefine = "#define TANGRAM_BLEND_MULTIPLY\n"; break;
+        case Blending::inlay: blendingDefine = "#define TANGRAM_BLEND_INLAY\n"; break;
+        case Blending::translucent: blendingDefine = "#define TANGRAM_BLEND_TRANSLUCENT\n"; break;
+        case Blending::overlay: blendingDefine = "#define TANGRAM_BLEND_OVERLAY\n"; break;
+        }
+
+        m_shaderSource->addSourceBlock("defines", blendingDefine, false);
     }
 
-    std::string vertSrc = m_shaderSource->buildVertexSource();
-    std::string fragSrc = m_shaderSource->buildFragmentSource();
+    const auto& blocks = m_shaderSource->getSourceBlocks();
 
-    for (auto& s : _scene.styles()) {
-        auto& prg = s->m_shaderProgram;
-        if (!prg) { break; }
-        if (prg->vertexShaderSource() == vertSrc &&
-            prg->fragmentShaderSource() == fragSrc) {
-            m_shaderProgram = prg;
-            break;
+    // Feature states are looked up by the selection colors of polygons and lines
+    bool readsFeatureState = false;
+    if (m_type == StyleType::polygon || m_type == StyleType::polyline) {
+        for (auto& block : blocks) {
+            for (auto& source : block.second) {
+                if (source.find("featureState(") != std::string::npos) {
+                    readsFeatureState = true;
+                }
+            }
         }
     }
-    if (!m_shaderProgram) {
-        m_shaderProgram = std::make_shared<ShaderProgram>();
-        m_shaderProgram->setDescription("{style:" + m_name + "}");
-        m_shaderProgram->setShaderSource(vertSrc, fragSrc);
+    if (readsFeatureState) {
+        m_shaderSource->addSourceBlock("defines", "#define TANGRAM_FEATURE_STATE\n", false);
+
+        // Without vertex texture units featureState() is zero
+        if (Hardware::maxVertexTextureUnits > 0) {
+            m_featureState = _scene.featureState().get();
+            m_shaderSource->addSourceBlock("defines", "#define TANGRAM_FEATURE_STATE_TEXTURE\n"
+                                           "#define TANGRAM_FEATURE_STATE_SIZE "
+                                           + std::to_string(FeatureState::size) + ".0\n", false);
+        }
     }
 
-    if (m_selection) {
-        std::string vertSrc = m_shaderSource->buildSelectionVertexSource();
-        std::string fragSrc = m_shaderSource->buildSelectionFragmentSource();
-
-        for (auto& s : _scene.styles()) {
-            if (!s->m_selection) { continue; }
-
-            auto& prg = s->m_selectionProgram;
-            if (!prg) { break; }
-            if (prg->vertexShaderSource() == vertSrc &&
-                prg->fragmentShaderSource() == fragSrc) {
-                m_selectionProgram = prg;
-                break;
+    if (m_tileBatching && !hasRasters() &&
+        Hardware::maxVertexUniformVectors >= TILE_BATCH_MIN_UNIFORM_VECTORS) {
+
+        // Shader blocks may read the tile uniforms in the fragment shader,
+        // where they are not replaced by the batch arrays
+        bool blocksUseTileUniforms = false;
+        for (auto& block : blocks) {
+            for (auto& source : block.second) {
+                if (source.find("u_model") != std::string::npos ||
+                    source.find("u_tile_origin") != std::string::npos ||
+                    source.find("u_proxy_depth") != std::string::npos) {
+                    blocksUseTileUniforms = true;
+                }
             }
         }
-        if (!m_selectionProgram) {
-            m_selectionProgram = std::make_shared<ShaderProgram>();
-            m_selectionProgram->setDescription("selection_program {style:" + m_name + "}");
-            m_selectionProgram->setShaderSource(vertSrc, fragSrc);
+
+        if (!blocksUseTileUniforms) {
+            m_tileBatchSize = TILE_BATCH_SIZE;
+            m_shaderSource->addSourceBlock("defines", "#define TANGRAM_TILE_BATCH "
+                                           + std::to_string(TILE_BATCH_SIZE) + "\n", false);
         }
     }
 
+    if (blocks.find("color") != blocks.end() ||
+        blocks.find("filter") != blocks.end() ||
+        blocks.find("raster") != blocks.end()) {
+        m_hasColorShaderBlock = true;
+    }
+
+    auto& programs = _scene.programCache();
+
+    m_shaderProgram = programs.get(m_shaderSource->buildVertexSource(),
+                                   m_shaderSource->buildFragmentSource(),
+                                   "{style:" + m_name + "}");
+
+    if (m_selection) {
+        m_selectionProgram = programs.get(m_shaderSource->buildSelectionVertexSource(),
+                                          m_shaderSource->buildSelectionFragmentSource(),
+                                          "selection_program {style:" + m_name + "}");
+    }
+
     // Clear ShaderSource builder
     m_shaderSource.reset();
 }
 
+void Style::compileShaders(RenderState& rs) {
+    m_shaderProgram->compile(rs);
+    if (m_selection) {
+        m_selectionProgram->compile(rs);
+    }
+}
+
+bool Style::shadersReady(RenderState& rs) {
+    return m_shaderProgram->isReady(rs);
+}
+
 void Style::setLightingType(LightingType _type) {
     m_lightingType = _type;
 }
 
-void Style::setupSceneShaderUniforms(RenderState& rs, UniformBlock& _uniformBlock) {
+void Style::setupSceneShaderUniforms(RenderState& rs, ShaderProgram& _program, UniformBlock& _uniformBlock) {
     for (auto& uniformPair : _uniformBlock.styleUniforms) {
         const auto& name = uniformPair.first;
         auto& value = uniformPair.second;
@@ -168,19 +220,19 @@ void Style::setupSceneShaderUniforms(RenderState& rs, UniformBlock& _uniformBloc
 
             texture->bind(rs, rs.nextAvailableTextureUnit());
 
-            m_shaderProgram->setUniformi(rs, name, rs.currentTextureUnit());
+            _program.setUniformi(rs, name, rs.currentTextureUnit());
         } else if (value.is<bool>()) {
-            m_shaderProgram->setUniformi(rs, name, value.get<bool>());
+            _program.setUniformi(rs, name, value.get<bool>());
         } else if(value.is<float>()) {
-            m_shaderProgram->setUniformf(rs, name, value.get<float>());
+            _program.setUniformf(rs, name, value.get<float>());
         } else if(value.is<glm::vec2>()) {
-            m_shaderProgram->setUniformf(rs, name, value.get<glm::vec2>());
+            _program.setUniformf(rs, name, value.get<glm::vec2>());
         } else if(value.is<glm::vec3>()) {
-            m_shaderProgram->setUniformf(rs, name, value.get<glm::vec3>());
+            _program.setUniformf(rs, name, value.get<glm::vec3>());
         } else if(value.is<glm::vec4>()) {
-            m_shaderProgram->setUniformf(rs, name, value.get<glm::vec4>());
+            _program.setUniformf(rs, name, value.get<glm::vec4>());
         } else if (value.is<UniformArray1f>()) {
-            m_shaderProgram->setUniformf(rs, name, value.get<UniformArray1f>());
+            _program.setUniformf(rs, name, value.get<UniformArray1f>());
         } else if (value.is<UniformTextureArray>()) {
             UniformTextureArray& textureUniformArray = value.get<UniformTextureArray>();
             textureUniformArray.slots.clear();
@@ -193,7 +245,7 @@ void Style::setupSceneShaderUniforms(RenderState& rs, UniformBlock& _uniformBloc
                 textureUniformArray.slots.push_back(rs.currentTextureUnit());
             }
 
-            m_shaderProgram->setUniformi(rs, name, textureUniformArray);
+            _program.setUniformi(rs, name, textureUniformArray);
         }
     }
 }
@@ -204,6 +256,31 @@ void Style::setupShaderUniforms(RenderState& rs, ShaderProgram& _program, const
     // Reset the currently used texture unit to 0
     rs.resetTextureUnit();
 
+    if (m_featureState) {
+        m_featureState->bind(rs, rs.nextAvailableTextureUnit());
+        _program.setUniformi(rs, _uniforms.uFeatureState, rs.currentTextureUnit());
+    }
+
+    if (m_lightCulling && m_lightCulling->bind(rs, rs.nextAvailableTextureUnit())) {
+        _program.setUniformi(rs, _uniforms.uLightTiles, rs.currentTextureUnit());
+        _program.setUniformf(rs, _uniforms.uLightTilesSize, m_lightCulling->gridSize());
+    }
+
+    if (m_viewUniforms) {
+        if (m_material.uniforms) {
+            m_material.material->setupProgram(rs, *m_shaderProgram, *m_material.uniforms);
+        }
+
+        // View and light uniforms are set once per frame by the Scene
+        m_viewUniforms->update(rs, _program);
+        if (!m_lights.empty()) {
+            m_lightUniforms->update(rs, _program);
+        }
+
+        setupSceneShaderUniforms(rs, _program, _uniforms);
+        return;
+    }
+
     // Set time uniforms style's shader programs
     _program.setUniformf(rs, _uniforms.uTime, rs.frameTime());
 
@@ -229,7 +306,7 @@ void Style::setupShaderUniforms(RenderState& rs, ShaderProgram& _program, const
     _program.setUniformMatrix4f(rs, _uniforms.uView, _view.getViewMatrix());
     _program.setUniformMatrix4f(rs, _uniforms.uProj, _view.getProjectionMatrix());
 
-    setupSceneShaderUniforms(rs, _uniforms);
+    setupSceneShaderUniforms(rs, _program, _uniforms);
 
 }
 
@@ -287,6 +364,13 @@ void Style::drawSelectionFrame(RenderState& rs, const View& _view,
 
     onBeginDrawSelectionFrame(rs, _view);
 
+    if (!m_selection) { return; }
+
+    if (m_tileBatchSize > 0) {
+        drawTileBatches(rs, *m_selectionProgram, m_selectionUniforms, _tiles, _markers, false);
+        return;
+    }
+
     for (const auto& tile : _tiles) { drawSelectionFrame(rs, *tile); }
     for (const auto& marker : _markers) { drawSelectionFrame(rs, *marker); }
 }
@@ -337,7 +421,7 @@ void Style::drawSelectionFrame(RenderState& _rs, const Marker& _marker) {
                                     _marker.origin().x, _marker.origin().y,
                                     _marker.builtZoomLevel(), _marker.builtZoomLevel());
 
-    if (!mesh->draw(_rs, *m_selectionProgram, false)) {
+    if (!drawMesh(_rs, *m_selectionProgram, *mesh, false)) {
         LOGN("Mesh built by style %s cannot be drawn", m_name.c_str());
     }
 }
@@ -350,7 +434,7 @@ void Style::drawSelectionFrame(Tangram::RenderState& rs, const Tangram::Tile &_t
 
     auto& styleMesh = _tile.getMesh(*this);
 
-    if (!styleMesh) { return; }
+    if (!styleMesh || !_tile.isMeshVisible(*this)) { return; }
 
     TileID tileID = _tile.getID();
 
@@ -362,44 +446,105 @@ void Style::drawSelectionFrame(Tangram::RenderState& rs, const Tangram::Tile &_t
                                     tileID.s,
                                     tileID.z);
 
-    if (!styleMesh->draw(rs, *m_selectionProgram, false)) {
+    if (!drawMesh(rs, *m_selectionProgram, *styleMesh, false)) {
         LOGN("Mesh built by style %s cannot be drawn", m_name.c_str());
     }
 
 }
 
+std::vector<Style*> Style::drawOrder(const std::vector<std::unique_ptr<Style>>& _styles) {
+
+    std::vector<Style*> order;
+    order.reserve(_styles.size());
+    std::vector<bool> added(_styles.size(), false);
+
+    for (size_t i = 0; i < _styles.size(); i++) {
+        if (added[i]) { continue; }
+        order.push_back(_styles[i].get());
+        added[i] = true;
+
+        // Opaque styles are depth tested, their order only matters for fragments of
+        // equal depth, which are already drawn in the arbitrary order of style names
+        auto& program = _styles[i]->m_shaderProgram;
+        if (_styles[i]->blendMode() != Blending::opaque || !program) { continue; }
+
+        for (size_t j = i + 1; j < _styles.size(); j++) {
+            if (!added[j] && _styles[j]->blendMode() == Blending::opaque &&
+                _styles[j]->m_shaderProgram == program) {
+                order.push_back(_styles[j].get());
+                added[j] = true;
+            }
+        }
+    }
+    return order;
+}
+
 bool Style::draw(RenderState& rs, const View& _view,
                  const std::vector<std::shared_ptr<Tile>>& _tiles,
                  const std::vector<std::unique_ptr<Marker>>& _markers) {
-    LOGD("skyway draw Feature _title size = %d _markers size = %d",_tiles.size(), _markers.size());
+    LOGC(render, "skyway draw Feature _title size = %d _markers size = %d", int(_tiles.size()), int(_markers.size()));
     auto tileIt = std::find_if(std::begin(_tiles), std::end(_tiles),
-                               [this](const auto& t){ return bool(t->getMesh(*this)); });
+                               [this](const auto& t){ return t->getMesh(*this) && t->isMeshVisible(*this); });
 
     auto markerIt = std::find_if(std::begin(_markers), std::end(_markers),
                                [this](const auto& m){ return m->styleId() == this->m_id && m->mesh(); });
 
     bool meshDrawn = false;
+    m_shadersPending = false;
 
     // Skip when no mesh is to be rendered.
-    // This also compiles shaders when they are first used.
     if (tileIt == std::end(_tiles) && markerIt == std::end(_markers)) {
         return false;
     }
 
+    // Skip until the driver finished compiling the shaders instead of stalling the frame
+    if (!shadersReady(rs)) {
+        m_shadersPending = true;
+        return false;
+    }
+
     onBeginDrawFrame(rs, _view);
 
-    if (m_blend == Blending::translucent) {
-        rs.colorMask(false, false, false, false);
+    const auto* tiles = &_tiles;
+    if (drawsFrontToBack()) {
+        m_sortedTiles = _tiles;
+        sortFrontToBack(_view, m_sortedTiles);
+        tiles = &m_sortedTiles;
     }
 
-    for (const auto& tile : _tiles) {
-        meshDrawn |= draw(rs, *tile);
+    bool depthPrepass = m_blend == Blending::translucent ||
+        (drawsFrontToBack() && m_renderMode == RenderMode::depth_prepass);
+
+    if (depthPrepass) {
+        rs.colorMask(false, false, false, false);
     }
-    for (const auto& marker : _markers) {
-        meshDrawn |= draw(rs, *marker);
+
+    if (m_tileBatchSize > 0) {
+        meshDrawn = drawTileBatches(rs, *m_shaderProgram, m_mainUniforms, *tiles, _markers, true);
+    } else {
+        for (const auto& tile : *tiles) {
+            meshDrawn |= draw(rs, *tile);
+        }
+        for (const auto& marker : _markers) {
+            meshDrawn |= draw(rs, *marker);
+        }
     }
 
     if (meshDrawn) {
+        if (m_blend == Blending::opaque && depthPrepass) {
+            // Only the nearest fragments pass the depth test and are shaded
+            rs.colorMask(true, true, true, true);
+            GL::depthFunc(GL_EQUAL);
+
+            if (m_tileBatchSize > 0) {
+                drawTileBatches(rs, *m_shaderProgram, m_mainUniforms, *tiles, _markers, true);
+            } else {
+                for (const auto &tile : *tiles) { draw(rs, *tile); }
+                for (const auto &marker : _markers) { draw(rs, *marker); }
+            }
+
+            GL::depthFunc(GL_LESS);
+        }
         if (m_blend == Blending::translucent) {
             rs.colorMask(true, true, true, true);
             GL::depthFunc(GL_EQUAL);
@@ -409,25 +554,116 @@ bool Style::draw(RenderState& rs, const View& _view,
             GL::stencilFunc(GL_EQUAL, GL_ZERO, 0xFF);
             GL::stencilOp(GL_KEEP, GL_KEEP, GL_INCR);
 
-            for (const auto &tile : _tiles) { draw(rs, *tile); }
-            for (const auto &marker : _markers) { draw(rs, *marker); }
+            if (m_tileBatchSize > 0) {
+                drawTileBatches(rs, *m_shaderProgram, m_mainUniforms, _tiles, _markers, true);
+            } else {
+                for (const auto &tile : _tiles) { draw(rs, *tile); }
+                for (const auto &marker : _markers) { draw(rs, *marker); }
+            }
 
             GL::disable(GL_STENCIL_TEST);
             GL::depthFunc(GL_LESS);
         }
+    } else if (depthPrepass) {
+        rs.colorMask(true, true, true, true);
     }
 
+    // Do not keep the tiles alive until the next frame
+    m_sortedTiles.clear();
+
     onEndDrawFrame(rs, _view);
 
     return meshDrawn;
 }
 
 
+void Style::sortFrontToBack(const View& _view, std::vector<std::shared_ptr<Tile>>& _tiles) {
+
+    // Tile positions of the model matrices are relative to the view center, like the eye
+    glm::vec2 eye = glm::vec2(_view.getEye());
+
+    auto distance2 = [&](const Tile& _tile) {
+        const glm::mat4& model = _tile.getModelMatrix();
+        float half = model[0][0] * 0.5f;
+        glm::vec2 center = glm::vec2(model[3][0] + half, model[3][1] + half);
+        glm::vec2 d = center - eye;
+        return glm::dot(d, d);
+    };
+
+    std::stable_sort(_tiles.begin(), _tiles.end(), [&](const auto& a, const auto& b) {
+        if (a->isProxy() != b->isProxy()) { return b->isProxy(); }
+        return distance2(*a) < distance2(*b);
+    });
+}
+
+bool Style::drawTileBatches(RenderState& rs, ShaderProgram& _program, UniformBlock& _uniforms,
+                            const std::vector<std::shared_ptr<Tile>>& _tiles,
+                            const std::vector<std::unique_ptr<Marker>>& _markers,
+                            bool _useVao) {
+
+    bool meshDrawn = false;
+
+    std::vector<StyledMesh*> meshes;
+    UniformArray4f transforms;
+    UniformArray4f origins;
+
+    auto drawBatch = [&]() {
+        if (meshes.empty()) { return; }
+
+        _program.setUniformf(rs, _uniforms.uTileTransforms, transforms);
+        _program.setUniformf(rs, _uniforms.uTileOrigins, origins);
+
+        for (size_t i = 0; i < meshes.size(); i++) {
+            _program.setUniformi(rs, _uniforms.uTileIndex, int(i));
+
+            if (drawMesh(rs, _program, *meshes[i], _useVao)) {
+                meshDrawn = true;
+            } else {
+                LOGN("Mesh built by style %s cannot be drawn", m_name.c_str());
+            }
+        }
+        meshes.clear();
+        transforms.clear();
+        origins.clear();
+    };
+
+    // The model matrices of tiles and markers only scale and translate
+    auto addMesh = [&](StyledMesh* _mesh, const glm::mat4& _model, float _proxyDepth,
+                       const glm::vec4& _origin) {
+        meshes.push_back(_mesh);
+        transforms.emplace_back(_model[3][0], _model[3][1], _model[0][0], _proxyDepth);
+        origins.push_back(_origin);
+
+        if (meshes.size() == m_tileBatchSize) { drawBatch(); }
+    };
+
+    for (const auto& tile : _tiles) {
+        auto& styleMesh = tile->getMesh(*this);
+        if (!styleMesh || !tile->isMeshVisible(*this)) { continue; }
+
+        TileID tileID = tile->getID();
+        addMesh(styleMesh.get(), tile->getModelMatrix(), tile->isProxy() ? 1.f : 0.f,
+                glm::vec4(tile->getOrigin().x, tile->getOrigin().y, tileID.s, tileID.z));
+    }
+
+    for (const auto& marker : _markers) {
+        if (marker->styleId() != m_id || !marker->isVisible() || !marker->mesh()) { continue; }
+
+        float zoom = marker->builtZoomLevel();
+        addMesh(marker->mesh(), marker->modelMatrix(), 0.f,
+                glm::vec4(marker->origin().x, marker->origin().y, zoom, zoom));
+    }
+
+    drawBatch();
+
+    return meshDrawn;
+}
+
 bool Style::draw(RenderState& rs, const Tile& _tile) {
     
     auto& styleMesh = _tile.getMesh(*this);
 
-    if (!styleMesh) { return false; }
+    if (!styleMesh || !_tile.isMeshVisible(*this)) { return false; }
 
     bool styleMeshDrawn = true;
     TileID tileID = _tile.getID();
@@ -457,7 +693,9 @@ bool Style::draw(RenderState& rs, const Tile& _tile) {
                 y = (dz2 - 1.f - fmodf(tileID.y, dz2)) / dz2;
                 z = 1.f / dz2;
             }
-            rasterOffsetsUniform.emplace_back(x, y, z);
+            auto region = texture->region();
+            rasterOffsetsUniform.emplace_back(region.x + x * region.z, region.y + y * region.z,
+                                              z * region.z);
         }
 
         m_shaderProgram->setUniformi(rs, m_mainUniforms.uRasters, textureIndexUniform);
@@ -473,7 +711,7 @@ bool Style::draw(RenderState& rs, const Tile& _tile) {
                                  tileID.s,
                                  tileID.z);
     
-    if (!styleMesh->draw(rs, *m_shaderProgram)) {
+    if (!drawMesh(rs, *m_shaderProgram, *styleMesh, true)) {
         LOGN("Mesh built by style %s cannot be drawn", m_name.c_str());
         styleMeshDrawn = false;
     }
@@ -503,7 +741,7 @@ bool Style::draw(RenderState& rs, const Marker& marker) {
                                  marker.origin().x, marker.origin().y,
                                  marker.builtZoomLevel(), marker.builtZoomLevel());
 
-    if (!mesh->draw(rs, *m_shaderProgram)) {
+    if (!drawMesh(rs, *m_shaderProgram, *mesh, true)) {
         LOGN("Mesh built by style %s cannot be drawn", m_name.c_str());
         styleMeshDrawn = false;
     }
@@ -511,6 +749,22 @@ bool Style::draw(RenderState& rs, const Marker& marker) {
     return styleMeshDrawn;
 }
 
+bool Style::setStyleUniform(const std::string& _name, const UniformValue& _value) {
+    for (auto& uniform : m_mainUniforms.styleUniforms) {
+        if (uniform.first.getName() != _name) { continue; }
+
+        auto& value = uniform.second;
+        if (value.which() != _value.which()) { return false; }
+        if (value.is<UniformArray1f>() &&
+            value.get<UniformArray1f>().size() != _value.get<UniformArray1f>().size()) {
+            return false;
+        }
+        value = _value;
+        return true;
+    }
+    return false;
+}
+
 void Style::setDefaultDrawRule(std::unique_ptr<DrawRuleData>&& _rule) {
     m_defaultDrawRule = std::move(_rule);
 }
@@ -520,11 +774,10 @@ void Style::applyDefaultDrawRules(DrawRule& _rule) const {
         for (auto& param : m_defaultDrawRule->parameters) {
             auto key = static_cast<uint8_t>(param.key);
             if (!_rule.active[key]) {
-                _rule.active[key] = true;
                 // NOTE: layername and layer depth are actually immaterial here, since these are
                 // only used during layer draw rules merging. Adding a default string for
                 // debugging purposes.
-                _rule.params[key] = { &param, "default_style_draw_rule", 0 };
+                _rule.setParam(key, { &param, "default_style_draw_rule", 0 });
             }
         }
     }
@@ -568,17 +821,17 @@ bool StyleBuilder::addFeature(const Feature& _feat, const DrawRule& _rule) {
     bool added = false;
     switch (_feat.geometryType) {
         case GeometryType::points:
-            for (auto& point : _feat.points) {
+            for (auto& point : _feat.points()) {
                 added |= addPoint(point, _feat.props, _rule);
             }
             break;
         case GeometryType::lines:
-            for (auto& line : _feat.lines) {
+            for (const auto& line : _feat.lines()) {
                 added |= addLine(line, _feat.props, _rule);
             }
             break;
         case GeometryType::polygons:
-            for (auto& polygon : _feat.polygons) {
+            for (const auto& polygon : _feat.polygons()) {
                 added |= addPolygon(polygon, _feat.props, _rule);
             }
             break;
@@ -594,12 +847,12 @@ bool StyleBuilder::addPoint(const Point& _point, const Properties& _props, const
     return false;
 }
 
-bool StyleBuilder::addLine(const Line& _line, const Properties& _props, const DrawRule& _rule) {
+bool StyleBuilder::addLine(const LineView& _line, const Properties& _props, const DrawRule& _rule) {
     // No-op by default
     return false;
 }
 
-bool StyleBuilder::addPolygon(const Polygon& _polygon, const Properties& _props, const DrawRule& _rule) {
+bool StyleBuilder::addPolygon(const PolygonView& _polygon, const Properties& _props, const DrawRule& _rule) {
     // No-op by default
     return false;
 }
@@ -5,6 +5,7 @@
 #include "gl/uniform.h"
 #include "scene/drawRule.h"
 #include "util/fastmap.h"
+#include "util/geom.h"
 
 #include <memory>
 #include <string>
@@ -12,9 +13,11 @@
 
 namespace Tangram {
 
+class FeatureState;
 class Label;
 class LabelCollider;
 class Light;
+class LightCulling;
 class MapProjection;
 class Marker;
 class Material;
@@ -25,6 +28,7 @@ class ShaderSource;
 class Style;
 class Tile;
 class TileSource;
+class UniformBuffer;
 class VertexLayout;
 class View;
 struct DrawRule;
@@ -56,6 +60,13 @@ enum class Blending : uint8_t {
     overlay,
 };
 
+/* Order in which the meshes of an opaque style are drawn */
+enum class RenderMode : uint8_t {
+    standard,       // Tiles in the order of the TileManager
+    front_to_back,  // Nearest tiles first and the tallest geometry of a tile first
+    depth_prepass,  // front_to_back, after a pass that only writes depth
+};
+
 enum class RasterType : uint8_t {
     none,
     color,
@@ -67,6 +78,21 @@ struct StyledMesh {
     virtual bool draw(RenderState& rs, ShaderProgram& _shader, bool _useVao = true) = 0;
     virtual size_t bufferSize() const = 0;
 
+    /* Bytes of bufferSize() held in memory, the rest is in GL buffers */
+    virtual size_t cpuBufferSize() const { return bufferSize(); }
+
+    /* Append the compiled geometry to _out for the TileDiskCache. Returns false
+     * when the mesh cannot be stored, e.g. when it contains labels. */
+    virtual bool serialize(std::vector<uint8_t>& _out) const { return false; }
+
+    /* Upload the geometry to GL buffers if it was not drawn yet, so that the
+     * first draw does not need to upload it */
+    virtual void uploadGeometry(RenderState& rs) {}
+
+    /* Release the vertex arrays of the programs that drew the mesh, before it
+     * is drawn by the styles of another scene */
+    virtual void releaseVaos() {}
+
     virtual ~StyledMesh() {}
 };
 
@@ -85,20 +111,45 @@ public:
     virtual bool addPoint(const Point& _point, const Properties& _props, const DrawRule& _rule);
 
     /* Build styled vertex data for line geometry */
-    virtual bool addLine(const Line& _line, const Properties& _props, const DrawRule& _rule);
+    virtual bool addLine(const LineView& _line, const Properties& _props, const DrawRule& _rule);
 
     /* Build styled vertex data for polygon geometry */
-    virtual bool addPolygon(const Polygon& _polygon, const Properties& _props, const DrawRule& _rule);
+    virtual bool addPolygon(const PolygonView& _polygon, const Properties& _props, const DrawRule& _rule);
 
     /* Create a new mesh object using the vertex layout corresponding to this style */
     virtual std::unique_ptr<StyledMesh> build() = 0;
 
+    /* Build a mesh for the line of _feat that appendLine() can extend, or return
+     * null when this style does not support it */
+    virtual std::unique_ptr<StyledMesh> buildAppendable(const Feature& _feat, const DrawRule& _rule) {
+        return nullptr;
+    }
+
+    /* Extend _mesh, built by buildAppendable() for the line of _feat, by the points
+     * of the line from _first. Returns false when the mesh must be built again. */
+    virtual bool appendLine(StyledMesh& _mesh, const Feature& _feat, size_t _first, const DrawRule& _rule) {
+        return false;
+    }
+
     virtual bool checkRule(const DrawRule& _rule) const;
 
     virtual void addLayoutItems(LabelCollider& _layout) {}
 
     virtual void addSelectionItems(LabelCollider& _layout) {}
 
+    /* Extent in tile units of the mesh returned by the last build(). Meshes
+     * that are not bounded are drawn without frustum culling. */
+    virtual MeshBounds meshBounds() const { return {}; }
+
+    /* Bytes held by reusable buffers of this builder, kept between tiles */
+    virtual size_t scratchCapacity() const { return 0; }
+
+    /* Whether geometry built by another builder of this style can be appended by merge() */
+    virtual bool canMerge() const { return false; }
+
+    /* Append the geometry built by _other, a builder for the same style, and clear _other */
+    virtual void merge(StyleBuilder& _other) {}
+
     virtual const Style& style() const = 0;
 };
 
@@ -116,6 +167,15 @@ class Style {
 
 using StyleUniform = std::pair<UniformLocation, UniformValue >;
 
+public:
+
+    /* Number of tile transforms in the uniform arrays of batched styles */
+    static constexpr size_t TILE_BATCH_SIZE = 16;
+
+    /* Vertex uniform vectors required for batched styles, so that the tile
+     * transforms leave enough room for lights, materials and shader blocks */
+    static constexpr uint32_t TILE_BATCH_MIN_UNIFORM_VECTORS = 256;
+
 protected:
 
     /* The platform pixel scale */
@@ -144,6 +204,12 @@ protected:
     Blending m_blend = Blending::opaque;
     int m_blendOrder = -1;
 
+    /* Only used by opaque styles, to reduce overdraw */
+    RenderMode m_renderMode = RenderMode::standard;
+
+    /* Tiles of a non-standard RenderMode, sorted front to back for a frame */
+    std::vector<std::shared_ptr<Tile>> m_sortedTiles;
+
     /* Draw mode to pass into <Mesh>es created with this style */
     GLenum m_drawMode;
 
@@ -153,6 +219,9 @@ protected:
     /* Whether the style should generate texture coordinates */
     bool m_texCoordsGeneration = false;
 
+    /* Lines and polygons are simplified by this distance in pixels, or not when 0 */
+    float m_simplifyTolerance = 0;
+
     bool m_hasColorShaderBlock = false;
 
     RasterType m_rasterType = RasterType::none;
@@ -179,13 +248,57 @@ protected:
         UniformLocation uRasters{"u_rasters"};
         UniformLocation uRasterSizes{"u_raster_sizes"};
         UniformLocation uRasterOffsets{"u_raster_offsets"};
+        // Tile batch uniforms
+        UniformLocation uTileTransforms{"u_tile_transforms"};
+        UniformLocation uTileOrigins{"u_tile_origins"};
+        UniformLocation uTileIndex{"u_tile_index"};
+        UniformLocation uFeatureState{"u_feature_state"};
+        UniformLocation uLightTiles{"u_light_tiles"};
+        UniformLocation uLightTilesSize{"u_light_tiles_size"};
 
         std::vector<StyleUniform> styleUniforms;
     } m_mainUniforms, m_selectionUniforms;
 
+    /* Whether the shaders of this style support TANGRAM_TILE_BATCH */
+    bool m_tileBatching = false;
+
+    /* Number of tiles and markers whose transforms are set at once, or 0 when
+     * each one is drawn with its own model matrix and origin uniforms */
+    size_t m_tileBatchSize = 0;
+
+    /* Whether the shaders of this style can read the view and light uniforms
+     * from the uniform blocks of uniformBlocks.glsl */
+    bool m_uniformBlocks = false;
+
+    bool m_shadersPending = false;
+
+    /* Buffers of the scene backing the uniform blocks, or null when the view
+     * and light uniforms are set on each program */
+    UniformBuffer* m_viewUniforms = nullptr;
+    UniformBuffer* m_lightUniforms = nullptr;
+
+    /* States of the features of the scene when shader blocks read featureState() */
+    FeatureState* m_featureState = nullptr;
+
+    /* Screen tiles of the lights of the scene when fragments skip the lights of other tiles */
+    LightCulling* m_lightCulling = nullptr;
+
+    /* Draw the meshes of _tiles and _markers in batches of m_tileBatchSize,
+     * selecting their transform with a single index uniform per draw */
+    bool drawTileBatches(RenderState& rs, ShaderProgram& _program, UniformBlock& _uniforms,
+                         const std::vector<std::shared_ptr<Tile>>& _tiles,
+                         const std::vector<std::unique_ptr<Marker>>& _markers,
+                         bool _useVao);
+
+    /* Draw a mesh of this style with _program, the main or the selection program.
+     * Styles override this to draw a mesh in several passes */
+    virtual bool drawMesh(RenderState& rs, ShaderProgram& _program, StyledMesh& _mesh, bool _useVao) {
+        return _mesh.draw(rs, _program, _useVao);
+    }
+
     /* Set uniform values when @_updateUniforms is true,
      */
-    void setupSceneShaderUniforms(RenderState& rs, UniformBlock& _uniformBlock);
+    void setupSceneShaderUniforms(RenderState& rs, ShaderProgram& _program, UniformBlock& _uniformBlock);
 
     void setupShaderUniforms(RenderState& rs, ShaderProgram& _program, const View& _view,
                              UniformBlock& _uniformBlock);
@@ -212,7 +325,7 @@ public:
 
     virtual ~Style();
 
-    StyleType type() { return m_type; }
+    StyleType type() const { return m_type; }
 
     std::string getTypeName() ;
 
@@ -234,6 +347,11 @@ public:
         return a->getName() < b->getName();
     }
 
+    /* Order in which to draw _styles, sorted by compare(). Opaque styles that
+     * share a program are drawn one after another, at the position of the
+     * first of them, so that the program is not switched between them. */
+    static std::vector<Style*> drawOrder(const std::vector<std::unique_ptr<Style>>& _styles);
+
     static const std::vector<std::string>& builtInStyleNames();
 
     Blending blendMode() const { return m_blend; };
@@ -242,16 +360,42 @@ public:
     void setBlendMode(Blending _blendMode) { m_blend = _blendMode; }
     void setBlendOrder(int _blendOrder) { m_blendOrder = _blendOrder; }
 
+    RenderMode renderMode() const { return m_renderMode; }
+    void setRenderMode(RenderMode _renderMode) { m_renderMode = _renderMode; }
+
+    /* Whether the meshes of this style are drawn front to back */
+    bool drawsFrontToBack() const {
+        return m_blend == Blending::opaque && m_renderMode != RenderMode::standard;
+    }
+
+    /* Sort _tiles by distance to the camera of _view, nearest first, with proxy
+     * tiles after the others as they are drawn behind them */
+    static void sortFrontToBack(const View& _view, std::vector<std::shared_ptr<Tile>>& _tiles);
+
     /* Whether or not the style is animated */
     bool isAnimated() { return m_animated; }
 
     /* Make this style ready to be used (call after all needed properties are set) */
     virtual void build(const Scene& _scene);
 
-    virtual void onBeginUpdate() {}
+    /* Called before labels are updated; _labelSetChanged is false when only
+     * the label fades advance since the last update. _time is the scene time
+     * of the update, which label fades start at */
+    virtual void onBeginUpdate(bool _labelSetChanged, float _time) {}
 
     virtual void onBeginFrame(RenderState& rs) {}
 
+    /* Issue compilation of the shader programs of this style without waiting
+     * for the driver, see ShaderProgram::compile() */
+    virtual void compileShaders(RenderState& rs);
+
+    /* Whether the programs drawing this style can be used without waiting
+     * for the driver to finish compiling them */
+    virtual bool shadersReady(RenderState& rs);
+
+    /* Whether the last draw() skipped this style because its shaders were not ready */
+    bool shadersPending() const { return m_shadersPending; }
+
     /* Create <VertexLayout> corresponding to this style; subclasses must
      * implement this and call it on construction
      */
@@ -294,6 +438,8 @@ public:
 
     virtual void setLightingType(LightingType _lType);
 
+    LightingType lightingType() const { return m_lightingType; }
+
     void setAnimated(bool _animated) { m_animated = _animated; }
 
     virtual void setPixelScale(float _pixelScale) { m_pixelScale = _pixelScale; }
@@ -304,6 +450,10 @@ public:
 
     bool genTexCoords() const { return m_texCoordsGeneration; }
 
+    void setSimplifyTolerance(float _pixels) { m_simplifyTolerance = _pixels; }
+
+    float simplifyTolerance() const { return m_simplifyTolerance; }
+
     void setID(uint32_t _id) { m_id = _id; }
 
     Material& getMaterial() { return *m_material.material; }
@@ -319,6 +469,10 @@ public:
 
     std::vector<StyleUniform>& styleUniforms() { return m_mainUniforms.styleUniforms; }
 
+    /* Replace the value of the style uniform _name. Returns false when there is no
+     * such uniform or when _value does not match the type it was declared with */
+    virtual bool setStyleUniform(const std::string& _name, const UniformValue& _value);
+
     void setDefaultDrawRule(std::unique_ptr<DrawRuleData>&& _rule);
     void applyDefaultDrawRules(DrawRule& _rule) const;
 
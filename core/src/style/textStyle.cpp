@@ -20,6 +20,7 @@ TextStyle::TextStyle(std::string _name, bool _sdf, Blending _blendMode, GLenum _
     : Style(_name, _blendMode, _drawMode, _selection), m_sdf(_sdf) {
     m_type = StyleType::text;
     m_lightingType = LightingType::none;
+    m_uniformBlocks = true;
 }
 
 TextStyle::~TextStyle() {}
@@ -31,8 +32,8 @@ void TextStyle::constructVertexLayout() {
         {"a_selection_color", 4, GL_UNSIGNED_BYTE, true, 0},
         {"a_color", 4, GL_UNSIGNED_BYTE, true, 0},
         {"a_stroke", 4, GL_UNSIGNED_BYTE, true, 0},
-        {"a_alpha", 1, GL_UNSIGNED_SHORT, true, 0},
-        {"a_scale", 1, GL_UNSIGNED_SHORT, false, 0},
+        {"a_scale", 2, GL_UNSIGNED_SHORT, false, 0},
+        {"a_fade", 2, GL_FLOAT, false, 0},
     }));
 }
 
@@ -47,10 +48,19 @@ void TextStyle::constructShaderProgram() {
     m_shaderSource->addSourceBlock("defines", "#define TANGRAM_TEXT\n");
 }
 
-void TextStyle::onBeginUpdate() {
+void TextStyle::onBeginUpdate(bool _labelSetChanged, float _time) {
+
+    m_labelTime = _time;
+
+    // The glyphs of the previous frame stay where they are when only fades
+    // advance, the labels drawn in it rewrite their fade when it changes
+    m_patchMeshes = !_labelSetChanged && m_meshes.size() == m_context->glyphTextureCount();
+
+    if (m_patchMeshes) { return; }
 
     // Clear vertices from previous frame
     for (auto& mesh : m_meshes) { mesh->clear(); }
+    m_meshGeneration++;
 
     // Ensure that meshes are available to push to on labels::update()
     size_t s = m_context->glyphTextureCount();
@@ -82,6 +92,7 @@ void TextStyle::onBeginDrawFrame(RenderState& rs, const View& _view) {
     m_shaderProgram->setUniformi(rs, m_mainUniforms.uTex, texUnit);
     m_shaderProgram->setUniformMatrix4f(rs, m_mainUniforms.uOrtho,
                                         _view.getOrthoViewportMatrix());
+    m_shaderProgram->setUniformf(rs, m_mainUniforms.uLabelTime, rs.frameTime());
 
     if (m_sdf) {
         m_shaderProgram->setUniformi(rs, m_mainUniforms.uPass, 1);
@@ -112,6 +123,7 @@ void TextStyle::onBeginDrawSelectionFrame(RenderState& rs, const View& _view) {
 
     m_selectionProgram->setUniformMatrix4f(rs, m_selectionUniforms.uOrtho,
                                            _view.getOrthoViewportMatrix());
+    m_selectionProgram->setUniformf(rs, m_selectionUniforms.uLabelTime, rs.frameTime());
 
     for (const auto& mesh : m_meshes) {
         if (mesh->isReady()) {
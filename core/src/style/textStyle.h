@@ -61,10 +61,17 @@ protected:
         UniformLocation uOrtho{"u_ortho"};
         UniformLocation uPass{"u_pass"};
         UniformLocation uMaxStrokeWidth{"u_max_stroke_width"};
+        UniformLocation uLabelTime{"u_label_time"};
     } m_mainUniforms, m_selectionUniforms;
 
     mutable std::vector<std::unique_ptr<DynamicQuadMesh<TextVertex>>> m_meshes;
 
+    uint32_t m_meshGeneration = 0;
+    bool m_patchMeshes = false;
+
+    // Scene time of the current update
+    float m_labelTime = 0;
+
 public:
 
     TextStyle(std::string _name, bool _sdf = false, Blending _blendMode = Blending::overlay,
@@ -75,8 +82,10 @@ public:
 
     /* Create the LabelMeshes associated with FontContext GlyphTexture<s>
      * No GL involved, called from Tangram::update()
+     * When the label set did not change the meshes are kept and labels only
+     * rewrite the fade of their glyphs when their state changes.
      */
-    virtual void onBeginUpdate() override;
+    virtual void onBeginUpdate(bool _labelSetChanged, float _time) override;
 
     /* Upload the buffers of the text batches
      * Upload the texture atlases
@@ -101,6 +110,17 @@ public:
 
     auto& getMeshes() const { return m_meshes; }
 
+    // Meshes of one generation keep the vertices of their labels until the
+    // label set changes
+    uint32_t meshGeneration() const { return m_meshGeneration; }
+
+    // Whether labels of the current generation only patch their fade
+    bool patchMeshes() const { return m_patchMeshes; }
+
+    // Scene time that the fades of the label vertices are relative to. The
+    // shaders evaluate the fades at the frame time of the RenderState.
+    float labelTime() const { return m_labelTime; }
+
     virtual size_t dynamicMeshSize() const override;
 
     virtual ~TextStyle() override;
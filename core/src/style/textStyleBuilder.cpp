@@ -19,7 +19,6 @@
 
 #include "unicode/unistr.h"
 #include "unicode/schriter.h"
-#include "unicode/brkiter.h"
 #include "unicode/locid.h"
 
 #include <glm/gtx/norm.hpp>
@@ -30,7 +29,7 @@
 
 namespace Tangram {
 
-const static std::string key_name("name");
+const static auto key_name = Properties::internKey("name");
 
 TextStyleBuilder::TextStyleBuilder(const TextStyle& _style) : m_style(_style) {}
 
@@ -42,6 +41,9 @@ void TextStyleBuilder::setup(const Tile& _tile){
     m_tileSize *= m_tileScale;
 
     m_atlasRefs.reset();
+    for (auto& texts : m_preparedTexts) { texts.clear(); }
+    // Stops are evaluated at the zoom of the tile
+    m_ruleParameters.clear();
 
     m_textLabels = std::make_unique<TextLabels>(m_style);
 }
@@ -58,6 +60,9 @@ void TextStyleBuilder::setup(const Marker& marker, int zoom) {
     m_tileSize *= m_style.pixelScale();
 
     m_atlasRefs.reset();
+    for (auto& texts : m_preparedTexts) { texts.clear(); }
+    // Stops are evaluated at the zoom of the tile
+    m_ruleParameters.clear();
 
     m_textLabels = std::make_unique<TextLabels>(m_style);
 }
@@ -170,7 +175,7 @@ bool getTextSource(const StyleParamKey _key, const DrawRule& _rule, const Proper
 
     auto& textSource = _rule.findParameter(_key);
     if (textSource.value.is<StyleParam::TextSource>()) {
-        for (auto& key : textSource.value.get<StyleParam::TextSource>().keys) {
+        for (auto key : textSource.value.get<StyleParam::TextSource>().keyIds) {
             _text = _props.getAsString(key);
             if (!_text.empty()) { break; }
         }
@@ -245,7 +250,7 @@ bool TextStyleBuilder::handleBoundaryLabel(const Feature& _feat, const DrawRule&
     };
 
     bool added = false;
-    for (auto& line : _feat.lines) {
+    for (const auto& line : _feat.lines()) {
         added |= addStraightTextLabels(line, labelWidth, onAddLabel);
     }
 
@@ -258,6 +263,7 @@ bool TextStyleBuilder::addFeature(const Feature& _feat, const DrawRule& _rule) {
 
     TextStyle::Parameters params = applyRule(_rule, _feat.props, false);
     if (!params.font) { return false; }
+    params.labelOptions.sourceId = _feat.id;
 
     Label::Type labelType;
     if (_feat.geometryType == GeometryType::lines) {
@@ -278,13 +284,13 @@ bool TextStyleBuilder::addFeature(const Feature& _feat, const DrawRule& _rule) {
         if (!prepareLabel(params, labelType, attrib)) { return false; }
 
         if (_feat.geometryType == GeometryType::points) {
-            for (auto& point : _feat.points) {
+            for (auto& point : _feat.points()) {
                 auto p = glm::vec2(point);
                 addLabel(Label::Type::point, {{ p }}, params, attrib, _rule);
             }
 
         } else if (_feat.geometryType == GeometryType::polygons) {
-            const auto& polygons = _feat.polygons;
+            const auto& polygons = _feat.polygons();
             for (const auto& polygon : polygons) {
                 if (!polygon.empty()) {
                     glm::vec2 c;
@@ -305,7 +311,7 @@ bool TextStyleBuilder::addFeature(const Feature& _feat, const DrawRule& _rule) {
     return true;
 }
 
-bool TextStyleBuilder::addStraightTextLabels(const Line& _line, float _labelWidth,
+bool TextStyleBuilder::addStraightTextLabels(const LineView& _line, float _labelWidth,
                                              const std::function<void(glm::vec2,glm::vec2)>& _onAddLabel) {
 
     // Size of pixel in tile coordinates
@@ -384,7 +390,7 @@ bool TextStyleBuilder::addStraightTextLabels(const Line& _line, float _labelWidt
     return false;
 }
 
-void TextStyleBuilder::addCurvedTextLabels(const Line& _line, const TextStyle::Parameters& _params,
+void TextStyleBuilder::addCurvedTextLabels(const LineView& _line, const TextStyle::Parameters& _params,
                                            const LabelAttributes& _attributes, const DrawRule& _rule) {
 
     // Size of pixel in tile coordinates
@@ -410,85 +416,104 @@ void TextStyleBuilder::addCurvedTextLabels(const Line& _line, const TextStyle::P
 
     if (sampler.sumLength() < minLength) { return; }
 
+    // Indices refer to the sampler points, which skip duplicate points of _line
+    const size_t numPoints = sampler.size();
+    if (numPoints < 2) { return; }
+    const size_t numSegments = numPoints - 1;
+
+    // Turns between segment j-1 and j, computed once per line so that each
+    // candidate range is checked in constant time:
+    // - hardTurn: inner angle below ~120 degree
+    // - flipCount: prefix count of turns that change the direction of the
+    //   previous turn larger than flipTolerance
+    // - angleSum: prefix sum of the sine of the turn angles
+    // - nextTurn: first turn larger than flipTolerance at or after j
+    // - hardBack: last segment k within sampleWindow before j that has an
+    //   inner angle below ~120 degree with j, or -1
+    std::vector<glm::vec2> dirs(numSegments);
+    for (size_t j = 0; j < numSegments; j++) {
+        dirs[j] = sampler.segmentDirection(j);
+    }
+
+    std::vector<bool> hardTurn(numSegments, false);
+    std::vector<int> flipCount(numSegments + 1, 0);
+    std::vector<float> angleSum(numSegments, 0.f);
+    std::vector<size_t> nextTurn(numSegments + 1, numSegments);
+    std::vector<int> hardBack(numSegments, -1);
+
+    float lastAngle = 0;
+    for (size_t j = 1; j < numSegments; j++) {
+        flipCount[j] = flipCount[j-1];
+        angleSum[j] = angleSum[j-1];
+
+        if (glm::length2(dirs[j-1] + dirs[j]) < sqDirLimit) {
+            hardTurn[j] = true;
+            continue;
+        }
+        float angle = perpDotProduct(dirs[j-1], dirs[j]);
+
+        if (std::abs(angle) > flipTolerance) {
+            if ((lastAngle > 0 && angle < 0) || (lastAngle < 0 && angle > 0)) {
+                flipCount[j]++;
+            }
+            lastAngle = angle;
+        }
+        angleSum[j] += std::abs(angle);
+
+        for (int k = j - 1; k >= 0; k--) {
+            if (glm::length2(dirs[k] + dirs[j]) < sqDirLimit) {
+                hardBack[j] = k;
+                break;
+            }
+            if (sampler.point(k).z < sampler.point(j).z - sampleWindow) {
+                break;
+            }
+        }
+    }
+    flipCount[numSegments] = flipCount[numSegments-1];
+
+    for (size_t j = numSegments; j-- > 1; ) {
+        bool turn = !hardTurn[j] && std::abs(perpDotProduct(dirs[j-1], dirs[j])) > flipTolerance;
+        nextTurn[j] = turn ? j : nextTurn[j+1];
+    }
+
     struct LineRange {
         size_t start, end;
-        int flips;
         float sumAngle;
     };
 
     std::vector<LineRange> ranges;
 
-    for (size_t i = 0; i < _line.size()-1; i++) {
+    for (size_t i = 0; i < numSegments; i++) {
 
-        int flips = 0;
-        float lastAngle = 0;
-        float sumAngle = 0;
-        size_t lastBreak = 0;
+        // Flips are counted from the first turn after 'i'
+        int flipBase = flipCount[nextTurn[i+1]];
+        bool split = false;
 
-        glm::vec2 dir1 = sampler.segmentDirection(i);
+        for (size_t j = i + 1; j < numSegments; j++) {
 
-        for (size_t j = i + 1; j < _line.size()-1; j++) {
-            glm::vec2 dir2 = sampler.segmentDirection(j);
-            bool splitLine = false;
-
-            if (glm::length2(dir1 + dir2) < sqDirLimit) {
-                // Split if the angle between current and next segment is
-                // not whithin 120 < a < 240 degree
-                splitLine = true;
-            } else {
-                // Take cross product of direction (unit-) vectors of the current
-                // and next segment. The magnitude of the cross product is the sine
-                // angle between dir1 and dir2.
-                float angle = perpDotProduct(dir1, dir2);
-
-                if (std::abs(angle) > flipTolerance) {
-                    if (lastAngle > 0) {
-                        if (angle < 0) { flips++; }
-                    } else if (lastAngle < 0) {
-                        if (angle > 0) { flips++; }
-                    }
-                    lastAngle = angle;
-                }
-
-                // Limit number of direction changes (Avoid squiggly labels)
-                if (flips > 2) {
-                    splitLine = true;
-                } else {
-                    sumAngle += std::abs(angle);
-                }
-            }
-
-            if (!splitLine) {
-                // Go back within window to check for hard direction changes
-                for (int k = j - 1; k >= int(i); k--){
-                    if (glm::length2(sampler.segmentDirection(k) + dir2) < sqDirLimit) {
-                        splitLine = true;
-                    }
-                    if (sampler.point(k).z < sampler.point(j).z - sampleWindow) {
-                        break;
-                    }
-                }
-            }
-
-            if (splitLine) {
-                float length = sampler.point(j).z - sampler.point(i).z;
-                if (length > minLength) {
-                    ranges.push_back(LineRange{i, j+1, flips, sumAngle});
-                }
+            // Split if the angle between current and next segment is not
+            // whithin 120 < a < 240 degree or when the direction changed
+            // too often (Avoid squiggly labels)
+            bool splitBefore = hardTurn[j] || flipCount[j] - flipBase > 2;
 
-                lastBreak = j;
-                break;
+            // Go back within window to check for hard direction changes
+            if (!splitBefore && hardBack[j] < int(i)) { continue; }
 
-            } else {
-                dir1 = dir2;
+            float length = sampler.point(j).z - sampler.point(i).z;
+            if (length > minLength) {
+                float sumAngle = angleSum[splitBefore ? j-1 : j] - angleSum[i];
+                ranges.push_back(LineRange{i, j+1, sumAngle});
             }
+            split = true;
+            break;
         }
 
         // Add segment from 'i' unless line got split.
-        if (lastBreak == 0) {
+        if (!split) {
             float length = sampler.sumLength() - sampler.point(i).z;
             if (length > minLength) {
-                ranges.push_back(LineRange{i, _line.size(), flips, sumAngle});
+                ranges.push_back(LineRange{i, numPoints, angleSum[numSegments-1] - angleSum[i]});
             }
         }
     }
@@ -507,8 +532,7 @@ void TextStyleBuilder::addCurvedTextLabels(const Line& _line, const TextStyle::P
         l.reserve(range.end - range.start + 1);
 
         for (size_t j = range.start; j < range.end; j++) {
-            auto& p = _line[j];
-            l.emplace_back(p.x, p.y);
+            l.emplace_back(sampler.point(j));
 
             if (j == offset) {
                 l.push_back(center);
@@ -544,7 +568,7 @@ void TextStyleBuilder::addLineTextLabels(const Feature& _feat, const TextStyle::
         addLabel(Label::Type::line, {{ a, b }}, _params, _attributes, _rule);
     };
 
-    for (auto& line : _feat.lines) {
+    for (const auto& line : _feat.lines()) {
 
         if (!addStraightTextLabels(line, _attributes.width, straightLabelCb) &&
             line.size() > 2 && !_params.hasComplexShaping &&
@@ -572,10 +596,6 @@ TextStyle::Parameters TextStyleBuilder::applyRule(const DrawRule& _rule,
                                                   const Properties& _props,
                                                   bool _iconText) const {
 
-    const static std::string defaultWeight("400");
-    const static std::string defaultStyle("regular");
-    const static std::string defaultFamily("default");
-
     TextStyle::Parameters p;
 
     bool hasLeft = getTextSource(StyleParamKey::text_source_left, _rule, _props, p.textLeft);
@@ -592,6 +612,76 @@ TextStyle::Parameters TextStyleBuilder::applyRule(const DrawRule& _rule,
         return p;
     }
 
+    // Params of the rule by which its parameters are cached, text sources aside.
+    // Values of JS functions may differ for each feature.
+    bool cacheable = true;
+    m_ruleParams.clear();
+    for (size_t i = 0; i < StyleParamKeySize; i++) {
+        if (!_rule.active[i]) { continue; }
+
+        auto key = static_cast<StyleParamKey>(i);
+        if (key == StyleParamKey::text_source || key == StyleParamKey::text_source_left ||
+            key == StyleParamKey::text_source_right) {
+            continue;
+        }
+        const StyleParam* param = _rule.param(i).param;
+        if (param->function >= 0) {
+            cacheable = false;
+            break;
+        }
+        // Evaluated Stops share a StyleParam of the DrawRuleMergeSet
+        m_ruleParams.push_back(param->stops ? static_cast<const void*>(param->stops) : param);
+    }
+
+    size_t ruleKey = 0;
+    if (cacheable) {
+        hash_combine(ruleKey, _rule.getParamSetHash());
+        hash_combine(ruleKey, _rule.id);
+        hash_combine(ruleKey, _iconText);
+
+        auto it = m_ruleParameters.find(ruleKey);
+        if (it != m_ruleParameters.end() && it->second.params == m_ruleParams) {
+            TextStyle::Parameters cached = it->second.parameters;
+            cached.text = std::move(p.text);
+            cached.textLeft = std::move(p.textLeft);
+            cached.textRight = std::move(p.textRight);
+            p = std::move(cached);
+        } else {
+            applyRuleParameters(_rule, _iconText, p);
+            auto& entry = m_ruleParameters[ruleKey];
+            entry.params = m_ruleParams;
+            entry.parameters = p;
+            entry.parameters.text.clear();
+            entry.parameters.textLeft.clear();
+            entry.parameters.textRight.clear();
+        }
+    } else {
+        applyRuleParameters(_rule, _iconText, p);
+    }
+
+    if (!p.font) { return p; }
+
+    if (p.labelOptions.repeatDistance > 0.f) {
+        hash_combine(p.labelOptions.repeatGroup, p.text);
+    }
+
+    std::hash<TextStyle::Parameters> hash;
+    p.labelOptions.paramHash = hash(p);
+
+    if (p.interactive) {
+        p.labelOptions.featureId = _rule.selectionColor;
+    }
+
+    return p;
+}
+
+void TextStyleBuilder::applyRuleParameters(const DrawRule& _rule, bool _iconText,
+                                           TextStyle::Parameters& p) const {
+
+    const static std::string defaultWeight("400");
+    const static std::string defaultStyle("regular");
+    const static std::string defaultFamily("default");
+
     auto fontFamily = _rule.get<std::string>(StyleParamKey::text_font_family);
     fontFamily = (!fontFamily) ? &defaultFamily : fontFamily;
 
@@ -607,7 +697,7 @@ TextStyle::Parameters TextStyleBuilder::applyRule(const DrawRule& _rule,
     p.font = m_style.context()->getFont(*fontFamily, *fontStyle, *fontWeight, p.fontSize);
     if (!p.font) {
         LOGW("Missing font for %s / %s / %s / %d", fontFamily->c_str(), fontStyle->c_str(), fontWeight->c_str(), p.fontSize);
-        return p;
+        return;
     }
     _rule.get(StyleParamKey::text_font_fill, p.fill);
     float alpha = 1;
@@ -711,8 +801,8 @@ TextStyle::Parameters TextStyleBuilder::applyRule(const DrawRule& _rule,
         }
     }
 
+    // The text of the feature is added to the repeat group by applyRule()
     if (p.labelOptions.repeatDistance > 0.f) {
-        hash_combine(repeatGroupHash, p.text);
         p.labelOptions.repeatGroup = repeatGroupHash;
         p.labelOptions.repeatDistance *= m_style.pixelScale();
     }
@@ -732,60 +822,61 @@ TextStyle::Parameters TextStyleBuilder::applyRule(const DrawRule& _rule,
 
     _rule.get(StyleParamKey::text_optional, p.labelOptions.optional);
 
-    std::hash<TextStyle::Parameters> hash;
-    p.labelOptions.paramHash = hash(p);
-
     p.lineSpacing = 2 * m_style.pixelScale();
+}
 
-    if (p.interactive) {
-        p.labelOptions.featureId = _rule.selectionColor;
-    }
+bool isComplexShapingScript(const icu::UnicodeString& _text) {
 
-    return p;
+    // Taken from:
+    // https://github.com/tangrams/tangram/blob/labels-rebase/src/styles/text/canvas_text.js#L538-L553
+    // See also http://r12a.github.io/scripts/featurelist/
+
+    icu::StringCharacterIterator iterator(_text);
+    for (UChar c = iterator.first(); c != icu::CharacterIterator::DONE; c = iterator.next()) {
+        if (c >= u'\u0600' && c <= u'\u18AF') {
+            if ((c <= u'\u06FF') ||                   // Arabic:     "\u0600-\u06FF"
+                (c >= u'\u1800' && c <= u'\u18AF')) { // Mongolian:  "\u1800-\u18AF"
+                return true;
+            }
+        }
+    }
+    return false;
 }
 
-void applyTextTransform(const TextStyle::Parameters& _params,
-                        icu::UnicodeString& _string) {
+const TextStyleBuilder::PreparedText& TextStyleBuilder::prepareText(const TextStyle::Parameters& _params) {
+
+    auto& texts = m_preparedTexts[int(_params.transform)];
+
+    auto it = texts.find(_params.text);
+    if (it != texts.end()) { return it->second; }
+
+    auto text = icu::UnicodeString::fromUTF8(_params.text);
 
     icu::Locale loc("en");
 
     switch (_params.transform) {
     case TextLabelProperty::Transform::capitalize: {
-        UErrorCode status{U_ZERO_ERROR};
-        auto *wordIterator = icu::BreakIterator::createWordInstance(loc, status);
-
-        if (U_SUCCESS(status)) { _string.toTitle(wordIterator); }
-
-        delete wordIterator;
+        if (!m_wordIterator) {
+            UErrorCode status{U_ZERO_ERROR};
+            m_wordIterator.reset(icu::BreakIterator::createWordInstance(loc, status));
+            if (U_FAILURE(status)) { m_wordIterator.reset(); }
+        }
+        if (m_wordIterator) { text.toTitle(m_wordIterator.get()); }
         break;
     }
     case TextLabelProperty::Transform::lowercase:
-        _string.toLower(loc);
+        text.toLower(loc);
         break;
     case TextLabelProperty::Transform::uppercase:
-        _string.toUpper(loc);
+        text.toUpper(loc);
         break;
     default:
         break;
     }
-}
 
-bool isComplexShapingScript(const icu::UnicodeString& _text) {
+    bool complexShaping = isComplexShapingScript(text);
 
-    // Taken from:
-    // https://github.com/tangrams/tangram/blob/labels-rebase/src/styles/text/canvas_text.js#L538-L553
-    // See also http://r12a.github.io/scripts/featurelist/
-
-    icu::StringCharacterIterator iterator(_text);
-    for (UChar c = iterator.first(); c != icu::CharacterIterator::DONE; c = iterator.next()) {
-        if (c >= u'\u0600' && c <= u'\u18AF') {
-            if ((c <= u'\u06FF') ||                   // Arabic:     "\u0600-\u06FF"
-                (c >= u'\u1800' && c <= u'\u18AF')) { // Mongolian:  "\u1800-\u18AF"
-                return true;
-            }
-        }
-    }
-    return false;
+    return texts.emplace(_params.text, PreparedText{ std::move(text), complexShaping }).first->second;
 }
 
 bool TextStyleBuilder::prepareLabel(TextStyle::Parameters& _params, Label::Type _type,
@@ -796,12 +887,11 @@ bool TextStyleBuilder::prepareLabel(TextStyle::Parameters& _params, Label::Type
         return false;
     }
 
-    auto text = icu::UnicodeString::fromUTF8(_params.text);
-
-    applyTextTransform(_params, text);
+    const auto& prepared = prepareText(_params);
+    const auto& text = prepared.text;
 
     if (_type == Label::Type::line) {
-        _params.hasComplexShaping = isComplexShapingScript(text);
+        _params.hasComplexShaping = prepared.complexShaping;
     }
 
     // Scale factor by which the texture glyphs are scaled to match fontSize
@@ -5,9 +5,12 @@
 #include "style/textStyle.h"
 #include "text/fontContext.h"
 
+#include "unicode/brkiter.h"
+#include <array>
 #include <memory>
 #include <vector>
 #include <string>
+#include <unordered_map>
 
 namespace Tangram {
 
@@ -37,6 +40,11 @@ public:
 
     std::unique_ptr<StyledMesh> build() override;
 
+    size_t scratchCapacity() const override {
+        return m_quads.capacity() * sizeof(GlyphQuad) +
+            m_labels.capacity() * sizeof(m_labels[0]);
+    }
+
     TextStyle::Parameters applyRule(const DrawRule& _rule, const Properties& _props, bool _iconText) const;
 
     bool prepareLabel(TextStyle::Parameters& _params, Label::Type _type, LabelAttributes& _attributes);
@@ -48,10 +56,10 @@ public:
     void addLineTextLabels(const Feature& _feature, const TextStyle::Parameters& _params,
                            const LabelAttributes& _attributes, const DrawRule& _rule);
 
-    bool addStraightTextLabels(const Line& _feature, float _labelWidth,
+    bool addStraightTextLabels(const LineView& _feature, float _labelWidth,
                                const std::function<void(glm::vec2,glm::vec2)>& _onAddLabel);
 
-    void addCurvedTextLabels(const Line& _feature, const TextStyle::Parameters& _params,
+    void addCurvedTextLabels(const LineView& _feature, const TextStyle::Parameters& _params,
                              const LabelAttributes& _attributes, const DrawRule& _rule);
 
     bool handleBoundaryLabel(const Feature& _feat, const DrawRule& _rule,
@@ -64,6 +72,15 @@ public:
 
 protected:
 
+    // Label text after the text transform, with its script properties
+    struct PreparedText {
+        icu::UnicodeString text;
+        bool complexShaping;
+    };
+
+    // Converts and transforms each distinct text of a tile once
+    const PreparedText& prepareText(const TextStyle::Parameters& _params);
+
     const TextStyle& m_style;
 
     // Result: TextLabel container
@@ -77,6 +94,25 @@ protected:
     float m_tileSize = 0;
     float m_tileScale = 0;
 
+    // Prepared texts of the current tile by text transform and UTF-8 text
+    std::array<std::unordered_map<std::string, PreparedText>, 4> m_preparedTexts;
+
+    // Word iterator for the capitalize transform
+    std::unique_ptr<icu::BreakIterator> m_wordIterator;
+
+    // Set the parameters of _rule other than the text, which do not change
+    // between the features of a tile that share the rule
+    void applyRuleParameters(const DrawRule& _rule, bool _iconText, TextStyle::Parameters& _params) const;
+
+    // Parameters of the rules of the current tile without JS functions, by the
+    // param-set hash and id of the rule. The params identify the rule on a hit.
+    struct RuleParameters {
+        std::vector<const void*> params;
+        TextStyle::Parameters parameters;
+    };
+    mutable std::unordered_map<size_t, RuleParameters> m_ruleParameters;
+    mutable std::vector<const void*> m_ruleParams;
+
 };
 
 }
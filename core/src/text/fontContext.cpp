@@ -1,11 +1,16 @@
 #include "text/fontContext.h"
 
 #include "log.h"
+#include "map.h"
 #include "platform.h"
+#include "util/hash.h"
+#include "util/threadPool.h"
 
 #define SDF_IMPLEMENTATION
 #include "sdf.h"
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
 #include <regex>
 
@@ -13,15 +18,63 @@
 
 #define MIN_LINE_WIDTH 4
 
+// Header of serialized glyph distance fields
+#define GLYPH_FIELDS_MAGIC "TGF1"
+
 namespace Tangram {
 
 const std::vector<float> FontContext::s_fontRasterSizes = { 16, 28, 40 };
 
+constexpr size_t FontContext::layout_cache_bytes;
+
+static std::atomic<size_t> s_layoutHits(0);
+static std::atomic<size_t> s_layoutMisses(0);
+
+FontContext::LayoutCacheStats FontContext::layoutCacheStats() {
+    LayoutCacheStats stats;
+    stats.hits = s_layoutHits;
+    stats.misses = s_layoutMisses;
+    return stats;
+}
+
+bool FontContext::LayoutKey::operator==(const LayoutKey& _other) const {
+    return font == _other.font &&
+        fontScale == _other.fontScale &&
+        lineSpacing == _other.lineSpacing &&
+        maxLineWidth == _other.maxLineWidth &&
+        maxLines == _other.maxLines &&
+        alignments == _other.alignments &&
+        text == _other.text;
+}
+
+size_t FontContext::LayoutKeyHash::operator()(const LayoutKey& _key) const {
+    size_t seed = 0;
+    hash_combine(seed, _key.text.hashCode());
+    hash_combine(seed, _key.font.get());
+    hash_combine(seed, _key.fontScale);
+    hash_combine(seed, _key.lineSpacing);
+    hash_combine(seed, _key.maxLineWidth);
+    hash_combine(seed, _key.maxLines);
+    hash_combine(seed, int(_key.alignments[0]) | int(_key.alignments[1]) << 1 | int(_key.alignments[2]) << 2);
+    return seed;
+}
+
 FontContext::FontContext(Platform& _platform) :
     m_sdfRadius(SDF_WIDTH),
     m_atlas(*this, GlyphTexture::size, m_sdfRadius),
     m_batch(m_atlas, m_scratch),
-    m_platform(_platform) {}
+    m_platform(_platform) {
+
+    m_textures.reserve(max_textures);
+}
+
+FontContext::~FontContext() {
+    std::unique_lock<std::mutex> lock(m_textureMutex);
+    m_rasterQueue.clear();
+
+    // Jobs refer to this FontContext
+    m_glyphsRasterized.wait(lock, [&]{ return m_rasterJobs == 0; });
+}
 
 void FontContext::setPixelScale(float _scale) {
     m_sdfRadius = SDF_WIDTH * _scale;
@@ -44,9 +97,20 @@ void FontContext::loadFonts() {
 
         alfons::InputSource source;
         switch (fallback.tag) {
-            case FontSourceHandle::FontPath:
+            case FontSourceHandle::FontPath: {
                 source = alfons::InputSource(fallback.fontPath.path());
+
+                // Only read which characters the font covers, its face is added
+                // by addFallbacks() once a text needs them
+                LazyFallback lazy;
+                if (lazy.coverage.load(fallback.fontPath.path())) {
+                    lazy.source = source;
+                    m_lazyFallbacks.push_back(std::move(lazy));
+                    added = true;
+                    continue;
+                }
                 break;
+            }
             case FontSourceHandle::FontName:
                 source = alfons::InputSource(fallback.fontName, true);
                 break;
@@ -69,7 +133,7 @@ void FontContext::loadFonts() {
     }
 }
 
-// Synchronized on m_mutex in layoutText(), called on tile-worker threads
+// Synchronized on m_fontMutex in layoutText(), called on tile-worker threads
 void FontContext::addTexture(alfons::AtlasID id, uint16_t width, uint16_t height) {
 
     std::lock_guard<std::mutex> lock(m_textureMutex);
@@ -78,43 +142,229 @@ void FontContext::addTexture(alfons::AtlasID id, uint16_t width, uint16_t height
         LOGE("Way too many glyph textures!");
         return;
     }
+    // Capacity is reserved, textures are accessed without m_textureMutex
     m_textures.push_back(std::make_unique<GlyphTexture>());
 }
 
-// Synchronized on m_mutex in layoutText(), called on tile-worker threads
+// Synchronized on m_fontMutex in layoutText(), called on tile-worker threads
 void FontContext::addGlyph(alfons::AtlasID id, uint16_t gx, uint16_t gy, uint16_t gw, uint16_t gh,
                            const unsigned char* src, uint16_t pad) {
 
+    if (id >= max_textures) { return; }
+
+    NewGlyph glyph;
+    glyph.atlas = id;
+    glyph.x = gx;
+    glyph.y = gy;
+    glyph.width = gw + pad * 2;
+    glyph.height = gh + pad * 2;
+    glyph.bitmap.resize(size_t(glyph.width) * size_t(glyph.height), 0);
+
+    unsigned char* dst = &glyph.bitmap[pad + pad * glyph.width];
+
+    for (size_t y = 0, pos = 0; y < gh; y++, pos += gw) {
+        std::memcpy(dst + (y * glyph.width), src + pos, gw);
+    }
+
+    m_newGlyphs.push_back(std::move(glyph));
+
     std::lock_guard<std::mutex> lock(m_textureMutex);
+    m_pendingGlyphs[id] += 1;
+}
 
-    if (id >= max_textures) { return; }
+void FontContext::queueGlyphs(std::vector<NewGlyph>&& _glyphs) {
 
-    auto texData = m_textures[id]->buffer();
-    auto& texture = m_textures[id];
+    if (_glyphs.empty()) { return; }
 
-    size_t stride = GlyphTexture::size;
-    size_t width =  GlyphTexture::size;
+    {
+        std::lock_guard<std::mutex> lock(m_textureMutex);
+        m_rasterQueue.push_back(std::move(_glyphs));
+        m_rasterJobs++;
+    }
 
-    unsigned char* dst = &texData[(gx + pad) + (gy + pad) * stride];
+    // One job per batch, so that batches are rasterized in parallel.
+    // The batch may already be taken by a thread in waitForGlyphs().
+    ThreadPool::shared().enqueue(ThreadPool::Priority::tile, [this]() {
+        rasterizeNextBatch();
 
-    for (size_t y = 0, pos = 0; y < gh; y++, pos += gw) {
-        std::memcpy(dst + (y * stride), src + pos, gw);
+        std::lock_guard<std::mutex> lock(m_textureMutex);
+        m_rasterJobs--;
+        // NB: 'this' may be destroyed right after the lock is released
+        m_glyphsRasterized.notify_all();
+    });
+}
+
+bool FontContext::rasterizeNextBatch() {
+    std::vector<NewGlyph> glyphs;
+    {
+        std::lock_guard<std::mutex> lock(m_textureMutex);
+        if (m_rasterQueue.empty()) { return false; }
+
+        glyphs = std::move(m_rasterQueue.front());
+        m_rasterQueue.pop_front();
+    }
+    rasterizeGlyphs(glyphs);
+    return true;
+}
+
+void FontContext::rasterizeGlyphs(const std::vector<NewGlyph>& _glyphs) {
+
+    if (_glyphs.empty()) { return; }
+
+    static thread_local std::vector<unsigned char> t_sdfBuffer;
+    std::vector<unsigned char> field;
+
+    for (const auto& glyph : _glyphs) {
+
+        uint64_t key = glyphFieldKey(glyph);
+        bool baked = false;
+        {
+            std::lock_guard<std::mutex> lock(m_fieldMutex);
+            auto it = m_glyphFields.find(key);
+            if (it != m_glyphFields.end() && it->second.size() == glyph.bitmap.size()) {
+                field = it->second;
+                baked = true;
+            }
+        }
+
+        if (!baked) {
+            size_t bytes = size_t(glyph.width) * size_t(glyph.height) * sizeof(float) * 3;
+            if (t_sdfBuffer.size() < bytes) {
+                t_sdfBuffer.resize(bytes);
+            }
+            field.resize(glyph.bitmap.size());
+
+            sdfBuildDistanceFieldNoAlloc(field.data(), glyph.width, m_sdfRadius,
+                                         glyph.bitmap.data(), glyph.width, glyph.height, glyph.width,
+                                         &t_sdfBuffer[0]);
+
+            if (m_recordGlyphFields) {
+                std::lock_guard<std::mutex> lock(m_fieldMutex);
+                m_glyphFields.emplace(key, field);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(m_atlasMutex[glyph.atlas]);
+
+        auto& texture = m_textures[glyph.atlas];
+        size_t stride = GlyphTexture::size;
+        unsigned char* dst = &texture->buffer()[size_t(glyph.x) + size_t(glyph.y) * stride];
+
+        for (size_t y = 0; y < glyph.height; y++) {
+            std::memcpy(dst + y * stride, &field[y * glyph.width], glyph.width);
+        }
+
+        texture->setRegionDirty(glyph.x, glyph.y, glyph.width, glyph.height);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_textureMutex);
+        for (const auto& glyph : _glyphs) {
+            m_pendingGlyphs[glyph.atlas] -= 1;
+        }
     }
+    m_glyphsRasterized.notify_all();
+}
 
-    dst = &texData[size_t(gx) + (size_t(gy) * width)];
-    gw += pad * 2;
-    gh += pad * 2;
+uint64_t FontContext::glyphFieldKey(const NewGlyph& _glyph) const {
+    // FNV-1a of the SDF radius, size and coverage of the glyph
+    uint64_t hash = 14695981039346656037ull;
+    auto add = [&](const unsigned char* _bytes, size_t _length) {
+        for (size_t i = 0; i < _length; i++) {
+            hash = (hash ^ _bytes[i]) * 1099511628211ull;
+        }
+    };
+    uint32_t radius = uint32_t(m_sdfRadius * 100.f);
+    add(reinterpret_cast<const unsigned char*>(&radius), sizeof(radius));
+    add(reinterpret_cast<const unsigned char*>(&_glyph.width), sizeof(_glyph.width));
+    add(reinterpret_cast<const unsigned char*>(&_glyph.height), sizeof(_glyph.height));
+    add(_glyph.bitmap.data(), _glyph.bitmap.size());
+    return hash;
+}
 
-    size_t bytes = size_t(gw) * size_t(gh) * sizeof(float) * 3;
-    if (m_sdfBuffer.size() < bytes) {
-        m_sdfBuffer.resize(bytes);
+bool FontContext::addGlyphFields(const std::vector<char>& _data) {
+    // Format: magic, uint32 count, then per glyph uint64 key,
+    // uint32 length and the distance field bytes.
+    size_t pos = 0;
+    auto read = [&](void* _dst, size_t _length) {
+        if (pos + _length > _data.size()) { return false; }
+        std::memcpy(_dst, _data.data() + pos, _length);
+        pos += _length;
+        return true;
+    };
+
+    char magic[4];
+    uint32_t count = 0;
+    if (!read(magic, sizeof(magic)) || std::memcmp(magic, GLYPH_FIELDS_MAGIC, sizeof(magic)) != 0 ||
+        !read(&count, sizeof(count))) {
+        LOGE("Invalid glyph fields");
+        return false;
     }
 
-    sdfBuildDistanceFieldNoAlloc(dst, width, m_sdfRadius,
-                                 dst, gw, gh, width,
-                                 &m_sdfBuffer[0]);
+    std::unordered_map<uint64_t, std::vector<unsigned char>> fields;
+    for (uint32_t i = 0; i < count; i++) {
+        uint64_t key = 0;
+        uint32_t length = 0;
+        if (!read(&key, sizeof(key)) || !read(&length, sizeof(length)) ||
+            pos + length > _data.size()) {
+            LOGE("Truncated glyph fields");
+            return false;
+        }
+        auto begin = reinterpret_cast<const unsigned char*>(_data.data()) + pos;
+        fields.emplace(key, std::vector<unsigned char>(begin, begin + length));
+        pos += length;
+    }
 
-    texture->setRowsDirty(gy, gh);
+    std::lock_guard<std::mutex> lock(m_fieldMutex);
+    m_glyphFields.insert(std::make_move_iterator(fields.begin()),
+                         std::make_move_iterator(fields.end()));
+    return true;
+}
+
+std::vector<char> FontContext::glyphFieldsData() {
+    std::vector<char> data;
+    auto write = [&](const void* _src, size_t _length) {
+        auto bytes = reinterpret_cast<const char*>(_src);
+        data.insert(data.end(), bytes, bytes + _length);
+    };
+
+    std::lock_guard<std::mutex> lock(m_fieldMutex);
+
+    uint32_t count = m_glyphFields.size();
+    write(GLYPH_FIELDS_MAGIC, 4);
+    write(&count, sizeof(count));
+
+    for (const auto& entry : m_glyphFields) {
+        uint32_t length = entry.second.size();
+        write(&entry.first, sizeof(entry.first));
+        write(&length, sizeof(length));
+        write(entry.second.data(), length);
+    }
+    return data;
+}
+
+void FontContext::waitForGlyphs(const std::bitset<max_textures>& _refs) {
+
+    std::unique_lock<std::mutex> lock(m_textureMutex);
+
+    auto rasterized = [&]() {
+        for (size_t i = 0; i < m_textures.size(); i++) {
+            if (_refs[i] && m_pendingGlyphs[i] > 0) { return false; }
+        }
+        return true;
+    };
+
+    while (!rasterized()) {
+        if (!m_rasterQueue.empty()) {
+            // Help instead of waiting for a pool thread
+            lock.unlock();
+            rasterizeNextBatch();
+            lock.lock();
+            continue;
+        }
+        // Remaining glyphs are being rasterized by other threads
+        m_glyphsRasterized.wait(lock);
+    }
 }
 
 void FontContext::releaseAtlas(std::bitset<max_textures> _refs) {
@@ -127,40 +377,105 @@ void FontContext::releaseAtlas(std::bitset<max_textures> _refs) {
 }
 
 void FontContext::updateTextures(RenderState& rs) {
-    std::lock_guard<std::mutex> lock(m_textureMutex);
+    size_t count = glyphTextureCount();
 
-    for (auto& gt : m_textures) { gt->bind(rs, 0); }
+    for (size_t i = 0; i < count; i++) {
+        std::lock_guard<std::mutex> lock(m_atlasMutex[i]);
+        m_textures[i]->bind(rs, 0);
+    }
 }
 
 void FontContext::bindTexture(RenderState& rs, alfons::AtlasID _id, GLuint _unit) {
-    std::lock_guard<std::mutex> lock(m_textureMutex);
+    std::lock_guard<std::mutex> lock(m_atlasMutex[_id]);
 
     m_textures[_id]->bind(rs, _unit);
 }
 
-bool FontContext::layoutText(TextStyle::Parameters& _params, const icu::UnicodeString& _text,
-                             std::vector<GlyphQuad>& _quads, std::bitset<max_textures>& _refs,
-                             glm::vec2& _size, TextRange& _textRanges) {
+bool FontContext::getCachedLayout(const LayoutKey& _key, std::vector<GlyphQuad>& _quads,
+                                  std::bitset<max_textures>& _refs, glm::vec2& _size,
+                                  TextRange& _textRanges) {
 
-    std::lock_guard<std::mutex> lock(m_fontMutex);
+    std::lock_guard<std::mutex> lock(m_layoutMutex);
 
-    alfons::LineLayout line = m_shaper.shapeICU(_params.font, _text, MIN_LINE_WIDTH,
-                                                _params.wordWrap ? _params.maxLineWidth : 0);
+    auto it = m_layouts.find(_key);
+    if (it == m_layouts.end()) { return false; }
 
-    if (line.missingGlyphs() || line.shapes().size() == 0) {
-        // Nothing to do!
-        return false;
+    // Move to the front of the LRU list
+    m_layoutList.splice(m_layoutList.begin(), m_layoutList, it->second);
+
+    const auto& layout = it->second->second;
+
+    int quadsStart = _quads.size();
+    _quads.insert(_quads.end(), layout.quads.begin(), layout.quads.end());
+
+    for (size_t i = 0; i < 3; i++) {
+        _textRanges[i] = Range(layout.textRanges[i].start + quadsStart, layout.textRanges[i].length);
     }
+    _size = layout.size;
 
-    line.setScale(_params.fontScale);
+    std::lock_guard<std::mutex> textureLock(m_textureMutex);
+    for (size_t i = 0; i < max_textures; i++) {
+        if (layout.refs[i] && !_refs[i]) {
+            _refs[i] = true;
+            m_atlasRefCount[i] += 1;
+        }
+    }
+    return true;
+}
 
-    // m_batch.drawShapeRange() calls FontContext's TextureCallback for new glyphs
-    // and MeshCallback (drawGlyph) for vertex quads of each glyph in LineLayout.
+void FontContext::cacheLayout(LayoutKey _key, Layout _layout) {
 
-    m_scratch.quads = &_quads;
+    std::lock_guard<std::mutex> lock(m_layoutMutex);
 
-    size_t quadsStart = _quads.size();
-    alfons::LineMetrics metrics;
+    // Another thread may have added the same layout in the meantime
+    if (m_layouts.find(_key) != m_layouts.end()) {
+        releaseAtlas(_layout.refs);
+        return;
+    }
+
+    _layout.bytes = sizeof(LayoutEntry) + _layout.quads.size() * sizeof(GlyphQuad)
+        + _key.text.length() * sizeof(UChar);
+    m_layoutBytes += _layout.bytes;
+
+    m_layoutList.emplace_front(std::move(_key), std::move(_layout));
+    m_layouts.emplace(m_layoutList.front().first, m_layoutList.begin());
+
+    trimLayoutCache(1);
+}
+
+void FontContext::trimLayoutCache(size_t _keep) {
+    while (m_layoutBytes > m_layoutCacheBytes && m_layoutList.size() > _keep) {
+        auto& entry = m_layoutList.back();
+        m_layoutBytes -= entry.second.bytes;
+        releaseAtlas(entry.second.refs);
+        m_layouts.erase(entry.first);
+        m_layoutList.pop_back();
+    }
+}
+
+void FontContext::setLayoutCacheSize(size_t _bytes) {
+
+    std::lock_guard<std::mutex> lock(m_layoutMutex);
+
+    m_layoutCacheBytes = _bytes;
+    trimLayoutCache(0);
+}
+
+void FontContext::clearLayoutCache() {
+
+    std::lock_guard<std::mutex> lock(m_layoutMutex);
+
+    for (auto& entry : m_layoutList) {
+        releaseAtlas(entry.second.refs);
+    }
+    m_layouts.clear();
+    m_layoutList.clear();
+    m_layoutBytes = 0;
+}
+
+bool FontContext::layoutText(TextStyle::Parameters& _params, const icu::UnicodeString& _text,
+                             std::vector<GlyphQuad>& _quads, std::bitset<max_textures>& _refs,
+                             glm::vec2& _size, TextRange& _textRanges) {
 
     std::array<bool, 3> alignments = {};
     if (_params.align != TextLabelProperty::Align::none) {
@@ -176,6 +491,42 @@ bool FontContext::layoutText(TextStyle::Parameters& _params, const icu::UnicodeS
         }
     }
 
+    LayoutKey key{ _text, _params.font, _params.fontScale, _params.lineSpacing,
+                   _params.wordWrap ? _params.maxLineWidth : 0,
+                   _params.wordWrap ? _params.maxLines : 0,
+                   alignments };
+
+    if (getCachedLayout(key, _quads, _refs, _size, _textRanges)) {
+        s_layoutHits++;
+        return true;
+    }
+    s_layoutMisses++;
+
+    std::unique_lock<std::mutex> fontLock(m_fontMutex);
+
+    alfons::LineLayout line = m_shaper.shapeICU(_params.font, _text, MIN_LINE_WIDTH,
+                                                _params.wordWrap ? _params.maxLineWidth : 0);
+
+    if ((line.missingGlyphs() || line.shapes().size() == 0) && addFallbacks(_text)) {
+        line = m_shaper.shapeICU(_params.font, _text, MIN_LINE_WIDTH,
+                                 _params.wordWrap ? _params.maxLineWidth : 0);
+    }
+
+    if (line.missingGlyphs() || line.shapes().size() == 0) {
+        // Nothing to do!
+        return false;
+    }
+
+    line.setScale(_params.fontScale);
+
+    // m_batch.drawShapeRange() calls FontContext's TextureCallback for new glyphs
+    // and MeshCallback (drawGlyph) for vertex quads of each glyph in LineLayout.
+
+    m_scratch.quads = &_quads;
+
+    size_t quadsStart = _quads.size();
+    alfons::LineMetrics metrics;
+
     if (_params.wordWrap) {
         m_textWrapper.clearWraps();
 
@@ -234,9 +585,13 @@ bool FontContext::layoutText(TextStyle::Parameters& _params, const icu::UnicodeS
         _textRanges[2] = Range(rangeEnd, 0);
     }
 
-    auto it = _quads.begin() + quadsStart;
-    if (it == _quads.end()) {
+    std::vector<NewGlyph> newGlyphs;
+    std::swap(newGlyphs, m_newGlyphs);
+
+    if (_quads.size() == quadsStart) {
         // No glyphs added
+        fontLock.unlock();
+        queueGlyphs(std::move(newGlyphs));
         return false;
     }
 
@@ -245,34 +600,60 @@ bool FontContext::layoutText(TextStyle::Parameters& _params, const icu::UnicodeS
     float height = metrics.aabb.w - metrics.aabb.y;
     _size = glm::vec2(width, height);
 
-    // Offset to center all glyphs around 0/0
-    glm::vec2 offset((metrics.aabb.x + width * 0.5) * TextVertex::position_scale,
-                     (metrics.aabb.y + height * 0.5) * TextVertex::position_scale);
+    Layout layout;
+    layout.size = _size;
 
     {
+        // References must be held before m_fontMutex is released,
+        // otherwise another thread could clear the atlas.
         std::lock_guard<std::mutex> lock(m_textureMutex);
-        for (; it != _quads.end(); ++it) {
+        for (auto it = _quads.begin() + quadsStart; it != _quads.end(); ++it) {
 
             if (!_refs[it->atlas]) {
                 _refs[it->atlas] = true;
                 m_atlasRefCount[it->atlas] += 1;
             }
 
-            it->quad[0].pos -= offset;
-            it->quad[1].pos -= offset;
-            it->quad[2].pos -= offset;
-            it->quad[3].pos -= offset;
+            // Reference held by the cached layout
+            if (!layout.refs[it->atlas]) {
+                layout.refs[it->atlas] = true;
+                m_atlasRefCount[it->atlas] += 1;
+            }
         }
 
         // Clear unused textures
         for (size_t i = 0; i < m_textures.size(); i++) {
-            if (m_atlasRefCount[i] == 0) {
+            if (m_atlasRefCount[i] == 0 && m_pendingGlyphs[i] == 0) {
                 m_atlas.clear(i);
+                std::lock_guard<std::mutex> atlasLock(m_atlasMutex[i]);
                 std::memset(m_textures[i]->buffer(), 0, GlyphTexture::size * GlyphTexture::size);
             }
         }
     }
 
+    fontLock.unlock();
+
+    // Distance fields are built on the ThreadPool while the layout proceeds,
+    // only the copy into the texture is synchronized per atlas.
+    queueGlyphs(std::move(newGlyphs));
+
+    // Offset to center all glyphs around 0/0
+    glm::vec2 offset((metrics.aabb.x + width * 0.5) * TextVertex::position_scale,
+                     (metrics.aabb.y + height * 0.5) * TextVertex::position_scale);
+
+    for (auto it = _quads.begin() + quadsStart; it != _quads.end(); ++it) {
+        it->quad[0].pos -= offset;
+        it->quad[1].pos -= offset;
+        it->quad[2].pos -= offset;
+        it->quad[3].pos -= offset;
+    }
+
+    layout.quads.assign(_quads.begin() + quadsStart, _quads.end());
+    for (size_t i = 0; i < 3; i++) {
+        layout.textRanges[i] = Range(_textRanges[i].start - int(quadsStart), _textRanges[i].length);
+    }
+    cacheLayout(std::move(key), std::move(layout));
+
     return true;
 }
 
@@ -287,8 +668,54 @@ void FontContext::addFont(const FontDescription& _ft, alfons::InputSource _sourc
             font->addFace(m_alfons.addFontFace(_source, s_fontRasterSizes[i]));
 
             // add fallbacks from default font
-            if (m_font[i]) { font->addFaces(*m_font[i]); }
+            if (m_font[i]) {
+                font->addFaces(*m_font[i]);
+                addFallbackUser(font, i);
+            }
+        }
+    }
+
+    // Layouts may use glyphs of the new faces now
+    clearLayoutCache();
+}
+
+bool FontContext::addFallbacks(const icu::UnicodeString& _text) {
+
+    bool added = false;
+
+    for (int32_t i = 0; i < _text.length(); i = _text.moveIndex32(i, 1)) {
+        UChar32 c = _text.char32At(i);
+        if (c < 0x20) { continue; }
+
+        bool covered = false;
+        LazyFallback* fallback = nullptr;
+        for (auto& lazy : m_lazyFallbacks) {
+            if (!lazy.coverage.covers(c)) { continue; }
+            if (lazy.added) {
+                covered = true;
+                break;
+            }
+            if (!fallback) { fallback = &lazy; }
         }
+        if (covered || !fallback) { continue; }
+
+        LOGD("Adding fallback font for U+%04X", c);
+
+        for (size_t j = 0; j < s_fontRasterSizes.size(); j++) {
+            auto face = m_alfons.addFontFace(fallback->source, s_fontRasterSizes[j]);
+            m_font[j]->addFace(face);
+            for (auto& font : m_fallbackUsers[j]) { font->addFace(face); }
+        }
+        fallback->added = true;
+        added = true;
+    }
+    return added;
+}
+
+void FontContext::addFallbackUser(std::shared_ptr<alfons::Font> _font, size_t _sizeIndex) {
+    auto& users = m_fallbackUsers[_sizeIndex];
+    if (std::find(users.begin(), users.end(), _font) == users.end()) {
+        users.push_back(std::move(_font));
     }
 }
 
@@ -299,6 +726,28 @@ void FontContext::releaseFonts() {
     m_alfons.unload();
 }
 
+void FontContext::getMemoryUsage(MemoryUsage& _usage) {
+    {
+        std::lock_guard<std::mutex> lock(m_textureMutex);
+        for (auto& texture : m_textures) {
+            _usage.cpuBytes[MemoryUsage::glyph_atlases] += texture->cpuBytes();
+            _usage.gpuBytes[MemoryUsage::glyph_atlases] += texture->gpuBytes();
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_layoutMutex);
+        _usage.cpuBytes[MemoryUsage::font_cache] += m_layoutBytes;
+    }
+    std::lock_guard<std::mutex> lock(m_fieldMutex);
+    for (const auto& field : m_glyphFields) {
+        _usage.cpuBytes[MemoryUsage::font_cache] += field.second.size();
+    }
+}
+
+void FontContext::releaseMemory() {
+    clearLayoutCache();
+}
+
 void FontContext::ScratchBuffer::drawGlyph(const alfons::Rect& q, const alfons::AtlasGlyph& atlasGlyph) {
     if (atlasGlyph.atlas >= max_textures) { return; }
 
@@ -368,6 +817,7 @@ std::shared_ptr<alfons::Font> FontContext::getFont(const std::string& _family, c
     // Add fallbacks from default font.
     if (m_font[sizeIndex]) {
         font->addFaces(*m_font[sizeIndex]);
+        addFallbackUser(font, sizeIndex);
     }
 
     return font;
@@ -3,6 +3,7 @@
 #include "gl/glyphTexture.h"
 #include "labels/textLabel.h"
 #include "style/textStyle.h"
+#include "text/fontCoverage.h"
 #include "text/textUtil.h"
 
 #include "alfons/alfons.h"
@@ -12,11 +13,18 @@
 #include "alfons/inputSource.h"
 #include "alfons/textBatch.h"
 #include "alfons/textShaper.h"
+#include <atomic>
 #include <bitset>
+#include <condition_variable>
+#include <deque>
+#include <list>
 #include <mutex>
+#include <unordered_map>
 
 namespace Tangram {
 
+struct MemoryUsage;
+
 struct FontMetrics {
     float ascender, descender, lineHeight;
 };
@@ -47,19 +55,36 @@ public:
 
     static constexpr int max_textures = 64;
 
+    // Bytes of glyph quads kept in the layout cache
+    static constexpr size_t layout_cache_bytes = 1024 * 1024;
+
+    struct LayoutCacheStats {
+        // Layouts copied from the cache
+        size_t hits = 0;
+        // Layouts shaped and drawn with alfons
+        size_t misses = 0;
+    };
+
+    // Totals of all FontContexts
+    static LayoutCacheStats layoutCacheStats();
+
     FontContext(Platform& _platform);
-    virtual ~FontContext() {}
+
+    // Waits for scheduled rasterization jobs
+    virtual ~FontContext();
 
     void loadFonts();
 
-    /* Synchronized on m_mutex on tile-worker threads
+    /* Synchronized on m_fontMutex on tile-worker threads
      * Called from alfons when a texture atlas needs to be created
      * Triggered from TextStyleBuilder::prepareLabel
      */
     void addTexture(alfons::AtlasID id, uint16_t width, uint16_t height) override;
 
-    /* Synchronized on m_mutex, called tile-worker threads
-     * Called from alfons when a glyph needs to be added the the atlas identified by id
+    /* Synchronized on m_fontMutex, called tile-worker threads
+     * Called from alfons when a glyph needs to be added the the atlas identified by id.
+     * Only records the glyph bitmap, its distance field is built by a rasterization
+     * job after m_fontMutex is released.
      * Triggered from TextStyleBuilder::prepareLabel
      */
     void addGlyph(alfons::AtlasID id, uint16_t gx, uint16_t gy, uint16_t gw, uint16_t gh,
@@ -67,6 +92,12 @@ public:
 
     void releaseAtlas(std::bitset<max_textures> _refs);
 
+    /* Wait until the glyphs in the atlases of _refs are rasterized. Queued
+     * rasterization jobs are run by the calling thread meanwhile.
+     * Called before glyph quads are handed over for rendering.
+     */
+    void waitForGlyphs(const std::bitset<max_textures>& _refs);
+
     /* Update all textures batches, uploads the data to the GPU */
     void updateTextures(RenderState& rs);
 
@@ -82,6 +113,11 @@ public:
 
     float maxStrokeWidth() { return m_sdfRadius; }
 
+    /* Appends the glyph quads of _text to _quads and adds the used atlases to _refs.
+     * Layouts of repeated strings are copied from an LRU cache, which holds a
+     * reference on the atlases of its layouts so that the glyphs stay valid.
+     * New glyphs only reserve their atlas region, see waitForGlyphs().
+     */
     bool layoutText(TextStyle::Parameters& _params, const icu::UnicodeString& _text,
                     std::vector<GlyphQuad>& _quads, std::bitset<max_textures>& _refs,
                     glm::vec2& _bbox, TextRange& _textRanges);
@@ -94,27 +130,156 @@ public:
 
     void addFont(const FontDescription& _ft, alfons::InputSource _source);
 
+    /* Load pre-baked glyph distance fields, returns false when _data is invalid.
+     * Glyphs whose coverage bitmap matches a baked glyph skip building the
+     * distance field. Fields are only used with the SDF radius they were built for.
+     */
+    bool addGlyphFields(const std::vector<char>& _data);
+
+    /* Keep the distance fields of glyphs built from now on, so that they can be
+     * baked with glyphFieldsData()
+     */
+    void recordGlyphFields(bool _record) { m_recordGlyphFields = _record; }
+
+    /* Limit the bytes of glyph quads kept in the layout cache. Cached layouts hold
+     * their atlas pages, so a smaller cache lets unused pages be cleared sooner.
+     */
+    void setLayoutCacheSize(size_t _bytes);
+
+    /* Serialize the loaded and recorded distance fields, in the format read
+     * by addGlyphFields()
+     */
+    std::vector<char> glyphFieldsData();
+
     void setPixelScale(float _scale);
 
     void releaseFonts();
 
+    /* Adds the memory of the glyph atlas, the layout cache and the glyph fields to _usage */
+    void getMemoryUsage(MemoryUsage& _usage);
+
+    /* Clears the layout cache */
+    void releaseMemory();
+
 private:
 
+    // Parameters that determine the glyph quads of a layout
+    struct LayoutKey {
+        icu::UnicodeString text;
+        std::shared_ptr<alfons::Font> font;
+        float fontScale;
+        float lineSpacing;
+        // Zero when word wrap is disabled
+        uint32_t maxLineWidth;
+        uint32_t maxLines;
+        std::array<bool, 3> alignments;
+
+        bool operator==(const LayoutKey& _other) const;
+    };
+
+    struct LayoutKeyHash {
+        size_t operator()(const LayoutKey& _key) const;
+    };
+
+    // Glyph quads centered around 0/0 with text ranges relative to the first quad
+    struct Layout {
+        std::vector<GlyphQuad> quads;
+        TextRange textRanges;
+        glm::vec2 size;
+        std::bitset<max_textures> refs;
+        size_t bytes;
+    };
+
+    using LayoutEntry = std::pair<LayoutKey, Layout>;
+
+    // Glyph with a reserved region in an atlas, waiting for its distance field
+    struct NewGlyph {
+        alfons::AtlasID atlas;
+        uint16_t x, y, width, height;
+        // Padded coverage bitmap
+        std::vector<unsigned char> bitmap;
+    };
+
+    // Queue _glyphs as one batch and schedule a job on the ThreadPool to rasterize it
+    void queueGlyphs(std::vector<NewGlyph>&& _glyphs);
+
+    // Rasterize the next queued batch, returns false when the queue is empty
+    bool rasterizeNextBatch();
+
+    // Build the distance fields of _glyphs and copy them into their atlases,
+    // locking only the atlas that is written
+    void rasterizeGlyphs(const std::vector<NewGlyph>& _glyphs);
+
+    // Key of the distance field of _glyph with the current SDF radius
+    uint64_t glyphFieldKey(const NewGlyph& _glyph) const;
+
+    bool getCachedLayout(const LayoutKey& _key, std::vector<GlyphQuad>& _quads,
+                         std::bitset<max_textures>& _refs, glm::vec2& _size,
+                         TextRange& _textRanges);
+
+    // Takes over the atlas references of _layout
+    void cacheLayout(LayoutKey _key, Layout _layout);
+
+    // Release the least recently used layouts above m_layoutCacheBytes, keeping at
+    // least _keep layouts. Synchronized on m_layoutMutex.
+    void trimLayoutCache(size_t _keep);
+
+    void clearLayoutCache();
+
+    /* Add the fallbacks that cover characters of _text to the default fonts and
+     * the fonts that use their faces, returns whether any was added.
+     * Synchronized on m_fontMutex.
+     */
+    bool addFallbacks(const icu::UnicodeString& _text);
+
+    // Fonts that use the faces of m_font[_sizeIndex], synchronized on m_fontMutex
+    void addFallbackUser(std::shared_ptr<alfons::Font> _font, size_t _sizeIndex);
+
+    // System fallback font whose face is only added once a glyph needs it
+    struct LazyFallback {
+        alfons::InputSource source;
+        FontCoverage coverage;
+        bool added = false;
+    };
+
     static const std::vector<float> s_fontRasterSizes;
 
     float m_sdfRadius;
     ScratchBuffer m_scratch;
-    std::vector<unsigned char> m_sdfBuffer;
 
+    // Guards shaping, alfons' glyph atlas and m_newGlyphs
     std::mutex m_fontMutex;
+    // Guards the number of textures, atlas references and pending glyphs
     std::mutex m_textureMutex;
+    // Guards the pixels of each glyph texture
+    std::array<std::mutex, max_textures> m_atlasMutex;
 
     std::array<int, max_textures> m_atlasRefCount = {{0}};
+
+    // Glyphs added to the atlas during the current layoutText() call
+    std::vector<NewGlyph> m_newGlyphs;
+
+    // Glyphs per atlas that are reserved but not yet rasterized
+    std::array<int, max_textures> m_pendingGlyphs = {{0}};
+    std::condition_variable m_glyphsRasterized;
+
+    // Distance fields by glyphFieldKey(), baked or recorded in this session
+    std::mutex m_fieldMutex;
+    std::unordered_map<uint64_t, std::vector<unsigned char>> m_glyphFields;
+    std::atomic<bool> m_recordGlyphFields{false};
+
+    // Batches of glyphs waiting for rasterization, guarded by m_textureMutex
+    std::deque<std::vector<NewGlyph>> m_rasterQueue;
+    // Rasterization jobs scheduled on the ThreadPool, guarded by m_textureMutex
+    int m_rasterJobs = 0;
     alfons::GlyphAtlas m_atlas;
 
     alfons::FontManager m_alfons;
     std::array<std::shared_ptr<alfons::Font>, 3> m_font;
 
+    std::vector<LazyFallback> m_lazyFallbacks;
+    std::array<std::vector<std::shared_ptr<alfons::Font>>, 3> m_fallbackUsers;
+
     std::vector<std::unique_ptr<GlyphTexture>> m_textures;
 
     // TextShaper to create <LineLayout> for a given text and Font
@@ -128,6 +293,13 @@ private:
 
     Platform& m_platform;
 
+    // Synchronized on m_layoutMutex, most recently used layouts first
+    std::mutex m_layoutMutex;
+    std::list<LayoutEntry> m_layoutList;
+    std::unordered_map<LayoutKey, std::list<LayoutEntry>::iterator, LayoutKeyHash> m_layouts;
+    size_t m_layoutBytes = 0;
+    size_t m_layoutCacheBytes = layout_cache_bytes;
+
 };
 
 }
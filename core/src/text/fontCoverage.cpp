@@ -0,0 +1,191 @@
+#include "text/fontCoverage.h"
+
+#include "log.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+// Upper limit for the size of a cmap table
+#define MAX_CMAP_BYTES (16 * 1024 * 1024)
+
+namespace Tangram {
+
+static uint16_t readU16(const uint8_t* _data) {
+    return uint16_t(_data[0] << 8 | _data[1]);
+}
+
+static uint32_t readU32(const uint8_t* _data) {
+    return uint32_t(_data[0]) << 24 | uint32_t(_data[1]) << 16 | uint32_t(_data[2]) << 8 | _data[3];
+}
+
+static bool readAt(std::ifstream& _file, size_t _offset, uint8_t* _data, size_t _size) {
+    _file.seekg(_offset);
+    _file.read(reinterpret_cast<char*>(_data), _size);
+    return bool(_file);
+}
+
+bool FontCoverage::load(const std::string& _path) {
+    m_ranges.clear();
+
+    std::ifstream file(_path, std::ios::binary);
+    if (!file) { return false; }
+
+    uint8_t header[12];
+    if (!readAt(file, 0, header, sizeof(header))) { return false; }
+
+    size_t fontOffset = 0;
+    if (readU32(header) == 0x74746366) { // 'ttcf'
+        uint8_t offset[4];
+        if (readU32(header + 8) == 0 || !readAt(file, 12, offset, 4)) { return false; }
+        fontOffset = readU32(offset);
+        if (!readAt(file, fontOffset, header, sizeof(header))) { return false; }
+    }
+
+    uint16_t numTables = readU16(header + 4);
+    std::vector<uint8_t> records(numTables * 16);
+    if (!readAt(file, fontOffset + 12, records.data(), records.size())) { return false; }
+
+    std::vector<uint8_t> cmap;
+    for (size_t i = 0; i < numTables; i++) {
+        const uint8_t* record = &records[i * 16];
+        if (readU32(record) != 0x636d6170) { continue; } // 'cmap'
+
+        uint32_t length = readU32(record + 12);
+        if (length < 4 || length > MAX_CMAP_BYTES) { return false; }
+
+        cmap.resize(length);
+        if (!readAt(file, readU32(record + 8), cmap.data(), length)) { return false; }
+        break;
+    }
+    if (cmap.empty()) { return false; }
+
+    // Prefer the full Unicode subtable over the BMP subtable
+    size_t bmpOffset = 0, fullOffset = 0;
+    uint16_t numSubtables = readU16(&cmap[2]);
+    for (size_t i = 0; i < numSubtables && 4 + i * 8 + 8 <= cmap.size(); i++) {
+        const uint8_t* record = &cmap[4 + i * 8];
+        uint16_t platform = readU16(record);
+        uint16_t encoding = readU16(record + 2);
+        uint32_t offset = readU32(record + 4);
+        if (offset + 2 > cmap.size()) { continue; }
+
+        bool unicode = platform == 0 || (platform == 3 && (encoding == 1 || encoding == 10));
+        if (!unicode) { continue; }
+
+        uint16_t format = readU16(&cmap[offset]);
+        if (format == 12 && !fullOffset) { fullOffset = offset; }
+        if (format == 4 && !bmpOffset) { bmpOffset = offset; }
+    }
+
+    bool loaded = false;
+    if (fullOffset) {
+        loaded = loadFormat12(cmap, fullOffset);
+    } else if (bmpOffset) {
+        loaded = loadFormat4(cmap, bmpOffset);
+    }
+    if (!loaded) {
+        LOGD("No supported character map in font: %s", _path.c_str());
+        m_ranges.clear();
+    }
+    return loaded;
+}
+
+bool FontCoverage::loadFormat4(const std::vector<uint8_t>& _cmap, size_t _offset) {
+    if (_offset + 14 > _cmap.size()) { return false; }
+
+    size_t segCount = readU16(&_cmap[_offset + 6]) / 2;
+    size_t endCodes = _offset + 14;
+    size_t startCodes = endCodes + segCount * 2 + 2;
+    size_t idDeltas = startCodes + segCount * 2;
+    size_t idRangeOffsets = idDeltas + segCount * 2;
+    if (idRangeOffsets + segCount * 2 > _cmap.size()) { return false; }
+
+    for (size_t i = 0; i < segCount; i++) {
+        uint32_t end = readU16(&_cmap[endCodes + i * 2]);
+        uint32_t start = readU16(&_cmap[startCodes + i * 2]);
+        uint16_t delta = readU16(&_cmap[idDeltas + i * 2]);
+        size_t rangeOffset = readU16(&_cmap[idRangeOffsets + i * 2]);
+
+        // The last segment only maps 0xFFFF to the missing glyph
+        if (start == 0xFFFF || start > end) { continue; }
+
+        if (rangeOffset == 0) {
+            // Glyph ids are the codepoints shifted by delta, skip the one that maps to 0
+            uint32_t missing = uint16_t(0x10000 - delta);
+            if (missing < start || missing > end) {
+                addRange(start, end);
+            } else {
+                if (missing > start) { addRange(start, missing - 1); }
+                if (missing < end) { addRange(missing + 1, end); }
+            }
+            continue;
+        }
+
+        // Glyph ids are looked up in the glyph id array
+        size_t glyphIds = idRangeOffsets + i * 2 + rangeOffset;
+        for (uint32_t c = start; c <= end; c++) {
+            size_t pos = glyphIds + (c - start) * 2;
+            if (pos + 2 > _cmap.size()) { break; }
+            if (readU16(&_cmap[pos]) != 0) { addRange(c, c); }
+        }
+    }
+    return true;
+}
+
+bool FontCoverage::loadFormat12(const std::vector<uint8_t>& _cmap, size_t _offset) {
+    if (_offset + 16 > _cmap.size()) { return false; }
+
+    size_t numGroups = readU32(&_cmap[_offset + 12]);
+    if (numGroups > (_cmap.size() - _offset - 16) / 12) { return false; }
+
+    for (size_t i = 0; i < numGroups; i++) {
+        const uint8_t* group = &_cmap[_offset + 16 + i * 12];
+        uint32_t start = readU32(group);
+        uint32_t end = readU32(group + 4);
+        uint32_t glyph = readU32(group + 8);
+
+        // Skip the codepoint that maps to the missing glyph
+        if (glyph == 0) { start++; }
+        if (start <= end) { addRange(start, end); }
+    }
+    return true;
+}
+
+void FontCoverage::addRange(uint32_t _first, uint32_t _last) {
+    if (m_ranges.empty() || _first > m_ranges.back().second + 1) {
+        if (m_ranges.empty() || _first > m_ranges.back().first) {
+            // Ranges mostly arrive in order
+            m_ranges.emplace_back(_first, _last);
+            return;
+        }
+    } else if (_first >= m_ranges.back().first) {
+        m_ranges.back().second = std::max(m_ranges.back().second, _last);
+        return;
+    }
+
+    m_ranges.emplace_back(_first, _last);
+    std::sort(m_ranges.begin(), m_ranges.end());
+
+    // Merge overlapping and adjacent ranges
+    size_t merged = 0;
+    for (size_t i = 1; i < m_ranges.size(); i++) {
+        if (m_ranges[i].first <= m_ranges[merged].second + 1) {
+            m_ranges[merged].second = std::max(m_ranges[merged].second, m_ranges[i].second);
+        } else {
+            m_ranges[++merged] = m_ranges[i];
+        }
+    }
+    m_ranges.resize(merged + 1);
+}
+
+bool FontCoverage::covers(uint32_t _codepoint) const {
+    auto it = std::upper_bound(m_ranges.begin(), m_ranges.end(), _codepoint,
+                               [](uint32_t _c, const std::pair<uint32_t, uint32_t>& _range) {
+                                   return _c < _range.first;
+                               });
+    if (it == m_ranges.begin()) { return false; }
+    return _codepoint <= std::prev(it)->second;
+}
+
+}
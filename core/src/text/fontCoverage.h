@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Tangram {
+
+/* Codepoints that a font file has glyphs for
+ *
+ * Only the table directory and the character map of the font are read, so
+ * that fallback fonts can be picked for a text without loading their faces.
+ * Supports TrueType and OpenType fonts with a Unicode cmap subtable of format
+ * 4 or 12. Of font collections the first font is read.
+ */
+class FontCoverage {
+
+public:
+
+    /* Read the character map of the font at _path, returns false when the file
+     * can not be read or has no supported character map
+     */
+    bool load(const std::string& _path);
+
+    bool covers(uint32_t _codepoint) const;
+
+    bool empty() const { return m_ranges.empty(); }
+
+private:
+
+    void addRange(uint32_t _first, uint32_t _last);
+
+    bool loadFormat4(const std::vector<uint8_t>& _cmap, size_t _offset);
+    bool loadFormat12(const std::vector<uint8_t>& _cmap, size_t _offset);
+
+    // Sorted, disjoint ranges of the first and last covered codepoint
+    std::vector<std::pair<uint32_t, uint32_t>> m_ranges;
+};
+
+}
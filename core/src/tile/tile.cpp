@@ -1,12 +1,16 @@
 #include "tile/tile.h"
 
+#include "gl/renderState.h"
+#include "gl/texture.h"
 #include "labels/labelSet.h"
+#include "selection/featureIndex.h"
 #include "style/style.h"
 #include "tile/tileID.h"
 #include "util/mapProjection.h"
 #include "view/view.h"
 
 #include "glm/gtc/matrix_transform.hpp"
+#include <algorithm>
 
 namespace Tangram {
 
@@ -33,6 +37,7 @@ Tile::~Tile() {}
 
 void Tile::initGeometry(uint32_t _size) {
     m_geometry.resize(_size);
+    m_meshBounds.resize(_size);
 }
 
 void Tile::update(float _dt, const View& _view) {
@@ -46,7 +51,13 @@ void Tile::update(float _dt, const View& _view) {
     m_modelMatrix[3][0] = static_cast<float>(originRelativeMeters.x);
     m_modelMatrix[3][1] = static_cast<float>(originRelativeMeters.y);
 
-    m_mvp = _view.getViewProjectionMatrix() * m_modelMatrix;
+    // The model matrix only scales and translates
+    const glm::mat4& viewProj = _view.getViewProjectionMatrix();
+    float scale = m_modelMatrix[0][0];
+    m_mvp[0] = viewProj[0] * scale;
+    m_mvp[1] = viewProj[1] * scale;
+    m_mvp[2] = viewProj[2] * scale;
+    m_mvp[3] = viewProj[0] * m_modelMatrix[3][0] + viewProj[1] * m_modelMatrix[3][1] + viewProj[3];
 }
 
 void Tile::resetState() {
@@ -62,8 +73,80 @@ void Tile::setMesh(const Style& _style, std::unique_ptr<StyledMesh> _mesh) {
     size_t id = _style.getID();
     if (id >= m_geometry.size()) {
         m_geometry.resize(id+1);
+        m_meshBounds.resize(id+1);
     }
     m_geometry[_style.getID()] = std::move(_mesh);
+    m_meshBounds[_style.getID()] = {};
+}
+
+const MeshBounds& Tile::getMeshBounds(const Style& _style) const {
+    static const MeshBounds NONE{};
+    if (_style.getID() >= m_meshBounds.size()) { return NONE; }
+
+    return m_meshBounds[_style.getID()];
+}
+
+void Tile::setMeshBounds(const Style& _style, const MeshBounds& _bounds) {
+    if (_style.getID() >= m_meshBounds.size()) { return; }
+
+    m_meshBounds[_style.getID()] = _bounds;
+}
+
+bool Tile::isMeshVisible(const Style& _style) const {
+    return !getMeshBounds(_style).isOutsideFrustum(m_mvp);
+}
+
+void Tile::addMeshes(Tile& _tile) {
+    if (_tile.m_geometry.size() > m_geometry.size()) {
+        m_geometry.resize(_tile.m_geometry.size());
+        m_meshBounds.resize(_tile.m_geometry.size());
+    }
+    for (size_t i = 0; i < _tile.m_geometry.size(); i++) {
+        if (_tile.m_geometry[i]) {
+            m_geometry[i] = std::move(_tile.m_geometry[i]);
+            m_meshBounds[i] = _tile.m_meshBounds[i];
+        }
+    }
+    for (auto& raster : _tile.m_rasters) {
+        m_rasters.push_back(std::move(raster));
+    }
+    _tile.m_rasters.clear();
+
+    m_selectionFeatures.merge(_tile.m_selectionFeatures);
+    m_selectionFeatures.shrink();
+
+    // The index of both passes of a progressive build. Queries may still
+    // hold the index of this tile, so a new one is built.
+    if (m_featureIndex && _tile.m_featureIndex) {
+        auto index = std::make_shared<FeatureIndex>(*m_featureIndex);
+        index->append(*_tile.m_featureIndex);
+        index->build();
+        m_featureIndex = std::move(index);
+    } else {
+        m_featureIndex = nullptr;
+    }
+
+    m_uploaded = m_uploaded && _tile.m_uploaded;
+    m_buildTime = std::max(m_buildTime, _tile.m_buildTime);
+    m_memoryUsage = 0;
+}
+
+void Tile::takeMeshes(Tile& _tile, const std::vector<bool>& _skipStyles) {
+    initGeometry(std::max(m_geometry.size(), _tile.m_geometry.size()));
+
+    for (size_t i = 0; i < _tile.m_geometry.size(); i++) {
+        if (!_tile.m_geometry[i] || (i < _skipStyles.size() && _skipStyles[i])) { continue; }
+
+        // The programs of this scene may have other attribute locations
+        _tile.m_geometry[i]->releaseVaos();
+        m_geometry[i] = std::move(_tile.m_geometry[i]);
+        m_meshBounds[i] = _tile.m_meshBounds[i];
+    }
+
+    m_uploaded = _tile.m_uploaded;
+    m_contentHash = _tile.m_contentHash;
+    m_buildTime = _tile.m_buildTime;
+    m_memoryUsage = 0;
 }
 
 const std::unique_ptr<StyledMesh>& Tile::getMesh(const Style& _style) const {
@@ -73,16 +156,42 @@ const std::unique_ptr<StyledMesh>& Tile::getMesh(const Style& _style) const {
     return m_geometry[_style.getID()];
 }
 
-void Tile::setSelectionFeatures(const fastmap<uint32_t, std::shared_ptr<Properties>> _selectionFeatures) {
-    m_selectionFeatures = _selectionFeatures;
+void Tile::upload(RenderState& _rs) {
+    for (auto& entry : m_geometry) {
+        if (entry) { entry->uploadGeometry(_rs); }
+    }
+
+    // Raster textures may take several frames
+    bool uploaded = true;
+    if (!m_rasters.empty()) {
+        auto unit = _rs.nextAvailableTextureUnit();
+        for (auto& raster : m_rasters) {
+            if (raster.texture && !raster.texture->uploadSlice(_rs, unit)) {
+                uploaded = false;
+            }
+        }
+        _rs.releaseTextureUnit();
+    }
+    m_uploaded = uploaded;
+}
+
+void Tile::setSelectionFeatures(SelectionFeatures _selectionFeatures) {
+    m_selectionFeatures = std::move(_selectionFeatures);
+    m_selectionFeatures.shrink();
 }
 
 std::shared_ptr<Properties> Tile::getSelectionFeature(uint32_t _id) const {
-    auto it = m_selectionFeatures.find(_id);
-    if (it != m_selectionFeatures.end()) {
-        return it->second;
+    return m_selectionFeatures.get(_id);
+}
+
+void Tile::getMeshMemoryUsage(size_t& _cpuBytes, size_t& _gpuBytes) const {
+    for (auto& entry : m_geometry) {
+        if (entry) {
+            size_t cpuBytes = entry->cpuBufferSize();
+            _cpuBytes += cpuBytes;
+            _gpuBytes += entry->bufferSize() - cpuBytes;
+        }
     }
-    return nullptr;
 }
 
 size_t Tile::getMemoryUsage() const {
@@ -97,6 +206,7 @@ size_t Tile::getMemoryUsage() const {
                 m_memoryUsage += raster.texture->bufferSize();
             }
         }
+        m_memoryUsage += m_selectionFeatures.memoryUsage();
     }
 
     return m_memoryUsage;
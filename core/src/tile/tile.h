@@ -1,8 +1,10 @@
 #pragma once
 
 #include "gl/texture.h"
+#include "selection/selectionFeatures.h"
 #include "tile/tileID.h"
 #include "util/fastmap.h"
+#include "util/geom.h"
 #include "util/types.h"
 
 #include "glm/mat4x4.hpp"
@@ -14,7 +16,9 @@
 
 namespace Tangram {
 
+class FeatureIndex;
 class MapProjection;
+class RenderState;
 struct Properties;
 class Style;
 class View;
@@ -59,6 +63,19 @@ public:
 
     const glm::mat4& mvp() const { return m_mvp; }
 
+    /* Model and model-view-projection matrices set by update() */
+    struct Transform {
+        glm::mat4 model;
+        glm::mat4 mvp;
+    };
+
+    Transform getTransform() const { return { m_modelMatrix, m_mvp }; }
+
+    void setTransform(const Transform& _transform) {
+        m_modelMatrix = _transform.model;
+        m_mvp = _transform.mvp;
+    }
+
     LngLat coordToLngLat(const glm::vec2& _tileCoord) const;
 
     void initGeometry(uint32_t _size);
@@ -67,12 +84,35 @@ public:
 
     void setMesh(const Style& _style, std::unique_ptr<StyledMesh> _mesh);
 
-    void setSelectionFeatures(const fastmap<uint32_t, std::shared_ptr<Properties>> _selectionFeatures);
+    /* Extent of the mesh of _style in tile units, reset by setMesh() */
+    const MeshBounds& getMeshBounds(const Style& _style) const;
+
+    void setMeshBounds(const Style& _style, const MeshBounds& _bounds);
+
+    /* Whether the mesh of _style may be in the view frustum of the MVP set by update() */
+    bool isMeshVisible(const Style& _style) const;
+
+    /* Move the meshes, rasters and selection features of _tile, built for other
+     * styles of the same tile, into this tile */
+    void addMeshes(Tile& _tile);
 
+    /* Move the meshes of _tile, built by a previous scene with the same styles,
+     * into this tile, but those of _skipStyles */
+    void takeMeshes(Tile& _tile, const std::vector<bool>& _skipStyles);
+
+    void setSelectionFeatures(SelectionFeatures _selectionFeatures);
+
+    /* Returns new Properties of the feature with selection color _id, or null */
     std::shared_ptr<Properties> getSelectionFeature(uint32_t _id) const;
 
     const auto& getSelectionFeatures() const { return m_selectionFeatures; }
 
+    /* Index of the interactive features of this tile, or null when they are
+     * not indexed. The index is not modified once it is set. */
+    void setFeatureIndex(std::shared_ptr<const FeatureIndex> _index) { m_featureIndex = std::move(_index); }
+
+    const std::shared_ptr<const FeatureIndex>& featureIndex() const { return m_featureIndex; }
+
     auto& rasters() { return m_rasters; }
     const auto& rasters() const { return m_rasters; }
 
@@ -81,17 +121,40 @@ public:
 
     void resetState();
 
-    /* Get the sum in bytes of static <Mesh>es */
+    /* Get the sum in bytes of static <Mesh>es and raster textures */
     size_t getMemoryUsage() const;
 
+    /* Get the sum in bytes of static <Mesh>es in memory and in GL buffers. The
+     * memory of each mesh is freed when it is uploaded. */
+    void getMeshMemoryUsage(size_t& _cpuBytes, size_t& _gpuBytes) const;
+
     int64_t sourceGeneration() const { return m_sourceGeneration; }
 
+    /* Set when the tile is kept for a newer generation with the same data */
+    void setSourceGeneration(int64_t _generation) { m_sourceGeneration = _generation; }
+
+    /* Hash of the data the tile was built from, 0 when unknown */
+    uint64_t contentHash() const { return m_contentHash; }
+
+    void setContentHash(uint64_t _hash) { m_contentHash = _hash; }
+
     int32_t sourceID() const { return m_sourceId; }
 
     bool isProxy() const { return m_proxyState; }
 
+    /* Milliseconds spent parsing and building the tile */
+    float getBuildTime() const { return m_buildTime; }
+
+    void setBuildTime(float _ms) { m_buildTime = _ms; }
+
     void setProxyState(bool isProxy) { m_proxyState = isProxy; }
 
+    /* Upload the geometry of all meshes to GL buffers, and the next slices of
+     * the raster textures. The tile is uploaded once all of them are. */
+    void upload(RenderState& _rs);
+
+    bool isUploaded() const { return m_uploaded; }
+
 private:
 
     const TileID m_id;
@@ -102,10 +165,16 @@ private:
     const int32_t m_sourceId;
 
     /* State of the TileSource for which this tile was created */
-    const int64_t m_sourceGeneration;
+    int64_t m_sourceGeneration;
+
+    uint64_t m_contentHash = 0;
 
     bool m_proxyState = false;
 
+    bool m_uploaded = false;
+
+    float m_buildTime = 0;
+
     glm::dvec2 m_tileOrigin; // South-West corner of the tile in 2D projection space in meters (e.g. mercator meters)
 
     glm::mat4 m_modelMatrix; // Matrix relating tile-local coordinates to global projection space coordinates;
@@ -117,11 +186,14 @@ private:
 
     // Map of <Style>s and their associated <Mesh>es
     std::vector<std::unique_ptr<StyledMesh>> m_geometry;
+    std::vector<MeshBounds> m_meshBounds;
     std::vector<Raster> m_rasters;
 
     mutable size_t m_memoryUsage = 0;
 
-    fastmap<uint32_t, std::shared_ptr<Properties>> m_selectionFeatures;
+    SelectionFeatures m_selectionFeatures;
+
+    std::shared_ptr<const FeatureIndex> m_featureIndex;
 
 };
 
@@ -3,17 +3,39 @@
 #include "data/properties.h"
 #include "data/propertyItem.h"
 #include "data/tileSource.h"
+#include "debug/metrics.h"
+#include "debug/trace.h"
 #include "gl/mesh.h"
 #include "log.h"
 #include "scene/dataLayer.h"
 #include "scene/scene.h"
 #include "selection/featureSelection.h"
+#include "selection/featureState.h"
 #include "tile/tile.h"
+#include "tile/tileTask.h"
 #include "util/mapProjection.h"
+#include "util/threadPool.h"
 #include "view/view.h"
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
 namespace Tangram {
 
+// Minimum number of features in a tile to split building across layer builders
+static constexpr size_t MIN_FEATURES_PER_LAYER_BUILDER = 256;
+
+// Minimum number of features in a collection to evaluate JS filter functions in one batch
+static constexpr size_t MIN_FEATURES_PER_FILTER_BATCH = 16;
+
+// Number of features styled between checks for the cancellation of the task
+static constexpr size_t CANCEL_CHECK_FEATURES = 64;
+
+static std::atomic<size_t> s_scratchReused{0};
+static std::atomic<size_t> s_scratchAllocated{0};
+
 TileBuilder::TileBuilder(const Scene& _scene)
     : m_scene(_scene),
       m_styleContext(std::make_unique<StyleContext>()) {
@@ -28,24 +50,171 @@ void TileBuilder::init() {
     m_styleContext->initFunctions(m_scene);
 
     // Initialize StyleBuilders
-    for (const auto& style : m_scene.styles()) {
+    const auto& styles = m_scene.styles();
+    m_styleBuilder.clear();
+    m_styleBuilder.resize(styles.size());
+    m_deferredStyles.assign(styles.size(), nullptr);
+
+    for (const auto& style : styles) {
         if (auto builder = style->createBuilder()) {
-            m_styleBuilder[style->getName()] = std::move(builder);
+            // Layer builders leave styles which cannot be merged to their owner
+            if (m_isLayerBuilder && !builder->canMerge()) {
+                m_deferredStyles[style->getID()] = style.get();
+                continue;
+            }
+
+            m_styleBuilder[style->getID()] = std::move(builder);
         }
     }
+
+    // Resolve the style names of draw rules once, rules are matched by name ID
+    const auto& names = m_scene.drawRuleNames();
+    m_nameStyles.assign(names.size(), -1);
+    for (size_t i = 0; i < names.size(); i++) {
+        for (const auto& style : styles) {
+            if (style->getName() == names[i]) {
+                m_nameStyles[i] = style->getID();
+                break;
+            }
+        }
+    }
+
+    m_sourceLayers.clear();
+    for (const auto& datalayer : m_scene.layers()) {
+        auto& source = m_sourceLayers[datalayer.source()];
+        uint32_t position = source.layers.size();
+        source.layers.push_back(&datalayer);
+        for (const auto& collection : datalayer.collections()) {
+            auto& positions = source.collections[collection];
+            if (positions.empty() || positions.back() != position) {
+                positions.push_back(position);
+            }
+        }
+    }
+
+    if (m_isLayerBuilder) { return; }
+
+    uint32_t numLayerWorkers = m_scene.options().numLayerWorkers;
+    if (numLayerWorkers > 0) {
+        ThreadPool::shared().reserveThreads(m_scene.options().numTileWorkers + numLayerWorkers);
+    }
+
+    // Layer builders are initialized on first use
+    m_layerBuilders.clear();
+    for (uint32_t i = 0; i < numLayerWorkers; i++) {
+        auto builder = std::make_unique<TileBuilder>(m_scene);
+        builder->m_isLayerBuilder = true;
+        m_layerBuilders.push_back(std::move(builder));
+    }
+}
+
+TileBuilder::ScratchStats TileBuilder::scratchStats() {
+    ScratchStats stats;
+    stats.reusedBytes = s_scratchReused;
+    stats.allocatedBytes = s_scratchAllocated;
+    return stats;
+}
+
+size_t TileBuilder::scratchCapacity() const {
+    size_t bytes = 0;
+    for (auto& builder : m_styleBuilder) {
+        if (builder) { bytes += builder->scratchCapacity(); }
+    }
+    for (auto& builder : m_layerBuilders) {
+        bytes += builder->scratchCapacity();
+    }
+    return bytes;
+}
+
+bool TileBuilder::isCanceled() const {
+    return m_task && m_task->isCanceled();
 }
 
 StyleBuilder* TileBuilder::getStyleBuilder(const std::string& _name) {
-    auto it = m_styleBuilder.find(_name);
-    if (it == m_styleBuilder.end()) { return nullptr; }
+    return getStyleBuilder(getStyleId(-1, _name));
+}
+
+int TileBuilder::getStyleId(int _nameId, const std::string& _name) const {
+    if (_nameId >= 0 && size_t(_nameId) < m_nameStyles.size()) {
+        return m_nameStyles[_nameId];
+    }
+
+    // Style names that were not known when the scene was loaded
+    for (const auto& style : m_scene.styles()) {
+        if (style->getName() == _name) { return style->getID(); }
+    }
+    return -1;
+}
+
+const TileBuilder::SourceLayers* TileBuilder::getSourceLayers(const std::string& _name) const {
+    auto it = m_sourceLayers.find(_name);
+    if (it == m_sourceLayers.end()) { return nullptr; }
+
+    return &it->second;
+}
+
+FeatureFilter& TileBuilder::featureFilter(TileID _tileID, const TileSource& _source) {
+    m_styleContext->setZoom(_tileID.s);
+    m_layerFilter.source = getSourceLayers(_source.name());
+    return m_layerFilter;
+}
+
+bool TileBuilder::LayerFilter::beginLayer(const std::string& _name) {
+    m_layers.clear();
+
+    if (!source) { return false; }
+
+    if (_name.empty()) {
+        for (auto* datalayer : source->layers) {
+            if (datalayer->enabled()) { m_layers.push_back(datalayer); }
+        }
+    } else {
+        auto it = source->collections.find(_name);
+        if (it == source->collections.end()) { return false; }
+
+        for (auto position : it->second) {
+            auto* datalayer = source->layers[position];
+            if (datalayer->enabled()) { m_layers.push_back(datalayer); }
+        }
+    }
+    return !m_layers.empty();
+}
+
+bool TileBuilder::LayerFilter::accept(const Feature& _feature) {
+    auto& styleContext = *m_builder.m_styleContext;
+    styleContext.setFeature(_feature);
+
+    for (auto* layer : m_layers) {
+        if (layer->filterProgram().eval(_feature, styleContext)) { return true; }
+    }
+    return false;
+}
 
-    return it->second.get();
+void TileBuilder::deferRule(const Feature& _feature, const DrawRule& _rule, bool _isOutline) {
+
+    m_deferredRules.push_back({ &_feature, _rule, {}, _isOutline });
+    auto& deferred = m_deferredRules.back();
+
+    // Copy parameters that point into the reusable storage of m_ruleSet
+    for (size_t i = 0; i < StyleParamKeySize; i++) {
+        if (_rule.active[i] && m_ruleSet.isEvaluated(_rule.param(i).param)) {
+            deferred.evaluated.emplace_back(uint8_t(i), *_rule.param(i).param);
+        }
+    }
 }
 
 void TileBuilder::applyStyling(const Feature& _feature, const SceneLayer& _layer) {
 
+    auto stageStart = m_recordMetrics ? Metrics::Clock::now() : Metrics::Clock::time_point();
+    bool matched = m_ruleSet.match(_feature, _layer, *m_styleContext);
+    if (m_recordMetrics) {
+        auto now = Metrics::Clock::now();
+        m_stylingTime += now - stageStart;
+        stageStart = now;
+    }
+
     // If no rules matched the feature, return immediately
-    if (!m_ruleSet.match(_feature, _layer, *m_styleContext)) { return; }
+    if (!matched) { return; }
 
     uint32_t selectionColor = 0;
     bool added = false;
@@ -54,15 +223,21 @@ void TileBuilder::applyStyling(const Feature& _feature, const SceneLayer& _layer
     // build the feature with the rule's parameters
     for (auto& rule : m_ruleSet.matchedRules()) {
 
-        StyleBuilder* style = getStyleBuilder(rule.getStyleName());
+        int styleId = getStyleId(rule.getStyleNameId(), rule.getStyleName());
+        StyleBuilder* style = getStyleBuilder(styleId);
+
+        const Style* drawStyle = style ? &style->style() : getDeferredStyle(styleId);
 
-        if (!style) {
+        if (!drawStyle) {
             LOGN("Invalid style %s", rule.getStyleName().c_str());
             continue;
         }
 
+        bool buildStyle = buildsStyle(*drawStyle);
+        if (!buildStyle && !rule.findParameter(StyleParamKey::outline_style)) { continue; }
+
         // Apply default draw rules defined for this style
-        style->style().applyDefaultDrawRules(rule);
+        drawStyle->applyDefaultDrawRules(rule);
 
         if (!m_ruleSet.evaluateRuleForContext(rule, *m_styleContext)) {
             continue;
@@ -70,6 +245,10 @@ void TileBuilder::applyStyling(const Feature& _feature, const SceneLayer& _layer
 
         bool interactive = false;
         if (rule.get(StyleParamKey::interactive, interactive) && interactive) {
+            if (selectionColor == 0) {
+                // Features with an ID share the color that indexes their FeatureState
+                selectionColor = m_scene.featureState()->color(m_sourceId, _feature.id);
+            }
             if (selectionColor == 0) {
                 selectionColor = m_scene.featureSelection()->nextColorIdentifier();
             }
@@ -79,14 +258,20 @@ void TileBuilder::applyStyling(const Feature& _feature, const SceneLayer& _layer
             rule.selectionColor = 0;
         }
 
-        // build outline explicitly with outline style
+        // build outline explicitly with outline style, unless that is the style
+        // of the line, which builds the outline together with the line
         const auto& outlineStyleName = rule.findParameter(StyleParamKey::outline_style);
         if (outlineStyleName) {
             auto& styleName = outlineStyleName.value.get<std::string>();
-            auto* outlineStyle = getStyleBuilder(styleName);
-            if (!outlineStyle) {
+            int outlineStyleId = getStyleId(outlineStyleName.nameId, styleName);
+            auto* outlineStyle = getStyleBuilder(outlineStyleId);
+            if (outlineStyleId == styleId && buildStyle) {
+                // built with the line below
+            } else if (!outlineStyle && getDeferredStyle(outlineStyleId)) {
+                deferRule(_feature, rule, true);
+            } else if (!outlineStyle) {
                 LOGN("Invalid style %s", styleName.c_str());
-            } else {
+            } else if (buildsStyle(outlineStyle->style())) {
                 rule.isOutlineOnly = true;
                 outlineStyle->addFeature(_feature, rule);
                 rule.isOutlineOnly = false;
@@ -94,64 +279,338 @@ void TileBuilder::applyStyling(const Feature& _feature, const SceneLayer& _layer
         }
 
         // build feature with style
-        added |= style->addFeature(_feature, rule);
+        if (!buildStyle) {
+            continue;
+        } else if (style) {
+            added |= style->addFeature(_feature, rule);
+        } else {
+            deferRule(_feature, rule, false);
+        }
     }
 
     if (added && (selectionColor != 0)) {
-        m_selectionFeatures[selectionColor] = std::make_shared<Properties>(_feature.props);
+        m_selectionFeatures.add(selectionColor, _feature.props, m_sourceId);
+        if (m_indexFeatures) { m_featureIndex.add(_feature, selectionColor); }
+    }
+
+    if (m_recordMetrics) { m_geometryTime += Metrics::Clock::now() - stageStart; }
+}
+
+void TileBuilder::buildLayers(const Tile& _tile, const std::vector<LayerCollection>& _layers,
+                              size_t _begin, size_t _end) {
+    TRACE_SCOPE("TileBuilder::buildLayers");
+
+    if (m_isLayerBuilder) {
+        if (!m_initialized) {
+            init();
+            m_initialized = true;
+        }
+        m_selectionFeatures = {};
+        m_featureIndex = {};
+        m_deferredRules.clear();
+        m_ruleSet.clearCache();
+        m_stylingTime = m_geometryTime = {};
+
+        m_styleContext->setZoom(_tile.getID().s);
+
+        for (auto& builder : m_styleBuilder) {
+            if (builder) { builder->setup(_tile); }
+        }
+    }
+
+    for (size_t i = _begin; i < _end; i++) {
+        if (isCanceled()) { return; }
+
+        const auto& features = _layers[i].collection->features;
+        const auto& layer = *_layers[i].layer;
+
+        bool batched = features.size() >= MIN_FEATURES_PER_FILTER_BATCH &&
+            !layer.batchFunctions().empty();
+
+        if (batched) {
+            for (auto id : layer.batchFunctions()) {
+                m_styleContext->evalFilterBatch(id, features);
+            }
+        }
+
+        size_t count = 0;
+        for (const auto& feat : features) {
+            if (++count % CANCEL_CHECK_FEATURES == 0 && isCanceled()) { break; }
+            applyStyling(feat, layer);
+        }
+
+        if (batched) { m_styleContext->clearFilterBatch(); }
     }
 }
 
-std::unique_ptr<Tile> TileBuilder::build(TileID _tileID, const TileData& _tileData, const TileSource& _source) {
+void TileBuilder::mergeLayerBuilder(TileBuilder& _builder) {
+
+    for (size_t i = 0; i < _builder.m_styleBuilder.size(); i++) {
+        auto& builder = _builder.m_styleBuilder[i];
+        if (builder && m_styleBuilder[i]) { m_styleBuilder[i]->merge(*builder); }
+    }
+
+    m_selectionFeatures.merge(_builder.m_selectionFeatures);
+    _builder.m_selectionFeatures = {};
+
+    if (m_indexFeatures) { m_featureIndex.append(_builder.m_featureIndex); }
+
+    // Apply the deferred rules in the order they were matched
+    for (auto& deferred : _builder.m_deferredRules) {
+        DrawRule& rule = deferred.rule;
 
-    m_selectionFeatures.clear();
+        for (auto& param : deferred.evaluated) {
+            rule.param(param.first).param = &param.second;
+        }
+
+        if (deferred.isOutline) {
+            auto& outlineStyleName = rule.findParameter(StyleParamKey::outline_style);
+            auto* outlineStyle = getStyleBuilder(getStyleId(outlineStyleName.nameId,
+                                                            outlineStyleName.value.get<std::string>()));
+            if (outlineStyle && buildsStyle(outlineStyle->style())) {
+                rule.isOutlineOnly = true;
+                outlineStyle->addFeature(*deferred.feature, rule);
+            }
+            continue;
+        }
+
+        StyleBuilder* style = getStyleBuilder(getStyleId(rule.getStyleNameId(), rule.getStyleName()));
+        if (!style) { continue; }
+
+        if (style->addFeature(*deferred.feature, rule) && rule.selectionColor != 0) {
+            if (!m_selectionFeatures.contains(rule.selectionColor)) {
+                m_selectionFeatures.add(rule.selectionColor, deferred.feature->props, m_sourceId);
+                if (m_indexFeatures) { m_featureIndex.add(*deferred.feature, rule.selectionColor); }
+            }
+        }
+    }
+    _builder.m_deferredRules.clear();
+
+    m_stylingTime += _builder.m_stylingTime;
+    m_geometryTime += _builder.m_geometryTime;
+}
+
+std::unique_ptr<Tile> TileBuilder::build(TileID _tileID, const TileData& _tileData, const TileSource& _source,
+                                         const TileTask* _task) {
 
     auto tile = std::make_unique<Tile>(_tileID, _source.id(), _source.generation());
 
     tile->initGeometry(int(m_scene.styles().size()));
 
-    m_styleContext->setZoom(_tileID.s);
+    m_buildStyles.clear();
+    m_task = _task;
+    bool built = buildTile(*tile, _tileData, _source);
+    m_task = nullptr;
+
+    if (!built) { return nullptr; }
+    return tile;
+}
+
+bool TileBuilder::build(Tile& _tile, const std::vector<bool>& _buildStyles, const TileData& _tileData,
+                        const TileSource& _source, const TileTask* _task) {
+
+    m_buildStyles = _buildStyles;
+    m_task = _task;
+    bool built = buildTile(_tile, _tileData, _source);
+    m_task = nullptr;
+    m_buildStyles.clear();
+
+    return built;
+}
+
+bool TileBuilder::buildTile(Tile& _tile, const TileData& _tileData, const TileSource& _source) {
+    TRACE_SCOPE("TileBuilder::build");
+
+    // The TileData may be shared with sources of other scenes
+    m_sourceId = _source.id();
+
+    // Keep the selection features of meshes that are not rebuilt
+    m_selectionFeatures = _tile.getSelectionFeatures();
+    m_ruleSet.clearCache();
+
+    // The geometry of features restored from the TileDiskCache is unknown,
+    // picks on such tiles use the selection pass
+    m_indexFeatures = m_scene.options().indexInteractiveFeatures && m_selectionFeatures.size() == 0;
+    m_featureIndex = {};
+
+    size_t scratchBytes = scratchCapacity();
+
+    m_styleContext->setZoom(_tile.getID().s);
+
+    m_recordMetrics = Metrics::enabled();
+    m_stylingTime = m_geometryTime = {};
 
     for (auto& builder : m_styleBuilder) {
-        if (builder.second) { builder.second->setup(*tile); }
+        if (builder) { builder->setup(_tile); }
     }
 
-    for (const auto& datalayer : m_scene.layers()) {
+    std::vector<LayerCollection> layers;
+    size_t numFeatures = 0;
+
+    if (auto* source = getSourceLayers(_source.name())) {
 
-        if (datalayer.source() != _source.name()) { continue; }
+        // Positions of the data layers that use each collection of the tile,
+        // null for collections without a name which all data layers use
+        std::vector<const std::vector<uint32_t>*> collectionLayers;
+        collectionLayers.reserve(_tileData.layers.size());
 
+        static const std::vector<uint32_t> noLayers;
         for (const auto& collection : _tileData.layers) {
+            if (collection.name.empty()) {
+                collectionLayers.push_back(nullptr);
+                continue;
+            }
+            auto it = source->collections.find(collection.name);
+            collectionLayers.push_back(it != source->collections.end() ? &it->second : &noLayers);
+        }
 
-            if (!collection.name.empty()) {
-                const auto& dlc = datalayer.collections();
-                bool layerContainsCollection =
-                    std::find(dlc.begin(), dlc.end(), collection.name) != dlc.end();
+        for (uint32_t position = 0; position < source->layers.size(); position++) {
+            for (size_t i = 0; i < _tileData.layers.size(); i++) {
+                auto* positions = collectionLayers[i];
+                if (positions && !std::binary_search(positions->begin(), positions->end(), position)) {
+                    continue;
+                }
 
-                if (!layerContainsCollection) { continue; }
+                const auto& collection = _tileData.layers[i];
+                layers.push_back({ source->layers[position], &collection });
+                numFeatures += collection.features.size();
             }
+        }
+    }
+
+    size_t numChunks = std::min(m_layerBuilders.size() + 1,
+                                numFeatures / MIN_FEATURES_PER_LAYER_BUILDER);
+    numChunks = std::min(numChunks, layers.size());
+
+    if (numChunks <= 1) {
+        buildLayers(_tile, layers, 0, layers.size());
+    } else {
+        // Split the layers into contiguous chunks with about the same number of features.
+        // Chunk 0 is built by this TileBuilder, the others by the layer builders.
+        std::vector<size_t> bounds(numChunks + 1, layers.size());
+        bounds[0] = 0;
+        size_t chunk = 1, count = 0;
+        for (size_t i = 0; i < layers.size() && chunk < numChunks; i++) {
+            count += layers[i].collection->features.size();
+            if (count * numChunks >= numFeatures * chunk) {
+                bounds[chunk++] = i + 1;
+            }
+        }
 
-            for (const auto& feat : collection.features) {
-                applyStyling(feat, datalayer);
+        struct Chunks {
+            std::mutex mutex;
+            std::condition_variable done;
+            std::vector<std::atomic<bool>> claimed;
+            size_t running = 0;
+            explicit Chunks(size_t n) : claimed(n) {}
+        };
+        auto chunks = std::make_shared<Chunks>(numChunks);
+
+        auto runChunk = [&, chunks](size_t i) {
+            if (chunks->claimed[i].exchange(true)) { return false; }
+
+            m_layerBuilders[i-1]->buildLayers(_tile, layers, bounds[i], bounds[i+1]);
+            return true;
+        };
+
+        for (size_t i = 1; i < numChunks; i++) {
+            m_layerBuilders[i-1]->m_buildStyles = m_buildStyles;
+            m_layerBuilders[i-1]->m_recordMetrics = m_recordMetrics;
+            m_layerBuilders[i-1]->m_indexFeatures = m_indexFeatures;
+            m_layerBuilders[i-1]->m_task = m_task;
+            m_layerBuilders[i-1]->m_sourceId = m_sourceId;
+            // The job may run after build() returned when the chunk was built inline
+            ThreadPool::shared().enqueue(ThreadPool::Priority::tile, [chunks, runChunk, i]() mutable {
+                if (chunks->claimed[i]) { return; }
+                {
+                    std::lock_guard<std::mutex> lock(chunks->mutex);
+                    chunks->running++;
+                }
+                runChunk(i);
+                std::lock_guard<std::mutex> lock(chunks->mutex);
+                chunks->running--;
+                chunks->done.notify_all();
+            });
+        }
+
+        buildLayers(_tile, layers, bounds[0], bounds[1]);
+
+        // Build chunks that were not picked up by the pool yet
+        for (size_t i = 1; i < numChunks; i++) { runChunk(i); }
+
+        {
+            std::unique_lock<std::mutex> lock(chunks->mutex);
+            chunks->done.wait(lock, [&]{ return chunks->running == 0; });
+        }
+
+        for (size_t i = 1; i < numChunks; i++) {
+            auto& builder = *m_layerBuilders[i-1];
+            builder.m_task = nullptr;
+            if (isCanceled()) {
+                // Deferred rules refer to the features of the tile data
+                builder.m_deferredRules.clear();
+                builder.m_selectionFeatures = {};
+            } else {
+                mergeLayerBuilder(builder);
             }
         }
     }
 
-    for (auto& builder : m_styleBuilder) {
+    if (isCanceled()) {
+        // The StyleBuilders drop their features with the setup of the next tile
+        m_selectionFeatures = {};
+        m_featureIndex = {};
+        return false;
+    }
+
+    auto buildStart = m_recordMetrics ? Metrics::Clock::now() : Metrics::Clock::time_point();
 
-        builder.second->addLayoutItems(m_labelLayout);
+    {
+        TRACE_SCOPE("StyleBuilder::addLayoutItems");
+        for (auto& builder : m_styleBuilder) {
+            if (builder) { builder->addLayoutItems(m_labelLayout); }
+        }
     }
 
     float tileSize = MapProjection::tileSize() * m_scene.pixelScale();
 
-    m_labelLayout.process(_tileID, tile->getInverseScale(), tileSize);
+    {
+        TRACE_SCOPE("LabelCollider::process");
+        m_labelLayout.process(_tile.getID(), _tile.getInverseScale(), tileSize);
+    }
 
     for (auto& builder : m_styleBuilder) {
-        tile->setMesh(builder.second->style(), builder.second->build());
+        if (!builder) { continue; }
+        TRACE_SCOPE("StyleBuilder::build");
+        auto mesh = builder->build();
+        if (buildsStyle(builder->style())) {
+            _tile.setMesh(builder->style(), std::move(mesh));
+            _tile.setMeshBounds(builder->style(), builder->meshBounds());
+        }
     }
 
-    tile->setSelectionFeatures(m_selectionFeatures);
+    // StyleBuilders clear their buffers after build() but keep the capacity
+    size_t newScratchBytes = scratchCapacity();
+    s_scratchReused += scratchBytes;
+    if (newScratchBytes > scratchBytes) {
+        s_scratchAllocated += newScratchBytes - scratchBytes;
+    }
 
-    return tile;
+    _tile.setSelectionFeatures(std::move(m_selectionFeatures));
+    m_selectionFeatures = {};
+
+    if (m_indexFeatures) {
+        m_featureIndex.build();
+        _tile.setFeatureIndex(std::make_shared<FeatureIndex>(std::move(m_featureIndex)));
+        m_featureIndex = {};
+    }
+
+    if (m_recordMetrics) {
+        Metrics::record(Metrics::Stage::styling, m_stylingTime);
+        Metrics::record(Metrics::Stage::geometry_build,
+                        m_geometryTime + (Metrics::Clock::now() - buildStart));
+    }
+    return true;
 }
 
 }
@@ -4,14 +4,22 @@
 #include "labels/labelCollider.h"
 #include "scene/styleContext.h"
 #include "scene/drawRule.h"
+#include "selection/featureIndex.h"
+#include "selection/selectionFeatures.h"
 #include "style/style.h"
 
+#include <chrono>
+#include <unordered_map>
+#include <vector>
+
 namespace Tangram {
 
 class DataLayer;
 class Tile;
 class TileSource;
+class TileTask;
 struct Feature;
+struct Layer;
 struct Properties;
 struct TileData;
 
@@ -19,11 +27,42 @@ class TileBuilder {
 
 public:
 
+    // Memory of StyleBuilder buffers which are kept between tiles
+    struct ScratchStats {
+        // Bytes that were already allocated when a tile build started
+        size_t reusedBytes = 0;
+        // Bytes that had to be allocated while building tiles
+        size_t allocatedBytes = 0;
+    };
+
+    // Totals of all TileBuilders
+    static ScratchStats scratchStats();
+
     explicit TileBuilder(const Scene& _scene);
 
     StyleBuilder* getStyleBuilder(const std::string& _name);
 
-    std::unique_ptr<Tile> build(TileID _tileID, const TileData& _data, const TileSource& _source);
+    // Returns the StyleBuilder of the style with ID _styleId, or null
+    StyleBuilder* getStyleBuilder(int _styleId) {
+        return _styleId >= 0 ? m_styleBuilder[_styleId].get() : nullptr;
+    }
+
+    // The build stops when _task is canceled, it is checked for each layer and
+    // every few features. Returns null when the build was stopped.
+    std::unique_ptr<Tile> build(TileID _tileID, const TileData& _data, const TileSource& _source,
+                                const TileTask* _task = nullptr);
+
+    // Build only the styles of _tile for which _buildStyles is set, indexed by
+    // style ID. The meshes and selection features of the other styles are kept.
+    // Used for tiles that were partially restored from the TileDiskCache.
+    // Returns false, leaving _tile unchanged, when _task was canceled.
+    bool build(Tile& _tile, const std::vector<bool>& _buildStyles, const TileData& _data,
+               const TileSource& _source, const TileTask* _task = nullptr);
+
+    // Returns a filter for parsing the data of _tileID from _source. It rejects features
+    // that the filters of the scene's data layers do not match. The filter is valid
+    // until the next call.
+    FeatureFilter& featureFilter(TileID _tileID, const TileSource& _source);
 
     const Scene& scene() const { return m_scene; }
 
@@ -34,9 +73,82 @@ public:
 
 private:
 
+    // The data layers of a tile source, and for each collection name the
+    // positions in 'layers' of the data layers that use it
+    struct SourceLayers {
+        std::vector<const DataLayer*> layers;
+        std::unordered_map<std::string, std::vector<uint32_t>> collections;
+    };
+
+    // Evaluates the top-level filters of the data layers for a feature collection
+    class LayerFilter : public FeatureFilter {
+    public:
+        explicit LayerFilter(TileBuilder& _builder) : m_builder(_builder) {}
+
+        bool beginLayer(const std::string& _name) override;
+        bool accept(const Feature& _feature) override;
+
+        const SourceLayers* source = nullptr;
+
+    private:
+        TileBuilder& m_builder;
+        std::vector<const DataLayer*> m_layers;
+    };
+
+    // A feature collection of the tile matched by a data layer
+    struct LayerCollection {
+        const SceneLayer* layer;
+        const Layer* collection;
+    };
+
+    // A rule for a style that cannot be merged, recorded by a layer builder
+    // to be applied by the owning TileBuilder in the original feature order.
+    struct DeferredRule {
+        const Feature* feature;
+        DrawRule rule;
+        // Parameters that were evaluated for this feature; 'rule' refers to them
+        std::vector<std::pair<uint8_t, StyleParam>> evaluated;
+        bool isOutline;
+    };
+
+    // Bytes held by the StyleBuilders of this TileBuilder and its layer builders
+    size_t scratchCapacity() const;
+
+    // Returns false when the task of the build was canceled
+    bool buildTile(Tile& _tile, const TileData& _data, const TileSource& _source);
+
+    bool isCanceled() const;
+
+    // Whether meshes of _style are built for the current tile
+    bool buildsStyle(const Style& _style) const {
+        return m_buildStyles.empty() ||
+            (_style.getID() < m_buildStyles.size() && m_buildStyles[_style.getID()]);
+    }
+
     // Determine and apply DrawRules for a @_feature
     void applyStyling(const Feature& _feature, const SceneLayer& _layer);
 
+    // Returns the ID of the style with draw rule name ID _nameId and name _name,
+    // or -1 when there is no such style
+    int getStyleId(int _nameId, const std::string& _name) const;
+
+    // Returns the Style of a layer builder that is built by its owner
+    const Style* getDeferredStyle(int _styleId) const {
+        return _styleId >= 0 ? m_deferredStyles[_styleId] : nullptr;
+    }
+
+    // Returns the data layers of the tile source named _name, or null
+    const SourceLayers* getSourceLayers(const std::string& _name) const;
+
+    void deferRule(const Feature& _feature, const DrawRule& _rule, bool _isOutline);
+
+    // Apply styling to the features of _layers in [_begin, _end)
+    void buildLayers(const Tile& _tile, const std::vector<LayerCollection>& _layers,
+                     size_t _begin, size_t _end);
+
+    // Merge the results of a layer builder into this TileBuilder
+    void mergeLayerBuilder(TileBuilder& _builder);
+
     const Scene& m_scene;
 
     std::unique_ptr<StyleContext> m_styleContext;
@@ -44,9 +156,48 @@ private:
 
     LabelCollider m_labelLayout;
 
-    fastmap<std::string, std::unique_ptr<StyleBuilder>> m_styleBuilder;
+    // StyleBuilders by style ID
+    std::vector<std::unique_ptr<StyleBuilder>> m_styleBuilder;
+
+    // Style IDs by draw rule name ID, or -1 for names of no style
+    std::vector<int> m_nameStyles;
+
+    fastmap<std::string, SourceLayers> m_sourceLayers;
+
+    SelectionFeatures m_selectionFeatures;
+
+    // Geometry of the interactive features, when the scene indexes them
+    FeatureIndex m_featureIndex;
+    bool m_indexFeatures = false;
+
+    // Styles to build for the current tile; empty when all styles are built
+    std::vector<bool> m_buildStyles;
+
+    // Task of the current tile, the build stops when it is canceled
+    const TileTask* m_task = nullptr;
+
+    // Source of the current tile
+    int32_t m_sourceId = 0;
+
+    // Builders for running parts of build() in parallel
+    std::vector<std::unique_ptr<TileBuilder>> m_layerBuilders;
+
+    // A layer builder builds a part of the layers of a tile in parallel to its
+    // owner. It only builds styles that can be merged into the owner's
+    // StyleBuilders and defers the others.
+    bool m_isLayerBuilder = false;
+    bool m_initialized = false;
+    std::vector<DeferredRule> m_deferredRules;
+    // Styles by ID that a layer builder defers to its owner, or null
+    std::vector<const Style*> m_deferredStyles;
+
+    LayerFilter m_layerFilter{*this};
 
-    fastmap<uint32_t, std::shared_ptr<Properties>> m_selectionFeatures;
+    // Time spent matching draw rules and building features of the current
+    // tile, including its layer builders, when Metrics are enabled
+    bool m_recordMetrics = false;
+    std::chrono::steady_clock::duration m_stylingTime{};
+    std::chrono::steady_clock::duration m_geometryTime{};
 };
 
 }
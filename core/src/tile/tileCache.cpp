@@ -0,0 +1,188 @@
+#include "tile/tileCache.h"
+
+#include "gl/texture.h"
+#include "tile/tile.h"
+
+#include "glm/geometric.hpp"
+
+namespace Tangram {
+
+constexpr size_t TileCache::eviction_candidates;
+
+TileCache::TileCache(size_t _cacheSizeBytes) :
+    m_maxUsage(_cacheSizeBytes) {}
+
+TileCache::~TileCache() = default;
+
+void TileCache::put(int32_t _sourceId, std::shared_ptr<Tile> _tile) {
+    TileCacheKey k(_sourceId, _tile->getID());
+
+    auto it = m_entries.find(k);
+    if (it != m_entries.end()) { remove(it->second); }
+
+    auto& entry = m_entries.emplace(k, Entry{k}).first->second;
+    entry.bytes = _tile->getMemoryUsage();
+    entry.tile = std::move(_tile);
+
+    auto& source = m_sources[_sourceId];
+    entry.next = source.head;
+    if (source.head) { source.head->prev = &entry; }
+    source.head = &entry;
+    if (!source.tail) { source.tail = &entry; }
+
+    source.usage += entry.bytes;
+    m_usage += entry.bytes;
+
+    limitSourceUsage(source);
+    limitCacheSize(m_maxUsage);
+}
+
+std::shared_ptr<Tile> TileCache::get(int32_t _sourceId, TileID _tileId) {
+
+    auto it = m_entries.find(TileCacheKey(_sourceId, _tileId));
+    if (it == m_entries.end()) {
+        m_misses++;
+        return nullptr;
+    }
+    m_hits++;
+    return remove(it->second);
+}
+
+std::shared_ptr<Tile> TileCache::contains(int32_t _sourceId, TileID _tileId) const {
+
+    auto it = m_entries.find(TileCacheKey(_sourceId, _tileId));
+    if (it != m_entries.end()) {
+        return it->second.tile;
+    }
+    return nullptr;
+}
+
+void TileCache::limitCacheSize(size_t _cacheSizeBytes) {
+    m_maxUsage = _cacheSizeBytes;
+    trim(m_maxUsage);
+}
+
+void TileCache::trim(size_t _bytes) {
+    while (m_usage > _bytes) {
+        if (!evict(nullptr)) {
+            LOGE("Invalid cache state!");
+            m_usage = 0;
+            break;
+        }
+    }
+}
+
+void TileCache::setSourceBudget(int32_t _sourceId, size_t _budgetBytes) {
+    auto& source = m_sources[_sourceId];
+    source.budget = _budgetBytes;
+    limitSourceUsage(source);
+}
+
+void TileCache::limitSourceUsage(Source& _source) {
+    if (_source.budget == 0) { return; }
+
+    while (_source.usage > _source.budget) {
+        if (!evict(&_source)) {
+            LOGE("Invalid cache state!");
+            _source.usage = 0;
+            break;
+        }
+    }
+}
+
+size_t TileCache::getMemoryUsage(int32_t _sourceId) const {
+    auto it = m_sources.find(_sourceId);
+    return it != m_sources.end() ? it->second.usage : 0;
+}
+
+size_t TileCache::getGpuMemoryUsage() const {
+    size_t usage = 0;
+    for (const auto& entry : m_entries) {
+        const auto& tile = *entry.second.tile;
+        size_t cpuBytes = 0;
+        tile.getMeshMemoryUsage(cpuBytes, usage);
+        for (const auto& raster : tile.rasters()) {
+            if (raster.texture) { usage += raster.texture->gpuBytes(); }
+        }
+    }
+    return usage;
+}
+
+TileCacheStats TileCache::stats() const {
+    TileCacheStats stats;
+    stats.hits = m_hits;
+    stats.misses = m_misses;
+    stats.evictions = m_evictions;
+    stats.tiles = m_entries.size();
+    stats.memoryUsage = m_usage;
+    stats.memoryLimit = m_maxUsage;
+    return stats;
+}
+
+void TileCache::clear() {
+    m_entries.clear();
+    m_usage = 0;
+    // Keep the budgets of the sources
+    for (auto& source : m_sources) {
+        source.second.head = nullptr;
+        source.second.tail = nullptr;
+        source.second.usage = 0;
+    }
+}
+
+std::shared_ptr<Tile> TileCache::remove(Entry& _entry) {
+    auto& source = m_sources[_entry.key.first];
+
+    if (_entry.prev) { _entry.prev->next = _entry.next; } else { source.head = _entry.next; }
+    if (_entry.next) { _entry.next->prev = _entry.prev; } else { source.tail = _entry.prev; }
+
+    source.usage -= _entry.bytes;
+    m_usage -= _entry.bytes;
+
+    auto tile = std::move(_entry.tile);
+    m_entries.erase(_entry.key);
+    return tile;
+}
+
+bool TileCache::evict(Source* _source) {
+    Entry* victim = nullptr;
+    double victimRetention = 0;
+
+    auto findVictim = [&](const Source& _candidates) {
+        size_t count = 0;
+        for (Entry* entry = _candidates.tail; entry && count < eviction_candidates;
+             entry = entry->prev, count++) {
+            double value = retention(*entry);
+            // Prefer the least recently used of equal tiles
+            if (!victim || value < victimRetention) {
+                victim = entry;
+                victimRetention = value;
+            }
+        }
+    };
+
+    if (_source) {
+        findVictim(*_source);
+    } else {
+        for (const auto& source : m_sources) { findVictim(source.second); }
+    }
+
+    if (!victim) { return false; }
+
+    remove(*victim);
+    m_evictions++;
+    return true;
+}
+
+double TileCache::retention(const Entry& _entry) const {
+    const Tile& tile = *_entry.tile;
+
+    // Distance of the tile center from the view, in tiles of the tile's zoom
+    double tileSize = tile.getScale();
+    glm::dvec2 center = tile.getOrigin() + glm::dvec2(0.5 * tileSize);
+    double distance = glm::length(center - m_viewPosition) / tileSize;
+
+    return (1.0 + tile.getBuildTime()) / (1.0 + distance);
+}
+
+}
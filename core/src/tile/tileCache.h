@@ -1,11 +1,12 @@
 #pragma once
 
 #include "log.h"
-#include "tile/tile.h"
+#include "map.h"
 #include "tile/tileHash.h"
 #include "tile/tileID.h"
+#include "util/fastmap.h"
 
-#include <list>
+#include "glm/vec2.hpp"
 #include <memory>
 #include <unordered_map>
 
@@ -28,92 +29,105 @@ namespace std {
 
 namespace Tangram {
 
+class Tile;
+
+/* Cache of recently used Tiles that are ready for rendering
+ *
+ * Tiles are kept in one LRU list per TileSource. The memory usage of a tile is
+ * recorded when it is added, so that the total and per-source usage are kept
+ * up to date without iterating the cache.
+ *
+ * When the total limit or the budget of a source is exceeded a tile is evicted.
+ * Among the least recently used tiles the one with the lowest rebuild cost
+ * (measured build time) relative to its distance from the view is chosen.
+ */
 class TileCache {
-    struct CacheEntry {
-        TileCacheKey key;
-        std::shared_ptr<Tile> tile;
-    };
-
-    using CacheList = std::list<CacheEntry>;
-    using CacheMap = std::unordered_map<TileCacheKey, typename CacheList::iterator>;
 
 public:
 
-    TileCache(size_t _cacheSizeMB) :
-        m_cacheUsage(0),
-        m_cacheMaxUsage(_cacheSizeMB) {}
+    // Number of least recently used tiles per source compared for eviction
+    static constexpr size_t eviction_candidates = 8;
 
-    void put(int32_t _sourceId, std::shared_ptr<Tile> _tile) {
-        TileCacheKey k(_sourceId, _tile->getID());
+    explicit TileCache(size_t _cacheSizeBytes);
 
-        m_cacheList.push_front({k, _tile});
-        m_cacheMap[k] = m_cacheList.begin();
-        m_cacheUsage += _tile->getMemoryUsage();
+    ~TileCache();
 
-        limitCacheSize(m_cacheMaxUsage);
-    }
+    TileCache(const TileCache&) = delete;
+    TileCache& operator=(const TileCache&) = delete;
 
-    std::shared_ptr<Tile> get(int32_t _sourceId, TileID _tileId) {
-        std::shared_ptr<Tile> tile;
-        TileCacheKey k(_sourceId, _tileId);
-
-        auto it = m_cacheMap.find(k);
-        if (it != m_cacheMap.end()) {
-            std::swap(tile, (*(it->second)).tile);
-            m_cacheList.erase(it->second);
-            m_cacheMap.erase(it);
-            m_cacheUsage -= tile->getMemoryUsage();
-        }
-        return tile;
-    }
+    void put(int32_t _sourceId, std::shared_ptr<Tile> _tile);
 
-    std::shared_ptr<Tile> contains(int32_t _source, TileID _tileID) {
-        std::shared_ptr<Tile> tile;
-        TileCacheKey k(_source, _tileID);
+    /* Removes and returns the tile when it is in the cache */
+    std::shared_ptr<Tile> get(int32_t _sourceId, TileID _tileId);
 
-        auto it = m_cacheMap.find(k);
-        if (it != m_cacheMap.end()) {
-            return it->second->tile;
-        }
-        return nullptr;
-    }
-
-    void limitCacheSize(size_t _cacheSizeBytes) {
-        m_cacheMaxUsage = _cacheSizeBytes;
-
-        while (m_cacheUsage > m_cacheMaxUsage) {
-            if (m_cacheList.empty()) {
-                LOGE("Invalid cache state!");
-                m_cacheUsage = 0;
-                break;
-            }
-            auto& tile = m_cacheList.back().tile;
-            m_cacheUsage -= tile->getMemoryUsage();
-            m_cacheMap.erase(m_cacheList.back().key);
-            m_cacheList.pop_back();
-        }
-    }
+    /* Returns the tile when it is in the cache, leaving it there */
+    std::shared_ptr<Tile> contains(int32_t _sourceId, TileID _tileId) const;
 
-    size_t getMemoryUsage() const {
-        size_t sum = 0;
-        for (auto& entry : m_cacheList) {
-            sum += entry.tile->getMemoryUsage();
-        }
-        return sum;
-    }
+    /* Evict tiles until at most _cacheSizeBytes are used */
+    void limitCacheSize(size_t _cacheSizeBytes);
+
+    /* Evict tiles until at most _bytes are used, keeping the cache size */
+    void trim(size_t _bytes);
+
+    /* Limit the bytes used by tiles of _sourceId; 0 leaves only the total limit */
+    void setSourceBudget(int32_t _sourceId, size_t _budgetBytes);
+
+    /* Position of the view in projected meters, evicting distant tiles first */
+    void setViewPosition(const glm::dvec2& _position) { m_viewPosition = _position; }
+
+    size_t getMemoryUsage() const { return m_usage; }
+
+    size_t getMemoryUsage(int32_t _sourceId) const;
 
-    void clear() {
-        m_cacheMap.clear();
-        m_cacheList.clear();
-        m_cacheUsage = 0;
-    }
+    /* Bytes of the tiles in GL buffers and textures, the rest is in memory */
+    size_t getGpuMemoryUsage() const;
+
+    TileCacheStats stats() const;
+
+    void clear();
 
 private:
-    CacheMap m_cacheMap;
-    CacheList m_cacheList;
 
-    int m_cacheUsage;
-    int m_cacheMaxUsage;
+    struct Entry {
+        TileCacheKey key;
+        std::shared_ptr<Tile> tile;
+        size_t bytes = 0;
+        // Links of the LRU list of the entry's source, most recently used first
+        Entry* prev = nullptr;
+        Entry* next = nullptr;
+    };
+
+    struct Source {
+        Entry* head = nullptr;
+        Entry* tail = nullptr;
+        size_t usage = 0;
+        size_t budget = 0;
+    };
+
+    // Remove _entry from the LRU list and usage of its source and from m_entries
+    std::shared_ptr<Tile> remove(Entry& _entry);
+
+    // Evict one tile of _source, or of any source when _source is null.
+    // Returns false when there was no tile to evict.
+    bool evict(Source* _source);
+
+    // How much would be lost by evicting the tile of _entry
+    double retention(const Entry& _entry) const;
+
+    void limitSourceUsage(Source& _source);
+
+    // Entries are linked within the map nodes so there is no separate list allocation
+    std::unordered_map<TileCacheKey, Entry> m_entries;
+    fastmap<int32_t, Source> m_sources;
+
+    size_t m_usage = 0;
+    size_t m_maxUsage;
+
+    glm::dvec2 m_viewPosition{0.0};
+
+    size_t m_hits = 0;
+    size_t m_misses = 0;
+    size_t m_evictions = 0;
 };
 
 }
@@ -0,0 +1,291 @@
+#include "tile/tileDiskCache.h"
+
+#include "data/propertyItem.h"
+#include "data/tileSource.h"
+#include "gl/mesh.h"
+#include "log.h"
+#include "selection/featureSelection.h"
+#include "selection/featureState.h"
+#include "style/style.h"
+#include "tile/tile.h"
+
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+namespace Tangram {
+
+constexpr uint32_t TileDiskCache::format_version;
+
+static constexpr uint32_t file_magic = 0x43445454; // "TTDC"
+
+enum class ValueType : uint8_t { none, number, string };
+
+namespace {
+
+struct Writer {
+    std::vector<uint8_t> data;
+
+    template<class T>
+    void write(const T& _value) {
+        auto bytes = reinterpret_cast<const uint8_t*>(&_value);
+        data.insert(data.end(), bytes, bytes + sizeof(T));
+    }
+
+    void write(const std::string& _value) {
+        write(uint32_t(_value.size()));
+        data.insert(data.end(), _value.begin(), _value.end());
+    }
+};
+
+struct Reader {
+    const uint8_t* pos;
+    const uint8_t* end;
+
+    template<class T>
+    bool read(T& _value) {
+        if (size_t(end - pos) < sizeof(T)) { return false; }
+        std::memcpy(&_value, pos, sizeof(T));
+        pos += sizeof(T);
+        return true;
+    }
+
+    bool read(std::string& _value) {
+        uint32_t size = 0;
+        if (!read(size) || size_t(end - pos) < size) { return false; }
+        _value.assign(reinterpret_cast<const char*>(pos), size);
+        pos += size;
+        return true;
+    }
+};
+
+}
+
+TileDiskCache::TileDiskCache(std::string _directory) :
+    m_directory(std::move(_directory)) {
+
+    if (!m_directory.empty() && m_directory.back() != '/') {
+        m_directory += '/';
+    }
+}
+
+std::string TileDiskCache::path(TileID _tileID, const TileSource& _source) const {
+    std::string name = _source.name();
+    for (auto& c : name) {
+        if (!isalnum(static_cast<unsigned char>(c))) { c = '_'; }
+    }
+    return m_directory + name + "-" + std::to_string(_tileID.z) + "-" +
+        std::to_string(_tileID.x) + "-" + std::to_string(_tileID.y) + "-" +
+        std::to_string(_tileID.s) + ".tile";
+}
+
+bool TileDiskCache::store(const Tile& _tile, const TileSource& _source, uint64_t _sceneHash,
+                          const std::vector<std::unique_ptr<Style>>& _styles,
+                          const FeatureState& _state) {
+
+    Writer out;
+    out.write(file_magic);
+    out.write(format_version);
+    out.write(_sceneHash);
+    out.write(uint32_t(_styles.size()));
+
+    // Meshes that cannot be stored are rebuilt when the tile is loaded
+    std::vector<uint32_t> buildStyles;
+    Writer meshes;
+    uint32_t numMeshes = 0;
+
+    for (auto& style : _styles) {
+        auto& mesh = _tile.getMesh(*style);
+        if (!mesh) { continue; }
+
+        size_t start = meshes.data.size();
+        uint32_t id = style->getID();
+        meshes.write(id);
+
+        auto& bounds = _tile.getMeshBounds(*style);
+        meshes.write(uint8_t(bounds.bounded));
+        meshes.write(bounds.min);
+        meshes.write(bounds.max);
+
+        if (mesh->serialize(meshes.data)) {
+            numMeshes++;
+        } else {
+            meshes.data.resize(start);
+            buildStyles.push_back(id);
+        }
+    }
+
+    out.write(uint32_t(buildStyles.size()));
+    for (auto id : buildStyles) { out.write(id); }
+
+    out.write(numMeshes);
+    out.data.insert(out.data.end(), meshes.data.begin(), meshes.data.end());
+
+    const auto& selection = _tile.getSelectionFeatures();
+    out.write(uint32_t(selection.size()));
+    for (auto id : selection.ids()) {
+        out.write(id);
+        // Features of FeatureState colors keep their state when they are loaded
+        out.write(_state.feature(id).second);
+        auto props = selection.get(id);
+        const auto& items = props->items();
+        out.write(uint32_t(items.size()));
+        for (auto& item : items) {
+            out.write(item.key);
+            if (item.value.is<double>()) {
+                out.write(ValueType::number);
+                out.write(item.value.get<double>());
+            } else if (item.value.is<std::string>()) {
+                out.write(ValueType::string);
+                out.write(item.value.get<std::string>());
+            } else {
+                out.write(ValueType::none);
+            }
+        }
+    }
+
+    // Write to a temporary file first so that readers never see a partial entry
+    std::string file = path(_tile.getID(), _source);
+    std::string tmpFile = file + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    {
+        std::ofstream stream(tmpFile, std::ofstream::binary | std::ofstream::trunc);
+        if (!stream.is_open()) {
+            LOGW("Cannot write tile cache file: %s", tmpFile.c_str());
+            return false;
+        }
+        stream.write(reinterpret_cast<const char*>(out.data.data()), out.data.size());
+        if (!stream.good()) {
+            stream.close();
+            std::remove(tmpFile.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tmpFile.c_str(), file.c_str()) != 0) {
+        std::remove(tmpFile.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::unique_ptr<Tile> TileDiskCache::load(TileID _tileID, const TileSource& _source, uint64_t _sceneHash,
+                                          const std::vector<std::unique_ptr<Style>>& _styles,
+                                          FeatureSelection& _selection, FeatureState& _state,
+                                          std::vector<bool>& _buildStyles) {
+
+    _buildStyles.clear();
+
+    std::ifstream stream(path(_tileID, _source), std::ifstream::ate | std::ifstream::binary);
+    if (!stream.is_open()) { return nullptr; }
+
+    std::vector<uint8_t> data(size_t(stream.tellg()));
+    stream.seekg(std::ifstream::beg);
+    stream.read(reinterpret_cast<char*>(data.data()), data.size());
+    if (!stream.good()) { return nullptr; }
+
+    Reader in{ data.data(), data.data() + data.size() };
+
+    uint32_t magic = 0, version = 0, numStyles = 0;
+    uint64_t sceneHash = 0;
+    if (!in.read(magic) || !in.read(version) || !in.read(sceneHash) || !in.read(numStyles) ||
+        magic != file_magic || version != format_version ||
+        sceneHash != _sceneHash || numStyles != _styles.size()) {
+        return nullptr;
+    }
+
+    auto tile = std::make_unique<Tile>(_tileID, _source.id(), _source.generation());
+    tile->initGeometry(numStyles);
+
+    uint32_t numBuild = 0;
+    if (!in.read(numBuild)) { return nullptr; }
+    for (uint32_t i = 0; i < numBuild; i++) {
+        uint32_t id = 0;
+        if (!in.read(id) || id >= numStyles) { return nullptr; }
+        _buildStyles.resize(numStyles);
+        _buildStyles[id] = true;
+    }
+
+    std::vector<CompiledMesh*> meshes;
+    uint32_t numMeshes = 0;
+    if (!in.read(numMeshes)) { return nullptr; }
+    for (uint32_t i = 0; i < numMeshes; i++) {
+        uint32_t id = 0;
+        if (!in.read(id) || id >= numStyles) { return nullptr; }
+
+        MeshBounds bounds;
+        uint8_t bounded = 0;
+        if (!in.read(bounded) || !in.read(bounds.min) || !in.read(bounds.max)) { return nullptr; }
+        bounds.bounded = bounded != 0;
+
+        auto& style = *_styles[id];
+        auto mesh = std::make_unique<CompiledMesh>(style.vertexLayout(), style.drawMode());
+        if (!mesh->deserialize(in.pos, in.end)) { return nullptr; }
+
+        meshes.push_back(mesh.get());
+        tile->setMesh(style, std::move(mesh));
+        tile->setMeshBounds(style, bounds);
+    }
+
+    fastmap<uint32_t, std::pair<uint64_t, std::shared_ptr<Properties>>> storedFeatures;
+    uint32_t numFeatures = 0;
+    if (!in.read(numFeatures)) { return nullptr; }
+    for (uint32_t i = 0; i < numFeatures; i++) {
+        uint32_t color = 0, numItems = 0;
+        uint64_t featureId = 0;
+        if (!in.read(color) || !in.read(featureId) || !in.read(numItems)) { return nullptr; }
+
+        std::vector<Properties::Item> items;
+        for (uint32_t j = 0; j < numItems; j++) {
+            std::string key;
+            ValueType type;
+            if (!in.read(key) || !in.read(type)) { return nullptr; }
+
+            if (type == ValueType::number) {
+                double value;
+                if (!in.read(value)) { return nullptr; }
+                items.emplace_back(std::move(key), value);
+            } else if (type == ValueType::string) {
+                std::string value;
+                if (!in.read(value)) { return nullptr; }
+                items.emplace_back(std::move(key), std::move(value));
+            } else {
+                items.emplace_back(std::move(key), Value());
+            }
+        }
+        auto props = std::make_shared<Properties>();
+        props->setSorted(std::move(items));
+        props->sourceId = _source.id();
+        storedFeatures[color] = { featureId, std::move(props) };
+    }
+
+    // Selection colors are only unique within a session. Assign new colors to
+    // the features that are drawn by the stored meshes.
+    if (numFeatures > 0) {
+        fastmap<uint32_t, uint32_t> colors;
+        SelectionFeatures selectionFeatures;
+
+        for (auto* mesh : meshes) {
+            mesh->mapAttribute("a_selection_color", [&](uint32_t _color) -> uint32_t {
+                if (_color == 0) { return 0; }
+
+                auto it = colors.find(_color);
+                if (it != colors.end()) { return it->second; }
+
+                auto feature = storedFeatures.find(_color);
+                if (feature == storedFeatures.end()) { return 0; }
+
+                uint32_t color = _state.color(_source.id(), feature->second.first);
+                if (color == 0) { color = _selection.nextColorIdentifier(); }
+                colors[_color] = color;
+                selectionFeatures.add(color, *feature->second.second);
+                return color;
+            });
+        }
+        tile->setSelectionFeatures(std::move(selectionFeatures));
+    }
+
+    return tile;
+}
+
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "tile/tileID.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Tangram {
+
+class FeatureSelection;
+class FeatureState;
+class Style;
+class Tile;
+class TileSource;
+
+/* Persistent cache of built tile geometry
+ *
+ * Stores the compiled meshes and selection features of tiles in a directory,
+ * one file per tile and TileSource. Each file records the hash of the scene
+ * configuration it was built with and is ignored when the hash differs, so
+ * that entries are invalidated when the scene or its SceneUpdates change.
+ *
+ * Meshes that cannot be stored, like those of label styles, are marked to be
+ * rebuilt from the tile data when the tile is loaded.
+ */
+class TileDiskCache {
+
+public:
+
+    // Version of the file format and of the stored vertex data
+    static constexpr uint32_t format_version = 4;
+
+    // _directory must exist and be writable
+    explicit TileDiskCache(std::string _directory);
+
+    /* Write the meshes and selection features of _tile, built from _source
+     * with the scene configuration _sceneHash. Returns false on failure. */
+    bool store(const Tile& _tile, const TileSource& _source, uint64_t _sceneHash,
+               const std::vector<std::unique_ptr<Style>>& _styles, const FeatureState& _state);
+
+    /* Load the stored tile _tileID of _source, or return null when it is not
+     * in the cache or was built with another scene configuration.
+     * Selection colors are reassigned from _selection, or from _state for
+     * features with an ID. _buildStyles is set to the styles to build from
+     * the tile data; it is empty when the tile is complete. */
+    std::unique_ptr<Tile> load(TileID _tileID, const TileSource& _source, uint64_t _sceneHash,
+                               const std::vector<std::unique_ptr<Style>>& _styles,
+                               FeatureSelection& _selection, FeatureState& _state,
+                               std::vector<bool>& _buildStyles);
+
+    const std::string& directory() const { return m_directory; }
+
+private:
+
+    std::string path(TileID _tileID, const TileSource& _source) const;
+
+    std::string m_directory;
+};
+
+}
@@ -1,6 +1,10 @@
 #include "tile/tileManager.h"
 
+#include "data/rasterSource.h"
 #include "data/tileSource.h"
+#include "debug/metrics.h"
+#include "gl/renderState.h"
+#include "gl/texture.h"
 #include "map.h"
 #include "platform.h"
 #include "tile/tile.h"
@@ -27,6 +31,26 @@ enum class TileManager::ProxyID : uint8_t {
     parent2 = 1 << 5,
 };
 
+// Cancels a task together with its raster sub-tasks: neither is of use
+// without the other. The request of a canceled task has already ended.
+static void cancelTaskUnit(TileSource& _source, TileTask& _task) {
+    if (!_task.isCanceled()) {
+        // Cancels the requests of the sub-tasks as well
+        _source.cancelLoadingTile(_task);
+    } else {
+        for (auto& raster : _task.subTasks()) {
+            auto rasterSource = raster->source();
+            if (rasterSource && !raster->isCanceled()) {
+                rasterSource->cancelLoadingTile(*raster);
+            }
+        }
+    }
+    for (auto& raster : _task.subTasks()) {
+        raster->cancel();
+    }
+    _task.cancel();
+}
+
 struct TileManager::TileEntry {
 
     TileEntry(std::shared_ptr<Tile>& _tile)
@@ -44,6 +68,13 @@ struct TileManager::TileEntry {
     uint8_t m_proxies;
     bool m_visible;
 
+    /* Whether tile is the partial tile of the progressive build of task */
+    bool m_partial = false;
+
+    /* Whether tile shows parent textures for raster sub-tasks of task that
+     * are not ready yet */
+    bool m_proxyRasters = false;
+
     bool isInProgress() {
         return bool(task) && !task->isCanceled();
     }
@@ -68,16 +99,70 @@ struct TileManager::TileEntry {
     // - task still exists
     // - task has a tile ready
     // - tile has all rasters set
-    bool completeTileTask() {
-        if (bool(task) && task->isReady()) {
-
+    // - tile geometry is uploaded, when _requireUpload is set
+    // The partial tile of a progressive build is shown until then, unless
+    // there is a previous tile. Raster sub-tasks that are not ready may
+    // be shown from the texture of a parent tile until they are.
+    bool completeTileTask(bool _requireUpload) {
+        if (!task) { return false; }
+
+        if (m_proxyRasters) {
             for (auto& rTask : task->subTasks()) {
                 if (!rTask->isReady()) { return false; }
             }
+            for (auto& rTask : task->subTasks()) {
+                rTask->replaceProxy(*tile);
+            }
+            m_proxyRasters = false;
+            task.reset();
+
+            return true;
+        }
+
+        if (!tile && !task->isCanceled() && task->partialTile() && task->subTasks().empty()) {
+            if (_requireUpload && !task->partialTile()->isUploaded()) {
+                return false;
+            }
+            tile = task->getPartialTile();
+            m_partial = true;
+            return true;
+        }
+
+        if (task->isReady()) {
+
+            bool proxyRasters = false;
+            for (auto& rTask : task->subTasks()) {
+                if (rTask->isReady()) { continue; }
+                if (!rTask->hasProxy() || rTask->isCanceled() || !task->tile() || m_partial) {
+                    return false;
+                }
+                proxyRasters = true;
+            }
+            if (_requireUpload && task->tile() && !task->tile()->isUploaded()) {
+                return false;
+            }
 
             task->complete();
-            tile = task->getTile();
-            task.reset();
+            if (task->keepsPreviousTile()) {
+                // The data did not change since the previous build, which
+                // is still shown or was taken from the TileCache
+                if (tile != task->previousTile()) {
+                    tile = task->previousTile();
+                    tile->resetState();
+                }
+                tile->setSourceGeneration(task->sourceGeneration());
+            } else if (m_partial) {
+                tile->addMeshes(*task->getTile());
+                m_partial = false;
+            } else {
+                tile = task->getTile();
+            }
+            if (proxyRasters) {
+                // The task is kept for the sub-tasks that are loading
+                m_proxyRasters = true;
+            } else {
+                task.reset();
+            }
 
             return true;
         }
@@ -85,6 +170,13 @@ struct TileManager::TileEntry {
     }
 
     void clearTask() {
+        // A partial tile would miss its labels, and a tile with proxy
+        // rasters would keep the parent textures
+        if (m_partial || m_proxyRasters) {
+            tile.reset();
+            m_partial = false;
+            m_proxyRasters = false;
+        }
         if (task) {
             for (auto& raster : task->subTasks()) {
                 raster->cancel();
@@ -96,6 +188,11 @@ struct TileManager::TileEntry {
         }
     }
 
+    void cancelTask(TileSource& _source) {
+        if (task) { cancelTaskUnit(_source, *task); }
+        clearTask();
+    }
+
     /* Methods to set and get proxy counter */
     int getProxyCounter() { return m_proxyCounter; }
     void incProxyCounter() { m_proxyCounter++; }
@@ -139,12 +236,17 @@ TileManager::TileSet::~TileSet() {
 
 void TileManager::TileSet::cancelTasks() {
     for (auto& tile : tiles) {
-        auto& entry = tile.second;
-        if (entry.isInProgress()) {
-            source->cancelLoadingTile(*entry.task);
-        }
-        entry.clearTask();
+        tile.second.cancelTask(*source);
+    }
+    cancelPrefetchTasks();
+}
+
+void TileManager::TileSet::cancelPrefetchTasks() {
+    for (auto& prefetch : prefetchTasks) {
+        cancelTaskUnit(*source, *prefetch.second);
     }
+    prefetchTasks.clear();
+    pathPrefetch = false;
 }
 
 TileManager::TileManager(Platform& platform, TileTaskQueue& _tileWorker) :
@@ -163,6 +265,8 @@ TileManager::TileManager(Platform& platform, TileTaskQueue& _tileWorker) :
 
         } else {
             task->cancel();
+            // The next update may start a load that waited for this one
+            platform.requestRender();
         }
     }};
 }
@@ -174,6 +278,7 @@ TileManager::~TileManager() {
 void TileManager::setTileSources(const std::vector<std::shared_ptr<TileSource>>& _sources) {
 
     m_tileCache->clear();
+    m_idle = false;
 
     // Remove all (non-client datasources) sources and respective tileSets not present in the
     // new scene
@@ -225,6 +330,7 @@ void TileManager::addClientTileSource(std::shared_ptr<TileSource> _tileSource) {
 
     if (it == m_tileSets.end()) {
         m_tileSets.emplace_back(_tileSource, true);
+        m_idle = false;
     }
 }
 
@@ -235,6 +341,7 @@ bool TileManager::removeClientTileSource(int32_t _sourceId) {
 
     if (it != m_tileSets.end()) {
         m_tileSets.erase(it);
+        m_idle = false;
         return true;
     }
     return false;
@@ -246,10 +353,56 @@ void TileManager::cancelTileTasks() {
         for (auto& tile : tileSet.tiles) {
             tile.second.clearTask();
         }
+        tileSet.cancelPrefetchTasks();
         tileSet.source->clearData();
     }
 
     m_tileCache->clear();
+    m_idle = false;
+}
+
+void TileManager::holdTileSets(const std::vector<std::string>& _sources) {
+    m_idle = false;
+    for (auto& tileSet : m_tileSets) {
+        tileSet.held = !tileSet.clientTileSource &&
+            std::find(_sources.begin(), _sources.end(), tileSet.source->name()) != _sources.end();
+    }
+}
+
+void TileManager::adoptTiles(TileManager& _previous, const std::vector<bool>& _labelStyles) {
+    m_idle = false;
+    for (auto& tileSet : m_tileSets) {
+        if (!tileSet.held) { continue; }
+
+        auto previous = std::find_if(_previous.m_tileSets.begin(), _previous.m_tileSets.end(),
+                                     [&](auto& ts) {
+                                         return !ts.clientTileSource &&
+                                             ts.source->name() == tileSet.source->name();
+                                     });
+        if (previous == _previous.m_tileSets.end()) { continue; }
+
+        auto& source = tileSet.source;
+        for (auto& it : previous->tiles) {
+            auto& entry = it.second;
+            if (!entry.tile || entry.m_partial || !entry.isVisible()) { continue; }
+
+            // Selection colors and rasters belong to the previous scene
+            if (entry.tile->getSelectionFeatures().size() > 0 || !entry.tile->rasters().empty()) {
+                continue;
+            }
+
+            auto tile = std::make_shared<Tile>(it.first, source->id(), source->generation());
+            tile->takeMeshes(*entry.tile, _labelStyles);
+
+            auto& adopted = tileSet.tiles.emplace(it.first, tile).first->second;
+            if (!_labelStyles.empty()) {
+                adopted.task = source->createTask(it.first);
+                adopted.task->setLabelsOnly();
+                adopted.m_partial = true;
+            }
+            m_tileSetChanged = true;
+        }
+    }
 }
 
 void TileManager::clearTileSets(bool clearSourceCaches) {
@@ -265,6 +418,13 @@ void TileManager::clearTileSets(bool clearSourceCaches) {
     }
 
     m_tileCache->clear();
+    m_idle = false;
+}
+
+void TileManager::rebuildLostTiles() {
+    clearTileSets();
+
+    m_rebuildingLostTiles = true;
 }
 
 void TileManager::clearTileSet(int32_t _sourceId) {
@@ -277,18 +437,65 @@ void TileManager::clearTileSet(int32_t _sourceId) {
 
     m_tileCache->clear();
     m_tileSetChanged = true;
+    m_idle = false;
 }
 
-void TileManager::updateTileSets(const View& _view) {
+bool TileManager::replaceTileSource(std::shared_ptr<TileSource> _source) {
+    for (auto& tileSet : m_tileSets) {
+        if (tileSet.clientTileSource || tileSet.source->name() != _source->name()) {
+            continue;
+        }
+        tileSet.cancelTasks();
+        tileSet.tiles.clear();
+        tileSet.source = std::move(_source);
+
+        m_tileCache->clear();
+        m_tileSetChanged = true;
+        m_idle = false;
+        return true;
+    }
+    return false;
+}
+
+bool TileManager::isIdle(const View& _view, const std::vector<const View*>& _views) const {
+
+    if (!m_idle || _view.changedOnLastUpdate() || _views.size() != m_viewTiles.size()) { return false; }
+
+    for (auto* view : _views) {
+        if (view->changedOnLastUpdate()) { return false; }
+    }
+    for (auto& tileSet : m_tileSets) {
+        if (tileSet.idleGeneration != tileSet.source->generation() ||
+            tileSet.idleVisible != tileSet.source->isVisible()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void TileManager::updateTileSets(const View& _view, const std::vector<const View*>& _views) {
+
+    // The visible tiles of the last update stay the same
+    if (isIdle(_view, _views)) {
+        m_tileSetChanged = false;
+        m_completedTiles = 0;
+        return;
+    }
 
     m_tiles.clear();
+    m_viewTiles.assign(_views.size(), {});
     m_tilesInProgress = 0;
     m_tileSetChanged = false;
+    m_completedTiles = 0;
+    m_completionDeferred = false;
+
+    m_tileCache->setViewPosition(glm::dvec2(_view.getPosition()));
 
     if (!getDebugFlag(DebugFlags::freeze_tiles)) {
 
         for (auto& tileSet : m_tileSets) {
             tileSet.visibleTiles.clear();
+            tileSet.viewTiles.assign(_views.size(), {});
         }
 
         auto tileCb = [&, zoom = _view.getZoom()](TileID _tileID){
@@ -297,22 +504,71 @@ void TileManager::updateTileSets(const View& _view) {
                 auto maxZoom = tileSet.source->maxZoom();
 
                 // Insert scaled and maxZoom mapped tileID in the visible set
-                tileSet.visibleTiles.insert(_tileID.zoomBiasAdjusted(zoomBias).withMaxSourceZoom(maxZoom));
+                tileSet.visibleTiles.push_back(_tileID.zoomBiasAdjusted(zoomBias).withMaxSourceZoom(maxZoom));
             }
         };
 
         _view.getVisibleTiles(tileCb);
+
+        for (size_t i = 0; i < _views.size(); i++) {
+            _views[i]->getVisibleTiles([&](TileID _tileID) {
+                for (auto& tileSet : m_tileSets) {
+                    auto zoomBias = tileSet.source->zoomBias();
+                    auto maxZoom = tileSet.source->maxZoom();
+                    tileSet.viewTiles[i].push_back(_tileID.zoomBiasAdjusted(zoomBias).withMaxSourceZoom(maxZoom));
+                }
+            });
+        }
+
+        for (auto& tileSet : m_tileSets) {
+            auto& tiles = tileSet.visibleTiles;
+            std::sort(tiles.begin(), tiles.end());
+            tiles.erase(std::unique(tiles.begin(), tiles.end()), tiles.end());
+
+            for (auto& viewTiles : tileSet.viewTiles) {
+                std::sort(viewTiles.begin(), viewTiles.end());
+                viewTiles.erase(std::unique(viewTiles.begin(), viewTiles.end()), viewTiles.end());
+            }
+        }
     }
 
     for (auto& tileSet : m_tileSets) {
+        if (tileSet.held) { continue; }
+
         // check if tile set is active for zoom (zoom might be below min_zoom)
         if (tileSet.source->isActiveForZoom(_view.getZoom()) && tileSet.source->isVisible()) {
             updateTileSet(tileSet, _view.state());
         }
+        // Tiles of the main view are rebuilt first after a lost context
+        for (size_t i = 0; i < _views.size() && i < tileSet.viewTiles.size() && !m_rebuildingLostTiles; i++) {
+            if (tileSet.source->isActiveForZoom(_views[i]->getZoom()) && tileSet.source->isVisible()) {
+                updateViewTiles(tileSet, i, _views[i]->state());
+            }
+        }
     }
 
+    // Let the workers reorder their queue by the updated task priorities
+    m_workers.updatePriorities();
+
     loadTiles();
 
+    if (m_rebuildingLostTiles && !hasLoadingTiles()) {
+        m_rebuildingLostTiles = false;
+    }
+
+    // Speculative loads start after the loads of visible tiles
+    for (auto& tileSet : m_tileSets) {
+        if (m_rebuildingLostTiles) {
+            break;
+        } else if (tileSet.held) {
+            continue;
+        } else if (tileSet.source->isActiveForZoom(_view.getZoom()) && tileSet.source->isVisible()) {
+            updatePrefetch(tileSet, _view);
+        } else if (!tileSet.pathPrefetch) {
+            tileSet.cancelPrefetchTasks();
+        }
+    }
+
     // Make m_tiles an unique list of tiles for rendering sorted from
     // high to low zoom-levels.
     std::sort(m_tiles.begin(), m_tiles.end(), [](auto& a, auto& b) {
@@ -323,6 +579,72 @@ void TileManager::updateTileSets(const View& _view) {
 
     // Remove duplicates: Proxy tiles could have been added more than once
     m_tiles.erase(std::unique(m_tiles.begin(), m_tiles.end()), m_tiles.end());
+
+    for (auto& tiles : m_viewTiles) {
+        std::sort(tiles.begin(), tiles.end(), [](auto& a, auto& b) {
+                return a->sourceID() == b->sourceID() ?
+                    a->getID() < b->getID() :
+                    a->sourceID() < b->sourceID(); }
+            );
+    }
+
+    // Without tasks nothing changes until the view, the sources or the tile sets do
+    m_idle = m_tilesInProgress == 0 && !m_completionDeferred && !m_rebuildingLostTiles &&
+        std::none_of(m_tileSets.begin(), m_tileSets.end(), [](auto& _tileSet) {
+            return _tileSet.held || !_tileSet.prefetchTasks.empty() ||
+                std::any_of(_tileSet.tiles.begin(), _tileSet.tiles.end(),
+                            [](auto& _entry) { return _entry.second.isInProgress(); });
+        });
+
+    if (m_idle) {
+        for (auto& tileSet : m_tileSets) {
+            tileSet.idleGeneration = tileSet.source->generation();
+            tileSet.idleVisible = tileSet.source->isVisible();
+        }
+    }
+}
+
+const std::vector<std::shared_ptr<Tile>>& TileManager::getViewTiles(size_t _view) const {
+    static const std::vector<std::shared_ptr<Tile>> noTiles;
+    return _view < m_viewTiles.size() ? m_viewTiles[_view] : noTiles;
+}
+
+bool TileManager::uploadTiles(RenderState& _rs) {
+
+    m_scheduleUploads = true;
+
+    std::vector<std::pair<double, Tile*>> pending;
+
+    for (auto& tileSet : m_tileSets) {
+        for (auto& it : tileSet.tiles) {
+            auto& task = it.second.task;
+            if (!task || task->isCanceled()) { continue; }
+
+            // The partial tile of a progressive build is uploaded on its own
+            for (auto* tile : { task->partialTile(), task->isReady() ? task->tile() : nullptr }) {
+                if (tile && !tile->isUploaded()) {
+                    pending.emplace_back(task->getPriority(), tile);
+                }
+            }
+        }
+    }
+    if (pending.empty()) { return false; }
+
+    // Tiles closest to the view center first
+    std::sort(pending.begin(), pending.end(),
+              [](auto& a, auto& b) { return a.first < b.first; });
+
+    // Upload at least one tile per frame, even when meshes drawn for the
+    // first time already used up the budget
+    bool uploaded = false;
+    for (auto& entry : pending) {
+        if (uploaded && !_rs.hasUploadBudget()) { break; }
+        auto uploadStart = Metrics::start();
+        entry.second->upload(_rs);
+        Metrics::record(Metrics::Stage::mesh_upload, uploadStart);
+        uploaded = true;
+    }
+    return true;
 }
 
 void TileManager::updateTileSet(TileSet& _tileSet, const ViewState& _view) {
@@ -345,7 +667,12 @@ void TileManager::updateTileSet(TileSet& _tileSet, const ViewState& _view) {
     // Check for ready tasks, move Tile to active TileSet and unset Proxies.
     for (auto& it : tiles) {
         auto& entry = it.second;
-        if (entry.completeTileTask()) {
+        if (m_completionLimit > 0 && m_completedTiles >= m_completionLimit) {
+            m_completionDeferred |= entry.task && entry.task->isReady();
+            continue;
+        }
+        if (entry.completeTileTask(m_scheduleUploads)) {
+            m_completedTiles++;
             clearProxyTiles(_tileSet, it.first, entry, removeTiles);
 
             newTiles = true;
@@ -359,8 +686,6 @@ void TileManager::updateTileSet(TileSet& _tileSet, const ViewState& _view) {
     auto curTilesIt = tiles.begin();
     auto visTilesIt = visibleTiles.begin();
 
-    auto generation = _tileSet.source->generation();
-
     while (visTilesIt != visibleTiles.end() || curTilesIt != tiles.end()) {
 
         auto& visTileId = visTilesIt == visibleTiles.end()
@@ -379,6 +704,11 @@ void TileManager::updateTileSet(TileSet& _tileSet, const ViewState& _view) {
 
             if (entry.tile) {
                 m_tiles.push_back(entry.tile);
+
+                // The labels of a tile taken from a previous scene
+                if (entry.m_partial && entry.task->needsLoading()) {
+                    enqueueTask(_tileSet, visTileId, _view);
+                }
             } else if (entry.needsLoading()) {
                 // Not yet available - enqueue for loading
                 if (!entry.task) {
@@ -391,14 +721,15 @@ void TileManager::updateTileSet(TileSet& _tileSet, const ViewState& _view) {
             // Can be removed once ClientDataSource is immutable
             if (entry.tile) {
                 auto sourceGeneration = entry.tile->sourceGeneration();
-                if ((sourceGeneration < generation) && !entry.isInProgress()) {
+                if ((sourceGeneration < _tileSet.source->tileGeneration(visTileId)) && !entry.isInProgress()) {
                     // Tile needs update - enqueue for loading
                     entry.task = _tileSet.source->createTask(visTileId);
+                    entry.task->setPreviousTile(entry.tile);
                     enqueueTask(_tileSet, visTileId, _view);
                 }
             } else if (entry.isCanceled()) {
                 auto sourceGeneration = entry.task->sourceGeneration();
-                if (sourceGeneration < generation) {
+                if (sourceGeneration < _tileSet.source->tileGeneration(visTileId)) {
                     // Tile needs update - enqueue for loading
                     entry.task = _tileSet.source->createTask(visTileId);
                     enqueueTask(_tileSet, visTileId, _view);
@@ -409,7 +740,7 @@ void TileManager::updateTileSet(TileSet& _tileSet, const ViewState& _view) {
                 m_tilesInProgress++;
             }
 
-            if (newTiles && entry.isInProgress()) {
+            if (newTiles && entry.isInProgress() && !entry.tile) {
                 // check again for proxies
                 updateProxyTiles(_tileSet, visTileId, entry);
             }
@@ -425,8 +756,10 @@ void TileManager::updateTileSet(TileSet& _tileSet, const ViewState& _view) {
             assert(visTilesIt != visibleTiles.end());
 
             if (!addTile(_tileSet, visTileId)) {
-                // Not in cache - enqueue for loading
-                enqueueTask(_tileSet, visTileId, _view);
+                // Not in cache - enqueue for loading, unless it was prefetched
+                if (_tileSet.tiles.find(visTileId)->second.needsLoading()) {
+                    enqueueTask(_tileSet, visTileId, _view);
+                }
                 m_tilesInProgress++;
             }
 
@@ -437,22 +770,23 @@ void TileManager::updateTileSet(TileSet& _tileSet, const ViewState& _view) {
             assert(curTilesIt != tiles.end());
 
             auto& entry = curTilesIt->second;
+            // Tiles of the additional views are kept for updateViewTiles()
+            bool viewTile = isViewTile(_tileSet, curTileId);
 
             if (entry.getProxyCounter() > 0) {
                 if (entry.tile) {
                     m_tiles.push_back(entry.tile);
-                } else if (entry.isInProgress()) {
+                } else if (entry.isInProgress() && !viewTile) {
                     if (curTileId.z >= maxZoom || curTileId.z <= minZoom) {
                         // Cancel tile loading but keep tile entry for referencing
                         // this tiles proxy tiles.
-                        _tileSet.source->cancelLoadingTile(*entry.task);
-                        entry.clearTask();
+                        entry.cancelTask(*_tileSet.source);
                     }
                 }
-            } else {
+            } else if (!viewTile) {
                 removeTiles.push_back(curTileId);
             }
-            entry.setVisible(false);
+            entry.setVisible(viewTile);
             ++curTilesIt;
         }
     }
@@ -491,7 +825,11 @@ void TileManager::updateTileSet(TileSet& _tileSet, const ViewState& _view) {
              entry.task && entry.task->isCanceled());
 #endif
 
-        if (entry.isInProgress()) {
+        if (entry.isCanceled()) {
+            // No data for the tile: stop loading its rasters
+            cancelTaskUnit(*_tileSet.source, *entry.task);
+
+        } else if (entry.isInProgress()) {
             auto& id = it.first;
             auto& task = entry.task;
 
@@ -501,6 +839,7 @@ void TileManager::updateTileSet(TileSet& _tileSet, const ViewState& _view) {
             if (scaleDiv < 1) { scaleDiv = 0.1/scaleDiv; } // prefer parent tiles
             task->setPriority(glm::length2(tileCenter - _view.center) * scaleDiv);
             task->setProxyState(entry.getProxyCounter() > 0);
+            if (!task->hasData()) { _tileSet.source->updateTilePriority(*task); }
         }
 
         if (entry.tile) {
@@ -510,6 +849,61 @@ void TileManager::updateTileSet(TileSet& _tileSet, const ViewState& _view) {
     }
 }
 
+void TileManager::updateViewTiles(TileSet& _tileSet, size_t _view, const ViewState& _viewState) {
+
+    auto& tiles = _tileSet.tiles;
+    auto& visibleTiles = _tileSet.visibleTiles;
+
+    for (auto& tileId : _tileSet.viewTiles[_view]) {
+        // Tiles of the main view are loaded by updateTileSet(), and those of an
+        // earlier view already
+        bool loaded = std::binary_search(visibleTiles.begin(), visibleTiles.end(), tileId);
+        for (size_t i = 0; i < _view && !loaded; i++) {
+            auto& viewTiles = _tileSet.viewTiles[i];
+            loaded = std::binary_search(viewTiles.begin(), viewTiles.end(), tileId);
+        }
+
+        auto it = tiles.find(tileId);
+        if (it == tiles.end()) {
+            if (loaded) { continue; }
+
+            auto tile = m_tileCache->get(_tileSet.source->id(), tileId);
+            if (tile && tile->sourceGeneration() >= _tileSet.source->tileGeneration(tileId)) {
+                tile->resetState();
+            } else {
+                tile.reset();
+            }
+            it = tiles.emplace(tileId, tile).first;
+        }
+
+        auto& entry = it->second;
+        if (entry.tile) {
+            m_viewTiles[_view].push_back(entry.tile);
+        }
+
+        if (loaded) { continue; }
+
+        entry.setVisible(true);
+
+        if (!entry.tile && entry.needsLoading()) {
+            if (!entry.task) {
+                entry.task = _tileSet.source->createTask(tileId);
+            }
+            enqueueTask(_tileSet, tileId, _viewState);
+        }
+        if (entry.isInProgress()) {
+            m_tilesInProgress++;
+        }
+    }
+}
+
+bool TileManager::isViewTile(const TileSet& _tileSet, const TileID& _tileID) const {
+    for (auto& viewTiles : _tileSet.viewTiles) {
+        if (std::binary_search(viewTiles.begin(), viewTiles.end(), _tileID)) { return true; }
+    }
+    return false;
+}
+
 void TileManager::enqueueTask(TileSet& _tileSet, const TileID& _tileID,
                               const ViewState& _view) {
 
@@ -527,18 +921,23 @@ void TileManager::enqueueTask(TileSet& _tileSet, const TileID& _tileID,
 
 void TileManager::loadTiles() {
 
+    m_loadBudget = loadBudget();
+
     if (m_loadTasks.empty()) { return; }
 
     for (auto& loadTask : m_loadTasks) {
 
+        if (m_loadBudget == 0) { break; }
+
         auto tileId = std::get<2>(loadTask);
         auto& tileSet = *std::get<1>(loadTask);
         auto tileIt = tileSet.tiles.find(tileId);
         auto& entry = tileIt->second;
 
         tileSet.source->loadTileData(entry.task, m_dataCallback);
+        m_loadBudget--;
 
-        LOGTO("Load Tile: %s", tileId.toString().c_str());
+        LOGC(tile, "Load Tile: %s", tileId.toString().c_str());
 
     }
 
@@ -549,19 +948,221 @@ void TileManager::loadTiles() {
     m_loadTasks.clear();
 }
 
+size_t TileManager::loadBudget() const {
+
+    size_t downloads = 0;
+    size_t builds = 0;
+
+    auto countTask = [&](const TileTask& _task) {
+        if (_task.isCanceled() || _task.needsLoading() || _task.isReady()) { return; }
+        if (_task.hasData()) {
+            builds++;
+        } else {
+            downloads++;
+        }
+    };
+
+    for (auto& tileSet : m_tileSets) {
+        for (auto& it : tileSet.tiles) {
+            if (it.second.task) { countTask(*it.second.task); }
+        }
+        for (auto& prefetch : tileSet.prefetchTasks) {
+            countTask(*prefetch.second);
+        }
+    }
+
+    if (downloads >= MAX_DOWNLOADS || builds >= MAX_PENDING_BUILDS) { return 0; }
+
+    // Each load becomes a pending build once its data arrives
+    return std::min(MAX_DOWNLOADS - downloads, MAX_PENDING_BUILDS - builds);
+}
+
+void TileManager::updatePrefetch(TileSet& _tileSet, const View& _view) {
+
+    auto& prefetchTasks = _tileSet.prefetchTasks;
+    auto sourceId = _tileSet.source->id();
+
+    // Move loaded tiles to the cache, where addTile finds them when they become visible
+    for (auto it = prefetchTasks.begin(); it != prefetchTasks.end();) {
+        auto& task = it->second;
+        bool ready = task->isReady() && std::all_of(task->subTasks().begin(), task->subTasks().end(),
+                                                    [](auto& _subTask) { return _subTask->isReady(); });
+        if (ready) {
+            task->complete();
+            std::shared_ptr<Tile> tile = task->getTile();
+            if (tile) { m_tileCache->put(sourceId, tile); }
+            it = prefetchTasks.erase(it);
+        } else if (task->isCanceled()) {
+            it = prefetchTasks.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    // Client sources have their data in memory
+    if (_tileSet.clientTileSource) { return; }
+
+    // Tiles along a camera animation are kept until it ends
+    if (_tileSet.pathPrefetch) { return; }
+
+    const glm::dvec2& translation = _view.getRemainingTranslation();
+    double distance = glm::length(translation);
+
+    // Prefetch when the view moves by at least half a tile before it stops
+    if (distance < 0.5 * MapProjection::metersPerTileAtZoom(_view.getIntegerZoom())) {
+        _tileSet.cancelPrefetchTasks();
+        return;
+    }
+
+    glm::dvec2 direction = translation / distance;
+
+    // Cancel when the direction changes by more than ~30 degrees
+    if (glm::dot(direction, _tileSet.prefetchDirection) < 0.85) {
+        _tileSet.cancelPrefetchTasks();
+        _tileSet.prefetchDirection = direction;
+    }
+
+    if (prefetchTasks.size() >= MAX_PREFETCH_TASKS || m_loadBudget == 0) { return; }
+
+    // The visible tiles moved to where the view comes to rest, and half way there,
+    // ordered by the distance to where the view comes to rest
+    glm::dvec2 target = glm::dvec2(_view.getPosition()) + translation;
+    std::vector<std::pair<double, TileID>> tiles;
+
+    for (auto& id : _tileSet.visibleTiles) {
+        double tileMeters = MapProjection::metersPerTileAtZoom(id.z);
+        for (double f : { 1.0, 0.5 }) {
+            // Tile y grows southwards
+            TileID tileId(id.x + int32_t(std::round(f * translation.x / tileMeters)),
+                          id.y - int32_t(std::round(f * translation.y / tileMeters)),
+                          id.z, id.s);
+
+            if (!tileId.isValid() ||
+                std::binary_search(_tileSet.visibleTiles.begin(), _tileSet.visibleTiles.end(), tileId) ||
+                _tileSet.tiles.count(tileId) ||
+                prefetchTasks.count(tileId) ||
+                m_tileCache->contains(sourceId, tileId)) {
+                continue;
+            }
+            tiles.emplace_back(glm::length2(MapProjection::tileCenter(tileId) - target), tileId);
+        }
+    }
+
+    std::sort(tiles.begin(), tiles.end(), [](auto& a, auto& b) { return a.first < b.first; });
+    auto end = std::unique(tiles.begin(), tiles.end(), [](auto& a, auto& b) { return a.second == b.second; });
+
+    for (auto it = tiles.begin(); it != end && prefetchTasks.size() < MAX_PREFETCH_TASKS && m_loadBudget > 0; ++it) {
+        auto& tileId = it->second;
+        if (prefetchTasks.count(tileId)) { continue; }
+
+        auto task = _tileSet.source->createTask(tileId);
+        // Build after the visible tiles
+        task->setPriority(glm::length2(MapProjection::tileCenter(tileId) - glm::dvec2(_view.getPosition())));
+
+        prefetchTasks.emplace(tileId, task);
+        _tileSet.source->loadTileData(task, m_dataCallback);
+        m_loadBudget--;
+
+        LOGC(tile, "Prefetch Tile: %s", tileId.toString().c_str());
+    }
+}
+
+void TileManager::prefetchPath(const std::vector<View>& _views) {
+
+    if (m_rebuildingLostTiles) { return; }
+
+    m_idle = false;
+
+    // Priorities of the tiles of each view, greater than those of visible tiles, which
+    // are squared distances in meters to the view center. They grow by one step per
+    // view and within a step by the distance to the center of the view.
+    const double priority_step = 1e16;
+
+    for (auto& tileSet : m_tileSets) {
+        tileSet.cancelPrefetchTasks();
+
+        if (tileSet.clientTileSource || !tileSet.source->isVisible()) { continue; }
+
+        tileSet.pathPrefetch = true;
+
+        auto& prefetchTasks = tileSet.prefetchTasks;
+        auto sourceId = tileSet.source->id();
+        auto zoomBias = tileSet.source->zoomBias();
+        auto maxZoom = tileSet.source->maxZoom();
+        double priority = 0;
+
+        for (auto& view : _views) {
+            priority += priority_step;
+            if (prefetchTasks.size() >= MAX_PATH_PREFETCH_TASKS) { break; }
+            if (!tileSet.source->isActiveForZoom(view.getZoom())) { continue; }
+
+            // The tiles of the view ordered by the distance to its center
+            glm::dvec2 center(view.getPosition());
+            std::vector<std::pair<double, TileID>> tiles;
+
+            view.getVisibleTiles([&](TileID _tileID) {
+                auto tileId = _tileID.zoomBiasAdjusted(zoomBias).withMaxSourceZoom(maxZoom);
+                if (tileSet.tiles.count(tileId) ||
+                    prefetchTasks.count(tileId) ||
+                    m_tileCache->contains(sourceId, tileId)) {
+                    return;
+                }
+                tiles.emplace_back(glm::length2(MapProjection::tileCenter(tileId) - center), tileId);
+            });
+
+            std::sort(tiles.begin(), tiles.end(), [](auto& a, auto& b) { return a.first < b.first; });
+
+            for (size_t i = 0; i < tiles.size(); i++) {
+                if (prefetchTasks.size() >= MAX_PATH_PREFETCH_TASKS) { break; }
+
+                auto& tileId = tiles[i].second;
+                if (prefetchTasks.count(tileId)) { continue; }
+
+                auto task = tileSet.source->createTask(tileId);
+                task->setPriority(priority + priority_step * i / tiles.size());
+
+                prefetchTasks.emplace(tileId, task);
+                tileSet.source->loadTileData(task, m_dataCallback);
+
+                LOGC(tile, "Prefetch Path Tile: %s", tileId.toString().c_str());
+            }
+        }
+    }
+
+    m_workers.updatePriorities();
+}
+
+void TileManager::cancelPathPrefetch() {
+    m_idle = false;
+    for (auto& tileSet : m_tileSets) {
+        if (tileSet.pathPrefetch) { tileSet.cancelPrefetchTasks(); }
+    }
+}
+
+void TileManager::endPathPrefetch() {
+    m_idle = false;
+    for (auto& tileSet : m_tileSets) {
+        tileSet.pathPrefetch = false;
+    }
+}
+
 bool TileManager::addTile(TileSet& _tileSet, const TileID& _tileID) {
 
+    auto lookupStart = Metrics::start();
     auto tile = m_tileCache->get(_tileSet.source->id(), _tileID);
+    Metrics::record(Metrics::Stage::cache_lookup, lookupStart);
+    std::shared_ptr<Tile> stale;
 
     if (tile) {
-        if (tile->sourceGeneration() == _tileSet.source->generation()) {
+        Metrics::count(Metrics::Counter::cache_hits);
+        if (tile->sourceGeneration() >= _tileSet.source->tileGeneration(_tileID)) {
             m_tiles.push_back(tile);
 
             // Reset tile on potential internal dynamic data set
             tile->resetState();
         } else {
-            // Clear stale tile data
-            tile.reset();
+            // Clear stale tile data, it is kept when the new data is the same
+            stale = std::move(tile);
         }
     }
 
@@ -572,7 +1173,18 @@ bool TileManager::addTile(TileSet& _tileSet, const TileID& _tileID) {
         // Add Proxy if corresponding proxy MapTile ready
         updateProxyTiles(_tileSet, _tileID, entry.first->second);
 
-        entry.first->second.task = _tileSet.source->createTask(_tileID);
+        // Take over the task when the tile is being prefetched
+        auto prefetch = _tileSet.prefetchTasks.find(_tileID);
+        if (prefetch != _tileSet.prefetchTasks.end()) {
+            if (!prefetch->second->isCanceled()) {
+                entry.first->second.task = std::move(prefetch->second);
+            }
+            _tileSet.prefetchTasks.erase(prefetch);
+        }
+        if (!entry.first->second.task) {
+            entry.first->second.task = _tileSet.source->createTask(_tileID);
+            entry.first->second.task->setPreviousTile(std::move(stale));
+        }
     }
     entry.first->second.setVisible(true);
 
@@ -582,15 +1194,13 @@ bool TileManager::addTile(TileSet& _tileSet, const TileID& _tileID) {
 void TileManager::removeTile(TileSet& _tileSet, std::map<TileID, TileEntry>::iterator& _tileIt) {
 
     auto& entry = _tileIt->second;
+    bool inProgress = entry.isInProgress();
 
-    if (entry.isInProgress()) {
-        // 1. Remove from Datasource. Make sure to cancel
-        //  the network request associated with this tile.
-        _tileSet.source->cancelLoadingTile(*entry.task);
+    // Make sure to cancel the network requests associated with this tile,
+    // including those of its rasters.
+    entry.cancelTask(*_tileSet.source);
 
-        entry.clearTask();
-
-    } else if (entry.tile) {
+    if (!inProgress && entry.tile) {
         // Add to cache
         m_tileCache->put(_tileSet.source->id(), entry.tile);
     }
@@ -711,4 +1321,49 @@ void TileManager::setCacheSize(size_t _cacheSize) {
     m_tileCache->limitCacheSize(_cacheSize);
 }
 
+void TileManager::getMemoryUsage(MemoryUsage& _usage) const {
+
+    // Raster textures are shared by tiles of different zoom levels
+    std::set<const Texture*> rasters;
+    for (const auto& tile : m_tiles) {
+        tile->getMeshMemoryUsage(_usage.cpuBytes[MemoryUsage::tile_meshes],
+                                 _usage.gpuBytes[MemoryUsage::tile_meshes]);
+
+        for (const auto& raster : tile->rasters()) {
+            if (raster.texture && rasters.insert(raster.texture.get()).second) {
+                _usage.cpuBytes[MemoryUsage::raster_textures] += raster.texture->cpuBytes();
+                _usage.gpuBytes[MemoryUsage::raster_textures] += raster.texture->gpuBytes();
+            }
+        }
+    }
+
+    size_t gpuBytes = m_tileCache->getGpuMemoryUsage();
+    _usage.cpuBytes[MemoryUsage::tile_cache] += m_tileCache->getMemoryUsage() - gpuBytes;
+    _usage.gpuBytes[MemoryUsage::tile_cache] += gpuBytes;
+
+    for (const auto* source : memorySources()) {
+        source->getMemoryUsage(_usage);
+    }
+}
+
+void TileManager::releaseSourceMemory() {
+    for (auto* source : memorySources()) {
+        source->releaseMemory();
+    }
+}
+
+std::vector<TileSource*> TileManager::memorySources() const {
+    std::vector<TileSource*> sources;
+    auto add = [&](TileSource* _source) {
+        if (std::find(sources.begin(), sources.end(), _source) == sources.end()) {
+            sources.push_back(_source);
+        }
+    };
+    for (const auto& tileSet : m_tileSets) {
+        add(tileSet.source.get());
+        for (auto* raster : tileSet.source->rasterSources()) { add(raster); }
+    }
+    return sources;
+}
+
 }
@@ -18,9 +18,11 @@ class Platform;
 
 namespace Tangram {
 
+class RenderState;
 class TileSource;
 class TileCache;
 class View;
+struct MemoryUsage;
 struct ViewState;
 
 /* Singleton container of <TileSet>s
@@ -32,6 +34,20 @@ class TileManager {
 
     const static size_t DEFAULT_CACHE_SIZE = 32*1024*1024; // 32 MB
 
+    /* Maximum number of prefetch tasks of a TileSet */
+    const static size_t MAX_PREFETCH_TASKS = 16;
+
+    /* Maximum number of prefetch tasks of a TileSet along a camera animation */
+    const static size_t MAX_PATH_PREFETCH_TASKS = 64;
+
+    /* Maximum number of tasks waiting for their data */
+    const static size_t MAX_DOWNLOADS = 32;
+
+    /* Maximum number of tasks with data waiting to be built. No more loads
+     * start while the workers are behind, so that tile data does not pile up
+     * in their queue. */
+    const static size_t MAX_PENDING_BUILDS = 32;
+
 public:
 
     TileManager(Platform& platform, TileTaskQueue& _tileWorker);
@@ -41,24 +57,64 @@ public:
     /* Sets the tile TileSources */
     void setTileSources(const std::vector<std::shared_ptr<TileSource>>& _sources);
 
-    /* Updates visible tile set and load missing tiles */
-    void updateTileSets(const View& _view);
+    /* Updates visible tile set and load missing tiles. The tiles of _views are
+     * loaded along with those of _view, see getViewTiles(). Returns early when
+     * no task is running and the views, the sources and the tile sets did not
+     * change since the last update. */
+    void updateTileSets(const View& _view, const std::vector<const View*>& _views = {});
+
+    /* Upload the geometry of loaded tiles, closest to the view center first,
+     * until the upload budget of _rs for this frame is used. Once this is
+     * called, loaded tiles replace their proxy tiles only after their upload.
+     * Returns true when tiles were waiting for upload. */
+    bool uploadTiles(RenderState& _rs);
 
     void clearTileSets(bool clearSourceCaches = false);
 
+    /* Clears the tiles of a lost GL context, which are built again from the
+     * data in the caches of the sources. Until the tiles in view are loaded,
+     * tiles of additional views and prefetches are not loaded. */
+    void rebuildLostTiles();
+
     void clearTileSet(int32_t _sourceId);
 
+    /* Replace the source of the scene TileSet with the same name as _source
+     * and clear its tiles. Returns false when there is no such TileSet. */
+    bool replaceTileSource(std::shared_ptr<TileSource> _source);
+
     void cancelTileTasks();
 
+    /* Do not load the tiles of the sources named _sources until they are taken
+     * from another TileManager by adoptTiles(). Sources that are not named are
+     * released. */
+    void holdTileSets(const std::vector<std::string>& _sources);
+
+    /* Take the tiles in view of _previous, the TileManager of a previous scene
+     * with the same styles, for the held sources of the same name. Label styles
+     * are built again, the tiles are shown without them until then. Tiles of
+     * interactive features or with rasters are loaded again. */
+    void adoptTiles(TileManager& _previous, const std::vector<bool>& _labelStyles);
+
     /* Returns the set of currently visible tiles */
     const auto& getVisibleTiles() const { return m_tiles; }
 
+    /* Returns the loaded tiles of the additional view _view of updateTileSets(),
+     * without proxies */
+    const std::vector<std::shared_ptr<Tile>>& getViewTiles(size_t _view) const;
+
     bool hasTileSetChanged() const { return m_tileSetChanged; }
 
     bool hasLoadingTiles() const {
         return m_tilesInProgress > 0;
     }
 
+    /* Limit the number of tiles that are completed by one updateTileSets(), 0
+     * when unlimited. Other ready tiles are completed by later updates. */
+    void setCompletionLimit(uint32_t _tiles) { m_completionLimit = _tiles; }
+
+    /* Whether ready tiles were left for a later update by the completion limit */
+    bool hasDeferredTiles() const { return m_completionDeferred; }
+
     std::shared_ptr<TileSource> getClientTileSource(int32_t _sourceId);
 
     void addClientTileSource(std::shared_ptr<TileSource> _source);
@@ -72,6 +128,25 @@ public:
      */
     void setCacheSize(size_t _cacheSize);
 
+    /* Adds the memory used by the tiles in view, the tile cache and the sources to _usage */
+    void getMemoryUsage(MemoryUsage& _usage) const;
+
+    /* Releases the cached data of the sources, see TileSource::releaseMemory() */
+    void releaseSourceMemory();
+
+    /* Starts loading the tiles of _views along a camera animation, ordered by their
+     * importance, e.g. the destination first. They load after the visible tiles and
+     * the tiles of each view after those of the previous one. Replaces other prefetch
+     * tasks, which would be canceled while the view does not move by itself. */
+    void prefetchPath(const std::vector<View>& _views);
+
+    /* Cancels the tasks of prefetchPath() that did not become visible */
+    void cancelPathPrefetch();
+
+    /* Lets the tiles of prefetchPath() in view at the end of the animation take over
+     * their tasks, and cancels the others with the next update */
+    void endPathPrefetch();
+
 protected:
 
     enum class ProxyID : uint8_t;
@@ -84,11 +159,27 @@ protected:
 
         std::shared_ptr<TileSource> source;
 
-        std::set<TileID> visibleTiles;
+        /* Sorted and unique */
+        std::vector<TileID> visibleTiles;
+        /* Sorted and unique visible tiles of each additional view */
+        std::vector<std::vector<TileID>> viewTiles;
         std::map<TileID, TileEntry> tiles;
 
+        /* Speculative tasks for tiles ahead of the moving view */
+        std::map<TileID, std::shared_ptr<TileTask>> prefetchTasks;
+        /* Direction of the view motion when the prefetch tasks were started */
+        glm::dvec2 prefetchDirection = glm::dvec2(0.0);
+        /* Whether the prefetch tasks are for the path of a camera animation */
+        bool pathPrefetch = false;
+        void cancelPrefetchTasks();
+
         int64_t sourceGeneration = 0;
+        /* Generation and visibility of the source when the TileManager became idle */
+        int64_t idleGeneration = 0;
+        bool idleVisible = false;
         bool clientTileSource;
+        /* Tiles are not loaded until they are taken by adoptTiles() */
+        bool held = false;
 
         TileSet(const TileSet&) = delete;
         TileSet(TileSet&&) = default;
@@ -98,10 +189,36 @@ protected:
 
     void updateTileSet(TileSet& tileSet, const ViewState& _view);
 
+    /* Whether the last update left the visible tiles of _view and _views as they are */
+    bool isIdle(const View& _view, const std::vector<const View*>& _views) const;
+
+    /*
+     * Loads the tiles of the additional view _view that are not visible in the
+     * main view and collects the loaded ones in m_viewTiles. Called after
+     * updateTileSet(), which keeps these tiles.
+     */
+    void updateViewTiles(TileSet& _tileSet, size_t _view, const ViewState& _viewState);
+
+    bool isViewTile(const TileSet& _tileSet, const TileID& _tileID) const;
+
     void enqueueTask(TileSet& _tileSet, const TileID& _tileID, const ViewState& _view);
 
+    /* Starts loading the tasks of enqueueTask() closest to the view first, as
+     * many as the load budget allows. The others are enqueued again by the
+     * next update. */
     void loadTiles();
 
+    /* Number of loads that can start without exceeding MAX_DOWNLOADS and
+     * MAX_PENDING_BUILDS */
+    size_t loadBudget() const;
+
+    /*
+     * Starts loading the tiles that come into view where the view comes to rest and on
+     * the way there, while the view is moving by itself. Cancels them when the direction
+     * of the motion changes. Moves loaded tiles into the tile cache.
+     */
+    void updatePrefetch(TileSet& _tileSet, const View& _view);
+
     /*
      * Constructs a future (async) to load data of a new visible tile this is
      *      also responsible for loading proxy tiles for the newly visible tiles
@@ -114,6 +231,9 @@ protected:
      */
     void removeTile(TileSet& _tileSet, std::map<TileID, TileEntry>::iterator& _tileIter);
 
+    /* The sources of the TileSets and their raster sources, each once */
+    std::vector<TileSource*> memorySources() const;
+
     /*
      * Checks and updates m_tileSet with proxy tiles for every new visible tile
      *  @_tile: Tile, the new visible tile for which proxies needs to be added
@@ -134,12 +254,28 @@ protected:
     /* Current tiles ready for rendering */
     std::vector<std::shared_ptr<Tile>> m_tiles;
 
+    /* Tiles ready for rendering of each additional view */
+    std::vector<std::vector<std::shared_ptr<Tile>>> m_viewTiles;
+
     std::unique_ptr<TileCache> m_tileCache;
 
     TileTaskQueue& m_workers;
 
     bool m_tileSetChanged = false;
 
+    /* The last update started no task and left none running */
+    bool m_idle = false;
+
+    // Set by rebuildLostTiles() while the tiles in view are loading
+    bool m_rebuildingLostTiles = false;
+
+    /* Tiles wait for uploadTiles() before they are shown */
+    bool m_scheduleUploads = false;
+
+    uint32_t m_completionLimit = 0;
+    uint32_t m_completedTiles = 0;
+    bool m_completionDeferred = false;
+
     /* Callback for TileSource:
      * Passes TileTask back with data for further processing by <TileWorker>s
      */
@@ -148,6 +284,9 @@ protected:
     /* Temporary list of tiles that need to be loaded */
     std::vector<std::tuple<double, TileSet*, TileID>> m_loadTasks;
 
+    /* Loads left for prefetching after loadTiles() */
+    size_t m_loadBudget = 0;
+
 };
 
 }
@@ -1,11 +1,17 @@
 #include "tile/tileTask.h"
 
 #include "data/tileSource.h"
+#include "debug/metrics.h"
+#include "debug/trace.h"
 #include "scene/scene.h"
+#include "style/style.h"
 #include "tile/tile.h"
 #include "tile/tileBuilder.h"
+#include "tile/tileDiskCache.h"
 #include "util/mapProjection.h"
 
+#include <chrono>
+
 namespace Tangram {
 
 TileTask::TileTask(TileID& _tileId, std::shared_ptr<TileSource> _source) :
@@ -22,34 +28,208 @@ TileTask::TileTask(TileID& _tileId, std::shared_ptr<TileSource> _source) :
 TileTask::~TileTask() {}
 
 std::unique_ptr<Tile> TileTask::getTile() {
+    if (m_partialTile && m_tile) {
+        m_partialTile->addMeshes(*m_tile);
+        m_tile.reset();
+        return std::move(m_partialTile);
+    }
     return std::move(m_tile);
 }
 
+std::unique_ptr<Tile> TileTask::getPartialTile() {
+    if (!m_partialReady) { return nullptr; }
+    return std::move(m_partialTile);
+}
+
 void TileTask::setTile(std::unique_ptr<Tile>&& _tile) {
     m_tile = std::move(_tile);
     m_ready = true;
 }
 
+void TileTask::setPreviousTile(std::shared_ptr<Tile> _tile) {
+    m_previousContentHash = _tile ? _tile->contentHash() : 0;
+    m_previousTile = std::move(_tile);
+}
+
+void TileTask::cancel() {
+    if (!m_canceled.exchange(true) && !m_ready) {
+        Metrics::count(Metrics::Counter::tiles_canceled);
+    }
+}
+
 void TileTask::process(TileBuilder& _tileBuilder) {
+    TRACE_SCOPE("TileTask::process");
 
     auto source = m_source.lock();
     if (!source) { return; }
 
-    auto tileData = source->parse(*this);
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = [&]() {
+        return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
 
-    if (tileData) {
-        m_tile = _tileBuilder.build(m_tileId, *tileData, *source);
+    const Scene& scene = _tileBuilder.scene();
+    auto* diskCache = scene.tileDiskCache();
+
+    // Second pass of a progressive build, or the labels of a tile that has
+    // the other meshes of a previous scene
+    if (m_partialData || m_labelsOnly) {
+        auto tileData = m_partialData ? std::move(m_partialData) : parse(_tileBuilder, *source);
+        if (!tileData) {
+            cancel();
+            return;
+        }
+        m_tile = std::make_unique<Tile>(m_tileId, source->id(), source->generation());
+        m_tile->initGeometry(int(scene.styles().size()));
+        if (!_tileBuilder.build(*m_tile, scene.labelStyles(), *tileData, *source, this)) {
+            m_tile.reset();
+            return;
+        }
+
+        m_tile->setBuildTime(m_partialBuildTime + elapsed());
+        Metrics::count(Metrics::Counter::tiles_built);
         m_ready = true;
-    } else {
+        return;
+    }
+
+    // Keep the previous build of the tile when the data did not change. Its
+    // rasters may have changed.
+    uint64_t contentHash = m_subTasks.empty() ? dataHash() : 0;
+    if (contentHash != 0 && contentHash == m_previousContentHash) {
+        m_keepPreviousTile = true;
+        m_ready = true;
+        return;
+    }
+
+    // Meshes restored from the TileDiskCache are not built again
+    std::vector<bool> buildStyles;
+    if (diskCache) {
+        auto lookupStart = Metrics::start();
+        m_tile = diskCache->load(m_tileId, *source, scene.tileCacheHash(), scene.styles(),
+                                 *scene.featureSelection(), *scene.featureState(), buildStyles);
+        Metrics::record(Metrics::Stage::cache_lookup, lookupStart);
+
+        if (m_tile) { Metrics::count(Metrics::Counter::cache_hits); }
+        if (m_tile && buildStyles.empty()) {
+            m_tile->setContentHash(contentHash);
+            m_tile->setBuildTime(elapsed());
+            m_ready = true;
+            return;
+        }
+    }
+
+    auto tileData = parse(_tileBuilder, *source);
+    if (!tileData) {
+        m_tile.reset();
         cancel();
+        return;
+    }
+
+    // Build the styles but labels first, when the tile is not restored from
+    // the TileDiskCache and has no rasters to wait for
+    std::vector<bool> secondPass;
+    if (scene.options().progressiveTiles && !diskCache && m_subTasks.empty()) {
+        secondPass = scene.labelStyles();
+    }
+
+    if (!secondPass.empty()) {
+        std::vector<bool> firstPass(secondPass.size());
+        for (size_t i = 0; i < secondPass.size(); i++) { firstPass[i] = !secondPass[i]; }
+
+        auto tile = std::make_unique<Tile>(m_tileId, source->id(), source->generation());
+        tile->initGeometry(int(scene.styles().size()));
+        if (!_tileBuilder.build(*tile, firstPass, *tileData, *source, this)) { return; }
+
+        m_partialBuildTime = elapsed();
+        tile->setBuildTime(m_partialBuildTime);
+        tile->setContentHash(contentHash);
+        m_partialData = std::move(tileData);
+        m_partialTile = std::move(tile);
+        m_partialReady = true;
+        return;
+    }
+
+    // Builds stop once the task is canceled
+    if (m_tile) {
+        if (!_tileBuilder.build(*m_tile, buildStyles, *tileData, *source, this)) {
+            m_tile.reset();
+            return;
+        }
+    } else {
+        m_tile = _tileBuilder.build(m_tileId, *tileData, *source, this);
+        if (!m_tile) { return; }
+
+        if (diskCache) {
+            diskCache->store(*m_tile, *source, scene.tileCacheHash(), scene.styles(),
+                             *scene.featureState());
+        }
+    }
+    // Rebuild cost of the tile, for the TileCache
+    m_tile->setBuildTime(elapsed());
+    m_tile->setContentHash(contentHash);
+    Metrics::count(Metrics::Counter::tiles_built);
+    m_ready = true;
+}
+
+void TileTask::parseData() {
+    TRACE_SCOPE("TileTask::parseData");
+
+    m_parseDone = true;
+
+    auto source = m_source.lock();
+    if (!source || !hasData()) { return; }
+
+    // Without the Scene there are no layer filters, they are applied when building
+    bool overzoomed = m_tileId.s > m_tileId.z;
+    auto parseStart = Metrics::start();
+    m_parsedData = overzoomed ? source->parseOverzoomed(*this) : source->parse(*this);
+    Metrics::record(Metrics::Stage::parse, parseStart);
+}
+
+std::shared_ptr<TileData> TileTask::parse(TileBuilder& _tileBuilder, TileSource& _source) {
+    if (m_parsedData) { return std::move(m_parsedData); }
+
+    // Overzoomed tiles share the unfiltered data of their data tile, the
+    // layer filters of the styling zoom are applied when building.
+    bool overzoomed = m_tileId.s > m_tileId.z;
+    if (!overzoomed) {
+        m_featureFilter = &_tileBuilder.featureFilter(m_tileId, _source);
+    }
+    auto parseStart = Metrics::start();
+    std::shared_ptr<TileData> tileData;
+    {
+        TRACE_SCOPE("TileSource::parse");
+        tileData = overzoomed ? _source.parseOverzoomed(*this) : _source.parse(*this);
+    }
+    Metrics::record(Metrics::Stage::parse, parseStart);
+    m_featureFilter = nullptr;
+
+    return tileData;
+}
+
+uint64_t BinaryTileTask::dataHash() const {
+    // FNV-1a, 0 is left for data that is not hashed
+    const char* data = tileData();
+    size_t size = tileDataSize();
+    if (!data || size == 0) { return 0; }
+
+    uint64_t hash = 0xcbf29ce484222325;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= uint8_t(data[i]);
+        hash *= 0x100000001b3;
     }
+    return hash != 0 ? hash : 1;
 }
 
 void TileTask::complete() {
 
     for (auto& subTask : m_subTasks) {
-        assert(subTask->isReady());
-        subTask->complete(*this);
+        if (subTask->isReady()) {
+            subTask->complete(*this);
+        } else {
+            assert(subTask->hasProxy());
+            subTask->completeProxy(*this);
+        }
     }
 
 }
@@ -11,18 +11,15 @@
 
 #include <algorithm>
 
-#define WORKER_NICENESS 10
-
 namespace Tangram {
 
-TileWorker::TileWorker(Platform& _platform, int _numWorker) : m_platform(_platform) {
+TileWorker::TileWorker(Platform& _platform, int _numWorker, ThreadPool& _pool)
+    : m_numWorker(std::max(_numWorker, 1)),
+      m_pool(_pool),
+      m_platform(_platform) {
     m_running = true;
 
-    for (int i = 0; i < _numWorker; i++) {
-        auto worker = std::make_unique<Worker>();
-        worker->thread = std::thread(&TileWorker::run, this, worker.get());
-        m_workers.push_back(std::move(worker));
-    }
+    m_pool.reserveThreads(m_numWorker);
 }
 
 TileWorker::~TileWorker(){
@@ -31,120 +28,226 @@ TileWorker::~TileWorker(){
     }
 }
 
-void TileWorker::run(Worker* instance) {
+void TileWorker::scheduleJobs() {
+    if (!m_running) { return; }
 
-    setCurrentThreadPriority(WORKER_NICENESS);
+    if (!m_sceneComplete) {
+        while (m_parseQueued && m_scheduledJobs < m_numWorker) {
+            m_scheduledJobs++;
+            m_pool.enqueue(ThreadPool::Priority::tile, [this]{ run(); });
+        }
+        return;
+    }
 
-    std::unique_ptr<TileBuilder> builder;
+    // Do not schedule more jobs than there are TileBuilders, and no more
+    // waiting jobs than there are queued tasks.
+    size_t numBuilders = m_idleBuilders.size() + m_activeJobs;
 
-    while (true) {
+    while (m_scheduledJobs < numBuilders &&
+           m_scheduledJobs - m_activeJobs < m_queue.size()) {
+        m_scheduledJobs++;
+        m_pool.enqueue(ThreadPool::Priority::tile, [this]{ run(); });
+    }
+}
 
-        std::shared_ptr<TileTask> task;
-        {
-            std::unique_lock<std::mutex> lock(m_mutex);
+void TileWorker::run() {
 
-            m_condition.wait(lock, [&] {
-                return (!m_queue.empty() && m_sceneComplete) || !m_running || instance->tileBuilder;
-            });
+    std::unique_lock<std::mutex> lock(m_mutex);
 
-            if (instance->tileBuilder) {
-                LOGTInit();
-                builder = std::move(instance->tileBuilder);
-                builder->init();
-                LOGT("Took init of TileBuilder");
-            }
-            // Check if thread should stop
-            if (!m_running) {
-                break;
-            }
+    std::shared_ptr<TileTask> task;
 
-            if (!builder || !m_sceneComplete) {
-                if (builder) LOGTO("Waiting for Scene to become ready");
-                continue;
-            }
-
-            // Remove all canceled tasks
-            auto removes = std::remove_if(m_queue.begin(), m_queue.end(),
-                                          [](const auto& a) { return a->isCanceled(); });
+    if (m_running && !m_sceneComplete) {
+        task = popParseTask();
+        if (!task) {
+            m_parseQueued = false;
+        } else {
+            lock.unlock();
 
-            m_queue.erase(removes, m_queue.end());
+            LOGC(tile, ">>> parse %s", task->tileId().toString().c_str());
+            task->parseData();
+            LOGC(tile, "<<< parse %s", task->tileId().toString().c_str());
 
-            if (m_queue.empty()) {
-                continue;
+            lock.lock();
+            if (m_running && !task->isCanceled()) {
+                m_queue.emplace_back(std::move(task));
+                std::push_heap(m_queue.begin(), m_queue.end(), processAfter);
             }
+            task.reset();
+        }
+    } else if (m_running && !m_idleBuilders.empty()) {
+
+        // Pop highest priority tile from queue, skip canceled tasks
+        while (!m_queue.empty()) {
+            std::pop_heap(m_queue.begin(), m_queue.end(), processAfter);
+            task = std::move(m_queue.back().task);
+            m_queue.pop_back();
 
-            // Pop highest priority tile from queue
-            auto it = std::min_element(m_queue.begin(), m_queue.end(),
-                [](const auto& a, const auto& b) {
-                    if (a->isProxy() != b->isProxy()) {
-                        return !a->isProxy();
-                    }
-                    if (a->sourceId() == b->sourceId() &&
-                        a->sourceGeneration() != b->sourceGeneration()) {
-                        return a->sourceGeneration() < b->sourceGeneration();
-                    }
-                    return a->getPriority() < b->getPriority();
-                });
-
-            task = std::move(*it);
-            m_queue.erase(it);
+            if (!task->isCanceled()) { break; }
+            task.reset();
         }
+    }
+
+    if (task) {
+        Builder builder = std::move(m_idleBuilders.back());
+        m_idleBuilders.pop_back();
+        m_activeJobs++;
+
+        lock.unlock();
 
-        if (task->isCanceled()) { continue; }
+        if (!builder.initialized) {
+            LOGTInit();
+            builder.tileBuilder->init();
+            builder.initialized = true;
+            LOGT("Took init of TileBuilder");
+        }
 
-        LOGTInit(">>> process %s", task->tileId().toString().c_str());
-        task->process(*builder);
-        LOGT("<<< process %s", task->tileId().toString().c_str());
+        LOGC(tile, ">>> process %s", task->tileId().toString().c_str());
+        task->process(*builder.tileBuilder);
+        LOGC(tile, "<<< process %s", task->tileId().toString().c_str());
 
         m_platform.requestRender();
+
+        lock.lock();
+        m_idleBuilders.push_back(std::move(builder));
+        m_activeJobs--;
+
+        // Queue progressive builds again for their second pass
+        if (m_running && task->needsSecondPass() && !task->isCanceled()) {
+            m_queue.emplace_back(std::move(task));
+            std::push_heap(m_queue.begin(), m_queue.end(), processAfter);
+        }
+    }
+
+    m_scheduledJobs--;
+
+    scheduleJobs();
+
+    if (m_scheduledJobs == 0 || m_activeJobs == 0) {
+        // Wake up stop() and pause()
+        m_condition.notify_all();
+    }
+}
+
+TileWorker::QueueEntry::QueueEntry(std::shared_ptr<TileTask> _task)
+    : task(std::move(_task)),
+      priority(task->getPriority()),
+      proxy(task->isProxy()),
+      secondPass(task->needsSecondPass()) {}
+
+std::shared_ptr<TileTask> TileWorker::popParseTask() {
+    auto next = m_queue.end();
+    for (auto it = m_queue.begin(); it != m_queue.end(); ++it) {
+        if (!it->task->needsParse()) { continue; }
+        if (next == m_queue.end() || processAfter(*next, *it)) { next = it; }
+    }
+    if (next == m_queue.end()) { return nullptr; }
+
+    auto task = std::move(next->task);
+    if (next != m_queue.end() - 1) { *next = std::move(m_queue.back()); }
+    m_queue.pop_back();
+    std::make_heap(m_queue.begin(), m_queue.end(), processAfter);
+
+    return task;
+}
+
+bool TileWorker::processAfter(const QueueEntry& _a, const QueueEntry& _b) {
+    // Non-proxy tiles first, then first passes of progressive builds, then
+    // older generations of the same source, then by distance to the view center.
+    if (_a.proxy != _b.proxy) {
+        return _a.proxy;
+    }
+    if (_a.secondPass != _b.secondPass) {
+        return _a.secondPass;
+    }
+    auto& a = *_a.task;
+    auto& b = *_b.task;
+    if (a.sourceId() == b.sourceId() &&
+        a.sourceGeneration() != b.sourceGeneration()) {
+        return a.sourceGeneration() > b.sourceGeneration();
     }
+    return _a.priority > _b.priority;
+}
+
+void TileWorker::rebuildQueue() {
+
+    // Remove all canceled tasks and take a new snapshot of the priorities
+    std::vector<QueueEntry> queue;
+    queue.reserve(m_queue.size());
+
+    for (auto& entry : m_queue) {
+        if (entry.task->isCanceled()) { continue; }
+        queue.emplace_back(std::move(entry.task));
+    }
+    std::make_heap(queue.begin(), queue.end(), processAfter);
+
+    m_queue.swap(queue);
 }
 
 void TileWorker::setScene(Scene& _scene) {
-    {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        for (auto& worker : m_workers) {
-            worker->tileBuilder = std::make_unique<TileBuilder>(_scene);
-        }
-        m_condition.notify_all();
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    // TileBuilders are initialized by the first job that uses them
+    m_idleBuilders.clear();
+    for (size_t i = 0; i < m_numWorker; i++) {
+        m_idleBuilders.emplace_back();
+        m_idleBuilders.back().tileBuilder = std::make_unique<TileBuilder>(_scene);
     }
+    scheduleJobs();
 }
 
 void TileWorker::enqueue(std::shared_ptr<TileTask> task) {
     {
         std::unique_lock<std::mutex> lock(m_mutex);
         if (!m_running) { return; }
-        LOGTO("--- %d enqueue %s", m_queue.size()+1, task->tileId().toString().c_str());
-        m_queue.push_back(std::move(task));
+        LOGC(tile, "--- %d enqueue %s", int(m_queue.size()+1), task->tileId().toString().c_str());
+        if (task->needsParse()) { m_parseQueued = true; }
+        m_queue.emplace_back(std::move(task));
+        std::push_heap(m_queue.begin(), m_queue.end(), processAfter);
 
-        m_condition.notify_all();
+        scheduleJobs();
     }
 }
 
+void TileWorker::updatePriorities() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    // Release the data of tasks of tiles that are gone right away, rather
+    // than when a worker gets to them
+    rebuildQueue();
+}
+
+size_t TileWorker::queuedTasks() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_queue.size();
+}
+
 void TileWorker::startJobs() {
     {
         std::unique_lock<std::mutex> lock(m_mutex);
         m_sceneComplete = true;
 
         LOGTO("Poking TileWorker - enqueued %d", m_queue.size());
-        if (!m_running || m_queue.empty()) { return; }
 
-        m_condition.notify_all();
+        scheduleJobs();
     }
 }
 
+void TileWorker::pause() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_sceneComplete = false;
+
+    m_condition.wait(lock, [&]{ return m_activeJobs == 0; });
+}
+
 void TileWorker::stop() {
-    {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        m_running = false;
-        m_condition.notify_all();
-    }
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_running = false;
 
-    for (auto& worker : m_workers) {
-        worker->thread.join();
-    }
+    // Wait for scheduled jobs, they keep a reference to this TileWorker
+    m_condition.wait(lock, [&]{ return m_scheduledJobs == 0; });
 
     m_queue.clear();
+    m_idleBuilders.clear();
 }
 
 }
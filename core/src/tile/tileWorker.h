@@ -2,12 +2,12 @@
 
 #include "tile/tileTask.h"
 #include "util/jobQueue.h"
+#include "util/threadPool.h"
 
 #include <atomic>
 #include <condition_variable>
 #include <memory>
 #include <mutex>
-#include <thread>
 #include <vector>
 
 namespace Tangram {
@@ -17,46 +17,103 @@ class Platform;
 class Scene;
 class TileBuilder;
 
+/* TileWorker processes TileTasks on a ThreadPool
+ *
+ * At most _numWorker tasks are processed at the same time, each with its own
+ * TileBuilder. Pool jobs are scheduled on demand and process one task each.
+ * Until the Scene is complete, jobs parse the data of queued tasks instead, so
+ * that tiles loaded during startup are only styled once the Scene is ready.
+ */
 class TileWorker : public TileTaskQueue {
 
 public:
 
-    TileWorker(Platform& _platform, int _numWorker);
+    TileWorker(Platform& _platform, int _numWorker, ThreadPool& _pool = ThreadPool::shared());
 
     virtual ~TileWorker();
 
     virtual void enqueue(std::shared_ptr<TileTask> task) override;
 
+    /// Drop canceled tasks and reorder queued tasks by their current priority
+    virtual void updatePriorities() override;
+
     void stop();
 
     bool isRunning() const { return m_running; }
 
+    /// Number of tasks waiting for a job
+    size_t queuedTasks();
+
     /// Set Scene and initialize TileBuilders
     void setScene(Scene& _scene);
 
     /// Start jobs when scene is complete.
     void startJobs();
 
+    /// Stop processing tasks until startJobs() and wait for running jobs,
+    /// so that the Scene data used by TileBuilders can be modified.
+    void pause();
+
 private:
 
-    struct Worker {
-        std::thread thread;
+    struct Builder {
         std::unique_ptr<TileBuilder> tileBuilder;
+        bool initialized = false;
+    };
+
+    /// Queued task with the ordering keys it had when the queue was last sorted
+    struct QueueEntry {
+        std::shared_ptr<TileTask> task;
+        double priority;
+        bool proxy;
+        bool secondPass;
+
+        QueueEntry(std::shared_ptr<TileTask> _task);
     };
 
-    void run(Worker* instance);
+    /// Heap comparator: true when _a is to be processed after _b
+    static bool processAfter(const QueueEntry& _a, const QueueEntry& _b);
+
+    /// Drop canceled tasks and rebuild the heap. Requires m_mutex.
+    void rebuildQueue();
+
+    /// Schedule pool jobs for queued tasks while builders are available. Requires m_mutex.
+    void scheduleJobs();
+
+    /// Pool job: process the next queued task with an idle TileBuilder, or
+    /// parse the data of one while the Scene is not complete
+    void run();
+
+    /// Remove the next queued task that needs parsing from the queue. Requires m_mutex.
+    std::shared_ptr<TileTask> popParseTask();
 
     bool m_running;
 
     /// Set true by startJobs()
     bool m_sceneComplete = false;
 
-    std::vector<std::unique_ptr<Worker>> m_workers;
+    /// Whether queued tasks may need parsing, until a job finds none
+    bool m_parseQueued = false;
+
+    const size_t m_numWorker;
+
+    /// Number of jobs scheduled on the pool and not yet finished
+    size_t m_scheduledJobs = 0;
+
+    /// Number of jobs currently processing a task
+    size_t m_activeJobs = 0;
+
+    /// TileBuilders not used by a running job
+    std::vector<Builder> m_idleBuilders;
+
+    ThreadPool& m_pool;
 
     std::condition_variable m_condition;
 
     std::mutex m_mutex;
-    std::vector<std::shared_ptr<TileTask>> m_queue;
+
+    /// Binary heap of queued tasks, top is the next task to process
+    std::vector<QueueEntry> m_queue;
 
     Platform& m_platform;
 };
@@ -1,5 +1,8 @@
 #pragma once
 
+#include "platform.h"
+#include "util/threadPool.h"
+
 #include <condition_variable>
 #include <deque>
 #include <mutex>
@@ -7,6 +10,11 @@
 
 namespace Tangram {
 
+// AsyncWorker runs tasks one at a time in FIFO order.
+//
+// By default it owns a thread. When constructed with a ThreadPool the tasks
+// are run on the pool instead, still one at a time and in order.
+
 class AsyncWorker {
 public:
 
@@ -14,7 +22,18 @@ public:
         thread = std::thread(&AsyncWorker::run, this);
     }
 
+    AsyncWorker(ThreadPool& _pool, ThreadPool::Priority _priority)
+        : m_pool(&_pool), m_priority(_priority) {}
+
     ~AsyncWorker() {
+        if (m_pool) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_running = false;
+            if (!m_waitForCompletion) { m_queue.clear(); }
+            // Wait for the pool to finish the currently scheduled drain job
+            m_condition.wait(lock, [&]{ return !m_scheduled; });
+            return;
+        }
         {
             std::unique_lock<std::mutex> lock(m_mutex);
             m_running = false;
@@ -29,6 +48,14 @@ public:
             if (!m_running) { return; }
 
             m_queue.push_back(std::move(_task));
+
+            if (m_pool) {
+                if (!m_scheduled) {
+                    m_scheduled = true;
+                    m_pool->enqueue(m_priority, [this]{ drain(); });
+                }
+                return;
+            }
         }
         m_condition.notify_one();
     }
@@ -39,6 +66,7 @@ public:
 private:
 
     void run() {
+        uint32_t placementGeneration = 0;
         while (true) {
             std::function<void()> task;
             {
@@ -56,11 +84,35 @@ private:
                 task = std::move(m_queue.front());
                 m_queue.pop_front();
             }
+            ThreadPool::applyThreadPlacement(ThreadRole::io, placementGeneration);
+            task();
+        }
+    }
+
+    // Runs on the ThreadPool: process queued tasks until the queue is empty
+    void drain() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                if (m_queue.empty() || (!m_running && !m_waitForCompletion)) {
+                    m_queue.clear();
+                    m_scheduled = false;
+                    // NB: 'this' may be destroyed right after the lock is released
+                    m_condition.notify_all();
+                    return;
+                }
+                task = std::move(m_queue.front());
+                m_queue.pop_front();
+            }
             task();
         }
     }
-    
+
     std::thread thread;
+    ThreadPool* m_pool = nullptr;
+    ThreadPool::Priority m_priority = ThreadPool::Priority::background;
+    bool m_scheduled = false;
     std::atomic<bool> m_running {true};
     std::atomic<bool> m_waitForCompletion {false};
     std::condition_variable m_condition;
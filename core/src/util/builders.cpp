@@ -5,6 +5,19 @@
 #include "glm/gtx/rotate_vector.hpp"
 #include "glm/gtx/norm.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TANGRAM_SEGMENTS_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define TANGRAM_SEGMENTS_NEON
+#endif
+
 namespace mapbox { namespace util {
 template <>
 struct nth<0, Tangram::Point> {
@@ -16,9 +29,161 @@ struct nth<1, Tangram::Point> {
 };
 }}
 
-namespace {
+namespace Tangram {
+
+bool Builders::isCollinear(const glm::vec2& _a, const glm::vec2& _b, const glm::vec2& _c) {
+    glm::vec2 ab = _b - _a;
+    glm::vec2 bc = _c - _b;
+    // Turn at _b of less than ~0.06 degrees
+    float cross = ab.x * bc.y - ab.y * bc.x;
+    return glm::dot(ab, bc) > 0.f &&
+        std::abs(cross) <= 1e-3f * glm::length(ab) * glm::length(bc);
+}
+
+void Builders::simplifyLine(const LineView& _line, float _tolerance, std::vector<Point>& _out) {
+    size_t size = _line.size();
+    if (size < 3 || _tolerance <= 0.f) {
+        _out.insert(_out.end(), _line.begin(), _line.end());
+        return;
+    }
+
+    std::vector<bool> keep(size, false);
+    keep[0] = keep[size - 1] = true;
+
+    float tolerance2 = _tolerance * _tolerance;
+    std::vector<std::pair<size_t, size_t>> stack{{ 0, size - 1 }};
+
+    while (!stack.empty()) {
+        auto range = stack.back();
+        stack.pop_back();
+
+        const Point& a = _line[range.first];
+        const Point& b = _line[range.second];
+        glm::vec2 ab = b - a;
+        float length2 = glm::dot(ab, ab);
+
+        // Farthest point from the segment, or from its start in closed rings
+        float max = 0.f;
+        size_t farthest = 0;
+        for (size_t i = range.first + 1; i < range.second; i++) {
+            glm::vec2 ap = _line[i] - a;
+            float t = length2 > 0.f ? glm::clamp(glm::dot(ap, ab) / length2, 0.f, 1.f) : 0.f;
+            float d2 = glm::length2(ap - ab * t);
+            if (d2 > max) {
+                max = d2;
+                farthest = i;
+            }
+        }
+        if (max <= tolerance2) { continue; }
+
+        keep[farthest] = true;
+        if (farthest - range.first > 1) { stack.emplace_back(range.first, farthest); }
+        if (range.second - farthest > 1) { stack.emplace_back(farthest, range.second); }
+    }
+
+    size_t kept = std::count(keep.begin(), keep.end(), true);
+    bool ring = _line.front() == _line.back();
+    if (ring && kept < 4) {
+        _out.insert(_out.end(), _line.begin(), _line.end());
+        return;
+    }
+
+    _out.reserve(_out.size() + kept);
+    for (size_t i = 0; i < size; i++) {
+        if (keep[i]) { _out.push_back(_line[i]); }
+    }
+}
+
+PolygonView Builders::simplifyPolygon(const PolygonView& _polygon, float _tolerance, GeometryBuffer& _buffer) {
+    size_t first = _buffer.numLines();
+    for (const auto& ring : _polygon) {
+        simplifyLine(ring, _tolerance, _buffer.coordinates);
+        _buffer.lines.push_back(_buffer.coordinates.size());
+    }
+    return PolygonView(&_buffer, first, _buffer.numLines());
+}
+
+bool Builders::isInsideTile(const LineView& _line) {
+    // Without branches, so that the bounds of long rings are found quickly
+    float minX = 0.f, minY = 0.f, maxX = 1.f, maxY = 1.f;
+    for (const auto& p : _line) {
+        minX = std::min(minX, p.x);
+        minY = std::min(minY, p.y);
+        maxX = std::max(maxX, p.x);
+        maxY = std::max(maxY, p.y);
+    }
+    return minX >= 0.f && minY >= 0.f && maxX <= 1.f && maxY <= 1.f;
+}
+
+// Clip the ring _in to one side of the tile, keeping the points where
+// _sign * p[_axis] <= _sign * _bound
+static void clipRingSide(const std::vector<Point>& _in, std::vector<Point>& _out,
+                         int _axis, float _bound, float _sign) {
+    _out.clear();
+    if (_in.empty()) { return; }
+
+    Point prev = _in.back();
+    bool prevInside = _sign * prev[_axis] <= _sign * _bound;
+
+    for (const auto& p : _in) {
+        bool inside = _sign * p[_axis] <= _sign * _bound;
+        if (inside != prevInside) {
+            float t = (_bound - prev[_axis]) / (p[_axis] - prev[_axis]);
+            Point q = prev + (p - prev) * t;
+            // Exactly on the tile edge
+            q[_axis] = _bound;
+            _out.push_back(q);
+        }
+        if (inside) { _out.push_back(p); }
+        prev = p;
+        prevInside = inside;
+    }
+}
+
+bool Builders::clipRing(const LineView& _ring, std::vector<Point>& _out) {
+    if (_ring.size() < 4) { return false; }
+
+    // Open ring, closed again below
+    std::vector<Point> ring(_ring.begin(), _ring.end());
+    if (ring.front() == ring.back()) { ring.pop_back(); }
+
+    std::vector<Point> clipped;
+    clipRingSide(ring, clipped, 0, 0.f, -1.f);
+    clipRingSide(clipped, ring, 0, 1.f, 1.f);
+    clipRingSide(ring, clipped, 1, 0.f, -1.f);
+    clipRingSide(clipped, ring, 1, 1.f, 1.f);
+
+    if (ring.size() < 3) { return false; }
+
+    _out.insert(_out.end(), ring.begin(), ring.end());
+    _out.push_back(ring.front());
+    return true;
+}
+
+PolygonView Builders::clipPolygon(const PolygonView& _polygon, GeometryBuffer& _buffer) {
+    bool inside = true;
+    for (const auto& ring : _polygon) {
+        if (!isInsideTile(ring)) {
+            inside = false;
+            break;
+        }
+    }
+    if (inside) { return _polygon; }
+
+    size_t first = _buffer.numLines();
+    for (const auto& ring : _polygon) {
+        if (clipRing(ring, _buffer.coordinates)) {
+            _buffer.lines.push_back(_buffer.coordinates.size());
+        } else if (_buffer.numLines() == first) {
+            // Holes are not drawn without their outer ring
+            return PolygonView(&_buffer, first, first);
+        }
+    }
+    return PolygonView(&_buffer, first, _buffer.numLines());
+}
+
 // Tests if a line segment (from point A to B) is outside the edge of a tile
-bool isOutsideTile(const glm::vec2& _a, const glm::vec2& _b) {
+bool Builders::isOutsideTile(const glm::vec2& _a, const glm::vec2& _b) {
 
     // tweak this adjust if catching too few/many line segments near tile edges
     // TODO: make tolerance configurable by source if necessary
@@ -35,9 +200,6 @@ bool isOutsideTile(const glm::vec2& _a, const glm::vec2& _b) {
 
     return false;
 }
-}
-
-namespace Tangram {
 
 CapTypes CapTypeFromString(const std::string& str) {
     if (str == "square") { return CapTypes::square; }
@@ -51,396 +213,263 @@ JoinTypes JoinTypeFromString(const std::string& str) {
     return JoinTypes::miter;
 }
 
-void Builders::buildPolygon(const Polygon& _polygon, float _height, PolygonBuilder& _ctx) {
+// Smaller polygons are cheaper to triangulate than to look up
+static constexpr size_t min_cached_points = 12;
+static constexpr size_t max_cached_points = 4096;
+static constexpr size_t max_cached_polygons = 512;
+
+static std::atomic<bool> s_collectStats{false};
+static std::atomic<uint64_t> s_tessellationNanos{0};
+static std::atomic<size_t> s_tessellatedPolygons{0};
+static std::atomic<size_t> s_convexPolygons{0};
+static std::atomic<size_t> s_cachedPolygons{0};
+
+Builders::TessellationStats Builders::tessellationStats() {
+    TessellationStats stats;
+    stats.nanoseconds = s_tessellationNanos;
+    stats.polygons = s_tessellatedPolygons;
+    stats.convex = s_convexPolygons;
+    stats.cached = s_cachedPolygons;
+    return stats;
+}
 
-    glm::vec2 min, max;
-    if (_ctx.useTexCoords) {
-        min = glm::vec2(std::numeric_limits<float>::max());
-        max = glm::vec2(std::numeric_limits<float>::min());
+void Builders::collectTessellationStats(bool _enable) {
+    s_collectStats = _enable;
+}
 
-        for (auto& p : _polygon[0]) {
-            min.x = std::min(min.x, p.x);
-            min.y = std::min(min.y, p.y);
-            max.x = std::max(max.x, p.x);
-            max.y = std::max(max.y, p.y);
+bool Builders::triangulateConvex(const PolygonView& _polygon, std::vector<uint16_t>& _indices) {
+    if (_polygon.size() != 1) { return false; }
+
+    auto ring = _polygon[0];
+    size_t n = ring.size();
+    // Rings are closed by repeating the first point
+    if (n > 0 && ring[0] == ring[n - 1]) { n--; }
+    if (n < 3) { return false; }
+
+    // All turns go the same way and the edges go around only once
+    float turn = 0;
+    int xFlips = 0, yFlips = 0;
+    float lastDx = 0, lastDy = 0;
+    glm::vec2 edge = ring[0] - ring[n - 1];
+
+    for (size_t i = 0; i < n; i++) {
+        glm::vec2 next = ring[(i + 1) % n] - ring[i];
+        // Skip repeated points
+        if (next == glm::vec2(0.f)) { continue; }
+        float cross = edge.x * next.y - edge.y * next.x;
+        if (cross != 0) {
+            if (turn * cross < 0) { return false; }
+            turn = cross;
         }
-    }
-
-    // Run earcut, triangles are stored in _ctx.earcut.indices
-    _ctx.earcut(_polygon);
-
-    size_t sumPoints = 0;
-    for (auto& line : _polygon) {
-        sumPoints += line.size();
-    }
-
-    // Mark the points that are referenced by indices as used.
-    size_t sumVertices = 0;
-    _ctx.used.assign(sumPoints, 0);
-    for (auto i : _ctx.earcut.indices) {
-        if (_ctx.used[i] == 0) {
-            _ctx.used[i] = 1;
-            sumVertices++;
+        if (next.x != 0) {
+            if (lastDx * next.x < 0) { xFlips++; }
+            lastDx = next.x;
         }
-    }
-
-    uint16_t vertexDataOffset = _ctx.numVertices;
-    _ctx.numVertices += sumVertices;
-
-    size_t ring = 0;
-    size_t offset = 0;
-
-    // Go through all points of the polyon.
-    for (size_t src = 0, dst = 0; src < sumPoints; src++) {
-        // The points of the polygon rings are indexed linearly.
-        // This maps the indices back to the original ring and point.
-        if (src - offset >= _polygon[ring].size()) {
-            offset += _polygon[ring].size();
-            ring += 1;
+        if (next.y != 0) {
+            if (lastDy * next.y < 0) { yFlips++; }
+            lastDy = next.y;
         }
+        edge = next;
+    }
+    if (turn == 0 || xFlips > 2 || yFlips > 2) { return false; }
 
-        // Add vertex only when the point is used.
-        if (_ctx.used[src] == 0) { continue; }
-
-        // Keep track of skipped points to update indices
-        _ctx.used[src] = dst++;
-
-        auto& p = _polygon[ring][src - offset];
-        glm::vec3 coord(p.x, p.y, _height);
-
-        if (_ctx.useTexCoords) {
-            glm::vec2 uv(mapRange01(coord.x, min.x, max.x), mapRange01(coord.y, max.y, min.y));
+    // Same winding as the triangles of earcut
+    float area = 0;
+    for (size_t i = 0, j = n - 1; i < n; j = i++) {
+        area += (ring[j].x - ring[i].x) * (ring[i].y + ring[j].y);
+    }
 
-            _ctx.addVertex(coord, glm::vec3(0.0, 0.0, 1.0), uv);
+    _indices.clear();
+    for (uint16_t i = 1; i + 1 < n; i++) {
+        _indices.push_back(0);
+        if (area > 0) {
+            _indices.push_back(i);
+            _indices.push_back(i + 1);
         } else {
-            _ctx.addVertex(coord, glm::vec3(0.0, 0.0, 1.0), glm::vec2(0));
+            _indices.push_back(i + 1);
+            _indices.push_back(i);
         }
     }
-
-    for (auto i : _ctx.earcut.indices) {
-        _ctx.indices.push_back(vertexDataOffset + _ctx.used[i]);
-    }
+    return true;
 }
 
-void Builders::buildPolygonExtrusion(const Polygon& _polygon, float _minHeight, float _maxHeight, PolygonBuilder& _ctx) {
-
-    auto vertexDataOffset = _ctx.numVertices;
-
-    static const glm::vec3 upVector(0.0f, 0.0f, 1.0f);
-    glm::vec3 normalVector;
-
-    for (auto& line : _polygon) {
+void Builders::triangulateCached(const PolygonView& _polygon, PolygonBuilder& _ctx) {
 
-        size_t lineSize = line.size();
-
-        for (size_t i = 0; i < lineSize - 1; i++) {
+    size_t sumPoints = 0;
+    for (const auto& ring : _polygon) { sumPoints += ring.size(); }
 
-            glm::vec3 a(line[i], 0.f);
-            glm::vec3 b(line[i+1], 0.f);
+    if (sumPoints < min_cached_points || sumPoints > max_cached_points) {
+        _ctx.earcut(_polygon);
+        return;
+    }
 
-            if (!_ctx.keepTileEdges && isOutsideTile(a, b)) {
-                continue;
-            }
-            normalVector = glm::cross(upVector, b - a);
-            normalVector = glm::normalize(normalVector);
+    // FNV-1a of the ring sizes and the point offsets
+    glm::vec2 origin = _polygon[0][0];
+    uint64_t hash = 14695981039346656037ull;
+    auto combine = [&](uint32_t _value) {
+        hash = (hash ^ _value) * 1099511628211ull;
+    };
+    for (const auto& ring : _polygon) {
+        combine(uint32_t(ring.size()));
+        for (const auto& p : ring) {
+            glm::vec2 offset = p - origin;
+            uint32_t bits[2];
+            std::memcpy(bits, &offset, sizeof(bits));
+            combine(bits[0]);
+            combine(bits[1]);
+        }
+    }
 
-            if (std::isnan(normalVector.x)
-             || std::isnan(normalVector.y)
-             || std::isnan(normalVector.z)) {
-                continue;
+    auto& cache = _ctx.triangulationCache;
+    auto it = cache.find(hash);
+    if (it != cache.end()) {
+        const auto& entry = it->second;
+        bool same = entry.ringSizes.size() == _polygon.size() && entry.offsets.size() == sumPoints;
+        for (size_t r = 0, i = 0; same && r < _polygon.size(); r++) {
+            auto ring = _polygon[r];
+            same = entry.ringSizes[r] == ring.size();
+            for (size_t j = 0; same && j < ring.size(); j++) {
+                same = entry.offsets[i++] == ring[j] - origin;
             }
-
-            // 1st vertex top
-            a.z = _maxHeight;
-            _ctx.addVertex(a, normalVector, glm::vec2(1.,1.));
-
-            // 2nd vertex top
-            b.z = _maxHeight;
-            _ctx.addVertex(b, normalVector, glm::vec2(0.,1.));
-
-            // 1st vertex bottom
-            a.z = _minHeight;
-            _ctx.addVertex(a, normalVector, glm::vec2(1.,0.));
-
-            // 2nd vertex bottom
-            b.z = _minHeight;
-            _ctx.addVertex(b, normalVector, glm::vec2(0.,0.));
-
-            // Start the index from the previous state of the vertex Data
-            _ctx.indices.push_back(vertexDataOffset);
-            _ctx.indices.push_back(vertexDataOffset + 1);
-            _ctx.indices.push_back(vertexDataOffset + 2);
-
-            _ctx.indices.push_back(vertexDataOffset + 1);
-            _ctx.indices.push_back(vertexDataOffset + 3);
-            _ctx.indices.push_back(vertexDataOffset + 2);
-
-            vertexDataOffset += 4;
         }
-
-        _ctx.numVertices = vertexDataOffset;
+        if (same) {
+            _ctx.earcut.indices = entry.indices;
+            if (s_collectStats) { s_cachedPolygons++; }
+            return;
+        }
     }
-}
 
-// Get 2D perpendicular of two points
-glm::vec2 perp2d(const glm::vec2& _v1, const glm::vec2& _v2 ){
-    return glm::vec2(_v2.y - _v1.y, _v1.x - _v2.x);
-}
-
-// Helper function for polyline tesselation
-inline void addPolyLineVertex(const glm::vec2& _coord, const glm::vec2& _normal, const glm::vec2& _uv, PolyLineBuilder& _ctx) {
-    _ctx.numVertices++;
-    _ctx.addVertex(_coord, _normal, _uv);
-}
+    _ctx.earcut(_polygon);
 
-// Helper function for polyline tesselation; adds indices for pairs of vertices arranged like a line strip
-void indexPairs( int _nPairs, int _nVertices, std::vector<uint16_t>& _indicesOut) {
-    for (int i = 0; i < _nPairs; i++) {
-        _indicesOut.push_back(_nVertices - 2*i - 4);
-        _indicesOut.push_back(_nVertices - 2*i - 2);
-        _indicesOut.push_back(_nVertices - 2*i - 3);
+    if (cache.size() >= max_cached_polygons) { cache.clear(); }
 
-        _indicesOut.push_back(_nVertices - 2*i - 3);
-        _indicesOut.push_back(_nVertices - 2*i - 2);
-        _indicesOut.push_back(_nVertices - 2*i - 1);
+    auto& entry = cache[hash];
+    entry.offsets.clear();
+    entry.ringSizes.clear();
+    for (const auto& ring : _polygon) {
+        entry.ringSizes.push_back(ring.size());
+        for (const auto& p : ring) { entry.offsets.push_back(p - origin); }
     }
+    entry.indices = _ctx.earcut.indices;
 }
 
-//  Tessalate a fan geometry between points A       B
-//  using their normals from a center        \ . . /
-//  and interpolating their UVs               \ p /
-//                                             \./
-//                                              C
-void addFan(const glm::vec2& _pC,
-            const glm::vec2& _nA, const glm::vec2& _nB, const glm::vec2& _nC,
-            const glm::vec2& _uA, const glm::vec2& _uB, const glm::vec2& _uC,
-            int _numTriangles, PolyLineBuilder& _ctx) {
-
-    // Find angle difference
-    float cross = _nA.x * _nB.y - _nA.y * _nB.x; // z component of cross(_CA, _CB)
-    float angle = atan2f(cross, glm::dot(_nA, _nB));
-
-    int startIndex = _ctx.numVertices;
-
-    // Add center vertex
-    addPolyLineVertex(_pC, _nC, _uC, _ctx);
-
-    // Add vertex for point A
-    addPolyLineVertex(_pC, _nA, _uA, _ctx);
-
-    // Add radial vertices
-    glm::vec2 radial = _nA;
-    for (int i = 0; i < _numTriangles; i++) {
-        float frac = (i + 1)/(float)_numTriangles;
-        radial = glm::rotate(_nA, angle * frac);
-
-        glm::vec2 uv(0.0);
-        if (_ctx.useTexCoords) {
-            uv = (1.f - frac) * _uA + frac * _uB;
-        }
+size_t Builders::triangulatePolygon(const PolygonView& _polygon, PolygonBuilder& _ctx) {
 
-        addPolyLineVertex(_pC, radial, uv, _ctx);
+    bool collectStats = s_collectStats;
+    std::chrono::steady_clock::time_point start;
+    if (collectStats) { start = std::chrono::steady_clock::now(); }
 
-        // Add indices
-        _ctx.indices.push_back(startIndex); // center vertex
-        _ctx.indices.push_back(startIndex + i + (angle > 0 ? 1 : 2));
-        _ctx.indices.push_back(startIndex + i + (angle > 0 ? 2 : 1));
+    // Triangles are stored in _ctx.earcut.indices
+    if (triangulateConvex(_polygon, _ctx.earcut.indices)) {
+        if (collectStats) { s_convexPolygons++; }
+    } else {
+        triangulateCached(_polygon, _ctx);
     }
 
-}
-
-// Function to add the vertices for line caps
-void addCap(const glm::vec2& _coord, const glm::vec2& _normal, int _numCorners, bool _isBeginning, PolyLineBuilder& _ctx) {
-
-    float v = _isBeginning ? 0.f : 1.f; // length-wise tex coord
+    size_t sumPoints = 0;
+    for (const auto& line : _polygon) {
+        sumPoints += line.size();
+    }
 
-    if (_numCorners < 1) {
-        // "Butt" cap needs no extra vertices
-        return;
-    } else if (_numCorners == 2) {
-        // "Square" cap needs two extra vertices
-        glm::vec2 tangent(-_normal.y, _normal.x);
-        addPolyLineVertex(_coord, _normal + tangent, {0.f, v}, _ctx);
-        addPolyLineVertex(_coord, -_normal + tangent, {0.f, v}, _ctx);
-        if (!_isBeginning) { // At the beginning of a line we can't form triangles with previous vertices
-            indexPairs(1, _ctx.numVertices, _ctx.indices);
+    // Mark the points that are referenced by indices as used.
+    size_t sumVertices = 0;
+    _ctx.used.assign(sumPoints, 0);
+    for (auto i : _ctx.earcut.indices) {
+        if (_ctx.used[i] == 0) {
+            _ctx.used[i] = 1;
+            sumVertices++;
         }
-        return;
     }
 
-    // "Round" cap type needs a fan of vertices
-    glm::vec2 nA(_normal), nB(-_normal), nC(0.f, 0.f), uA(1.f, v), uB(0.f, v), uC(0.5f, v);
-    if (_isBeginning) {
-        nA *= -1.f; // To flip the direction of the fan, we negate the normal vectors
-        nB *= -1.f;
-        uA.x = 0.f; // To keep tex coords consistent, we must reverse these too
-        uB.x = 1.f;
+    if (collectStats) {
+        s_tessellatedPolygons++;
+        s_tessellationNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
     }
-    addFan(_coord, nA, nB, nC, uA, uB, uC, _numCorners, _ctx);
+    return sumVertices;
 }
 
-void buildPolyLineSegment(const Line& _line, PolyLineBuilder& _ctx, size_t _startIndex,
-                          size_t _endIndex, bool endCap = true) {
-
-    float distance = 0; // Cumulative distance along the polyline.
-
-    size_t origLineSize = _line.size();
-
-    // endIndex/startIndex could be wrapped values, calculate lineSize accordingly
-    int lineSize = (int)((_endIndex > _startIndex) ?
-                   (_endIndex - _startIndex) :
-                   (origLineSize - _startIndex + _endIndex));
-    if (lineSize < 2) { return; }
-
-    glm::vec2 coordCurr(_line[_startIndex]);
-    // get the Point using wrapped index in the original line geometry
-    glm::vec2 coordNext(_line[(_startIndex + 1) % origLineSize]);
-    glm::vec2 normPrev, normNext, miterVec;
-
-    int cornersOnCap = (int)_ctx.cap;
-    int trianglesOnJoin = (int)_ctx.join;
+void Builders::buildPolygon(const PolygonView& _polygon, float _height, PolygonBuilder& _ctx) {
+    buildPolygon(_polygon, _height, _ctx, _ctx.addVertex);
+}
 
-    // Process first point in line with an end cap
-    normNext = glm::normalize(perp2d(coordCurr, coordNext));
+void Builders::buildPolygonExtrusion(const PolygonView& _polygon, float _minHeight, float _maxHeight, PolygonBuilder& _ctx) {
+    buildPolygonExtrusion(_polygon, _minHeight, _maxHeight, _ctx, _ctx.addVertex);
+}
 
-    if (endCap) {
-        addCap(coordCurr, normNext, cornersOnCap, true, _ctx);
+void Builders::buildPolyLine(const LineView& _line, PolyLineBuilder& _ctx) {
+    if (_ctx.useVertexBuffer) {
+        auto& vertices = _ctx.vertices;
+        buildPolyLine(_line, _ctx, [&](const glm::vec2& coord, const glm::vec2& normal, const glm::vec2& uv) {
+            vertices.push_back({ coord, normal, uv });
+        });
+    } else {
+        buildPolyLine(_line, _ctx, _ctx.addVertex);
     }
-    addPolyLineVertex(coordCurr, normNext, {1.0f, 0.0f}, _ctx); // right corner
-    addPolyLineVertex(coordCurr, -normNext, {0.0f, 0.0f}, _ctx); // left corner
-
-
-    // Process intermediate points
-    for (int i = 1; i < lineSize - 1; i++) {
-        // get the Point using wrapped index in the original line geometry
-        int nextIndex = (i + _startIndex + 1) % origLineSize;
-
-        distance += glm::distance(coordCurr, coordNext);
-
-        coordCurr = coordNext;
-        coordNext = _line[nextIndex];
-
-        if (coordCurr == coordNext) {
-            continue;
-        }
-
-        normPrev = normNext;
-        normNext = glm::normalize(perp2d(coordCurr, coordNext));
-
-        // Compute "normal" for miter joint
-        miterVec = normPrev + normNext;
-
-        float scale = 1.f;
-
-        // normPrev and normNext are in the opposite direction
-        // in order to prevent NaN values, we use the perp
-        // vector of those two vectors
-        if (miterVec == glm::zero<glm::vec2>()) {
-            miterVec = perp2d(glm::vec3(normNext, 0.f), glm::vec3(normPrev, 0.f));
-        } else {
-            scale = 2.f / glm::dot(miterVec, miterVec);
-        }
-
-        miterVec *= scale;
-
-        if (glm::length2(miterVec) > glm::length2(_ctx.miterLimit)) {
-            trianglesOnJoin = 1;
-            miterVec *= _ctx.miterLimit / glm::length(miterVec);
-        }
-
-        float v = distance;
-
-        if (trianglesOnJoin == 0) {
-            // Join type is a simple miter
-
-            addPolyLineVertex(coordCurr, miterVec, {1.0, v}, _ctx); // right corner
-            addPolyLineVertex(coordCurr, -miterVec, {0.0, v}, _ctx); // left corner
-            indexPairs(1, _ctx.numVertices, _ctx.indices);
-
-        } else {
-
-            // Join type is a fan of triangles
-
-            bool isRightTurn = (normNext.x * normPrev.y - normNext.y * normPrev.x) > 0; // z component of cross(normNext, normPrev)
-
-            if (isRightTurn) {
-
-                addPolyLineVertex(coordCurr, miterVec, {1.0f, v}, _ctx); // right (inner) corner
-                addPolyLineVertex(coordCurr, -normPrev, {0.0f, v}, _ctx); // left (outer) corner
-                indexPairs(1, _ctx.numVertices, _ctx.indices);
-
-                addFan(coordCurr, -normPrev, -normNext, miterVec, {0.f, v}, {0.f, v}, {1.f, v}, trianglesOnJoin, _ctx);
-
-                addPolyLineVertex(coordCurr, miterVec, {1.0f, v}, _ctx); // right (inner) corner
-                addPolyLineVertex(coordCurr, -normNext, {0.0f, v}, _ctx); // left (outer) corner
+}
 
-            } else {
+// Compute the normalized perpendicular and the length of the _numSegments
+// segments of _line starting at _startIndex, with wrapped indices.
+// The results are the same as of glm::normalize(perp2d()) and glm::distance().
+void Builders::computeSegments(const LineView& _line, size_t _startIndex, int _numSegments, PolyLineBuilder& _ctx) {
 
-                addPolyLineVertex(coordCurr, normPrev, {1.0f, v}, _ctx); // right (outer) corner
-                addPolyLineVertex(coordCurr, -miterVec, {0.0f, v}, _ctx); // left (inner) corner
-                indexPairs(1, _ctx.numVertices, _ctx.indices);
+    auto& normals = _ctx.segmentNormals;
+    auto& lengths = _ctx.segmentLengths;
 
-                addFan(coordCurr, normPrev, normNext, -miterVec, {1.f, v}, {1.f, v}, {0.0f, v}, trianglesOnJoin, _ctx);
+    // Padded to an even number for the vector loop
+    normals.resize(_numSegments + 1);
+    lengths.resize(_numSegments + 1);
 
-                addPolyLineVertex(coordCurr, normNext, {1.0f, v}, _ctx); // right (outer) corner
-                addPolyLineVertex(coordCurr, -miterVec, {0.0f, v}, _ctx); // left (inner) corner
-            }
-        }
+    size_t lineSize = _line.size();
+    for (int i = 0; i < _numSegments; i++) {
+        normals[i] = perp2d(_line[(_startIndex + i) % lineSize], _line[(_startIndex + i + 1) % lineSize]);
     }
-
-    distance += glm::distance(coordCurr, coordNext);
-
-    // Process last point in line with a cap
-    addPolyLineVertex(coordNext, normNext, {1.f, distance}, _ctx); // right corner
-    addPolyLineVertex(coordNext, -normNext, {0.f, distance}, _ctx); // left corner
-    indexPairs(1, _ctx.numVertices, _ctx.indices);
-    if (endCap) {
-        addCap(coordNext, normNext, cornersOnCap, false, _ctx);
+    int i = 0;
+
+#if defined(TANGRAM_SEGMENTS_SSE2)
+    // Two segments at a time: [x0 y0 x1 y1]
+    const __m128 one = _mm_set1_ps(1.f);
+    for (; i + 1 < _numSegments; i += 2) {
+        float* n = &normals[i].x;
+        __m128 v = _mm_loadu_ps(n);
+        __m128 sq = _mm_mul_ps(v, v);
+        __m128 dot = _mm_add_ps(sq, _mm_shuffle_ps(sq, sq, _MM_SHUFFLE(2, 3, 0, 1)));
+        __m128 len = _mm_sqrt_ps(dot);
+        _mm_storeu_ps(n, _mm_mul_ps(v, _mm_div_ps(one, len)));
+        lengths[i] = _mm_cvtss_f32(len);
+        lengths[i + 1] = _mm_cvtss_f32(_mm_shuffle_ps(len, len, _MM_SHUFFLE(2, 2, 2, 2)));
+    }
+#elif defined(TANGRAM_SEGMENTS_NEON)
+    const float32x4_t one = vdupq_n_f32(1.f);
+    for (; i + 1 < _numSegments; i += 2) {
+        float* n = &normals[i].x;
+        float32x4_t v = vld1q_f32(n);
+        float32x4_t sq = vmulq_f32(v, v);
+        float32x4_t dot = vaddq_f32(sq, vrev64q_f32(sq));
+        float32x4_t len = vsqrtq_f32(dot);
+        vst1q_f32(n, vmulq_f32(v, vdivq_f32(one, len)));
+        lengths[i] = vgetq_lane_f32(len, 0);
+        lengths[i + 1] = vgetq_lane_f32(len, 2);
     }
+#endif
 
+    for (; i < _numSegments; i++) {
+        lengths[i] = glm::length(normals[i]);
+        normals[i] = glm::normalize(normals[i]);
+    }
 }
 
-void Builders::buildPolyLine(const Line& _line, PolyLineBuilder& _ctx) {
-
-    size_t lineSize = _line.size();
-
-    if (_ctx.keepTileEdges) {
-
-        buildPolyLineSegment(_line, _ctx, 0, lineSize);
-
-    } else {
-
-        int cut = 0;
-        int firstCutEnd = 0;
-
-        // Determine cuts
-        for (size_t i = 0; i < lineSize - 1; i++) {
-            const glm::vec2& coordCurr = _line[i];
-            const glm::vec2& coordNext = _line[i+1];
-            if (isOutsideTile(coordCurr, coordNext)) {
-                if (cut == 0) {
-                    firstCutEnd = i + 1;
-                }
-                buildPolyLineSegment(_line, _ctx, cut, i + 1);
-                cut = i + 1;
-            }
-        }
-
-        if (_ctx.closedPolygon) {
-            if (cut == 0) {
-                // no tile edge cuts!
-                // loop and close the polygon with no endcaps
-                buildPolyLineSegment(_line, _ctx, 0, lineSize+2, false);
-            } else {
-                // merge first and last cut line-segments together
-                buildPolyLineSegment(_line, _ctx, cut, firstCutEnd);
-            }
-        } else {
-            buildPolyLineSegment(_line, _ctx, cut, lineSize);
-        }
+// Helper function for polyline tesselation; adds indices for pairs of vertices arranged like a line strip
+void Builders::indexPairs(int _nPairs, int _nVertices, std::vector<uint16_t>& _indicesOut) {
+    for (int i = 0; i < _nPairs; i++) {
+        _indicesOut.push_back(_nVertices - 2*i - 4);
+        _indicesOut.push_back(_nVertices - 2*i - 2);
+        _indicesOut.push_back(_nVertices - 2*i - 3);
 
+        _indicesOut.push_back(_nVertices - 2*i - 3);
+        _indicesOut.push_back(_nVertices - 2*i - 2);
+        _indicesOut.push_back(_nVertices - 2*i - 1);
     }
-
 }
 
 void Builders::buildQuadAtPoint(const glm::vec2& _screenPosition, const glm::vec2& _size, const glm::vec2& _uvBL, const glm::vec2& _uvTR, SpriteBuilder& _ctx) {
@@ -2,9 +2,16 @@
 
 #include "data/tileData.h"
 
+#include "util/geom.h"
+
 #include "glm/vec3.hpp"
+#include "glm/gtx/norm.hpp"
+#include "glm/gtx/rotate_vector.hpp"
 #include "earcut.hpp"
+#include <cmath>
 #include <functional>
+#include <limits>
+#include <unordered_map>
 #include <vector>
 
 
@@ -45,9 +52,21 @@ struct PolygonBuilder {
     size_t numVertices = 0;
     bool keepTileEdges;
     bool useTexCoords;
+    // Build one wall for consecutive collinear edges of a ring
+    bool mergeCollinearWalls = false;
 
     mapbox::detail::Earcut<uint16_t> earcut;
 
+    // Earcut results of recently built polygons, by a hash of their shape.
+    // Polygons with the same point offsets from their first point share a
+    // triangulation, so repeated shapes and rebuilt tiles skip earcut.
+    struct CachedTriangulation {
+        std::vector<glm::vec2> offsets;
+        std::vector<uint32_t> ringSizes;
+        std::vector<uint16_t> indices;
+    };
+    std::unordered_map<uint64_t, CachedTriangulation> triangulationCache;
+
     PolygonBuilder(PolygonVertexFn _addVertex = [](auto&,auto&,auto&){},
                    bool _kte = true, bool _useTexCoords = true)
         : addVertex(_addVertex), keepTileEdges(_kte), useTexCoords(_useTexCoords){}
@@ -67,6 +86,14 @@ struct PolygonBuilder {
  */
 typedef std::function<void(const glm::vec2& coord, const glm::vec2& enormal, const glm::vec2& uv)> PolyLineVertexFn;
 
+/* Output vertex of PolyLineBuilder, with the arguments of PolyLineVertexFn
+ */
+struct PolyLineVertex {
+    glm::vec2 coord;
+    glm::vec2 enormal;
+    glm::vec2 uv;
+};
+
 /* PolyLineBuilder context,
  * see Builders::buildPolyLine()
  */
@@ -81,6 +108,24 @@ struct PolyLineBuilder {
     bool closedPolygon;
     bool useTexCoords = false;
 
+    // When set, vertices are appended to 'vertices' instead of being passed to addVertex
+    bool useVertexBuffer = false;
+    std::vector<PolyLineVertex> vertices;
+
+    // When set, the line continues a line whose last vertices are the corners
+    // of its first point: no start cap and corners are added for it, indices 0
+    // and 1 refer to these corners and numVertices counts them
+    bool continueLine = false;
+
+    // Vertices and indices at the end of the last built line, the corners and
+    // cap of its last point, which a continued line replaces
+    size_t endVertices = 0;
+    size_t endIndices = 0;
+
+    // Scratch buffers: extrusion normal and length of each segment of a line
+    std::vector<glm::vec2> segmentNormals;
+    std::vector<float> segmentLengths;
+
     PolyLineBuilder(PolyLineVertexFn _addVertex = [](auto&,auto&,auto&){},
                     CapTypes _cap = CapTypes::butt,
                     JoinTypes _join = JoinTypes::bevel,
@@ -90,6 +135,7 @@ struct PolyLineBuilder {
     void clear() {
         numVertices = 0;
         indices.clear();
+        vertices.clear();
     }
 };
 
@@ -114,25 +160,98 @@ class Builders {
 
 public:
 
+    struct TessellationStats {
+        // Time spent in polygon triangulation
+        uint64_t nanoseconds = 0;
+        size_t polygons = 0;
+        // Convex polygons triangulated as a fan
+        size_t convex = 0;
+        // Polygons found in the triangulation cache
+        size_t cached = 0;
+    };
+
+    // Totals of all builders while collecting is enabled
+    static TessellationStats tessellationStats();
+
+    static void collectTessellationStats(bool _enable);
+
     /* Build a tesselated polygon
      * @_polygon input coordinates describing the polygon
      * @_ctx output vectors, see <PolygonBuilder>
      */
-    static void buildPolygon(const Polygon& _polygon, float _height, PolygonBuilder& _ctx);
+    static void buildPolygon(const PolygonView& _polygon, float _height, PolygonBuilder& _ctx);
+
+    /* Same as above, passing each vertex to _addVertex instead of _ctx.addVertex.
+     * _addVertex is called like PolygonVertexFn and is inlined.
+     */
+    template<class VertexFn>
+    static void buildPolygon(const PolygonView& _polygon, float _height, PolygonBuilder& _ctx,
+                             VertexFn&& _addVertex);
 
     /* Build extruded 'walls' from a polygon
      * @_polygon input coordinates describing the polygon
      * @_minHeight the extrusion will extend from this z coordinate to the z of the polygon points
      * @_ctx output vectors, see <PolygonBuilder>
      */
-    static void buildPolygonExtrusion(const Polygon& _polygon, float _minHeight, float _maxHeight, PolygonBuilder& _ctx);
+    static void buildPolygonExtrusion(const PolygonView& _polygon, float _minHeight, float _maxHeight, PolygonBuilder& _ctx);
+
+    template<class VertexFn>
+    static void buildPolygonExtrusion(const PolygonView& _polygon, float _minHeight, float _maxHeight,
+                                      PolygonBuilder& _ctx, VertexFn&& _addVertex);
+
+    /* Call _addEdge(a, b) for each edge of the rings of _polygon that gets a wall
+     * in buildPolygonExtrusion(), see <PolygonBuilder> for the options
+     */
+    template<class EdgeFn>
+    static void forEachWall(const PolygonView& _polygon, const PolygonBuilder& _ctx, EdgeFn&& _addEdge);
+
+    /* Build one extruded wall from _a to _b, facing to the right of the edge
+     */
+    template<class VertexFn>
+    static void buildWall(const glm::vec2& _a, const glm::vec2& _b, float _minHeight, float _maxHeight,
+                          PolygonBuilder& _ctx, VertexFn&& _addVertex);
+
+    // Whether _b is on the line from _a to _c and between them
+    static bool isCollinear(const glm::vec2& _a, const glm::vec2& _b, const glm::vec2& _c);
+
+    /* Douglas-Peucker simplification of _line into _out, which drops points that are
+     * closer than _tolerance to the simplified line. The first and last points are
+     * kept. Rings that would have less than 4 points are kept unchanged.
+     */
+    static void simplifyLine(const LineView& _line, float _tolerance, std::vector<Point>& _out);
+
+    /* Simplify the rings of _polygon into _buffer, see simplifyLine. Returns a view
+     * of the simplified polygon, which stays valid until _buffer is cleared.
+     */
+    static PolygonView simplifyPolygon(const PolygonView& _polygon, float _tolerance, GeometryBuffer& _buffer);
+
+    // Whether all points of _line are inside the tile
+    static bool isInsideTile(const LineView& _line);
+
+    /* Sutherland-Hodgman clip of the closed ring _ring to the tile, appended to _out.
+     * Returns false and appends nothing when less than a triangle is left.
+     */
+    static bool clipRing(const LineView& _ring, std::vector<Point>& _out);
+
+    /* Clip the rings of _polygon to the tile into _buffer, see clipRing. Returns
+     * _polygon itself when it is inside the tile, and an empty view when its
+     * outer ring is outside. Clipped edges lie on the tile edges, so they get no
+     * walls or outlines unless tile edges are kept.
+     */
+    static PolygonView clipPolygon(const PolygonView& _polygon, GeometryBuffer& _buffer);
 
     /* Build a tesselated polygon line of fixed width from line coordinates
      * @_line input coordinates describing the line
      * @_options parameters for polyline construction
      * @_ctx output vectors, see <PolyLineBuilder>
      */
-    static void buildPolyLine(const Line& _line, PolyLineBuilder& _ctx);
+    static void buildPolyLine(const LineView& _line, PolyLineBuilder& _ctx);
+
+    /* Same as above, passing each vertex to _addVertex, which is called like
+     * PolyLineVertexFn and is inlined.
+     */
+    template<class VertexFn>
+    static void buildPolyLine(const LineView& _line, PolyLineBuilder& _ctx, VertexFn&& _addVertex);
 
     /* Build a tesselated quad centered on _screenOrigin
      * @_screenOrigin the sprite origin in screen space
@@ -143,6 +262,467 @@ public:
      */
     static void buildQuadAtPoint(const glm::vec2& _screenOrigin, const glm::vec2& _size, const glm::vec2& _uvBL, const glm::vec2& _uvTR, SpriteBuilder& _ctx);
 
+private:
+
+    // Triangulate into _ctx.earcut.indices and mark the used points in _ctx.used.
+    // Returns the number of used points.
+    static size_t triangulatePolygon(const PolygonView& _polygon, PolygonBuilder& _ctx);
+
+    // Fan triangulation of a single convex ring. Returns false for other polygons.
+    static bool triangulateConvex(const PolygonView& _polygon, std::vector<uint16_t>& _indices);
+
+    static void triangulateCached(const PolygonView& _polygon, PolygonBuilder& _ctx);
+
+    static bool isOutsideTile(const glm::vec2& _a, const glm::vec2& _b);
+
+    static glm::vec2 perp2d(const glm::vec2& _v1, const glm::vec2& _v2);
+
+    static void computeSegments(const LineView& _line, size_t _startIndex, int _numSegments, PolyLineBuilder& _ctx);
+
+    static void indexPairs(int _nPairs, int _nVertices, std::vector<uint16_t>& _indicesOut);
+
+    template<class VertexFn>
+    static void addPolyLineVertex(const glm::vec2& _coord, const glm::vec2& _normal, const glm::vec2& _uv,
+                                  PolyLineBuilder& _ctx, VertexFn& _addVertex);
+
+    template<class VertexFn>
+    static void addFan(const glm::vec2& _pC,
+                       const glm::vec2& _nA, const glm::vec2& _nB, const glm::vec2& _nC,
+                       const glm::vec2& _uA, const glm::vec2& _uB, const glm::vec2& _uC,
+                       int _numTriangles, PolyLineBuilder& _ctx, VertexFn& _addVertex);
+
+    template<class VertexFn>
+    static void addCap(const glm::vec2& _coord, const glm::vec2& _normal, int _numCorners, bool _isBeginning,
+                       PolyLineBuilder& _ctx, VertexFn& _addVertex);
+
+    template<class VertexFn>
+    static void buildPolyLineSegment(const LineView& _line, PolyLineBuilder& _ctx, VertexFn& _addVertex,
+                                     size_t _startIndex, size_t _endIndex, bool endCap);
 };
 
+// Template implementations, so that the vertex function is inlined into the
+// emission loops of the style builders
+
+// Get 2D perpendicular of two points
+inline glm::vec2 Builders::perp2d(const glm::vec2& _v1, const glm::vec2& _v2) {
+    return glm::vec2(_v2.y - _v1.y, _v1.x - _v2.x);
+}
+
+// Helper function for polyline tesselation
+template<class VertexFn>
+inline void Builders::addPolyLineVertex(const glm::vec2& _coord, const glm::vec2& _normal, const glm::vec2& _uv,
+                                        PolyLineBuilder& _ctx, VertexFn& _addVertex) {
+    _ctx.numVertices++;
+    _addVertex(_coord, _normal, _uv);
+}
+
+template<class VertexFn>
+void Builders::buildPolygon(const PolygonView& _polygon, float _height, PolygonBuilder& _ctx,
+                            VertexFn&& _addVertex) {
+
+    glm::vec2 min, max;
+    if (_ctx.useTexCoords) {
+        min = glm::vec2(std::numeric_limits<float>::max());
+        max = glm::vec2(std::numeric_limits<float>::min());
+
+        for (auto& p : _polygon[0]) {
+            min.x = std::min(min.x, p.x);
+            min.y = std::min(min.y, p.y);
+            max.x = std::max(max.x, p.x);
+            max.y = std::max(max.y, p.y);
+        }
+    }
+
+    size_t sumVertices = triangulatePolygon(_polygon, _ctx);
+    size_t sumPoints = _ctx.used.size();
+
+    uint16_t vertexDataOffset = _ctx.numVertices;
+    _ctx.numVertices += sumVertices;
+
+    size_t ring = 0;
+    size_t offset = 0;
+
+    // Go through all points of the polyon.
+    for (size_t src = 0, dst = 0; src < sumPoints; src++) {
+        // The points of the polygon rings are indexed linearly.
+        // This maps the indices back to the original ring and point.
+        if (src - offset >= _polygon[ring].size()) {
+            offset += _polygon[ring].size();
+            ring += 1;
+        }
+
+        // Add vertex only when the point is used.
+        if (_ctx.used[src] == 0) { continue; }
+
+        // Keep track of skipped points to update indices
+        _ctx.used[src] = dst++;
+
+        auto& p = _polygon[ring][src - offset];
+        glm::vec3 coord(p.x, p.y, _height);
+
+        if (_ctx.useTexCoords) {
+            glm::vec2 uv(mapRange01(coord.x, min.x, max.x), mapRange01(coord.y, max.y, min.y));
+
+            _addVertex(coord, glm::vec3(0.0, 0.0, 1.0), uv);
+        } else {
+            _addVertex(coord, glm::vec3(0.0, 0.0, 1.0), glm::vec2(0));
+        }
+    }
+
+    for (auto i : _ctx.earcut.indices) {
+        _ctx.indices.push_back(vertexDataOffset + _ctx.used[i]);
+    }
+}
+
+template<class VertexFn>
+void Builders::buildPolygonExtrusion(const PolygonView& _polygon, float _minHeight, float _maxHeight,
+                                     PolygonBuilder& _ctx, VertexFn&& _addVertex) {
+
+    forEachWall(_polygon, _ctx, [&](const glm::vec2& a, const glm::vec2& b) {
+        buildWall(a, b, _minHeight, _maxHeight, _ctx, _addVertex);
+    });
+}
+
+template<class EdgeFn>
+void Builders::forEachWall(const PolygonView& _polygon, const PolygonBuilder& _ctx, EdgeFn&& _addEdge) {
+
+    for (const auto& line : _polygon) {
+
+        // Wall of the previous edges, not added yet while it can be extended
+        bool pending = false;
+        glm::vec2 a, b;
+
+        for (size_t i = 0; i + 1 < line.size(); i++) {
+
+            const glm::vec2& p = line[i];
+            const glm::vec2& q = line[i+1];
+
+            if (p == q) { continue; }
+
+            if (!_ctx.keepTileEdges && isOutsideTile(p, q)) {
+                if (pending) { _addEdge(a, b); }
+                pending = false;
+                continue;
+            }
+
+            if (pending && _ctx.mergeCollinearWalls && b == p && isCollinear(a, b, q)) {
+                b = q;
+                continue;
+            }
+
+            if (pending) { _addEdge(a, b); }
+            a = p;
+            b = q;
+            pending = true;
+        }
+
+        if (pending) { _addEdge(a, b); }
+    }
+}
+
+template<class VertexFn>
+void Builders::buildWall(const glm::vec2& _a, const glm::vec2& _b, float _minHeight, float _maxHeight,
+                         PolygonBuilder& _ctx, VertexFn&& _addVertex) {
+
+    static const glm::vec3 upVector(0.0f, 0.0f, 1.0f);
+
+    glm::vec3 a(_a, 0.f);
+    glm::vec3 b(_b, 0.f);
+
+    glm::vec3 normalVector = glm::normalize(glm::cross(upVector, b - a));
+
+    if (std::isnan(normalVector.x)
+     || std::isnan(normalVector.y)
+     || std::isnan(normalVector.z)) {
+        return;
+    }
+
+    auto vertexDataOffset = _ctx.numVertices;
+
+    // 1st vertex top
+    a.z = _maxHeight;
+    _addVertex(a, normalVector, glm::vec2(1.,1.));
+
+    // 2nd vertex top
+    b.z = _maxHeight;
+    _addVertex(b, normalVector, glm::vec2(0.,1.));
+
+    // 1st vertex bottom
+    a.z = _minHeight;
+    _addVertex(a, normalVector, glm::vec2(1.,0.));
+
+    // 2nd vertex bottom
+    b.z = _minHeight;
+    _addVertex(b, normalVector, glm::vec2(0.,0.));
+
+    // Start the index from the previous state of the vertex Data
+    _ctx.indices.push_back(vertexDataOffset);
+    _ctx.indices.push_back(vertexDataOffset + 1);
+    _ctx.indices.push_back(vertexDataOffset + 2);
+
+    _ctx.indices.push_back(vertexDataOffset + 1);
+    _ctx.indices.push_back(vertexDataOffset + 3);
+    _ctx.indices.push_back(vertexDataOffset + 2);
+
+    _ctx.numVertices = vertexDataOffset + 4;
+}
+
+//  Tessalate a fan geometry between points A       B
+//  using their normals from a center        \ . . /
+//  and interpolating their UVs               \ p /
+//                                             \./
+//                                              C
+template<class VertexFn>
+void Builders::addFan(const glm::vec2& _pC,
+                      const glm::vec2& _nA, const glm::vec2& _nB, const glm::vec2& _nC,
+                      const glm::vec2& _uA, const glm::vec2& _uB, const glm::vec2& _uC,
+                      int _numTriangles, PolyLineBuilder& _ctx, VertexFn& _addVertex) {
+
+    // Find angle difference
+    float cross = _nA.x * _nB.y - _nA.y * _nB.x; // z component of cross(_CA, _CB)
+    float angle = atan2f(cross, glm::dot(_nA, _nB));
+
+    int startIndex = _ctx.numVertices;
+
+    // Add center vertex
+    addPolyLineVertex(_pC, _nC, _uC, _ctx, _addVertex);
+
+    // Add vertex for point A
+    addPolyLineVertex(_pC, _nA, _uA, _ctx, _addVertex);
+
+    // Add radial vertices
+    glm::vec2 radial = _nA;
+    for (int i = 0; i < _numTriangles; i++) {
+        float frac = (i + 1)/(float)_numTriangles;
+        radial = glm::rotate(_nA, angle * frac);
+
+        glm::vec2 uv(0.0);
+        if (_ctx.useTexCoords) {
+            uv = (1.f - frac) * _uA + frac * _uB;
+        }
+
+        addPolyLineVertex(_pC, radial, uv, _ctx, _addVertex);
+
+        // Add indices
+        _ctx.indices.push_back(startIndex); // center vertex
+        _ctx.indices.push_back(startIndex + i + (angle > 0 ? 1 : 2));
+        _ctx.indices.push_back(startIndex + i + (angle > 0 ? 2 : 1));
+    }
+
+}
+
+// Function to add the vertices for line caps
+template<class VertexFn>
+void Builders::addCap(const glm::vec2& _coord, const glm::vec2& _normal, int _numCorners, bool _isBeginning,
+                      PolyLineBuilder& _ctx, VertexFn& _addVertex) {
+
+    float v = _isBeginning ? 0.f : 1.f; // length-wise tex coord
+
+    if (_numCorners < 1) {
+        // "Butt" cap needs no extra vertices
+        return;
+    } else if (_numCorners == 2) {
+        // "Square" cap needs two extra vertices
+        glm::vec2 tangent(-_normal.y, _normal.x);
+        addPolyLineVertex(_coord, _normal + tangent, {0.f, v}, _ctx, _addVertex);
+        addPolyLineVertex(_coord, -_normal + tangent, {0.f, v}, _ctx, _addVertex);
+        if (!_isBeginning) { // At the beginning of a line we can't form triangles with previous vertices
+            indexPairs(1, _ctx.numVertices, _ctx.indices);
+        }
+        return;
+    }
+
+    // "Round" cap type needs a fan of vertices
+    glm::vec2 nA(_normal), nB(-_normal), nC(0.f, 0.f), uA(1.f, v), uB(0.f, v), uC(0.5f, v);
+    if (_isBeginning) {
+        nA *= -1.f; // To flip the direction of the fan, we negate the normal vectors
+        nB *= -1.f;
+        uA.x = 0.f; // To keep tex coords consistent, we must reverse these too
+        uB.x = 1.f;
+    }
+    addFan(_coord, nA, nB, nC, uA, uB, uC, _numCorners, _ctx, _addVertex);
+}
+
+template<class VertexFn>
+void Builders::buildPolyLineSegment(const LineView& _line, PolyLineBuilder& _ctx, VertexFn& _addVertex,
+                                    size_t _startIndex, size_t _endIndex, bool endCap) {
+
+    float distance = 0; // Cumulative distance along the polyline.
+
+    size_t origLineSize = _line.size();
+
+    // endIndex/startIndex could be wrapped values, calculate lineSize accordingly
+    int lineSize = (int)((_endIndex > _startIndex) ?
+                   (_endIndex - _startIndex) :
+                   (origLineSize - _startIndex + _endIndex));
+    if (lineSize < 2) { return; }
+
+    glm::vec2 coordCurr(_line[_startIndex]);
+    // get the Point using wrapped index in the original line geometry
+    glm::vec2 coordNext(_line[(_startIndex + 1) % origLineSize]);
+    glm::vec2 normPrev, normNext, miterVec;
+
+    int cornersOnCap = (int)_ctx.cap;
+    int trianglesOnJoin = (int)_ctx.join;
+
+    // Normals and lengths of all segments are computed up front in batches
+    computeSegments(_line, _startIndex, lineSize - 1, _ctx);
+    const auto& segmentNormals = _ctx.segmentNormals;
+    const auto& segmentLengths = _ctx.segmentLengths;
+
+    // Process first point in line with an end cap
+    normNext = segmentNormals[0];
+
+    if (_ctx.continueLine) {
+        _ctx.numVertices += 2;
+    } else {
+        if (endCap) {
+            addCap(coordCurr, normNext, cornersOnCap, true, _ctx, _addVertex);
+        }
+        addPolyLineVertex(coordCurr, normNext, {1.0f, 0.0f}, _ctx, _addVertex); // right corner
+        addPolyLineVertex(coordCurr, -normNext, {0.0f, 0.0f}, _ctx, _addVertex); // left corner
+    }
+
+
+    // Process intermediate points
+    for (int i = 1; i < lineSize - 1; i++) {
+        // get the Point using wrapped index in the original line geometry
+        int nextIndex = (i + _startIndex + 1) % origLineSize;
+
+        distance += segmentLengths[i - 1];
+
+        coordCurr = coordNext;
+        coordNext = _line[nextIndex];
+
+        if (coordCurr == coordNext) {
+            continue;
+        }
+
+        normPrev = normNext;
+        normNext = segmentNormals[i];
+
+        // Compute "normal" for miter joint
+        miterVec = normPrev + normNext;
+
+        float scale = 1.f;
+
+        // normPrev and normNext are in the opposite direction
+        // in order to prevent NaN values, we use the perp
+        // vector of those two vectors
+        if (miterVec == glm::zero<glm::vec2>()) {
+            miterVec = perp2d(glm::vec3(normNext, 0.f), glm::vec3(normPrev, 0.f));
+        } else {
+            scale = 2.f / glm::dot(miterVec, miterVec);
+        }
+
+        miterVec *= scale;
+
+        if (glm::length2(miterVec) > glm::length2(_ctx.miterLimit)) {
+            trianglesOnJoin = 1;
+            miterVec *= _ctx.miterLimit / glm::length(miterVec);
+        }
+
+        float v = distance;
+
+        if (trianglesOnJoin == 0) {
+            // Join type is a simple miter
+
+            addPolyLineVertex(coordCurr, miterVec, {1.0, v}, _ctx, _addVertex); // right corner
+            addPolyLineVertex(coordCurr, -miterVec, {0.0, v}, _ctx, _addVertex); // left corner
+            indexPairs(1, _ctx.numVertices, _ctx.indices);
+
+        } else {
+
+            // Join type is a fan of triangles
+
+            bool isRightTurn = (normNext.x * normPrev.y - normNext.y * normPrev.x) > 0; // z component of cross(normNext, normPrev)
+
+            if (isRightTurn) {
+
+                addPolyLineVertex(coordCurr, miterVec, {1.0f, v}, _ctx, _addVertex); // right (inner) corner
+                addPolyLineVertex(coordCurr, -normPrev, {0.0f, v}, _ctx, _addVertex); // left (outer) corner
+                indexPairs(1, _ctx.numVertices, _ctx.indices);
+
+                addFan(coordCurr, -normPrev, -normNext, miterVec, {0.f, v}, {0.f, v}, {1.f, v}, trianglesOnJoin, _ctx, _addVertex);
+
+                addPolyLineVertex(coordCurr, miterVec, {1.0f, v}, _ctx, _addVertex); // right (inner) corner
+                addPolyLineVertex(coordCurr, -normNext, {0.0f, v}, _ctx, _addVertex); // left (outer) corner
+
+            } else {
+
+                addPolyLineVertex(coordCurr, normPrev, {1.0f, v}, _ctx, _addVertex); // right (outer) corner
+                addPolyLineVertex(coordCurr, -miterVec, {0.0f, v}, _ctx, _addVertex); // left (inner) corner
+                indexPairs(1, _ctx.numVertices, _ctx.indices);
+
+                addFan(coordCurr, normPrev, normNext, -miterVec, {1.f, v}, {1.f, v}, {0.0f, v}, trianglesOnJoin, _ctx, _addVertex);
+
+                addPolyLineVertex(coordCurr, normNext, {1.0f, v}, _ctx, _addVertex); // right (outer) corner
+                addPolyLineVertex(coordCurr, -miterVec, {0.0f, v}, _ctx, _addVertex); // left (inner) corner
+            }
+        }
+    }
+
+    distance += segmentLengths[lineSize - 2];
+
+    size_t endVertex = _ctx.numVertices;
+    size_t endIndex = _ctx.indices.size();
+
+    // Process last point in line with a cap
+    addPolyLineVertex(coordNext, normNext, {1.f, distance}, _ctx, _addVertex); // right corner
+    addPolyLineVertex(coordNext, -normNext, {0.f, distance}, _ctx, _addVertex); // left corner
+    indexPairs(1, _ctx.numVertices, _ctx.indices);
+    if (endCap) {
+        addCap(coordNext, normNext, cornersOnCap, false, _ctx, _addVertex);
+    }
+
+    _ctx.endVertices = _ctx.numVertices - endVertex;
+    _ctx.endIndices = _ctx.indices.size() - endIndex;
+
+}
+
+template<class VertexFn>
+void Builders::buildPolyLine(const LineView& _line, PolyLineBuilder& _ctx, VertexFn&& _addVertex) {
+
+    size_t lineSize = _line.size();
+
+    if (_ctx.keepTileEdges) {
+
+        buildPolyLineSegment(_line, _ctx, _addVertex, 0, lineSize, true);
+
+    } else {
+
+        int cut = 0;
+        int firstCutEnd = 0;
+
+        // Determine cuts
+        for (size_t i = 0; i < lineSize - 1; i++) {
+            const glm::vec2& coordCurr = _line[i];
+            const glm::vec2& coordNext = _line[i+1];
+            if (isOutsideTile(coordCurr, coordNext)) {
+                if (cut == 0) {
+                    firstCutEnd = i + 1;
+                }
+                buildPolyLineSegment(_line, _ctx, _addVertex, cut, i + 1, true);
+                cut = i + 1;
+            }
+        }
+
+        if (_ctx.closedPolygon) {
+            if (cut == 0) {
+                // no tile edge cuts!
+                // loop and close the polygon with no endcaps
+                buildPolyLineSegment(_line, _ctx, _addVertex, 0, lineSize+2, false);
+            } else {
+                // merge first and last cut line-segments together
+                buildPolyLineSegment(_line, _ctx, _addVertex, cut, firstCutEnd, true);
+            }
+        } else {
+            buildPolyLineSegment(_line, _ctx, _addVertex, cut, lineSize, true);
+        }
+
+    }
+
+}
+
+
 }
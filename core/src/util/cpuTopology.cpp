@@ -0,0 +1,124 @@
+#include "util/cpuTopology.h"
+
+#include "log.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+#if defined(__linux__)
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+namespace Tangram {
+
+constexpr size_t max_cores = 64;
+
+#if defined(__linux__)
+static bool readNumber(const std::string& _path, uint32_t& _value) {
+    FILE* file = fopen(_path.c_str(), "r");
+    if (!file) { return false; }
+    unsigned int value = 0;
+    bool ok = fscanf(file, "%u", &value) == 1;
+    fclose(file);
+    if (ok) { _value = value; }
+    return ok;
+}
+#endif
+
+static std::vector<uint32_t> readCapacities() {
+    std::vector<uint32_t> capacities;
+#if defined(__linux__)
+    for (size_t i = 0; i < max_cores; i++) {
+        std::string core = "/sys/devices/system/cpu/cpu" + std::to_string(i);
+        if (access(core.c_str(), F_OK) != 0) { break; }
+
+        // The scheduler's capacity of the core, or else its maximum frequency
+        uint32_t capacity = 0;
+        if (!readNumber(core + "/cpu_capacity", capacity)) {
+            readNumber(core + "/cpufreq/cpuinfo_max_freq", capacity);
+        }
+        capacities.push_back(capacity);
+    }
+#endif
+    return capacities;
+}
+
+const CpuTopology& CpuTopology::get() {
+    static const CpuTopology s_topology(readCapacities());
+    return s_topology;
+}
+
+CpuTopology::CpuTopology(const std::vector<uint32_t>& _capacities) {
+    size_t numCores = std::min(_capacities.size(), max_cores);
+
+    uint32_t maxCapacity = 0;
+    uint32_t minCapacity = UINT32_MAX;
+    for (size_t i = 0; i < numCores; i++) {
+        m_allCores |= uint64_t(1) << i;
+        if (_capacities[i] == 0) { continue; }
+        maxCapacity = std::max(maxCapacity, _capacities[i]);
+        minCapacity = std::min(minCapacity, _capacities[i]);
+    }
+
+    if (maxCapacity == 0 || maxCapacity == minCapacity) {
+        // Cores of the same or unknown capacity
+        m_bigCores = m_littleCores = m_allCores;
+        return;
+    }
+
+    for (size_t i = 0; i < numCores; i++) {
+        if (_capacities[i] == maxCapacity) { m_bigCores |= uint64_t(1) << i; }
+        if (_capacities[i] == minCapacity) { m_littleCores |= uint64_t(1) << i; }
+    }
+
+    LOG("CPU cores: %d, big: %016llx, little: %016llx", int(numCores),
+        (unsigned long long)m_bigCores, (unsigned long long)m_littleCores);
+}
+
+uint64_t CpuTopology::affinity(ThreadRole _role, ThreadPlacement _placement) const {
+    if (_placement == ThreadPlacement::none || !isHeterogeneous()) { return m_allCores; }
+
+    // Cores of all but the lowest capacity
+    uint64_t fastCores = m_allCores & ~m_littleCores;
+
+    if (_placement == ThreadPlacement::battery) {
+        return _role == ThreadRole::gl ? m_allCores : m_littleCores;
+    }
+
+    switch (_role) {
+    case ThreadRole::gl:
+        return m_bigCores;
+    case ThreadRole::worker: {
+        // Leave the first big core to the GL thread when there are other fast cores
+        uint64_t glCore = m_bigCores & (~m_bigCores + 1);
+        uint64_t cores = fastCores & ~glCore;
+        return cores ? cores : fastCores;
+    }
+    case ThreadRole::io:
+        return m_littleCores;
+    }
+    return m_allCores;
+}
+
+bool setCurrentThreadAffinity(uint64_t _mask) {
+    if (_mask == 0) { return false; }
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (size_t i = 0; i < max_cores; i++) {
+        if (_mask & (uint64_t(1) << i)) { CPU_SET(i, &set); }
+    }
+    // Pid 0 is the calling thread
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+        LOGW("Unable to set the thread affinity to %016llx", (unsigned long long)_mask);
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "platform.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Tangram {
+
+// The cores of the CPU grouped by their capacity. On CPUs with cores of different
+// capacity (e.g. big.LITTLE) threads are placed on the cores suited for their role.
+class CpuTopology {
+public:
+
+    // Topology of this device, read once from sysfs on Linux and Android
+    static const CpuTopology& get();
+
+    // Capacities of the cores by core index, 0 when unknown. At most 64 cores are used.
+    explicit CpuTopology(const std::vector<uint32_t>& _capacities);
+
+    // Cores suited for a thread with _role under _placement, one bit per core index
+    uint64_t affinity(ThreadRole _role, ThreadPlacement _placement) const;
+
+    bool isHeterogeneous() const { return m_bigCores != m_allCores; }
+
+    uint64_t allCores() const { return m_allCores; }
+    // Cores of the highest capacity
+    uint64_t bigCores() const { return m_bigCores; }
+    // Cores of the lowest capacity
+    uint64_t littleCores() const { return m_littleCores; }
+
+private:
+    uint64_t m_allCores = 0;
+    uint64_t m_bigCores = 0;
+    uint64_t m_littleCores = 0;
+};
+
+// Restrict the current thread to the cores in _mask; returns false when
+// thread affinity is not supported or _mask is empty
+bool setCurrentThreadAffinity(uint64_t _mask);
+
+}
@@ -1,5 +1,8 @@
 #include "util/dashArray.h"
 
+#include "gl/texture.h"
+
+#include <algorithm>
 #include <cmath>
 
 namespace Tangram {
@@ -24,4 +27,49 @@ std::vector<unsigned int> DashArray::render(std::vector<float> _pattern, float _
     return dashArray;
 }
 
+DashAtlas::DashAtlas() {
+    TextureOptions options;
+    options.minFilter = TextureMinFilter::NEAREST;
+    options.magFilter = TextureMagFilter::NEAREST;
+    m_texture = std::make_shared<Texture>(options);
+}
+
+DashAtlas::Pattern DashAtlas::add(const std::vector<float>& _pattern, float _dashScale) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    Pattern result;
+    for (auto& entry : m_entries) {
+        if (entry.pattern == _pattern && entry.dashScale == _dashScale) {
+            result.length = entry.pixels.size();
+            return result;
+        }
+        result.column++;
+    }
+
+    auto pixels = DashArray::render(_pattern, _dashScale);
+    // Patterns too short to render are drawn as background
+    if (pixels.empty()) { pixels.push_back(0); }
+    result.length = pixels.size();
+    m_entries.push_back({ _pattern, _dashScale, std::move(pixels) });
+
+    size_t width = m_entries.size();
+    size_t height = 0;
+    for (auto& entry : m_entries) { height = std::max(height, entry.pixels.size()); }
+
+    // Below its pattern a column is transparent
+    std::vector<unsigned int> data(width * height, 0);
+    for (size_t x = 0; x < width; x++) {
+        auto& pixels = m_entries[x].pixels;
+        for (size_t y = 0; y < pixels.size(); y++) {
+            data[y * width + x] = pixels[y];
+        }
+    }
+
+    m_texture->setPixelData(width, height, sizeof(GLuint),
+                            reinterpret_cast<GLubyte*>(data.data()),
+                            data.size() * sizeof(GLuint));
+    m_texture->retainCompressedCopy();
+    return result;
+}
+
 }
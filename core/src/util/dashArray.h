@@ -1,13 +1,54 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 namespace Tangram {
 
+class Texture;
+
 struct DashArray {
     static std::vector<unsigned int> render(std::vector<float> _pattern, float _dashScale,
         unsigned int _dashColor = 0xffffffff,
         unsigned int _backgroundColor = 0x00000000);
 };
 
+/* Texture with the rendered dash patterns of the line styles of a scene, one
+ * pattern in each column from the top, so that all dashed styles bind the
+ * same texture. Styles with the same pattern share its column.
+ */
+class DashAtlas {
+
+public:
+
+    struct Pattern {
+        uint32_t column = 0;
+        // Pixels of the pattern in its column
+        uint32_t length = 0;
+    };
+
+    DashAtlas();
+
+    /* Returns the column of _pattern rendered at _dashScale, adding it to the
+     * texture when no style used it yet */
+    Pattern add(const std::vector<float>& _pattern, float _dashScale);
+
+    const std::shared_ptr<Texture>& texture() const { return m_texture; }
+
+private:
+
+    struct Entry {
+        std::vector<float> pattern;
+        float dashScale;
+        std::vector<unsigned int> pixels;
+    };
+
+    std::mutex m_mutex;
+    std::vector<Entry> m_entries;
+    std::shared_ptr<Texture> m_texture;
+
+};
+
 }
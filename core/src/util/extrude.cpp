@@ -37,7 +37,7 @@ Extrude parseExtrudeNode(const YAML::Node& node) {
 
 float getLowerExtrudeMeters(const Extrude& _extrude, const Properties& _props) {
 
-    const static std::string key_min_height("min_height");
+    const static auto key_min_height = Properties::internKey("min_height");
 
     double lower = 0;
 
@@ -54,7 +54,7 @@ float getLowerExtrudeMeters(const Extrude& _extrude, const Properties& _props) {
 
 float getUpperExtrudeMeters(const Extrude& _extrude, const Properties& _props) {
 
-    const static std::string key_height("height");
+    const static auto key_height = Properties::internKey("height");
 
     double upper = 0;
 
@@ -0,0 +1,70 @@
+#include "util/frameBudget.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Tangram {
+
+constexpr float FrameBudget::MIN_QUALITY;
+constexpr uint32_t FrameBudget::MAX_TILE_COMPLETIONS;
+
+// Quality is lowered quickly when a frame is late and raised slowly while
+// frames are well within the target
+static constexpr float QUALITY_DECREASE = 0.7f;
+static constexpr float QUALITY_INCREASE = 0.05f;
+static constexpr float RECOVERY_THRESHOLD = 0.75f;
+
+// Fraction of the target frame time for queued jobs at full quality
+static constexpr float JOB_TIME_FRACTION = 0.25f;
+
+// Frames between label placements at minimum quality
+static constexpr uint32_t MAX_PLACEMENT_INTERVAL = 4;
+
+void FrameBudget::setTargetFrameTime(float _ms) {
+    m_targetFrameTime = std::max(_ms, 0.f);
+    if (m_targetFrameTime == 0) { m_quality = 1; }
+}
+
+void FrameBudget::endUpdate() {
+    m_updateTime = std::chrono::duration<float, std::milli>(Clock::now() - m_start).count();
+}
+
+void FrameBudget::endRender() {
+    float renderTime = std::chrono::duration<float, std::milli>(Clock::now() - m_start).count();
+    m_frameTime = m_updateTime + renderTime;
+    addFrameTime(m_frameTime);
+    m_updateTime = 0;
+}
+
+void FrameBudget::addFrameTime(float _ms) {
+    if (m_targetFrameTime <= 0) { return; }
+
+    if (_ms > m_targetFrameTime) {
+        m_quality = std::max(m_quality * QUALITY_DECREASE, MIN_QUALITY);
+    } else if (_ms < m_targetFrameTime * RECOVERY_THRESHOLD) {
+        m_quality = std::min(m_quality + QUALITY_INCREASE, 1.f);
+    }
+}
+
+size_t FrameBudget::uploadBudget(size_t _defaultBudget) const {
+    return size_t(_defaultBudget * m_quality);
+}
+
+uint32_t FrameBudget::tileCompletions() const {
+    if (m_quality >= 1) { return 0; }
+    return std::max(uint32_t(std::round(MAX_TILE_COMPLETIONS * m_quality)), 1u);
+}
+
+float FrameBudget::jobTime() const {
+    return m_targetFrameTime * JOB_TIME_FRACTION * m_quality;
+}
+
+bool FrameBudget::placeLabels() {
+    uint32_t interval = std::min(uint32_t(std::round(1.f / m_quality)), MAX_PLACEMENT_INTERVAL);
+    if (++m_framesSincePlacement < interval) { return false; }
+
+    m_framesSincePlacement = 0;
+    return true;
+}
+
+}
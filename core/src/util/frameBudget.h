@@ -0,0 +1,72 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace Tangram {
+
+// Adapts the work that can be deferred to later frames to a target frame time.
+//
+// The time of Map::update() and Map::render() is measured for each frame.
+// When a frame takes longer than the target the quality is lowered, which
+// shrinks the mesh upload budget, the number of tiles completed per update and
+// the frequency of label placement. Quality recovers while frames are fast.
+class FrameBudget {
+
+public:
+
+    using Clock = std::chrono::steady_clock;
+
+    // Lowest quality, work is scaled down at most to this fraction
+    static constexpr float MIN_QUALITY = 0.25f;
+
+    // Tiles completed per update at full quality, 0 when unlimited
+    static constexpr uint32_t MAX_TILE_COMPLETIONS = 8;
+
+    // Target time of update and render of a frame in milliseconds, 0 disables adaptation
+    void setTargetFrameTime(float _ms);
+    float targetFrameTime() const { return m_targetFrameTime; }
+
+    // Measure the time of the update and the render of a frame
+    void beginUpdate() { m_start = Clock::now(); }
+    void endUpdate();
+    void beginRender() { m_start = Clock::now(); }
+    void endRender();
+
+    // Adapt the quality to the time of the last frame
+    void addFrameTime(float _ms);
+
+    // Time of update and render of the last frame in milliseconds
+    float frameTime() const { return m_frameTime; }
+
+    // Fraction of the deferrable work that is done per frame in [MIN_QUALITY, 1]
+    float quality() const { return m_quality; }
+
+    // Bytes of mesh and texture data to upload per frame
+    size_t uploadBudget(size_t _defaultBudget) const;
+
+    // Tiles to complete per update, 0 when unlimited
+    uint32_t tileCompletions() const;
+
+    // Milliseconds of queued GL thread jobs to run per update, 0 when unlimited
+    float jobTime() const;
+
+    // Whether labels should be placed in this update. Under load labels are
+    // placed every few frames and keep their last placement in between.
+    bool placeLabels();
+
+private:
+
+    float m_targetFrameTime = 0;
+    float m_quality = 1;
+    float m_updateTime = 0;
+    float m_frameTime = 0;
+
+    uint32_t m_framesSincePlacement = 0;
+
+    Clock::time_point m_start;
+
+};
+
+}
@@ -12,6 +12,25 @@ float mapRange01(float value, float inputMin, float inputMax) {
     return clamp01((value - inputMin) / (inputMax - inputMin));
 }
 
+bool MeshBounds::isOutsideFrustum(const glm::mat4& mvp) const {
+    if (!bounded) { return false; }
+
+    // Bits of the planes that each corner is beyond
+    int outside = 0x1f;
+    for (int i = 0; i < 8; i++) {
+        glm::vec4 corner((i & 1) ? max.x : min.x, (i & 2) ? max.y : min.y, (i & 4) ? max.z : min.z, 1.f);
+        glm::vec4 clip = mvp * corner;
+        int planes = (clip.x < -clip.w ? 0x1 : 0) |
+            (clip.x > clip.w ? 0x2 : 0) |
+            (clip.y < -clip.w ? 0x4 : 0) |
+            (clip.y > clip.w ? 0x8 : 0) |
+            (clip.z < -clip.w ? 0x10 : 0);
+        outside &= planes;
+        if (outside == 0) { return false; }
+    }
+    return true;
+}
+
 glm::vec2 worldToScreenSpace(const glm::mat4& mvp, const glm::vec4& worldPosition, const glm::vec2& screenSize, bool& behindCamera) {
     glm::vec4 clip = worldToClipSpace(mvp, worldPosition);
     glm::vec3 ndc = clipSpaceToNdc(clip);
@@ -1,9 +1,13 @@
 #pragma once
 
+#include "glm/common.hpp"
 #include "glm/vec2.hpp"
+#include "glm/vec3.hpp"
 #include "glm/vec4.hpp"
 #include "glm/mat4x4.hpp"
 
+#include <iterator>
+
 namespace Tangram {
 
 constexpr double PI = 3.14159265358979323846;
@@ -64,6 +68,29 @@ struct BoundingBox {
     }
 };
 
+/// Extent of the geometry of a mesh in its model space. Meshes that are not
+/// bounded are always drawn.
+struct MeshBounds {
+
+    glm::vec3 min;
+    glm::vec3 max;
+    bool bounded = false;
+
+    void expand(const glm::vec3& p) {
+        if (!bounded) {
+            min = max = p;
+            bounded = true;
+            return;
+        }
+        min = glm::min(min, p);
+        max = glm::max(max, p);
+    }
+
+    /// Whether the box is outside of the view frustum of mvp: all of its
+    /// corners are beyond the same left, right, bottom, top or near plane.
+    bool isOutsideFrustum(const glm::mat4& mvp) const;
+};
+
 /// Return the signed area of the polygon defined by the points in the range [begin, end).
 /// The sign of the area is positive if the vertices of the polygon are counter-clockwise.
 template<class InputIt>
@@ -80,7 +107,7 @@ float signedArea(InputIt begin, InputIt end) {
 
 /// Calculate the area centroid of a closed polygon given as a sequence of vectors.
 /// If the polygon has no area, the coordinates returned are NaN.
-template<class InputIt, class Vector = typename InputIt::value_type>
+template<class InputIt, class Vector = typename std::iterator_traits<InputIt>::value_type>
 Vector centroid(InputIt begin, InputIt end) {
     Vector centroid{};
     float area = 0.f;
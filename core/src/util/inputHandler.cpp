@@ -40,6 +40,10 @@ bool InputHandler::update(float _dt) {
 
         m_velocityZoom -= min(_dt * DAMPING_ZOOM, 1.f) * m_velocityZoom;
         m_view.zoom(m_velocityZoom * _dt);
+
+        setMotion();
+    } else {
+        m_view.setMotion(glm::dvec2(0.0), glm::dvec2(0.0));
     }
 
     return isFlinging;
@@ -154,6 +158,15 @@ void InputHandler::setVelocity(float _zoom, glm::vec2 _translate) {
     // setup deltas for momentum on gesture
     m_velocityPan = _translate;
     m_velocityZoom = _zoom;
+
+    setMotion();
+}
+
+void InputHandler::setMotion() {
+    // The exponentially damped velocity v(t) = v * exp(-t * DAMPING_PAN)
+    // moves the view by v / DAMPING_PAN until it stops.
+    glm::dvec2 velocity(m_velocityPan);
+    m_view.setMotion(velocity, velocity / double(DAMPING_PAN));
 }
 
 }
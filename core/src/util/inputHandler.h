@@ -33,6 +33,9 @@ private:
 
     void setVelocity(float _zoom, glm::vec2 _pan);
 
+    // Pass the pan velocity and the translation left until the fling ends to the view
+    void setMotion();
+
     View& m_view;
 
     // fling deltas on zoom and translation
@@ -1,47 +1,91 @@
 #include "util/jobQueue.h"
 
+#include <chrono>
+#include <memory>
+
 namespace Tangram {
 
 JobQueue::~JobQueue() {
 
-    if (!m_jobs.empty()) { runJobs(); }
+    if (hasPendingJobs()) { runJobs(); }
+
+    // Jobs added by the last jobs are dropped
+    takeAdded();
+    while (Node* node = pop()) {
+        delete node;
+        m_count--;
+    }
+}
+
+void JobQueue::push(Node* _node) {
+    m_count++;
+    Node* head = m_head.load(std::memory_order_relaxed);
+    do {
+        _node->next = head;
+    } while (!m_head.compare_exchange_weak(head, _node, std::memory_order_release,
+                                           std::memory_order_relaxed));
+}
+
+bool JobQueue::hasPendingJobs() {
+    if (m_head.load(std::memory_order_relaxed)) { return true; }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pending != nullptr;
 }
 
-void JobQueue::add(Job job) {
+void JobQueue::takeAdded() {
+    // The added jobs are taken while the pending jobs are locked, so that batches
+    // taken by concurrent calls are appended in the order they were added
+    std::lock_guard<std::mutex> lock(m_mutex);
 
-    if (!m_stopped) {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        m_jobs.push_back(std::move(job));
+    // Take all added jobs at once and reverse them into the order they were added
+    Node* node = m_head.exchange(nullptr, std::memory_order_acquire);
+    if (!node) { return; }
+
+    Node* first = nullptr;
+    Node* last = node;
+    while (node) {
+        Node* next = node->next;
+        node->next = first;
+        first = node;
+        node = next;
+    }
+
+    if (m_pendingTail) {
+        m_pendingTail->next = first;
     } else {
-        job();
+        m_pending = first;
     }
+    m_pendingTail = last;
 }
 
-void JobQueue::runJobs() {
-    std::vector<Job> localJobs;
+JobQueue::Node* JobQueue::pop() {
+    std::lock_guard<std::mutex> lock(m_mutex);
 
-    {
-        // steal contents of m_jobs inside the lock
-        std::lock_guard<std::mutex> lock(m_mutex);
-        m_jobs.swap(localJobs);
-        // now the lock can be released as we won't touch m_jobs anymore
+    Node* node = m_pending;
+    if (node) {
+        m_pending = node->next;
+        if (!m_pending) { m_pendingTail = nullptr; }
     }
+    return node;
+}
+
+void JobQueue::runJobs(float _budget) {
+    using Clock = std::chrono::steady_clock;
+    auto start = Clock::now();
+
+    // Jobs that are added while these run are left for the next call
+    takeAdded();
 
     // execute jobs outside of the lock
-    for (auto& jobref : localJobs) {
-        Job job = std::move(jobref);
-        job();
+    while (std::unique_ptr<Node> node{pop()}) {
+        node->run();
+        m_count--;
         // job dtor triggers here
-    }
-
 
-    // try to give back memory to m_jobs
-    if (!localJobs.empty()) {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        if (m_jobs.empty() && m_jobs.capacity() < localJobs.capacity()) {
-            // clear does not release capacity/memory
-            localJobs.clear();
-            m_jobs.swap(localJobs);
+        if (_budget > 0 &&
+            std::chrono::duration<float, std::milli>(Clock::now() - start).count() >= _budget) {
+            break;
         }
     }
 }
@@ -1,40 +1,90 @@
 #pragma once
 
-#include <functional>
-#include <mutex>
-#include <vector>
 #include <atomic>
+#include <mutex>
+#include <type_traits>
+#include <utility>
 
 namespace Tangram {
 
 // JobQueue allows you to queue a sequence of jobs to run later.
 // This is useful for OpenGL resources that must be created and destroyed on the GL thread.
+//
+// Jobs are added to a lock-free list, each in one allocation that holds the job
+// function with its captures. runJobs() takes the list in the order the jobs
+// were added and may leave jobs for a later call when it has a time budget.
 
 class JobQueue {
 
 public:
-    using Job = std::function<void()>;
 
     JobQueue() = default;
 
     // Any jobs left in the queue will be run in the destructor. This is thread-safe.
     ~JobQueue();
 
-    // Put a job on the queue. This is thread-safe.
-    void add(Job job);
+    // Put a job on the queue. This is thread-safe and does not block.
+    template <class F>
+    void add(F&& _job) {
+        if (m_stopped) {
+            _job();
+            return;
+        }
+        push(new JobNode<typename std::decay<F>::type>(std::forward<F>(_job)));
+    }
+
+    // Run the jobs on the queue in the order they were added, then remove them.
+    // With a _budget in milliseconds the jobs that are left once it is used up
+    // are run by the next calls, at least one job runs per call. This is thread-safe.
+    void runJobs(float _budget = 0);
 
-    // Run all jobs on the queue in the order they were added, then remove them. This is thread-safe.
-    void runJobs();
+    // Whether jobs are waiting to run. This is thread-safe.
+    bool hasPendingJobs();
+
+    // Number of jobs waiting to run. This is thread-safe.
+    size_t pendingJobs() const { return m_count.load(std::memory_order_relaxed); }
 
     void stop() {
         m_stopped = true;
         runJobs();
     }
+
 private:
 
-    std::vector<Job> m_jobs;
+    struct Node {
+        Node* next = nullptr;
+        virtual ~Node() = default;
+        virtual void run() = 0;
+    };
+
+    template <class F>
+    struct JobNode : Node {
+        template <class G>
+        explicit JobNode(G&& _job) : job(std::forward<G>(_job)) {}
+        void run() override { job(); }
+        F job;
+    };
+
+    void push(Node* _node);
+
+    // Appends the added jobs to the pending jobs
+    void takeAdded();
+
+    // Takes the next pending job, or nullptr
+    Node* pop();
+
+    // Jobs added since the last runJobs(), the most recent first
+    std::atomic<Node*> m_head{nullptr};
+
+    // Jobs taken from m_head that did not run yet, the oldest first
     std::mutex m_mutex;
+    Node* m_pending = nullptr;
+    Node* m_pendingTail = nullptr;
+
     std::atomic<bool> m_stopped{false};
+
+    // Jobs added and not yet run or dropped
+    std::atomic<size_t> m_count{0};
 };
 
 }
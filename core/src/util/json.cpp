@@ -4,6 +4,8 @@
 #include "rapidjson/error/en.h"
 #include "rapidjson/memorystream.h"
 
+#include <cstring>
+
 namespace Tangram {
 
     JsonDocument JsonParseBytes(const char* _bytes, size_t _length, const char** _error, size_t* _errorOffset) {
@@ -24,4 +26,30 @@ namespace Tangram {
 
     }
 
+    JsonDocument JsonParseInsitu(const char* _bytes, size_t _length, std::vector<char>& _buffer,
+                                 const char** _error, size_t* _errorOffset) {
+
+        // Skip the UTF-8 byte order mark, which in situ parsing does not handle
+        if (_length >= 3 && std::memcmp(_bytes, "\xEF\xBB\xBF", 3) == 0) {
+            _bytes += 3;
+            _length -= 3;
+        }
+
+        _buffer.assign(_bytes, _bytes + _length);
+        _buffer.push_back('\0');
+
+        JsonDocument document;
+        document.ParseInsitu(_buffer.data());
+
+        *_error = nullptr;
+        *_errorOffset = 0;
+        if (document.HasParseError()) {
+            *_error = rapidjson::GetParseError_En(document.GetParseError());
+            *_errorOffset = document.GetErrorOffset();
+        }
+
+        return document;
+
+    }
+
 }
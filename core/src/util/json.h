@@ -2,6 +2,8 @@
 
 #include "rapidjson/document.h"
 
+#include <vector>
+
 namespace Tangram {
 
     using JsonDocument = rapidjson::Document;
@@ -9,4 +11,9 @@ namespace Tangram {
 
     JsonDocument JsonParseBytes(const char* _bytes, size_t _length, const char** _error, size_t* _errorOffset);
 
+    // Parses a copy of _bytes in _buffer in situ, so that strings of the document point into
+    // _buffer instead of being allocated. _buffer must outlive the document.
+    JsonDocument JsonParseInsitu(const char* _bytes, size_t _length, std::vector<char>& _buffer,
+                                 const char** _error, size_t* _errorOffset);
+
 }
@@ -8,7 +8,7 @@ template<typename Points>
 struct LineSampler {
 
     template<typename T>
-    void set(std::vector<T> _points) {
+    void set(const T& _points) {
         m_points.clear();
 
         if (_points.empty()) { return; }
@@ -84,6 +84,11 @@ struct LineSampler {
         return m_curPoint;
     }
 
+    // Number of points, without the duplicates skipped by set() and add()
+    size_t size() const {
+        return m_points.size();
+    }
+
     glm::vec3 point(size_t _pos) {
         return m_points[_pos];
     }
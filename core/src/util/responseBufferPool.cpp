@@ -0,0 +1,64 @@
+#include "util/responseBufferPool.h"
+
+namespace Tangram {
+
+constexpr size_t ResponseBufferPool::max_buffers;
+constexpr size_t ResponseBufferPool::max_capacity;
+
+ResponseBufferPool& ResponseBufferPool::shared() {
+    // Leaked on purpose: static NetworkDataSource requests release buffers during static destruction
+    static ResponseBufferPool* s_pool = new ResponseBufferPool();
+    return *s_pool;
+}
+
+std::vector<char> ResponseBufferPool::acquire(size_t _capacity) {
+    std::vector<char> buffer;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_buffers.empty()) {
+            // The most recently released buffer that is large enough, or else the last one
+            auto it = m_buffers.end() - 1;
+            for (auto b = m_buffers.rbegin(); b != m_buffers.rend(); ++b) {
+                if (b->capacity() >= _capacity) {
+                    it = b.base() - 1;
+                    break;
+                }
+            }
+            buffer = std::move(*it);
+            m_buffers.erase(it);
+        }
+    }
+    buffer.reserve(_capacity);
+    return buffer;
+}
+
+void ResponseBufferPool::release(std::vector<char>&& _buffer) {
+    if (_buffer.capacity() == 0 || _buffer.capacity() > max_capacity) { return; }
+
+    _buffer.clear();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_buffers.size() < max_buffers) {
+        m_buffers.push_back(std::move(_buffer));
+    }
+}
+
+std::shared_ptr<std::vector<char>> ResponseBufferPool::share(std::vector<char>&& _content) {
+    return std::shared_ptr<std::vector<char>>(new std::vector<char>(std::move(_content)),
+                                              [this](std::vector<char>* _buffer) {
+                                                  release(std::move(*_buffer));
+                                                  delete _buffer;
+                                              });
+}
+
+size_t ResponseBufferPool::size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_buffers.size();
+}
+
+void ResponseBufferPool::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_buffers.clear();
+}
+
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Tangram {
+
+// ResponseBufferPool keeps the buffers of URL response content for reuse.
+//
+// A UrlClient takes a buffer for each request and reserves it for the expected
+// content length. NetworkDataSource hands the content to its tasks with share(),
+// which returns the buffer to the pool once the last task or cache releases it,
+// so that bursts of tile requests reuse a few buffers.
+
+class ResponseBufferPool {
+
+public:
+
+    // Maximum number of buffers kept
+    static constexpr size_t max_buffers = 16;
+    // Larger buffers are freed rather than kept
+    static constexpr size_t max_capacity = 512 * 1024;
+
+    /// Pool shared by all UrlClients and NetworkDataSources in this process
+    static ResponseBufferPool& shared();
+
+    /// Get an empty buffer, preferably one with at least _capacity bytes reserved.
+    /// This is thread-safe.
+    std::vector<char> acquire(size_t _capacity = 0);
+
+    /// Return a buffer to the pool. This is thread-safe.
+    void release(std::vector<char>&& _buffer);
+
+    /// Share _content and return its buffer to the pool when the last reference is released
+    std::shared_ptr<std::vector<char>> share(std::vector<char>&& _content);
+
+    /// Number of buffers in the pool
+    size_t size() const;
+
+    /// Free the buffers in the pool
+    void clear();
+
+private:
+
+    mutable std::mutex m_mutex;
+    std::vector<std::vector<char>> m_buffers;
+};
+
+}
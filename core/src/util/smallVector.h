@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+
+namespace Tangram {
+
+// Vector of trivially copyable values that holds up to N of them inline, so
+// that copies of small containers do not allocate.
+template<typename T, size_t N>
+class SmallVector {
+
+    static_assert(std::is_trivially_copyable<T>::value, "SmallVector values are copied as bytes");
+
+public:
+
+    SmallVector() = default;
+
+    SmallVector(const SmallVector& _other) { assign(_other); }
+
+    SmallVector(SmallVector&& _other) noexcept { take(_other); }
+
+    SmallVector& operator=(const SmallVector& _other) {
+        if (this != &_other) { assign(_other); }
+        return *this;
+    }
+
+    SmallVector& operator=(SmallVector&& _other) noexcept {
+        if (this != &_other) {
+            release();
+            take(_other);
+        }
+        return *this;
+    }
+
+    ~SmallVector() { release(); }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    T& operator[](size_t _i) { return data()[_i]; }
+    const T& operator[](size_t _i) const { return data()[_i]; }
+
+    T* begin() { return data(); }
+    T* end() { return data() + m_size; }
+    const T* begin() const { return data(); }
+    const T* end() const { return data() + m_size; }
+
+    void push_back(const T& _value) {
+        if (m_size == m_capacity) { grow(m_capacity * 2); }
+        data()[m_size++] = _value;
+    }
+
+    void clear() { m_size = 0; }
+
+private:
+
+    T* data() { return m_heap ? m_heap : reinterpret_cast<T*>(m_inline); }
+    const T* data() const { return m_heap ? m_heap : reinterpret_cast<const T*>(m_inline); }
+
+    void grow(size_t _capacity) {
+        T* heap = static_cast<T*>(std::malloc(_capacity * sizeof(T)));
+        std::memcpy(heap, data(), m_size * sizeof(T));
+        release();
+        m_heap = heap;
+        m_capacity = _capacity;
+    }
+
+    void release() {
+        std::free(m_heap);
+        m_heap = nullptr;
+        m_capacity = N;
+    }
+
+    void assign(const SmallVector& _other) {
+        // Keep a heap buffer that is large enough
+        if (_other.m_size > m_capacity) {
+            m_size = 0;
+            release();
+            grow(_other.m_size);
+        }
+        std::memcpy(data(), _other.data(), _other.m_size * sizeof(T));
+        m_size = _other.m_size;
+    }
+
+    void take(SmallVector& _other) {
+        if (_other.m_heap) {
+            m_heap = _other.m_heap;
+            m_capacity = _other.m_capacity;
+            _other.m_heap = nullptr;
+            _other.m_capacity = N;
+        } else {
+            std::memcpy(m_inline, _other.m_inline, _other.m_size * sizeof(T));
+        }
+        m_size = _other.m_size;
+        _other.m_size = 0;
+    }
+
+    T* m_heap = nullptr;
+    size_t m_size = 0;
+    size_t m_capacity = N;
+    alignas(T) unsigned char m_inline[N * sizeof(T)];
+
+};
+
+}
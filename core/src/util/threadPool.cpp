@@ -0,0 +1,155 @@
+#include "util/threadPool.h"
+
+#include "platform.h"
+
+#include <algorithm>
+
+#define WORKER_NICENESS 10
+
+namespace Tangram {
+
+constexpr size_t ThreadPool::max_threads;
+constexpr size_t ThreadPool::num_priorities;
+
+// Pool and index of the worker running on the current thread
+static thread_local ThreadPool* t_pool = nullptr;
+static thread_local size_t t_index = 0;
+
+// Placement of the threads, applied again by each thread when the generation changes
+static std::atomic<ThreadPlacement> s_placement{ThreadPlacement::none};
+static std::atomic<uint32_t> s_placementGeneration{0};
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool s_pool;
+    return s_pool;
+}
+
+ThreadPool::ThreadPool(size_t _numThreads) {
+    reserveThreads(_numThreads);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_condition.notify_all();
+
+    for (size_t i = 0; i < m_numThreads; i++) {
+        m_workers[i].thread.join();
+    }
+}
+
+void ThreadPool::reserveThreads(size_t _numThreads) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    size_t numThreads = std::min(_numThreads, max_threads);
+
+    for (size_t i = m_numThreads; i < numThreads; i++) {
+        m_workers[i].thread = std::thread(&ThreadPool::run, this, i);
+    }
+    if (numThreads > m_numThreads) {
+        m_numThreads = numThreads;
+    }
+}
+
+void ThreadPool::enqueue(Priority _priority, Job _job) {
+
+    if (m_numThreads == 0) { reserveThreads(1); }
+
+    size_t index = (t_pool == this)
+        ? t_index
+        : m_nextWorker++ % m_numThreads;
+
+    {
+        // Count the job before it can be taken: a thread that takes it
+        // decrements m_pendingJobs only once this lock is released
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pendingJobs++;
+
+        std::lock_guard<std::mutex> workerLock(m_workers[index].mutex);
+        m_workers[index].queues[size_t(_priority)].push_back(std::move(_job));
+    }
+    m_condition.notify_one();
+}
+
+size_t ThreadPool::pendingJobs() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pendingJobs;
+}
+
+void ThreadPool::setThreadPlacement(ThreadPlacement _placement) {
+    if (s_placement.exchange(_placement) != _placement) {
+        s_placementGeneration++;
+    }
+}
+
+void ThreadPool::applyThreadPlacement(ThreadRole _role, uint32_t& _generation) {
+    uint32_t generation = s_placementGeneration;
+    if (generation == _generation) { return; }
+
+    _generation = generation;
+    setCurrentThreadPlacement(_role, s_placement);
+}
+
+bool ThreadPool::takeJob(size_t _index, Job& _job) {
+
+    size_t numThreads = m_numThreads;
+
+    for (size_t p = 0; p < num_priorities; p++) {
+        // Take the oldest job from our own queue
+        {
+            auto& worker = m_workers[_index];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            auto& queue = worker.queues[p];
+            if (!queue.empty()) {
+                _job = std::move(queue.front());
+                queue.pop_front();
+                return true;
+            }
+        }
+        // Steal the newest job from another worker
+        for (size_t i = 1; i < numThreads; i++) {
+            auto& worker = m_workers[(_index + i) % numThreads];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            auto& queue = worker.queues[p];
+            if (!queue.empty()) {
+                _job = std::move(queue.back());
+                queue.pop_back();
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void ThreadPool::run(size_t _index) {
+
+    setCurrentThreadPriority(WORKER_NICENESS);
+
+    t_pool = this;
+    t_index = _index;
+
+    uint32_t placementGeneration = 0;
+
+    while (true) {
+        applyThreadPlacement(ThreadRole::worker, placementGeneration);
+
+        Job job;
+        if (takeJob(_index, job)) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_pendingJobs--;
+            }
+            job();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condition.wait(lock, [&]{ return m_pendingJobs > 0 || !m_running; });
+
+        if (!m_running && m_pendingJobs == 0) { break; }
+    }
+}
+
+}
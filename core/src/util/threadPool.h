@@ -0,0 +1,93 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace Tangram {
+
+enum class ThreadPlacement : uint8_t;
+enum class ThreadRole : uint8_t;
+
+// ThreadPool runs jobs on a set of threads shared by TileWorkers and TileSources.
+//
+// Each thread owns one job deque per priority class. Jobs added from a pool
+// thread go to that thread's own deques, jobs from other threads are handed
+// out round-robin. A thread takes jobs from the front of its own deques and
+// steals from the back of the other threads' deques when it runs out of work.
+// Higher priority classes are always checked first.
+
+class ThreadPool {
+
+public:
+    using Job = std::function<void()>;
+
+    enum class Priority : uint8_t {
+        gl = 0,     // Work that the GL thread is waiting on
+        tile,       // Tile building
+        io,         // File and database access
+        background, // Everything else
+    };
+
+    static constexpr size_t max_threads = 16;
+
+    /// ThreadPool shared by all Map instances in this process
+    static ThreadPool& shared();
+
+    explicit ThreadPool(size_t _numThreads = 0);
+
+    /// Runs all queued jobs, then joins the threads.
+    ~ThreadPool();
+
+    /// Start threads until at least _numThreads are running (limited to max_threads).
+    /// The pool never shrinks. This is thread-safe.
+    void reserveThreads(size_t _numThreads);
+
+    size_t numThreads() const { return m_numThreads; }
+
+    /// Put a job on the queue of the given priority class. This is thread-safe.
+    void enqueue(Priority _priority, Job _job);
+
+    /// Number of queued jobs that no thread has taken yet. This is thread-safe.
+    size_t pendingJobs();
+
+    /// Set the placement of the pool threads, of AsyncWorker threads and of the GL
+    /// thread on the CPU cores. Shared by all pools in this process.
+    static void setThreadPlacement(ThreadPlacement _placement);
+
+    /// Apply the placement to the current thread when it changed since _generation,
+    /// which is 0 for a thread that was not placed yet.
+    static void applyThreadPlacement(ThreadRole _role, uint32_t& _generation);
+
+private:
+
+    static constexpr size_t num_priorities = 4;
+
+    struct Worker {
+        std::thread thread;
+        std::mutex mutex;
+        std::array<std::deque<Job>, num_priorities> queues;
+    };
+
+    void run(size_t _index);
+
+    bool takeJob(size_t _index, Job& _job);
+
+    std::array<Worker, max_threads> m_workers;
+
+    std::atomic<size_t> m_numThreads{0};
+    std::atomic<size_t> m_nextWorker{0};
+
+    // Guards m_pendingJobs, m_running and starting of threads. Taken before
+    // the mutex of a Worker when both are held.
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    size_t m_pendingJobs = 0;
+    bool m_running = true;
+};
+
+}
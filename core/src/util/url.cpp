@@ -14,7 +14,7 @@ Url::Url(const std::string& source) :
 }
 
 Url::Url(std::string&& source) :
-    buffer(source) {
+    buffer(std::move(source)) {
     parse();
 }
 
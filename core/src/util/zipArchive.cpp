@@ -1,11 +1,25 @@
 #include "zipArchive.h"
 
+#include <cstring>
+
 namespace Tangram {
 
-ZipArchive::ZipArchive() {
-    mz_zip_zero_struct(&minizData);
+// Size of the fixed part of a local file header
+static constexpr size_t LOCAL_HEADER_SIZE = 30;
+static constexpr uint32_t LOCAL_HEADER_SIGNATURE = 0x04034b50;
+
+static uint32_t readUint16(const char* _data) {
+    auto* data = reinterpret_cast<const uint8_t*>(_data);
+    return data[0] | (data[1] << 8);
 }
 
+static uint32_t readUint32(const char* _data) {
+    auto* data = reinterpret_cast<const uint8_t*>(_data);
+    return data[0] | (data[1] << 8) | (data[2] << 16) | (uint32_t(data[3]) << 24);
+}
+
+ZipArchive::ZipArchive() {}
+
 ZipArchive::~ZipArchive() {
     reset();
 }
@@ -15,51 +29,96 @@ bool ZipArchive::loadFromMemory(std::vector<char>&& compressedArchiveData) {
     reset();
     // Initialize the buffer and archive with the input data.
     buffer = std::move(compressedArchiveData);
+
+    // Read the central directory with miniz, entries are then read from the
+    // buffer directly.
+    mz_zip_archive minizData;
+    mz_zip_zero_struct(&minizData);
     if (!mz_zip_reader_init_mem(&minizData, buffer.data(), buffer.size(), 0)) {
         return false;
     }
     // Scan the archive entries into a list.
     auto numberOfFiles = mz_zip_reader_get_num_files(&minizData);
     entryList.reserve(numberOfFiles);
+    entryIndex.reserve(numberOfFiles);
     for (size_t i = 0; i < numberOfFiles; i++) {
         Entry entry;
         mz_zip_archive_file_stat stats;
         if (mz_zip_reader_file_stat(&minizData, i, &stats)) {
             entry.path = stats.m_filename;
             entry.uncompressedSize = stats.m_uncomp_size;
+            entry.compressedSize = stats.m_comp_size;
+            entry.crc32 = stats.m_crc32;
+            entry.stored = stats.m_method == 0;
+            entry.supported = stats.m_is_supported && !stats.m_is_directory &&
+                (entry.stored || stats.m_method == MZ_DEFLATED);
+
+            // The file data follows the local header and its variable fields
+            size_t header = stats.m_local_header_ofs;
+            if (header + LOCAL_HEADER_SIZE <= buffer.size() &&
+                readUint32(&buffer[header]) == LOCAL_HEADER_SIGNATURE) {
+                entry.dataOffset = header + LOCAL_HEADER_SIZE +
+                    readUint16(&buffer[header + 26]) + readUint16(&buffer[header + 28]);
+            }
+            if (entry.dataOffset == 0 || entry.dataOffset + entry.compressedSize > buffer.size() ||
+                (entry.stored && entry.compressedSize != entry.uncompressedSize)) {
+                entry.supported = false;
+            }
         }
+        entryIndex.emplace(entry.path, entryList.size());
         entryList.push_back(entry);
     }
+    mz_zip_reader_end(&minizData);
     return true;
 }
 
 const ZipArchive::Entry* ZipArchive::findEntry(const std::string& path) const {
-    for (const auto& entry : entryList) {
-        if (entry.path == path) {
-            return &entry;
-        }
+    auto it = entryIndex.find(path);
+    if (it == entryIndex.end()) {
+        return nullptr;
     }
-    return nullptr;
+    return &entryList[it->second];
 }
 
-bool ZipArchive::decompressEntry(const Entry* entry, char* output) {
+const char* ZipArchive::entryData(const Entry* entry) const {
+    // Check that the given pointer refers to an entry in our list.
+    if (entry == nullptr || entry < entryList.data() || entry >= entryList.data() + entryList.size()) {
+        return nullptr;
+    }
+    if (!entry->supported || !entry->stored) {
+        return nullptr;
+    }
+    return buffer.data() + entry->dataOffset;
+}
+
+bool ZipArchive::decompressEntry(const Entry* entry, char* output) const {
     // Check that the given pointer refers to an entry in our list.
     if (entry == nullptr || entry < entryList.data() || entry >= entryList.data() + entryList.size()) {
         return false;
     }
-    // Get the index of the entry (this arithmetic is only legal in an array).
-    size_t index = entry - entryList.data();
+    if (!entry->supported) {
+        return false;
+    }
     size_t size = entry->uncompressedSize;
-    return mz_zip_reader_extract_to_mem(&minizData, index, output, size, 0);
+    const char* data = buffer.data() + entry->dataOffset;
+    if (entry->stored) {
+        std::memcpy(output, data, size);
+    } else {
+        // Inflate the raw deflate stream, no state is shared between entries
+        size_t written = tinfl_decompress_mem_to_mem(output, size, data, entry->compressedSize, 0);
+        if (written != size) {
+            return false;
+        }
+    }
+    auto crc = mz_crc32(MZ_CRC32_INIT, reinterpret_cast<const unsigned char*>(output), size);
+    return crc == entry->crc32;
 }
 
 void ZipArchive::reset() {
-    // Close and free the miniz archive (if null, this is a no-op).
-    mz_zip_reader_end(&minizData);
-    mz_zip_zero_struct(&minizData);
     // Empty the buffer and entry list.
     buffer.clear();
     entryList.clear();
+    entryIndex.clear();
 }
 
 }
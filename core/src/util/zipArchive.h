@@ -5,6 +5,7 @@
 #include <miniz.h>
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace Tangram {
@@ -17,6 +18,15 @@ public:
     struct Entry {
         std::string path;
         size_t uncompressedSize = 0;
+        size_t compressedSize = 0;
+        // Offset of the file data in the archive buffer
+        size_t dataOffset = 0;
+        uint32_t crc32 = 0;
+        // Whether the data is stored without compression
+        bool stored = false;
+        // Whether the data can be read, encrypted entries and unsupported
+        // compression methods are listed but can't be decompressed
+        bool supported = false;
     };
 
     // Create an empty archive.
@@ -25,11 +35,12 @@ public:
     // Dispose an archive and any memory it owns.
     ~ZipArchive();
 
-    // Copying would cause memory errors on the internal archive pointer.
+    // Copying would duplicate the whole archive data.
     ZipArchive(const ZipArchive& other) = delete;
 
-    // Load a zip archive from its compressed data in memory. This creates a
-    // list of entries for the archive, but does not decompress any data. If the
+    // Load a zip archive from its compressed data in memory. This reads the
+    // central directory once to create a list of entries and the offsets of
+    // their data, but does not decompress any data. If the
     // archive is successfully loaded this returns true, otherwise returns
     // false. The data is moved out of the input vector and retained until other
     // data is loaded or the archive is destroyed.
@@ -45,11 +56,17 @@ public:
     // entry for the path.
     const Entry* findEntry(const std::string& path) const;
 
+    // Return a pointer to the data of a stored entry in the archive buffer,
+    // which stays valid until other data is loaded or the archive is
+    // destroyed. Returns null for compressed entries.
+    const char* entryData(const Entry* entry) const;
+
     // Decompress the data from the given entry into the output buffer. The
     // caller MUST ensure that the output has enough space allocated to store
     // the uncompressed size of the entry. Returns false if the entry is not
     // from this archive or it can't be decompressed, otherwise returns true.
-    bool decompressEntry(const Entry* entry, char* output);
+    // Entries can be decompressed from several threads at once.
+    bool decompressEntry(const Entry* entry, char* output) const;
 
 protected:
     // Buffer of compressed zip archive data.
@@ -58,8 +75,8 @@ protected:
     // List of file entries in the archive.
     std::vector<Entry> entryList;
 
-    // Archive data used by miniz.
-    mz_zip_archive minizData;
+    // Index of each entry in entryList by path.
+    std::unordered_map<std::string, size_t> entryIndex;
 };
 
 } // namespace Tangram
@@ -2,54 +2,119 @@
 
 #include <zlib.h>
 
-#include <assert.h>
+#include <algorithm>
+#include <cstdint>
 
 #define CHUNK 16384
 
 namespace Tangram {
 namespace zlib {
 
-int inflate(const char* _data, size_t _size, std::vector<char>& dst) {
+// Largest ratio of the sizes of inflated and deflated data
+constexpr size_t max_deflate_ratio = 1032;
 
-    int ret;
-    unsigned char out[CHUNK];
+namespace {
 
+// Inflate stream of a thread. It is reset for each buffer rather than
+// allocating its state and window again.
+struct InflateStream {
     z_stream strm;
-    memset(&strm, 0, sizeof(z_stream));
+    bool ok = false;
+
+    InflateStream() {
+        memset(&strm, 0, sizeof(z_stream));
+        ok = inflateInit2(&strm, 16+MAX_WBITS) == Z_OK;
+    }
+    ~InflateStream() {
+        if (ok) { inflateEnd(&strm); }
+    }
+};
+
+// Size of the data from the trailer of a gzip member, 0 when unknown
+size_t gzipSizeHint(const char* _data, size_t _size) {
+    // Magic bytes, and room for the header and the trailer
+    if (_size < 18 || uint8_t(_data[0]) != 0x1f || uint8_t(_data[1]) != 0x8b) { return 0; }
+
+    // ISIZE, the size modulo 2^32, is only checked once the data is inflated
+    auto trailer = reinterpret_cast<const uint8_t*>(_data + _size - 4);
+    size_t size = uint32_t(trailer[0]) | uint32_t(trailer[1]) << 8 |
+        uint32_t(trailer[2]) << 16 | uint32_t(trailer[3]) << 24;
+
+    return size <= _size * max_deflate_ratio ? size : 0;
+}
+
+}
+
+int inflate(const char* _data, size_t _size, std::vector<char>& dst) {
 
-    ret = inflateInit2(&strm, 16+MAX_WBITS);
+    static thread_local InflateStream t_stream;
+    if (!t_stream.ok) { return Z_MEM_ERROR; }
+
+    z_stream& strm = t_stream.strm;
+    int ret = inflateReset(&strm);
     if (ret != Z_OK) { return ret; }
 
+    // Inflate in place into dst, sized by the gzip trailer when it can be
+    // trusted, so that most buffers are inflated without growing dst
+    size_t start = dst.size();
+    size_t hint = gzipSizeHint(_data, _size);
+    dst.resize(start + std::max<size_t>(hint > 0 ? hint : _size * 4, CHUNK));
+
     strm.avail_in = _size;
     strm.next_in = (Bytef*)_data;
 
-    do {
-        strm.avail_out = CHUNK;
-        strm.next_out = out;
+    size_t end = start;
+
+    while (true) {
+        if (end == dst.size()) {
+            dst.resize(dst.size() + std::max<size_t>(dst.size() - start, CHUNK));
+        }
+        strm.avail_out = dst.size() - end;
+        strm.next_out = (Bytef*)(dst.data() + end);
 
-        ret = inflate(&strm, Z_NO_FLUSH);
+        ret = ::inflate(&strm, Z_NO_FLUSH);
 
-         /* state not clobbered */
-        assert(ret != Z_STREAM_ERROR);
+        end = dst.size() - strm.avail_out;
 
-        switch (ret) {
-        case Z_NEED_DICT:
-            ret = Z_DATA_ERROR;
-            /* fall through */
-        case Z_DATA_ERROR:
-        case Z_MEM_ERROR:
-            inflateEnd(&strm);
-            return ret;
-        }
+        // Continue while the output is full. With room left, no progress
+        // (Z_BUF_ERROR) means that the input is truncated.
+        if (ret == Z_OK || (ret == Z_BUF_ERROR && strm.avail_out == 0)) { continue; }
+        break;
+    }
+
+    if (ret != Z_STREAM_END) {
+        dst.resize(start);
+        return ret == Z_MEM_ERROR ? Z_MEM_ERROR : Z_DATA_ERROR;
+    }
 
-        size_t have = CHUNK - strm.avail_out;
-        dst.insert(dst.end(), out, out+have);
+    dst.resize(end);
+
+    return Z_OK;
+}
+
+int deflate(const char* _data, size_t _size, std::vector<char>& dst, int _level) {
+
+    z_stream strm;
+    memset(&strm, 0, sizeof(z_stream));
+
+    int ret = deflateInit2(&strm, _level, Z_DEFLATED, 16+MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+    if (ret != Z_OK) { return ret; }
+
+    size_t start = dst.size();
+    dst.resize(start + deflateBound(&strm, _size));
+
+    strm.avail_in = _size;
+    strm.next_in = (Bytef*)_data;
+    strm.avail_out = dst.size() - start;
+    strm.next_out = (Bytef*)(dst.data() + start);
 
-    } while (ret == Z_OK);
+    // The output buffer holds the whole result, so this finishes in one call
+    ret = deflate(&strm, Z_FINISH);
+    dst.resize(dst.size() - strm.avail_out);
 
-    inflateEnd(&strm);
+    deflateEnd(&strm);
 
-    return ret == Z_STREAM_END ? Z_OK : Z_DATA_ERROR;
+    return ret == Z_STREAM_END ? Z_OK : Z_BUF_ERROR;
 }
 
 }
@@ -8,5 +8,8 @@ namespace zlib {
 
 int inflate(const char* _data, size_t _size, std::vector<char>& dst);
 
+// Compress _data in gzip format, readable by inflate(). Level 1 is fastest.
+int deflate(const char* _data, size_t _size, std::vector<char>& dst, int _level = 1);
+
 }
 }
@@ -6,7 +6,9 @@
 
 #include "glm/gtc/matrix_transform.hpp"
 #include "glm/gtx/rotate_vector.hpp"
+#include <algorithm>
 #include <cmath>
+#include <vector>
 
 #define MAX_LOD 6
 
@@ -85,7 +87,10 @@ ViewState View::state() const {
         powf(2.f, m_zoom),
         m_zoom - std::floor(m_zoom),
         glm::vec2(m_vpWidth, m_vpHeight),
-        (float)MapProjection::tileSize() * m_pixelScale
+        (float)MapProjection::tileSize() * m_pixelScale,
+        m_translated,
+        m_roll,
+        m_pitch
     };
 }
 
@@ -175,6 +180,18 @@ void View::setMaxPitch(float degrees) {
 
 }
 
+void View::setTileLodPixelError(float _pixels) {
+
+    m_tileLodPixelError = std::max(_pixels, 0.f);
+    m_dirtyTiles = true;
+}
+
+void View::setMaxVisibleTiles(int _tiles) {
+
+    m_maxVisibleTiles = std::max(_tiles, 0);
+    m_dirtyTiles = true;
+}
+
 void View::setMaxPitchStops(std::shared_ptr<Stops> stops) {
 
     m_maxPitchStops = stops;
@@ -314,6 +331,30 @@ void View::update() {
         m_changed = true;
         m_dirtyTiles = false;
     }
+
+    bool projectionChanged = m_zoom != m_lastProjection.zoom ||
+        m_roll != m_lastProjection.roll ||
+        m_pitch != m_lastProjection.pitch ||
+        m_pixelScale != m_lastProjection.pixelScale ||
+        m_fov != m_lastProjection.fov ||
+        m_vpWidth != m_lastProjection.width ||
+        m_vpHeight != m_lastProjection.height ||
+        m_type != m_lastProjection.type ||
+        m_padding != m_lastProjection.padding;
+
+    // Under a tilted perspective a translation moves points by different amounts
+    m_translated = m_changed && !projectionChanged &&
+        (m_type != CameraType::perspective || m_pitch == 0.f);
+
+    m_lastProjection.zoom = m_zoom;
+    m_lastProjection.roll = m_roll;
+    m_lastProjection.pitch = m_pitch;
+    m_lastProjection.pixelScale = m_pixelScale;
+    m_lastProjection.fov = m_fov;
+    m_lastProjection.width = m_vpWidth;
+    m_lastProjection.height = m_vpHeight;
+    m_lastProjection.type = m_type;
+    m_lastProjection.padding = m_padding;
 }
 
 glm::dmat2 View::getBoundsRect() const {
@@ -612,10 +653,22 @@ void View::getVisibleTiles(const std::function<void(TileID)>& _tileCb) const {
         int y_limit_pos[MAX_LOD] = { imax };
         int y_limit_neg[MAX_LOD] = { imin };
 
+        // Screen-space error: Element [n] is the minimum squared distance from the
+        // eye in tile space at which level-of-detail n + 1 keeps the pixel error.
+        // The eye is relative to the origin of its tile, so that the distances
+        // of each tile are computed in floats at any zoom.
+        glm::ivec2 eyeTile;
+        glm::vec3 eye;
+        float min_distance2[MAX_LOD];
+
         glm::ivec4 last = glm::ivec4{-1};
     };
 
     ScanParams opt{ zoom, static_cast<int>(m_maxZoom) };
+    opt.eyeTile = { int(std::floor(e.x)), int(std::floor(e.y)) };
+    opt.eye = { e.x - opt.eyeTile.x, e.y - opt.eyeTile.y, m_eye.z * invTileSize };
+    std::fill(std::begin(opt.min_distance2), std::end(opt.min_distance2),
+              std::numeric_limits<float>::infinity());
 
     if (m_type == CameraType::perspective) {
 
@@ -634,7 +687,22 @@ void View::getVisibleTiles(const std::function<void(TileID)>& _tileCb) const {
         }
     }
 
-    Rasterize::ScanCallback s = [&opt, &_tileCb](int x, int y) {
+    // A pixel of a tile at level-of-detail n appears exp2(fractZoom + n) * d0 / d pixels
+    // large at distance d from the eye, where d0 is the distance to the view center.
+    auto setPixelError = [&](double _pixelError) {
+        if (m_type != CameraType::perspective || _pixelError <= 0) { return; }
+        double centerDistance = m_pos.z * invTileSize;
+        for (int i = 0; i < MAX_LOD; i++) {
+            double d = exp2(m_zoom - zoom + i + 1) * centerDistance / _pixelError;
+            opt.min_distance2[i] = float(d * d);
+        }
+    };
+
+    // Tiles are passed to _tileCb, or collected to check the tile limit
+    std::vector<TileID> tiles;
+    bool collect = m_maxVisibleTiles > 0;
+
+    Rasterize::ScanCallback s = [&opt, &_tileCb, &tiles, collect](int x, int y) {
 
         int lod = 0;
         while (lod < MAX_LOD && x >= opt.x_limit_pos[lod]) { lod++; }
@@ -642,6 +710,20 @@ void View::getVisibleTiles(const std::function<void(TileID)>& _tileCb) const {
         while (lod < MAX_LOD && y >= opt.y_limit_pos[lod]) { lod++; }
         while (lod < MAX_LOD && y <  opt.y_limit_neg[lod]) { lod++; }
 
+        // Use the lowest zoom at which the nearest point of the tile keeps the pixel
+        // error. This depends only on the parent tile at that zoom, so neighbouring
+        // tiles select the same parent and never overlap.
+        glm::vec2 eye(opt.eye);
+        for (int i = MAX_LOD; i > lod; i--) {
+            glm::vec2 min((x >> i << i) - opt.eyeTile.x, (y >> i << i) - opt.eyeTile.y);
+            glm::vec2 max = min + float(1 << i);
+            glm::vec2 d = glm::max(glm::max(min - eye, eye - max), 0.f);
+            if (d.x * d.x + d.y * d.y + opt.eye.z * opt.eye.z >= opt.min_distance2[i - 1]) {
+                lod = i;
+                break;
+            }
+        }
+
         x >>= lod;
         y >>= lod;
 
@@ -654,18 +736,47 @@ void View::getVisibleTiles(const std::function<void(TileID)>& _tileCb) const {
 
         if (tile != opt.last) {
             opt.last = tile;
-            _tileCb(TileID(tile.x, tile.y, tile.z, tile.z));
+            TileID id(tile.x, tile.y, tile.z, tile.z);
+            if (collect) {
+                tiles.push_back(id);
+            } else {
+                _tileCb(id);
+            }
         }
     };
 
-    // Rasterize view trapezoid into tiles
-    Rasterize::scanTriangle(a, b, c, 0, maxTileIndex, s);
-    Rasterize::scanTriangle(c, d, a, 0, maxTileIndex, s);
+    auto scan = [&]() {
+        opt.last = glm::ivec4{-1};
+
+        // Rasterize view trapezoid into tiles
+        Rasterize::scanTriangle(a, b, c, 0, maxTileIndex, s);
+        Rasterize::scanTriangle(c, d, a, 0, maxTileIndex, s);
+
+        // Rasterize the area bounded by the point under the view center and the two nearest corners
+        // of the view trapezoid. This is necessary to not cull any geometry with height in these tiles
+        // (which should remain visible, even though the base of the tile is not).
+        Rasterize::scanTriangle(a, b, e, 0, maxTileIndex, s);
+    };
+
+    double pixelError = m_tileLodPixelError;
+    setPixelError(pixelError);
+    scan();
+
+    if (!collect) { return; }
+
+    // Raise the pixel error until the tiles fit into the limit
+    for (int i = 0; ; i++) {
+        std::sort(tiles.begin(), tiles.end());
+        tiles.erase(std::unique(tiles.begin(), tiles.end()), tiles.end());
+        if (tiles.size() <= size_t(m_maxVisibleTiles) || i == MAX_LOD) { break; }
+
+        pixelError = std::max(pixelError, 1.0) * 2.0;
+        setPixelError(pixelError);
+        tiles.clear();
+        scan();
+    }
 
-    // Rasterize the area bounded by the point under the view center and the two nearest corners
-    // of the view trapezoid. This is necessary to not cull any geometry with height in these tiles
-    // (which should remain visible, even though the base of the tile is not).
-    Rasterize::scanTriangle(a, b, e, 0, maxTileIndex, s);
+    for (const auto& tile : tiles) { _tileCb(tile); }
 }
 
 }
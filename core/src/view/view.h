@@ -45,6 +45,10 @@ struct ViewState {
     float fractZoom;
     glm::vec2 viewportSize;
     float tileSize;
+    // The last update only moved the screen positions of the map uniformly
+    bool translatedOnLastUpdate = false;
+    float rotation = 0.f;
+    float pitch = 0.f;
 };
 
 // View
@@ -111,6 +115,16 @@ public:
     // Get the maximum pitch angle for the current zoom, in degrees.
     float getMaxPitch() const;
 
+    // Set the screen-space error in pixels up to which tiles far from the camera are
+    // drawn at lower zoom levels: a pixel of such tiles covers at most this many pixels
+    // on screen. 0 disables it. Default is 1.5, which keeps the integer zoom in views
+    // without tilt.
+    void setTileLodPixelError(float _pixels);
+
+    // Set the maximum number of visible tiles; above it the pixel error is raised until
+    // the tiles fit. 0 (default) means no limit.
+    void setMaxVisibleTiles(int _tiles);
+
     // Whether to constrain visible area to the projected bounds of the world.
     void setConstrainToWorldBounds(bool constrainToWorldBounds);
 
@@ -165,6 +179,17 @@ public:
     // Get the position of the view in projection units (z is the effective 'height' determined from zoom).
     const glm::dvec3& getPosition() const { return m_pos; }
 
+    // Set the motion of the view that is not driven by user input, e.g. a fling: its current
+    // velocity in projection units per second and the translation left until it comes to rest.
+    void setMotion(glm::dvec2 _velocity, glm::dvec2 _remainingTranslation) {
+        m_velocity = _velocity;
+        m_remainingTranslation = _remainingTranslation;
+    }
+
+    const glm::dvec2& getVelocity() const { return m_velocity; }
+
+    const glm::dvec2& getRemainingTranslation() const { return m_remainingTranslation; }
+
     // Get the coordinates of the point at the center of the view.
     LngLat getCenterCoordinates() const;
 
@@ -224,6 +249,10 @@ public:
     // Returns true if the view properties have changed since the last call to update().
     bool changedOnLastUpdate() const { return m_changed; }
 
+    // Returns true if the last call to update() only translated the view in screen space,
+    // i.e. the position changed while zoom, rotation, tilt and projection stayed the same.
+    bool translatedOnLastUpdate() const { return m_translated; }
+
     const glm::mat4& getOrthoViewportMatrix() const { return m_orthoViewport; };
 
     float pixelScale() const { return m_pixelScale; }
@@ -246,6 +275,8 @@ protected:
     ViewConstraint m_constraint;
 
     glm::dvec3 m_pos;
+    glm::dvec2 m_velocity = glm::dvec2(0.0);
+    glm::dvec2 m_remainingTranslation = glm::dvec2(0.0);
     glm::vec3 m_eye;
     glm::vec2 m_obliqueAxis;
     glm::vec2 m_vanishingPoint;
@@ -275,6 +306,8 @@ protected:
     float m_maxPitch = 90.f;
     float m_minZoom = 0.f;
     float m_maxZoom = 20.5f;
+    float m_tileLodPixelError = 1.5f;
+    int m_maxVisibleTiles = 0;
 
     CameraType m_type;
 
@@ -284,8 +317,22 @@ protected:
     bool m_dirtyTiles;
     bool m_dirtyWorldBoundsMinZoom;
     bool m_changed;
+    bool m_translated = false;
     bool m_constrainToWorldBounds = true;
 
+    // View parameters other than the position at the last update()
+    struct {
+        float zoom = -1.f;
+        float roll = 0.f;
+        float pitch = 0.f;
+        float pixelScale = 0.f;
+        float fov = 0.f;
+        int width = 0;
+        int height = 0;
+        CameraType type = CameraType::perspective;
+        EdgePadding padding;
+    } m_lastProjection;
+
 };
 
 }
@@ -24,6 +24,17 @@ if(TANGRAM_MBTILES_DATASOURCE)
   target_compile_definitions(tangram PRIVATE TANGRAM_MBTILES_DATASOURCE=1)
 endif()
 
+# Send HTTP requests with the curl-based UrlClient instead of the Java HttpHandler.
+# Needs a libcurl built for the target ABI, found through CURL_INCLUDE_DIR and CURL_LIBRARY.
+option(TANGRAM_ANDROID_NATIVE_HTTP "Include the native UrlClient" OFF)
+if(TANGRAM_ANDROID_NATIVE_HTTP)
+  find_package(CURL REQUIRED)
+  target_sources(tangram PRIVATE platforms/common/urlClient.cpp)
+  target_include_directories(tangram PRIVATE platforms/common ${CURL_INCLUDE_DIRS})
+  target_compile_definitions(tangram PRIVATE TANGRAM_NATIVE_HTTP=1)
+  target_link_libraries(tangram PRIVATE ${CURL_LIBRARIES})
+endif()
+
 target_link_libraries(tangram
   PRIVATE
   tangram-core
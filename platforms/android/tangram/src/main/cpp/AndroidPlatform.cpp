@@ -3,7 +3,9 @@
 #include "JniHelpers.h"
 #include "JniThreadBinding.h"
 
+#include "gl/hardware.h"
 #include "log.h"
+#include "util/cpuTopology.h"
 #include "util/url.h"
 
 #ifndef GL_GLEXT_PROTOTYPES
@@ -15,6 +17,7 @@
 #include <GLES2/gl2platform.h>
 #include <android/log.h>
 #include <android/asset_manager_jni.h>
+#include <algorithm>
 #include <cstdarg>
 #include <dlfcn.h> // dlopen, dlsym
 #include <libgen.h>
@@ -28,6 +31,26 @@
 PFNGLBINDVERTEXARRAYOESPROC glBindVertexArrayOESEXT = 0;
 PFNGLDELETEVERTEXARRAYSOESPROC glDeleteVertexArraysOESEXT = 0;
 PFNGLGENVERTEXARRAYSOESPROC glGenVertexArraysOESEXT = 0;
+PFNGLVERTEXATTRIBDIVISOREXTPROC glVertexAttribDivisorEXTPTR = 0;
+PFNGLDRAWELEMENTSINSTANCEDEXTPROC glDrawElementsInstancedEXTPTR = 0;
+PFNGLBINDBUFFERBASEPROC glBindBufferBasePTR = 0;
+PFNGLGETUNIFORMBLOCKINDEXPROC glGetUniformBlockIndexPTR = 0;
+PFNGLUNIFORMBLOCKBINDINGPROC glUniformBlockBindingPTR = 0;
+PFNGLGETACTIVEUNIFORMBLOCKIVPROC glGetActiveUniformBlockivPTR = 0;
+PFNGLGETUNIFORMINDICESPROC glGetUniformIndicesPTR = 0;
+PFNGLGETACTIVEUNIFORMSIVPROC glGetActiveUniformsivPTR = 0;
+PFNGLGETPROGRAMBINARYPROC glGetProgramBinaryPTR = 0;
+PFNGLPROGRAMBINARYPROC glProgramBinaryPTR = 0;
+PFNGLMAPBUFFERRANGEPROC glMapBufferRangePTR = 0;
+PFNGLDISPATCHCOMPUTEPROC glDispatchComputePTR = 0;
+PFNGLMEMORYBARRIERPROC glMemoryBarrierPTR = 0;
+PFNGLDRAWELEMENTSBASEVERTEXPROC glDrawElementsBaseVertexPTR = 0;
+PFNGLGENQUERIESPROC glGenQueriesPTR = 0;
+PFNGLDELETEQUERIESPROC glDeleteQueriesPTR = 0;
+PFNGLBEGINQUERYPROC glBeginQueryPTR = 0;
+PFNGLENDQUERYPROC glEndQueryPTR = 0;
+PFNGLGETQUERYOBJECTUIVPROC glGetQueryObjectuivPTR = 0;
+PFNGLGETQUERYOBJECTUI64VPROC glGetQueryObjectui64vPTR = 0;
 
 namespace Tangram {
 
@@ -48,6 +71,10 @@ static jmethodID getFontFallbackFilePath = nullptr;
 
 static bool glExtensionsLoaded = false;
 
+#ifdef TANGRAM_NATIVE_HTTP
+constexpr UrlRequestId AndroidPlatform::native_request_bit;
+#endif
+
 void AndroidPlatform::jniOnLoad(JavaVM* javaVM, JNIEnv* jniEnv) {
     // JNI OnLoad is invoked once when the native library is loaded so this is a good place to cache
     // any method or class IDs that we'll need.
@@ -85,10 +112,31 @@ AndroidPlatform::AndroidPlatform(JNIEnv* jniEnv, jobject mapController, jobject
 }
 
 void AndroidPlatform::shutdown() {
+#ifdef TANGRAM_NATIVE_HTTP
+    {
+        // Stop all UrlClient threads
+        std::lock_guard<std::mutex> lock(m_urlClientMutex);
+        m_urlClient.reset();
+    }
+#endif
     Platform::shutdown();
     m_jniWorker.stop();
 }
 
+bool AndroidPlatform::useNativeUrlClient(bool _use) {
+#ifdef TANGRAM_NATIVE_HTTP
+    std::lock_guard<std::mutex> lock(m_urlClientMutex);
+    if (_use && !m_urlClient) {
+        m_urlClient = std::make_unique<UrlClient>(UrlClient::Options{});
+    } else if (!_use) {
+        m_urlClient.reset();
+    }
+    return true;
+#else
+    return !_use;
+#endif
+}
+
 std::string AndroidPlatform::fontPath(const std::string& family, const std::string& weight, const std::string& style) const {
 
     JniThreadBinding jniEnv(JniHelpers::getJVM());
@@ -148,9 +196,8 @@ FontSourceHandle AndroidPlatform::systemFont(const std::string& name, const std:
 
     if (path.empty()) { return {}; }
 
-    auto data = bytesFromFile(Url(path.c_str()));
-
-    return FontSourceHandle([data]() { return data; });
+    // System fonts are files, which FreeType maps instead of reading them into memory
+    return FontSourceHandle(Url(path));
 }
 
 void AndroidPlatform::setContinuousRendering(bool isContinuous) {
@@ -205,6 +252,11 @@ std::vector<char> AndroidPlatform::bytesFromFile(const Url& url) const {
 }
 
 bool AndroidPlatform::startUrlRequestImpl(const Url& url, const UrlRequestHandle request, UrlRequestId& id) {
+    return startConditionalUrlRequestImpl(url, UrlValidators(), request, id);
+}
+
+bool AndroidPlatform::startConditionalUrlRequestImpl(const Url& url, const UrlValidators& validators,
+                                                     const UrlRequestHandle request, UrlRequestId& id) {
 
     // If the requested URL does not use HTTP or HTTPS, retrieve it asynchronously.
     if (!url.hasHttpScheme()) {
@@ -216,6 +268,20 @@ bool AndroidPlatform::startUrlRequestImpl(const Url& url, const UrlRequestHandle
         return false;
     }
 
+#ifdef TANGRAM_NATIVE_HTTP
+    {
+        // Responses of the native client are read on its own threads
+        std::lock_guard<std::mutex> lock(m_urlClientMutex);
+        if (m_urlClient) {
+            id = native_request_bit | m_urlClient->addRequest(url.string(),
+                [this, request](UrlResponse&& response) {
+                    onUrlResponse(request, std::move(response));
+                }, validators);
+            return true;
+        }
+    }
+#endif
+
     // We can use UrlRequestHandle to cancel requests. MapController handles the
     // mapping between UrlRequestHandle and request object
     id = request;
@@ -242,6 +308,14 @@ bool AndroidPlatform::startUrlRequestImpl(const Url& url, const UrlRequestHandle
 
 void AndroidPlatform::cancelUrlRequestImpl(const UrlRequestId id) {
 
+#ifdef TANGRAM_NATIVE_HTTP
+    if (id & native_request_bit) {
+        std::lock_guard<std::mutex> lock(m_urlClientMutex);
+        if (m_urlClient) { m_urlClient->cancelRequest(id & ~native_request_bit); }
+        return;
+    }
+#endif
+
     m_jniWorker.enqueue([=](JNIEnv *jniEnv) {
 
         jlong jRequestHandle = static_cast<jlong>(id);
@@ -250,16 +324,29 @@ void AndroidPlatform::cancelUrlRequestImpl(const UrlRequestId id) {
     });
 }
 
+void AndroidPlatform::setUrlRequestPriorityImpl(const UrlRequestId id, float priority) {
+
+#ifdef TANGRAM_NATIVE_HTTP
+    // Requests of the Java HttpHandler are left to OkHttp's dispatcher
+    if (id & native_request_bit) {
+        std::lock_guard<std::mutex> lock(m_urlClientMutex);
+        if (m_urlClient) { m_urlClient->setRequestPriority(id & ~native_request_bit, priority); }
+    }
+#endif
+}
+
 void AndroidPlatform::onUrlComplete(JNIEnv* _jniEnv, jlong _jRequestHandle, jbyteArray _jBytes, jstring _jError) {
     // Start building a response object.
     UrlResponse response;
 
+    // Release the buffer of a request that failed while Java read into it
+    releaseUrlBuffer(_jRequestHandle);
+
     // If the request was successful, we will receive a non-null byte array.
     if (_jBytes != nullptr) {
         size_t length = _jniEnv->GetArrayLength(_jBytes);
         response.content.resize(length);
         _jniEnv->GetByteArrayRegion(_jBytes, 0, length, reinterpret_cast<jbyte*>(response.content.data()));
-        // TODO: Can we use a DirectByteBuffer to transfer data with fewer copies?
     }
 
     // If the request was unsuccessful, we will receive a non-null error string.
@@ -278,22 +365,133 @@ void AndroidPlatform::onUrlComplete(JNIEnv* _jniEnv, jlong _jRequestHandle, jbyt
     });
 }
 
+jobject AndroidPlatform::allocateUrlBuffer(JNIEnv* _jniEnv, jlong _jRequestHandle, jint _jSize) {
+    if (_jSize < 0) { return nullptr; }
+
+    std::lock_guard<std::mutex> lock(m_urlBufferMutex);
+    auto& buffer = m_urlBuffers[_jRequestHandle];
+    buffer.resize(_jSize);
+    return _jniEnv->NewDirectByteBuffer(buffer.data(), buffer.size());
+}
+
+void AndroidPlatform::releaseUrlBuffer(jlong _jRequestHandle) {
+    std::lock_guard<std::mutex> lock(m_urlBufferMutex);
+    m_urlBuffers.erase(_jRequestHandle);
+}
+
+void AndroidPlatform::onUrlBufferComplete(JNIEnv* _jniEnv, jlong _jRequestHandle, jint _jLength) {
+    UrlResponse response;
+
+    {
+        std::lock_guard<std::mutex> lock(m_urlBufferMutex);
+        auto it = m_urlBuffers.find(_jRequestHandle);
+        if (it == m_urlBuffers.end()) {
+            response.error = "Missing response buffer";
+        } else {
+            response.content = std::move(it->second);
+            m_urlBuffers.erase(it);
+            // Java may have read less than the announced content length
+            response.content.resize(std::min(response.content.size(), size_t(std::max(_jLength, 0))));
+        }
+    }
+
+    m_fileWorker.enqueue([this, _jRequestHandle, r = std::move(response)]() mutable {
+        UrlRequestHandle requestHandle = static_cast<UrlRequestHandle>(_jRequestHandle);
+
+        onUrlResponse(requestHandle, std::move(r));
+    });
+}
+
 void setCurrentThreadPriority(int priority) {
     setpriority(PRIO_PROCESS, 0, priority);
 }
 
+void setCurrentThreadPlacement(ThreadRole _role, ThreadPlacement _placement) {
+    setCurrentThreadAffinity(CpuTopology::get().affinity(_role, _placement));
+}
+
 void initGLExtensions() {
-    if (glExtensionsLoaded) {
-        return;
+    if (!glExtensionsLoaded) {
+        void* libhandle = dlopen("libGLESv2.so", RTLD_LAZY);
+
+        glBindVertexArrayOESEXT = (PFNGLBINDVERTEXARRAYOESPROC) dlsym(libhandle, "glBindVertexArrayOES");
+        glDeleteVertexArraysOESEXT = (PFNGLDELETEVERTEXARRAYSOESPROC) dlsym(libhandle, "glDeleteVertexArraysOES");
+        glGenVertexArraysOESEXT = (PFNGLGENVERTEXARRAYSOESPROC) dlsym(libhandle, "glGenVertexArraysOES");
+
+        // Core in GLES 3, GL_EXT_instanced_arrays in GLES 2
+        glVertexAttribDivisorEXTPTR = (PFNGLVERTEXATTRIBDIVISOREXTPROC) dlsym(libhandle, "glVertexAttribDivisor");
+        if (!glVertexAttribDivisorEXTPTR) {
+            glVertexAttribDivisorEXTPTR = (PFNGLVERTEXATTRIBDIVISOREXTPROC) dlsym(libhandle, "glVertexAttribDivisorEXT");
+        }
+        glDrawElementsInstancedEXTPTR = (PFNGLDRAWELEMENTSINSTANCEDEXTPROC) dlsym(libhandle, "glDrawElementsInstanced");
+        if (!glDrawElementsInstancedEXTPTR) {
+            glDrawElementsInstancedEXTPTR = (PFNGLDRAWELEMENTSINSTANCEDEXTPROC) dlsym(libhandle, "glDrawElementsInstancedEXT");
+        }
+
+        // Core in GLES 3
+        glBindBufferBasePTR = (PFNGLBINDBUFFERBASEPROC) dlsym(libhandle, "glBindBufferBase");
+        glGetUniformBlockIndexPTR = (PFNGLGETUNIFORMBLOCKINDEXPROC) dlsym(libhandle, "glGetUniformBlockIndex");
+        glUniformBlockBindingPTR = (PFNGLUNIFORMBLOCKBINDINGPROC) dlsym(libhandle, "glUniformBlockBinding");
+        glGetActiveUniformBlockivPTR = (PFNGLGETACTIVEUNIFORMBLOCKIVPROC) dlsym(libhandle, "glGetActiveUniformBlockiv");
+        glGetUniformIndicesPTR = (PFNGLGETUNIFORMINDICESPROC) dlsym(libhandle, "glGetUniformIndices");
+        glGetActiveUniformsivPTR = (PFNGLGETACTIVEUNIFORMSIVPROC) dlsym(libhandle, "glGetActiveUniformsiv");
+        glGetProgramBinaryPTR = (PFNGLGETPROGRAMBINARYPROC) dlsym(libhandle, "glGetProgramBinary");
+        glProgramBinaryPTR = (PFNGLPROGRAMBINARYPROC) dlsym(libhandle, "glProgramBinary");
+        glMapBufferRangePTR = (PFNGLMAPBUFFERRANGEPROC) dlsym(libhandle, "glMapBufferRange");
+
+        // Core in GLES 3.1
+        glDispatchComputePTR = (PFNGLDISPATCHCOMPUTEPROC) dlsym(libhandle, "glDispatchCompute");
+        glMemoryBarrierPTR = (PFNGLMEMORYBARRIERPROC) dlsym(libhandle, "glMemoryBarrier");
+
+        // Core in GLES 3.2, GL_OES_ or GL_EXT_draw_elements_base_vertex before
+        glDrawElementsBaseVertexPTR = (PFNGLDRAWELEMENTSBASEVERTEXPROC) dlsym(libhandle, "glDrawElementsBaseVertex");
+        if (!glDrawElementsBaseVertexPTR) {
+            glDrawElementsBaseVertexPTR = (PFNGLDRAWELEMENTSBASEVERTEXPROC) dlsym(libhandle, "glDrawElementsBaseVertexOES");
+        }
+        if (!glDrawElementsBaseVertexPTR) {
+            glDrawElementsBaseVertexPTR = (PFNGLDRAWELEMENTSBASEVERTEXPROC) dlsym(libhandle, "glDrawElementsBaseVertexEXT");
+        }
+
+        // GL_EXT_disjoint_timer_query, its query object functions are core in GLES 3
+        glGenQueriesPTR = (PFNGLGENQUERIESPROC) dlsym(libhandle, "glGenQueriesEXT");
+        glDeleteQueriesPTR = (PFNGLDELETEQUERIESPROC) dlsym(libhandle, "glDeleteQueriesEXT");
+        glBeginQueryPTR = (PFNGLBEGINQUERYPROC) dlsym(libhandle, "glBeginQueryEXT");
+        glEndQueryPTR = (PFNGLENDQUERYPROC) dlsym(libhandle, "glEndQueryEXT");
+        glGetQueryObjectuivPTR = (PFNGLGETQUERYOBJECTUIVPROC) dlsym(libhandle, "glGetQueryObjectuivEXT");
+        glGetQueryObjectui64vPTR = (PFNGLGETQUERYOBJECTUI64VPROC) dlsym(libhandle, "glGetQueryObjectui64vEXT");
+
+        glExtensionsLoaded = true;
+    }
+
+    if (!glVertexAttribDivisorEXTPTR || !glDrawElementsInstancedEXTPTR) {
+        Hardware::supportsInstancing = false;
+    }
+
+    if (!glBindBufferBasePTR || !glGetUniformBlockIndexPTR || !glUniformBlockBindingPTR ||
+        !glGetActiveUniformBlockivPTR || !glGetUniformIndicesPTR || !glGetActiveUniformsivPTR) {
+        Hardware::supportsUniformBuffers = false;
+    }
+
+    if (!glGetProgramBinaryPTR || !glProgramBinaryPTR) {
+        Hardware::supportsProgramBinary = false;
+    }
+
+    if (!glMapBufferRangePTR) {
+        Hardware::supportsPixelBufferObjects = false;
     }
 
-    void* libhandle = dlopen("libGLESv2.so", RTLD_LAZY);
+    if (!glDispatchComputePTR || !glMemoryBarrierPTR || !glBindBufferBasePTR || !glMapBufferRangePTR) {
+        Hardware::supportsComputeShaders = false;
+    }
 
-    glBindVertexArrayOESEXT = (PFNGLBINDVERTEXARRAYOESPROC) dlsym(libhandle, "glBindVertexArrayOES");
-    glDeleteVertexArraysOESEXT = (PFNGLDELETEVERTEXARRAYSOESPROC) dlsym(libhandle, "glDeleteVertexArraysOES");
-    glGenVertexArraysOESEXT = (PFNGLGENVERTEXARRAYSOESPROC) dlsym(libhandle, "glGenVertexArraysOES");
+    if (!glDrawElementsBaseVertexPTR) {
+        Hardware::supportsBaseVertex = false;
+    }
 
-    glExtensionsLoaded = true;
+    if (!glGenQueriesPTR || !glDeleteQueriesPTR || !glBeginQueryPTR || !glEndQueryPTR ||
+        !glGetQueryObjectuivPTR || !glGetQueryObjectui64vPTR) {
+        Hardware::supportsTimerQuery = false;
+    }
 }
 
 } // namespace Tangram
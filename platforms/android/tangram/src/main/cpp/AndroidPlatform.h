@@ -4,9 +4,14 @@
 #include "JniWorker.h"
 #include "util/asyncWorker.h"
 
+#ifdef TANGRAM_NATIVE_HTTP
+#include "urlClient.h"
+#endif
+
 #include <jni.h>
 #include <android/asset_manager.h>
 #include <atomic>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <unordered_map>
@@ -33,10 +38,29 @@ public:
     FontSourceHandle systemFont(const std::string& name, const std::string& weight, const std::string& face) const override;
     std::vector<FontSourceHandle> systemFontFallbacksHandle() const override;
     bool startUrlRequestImpl(const Url& url, const UrlRequestHandle request, UrlRequestId& id) override;
+    bool startConditionalUrlRequestImpl(const Url& url, const UrlValidators& validators,
+                                        const UrlRequestHandle request, UrlRequestId& id) override;
     void cancelUrlRequestImpl(const UrlRequestId id) override;
+    void setUrlRequestPriorityImpl(const UrlRequestId id, float priority) override;
+
+    // Send HTTP requests with the native UrlClient instead of the HttpHandler
+    // of the MapController. Returns false when the library is built without
+    // TANGRAM_NATIVE_HTTP.
+    bool useNativeUrlClient(bool use);
 
     void onUrlComplete(JNIEnv* jniEnv, jlong jRequestHandle, jbyteArray jBytes, jstring jError);
 
+    // Returns a direct ByteBuffer over native memory of _size bytes, into which
+    // Java reads the body of the response of a request. The memory is passed on
+    // with the response by onUrlBufferComplete() without a copy.
+    jobject allocateUrlBuffer(JNIEnv* jniEnv, jlong jRequestHandle, jint jSize);
+
+    // Complete a request with the first _length bytes of its buffer
+    void onUrlBufferComplete(JNIEnv* jniEnv, jlong jRequestHandle, jint jLength);
+
+    // Free the buffer of a request that was canceled while Java read into it
+    void releaseUrlBuffer(jlong jRequestHandle);
+
     static void jniOnLoad(JavaVM* javaVM, JNIEnv* jniEnv);
 
 private:
@@ -50,6 +74,18 @@ private:
 
     mutable JniWorker m_jniWorker;
     AsyncWorker m_fileWorker;
+
+#ifdef TANGRAM_NATIVE_HTTP
+    // Set when requests are sent by the native client. Its request IDs are
+    // marked with native_request_bit to tell them apart from Java handles.
+    static constexpr UrlRequestId native_request_bit = UrlRequestId(1) << 63;
+    std::mutex m_urlClientMutex;
+    std::unique_ptr<UrlClient> m_urlClient;
+#endif
+
+    // Buffers of allocateUrlBuffer() by request, until the request completes
+    std::mutex m_urlBufferMutex;
+    std::unordered_map<jlong, std::vector<char>> m_urlBuffers;
 };
 
 } // namespace Tangram
@@ -30,6 +30,16 @@ std::vector<Tangram::SceneUpdate> unpackSceneUpdates(JNIEnv* jniEnv, jobjectArra
     return sceneUpdates;
 }
 
+std::vector<Tangram::MarkerID> markerIDsFromJava(JNIEnv* env, jlongArray jmarkerIDs) {
+    std::vector<Tangram::MarkerID> markerIDs(env->GetArrayLength(jmarkerIDs));
+    auto* ids = env->GetLongArrayElements(jmarkerIDs, nullptr);
+    for (size_t i = 0; i < markerIDs.size(); i++) {
+        markerIDs[i] = static_cast<Tangram::MarkerID>(ids[i]);
+    }
+    env->ReleaseLongArrayElements(jmarkerIDs, ids, JNI_ABORT);
+    return markerIDs;
+}
+
 extern "C" {
 
 #define NATIVE_METHOD(NAME) JNIEXPORT JNICALL Java_com_mapzen_tangram_NativeMap_ ## NAME
@@ -305,6 +315,26 @@ void NATIVE_METHOD(onUrlComplete)(JNIEnv* env, jobject obj, jlong requestHandle,
     map->androidPlatform().onUrlComplete(env, requestHandle, fetchedBytes, errorString);
 }
 
+jobject NATIVE_METHOD(allocateUrlBuffer)(JNIEnv* env, jobject obj, jlong requestHandle, jint size) {
+    auto* map = androidMapFromJava(env, obj);
+    return map->androidPlatform().allocateUrlBuffer(env, requestHandle, size);
+}
+
+void NATIVE_METHOD(onUrlBufferComplete)(JNIEnv* env, jobject obj, jlong requestHandle, jint length) {
+    auto* map = androidMapFromJava(env, obj);
+    map->androidPlatform().onUrlBufferComplete(env, requestHandle, length);
+}
+
+jboolean NATIVE_METHOD(useNativeUrlClient)(JNIEnv* env, jobject obj, jboolean use) {
+    auto* map = androidMapFromJava(env, obj);
+    return static_cast<jboolean>(map->androidPlatform().useNativeUrlClient(use));
+}
+
+void NATIVE_METHOD(releaseUrlBuffer)(JNIEnv* env, jobject obj, jlong requestHandle) {
+    auto* map = androidMapFromJava(env, obj);
+    map->androidPlatform().releaseUrlBuffer(requestHandle);
+}
+
 void NATIVE_METHOD(setPickRadius)(JNIEnv* env, jobject obj, jfloat radius) {
     auto* map = androidMapFromJava(env, obj);
     map->setPickRadius(radius);
@@ -339,6 +369,74 @@ jboolean NATIVE_METHOD(markerRemove)(JNIEnv* env, jobject obj, jlong markerID) {
     return static_cast<jboolean>(result);
 }
 
+void NATIVE_METHOD(markerAddBulk)(JNIEnv* env, jobject obj, jlongArray jmarkerIDs) {
+    auto* map = androidMapFromJava(env, obj);
+
+    std::vector<Tangram::MarkerID> markerIDs(env->GetArrayLength(jmarkerIDs));
+    map->markerAdd(markerIDs.data(), markerIDs.size());
+
+    auto* ids = env->GetLongArrayElements(jmarkerIDs, nullptr);
+    for (size_t i = 0; i < markerIDs.size(); i++) {
+        ids[i] = static_cast<jlong>(markerIDs[i]);
+    }
+    env->ReleaseLongArrayElements(jmarkerIDs, ids, 0);
+}
+
+jint NATIVE_METHOD(markerRemoveBulk)(JNIEnv* env, jobject obj, jlongArray jmarkerIDs) {
+    auto* map = androidMapFromJava(env, obj);
+
+    auto markerIDs = markerIDsFromJava(env, jmarkerIDs);
+    return map->markerRemove(markerIDs.data(), markerIDs.size());
+}
+
+jlong NATIVE_METHOD(markerCreateStylingFromString)(JNIEnv* env, jobject obj, jstring styling) {
+    auto* map = androidMapFromJava(env, obj);
+
+    auto styleString = JniHelpers::stringFromJavaString(env, styling);
+    return static_cast<jlong>(map->markerCreateStylingFromString(styleString.c_str()));
+}
+
+jlong NATIVE_METHOD(markerCreateStylingFromPath)(JNIEnv* env, jobject obj, jstring path) {
+    auto* map = androidMapFromJava(env, obj);
+
+    auto pathString = JniHelpers::stringFromJavaString(env, path);
+    return static_cast<jlong>(map->markerCreateStylingFromPath(pathString.c_str()));
+}
+
+jboolean NATIVE_METHOD(markerRemoveStyling)(JNIEnv* env, jobject obj, jlong stylingID) {
+    auto* map = androidMapFromJava(env, obj);
+
+    auto result = map->markerRemoveStyling(static_cast<unsigned int>(stylingID));
+    return static_cast<jboolean>(result);
+}
+
+jint NATIVE_METHOD(markerSetStylingBulk)(JNIEnv* env, jobject obj, jlongArray jmarkerIDs,
+                                         jlong stylingID) {
+    auto* map = androidMapFromJava(env, obj);
+
+    auto markerIDs = markerIDsFromJava(env, jmarkerIDs);
+    return map->markerSetStyling(markerIDs.data(), markerIDs.size(),
+                                 static_cast<unsigned int>(stylingID));
+}
+
+jint NATIVE_METHOD(markerSetPointBulk)(JNIEnv* env, jobject obj, jlongArray jmarkerIDs,
+                                       jdoubleArray jcoordinates) {
+    auto* map = androidMapFromJava(env, obj);
+
+    auto markerIDs = markerIDsFromJava(env, jmarkerIDs);
+    if (env->GetArrayLength(jcoordinates) < jsize(2 * markerIDs.size())) { return 0; }
+
+    auto* coordinates = env->GetDoubleArrayElements(jcoordinates, nullptr);
+    std::vector<Tangram::LngLat> points;
+    points.reserve(markerIDs.size());
+    for (size_t i = 0; i < markerIDs.size(); ++i) {
+        points.emplace_back(coordinates[2 * i], coordinates[2 * i + 1]);
+    }
+    env->ReleaseDoubleArrayElements(jcoordinates, coordinates, JNI_ABORT);
+
+    return map->markerSetPoint(markerIDs.data(), points.data(), markerIDs.size());
+}
+
 jboolean NATIVE_METHOD(markerSetStylingFromString)(JNIEnv* env, jobject obj, jlong markerID,
                                                    jstring styling) {
     auto* map = androidMapFromJava(env, obj);
@@ -574,6 +672,47 @@ void NATIVE_METHOD(addClientDataFeature)(JNIEnv* env, jobject obj, jlong javaSou
     env->ReleaseDoubleArrayElements(javaCoordinates, coordinates, JNI_ABORT);
 }
 
+void NATIVE_METHOD(addClientDataPoints)(JNIEnv* env, jobject obj, jlong javaSourcePtr, jdoubleArray javaCoordinates,
+                                       jobjectArray javaNumberKeys, jdoubleArray javaNumberValues,
+                                       jobjectArray javaStringKeys, jobjectArray javaStringValues) {
+    auto* source = reinterpret_cast<ClientDataSource*>(javaSourcePtr);
+
+    size_t nPoints = env->GetArrayLength(javaCoordinates) / 2;
+    int nNumberKeys = (javaNumberKeys == NULL) ? 0 : env->GetArrayLength(javaNumberKeys);
+    int nStringKeys = (javaStringKeys == NULL) ? 0 : env->GetArrayLength(javaStringKeys);
+
+    // Values are stored column by column: all values of the first key, then of the second key...
+    auto* coordinates = env->GetDoubleArrayElements(javaCoordinates, NULL);
+    double* numberValues = (nNumberKeys > 0) ? env->GetDoubleArrayElements(javaNumberValues, NULL) : nullptr;
+
+    std::vector<ClientDataSource::NumberColumn> numbers;
+    for (int i = 0; i < nNumberKeys; ++i) {
+        auto javaKey = (jstring) (env->GetObjectArrayElement(javaNumberKeys, i));
+        numbers.push_back({JniHelpers::stringFromJavaString(env, javaKey), numberValues + i * nPoints});
+        env->DeleteLocalRef(javaKey);
+    }
+
+    std::vector<std::string> stringValues(nStringKeys * nPoints);
+    for (size_t i = 0; i < stringValues.size(); ++i) {
+        auto javaValue = (jstring) (env->GetObjectArrayElement(javaStringValues, i));
+        stringValues[i] = JniHelpers::stringFromJavaString(env, javaValue);
+        env->DeleteLocalRef(javaValue);
+    }
+    std::vector<ClientDataSource::StringColumn> strings;
+    for (int i = 0; i < nStringKeys; ++i) {
+        auto javaKey = (jstring) (env->GetObjectArrayElement(javaStringKeys, i));
+        strings.push_back({JniHelpers::stringFromJavaString(env, javaKey), stringValues.data() + i * nPoints});
+        env->DeleteLocalRef(javaKey);
+    }
+
+    source->addPointFeatures(nPoints, coordinates, numbers, strings);
+
+    if (numberValues) {
+        env->ReleaseDoubleArrayElements(javaNumberValues, numberValues, JNI_ABORT);
+    }
+    env->ReleaseDoubleArrayElements(javaCoordinates, coordinates, JNI_ABORT);
+}
+
 void NATIVE_METHOD(addClientDataGeoJson)(JNIEnv* env, jobject obj, jlong javaSourcePtr, jstring javaGeoJson) {
     auto* source = reinterpret_cast<ClientDataSource*>(javaSourcePtr);
     auto data = JniHelpers::stringFromJavaString(env, javaGeoJson);
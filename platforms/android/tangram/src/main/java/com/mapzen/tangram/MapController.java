@@ -20,6 +20,8 @@ import com.mapzen.tangram.networking.DefaultHttpHandler;
 import com.mapzen.tangram.networking.HttpHandler;
 
 import java.io.IOException;
+import java.nio.ByteBuffer;
+import java.util.ArrayList;
 import java.util.Collections;
 import java.util.HashMap;
 import java.util.List;
@@ -1011,6 +1013,106 @@ public class MapController {
         return nativeMap.markerRemove(markerId);
     }
 
+    /**
+     * Adds several {@link Marker}s to the map with a single call into the native map.
+     * @param count number of markers to add
+     * @return Newly created {@link Marker} objects.
+     */
+    @NonNull
+    public List<Marker> addMarkers(final int count) {
+        final long[] markerIds = new long[count];
+        nativeMap.markerAddBulk(markerIds);
+
+        final List<Marker> result = new ArrayList<>(count);
+        for (final long markerId : markerIds) {
+            final Marker marker = new Marker(viewHolder.getView().getContext(), markerId, this);
+            markers.put(markerId, marker);
+            result.add(marker);
+        }
+        return result;
+    }
+
+    /**
+     * Removes the passed in {@link Marker}s from the map with a single call into the native map.
+     * @param markersToRemove markers to remove from the map
+     * @return the number of markers removed
+     */
+    public int removeMarkers(@NonNull final List<Marker> markersToRemove) {
+        final long[] markerIds = markerIds(markersToRemove);
+        for (final long markerId : markerIds) {
+            markers.remove(markerId);
+        }
+        return nativeMap.markerRemoveBulk(markerIds);
+    }
+
+    /**
+     * Creates a marker styling from a string of YAML that can be shared by many {@link Marker}s.
+     * The styling is parsed once for all of its markers.
+     * @param styleString YAML draw rule, like for {@link Marker#setStylingFromString(String)}
+     * @return the styling id, to use with {@link #setMarkersStyling(List, long)}
+     */
+    public long createMarkerStylingFromString(@NonNull final String styleString) {
+        return nativeMap.markerCreateStylingFromString(styleString);
+    }
+
+    /**
+     * Creates a marker styling from a draw rule path that can be shared by many {@link Marker}s.
+     * @param path draw rule path, like for {@link Marker#setStylingFromPath(String)}
+     * @return the styling id, to use with {@link #setMarkersStyling(List, long)}
+     */
+    public long createMarkerStylingFromPath(@NonNull final String path) {
+        return nativeMap.markerCreateStylingFromPath(path);
+    }
+
+    /**
+     * Removes a shared marker styling. Markers that use it keep their styling.
+     * @param stylingId the styling id
+     * @return whether or not the styling was removed
+     */
+    public boolean removeMarkerStyling(final long stylingId) {
+        checkId(stylingId);
+        return nativeMap.markerRemoveStyling(stylingId);
+    }
+
+    /**
+     * Sets a shared styling on the passed in {@link Marker}s with a single call into the native map.
+     * @param markersToStyle markers to style
+     * @param stylingId the styling id
+     * @return the number of markers updated
+     */
+    public int setMarkersStyling(@NonNull final List<Marker> markersToStyle, final long stylingId) {
+        checkId(stylingId);
+        return nativeMap.markerSetStylingBulk(markerIds(markersToStyle), stylingId);
+    }
+
+    /**
+     * Sets the passed in {@link Marker}s to points with a single call into the native map.
+     * @param markersToMove markers to set
+     * @param points coordinates of the points, one for each marker
+     * @return the number of markers updated
+     */
+    public int setMarkersPoints(@NonNull final List<Marker> markersToMove, @NonNull final List<LngLat> points) {
+        if (points.size() != markersToMove.size()) {
+            throw new IllegalArgumentException("Expected one point for each marker");
+        }
+        final double[] coordinates = new double[2 * points.size()];
+        for (int i = 0; i < points.size(); i++) {
+            coordinates[2 * i] = points.get(i).longitude;
+            coordinates[2 * i + 1] = points.get(i).latitude;
+        }
+        return nativeMap.markerSetPointBulk(markerIds(markersToMove), coordinates);
+    }
+
+    @NonNull
+    private long[] markerIds(@NonNull final List<Marker> markerList) {
+        final long[] markerIds = new long[markerList.size()];
+        for (int i = 0; i < markerIds.length; i++) {
+            markerIds[i] = markerList.get(i).getMarkerId();
+            checkId(markerIds[i]);
+        }
+        return markerIds;
+    }
+
     /**
      * Remove all the {@link Marker} objects from the map.
      */
@@ -1092,6 +1194,17 @@ public class MapController {
         nativeMap.useCachedGlState(use);
     }
 
+    /**
+     * Send HTTP requests with the native curl-based client of the library instead of the
+     * {@link HttpHandler}. Responses are then read into native memory without passing
+     * through the JVM. Call this before loading a scene.
+     * @param use Whether to use the native client; false by default
+     * @return false when the library was built without native HTTP support
+     */
+    public boolean useNativeHttpClient(final boolean use) {
+        return nativeMap.useNativeUrlClient(use);
+    }
+
     /**
      * Sets an opaque background color used as default color when a scene is being loaded
      * @param red red component of the background color
@@ -1213,6 +1326,27 @@ public class MapController {
                 }
             }
 
+            @Override
+            public ByteBuffer allocateBody(final int length) {
+                if (!httpRequestHandles.containsKey(requestHandle)) { return null; }
+                return nativeMap.allocateUrlBuffer(requestHandle, length);
+            }
+
+            @Override
+            public void onResponse(final int code, @NonNull final ByteBuffer body) {
+                if (httpRequestHandles.remove(requestHandle) == null) {
+                    // Canceled while the body was read
+                    nativeMap.releaseUrlBuffer(requestHandle);
+                    return;
+                }
+                if (code >= 200 && code < 300) {
+                    nativeMap.onUrlBufferComplete(requestHandle, body.position());
+                } else {
+                    nativeMap.onUrlComplete(requestHandle, null,
+                            "Unexpected response code: " + code + " for URL: " + url);
+                }
+            }
+
             @Override
             public void onCancel() {
                 if (httpRequestHandles.remove(requestHandle) == null) { return; }
@@ -5,6 +5,7 @@ import com.mapzen.tangram.geometry.Geometry;
 import java.util.List;
 
 import androidx.annotation.NonNull;
+import androidx.annotation.Nullable;
 
 /**
  * {@code MapData} is a named collection of drawable map features.
@@ -45,6 +46,32 @@ public class MapData {
         nativeMap.generateClientDataTiles(pointer);
     }
 
+    /**
+     * Assign a set of points to this data collection in one call. This replaces any previously
+     * assigned feature lists or GeoJSON data. Properties are given by column: each key is given
+     * once, followed by the values of that key for all points.
+     * @param coordinates The longitude and latitude of each point
+     * @param numberKeys Keys of the numeric properties, or null
+     * @param numberValues The values of numberKeys, by key: all values of the first key, then of
+     * the second key, and so on. There is one value for each point and key.
+     * @param stringKeys Keys of the string properties, or null
+     * @param stringValues The values of stringKeys, ordered like numberValues
+     */
+    public void setPoints(@NonNull final double[] coordinates,
+                          @Nullable final String[] numberKeys, @Nullable final double[] numberValues,
+                          @Nullable final String[] stringKeys, @Nullable final String[] stringValues) {
+        checkPointer(pointer);
+        final int count = coordinates.length / 2;
+        if ((numberKeys != null && (numberValues == null || numberValues.length != numberKeys.length * count)) ||
+                (stringKeys != null && (stringValues == null || stringValues.length != stringKeys.length * count))) {
+            throw new IllegalArgumentException("Each property key needs one value for each point");
+        }
+        final NativeMap nativeMap = mapController.nativeMap;
+        nativeMap.clearClientDataFeatures(pointer);
+        nativeMap.addClientDataPoints(pointer, coordinates, numberKeys, numberValues, stringKeys, stringValues);
+        nativeMap.generateClientDataTiles(pointer);
+    }
+
     /**
      * Assign features described in a GeoJSON string to this collection. This will replace any previously assigned feature lists or GeoJSON data.
      * @param data A string containing a <a href="http://geojson.org/">GeoJSON</a> FeatureCollection
@@ -5,6 +5,8 @@ import android.graphics.Bitmap;
 import android.graphics.PointF;
 import android.graphics.Rect;
 
+import java.nio.ByteBuffer;
+
 class NativeMap {
 
     NativeMap(MapController mapController, AssetManager assetManager) {
@@ -74,12 +76,20 @@ class NativeMap {
     native synchronized boolean markerSetVisible(long markerID, boolean visible);
     native synchronized boolean markerSetDrawOrder(long markerID, int drawOrder);
     native synchronized void markerRemoveAll();
+    native synchronized void markerAddBulk(long[] markerIDs);
+    native synchronized int markerRemoveBulk(long[] markerIDs);
+    native synchronized long markerCreateStylingFromString(String styling);
+    native synchronized long markerCreateStylingFromPath(String path);
+    native synchronized boolean markerRemoveStyling(long stylingID);
+    native synchronized int markerSetStylingBulk(long[] markerIDs, long stylingID);
+    native synchronized int markerSetPointBulk(long[] markerIDs, double[] coordinates);
     native synchronized void useCachedGlState(boolean use);
     native synchronized void setDefaultBackgroundColor(float r, float g, float b);
 
     native synchronized long addClientDataSource(String name, boolean generateCentroid);
     native synchronized void removeClientDataSource(long sourcePtr);
     native synchronized void addClientDataFeature(long sourcePtr, double[] coordinates, int[] rings, String[] properties);
+    native synchronized void addClientDataPoints(long sourcePtr, double[] coordinates, String[] numberKeys, double[] numberValues, String[] stringKeys, String[] stringValues);
     native synchronized void addClientDataGeoJson(long sourcePtr, String geoJson);
     native synchronized void generateClientDataTiles(long sourcePtr);
     native synchronized void clearClientDataFeatures(long sourcePtr);
@@ -89,6 +99,10 @@ class NativeMap {
     native synchronized void setDebugFlag(int flag, boolean on);
 
     native void onUrlComplete(long requestHandle, byte[] rawDataBytes, String errorMessage);
+    native ByteBuffer allocateUrlBuffer(long requestHandle, int size);
+    native void onUrlBufferComplete(long requestHandle, int length);
+    native void releaseUrlBuffer(long requestHandle);
+    native boolean useNativeUrlClient(boolean use);
 
     private final long nativePointer;
 }
@@ -7,6 +7,7 @@ import java.net.InetAddress;
 import java.net.Socket;
 import java.net.SocketException;
 import java.net.UnknownHostException;
+import java.nio.ByteBuffer;
 import java.util.concurrent.TimeUnit;
 
 import javax.net.SocketFactory;
@@ -21,6 +22,7 @@ import okhttp3.OkHttpClient;
 import okhttp3.Request;
 import okhttp3.Response;
 import okhttp3.ResponseBody;
+import okio.BufferedSource;
 
 /**
  * {@code DefaultHttpHandler} is an implementation of {@link HttpHandler} using OkHTTP.
@@ -87,6 +89,16 @@ public class DefaultHttpHandler implements HttpHandler {
                 final ResponseBody body = response.body();
                 if (body != null) {
                     try {
+                        // Read the body into native memory when its length is known
+                        final long length = body.contentLength();
+                        final ByteBuffer buffer = (response.isSuccessful() && length >= 0 && length <= Integer.MAX_VALUE)
+                                ? cb.allocateBody((int)length) : null;
+                        if (buffer != null) {
+                            final BufferedSource source = body.source();
+                            while (buffer.hasRemaining() && source.read(buffer) != -1) {}
+                            cb.onResponse(response.code(), buffer);
+                            return;
+                        }
                         data = body.bytes();
                         cb.onResponse(response.code(), data);
                     } catch (final IOException e) {
@@ -4,6 +4,7 @@ import com.mapzen.tangram.MapController;
 import com.mapzen.tangram.MapView;
 
 import java.io.IOException;
+import java.nio.ByteBuffer;
 
 import androidx.annotation.NonNull;
 import androidx.annotation.Nullable;
@@ -47,6 +48,24 @@ public interface HttpHandler {
          */
         void onResponse(final int code, @Nullable final byte[] body);
 
+        /**
+         * Get a direct buffer in native memory for the body of a successful response,
+         * so that it is passed to the map without copies
+         * @param length Length of the body in bytes
+         * @return Buffer with a capacity of {@code length} bytes, or null when the body
+         * has to be passed to {@link #onResponse(int, byte[])}
+         */
+        @Nullable
+        ByteBuffer allocateBody(final int length);
+
+        /**
+         * Called when the body of a successful response was read into the buffer of
+         * {@link #allocateBody(int)}
+         * @param code Status code returned from the network response
+         * @param body Buffer holding the body up to its position
+         */
+        void onResponse(final int code, @NonNull final ByteBuffer body);
+
         /**
          * Called when the request could not be executed due to cancellation
          */
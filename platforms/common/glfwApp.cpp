@@ -13,6 +13,9 @@
 #define GL_SILENCE_DEPRECATION
 #include <GLFW/glfw3.h>
 #include <cstdlib>
+#include <cstdio>
+#include <algorithm>
+#include <array>
 #include <atomic>
 #include "gl.h"
 
@@ -37,6 +40,8 @@ void showDebugFlagsGUI();
 void showViewportGUI();
 void showSceneGUI();
 void showMarkerGUI();
+void showProfilerGUI();
+void updateProfiler(double delta);
 
 constexpr double double_tap_time = 0.5; // seconds
 constexpr double scroll_span_multiplier = 0.05; // scaling for zoom and rotation
@@ -99,6 +104,44 @@ Tangram::MarkerID pickResultMarker = 0;
 std::vector<SceneUpdate> sceneUpdates;
 const char* apiKeyScenePath = "global.sdk_api_key";
 
+// Samples shown by the plots of the profiler
+constexpr int profiler_samples = 120;
+// Seconds between samples of the pipeline metrics, cache stats and memory usage
+constexpr double profiler_interval = 0.5;
+
+struct ProfilerHistory {
+    std::array<float, profiler_samples> values{};
+    // Index of the oldest sample
+    int offset = 0;
+
+    void add(float value) {
+        values[offset] = value;
+        offset = (offset + 1) % profiler_samples;
+    }
+    float last() const { return values[(offset + profiler_samples - 1) % profiler_samples]; }
+    float max() const { return *std::max_element(values.begin(), values.end()); }
+};
+
+bool profiler_enabled = false;
+double profiler_last_sample = 0.0;
+ProfilerHistory frame_times;
+std::array<ProfilerHistory, PipelineMetrics::stage_count> stage_times;
+ProfilerHistory tile_task_queue;
+ProfilerHistory url_request_queue;
+ProfilerHistory job_queue;
+ProfilerHistory tile_cache_hit_rate;
+TileCacheStats last_tile_cache_stats;
+MemoryUsage memory_usage;
+
+const char* stage_names[PipelineMetrics::stage_count] = {
+    "Fetch", "Cache Lookup", "Parse", "Styling", "Geometry Build", "Label Collision", "Mesh Upload", "Render"
+};
+
+const char* memory_category_names[MemoryUsage::category_count] = {
+    "Tile Meshes", "Raster Textures", "Tile Cache", "Data Cache", "Client Data",
+    "Glyph Atlases", "Font Cache", "Scene Textures", "JavaScript"
+};
+
 void loadSceneFile(bool setPosition, std::vector<SceneUpdate> updates) {
 
     for (auto& update : updates) {
@@ -263,11 +306,14 @@ void run() {
             showViewportGUI();
             showMarkerGUI();
             showDebugFlagsGUI();
+            showProfilerGUI();
         }
         double currentTime = glfwGetTime();
         double delta = currentTime - lastTime;
         lastTime = currentTime;
 
+        updateProfiler(delta);
+
         // Render
         MapState state = map->update(delta);
         if (state.isAnimating()) {
@@ -775,6 +821,92 @@ void showDebugFlagsGUI() {
     }
 }
 
+void updateProfiler(double delta) {
+    if (!profiler_enabled) { return; }
+
+    frame_times.add(delta * 1000.0);
+
+    QueueDepths queues = map->getQueueDepths();
+    tile_task_queue.add(queues.tileTasks);
+    url_request_queue.add(queues.urlRequests);
+    job_queue.add(queues.jobs);
+
+    double now = glfwGetTime();
+    if (now - profiler_last_sample < profiler_interval) { return; }
+    profiler_last_sample = now;
+
+    // Mean time of each stage since the last sample
+    PipelineMetrics metrics = Map::getPipelineMetrics(true);
+    for (size_t i = 0; i < PipelineMetrics::stage_count; i++) {
+        const auto& stage = metrics.stages[i];
+        stage_times[i].add(stage.count > 0 ? stage.totalMs / stage.count : 0.0);
+    }
+
+    // The stats start over with the tile cache of a new scene
+    TileCacheStats cache = map->getTileCacheStats();
+    size_t hits = cache.hits, misses = cache.misses;
+    if (hits >= last_tile_cache_stats.hits && misses >= last_tile_cache_stats.misses) {
+        hits -= last_tile_cache_stats.hits;
+        misses -= last_tile_cache_stats.misses;
+    }
+    tile_cache_hit_rate.add(hits + misses > 0 ? 100.f * hits / (hits + misses) : 0.f);
+    last_tile_cache_stats = cache;
+
+    memory_usage = map->getMemoryUsage();
+}
+
+void plotHistory(const char* label, const ProfilerHistory& history, const char* format) {
+    char overlay[32];
+    std::snprintf(overlay, sizeof(overlay), format, history.last());
+    ImGui::PlotLines(label, history.values.data(), profiler_samples, history.offset, overlay,
+                     0.f, std::max(history.max(), 1.f), ImVec2(0, 40));
+}
+
+void showProfilerGUI() {
+    if (ImGui::CollapsingHeader("Profiler")) {
+        if (ImGui::Checkbox("Collect Metrics", &profiler_enabled)) {
+            Map::setMetricsEnabled(profiler_enabled);
+            Map::getPipelineMetrics(true);
+        }
+        if (!profiler_enabled) { return; }
+
+        plotHistory("Frame Time", frame_times, "%.1f ms");
+
+        if (ImGui::TreeNode("Tile Pipeline")) {
+            for (size_t i = 0; i < PipelineMetrics::stage_count; i++) {
+                plotHistory(stage_names[i], stage_times[i], "%.2f ms");
+            }
+            ImGui::TreePop();
+        }
+        if (ImGui::TreeNode("Queues")) {
+            plotHistory("Tile Tasks", tile_task_queue, "%.0f");
+            plotHistory("URL Requests", url_request_queue, "%.0f");
+            plotHistory("GL Jobs", job_queue, "%.0f");
+            ImGui::TreePop();
+        }
+        if (ImGui::TreeNode("Tile Cache")) {
+            plotHistory("Hit Rate", tile_cache_hit_rate, "%.0f%%");
+            ImGui::Text("%zu tiles, %.1f of %.1f MB", last_tile_cache_stats.tiles,
+                        last_tile_cache_stats.memoryUsage / 1e6, last_tile_cache_stats.memoryLimit / 1e6);
+            ImGui::TreePop();
+        }
+        if (ImGui::TreeNode("Memory")) {
+            ImGui::Columns(3);
+            ImGui::Text("Category"); ImGui::NextColumn();
+            ImGui::Text("CPU MB"); ImGui::NextColumn();
+            ImGui::Text("GPU MB"); ImGui::NextColumn();
+            for (size_t i = 0; i < MemoryUsage::category_count; i++) {
+                ImGui::Text("%s", memory_category_names[i]); ImGui::NextColumn();
+                ImGui::Text("%.2f", memory_usage.cpuBytes[i] / 1e6); ImGui::NextColumn();
+                ImGui::Text("%.2f", memory_usage.gpuBytes[i] / 1e6); ImGui::NextColumn();
+            }
+            ImGui::Columns(1);
+            ImGui::Text("Total %.2f MB", memory_usage.total() / 1e6);
+            ImGui::TreePop();
+        }
+    }
+}
+
 } // namespace GlfwApp
 
 } // namespace Tangram
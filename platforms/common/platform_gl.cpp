@@ -24,6 +24,9 @@ void GL::lineWidth(GLfloat width) {
 void GL::viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
     GL_CHECK(glViewport(x, y, width, height));
 }
+void GL::scissor(GLint x, GLint y, GLsizei width, GLsizei height) {
+    GL_CHECK(glScissor(x, y, width, height));
+}
 
 void GL::enable(GLenum id) {
     GL_CHECK(glEnable(id));
@@ -148,6 +151,39 @@ void GL::bufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usa
 void GL::bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void *data) {
     GL_CHECK(glBufferSubData(target, offset, size, data));
 }
+
+// Uniform buffers
+void GL::bindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+    GL_CHECK(glBindBufferBase(target, index, buffer));
+}
+GLuint GL::getUniformBlockIndex(GLuint program, const GLchar *uniformBlockName) {
+    auto result = glGetUniformBlockIndex(program, uniformBlockName);
+    GL_CHECK({});
+    return result;
+}
+void GL::uniformBlockBinding(GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding) {
+    GL_CHECK(glUniformBlockBinding(program, uniformBlockIndex, uniformBlockBinding));
+}
+void GL::getActiveUniformBlockiv(GLuint program, GLuint uniformBlockIndex, GLenum pname, GLint *params) {
+    GL_CHECK(glGetActiveUniformBlockiv(program, uniformBlockIndex, pname, params));
+}
+void GL::getUniformIndices(GLuint program, GLsizei uniformCount, const GLchar *const*uniformNames,
+                           GLuint *uniformIndices) {
+    GL_CHECK(glGetUniformIndices(program, uniformCount, uniformNames, uniformIndices));
+}
+void GL::getActiveUniformsiv(GLuint program, GLsizei uniformCount, const GLuint *uniformIndices,
+                             GLenum pname, GLint *params) {
+    GL_CHECK(glGetActiveUniformsiv(program, uniformCount, uniformIndices, pname, params));
+}
+
+// Program binaries
+void GL::getProgramBinary(GLuint program, GLsizei bufSize, GLsizei *length,
+                          GLenum *binaryFormat, void *binary) {
+    GL_CHECK(glGetProgramBinary(program, bufSize, length, binaryFormat, binary));
+}
+void GL::programBinary(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length) {
+    GL_CHECK(glProgramBinary(program, binaryFormat, binary, length));
+}
 void GL::readPixels(GLint x, GLint y, GLsizei width, GLsizei height,
                     GLenum format, GLenum type, GLvoid* pixels) {
     GL_CHECK(glReadPixels(x, y, width, height, format, type, pixels));
@@ -173,6 +209,10 @@ void GL::texImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei wi
                     GLint border, GLenum format, GLenum type, const GLvoid *pixels) {
     GL_CHECK(glTexImage2D(target, level, internalFormat, width, height, border, format, type, pixels)); }
 
+void GL::compressedTexImage2D(GLenum target, GLint level, GLenum internalFormat, GLsizei width, GLsizei height,
+                              GLint border, GLsizei imageSize, const GLvoid *data) {
+    GL_CHECK(glCompressedTexImage2D(target, level, internalFormat, width, height, border, imageSize, data)); }
+
 void GL::texSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height,
                        GLenum format, GLenum type, const GLvoid *pixels) {
     GL_CHECK(glTexSubImage2D(target, level, xoffset, yoffset, width, height, format, type, pixels)); }
@@ -198,6 +238,19 @@ void GL::drawArrays(GLenum mode, GLint first, GLsizei count ) {
 void GL::drawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices ) {
     GL_CHECK(glDrawElements(mode, count, type, indices ));
 }
+void GL::drawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type,
+                                const GLvoid *indices, GLint basevertex) {
+    GL_CHECK(glDrawElementsBaseVertex(mode, count, type, indices, basevertex));
+}
+
+// Instancing
+void GL::vertexAttribDivisor(GLuint index, GLuint divisor) {
+    GL_CHECK(glVertexAttribDivisor(index, divisor));
+}
+void GL::drawElementsInstanced(GLenum mode, GLsizei count, GLenum type,
+                               const GLvoid *indices, GLsizei instancecount) {
+    GL_CHECK(glDrawElementsInstanced(mode, count, type, indices, instancecount));
+}
 
 void GL::uniform1f(GLint location, GLfloat v0) {
     GL_CHECK(glUniform1f(location, v0));
@@ -271,6 +324,11 @@ GLboolean GL::unmapBuffer(GLenum target) {
     GL_CHECK({});
     return result;
 }
+void* GL::mapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+    auto result = glMapBufferRange(target, offset, length, access);
+    GL_CHECK({});
+    return result;
+}
 
 void GL::finish(void) {
     GL_CHECK(glFinish());
@@ -287,6 +345,34 @@ void GL::genVertexArrays(GLsizei n, GLuint *arrays) {
     GL_CHECK(glGenVertexArrays(n, arrays));
 }
 
+// Compute shaders
+void GL::dispatchCompute(GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z) {
+    GL_CHECK(glDispatchCompute(num_groups_x, num_groups_y, num_groups_z));
+}
+void GL::memoryBarrier(GLbitfield barriers) {
+    GL_CHECK(glMemoryBarrier(barriers));
+}
+
+// Timer queries
+void GL::genQueries(GLsizei n, GLuint *ids) {
+    GL_CHECK(glGenQueries(n, ids));
+}
+void GL::deleteQueries(GLsizei n, const GLuint *ids) {
+    GL_CHECK(glDeleteQueries(n, ids));
+}
+void GL::beginQuery(GLenum target, GLuint id) {
+    GL_CHECK(glBeginQuery(target, id));
+}
+void GL::endQuery(GLenum target) {
+    GL_CHECK(glEndQuery(target));
+}
+void GL::getQueryObjectuiv(GLuint id, GLenum pname, GLuint *params) {
+    GL_CHECK(glGetQueryObjectuiv(id, pname, params));
+}
+void GL::getQueryObjectui64v(GLuint id, GLenum pname, uint64_t *params) {
+    GL_CHECK(glGetQueryObjectui64v(id, pname, params));
+}
+
 // Framebuffer
 void GL::bindFramebuffer(GLenum target, GLuint framebuffer) {
     GL_CHECK(glBindFramebuffer(target, framebuffer));
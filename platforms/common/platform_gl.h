@@ -13,10 +13,80 @@
 extern PFNGLBINDVERTEXARRAYOESPROC glBindVertexArrayOESEXT;
 extern PFNGLDELETEVERTEXARRAYSOESPROC glDeleteVertexArraysOESEXT;
 extern PFNGLGENVERTEXARRAYSOESPROC glGenVertexArraysOESEXT;
+extern PFNGLVERTEXATTRIBDIVISOREXTPROC glVertexAttribDivisorEXTPTR;
+extern PFNGLDRAWELEMENTSINSTANCEDEXTPROC glDrawElementsInstancedEXTPTR;
+
+// Uniform buffer functions of GLES 3, loaded when the context provides them
+typedef void (GL_APIENTRYP PFNGLBINDBUFFERBASEPROC) (GLenum target, GLuint index, GLuint buffer);
+typedef GLuint (GL_APIENTRYP PFNGLGETUNIFORMBLOCKINDEXPROC) (GLuint program, const GLchar *uniformBlockName);
+typedef void (GL_APIENTRYP PFNGLUNIFORMBLOCKBINDINGPROC) (GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding);
+typedef void (GL_APIENTRYP PFNGLGETACTIVEUNIFORMBLOCKIVPROC) (GLuint program, GLuint uniformBlockIndex, GLenum pname, GLint *params);
+typedef void (GL_APIENTRYP PFNGLGETUNIFORMINDICESPROC) (GLuint program, GLsizei uniformCount, const GLchar *const*uniformNames, GLuint *uniformIndices);
+typedef void (GL_APIENTRYP PFNGLGETACTIVEUNIFORMSIVPROC) (GLuint program, GLsizei uniformCount, const GLuint *uniformIndices, GLenum pname, GLint *params);
+extern PFNGLBINDBUFFERBASEPROC glBindBufferBasePTR;
+extern PFNGLGETUNIFORMBLOCKINDEXPROC glGetUniformBlockIndexPTR;
+extern PFNGLUNIFORMBLOCKBINDINGPROC glUniformBlockBindingPTR;
+extern PFNGLGETACTIVEUNIFORMBLOCKIVPROC glGetActiveUniformBlockivPTR;
+extern PFNGLGETUNIFORMINDICESPROC glGetUniformIndicesPTR;
+extern PFNGLGETACTIVEUNIFORMSIVPROC glGetActiveUniformsivPTR;
+
+// Program binary functions of GLES 3
+typedef void (GL_APIENTRYP PFNGLGETPROGRAMBINARYPROC) (GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary);
+typedef void (GL_APIENTRYP PFNGLPROGRAMBINARYPROC) (GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
+extern PFNGLGETPROGRAMBINARYPROC glGetProgramBinaryPTR;
+extern PFNGLPROGRAMBINARYPROC glProgramBinaryPTR;
+
+// Buffer mapping of GLES 3, to read back pixel buffer objects
+typedef void* (GL_APIENTRYP PFNGLMAPBUFFERRANGEPROC) (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+extern PFNGLMAPBUFFERRANGEPROC glMapBufferRangePTR;
+
+// Compute shaders of GLES 3.1, for the label collision prepass
+typedef void (GL_APIENTRYP PFNGLDISPATCHCOMPUTEPROC) (GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z);
+typedef void (GL_APIENTRYP PFNGLMEMORYBARRIERPROC) (GLbitfield barriers);
+extern PFNGLDISPATCHCOMPUTEPROC glDispatchComputePTR;
+extern PFNGLMEMORYBARRIERPROC glMemoryBarrierPTR;
+
+// Base vertex draws of GLES 3.2 or GL_OES/EXT_draw_elements_base_vertex, for shared VAOs
+typedef void (GL_APIENTRYP PFNGLDRAWELEMENTSBASEVERTEXPROC) (GLenum mode, GLsizei count, GLenum type, const void *indices, GLint basevertex);
+extern PFNGLDRAWELEMENTSBASEVERTEXPROC glDrawElementsBaseVertexPTR;
+
+// Timer queries of GL_EXT_disjoint_timer_query, for the GPU time of styles
+typedef void (GL_APIENTRYP PFNGLGENQUERIESPROC) (GLsizei n, GLuint *ids);
+typedef void (GL_APIENTRYP PFNGLDELETEQUERIESPROC) (GLsizei n, const GLuint *ids);
+typedef void (GL_APIENTRYP PFNGLBEGINQUERYPROC) (GLenum target, GLuint id);
+typedef void (GL_APIENTRYP PFNGLENDQUERYPROC) (GLenum target);
+typedef void (GL_APIENTRYP PFNGLGETQUERYOBJECTUIVPROC) (GLuint id, GLenum pname, GLuint *params);
+typedef void (GL_APIENTRYP PFNGLGETQUERYOBJECTUI64VPROC) (GLuint id, GLenum pname, uint64_t *params);
+extern PFNGLGENQUERIESPROC glGenQueriesPTR;
+extern PFNGLDELETEQUERIESPROC glDeleteQueriesPTR;
+extern PFNGLBEGINQUERYPROC glBeginQueryPTR;
+extern PFNGLENDQUERYPROC glEndQueryPTR;
+extern PFNGLGETQUERYOBJECTUIVPROC glGetQueryObjectuivPTR;
+extern PFNGLGETQUERYOBJECTUI64VPROC glGetQueryObjectui64vPTR;
 
 #define glDeleteVertexArrays glDeleteVertexArraysOESEXT
 #define glGenVertexArrays glGenVertexArraysOESEXT
 #define glBindVertexArray glBindVertexArrayOESEXT
+#define glVertexAttribDivisor glVertexAttribDivisorEXTPTR
+#define glDrawElementsInstanced glDrawElementsInstancedEXTPTR
+#define glBindBufferBase glBindBufferBasePTR
+#define glGetUniformBlockIndex glGetUniformBlockIndexPTR
+#define glUniformBlockBinding glUniformBlockBindingPTR
+#define glGetActiveUniformBlockiv glGetActiveUniformBlockivPTR
+#define glGetUniformIndices glGetUniformIndicesPTR
+#define glGetActiveUniformsiv glGetActiveUniformsivPTR
+#define glGetProgramBinary glGetProgramBinaryPTR
+#define glProgramBinary glProgramBinaryPTR
+#define glMapBufferRange glMapBufferRangePTR
+#define glDispatchCompute glDispatchComputePTR
+#define glMemoryBarrier glMemoryBarrierPTR
+#define glDrawElementsBaseVertex glDrawElementsBaseVertexPTR
+#define glGenQueries glGenQueriesPTR
+#define glDeleteQueries glDeleteQueriesPTR
+#define glBeginQuery glBeginQueryPTR
+#define glEndQuery glEndQueryPTR
+#define glGetQueryObjectuiv glGetQueryObjectuivPTR
+#define glGetQueryObjectui64v glGetQueryObjectui64vPTR
 #endif // TANGRAM_ANDROID
 
 #ifdef TANGRAM_IOS
@@ -26,6 +96,8 @@ extern PFNGLGENVERTEXARRAYSOESPROC glGenVertexArraysOESEXT;
 #define glDeleteVertexArrays glDeleteVertexArraysOES
 #define glGenVertexArrays glGenVertexArraysOES
 #define glBindVertexArray glBindVertexArrayOES
+#define glVertexAttribDivisor glVertexAttribDivisorEXT
+#define glDrawElementsInstanced glDrawElementsInstancedEXT
 #endif // TANGRAM_IOS
 
 #ifdef TANGRAM_OSX
@@ -38,6 +110,8 @@ extern PFNGLGENVERTEXARRAYSOESPROC glGenVertexArraysOESEXT;
 #define glDeleteVertexArrays glDeleteVertexArraysAPPLE
 #define glGenVertexArrays glGenVertexArraysAPPLE
 #define glBindVertexArray glBindVertexArrayAPPLE
+#define glVertexAttribDivisor glVertexAttribDivisorARB
+#define glDrawElementsInstanced glDrawElementsInstancedARB
 #endif // TANGRAM_OSX
 
 #ifdef TANGRAM_LINUX
@@ -68,8 +142,76 @@ static void glBindVertexArray(GLuint array) {}
 static void glDeleteVertexArrays(GLsizei n, const GLuint *arrays) {}
 static void glGenVertexArrays(GLsizei n, GLuint *arrays) {}
 
+// Dummy instancing functions
+static void glVertexAttribDivisor(GLuint index, GLuint divisor) {}
+static void glDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type,
+                                    const GLvoid *indices, GLsizei instancecount) {}
+
 #endif // TANGRAM_RPI
 
+#if defined(TANGRAM_IOS) || defined(TANGRAM_OSX) || defined(TANGRAM_RPI)
+// Dummy uniform buffer functions, these platforms create GLES 2 or legacy desktop GL
+// contexts, see Hardware::supportsUniformBuffers
+static void tangramBindBufferBase(GLenum target, GLuint index, GLuint buffer) {}
+static GLuint tangramGetUniformBlockIndex(GLuint program, const GLchar *uniformBlockName) { return 0xFFFFFFFFu; }
+static void tangramUniformBlockBinding(GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding) {}
+static void tangramGetActiveUniformBlockiv(GLuint program, GLuint uniformBlockIndex, GLenum pname, GLint *params) {}
+static void tangramGetUniformIndices(GLuint program, GLsizei uniformCount, const GLchar *const*uniformNames,
+                                     GLuint *uniformIndices) {}
+static void tangramGetActiveUniformsiv(GLuint program, GLsizei uniformCount, const GLuint *uniformIndices,
+                                       GLenum pname, GLint *params) {}
+
+#define glBindBufferBase tangramBindBufferBase
+#define glGetUniformBlockIndex tangramGetUniformBlockIndex
+#define glUniformBlockBinding tangramUniformBlockBinding
+#define glGetActiveUniformBlockiv tangramGetActiveUniformBlockiv
+#define glGetUniformIndices tangramGetUniformIndices
+#define glGetActiveUniformsiv tangramGetActiveUniformsiv
+
+// Dummy program binary functions, see Hardware::supportsProgramBinary
+static void tangramGetProgramBinary(GLuint program, GLsizei bufSize, GLsizei *length,
+                                    GLenum *binaryFormat, void *binary) {}
+static void tangramProgramBinary(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length) {}
+
+#define glGetProgramBinary tangramGetProgramBinary
+#define glProgramBinary tangramProgramBinary
+
+// Dummy buffer mapping, see Hardware::supportsPixelBufferObjects
+static void* tangramMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+    return nullptr;
+}
+
+#define glMapBufferRange tangramMapBufferRange
+
+// Dummy compute functions, see Hardware::supportsComputeShaders
+static void tangramDispatchCompute(GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z) {}
+static void tangramMemoryBarrier(GLbitfield barriers) {}
+
+#define glDispatchCompute tangramDispatchCompute
+#define glMemoryBarrier tangramMemoryBarrier
+
+// Dummy base vertex draws, see Hardware::supportsBaseVertex
+static void tangramDrawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type,
+                                          const GLvoid *indices, GLint basevertex) {}
+
+#define glDrawElementsBaseVertex tangramDrawElementsBaseVertex
+
+// Dummy timer queries, see Hardware::supportsTimerQuery
+static void tangramGenQueries(GLsizei n, GLuint *ids) {}
+static void tangramDeleteQueries(GLsizei n, const GLuint *ids) {}
+static void tangramBeginQuery(GLenum target, GLuint id) {}
+static void tangramEndQuery(GLenum target) {}
+static void tangramGetQueryObjectuiv(GLuint id, GLenum pname, GLuint *params) {}
+static void tangramGetQueryObjectui64v(GLuint id, GLenum pname, uint64_t *params) {}
+
+#define glGenQueries tangramGenQueries
+#define glDeleteQueries tangramDeleteQueries
+#define glBeginQuery tangramBeginQuery
+#define glEndQuery tangramEndQuery
+#define glGetQueryObjectuiv tangramGetQueryObjectuiv
+#define glGetQueryObjectui64v tangramGetQueryObjectui64v
+#endif // defined(TANGRAM_IOS) || defined(TANGRAM_OSX) || defined(TANGRAM_RPI)
+
 #if defined(TANGRAM_ANDROID) || defined(TANGRAM_IOS) || defined(TANGRAM_RPI)
     #define glMapBuffer glMapBufferOES
     #define glUnmapBuffer glUnmapBufferOES
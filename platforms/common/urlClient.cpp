@@ -1,7 +1,11 @@
 #include "urlClient.h"
 #include "log.h"
+#include "util/responseBufferPool.h"
+#include "util/url.h"
 #include <algorithm>
 #include <cassert>
+#include <cctype>
+#include <cstdlib>
 #include <cstring>
 #include <curl/curl.h>
 #ifndef _MSC_VER
@@ -14,12 +18,35 @@ constexpr char const* requestCancelledError = "Request cancelled";
 namespace Tangram {
 
 struct CurlGlobals {
+    // Shares DNS lookups, TLS sessions and open connections between the
+    // multi handles of all UrlClients in the process.
+    CURLSH* share = nullptr;
+    std::mutex shareLocks[CURL_LOCK_DATA_LAST];
+
+    static void lockShare(CURL*, curl_lock_data data, curl_lock_access, void* user) {
+        static_cast<CurlGlobals*>(user)->shareLocks[data].lock();
+    }
+    static void unlockShare(CURL*, curl_lock_data data, void* user) {
+        static_cast<CurlGlobals*>(user)->shareLocks[data].unlock();
+    }
+
     CurlGlobals() {
         LOGD("curl global init");
         curl_global_init(CURL_GLOBAL_ALL);
+
+        share = curl_share_init();
+        curl_share_setopt(share, CURLSHOPT_LOCKFUNC, &lockShare);
+        curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, &unlockShare);
+        curl_share_setopt(share, CURLSHOPT_USERDATA, this);
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+#if LIBCURL_VERSION_NUM >= 0x073900 // 7.57.0
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+#endif
     }
     ~CurlGlobals() {
         LOGD("curl global shutdown");
+        curl_share_cleanup(share);
         curl_global_cleanup();
     }
 } s_curl;
@@ -111,14 +138,18 @@ UrlClient::SelfPipe::Socket UrlClient::SelfPipe::getReadFd() {
 }
 
 struct UrlClient::Task {
-    // Reduce Task content capacity when it's more than 128kb and last
-    // content size was less then half limit_capacity.
-    static constexpr size_t limit_capacity = 128 * 1024;
+    // Largest Content-Length that is reserved up front
+    static constexpr size_t max_reserve = 16 * 1024 * 1024;
 
     Request request;
     std::vector<char> content;
     CURL *handle = nullptr;
     char curlErrorString[CURL_ERROR_SIZE] = {0};
+    // Conditional request headers
+    curl_slist* headers = nullptr;
+    // Validators and max-age of the response
+    UrlValidators validators;
+    int64_t maxAge = -1;
     bool active = false;
     bool canceled = false;
 
@@ -129,17 +160,65 @@ struct UrlClient::Task {
 
         auto& buffer = task->content;
         auto addedSize = size * n;
-        auto oldSize = buffer.size();
-        buffer.resize(oldSize + addedSize);
-        std::memcpy(buffer.data() + oldSize, ptr, addedSize);
+        buffer.insert(buffer.end(), ptr, ptr + addedSize);
         return addedSize;
     }
 
+    static size_t curlHeaderCallback(char* ptr, size_t size, size_t n, void* user) {
+        // Called for each header line, including the line ending.
+        auto* task = reinterpret_cast<Task*>(user);
+        size_t length = size * n;
+
+        std::string line(ptr, length);
+        while (!line.empty() && (line.back() == '\r' || line.back() == '\n')) { line.pop_back(); }
+
+        auto colon = line.find(':');
+        if (colon == std::string::npos) {
+            // Status line of a redirect or a new response: drop earlier headers
+            if (line.compare(0, 5, "HTTP/") == 0) {
+                task->validators = UrlValidators();
+                task->maxAge = -1;
+                task->content.clear();
+            }
+            return length;
+        }
+
+        std::string name = line.substr(0, colon);
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        auto start = line.find_first_not_of(' ', colon + 1);
+        std::string value = (start == std::string::npos) ? "" : line.substr(start);
+
+        if (name == "content-length") {
+            // The size of the encoded content, which is a lower bound when
+            // curl decodes gzip content
+            size_t contentLength = std::strtoull(value.c_str(), nullptr, 10);
+            task->content.reserve(std::min(contentLength, max_reserve));
+        } else if (name == "etag") {
+            task->validators.etag = value;
+        } else if (name == "last-modified") {
+            task->validators.lastModified = value;
+        } else if (name == "cache-control") {
+            std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+            if (value.find("no-cache") != std::string::npos ||
+                value.find("no-store") != std::string::npos) {
+                task->maxAge = 0;
+            } else {
+                auto pos = value.find("max-age=");
+                if (pos != std::string::npos) {
+                    task->maxAge = std::strtoll(value.c_str() + pos + 8, nullptr, 10);
+                }
+            }
+        }
+        return length;
+    }
+
     Task(const Options& _options) {
         // Set up an easy handle for reuse.
         handle = curl_easy_init();
         curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, &curlWriteCallback);
         curl_easy_setopt(handle, CURLOPT_WRITEDATA, this);
+        curl_easy_setopt(handle, CURLOPT_HEADERFUNCTION, &curlHeaderCallback);
+        curl_easy_setopt(handle, CURLOPT_HEADERDATA, this);
         curl_easy_setopt(handle, CURLOPT_NOPROGRESS, 1L);
         curl_easy_setopt(handle, CURLOPT_HEADER, 0L);
         curl_easy_setopt(handle, CURLOPT_VERBOSE, 0L);
@@ -152,29 +231,52 @@ struct UrlClient::Task {
         curl_easy_setopt(handle, CURLOPT_MAXREDIRS, 20);
         curl_easy_setopt(handle, CURLOPT_TCP_NODELAY, 1);
         curl_easy_setopt(handle, CURLOPT_USERAGENT, _options.userAgentString);
+        curl_easy_setopt(handle, CURLOPT_SHARE, s_curl.share);
+        // Detect dead idle connections that are kept for reuse
+        curl_easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, 1L);
+        if (_options.proxyAddress && *_options.proxyAddress) {
+            curl_easy_setopt(handle, CURLOPT_PROXY, _options.proxyAddress);
+        }
+#if LIBCURL_VERSION_NUM >= 0x072f00 // 7.47.0
+        if (_options.http2) {
+            curl_easy_setopt(handle, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+            // Wait for a connection that can be multiplexed rather than opening another one
+            curl_easy_setopt(handle, CURLOPT_PIPEWAIT, 1L);
+        }
+#endif
     }
 
     void setup() {
         canceled = false;
         active = true;
-    }
+        validators = UrlValidators();
+        maxAge = -1;
 
-    void clear() {
-        bool shrink = content.capacity() > limit_capacity &&
-            !content.empty() && content.size() < limit_capacity / 2;
+        // The content of the last response was handed to its callback
+        if (content.capacity() == 0) {
+            content = ResponseBufferPool::shared().acquire();
+        }
 
-        if (shrink) {
-            LOGD("Release content buffer %u / %u", content.size(), content.capacity());
-            content.resize(limit_capacity / 2);
-            content.shrink_to_fit();
+        // Ask the host to reply 304 when our copy is still valid
+        curl_slist_free_all(headers);
+        headers = nullptr;
+        if (!request.validators.etag.empty()) {
+            headers = curl_slist_append(headers, ("If-None-Match: " + request.validators.etag).c_str());
         }
-        content.clear();
+        if (!request.validators.lastModified.empty()) {
+            headers = curl_slist_append(headers, ("If-Modified-Since: " + request.validators.lastModified).c_str());
+        }
+        curl_easy_setopt(handle, CURLOPT_HTTPHEADER, headers);
+    }
 
+    void clear() {
+        content.clear();
         active = false;
     }
 
     ~Task() {
         curl_easy_cleanup(handle);
+        curl_slist_free_all(headers);
     }
 
     Task(const Task&) = delete;
@@ -182,6 +284,7 @@ struct UrlClient::Task {
 
 };
 
+constexpr size_t UrlClient::Task::max_reserve;
 
 UrlClient::UrlClient(Options options) : m_options(options) {
     // Using a pipe to notify select() in curl-thread of new requests..
@@ -192,6 +295,12 @@ UrlClient::UrlClient(Options options) : m_options(options) {
 
     // Start the curl thread
     m_curlHandle = curl_multi_init();
+    curl_multi_setopt(m_curlHandle, CURLMOPT_MAX_HOST_CONNECTIONS, long(m_options.maxHostConnections));
+#if LIBCURL_VERSION_NUM >= 0x072b00 // 7.43.0
+    if (m_options.http2) {
+        curl_multi_setopt(m_curlHandle, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    }
+#endif
     m_curlRunning = true;
     m_curlWorker = std::make_unique<std::thread>(&UrlClient::curlLoop, this);
 
@@ -251,23 +360,43 @@ void UrlClient::curlWakeUp() {
     }
 }
 
-UrlClient::RequestId UrlClient::addRequest(const std::string& _url, UrlCallback _onComplete) {
+UrlClient::RequestId UrlClient::addRequest(const std::string& _url, UrlCallback _onComplete,
+                                           const UrlValidators& _validators, float _priority) {
 
     auto id = ++m_requestCount;
-    Request request = {_url, _onComplete, id};
+    Request request = {_url, _onComplete, id, Url(_url).netLocation(), _validators, _priority};
 
     // Add the request to our list.
     {
         // Lock the mutex to prevent concurrent modification of the
         // list by the curl thread.
         std::lock_guard<std::mutex> lock(m_requestMutex);
-        m_requests.push_back(request);
+        enqueueRequest(std::move(request));
     }
     curlWakeUp();
 
     return id;
 }
 
+void UrlClient::enqueueRequest(Request&& _request) {
+    auto it = std::upper_bound(m_requests.begin(), m_requests.end(), _request.priority,
+                               [](float priority, const Request& r) { return priority > r.priority; });
+    m_requests.insert(it, std::move(_request));
+}
+
+void UrlClient::setRequestPriority(UrlClient::RequestId _id, float _priority) {
+    std::lock_guard<std::mutex> lock(m_requestMutex);
+
+    auto it = std::find_if(m_requests.begin(), m_requests.end(),
+                           [&](auto& r) { return r.id == _id; });
+    if (it == m_requests.end() || it->priority == _priority) { return; }
+
+    Request request = std::move(*it);
+    m_requests.erase(it);
+    request.priority = _priority;
+    enqueueRequest(std::move(request));
+}
+
 void UrlClient::cancelRequest(UrlClient::RequestId _id) {
     UrlCallback callback;
     // First check the pending request list.
@@ -298,18 +427,68 @@ void UrlClient::cancelRequest(UrlClient::RequestId _id) {
         auto it = std::find_if(m_tasks.begin(), m_tasks.end(),
                                [&](auto& t) { return t.request.id == _id; });
 
-        if (it != std::end(m_tasks)) {
-            it->canceled = true;
+        if (it == std::end(m_tasks) || !it->active) { return; }
+
+        it->canceled = true;
+        m_tasksCanceled = true;
+    }
+    curlWakeUp();
+}
+
+void UrlClient::abortCanceledTasks() {
+    std::vector<UrlCallback> callbacks;
+    {
+        std::lock_guard<std::mutex> lock(m_requestMutex);
+        if (!m_tasksCanceled) { return; }
+        m_tasksCanceled = false;
+
+        for (auto it = m_tasks.begin(); it != m_tasks.end(); ) {
+            auto& task = *it;
+            if (!task.active || !task.canceled) {
+                ++it;
+                continue;
+            }
+            LOGD("Aborted request for url: %s", task.request.url.c_str());
+            curl_multi_remove_handle(m_curlHandle, task.handle);
+
+            auto hostTasks = m_hostTasks.find(task.request.host);
+            if (hostTasks != m_hostTasks.end() && --hostTasks->second == 0) {
+                m_hostTasks.erase(hostTasks);
+            }
+            callbacks.push_back(std::move(task.request.callback));
+            task.clear();
+            m_activeTasks--;
+
+            // Move task to front - for quick reuse
+            auto next = std::next(it);
+            m_tasks.splice(m_tasks.begin(), m_tasks, it);
+            it = next;
         }
     }
+
+    for (auto& callback : callbacks) {
+        if (!callback) { continue; }
+        m_dispatcher.enqueue([callback = std::move(callback)]() mutable {
+                                 UrlResponse response;
+                                 response.error = requestCancelledError;
+                                 callback(std::move(response));
+                             });
+    }
 }
 
 void UrlClient::startPendingRequests() {
     std::unique_lock<std::mutex> lock(m_requestMutex);
 
-    while (m_activeTasks < m_options.maxActiveTasks) {
+    auto it = m_requests.begin();
+    while (m_activeTasks < m_options.maxActiveTasks && it != m_requests.end()) {
 
-        if (m_requests.empty()) { break; }
+        // Leave requests to busy hosts queued
+        uint32_t& hostTasks = m_hostTasks[it->host];
+        if (m_options.maxActiveTasksPerHost > 0 && hostTasks >= m_options.maxActiveTasksPerHost) {
+            ++it;
+            continue;
+        }
+        hostTasks++;
 
         if (m_tasks.front().active) {
             m_tasks.emplace_front(m_options);
@@ -322,10 +501,10 @@ void UrlClient::startPendingRequests() {
         // Swap front with back
         m_tasks.splice(m_tasks.end(), m_tasks, m_tasks.begin());
 
-        task.setup();
+        task.request = std::move(*it);
+        it = m_requests.erase(it);
 
-        task.request = std::move(m_requests.front());
-        m_requests.erase(m_requests.begin());
+        task.setup();
 
         // Configure the easy handle.
         const char* url = task.request.url.c_str();
@@ -343,74 +522,37 @@ void UrlClient::curlLoop() {
     // Loop until the session is destroyed.
     while (m_curlRunning) {
 
-        fd_set fdread, fdwrite, fdexcep;
-        FD_ZERO(&fdread);
-        FD_ZERO(&fdwrite);
-        FD_ZERO(&fdexcep);
-
-        // 100ms select() default timeout
-        struct timeval timeout{0, 100 * 1000};
-
-        int maxfd = -1;
-        long curl_timeo = -1;
-        curl_multi_timeout(m_curlHandle, &curl_timeo);
-
-        if (curl_timeo >= 0) {
-            timeout.tv_usec = 0;
-            timeout.tv_sec = curl_timeo / 1000;
-            if (timeout.tv_sec > 1) {
-                timeout.tv_sec = 1;
-            } else {
-                timeout.tv_usec = (curl_timeo % 1000) * 1000;
-            }
-            if (timeout.tv_sec > 0) {
-                timeout.tv_sec = 0;
-            } else {
-                timeout.tv_usec = (curl_timeo % 1000) * 1000;
-            }
-            //printf ("Timeout %ld.%06ld\n", timeout.tv_sec, timeout.tv_usec);
-        }
-
-        // Get file descriptors from the transfers
-        CURLMcode mc = curl_multi_fdset(m_curlHandle, &fdread, &fdwrite, &fdexcep,
-                                        &maxfd);
+        // Listen on requestNotify to break the wait when new requests are added.
+        struct curl_waitfd notify;
+        notify.fd = m_requestNotify.getReadFd();
+        notify.events = CURL_WAIT_POLLIN;
+        notify.revents = 0;
+
+        // Wait for transfers with poll(), so that the number of open sockets
+        // is not limited by FD_SETSIZE. Waits at most 100ms or until the next
+        // curl timeout.
+        int numfds = 0;
+        CURLMcode mc = curl_multi_wait(m_curlHandle, &notify, 1, 100, &numfds);
         if (mc != CURLM_OK) {
-            LOGE("curl_multi_fdset() failed, code %d.", mc);
+            LOGE("curl_multi_wait() failed, code %d.", mc);
             continue;
         }
 
-        // Listen on requestNotify to break select when new requests are added.
-        FD_SET(m_requestNotify.getReadFd(), &fdread);
-
-        // Wait for transfers
-        // On success the value of maxfd is guaranteed to be >= -1. We call
-        // select(maxfd + 1, ...); specially in case of (maxfd == -1) there are
-        // no fds ready yet so we call select(0, ...) to sleep 100ms, which is
-        // the minimum suggested value in the curl_multi_fdset() doc.
-        int ready = select(maxfd + 2, &fdread, &fdwrite, &fdexcep, &timeout);
-
-        if (ready == -1) {
-            LOGE("select() error!");
-            continue;
-
-        } else {
-            if (FD_ISSET(m_requestNotify.getReadFd(), &fdread)) {
-                // Clear notify fd
-                int error;
-                if(!m_requestNotify.read(&error)) {
-                    LOGE("Read request notify %d", error);
-                }
-                //LOG("Got request notifies %d %d", n, m_curlNotified);
-                m_curlNotified = false;
+        if (notify.revents & CURL_WAIT_POLLIN) {
+            // Clear notify fd
+            int error;
+            if(!m_requestNotify.read(&error)) {
+                LOGE("Read request notify %d", error);
             }
+            m_curlNotified = false;
+        }
 
-            // Create tasks from request queue
-            startPendingRequests();
+        // Free the tasks of canceled requests, then create tasks from request queue
+        abortCanceledTasks();
+        startPendingRequests();
 
-            //
-            int activeRequests = 0;
-            curl_multi_perform(m_curlHandle, &activeRequests);
-        }
+        int activeRequests = 0;
+        curl_multi_perform(m_curlHandle, &activeRequests);
 
         while (true) {
             // how many messages are left
@@ -444,18 +586,33 @@ void UrlClient::curlLoop() {
                     continue;
                 }
                 auto& task = *it;
+                // Already aborted by abortCanceledTasks()
+                if (!task.active) { continue; }
                 // Move task to front - for quick reuse
                 m_tasks.splice(m_tasks.begin(), m_tasks, it);
 
+                auto hostTasks = m_hostTasks.find(task.request.host);
+                if (hostTasks != m_hostTasks.end() && --hostTasks->second == 0) {
+                    m_hostTasks.erase(hostTasks);
+                }
+
                 // Get Response content and Request callback
                 callback = std::move(task.request.callback);
-                response.content = task.content;
 
                 const char* url = task.request.url.c_str();
                 if (resultCode == CURLE_OK) {
                     LOGD("Succeeded for url: %s", url);
                     response.error = nullptr;
 
+                    long statusCode = 0;
+                    curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &statusCode);
+                    response.statusCode = int(statusCode);
+                    response.validators = std::move(task.validators);
+                    response.maxAge = task.maxAge;
+                    // Hand over the buffer, the next request takes one from the pool
+                    response.content = std::move(task.content);
+                    task.content = std::vector<char>();
+
                 } else if (task.canceled) {
                     LOGD("Aborted request for url: %s", url);
                     response.error = requestCancelledError;
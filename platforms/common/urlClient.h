@@ -11,6 +11,7 @@
 #include <deque>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 #if defined(_WIN32)
@@ -28,6 +29,17 @@ public:
         uint32_t connectionTimeoutMs = 3000;
         uint32_t requestTimeoutMs = 30000;
         const char* userAgentString = "tangram";
+        // Maximum number of active requests to one host, 0 for no limit.
+        // Requests to other hosts can start while a host is at its limit.
+        uint32_t maxActiveTasksPerHost = 0;
+        // Maximum number of connections to one host. Further requests wait
+        // for a free connection, or share one when multiplexing with HTTP/2.
+        uint32_t maxHostConnections = 6;
+        // Negotiate HTTP/2 for https urls and run requests to the same host
+        // as parallel streams on one connection.
+        bool http2 = true;
+        // Proxy for all requests, none when empty
+        const char* proxyAddress = "";
     };
 
     UrlClient(Options options);
@@ -35,16 +47,28 @@ public:
 
     using RequestId = uint64_t;
 
-    RequestId addRequest(const std::string& url, UrlCallback cb);
+    // With non-empty validators the request is conditional, see UrlValidators.
+    // Pending requests start in order of priority, from 0 to 1 for the most
+    // urgent, and in the order they were added for equal priorities.
+    RequestId addRequest(const std::string& url, UrlCallback cb,
+                         const UrlValidators& validators = UrlValidators(),
+                         float priority = 0.5f);
 
     void cancelRequest(RequestId request);
 
+    // Move a pending request in the queue. Started requests keep running.
+    void setRequestPriority(RequestId request, float priority);
+
 private:
 
     struct Request {
         std::string url;
         UrlCallback callback;
         RequestId id;
+        // Key for maxActiveTasksPerHost
+        std::string host;
+        UrlValidators validators;
+        float priority;
     };
 
     class SelfPipe {
@@ -72,6 +96,13 @@ private:
 
     void startPendingRequests();
 
+    // Remove the handles of canceled active tasks from the multi handle, which
+    // aborts their transfers without waiting for their next data
+    void abortCanceledTasks();
+
+    // Insert _request in m_requests after those of the same or higher priority
+    void enqueueRequest(Request&& _request);
+
     Options m_options;
 
     // Curl multi handle
@@ -79,6 +110,8 @@ private:
 
     bool m_curlRunning = false;
     bool m_curlNotified = false;
+    // An active task was canceled, guarded by m_requestMutex
+    bool m_tasksCanceled = false;
 
     std::unique_ptr<std::thread> m_curlWorker;
     AsyncWorker m_dispatcher;
@@ -86,6 +119,10 @@ private:
     std::list<Task> m_tasks;
     uint32_t m_activeTasks = 0;
 
+    // Number of active tasks by Request::host
+    std::unordered_map<std::string, uint32_t> m_hostTasks;
+
+    // Pending requests by descending priority
     std::deque<Request> m_requests;
 
     // Synchronize m_tasks and m_requests
@@ -94,7 +131,7 @@ private:
     // RequestIds
     std::atomic<uint64_t> m_requestCount{0};
 
-    // File descriptors to break waiting select.
+    // File descriptors to break waiting curl_multi_wait.
     SelfPipe m_requestNotify;
 };
 
@@ -70,6 +70,22 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (void)setFeatures:(NSArray<TGMapFeature *> *)features;
 
+/**
+ Sets the contents of this map data to a set of points in one call.
+
+ This replaces any previously assigned contents. Properties are given by column: each key maps to the values of that
+ key for all points, in the order of the coordinates.
+
+ @param coordinates The coordinates of the points.
+ @param count The number of points.
+ @param numberProperties Numeric property values by key. Each value holds `count` doubles.
+ @param stringProperties String property values by key. Each array holds `count` strings.
+ */
+- (void)setPoints:(const CLLocationCoordinate2D *)coordinates
+            count:(NSUInteger)count
+ numberProperties:(nullable NSDictionary<NSString *, NSData *> *)numberProperties
+ stringProperties:(nullable NSDictionary<NSString *, NSArray<NSString *> *> *)stringProperties;
+
 /**
  Sets the contents of this map data to the features defined in a
  <a href="http://geojson.org/geojson-spec.html">GeoJSON</a> string.
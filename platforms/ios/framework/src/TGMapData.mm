@@ -17,6 +17,7 @@
 
 #include "tangram.h"
 #include <memory>
+#include <vector>
 
 static inline void TGFeaturePropertiesConvertToCoreProperties(TGFeatureProperties* properties, Tangram::Properties& tgProperties)
 {
@@ -93,6 +94,49 @@ static inline void TGFeaturePropertiesConvertToCoreProperties(TGFeaturePropertie
     dataSource->generateTiles();
 }
 
+- (void)setPoints:(const CLLocationCoordinate2D *)coordinates
+            count:(NSUInteger)count
+ numberProperties:(NSDictionary<NSString *, NSData *> *)numberProperties
+ stringProperties:(NSDictionary<NSString *, NSArray<NSString *> *> *)stringProperties
+{
+    if (!self.map) {
+        return;
+    }
+
+    std::vector<double> lngLats(2 * count);
+    for (NSUInteger i = 0; i < count; i++) {
+        lngLats[2 * i] = coordinates[i].longitude;
+        lngLats[2 * i + 1] = coordinates[i].latitude;
+    }
+
+    std::vector<Tangram::ClientDataSource::NumberColumn> numbers;
+    for (NSString *key in numberProperties) {
+        NSData *values = numberProperties[key];
+        if (values.length < count * sizeof(double)) { continue; }
+        numbers.push_back({ std::string([key UTF8String]), static_cast<const double *>(values.bytes) });
+    }
+
+    // Columns are not reallocated, so that the StringColumns can point into them
+    std::vector<std::vector<std::string>> stringValues;
+    stringValues.reserve(stringProperties.count);
+    std::vector<Tangram::ClientDataSource::StringColumn> strings;
+    for (NSString *key in stringProperties) {
+        NSArray<NSString *> *values = stringProperties[key];
+        if (values.count < count) { continue; }
+        stringValues.emplace_back();
+        auto& column = stringValues.back();
+        column.reserve(count);
+        for (NSUInteger i = 0; i < count; i++) {
+            column.emplace_back([values[i] UTF8String]);
+        }
+        strings.push_back({ std::string([key UTF8String]), column.data() });
+    }
+
+    dataSource->clearFeatures();
+    dataSource->addPointFeatures(count, lngLats.data(), numbers, strings);
+    dataSource->generateTiles();
+}
+
 - (void)setGeoJson:(NSString *)data
 {
     if (!self.map) {
@@ -40,6 +40,18 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (void)cancelDownloadRequestAsync:(NSUInteger)taskIdentifier;
 
+@optional
+
+/**
+ Change the priority of a previous download request.
+
+ Requests for tiles near the center of the view get a higher priority, which changes as the view moves.
+
+ @param priority The priority from 0 to 1, like `NSURLSessionTask.priority`.
+ @param taskIdentifier The task identifier for the request.
+ */
+- (void)setPriority:(float)priority forDownloadRequestAsync:(NSUInteger)taskIdentifier;
+
 @end // protocol TGURLHandler
 
 /**
@@ -12,6 +12,8 @@
 @interface TGDefaultURLHandler()
 
 @property (strong, nonatomic) NSURLSession* session;
+// Running tasks by identifier, guarded by @synchronized(self.tasks)
+@property (strong, nonatomic) NSMutableDictionary<NSNumber*, NSURLSessionTask*>* tasks;
 
 @end
 
@@ -43,6 +45,7 @@
 
 - (void)setupWithConfiguration:(NSURLSessionConfiguration *)configuration {
     self.session = [NSURLSession sessionWithConfiguration:configuration];
+    self.tasks = [NSMutableDictionary dictionary];
 }
 
 #pragma mark - Class Methods
@@ -63,8 +66,21 @@
 
 - (NSUInteger)downloadRequestAsync:(NSURL *)url completionHandler:(TGDownloadCompletionHandler)completionHandler
 {
+    NSMutableDictionary* tasks = self.tasks;
+    __block NSNumber* key = nil;
+
     NSURLSessionDataTask* dataTask = [self.session dataTaskWithURL:url
-                                                 completionHandler:completionHandler];
+                                                 completionHandler:^(NSData* data, NSURLResponse* response, NSError* error) {
+        @synchronized(tasks) {
+            if (key) { [tasks removeObjectForKey:key]; }
+        }
+        completionHandler(data, response, error);
+    }];
+
+    @synchronized(tasks) {
+        key = @([dataTask taskIdentifier]);
+        tasks[key] = dataTask;
+    }
 
     [dataTask resume];
 
@@ -73,14 +89,21 @@
 
 - (void)cancelDownloadRequestAsync:(NSUInteger)taskIdentifier
 {
-    [self.session getTasksWithCompletionHandler:^(NSArray* dataTasks, NSArray* uploadTasks, NSArray* downloadTasks) {
-        for (NSURLSessionTask* task in dataTasks) {
-            if ([task taskIdentifier] == taskIdentifier) {
-                [task cancel];
-                break;
-            }
-        }
-    }];
+    NSURLSessionTask* task;
+    @synchronized(self.tasks) {
+        task = self.tasks[@(taskIdentifier)];
+    }
+    [task cancel];
+}
+
+- (void)setPriority:(float)priority forDownloadRequestAsync:(NSUInteger)taskIdentifier
+{
+    NSURLSessionTask* task;
+    @synchronized(self.tasks) {
+        task = self.tasks[@(taskIdentifier)];
+    }
+    // Also weights the stream of the request on HTTP/2 connections
+    task.priority = priority;
 }
 
 @end
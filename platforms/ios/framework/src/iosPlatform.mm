@@ -4,6 +4,7 @@
 #import <UIKit/UIKit.h>
 
 #include "iosPlatform.h"
+#include "gl/hardware.h"
 #include "log.h"
 #include <cstdarg>
 #include <cstdio>
@@ -26,8 +27,15 @@ void setCurrentThreadPriority(int priority) {
     [[NSThread currentThread] setThreadPriority:p];
 }
 
+void setCurrentThreadPlacement(ThreadRole _role, ThreadPlacement _placement) {
+    // no-op, thread affinity is not exposed. Cores are chosen by the thread priority.
+}
+
 void initGLExtensions() {
-    // No-op
+    // Uniform buffer, program binary and compute functions are dummies, see platform_gl.h
+    Tangram::Hardware::supportsUniformBuffers = false;
+    Tangram::Hardware::supportsProgramBinary = false;
+    Tangram::Hardware::supportsComputeShaders = false;
 }
 
 iOSPlatform::iOSPlatform(__weak TGMapView* _mapView) :
@@ -219,4 +227,20 @@ void iOSPlatform::cancelUrlRequestImpl(const UrlRequestId _id) {
     [urlHandler cancelDownloadRequestAsync:_id];
 }
 
+void iOSPlatform::setUrlRequestPriorityImpl(const UrlRequestId _id, float _priority) {
+    __strong TGMapView* mapView = m_mapView;
+
+    if (!mapView) {
+        return;
+    }
+
+    id<TGURLHandler> urlHandler = mapView.urlHandler;
+
+    if (![urlHandler respondsToSelector:@selector(setPriority:forDownloadRequestAsync:)]) {
+        return;
+    }
+
+    [urlHandler setPriority:_priority forDownloadRequestAsync:_id];
+}
+
 } // namespace Tangram
@@ -82,3 +82,67 @@ target_compile_definitions(tangram
 
 
 add_resources(tangram "${PROJECT_SOURCE_DIR}/scenes" "res")
+
+# Writes precompiled scenes for SceneOptions::precompiledScene at build time
+add_executable(tangram-compile-scene
+  platforms/linux/src/linuxPlatform.cpp
+  platforms/linux/src/compileScene.cpp
+  platforms/common/urlClient.cpp
+  platforms/common/linuxSystemFontHelper.cpp
+)
+
+target_include_directories(tangram-compile-scene
+  PRIVATE
+  platforms/common
+  ${FONTCONFIG_INCLUDE_DIRS}
+)
+
+target_link_libraries(tangram-compile-scene
+  PRIVATE
+  tangram-core
+  glfw
+  ${GLFW_LIBRARIES}
+  ${FONTCONFIG_LDFLAGS}
+  ${CURL_LIBRARIES}
+  -pthread
+  -ldl
+)
+
+target_compile_options(tangram-compile-scene
+  PRIVATE
+  -std=c++1y
+  -Wall
+)
+
+# Renders a scene along a camera path in a hidden window and reports frame times
+add_executable(tangram-bench-render
+  platforms/linux/src/linuxPlatform.cpp
+  platforms/linux/src/benchRender.cpp
+  platforms/common/platform_gl.cpp
+  platforms/common/urlClient.cpp
+  platforms/common/linuxSystemFontHelper.cpp
+)
+
+target_include_directories(tangram-bench-render
+  PRIVATE
+  platforms/common
+  ${FONTCONFIG_INCLUDE_DIRS}
+)
+
+target_link_libraries(tangram-bench-render
+  PRIVATE
+  tangram-core
+  glfw
+  ${GLFW_LIBRARIES}
+  ${OPENGL_LIBRARIES}
+  ${FONTCONFIG_LDFLAGS}
+  ${CURL_LIBRARIES}
+  -pthread
+  -ldl
+)
+
+target_compile_options(tangram-bench-render
+  PRIVATE
+  -std=c++1y
+  -Wall
+)
@@ -0,0 +1,288 @@
+#include "linuxPlatform.h"
+#include "log.h"
+#include "map.h"
+
+#define GLFW_INCLUDE_GLEXT
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits.h>
+#include <sstream>
+#include <sys/resource.h>
+#include <unistd.h>
+
+using namespace Tangram;
+
+// Renders a scene in a hidden window along a scripted camera path and reports
+// frame times, the time to the first complete view, tile build throughput and
+// peak memory.
+//
+// Usage: tangram-bench-render <scene.yaml> [--path <file>] [--size <w>x<h>] [--egl]
+//                             [--max-frames <n>] [<path>=<value> ...]
+//
+// SceneUpdates point the sources of the scene to a local tile fixture set,
+// e.g. sources.mapzen.url=file:///data/tiles/{z}/{x}/{y}.mvt
+//
+// Each line of the camera path is one command; the camera advances by a fixed
+// 1/60s per frame, so that runs are comparable:
+//   jump <lon> <lat> <zoom>        set the position
+//   pan <frames> <dx> <dy>         drag by dx, dy pixels over the frames
+//   fling <frames> <vx> <vy>       fling with vx, vy pixels per second
+//   zoom <frames> <factor>         pinch by factor over the frames
+//   rotate <frames> <radians>      rotate over the frames
+//   tilt <frames> <radians>        change the tilt over the frames
+//   wait <frames>                  render without input
+//   settle                         render until the view is complete
+// Lines starting with '#' are ignored.
+
+static const char* default_camera_path = R"END(
+jump -74.0 40.72 15
+settle
+pan 60 -400 0
+fling 60 1200 300
+zoom 90 4
+tilt 45 0.8
+rotate 60 1.2
+pan 60 0 300
+zoom 90 0.125
+settle
+)END";
+
+static const float frame_dt = 1.f / 60.f;
+
+using Clock = std::chrono::steady_clock;
+
+static double millis(Clock::duration _duration) {
+    return std::chrono::duration<double, std::milli>(_duration).count();
+}
+
+struct Bench {
+    Map& map;
+    int width, height;
+    int maxFrames;
+
+    std::vector<double> frameTimes;
+    int settleFrames = 0;
+
+    MapState frame() {
+        auto start = Clock::now();
+        MapState state = map.update(frame_dt);
+        map.render();
+        glFinish();
+        frameTimes.push_back(millis(Clock::now() - start));
+        glfwPollEvents();
+        return state;
+    }
+
+    // Render until the view is complete, returns whether it completed
+    bool settle() {
+        for (int i = 0; i < maxFrames; i++) {
+            settleFrames++;
+            if (frame().viewComplete()) { return true; }
+            // Tiles are loaded and built by other threads
+            usleep(1000);
+        }
+        return false;
+    }
+
+    bool run(std::istream& _path) {
+        float cx = width / 2.f, cy = height / 2.f;
+        std::string line;
+        while (std::getline(_path, line)) {
+            std::istringstream in(line);
+            std::string command;
+            if (!(in >> command) || command[0] == '#') { continue; }
+
+            int frames = 0;
+            if (command == "jump") {
+                double lon, lat;
+                float zoom;
+                if (!(in >> lon >> lat >> zoom)) { return invalid(line); }
+                map.setPosition(lon, lat);
+                map.setZoom(zoom);
+                continue;
+            }
+            if (command == "settle") {
+                if (!settle()) { LOGW("View did not complete within %d frames", maxFrames); }
+                continue;
+            }
+            if (!(in >> frames) || frames <= 0) { return invalid(line); }
+
+            float a = 0, b = 0;
+            if (command == "pan") {
+                if (!(in >> a >> b)) { return invalid(line); }
+                for (int i = 0; i < frames; i++) {
+                    map.handlePanGesture(cx, cy, cx + a / frames, cy + b / frames);
+                    frame();
+                }
+            } else if (command == "fling") {
+                if (!(in >> a >> b)) { return invalid(line); }
+                map.handleFlingGesture(cx, cy, a, b);
+                for (int i = 0; i < frames; i++) { frame(); }
+            } else if (command == "zoom") {
+                if (!(in >> a) || a <= 0) { return invalid(line); }
+                float scale = std::pow(a, 1.f / frames);
+                for (int i = 0; i < frames; i++) {
+                    map.handlePinchGesture(cx, cy, scale, 0);
+                    frame();
+                }
+            } else if (command == "rotate") {
+                if (!(in >> a)) { return invalid(line); }
+                for (int i = 0; i < frames; i++) {
+                    map.handleRotateGesture(cx, cy, a / frames);
+                    frame();
+                }
+            } else if (command == "tilt") {
+                if (!(in >> a)) { return invalid(line); }
+                float tilt = map.getTilt();
+                for (int i = 0; i < frames; i++) {
+                    map.setTilt(tilt + a * (i + 1) / frames);
+                    frame();
+                }
+            } else if (command == "wait") {
+                for (int i = 0; i < frames; i++) { frame(); }
+            } else {
+                return invalid(line);
+            }
+        }
+        return true;
+    }
+
+    bool invalid(const std::string& _line) {
+        fprintf(stderr, "Invalid camera path command '%s'\n", _line.c_str());
+        return false;
+    }
+};
+
+static double percentile(std::vector<double> _values, double _p) {
+    if (_values.empty()) { return 0; }
+    std::sort(_values.begin(), _values.end());
+    size_t index = std::min(_values.size() - 1, size_t(_p * _values.size()));
+    return _values[index];
+}
+
+int main(int argc, char* argv[]) {
+
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <scene.yaml> [--path <file>] [--size <w>x<h>] [--egl] "
+                "[--max-frames <n>] [<path>=<value> ...]\n", argv[0]);
+        return 1;
+    }
+
+    Url baseUrl("file:///");
+    char pathBuffer[PATH_MAX] = {0};
+    if (getcwd(pathBuffer, PATH_MAX) != nullptr) {
+        baseUrl = baseUrl.resolve(Url(std::string(pathBuffer) + "/"));
+    }
+    Url sceneUrl = baseUrl.resolve(Url(argv[1]));
+
+    std::string cameraPath = default_camera_path;
+    int width = 1024, height = 768;
+    int maxFrames = 600;
+    bool useEgl = false;
+    std::vector<SceneUpdate> updates;
+
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--path") == 0 && i + 1 < argc) {
+            std::ifstream file(argv[++i]);
+            if (!file) {
+                fprintf(stderr, "Unable to read camera path '%s'\n", argv[i]);
+                return 1;
+            }
+            std::stringstream buffer;
+            buffer << file.rdbuf();
+            cameraPath = buffer.str();
+        } else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%dx%d", &width, &height) != 2) {
+                fprintf(stderr, "Invalid size '%s'\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--max-frames") == 0 && i + 1 < argc) {
+            maxFrames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--egl") == 0) {
+            useEgl = true;
+        } else if (const char* value = strchr(argv[i], '=')) {
+            updates.emplace_back(std::string(argv[i], value - argv[i]), std::string(value + 1));
+        } else {
+            fprintf(stderr, "Invalid argument '%s'\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if (!glfwInit()) {
+        fprintf(stderr, "Unable to initialize GLFW\n");
+        return 1;
+    }
+
+    // No window is shown; with --egl the context is created through EGL,
+    // which also works without a display server on drivers that support it.
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_STENCIL_BITS, 8);
+    if (useEgl) {
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+    }
+    GLFWwindow* window = glfwCreateWindow(width, height, "tangram-bench-render", nullptr, nullptr);
+    if (!window) {
+        fprintf(stderr, "Unable to create an OpenGL context\n");
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(0);
+
+    Map::setMetricsEnabled(true);
+    Map::getPipelineMetrics(true);
+
+    auto map = std::make_unique<Map>(std::make_unique<LinuxPlatform>());
+    map->setupGL();
+    map->resize(width, height);
+
+    Bench bench{*map, width, height, maxFrames};
+
+    auto loadStart = Clock::now();
+    map->loadScene(SceneOptions{sceneUrl, true, updates}, false);
+
+    bool completed = bench.settle();
+    double firstCompleteView = millis(Clock::now() - loadStart);
+    bench.frameTimes.clear();
+
+    auto pathStart = Clock::now();
+    std::istringstream path(cameraPath);
+    bool ok = bench.run(path);
+    double pathTime = millis(Clock::now() - pathStart);
+
+    auto metrics = Map::getPipelineMetrics();
+    size_t tilesBuilt = metrics.counters[PipelineMetrics::tiles_built];
+    const auto& geometry = metrics.stages[PipelineMetrics::geometry_build];
+    const auto& styling = metrics.stages[PipelineMetrics::styling];
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    const auto& frames = bench.frameTimes;
+    printf("scene                    %s\n", sceneUrl.string().c_str());
+    printf("first_complete_view_ms   %.1f%s\n", firstCompleteView, completed ? "" : " (incomplete)");
+    printf("frames                   %d\n", int(frames.size()));
+    printf("frames_settling          %d\n", bench.settleFrames);
+    printf("frame_ms_p50             %.2f\n", percentile(frames, 0.5));
+    printf("frame_ms_p90             %.2f\n", percentile(frames, 0.9));
+    printf("frame_ms_p99             %.2f\n", percentile(frames, 0.99));
+    printf("frame_ms_max             %.2f\n", percentile(frames, 1.0));
+    printf("tiles_built              %d\n", int(tilesBuilt));
+    printf("tiles_canceled           %d\n", int(metrics.counters[PipelineMetrics::tiles_canceled]));
+    printf("tiles_per_second         %.1f\n",
+           tilesBuilt / ((firstCompleteView + pathTime) / 1000.0));
+    printf("tile_build_ms_mean       %.2f\n",
+           geometry.count ? (geometry.totalMs + styling.totalMs) / geometry.count : 0.0);
+    printf("peak_memory_kb           %ld\n", usage.ru_maxrss);
+
+    map.reset();
+    glfwDestroyWindow(window);
+    glfwTerminate();
+
+    return ok ? 0 : 1;
+}
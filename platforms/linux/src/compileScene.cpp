@@ -0,0 +1,84 @@
+#include "linuxPlatform.h"
+#include "log.h"
+#include "scene/importer.h"
+#include "scene/sceneBinary.h"
+#include "scene/sceneLoader.h"
+#include "sceneOptions.h"
+
+#include <cstring>
+#include <fstream>
+#include <limits.h>
+#include <unistd.h>
+
+using namespace Tangram;
+
+// Writes a precompiled scene for SceneOptions::precompiledScene.
+//
+// Usage: tangram-compile-scene <scene.yaml> <output> [--url <url>] [<path>=<value> ...]
+//
+// --url is the scene URL used by the app, e.g. asset:///scene.yaml, it
+// defaults to the file URL of the input. The SceneUpdates must match the
+// ones the app loads the scene with.
+
+int main(int argc, char* argv[]) {
+
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <scene.yaml> <output> [--url <url>] [<path>=<value> ...]\n", argv[0]);
+        return 1;
+    }
+
+    // Resolve the input path against the current directory.
+    Url baseUrl("file:///");
+    char pathBuffer[PATH_MAX] = {0};
+    if (getcwd(pathBuffer, PATH_MAX) != nullptr) {
+        baseUrl = baseUrl.resolve(Url(std::string(pathBuffer) + "/"));
+    }
+    Url sceneUrl = baseUrl.resolve(Url(argv[1]));
+    std::string output = argv[2];
+
+    SceneOptions options(sceneUrl);
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--url") == 0 && i + 1 < argc) {
+            options.url = Url(argv[++i]);
+            continue;
+        }
+        const char* value = strchr(argv[i], '=');
+        if (!value) {
+            fprintf(stderr, "Invalid scene update '%s'\n", argv[i]);
+            return 1;
+        }
+        options.updates.emplace_back(std::string(argv[i], value - argv[i]), std::string(value + 1));
+    }
+
+    LinuxPlatform platform;
+
+    Importer importer;
+    auto config = importer.loadSceneData(platform, sceneUrl);
+    if (!config || !config.IsMap()) {
+        fprintf(stderr, "Unable to load scene '%s'\n", sceneUrl.string().c_str());
+        platform.shutdown();
+        return 1;
+    }
+
+    auto result = SceneLoader::applyUpdates(config, options.updates);
+    if (result.error != Error::none) {
+        fprintf(stderr, "Applying scene update '%s' failed\n", result.update.path.c_str());
+        platform.shutdown();
+        return 1;
+    }
+    Importer::resolveSceneUrls(config, sceneUrl);
+
+    auto data = SceneBinary::write(config, SceneBinary::sourceHash(options), sceneUrl);
+
+    std::ofstream file(output, std::ios::binary);
+    file.write(data.data(), data.size());
+    platform.shutdown();
+
+    if (!file) {
+        fprintf(stderr, "Unable to write '%s'\n", output.c_str());
+        return 1;
+    }
+    LOG("Precompiled scene for %s: %s (%d bytes)", options.url.string().c_str(),
+        output.c_str(), int(data.size()));
+    return 0;
+}
@@ -2,6 +2,7 @@
 #include "linuxSystemFontHelper.h"
 #include "gl/hardware.h"
 #include "log.h"
+#include "util/cpuTopology.h"
 #include <algorithm>
 #include <stdio.h>
 #include <stdarg.h>
@@ -78,11 +79,16 @@ FontSourceHandle LinuxPlatform::systemFont(const std::string& _name,
 }
 
 bool LinuxPlatform::startUrlRequestImpl(const Url& _url, const UrlRequestHandle _request, UrlRequestId& _id) {
+    return startConditionalUrlRequestImpl(_url, UrlValidators(), _request, _id);
+}
+
+bool LinuxPlatform::startConditionalUrlRequestImpl(const Url& _url, const UrlValidators& _validators,
+                                                   const UrlRequestHandle _request, UrlRequestId& _id) {
 
     _id = m_urlClient->addRequest(_url.string(),
                                   [this, _request](UrlResponse&& response) {
                                       onUrlResponse(_request, std::move(response));
-                                  });
+                                  }, _validators);
     return true;
 }
 
@@ -92,10 +98,20 @@ void LinuxPlatform::cancelUrlRequestImpl(const UrlRequestId _id) {
     }
 }
 
+void LinuxPlatform::setUrlRequestPriorityImpl(const UrlRequestId _id, float _priority) {
+    if (m_urlClient) {
+        m_urlClient->setRequestPriority(_id, _priority);
+    }
+}
+
 void setCurrentThreadPriority(int priority) {
     setpriority(PRIO_PROCESS, 0, priority);
 }
 
+void setCurrentThreadPlacement(ThreadRole _role, ThreadPlacement _placement) {
+    setCurrentThreadAffinity(CpuTopology::get().affinity(_role, _placement));
+}
+
 void initGLExtensions() {
     Tangram::Hardware::supportsMapBuffer = true;
 }
@@ -20,7 +20,10 @@ public:
                                 const std::string& _face) const override;
 
     bool startUrlRequestImpl(const Url& _url, const UrlRequestHandle _request, UrlRequestId& _id) override;
+    bool startConditionalUrlRequestImpl(const Url& _url, const UrlValidators& _validators,
+                                        const UrlRequestHandle _request, UrlRequestId& _id) override;
     void cancelUrlRequestImpl(const UrlRequestId _id) override;
+    void setUrlRequestPriorityImpl(const UrlRequestId _id, float _priority) override;
 
 protected:
     FcConfig* m_fcConfig = nullptr;
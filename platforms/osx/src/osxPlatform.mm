@@ -25,8 +25,16 @@ void setCurrentThreadPriority(int priority) {
     [[NSThread currentThread] setThreadPriority:p];
 }
 
+void setCurrentThreadPlacement(ThreadRole _role, ThreadPlacement _placement) {
+    // no-op, thread affinity is not exposed. Cores are chosen by the thread priority.
+}
+
 void initGLExtensions() {
     Tangram::Hardware::supportsMapBuffer = true;
+    // Uniform buffer, program binary and compute functions are dummies, see platform_gl.h
+    Tangram::Hardware::supportsUniformBuffers = false;
+    Tangram::Hardware::supportsProgramBinary = false;
+    Tangram::Hardware::supportsComputeShaders = false;
 }
 
 void OSXPlatform::requestRender() const {
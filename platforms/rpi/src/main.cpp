@@ -147,8 +147,13 @@ int main(int argc, char **argv) {
 
     Url sceneUrl = Url(options.sceneFilePath).resolved(baseUrl);
 
+    // The RAM of a Raspberry Pi is shared with the GPU
+    SceneOptions sceneOptions{sceneUrl, !options.hasLocationSet, updates};
+    sceneOptions.lowMemory = true;
+
     map = std::make_unique<Map>(std::make_unique<RpiPlatform>(urlClientOptions));
-    map->loadScene(sceneUrl.string(), !options.hasLocationSet, updates);
+    map->setMemoryBudget(64 * 1024 * 1024);
+    map->loadScene(std::move(sceneOptions), false);
     map->setupGL();
     map->resize(getWindowWidth(), getWindowHeight());
     map->setTilt(options.tilt);
@@ -64,11 +64,16 @@ FontSourceHandle RpiPlatform::systemFont(const std::string& _name, const std::st
 }
 
 bool RpiPlatform::startUrlRequestImpl(const Url& _url, const UrlRequestHandle _request, UrlRequestId& _id) {
+    return startConditionalUrlRequestImpl(_url, UrlValidators(), _request, _id);
+}
+
+bool RpiPlatform::startConditionalUrlRequestImpl(const Url& _url, const UrlValidators& _validators,
+                                                 const UrlRequestHandle _request, UrlRequestId& _id) {
 
     _id = m_urlClient.addRequest(_url.string(),
                                  [this, _request](UrlResponse&& response) {
                                      onUrlResponse(_request, std::move(response));
-                                 });
+                                 }, _validators);
     return true;
 }
 
@@ -76,14 +81,26 @@ void RpiPlatform::cancelUrlRequestImpl(const UrlRequestId _id) {
     m_urlClient.cancelRequest(_id);
 }
 
+void RpiPlatform::setUrlRequestPriorityImpl(const UrlRequestId _id, float _priority) {
+    m_urlClient.setRequestPriority(_id, _priority);
+}
+
 RpiPlatform::~RpiPlatform() {}
 
 void setCurrentThreadPriority(int priority) {
     // no-op
 }
 
+void setCurrentThreadPlacement(ThreadRole _role, ThreadPlacement _placement) {
+    // no-op, the cores are of the same capacity
+}
+
 void initGLExtensions() {
-    // no-op
+    // Instancing, uniform buffer, program binary and compute functions are dummies, see platform_gl.h
+    Tangram::Hardware::supportsInstancing = false;
+    Tangram::Hardware::supportsUniformBuffers = false;
+    Tangram::Hardware::supportsProgramBinary = false;
+    Tangram::Hardware::supportsComputeShaders = false;
 }
 
 } // namespace Tangram
@@ -47,11 +47,12 @@ set(LIB_NAME tangram) # in order to have libtangram.so
 add_library(${LIB_NAME} SHARED
   ${PROJECT_SOURCE_DIR}/platforms/tizen/src/platform_gl.cpp
   ${PROJECT_SOURCE_DIR}/platforms/tizen/src/platform_tizen.cpp
-  ${PROJECT_SOURCE_DIR}/platforms/tizen/src/urlWorker.cpp
+  ${PROJECT_SOURCE_DIR}/platforms/common/urlClient.cpp
   )
 
 target_include_directories(${LIB_NAME} PUBLIC
   ${PROJECT_SOURCE_DIR}/platforms/tizen/inc
+  ${PROJECT_SOURCE_DIR}/platforms/common
   )
 
 # link to the core library, forcing all symbols to be added
@@ -21,6 +21,9 @@ void GL::lineWidth(GLfloat width) {
 void GL::viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
     __evas_gl_glapi->glViewport(x, y, width, height);
 }
+void GL::scissor(GLint x, GLint y, GLsizei width, GLsizei height) {
+    __evas_gl_glapi->glScissor(x, y, width, height);
+}
 
 void GL::enable(GLenum id) {
     __evas_gl_glapi->glEnable(id);
@@ -137,6 +140,23 @@ void GL::bufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usa
 void GL::bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void *data) {
     __evas_gl_glapi->glBufferSubData(target, offset, size, data);
 }
+
+// Uniform buffers are not exposed by the GLES 2 Evas GL API, see initGLExtensions()
+void GL::bindBufferBase(GLenum target, GLuint index, GLuint buffer) {}
+GLuint GL::getUniformBlockIndex(GLuint program, const GLchar *uniformBlockName) {
+    return GL_INVALID_INDEX;
+}
+void GL::uniformBlockBinding(GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding) {}
+void GL::getActiveUniformBlockiv(GLuint program, GLuint uniformBlockIndex, GLenum pname, GLint *params) {}
+void GL::getUniformIndices(GLuint program, GLsizei uniformCount, const GLchar *const*uniformNames,
+                           GLuint *uniformIndices) {}
+void GL::getActiveUniformsiv(GLuint program, GLsizei uniformCount, const GLuint *uniformIndices,
+                             GLenum pname, GLint *params) {}
+
+// Program binaries are not exposed by the GLES 2 Evas GL API, see initGLExtensions()
+void GL::getProgramBinary(GLuint program, GLsizei bufSize, GLsizei *length,
+                          GLenum *binaryFormat, void *binary) {}
+void GL::programBinary(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length) {}
 void GL::readPixels(GLint x, GLint y, GLsizei width, GLsizei height,
                     GLenum format, GLenum type, GLvoid* pixels) {
     __evas_gl_glapi->glReadPixels(x, y, width, height, format, type, pixels);
@@ -162,6 +182,10 @@ void GL::texImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei wi
                     GLint border, GLenum format, GLenum type, const GLvoid *pixels) {
     __evas_gl_glapi->glTexImage2D(target, level, internalFormat, width, height, border, format, type, pixels); }
 
+void GL::compressedTexImage2D(GLenum target, GLint level, GLenum internalFormat, GLsizei width, GLsizei height,
+                              GLint border, GLsizei imageSize, const GLvoid *data) {
+    __evas_gl_glapi->glCompressedTexImage2D(target, level, internalFormat, width, height, border, imageSize, data); }
+
 void GL::texSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height,
                        GLenum format, GLenum type, const GLvoid *pixels) {
     __evas_gl_glapi->glTexSubImage2D(target, level, xoffset, yoffset, width, height, format, type, pixels); }
@@ -187,6 +211,14 @@ void GL::drawArrays(GLenum mode, GLint first, GLsizei count ) {
 void GL::drawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices ) {
     __evas_gl_glapi->glDrawElements(mode, count, type, indices );
 }
+// Not exposed by the GLES 2 Evas GL API, see Hardware::supportsBaseVertex
+void GL::drawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type,
+                                const GLvoid *indices, GLint basevertex) {}
+
+// Instancing is not exposed by the GLES 2 Evas GL API, see initGLExtensions()
+void GL::vertexAttribDivisor(GLuint index, GLuint divisor) {}
+void GL::drawElementsInstanced(GLenum mode, GLsizei count, GLenum type,
+                               const GLvoid *indices, GLsizei instancecount) {}
 
 void GL::uniform1f(GLint location, GLfloat v0) {
     __evas_gl_glapi->glUniform1f(location, v0);
@@ -256,6 +288,10 @@ void* GL::mapBuffer(GLenum target, GLenum access) {
 GLboolean GL::unmapBuffer(GLenum target) {
     return __evas_gl_glapi->glUnmapBufferOES(target);
 }
+// GLES 2 context, see Hardware::supportsPixelBufferObjects
+void* GL::mapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+    return nullptr;
+}
 
 void GL::finish(void) {
     __evas_gl_glapi->glFinish();
@@ -272,6 +308,18 @@ void GL::genVertexArrays(GLsizei n, GLuint *arrays) {
     __evas_gl_glapi->glGenVertexArraysOES(n, arrays);
 }
 
+// Compute shaders are not exposed by the GLES 2 Evas GL API, see Hardware::supportsComputeShaders
+void GL::dispatchCompute(GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z) {}
+void GL::memoryBarrier(GLbitfield barriers) {}
+
+// Timer queries are not exposed by the GLES 2 Evas GL API, see Hardware::supportsTimerQuery
+void GL::genQueries(GLsizei n, GLuint *ids) {}
+void GL::deleteQueries(GLsizei n, const GLuint *ids) {}
+void GL::beginQuery(GLenum target, GLuint id) {}
+void GL::endQuery(GLenum target) {}
+void GL::getQueryObjectuiv(GLuint id, GLenum pname, GLuint *params) {}
+void GL::getQueryObjectui64v(GLuint id, GLenum pname, uint64_t *params) {}
+
 // Framebuffer
 void GL::bindFramebuffer(GLenum target, GLuint framebuffer) {
     __evas_gl_glapi->glBindFramebuffer(target, framebuffer);
@@ -6,11 +6,14 @@
 #include <list>
 #include <memory>
 #include <algorithm>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 
 #include "platform_tizen.h"
 #include "platform_gl.h"
-#include "urlWorker.h"
+#include "urlClient.h"
+#include "gl/hardware.h"
 
 #include "log.h"
 
@@ -22,31 +25,85 @@
 #include <fontconfig.h>
 #include <dlog.h>
 
-#define NUM_WORKERS 4
-
 static bool s_isContinuousRendering = false;
 static std::function<void()> s_renderCallbackFunction = nullptr;
 
 static std::vector<std::string> s_fallbackFonts;
 static FcConfig* s_fcConfig = nullptr;
 
-static UrlWorker s_workers;
+// Requests by URL for cancelUrlRequest(), guarded by s_urlMutex
+static std::mutex s_urlMutex;
+static std::shared_ptr<Tangram::UrlClient> s_urlClient;
+static std::unordered_multimap<std::string, Tangram::UrlClient::RequestId> s_urlRequests;
+static std::string s_proxyAddress;
+
+static void removeUrlRequest(const std::string& _url, Tangram::UrlClient::RequestId _id) {
+    auto range = s_urlRequests.equal_range(_url);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == _id) {
+            s_urlRequests.erase(it);
+            return;
+        }
+    }
+}
 
 bool startUrlRequest(const std::string& _url, UrlCallback _callback) {
-    s_workers.enqueue(std::make_unique<UrlTask>(_url, _callback));
+    std::lock_guard<std::mutex> lock(s_urlMutex);
+    if (!s_urlClient) { return false; }
+
+    // The request is only completed on the dispatcher thread of the UrlClient,
+    // which waits for s_urlMutex, so the id is known to the callback
+    auto id = std::make_shared<Tangram::UrlClient::RequestId>(0);
+    *id = s_urlClient->addRequest(_url, [_url, id, _callback](Tangram::UrlResponse&& _response) {
+        {
+            std::lock_guard<std::mutex> lock(s_urlMutex);
+            removeUrlRequest(_url, *id);
+        }
+        _callback(std::move(_response));
+    });
+    s_urlRequests.emplace(_url, *id);
     return true;
 }
 
 void cancelUrlRequest(const std::string& _url) {
-    s_workers.cancel(_url);
+    std::shared_ptr<Tangram::UrlClient> urlClient;
+    std::vector<Tangram::UrlClient::RequestId> ids;
+    {
+        std::lock_guard<std::mutex> lock(s_urlMutex);
+        urlClient = s_urlClient;
+        auto range = s_urlRequests.equal_range(_url);
+        for (auto it = range.first; it != range.second; ++it) { ids.push_back(it->second); }
+    }
+    if (!urlClient) { return; }
+
+    // Pending requests complete within cancelRequest(), which locks s_urlMutex
+    for (auto id : ids) { urlClient->cancelRequest(id); }
 }
 
 void initUrlRequests(const char* proxyAddress) {
-    s_workers.start(4, proxyAddress);
+    std::lock_guard<std::mutex> lock(s_urlMutex);
+    if (s_urlClient) { return; }
+
+    s_proxyAddress = proxyAddress ? proxyAddress : "";
+
+    Tangram::UrlClient::Options options;
+    options.maxActiveTasks = 16;
+    options.maxActiveTasksPerHost = 8;
+    options.proxyAddress = s_proxyAddress.c_str();
+    s_urlClient = std::make_shared<Tangram::UrlClient>(options);
 }
 
 void stopUrlRequests() {
-    s_workers.stop();
+    std::shared_ptr<Tangram::UrlClient> urlClient;
+    {
+        std::lock_guard<std::mutex> lock(s_urlMutex);
+        urlClient = std::move(s_urlClient);
+    }
+    // Cancels the remaining requests, whose callbacks lock s_urlMutex
+    urlClient.reset();
+
+    std::lock_guard<std::mutex> lock(s_urlMutex);
+    s_urlRequests.clear();
 }
 
 static bool s_update = false;
@@ -272,4 +329,8 @@ void initGLExtensions() {
      // glBindVertexArrayOESEXT = (PFNGLBINDVERTEXARRAYPROC)glfwGetProcAddress("glBindVertexArray");
      // glDeleteVertexArraysOESEXT = (PFNGLDELETEVERTEXARRAYSPROC)glfwGetProcAddress("glDeleteVertexArrays");
      // glGenVertexArraysOESEXT = (PFNGLGENVERTEXARRAYSPROC)glfwGetProcAddress("glGenVertexArrays");
+    Tangram::Hardware::supportsInstancing = false;
+    Tangram::Hardware::supportsUniformBuffers = false;
+    Tangram::Hardware::supportsProgramBinary = false;
+    Tangram::Hardware::supportsComputeShaders = false;
 }
@@ -55,10 +55,15 @@ std::vector<FontSourceHandle> WindowsPlatform::systemFontFallbacksHandle() const
 }
 
 bool WindowsPlatform::startUrlRequestImpl(const Url& _url, const UrlRequestHandle _request, UrlRequestId& _id) {
+    return startConditionalUrlRequestImpl(_url, UrlValidators(), _request, _id);
+}
+
+bool WindowsPlatform::startConditionalUrlRequestImpl(const Url& _url, const UrlValidators& _validators,
+                                                     const UrlRequestHandle _request, UrlRequestId& _id) {
     auto onURLResponse = [this, _request](UrlResponse&& response) {
         onUrlResponse(_request, std::move(response));
     };
-    _id = m_urlClient->addRequest(_url.string(), onURLResponse);
+    _id = m_urlClient->addRequest(_url.string(), onURLResponse, _validators);
     return false;
 }
 
@@ -68,8 +73,16 @@ void WindowsPlatform::cancelUrlRequestImpl(const UrlRequestId _id) {
     }
 }
 
+void WindowsPlatform::setUrlRequestPriorityImpl(const UrlRequestId _id, float _priority) {
+    if (m_urlClient) {
+        m_urlClient->setRequestPriority(_id, _priority);
+    }
+}
+
 void setCurrentThreadPriority(int priority) {}
 
+void setCurrentThreadPlacement(ThreadRole _role, ThreadPlacement _placement) {}
+
 void initGLExtensions() {
     Tangram::Hardware::supportsMapBuffer = true;
 }
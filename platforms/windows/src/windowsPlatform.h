@@ -16,7 +16,10 @@ public:
     void requestRender() const override;
     std::vector<FontSourceHandle> systemFontFallbacksHandle() const override;
     bool startUrlRequestImpl(const Url& _url, const UrlRequestHandle _request, UrlRequestId& _id) override;
+    bool startConditionalUrlRequestImpl(const Url& _url, const UrlValidators& _validators,
+                                        const UrlRequestHandle _request, UrlRequestId& _id) override;
     void cancelUrlRequestImpl(const UrlRequestId _id) override;
+    void setUrlRequestPriorityImpl(const UrlRequestId _id, float _priority) override;
 
 protected:
     std::unique_ptr<UrlClient> m_urlClient;
@@ -16,6 +16,8 @@ void GL::lineWidth(GLfloat width) {
 }
 void GL::viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
 }
+void GL::scissor(GLint x, GLint y, GLsizei width, GLsizei height) {
+}
 
 void GL::enable(GLenum id) {
 }
@@ -99,6 +101,26 @@ void GL::bufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usa
 }
 void GL::bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void *data) {
 }
+void GL::bindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+}
+GLuint GL::getUniformBlockIndex(GLuint program, const GLchar *uniformBlockName) {
+    return GL_INVALID_INDEX;
+}
+void GL::uniformBlockBinding(GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding) {
+}
+void GL::getActiveUniformBlockiv(GLuint program, GLuint uniformBlockIndex, GLenum pname, GLint *params) {
+}
+void GL::getUniformIndices(GLuint program, GLsizei uniformCount, const GLchar *const*uniformNames,
+                           GLuint *uniformIndices) {
+}
+void GL::getActiveUniformsiv(GLuint program, GLsizei uniformCount, const GLuint *uniformIndices,
+                             GLenum pname, GLint *params) {
+}
+void GL::getProgramBinary(GLuint program, GLsizei bufSize, GLsizei *length,
+                          GLenum *binaryFormat, void *binary) {
+}
+void GL::programBinary(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length) {
+}
 void GL::readPixels(GLint x, GLint y, GLsizei width, GLsizei height,
                     GLenum format, GLenum type, GLvoid* pixels) {
 }
@@ -109,6 +131,8 @@ void GL::bindTexture(GLenum target, GLuint texture ) {
 void GL::activeTexture(GLenum texture) {
 }
 void GL::genTextures(GLsizei n, GLuint *textures ) {
+    static GLuint handle = 0;
+    for (GLsizei i = 0; i < n; i++) { textures[i] = ++handle; }
 }
 void GL::deleteTextures(GLsizei n, const GLuint *textures) {
 }
@@ -117,6 +141,9 @@ void GL::texParameteri(GLenum target, GLenum pname, GLint param ) {
 void GL::texImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height,
                     GLint border, GLenum format, GLenum type, const GLvoid *pixels) {
 }
+void GL::compressedTexImage2D(GLenum target, GLint level, GLenum internalFormat, GLsizei width, GLsizei height,
+                              GLint border, GLsizei imageSize, const GLvoid *data) {
+}
 void GL::texSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height,
                        GLenum format, GLenum type, const GLvoid *pixels) {
 }
@@ -135,6 +162,14 @@ void GL::drawArrays(GLenum mode, GLint first, GLsizei count ) {
 }
 void GL::drawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices ) {
 }
+void GL::vertexAttribDivisor(GLuint index, GLuint divisor) {
+}
+void GL::drawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type,
+                                const GLvoid *indices, GLint basevertex) {
+}
+void GL::drawElementsInstanced(GLenum mode, GLsizei count, GLenum type,
+                               const GLvoid *indices, GLsizei instancecount) {
+}
 
 void GL::uniform1f(GLint location, GLfloat v0) {
 }
@@ -185,6 +220,9 @@ void* GL::mapBuffer(GLenum target, GLenum access) {
 GLboolean GL::unmapBuffer(GLenum target) {
     return true;
 }
+void* GL::mapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+    return nullptr;
+}
 
 void GL::finish(void) {
 }
@@ -197,6 +235,32 @@ void GL::deleteVertexArrays(GLsizei n, const GLuint *arrays) {
 void GL::genVertexArrays(GLsizei n, GLuint *arrays) {
 }
 
+// Compute shaders
+void GL::dispatchCompute(GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z) {
+}
+void GL::memoryBarrier(GLbitfield barriers) {
+}
+
+// Timer queries
+void GL::genQueries(GLsizei n, GLuint *ids) {
+    static GLuint handle = 0;
+    for (GLsizei i = 0; i < n; i++) { ids[i] = ++handle; }
+}
+void GL::deleteQueries(GLsizei n, const GLuint *ids) {
+}
+void GL::beginQuery(GLenum target, GLuint id) {
+}
+void GL::endQuery(GLenum target) {
+}
+void GL::getQueryObjectuiv(GLuint id, GLenum pname, GLuint *params) {
+    // Results are available immediately
+    *params = 1;
+}
+void GL::getQueryObjectui64v(GLuint id, GLenum pname, uint64_t *params) {
+    // One millisecond for each query
+    *params = 1000000;
+}
+
 // Framebuffer
 void GL::bindFramebuffer(GLenum target, GLuint framebuffer) {
 }
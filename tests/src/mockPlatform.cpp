@@ -100,6 +100,8 @@ std::vector<char> MockPlatform::getBytesFromFile(const char* path) {
 
 void setCurrentThreadPriority(int priority) {}
 
+void setCurrentThreadPlacement(ThreadRole _role, ThreadPlacement _placement) {}
+
 void initGLExtensions() {}
 
 } // namespace Tangram
@@ -0,0 +1,71 @@
+#include "catch.hpp"
+
+#include "gl/bufferPool.h"
+#include "gl/renderState.h"
+
+using namespace Tangram;
+
+#define TAGS "[BufferPool]"
+
+TEST_CASE("BufferPool reuses released ranges", TAGS) {
+    RenderState rs;
+    BufferPool pool(GL_ARRAY_BUFFER);
+    std::vector<char> data(BufferPool::PAGE_SIZE);
+
+    auto a = pool.allocate(rs, 100, data.data());
+    auto b = pool.allocate(rs, 100, data.data());
+    REQUIRE(a);
+    REQUIRE(b);
+    CHECK(a->offset() == 0);
+    CHECK(b->offset() == 112);
+
+    // A released range is merged with the free space after it
+    b.reset();
+    auto c = pool.allocate(rs, 200, data.data());
+    CHECK(c->offset() == 112);
+
+    a.reset();
+    auto d = pool.allocate(rs, 50, data.data());
+    CHECK(d->offset() == 0);
+    CHECK(pool.pageCount() == 1);
+
+    CHECK(!pool.allocate(rs, BufferPool::PAGE_SIZE + 1, data.data()));
+}
+
+TEST_CASE("BufferPool adds and deletes pages", TAGS) {
+    RenderState rs;
+    BufferPool pool(GL_ELEMENT_ARRAY_BUFFER);
+    std::vector<char> data(BufferPool::PAGE_SIZE);
+
+    size_t size = BufferPool::PAGE_SIZE / 2 + 1;
+    auto a = pool.allocate(rs, size, data.data());
+    auto b = pool.allocate(rs, size, data.data());
+    auto c = pool.allocate(rs, size, data.data());
+    CHECK(pool.pageCount() == 3);
+
+    // Unused pages are deleted on the next allocation, except one
+    a.reset();
+    b.reset();
+    c.reset();
+    auto d = pool.allocate(rs, BufferPool::PAGE_SIZE, data.data());
+    CHECK(pool.pageCount() == 1);
+    CHECK(d->offset() == 0);
+}
+
+TEST_CASE("BufferPool aligns ranges to the vertex stride", TAGS) {
+    RenderState rs;
+    BufferPool pool(GL_ARRAY_BUFFER);
+    std::vector<char> data(BufferPool::PAGE_SIZE);
+
+    auto a = pool.allocate(rs, 100, data.data());
+    auto b = pool.allocate(rs, 240, data.data(), 48);
+    REQUIRE(b);
+    CHECK(b->offset() == 144);
+
+    // The space before an aligned range stays free
+    auto c = pool.allocate(rs, 16, data.data());
+    CHECK(c->offset() == 112);
+    auto d = pool.allocate(rs, 10, data.data(), 48);
+    CHECK(d->offset() == 384);
+    CHECK(pool.pageCount() == 1);
+}
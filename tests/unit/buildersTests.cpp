@@ -0,0 +1,287 @@
+#include "catch.hpp"
+
+#include "util/builders.h"
+
+#include "glm/geometric.hpp"
+
+using namespace Tangram;
+
+#define TAGS "[Builders]"
+
+static std::vector<PolyLineVertex> buildLine(const Line& _line, JoinTypes _join, CapTypes _cap,
+                                             bool _useVertexBuffer, std::vector<uint16_t>& _indices) {
+    std::vector<PolyLineVertex> vertices;
+
+    PolyLineBuilder builder([&](const glm::vec2& coord, const glm::vec2& normal, const glm::vec2& uv) {
+        vertices.push_back({ coord, normal, uv });
+    }, _cap, _join);
+    builder.useVertexBuffer = _useVertexBuffer;
+
+    Builders::buildPolyLine(_line, builder);
+
+    if (_useVertexBuffer) { vertices = builder.vertices; }
+    REQUIRE(builder.numVertices == vertices.size());
+    _indices = builder.indices;
+    return vertices;
+}
+
+TEST_CASE("Polyline vertices are the same in the vertex buffer", TAGS) {
+    // Repeated point and an odd number of segments
+    Line line = {{0, 0}, {1, 0}, {1, 1}, {1, 1}, {2, 1}, {2.5, 2}};
+
+    for (auto join : {JoinTypes::miter, JoinTypes::bevel, JoinTypes::round}) {
+        for (auto cap : {CapTypes::butt, CapTypes::square, CapTypes::round}) {
+            std::vector<uint16_t> callbackIndices, bufferIndices;
+            auto callback = buildLine(line, join, cap, false, callbackIndices);
+            auto buffer = buildLine(line, join, cap, true, bufferIndices);
+
+            REQUIRE(callback.size() == buffer.size());
+            REQUIRE(callbackIndices == bufferIndices);
+            for (size_t i = 0; i < callback.size(); i++) {
+                REQUIRE(callback[i].coord == buffer[i].coord);
+                REQUIRE(callback[i].enormal == buffer[i].enormal);
+                REQUIRE(callback[i].uv == buffer[i].uv);
+            }
+        }
+    }
+}
+
+TEST_CASE("Polyline segment normals and distances", TAGS) {
+    Line line = {{0, 0}, {3, 0}, {3, 4}};
+
+    std::vector<uint16_t> indices;
+    auto vertices = buildLine(line, JoinTypes::miter, CapTypes::butt, true, indices);
+
+    // Two vertices for each point with a miter join
+    REQUIRE(vertices.size() == 6);
+    CHECK(vertices[0].enormal == glm::vec2(0, -1));
+    CHECK(vertices[1].enormal == glm::vec2(0, 1));
+    CHECK(vertices[4].enormal == glm::vec2(1, 0));
+
+    // The length-wise texture coordinate is the distance along the line
+    CHECK(vertices[2].uv.y == 3.f);
+    CHECK(vertices[5].uv.y == 7.f);
+}
+
+TEST_CASE("A continued polyline has the geometry of the whole line", TAGS) {
+    Line line = {{0, 0}, {1, 0}, {1, 1}, {2, 1.5}, {3, 1}};
+
+    for (auto join : {JoinTypes::miter, JoinTypes::bevel, JoinTypes::round}) {
+        for (auto cap : {CapTypes::butt, CapTypes::square, CapTypes::round}) {
+            std::vector<uint16_t> indices, wholeIndices;
+            auto whole = buildLine(line, join, cap, true, wholeIndices);
+
+            PolyLineBuilder builder({}, cap, join);
+            builder.useVertexBuffer = true;
+            Builders::buildPolyLine(LineView(line.data(), 3), builder);
+
+            // Replace the end of the line by the line from its second to last point
+            auto vertices = builder.vertices;
+            indices = builder.indices;
+            vertices.resize(vertices.size() - builder.endVertices);
+            indices.resize(indices.size() - builder.endIndices);
+            size_t base = vertices.size() - 2;
+
+            builder.clear();
+            builder.continueLine = true;
+            Builders::buildPolyLine(LineView(line.data() + 1, line.size() - 1), builder);
+
+            REQUIRE(builder.numVertices == builder.vertices.size() + 2);
+            vertices.insert(vertices.end(), builder.vertices.begin(), builder.vertices.end());
+            for (auto i : builder.indices) { indices.push_back(base + i); }
+
+            REQUIRE(vertices.size() == whole.size());
+            REQUIRE(indices == wholeIndices);
+            for (size_t i = 0; i < whole.size(); i++) {
+                REQUIRE(vertices[i].coord == whole[i].coord);
+                REQUIRE(vertices[i].enormal == whole[i].enormal);
+            }
+        }
+    }
+}
+
+static std::vector<uint16_t> buildPolygon(const Polygon& _polygon, PolygonBuilder& _builder) {
+    Feature feature;
+    feature.addPolygon(_polygon);
+    _builder.clear();
+    Builders::buildPolygon(feature.polygons()[0], 0.f, _builder);
+    return _builder.indices;
+}
+
+TEST_CASE("Convex polygons are triangulated as a fan", TAGS) {
+    Builders::collectTessellationStats(true);
+    auto before = Builders::tessellationStats();
+
+    PolygonBuilder builder;
+    Line square = {{0, 0}, {1, 0}, {1, 1}, {0, 1}, {0, 0}};
+    Line reversed(square.rbegin(), square.rend());
+
+    for (auto& ring : {square, reversed}) {
+        // The closing point is not used
+        auto indices = buildPolygon({ring}, builder);
+        REQUIRE(indices.size() == 6);
+        REQUIRE(builder.numVertices == 4);
+    }
+
+    // Both windings result in counterclockwise triangles
+    Feature feature;
+    feature.addPolygon({reversed});
+    std::vector<glm::vec3> vertices;
+    PolygonBuilder collect([&](const glm::vec3& coord, const glm::vec3&, const glm::vec2&) {
+        vertices.push_back(coord);
+    });
+    Builders::buildPolygon(feature.polygons()[0], 0.f, collect);
+    for (size_t i = 0; i < collect.indices.size(); i += 3) {
+        auto a = vertices[collect.indices[i]], b = vertices[collect.indices[i + 1]], c = vertices[collect.indices[i + 2]];
+        CHECK((b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x) > 0);
+    }
+
+    // A concave ring and a star are not convex
+    buildPolygon({{{0, 0}, {2, 0}, {2, 1}, {1, 1}, {1, 2}, {0, 2}, {0, 0}}}, builder);
+    buildPolygon({{{0, 0}, {2, 1}, {-0.5, 1.5}, {1, -0.5}, {1.5, 2}, {0, 0}}}, builder);
+
+    auto after = Builders::tessellationStats();
+    CHECK(after.polygons - before.polygons == 5);
+    CHECK(after.convex - before.convex == 3);
+    Builders::collectTessellationStats(false);
+}
+
+TEST_CASE("Triangulations of repeated shapes are cached", TAGS) {
+    Builders::collectTessellationStats(true);
+    auto before = Builders::tessellationStats();
+
+    // Concave comb shape with enough points to be cached
+    Line ring;
+    for (int i = 0; i < 6; i++) {
+        ring.push_back({i * 2.f, 0});
+        ring.push_back({i * 2.f + 1, 1});
+    }
+    ring.push_back({11, 3});
+    ring.push_back({0, 3});
+    ring.push_back(ring.front());
+
+    PolygonBuilder builder;
+    auto first = buildPolygon({ring}, builder);
+
+    // The same shape at another position
+    Line moved;
+    for (auto& p : ring) { moved.push_back(p + glm::vec2(5, 5)); }
+    auto second = buildPolygon({moved}, builder);
+
+    auto after = Builders::tessellationStats();
+    CHECK(after.cached - before.cached == 1);
+    CHECK(first == second);
+    Builders::collectTessellationStats(false);
+}
+
+TEST_CASE("Collinear polygon edges are merged into one wall", TAGS) {
+    // Square with a point in the middle of each side, inside the tile
+    Line ring = {{0.2, 0.2}, {0.5, 0.2}, {0.8, 0.2}, {0.8, 0.5}, {0.8, 0.8},
+                 {0.5, 0.8}, {0.2, 0.8}, {0.2, 0.5}, {0.2, 0.2}};
+    Feature feature;
+    feature.addPolygon({ring});
+
+    PolygonBuilder builder;
+    Builders::buildPolygonExtrusion(feature.polygons()[0], 0.f, 1.f, builder);
+    CHECK(builder.numVertices == 32);
+    CHECK(builder.indices.size() == 48);
+
+    std::vector<glm::vec3> vertices;
+    PolygonBuilder merged([&](const glm::vec3& coord, const glm::vec3&, const glm::vec2&) {
+        vertices.push_back(coord);
+    });
+    merged.mergeCollinearWalls = true;
+    Builders::buildPolygonExtrusion(feature.polygons()[0], 0.f, 1.f, merged);
+    REQUIRE(merged.numVertices == 16);
+    CHECK(merged.indices.size() == 24);
+
+    // Each wall spans a whole side of the square
+    for (size_t i = 0; i < vertices.size(); i += 4) {
+        CHECK(glm::distance(glm::vec2(vertices[i]), glm::vec2(vertices[i + 1])) == Approx(0.6f));
+    }
+
+    // Edges on the tile border get no wall
+    Feature triangle;
+    triangle.addPolygon({{{0, 0}, {0.5, 0}, {1, 0}, {0.5, 0.5}, {0, 0}}});
+    std::vector<std::pair<glm::vec2, glm::vec2>> walls;
+    merged.keepTileEdges = false;
+    Builders::forEachWall(triangle.polygons()[0], merged, [&](const glm::vec2& a, const glm::vec2& b) {
+        walls.emplace_back(a, b);
+    });
+    REQUIRE(walls.size() == 2);
+    CHECK(walls[0].first == glm::vec2(1, 0));
+    CHECK(walls[1].second == glm::vec2(0, 0));
+}
+
+TEST_CASE("Points closer than the tolerance are simplified away", TAGS) {
+    // Points within 0.001 of a straight line, then a corner
+    Line line = {{0, 0}, {0.1, 0.0005}, {0.2, -0.0005}, {0.3, 0}, {0.3, 0.1}, {0.3, 0.2}};
+
+    Line simplified;
+    Builders::simplifyLine(line, 0.001f, simplified);
+    REQUIRE(simplified.size() == 3);
+    CHECK(simplified[0] == glm::vec2(0, 0));
+    CHECK(simplified[1] == glm::vec2(0.3, 0));
+    CHECK(simplified[2] == glm::vec2(0.3, 0.2));
+
+    // Points farther than the tolerance are kept
+    simplified.clear();
+    Builders::simplifyLine(line, 0.0001f, simplified);
+    CHECK(simplified.size() == 5);
+
+    // Rings are not collapsed below a triangle
+    Feature feature;
+    feature.addPolygon({{{0, 0}, {0.0005, 0}, {0.0005, 0.0005}, {0, 0}},
+                        {{0.2, 0.2}, {0.3, 0.2005}, {0.4, 0.2}, {0.3, 0.4}, {0.2, 0.2}}});
+
+    GeometryBuffer buffer;
+    auto polygon = Builders::simplifyPolygon(feature.polygons()[0], 0.001f, buffer);
+    REQUIRE(polygon.size() == 2);
+    CHECK(polygon[0].size() == 4);
+    CHECK(polygon[1].size() == 4);
+}
+
+TEST_CASE("Polygons are clipped to the tile", TAGS) {
+    // Square much larger than the tile with a hole inside the tile and one outside
+    Feature feature;
+    feature.addPolygon({{{-10, -10}, {10, -10}, {10, 10}, {-10, 10}, {-10, -10}},
+                        {{0.2, 0.2}, {0.2, 0.8}, {0.8, 0.8}, {0.8, 0.2}, {0.2, 0.2}},
+                        {{2, 2}, {2, 3}, {3, 3}, {3, 2}, {2, 2}}});
+
+    GeometryBuffer buffer;
+    auto polygon = Builders::clipPolygon(feature.polygons()[0], buffer);
+    REQUIRE(polygon.size() == 2);
+    REQUIRE(polygon[0].size() == 5);
+    for (const auto& p : polygon[0]) {
+        CHECK((p.x == 0.f || p.x == 1.f));
+        CHECK((p.y == 0.f || p.y == 1.f));
+    }
+    CHECK(polygon[1].size() == 5);
+
+    // The clipped edges are on the tile edges, so they get no walls
+    PolygonBuilder builder;
+    builder.keepTileEdges = false;
+    size_t walls = 0;
+    Builders::forEachWall(polygon, builder, [&](const glm::vec2&, const glm::vec2&) { walls++; });
+    CHECK(walls == 4);
+
+    // Polygons inside the tile are not copied
+    Feature inside;
+    inside.addPolygon({{{0.2, 0.2}, {0.8, 0.2}, {0.5, 0.8}, {0.2, 0.2}}});
+    buffer.clear();
+    polygon = Builders::clipPolygon(inside.polygons()[0], buffer);
+    CHECK(polygon.size() == 1);
+    CHECK(buffer.coordinates.empty());
+
+    // Polygons outside the tile are dropped
+    Feature outside;
+    outside.addPolygon({{{2, 2}, {3, 2}, {3, 3}, {2, 2}}});
+    polygon = Builders::clipPolygon(outside.polygons()[0], buffer);
+    CHECK(polygon.empty());
+
+    // A triangle crossing a corner becomes a quad
+    Line ring;
+    REQUIRE(Builders::clipRing(Line{{-0.5, 0.5}, {0.5, -0.5}, {0.5, 0.5}, {-0.5, 0.5}}, ring));
+    CHECK(ring.size() == 6);
+    CHECK(ring.front() == ring.back());
+}
@@ -0,0 +1,48 @@
+#include "catch.hpp"
+
+#include "util/cpuTopology.h"
+
+using namespace Tangram;
+
+TEST_CASE("CpuTopology does not place threads on cores of the same capacity", "[Core][CpuTopology]") {
+    CpuTopology topology({ 1024, 1024, 1024, 1024 });
+
+    REQUIRE(!topology.isHeterogeneous());
+    REQUIRE(topology.allCores() == 0xf);
+    REQUIRE(topology.affinity(ThreadRole::worker, ThreadPlacement::throughput) == 0xf);
+    REQUIRE(topology.affinity(ThreadRole::io, ThreadPlacement::battery) == 0xf);
+}
+
+TEST_CASE("CpuTopology does not place threads on cores of unknown capacity", "[Core][CpuTopology]") {
+    CpuTopology topology({ 0, 0 });
+
+    REQUIRE(!topology.isHeterogeneous());
+    REQUIRE(topology.affinity(ThreadRole::gl, ThreadPlacement::throughput) == 0x3);
+}
+
+TEST_CASE("CpuTopology places threads on big.LITTLE cores", "[Core][CpuTopology]") {
+    // Four little, three mid and one prime core
+    CpuTopology topology({ 400, 400, 400, 400, 800, 800, 800, 1024 });
+
+    REQUIRE(topology.isHeterogeneous());
+    REQUIRE(topology.littleCores() == 0x0f);
+    REQUIRE(topology.bigCores() == 0x80);
+
+    REQUIRE(topology.affinity(ThreadRole::worker, ThreadPlacement::none) == 0xff);
+
+    // The workers leave the prime core to the GL thread
+    REQUIRE(topology.affinity(ThreadRole::gl, ThreadPlacement::throughput) == 0x80);
+    REQUIRE(topology.affinity(ThreadRole::worker, ThreadPlacement::throughput) == 0x70);
+    REQUIRE(topology.affinity(ThreadRole::io, ThreadPlacement::throughput) == 0x0f);
+
+    REQUIRE(topology.affinity(ThreadRole::gl, ThreadPlacement::battery) == 0xff);
+    REQUIRE(topology.affinity(ThreadRole::worker, ThreadPlacement::battery) == 0x0f);
+    REQUIRE(topology.affinity(ThreadRole::io, ThreadPlacement::battery) == 0x0f);
+}
+
+TEST_CASE("CpuTopology shares a single fast core in throughput placement", "[Core][CpuTopology]") {
+    CpuTopology topology({ 500, 500, 1000 });
+
+    REQUIRE(topology.affinity(ThreadRole::gl, ThreadPlacement::throughput) == 0x4);
+    REQUIRE(topology.affinity(ThreadRole::worker, ThreadPlacement::throughput) == 0x4);
+}
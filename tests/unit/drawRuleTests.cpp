@@ -1,7 +1,9 @@
 #include "catch.hpp"
 
+#include "data/tileData.h"
 #include "scene/drawRule.h"
 #include "scene/sceneLayer.h"
+#include "scene/styleContext.h"
 #include "platform.h"
 
 #include <cstdio>
@@ -17,7 +19,7 @@ void logDrawRule(const DrawRule& drawRule) {
         if (!drawRule.active[i]) {
             continue;
         }
-        auto* param = drawRule.params[i].param;
+        auto* param = drawRule.param(i).param;
         if (!param) {
             logMsg("param : none %d\n", i);
             continue;
@@ -132,4 +134,161 @@ TEST_CASE("DrawRule correctly merges with another DrawRule", TAGS) {
     }
 }
 
+TEST_CASE("DrawRuleMergeSet reuses matches for features with equal filter properties", TAGS) {
+
+    const DrawRuleData rule_a = { "draw_group_0", 0, {
+            { StyleParamKey::order, "order_a" }
+    } };
+
+    const DrawRuleData rule_b = { "draw_group_0", 0, {
+            { StyleParamKey::order, "order_b" }
+    } };
+
+    SceneLayer layer_b = { "b", Filter::MatchEquality("kind", { Value(std::string("major")) }),
+                           { rule_b }, {}, SceneLayer::Options() };
+    SceneLayer layer_a = { "a", Filter(), { rule_a }, { layer_b }, SceneLayer::Options() };
+
+    REQUIRE(layer_a.matchIsCacheable());
+    REQUIRE(layer_a.filterKeys().size() == 1);
+
+    Feature major1, major2, minor;
+    major1.props.set("kind", "major");
+    major1.props.set("name", "a");
+    major2.props.set("kind", "major");
+    major2.props.set("name", "b");
+    minor.props.set("kind", "minor");
+
+    StyleContext ctx;
+    DrawRuleMergeSet mergeSet;
+    std::string order;
+
+    REQUIRE(mergeSet.match(major1, layer_a, ctx));
+    REQUIRE(mergeSet.matchedRules()[0].get(StyleParamKey::order, order));
+    CHECK(order == "order_b");
+    CHECK(mergeSet.cacheHits() == 0);
+
+    // 'name' is not used by the filters
+    REQUIRE(mergeSet.match(major2, layer_a, ctx));
+    REQUIRE(mergeSet.matchedRules()[0].get(StyleParamKey::order, order));
+    CHECK(order == "order_b");
+    CHECK(mergeSet.cacheHits() == 1);
+
+    REQUIRE(mergeSet.match(minor, layer_a, ctx));
+    REQUIRE(mergeSet.matchedRules()[0].get(StyleParamKey::order, order));
+    CHECK(order == "order_a");
+    CHECK(mergeSet.cacheHits() == 1);
+
+    SECTION("layers with function filters are not cached") {
+        SceneLayer layer_f = { "f", Filter::MatchFunction(0), { rule_b }, {}, SceneLayer::Options() };
+        SceneLayer layer_g = { "g", Filter(), { rule_a }, { layer_f }, SceneLayer::Options() };
+        CHECK(!layer_g.matchIsCacheable());
+    }
+}
+
+TEST_CASE("DrawRuleMergeSet reuses merged rules for matches of the same layers", TAGS) {
+
+    const DrawRuleData rule_a = { "draw_group_0", 0, {
+            { StyleParamKey::order, "order_a" },
+            { StyleParamKey::color, "color_a" }
+    } };
+
+    const DrawRuleData rule_b = { "draw_group_0", 0, {
+            { StyleParamKey::order, "order_b" }
+    } };
+
+    SceneLayer layer_b = { "b", Filter::MatchEquality("kind", { Value(std::string("major")),
+                                                                Value(std::string("trunk")) }),
+                           { rule_b }, {}, SceneLayer::Options() };
+    SceneLayer layer_a = { "a", Filter(), { rule_a }, { layer_b }, SceneLayer::Options() };
+
+    Feature major, trunk;
+    major.props.set("kind", "major");
+    trunk.props.set("kind", "trunk");
+
+    StyleContext ctx;
+    DrawRuleMergeSet mergeSet;
+    std::string order;
+
+    REQUIRE(mergeSet.match(major, layer_a, ctx));
+    size_t hash = mergeSet.matchedRules()[0].getParamSetHash();
+    CHECK(mergeSet.mergeCacheHits() == 0);
+
+    // Different filter values, same matched layers
+    REQUIRE(mergeSet.match(trunk, layer_a, ctx));
+    CHECK(mergeSet.cacheHits() == 0);
+    CHECK(mergeSet.mergeCacheHits() == 1);
+
+    auto& rule = mergeSet.matchedRules()[0];
+    REQUIRE(rule.get(StyleParamKey::order, order));
+    CHECK(order == "order_b");
+    CHECK(rule.getParamSetHash() == hash);
+
+    // The hash follows parameters that are deactivated after merging
+    rule.active[static_cast<uint8_t>(StyleParamKey::color)] = false;
+    CHECK(rule.getParamSetHash() != hash);
+
+    mergeSet.clearCache();
+    REQUIRE(mergeSet.match(trunk, layer_a, ctx));
+    CHECK(mergeSet.mergeCacheHits() == 1);
+}
+
+
+TEST_CASE("DrawRule copies keep the params of many keys", TAGS) {
+
+    std::vector<StyleParam> params;
+    for (size_t i = 0; i < StyleParamKeySize; i += 2) {
+        params.emplace_back(static_cast<StyleParamKey>(i), "value_" + std::to_string(i));
+    }
+    const DrawRuleData data = { "draw_group_0", 0, params };
+    const DrawRuleData override_data = { "draw_group_0", 0, {
+            { StyleParamKey::order, "order_b" },
+            { StyleParamKey::join, "join_b" }
+    } };
+
+    DrawRule rule(data, "a", 1);
+    rule.merge(override_data, "b", 2);
+
+    DrawRule copy = rule;
+    DrawRule assigned(override_data, "c", 1);
+    assigned = copy;
+
+    for (auto* r : { &rule, &copy, &assigned }) {
+        std::string value;
+        for (size_t i = 0; i < StyleParamKeySize; i++) {
+            auto key = static_cast<StyleParamKey>(i);
+            if (key == StyleParamKey::order || key == StyleParamKey::join) { continue; }
+            CHECK(r->get(key, value) == (i % 2 == 0));
+            if (i % 2 == 0) { CHECK(value == "value_" + std::to_string(i)); }
+        }
+        REQUIRE(r->get(StyleParamKey::order, value));
+        CHECK(value == "order_b");
+        REQUIRE(r->get(StyleParamKey::join, value));
+        CHECK(value == "join_b");
+    }
+}
+
+TEST_CASE("DrawRule resolves the name ID of its style", TAGS) {
+
+    const Filter matchEverything;
+
+    StyleParam style(StyleParamKey::style, "lines");
+    style.nameId = 2;
+
+    const DrawRuleData rule_a = { "polygons", 0, { { StyleParamKey::order, "1" } } };
+    const DrawRuleData rule_b = { "roads", 1, { style } };
+
+    const SceneLayer layer_a = { "a", matchEverything, { rule_a }, {}, SceneLayer::Options() };
+    const SceneLayer layer_b = { "b", matchEverything, { rule_b }, {}, SceneLayer::Options() };
+
+    DrawRuleMergeSet mergeSet;
+    mergeSet.mergeRules(layer_a);
+    mergeSet.mergeRules(layer_b);
+    REQUIRE(mergeSet.matchedRules().size() == 2);
+
+    // Without a style param the rule name is the style name
+    CHECK(mergeSet.matchedRules()[0].getStyleNameId() == 0);
+    CHECK(mergeSet.matchedRules()[1].getStyleNameId() == 2);
+    CHECK(mergeSet.matchedRules()[1].getStyleName() == "lines");
+}
+
 }
@@ -375,3 +375,161 @@ TEST_CASE( "Test evalFunction explicit", "[Duktape][evalFunction]") {
     }
 
 }
+
+TEST_CASE( "Test native evaluation of simple functions", "[Duktape][native]") {
+    Feature feature;
+    feature.props.set("kind", "major_road");
+    feature.props.set("n", 42);
+
+    StyleContext ctx;
+    ctx.setFeature(feature);
+    ctx.setZoom(15);
+
+    REQUIRE(ctx.setFunctions({
+        R"(function() { return feature.kind === 'major_road' && $zoom >= 14; })",
+        R"(function() { return feature.n > 40 ? 'high' : 'low'; })",
+        R"(function() { return feature.n * 0.5 + 1; })",
+        R"(function() { return 'n' + feature.n; })",
+        R"(function() { return feature.kind.toUpperCase(); })"}));
+
+    // The last one calls a method and is left to the JS engine
+    REQUIRE(ctx.nativeFunctionCount() == 4);
+
+    REQUIRE(ctx.evalFilter(0) == true);
+
+    StyleParam::Value value;
+    REQUIRE(ctx.evalStyle(1, StyleParamKey::text_source, value) == true);
+    REQUIRE(value.get<std::string>() == "high");
+
+    REQUIRE(ctx.evalStyle(2, StyleParamKey::priority, value) == true);
+    REQUIRE(value.get<float>() == 22.f);
+
+    // Number to string conversion falls back to JS
+    REQUIRE(ctx.evalStyle(3, StyleParamKey::text_source, value) == true);
+    REQUIRE(value.get<std::string>() == "n42");
+
+    REQUIRE(ctx.evalStyle(4, StyleParamKey::text_source, value) == true);
+    REQUIRE(value.get<std::string>() == "MAJOR_ROAD");
+
+    ctx.setZoom(13);
+    REQUIRE(ctx.evalFilter(0) == false);
+}
+
+TEST_CASE( "Test loading functions from compiled bytecode", "[Duktape][bytecode]") {
+    std::vector<std::string> functions = {
+        R"(function() { return feature.name.toUpperCase() === 'MAIN ST'; })",
+        R"(function() { return feature.name.length; })",
+        R"(function() { return ( })"};
+
+    std::vector<JSFunctionBytecode> bytecode;
+    {
+        StyleContext compileContext;
+        REQUIRE(compileContext.compileFunctions(functions, bytecode) == false);
+    }
+    REQUIRE(bytecode.size() == 3);
+    REQUIRE(bytecode[0].empty() == false);
+    REQUIRE(bytecode[2].empty() == true);
+
+    Feature feature;
+    feature.props.set("name", "Main St");
+
+    StyleContext ctx;
+    ctx.setFeature(feature);
+
+    // The last function failed to compile
+    REQUIRE(ctx.setFunctions(functions, bytecode) == false);
+
+    REQUIRE(ctx.evalFilter(0) == true);
+
+    StyleParam::Value value;
+    REQUIRE(ctx.evalStyle(1, StyleParamKey::priority, value) == true);
+    REQUIRE(value.get<float>() == 7.f);
+}
+
+TEST_CASE( "Test evalFilterBatch", "[Duktape][evalFilter]") {
+    std::vector<Feature> features(6);
+    for (size_t i = 0; i < features.size(); i++) {
+        features[i].props.set("name", i % 2 ? "odd" : "even");
+        features[i].geometryType = i < 3 ? GeometryType::points : GeometryType::lines;
+    }
+
+    StyleContext ctx;
+    REQUIRE(ctx.setFunctions({
+        R"(function() { return feature.name.indexOf('o') === 0; })",
+        R"(function() { return $geometry === 'line' && feature.name.length === 4; })",
+        R"(function() { return feature.name === 'odd'; })"}));
+
+    // The last one is evaluated natively
+    REQUIRE(ctx.nativeFunctionCount() == 1);
+
+    ctx.evalFilterBatch(0, features);
+    ctx.evalFilterBatch(1, features);
+    ctx.evalFilterBatch(2, features);
+
+    for (size_t i = 0; i < features.size(); i++) {
+        ctx.setFeature(features[i]);
+        REQUIRE(ctx.evalFilter(0) == (i % 2 == 1));
+        REQUIRE(ctx.evalFilter(1) == (i == 4));
+        REQUIRE(ctx.evalFilter(2) == (i % 2 == 1));
+    }
+
+    // Features outside of the batch are evaluated one at a time
+    Feature other;
+    other.props.set("name", "odd");
+    other.geometryType = GeometryType::lines;
+    ctx.setFeature(other);
+    REQUIRE(ctx.evalFilter(0) == true);
+    REQUIRE(ctx.evalFilter(1) == false);
+
+    ctx.clearFilterBatch();
+    ctx.setFeature(features[4]);
+    REQUIRE(ctx.evalFilter(1) == true);
+}
+
+TEST_CASE( "Test caching of evalStyle results by the properties read", "[Duktape][evalStyle]") {
+    StyleContext ctx;
+    REQUIRE(ctx.setFunctions({
+        R"(function() { return feature.kind.indexOf('water') === 0 ? 1 : (feature.name ? 2 : 3); })",
+        R"(function() { return Math.random() < 2 ? feature.kind.length : 0; })"}));
+    REQUIRE(ctx.nativeFunctionCount() == 0);
+
+    std::vector<Feature> features(4);
+    features[0].props.set("kind", "water");
+    features[0].props.set("name", "a");
+    features[1].props.set("kind", "water");
+    features[1].props.set("name", "b");
+    features[2].props.set("kind", "park");
+    features[2].props.set("name", "c");
+    features[3].props.set("kind", "park");
+    ctx.setZoom(10);
+
+    StyleParam::Value value;
+    for (size_t i = 0; i < features.size(); i++) {
+        ctx.setFeature(features[i]);
+        REQUIRE(ctx.evalStyle(0, StyleParamKey::priority, value) == true);
+        REQUIRE(value.get<float>() == (i < 2 ? 1 : (i < 3 ? 2 : 3)));
+    }
+    // Only 'kind' was read for the second feature
+    REQUIRE(ctx.cachedResultCount() == 1);
+
+    // 'name' is read once the kind is not water
+    ctx.setFeature(features[2]);
+    REQUIRE(ctx.evalStyle(0, StyleParamKey::priority, value) == true);
+    REQUIRE(value.get<float>() == 2);
+    ctx.setFeature(features[3]);
+    REQUIRE(ctx.evalStyle(0, StyleParamKey::priority, value) == true);
+    REQUIRE(value.get<float>() == 3);
+    REQUIRE(ctx.cachedResultCount() == 3);
+
+    // The zoom is an input of all functions
+    ctx.setZoom(11);
+    REQUIRE(ctx.evalStyle(0, StyleParamKey::priority, value) == true);
+    REQUIRE(ctx.cachedResultCount() == 3);
+
+    // Functions that are not deterministic are always evaluated
+    ctx.setFeature(features[0]);
+    REQUIRE(ctx.evalStyle(1, StyleParamKey::priority, value) == true);
+    REQUIRE(ctx.evalStyle(1, StyleParamKey::priority, value) == true);
+    REQUIRE(value.get<float>() == 5);
+    REQUIRE(ctx.cachedResultCount() == 3);
+}
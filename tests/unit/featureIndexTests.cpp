@@ -0,0 +1,68 @@
+#include "catch.hpp"
+
+#include "data/propertyItem.h"
+#include "data/tileData.h"
+#include "selection/featureIndex.h"
+
+using namespace Tangram;
+
+TEST_CASE("FeatureIndex picks points, lines and polygons", "[Core][FeatureIndex]") {
+    Layer layer("test");
+
+    Feature polygon(0, layer.geometry);
+    polygon.geometryType = GeometryType::polygons;
+    polygon.addPolygon({{{0.f, 0.f}, {1.f, 0.f}, {1.f, 1.f}, {0.f, 1.f}, {0.f, 0.f}},
+                        {{0.4f, 0.4f}, {0.6f, 0.4f}, {0.6f, 0.6f}, {0.4f, 0.6f}, {0.4f, 0.4f}}});
+
+    Feature line(0, layer.geometry);
+    line.geometryType = GeometryType::lines;
+    line.addLine({{0.f, 0.2f}, {1.f, 0.2f}});
+
+    Feature point(0, layer.geometry);
+    point.geometryType = GeometryType::points;
+    point.addPoint({0.8f, 0.8f});
+
+    FeatureIndex index;
+    index.add(point, 3);
+    index.add(line, 2);
+    index.add(polygon, 1);
+    index.build();
+
+    REQUIRE(index.size() == 3);
+
+    // Inside the polygon, but not in its hole
+    REQUIRE(index.pick({0.2f, 0.8f}, 0.01f).id == 1);
+    REQUIRE(index.pick({0.5f, 0.5f}, 0.01f).id == 0);
+    REQUIRE(index.pick({1.5f, 0.5f}, 0.01f).id == 0);
+
+    // Points and lines are picked over the polygon below them
+    auto hit = index.pick({0.5f, 0.21f}, 0.02f);
+    REQUIRE(hit.id == 2);
+    REQUIRE(hit.type == GeometryType::lines);
+    REQUIRE(index.pick({0.5f, 0.3f}, 0.02f).id == 1);
+    REQUIRE(index.pick({0.81f, 0.8f}, 0.02f).id == 3);
+}
+
+TEST_CASE("FeatureIndex picks the last added feature", "[Core][FeatureIndex]") {
+    Layer layer("test");
+
+    std::vector<Feature> features;
+    for (int i = 0; i < 100; i++) {
+        Feature feature(0, layer.geometry);
+        feature.geometryType = GeometryType::points;
+        feature.addPoint({i * 0.01f, i * 0.01f});
+        features.push_back(std::move(feature));
+    }
+
+    FeatureIndex first, second;
+    for (int i = 0; i < 100; i++) { first.add(features[i], i + 1); }
+    second.add(features[50], 1000);
+
+    first.append(second);
+    first.build();
+
+    REQUIRE(first.size() == 101);
+    REQUIRE(first.pick({0.2f, 0.2f}, 0.001f).id == 21);
+    REQUIRE(first.pick({0.5f, 0.5f}, 0.001f).id == 1000);
+    REQUIRE(first.pick({0.5f, 0.6f}, 0.001f).id == 0);
+}
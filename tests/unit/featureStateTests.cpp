@@ -0,0 +1,48 @@
+#include "catch.hpp"
+
+#include "selection/featureSelection.h"
+#include "selection/featureState.h"
+
+using namespace Tangram;
+
+TEST_CASE("Features share the color of their FeatureState across tiles", "[FeatureState]") {
+    FeatureState state;
+
+    uint32_t color = state.color(1, 42);
+    REQUIRE(color != 0);
+    REQUIRE((color & FeatureState::color_flag) != 0);
+
+    REQUIRE(state.color(1, 42) == color);
+    REQUIRE(state.color(2, 42) != color);
+    REQUIRE(state.color(1, 43) != color);
+
+    // Features without an ID have no state
+    REQUIRE(state.color(1, 0) == 0);
+    REQUIRE(!state.set(1, 0, 0xff));
+
+    REQUIRE(state.feature(color) == std::make_pair(int32_t(1), uint64_t(42)));
+    REQUIRE(state.feature(color & ~FeatureState::color_flag) == std::make_pair(int32_t(0), uint64_t(0)));
+}
+
+TEST_CASE("FeatureState is limited to the texels of its texture", "[FeatureState]") {
+    FeatureState state;
+
+    for (uint64_t id = 1; id < FeatureState::size * FeatureState::size; id++) {
+        REQUIRE(state.color(0, id) == (FeatureState::color_flag | uint32_t(id)));
+    }
+
+    // Further features are drawn without a state
+    REQUIRE(state.color(0, FeatureState::size * FeatureState::size) == 0);
+    REQUIRE(!state.set(0, FeatureState::size * FeatureState::size, 0xff));
+    REQUIRE(state.set(0, 1, 0xff));
+}
+
+TEST_CASE("FeatureSelection colors are not FeatureState colors", "[FeatureState]") {
+    FeatureSelection selection;
+
+    for (int i = 0; i < 100; i++) {
+        uint32_t color = selection.nextColorIdentifier();
+        REQUIRE(color != 0);
+        REQUIRE((color & FeatureState::color_flag) == 0);
+    }
+}
@@ -0,0 +1,35 @@
+#include "catch.hpp"
+
+#include "text/fontCoverage.h"
+
+using namespace Tangram;
+
+#define TEST_FONT       "res/fonts/NotoSans-Regular.ttf"
+#define TEST_FONT_AR    "res/fonts/NotoNaskh-Regular.ttf"
+#define TEST_FONT_JP    "res/fonts/DroidSansJapanese.ttf"
+
+TEST_CASE("Read the codepoints covered by a font", "[Core][FontCoverage]") {
+    FontCoverage latin, arabic, japanese;
+    REQUIRE(latin.load(TEST_FONT));
+    REQUIRE(arabic.load(TEST_FONT_AR));
+    REQUIRE(japanese.load(TEST_FONT_JP));
+
+    CHECK(latin.covers('A'));
+    CHECK(latin.covers(0x00E9)); // é
+    CHECK_FALSE(latin.covers(0x0627)); // Arabic alef
+    CHECK_FALSE(latin.covers(0x3042)); // Hiragana a
+
+    CHECK(arabic.covers(0x0627));
+    CHECK_FALSE(arabic.covers(0x3042));
+
+    CHECK(japanese.covers(0x3042));
+    CHECK_FALSE(japanese.covers(0x0627));
+}
+
+TEST_CASE("Fail to read the coverage of a file that is not a font", "[Core][FontCoverage]") {
+    FontCoverage coverage;
+    CHECK_FALSE(coverage.load("res/fonts/missing.ttf"));
+    CHECK_FALSE(coverage.load("res/scene.yaml"));
+    CHECK(coverage.empty());
+    CHECK_FALSE(coverage.covers('A'));
+}
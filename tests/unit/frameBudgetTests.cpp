@@ -0,0 +1,46 @@
+#include "catch.hpp"
+
+#include "util/frameBudget.h"
+
+using namespace Tangram;
+
+TEST_CASE("FrameBudget keeps full quality without a target", "[Core][FrameBudget]") {
+    FrameBudget budget;
+
+    budget.addFrameTime(100.f);
+
+    REQUIRE(budget.quality() == 1.f);
+    REQUIRE(budget.uploadBudget(1000) == 1000);
+    REQUIRE(budget.tileCompletions() == 0);
+    REQUIRE(budget.jobTime() == 0.f);
+    REQUIRE(budget.placeLabels());
+    REQUIRE(budget.placeLabels());
+}
+
+TEST_CASE("FrameBudget defers work while frames are late", "[Core][FrameBudget]") {
+    FrameBudget budget;
+    budget.setTargetFrameTime(16.f);
+
+    for (int i = 0; i < 10; i++) { budget.addFrameTime(30.f); }
+
+    REQUIRE(budget.quality() == FrameBudget::MIN_QUALITY);
+    REQUIRE(budget.uploadBudget(1000) == 250);
+    REQUIRE(budget.tileCompletions() == 2);
+    REQUIRE(budget.jobTime() == 1.f);
+
+    // Labels are placed every fourth update
+    int placements = 0;
+    for (int i = 0; i < 8; i++) { placements += budget.placeLabels() ? 1 : 0; }
+    REQUIRE(placements == 2);
+
+    // Frames within the target keep the quality, fast frames raise it
+    budget.addFrameTime(14.f);
+    REQUIRE(budget.quality() == FrameBudget::MIN_QUALITY);
+    for (int i = 0; i < 20; i++) { budget.addFrameTime(5.f); }
+    REQUIRE(budget.quality() == 1.f);
+    REQUIRE(budget.tileCompletions() == 0);
+
+    budget.addFrameTime(30.f);
+    budget.setTargetFrameTime(0);
+    REQUIRE(budget.quality() == 1.f);
+}
@@ -2,6 +2,7 @@
 
 #include "util/jobQueue.h"
 
+#include <chrono>
 #include <condition_variable>
 #include <memory>
 #include <mutex>
@@ -63,3 +64,39 @@ TEST_CASE("stress test JobQueue", "[JobQueue]") {
 
     CHECK(globalCounter == (numThreads * runJobsRepeats * addJobRepeats));
 }
+
+TEST_CASE("JobQueue leaves jobs beyond the budget for the next call", "[JobQueue]") {
+
+    JobQueue jobQueue;
+    std::vector<int> order;
+
+    for (int i = 0; i < 4; i++) {
+        jobQueue.add([&, i] {
+            order.push_back(i);
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        });
+    }
+
+    CHECK(jobQueue.pendingJobs() == 4);
+
+    // At least one job runs per call
+    jobQueue.runJobs(1.f);
+    CHECK(order.size() == 1);
+    CHECK(jobQueue.hasPendingJobs());
+    CHECK(jobQueue.pendingJobs() == 3);
+
+    // Jobs added by jobs run in the next call, after the pending jobs
+    jobQueue.add([&] {
+        jobQueue.add([&] { order.push_back(5); });
+        order.push_back(4);
+    });
+    jobQueue.runJobs();
+    CHECK(order == std::vector<int>({ 0, 1, 2, 3, 4 }));
+    CHECK(jobQueue.hasPendingJobs());
+    CHECK(jobQueue.pendingJobs() == 1);
+
+    jobQueue.runJobs();
+    CHECK(order.back() == 5);
+    CHECK_FALSE(jobQueue.hasPendingJobs());
+    CHECK(jobQueue.pendingJobs() == 0);
+}
@@ -151,6 +151,33 @@ TEST_CASE( "Ensure debug labels are always visible and cannot occlude", "[Core][
     REQUIRE(!l.canOcclude());
 }
 
+TEST_CASE( "Ensure the fade of a label only changes with its state", "[Core][Label][Fade]" ) {
+    View view = makeView();
+    TestTransform t1;
+
+    TextLabel l(makeLabel({screenSize/2.f}, Label::Type::point));
+
+    l.update(glm::ortho(0.f, screenSize.x, screenSize.y, 0.f, -1.f, 1.f), view.state(), &bounds, t1.transform);
+    l.occlude(false);
+    l.evalState(0);
+
+    REQUIRE(l.state() == Label::State::fading_in);
+    REQUIRE(l.fade(10.f) == glm::vec2(10.f, 0.2f));
+
+    l.evalState(0.1f);
+    REQUIRE(l.state() == Label::State::fading_in);
+    REQUIRE(l.fade(10.1f) == glm::vec2(10.f, 0.2f));
+
+    l.evalState(0.2f);
+    REQUIRE(l.state() == Label::State::visible);
+    REQUIRE(l.fade(10.3f) == glm::vec2(1.f, 0.f));
+
+    l.occlude(true);
+    l.evalState(0);
+    REQUIRE(l.state() == Label::State::fading_out);
+    REQUIRE(l.fade(11.f) == glm::vec2(11.f, -0.2f));
+}
+
 TEST_CASE( "Linear interpolation", "[Core][Label][Fade]" ) {
     FadeEffect fadeOut(false, FadeEffect::Interpolation::linear, 1.0);
 
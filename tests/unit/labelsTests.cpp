@@ -1,5 +1,7 @@
 #include "catch.hpp"
 #include "gl/dynamicQuadMesh.h"
+#include "labels/labelCollider.h"
+#include "labels/labelCollisionPass.h"
 #include "labels/labelManager.h"
 #include "labels/textLabel.h"
 #include "labels/textLabels.h"
@@ -12,6 +14,7 @@
 #include "view/view.h"
 
 #include <memory>
+#include <thread>
 
 namespace Tangram {
 
@@ -216,4 +219,156 @@ TEST_CASE( "Test anchor fallback behavior", "[Labels][AnchorFallback]" ) {
     }
 
 }
+
+TEST_CASE( "Test asynchronous placement", "[Labels][AsyncPlacement]" ) {
+
+    View view(256, 256);
+    view.setConstrainToWorldBounds(false);
+    view.setPosition(0, 0);
+    view.setZoom(0);
+    view.update();
+
+    Tile tile({0,0,0});
+    tile.update(0, view);
+
+    class AsyncLabels : public LabelManager {
+    public:
+        void addLabel(Label* _l, Tile* _t, View& _v) {
+            m_labels.push_back({_l, nullptr, _t, nullptr, false, {}});
+            ScreenTransform transform(m_transforms, m_labels.back().transformRange);
+            _l->update(_t->mvp(), _v.state(), bounds, transform);
+        }
+        void run(View& _v) {
+            applyPlacement();
+            schedulePlacement(_v.state());
+        }
+    };
+
+    AsyncLabels labels;
+    labels.setAsyncPlacement(true);
+
+    TextLabel l1 = makeLabelWithAnchorFallbacks(glm::vec2{0.5,0.5});
+    labels.addLabel(&l1, &tile, view);
+
+    // Second label is one pixel left of L1
+    TextLabel l2 = makeLabelWithAnchorFallbacks(glm::vec2{0.5 - 1./256,0.5});
+    labels.addLabel(&l2, &tile, view);
+
+    // Labels wait for the first placement
+    labels.run(view);
+    REQUIRE(l1.isOccluded() == true);
+    REQUIRE(l2.isOccluded() == true);
+
+    while (labels.placementPending()) {
+        std::this_thread::yield();
+        labels.run(view);
+    }
+
+    // Same result as the synchronous placement
+    REQUIRE(l1.isOccluded() == false);
+    REQUIRE(l2.isOccluded() == false);
+
+    REQUIRE(l1.anchorType() == LabelProperty::Anchor::right);
+    REQUIRE(l2.anchorType() == LabelProperty::Anchor::left);
+}
+
+
+TEST_CASE( "Test incremental placement after a translation", "[Labels][Incremental]" ) {
+
+    View view(256, 256);
+    view.setConstrainToWorldBounds(false);
+    view.setPosition(0, 0);
+    view.setZoom(0);
+    view.update();
+
+    Tile tile({0,0,0});
+    tile.update(0, view);
+
+    class IncrementalLabels : public LabelManager {
+    public:
+        void addLabel(Label* _l, Tile* _t, View& _v) {
+            m_labels.push_back({_l, nullptr, _t, nullptr, false, {}});
+            ScreenTransform transform(m_transforms, m_labels.back().transformRange);
+            _l->update(_t->mvp(), _v.state(), bounds, transform);
+        }
+        void run(View& _v) { handleOcclusions(_v.state()); }
+        void clear() {
+            m_labels.clear();
+            m_transforms.clear();
+            m_obbs.clear();
+        }
+    };
+
+    IncrementalLabels labels;
+
+    TextLabel l1 = makeLabelWithAnchorFallbacks(glm::vec2{0.5,0.5});
+    TextLabel l2 = makeLabelWithAnchorFallbacks(glm::vec2{0.5,0.5});
+
+    labels.addLabel(&l1, &tile, view);
+    labels.addLabel(&l2, &tile, view);
+    labels.run(view);
+
+    REQUIRE(l1.isOccluded() == false);
+    REQUIRE(l2.isOccluded() == true);
+
+    // Pan by a few pixels
+    view.setPosition(1e6, 0);
+    view.update();
+    REQUIRE(view.translatedOnLastUpdate());
+    tile.update(0, view);
+
+    // In reverse order a full placement would show l2 instead of l1
+    labels.clear();
+    labels.addLabel(&l2, &tile, view);
+    labels.addLabel(&l1, &tile, view);
+    labels.run(view);
+
+    REQUIRE(l1.isOccluded() == false);
+    REQUIRE(l2.isOccluded() == true);
+
+    view.setZoom(1);
+    view.update();
+    REQUIRE(view.translatedOnLastUpdate() == false);
+}
+
+
+TEST_CASE( "LabelCollider stores the collisions within a tile per zoom step", "[Labels][LabelCollider]" ) {
+
+    std::vector<std::unique_ptr<Label>> labels;
+    labels.push_back(makeLabel(glm::vec2{0.5,0.5}, Label::Type::point, "0"));
+    labels.push_back(makeLabel(glm::vec2{0.5,0.5}, Label::Type::point, "1"));
+    labels.push_back(makeLabel(glm::vec2{0.1,0.1}, Label::Type::point, "2"));
+
+    LabelCollider collider;
+    collider.addLabels(labels);
+    collider.process({0,0,0}, 1.f, 256.f);
+
+    for (int step = 0; step < Label::tile_zoom_steps; step++) {
+        // One of the overlapping labels is occluded
+        REQUIRE(labels[0]->occludedInTile(step) != labels[1]->occludedInTile(step));
+        REQUIRE(labels[2]->occludedInTile(step) == false);
+    }
+}
+
+TEST_CASE( "Collision candidates are grouped by box", "[Labels][CollisionPass]" ) {
+
+    // Pairs of a box and an earlier box, in the order the GPU reported them
+    std::vector<uint32_t> pairs = { 3, 1,  1, 0,  3, 0,  2, 1 };
+
+    CollisionCandidates candidates;
+    candidates.set(4, pairs.data(), pairs.size() / 2);
+
+    REQUIRE(candidates.size() == 4);
+    REQUIRE(candidates.begin(0) == candidates.end(0));
+    REQUIRE(std::vector<uint32_t>(candidates.begin(1), candidates.end(1)) == std::vector<uint32_t>{ 0 });
+    REQUIRE(std::vector<uint32_t>(candidates.begin(2), candidates.end(2)) == std::vector<uint32_t>{ 1 });
+    REQUIRE(std::vector<uint32_t>(candidates.begin(3), candidates.end(3)) == std::vector<uint32_t>{ 1, 0 });
+
+    // Without a working program the boxes are left to the CPU
+    RenderState rs;
+    LabelCollisionPass pass(rs);
+    REQUIRE_FALSE(pass.findCandidates({ { 0, 0, 10, 10 }, { 5, 5, 15, 15 } }, { 256, 256 }, candidates));
+    REQUIRE(candidates.size() == 0);
+}
+
 }
@@ -0,0 +1,92 @@
+#include "catch.hpp"
+
+#include "scene/light.h"
+#include "scene/lightCulling.h"
+#include "scene/pointLight.h"
+#include "view/view.h"
+
+#include <memory>
+#include <vector>
+
+using namespace Tangram;
+
+static std::unique_ptr<Light> cameraLight(const std::string& _name, glm::vec3 _position, float _radius) {
+    auto light = std::make_unique<PointLight>(_name);
+    UnitVec<glm::vec3> position;
+    position.value = _position;
+    light->setPosition(position);
+    light->setRadius(_radius);
+    return std::move(light);
+}
+
+TEST_CASE("Lights are binned into the screen tiles they reach", "[Lights]") {
+    View view(1024, 768);
+    view.setZoom(16.f);
+    view.setPosition(1000, 1000);
+    view.update();
+
+    float distance = view.getPosition().z;
+
+    std::vector<std::unique_ptr<Light>> lights;
+    // In front of the eye, at the center of the screen
+    lights.push_back(cameraLight("center", {0.f, 0.f, -distance}, 1.f));
+    // Behind the eye
+    lights.push_back(cameraLight("behind", {0.f, 0.f, distance}, 1.f));
+    // Around the eye
+    lights.push_back(cameraLight("around", {0.f, 0.f, 0.f}, 10.f));
+    // Left of the screen
+    lights.push_back(cameraLight("left", {-distance * 10.f, 0.f, -distance}, 1.f));
+
+    auto culled = LightCulling::cullableLights(lights);
+    REQUIRE(culled.size() == 4);
+
+    LightCulling culling(culled);
+    culling.update(view);
+
+    REQUIRE(culling.columns() == 16);
+    REQUIRE(culling.rows() == 12);
+
+    int center = 0, behind = 0, around = 0, left = 0;
+    for (int row = 0; row < culling.rows(); row++) {
+        for (int col = 0; col < culling.columns(); col++) {
+            center += culling.lightInTile(0, col, row);
+            behind += culling.lightInTile(1, col, row);
+            around += culling.lightInTile(2, col, row);
+            left += culling.lightInTile(3, col, row);
+        }
+    }
+
+    REQUIRE(center >= 1);
+    REQUIRE(center <= 4);
+    REQUIRE(culling.lightInTile(0, 8, 6));
+    REQUIRE(behind == 0);
+    REQUIRE(around == 16 * 12);
+    REQUIRE(left == 0);
+}
+
+TEST_CASE("Lights are culled in the shaders of scenes with enough lights of a radius", "[Lights]") {
+
+    std::vector<std::unique_ptr<Light>> lights;
+    for (int i = 0; i < 3; i++) {
+        lights.push_back(cameraLight("light" + std::to_string(i), {0.f, 0.f, -100.f}, 10.f));
+    }
+    lights.push_back(cameraLight("unbounded", {0.f, 0.f, -100.f}, 0.f));
+
+    REQUIRE(LightCulling::cullableLights(lights).empty());
+    REQUIRE(Light::assembleLights(lights)["lighting"].find("lightInTile(") == std::string::npos);
+
+    lights.push_back(cameraLight("light3", {0.f, 0.f, -100.f}, 10.f));
+
+    REQUIRE(LightCulling::cullableLights(lights).size() == 4);
+
+    auto blocks = Light::assembleLights(lights);
+    REQUIRE(blocks["defines"].find("#define TANGRAM_LIGHT_CULLING") != std::string::npos);
+
+    // The light without a radius is computed for all fragments
+    const auto& lighting = blocks["lighting"];
+    REQUIRE(lighting.find("calculateLight(light3") != std::string::npos);
+    REQUIRE(lighting.find("calculateLight(unbounded") != std::string::npos);
+    REQUIRE(lighting.find("lightInTile(light_tile_mask0, vec4(1.0,0.0,0.0,0.0), 8.0)) {\n"
+                          "calculateLight(light3") != std::string::npos);
+    REQUIRE(lighting.find("{\ncalculateLight(unbounded") == std::string::npos);
+}
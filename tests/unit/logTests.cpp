@@ -0,0 +1,44 @@
+#include "catch.hpp"
+
+#include "log.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Tangram;
+
+TEST_CASE("Trace logs are written for enabled categories", "[Log]") {
+    REQUIRE(!logCategoryEnabled(LogCategory::tile));
+
+    setLogCategories(uint32_t(LogCategory::tile) | uint32_t(LogCategory::network));
+    REQUIRE(logCategoryEnabled(LogCategory::tile));
+    REQUIRE(logCategoryEnabled(LogCategory::network));
+    REQUIRE(!logCategoryEnabled(LogCategory::render));
+
+    int evaluated = 0;
+    auto arg = [&]() { return ++evaluated; };
+    LOGC(tile, "enabled %d", arg());
+    LOGC(render, "disabled %d", arg());
+    REQUIRE(evaluated == 1);
+
+    setLogCategories(0);
+    flushLog();
+}
+
+TEST_CASE("Queued log messages are written from many threads", "[Log]") {
+    std::string longText(1000, 'x');
+
+    // More messages than the queue holds, some are dropped
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < 100; i++) {
+                logAsync("thread %d message %d %s\n", t, i, i == 0 ? longText.c_str() : "");
+            }
+        });
+    }
+    for (auto& thread : threads) { thread.join(); }
+
+    flushLog();
+}
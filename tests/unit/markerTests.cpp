@@ -0,0 +1,108 @@
+#include "catch.hpp"
+
+#include "marker/marker.h"
+#include "view/view.h"
+
+#include <memory>
+
+using namespace Tangram;
+
+TEST_CASE( "Markers leave their batch when their mesh is cleared", "[Core][Marker]" ) {
+
+    auto batch = std::make_unique<Marker>(0);
+    Marker a(1), b(2);
+
+    REQUIRE(batch->isBatch());
+    REQUIRE(!a.isBatch());
+
+    a.setBatch(batch.get());
+    b.setBatch(batch.get());
+
+    REQUIRE(a.batch() == batch.get());
+    REQUIRE(batch->batchedMarkers().size() == 2);
+
+    a.clearMesh();
+    REQUIRE(a.batch() == nullptr);
+    REQUIRE(batch->batchedMarkers().size() == 1);
+    REQUIRE(batch->batchedMarkers()[0] == &b);
+
+    {
+        Marker c(3);
+        c.setBatch(batch.get());
+        REQUIRE(batch->batchedMarkers().size() == 2);
+    }
+    REQUIRE(batch->batchedMarkers().size() == 1);
+
+    // Markers of a removed batch are built again on their own
+    batch.reset();
+    REQUIRE(b.batch() == nullptr);
+}
+
+TEST_CASE( "Markers drop a shared styling when they are styled on their own", "[Core][Marker]" ) {
+
+    auto shared = std::make_shared<MarkerStyling>("{ style: lines, color: red }", false);
+    Marker a(1), b(2);
+
+    a.setSharedStyling(shared);
+    b.setSharedStyling(shared);
+    REQUIRE(shared.use_count() == 3);
+    REQUIRE(a.sharedStyling() == shared);
+
+    b.setStyling("{ style: points }", false);
+    REQUIRE(b.sharedStyling() == nullptr);
+    REQUIRE(shared.use_count() == 2);
+
+    // A removed styling stays alive while markers use it
+    std::weak_ptr<MarkerStyling> weak = shared;
+    shared.reset();
+    REQUIRE(!weak.expired());
+    REQUIRE(weak.lock()->rule.styling().string == "{ style: lines, color: red }");
+}
+
+TEST_CASE( "Marker eases are evaluated from the time of the update", "[Core][Marker]" ) {
+
+    View view(256, 256);
+    Marker marker(1);
+    marker.setBounds({ glm::dvec2(0, 0), glm::dvec2(0, 0) });
+
+    marker.setEase({ 100, 200 }, 2.f, EaseType::linear, 10.0);
+    REQUIRE(marker.isEasing());
+
+    marker.update(11.0, view);
+    REQUIRE(marker.origin().x == Approx(50));
+    REQUIRE(marker.origin().y == Approx(100));
+
+    // A new ease starts from the current origin
+    marker.setEase({ 0, 0 }, 1.f, EaseType::linear, 12.0);
+    REQUIRE(marker.origin().x == Approx(100));
+    REQUIRE(marker.origin().y == Approx(200));
+
+    // Updates skipped while hidden do not delay the ease
+    marker.update(20.0, view);
+    REQUIRE(!marker.isEasing());
+    REQUIRE(marker.origin().x == Approx(0));
+    REQUIRE(marker.origin().y == Approx(0));
+
+    marker.setEase({ 10, 10 }, 1.f, EaseType::linear, 20.0);
+    marker.setBounds({ glm::dvec2(5, 5), glm::dvec2(5, 5) });
+    REQUIRE(!marker.isEasing());
+}
+
+TEST_CASE( "Marker bounds are extended without moving the marker geometry", "[Core][Marker]" ) {
+
+    Marker marker(1);
+    marker.setBounds({ glm::dvec2(10, 20), glm::dvec2(110, 70) });
+    REQUIRE(marker.extent() == Approx(100));
+
+    marker.extendBounds({ glm::dvec2(0, 20), glm::dvec2(300, 80) });
+    REQUIRE(marker.bounds().min == glm::dvec2(0, 20));
+    REQUIRE(marker.bounds().max == glm::dvec2(300, 80));
+
+    // The origin and scale of the feature coordinates stay the same
+    REQUIRE(marker.origin() == glm::dvec2(10, 20));
+    REQUIRE(marker.extent() == Approx(100));
+
+    marker.setBounds(marker.bounds());
+    REQUIRE(marker.origin() == glm::dvec2(0, 20));
+    REQUIRE(marker.extent() == Approx(300));
+}
@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include "gl/mesh.h"
+#include "gl/hardware.h"
 
 using namespace Tangram;
 
@@ -27,6 +28,12 @@ struct TestMesh : public Mesh<Vertex> {
 
     int numVertices() const { return m_nVertices; }
     int numIndices() const { return m_nIndices; }
+    size_t numBatches() const { return m_vertexOffsets.size(); }
+    GLenum indexType() const { return m_indexType; }
+    uint32_t index(size_t i) const {
+        return m_indexType == GL_UNSIGNED_INT ? reinterpret_cast<GLuint*>(m_glIndexData)[i]
+                                              : reinterpret_cast<GLushort*>(m_glIndexData)[i];
+    }
 };
 
 std::shared_ptr<TestMesh> newMesh(unsigned int size) {
@@ -170,3 +177,80 @@ TEST_CASE( "Check overflow", "[Core][TypedMesh]" ) {
 
     checkBounds(mesh);
 }
+
+TEST_CASE( "Append MeshData", "[Core][TypedMesh]" ) {
+    MeshData<Vertex> a({0, 1, 2}, {{0,0,0,0}, {1,0,0,0}, {2,0,0,0}});
+    MeshData<Vertex> b({0, 2, 1, 0}, {{3,0,0,0}, {4,0,0,0}, {5,0,0,0}});
+
+    a.append(b);
+
+    REQUIRE(a.indices.size() == 7);
+    REQUIRE(a.vertices.size() == 6);
+    REQUIRE(a.offsets.size() == 2);
+    REQUIRE(a.offsets[1].first == 4);
+    REQUIRE(a.offsets[1].second == 3);
+    REQUIRE(a.vertices[3].a == 3);
+
+    auto mesh = std::make_shared<TestMesh>(layout, GL_TRIANGLES);
+    mesh->compile(a);
+
+    REQUIRE(mesh->numIndices() == 7);
+    REQUIRE(mesh->numVertices() == 6);
+}
+
+TEST_CASE( "MeshData chunks are sorted by their key", "[Core][TypedMesh]" ) {
+    MeshData<Vertex> a({0, 1, 2}, {{0,0,1,0}, {1,0,1,0}, {2,0,1,0}});
+    MeshData<Vertex> b({0, 2, 1, 0}, {{3,0,5,0}, {4,0,5,0}, {5,0,5,0}});
+    MeshData<Vertex> c({1, 0}, {{6,0,3,0}, {7,0,3,0}});
+
+    a.append(b);
+    a.append(c);
+
+    // Highest 'c' first
+    a.sortChunks([](const Vertex* _vertices, size_t _count) {
+        return -float(_vertices[0].c);
+    });
+
+    REQUIRE(a.offsets.size() == 3);
+    REQUIRE(a.offsets[0] == std::make_pair(uint32_t(4), uint32_t(3)));
+    REQUIRE(a.offsets[1] == std::make_pair(uint32_t(2), uint32_t(2)));
+    REQUIRE(a.offsets[2] == std::make_pair(uint32_t(3), uint32_t(3)));
+
+    REQUIRE(a.vertices.size() == 8);
+    REQUIRE(a.vertices[0].a == 3);
+    REQUIRE(a.vertices[3].a == 6);
+    REQUIRE(a.vertices[5].a == 0);
+
+    // Indices stay relative to the first vertex of their chunk
+    REQUIRE(a.indices == std::vector<uint16_t>({0, 2, 1, 0, 1, 0, 0, 1, 2}));
+}
+
+TEST_CASE( "Large meshes are drawn in one batch with 32-bit indices", "[Core][TypedMesh]" ) {
+    // Three parts of 30000 vertices do not fit in one 16-bit batch
+    MeshData<Vertex> meshData;
+    for (int part = 0; part < 3; part++) {
+        meshData.indices.insert(meshData.indices.end(), {0, 1, 29999});
+        meshData.vertices.resize(meshData.vertices.size() + 30000);
+        meshData.offsets.emplace_back(3, 30000);
+    }
+
+    bool supported = Hardware::supportsElementIndexUint;
+
+    Hardware::supportsElementIndexUint = false;
+    auto batched = std::make_shared<TestMesh>(layout, GL_TRIANGLES);
+    batched->compile(meshData);
+    REQUIRE(batched->indexType() == GL_UNSIGNED_SHORT);
+    REQUIRE(batched->numBatches() == 2);
+    REQUIRE(batched->index(5) == 59999);
+    REQUIRE(batched->index(8) == 29999);
+
+    Hardware::supportsElementIndexUint = true;
+    auto single = std::make_shared<TestMesh>(layout, GL_TRIANGLES);
+    single->compile(meshData);
+    REQUIRE(single->indexType() == GL_UNSIGNED_INT);
+    REQUIRE(single->numBatches() == 1);
+    REQUIRE(single->index(8) == 89999);
+    REQUIRE(single->bufferSize() == batched->bufferSize() + 9 * 2);
+
+    Hardware::supportsElementIndexUint = supported;
+}
@@ -0,0 +1,101 @@
+#include "catch.hpp"
+
+#include "debug/metrics.h"
+#include "gl/gpuTimer.h"
+#include "gl/hardware.h"
+
+#include <thread>
+#include <vector>
+
+using namespace Tangram;
+
+#define TAGS "[Metrics]"
+
+using namespace std::chrono;
+
+TEST_CASE("Metrics are only recorded when enabled", TAGS) {
+    Metrics::collect(true);
+
+    Metrics::setEnabled(false);
+    { Metrics::Timer timer(Metrics::Stage::parse); }
+    Metrics::count(Metrics::Counter::tiles_built);
+
+    auto metrics = Metrics::collect(true);
+    CHECK(metrics.stages[Metrics::Stage::parse].count == 0);
+    CHECK(metrics.counters[Metrics::Counter::tiles_built] == 0);
+}
+
+TEST_CASE("Metrics of all threads are merged into histograms", TAGS) {
+    Metrics::collect(true);
+    Metrics::setEnabled(true);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++) {
+        threads.emplace_back([]() {
+            Metrics::record(Metrics::Stage::parse, microseconds(0));
+            Metrics::record(Metrics::Stage::parse, microseconds(3));
+            Metrics::record(Metrics::Stage::parse, seconds(10));
+            Metrics::recordStyle("lines", milliseconds(2));
+            Metrics::count(Metrics::Counter::tiles_built, 2);
+        });
+    }
+    for (auto& thread : threads) { thread.join(); }
+
+    // Recorded by this thread, which is still running
+    Metrics::count(Metrics::Counter::cache_hits);
+
+    auto metrics = Metrics::collect(true);
+    const auto& parse = metrics.stages[Metrics::Stage::parse];
+    CHECK(parse.count == 12);
+    CHECK(parse.buckets[0] == 4);
+    // 3us is below 2^2us
+    CHECK(parse.buckets[2] == 4);
+    CHECK(parse.buckets[MetricsHistogram::bucketCount - 1] == 4);
+    CHECK(parse.maxMs == Approx(10000));
+    CHECK(metrics.renderStyles["lines"].count == 4);
+    CHECK(metrics.renderStyles["lines"].totalMs == Approx(8));
+    CHECK(metrics.counters[Metrics::Counter::tiles_built] == 8);
+    CHECK(metrics.counters[Metrics::Counter::cache_hits] == 1);
+
+    // Reset by the previous collect
+    metrics = Metrics::collect(false);
+    CHECK(metrics.stages[Metrics::Stage::parse].count == 0);
+    CHECK(metrics.counters[Metrics::Counter::cache_hits] == 0);
+
+    Metrics::setEnabled(false);
+}
+
+TEST_CASE("GPU times of styles are recorded once their queries finish", TAGS) {
+    Metrics::collect(true);
+    Metrics::setEnabled(true);
+    Hardware::supportsTimerQuery = true;
+
+    GpuTimer timer;
+    CHECK(timer.begin(GpuTimer::Pass::style, "lines"));
+    // Only one query can be active
+    CHECK_FALSE(timer.begin(GpuTimer::Pass::style, "polygons"));
+    timer.end();
+    CHECK(timer.begin(GpuTimer::Pass::selection));
+    timer.end();
+    CHECK(timer.pendingQueries() == 2);
+
+    // The mock reports one millisecond for each query
+    timer.collect();
+    CHECK(timer.pendingQueries() == 0);
+
+    Metrics::countStyleDraws("lines", { 2, 600, 3 });
+    Metrics::countStyleDraws("lines", { 1, 6, 0 });
+
+    auto metrics = Metrics::collect(true);
+    CHECK(metrics.renderStylesGpu["lines"].count == 1);
+    CHECK(metrics.renderStylesGpu["lines"].totalMs == Approx(1));
+    CHECK(metrics.renderStylesGpu.count("polygons") == 0);
+    CHECK(metrics.selectionGpu.count == 1);
+    CHECK(metrics.renderStyleDraws["lines"].drawCalls == 3);
+    CHECK(metrics.renderStyleDraws["lines"].vertices == 606);
+    CHECK(metrics.renderStyleDraws["lines"].stateChanges == 3);
+
+    timer.clear();
+    Hardware::supportsTimerQuery = false;
+    Metrics::setEnabled(false);
+}
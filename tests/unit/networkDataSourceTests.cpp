@@ -1,6 +1,14 @@
 #include "catch.hpp"
 
+#include "data/memoryCacheDataSource.h"
 #include "data/networkDataSource.h"
+#include "gl/hardware.h"
+#include "mockPlatform.h"
+#include "tile/tileTask.h"
+#include "util/mapProjection.h"
+
+#include <condition_variable>
+#include <mutex>
 
 using namespace Tangram;
 
@@ -55,4 +63,366 @@ TEST_CASE("Build URL for tile from template", TAGS) {
         CHECK(NetworkDataSource::buildUrlForTile(TileID(0, 0, 1), url, urlOptions, 0) == "file://tiles/0.blah");
         CHECK(NetworkDataSource::buildUrlForTile(TileID(3, 5, 3), url, urlOptions, 0) == "file://tiles/213.blah");
     }
+
+    SECTION("Template with texture format") {
+        std::string url = "https://some.domain/{texture_format}/{z}/{x}/{y}";
+        bool etc2 = Hardware::supportsETC2;
+        bool astc = Hardware::supportsASTC;
+
+        Hardware::supportsETC2 = false;
+        Hardware::supportsASTC = false;
+        CHECK(NetworkDataSource::buildUrlForTile(TileID(0, 1, 2), url, urlOptions, 0) == "https://some.domain/png/2/0/1");
+
+        Hardware::supportsETC2 = true;
+        CHECK(NetworkDataSource::buildUrlForTile(TileID(0, 1, 2), url, urlOptions, 0) == "https://some.domain/etc2/2/0/1");
+
+        Hardware::supportsASTC = true;
+        CHECK(NetworkDataSource::buildUrlForTile(TileID(0, 1, 2), url, urlOptions, 0) == "https://some.domain/astc/2/0/1");
+
+        Hardware::supportsETC2 = etc2;
+        Hardware::supportsASTC = astc;
+    }
+
+    SECTION("Template with repeated and unknown placeholders") {
+        std::string url = "https://some.domain/{z}/{x}/{y}.json?key={key}&zoom={z}";
+
+        CHECK(NetworkDataSource::buildUrlForTile(TileID(0, 1, 2), url, urlOptions, 0) == "https://some.domain/2/0/1.json?key={key}&zoom=2");
+        CHECK(NetworkDataSource::buildUrlForTile(TileID(0, 1, 2), "{", urlOptions, 0) == "{");
+    }
+}
+
+// Completes URL requests only when respond() is called
+class DeferredPlatform : public MockPlatform {
+public:
+    bool startUrlRequestImpl(const Url& _url, const UrlRequestHandle _handle, UrlRequestId& _id) override {
+        return startConditionalUrlRequestImpl(_url, UrlValidators(), _handle, _id);
+    }
+    bool startConditionalUrlRequestImpl(const Url& _url, const UrlValidators& _validators,
+                                        const UrlRequestHandle _handle, UrlRequestId& _id) override {
+        requests.push_back(_handle);
+        validators.push_back(_validators);
+        _id = _handle;
+        return true;
+    }
+    void cancelUrlRequestImpl(const UrlRequestId _id) override {
+        canceled.push_back(_id);
+    }
+    void setUrlRequestPriorityImpl(const UrlRequestId _id, float _priority) override {
+        priorities.emplace_back(_id, _priority);
+    }
+    void respond(UrlRequestHandle _handle, std::string _content) {
+        UrlResponse response;
+        response.content.assign(_content.begin(), _content.end());
+        onUrlResponse(_handle, std::move(response));
+    }
+    void respond(UrlRequestHandle _handle, UrlResponse&& _response) {
+        onUrlResponse(_handle, std::move(_response));
+    }
+    std::vector<UrlRequestHandle> requests;
+    std::vector<UrlValidators> validators;
+    std::vector<UrlRequestId> canceled;
+    std::vector<std::pair<UrlRequestId, float>> priorities;
+};
+
+TEST_CASE("Share requests for the same URL between sources", TAGS) {
+    DeferredPlatform platform;
+    std::string url = "https://some.domain/tiles/{z}/{x}/{y}.mvt";
+
+    NetworkDataSource sourceA(platform, url, {});
+    NetworkDataSource sourceB(platform, url, {});
+
+    auto tileSource = std::make_shared<TileSource>("test", nullptr);
+    TileID tileId(1, 2, 3), otherTileId(1, 3, 3);
+    auto taskA = std::make_shared<BinaryTileTask>(tileId, tileSource);
+    auto taskB = std::make_shared<BinaryTileTask>(tileId, tileSource);
+    auto taskC = std::make_shared<BinaryTileTask>(otherTileId, tileSource);
+
+    int loaded = 0;
+    TileTaskCb callback{[&](std::shared_ptr<TileTask>) { loaded++; }};
+
+    SECTION("Both tasks get the data of one request") {
+        REQUIRE(sourceA.loadTileData(taskA, callback));
+        REQUIRE(sourceB.loadTileData(taskB, callback));
+        REQUIRE(platform.requests.size() == 1);
+
+        platform.respond(platform.requests[0], "tile");
+
+        CHECK(loaded == 2);
+        REQUIRE(taskA->rawTileData);
+        CHECK(taskA->rawTileData == taskB->rawTileData);
+        CHECK(std::string(taskA->tileData(), taskA->tileDataSize()) == "tile");
+    }
+
+    SECTION("The request is canceled with its last task") {
+        REQUIRE(sourceA.loadTileData(taskA, callback));
+        REQUIRE(sourceB.loadTileData(taskB, callback));
+        REQUIRE(sourceA.loadTileData(taskC, callback));
+        REQUIRE(platform.requests.size() == 2);
+
+        sourceA.cancelLoadingTile(*taskA);
+        CHECK(platform.canceled.empty());
+
+        sourceB.cancelLoadingTile(*taskB);
+        REQUIRE(platform.canceled.size() == 1);
+        CHECK(platform.canceled[0] == platform.requests[0]);
+
+        // A new request for the URL is not completed by the canceled one
+        auto taskD = std::make_shared<BinaryTileTask>(tileId, tileSource);
+        REQUIRE(sourceA.loadTileData(taskD, callback));
+        REQUIRE(platform.requests.size() == 3);
+
+        platform.respond(platform.requests[0], "old");
+        CHECK(loaded == 0);
+
+        platform.respond(platform.requests[2], "new");
+        CHECK(loaded == 1);
+        CHECK(std::string(taskD->tileData(), taskD->tileDataSize()) == "new");
+    }
+}
+
+TEST_CASE("Pass new tile priorities to the shared request", TAGS) {
+    DeferredPlatform platform;
+    std::string url = "https://some.domain/tiles/{z}/{x}/{y}.mvt";
+
+    NetworkDataSource sourceA(platform, url, {});
+    NetworkDataSource sourceB(platform, url, {});
+
+    auto tileSource = std::make_shared<TileSource>("test", nullptr);
+    TileID tileId(1, 2, 3);
+    auto taskA = std::make_shared<BinaryTileTask>(tileId, tileSource);
+    auto taskB = std::make_shared<BinaryTileTask>(tileId, tileSource);
+    taskA->setPriority(0);
+    taskB->setPriority(0);
+
+    TileTaskCb callback{[&](std::shared_ptr<TileTask>) {}};
+
+    REQUIRE(sourceA.loadTileData(taskA, callback));
+    REQUIRE(sourceB.loadTileData(taskB, callback));
+    REQUIRE(platform.requests.size() == 1);
+    REQUIRE(platform.priorities.size() == 1);
+    CHECK(platform.priorities[0].second == Approx(1.f));
+
+    // One tile away from the view center
+    double metersPerTile = MapProjection::metersPerTileAtZoom(tileId.z);
+    taskB->setPriority(metersPerTile * metersPerTile);
+    sourceB.updateTilePriority(*taskB);
+    REQUIRE(platform.priorities.size() == 2);
+    CHECK(platform.priorities[1].first == platform.requests[0]);
+    CHECK(platform.priorities[1].second == Approx(0.5f));
+
+    // Unchanged priorities are not passed on
+    sourceB.updateTilePriority(*taskB);
+    CHECK(platform.priorities.size() == 2);
+
+    // Nor are those of completed requests
+    platform.respond(platform.requests[0], "tile");
+    sourceA.updateTilePriority(*taskA);
+    CHECK(platform.priorities.size() == 2);
+}
+
+TEST_CASE("Revalidate expired tiles of the memory cache", TAGS) {
+    DeferredPlatform platform;
+    std::string url = "https://some.domain/tiles/{z}/{x}/{y}.mvt";
+
+    MemoryCacheDataSource cache;
+    cache.setCacheSize(1024);
+    cache.setNext(std::make_unique<NetworkDataSource>(platform, url, NetworkDataSource::UrlOptions()));
+
+    auto tileSource = std::make_shared<TileSource>("test", nullptr);
+    TileID tileId(1, 2, 3);
+
+    int loaded = 0;
+    TileTaskCb callback{[&](std::shared_ptr<TileTask>) { loaded++; }};
+
+    auto loadTile = [&]() {
+        auto task = std::make_shared<BinaryTileTask>(tileId, tileSource);
+        REQUIRE(cache.loadTileData(task, callback));
+        return task;
+    };
+    auto tileData = [](const std::shared_ptr<BinaryTileTask>& _task) {
+        return std::string(_task->tileData(), _task->tileDataSize());
+    };
+
+    // The response must be revalidated on the next request
+    loadTile();
+    REQUIRE(platform.requests.size() == 1);
+    CHECK(platform.validators[0].empty());
+
+    UrlResponse response;
+    response.content = { 'o', 'l', 'd' };
+    response.statusCode = 200;
+    response.validators.etag = "\"v1\"";
+    response.maxAge = 0;
+    platform.respond(platform.requests[0], std::move(response));
+    REQUIRE(loaded == 1);
+
+    auto task = loadTile();
+    REQUIRE(platform.requests.size() == 2);
+    CHECK(platform.validators[1].etag == "\"v1\"");
+
+    SECTION("A 304 response keeps the cached data for max-age") {
+        UrlResponse notModified;
+        notModified.statusCode = 304;
+        notModified.maxAge = 60;
+        platform.respond(platform.requests[1], std::move(notModified));
+
+        CHECK(loaded == 2);
+        CHECK(task->notModified);
+        CHECK(tileData(task) == "old");
+
+        auto cached = loadTile();
+        CHECK(platform.requests.size() == 2);
+        CHECK(loaded == 3);
+        CHECK(tileData(cached) == "old");
+    }
+
+    SECTION("A changed tile replaces the cached data") {
+        UrlResponse changed;
+        changed.content = { 'n', 'e', 'w' };
+        changed.statusCode = 200;
+        changed.validators.etag = "\"v2\"";
+        changed.maxAge = 60;
+        platform.respond(platform.requests[1], std::move(changed));
+
+        CHECK(loaded == 2);
+        CHECK(tileData(task) == "new");
+
+        auto cached = loadTile();
+        CHECK(platform.requests.size() == 2);
+        CHECK(tileData(cached) == "new");
+    }
+
+    SECTION("The expired data is used when the request fails") {
+        UrlResponse failed;
+        failed.error = "offline";
+        platform.respond(platform.requests[1], std::move(failed));
+
+        CHECK(loaded == 2);
+        CHECK(tileData(task) == "old");
+
+        // The data is still expired
+        loadTile();
+        CHECK(platform.requests.size() == 3);
+    }
+}
+
+TEST_CASE("Load compressed tiles from the memory cache", TAGS) {
+    DeferredPlatform platform;
+    std::string url = "https://some.domain/tiles/{z}/{x}/{y}.mvt";
+
+    MemoryCacheDataSource cache;
+    cache.setCacheSize(1024);
+    cache.setCompression(true);
+    cache.setNext(std::make_unique<NetworkDataSource>(platform, url, NetworkDataSource::UrlOptions()));
+
+    auto tileSource = std::make_shared<TileSource>("test", nullptr);
+    TileID tileId(1, 2, 3);
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    int loaded = 0;
+    TileTaskCb callback{[&](std::shared_ptr<TileTask>) {
+        std::lock_guard<std::mutex> lock(mutex);
+        loaded++;
+        condition.notify_all();
+    }};
+
+    // Larger than the cache size, but not when compressed
+    std::string content(4096, 'a');
+
+    auto task = std::make_shared<BinaryTileTask>(tileId, tileSource);
+    REQUIRE(cache.loadTileData(task, callback));
+    REQUIRE(platform.requests.size() == 1);
+    platform.respond(platform.requests[0], content);
+    REQUIRE(loaded == 1);
+
+    auto cached = std::make_shared<BinaryTileTask>(tileId, tileSource);
+    REQUIRE(cache.loadTileData(cached, callback));
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [&]{ return loaded == 2; });
+    }
+    CHECK(platform.requests.size() == 1);
+    REQUIRE(cached->hasData());
+    CHECK(std::string(cached->tileData(), cached->tileDataSize()) == content);
+}
+
+TEST_CASE("Copy the memory cache of a source of a previous scene", TAGS) {
+    DeferredPlatform platform;
+    std::string url = "https://some.domain/tiles/{z}/{x}/{y}.mvt";
+
+    auto createCache = [&]() {
+        auto cache = std::make_unique<MemoryCacheDataSource>();
+        cache->setCacheSize(1024);
+        cache->setNext(std::make_unique<NetworkDataSource>(platform, url, NetworkDataSource::UrlOptions()));
+        return cache;
+    };
+    auto previous = createCache();
+    auto cache = createCache();
+
+    auto tileSource = std::make_shared<TileSource>("test", nullptr);
+    TileID tileId(1, 2, 3);
+
+    int loaded = 0;
+    TileTaskCb callback{[&](std::shared_ptr<TileTask>) { loaded++; }};
+
+    auto task = std::make_shared<BinaryTileTask>(tileId, tileSource);
+    REQUIRE(previous->loadTileData(task, callback));
+    REQUIRE(platform.requests.size() == 1);
+    platform.respond(platform.requests[0], "tile");
+    REQUIRE(loaded == 1);
+
+    cache->copyCache(*previous);
+    CHECK(cache->memoryUsage() == 4);
+
+    // The data stays in the copy when the previous source is cleared
+    previous->clear();
+
+    auto cached = std::make_shared<BinaryTileTask>(tileId, tileSource);
+    REQUIRE(cache->loadTileData(cached, callback));
+    CHECK(platform.requests.size() == 1);
+    CHECK(loaded == 2);
+    CHECK(std::string(cached->tileData(), cached->tileDataSize()) == "tile");
+}
+
+TEST_CASE("Share the memory cache with the sources of other maps", TAGS) {
+    DeferredPlatform platform;
+    std::string url = "https://shared.domain/tiles/{z}/{x}/{y}.mvt";
+
+    auto createCache = [&]() {
+        auto cache = std::make_unique<MemoryCacheDataSource>();
+        cache->setCacheSize(1024);
+        cache->setSharedCache(url);
+        cache->setNext(std::make_unique<NetworkDataSource>(platform, url, NetworkDataSource::UrlOptions()));
+        return cache;
+    };
+
+    auto tileSource = std::make_shared<TileSource>("test", nullptr);
+    TileID tileId(1, 2, 3);
+
+    int loaded = 0;
+    TileTaskCb callback{[&](std::shared_ptr<TileTask>) { loaded++; }};
+
+    {
+        auto first = createCache();
+        auto task = std::make_shared<BinaryTileTask>(tileId, tileSource);
+        REQUIRE(first->loadTileData(task, callback));
+        REQUIRE(platform.requests.size() == 1);
+        platform.respond(platform.requests[0], "tile");
+        REQUIRE(loaded == 1);
+    }
+
+    // The cache outlives the source that filled it
+    auto cache = createCache();
+    auto cached = std::make_shared<BinaryTileTask>(tileId, tileSource);
+    REQUIRE(cache->loadTileData(cached, callback));
+    CHECK(platform.requests.size() == 1);
+    CHECK(loaded == 2);
+    CHECK(std::string(cached->tileData(), cached->tileDataSize()) == "tile");
+
+    // Caches that no source uses are dropped when memory is released
+    size_t caches = MemoryCacheDataSource::sharedCacheCount();
+    cache.reset();
+    MemoryCacheDataSource::releaseSharedCaches();
+    CHECK(MemoryCacheDataSource::sharedCacheCount() < caches);
 }
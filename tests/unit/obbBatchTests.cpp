@@ -0,0 +1,65 @@
+#include "catch.hpp"
+
+#include "labels/obbBatch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+using namespace Tangram;
+
+#define TAGS "[OBBBatch]"
+
+using OBB = OBBBatch::OBB;
+
+static OBB randomOBB() {
+    float angle = rand() / float(RAND_MAX) * 6.28f;
+    glm::vec2 center(rand() % 512, rand() % 512);
+    return OBB(center, {std::cos(angle), std::sin(angle)}, 5 + rand() % 60, 5 + rand() % 20);
+}
+
+TEST_CASE("OBBBatch matches the pairwise OBB intersection", TAGS) {
+    srand(0);
+
+    std::vector<OBB> obbs;
+    OBBBatch batch;
+    for (size_t i = 0; i < 512; i++) {
+        obbs.push_back(randomOBB());
+        batch.set(i, obbs.back());
+    }
+    REQUIRE(batch.size() == obbs.size());
+
+    for (int n = 0; n < 4096; n++) {
+        OBB obb = randomOBB();
+        auto query = OBBBatch::query(obb);
+
+        size_t begin = rand() % obbs.size();
+        size_t end = std::min(obbs.size(), begin + rand() % 11);
+
+        bool expected = false;
+        std::vector<uint32_t> indices;
+        for (size_t i = begin; i < end; i++) {
+            CHECK(batch.intersects(query, i) == intersect(obb, obbs[i]));
+            expected |= intersect(obb, obbs[i]);
+            indices.insert(indices.begin(), i);
+        }
+
+        CHECK(batch.intersectsAny(query, begin, end) == expected);
+        CHECK(batch.intersectsAny(query, indices.data(), indices.size()) == expected);
+    }
+}
+
+TEST_CASE("OBBBatch is refilled after clear", TAGS) {
+    OBBBatch batch;
+    batch.set(3, OBB({0, 0}, {1, 0}, 10, 10));
+    CHECK(batch.size() == 4);
+
+    batch.clear();
+    CHECK(batch.size() == 0);
+
+    batch.set(0, OBB({100, 100}, {1, 0}, 10, 10));
+    auto query = OBBBatch::query(OBB({0, 0}, {1, 0}, 10, 10));
+    CHECK(batch.size() == 1);
+    CHECK(batch.intersectsAny(query, 0, batch.size()) == false);
+}
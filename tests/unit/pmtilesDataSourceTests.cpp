@@ -0,0 +1,130 @@
+#include "catch.hpp"
+
+#include "data/pmtilesDataSource.h"
+#include "mockPlatform.h"
+#include "tile/tileTask.h"
+
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+
+using namespace Tangram;
+
+#define TAGS "[PMTilesDataSource]"
+
+static void writeUint64(std::string& _out, size_t _pos, uint64_t _value) {
+    for (int i = 0; i < 8; i++) { _out[_pos + i] = char((_value >> (8 * i)) & 0xff); }
+}
+
+static void writeVarint(std::string& _out, uint64_t _value) {
+    while (_value >= 0x80) {
+        _out += char((_value & 0x7f) | 0x80);
+        _value >>= 7;
+    }
+    _out += char(_value);
+}
+
+struct TestEntry { uint64_t tileId, offset, length, runLength; };
+
+static std::string encodeDirectory(const std::vector<TestEntry>& _entries) {
+    std::string out;
+    writeVarint(out, _entries.size());
+    uint64_t lastId = 0;
+    for (auto& e : _entries) { writeVarint(out, e.tileId - lastId); lastId = e.tileId; }
+    for (auto& e : _entries) { writeVarint(out, e.runLength); }
+    for (auto& e : _entries) { writeVarint(out, e.length); }
+    for (auto& e : _entries) { writeVarint(out, e.offset + 1); }
+    return out;
+}
+
+// Uncompressed archive with a root directory, one leaf directory and _tiles
+static std::string writeArchive(const std::vector<TestEntry>& _root, const std::vector<TestEntry>& _leaf,
+                                const std::string& _tiles) {
+    std::string root = encodeDirectory(_root);
+    std::string leaf = encodeDirectory(_leaf);
+
+    std::string header(127, '\0');
+    header.replace(0, 7, "PMTiles");
+    header[7] = 3;
+    writeUint64(header, 8, 127);
+    writeUint64(header, 16, root.size());
+    writeUint64(header, 40, 127 + root.size());
+    writeUint64(header, 48, leaf.size());
+    writeUint64(header, 56, 127 + root.size() + leaf.size());
+    writeUint64(header, 64, _tiles.size());
+    header[97] = 1; // no directory compression
+    header[98] = 1; // no tile compression
+
+    std::string path = "pmtilesDataSourceTest.pmtiles";
+    std::ofstream file(path, std::ofstream::binary);
+    file << header << root << leaf << _tiles;
+    return path;
+}
+
+static std::string loadTile(PMTilesDataSource& _source, TileID _tileId) {
+    TileID id = _tileId;
+    auto task = std::make_shared<BinaryTileTask>(id, std::make_shared<TileSource>("test", nullptr));
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool done = false;
+
+    bool started = _source.loadTileData(task, {[&](std::shared_ptr<TileTask>) {
+        std::lock_guard<std::mutex> lock(mutex);
+        done = true;
+        condition.notify_all();
+    }});
+    REQUIRE(started);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    condition.wait(lock, [&]{ return done; });
+
+    if (!task->hasData()) { return ""; }
+    return std::string(task->tileData(), task->tileDataSize());
+}
+
+TEST_CASE("Compute Hilbert tile index", TAGS) {
+    CHECK(PMTilesDataSource::tileIndex(TileID(0, 0, 0)) == 0);
+    CHECK(PMTilesDataSource::tileIndex(TileID(0, 0, 1)) == 1);
+    CHECK(PMTilesDataSource::tileIndex(TileID(0, 1, 1)) == 2);
+    CHECK(PMTilesDataSource::tileIndex(TileID(1, 1, 1)) == 3);
+    CHECK(PMTilesDataSource::tileIndex(TileID(1, 0, 1)) == 4);
+    CHECK(PMTilesDataSource::tileIndex(TileID(0, 0, 2)) == 5);
+
+    // Each index of a zoom level is used once and consecutive tiles are neighbors
+    int z = 4, n = 1 << z;
+    uint64_t first = PMTilesDataSource::tileIndex(TileID(0, 0, z));
+    std::vector<TileID> tiles(n * n, TileID(-1, -1, -1));
+    for (int x = 0; x < n; x++) {
+        for (int y = 0; y < n; y++) {
+            uint64_t index = PMTilesDataSource::tileIndex(TileID(x, y, z)) - first;
+            REQUIRE(index < tiles.size());
+            REQUIRE(tiles[index].x == -1);
+            tiles[index] = TileID(x, y, z);
+        }
+    }
+    for (size_t i = 1; i < tiles.size(); i++) {
+        REQUIRE(std::abs(tiles[i].x - tiles[i-1].x) + std::abs(tiles[i].y - tiles[i-1].y) == 1);
+    }
+}
+
+TEST_CASE("Read tiles from a PMTiles archive", TAGS) {
+    MockPlatform platform;
+
+    // Tile 0: "a", tiles 1-2: "bb" (run of 2), tile 5 in a leaf directory: "ccc"
+    std::vector<TestEntry> leaf = {{5, 3, 3, 1}};
+    uint64_t leafLength = encodeDirectory(leaf).size();
+    std::string path = writeArchive({{0, 0, 1, 1}, {1, 1, 2, 2}, {5, 0, leafLength, 0}}, leaf, "abbccc");
+
+    PMTilesDataSource source(platform, path);
+
+    CHECK(loadTile(source, TileID(0, 0, 0)) == "a");
+    CHECK(loadTile(source, TileID(0, 0, 1)) == "bb");
+    CHECK(loadTile(source, TileID(0, 1, 1)) == "bb");
+    CHECK(loadTile(source, TileID(1, 1, 1)) == "");
+    CHECK(loadTile(source, TileID(0, 0, 2)) == "ccc");
+    CHECK(loadTile(source, TileID(1, 0, 2)) == "");
+
+    std::remove(path.c_str());
+}
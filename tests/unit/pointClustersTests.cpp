@@ -0,0 +1,75 @@
+#include "catch.hpp"
+
+#include "data/pointClusters.h"
+
+#include <random>
+
+using namespace Tangram;
+
+static uint32_t countPoints(const std::vector<PointClusters::Cluster>& _clusters) {
+    uint32_t count = 0;
+    for (const auto& cluster : _clusters) { count += cluster.count; }
+    return count;
+}
+
+TEST_CASE("Points close to each other are clustered at low zooms", "[PointClusters]") {
+    std::vector<double> lngLats = {
+        10.0, 20.0,
+        10.0001, 20.0001,
+        -100.0, -40.0,
+    };
+    PointClusters::Options options;
+    options.maxZoom = 10;
+    PointClusters clusters(lngLats, options);
+
+    std::vector<PointClusters::Cluster> tile;
+    clusters.getTile(TileID(0, 0, 0), tile);
+
+    REQUIRE(tile.size() == 2);
+    REQUIRE(countPoints(tile) == 3);
+    for (const auto& cluster : tile) {
+        REQUIRE(cluster.x >= 0.0);
+        REQUIRE(cluster.x <= 1.0);
+        REQUIRE(cluster.y >= 0.0);
+        REQUIRE(cluster.y <= 1.0);
+        if (cluster.count == 1) { REQUIRE(cluster.point == 2); }
+    }
+
+    // Above the max zoom each point is drawn alone
+    tile.clear();
+    int x = int((10.0 / 360.0 + 0.5) * (1 << 11));
+    int y = int((0.5 - std::log(std::tan(M_PI / 4 + 20.0 * M_PI / 360.0)) / (2 * M_PI)) * (1 << 11));
+    clusters.getTile(TileID(x, y, 11), tile);
+    REQUIRE(tile.size() == 2);
+    REQUIRE(tile[0].count == 1);
+    REQUIRE(tile[1].count == 1);
+}
+
+TEST_CASE("Each point is in one cluster of one tile at each zoom", "[PointClusters]") {
+    std::mt19937 random(1);
+    std::uniform_real_distribution<double> lng(-20.0, 20.0);
+    std::uniform_real_distribution<double> lat(-20.0, 20.0);
+
+    std::vector<double> lngLats;
+    for (int i = 0; i < 5000; i++) {
+        lngLats.push_back(lng(random));
+        lngLats.push_back(lat(random));
+    }
+    PointClusters::Options options;
+    options.maxZoom = 8;
+    PointClusters clusters(lngLats, options);
+
+    for (int z = 0; z <= 4; z++) {
+        std::vector<PointClusters::Cluster> tiles;
+        int n = 1 << z;
+        for (int x = 0; x < n; x++) {
+            for (int y = 0; y < n; y++) {
+                clusters.getTile(TileID(x, y, z), tiles);
+            }
+        }
+        REQUIRE(countPoints(tiles) == 5000);
+
+        // Fewer clusters at lower zooms
+        if (z < 2) { REQUIRE(tiles.size() < 100); }
+    }
+}
@@ -0,0 +1,129 @@
+#include "catch.hpp"
+
+#include "gl/hardware.h"
+#include "scene/qualityProfile.h"
+#include "scene/sceneLoader.h"
+
+using namespace Tangram;
+
+#define TAGS "[QualityProfile]"
+
+TEST_CASE("QualityProfile selects the tier of the GL limits", TAGS) {
+    auto maxTextureSize = Hardware::maxTextureSize;
+    auto maxVertexUniformVectors = Hardware::maxVertexUniformVectors;
+    auto isGLES = Hardware::isGLES;
+    auto supportsUniformBuffers = Hardware::supportsUniformBuffers;
+
+    Hardware::maxTextureSize = 0;
+    CHECK(QualityProfile::hardwareTier() == QualityTier::high);
+
+    Hardware::maxTextureSize = 2048;
+    Hardware::maxVertexUniformVectors = 256;
+    CHECK(QualityProfile::hardwareTier() == QualityTier::low);
+    CHECK(QualityProfile::forTier(QualityTier::automatic).tier == QualityTier::low);
+
+    Hardware::maxTextureSize = 4096;
+    Hardware::isGLES = true;
+    Hardware::supportsUniformBuffers = false;
+    CHECK(QualityProfile::hardwareTier() == QualityTier::medium);
+
+    Hardware::supportsUniformBuffers = true;
+    CHECK(QualityProfile::hardwareTier() == QualityTier::high);
+
+    Hardware::maxTextureSize = maxTextureSize;
+    Hardware::maxVertexUniformVectors = maxVertexUniformVectors;
+    Hardware::isGLES = isGLES;
+    Hardware::supportsUniformBuffers = supportsUniformBuffers;
+}
+
+TEST_CASE("QualityProfile lowers tiers down to low", TAGS) {
+    CHECK(QualityProfile::lowerTier(QualityTier::high) == QualityTier::medium);
+    CHECK(QualityProfile::lowerTier(QualityTier::medium) == QualityTier::low);
+    CHECK(QualityProfile::lowerTier(QualityTier::low) == QualityTier::low);
+
+    auto high = QualityProfile::forTier(QualityTier::high);
+    CHECK(!high.vertexLighting);
+    CHECK(high.extrusion);
+    CHECK(high.labelDensity == 0);
+    CHECK(high.sceneUpdates(YAML::Load("sources: { r: { type: Raster } }")).empty());
+}
+
+TEST_CASE("QualityProfile applies the settings of lowMemory scenes", TAGS) {
+    SceneOptions options{Url("scene.yaml")};
+    options.qualityTier = QualityTier::automatic;
+    options.numTileWorkers = 4;
+    options.numLayerWorkers = 2;
+
+    QualityProfile::applyLowMemory(options);
+    CHECK(options.qualityTier == QualityTier::automatic);
+    CHECK(options.numTileWorkers == 4);
+
+    options.lowMemory = true;
+    QualityProfile::applyLowMemory(options);
+    CHECK(options.qualityTier == QualityTier::low);
+    CHECK(options.numTileWorkers == 1);
+    CHECK(options.numLayerWorkers == 0);
+    CHECK(options.memoryTileCacheSize == QualityProfile::low_memory_cache_size);
+    CHECK(options.compressMemoryTileCache);
+
+    options.memoryTileCacheSize = 1024;
+    QualityProfile::applyLowMemory(options);
+    CHECK(options.memoryTileCacheSize == 1024);
+}
+
+TEST_CASE("QualityProfile updates extrusion and raster sources of the scene", TAGS) {
+    YAML::Node config = YAML::Load(R"END(
+        sources:
+            tiles: { type: MVT, url: a }
+            satellite: { type: Raster, url: b, zoom_offset: 1 }
+            hillshade: { type: Raster, url: c }
+        styles:
+            buildings: { base: polygons, draw: { extrude: true } }
+        layers:
+            landuse:
+                draw: { polygons: { color: green } }
+            buildings:
+                data: { source: tiles }
+                draw: { polygons: { extrude: true } }
+                tall:
+                    filter: { height: { min: 100 } }
+                    draw:
+                        polygons:
+                            extrude: [10, 100]
+                        lines: { width: 1px }
+    )END");
+
+    auto updates = QualityProfile::forTier(QualityTier::low).sceneUpdates(config);
+
+    std::map<std::string, std::string> values;
+    for (auto& update : updates) { values[update.path] = update.value; }
+
+    CHECK(values.size() == 5);
+    CHECK(values["layers.buildings.draw.polygons.extrude"] == "false");
+    CHECK(values["layers.buildings.tall.draw.polygons.extrude"] == "false");
+    CHECK(values["styles.buildings.draw.extrude"] == "false");
+    CHECK(values["sources.satellite.zoom_offset"] == "2");
+    CHECK(values["sources.hillshade.zoom_offset"] == "1");
+
+    REQUIRE(SceneLoader::applyUpdates(config, updates).error == Error::none);
+    CHECK(config["sources"]["hillshade"]["zoom_offset"].Scalar() == "1");
+    CHECK(config["layers"]["buildings"]["tall"]["draw"]["polygons"]["extrude"].Scalar() == "false");
+}
+
+TEST_CASE("QualityMonitor reports windows of slow frames", TAGS) {
+    QualityMonitor monitor;
+
+    for (uint32_t i = 0; i < QualityMonitor::window_frames; i++) {
+        CHECK(!monitor.addFrameTime(10.f));
+    }
+    for (uint32_t i = 1; i < QualityMonitor::window_frames; i++) {
+        CHECK(!monitor.addFrameTime(30.f));
+    }
+    CHECK(monitor.addFrameTime(30.f));
+
+    // A target frame time replaces the default threshold
+    for (uint32_t i = 1; i < QualityMonitor::window_frames; i++) {
+        monitor.addFrameTime(30.f, 40.f);
+    }
+    CHECK(!monitor.addFrameTime(30.f, 40.f));
+}
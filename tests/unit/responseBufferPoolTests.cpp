@@ -0,0 +1,72 @@
+#include "catch.hpp"
+
+#include "util/responseBufferPool.h"
+
+using namespace Tangram;
+
+TEST_CASE("ResponseBufferPool reuses released buffers", "[Core][ResponseBufferPool]") {
+    ResponseBufferPool pool;
+
+    auto buffer = pool.acquire(1000);
+    REQUIRE(buffer.empty());
+    REQUIRE(buffer.capacity() >= 1000);
+    const char* data = buffer.data();
+
+    buffer.resize(500);
+    pool.release(std::move(buffer));
+    REQUIRE(pool.size() == 1);
+
+    auto reused = pool.acquire(100);
+    REQUIRE(reused.empty());
+    REQUIRE(reused.data() == data);
+    REQUIRE(pool.size() == 0);
+}
+
+TEST_CASE("ResponseBufferPool prefers a buffer that is large enough", "[Core][ResponseBufferPool]") {
+    ResponseBufferPool pool;
+
+    auto large = pool.acquire(4000);
+    auto small = pool.acquire(100);
+    const char* largeData = large.data();
+
+    pool.release(std::move(large));
+    pool.release(std::move(small));
+
+    auto buffer = pool.acquire(2000);
+    REQUIRE(buffer.data() == largeData);
+    REQUIRE(pool.size() == 1);
+}
+
+TEST_CASE("ResponseBufferPool limits the buffers it keeps", "[Core][ResponseBufferPool]") {
+    ResponseBufferPool pool;
+
+    pool.release(std::vector<char>());
+    pool.release(std::vector<char>(ResponseBufferPool::max_capacity + 1));
+    REQUIRE(pool.size() == 0);
+
+    for (size_t i = 0; i < ResponseBufferPool::max_buffers + 4; i++) {
+        pool.release(std::vector<char>(100));
+    }
+    REQUIRE(pool.size() == ResponseBufferPool::max_buffers);
+
+    pool.clear();
+    REQUIRE(pool.size() == 0);
+}
+
+TEST_CASE("ResponseBufferPool takes back shared content once it is released", "[Core][ResponseBufferPool]") {
+    ResponseBufferPool pool;
+
+    std::vector<char> content(300, 'x');
+    const char* data = content.data();
+
+    auto shared = pool.share(std::move(content));
+    auto other = shared;
+    REQUIRE(shared->size() == 300);
+
+    shared.reset();
+    REQUIRE(pool.size() == 0);
+
+    other.reset();
+    REQUIRE(pool.size() == 1);
+    REQUIRE(pool.acquire().data() == data);
+}
@@ -0,0 +1,65 @@
+#include "catch.hpp"
+
+#include "scene/sceneBinary.h"
+#include "sceneOptions.h"
+
+#include "yaml-cpp/yaml.h"
+
+using namespace Tangram;
+
+#define TAGS "[SceneBinary]"
+
+TEST_CASE("Precompiled scene restores the config", TAGS) {
+    auto config = YAML::Load(R"END(
+        global:
+            width: 2px
+        textures:
+            pois:
+                url: "file:///root/res/pois.png"
+        layers:
+            roads:
+                filter:
+                    kind:
+                        - highway
+                        - major_road
+                draw:
+                    lines:
+                        color: 'red'
+                        width: function() { return 1; }
+        empty: ~
+    )END");
+
+    SceneOptions options(Url("file:///root/res/scene.yaml"));
+    options.updates.emplace_back("global.width", "4px");
+    uint64_t hash = SceneBinary::sourceHash(options);
+
+    auto data = SceneBinary::write(config, hash, options.url);
+
+    auto restored = SceneBinary::read(data, hash, options.url);
+    REQUIRE(restored.IsMap());
+    CHECK(YAML::Dump(restored) == YAML::Dump(config));
+    CHECK(restored["layers"]["roads"]["draw"]["lines"]["color"].Tag() == "!");
+    CHECK(restored["empty"].IsNull());
+
+    // Scene URLs are rebased to the directory the scene is loaded from
+    auto rebased = SceneBinary::read(data, hash, Url("asset:///scene.yaml"));
+    REQUIRE(rebased.IsMap());
+    CHECK(rebased["textures"]["pois"]["url"].Scalar() == "asset:///pois.png");
+}
+
+TEST_CASE("Precompiled scene is rejected for other updates or invalid data", TAGS) {
+    auto config = YAML::Load("a: [1, 2, 3]");
+
+    SceneOptions options(Url("file:///root/scene.yaml"));
+    auto data = SceneBinary::write(config, SceneBinary::sourceHash(options), options.url);
+
+    options.updates.emplace_back("a", "[4]");
+    CHECK(!SceneBinary::read(data, SceneBinary::sourceHash(options), options.url));
+
+    options.updates.clear();
+    uint64_t hash = SceneBinary::sourceHash(options);
+    CHECK(SceneBinary::read(data, hash, options.url));
+
+    data.resize(data.size() - 1);
+    CHECK(!SceneBinary::read(data, hash, options.url));
+}
@@ -67,7 +67,7 @@ struct ImportMockPlatform : public MockPlatform {
         )END");
 
         putMockUrlContents(Url("/root/imports/urls.yaml"), R"END(
-            fonts: { fontB: [ { url: fonts/0.ttf }, { url: fonts/1.ttf } ] }
+            fonts: { fontB: [ { url: fonts/0.ttf, fields: fonts/0.fields }, { url: fonts/1.ttf } ] }
             sources: { sourceB: { url: "tiles/{z}/{y}/{x}.mvt" } }
             textures:
                 tex3: { url: "in_imports.png" }
@@ -186,6 +186,7 @@ TEST_CASE("Scene URLs are resolved against their parent during import", "[import
     CHECK(root["fonts"]["fontA"]["url"].Scalar() == "https://host/font.woff");
     CHECK(root["fonts"]["fontB"][0]["url"].Scalar() == "/root/imports/fonts/0.ttf");
     CHECK(root["fonts"]["fontB"][1]["url"].Scalar() == "/root/imports/fonts/1.ttf");
+    CHECK(root["fonts"]["fontB"][0]["fields"].Scalar() == "/root/imports/fonts/0.fields");
 
     // We don't explicitly check that import URLs are resolved correctly because if they were not,
     // the scenes wouldn't be loaded and merged; i.e. we already test it implicitly.
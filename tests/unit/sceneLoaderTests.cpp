@@ -1,9 +1,12 @@
 #include "catch.hpp"
 
+#include "gl/hardware.h"
+#include "gl/shaderSource.h"
 #include "mockPlatform.h"
 #include "scene/pointLight.h"
 #include "scene/scene.h"
 #include "scene/sceneLoader.h"
+#include "sceneOptions.h"
 #include "style/material.h"
 #include "style/polylineStyle.h"
 #include "style/polygonStyle.h"
@@ -51,6 +54,27 @@ TEST_CASE("Correctly instantiate a style from a YAML configuration") {
     REQUIRE(styles[2]->getMaterial().hasSpecular() == false);
 }
 
+TEST_CASE("Parse the render mode of a style") {
+
+    PolygonStyle style("buildings");
+    SceneTextures textures;
+
+    REQUIRE(style.renderMode() == RenderMode::standard);
+    REQUIRE(style.drawsFrontToBack() == false);
+
+    SceneLoader::loadStyleProps(YAML::Load("render_mode: depth_prepass"), style, textures);
+
+    REQUIRE(style.renderMode() == RenderMode::depth_prepass);
+    REQUIRE(style.drawsFrontToBack() == true);
+
+    // Only opaque styles are drawn front to back
+    SceneLoader::loadStyleProps(YAML::Load("{ blend: translucent, render_mode: front_to_back }"),
+                                style, textures);
+
+    REQUIRE(style.renderMode() == RenderMode::front_to_back);
+    REQUIRE(style.drawsFrontToBack() == false);
+}
+
 TEST_CASE("Test light parameter parsing") {
     YAML::Node node = YAML::Load("position: [100px, 0, 20m]");
 
@@ -66,3 +90,35 @@ TEST_CASE("Test light parameter parsing") {
     REQUIRE(pos.units[1] == Unit::meter);
     REQUIRE(pos.units[2] == Unit::meter);
 }
+
+TEST_CASE("Shader blocks stay GLSL 1.00 unless the scene opts into uniform blocks") {
+    MockPlatform platform;
+
+    auto supportsUniformBuffers = Hardware::supportsUniformBuffers;
+    Hardware::supportsUniformBuffers = true;
+
+    // 'texture' is a built-in function in GLSL ES 3.00 and GLSL 1.40
+    const std::string block = "vec4 texture = color;\ncolor = texture;\n";
+
+    {
+        Scene scene(platform);
+        PolygonStyle style("custom");
+        style.getShaderSource().addSourceBlock("color", block);
+        style.build(scene);
+
+        auto source = style.getShaderSource().buildFragmentSource();
+        CHECK(source.find("#version") == std::string::npos);
+        CHECK(source.find(block) != std::string::npos);
+    }
+    {
+        SceneOptions options;
+        options.uniformBlocks = true;
+        Scene scene(platform, std::move(options));
+        PolygonStyle style("custom");
+        style.build(scene);
+
+        CHECK(style.getShaderSource().buildFragmentSource().find("#version") != std::string::npos);
+    }
+
+    Hardware::supportsUniformBuffers = supportsUniformBuffers;
+}
@@ -231,3 +231,120 @@ TEST_CASE("Scene update statuses") {
         CHECK(SceneLoader::applyUpdates(config, updates).error == Error::scene_update_value_yaml_syntax_error);
     }
 }
+
+const static std::string diffSceneString = R"END(
+sources:
+    osm: { type: MVT, url: "https://tiles/{z}/{x}/{y}.mvt" }
+    other: { type: GeoJSON, url: "https://tiles/{z}/{x}/{y}.json" }
+styles:
+    water:
+        base: polygons
+        shaders:
+            uniforms:
+                u_tint: [1, 1, 1]
+        material:
+            diffuse: [1, 1, 1]
+        draw:
+            order: 1
+lights:
+    sun:
+        type: directional
+        origin: world
+        direction: [1, 1, -1]
+        diffuse: white
+layers:
+    water:
+        data: { source: osm }
+        filter: { kind: ocean }
+        draw: { water: { color: blue } }
+    roads:
+        data: { source: other }
+        draw: { lines: { color: white, width: 2px } }
+)END";
+
+TEST_CASE("Classify the differences of updated scene configs") {
+    Node current;
+    REQUIRE(loadConfig(diffSceneString, current));
+
+    auto diff = [&](std::vector<SceneUpdate> _updates) {
+        Node updated = YAML::Clone(current);
+        REQUIRE(SceneLoader::applyUpdates(updated, _updates).error == Error::none);
+        return SceneLoader::diffConfig(current, updated);
+    };
+
+    {
+        auto changes = diff({});
+        CHECK(!changes.reload);
+        CHECK(changes.uniforms.empty());
+        CHECK(changes.layers.empty());
+        CHECK(changes.sources.empty());
+    }
+    {
+        auto changes = diff({{"styles.water.shaders.uniforms.u_tint", "[1, 0, 0]"}});
+        CHECK(!changes.reload);
+        REQUIRE(changes.uniforms.size() == 1);
+        CHECK(changes.uniforms[0] == "water");
+        CHECK(changes.styleParams.empty());
+        CHECK(changes.layerSources.empty());
+    }
+    {
+        auto changes = diff({{"styles.water.shaders.uniforms.u_shade", "0.5"}});
+        CHECK(changes.reload);
+    }
+    {
+        auto changes = diff({{"styles.water.draw.order", "2"}});
+        CHECK(!changes.reload);
+        REQUIRE(changes.styleParams.size() == 1);
+        CHECK(changes.styleParams[0] == "water");
+    }
+    {
+        auto changes = diff({{"styles.water.base", "lines"}});
+        CHECK(changes.reload);
+    }
+    {
+        auto changes = diff({{"styles.water.material.diffuse", "[0.5, 0.5, 1]"}});
+        CHECK(!changes.reload);
+        REQUIRE(changes.materials.size() == 1);
+        CHECK(changes.materials[0] == "water");
+    }
+    {
+        auto changes = diff({{"styles.water.material.diffuse", "{ texture: noise }"}});
+        CHECK(changes.reload);
+    }
+    {
+        auto changes = diff({{"lights.sun.direction", "[0, 1, -1]"}, {"lights.sun.diffuse", "gray"}});
+        CHECK(!changes.reload);
+        REQUIRE(changes.lights.size() == 1);
+        CHECK(changes.lights[0] == "sun");
+    }
+    {
+        auto changes = diff({{"lights.sun.type", "ambient"}});
+        CHECK(changes.reload);
+    }
+    {
+        auto changes = diff({{"layers.water.filter.kind", "lake"}});
+        CHECK(!changes.reload);
+        REQUIRE(changes.layers.size() == 1);
+        CHECK(changes.layers[0] == "water");
+        CHECK(changes.layerSources == std::set<std::string>{"osm"});
+    }
+    {
+        // The source of the other layer would not generate geometry anymore
+        auto changes = diff({{"layers.roads.enabled", "false"}});
+        CHECK(changes.reload);
+    }
+    {
+        auto changes = diff({{"layers.roads.data.source", "osm"}});
+        CHECK(changes.reload);
+    }
+    {
+        auto changes = diff({{"sources.other.url", "https://other/{z}/{x}/{y}.json"}});
+        CHECK(!changes.reload);
+        REQUIRE(changes.sources.size() == 1);
+        CHECK(changes.sources[0] == "other");
+    }
+    {
+        auto changes = diff({{"scene", "{ background: { color: red } }"}});
+        CHECK(changes.reload);
+    }
+}
@@ -0,0 +1,60 @@
+#include "catch.hpp"
+
+#include "data/propertyItem.h"
+#include "selection/selectionFeatures.h"
+
+using namespace Tangram;
+
+TEST_CASE("SelectionFeatures share keys and values between features", "[Core][SelectionFeatures]") {
+    Properties a;
+    a.set("kind", "cafe");
+    a.set("name", "A");
+    a.sourceId = 2;
+
+    Properties b;
+    b.set("kind", "cafe");
+    b.set("height", 10);
+
+    SelectionFeatures features;
+    features.add(1, a);
+    features.add(2, b);
+
+    REQUIRE(features.size() == 2);
+    REQUIRE(features.contains(1));
+    REQUIRE(!features.contains(3));
+    REQUIRE(features.get(3) == nullptr);
+
+    auto props = features.get(1);
+    REQUIRE(props->sourceId == 2);
+    REQUIRE(props->items().size() == 2);
+    REQUIRE(props->getString("kind") == "cafe");
+    REQUIRE(props->getString("name") == "A");
+
+    props = features.get(2);
+    REQUIRE(props->getString("kind") == "cafe");
+    REQUIRE(props->getNumber("height") == 10);
+    REQUIRE(!props->contains("name"));
+}
+
+TEST_CASE("SelectionFeatures merge features after shrink", "[Core][SelectionFeatures]") {
+    Properties a;
+    a.set("name", "A");
+    Properties b;
+    b.set("name", "B");
+    b.set("kind", "park");
+
+    SelectionFeatures first, second;
+    first.add(1, a);
+    first.shrink();
+    second.add(2, b);
+    second.add(1, b);
+
+    first.merge(second);
+    first.add(3, a);
+
+    REQUIRE(first.size() == 3);
+    REQUIRE(first.get(1)->getString("name") == "B");
+    REQUIRE(first.get(2)->getString("kind") == "park");
+    REQUIRE(first.get(3)->getString("name") == "A");
+    REQUIRE(first.ids() == std::vector<uint32_t>{ 1, 2, 3 });
+}
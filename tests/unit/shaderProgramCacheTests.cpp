@@ -0,0 +1,25 @@
+#include "catch.hpp"
+
+#include "gl/shaderProgram.h"
+#include "gl/shaderProgramCache.h"
+
+using namespace Tangram;
+
+#define TAGS "[ShaderProgramCache]"
+
+TEST_CASE("ShaderProgramCache shares programs with identical sources", TAGS) {
+    ShaderProgramCache cache;
+
+    auto a = cache.get("vertex", "fragment", "a");
+    auto b = cache.get("vertex", "fragment", "b");
+    CHECK(a == b);
+    CHECK(a->getDescription() == "a");
+    CHECK(cache.size() == 1);
+
+    auto c = cache.get("vertex", "other fragment", "c");
+    auto d = cache.get("other vertex", "fragment", "d");
+    CHECK(c != a);
+    CHECK(d != a);
+    CHECK(c != d);
+    CHECK(cache.size() == 3);
+}
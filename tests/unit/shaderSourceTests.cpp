@@ -0,0 +1,56 @@
+#include "catch.hpp"
+
+#include "gl/shaderSource.h"
+
+using namespace Tangram;
+
+#define TAGS "[ShaderSource]"
+
+static const std::string vertexSource =
+    "#pragma tangram: defines\n"
+    "void main() {\n"
+    "    #pragma tangram:position\n"
+    "}\n";
+
+TEST_CASE("ShaderSource inserts source blocks at their pragmas", TAGS) {
+    ShaderSource source;
+    source.setSourceStrings(vertexSource, vertexSource);
+    source.addSourceBlock("defines", "#define A");
+    source.addSourceBlock("position", "x = 1.;\n");
+
+    auto out = source.buildVertexSource();
+    CHECK(out.find("#define TANGRAM_VERTEX_SHADER\n") != std::string::npos);
+    CHECK(out.find("#pragma tangram: defines\n#define A\n") != std::string::npos);
+    CHECK(out.find("#pragma tangram:position\nx = 1.;\n") != std::string::npos);
+
+    auto selection = source.buildSelectionVertexSource();
+    CHECK(selection.find("#define TANGRAM_FEATURE_SELECTION\n") != std::string::npos);
+}
+
+TEST_CASE("ShaderSource reuses sources built from the same inputs", TAGS) {
+    ShaderSource::clearCache();
+
+    ShaderSource a, b;
+    for (auto* source : { &a, &b }) {
+        source->setSourceStrings(vertexSource, vertexSource);
+        source->addSourceBlock("defines", "#define A\n");
+    }
+
+    auto out = a.buildVertexSource();
+    CHECK(ShaderSource::cacheSize() == 1);
+    CHECK(b.buildVertexSource() == out);
+    CHECK(ShaderSource::cacheSize() == 1);
+
+    b.addSourceBlock("defines", "#define B\n");
+    auto other = b.buildVertexSource();
+    CHECK(other != out);
+    CHECK(other.find("#define A\n#define B\n") != std::string::npos);
+    CHECK(ShaderSource::cacheSize() == 2);
+
+    b.setUniformBlocks(true);
+    CHECK(b.buildVertexSource() != other);
+    CHECK(ShaderSource::cacheSize() == 3);
+
+    ShaderSource::clearCache();
+    CHECK(ShaderSource::cacheSize() == 0);
+}
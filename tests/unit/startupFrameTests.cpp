@@ -0,0 +1,68 @@
+#include "catch.hpp"
+
+#include "gl/startupFrame.h"
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+using namespace Tangram;
+
+static const char* frame_file = "./startupFrame.bin";
+
+static StartupFrame::ViewPosition testView() {
+    StartupFrame::ViewPosition view;
+    view.position = { 1000.0, -2000.0 };
+    view.zoom = 12.5f;
+    view.width = 8;
+    view.height = 4;
+    return view;
+}
+
+static void waitForLoad(const StartupFrame& _frame) {
+    for (int i = 0; i < 500 && _frame.isLoading(); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
+
+TEST_CASE("StartupFrame is drawn for the view and scene it was stored for", "[StartupFrame]") {
+    auto view = testView();
+    std::vector<GLuint> pixels(view.width * view.height, 0xff336699);
+    REQUIRE(StartupFrame::store(frame_file, 42, view, pixels));
+
+    auto frame = StartupFrame::load(frame_file, 42);
+    waitForLoad(*frame);
+    REQUIRE_FALSE(frame->isLoading());
+    CHECK(frame->canDraw(view));
+
+    // Moved by less than a pixel
+    auto other = view;
+    other.position.x += 0.01;
+    CHECK(frame->canDraw(other));
+
+    other.position.x += 100.0;
+    CHECK_FALSE(frame->canDraw(other));
+
+    other = view;
+    other.width = 16;
+    CHECK_FALSE(frame->canDraw(other));
+
+    // Another scene
+    auto stale = StartupFrame::load(frame_file, 43);
+    waitForLoad(*stale);
+    REQUIRE_FALSE(stale->isLoading());
+    CHECK_FALSE(stale->canDraw(view));
+
+    std::remove(frame_file);
+}
+
+TEST_CASE("StartupFrame fades out once the view is complete", "[StartupFrame]") {
+    auto frame = StartupFrame::load("./missingStartupFrame.bin", 42);
+
+    // Held while the tiles in view load
+    CHECK(frame->update(0.5f, false));
+    CHECK(frame->update(0.5f, false));
+
+    CHECK(frame->update(0.1f, true));
+    CHECK_FALSE(frame->update(StartupFrame::fade_duration, true));
+}
@@ -323,3 +323,49 @@ TEST_CASE("Stops using `%` and auto for StyleParam::size", "[Stops][YAML]") {
     val = stops.evalSize(18, CSS_SIZE);
     REQUIRE(glm::all(glm::epsilonEqual(val, glm::vec2(40.f, 20.f), EPSILON)));
 }
+
+TEST_CASE("Stops tables match the evaluation of the frames", "[Stops]") {
+
+    Stops widths({
+            Stops::Frame(10, 1.f),
+            Stops::Frame(14, 8.f),
+            Stops::Frame(18, 40.f)
+    });
+    Stops colors = instance_color();
+    Stops offsets({
+            Stops::Frame(2, glm::vec2(0.0)),
+            Stops::Frame(4, glm::vec2(4.0, -2.0))
+    });
+
+    auto check = [](Stops stops, StyleParamKey key, float tolerance) {
+        Stops table = stops;
+        table.buildTable(key);
+        REQUIRE(!table.table.samples.empty());
+
+        for (int i = -20; i <= 420; i++) {
+            float zoom = i / 20.f;
+            StyleParam::Value expected, result;
+            Stops::eval(stops, key, zoom, expected);
+            Stops::eval(table, key, zoom, result);
+
+            if (expected.is<uint32_t>()) {
+                Color a(expected.get<uint32_t>()), b(result.get<uint32_t>());
+                CHECK(std::abs(a.r - b.r) <= 1);
+                CHECK(std::abs(a.g - b.g) <= 1);
+                CHECK(std::abs(a.b - b.b) <= 1);
+            } else if (expected.is<glm::vec2>()) {
+                CHECK(glm::all(glm::epsilonEqual(expected.get<glm::vec2>(), result.get<glm::vec2>(), tolerance)));
+            } else {
+                CHECK(std::abs(expected.get<float>() - result.get<float>()) <= tolerance);
+            }
+            // Samples are exact at integer zooms
+            if (i % 20 == 0 && expected.is<float>()) {
+                CHECK(expected.get<float>() == result.get<float>());
+            }
+        }
+    };
+
+    check(widths, StyleParamKey::width, 0.1f);
+    check(colors, StyleParamKey::color, 0);
+    check(offsets, StyleParamKey::offset, 1e-5f);
+}
@@ -291,3 +291,40 @@ TEST_CASE("fix:mergeMapFieldTakingLast: Correctly mix two style config nodes", "
     REQUIRE(resultB["material"]["specular"].Scalar() == "green");
 
 }
+
+TEST_CASE("Cached style mixing is reused for equal input only", "[mixing][yaml]") {
+
+    StyleMixer mixer;
+    StyleMixer::clearCache();
+
+    const char* yaml = R"END(
+        styleA:
+            shaders:
+                blocks: { color: a }
+        styleB:
+            base: styleA
+            shaders:
+                blocks: { color: b }
+        )END";
+
+    Node first = YAML::Load(yaml);
+    Node second = YAML::Load(yaml);
+    Node changed = YAML::Load(yaml);
+    changed["styleA"]["shaders"]["blocks"]["color"] = "c";
+
+    REQUIRE(!mixer.mixStyleNodesCached(first));
+    REQUIRE(mixer.mixStyleNodesCached(second));
+    REQUIRE(!mixer.mixStyleNodesCached(changed));
+
+    REQUIRE(YAML::Dump(first) == YAML::Dump(second));
+    REQUIRE(second["styleB"]["shaders"]["blocks_mixed"]["color"].size() == 2);
+    REQUIRE(changed["styleB"]["shaders"]["blocks_mixed"]["color"][0].Scalar() == "c");
+
+    // The reused output does not share nodes with the cache
+    second["styleB"]["base"] = "polygons";
+    Node third = YAML::Load(yaml);
+    REQUIRE(mixer.mixStyleNodesCached(third));
+    REQUIRE(third["styleB"]["base"].Scalar() == "styleA");
+
+    StyleMixer::clearCache();
+}
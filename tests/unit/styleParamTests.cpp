@@ -88,3 +88,20 @@ TEST_CASE("Correctly reject invalid Vec3", "[StyleParam]") {
         CHECK_FALSE(StyleParam::parseVec3(input, UnitSet{Unit::none, Unit::meter, Unit::pixel}, result));
     }
 }
+
+TEST_CASE("Parse values of function results like scene values", "[StyleParam]") {
+
+    auto color = StyleParam::parseString(StyleParamKey::color, "#ff0000");
+    REQUIRE(color.is<uint32_t>());
+    CHECK(color.get<uint32_t>() == 0xff0000ff);
+    CHECK(StyleParam::parseString(StyleParamKey::color, "not a color").is<none_type>());
+
+    auto sprite = StyleParam::parseString(StyleParamKey::sprite, "true");
+    REQUIRE(sprite.is<std::string>());
+    CHECK(sprite.get<std::string>() == "true");
+
+    auto width = StyleParam::parseString(StyleParamKey::width, "4px");
+    REQUIRE(width.is<StyleParam::Width>());
+    CHECK(width.get<StyleParam::Width>().isPixel());
+    CHECK(width.get<StyleParam::Width>().value == 4.f);
+}
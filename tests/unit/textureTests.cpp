@@ -2,6 +2,15 @@
 
 #include "gl/texture.h"
 #include "gl/glyphTexture.h"
+#include "gl/hardware.h"
+#include "gl/iconAtlas.h"
+#include "gl/rasterAtlas.h"
+#include "gl/renderState.h"
+#include "mockPlatform.h"
+#include "util/dashArray.h"
+
+#include <cstring>
+#include <vector>
 
 using namespace Tangram;
 
@@ -113,3 +122,407 @@ TEST_CASE("Merging of dirty Regions - Merge three regions, when 3rd region is ad
     }
 
 }
+
+TEST_CASE("Merging of dirty Regions - Column extent", "[Texture]") {
+    TestTexture texture{};
+
+    // Columns are aligned to 4 bytes
+    texture.setRegionDirty(10, 20, 13, 10);
+    REQUIRE(texture.dirtyRanges().size() == 1);
+    REQUIRE(texture.dirtyRanges()[0].left == 8);
+    REQUIRE(texture.dirtyRanges()[0].right == 24);
+
+    // Overlapping rows extend the columns
+    texture.setRegionDirty(100, 25, 20, 10);
+    REQUIRE(texture.dirtyRanges().size() == 1);
+    REQUIRE(texture.dirtyRanges()[0].min == 20);
+    REQUIRE(texture.dirtyRanges()[0].max == 35);
+    REQUIRE(texture.dirtyRanges()[0].left == 8);
+    REQUIRE(texture.dirtyRanges()[0].right == 120);
+
+    // Separate rows keep their own columns
+    texture.setRegionDirty(200, 100, 8, 8);
+    REQUIRE(texture.dirtyRanges().size() == 2);
+    REQUIRE(texture.dirtyRanges()[1].left == 200);
+    REQUIRE(texture.dirtyRanges()[1].right == 208);
+
+    // Whole rows
+    texture.setRowsDirty(30, 80);
+    REQUIRE(texture.dirtyRanges().size() == 1);
+    REQUIRE(texture.dirtyRanges()[0].left == 0);
+    REQUIRE(texture.dirtyRanges()[0].right == 512);
+}
+
+// KTX2 container of an 8x8 ETC2 texture with a 4x4 and a 2x2 mipmap level
+static std::vector<uint8_t> ktx2Data(uint32_t _vkFormat, uint32_t _supercompression = 0) {
+    const uint8_t identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+    const uint64_t levelSizes[3] = { 32, 8, 8 };
+
+    std::vector<uint8_t> data(80 + 3 * 24);
+    auto write = [&](size_t _offset, auto _value) {
+        std::memcpy(&data[_offset], &_value, sizeof(_value));
+    };
+    std::memcpy(&data[0], identifier, sizeof(identifier));
+    write(12, _vkFormat);
+    write(20, uint32_t(8));
+    write(24, uint32_t(8));
+    write(36, uint32_t(1));
+    write(40, uint32_t(3));
+    write(44, _supercompression);
+
+    // Levels are stored from the smallest
+    uint64_t offset = data.size() + 48;
+    for (int i = 0; i < 3; i++) {
+        offset -= levelSizes[i];
+        write(80 + i * 24, offset);
+        write(80 + i * 24 + 8, levelSizes[i]);
+        write(80 + i * 24 + 16, levelSizes[i]);
+    }
+    data.resize(data.size() + 48, uint8_t(0x55));
+    return data;
+}
+
+TEST_CASE("Load compressed texture from KTX2 container", "[Texture]") {
+    bool supported = Hardware::supportsETC2;
+    Hardware::supportsETC2 = true;
+
+    TextureOptions options;
+    options.minFilter = TextureMinFilter::LINEAR_MIPMAP_LINEAR;
+    options.generateMipmaps = true;
+
+    // VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK
+    auto data = ktx2Data(147);
+    REQUIRE(Texture::isKTX2(data.data(), data.size()));
+
+    Texture texture(options);
+    REQUIRE(texture.loadImageFromMemory(data.data(), data.size()));
+    CHECK(texture.compressedFormat() == GL_COMPRESSED_RGB8_ETC2);
+    CHECK(texture.width() == 8);
+    CHECK(texture.height() == 8);
+    // All levels at 4 bits per pixel, instead of 256 bytes for the first level in RGBA
+    CHECK(texture.bufferSize() == 48);
+    CHECK(texture.cpuBytes() == 48);
+
+    // Formats the GPU does not support
+    Hardware::supportsETC2 = false;
+    Texture unsupported(options);
+    CHECK_FALSE(unsupported.loadImageFromMemory(data.data(), data.size()));
+    CHECK(unsupported.compressedFormat() == 0);
+
+    // Supercompressed data, e.g. BasisLZ
+    Hardware::supportsETC2 = true;
+    auto basis = ktx2Data(147, 1);
+    Texture supercompressed(options);
+    CHECK_FALSE(supercompressed.loadImageFromMemory(basis.data(), basis.size()));
+
+    // Truncated data
+    data.resize(data.size() - 8);
+    Texture truncated(options);
+    CHECK_FALSE(truncated.loadImageFromMemory(data.data(), data.size()));
+
+    Hardware::supportsETC2 = supported;
+}
+
+struct DecoderPlatform : MockPlatform {
+    bool decodeImage(const uint8_t* _data, size_t _length, int _channels,
+                     int& _width, int& _height,
+                     std::function<uint8_t*(size_t)> _allocator) const override {
+        decoded++;
+        if (_length < 2) { return false; }
+        _width = _data[0];
+        _height = _data[1];
+        uint8_t* pixels = _allocator(_width * _height * _channels);
+        std::memset(pixels, 0xff, _width * _height * _channels);
+        return true;
+    }
+    mutable int decoded = 0;
+};
+
+TEST_CASE("Decode images with the decoder of the platform", "[Texture]") {
+    DecoderPlatform platform;
+
+    std::vector<uint8_t> data = { 4, 2 };
+    Texture texture(TextureOptions{});
+    REQUIRE(texture.loadImageFromMemory(data.data(), data.size(), &platform));
+    CHECK(platform.decoded == 1);
+    CHECK(texture.width() == 4);
+    CHECK(texture.height() == 2);
+    CHECK(texture.bufferSize() == 4 * 2 * 4);
+    CHECK(texture.cpuBytes() == 4 * 2 * 4);
+
+    // Data without a platform decoder is decoded with stb_image
+    std::vector<uint8_t> invalid = { 0 };
+    Texture fallback(TextureOptions{});
+    CHECK_FALSE(fallback.loadImageFromMemory(invalid.data(), invalid.size(), &platform));
+    CHECK(platform.decoded == 2);
+    CHECK(fallback.width() == 1);
+}
+
+static std::unique_ptr<RasterAtlasTexture> rasterTexture(int _size) {
+    auto texture = std::make_unique<RasterAtlasTexture>(TextureOptions());
+    std::vector<GLubyte> pixels(_size * _size * 4, 0xff);
+    texture->setPixelData(_size, _size, 4, pixels.data(), pixels.size());
+    return texture;
+}
+
+TEST_CASE("Place raster textures in atlas slots", "[Texture]") {
+    auto atlas = std::make_shared<RasterAtlas>(TextureOptions(), 1000);
+    float size = RasterAtlas::textureSize();
+
+    auto first = rasterTexture(1000);
+    REQUIRE(first->canAddToAtlas());
+    REQUIRE(first->addToAtlas(atlas));
+    CHECK(first->width() == size);
+    // Slots start after a border of one pixel
+    CHECK(first->region() == glm::vec3(1.f / size, 1.f / size, 1000.f / size));
+    // With the border, until it is uploaded
+    CHECK(first->cpuBytes() == 1002 * 1002 * 4);
+    CHECK(first->gpuBytes() == 0);
+
+    auto second = rasterTexture(1000);
+    REQUIRE(second->addToAtlas(atlas));
+    CHECK(second->region() == glm::vec3(1003.f / size, 1.f / size, 1000.f / size));
+
+    // Two slots per row and column
+    auto third = rasterTexture(1000);
+    auto fourth = rasterTexture(1000);
+    REQUIRE(third->addToAtlas(atlas));
+    REQUIRE(fourth->addToAtlas(atlas));
+    auto full = rasterTexture(1000);
+    CHECK_FALSE(full->addToAtlas(atlas));
+    CHECK_FALSE(full->inAtlas());
+
+    // Released slots are reused
+    auto region = second->region();
+    second.reset();
+    REQUIRE(full->addToAtlas(atlas));
+    CHECK(full->region() == region);
+
+    // Images that do not fit in slots keep their own texture
+    CHECK_FALSE(rasterTexture(size)->canAddToAtlas());
+    auto image = std::make_unique<RasterAtlasTexture>(TextureOptions());
+    std::vector<GLubyte> pixels(8 * 4 * 4);
+    image->setPixelData(8, 4, 4, pixels.data(), pixels.size());
+    CHECK_FALSE(image->canAddToAtlas());
+    CHECK(image->region() == glm::vec3(0.f, 0.f, 1.f));
+}
+
+static std::unique_ptr<IconAtlasTexture> iconTexture(int _width, int _height) {
+    auto texture = std::make_unique<IconAtlasTexture>(TextureOptions());
+    std::vector<GLubyte> pixels(_width * _height * 4, 0xff);
+    texture->setPixelData(_width, _height, 4, pixels.data(), pixels.size());
+    return texture;
+}
+
+TEST_CASE("Pack point icons into an atlas", "[Texture]") {
+    auto atlas = std::make_shared<IconAtlas>();
+    float size = IconAtlas::textureSize();
+
+    auto first = iconTexture(32, 16);
+    REQUIRE(first->canAddToAtlas());
+    REQUIRE(first->addToAtlas(atlas));
+    // Icons keep their size and are drawn from the atlas texture
+    CHECK(first->width() == 32);
+    CHECK(first->height() == 16);
+    CHECK(first->sharedTexture() == &atlas->texture());
+    CHECK(first->uvRect() == glm::vec4(1.f / size, 1.f / size, 32.f / size, 16.f / size));
+    // With the border, until it is uploaded
+    CHECK(first->cpuBytes() == 34 * 18 * 4);
+
+    // Next to the first icon in its row
+    auto second = iconTexture(16, 16);
+    REQUIRE(second->addToAtlas(atlas));
+    CHECK(second->uvRect() == glm::vec4(35.f / size, 1.f / size, 16.f / size, 16.f / size));
+
+    // Taller icons start a new row
+    auto third = iconTexture(16, 32);
+    REQUIRE(third->addToAtlas(atlas));
+    CHECK(third->uvRect() == glm::vec4(1.f / size, 19.f / size, 16.f / size, 32.f / size));
+
+    // Released cells are reused by icons that fit
+    auto rect = second->uvRect();
+    second.reset();
+    auto fourth = iconTexture(12, 14);
+    REQUIRE(fourth->addToAtlas(atlas));
+    CHECK(fourth->uvRect().x == rect.x);
+    CHECK(fourth->uvRect().y == rect.y);
+
+    // Large images, sprite sheets and images without linear filtering keep
+    // their own texture
+    CHECK_FALSE(iconTexture(IconAtlas::max_icon_size + 1, 16)->canAddToAtlas());
+    auto sprites = iconTexture(32, 32);
+    sprites->setSpriteAtlas(std::make_unique<SpriteAtlas>());
+    CHECK_FALSE(sprites->canAddToAtlas());
+    TextureOptions nearest;
+    nearest.magFilter = TextureMagFilter::NEAREST;
+    IconAtlasTexture image(nearest);
+    std::vector<GLubyte> pixels(8 * 8 * 4);
+    image.setPixelData(8, 8, 4, pixels.data(), pixels.size());
+    CHECK_FALSE(image.canAddToAtlas());
+    CHECK(image.sharedTexture() == &image);
+    CHECK(image.uvRect() == glm::vec4(0.f, 0.f, 1.f, 1.f));
+}
+
+TEST_CASE("Dash patterns share one atlas texture", "[Texture]") {
+    DashAtlas atlas;
+
+    auto dash = atlas.add({ 1.f, 1.f }, 2.f);
+    CHECK(dash.column == 0);
+    CHECK(dash.length == 4);
+
+    // An odd pattern is repeated
+    auto longDash = atlas.add({ 3.f }, 2.f);
+    CHECK(longDash.column == 1);
+    CHECK(longDash.length == 12);
+
+    // The same pattern is added once
+    auto same = atlas.add({ 1.f, 1.f }, 2.f);
+    CHECK(same.column == 0);
+
+    auto& texture = atlas.texture();
+    CHECK(texture->width() == 2);
+    CHECK(texture->height() == 12);
+    CHECK(texture->bufferSize() == 2 * 12 * 4);
+}
+
+struct FrameRenderState : RenderState {
+    void beginFrame() { resetUploadedBytes(); }
+};
+
+TEST_CASE("Upload textures in slices within the upload budget", "[Texture]") {
+    uint32_t maxTextureSize = Hardware::maxTextureSize;
+    Hardware::maxTextureSize = 4096;
+
+    FrameRenderState rs;
+    rs.uploadBudget = 64 * 1024;
+
+    TextureOptions options;
+    options.minFilter = TextureMinFilter::LINEAR_MIPMAP_LINEAR;
+    options.generateMipmaps = true;
+    Texture texture(options);
+    std::vector<GLubyte> pixels(256 * 256 * 4);
+    texture.setPixelData(256, 256, 4, pixels.data(), pixels.size());
+
+    // 64 rows of 1kB fit in the budget
+    rs.beginFrame();
+    CHECK_FALSE(texture.uploadSlice(rs, 0));
+    CHECK(rs.uploadedBytes() == 64 * 1024);
+
+    // At least one slice when the budget is used up
+    CHECK_FALSE(texture.uploadSlice(rs, 0));
+    CHECK(rs.uploadedBytes() == 96 * 1024);
+
+    // The other 160 rows in the next frames
+    int frames = 0;
+    do {
+        rs.beginFrame();
+        frames++;
+    } while (!texture.uploadSlice(rs, 0));
+    CHECK(frames == 3);
+    CHECK(texture.cpuBytes() == 0);
+
+    // Mipmaps wait for a bind with upload budget
+    CHECK(rs.hasDeferredUploads());
+    rs.addUploadedBytes(rs.uploadBudget);
+    CHECK(texture.uploadSlice(rs, 0));
+    CHECK(texture.bind(rs, 0));
+    CHECK(rs.hasDeferredUploads());
+
+    rs.beginFrame();
+    CHECK(texture.bind(rs, 0));
+    CHECK_FALSE(rs.hasDeferredUploads());
+    CHECK(rs.uploadedBytes() == 256 * 256 * 4 / 3);
+
+    Hardware::maxTextureSize = maxTextureSize;
+}
+
+TEST_CASE("Upload textures again after a loss of the GL context", "[Texture]") {
+    uint32_t maxTextureSize = Hardware::maxTextureSize;
+    Hardware::maxTextureSize = 4096;
+
+    FrameRenderState rs;
+
+    std::vector<GLubyte> pixels(64 * 64 * 4, 0x80);
+
+    Texture retained(TextureOptions{});
+    retained.setPixelData(64, 64, 4, pixels.data(), pixels.size());
+    retained.retainCompressedCopy();
+
+    Texture disposed(TextureOptions{});
+    disposed.setPixelData(64, 64, 4, pixels.data(), pixels.size());
+
+    CHECK(retained.bind(rs, 0));
+    CHECK(disposed.bind(rs, 0));
+
+    // Only the deflated copy stays in memory
+    CHECK(retained.cpuBytes() > 0);
+    CHECK(retained.cpuBytes() < pixels.size());
+    CHECK(disposed.cpuBytes() == 0);
+
+    rs.invalidateHandles();
+    rs.beginFrame();
+
+    CHECK(retained.bind(rs, 0));
+    CHECK(rs.uploadedBytes() == pixels.size());
+    CHECK(retained.gpuBytes() == pixels.size());
+
+    // Without a copy the texture is allocated without data
+    disposed.bind(rs, 0);
+    CHECK(rs.uploadedBytes() == pixels.size());
+
+    // Nothing to upload in the same context
+    rs.beginFrame();
+    CHECK(retained.bind(rs, 0));
+    CHECK(rs.uploadedBytes() == 0);
+
+    Hardware::maxTextureSize = maxTextureSize;
+}
+
+TEST_CASE("Reuse the GL textures of deleted textures of the same size", "[Texture]") {
+    uint32_t maxTextureSize = Hardware::maxTextureSize;
+    Hardware::maxTextureSize = 4096;
+
+    struct HandleTexture : public Texture {
+        using Texture::Texture;
+        GLuint handle() const { return m_glHandle; }
+    };
+
+    RenderState rs;
+    std::vector<GLubyte> pixels(64 * 64 * 4);
+
+    GLuint handle = 0;
+    {
+        HandleTexture texture(TextureOptions{});
+        texture.setPixelData(64, 64, 4, pixels.data(), pixels.size());
+        CHECK(texture.bind(rs, 0));
+        handle = texture.handle();
+    }
+    CHECK(rs.recyclePool().textureBytes() == 0);
+
+    // Not before the next frame
+    HandleTexture early(TextureOptions{});
+    early.setPixelData(64, 64, 4, pixels.data(), pixels.size());
+    CHECK(early.bind(rs, 0));
+    CHECK(early.handle() != handle);
+
+    rs.flushResourceDeletion();
+    CHECK(rs.recyclePool().textureBytes() == pixels.size());
+
+    // Only for the same size
+    HandleTexture other(TextureOptions{});
+    other.setPixelData(32, 32, 4, pixels.data(), 32 * 32 * 4);
+    CHECK(other.bind(rs, 0));
+    CHECK(other.handle() != handle);
+
+    HandleTexture reused(TextureOptions{});
+    reused.setPixelData(64, 64, 4, pixels.data(), pixels.size());
+    CHECK(reused.bind(rs, 0));
+    CHECK(reused.handle() == handle);
+    CHECK(rs.recyclePool().textureBytes() == 0);
+
+    // Dropped with a lost context
+    rs.invalidateHandles();
+    CHECK(rs.recyclePool().textureBytes() == 0);
+
+    Hardware::maxTextureSize = maxTextureSize;
+}
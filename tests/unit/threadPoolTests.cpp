@@ -0,0 +1,115 @@
+#include "catch.hpp"
+
+#include "util/asyncWorker.h"
+#include "util/threadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace Tangram;
+
+
+TEST_CASE("ThreadPool runs all jobs before it is destroyed", "[ThreadPool]") {
+
+    std::atomic<int> counter{0};
+    {
+        ThreadPool pool(4);
+
+        for (int i = 0; i < 1000; i++) {
+            auto priority = ThreadPool::Priority(i % 4);
+            pool.enqueue(priority, [&] { counter++; });
+        }
+    }
+    CHECK(counter == 1000);
+}
+
+TEST_CASE("ThreadPool jobs can enqueue jobs", "[ThreadPool]") {
+
+    std::atomic<int> counter{0};
+    {
+        ThreadPool pool(2);
+
+        for (int i = 0; i < 100; i++) {
+            pool.enqueue(ThreadPool::Priority::tile, [&] {
+                pool.enqueue(ThreadPool::Priority::io, [&] { counter++; });
+                counter++;
+            });
+        }
+    }
+    CHECK(counter == 200);
+}
+
+TEST_CASE("ThreadPool is limited to max_threads", "[ThreadPool]") {
+
+    ThreadPool pool(1);
+    CHECK(pool.numThreads() == 1);
+
+    pool.reserveThreads(3);
+    CHECK(pool.numThreads() == 3);
+
+    pool.reserveThreads(2);
+    CHECK(pool.numThreads() == 3);
+
+    pool.reserveThreads(ThreadPool::max_threads + 1);
+    CHECK(pool.numThreads() == ThreadPool::max_threads);
+}
+
+TEST_CASE("AsyncWorker on a ThreadPool runs tasks in order", "[ThreadPool]") {
+
+    ThreadPool pool(4);
+
+    std::mutex mutex;
+    std::vector<int> order;
+    {
+        AsyncWorker worker(pool, ThreadPool::Priority::io);
+        worker.waitForCompletion();
+
+        for (int i = 0; i < 500; i++) {
+            worker.enqueue([&, i] {
+                std::lock_guard<std::mutex> lock(mutex);
+                order.push_back(i);
+            });
+        }
+    }
+
+    REQUIRE(order.size() == 500);
+    for (int i = 0; i < 500; i++) {
+        CHECK(order[i] == i);
+    }
+}
+
+TEST_CASE("ThreadPool counts jobs enqueued from a pool thread before idle threads take them", "[ThreadPool]") {
+
+    const int numJobs = 100;
+
+    std::atomic<int> done{0};
+    std::atomic<bool> finished{false};
+    size_t maxPending = 0;
+
+    ThreadPool pool(4);
+
+    // Polls the count while jobs are added and taken
+    std::thread monitor([&] {
+        while (!finished) {
+            maxPending = std::max(maxPending, pool.pendingJobs());
+        }
+    });
+
+    for (int i = 1; i <= 100; i++) {
+        pool.enqueue(ThreadPool::Priority::tile, [&, i] {
+            // Woken threads steal these jobs while more are added
+            for (int j = 0; j < numJobs; j++) {
+                pool.enqueue(ThreadPool::Priority::tile, [&] { done++; });
+            }
+            while (done < i * numJobs) { std::this_thread::yield(); }
+        });
+        while (done < i * numJobs) { std::this_thread::yield(); }
+    }
+    finished = true;
+    monitor.join();
+
+    CHECK(maxPending <= size_t(numJobs));
+}
@@ -0,0 +1,140 @@
+#include "catch.hpp"
+
+#include "gl/texture.h"
+#include "tile/tile.h"
+#include "tile/tileCache.h"
+
+#include <vector>
+
+using namespace Tangram;
+
+// Tile with a raster of _bytes so that it has a known memory usage
+static std::shared_ptr<Tile> makeTile(TileID _id, int32_t _sourceId, size_t _bytes, float _buildTime = 0) {
+    auto tile = std::make_shared<Tile>(_id, _sourceId);
+
+    std::vector<GLubyte> data(_bytes);
+    auto texture = std::make_shared<Texture>(TextureOptions());
+    texture->setPixelData(int(_bytes / 4), 1, 4, data.data(), data.size());
+    tile->rasters().emplace_back(_id, texture);
+
+    tile->setBuildTime(_buildTime);
+    return tile;
+}
+
+TEST_CASE("TileCache keeps track of memory usage", "[TileCache]") {
+    TileCache cache(1000);
+
+    cache.put(0, makeTile({0, 0, 1}, 0, 100));
+    cache.put(0, makeTile({1, 0, 1}, 0, 100));
+    cache.put(1, makeTile({0, 0, 1}, 1, 200));
+
+    REQUIRE(cache.getMemoryUsage() == 400);
+    REQUIRE(cache.getMemoryUsage(0) == 200);
+    REQUIRE(cache.getMemoryUsage(1) == 200);
+
+    // Putting the same tile again replaces it
+    cache.put(0, makeTile({0, 0, 1}, 0, 40));
+    REQUIRE(cache.getMemoryUsage(0) == 140);
+    REQUIRE(cache.stats().tiles == 3);
+
+    REQUIRE(cache.contains(1, {0, 0, 1}));
+    REQUIRE(cache.getMemoryUsage() == 340);
+
+    REQUIRE(cache.get(1, {0, 0, 1}));
+    REQUIRE(!cache.get(1, {0, 0, 1}));
+    REQUIRE(cache.getMemoryUsage() == 140);
+    REQUIRE(cache.getMemoryUsage(1) == 0);
+
+    auto stats = cache.stats();
+    REQUIRE(stats.hits == 1);
+    REQUIRE(stats.misses == 1);
+    REQUIRE(stats.tiles == 2);
+    REQUIRE(stats.memoryLimit == 1000);
+
+    cache.clear();
+    REQUIRE(cache.getMemoryUsage() == 0);
+    REQUIRE(cache.stats().tiles == 0);
+}
+
+TEST_CASE("TileCache evicts least recently used tiles when the limit is exceeded", "[TileCache]") {
+    TileCache cache(1000);
+
+    for (int x = 0; x < 12; x++) {
+        cache.put(0, makeTile({x, 0, 4}, 0, 100));
+    }
+    REQUIRE(cache.getMemoryUsage() == 1000);
+    REQUIRE(cache.stats().evictions == 2);
+
+    // Recently added tiles are kept
+    REQUIRE(cache.contains(0, {11, 0, 4}));
+    REQUIRE(cache.contains(0, {10, 0, 4}));
+
+    cache.limitCacheSize(500);
+    REQUIRE(cache.getMemoryUsage() == 500);
+    REQUIRE(cache.stats().tiles == 5);
+}
+
+TEST_CASE("TileCache trim releases memory and keeps the limit", "[TileCache]") {
+    TileCache cache(1000);
+
+    for (int x = 0; x < 5; x++) {
+        cache.put(0, makeTile({x, 0, 4}, 0, 100));
+    }
+    // Tiles were not uploaded
+    REQUIRE(cache.getGpuMemoryUsage() == 0);
+
+    cache.trim(200);
+    REQUIRE(cache.getMemoryUsage() == 200);
+    REQUIRE(cache.stats().memoryLimit == 1000);
+    REQUIRE(cache.contains(0, {4, 0, 4}));
+
+    for (int x = 5; x < 10; x++) {
+        cache.put(0, makeTile({x, 0, 4}, 0, 100));
+    }
+    REQUIRE(cache.getMemoryUsage() == 700);
+}
+
+TEST_CASE("TileCache budget of a source evicts only tiles of that source", "[TileCache]") {
+    TileCache cache(10000);
+
+    cache.setSourceBudget(1, 300);
+
+    for (int x = 0; x < 4; x++) {
+        cache.put(0, makeTile({x, 0, 4}, 0, 100));
+        cache.put(1, makeTile({x, 0, 4}, 1, 100));
+    }
+
+    REQUIRE(cache.getMemoryUsage(0) == 400);
+    REQUIRE(cache.getMemoryUsage(1) == 300);
+    REQUIRE(cache.stats().evictions == 1);
+
+    // Budgets are kept when the cache is cleared
+    cache.clear();
+    for (int x = 0; x < 4; x++) {
+        cache.put(1, makeTile({x, 0, 4}, 1, 100));
+    }
+    REQUIRE(cache.getMemoryUsage(1) == 300);
+}
+
+TEST_CASE("TileCache prefers to evict distant and cheap tiles", "[TileCache]") {
+    TileCache cache(300);
+
+    // View at the center of tile 0/0/4
+    TileID near{0, 0, 4};
+    auto nearTile = makeTile(near, 0, 100);
+    cache.setViewPosition(nearTile->getOrigin() + glm::dvec2(0.5 * nearTile->getScale()));
+
+    // The nearest tile is the least recently used
+    cache.put(0, nearTile);
+    cache.put(0, makeTile({8, 0, 4}, 0, 100));
+    cache.put(0, makeTile({1, 0, 4}, 0, 100));
+    cache.put(0, makeTile({2, 0, 4}, 0, 100));
+
+    REQUIRE(cache.contains(0, near));
+    REQUIRE(!cache.contains(0, {8, 0, 4}));
+
+    // An expensive tile is kept over a cheap one at the same distance
+    cache.put(0, makeTile({0, 1, 4}, 0, 100, 50.f));
+    cache.put(0, makeTile({1, 1, 4}, 0, 100));
+    REQUIRE(cache.contains(0, {0, 1, 4}));
+}
@@ -0,0 +1,352 @@
+#include "catch.hpp"
+
+#include "data/formats/geoJson.h"
+#include "data/formats/mvt.h"
+#include "data/propertyItem.h"
+#include "data/tileData.h"
+#include "data/tileSource.h"
+#include "tile/tileTask.h"
+
+#include <atomic>
+#include <thread>
+
+using namespace Tangram;
+
+TEST_CASE("Features share the GeometryBuffer of their Layer", "[Core][TileData]") {
+    Layer layer("test");
+
+    Feature points(0, layer.geometry);
+    points.geometryType = GeometryType::points;
+    points.addPoint({0.5f, 0.5f});
+    points.addPoint({0.25f, 0.75f});
+
+    Feature lines(0, layer.geometry);
+    lines.geometryType = GeometryType::lines;
+    lines.addLine({{0.f, 0.f}, {1.f, 0.f}, {1.f, 1.f}});
+    lines.addLine({{0.f, 1.f}, {1.f, 1.f}});
+
+    Feature polygons(0, layer.geometry);
+    polygons.geometryType = GeometryType::polygons;
+    polygons.addPolygon({{{0.f, 0.f}, {1.f, 0.f}, {1.f, 1.f}, {0.f, 0.f}},
+                         {{0.2f, 0.2f}, {0.8f, 0.2f}, {0.8f, 0.8f}, {0.2f, 0.2f}}});
+    polygons.beginPolygon();
+    polygons.addRing({{2.f, 2.f}, {3.f, 2.f}, {3.f, 3.f}, {2.f, 2.f}});
+
+    REQUIRE(layer.geometry->coordinates.size() == 17);
+    REQUIRE(layer.geometry->numLines() == 5);
+
+    REQUIRE(points.points().size() == 2);
+    REQUIRE(points.points()[1] == Point(0.25f, 0.75f));
+    REQUIRE(points.lines().empty());
+    REQUIRE(points.polygons().empty());
+
+    auto featureLines = lines.lines();
+    REQUIRE(featureLines.size() == 2);
+    REQUIRE(featureLines[0].size() == 3);
+    REQUIRE(featureLines[1].size() == 2);
+    REQUIRE(featureLines[1].front() == Point(0.f, 1.f));
+    REQUIRE(lines.points().empty());
+
+    auto featurePolygons = polygons.polygons();
+    REQUIRE(featurePolygons.size() == 2);
+    REQUIRE(featurePolygons[0].size() == 2);
+    REQUIRE(featurePolygons[0][1].back() == Point(0.2f, 0.2f));
+    REQUIRE(featurePolygons[1].size() == 1);
+    REQUIRE(featurePolygons[1][0][2] == Point(3.f, 3.f));
+    REQUIRE(polygons.lines().empty());
+
+    size_t numRings = 0;
+    for (const auto& polygon : featurePolygons) {
+        for (const auto& ring : polygon) {
+            REQUIRE(ring.front() == ring.back());
+            numRings++;
+        }
+    }
+    REQUIRE(numRings == 3);
+}
+
+TEST_CASE("Feature without Layer owns its geometry", "[Core][TileData]") {
+    Feature feature;
+    feature.geometryType = GeometryType::lines;
+
+    REQUIRE(feature.lines().empty());
+
+    feature.addLine({{0.f, 0.f}, {1.f, 1.f}});
+
+    REQUIRE(feature.lines().size() == 1);
+    REQUIRE(feature.lines()[0][1] == Point(1.f, 1.f));
+
+    // Copies reference the same geometry
+    Feature copy = feature;
+    REQUIRE(copy.lines()[0].data() == feature.lines()[0].data());
+}
+
+TEST_CASE("MVT feature keeps its ID and drops repeated points", "[Core][TileData]") {
+    // id 42, type LINESTRING, geometry MoveTo(2, 2) LineTo(+2, 0)(0, 0)(0, +2)
+    const char data[] = { 0x08, 42, 0x18, 2, 0x22, 10,
+                          0x09, 4, 4, 0x1a, 4, 0, 0, 0, 0, 4 };
+
+    Layer layer("test");
+    Mvt::ParserContext ctx(0);
+    ctx.properties = std::make_shared<PropertyTable>();
+    ctx.layerGeometry = layer.geometry;
+    ctx.tileExtent = 4097;
+
+    Feature feature(0, layer.geometry);
+    REQUIRE(Mvt::getFeature(ctx, protobuf::message(data, sizeof(data)), feature));
+
+    REQUIRE(feature.id == 42);
+    REQUIRE(feature.geometryType == GeometryType::lines);
+    REQUIRE(feature.lines().size() == 1);
+
+    auto line = feature.lines()[0];
+    REQUIRE(line.size() == 3);
+    REQUIRE(line[1] == Point(4.f / 4096, 4095.f / 4096));
+    REQUIRE(line[2] == Point(4.f / 4096, 4093.f / 4096));
+}
+
+TEST_CASE("MVT parsing stops when the task is canceled", "[Core][TileData]") {
+    // Layer 'test' with a point feature at (1, 1) and extent 4096
+    const char data[] = { 0x1a, 18,
+                          0x0a, 4, 't', 'e', 's', 't',
+                          0x12, 7, 0x18, 1, 0x22, 3, 0x09, 2, 2,
+                          0x28, char(0x80), 0x20 };
+
+    auto source = std::make_shared<TileSource>("test", nullptr);
+    TileID tileId(0, 0, 0);
+    BinaryTileTask task(tileId, source);
+    task.rawTileData = std::make_shared<std::vector<char>>(data, data + sizeof(data));
+
+    auto tileData = Mvt::parseTile(task, 0);
+    REQUIRE(tileData);
+    REQUIRE(tileData->layers.size() == 1);
+    REQUIRE(tileData->layers[0].features.size() == 1);
+
+    task.cancel();
+    REQUIRE(!Mvt::parseTile(task, 0));
+}
+
+TEST_CASE("Properties reference the PropertyTable of their Layer", "[Core][TileData]") {
+    auto table = std::make_shared<PropertyTable>();
+    table->keys = {"name", "kind", "height"};
+    table->values = {Value{std::string("a")}, Value{std::string("b")}, Value{10.0}, Value{20.0}};
+    // Key ordering: height, kind, name
+    table->keyOrder = {2, 1, 0};
+    for (const auto& key : table->keys) {
+        table->keyIds.push_back(Properties::internKey(key));
+    }
+
+    Properties props;
+    props.setTags(table, {{0, 0}, {2, 2}, {1, 1}, {2, 3}});
+
+    REQUIRE(props.getString("name") == "a");
+    REQUIRE(props.getNumber("height") == 20.0);
+    REQUIRE(!props.contains("width"));
+    REQUIRE(props.getString(Properties::internKey("kind")) == "b");
+
+    // Copies hold their own items
+    Properties copy = props;
+    table.reset();
+
+    const auto& items = copy.items();
+    REQUIRE(items.size() == 3);
+    REQUIRE(items[0].key == "height");
+    REQUIRE(items[0].value == Value{20.0});
+    REQUIRE(items[2].key == "name");
+
+    REQUIRE(props.getString("kind") == "b");
+    props.set("width", 5.0);
+    REQUIRE(props.items().size() == 4);
+    REQUIRE(props.getNumber("height") == 20.0);
+}
+
+TEST_CASE("GeoJSON features share the keys and values of their Layer", "[Core][TileData]") {
+    const char json[] = R"({ "type": "FeatureCollection", "features": [
+        { "type": "Feature", "properties": { "name": "a", "kind": "residential", "height": 10 },
+          "geometry": { "type": "Point", "coordinates": [0, 0] } },
+        { "type": "Feature", "properties": { "kind": "residential", "height": 10, "roof": true },
+          "geometry": { "type": "Point", "coordinates": [1, 1] } }
+    ]})";
+
+    const char* error = nullptr;
+    size_t offset = 0;
+    std::vector<char> buffer;
+    auto document = JsonParseInsitu(json, sizeof(json) - 1, buffer, &error, &offset);
+    REQUIRE(error == nullptr);
+
+    auto layer = GeoJson::getLayer(document, [](LngLat _lngLat) {
+        return Point(_lngLat.longitude, _lngLat.latitude);
+    }, 0);
+    REQUIRE(layer.features.size() == 2);
+
+    auto& a = layer.features[0].props;
+    auto& b = layer.features[1].props;
+    REQUIRE(a.getString("kind") == "residential");
+    REQUIRE(&a.getString("kind") == &b.getString("kind"));
+    REQUIRE(&a.get("height") == &b.get("height"));
+    REQUIRE(b.contains(Properties::internKey("roof")));
+    REQUIRE(b.getNumber("roof") == 1.0);
+    REQUIRE(!b.contains("name"));
+
+    a.resolve();
+    const auto& items = a.items();
+    REQUIRE(items.size() == 3);
+    REQUIRE(items[0].key == "kind");
+    REQUIRE(items[1].key == "name");
+    REQUIRE(items[2].key == "height");
+}
+
+TEST_CASE("Properties can be looked up by interned key", "[Core][TileData]") {
+    auto name = Properties::internKey("name");
+    auto height = Properties::internKey("height");
+
+    REQUIRE(Properties::internKey("name") == name);
+    REQUIRE(name != height);
+
+    Properties props;
+    props.set("name", "a");
+    props.set("height", 10.0);
+
+    double value = 0;
+    REQUIRE(props.getNumber(height, value));
+    REQUIRE(value == 10.0);
+    REQUIRE(props.getString(name) == "a");
+    REQUIRE(props.getAsString(height) == "10");
+    REQUIRE(!props.contains(Properties::internKey("width")));
+
+    // Copies keep the interned keys
+    Properties copy = props;
+    REQUIRE(copy.get(name) == Value{std::string("a")});
+}
+
+TEST_CASE("Overzoomed tiles share parsed TileData with sources of the same URL", "[Core][TileData]") {
+    std::string json = R"({ "type": "FeatureCollection", "features": [
+        { "type": "Feature", "properties": { "kind": "park" },
+          "geometry": { "type": "Point", "coordinates": [0, 0] } }
+    ]})";
+    auto data = std::make_shared<std::vector<char>>(json.begin(), json.end());
+
+    auto a = std::make_shared<TileSource>("a", nullptr);
+    auto b = std::make_shared<TileSource>("b", nullptr);
+    auto other = std::make_shared<TileSource>("other", nullptr);
+    a->setSharedData("https://some.domain/{z}/{x}/{y}.json");
+    b->setSharedData("https://some.domain/{z}/{x}/{y}.json");
+    other->setSharedData("https://other.domain/{z}/{x}/{y}.json");
+
+    auto parse = [&](std::shared_ptr<TileSource> _source) {
+        TileID tileId(0, 0, 0, 2);
+        BinaryTileTask task(tileId, _source);
+        task.rawTileData = data;
+        return _source->parseOverzoomed(task);
+    };
+
+    auto tileData = parse(a);
+    REQUIRE(tileData);
+    REQUIRE(tileData->layers.size() == 1);
+    CHECK(parse(b) == tileData);
+    CHECK(parse(other) != tileData);
+
+    // The data is released with the last source that holds it
+    size_t shared = TileSource::sharedDataCount();
+    tileData.reset();
+    a.reset();
+    b.reset();
+    CHECK(TileSource::sharedDataCount() == shared - 1);
+}
+
+TEST_CASE("Overzoomed children of a tile are built from its TileData on separate threads", "[Core][TileData]") {
+    std::string json = R"({ "type": "FeatureCollection", "features": [
+        { "type": "Feature", "properties": { "kind": "park", "name": "a", "area": 10 },
+          "geometry": { "type": "Point", "coordinates": [0, 0] } },
+        { "type": "Feature", "properties": { "kind": "forest", "area": 20 },
+          "geometry": { "type": "Point", "coordinates": [1, 1] } }
+    ]})";
+    auto data = std::make_shared<std::vector<char>>(json.begin(), json.end());
+
+    auto source = std::make_shared<TileSource>("test", nullptr);
+
+    // The children have the data of tile 0/0/0, parsed for the first of them
+    TileID parent(0, 0, 0, 1);
+    auto parse = [&](int _child) {
+        TileID tileId = parent.getChild(_child, 0);
+        BinaryTileTask task(tileId, source);
+        task.rawTileData = data;
+        return source->parseOverzoomed(task);
+    };
+    auto parsed = parse(0);
+    REQUIRE(parsed);
+
+    std::shared_ptr<TileData> tileData[2];
+    std::vector<Properties> copies[2];
+    // Catch assertions are not thread-safe
+    bool valid[2] = { true, true };
+    std::atomic<int> started{0};
+
+    auto build = [&](int _child) {
+        tileData[_child] = parse(_child + 1);
+        if (!tileData[_child]) {
+            valid[_child] = false;
+        }
+        // Read the data at the same time
+        started++;
+        while (started < 2) { std::this_thread::yield(); }
+        if (!valid[_child]) { return; }
+
+        // Read the properties of the shared TileData as the StyleBuilders,
+        // the selection features and the tile disk cache do
+        for (int i = 0; i < 100; i++) {
+            copies[_child].clear();
+            for (auto& feature : tileData[_child]->layers[0].features) {
+                valid[_child] &= feature.props.getNumber("area") > 0;
+                valid[_child] &= !feature.props.items().empty();
+                copies[_child].push_back(feature.props);
+            }
+        }
+    };
+
+    std::thread a(build, 0);
+    std::thread b(build, 1);
+    a.join();
+    b.join();
+
+    for (int child = 0; child < 2; child++) {
+        REQUIRE(valid[child]);
+        REQUIRE(tileData[child] == parsed);
+        REQUIRE(copies[child].size() == 2);
+        const auto& items = copies[child][0].items();
+        REQUIRE(items.size() == 3);
+        REQUIRE(items[0].key == "area");
+        REQUIRE(items[1].key == "kind");
+        REQUIRE(items[2].key == "name");
+        REQUIRE(copies[child][1].getString("kind") == "forest");
+    }
+}
+
+TEST_CASE("Keys of features are interned only by filters and styles", "[Core][TileData]") {
+    std::vector<Properties::Item> items;
+    items.emplace_back("late_key", Value{1.0});
+    REQUIRE(Properties::findKey("late_key") == items[0].keyId);
+
+    Properties props;
+    props.setSorted(std::move(items));
+
+    auto table = std::make_shared<PropertyTable>();
+    table->keys = {"late_key"};
+    table->values = {Value{2.0}};
+    table->orderKeys();
+    Properties tags;
+    tags.setTags(table, {{0, 0}});
+
+    // Interning a key after the features were parsed
+    auto id = Properties::internKey("late_key");
+    REQUIRE(table->keyIds[0] != id);
+    REQUIRE(Properties::findKey("late_key") == id);
+
+    double value = 0;
+    REQUIRE(props.getNumber(id, value));
+    REQUIRE(value == 1.0);
+    REQUIRE(tags.getNumber(id, value));
+    REQUIRE(value == 2.0);
+    REQUIRE(!props.contains(Properties::internKey("other_late_key")));
+    REQUIRE(!tags.contains(Properties::internKey("other_late_key")));
+}
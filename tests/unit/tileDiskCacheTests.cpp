@@ -0,0 +1,171 @@
+#include "catch.hpp"
+
+#include "data/propertyItem.h"
+#include "data/tileSource.h"
+#include "gl/mesh.h"
+#include "selection/featureSelection.h"
+#include "selection/featureState.h"
+#include "style/polygonStyle.h"
+#include "tile/tile.h"
+#include "tile/tileDiskCache.h"
+
+#include <cstdio>
+
+using namespace Tangram;
+
+struct CacheTestVertex {
+    float x, y;
+    uint32_t selection;
+};
+
+struct CacheTestStyle : PolygonStyle {
+    CacheTestStyle(std::string _name, uint32_t _id) : PolygonStyle(_name) {
+        m_vertexLayout = std::make_shared<VertexLayout>(std::vector<VertexLayout::VertexAttrib>({
+            {"a_position", 2, GL_FLOAT, false, 0},
+            {"a_selection_color", 4, GL_UNSIGNED_BYTE, true, 0},
+        }));
+        setID(_id);
+    }
+};
+
+// Stands in for the meshes of label styles which cannot be stored
+struct CacheTestLabelMesh : StyledMesh {
+    bool draw(RenderState& rs, ShaderProgram& _shader, bool _useVao) override { return false; }
+    size_t bufferSize() const override { return 0; }
+};
+
+struct CacheTestSource : TileSource {
+    CacheTestSource() : TileSource("disk cache test", nullptr) {}
+};
+
+static std::vector<std::unique_ptr<Style>> cacheTestStyles() {
+    std::vector<std::unique_ptr<Style>> styles;
+    styles.push_back(std::make_unique<CacheTestStyle>("polygons", 0));
+    styles.push_back(std::make_unique<CacheTestStyle>("lines", 1));
+    styles.push_back(std::make_unique<CacheTestStyle>("text", 2));
+    return styles;
+}
+
+static std::unique_ptr<Tile> cacheTestTile(TileID _tileId, const TileSource& _source,
+                                           const std::vector<std::unique_ptr<Style>>& _styles,
+                                           bool _labels, uint32_t _color = 5) {
+    auto tile = std::make_unique<Tile>(_tileId, _source.id(), _source.generation());
+    tile->initGeometry(_styles.size());
+
+    MeshData<CacheTestVertex> data({ 0, 1, 2, 2, 1, 3 },
+                                   {{ 0, 0, _color }, { 1, 0, _color }, { 0, 1, _color }, { 1, 1, 0 }});
+    auto mesh = std::make_unique<Mesh<CacheTestVertex>>(_styles[0]->vertexLayout(), GL_TRIANGLES);
+    mesh->compile(data);
+    tile->setMesh(*_styles[0], std::move(mesh));
+
+    MeshBounds bounds;
+    bounds.expand({ 0, 0, 0 });
+    bounds.expand({ 1, 1, 5 });
+    tile->setMeshBounds(*_styles[0], bounds);
+
+    if (_labels) {
+        tile->setMesh(*_styles[2], std::make_unique<CacheTestLabelMesh>());
+    }
+
+    Properties props;
+    props.set("name", "a");
+    props.set("height", 10);
+    SelectionFeatures selection;
+    selection.add(_color, props);
+    tile->setSelectionFeatures(std::move(selection));
+
+    return tile;
+}
+
+TEST_CASE("TileDiskCache restores meshes and selection features", "[TileDiskCache]") {
+    TileDiskCache cache(".");
+    CacheTestSource source;
+    auto styles = cacheTestStyles();
+    FeatureSelection selection;
+    FeatureState state;
+    TileID tileId(1, 2, 3);
+
+    auto tile = cacheTestTile(tileId, source, styles, false);
+    REQUIRE(cache.store(*tile, source, 42, styles, state));
+
+    std::vector<bool> buildStyles;
+    auto restored = cache.load(tileId, source, 42, styles, selection, state, buildStyles);
+
+    REQUIRE(restored);
+    REQUIRE(buildStyles.empty());
+    REQUIRE(restored->getID() == tileId);
+    REQUIRE(restored->getMesh(*styles[0]));
+    REQUIRE(restored->getMesh(*styles[0])->bufferSize() == tile->getMesh(*styles[0])->bufferSize());
+    REQUIRE(!restored->getMesh(*styles[1]));
+
+    auto& bounds = restored->getMeshBounds(*styles[0]);
+    REQUIRE(bounds.bounded);
+    REQUIRE(bounds.min == glm::vec3(0, 0, 0));
+    REQUIRE(bounds.max == glm::vec3(1, 1, 5));
+
+    // The selection feature is drawn with a new color
+    auto& features = restored->getSelectionFeatures();
+    REQUIRE(features.size() == 1);
+    auto feature = features.get(features.ids()[0]);
+    REQUIRE(features.ids()[0] != 5);
+    REQUIRE(feature->getString("name") == "a");
+    REQUIRE(feature->getNumber("height") == 10);
+
+    // Entries of another scene configuration are not used
+    REQUIRE(!cache.load(tileId, source, 43, styles, selection, state, buildStyles));
+    REQUIRE(!cache.load(TileID(1, 2, 4), source, 42, styles, selection, state, buildStyles));
+
+    std::remove("./disk_cache_test-3-1-2-3.tile");
+}
+
+TEST_CASE("TileDiskCache marks label styles to be rebuilt", "[TileDiskCache]") {
+    TileDiskCache cache(".");
+    CacheTestSource source;
+    auto styles = cacheTestStyles();
+    FeatureSelection selection;
+    FeatureState state;
+    TileID tileId(1, 2, 3);
+
+    auto tile = cacheTestTile(tileId, source, styles, true);
+    REQUIRE(cache.store(*tile, source, 42, styles, state));
+
+    std::vector<bool> buildStyles;
+    auto restored = cache.load(tileId, source, 42, styles, selection, state, buildStyles);
+
+    REQUIRE(restored);
+    REQUIRE(buildStyles.size() == 3);
+    REQUIRE(!buildStyles[0]);
+    REQUIRE(!buildStyles[1]);
+    REQUIRE(buildStyles[2]);
+    REQUIRE(restored->getMesh(*styles[0]));
+    REQUIRE(!restored->getMesh(*styles[2]));
+
+    std::remove("./disk_cache_test-3-1-2-3.tile");
+}
+
+TEST_CASE("TileDiskCache restores the FeatureState colors of features", "[TileDiskCache]") {
+    TileDiskCache cache(".");
+    CacheTestSource source;
+    auto styles = cacheTestStyles();
+    FeatureSelection selection;
+    TileID tileId(1, 2, 3);
+
+    FeatureState state;
+    auto tile = cacheTestTile(tileId, source, styles, false, state.color(source.id(), 7));
+    REQUIRE(cache.store(*tile, source, 42, styles, state));
+
+    // Feature states are indexed anew in another session
+    FeatureState newState;
+    newState.color(source.id(), 3);
+
+    std::vector<bool> buildStyles;
+    auto restored = cache.load(tileId, source, 42, styles, selection, newState, buildStyles);
+
+    REQUIRE(restored);
+    auto& features = restored->getSelectionFeatures();
+    REQUIRE(features.size() == 1);
+    REQUIRE(features.ids()[0] == newState.color(source.id(), 7));
+    REQUIRE(newState.feature(features.ids()[0]).second == 7);
+
+    std::remove("./disk_cache_test-3-1-2-3.tile");
+}
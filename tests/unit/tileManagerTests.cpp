@@ -1,6 +1,7 @@
 #include "catch.hpp"
 
 #include "data/tileSource.h"
+#include "gl/renderState.h"
 #include "mockPlatform.h"
 #include "tile/tileManager.h"
 #include "tile/tileWorker.h"
@@ -8,7 +9,11 @@
 #include "util/fastmap.h"
 #include "view/view.h"
 
+#include <atomic>
+#include <chrono>
 #include <deque>
+#include <limits>
+#include <thread>
 
 using namespace Tangram;
 
@@ -80,9 +85,35 @@ struct TestTileSource : TileSource {
             : TileTask(_tileId, _source) {}
 
         bool hasData() const override { return gotData; }
+
+        // Mimic the first pass of a progressive build
+        void setPartialTile() {
+            m_partialTile = std::make_unique<Tile>(m_tileId, m_sourceId, m_sourceGeneration);
+            m_partialReady = true;
+        }
+
+        // Mimic data with the content hash of the previous tile
+        void keepPreviousTile() {
+            m_keepPreviousTile = true;
+            m_ready = true;
+        }
+
+        // Mimic a raster sub-task with the texture of a parent tile
+        bool proxy = false;
+        int proxiesShown = 0;
+        int proxiesReplaced = 0;
+
+        bool hasProxy() const override { return proxy; }
+        void completeProxy(TileTask& _mainTask) override { proxiesShown++; }
+        void replaceProxy(Tile& _tile) override { proxiesReplaced++; }
     };
 
     int tileTaskCount = 0;
+    int canceledCount = 0;
+    bool noData = false;
+
+    // Source of raster sub-tasks of the tasks
+    std::shared_ptr<TestTileSource> raster;
 
     TestTileSource() : TileSource("test", nullptr) {
         m_generateGeometry = true;
@@ -90,21 +121,28 @@ struct TestTileSource : TileSource {
 
     void loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) override {
         tileTaskCount++;
-        static_cast<Task*>(_task.get())->gotData = true;
+        static_cast<Task*>(_task.get())->gotData = !noData;
         _task->startedLoading();
         _cb.func(std::move(_task));
     }
 
-    void cancelLoadingTile(TileTask& _tile) override {}
+    void cancelLoadingTile(TileTask& _tile) override { canceledCount++; }
+
+    mutable std::atomic<int> parseCount{0};
 
     std::shared_ptr<TileData> parse(const TileTask& _task) const override {
+        parseCount++;
         return nullptr;
     };
 
     void clearData() override {}
 
+    void updateData() { m_generation++; }
+
     std::shared_ptr<TileTask> createTask(TileID _tileId) override {
-        return std::make_shared<Task>(_tileId, shared_from_this());
+        auto task = std::make_shared<Task>(_tileId, shared_from_this());
+        if (raster) { task->subTasks().push_back(raster->createTask(_tileId)); }
+        return task;
     }
 };
 
@@ -113,17 +151,21 @@ public:
     using Base = TileManager;
     using Base::Base;
 
-    void updateTiles(const ViewState& _view, std::set<TileID> _visibleTiles) {
-        // Mimic TileManager::updateTileSets(View& _view)
+    void updateTiles(const ViewState& _view, std::set<TileID> _visibleTiles,
+                     std::set<TileID> _viewTiles = {}) {
+        // Mimic TileManager::updateTileSets(View& _view, _views)
         m_tiles.clear();
+        m_viewTiles.assign(1, {});
         m_tilesInProgress = 0;
         m_tileSetChanged = false;
 
         TileSet& tileSet = m_tileSets[0];
 
-        tileSet.visibleTiles = _visibleTiles;
+        tileSet.visibleTiles.assign(_visibleTiles.begin(), _visibleTiles.end());
+        tileSet.viewTiles.assign(1, std::vector<TileID>(_viewTiles.begin(), _viewTiles.end()));
 
         TileManager::updateTileSet(tileSet, _view);
+        TileManager::updateViewTiles(tileSet, 0, _view);
 
         loadTiles();
 
@@ -197,6 +239,29 @@ TEST_CASE( "Real TileWorker Initialization", "[TileManager][Constructor]" ) {
     TileManager tileManager(platform, worker);
 }
 
+TEST_CASE( "TileWorker parses queued tasks before the Scene is complete", "[TileManager][TileWorker]" ) {
+    MockPlatform platform;
+
+    auto source = std::make_shared<TestTileSource>();
+    TileID tileId(0, 0, 0);
+    auto task = std::make_shared<TestTileSource::Task>(tileId, source);
+    task->gotData = true;
+    REQUIRE(task->needsParse());
+
+    {
+        TileWorker worker(platform, 1);
+        worker.enqueue(task);
+
+        for (int i = 0; i < 1000 && source->parseCount == 0; i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        worker.stop();
+    }
+    REQUIRE(source->parseCount == 1);
+    REQUIRE(!task->needsParse());
+    REQUIRE(!task->isReady());
+}
+
 TEST_CASE( "Load visible Tile", "[TileManager][updateTileSets]" ) {
     TestTileWorker worker;
     MockPlatform platform;
@@ -222,6 +287,67 @@ TEST_CASE( "Load visible Tile", "[TileManager][updateTileSets]" ) {
 
 }
 
+TEST_CASE( "Loaded Tile is shown after its upload", "[TileManager][updateTileSets]" ) {
+    TestTileWorker worker;
+    MockPlatform platform;
+    TestTileManager tileManager(platform, worker);
+    RenderState renderState;
+
+    auto source = std::make_shared<TestTileSource>();
+    std::vector<std::shared_ptr<TileSource>> sources = { source };
+    tileManager.setTileSources(sources);
+
+    std::set<TileID> visibleTiles = {TileID{0,0,0}};
+    tileManager.updateTiles(viewState, visibleTiles);
+    REQUIRE(!tileManager.uploadTiles(renderState));
+
+    worker.processTask();
+    tileManager.updateTiles(viewState, visibleTiles);
+
+    // Waits for the upload once uploads are scheduled
+    REQUIRE(tileManager.getVisibleTiles().size() == 0);
+    REQUIRE(tileManager.uploadTiles(renderState));
+    REQUIRE(!tileManager.uploadTiles(renderState));
+
+    tileManager.updateTiles(viewState, visibleTiles);
+    REQUIRE(tileManager.getVisibleTiles().size() == 1);
+    REQUIRE(tileManager.getVisibleTiles()[0]->isUploaded());
+}
+
+
+TEST_CASE( "Load the Tiles of an additional view", "[TileManager][updateTileSets]" ) {
+    TestTileWorker worker;
+    MockPlatform platform;
+    TestTileManager tileManager(platform, worker);
+
+    auto source = std::make_shared<TestTileSource>();
+    std::vector<std::shared_ptr<TileSource>> sources = { source };
+    tileManager.setTileSources(sources);
+
+    std::set<TileID> visibleTiles = {TileID{0,0,1}};
+    std::set<TileID> viewTiles = {TileID{0,0,0}, TileID{0,0,1}};
+    tileManager.updateTiles(viewState, visibleTiles, viewTiles);
+
+    // Tiles in both views are loaded once
+    REQUIRE(source->tileTaskCount == 2);
+    REQUIRE(tileManager.hasLoadingTiles());
+
+    worker.processTask();
+    worker.processTask();
+    tileManager.updateTiles(viewState, visibleTiles, viewTiles);
+
+    REQUIRE(tileManager.getVisibleTiles().size() == 1);
+    REQUIRE(tileManager.getVisibleTiles()[0]->getID() == TileID(0,0,1));
+    REQUIRE(tileManager.getViewTiles(0).size() == 2);
+    REQUIRE(!tileManager.hasLoadingTiles());
+
+    // The tile of the removed view moves to the tile cache
+    tileManager.updateTiles(viewState, visibleTiles);
+    REQUIRE(tileManager.getViewTiles(0).size() == 0);
+    tileManager.updateTiles(viewState, visibleTiles, viewTiles);
+    REQUIRE(tileManager.getViewTiles(0).size() == 2);
+    REQUIRE(source->tileTaskCount == 2);
+}
 
 TEST_CASE( "Use proxy Tile", "[TileManager][updateTileSets]" ) {
     TestTileWorker worker;
@@ -309,3 +435,258 @@ TEST_CASE( "Use proxy Tile - circular proxies", "[TileManager][updateTileSets]"
     REQUIRE(tileManager.getVisibleTiles()[0]->getID() == TileID(0,0,0));
 
 }
+
+TEST_CASE( "Prefetch the tiles along a camera path", "[TileManager][prefetchPath]" ) {
+    TestTileWorker worker;
+    MockPlatform platform;
+    TestTileManager tileManager(platform, worker);
+
+    auto source = std::make_shared<TestTileSource>();
+    std::vector<std::shared_ptr<TileSource>> sources = { source };
+    tileManager.setTileSources(sources);
+
+    // Destination first, then a view on the way
+    std::vector<View> views(2, View(256, 256));
+    views[0].setZoom(3);
+    views[0].setPosition(MapProjection::tileCenter({6, 2, 3}));
+    views[1].setZoom(2);
+    for (auto& view : views) { view.update(); }
+
+    tileManager.prefetchPath(views);
+
+    REQUIRE(source->tileTaskCount > 0);
+    REQUIRE(worker.tasks.size() == size_t(source->tileTaskCount));
+
+    double maxDestination = 0, minPath = std::numeric_limits<double>::max();
+    for (auto& task : worker.tasks) {
+        if (task->tileId().z == 3) {
+            maxDestination = std::max(maxDestination, task->getPriority());
+        } else {
+            minPath = std::min(minPath, task->getPriority());
+        }
+    }
+    REQUIRE(maxDestination < minPath);
+
+    // Interrupting the animation cancels them
+    tileManager.cancelPathPrefetch();
+    for (auto& task : worker.tasks) { REQUIRE(task->isCanceled()); }
+}
+
+TEST_CASE( "Show the partial Tile of a progressive build", "[TileManager][updateTileSets]" ) {
+    TestTileWorker worker;
+    MockPlatform platform;
+    TestTileManager tileManager(platform, worker);
+
+    auto source = std::make_shared<TestTileSource>();
+    std::vector<std::shared_ptr<TileSource>> sources = { source };
+    tileManager.setTileSources(sources);
+
+    std::set<TileID> visibleTiles = {TileID{0,0,0}};
+    tileManager.updateTiles(viewState, visibleTiles);
+    REQUIRE(worker.tasks.size() == 1);
+
+    static_cast<TestTileSource::Task&>(*worker.tasks.front()).setPartialTile();
+    tileManager.updateTiles(viewState, visibleTiles);
+
+    REQUIRE(tileManager.getVisibleTiles().size() == 1);
+    auto partial = tileManager.getVisibleTiles()[0];
+    REQUIRE(tileManager.hasLoadingTiles());
+
+    // The second pass is added to the visible tile
+    worker.processTask();
+    tileManager.updateTiles(viewState, visibleTiles);
+
+    REQUIRE(tileManager.getVisibleTiles().size() == 1);
+    REQUIRE(tileManager.getVisibleTiles()[0] == partial);
+    REQUIRE(!tileManager.hasLoadingTiles());
+}
+
+TEST_CASE( "Schedule and cancel raster sub-tasks with their Tile", "[TileManager][updateTileSets]" ) {
+    TestTileWorker worker;
+    MockPlatform platform;
+    TestTileManager tileManager(platform, worker);
+
+    auto source = std::make_shared<TestTileSource>();
+    source->raster = std::make_shared<TestTileSource>();
+    std::vector<std::shared_ptr<TileSource>> sources = { source };
+    tileManager.setTileSources(sources);
+
+    std::set<TileID> visibleTiles = {TileID{1,0,1}};
+    tileManager.updateTiles(viewState, visibleTiles);
+    REQUIRE(worker.tasks.size() == 1);
+
+    auto task = worker.tasks.front();
+    auto rasterTask = task->subTasks()[0];
+    REQUIRE(task->getPriority() > 0);
+    REQUIRE(rasterTask->getPriority() == task->getPriority());
+
+    // Removing the tile cancels the requests of its rasters too
+    tileManager.updateTiles(viewState, {});
+    REQUIRE(task->isCanceled());
+    REQUIRE(rasterTask->isCanceled());
+    REQUIRE(source->canceledCount == 1);
+
+    // A tile without data stops loading its rasters
+    source->noData = true;
+    tileManager.updateTiles(viewState, {TileID{0,0,0}});
+    tileManager.updateTiles(viewState, {TileID{0,0,0}});
+    REQUIRE(source->raster->canceledCount == 1);
+}
+
+TEST_CASE( "Show a Tile with the proxies of its raster sub-tasks", "[TileManager][updateTileSets]" ) {
+    TestTileWorker worker;
+    MockPlatform platform;
+    TestTileManager tileManager(platform, worker);
+
+    auto source = std::make_shared<TestTileSource>();
+    source->raster = std::make_shared<TestTileSource>();
+    std::vector<std::shared_ptr<TileSource>> sources = { source };
+    tileManager.setTileSources(sources);
+
+    std::set<TileID> visibleTiles = {TileID{1,0,1}};
+    tileManager.updateTiles(viewState, visibleTiles);
+    REQUIRE(worker.tasks.size() == 1);
+
+    auto task = worker.tasks.front();
+    auto& rasterTask = static_cast<TestTileSource::Task&>(*task->subTasks()[0]);
+
+    // Without a proxy the tile waits for its raster
+    worker.processTask();
+    tileManager.updateTiles(viewState, visibleTiles);
+    REQUIRE(tileManager.getVisibleTiles().empty());
+
+    rasterTask.proxy = true;
+    tileManager.updateTiles(viewState, visibleTiles);
+    REQUIRE(tileManager.getVisibleTiles().size() == 1);
+    REQUIRE(rasterTask.proxiesShown == 1);
+    REQUIRE(tileManager.hasLoadingTiles());
+
+    auto tile = tileManager.getVisibleTiles()[0];
+    tileManager.updateTiles(viewState, visibleTiles);
+    REQUIRE(rasterTask.proxiesReplaced == 0);
+
+    // The raster replaces its proxy in the same tile
+    rasterTask.startedLoading();
+    rasterTask.setTile(std::make_unique<Tile>(rasterTask.tileId(), 0, 0));
+    tileManager.updateTiles(viewState, visibleTiles);
+    REQUIRE(rasterTask.proxiesReplaced == 1);
+    REQUIRE(tileManager.getVisibleTiles().size() == 1);
+    REQUIRE(tileManager.getVisibleTiles()[0] == tile);
+    REQUIRE(!tileManager.hasLoadingTiles());
+}
+
+TEST_CASE( "Tiles wait for their load while the workers are behind", "[TileManager][updateTileSets]" ) {
+    TestTileWorker worker;
+    MockPlatform platform;
+    TestTileManager tileManager(platform, worker);
+
+    auto source = std::make_shared<TestTileSource>();
+    std::vector<std::shared_ptr<TileSource>> sources = { source };
+    tileManager.setTileSources(sources);
+
+    std::set<TileID> visibleTiles;
+    for (int x = 0; x < 8; x++) {
+        for (int y = 0; y < 8; y++) { visibleTiles.insert(TileID{x, y, 3}); }
+    }
+    tileManager.updateTiles(viewState, visibleTiles);
+
+    // Loads stop once the workers have enough tasks
+    int loaded = source->tileTaskCount;
+    REQUIRE(loaded > 0);
+    REQUIRE(loaded < 64);
+    REQUIRE(worker.tasks.size() == size_t(loaded));
+
+    tileManager.updateTiles(viewState, visibleTiles);
+    REQUIRE(source->tileTaskCount == loaded);
+
+    // Built tiles make room for the next loads
+    for (int i = 0; i < 8; i++) { worker.processTask(); }
+    tileManager.updateTiles(viewState, visibleTiles);
+    REQUIRE(source->tileTaskCount == loaded + 8);
+    REQUIRE(tileManager.getVisibleTiles().size() == 8);
+    REQUIRE(tileManager.hasLoadingTiles());
+
+    // Canceled tasks do not count
+    worker.dropTask();
+    tileManager.updateTiles(viewState, visibleTiles);
+    REQUIRE(source->tileTaskCount == loaded + 9);
+}
+
+TEST_CASE( "Keep the Tile when its data did not change", "[TileManager][updateTileSets]" ) {
+    TestTileWorker worker;
+    MockPlatform platform;
+    TestTileManager tileManager(platform, worker);
+
+    auto source = std::make_shared<TestTileSource>();
+    std::vector<std::shared_ptr<TileSource>> sources = { source };
+    tileManager.setTileSources(sources);
+
+    std::set<TileID> visibleTiles = {TileID{0,0,0}};
+    tileManager.updateTiles(viewState, visibleTiles);
+    worker.processTask();
+    tileManager.updateTiles(viewState, visibleTiles);
+    REQUIRE(tileManager.getVisibleTiles().size() == 1);
+    auto tile = tileManager.getVisibleTiles()[0];
+
+    // The tile is loaded again for the new generation of the source
+    source->updateData();
+    tileManager.updateTiles(viewState, visibleTiles);
+    REQUIRE(worker.tasks.size() == 1);
+    auto task = worker.tasks.front();
+    worker.tasks.pop_front();
+    REQUIRE(task->previousTile() == tile);
+
+    static_cast<TestTileSource::Task&>(*task).keepPreviousTile();
+    tileManager.updateTiles(viewState, visibleTiles);
+    REQUIRE(tileManager.getVisibleTiles().size() == 1);
+    REQUIRE(tileManager.getVisibleTiles()[0] == tile);
+    REQUIRE(tile->sourceGeneration() == source->generation());
+
+    tileManager.updateTiles(viewState, visibleTiles);
+    REQUIRE(worker.tasks.empty());
+    REQUIRE(source->tileTaskCount == 2);
+}
+
+TEST_CASE( "Keep the visible Tiles while nothing changes", "[TileManager][updateTileSets]" ) {
+    TestTileWorker worker;
+    MockPlatform platform;
+    TestTileManager tileManager(platform, worker);
+
+    auto source = std::make_shared<TestTileSource>();
+    std::vector<std::shared_ptr<TileSource>> sources = { source };
+    tileManager.setTileSources(sources);
+
+    View view(256, 256);
+    view.setZoom(1);
+    view.update();
+    tileManager.updateTileSets(view);
+
+    int tiles = source->tileTaskCount;
+    REQUIRE(tiles > 0);
+    while (!worker.tasks.empty()) { worker.processTask(); }
+
+    view.update();
+    REQUIRE(!view.changedOnLastUpdate());
+    tileManager.updateTileSets(view);
+    REQUIRE(tileManager.hasTileSetChanged());
+    REQUIRE(tileManager.getVisibleTiles().size() == size_t(tiles));
+
+    // Idle updates keep the tiles
+    tileManager.updateTileSets(view);
+    REQUIRE(!tileManager.hasTileSetChanged());
+    REQUIRE(tileManager.getVisibleTiles().size() == size_t(tiles));
+
+    // A new generation of the source loads them again
+    source->updateData();
+    tileManager.updateTileSets(view);
+    REQUIRE(source->tileTaskCount == 2 * tiles);
+    while (!worker.tasks.empty()) { worker.processTask(); }
+    tileManager.updateTileSets(view);
+    tileManager.updateTileSets(view);
+    REQUIRE(tileManager.getVisibleTiles().size() == size_t(tiles));
+
+    // A hidden source has no visible tiles
+    source->setVisible(false);
+    tileManager.updateTileSets(view);
+    REQUIRE(tileManager.getVisibleTiles().empty());
+}
@@ -0,0 +1,67 @@
+#include "catch.hpp"
+
+#include "debug/trace.h"
+
+#include <thread>
+#include <vector>
+
+using namespace Tangram;
+
+#define TAGS "[Trace]"
+
+static size_t countOf(const std::string& _str, const std::string& _pattern) {
+    size_t count = 0;
+    for (size_t pos = _str.find(_pattern); pos != std::string::npos;
+         pos = _str.find(_pattern, pos + 1)) {
+        count++;
+    }
+    return count;
+}
+
+TEST_CASE("Trace events are only recorded when enabled", TAGS) {
+    Trace::toJson(true);
+
+    Trace::setEnabled(false);
+    { TRACE_SCOPE("disabled"); }
+
+    CHECK(Trace::toJson(true) == "{\"traceEvents\":[],\"displayTimeUnit\":\"ms\"}");
+}
+
+TEST_CASE("Trace events of all threads are exported", TAGS) {
+    Trace::toJson(true);
+    Trace::setEnabled(true);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++) {
+        threads.emplace_back([]() {
+            for (int j = 0; j < 100; j++) { TRACE_SCOPE("worker"); }
+        });
+    }
+    for (auto& thread : threads) { thread.join(); }
+    { TRACE_SCOPE("main"); }
+
+    auto json = Trace::toJson(false);
+    CHECK(countOf(json, "\"name\":\"worker\"") == 400);
+    CHECK(countOf(json, "\"name\":\"main\"") == 1);
+    CHECK(countOf(json, "\"ph\":\"X\"") == 401);
+
+    // Cleared by toJson(true)
+    Trace::toJson(true);
+    CHECK(countOf(Trace::toJson(true), "\"ph\"") == 0);
+
+    Trace::setEnabled(false);
+}
+
+TEST_CASE("Trace keeps the newest events when the buffer is full", TAGS) {
+    Trace::toJson(true);
+    Trace::setEnabled(true);
+
+    { TRACE_SCOPE("oldest"); }
+    for (size_t i = 0; i < Trace::capacity; i++) { TRACE_SCOPE("newer"); }
+
+    auto json = Trace::toJson(true);
+    CHECK(countOf(json, "\"name\":\"oldest\"") == 0);
+    CHECK(countOf(json, "\"name\":\"newer\"") == Trace::capacity);
+
+    Trace::setEnabled(false);
+}
@@ -0,0 +1,82 @@
+#include "catch.hpp"
+
+#include "util/geom.h"
+#include "view/view.h"
+
+#include <map>
+#include <set>
+
+using namespace Tangram;
+
+static std::set<TileID> visibleTiles(float _pitch, float _pixelError, int _maxTiles = 0) {
+    View view(1024, 768);
+    view.setMaxPitch(90);
+    view.setZoom(15.3f);
+    view.setPosition(1000, 1000);
+    view.setPitch(_pitch);
+    view.setTileLodPixelError(_pixelError);
+    view.setMaxVisibleTiles(_maxTiles);
+    view.update();
+
+    std::set<TileID> tiles;
+    view.getVisibleTiles([&](TileID _id) { tiles.insert(_id); });
+    return tiles;
+}
+
+TEST_CASE("Views without tilt keep the integer zoom", "[View][Tiles]") {
+    auto tiles = visibleTiles(0.f, 1.5f);
+
+    REQUIRE(tiles == visibleTiles(0.f, 0.f));
+    for (auto& tile : tiles) { REQUIRE(tile.z == 15); }
+}
+
+TEST_CASE("Tilted views load distant tiles at lower zooms", "[View][Tiles]") {
+    auto full = visibleTiles(1.f, 0.f);
+    auto reduced = visibleTiles(1.f, 1.5f);
+
+    REQUIRE(reduced.size() < full.size());
+
+    // No tile covers another one
+    for (auto& a : reduced) {
+        for (auto& b : reduced) {
+            if (b.z >= a.z) { continue; }
+            int dz = a.z - b.z;
+            REQUIRE(!((a.x >> dz) == b.x && (a.y >> dz) == b.y));
+        }
+    }
+}
+
+TEST_CASE("The pixel error is raised to fit the maximum number of tiles", "[View][Tiles]") {
+    auto tiles = visibleTiles(1.3f, 1.5f, 20);
+
+    REQUIRE(!tiles.empty());
+    REQUIRE(tiles.size() <= 20);
+}
+
+TEST_CASE("Mesh bounds outside of the view frustum are culled", "[View]") {
+    View view(1024, 768);
+    view.setMaxPitch(90);
+    view.setZoom(15.f);
+    view.setPosition(1000, 1000);
+    view.setPitch(1.f);
+    view.update();
+
+    // Bounds in meters relative to the view center
+    const auto& viewProj = view.getViewProjectionMatrix();
+    auto bounds = [](glm::vec3 _min, glm::vec3 _max) {
+        MeshBounds b;
+        b.expand(_min);
+        b.expand(_max);
+        return b;
+    };
+
+    REQUIRE(!MeshBounds().isOutsideFrustum(viewProj));
+    REQUIRE(!bounds({ -10, -10, 0 }, { 10, 10, 50 }).isOutsideFrustum(viewProj));
+
+    // Beyond the right and the bottom edges of the view
+    REQUIRE(bounds({ 5000, -10, 0 }, { 5100, 10, 50 }).isOutsideFrustum(viewProj));
+    REQUIRE(bounds({ -10, -5000, 0 }, { 10, -4900, 50 }).isOutsideFrustum(viewProj));
+
+    // Across the view without any corner in it
+    REQUIRE(!bounds({ -5000, -10, 0 }, { 5000, 10, 50 }).isOutsideFrustum(viewProj));
+}
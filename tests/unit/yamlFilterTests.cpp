@@ -238,3 +238,39 @@ TEST_CASE("Sequences in filters implicitly create an 'any' filter", "[filters][c
     REQUIRE(filter.eval(bmw1, ctx));
     REQUIRE(!filter.eval(bike, ctx));
 }
+
+TEST_CASE("Compiled filter programs evaluate like their filters", "[filters][core][yaml]") {
+    init();
+    const std::vector<std::string> filters = {
+        "filter: { series: !!str 3}",
+        "filter: { name : [civic, bmw320i] }",
+        "filter: {wheel : {min : 2, max : 5}}",
+        "filter: {any : [{name : civic}, {name : bmw320i}]}",
+        "filter: {all : [ {name : civic}, {brand : honda}, {wheel: 4} ] }",
+        "filter: {none : [{name : civic}, {name : bmw320i}]}",
+        "filter: {not : { any: [{name : civic}, {name : bmw320i}]}}",
+        "filter: {all : [ {any : [{brand : bmw}, {wheel : 2}]}, {none : [{check : false}]} ] }",
+        "filter: {any : [ {all : []}, {name : civic} ] }",
+        "filter: {$zoom : {min : 8, max : 12}}",
+        "filter: { drive : true }",
+        "filter: { drive : false}",
+        "filter: { serial : [4398046511104] }",
+        "filter: 'function() { return false; }'",
+        "filter: [ { brand: 'bmw' }, { type: 'car' } ]",
+    };
+
+    for (const auto& yaml : filters) {
+        Filter filter = load(yaml);
+        FilterProgram program(filter);
+
+        for (const auto* feature : { &civic, &bmw1, &bike }) {
+            INFO(yaml);
+            REQUIRE(program.eval(*feature, ctx) == filter.eval(*feature, ctx));
+        }
+    }
+
+    // Keys are stored once per program
+    FilterProgram program(load("filter: {any : [{name : civic}, {name : bmw320i}, {brand : bmw}]}"));
+    REQUIRE(program.numInstructions() == 3);
+    REQUIRE(program.keys().size() == 2);
+}
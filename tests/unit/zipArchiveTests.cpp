@@ -0,0 +1,73 @@
+#include "catch.hpp"
+
+#include "util/zipArchive.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace Tangram;
+
+static std::vector<char> createArchive(const std::vector<std::pair<std::string, std::string>>& _files,
+                                       mz_uint _level) {
+    mz_zip_archive zip;
+    mz_zip_zero_struct(&zip);
+    REQUIRE(mz_zip_writer_init_heap(&zip, 0, 0));
+    for (auto& file : _files) {
+        REQUIRE(mz_zip_writer_add_mem(&zip, file.first.c_str(), file.second.data(),
+                                      file.second.size(), _level));
+    }
+    void* data = nullptr;
+    size_t size = 0;
+    REQUIRE(mz_zip_writer_finalize_heap_archive(&zip, &data, &size));
+    std::vector<char> archive(static_cast<char*>(data), static_cast<char*>(data) + size);
+    mz_zip_writer_end(&zip);
+    return archive;
+}
+
+TEST_CASE("Stored zip entries are read in place", "[ZipArchive]") {
+    std::string scene = "scene: { background: { color: white } }";
+
+    ZipArchive archive;
+    REQUIRE(archive.loadFromMemory(createArchive({{"scene.yaml", scene}, {"img/a.png", "png"}},
+                                                 MZ_NO_COMPRESSION)));
+    REQUIRE(archive.entries().size() == 2);
+
+    auto entry = archive.findEntry("scene.yaml");
+    REQUIRE(entry != nullptr);
+    REQUIRE(entry->stored);
+    REQUIRE(entry->uncompressedSize == scene.size());
+
+    const char* data = archive.entryData(entry);
+    REQUIRE(data != nullptr);
+    REQUIRE(std::string(data, entry->uncompressedSize) == scene);
+
+    std::vector<char> output(entry->uncompressedSize);
+    REQUIRE(archive.decompressEntry(entry, output.data()));
+    REQUIRE(std::string(output.begin(), output.end()) == scene);
+
+    REQUIRE(archive.findEntry("img/b.png") == nullptr);
+}
+
+TEST_CASE("Deflated zip entries are decompressed", "[ZipArchive]") {
+    std::string text;
+    for (int i = 0; i < 1000; i++) { text += "repeated line " + std::to_string(i % 10) + "\n"; }
+
+    ZipArchive archive;
+    REQUIRE(archive.loadFromMemory(createArchive({{"a.txt", text}, {"b.txt", text + text}},
+                                                 MZ_DEFAULT_LEVEL)));
+
+    auto entry = archive.findEntry("b.txt");
+    REQUIRE(entry != nullptr);
+    REQUIRE(!entry->stored);
+    REQUIRE(entry->compressedSize < entry->uncompressedSize);
+    REQUIRE(archive.entryData(entry) == nullptr);
+
+    std::vector<char> output(entry->uncompressedSize);
+    REQUIRE(archive.decompressEntry(entry, output.data()));
+    REQUIRE(std::string(output.begin(), output.end()) == text + text);
+
+    // Entries of other archives are rejected
+    ZipArchive other;
+    REQUIRE(!other.decompressEntry(entry, output.data()));
+}
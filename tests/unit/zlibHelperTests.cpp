@@ -0,0 +1,69 @@
+#include "catch.hpp"
+
+#include "util/zlibHelper.h"
+
+#include <zlib.h>
+
+#include <string>
+
+using namespace Tangram;
+
+static std::vector<char> makeData(size_t _size) {
+    std::vector<char> data(_size);
+    for (size_t i = 0; i < _size; i++) {
+        data[i] = char((i * 7) % 251 + (i / 1000));
+    }
+    return data;
+}
+
+TEST_CASE("Inflate data compressed with deflate", "[Core][zlib]") {
+    for (size_t size : { 0, 10, 1000, 100000 }) {
+        auto data = makeData(size);
+        std::vector<char> compressed;
+        REQUIRE(zlib::deflate(data.data(), data.size(), compressed) == Z_OK);
+
+        std::vector<char> inflated;
+        REQUIRE(zlib::inflate(compressed.data(), compressed.size(), inflated) == Z_OK);
+        REQUIRE(inflated == data);
+    }
+}
+
+TEST_CASE("Inflate appends to the output", "[Core][zlib]") {
+    std::string text = "tile data";
+    std::vector<char> compressed;
+    REQUIRE(zlib::deflate(text.data(), text.size(), compressed) == Z_OK);
+
+    std::vector<char> inflated = { 'a', 'b' };
+    REQUIRE(zlib::inflate(compressed.data(), compressed.size(), inflated) == Z_OK);
+    REQUIRE(std::string(inflated.begin(), inflated.end()) == "abtile data");
+}
+
+TEST_CASE("Inflate data with a wrong size in the gzip trailer", "[Core][zlib]") {
+    // The size is used as a hint and checked once the data is inflated
+    auto data = makeData(50000);
+    std::vector<char> compressed;
+    REQUIRE(zlib::deflate(data.data(), data.size(), compressed) == Z_OK);
+    compressed[compressed.size() - 4] ^= 0x10;
+
+    std::vector<char> inflated;
+    REQUIRE(zlib::inflate(compressed.data(), compressed.size(), inflated) != Z_OK);
+    REQUIRE(inflated.empty());
+}
+
+TEST_CASE("Inflate fails on truncated or invalid data", "[Core][zlib]") {
+    auto data = makeData(20000);
+    std::vector<char> compressed;
+    REQUIRE(zlib::deflate(data.data(), data.size(), compressed) == Z_OK);
+
+    std::vector<char> inflated = { 'a' };
+    REQUIRE(zlib::inflate(compressed.data(), compressed.size() / 2, inflated) == Z_DATA_ERROR);
+    REQUIRE(inflated.size() == 1);
+
+    std::string text = "not compressed";
+    REQUIRE(zlib::inflate(text.data(), text.size(), inflated) == Z_DATA_ERROR);
+    REQUIRE(inflated.size() == 1);
+
+    // The stream is reset after a failure
+    REQUIRE(zlib::inflate(compressed.data(), compressed.size(), inflated) == Z_OK);
+    REQUIRE(inflated.size() == data.size() + 1);
+}